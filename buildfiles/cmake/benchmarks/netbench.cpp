@@ -0,0 +1,375 @@
+//
+//  netbench.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This is a microbenchmark suite for the networking classes. It measures the
+//  serializers, the physics synchronization events, the event wrapping of the
+//  NetEventController, and the synchronization packing of the NetPhysicsController
+//  at 100, 1k, and 10k obstacles. Everything runs on a headless ObstacleWorld,
+//  so the program never opens a window.
+//
+//  Every result is printed as a single line of JSON, so that the output can be
+//  collected and compared between builds to catch regressions. Usage:
+//
+//      netbench [millis] [file]
+//
+//  where millis is the minimum time spent on each benchmark (default 250) and
+//  file is where the results are written (default is standard output).
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/base/CUApplication.h>
+#include <cugl/net/CUNetcodeSerializer.h>
+#include <cugl/physics2/CUObstacleWorld.h>
+#include <cugl/physics2/CUBoxObstacle.h>
+#include <cugl/netphysics/CULWSerializer.h>
+#include <cugl/netphysics/CULWDeserializer.h>
+#include <cugl/netphysics/CUPhysSyncEvent.h>
+#include <cugl/netphysics/CUNetEventController.h>
+#include <cugl/netphysics/CUNetPhysicsController.h>
+#include <functional>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace cugl;
+using namespace cugl::net;
+using namespace cugl::netphysics;
+using namespace cugl::physics2;
+
+/** The default minimum time spent on each benchmark (in ms) */
+#define BENCH_MILLIS    250
+/** The minimum number of iterations of each benchmark */
+#define BENCH_MINIMUM   5
+/** The width of the obstacle grid */
+#define GRID_WIDTH      100
+/** The physics time step */
+#define STEP_SIZE       (1.0f/60.0f)
+
+#pragma mark -
+#pragma mark Harness
+/**
+ * The file to write results to
+ */
+static FILE* out = stdout;
+
+/**
+ * The minimum time spent on each benchmark in nanoseconds
+ */
+static Uint64 budget = (Uint64)BENCH_MILLIS*1000000;
+
+/**
+ * A sink for values read back, so that the reads are not optimized away
+ */
+static volatile float sink = 0;
+
+/**
+ * Runs a single benchmark and writes the result as a line of JSON.
+ *
+ * The function op is the operation being measured. The function prepare is
+ * run before each call to op, but is not part of the measurement. It may be
+ * nullptr. The function size returns the number of bytes produced (or consumed)
+ * by op, and is called once after the first operation.
+ *
+ * @param name      The benchmark name
+ * @param objects   The number of obstacles in the benchmark
+ * @param prepare   The preparation for each operation (may be nullptr)
+ * @param op        The operation to measure
+ * @param size      The size of the operation data
+ */
+static void measure(const std::string& name, size_t objects,
+                    const std::function<void()>& prepare,
+                    const std::function<void()>& op,
+                    const std::function<size_t()>& size) {
+    typedef std::chrono::steady_clock clock;
+
+    // Warm up the caches and allocators
+    if (prepare) {
+        prepare();
+    }
+    op();
+    size_t bytes = size();
+
+    Uint64 total = 0;
+    Uint64 iterations = 0;
+    while (total < budget || iterations < BENCH_MINIMUM) {
+        if (prepare) {
+            prepare();
+        }
+        auto start = clock::now();
+        op();
+        auto end = clock::now();
+        total += (Uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(end-start).count();
+        iterations++;
+    }
+
+    double perop = (double)total/(double)iterations;
+    fprintf(out,"{\"benchmark\":\"%s\",\"objects\":%zu,\"iterations\":%llu,"
+            "\"ns_per_op\":%.1f,\"ns_per_object\":%.2f,\"bytes_per_object\":%.2f}\n",
+            name.c_str(),objects,(unsigned long long)iterations,
+            perop,perop/objects,(double)bytes/objects);
+    fflush(out);
+}
+
+#pragma mark -
+#pragma mark Fixtures
+/**
+ * A NetEventController that exposes its wrapping methods.
+ *
+ * The controller is never connected. It only has the event types needed to
+ * wrap a physics synchronization event.
+ */
+class BenchController : public NetEventController {
+public:
+    /**
+     * Creates a disconnected controller for the given application.
+     *
+     * @param app   The application for the game tick
+     */
+    BenchController(Application* app) {
+        _appRef = app;
+        attachEventType<PhysSyncEvent>();
+    }
+
+    using NetEventController::wrapInto;
+    using NetEventController::unwrap;
+};
+
+/**
+ * Returns a headless world with the given number of shared obstacles.
+ *
+ * The obstacles are laid out in a grid, so that none of them touch. They are
+ * all owned by this client, so that they are packed for synchronization.
+ *
+ * @param objects   The number of obstacles
+ *
+ * @return a headless world with the given number of shared obstacles.
+ */
+static std::shared_ptr<ObstacleWorld> makeWorld(size_t objects) {
+    float height = (float)(objects/GRID_WIDTH+1)*2.0f;
+    auto world = ObstacleWorld::alloc(Rect(0,0,GRID_WIDTH*2.0f,height),Vec2(0,-9.8f));
+    world->setShortUID(1);
+    for(size_t ii = 0; ii < objects; ii++) {
+        Vec2 pos((float)(ii % GRID_WIDTH)*2.0f+1.0f,(float)(ii / GRID_WIDTH)*2.0f+1.0f);
+        auto box = BoxObstacle::alloc(pos,Size(1,1));
+        box->setShared(true);
+        box->setOwned(0);
+        box->setLinearVelocity(Vec2((float)(ii % 7),(float)(ii % 5)));
+        box->setAngularVelocity((float)(ii % 3));
+        world->addObstacle(box);
+    }
+    return world;
+}
+
+/**
+ * Returns the total size of the given events once serialized.
+ *
+ * @param events    The events to serialize
+ *
+ * @return the total size of the given events once serialized.
+ */
+static size_t sizeOf(const std::vector<std::shared_ptr<NetEvent>>& events) {
+    size_t result = 0;
+    for(auto it = events.begin(); it != events.end(); ++it) {
+        result += (*it)->serialize().size();
+    }
+    return result;
+}
+
+#pragma mark -
+#pragma mark Benchmarks
+/**
+ * Measures the general purpose serializers on obstacle state.
+ *
+ * Each object is an id and six floats, the same state as a synchronization
+ * snapshot.
+ *
+ * @param world The physics world
+ */
+static void benchSerializers(const std::shared_ptr<ObstacleWorld>& world) {
+    const auto& objs = world->getObstacles();
+    size_t count = objs.size();
+
+    auto netout = NetcodeSerializer::alloc();
+    measure("NetcodeSerializer/serialize",count,nullptr,[&]() {
+        netout->reset();
+        for(auto it = objs.begin(); it != objs.end(); ++it) {
+            netout->writeUint64((*it)->getGlobalId());
+            netout->writeFloat((*it)->getX());
+            netout->writeFloat((*it)->getY());
+            netout->writeFloat((*it)->getVX());
+            netout->writeFloat((*it)->getVY());
+            netout->writeFloat((*it)->getAngle());
+            netout->writeFloat((*it)->getAngularVelocity());
+        }
+        netout->serialize();
+    },[&]() { return netout->serialize().size(); });
+
+    std::vector<std::byte> netbytes = netout->serialize();
+    auto netin = NetcodeDeserializer::alloc();
+    measure("NetcodeDeserializer/deserialize",count,nullptr,[&]() {
+        netin->receive(netbytes);
+        float sum = 0;
+        for(size_t ii = 0; ii < count; ii++) {
+            sum += (float)netin->readUint64();
+            for(int jj = 0; jj < 6; jj++) {
+                sum += netin->readFloat();
+            }
+        }
+        netin->reset();
+        sink = sum;
+    },[&]() { return netbytes.size(); });
+
+    LWSerializer lwout;
+    measure("LWSerializer/serialize",count,nullptr,[&]() {
+        lwout.reset();
+        for(auto it = objs.begin(); it != objs.end(); ++it) {
+            lwout.writeUint64((*it)->getGlobalId());
+            lwout.writeFloat((*it)->getX());
+            lwout.writeFloat((*it)->getY());
+            lwout.writeFloat((*it)->getVX());
+            lwout.writeFloat((*it)->getVY());
+            lwout.writeFloat((*it)->getAngle());
+            lwout.writeFloat((*it)->getAngularVelocity());
+        }
+        lwout.serialize();
+    },[&]() { return lwout.serialize().size(); });
+
+    std::vector<std::byte> lwbytes = lwout.serialize();
+    LWDeserializer lwin;
+    measure("LWDeserializer/deserialize",count,nullptr,[&]() {
+        lwin.receive(lwbytes);
+        float sum = 0;
+        for(size_t ii = 0; ii < count; ii++) {
+            sum += (float)lwin.readUint64();
+            for(int jj = 0; jj < 6; jj++) {
+                sum += lwin.readFloat();
+            }
+        }
+        lwin.reset();
+        sink = sum;
+    },[&]() { return lwbytes.size(); });
+}
+
+/**
+ * Measures the physics synchronization event and its wrapping.
+ *
+ * @param world The physics world
+ * @param app   The application for the game tick
+ */
+static void benchEvents(const std::shared_ptr<ObstacleWorld>& world, Application* app) {
+    const auto& objs = world->getObstacles();
+    size_t count = objs.size();
+
+    auto event = PhysSyncEvent::alloc();
+    for(auto it = objs.begin(); it != objs.end(); ++it) {
+        event->addObj(*it,(*it)->getGlobalId());
+    }
+    std::vector<std::byte> bytes;
+    measure("PhysSyncEvent/serialize",count,nullptr,[&]() {
+        bytes = event->serialize();
+    },[&]() { return bytes.size(); });
+
+    measure("PhysSyncEvent/deserialize",count,nullptr,[&]() {
+        auto copy = PhysSyncEvent::alloc();
+        copy->deserialize(bytes);
+    },[&]() { return bytes.size(); });
+
+    auto controller = std::make_shared<BenchController>(app);
+    std::vector<std::byte> wrapped;
+    measure("NetEventController/wrap",count,nullptr,[&]() {
+        controller->wrapInto(event,wrapped);
+    },[&]() { return wrapped.size(); });
+
+    auto source = std::make_shared<const std::string>("bench");
+    measure("NetEventController/unwrap",count,nullptr,[&]() {
+        auto copy = controller->unwrap(wrapped,0,source);
+    },[&]() { return wrapped.size(); });
+}
+
+/**
+ * Measures the synchronization packing of the physics controller.
+ *
+ * The delta compressed synchronization steps the world before each pack, so
+ * that every object has moved. The step is not part of the measurement.
+ *
+ * @param world The physics world
+ */
+static void benchPacking(std::shared_ptr<ObstacleWorld>& world) {
+    size_t count = world->getObstacles().size();
+    auto physics = NetPhysicsController::alloc();
+    physics->init(world,1,true,nullptr);
+
+    auto clear = [&]() { physics->getOutEvents().clear(); };
+    measure("NetPhysicsController/packPhysSync/override",count,clear,[&]() {
+        physics->packPhysSync(NetPhysicsController::OVERRIDE_FULL_SYNC);
+    },[&]() { return sizeOf(physics->getOutEvents()); });
+
+    auto step = [&]() {
+        physics->getOutEvents().clear();
+        world->update(STEP_SIZE);
+    };
+    measure("NetPhysicsController/packPhysSync/full",count,step,[&]() {
+        physics->packPhysSync(NetPhysicsController::FULL_SYNC);
+    },[&]() { return sizeOf(physics->getOutEvents()); });
+    physics->dispose();
+}
+
+#pragma mark -
+#pragma mark Main
+/**
+ * Runs every benchmark at 100, 1k, and 10k obstacles.
+ *
+ * @param argc  The number of arguments
+ * @param argv  The arguments (the time per benchmark and the output file)
+ */
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        budget = (Uint64)std::strtoull(argv[1],nullptr,10)*1000000;
+    }
+    if (argc > 2) {
+        out = fopen(argv[2],"w");
+        if (out == nullptr) {
+            fprintf(stderr,"Could not open '%s'\n",argv[2]);
+            return 1;
+        }
+    }
+
+    // Never initialized, so there is no window
+    Application app;
+    const size_t sizes[] = { 100, 1000, 10000 };
+    for(size_t size : sizes) {
+        auto world = makeWorld(size);
+        benchSerializers(world);
+        benchEvents(world,&app);
+        benchPacking(world);
+        world->dispose();
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,316 @@
+//
+//  physbench.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This is a scalability benchmark for the physics worlds and their network
+//  synchronization. It populates a headless host world with 100 to 20k box,
+//  wheel and polygon obstacles, and a client world with the same obstacles.
+//  Each tick, the host steps its world and packs a physics snapshot, and the
+//  client receives the snapshot and interpolates towards it. The client acks
+//  every snapshot, so the host sends delta snapshots as it would in a game.
+//
+//  Every result is printed as a single line of JSON, with the time per tick of
+//  each stage, so that the output can be collected and compared between builds
+//  to catch regressions. Usage:
+//
+//      physbench [ticks] [file]
+//
+//  where ticks is the number of measured ticks at each size (default 120) and
+//  file is where the results are written (default is standard output).
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/base/CUApplication.h>
+#include <cugl/math/polygon/CUPolyFactory.h>
+#include <cugl/physics2/CUObstacleWorld.h>
+#include <cugl/physics2/CUBoxObstacle.h>
+#include <cugl/physics2/CUWheelObstacle.h>
+#include <cugl/physics2/CUPolygonObstacle.h>
+#include <cugl/netphysics/CUPhysSyncEvent.h>
+#include <cugl/netphysics/CUPhysInputEvent.h>
+#include <cugl/netphysics/CUNetEventController.h>
+#include <cugl/netphysics/CUNetPhysicsController.h>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace cugl;
+using namespace cugl::netphysics;
+using namespace cugl::physics2;
+
+/** The default number of measured ticks at each size */
+#define BENCH_TICKS     120
+/** The number of unmeasured ticks before each size */
+#define BENCH_WARMUP    10
+/** The width of the obstacle grid */
+#define GRID_WIDTH      200
+/** The spacing of the obstacle grid */
+#define GRID_SPACING    2.0f
+/** The physics time step */
+#define STEP_SIZE       (1.0f/60.0f)
+/** The short UID of the host */
+#define HOST_UID        1
+/** The short UID of the client */
+#define CLIENT_UID      2
+
+#pragma mark -
+#pragma mark Fixtures
+/**
+ * A NetEventController that exposes its wrapping methods.
+ *
+ * The controller is never connected. It only has the event types that pass
+ * between the host and the client.
+ */
+class BenchController : public NetEventController {
+public:
+    /**
+     * Creates a disconnected controller for the given application.
+     *
+     * @param app   The application for the game tick
+     */
+    BenchController(Application* app) {
+        _appRef = app;
+        attachEventType<PhysSyncEvent>();
+        attachEventType<PhysInputEvent>();
+    }
+
+    using NetEventController::wrapInto;
+    using NetEventController::unwrap;
+};
+
+/**
+ * The accumulated time of each stage of a tick (in nanoseconds)
+ */
+struct StageTimes {
+    /** The time spent in ObstacleWorld::update on the host */
+    Uint64 update;
+    /** The time spent packing snapshots on the host */
+    Uint64 pack;
+    /** The time spent serializing the snapshots */
+    Uint64 serialize;
+    /** The time spent deserializing and applying the snapshots on the client */
+    Uint64 receive;
+    /** The time spent interpolating on the client */
+    Uint64 interpolate;
+    /** The total size of the serialized snapshots */
+    Uint64 bytes;
+
+    /** Creates a record with every time zeroed */
+    StageTimes() : update(0), pack(0), serialize(0), receive(0), interpolate(0), bytes(0) {}
+};
+
+/**
+ * Returns a headless world with the given number of shared obstacles.
+ *
+ * The obstacles cycle through boxes, wheels and hexagons, and are laid out
+ * in a grid so that none of them touch at first. Every obstacle has a small
+ * velocity, so that they spread out and collide over time. The world has no
+ * gravity, so that the obstacles do not simply fall out of it. Worlds created
+ * with the same arguments have the same obstacle ids.
+ *
+ * @param objects   The number of obstacles
+ * @param owned     Whether the obstacles are owned by this client
+ *
+ * @return a headless world with the given number of shared obstacles.
+ */
+static std::shared_ptr<ObstacleWorld> make_world(size_t objects, bool owned) {
+    float width  = GRID_WIDTH*GRID_SPACING;
+    float height = (float)(objects/GRID_WIDTH+1)*GRID_SPACING;
+    auto world = ObstacleWorld::alloc(Rect(-width,-height,3*width,3*height),Vec2::ZERO);
+    world->setShortUID(HOST_UID);
+
+    PolyFactory factory;
+    Poly2 hexagon = factory.makeNgon(Vec2::ZERO,0.5f,6);
+    for(size_t ii = 0; ii < objects; ii++) {
+        Vec2 pos((float)(ii % GRID_WIDTH),(float)(ii / GRID_WIDTH));
+        pos = pos*GRID_SPACING+Vec2(GRID_SPACING,GRID_SPACING)/2;
+
+        std::shared_ptr<Obstacle> obj;
+        switch (ii % 3) {
+            case 0:
+                obj = BoxObstacle::alloc(pos,Size(1,1));
+                break;
+            case 1:
+                obj = WheelObstacle::alloc(pos,0.5f);
+                break;
+            default:
+                obj = PolygonObstacle::alloc(hexagon,pos);
+                break;
+        }
+        obj->setShared(true);
+        if (owned) {
+            obj->setOwned(0);
+        }
+        obj->setLinearVelocity(Vec2((float)(ii % 7)-3.0f,(float)(ii % 5)-2.0f));
+        obj->setAngularVelocity((float)(ii % 3));
+        world->addObstacle(obj);
+    }
+    return world;
+}
+
+/**
+ * Returns the nanoseconds since the given time.
+ *
+ * @param start The starting time
+ *
+ * @return the nanoseconds since the given time.
+ */
+static Uint64 elapsed(std::chrono::steady_clock::time_point start) {
+    auto end = std::chrono::steady_clock::now();
+    return (Uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(end-start).count();
+}
+
+#pragma mark -
+#pragma mark Benchmark
+/**
+ * Runs a host and a client with the given number of obstacles.
+ *
+ * The step and post-update times come from the profiler of the host world
+ * (see {@link ObstacleWorld#getProfile}), so they are rolling averages over
+ * the last second of ticks. Every other stage is timed here.
+ *
+ * @param app       The application for the game tick
+ * @param objects   The number of obstacles
+ * @param ticks     The number of measured ticks
+ * @param out       The file to write the result to
+ */
+static void bench(Application* app, size_t objects, Uint32 ticks, FILE* out) {
+    typedef std::chrono::steady_clock clock;
+    auto hostWorld = make_world(objects,true);
+    auto clientWorld = make_world(objects,false);
+
+    auto host = NetPhysicsController::alloc();
+    host->init(hostWorld,HOST_UID,true,nullptr);
+    auto client = NetPhysicsController::alloc();
+    client->init(clientWorld,CLIENT_UID,false,nullptr);
+
+    auto network = std::make_shared<BenchController>(app);
+    auto hostName = std::make_shared<const std::string>("host");
+    auto clientName = std::make_shared<const std::string>("client");
+    std::vector<std::byte> wrapped;
+
+    StageTimes times;
+    for(Uint32 tick = 0; tick < ticks+BENCH_WARMUP; tick++) {
+        auto start = clock::now();
+        hostWorld->update(STEP_SIZE);
+        times.update += elapsed(start);
+
+        start = clock::now();
+        host->fixedUpdate();
+        host->packPhysSync(NetPhysicsController::FULL_SYNC);
+        times.pack += elapsed(start);
+
+        // Only the snapshots travel to the client
+        std::vector<std::vector<std::byte>> messages;
+        start = clock::now();
+        for(auto it = host->getOutEvents().begin(); it != host->getOutEvents().end(); ++it) {
+            if (std::dynamic_pointer_cast<PhysSyncEvent>(*it) != nullptr) {
+                network->wrapInto(*it,wrapped);
+                times.bytes += wrapped.size();
+                messages.push_back(wrapped);
+            }
+        }
+        times.serialize += elapsed(start);
+        host->getOutEvents().clear();
+
+        start = clock::now();
+        for(auto it = messages.begin(); it != messages.end(); ++it) {
+            auto event = std::dynamic_pointer_cast<PhysSyncEvent>(network->unwrap(*it,HOST_UID,hostName));
+            if (event != nullptr) {
+                client->processPhysSyncEvent(event);
+            }
+        }
+        times.receive += elapsed(start);
+
+        start = clock::now();
+        client->fixedUpdate();
+        times.interpolate += elapsed(start);
+        clientWorld->update(STEP_SIZE);
+        client->getOutEvents().clear();
+
+        // Acknowledge the snapshots so that the host sends deltas
+        network->wrapInto(client->allocInputEvent(tick),wrapped);
+        auto input = std::dynamic_pointer_cast<PhysInputEvent>(network->unwrap(wrapped,CLIENT_UID,clientName));
+        if (input != nullptr) {
+            host->processPhysInputEvent(input);
+        }
+
+        if (tick < BENCH_WARMUP) {
+            times = StageTimes();
+        }
+    }
+
+    PhysicsProfile profile = hostWorld->getProfile();
+    double scale = 1.0/(ticks*1000000.0);
+    fprintf(out,"{\"benchmark\":\"physics\",\"objects\":%zu,\"ticks\":%u,\"contacts\":%zu,"
+            "\"update_ms\":%.3f,\"step_ms\":%.3f,\"post_ms\":%.3f,\"pack_ms\":%.3f,"
+            "\"serialize_ms\":%.3f,\"receive_ms\":%.3f,\"interpolate_ms\":%.3f,"
+            "\"bytes_per_tick\":%.1f}\n",
+            objects,ticks,profile.contacts,
+            times.update*scale,profile.step,profile.postStep,times.pack*scale,
+            times.serialize*scale,times.receive*scale,times.interpolate*scale,
+            (double)times.bytes/ticks);
+    fflush(out);
+
+    host->dispose();
+    client->dispose();
+    hostWorld->dispose();
+    clientWorld->dispose();
+}
+
+#pragma mark -
+#pragma mark Main
+/**
+ * Runs the benchmark at 100, 1k, 5k, and 20k obstacles.
+ *
+ * @param argc  The number of arguments
+ * @param argv  The arguments (the ticks per size and the output file)
+ */
+int main(int argc, char* argv[]) {
+    Uint32 ticks = BENCH_TICKS;
+    FILE* out = stdout;
+    if (argc > 1) {
+        ticks = (Uint32)std::max(std::strtoul(argv[1],nullptr,10),1UL);
+    }
+    if (argc > 2) {
+        out = fopen(argv[2],"w");
+        if (out == nullptr) {
+            fprintf(stderr,"Could not open '%s'\n",argv[2]);
+            return 1;
+        }
+    }
+
+    // Never initialized, so there is no window
+    Application app;
+    const size_t sizes[] = { 100, 1000, 5000, 20000 };
+    for(size_t size : sizes) {
+        bench(&app,size,ticks,out);
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
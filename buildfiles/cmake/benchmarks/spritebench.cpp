@@ -0,0 +1,447 @@
+//
+//  spritebench.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This is a throughput benchmark suite for the SpriteBatch. Every scenario
+//  renders into an offscreen RenderTarget, so the results do not depend on
+//  the size of the window or the refresh rate of the display. The scenarios
+//  are textured quads from one texture and from several textures, polygons,
+//  text, and gradient and scissor churn, each at 1k and 10k sprites.
+//
+//  Every result is printed as a single line of JSON, so that the output can be
+//  collected and compared between builds to catch regressions. Usage:
+//
+//      spritebench [frames] [font] [file]
+//
+//  where frames is the number of measured frames per scenario (default 120),
+//  font is a TrueType font for the text scenario (skipped if absent), and file
+//  is where the results are written (default is the log). The benchmark uses
+//  the normal application loop, so it also runs on device, where the results
+//  go to the device log.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/base/CUApplication.h>
+#include <cugl/render/CURenderBase.h>
+#include <cugl/render/CUSpriteBatch.h>
+#include <cugl/render/CURenderTarget.h>
+#include <cugl/render/CUTexture.h>
+#include <cugl/render/CUGradient.h>
+#include <cugl/render/CUScissor.h>
+#include <cugl/render/CUFont.h>
+#include <cugl/render/CUTextLayout.h>
+#include <cugl/math/polygon/CUPolyFactory.h>
+#include <cugl/util/CUDebug.h>
+#include <functional>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace cugl;
+
+/** The default number of measured frames per scenario */
+#define BENCH_FRAMES    120
+/** The number of unmeasured frames before each scenario */
+#define BENCH_WARMUP    10
+/** The width of the offscreen target */
+#define TARGET_WIDTH    1920
+/** The height of the offscreen target */
+#define TARGET_HEIGHT   1080
+/** The number of textures in the multi-texture scenario */
+#define TEXTURE_COUNT   8
+/** The size of each generated texture */
+#define TEXTURE_SIZE    64
+/** The size of each sprite on screen */
+#define SPRITE_SIZE     24.0f
+/** The number of sprites drawn between scissor or gradient changes */
+#define CHURN_RUN       4
+
+#pragma mark -
+#pragma mark Scenarios
+/**
+ * A single benchmark scenario.
+ *
+ * The function body draws every sprite of one frame between the begin and
+ * end of the sprite batch.
+ */
+struct Scenario {
+    /** The scenario name */
+    std::string name;
+    /** The number of sprites drawn each frame */
+    size_t sprites;
+    /** The draw commands for a single frame */
+    std::function<void(const std::shared_ptr<SpriteBatch>&)> body;
+};
+
+/**
+ * Returns the position of the given sprite on the offscreen target.
+ *
+ * The sprites are spread over a grid that covers the target, so that they
+ * overlap when there are many of them (as they would in a game).
+ *
+ * @param index The sprite index
+ *
+ * @return the position of the given sprite on the offscreen target.
+ */
+static Vec2 sprite_position(size_t index) {
+    const size_t cols = (size_t)(TARGET_WIDTH/SPRITE_SIZE);
+    const size_t rows = (size_t)(TARGET_HEIGHT/SPRITE_SIZE);
+    size_t cell = (index*7919) % (cols*rows);
+    return Vec2((cell % cols)*SPRITE_SIZE,(cell / cols)*SPRITE_SIZE);
+}
+
+/**
+ * Returns a generated texture with a checkerboard in the given color.
+ *
+ * @param color The color of the checkerboard
+ *
+ * @return a generated texture with a checkerboard in the given color.
+ */
+static std::shared_ptr<Texture> make_texture(Color4 color) {
+    std::vector<Uint32> data(TEXTURE_SIZE*TEXTURE_SIZE);
+    Uint32 packed = color.getRGBA();
+    for(int yy = 0; yy < TEXTURE_SIZE; yy++) {
+        for(int xx = 0; xx < TEXTURE_SIZE; xx++) {
+            data[yy*TEXTURE_SIZE+xx] = ((xx/8+yy/8) % 2) ? packed : 0xffffffff;
+        }
+    }
+    return Texture::allocWithData(data.data(),TEXTURE_SIZE,TEXTURE_SIZE);
+}
+
+#pragma mark -
+#pragma mark Application
+/**
+ * The application that runs each scenario in turn.
+ *
+ * Each scenario gets a few frames to warm up the caches and the sprite batch,
+ * and is then measured over the given number of frames. The CPU time is the
+ * time from the start of the batch to the end of the batch. The GPU time is
+ * how long glFinish waits afterwards, so it is the work the CPU did not hide.
+ */
+class SpriteBench : public Application {
+protected:
+    /** The sprite batch under test */
+    std::shared_ptr<SpriteBatch> _batch;
+    /** The offscreen target */
+    std::shared_ptr<RenderTarget> _target;
+    /** The scenarios to run */
+    std::vector<Scenario> _scenarios;
+    /** The current scenario */
+    size_t _current;
+    /** The frames drawn in the current scenario (including the warmup) */
+    Uint32 _frame;
+    /** The CPU time of the measured frames in the current scenario (in ns) */
+    Uint64 _cputime;
+    /** The GPU wait of the measured frames in the current scenario (in ns) */
+    Uint64 _gputime;
+    /** The draw calls of the measured frames in the current scenario */
+    Uint64 _calls;
+    /** The state changes of the measured frames in the current scenario */
+    Uint64 _changes;
+
+    /** The generated textures */
+    std::vector<std::shared_ptr<Texture>> _textures;
+    /** The gradients for the gradient churn */
+    std::vector<std::shared_ptr<Gradient>> _gradients;
+    /** The scissors for the scissor churn */
+    std::vector<std::shared_ptr<Scissor>> _scissors;
+    /** The polygon for the polygon scenario */
+    Poly2 _poly;
+    /** The text layouts for the text scenario */
+    std::vector<std::shared_ptr<TextLayout>> _layouts;
+
+public:
+    /** The number of measured frames per scenario */
+    Uint32 frames;
+    /** The font file for the text scenario (empty to skip) */
+    std::string fontfile;
+    /** The file to write results to (nullptr for the log) */
+    FILE* out;
+
+    /**
+     * Creates a benchmark with the default settings.
+     */
+    SpriteBench() : Application(), _current(0), _frame(0),
+    _cputime(0), _gputime(0), _calls(0), _changes(0),
+    frames(BENCH_FRAMES), out(nullptr) {}
+
+    /**
+     * Allocates the batch, the target, and the assets for each scenario.
+     */
+    virtual void onStartup() override {
+        _batch  = SpriteBatch::alloc();
+        _target = RenderTarget::alloc(TARGET_WIDTH,TARGET_HEIGHT);
+        _batch->setPerspective(Mat4::createOrthographicOffCenter(0,TARGET_WIDTH,0,TARGET_HEIGHT,-1,1));
+
+        for(int ii = 0; ii < TEXTURE_COUNT; ii++) {
+            float hue = (float)ii/TEXTURE_COUNT;
+            _textures.push_back(make_texture(Color4f(hue,1-hue,0.5f,1)));
+        }
+        _gradients.push_back(Gradient::allocLinear(Color4::RED,Color4::BLUE,Vec2(0,0),Vec2(1,1)));
+        _gradients.push_back(Gradient::allocRadial(Color4::YELLOW,Color4::GREEN,Vec2(0.5f,0.5f),0.5f));
+        _scissors.push_back(Scissor::alloc(Rect(0,0,TARGET_WIDTH*0.75f,TARGET_HEIGHT)));
+        _scissors.push_back(Scissor::alloc(Rect(TARGET_WIDTH*0.25f,0,TARGET_WIDTH*0.75f,TARGET_HEIGHT)));
+        PolyFactory factory;
+        _poly = factory.makeCircle(Vec2::ZERO,SPRITE_SIZE/2);
+
+        std::shared_ptr<Font> font = nullptr;
+        if (!fontfile.empty()) {
+            font = Font::alloc(fontfile,16);
+            if (font == nullptr) {
+                CULogError("Could not load font '%s'",fontfile.c_str());
+            }
+        }
+
+        const size_t sizes[] = { 1000, 10000 };
+        for(size_t size : sizes) {
+            addQuads(size);
+            addPolygons(size);
+            addChurn(size);
+            if (font != nullptr) {
+                addText(font,size/10);
+            }
+        }
+        Application::onStartup();
+    }
+
+    /**
+     * Releases all of the benchmark resources.
+     */
+    virtual void onShutdown() override {
+        _scenarios.clear();
+        _layouts.clear();
+        _scissors.clear();
+        _gradients.clear();
+        _textures.clear();
+        _target = nullptr;
+        _batch = nullptr;
+        Application::onShutdown();
+    }
+
+    /**
+     * Draws a single frame of the current scenario.
+     */
+    virtual void draw() override {
+        typedef std::chrono::steady_clock clock;
+        if (_current >= _scenarios.size()) {
+            quit();
+            return;
+        }
+
+        const Scenario& scene = _scenarios[_current];
+        _target->begin();
+        auto start = clock::now();
+        _batch->begin();
+        scene.body(_batch);
+        _batch->end();
+        auto middle = clock::now();
+        glFinish();
+        auto end = clock::now();
+        _target->end();
+
+        if (_frame >= BENCH_WARMUP) {
+            _cputime += (Uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(middle-start).count();
+            _gputime += (Uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(end-middle).count();
+            _calls   += _batch->getCallsMade();
+            _changes += _batch->getStateChanges();
+        }
+        _frame++;
+        if (_frame >= BENCH_WARMUP+frames) {
+            report(scene);
+            _current++;
+            _frame = 0;
+            _cputime = _gputime = _calls = _changes = 0;
+        }
+    }
+
+private:
+    /**
+     * Writes the result of the given scenario as a line of JSON.
+     *
+     * @param scene The completed scenario
+     */
+    void report(const Scenario& scene) {
+        double cpums = _cputime/(frames*1000000.0);
+        double gpums = _gputime/(frames*1000000.0);
+        double rate  = scene.sprites*frames/((_cputime+_gputime)/1000000000.0);
+        char line[512];
+        snprintf(line,sizeof(line),"{\"benchmark\":\"%s\",\"sprites\":%zu,\"frames\":%u,"
+                 "\"cpu_ms\":%.3f,\"gpu_wait_ms\":%.3f,\"sprites_per_sec\":%.0f,"
+                 "\"draw_calls\":%.1f,\"state_changes\":%.1f}",
+                 scene.name.c_str(),scene.sprites,frames,cpums,gpums,rate,
+                 (double)_calls/frames,(double)_changes/frames);
+        if (out != nullptr) {
+            fprintf(out,"%s\n",line);
+            fflush(out);
+        } else {
+            CULog("%s",line);
+        }
+    }
+
+    /**
+     * Adds the textured quad scenarios for the given number of sprites.
+     *
+     * One scenario draws every quad from the same texture. The other cycles
+     * through {@link TEXTURE_COUNT} textures, which is the worst case for
+     * batching (every quad changes the texture).
+     *
+     * @param count The number of sprites
+     */
+    void addQuads(size_t count) {
+        _scenarios.push_back({"quads/1-texture",count,[=](const std::shared_ptr<SpriteBatch>& batch) {
+            const std::shared_ptr<Texture>& texture = _textures[0];
+            for(size_t ii = 0; ii < count; ii++) {
+                batch->draw(texture,Rect(sprite_position(ii),Size(SPRITE_SIZE,SPRITE_SIZE)));
+            }
+        }});
+        _scenarios.push_back({"quads/"+std::to_string(TEXTURE_COUNT)+"-textures",count,
+            [=](const std::shared_ptr<SpriteBatch>& batch) {
+            for(size_t ii = 0; ii < count; ii++) {
+                batch->draw(_textures[ii % TEXTURE_COUNT],Rect(sprite_position(ii),Size(SPRITE_SIZE,SPRITE_SIZE)));
+            }
+        }});
+    }
+
+    /**
+     * Adds the polygon scenario for the given number of sprites.
+     *
+     * Every sprite is an untextured circle drawn with fill(Poly2).
+     *
+     * @param count The number of sprites
+     */
+    void addPolygons(size_t count) {
+        _scenarios.push_back({"fill/poly2",count,[=](const std::shared_ptr<SpriteBatch>& batch) {
+            batch->setTexture(nullptr);
+            for(size_t ii = 0; ii < count; ii++) {
+                batch->setColor(ii % 2 ? Color4::WHITE : Color4::CORNFLOWER);
+                batch->fill(_poly,sprite_position(ii));
+            }
+        }});
+    }
+
+    /**
+     * Adds the gradient and scissor churn scenarios for the given number of sprites.
+     *
+     * Both scenarios draw untextured quads, and change the gradient (or the
+     * scissor) every {@link CHURN_RUN} quads.
+     *
+     * @param count The number of sprites
+     */
+    void addChurn(size_t count) {
+        _scenarios.push_back({"churn/gradient",count,[=](const std::shared_ptr<SpriteBatch>& batch) {
+            batch->setTexture(nullptr);
+            batch->setColor(Color4::WHITE);
+            for(size_t ii = 0; ii < count; ii++) {
+                if (ii % CHURN_RUN == 0) {
+                    batch->setGradient(_gradients[(ii/CHURN_RUN) % _gradients.size()]);
+                }
+                batch->fill(Rect(sprite_position(ii),Size(SPRITE_SIZE,SPRITE_SIZE)));
+            }
+            batch->setGradient(nullptr);
+        }});
+        _scenarios.push_back({"churn/scissor",count,[=](const std::shared_ptr<SpriteBatch>& batch) {
+            batch->setTexture(nullptr);
+            batch->setColor(Color4::WHITE);
+            for(size_t ii = 0; ii < count; ii++) {
+                if (ii % CHURN_RUN == 0) {
+                    batch->setScissor(_scissors[(ii/CHURN_RUN) % _scissors.size()]);
+                }
+                batch->fill(Rect(sprite_position(ii),Size(SPRITE_SIZE,SPRITE_SIZE)));
+            }
+            batch->setScissor(nullptr);
+        }});
+    }
+
+    /**
+     * Adds the text scenario for the given number of text layouts.
+     *
+     * Each layout is a short line of text, and the sprite count of the
+     * scenario is the number of glyphs drawn.
+     *
+     * @param font  The font for the text
+     * @param count The number of text layouts
+     */
+    void addText(const std::shared_ptr<Font>& font, size_t count) {
+        size_t glyphs = 0;
+        size_t first = _layouts.size();
+        for(size_t ii = 0; ii < count; ii++) {
+            std::string text = "Sprite batch text "+std::to_string(ii);
+            auto layout = TextLayout::allocWithText(text,font);
+            layout->layout();
+            _layouts.push_back(layout);
+            for(char c : text) {
+                glyphs += (c != ' ');
+            }
+        }
+        _scenarios.push_back({"text/layout",glyphs,[=](const std::shared_ptr<SpriteBatch>& batch) {
+            batch->setColor(Color4::WHITE);
+            for(size_t ii = 0; ii < count; ii++) {
+                batch->drawText(_layouts[first+ii],sprite_position(ii*TEXTURE_COUNT));
+            }
+        }});
+    }
+};
+
+#pragma mark -
+#pragma mark Main
+/**
+ * Runs every scenario until done.
+ *
+ * @param argc  The number of arguments
+ * @param argv  The arguments (the frames per scenario, the font, and the output file)
+ */
+int main(int argc, char* argv[]) {
+    SpriteBench app;
+    if (argc > 1) {
+        app.frames = (Uint32)std::max(std::strtoul(argv[1],nullptr,10),1UL);
+    }
+    if (argc > 2) {
+        app.fontfile = argv[2];
+    }
+    if (argc > 3) {
+        app.out = fopen(argv[3],"w");
+        if (app.out == nullptr) {
+            fprintf(stderr,"Could not open '%s'\n",argv[3]);
+            return 1;
+        }
+    }
+
+    // The window is only needed for the OpenGL context
+    app.setName("SpriteBench");
+    app.setDisplaySize(640,360);
+    app.setVSync(false);
+    if (!app.init()) {
+        return 1;
+    }
+
+    app.onStartup();
+    while (app.step());
+    app.onShutdown();
+
+    if (app.out != nullptr) {
+        fclose(app.out);
+    }
+    return 0;
+}
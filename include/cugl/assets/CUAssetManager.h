@@ -11,6 +11,11 @@
 //  elected not to do that.  This way you can use a different managers for
 //  different player modes.
 //
+//  Asynchronous loading runs across several threads. Asset categories are
+//  ordered by the loader priorities, so that a category only starts once the
+//  categories it depends on have finished. The main-thread half of loading is
+//  run from a queue that is limited to a per-frame time budget.
+//
 //  This class uses our standard shared-pointer architecture.
 //
 //  1. The constructor does not perform any initialization; it just sets all
@@ -52,6 +57,8 @@
 #include <cugl/assets/CULoader.h>
 #include <typeinfo>
 #include <atomic>
+#include <mutex>
+#include <deque>
 
 
 namespace cugl {
@@ -77,6 +84,15 @@ namespace cugl {
  * still be used after an asset manager is destroyed, provided that they still
  * have a smart pointer referencing them.
  *
+ * Asynchronous loads use a pool of worker threads (by default one fewer than
+ * the number of cores), so assets of the same priority load in parallel.
+ * Loaders that are not thread-safe (see {@link BaseLoader#isSerial}) share a
+ * separate single thread. The loader priorities form the dependencies of an
+ * asset directory: a category only starts once every category of a higher
+ * priority has finished, including its work on the main thread. That work
+ * is queued with this manager and is limited to the frame budget (see
+ * {@link setFrameBudget}), so that a large directory does not stall a frame.
+ *
  * IMPORTANT: This class is not even remotely thread-safe.  Do not call any of
  * these methods outside of the main CUGL thread.
  */
@@ -93,14 +109,46 @@ protected:
     std::unordered_map<std::string,size_t> _jsonKeys;
     /** The priorities for each JSON key */
     std::unordered_map<std::string,Uint32> _priority;
-    /** The central thread for managing all of the loaders */
+    /** The worker threads for managing all of the loaders */
     std::shared_ptr<ThreadPool> _workers;
+    /** The single thread for loaders that are not thread-safe */
+    std::shared_ptr<ThreadPool> _serial;
 
-    /** State variable to manage reading JSON directories */
-    bool _preload;
-    
-    /** Wait variable to create a load barrier for directories. */
-    std::atomic<bool> _wait;
+    /** The number of directories with categories still to be started */
+    std::atomic<Uint32> _preload;
+
+    /** The time to spend materializing assets each frame, in microseconds */
+    Uint32 _budget;
+    /** The pending main-thread materialization callbacks */
+    std::deque<std::function<bool()>> _finish;
+    /** A mutex lock for the materialization queue */
+    std::mutex _mutex;
+    /** The id of the callback draining the queue (0 if not scheduled) */
+    Uint32 _drainer;
+
+    /** Whether to reload assets when their files change */
+    bool _watching;
+    /** The time between checks for changed files, in milliseconds */
+    Uint32 _period;
+    /** The id of the callback checking for changed files (0 if not scheduled) */
+    Uint32 _watcher;
+    /** Whether a check for changed files is in progress */
+    bool _scanning;
+    /** The last known modification time of each watched file */
+    std::unordered_map<std::string,Uint64> _stamps;
+    /** The callback invoked after each hot reload */
+    LoaderCallback _onreload;
+
+    /**
+     * Runs the queued materialization callbacks for this frame
+     *
+     * This method is called on the main thread once each animation frame
+     * while there are queued callbacks. It stops once the frame budget is
+     * exceeded, leaving the remaining callbacks for the next frame.
+     *
+     * @return true if there are callbacks remaining
+     */
+    bool drain();
 
     /**
      * Synchronously reads an asset category from a JSON file
@@ -146,7 +194,7 @@ protected:
      * As an asynchronous read, all asset loading will take place outside of
      * the main thread.  However, assets such as fonts and textures will need
      * the OpenGL context to complete, so part of their asset loading may take
-     * place in the main thread via the {@link Application#schedule} interface.
+     * place in the main thread, limited by the frame budget {@see setFrameBudget}.
      * You may either poll this interface to determine when the assets are 
      * loaded or use optional callbacks.
      *
@@ -177,32 +225,83 @@ protected:
     bool purgeCategory(size_t hash, const std::shared_ptr<JsonValue>& json);
 
     /**
-     * Synchronizes the asset manager to wait until all assets have finished.
+     * Starts the next stage of the given asset directory
+     *
+     * The categories of an asset directory are grouped into stages by the
+     * priority of their loaders. This method is called on the main thread
+     * (once a frame) until every stage has started. A stage only starts
+     * once every loader of the previous stages has no pending assets.
      *
-     * This method is necessary for assets whose construction depends on
-     * previously loaded assets (e.g. scene graphs).  In the current architecture,
-     * this method is only correct if the asset manager loads assets in a
-     * single thread.
+     * @param stages    The remaining stages of the directory
+     * @param started   The loaders of the stages already started
+     * @param callback  An optional callback after each asset is loaded
+     *
+     * @return true if there are stages remaining
      */
-    void sync();
-    
+    bool advance(const std::shared_ptr<std::deque<std::vector<std::shared_ptr<JsonValue>>>>& stages,
+                 const std::shared_ptr<std::vector<std::shared_ptr<BaseLoader>>>& started,
+                 LoaderCallback callback);
+
     /**
-     * Blocks the asset manager until the next animation frame.
+     * Returns the files read by the given loader to load the given asset
      *
-     * Any assets queued after a block will not be added to thread pool
-     * until at least one animation frame has passed.  This method is used
-     * to implement the {@link sync()} method.
+     * The paths are normalized, and relative to the asset directory.
+     *
+     * @param loader    The loader for the asset
+     * @param source    The source of the asset
+     *
+     * @return the files read by the given loader to load the given asset
      */
-    void block();
+    std::vector<std::string> locate(const std::shared_ptr<BaseLoader>& loader,
+                                    const BaseLoader::Source& source) const;
 
     /**
-     * Resumes a previously blocked the asset manager.
+     * Starts a check for changed asset files
+     *
+     * This method is called on the main thread every reload period while
+     * hot reloading is active. The files are checked by a worker thread.
+     * Any changed files are reloaded on the main thread, within the frame
+     * budget, by {@link invalidate}.
+     *
+     * @return true if hot reloading is still active
+     */
+    bool poll();
+
+    /**
+     * Reloads the assets of every file that changed since the last check
+     *
+     * A file seen for the first time is recorded, but not reloaded.
      *
-     * Any assets queued after a block will not be added to thread pool
-     * until at least one animation frame has passed.  This method is used
-     * to implement the {@link sync()} method.
+     * @param files     The watched files
+     * @param stamps    The modification time of each file
      */
-    void resume();
+    void invalidate(const std::vector<std::string>& files, const std::vector<Uint64>& stamps);
+
+    /**
+     * Synchronously reloads every asset read from the given files
+     *
+     * The assets are reloaded in loader priority order, so that an asset is
+     * always reloaded before any asset of a lower priority.
+     *
+     * @param files     The normalized file paths, relative to the asset directory
+     *
+     * @return the number of assets successfully reloaded
+     */
+    size_t reloadFiles(const std::vector<std::string>& files);
+
+    /**
+     * Synchronously reloads the given asset, rebinding its dependents
+     *
+     * If the asset is successfully reloaded, every attached loader is given
+     * the chance to replace the previous asset with the new one (see
+     * {@link BaseLoader#rebind}). The reload callback is invoked either way.
+     *
+     * @param hash  The hash of the asset type
+     * @param key   The key associated with the asset
+     *
+     * @return true if the asset was successfully reloaded
+     */
+    bool refresh(size_t hash, const std::string key);
     
     
 #pragma mark -
@@ -214,7 +313,8 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an asset 
      * manager on the heap, use one of the static constructors instead.
      */
-    AssetManager() : _preload(false), _wait(false) {}
+    AssetManager() : _preload(0), _budget(0), _drainer(0), _watching(false),
+    _period(500), _watcher(0), _scanning(false) {}
     
     /**
      * Deletes this asset manager, disposing of all resources.
@@ -233,10 +333,10 @@ public:
     /**
      * Initializes a new asset manager.
      *
-     * The asset manager has a single thread, as some of the asset loading
-     * operations (particularly fonts) cannot be run in multiple threads
-     * simultaneously. However, it will run in a distinct thread from the
-     * main application.
+     * The asset manager has one fewer worker thread than the number of cores
+     * (but always at least one). Loaders that are not thread-safe, such as
+     * fonts, share an additional single thread (see {@link BaseLoader#isSerial}).
+     * All of these threads are distinct from the main application thread.
      *
      * This initializer does not attach any loaders.  It simply creates an 
      * object that is ready to accept loader objects.
@@ -245,27 +345,64 @@ public:
      */
     bool init();
 
+    /**
+     * Initializes a new asset manager with the given number of worker threads.
+     *
+     * Loaders that are not thread-safe, such as fonts, share an additional
+     * single thread (see {@link BaseLoader#isSerial}), unless there is only
+     * one worker thread. All of these threads are distinct from the main
+     * application thread.
+     *
+     * This initializer does not attach any loaders.  It simply creates an
+     * object that is ready to accept loader objects.
+     *
+     * @param threads   The number of worker threads
+     *
+     * @return true if the asset manager was initialized successfully
+     */
+    bool init(Uint32 threads);
+
     
 #pragma mark -
 #pragma mark Static Constructors
     /**
      * Returns a newly allocated asset manager.
      *
-     * The asset manager has a single thread, as some of the asset loading
-     * operations (particularly fonts) cannot be run in multiple threads
-     * simultaneously. However, it will run in a distinct thread from the
-     * main application.
+     * The asset manager has one fewer worker thread than the number of cores
+     * (but always at least one). Loaders that are not thread-safe, such as
+     * fonts, share an additional single thread (see {@link BaseLoader#isSerial}).
+     * All of these threads are distinct from the main application thread.
      *
      * This constructor does not attach any loaders.  It simply creates an
      * object that is ready to accept loader objects.
      *
-     * @return a newly allocated asset manager with two auxiliary threads.
+     * @return a newly allocated asset manager.
      */
     static std::shared_ptr<AssetManager> alloc() {
         std::shared_ptr<AssetManager> result = std::make_shared<AssetManager>();
         return (result->init() ? result : nullptr);
     }
 
+    /**
+     * Returns a newly allocated asset manager with the given number of worker threads.
+     *
+     * Loaders that are not thread-safe, such as fonts, share an additional
+     * single thread (see {@link BaseLoader#isSerial}), unless there is only
+     * one worker thread. All of these threads are distinct from the main
+     * application thread.
+     *
+     * This constructor does not attach any loaders.  It simply creates an
+     * object that is ready to accept loader objects.
+     *
+     * @param threads   The number of worker threads
+     *
+     * @return a newly allocated asset manager with the given number of worker threads.
+     */
+    static std::shared_ptr<AssetManager> alloc(Uint32 threads) {
+        std::shared_ptr<AssetManager> result = std::make_shared<AssetManager>();
+        return (result->init(threads) ? result : nullptr);
+    }
+
 #pragma mark -
 #pragma mark Loader Management
     /**
@@ -295,7 +432,7 @@ public:
             return false;
         }
         
-        loader->setThreadPool(_workers);
+        loader->setThreadPool(loader->isSerial() ? _serial : _workers);
         _handlers[hash] = loader;
         
         // Do not allow key collisions
@@ -447,6 +584,139 @@ public:
         return (size == 0 ? 0.0f : ((float)loadCount())/size);
     }
 
+#pragma mark -
+#pragma mark Materialization
+    /**
+     * Returns the time to spend materializing assets each frame, in microseconds.
+     *
+     * Asynchronous loading finishes each asset on the main thread (e.g. to
+     * create an OpenGL texture). These callbacks are queued with the asset
+     * manager, which runs as many of them as it can each frame, stopping once
+     * this time is exceeded. At least one callback is always run each frame.
+     * A value of 0 (the default) runs every queued callback each frame.
+     *
+     * @return the time to spend materializing assets each frame, in microseconds.
+     */
+    Uint32 getFrameBudget() const { return _budget; }
+
+    /**
+     * Sets the time to spend materializing assets each frame, in microseconds.
+     *
+     * Asynchronous loading finishes each asset on the main thread (e.g. to
+     * create an OpenGL texture). These callbacks are queued with the asset
+     * manager, which runs as many of them as it can each frame, stopping once
+     * this time is exceeded. At least one callback is always run each frame.
+     * A value of 0 (the default) runs every queued callback each frame.
+     *
+     * @param micros    The time to spend materializing assets each frame
+     */
+    void setFrameBudget(Uint32 micros) { _budget = micros; }
+
+    /**
+     * Queues the given callback to run on the main thread within the frame budget
+     *
+     * This method is used by the attached loaders to materialize assets. The
+     * callbacks are run in the order that they are queued. As with the method
+     * {@link Application#schedule}, a callback that returns true is run again.
+     * It is placed at the back of the queue.
+     *
+     * This method is safe to call from any thread.
+     *
+     * @param callback  The materialization callback
+     */
+    void schedule(std::function<bool()> callback);
+
+#pragma mark -
+#pragma mark Memory Management
+    /**
+     * Returns the estimated memory used by the assets of type T in bytes
+     *
+     * The type of the asset is specified by the template parameter T. For
+     * GPU assets, such as textures, this is an estimate of the memory used
+     * on the GPU. See {@link BaseLoader#getMemoryUsage}.
+     *
+     * @return the estimated memory used by the assets of type T in bytes
+     */
+    template<typename T>
+    size_t getMemoryUsage() const {
+        size_t hash = typeid(T).hash_code();
+        auto it = _handlers.find(hash);
+        if (it == _handlers.end()) {
+            CUAssertLog(false, "No loader assigned for given type");
+            return 0;
+        }
+        return it->second->getMemoryUsage();
+    }
+
+    /**
+     * Returns the estimated memory used by all assets in bytes
+     *
+     * This is the sum of the memory used by each attached loader. See
+     * {@link BaseLoader#getMemoryUsage}.
+     *
+     * @return the estimated memory used by all assets in bytes
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * Returns the memory limit for the assets of type T in bytes
+     *
+     * The type of the asset is specified by the template parameter T. A
+     * value of 0 means that there is no limit, which is the default. See
+     * {@link BaseLoader#getMemoryLimit}.
+     *
+     * @return the memory limit for the assets of type T in bytes
+     */
+    template<typename T>
+    size_t getMemoryLimit() const {
+        size_t hash = typeid(T).hash_code();
+        auto it = _handlers.find(hash);
+        if (it == _handlers.end()) {
+            CUAssertLog(false, "No loader assigned for given type");
+            return 0;
+        }
+        return it->second->getMemoryLimit();
+    }
+
+    /**
+     * Sets the memory limit for the assets of type T in bytes
+     *
+     * The type of the asset is specified by the template parameter T. When
+     * the assets of this type exceed the limit, {@link trim} evicts the least
+     * recently used assets that are referenced by nothing but this manager.
+     * An evicted asset is reloaded (synchronously) the next time it is
+     * requested with {@link get}. A value of 0 means that there is no limit,
+     * which is the default.
+     *
+     * @param bytes The memory limit for the assets of type T in bytes
+     */
+    template<typename T>
+    void setMemoryLimit(size_t bytes) {
+        size_t hash = typeid(T).hash_code();
+        auto it = _handlers.find(hash);
+        if (it == _handlers.end()) {
+            CUAssertLog(false, "No loader assigned for given type");
+            return;
+        }
+        it->second->setMemoryLimit(bytes);
+    }
+
+    /**
+     * Evicts unused assets until every loader is within its memory limit
+     *
+     * Only assets that are referenced by nothing but this manager, and that
+     * were loaded from a file or directory entry, may be evicted. The least
+     * recently requested are evicted first. This method is called
+     * automatically at the end of {@link loadDirectory}, and whenever the
+     * materialization queue empties. It should also be called after a level
+     * transition releases its assets.
+     *
+     * This method should only be called on the main thread.
+     *
+     * @return the number of assets evicted
+     */
+    size_t trim();
+
     
 #pragma mark -
 #pragma mark Loading/Unloading
@@ -457,6 +727,9 @@ public:
      * the method is parameterized by the type, it is safe to reuse keys for
      * different types.  However, this is not recommended.
      *
+     * If the asset was evicted to meet a memory limit (see {@link trim}), it
+     * is reloaded synchronously by this method.
+     *
      * @param  key  The key to identify the given asset
      *
      * @return the asset for the given key.
@@ -671,7 +944,7 @@ public:
      * As an asynchronous load, all asset loading will take place outside of
      * the main thread.  However, assets such as fonts and textures will need
      * the OpenGL context to complete, so part of their asset loading may take
-     * place in the main thread via the {@link Application#schedule} interface.
+     * place in the main thread, limited by the frame budget {@see setFrameBudget}.
      * You may either poll this interface to determine when the assets are
      * loaded or use optional callbacks.
      *
@@ -710,7 +983,7 @@ public:
      * As an asynchronous load, all asset loading will take place outside of
      * the main thread.  However, assets such as fonts and textures will need
      * the OpenGL context to complete, so part of their asset loading may take
-     * place in the main thread via the {@link Application#schedule} interface.
+     * place in the main thread, limited by the frame budget {@see setFrameBudget}.
      * You may either poll this interface to determine when the assets are
      * loaded or use optional callbacks.
      *
@@ -748,6 +1021,130 @@ public:
      */
     bool unloadDirectory(const std::string directory);
 
+#pragma mark -
+#pragma mark Hot Reloading
+    /**
+     * Returns true if assets are reloaded when their files change
+     *
+     * Hot reloading is intended for development builds, so that assets can
+     * be edited without restarting the application. The asset files are
+     * checked every reload period (on a worker thread). Only the assets read
+     * from a changed file are reloaded, through their loaders. Dependent
+     * assets, such as scene graphs using a reloaded texture or font, are
+     * updated to use the new asset instead of being reloaded. See
+     * {@link BaseLoader#rebind}.
+     *
+     * Reloaded assets are new objects. Any other references to the previous
+     * asset must be updated with the reload callback (see
+     * {@link setReloadCallback}).
+     *
+     * Note that file times are only precise to the second, and that assets
+     * loaded from an asset bundle or the Android APK never change. By
+     * default, hot reloading is off.
+     *
+     * @return true if assets are reloaded when their files change
+     */
+    bool isHotReload() const { return _watching; }
+
+    /**
+     * Sets whether assets are reloaded when their files change
+     *
+     * Hot reloading is intended for development builds, so that assets can
+     * be edited without restarting the application. The asset files are
+     * checked every reload period (on a worker thread). Only the assets read
+     * from a changed file are reloaded, through their loaders. Dependent
+     * assets, such as scene graphs using a reloaded texture or font, are
+     * updated to use the new asset instead of being reloaded. See
+     * {@link BaseLoader#rebind}.
+     *
+     * Reloaded assets are new objects. Any other references to the previous
+     * asset must be updated with the reload callback (see
+     * {@link setReloadCallback}).
+     *
+     * Note that file times are only precise to the second, and that assets
+     * loaded from an asset bundle or the Android APK never change. By
+     * default, hot reloading is off.
+     *
+     * @param value Whether assets are reloaded when their files change
+     */
+    void setHotReload(bool value);
+
+    /**
+     * Returns the time between checks for changed files, in milliseconds
+     *
+     * The default is 500 milliseconds.
+     *
+     * @return the time between checks for changed files, in milliseconds
+     */
+    Uint32 getReloadPeriod() const { return _period; }
+
+    /**
+     * Sets the time between checks for changed files, in milliseconds
+     *
+     * The default is 500 milliseconds.
+     *
+     * @param millis    The time between checks for changed files
+     */
+    void setReloadPeriod(Uint32 millis);
+
+    /**
+     * Returns the callback invoked after each hot reload
+     *
+     * The callback is given the key of each asset reloaded, and whether the
+     * reload was successful. On failure, the previous asset is kept.
+     *
+     * @return the callback invoked after each hot reload
+     */
+    const LoaderCallback& getReloadCallback() const { return _onreload; }
+
+    /**
+     * Sets the callback invoked after each hot reload
+     *
+     * The callback is given the key of each asset reloaded, and whether the
+     * reload was successful. On failure, the previous asset is kept.
+     *
+     * @param callback  The callback invoked after each hot reload
+     */
+    void setReloadCallback(LoaderCallback callback) { _onreload = callback; }
+
+    /**
+     * Synchronously reloads the asset for the given key.
+     *
+     * The type of the asset is specified by the template parameter T. The
+     * asset is loaded again exactly as it was originally requested, and its
+     * dependent assets are updated to use the new asset. If the reload fails,
+     * the previous asset is kept.
+     *
+     * This method may be used whether or not hot reloading is active.
+     *
+     * @param  key  The key referencing the asset
+     *
+     * @return true if the asset was successfully reloaded
+     */
+    template<typename T>
+    bool reload(const std::string key) {
+        size_t hash = typeid(T).hash_code();
+        if (_handlers.find(hash) == _handlers.end()) {
+            CUAssertLog(false, "No loader assigned for given type");
+            return false;
+        }
+        return refresh(hash,key);
+    }
+
+    /**
+     * Synchronously reloads every asset read from the given file.
+     *
+     * The assets are reloaded in loader priority order, and their dependent
+     * assets are updated to use the new assets. This is the method used by
+     * hot reloading when a file changes. It may be used whether or not hot
+     * reloading is active.
+     *
+     * @param file  The file path, relative to the asset directory
+     *
+     * @return the number of assets successfully reloaded
+     */
+    size_t reloadFile(const std::string file);
+
 };
 
 }
@@ -113,6 +113,8 @@ protected:
      *      "size":         This font size (int)
      *      "charset":      The set of characters for the font atlas (string)
      *      "padding":      The atlas padding (to prevent blur bleedthrough)
+     *      "distance":     Whether to use signed distance field atlases (bool)
+     *      "paging":       Whether to add missing glyphs to the atlases on demand (bool)
      *      "hinting":		The rendering hints ("normal", "light", "mono", "none")
      *      "bold":      	Whether to make the font an (ad hoc) bold
      *      "italic":      	Whether to make the font an (ad hoc) italic
@@ -207,6 +209,8 @@ protected:
      *      "size":         This font size (int)
      *      "charset":      The set of characters for the font atlas (string)
      *      "padding":      The atlas padding (to prevent blur bleedthrough)
+     *      "distance":     Whether to use signed distance field atlases (bool)
+     *      "paging":       Whether to add missing glyphs to the atlases on demand (bool)
      *      "hinting":		The rendering hints ("normal", "light", "mono", "none")
      *      "bold":      	Whether to make the font an (ad hoc) bold
      *      "italic":      	Whether to make the font an (ad hoc) italic
@@ -220,6 +224,18 @@ protected:
      * @return true if the asset was successfully loaded
      */
     bool read(const std::shared_ptr<JsonValue>& json, LoaderCallback callback, bool async) override;
+
+    /**
+     * Returns the estimated GPU memory used by the given font in bytes
+     *
+     * This is the size of the font atlas textures. A font with no atlases
+     * has size 0.
+     *
+     * @param asset The font to measure
+     *
+     * @return the estimated GPU memory used by the given font in bytes
+     */
+    size_t measure(const std::shared_ptr<Font>& asset) const override;
     
     
 public:
@@ -146,7 +146,7 @@ protected:
                 if (!asset->preload(source)) {
                     asset = nullptr;
                 }
-                Application::get()->schedule([=](void){
+                this->schedule([=](void){
                     this->materialize(key,asset,callback);
                     return false;
                 });
@@ -198,7 +198,7 @@ protected:
                 if (!asset->preload(json)) {
                     asset = nullptr;
                 }
-                Application::get()->schedule([=](void){
+                this->schedule([=](void){
                     this->materialize(key,asset,callback);
                     return false;
                 });
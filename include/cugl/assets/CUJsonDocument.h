@@ -0,0 +1,741 @@
+//
+//  CUJsonDocument.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a read-only alternative to JsonValue for very large
+//  JSON files, such as level files. Unlike JsonValue, it does not build a tree
+//  of shared pointers. Instead, the parser makes a single pass over the JSON,
+//  writing the nodes into a single contiguous arena. Strings (and keys) are
+//  views into the source buffer, which the document owns. Escape sequences
+//  are decoded in place, so parsing never allocates a string.
+//
+//  The nodes are accessed through JsonView, which is a lightweight handle that
+//  presents the same read API as JsonValue. This view is only valid as long as
+//  the document that created it.
+//
+//  A document can also be saved in (and loaded from) a compiled binary format,
+//  which is the arena and string table written out directly. Loading this
+//  format requires no parsing at all. By convention, these files have the
+//  extension .cbin, and are placed next to the .json file they replace.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_JSON_DOCUMENT_H__
+#define __CU_JSON_DOCUMENT_H__
+#include <cugl/assets/CUJsonValue.h>
+#include <string_view>
+#include <vector>
+#include <string>
+
+namespace cugl {
+
+// Forward reference
+class JsonDocument;
+
+/**
+ * This class is a read-only handle to a node in a {@link JsonDocument}.
+ *
+ * A view is small enough to be passed by value. It has the same read API as
+ * {@link JsonValue}, except that children are returned as views, and views
+ * cannot be modified. If a child does not exist, the view returned is invalid
+ * (it converts to false). An invalid view has type NullType.
+ *
+ * A view is only valid as long as the document that created it. Strings and
+ * keys are returned as views into the document buffer. Copy them with the
+ * std::string constructor if they need to outlive the document.
+ */
+class JsonView {
+private:
+    /** The document for this view (nullptr if invalid) */
+    const JsonDocument* _document;
+    /** The index of this node in the document arena */
+    size_t _index;
+
+    /**
+     * Creates a view of the given node in the document
+     *
+     * @param document  The document
+     * @param index     The index of the node in the document arena
+     */
+    JsonView(const JsonDocument* document, size_t index) :
+    _document(document), _index(index) {}
+
+    /** Allow the document to create views */
+    friend class JsonDocument;
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an invalid view
+     */
+    JsonView() : _document(nullptr), _index(0) {}
+
+    /**
+     * Returns true if this view refers to a node
+     *
+     * @return true if this view refers to a node
+     */
+    explicit operator bool() const { return _document != nullptr; }
+
+#pragma mark Type
+    /**
+     * Returns the type of this node.
+     *
+     * An invalid view has type NullType.
+     *
+     * @return the type of this node.
+     */
+    JsonValue::Type type() const;
+
+    /**
+     * Returns true if this node is a NULL value.
+     *
+     * @return true if this node is a NULL value.
+     */
+    bool isNull() const     { return type() == JsonValue::Type::NullType; }
+
+    /**
+     * Returns true if this node is a numeric value.
+     *
+     * @return true if this node is a numeric value.
+     */
+    bool isNumber() const   { return type() == JsonValue::Type::NumberType; }
+
+    /**
+     * Returns true if this node is a boolean value.
+     *
+     * @return true if this node is a boolean value.
+     */
+    bool isBool() const     { return type() == JsonValue::Type::BoolType; }
+
+    /**
+     * Returns true if this node is a string value.
+     *
+     * @return true if this node is a string value.
+     */
+    bool isString() const   { return type() == JsonValue::Type::StringType; }
+
+    /**
+     * Returns true if this node is not NULL nor an array or object.
+     *
+     * @return true if this node is not NULL nor an array or object.
+     */
+    bool isValue() const;
+
+    /**
+     * Returns true if this node is an array.
+     *
+     * @return true if this node is an array.
+     */
+    bool isArray() const    { return type() == JsonValue::Type::ArrayType; }
+
+    /**
+     * Returns true if this node is an object.
+     *
+     * @return true if this node is an object.
+     */
+    bool isObject() const   { return type() == JsonValue::Type::ObjectType; }
+
+#pragma mark Value Access
+    /**
+     * Returns this node as a string view into the document buffer.
+     *
+     * If the node is not a StringType, this returns an empty view.
+     *
+     * @return this node as a string view into the document buffer.
+     */
+    std::string_view view() const;
+
+    /**
+     * Returns this node as a string.
+     *
+     * This method will fail if the node is not a value type.  Otherwise, if
+     * the node is not a StringType, it will return the default value instead.
+     *
+     * @param defaultValue  The value to return if the node is not a string
+     *
+     * @return this node as a string.
+     */
+    std::string asString(const std::string defaultValue="") const;
+
+    /**
+     * Returns this node as a float.
+     *
+     * This method will fail if the node is not a value type.  Otherwise, if
+     * the node is not a NumberType, it will return the default value instead.
+     *
+     * @param defaultValue  The value to return if the node is not a number
+     *
+     * @return this node as a float.
+     */
+    float asFloat(float defaultValue=0.0f) const;
+
+    /**
+     * Returns this node as a double.
+     *
+     * This method will fail if the node is not a value type.  Otherwise, if
+     * the node is not a NumberType, it will return the default value instead.
+     *
+     * @param defaultValue  The value to return if the node is not a number
+     *
+     * @return this node as a double.
+     */
+    double asDouble(double defaultValue=0.0) const;
+
+    /**
+     * Returns this node as a long.
+     *
+     * This method will fail if the node is not a value type.  Otherwise, if
+     * the node is not a NumberType, it will return the default value instead.
+     *
+     * @param defaultValue  The value to return if the node is not a number
+     *
+     * @return this node as a long.
+     */
+    long asLong(long defaultValue=0L) const;
+
+    /**
+     * Returns this node as a int.
+     *
+     * This method will fail if the node is not a value type.  Otherwise, if
+     * the node is not a NumberType, it will return the default value instead.
+     *
+     * @param defaultValue  The value to return if the node is not a number
+     *
+     * @return this node as a int.
+     */
+    int asInt(int defaultValue=0) const;
+
+    /**
+     * Returns this node as a bool.
+     *
+     * This method will fail if the node is not a value type.  Otherwise, if
+     * the node is not a BoolType, it will return the default value instead.
+     *
+     * @param defaultValue  The value to return if the node is not a boolean
+     *
+     * @return this node as a bool.
+     */
+    bool asBool(bool defaultValue=false) const;
+
+#pragma mark Child Access
+    /**
+     * Returns the number of children of this node.
+     *
+     * This is 0 for any node that is not an array or object.
+     *
+     * @return the number of children of this node.
+     */
+    size_t size() const;
+
+    /**
+     * Returns the key for this object value.
+     *
+     * If this node is not the child of an object, this returns an empty view.
+     *
+     * @return the key for this object value.
+     */
+    std::string_view key() const;
+
+    /**
+     * Returns true if a child with the specified name exists.
+     *
+     * This method will always return false if the node is not an object type
+     *
+     * @param key   The key identifying the child
+     *
+     * @return true if a child with the specified name exists.
+     */
+    bool has(std::string_view key) const;
+
+    /**
+     * Returns the child at the specified index.
+     *
+     * This method will fail if the node is not an array or object type.
+     * If the index is out of bounds, this method returns an invalid view.
+     *
+     * @param index The index into the child array.
+     *
+     * @return the child at the specified index.
+     */
+    JsonView get(size_t index) const;
+
+    /**
+     * Returns the child with the specified key.
+     *
+     * This method will fail if the node is not an object type. If there is no
+     * child with this key, the method returns an invalid view. If there is more
+     * than one child of this name, it will return the first one.
+     *
+     * @param key   The key identifying the child.
+     *
+     * @return the child with the specified key.
+     */
+    JsonView get(std::string_view key) const;
+
+#pragma mark Child Values
+    /**
+     * Returns the string value of the child with the specified key.
+     *
+     * If there is no child with the given key, or if that child cannot be
+     * represented as a string value, it returns the default value instead.
+     *
+     * @param key           The key identifying the child
+     * @param defaultValue  The value to use if child does not exist or is not a string
+     *
+     * @return the string value of the child with the specified key.
+     */
+    std::string getString(std::string_view key, const std::string defaultValue="") const;
+
+    /**
+     * Returns the float value of the child with the specified key.
+     *
+     * If there is no child with the given key, or if that child cannot be
+     * represented as a numeric value, it returns the default value instead.
+     *
+     * @param key           The key identifying the child
+     * @param defaultValue  The value to use if child does not exist or is not a number
+     *
+     * @return the float value of the child with the specified key.
+     */
+    float getFloat(std::string_view key, float defaultValue=0.0f) const;
+
+    /**
+     * Returns the double value of the child with the specified key.
+     *
+     * If there is no child with the given key, or if that child cannot be
+     * represented as a numeric value, it returns the default value instead.
+     *
+     * @param key           The key identifying the child
+     * @param defaultValue  The value to use if child does not exist or is not a number
+     *
+     * @return the double value of the child with the specified key.
+     */
+    double getDouble(std::string_view key, double defaultValue=0.0) const;
+
+    /**
+     * Returns the long value of the child with the specified key.
+     *
+     * If there is no child with the given key, or if that child cannot be
+     * represented as a numeric value, it returns the default value instead.
+     *
+     * @param key           The key identifying the child
+     * @param defaultValue  The value to use if child does not exist or is not a number
+     *
+     * @return the long value of the child with the specified key.
+     */
+    long getLong(std::string_view key, long defaultValue=0L) const;
+
+    /**
+     * Returns the int value of the child with the specified key.
+     *
+     * If there is no child with the given key, or if that child cannot be
+     * represented as a numeric value, it returns the default value instead.
+     *
+     * @param key           The key identifying the child
+     * @param defaultValue  The value to use if child does not exist or is not a number
+     *
+     * @return the int value of the child with the specified key.
+     */
+    int getInt(std::string_view key, int defaultValue=0) const;
+
+    /**
+     * Returns the boolean value of the child with the specified key.
+     *
+     * If there is no child with the given key, or if that child cannot be
+     * represented as a boolean value, it returns the default value instead.
+     *
+     * @param key           The key identifying the child
+     * @param defaultValue  The value to use if child does not exist or is not a boolean
+     *
+     * @return the boolean value of the child with the specified key.
+     */
+    bool getBool(std::string_view key, bool defaultValue=false) const;
+
+#pragma mark Conversion
+    /**
+     * Returns a newly allocated JsonValue equivalent to this node
+     *
+     * This method copies the entire subtree of this node. It is intended for
+     * code that still requires a JsonValue, such as the data of a single
+     * scene in a large level file.
+     *
+     * @return a newly allocated JsonValue equivalent to this node
+     */
+    std::shared_ptr<JsonValue> toJsonValue() const;
+};
+
+/**
+ * This class is a read-only JSON document parsed into a contiguous arena.
+ *
+ * The parser makes a single pass over the JSON string. Every node is written
+ * into one array, and the children of each array or object are contiguous in
+ * that array. Hence looking up a child by index is constant time, and a
+ * document of n nodes requires only a handful of allocations. Strings and
+ * keys are stored as offsets into the source buffer, which is owned by the
+ * document. Escape sequences are decoded in place.
+ *
+ * Nodes are accessed with {@link JsonView}, starting at {@link getRoot}. The
+ * document must outlive all of its views.
+ *
+ * This class is designed for large, read-only files, like level files. Use
+ * {@link JsonValue} if you need to modify the JSON or write it back out. You
+ * can convert any part of the document with {@link JsonView#toJsonValue}.
+ *
+ * A document may be compiled offline to a binary file with {@link writeBinary}
+ * (or the script scripts/cbin.py). The binary format is little-endian, and
+ * consists of a 32 byte header, the node arena, and the string table:
+ *
+ *     header:  "CBIN", version, node count, root index, string bytes, 0, 0, 0
+ *     nodes:   type, key offset, key length, start, size, 0, number (double)
+ *     strings: UTF-8 bytes, with every key and string stored only once
+ *
+ * Every field is a 32 bit unsigned integer except for the number. For strings,
+ * start and size are the offset and length in the string table. For arrays
+ * and objects, they are the index of the first child and the number of
+ * children. Children always precede their parent in the arena.
+ */
+class JsonDocument {
+private:
+    /**
+     * A single node in the document arena
+     */
+    struct Entry {
+        /** The node type */
+        JsonValue::Type type;
+        /** The offset of the key in the source buffer */
+        Uint32 key;
+        /** The length of the key */
+        Uint32 keylen;
+        /** The offset of a string, or the index of the first child */
+        Uint32 start;
+        /** The length of a string, or the number of children */
+        Uint32 size;
+        /** The numeric (or boolean) value */
+        double number;
+    };
+
+    /** The source buffer (with escape sequences decoded in place) */
+    std::string _source;
+    /** The node arena */
+    std::vector<Entry> _nodes;
+    /** The index of the root node */
+    size_t _root;
+
+    /** The children of any open containers (only used while parsing) */
+    std::vector<Entry> _stack;
+    /** The current parse position */
+    size_t _offset;
+
+    /** Allow views to access the arena */
+    friend class JsonView;
+
+#pragma mark Parsing
+    /**
+     * Parses the source buffer, returning true if successful
+     *
+     * @return true if the source buffer was parsed successfully
+     */
+    bool parse();
+
+    /**
+     * Advances the parse position past any whitespace
+     */
+    void skip();
+
+    /**
+     * Parses the value at the current position into the given entry
+     *
+     * This does not set the key of the entry.
+     *
+     * @param entry The entry to store the result
+     * @param depth The current nesting depth
+     *
+     * @return true if the value was parsed successfully
+     */
+    bool parseValue(Entry& entry, int depth);
+
+    /**
+     * Parses the string at the current position
+     *
+     * The string is decoded in place, so this method records the offset and
+     * length of the decoded string in the source buffer.
+     *
+     * @param start The variable to store the string offset
+     * @param size  The variable to store the string length
+     *
+     * @return true if the string was parsed successfully
+     */
+    bool parseString(Uint32& start, Uint32& size);
+
+    /**
+     * Parses the array or object at the current position into the given entry
+     *
+     * The children are parsed onto the stack, and are moved to the arena when
+     * the container is closed. This is what keeps them contiguous.
+     *
+     * @param entry The entry to store the result
+     * @param depth The current nesting depth
+     *
+     * @return true if the container was parsed successfully
+     */
+    bool parseContainer(Entry& entry, int depth);
+
+    /**
+     * Reports a parsing error at the current position
+     *
+     * Detailed information about the parsing error will be passed to an
+     * assert. Hence error messages are suppressed if asserts are turned off.
+     *
+     * @return false (for convenience)
+     */
+    bool error();
+
+    /**
+     * Returns true if the arena and string table are consistent
+     *
+     * This method is used to validate a binary document. It checks that all
+     * string offsets are in range, and that every container refers to nodes
+     * that precede it in the arena (so that there are no cycles).
+     *
+     * @return true if the arena and string table are consistent
+     */
+    bool validate() const;
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an empty document.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    JsonDocument();
+
+    /**
+     * Deletes this document and all of its resources.
+     */
+    ~JsonDocument() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this document.
+     *
+     * All views of this document are invalid after this method is called.
+     */
+    void dispose();
+
+    /**
+     * Initializes a new document from the given JSON string.
+     *
+     * The document makes a copy of the string to use as its buffer.
+     *
+     * If there is a parsing error, this method will return false.  Detailed
+     * information about the parsing error will be passed to an assert.  Hence
+     * error messages are suppressed if asserts are turned off.
+     *
+     * @param json  The JSON string to parse.
+     *
+     * @return true if the document is initialized properly, false otherwise.
+     */
+    bool initWithJson(const std::string& json);
+
+    /**
+     * Initializes a new document from the given JSON string.
+     *
+     * The document acquires the string to use as its buffer, so no copy is made.
+     *
+     * If there is a parsing error, this method will return false.  Detailed
+     * information about the parsing error will be passed to an assert.  Hence
+     * error messages are suppressed if asserts are turned off.
+     *
+     * @param json  The JSON string to parse.
+     *
+     * @return true if the document is initialized properly, false otherwise.
+     */
+    bool initWithJson(std::string&& json);
+
+    /**
+     * Initializes a new document from the given compiled binary data.
+     *
+     * See the class description for the binary format. The data is copied
+     * into the arena and string table, with no parsing. If the data is not
+     * a valid binary document, this method returns false.
+     *
+     * @param data  The binary data
+     * @param size  The number of bytes of data
+     *
+     * @return true if the document is initialized properly, false otherwise.
+     */
+    bool initWithBinary(const Uint8* data, size_t size);
+
+    /**
+     * Initializes a new document from the given asset file.
+     *
+     * This initializer assumes that the file name is a relative path. It will
+     * search the application assert directory {@see Application#getAssetDirectory()}
+     * for the file. If the file ends in .json, and there is a file of the same
+     * name ending in .cbin, it will load that compiled file instead. Otherwise,
+     * it parses the JSON file.
+     *
+     * If there is a parsing error, this method will return false.  Detailed
+     * information about the parsing error will be passed to an assert.  Hence
+     * error messages are suppressed if asserts are turned off.
+     *
+     * @param file  The relative path to the file
+     *
+     * @return true if the document is initialized properly, false otherwise.
+     */
+    bool initWithAsset(const std::string& file);
+
+#pragma mark Static Constructors
+    /**
+     * Returns a newly allocated document from the given JSON string.
+     *
+     * The document makes a copy of the string to use as its buffer.
+     *
+     * If there is a parsing error, this method will return nullptr.  Detailed
+     * information about the parsing error will be passed to an assert.  Hence
+     * error messages are suppressed if asserts are turned off.
+     *
+     * @param json  The JSON string to parse.
+     *
+     * @return a newly allocated document from the given JSON string.
+     */
+    static std::shared_ptr<JsonDocument> allocWithJson(const std::string& json) {
+        std::shared_ptr<JsonDocument> result = std::make_shared<JsonDocument>();
+        return (result->initWithJson(json) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated document from the given JSON string.
+     *
+     * The document acquires the string to use as its buffer, so no copy is made.
+     *
+     * If there is a parsing error, this method will return nullptr.  Detailed
+     * information about the parsing error will be passed to an assert.  Hence
+     * error messages are suppressed if asserts are turned off.
+     *
+     * @param json  The JSON string to parse.
+     *
+     * @return a newly allocated document from the given JSON string.
+     */
+    static std::shared_ptr<JsonDocument> allocWithJson(std::string&& json) {
+        std::shared_ptr<JsonDocument> result = std::make_shared<JsonDocument>();
+        return (result->initWithJson(std::move(json)) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated document from the given compiled binary data.
+     *
+     * See the class description for the binary format. The data is copied
+     * into the arena and string table, with no parsing. If the data is not
+     * a valid binary document, this method returns nullptr.
+     *
+     * @param data  The binary data
+     * @param size  The number of bytes of data
+     *
+     * @return a newly allocated document from the given compiled binary data.
+     */
+    static std::shared_ptr<JsonDocument> allocWithBinary(const Uint8* data, size_t size) {
+        std::shared_ptr<JsonDocument> result = std::make_shared<JsonDocument>();
+        return (result->initWithBinary(data,size) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated document from the given asset file.
+     *
+     * This allocator assumes that the file name is a relative path. It will
+     * search the application assert directory {@see Application#getAssetDirectory()}
+     * for the file. If the file ends in .json, and there is a file of the same
+     * name ending in .cbin, it will load that compiled file instead. Otherwise,
+     * it parses the JSON file.
+     *
+     * If there is a parsing error, this method will return nullptr.  Detailed
+     * information about the parsing error will be passed to an assert.  Hence
+     * error messages are suppressed if asserts are turned off.
+     *
+     * @param file  The relative path to the file
+     *
+     * @return a newly allocated document from the given asset file.
+     */
+    static std::shared_ptr<JsonDocument> allocWithAsset(const std::string& file) {
+        std::shared_ptr<JsonDocument> result = std::make_shared<JsonDocument>();
+        return (result->initWithAsset(file) ? result : nullptr);
+    }
+
+#pragma mark Attributes
+    /**
+     * Returns a view of the root node of this document.
+     *
+     * If the document is not initialized, this returns an invalid view.
+     *
+     * @return a view of the root node of this document.
+     */
+    JsonView getRoot() const;
+
+    /**
+     * Returns the number of nodes in this document.
+     *
+     * @return the number of nodes in this document.
+     */
+    size_t getNodeCount() const { return _nodes.size(); }
+
+#pragma mark Binary Encoding
+    /**
+     * Returns the compiled binary encoding of this document.
+     *
+     * See the class description for the binary format. All keys and strings
+     * are interned, so each distinct string is stored only once.
+     *
+     * @return the compiled binary encoding of this document.
+     */
+    std::vector<Uint8> toBinary() const;
+
+    /**
+     * Writes the compiled binary encoding of this document to a file.
+     *
+     * The path is used as is, so it should be an absolute path (or a path
+     * relative to the working directory). This method is intended for offline
+     * tools that compile JSON assets.
+     *
+     * @param path  The file to write
+     *
+     * @return true if the file was written successfully
+     */
+    bool writeBinary(const std::string& path) const;
+};
+
+}
+
+#endif /* __CU_JSON_DOCUMENT_H__ */
@@ -56,6 +56,9 @@ namespace cugl {
  * wrapper around {@link JsonReader} that allows it to be used with an
  * instance of {@link AssetManager}.
  *
+ * If a compiled binary file (.cbin) sits next to a .json asset, this loader
+ * will load that file instead, skipping the parse. See {@link JsonDocument}.
+ *
  * As with all of our loaders, this loader is designed to be attached to an
  * asset manager. Use the method {@link getHook()} to get the appropriate
  * pointer for attaching the loader.
@@ -4,8 +4,8 @@
 //
 //  This module a modern C++ alternative to the cJSON interface for reading
 //  JSON files.  In particular, this gives us better type-checking and memory
-//  management.  With that said, it still uses cJSON as the underlying parsing
-//  engine.
+//  management.  Parsing is done by JsonDocument, while cJSON is still used
+//  to encode JSON strings.
 //
 //  This class uses our standard shared-pointer architecture.
 //
@@ -50,6 +50,9 @@
 
 namespace cugl {
 
+// Forward reference
+class JsonView;
+
 /**
  * This class represents a node in a JSON DOM tree.
  *
@@ -62,8 +65,8 @@ namespace cugl {
  * if the node is an object type.  Hence the main usage of this feature is to
  * "cast" object nodes to arrays.
  *
- * This class uses cJSON as the underlying parsing engine.  However, it manages
- * memory automatically so that the user does not need to worry about deleting
+ * This class uses {@link JsonDocument} as the underlying parsing engine, and
+ * cJSON to encode JSON strings.  However, it manages memory automatically so that the user does not need to worry about deleting
  * or allocating memory beyond the initial node itself.
  */
 class JsonValue {
@@ -152,6 +155,33 @@ public:
      * @param value The JsonValue to convert
      */
     static cJSON* toCJSON(const JsonValue* value);
+
+#pragma mark -
+#pragma mark JsonView Conversions
+    /**
+     * Returns a newly allocated JsonValue equivalent to the document node
+     *
+     * This allocator recursively allocates child nodes as necessary. These
+     * nodes will be owned by the parent node and deleted when it is deleted
+     * (provided there are no other references).
+     *
+     * @param node  The document node to convert
+     *
+     * @return a newly allocated JsonValue equivalent to the document node
+     */
+    static std::shared_ptr<JsonValue> toJsonValue(const JsonView& node);
+
+    /**
+     * Modifies value so that it is equivalent to the document node
+     *
+     * This allocator recursively allocates child nodes as necessary. These
+     * nodes will be owned by the parent node value and deleted when it is
+     * deleted (provided there are no other references).
+     *
+     * @param value The JsonValue to store the result
+     * @param node  The document node to convert
+     */
+    static void toJsonValue(JsonValue* value, const JsonView& node);
     
 #pragma mark -
 #pragma mark Constructors
@@ -274,6 +304,19 @@ public:
      */
     bool initWithJson(const std::string json);
 
+    /**
+     * Initializes a new JsonValue equivalent to the given document node.
+     *
+     * This initializer copies the entire subtree of the node, so the result
+     * does not depend on the {@link JsonDocument}. The children are all owned
+     * by this node will be deleted when this node is deleted (provided there
+     * are no other references).
+     *
+     * @param node  The document node to copy.
+     *
+     * @return  true if the JSON node is initialized properly, false otherwise.
+     */
+    bool initWithView(const JsonView& node);
     
 #pragma mark -
 #pragma mark Static Constructors
@@ -406,6 +449,23 @@ public:
         return (result->initWithJson(json) ? result : nullptr);
     }
 
+    /**
+     * Returns a newly allocated JsonValue equivalent to the given document node.
+     *
+     * This allocator copies the entire subtree of the node, so the result
+     * does not depend on the {@link JsonDocument}. The children are all owned
+     * by this node will be deleted when this node is deleted (provided there
+     * are no other references).
+     *
+     * @param node  The document node to copy.
+     *
+     * @return a newly allocated JsonValue equivalent to the given document node.
+     */
+    static std::shared_ptr<JsonValue> allocWithView(const JsonView& node) {
+        std::shared_ptr<JsonValue> result = std::make_shared<JsonValue>();
+        return (result->initWithView(node) ? result : nullptr);
+    }
+
     
 #pragma mark -
 #pragma mark Type
@@ -1471,6 +1531,23 @@ public:
      */
     std::string toString(bool format=true) const;
 
+    /**
+     * Appends a string representation of this JSON to the given buffer.
+     *
+     * This method is the same as {@link toString(bool)}, except that the
+     * result is appended to an existing buffer. The JSON is serialized
+     * directly to the buffer, so reusing a buffer (clearing it between uses)
+     * means that serialization does not allocate once the buffer is large
+     * enough.
+     *
+     * Numbers are written in the shortest form that reads back to the same
+     * value, and the formatted layout is that of {@link toString(bool)}.
+     *
+     * @param buffer    The buffer to append to
+     * @param format    Whether to pretty-print the JSON string
+     */
+    void toString(std::string& buffer, bool format=true) const;
+
 };
 
 }
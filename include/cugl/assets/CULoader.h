@@ -51,8 +51,11 @@
 #include <functional>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
+#include <algorithm>
 #include <cugl/assets/CUJsonValue.h>
 #include <cugl/util/CUThreadPool.h>
+#include <cugl/util/CUProfiler.h>
 
 namespace cugl {
 
@@ -97,10 +100,31 @@ typedef std::function<void(const std::string key, bool success)> LoaderCallback;
  */
 class BaseLoader : public std::enable_shared_from_this<BaseLoader> {
 protected:
+    /**
+     * The source of a requested asset
+     *
+     * This is all that is needed to load the asset again (e.g. when its
+     * file changes).
+     */
+    class Source {
+    public:
+        /** The pathname of the asset (if loaded without a directory entry) */
+        std::string path;
+        /** The directory entry of the asset (if any) */
+        std::shared_ptr<JsonValue> json;
+    };
+
+    /** The sources of every asset requested from this loader */
+    std::unordered_map<std::string, Source> _sources;
+
     /** The JSON key this loader responds to */
     std::string _jsonKey;
     /** The loader priority (all higher priority loaders finish first) */
     Uint32 _priority;
+    /** Whether this loader must load its assets one at a time */
+    bool _serial;
+    /** The memory limit for the assets of this loader in bytes (0 for no limit) */
+    size_t _limit;
     
     /**
      * The associated thread for asynchronous loading
@@ -115,6 +139,21 @@ protected:
      * This is a weak reference to avoid cycles.
      */
     AssetManager* _manager;
+
+    /**
+     * Schedules the given callback to materialize an asset on the main thread
+     *
+     * If this loader is attached to an {@link AssetManager}, the callback is
+     * queued with the manager, which runs these callbacks within its frame
+     * budget. Otherwise, it is passed to {@link Application#schedule}. As
+     * with that method, a callback that returns true is run again (on a
+     * later frame, if the budget is exhausted).
+     *
+     * This method is safe to call from any thread.
+     *
+     * @param callback  The materialization callback
+     */
+    void schedule(std::function<bool()> callback);
     
     /**
      * Internal method to support asset loading.
@@ -214,7 +253,88 @@ protected:
      * @return true if the key maps to a loaded asset.
      */
     virtual bool verify(const std::string key) const { return false; }
-   
+
+#pragma mark Reloading
+    /**
+     * Records the source of the given asset, so that it may be reloaded
+     *
+     * If the key already has a source, this method does nothing, as the
+     * request will be rejected by the loader.
+     *
+     * @param key       The key associated with the asset
+     * @param path      The pathname to the asset (empty for a directory entry)
+     * @param json      The directory entry for the asset (nullptr for a path)
+     */
+    void record(const std::string key, const std::string path,
+                const std::shared_ptr<JsonValue>& json) {
+        if (_sources.find(key) == _sources.end()) {
+            Source source;
+            source.path = path;
+            source.json = json;
+            _sources.emplace(key,source);
+        }
+    }
+
+    /**
+     * Returns the files read to load the given directory entry
+     *
+     * These are the files watched by {@link AssetManager} for hot reloading.
+     * By default, this is either the entry itself (if it is a string) or its
+     * "file" attribute. Loaders that read other files, or that read no files
+     * at all, should override this method. Paths are relative to the asset
+     * directory.
+     *
+     * @param json      The directory entry for the asset
+     *
+     * @return the files read to load the given directory entry
+     */
+    virtual std::vector<std::string> locate(const std::shared_ptr<JsonValue>& json) const {
+        std::vector<std::string> result;
+        std::string file = json->isString() ? json->asString() : json->getString("file","");
+        if (!file.empty()) {
+            result.push_back(file);
+        }
+        return result;
+    }
+
+    /**
+     * Synchronously reloads the asset for the given key from its source
+     *
+     * If the reload is successful, the previous and current versions of the
+     * asset are stored in the given pointers. If it fails, the previous asset
+     * remains loaded under the key. This method fails if the asset is still
+     * being loaded.
+     *
+     * This method is abstract and should be overridden in child classes.
+     *
+     * @param key       The key associated with the asset
+     * @param previous  The pointer to store the asset before the reload
+     * @param current   The pointer to store the asset after the reload
+     *
+     * @return true if the asset was successfully reloaded
+     */
+    virtual bool refresh(const std::string key, std::shared_ptr<void>& previous,
+                         std::shared_ptr<void>& current) {
+        return false;
+    }
+
+    /**
+     * Replaces every use of the given asset by the assets of this loader
+     *
+     * This method is called by {@link AssetManager} when an asset of another
+     * loader is reloaded. It allows dependent assets (e.g. scene graphs using
+     * a reloaded texture) to use the new asset without being reloaded
+     * themselves. By default, this method does nothing.
+     *
+     * @param type      The hash of the type of the reloaded asset
+     * @param previous  The asset before the reload
+     * @param current   The asset after the reload
+     */
+    virtual void rebind(size_t type, const std::shared_ptr<void>& previous,
+                        const std::shared_ptr<void>& current) {}
+
+    /** Allow the asset manager to reload assets */
+    friend class AssetManager;
     
 public:
 #pragma mark Constructors
@@ -224,7 +344,7 @@ public:
      * NEVER CALL THIS CONSTRUCTOR. As this is an abstract class, you should 
      * call one of the static constructors of the appropriate child class.
      */
-    BaseLoader()    { _jsonKey = ""; _priority = 0;}
+    BaseLoader()    { _jsonKey = ""; _priority = 0; _serial = false; _limit = 0; _manager = nullptr; }
     
     /**
      * Deletes this asset loader, disposing of all resources.
@@ -420,6 +540,40 @@ public:
     const Uint32 getPriority() const {
         return _priority;
     }
+
+    /**
+     * Returns true if this loader must load its assets one at a time.
+     *
+     * An {@link AssetManager} loads assets across all of its threads. However,
+     * some assets (such as fonts) use libraries that are not thread-safe.
+     * The asset manager gives a serial loader a thread pool with a single
+     * thread, so that none of its assets are loaded simultaneously.
+     *
+     * NOTE: Changing this value after the loader is attached to an
+     * {@link AssetManager} has no effect.
+     *
+     * @return true if this loader must load its assets one at a time.
+     */
+    bool isSerial() const {
+        return _serial;
+    }
+
+    /**
+     * Sets whether this loader must load its assets one at a time.
+     *
+     * An {@link AssetManager} loads assets across all of its threads. However,
+     * some assets (such as fonts) use libraries that are not thread-safe.
+     * The asset manager gives a serial loader a thread pool with a single
+     * thread, so that none of its assets are loaded simultaneously.
+     *
+     * NOTE: Changing this value after the loader is attached to an
+     * {@link AssetManager} has no effect.
+     *
+     * @param value Whether this loader must load its assets one at a time.
+     */
+    void setSerial(bool value) {
+        _serial = value;
+    }
     
 
 #pragma mark Loading/Unloading
@@ -440,6 +594,8 @@ public:
      * @return true if the asset was successfully loaded
      */
     bool load(const std::string key, const std::string source) {
+        CU_PROFILE_SCOPE("Loader::load");
+        record(key,source,nullptr);
         return read(key,source,nullptr,false);
     }
 
@@ -465,6 +621,8 @@ public:
      * @return true if the asset was successfully loaded
      */
     bool load(const std::shared_ptr<JsonValue>& json) {
+        CU_PROFILE_SCOPE("Loader::load");
+        record(json->key(),"",json);
         return read(json,nullptr,false);
     }
     
@@ -488,6 +646,7 @@ public:
      * @param callback  An optional callback for asynchronous loading
      */
     void loadAsync(const std::string key, const std::string source, LoaderCallback callback) {
+        record(key,source,nullptr);
         read(key, source, callback,true);
     }
 
@@ -516,6 +675,7 @@ public:
      * @param callback  An optional callback for asynchronous loading
      */
     void loadAsync(const std::shared_ptr<JsonValue>& json, LoaderCallback callback) {
+        record(json->key(),"",json);
         read(json, callback,true);
     }
 
@@ -533,6 +693,7 @@ public:
      * @return true if the asset was successfully unloaded
      */
     bool unload(const std::string key) {
+        _sources.erase(key);
         return purge(key);
     }
     
@@ -550,6 +711,7 @@ public:
      * @return true if the asset was successfully unloaded
      */
     bool unload(const std::shared_ptr<JsonValue>& json) {
+        _sources.erase(json->key());
         return purge(json);
     }
     
@@ -562,7 +724,24 @@ public:
      *
      * This method is abstract and should be overridden in the child classes.
      */
-    virtual void unloadAll() {}
+    virtual void unloadAll() { _sources.clear(); }
+
+    /**
+     * Synchronously reloads the asset for the given key from its source
+     *
+     * The asset is loaded again exactly as it was originally requested. If
+     * the reload fails, the previous asset remains loaded under the key.
+     * Other objects referencing the previous asset are not updated. Use
+     * {@link AssetManager#reload} to also update dependent assets.
+     *
+     * @param key   The key associated with the asset
+     *
+     * @return true if the asset was successfully reloaded
+     */
+    bool reload(const std::string key) {
+        std::shared_ptr<void> previous, current;
+        return refresh(key,previous,current);
+    }
     
 
 #pragma mark Progress Monitoring
@@ -645,6 +824,59 @@ public:
         size_t size = loadCount()+waitCount();
         return (size == 0 ? 0.0f : ((float)loadCount())/size);
     }
+
+#pragma mark Memory Management
+    /**
+     * Returns the estimated memory used by the assets of this loader in bytes
+     *
+     * For GPU assets, such as textures, this is an estimate of the memory used
+     * on the GPU. Loaders that cannot estimate the size of their assets
+     * return 0.
+     *
+     * This method is abstract and should be overridden in child classes.
+     *
+     * @return the estimated memory used by the assets of this loader in bytes
+     */
+    virtual size_t getMemoryUsage() const { return 0; }
+
+    /**
+     * Returns the memory limit for the assets of this loader in bytes
+     *
+     * When the assets exceed this limit, {@link trim} evicts the least
+     * recently used assets that are referenced by nothing but this loader.
+     * An evicted asset is reloaded (synchronously) the next time that it is
+     * requested from an {@link AssetManager}. A value of 0 means that there
+     * is no limit, which is the default.
+     *
+     * @return the memory limit for the assets of this loader in bytes
+     */
+    size_t getMemoryLimit() const { return _limit; }
+
+    /**
+     * Sets the memory limit for the assets of this loader in bytes
+     *
+     * When the assets exceed this limit, {@link trim} evicts the least
+     * recently used assets that are referenced by nothing but this loader.
+     * An evicted asset is reloaded (synchronously) the next time that it is
+     * requested from an {@link AssetManager}. A value of 0 means that there
+     * is no limit, which is the default.
+     *
+     * @param bytes The memory limit for the assets of this loader in bytes
+     */
+    void setMemoryLimit(size_t bytes) { _limit = bytes; }
+
+    /**
+     * Evicts unused assets until this loader is within its memory limit
+     *
+     * Only assets that are referenced by nothing but this loader, and that
+     * can be loaded again, may be evicted. The least recently requested are
+     * evicted first. This method does nothing if there is no memory limit.
+     *
+     * This method is abstract and should be overridden in child classes.
+     *
+     * @return the number of assets evicted
+     */
+    virtual size_t trim() { return 0; }
     
 };
 
@@ -674,6 +906,37 @@ protected:
     /** The assets we are expecting that are not yet loaded */
     std::unordered_set<std::string> _queue;
 
+    /** The assets evicted to meet the memory limit (and not yet reloaded) */
+    std::unordered_set<std::string> _evicted;
+    /** The time each asset was last requested (in requests) */
+    mutable std::unordered_map<std::string, Uint64> _touched;
+    /** The number of requests for an asset */
+    mutable Uint64 _clock;
+
+    /**
+     * Returns the asset for the given key, without marking it as used
+     *
+     * @param key   The key associated with the asset
+     *
+     * @return the asset pointer for the given key
+     */
+    std::shared_ptr<T> lookup(const std::string key) const {
+        auto it = _assets.find(key);
+        return (it == _assets.end() ? nullptr : it->second);
+    }
+
+    /**
+     * Returns the estimated memory used by the given asset in bytes
+     *
+     * For GPU assets, such as textures, this is an estimate of the memory
+     * used on the GPU. By default, this method returns 0.
+     *
+     * @param asset The asset to measure
+     *
+     * @return the estimated memory used by the given asset in bytes
+     */
+    virtual size_t measure(const std::shared_ptr<T>& asset) const { return 0; }
+
     /**
      * Returns the set of active keys in this loader.
      *
@@ -732,7 +995,7 @@ public:
      * NEVER CALL THIS CONSTRUCTOR. As this is an abstract class, you should
      * call one of the static constructors of the appropriate child class.
      */
-    Loader(): BaseLoader() {}
+    Loader(): BaseLoader(), _clock(0) {}
 
     
 #pragma mark Asset Access
@@ -748,7 +1011,41 @@ public:
      */
     std::shared_ptr<T> get(const std::string key) const {
         auto it = _assets.find(key);
-        return (it == _assets.end() ? nullptr : it->second);
+        if (it == _assets.end()) {
+            return nullptr;
+        }
+        _touched[key] = ++_clock;
+        return it->second;
+    }
+
+    /**
+     * Returns the asset for the given key.
+     *
+     * If the key is valid, the asset is guaranteed not to be null.  Otherwise,
+     * this method returns nullptr
+     *
+     * If the asset was evicted to meet the memory limit (see {@link trim}),
+     * this method reloads it synchronously.
+     *
+     * @param key   The key associated with the asset
+     *
+     * @return the asset pointer for the given key
+     */
+    std::shared_ptr<T> get(const std::string key) {
+        auto it = _evicted.find(key);
+        if (it != _evicted.end() && _assets.find(key) == _assets.end()) {
+            _evicted.erase(it);
+            auto jt = _sources.find(key);
+            if (jt != _sources.end() && _queue.find(key) == _queue.end()) {
+                Source source = jt->second;
+                bool success = (source.json != nullptr ? read(source.json,nullptr,false)
+                                                       : read(key,source.path,nullptr,false));
+                if (!success) {
+                    _queue.erase(key);
+                }
+            }
+        }
+        return static_cast<const Loader<T>*>(this)->get(key);
     }
     
     /**
@@ -763,6 +1060,37 @@ public:
      */
     std::shared_ptr<T> operator[](const std::string key) const { return get(key); }
 
+    /**
+     * Returns the asset for the given key.
+     *
+     * If the key is valid, the asset is guaranteed not to be null.  Otherwise,
+     * this method returns nullptr
+     *
+     * If the asset was evicted to meet the memory limit (see {@link trim}),
+     * this method reloads it synchronously.
+     *
+     * @param key   The key associated with the asset
+     *
+     * @return the asset pointer for the given key
+     */
+    std::shared_ptr<T> operator[](const std::string key) { return get(key); }
+
+    /**
+     * Returns true if the asset for the given key was evicted
+     *
+     * An asset is evicted to meet the memory limit (see {@link trim}). It is
+     * reloaded the next time that it is requested with a non-const call to
+     * {@link get}.
+     *
+     * @param key   The key associated with the asset
+     *
+     * @return true if the asset for the given key was evicted
+     */
+    bool isEvicted(const std::string key) const {
+        return (_evicted.find(key) != _evicted.end() &&
+                _sources.find(key) != _sources.end());
+    }
+
 #pragma mark Asset Loading
     /**
      * Returns the number of assets currently loaded.
@@ -796,6 +1124,116 @@ public:
      */
     void unloadAll() override {
         _assets.clear();
+        _sources.clear();
+        _evicted.clear();
+        _touched.clear();
+    }
+
+#pragma mark Memory Management
+    /**
+     * Returns the estimated memory used by the assets of this loader in bytes
+     *
+     * For GPU assets, such as textures, this is an estimate of the memory used
+     * on the GPU. Loaders that cannot estimate the size of their assets
+     * return 0.
+     *
+     * @return the estimated memory used by the assets of this loader in bytes
+     */
+    size_t getMemoryUsage() const override {
+        size_t result = 0;
+        for (auto it = _assets.begin(); it != _assets.end(); ++it) {
+            result += measure(it->second);
+        }
+        return result;
+    }
+
+    /**
+     * Evicts unused assets until this loader is within its memory limit
+     *
+     * Only assets that are referenced by nothing but this loader, and that
+     * can be loaded again, may be evicted. The least recently requested are
+     * evicted first. This method does nothing if there is no memory limit.
+     *
+     * @return the number of assets evicted
+     */
+    size_t trim() override {
+        if (_limit == 0) {
+            return 0;
+        }
+        size_t usage = getMemoryUsage();
+        if (usage <= _limit) {
+            return 0;
+        }
+
+        // Candidates in order of last use (never used comes first)
+        std::vector<std::pair<Uint64,std::string>> order;
+        for (auto it = _assets.begin(); it != _assets.end(); ++it) {
+            if (it->second.use_count() == 1 && _sources.find(it->first) != _sources.end()) {
+                auto jt = _touched.find(it->first);
+                order.push_back(std::make_pair(jt == _touched.end() ? 0 : jt->second, it->first));
+            }
+        }
+        std::sort(order.begin(), order.end());
+
+        size_t count = 0;
+        for (auto it = order.begin(); it != order.end() && usage > _limit; ++it) {
+            auto jt = _assets.find(it->second);
+            size_t bytes = measure(jt->second);
+            if (bytes == 0) {
+                continue;
+            }
+            usage -= bytes;
+            _assets.erase(jt);
+            _touched.erase(it->second);
+            _evicted.insert(it->second);
+            count++;
+        }
+        return count;
+    }
+
+protected:
+    /**
+     * Synchronously reloads the asset for the given key from its source
+     *
+     * If the reload is successful, the previous and current versions of the
+     * asset are stored in the given pointers. If it fails, the previous asset
+     * remains loaded under the key. This method fails if the asset is still
+     * being loaded.
+     *
+     * @param key       The key associated with the asset
+     * @param previous  The pointer to store the asset before the reload
+     * @param current   The pointer to store the asset after the reload
+     *
+     * @return true if the asset was successfully reloaded
+     */
+    bool refresh(const std::string key, std::shared_ptr<void>& previous,
+                 std::shared_ptr<void>& current) override {
+        auto it = _sources.find(key);
+        if (it == _sources.end() || _queue.find(key) != _queue.end()) {
+            return false;
+        } else if (_evicted.find(key) != _evicted.end()) {
+            // The asset will be read fresh when next requested
+            return false;
+        }
+
+        // Erase directly, as purge may release more than the asset
+        Source source = it->second;
+        std::shared_ptr<T> before = lookup(key);
+        _assets.erase(key);
+        _evicted.erase(key);
+        bool success = (source.json != nullptr ? read(source.json,nullptr,false)
+                                               : read(key,source.path,nullptr,false));
+        std::shared_ptr<T> after = lookup(key);
+        if (!success || after == nullptr) {
+            _queue.erase(key);
+            if (before != nullptr) {
+                _assets[key] = before;
+            }
+            return false;
+        }
+        previous = before;
+        current  = after;
+        return true;
     }
 };
 
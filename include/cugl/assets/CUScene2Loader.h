@@ -148,6 +148,11 @@ protected:
     /** The type map for managing layout */
     std::unordered_map<std::string,Form> _forms;
     
+    /** The time (in microseconds) to spend building scenes each frame (0 for no limit) */
+    Uint32 _budget;
+    /** Whether to defer building the children of hidden nodes */
+    bool _deferHidden;
+    
     /**
      * Records the given Node with this loader, so that it may be unloaded later.
      *
@@ -237,6 +242,21 @@ protected:
      * @return true if the asset was successfully unloaded
      */
     virtual bool purge(const std::shared_ptr<JsonValue>& json) override;
+
+    /**
+     * Replaces every use of the given asset in the loaded scenes
+     *
+     * This method is called by {@link AssetManager} when an asset is hot
+     * reloaded. Scene nodes using a reloaded texture (textured nodes, nine
+     * patches and particle nodes) or font (labels) are given the new asset.
+     * The scenes themselves are not reloaded.
+     *
+     * @param type      The hash of the type of the reloaded asset
+     * @param previous  The asset before the reload
+     * @param current   The asset after the reload
+     */
+    virtual void rebind(size_t type, const std::shared_ptr<void>& previous,
+                        const std::shared_ptr<void>& current) override;
     
     /**
      * Attaches all generate nodes to the asset dictionary.
@@ -262,6 +282,89 @@ protected:
 	 * @return the JSON loaded from the widget file with all variables set based on the values presented in json.
 	 */
 	std::shared_ptr<JsonValue> getWidgetJson(const std::shared_ptr<JsonValue>& json) const;
+
+    /**
+     * Returns the JSON of the node encoded by the given JSON.
+     *
+     * If the JSON is a widget, this returns the JSON of the node that it
+     * encodes (see {@link #getWidgetJson}). Otherwise, it returns the JSON
+     * unchanged.
+     *
+     * @param json      The JSON object defining a node or widget
+     *
+     * @return the JSON of the node encoded by the given JSON.
+     */
+    std::shared_ptr<JsonValue> resolveJson(const std::shared_ptr<JsonValue>& json) const;
+
+    /**
+     * Returns a single node built from the given JSON, without its children.
+     *
+     * The node has its layout manager (if any) and name, but no children.
+     * The JSON should already be resolved (see {@link #resolveJson}). This
+     * method returns nullptr if the JSON does not define a supported node.
+     *
+     * @param key           The name of the node
+     * @param json          The JSON object defining the node
+     * @param nonrelative   Pointer to store whether children ignore the node color
+     *
+     * @return a single node built from the given JSON, without its children.
+     */
+    std::shared_ptr<scene2::SceneNode> buildNode(const std::string key,
+                                                 const std::shared_ptr<JsonValue>& json,
+                                                 bool* nonrelative) const;
+
+    /**
+     * Recursively builds the children of a node from the given JSON.
+     *
+     * The children are defined by the "children" attribute of the JSON.
+     *
+     * @param node          The node to add the children to
+     * @param json          The JSON object defining the node
+     * @param nonrelative   Whether the children ignore the node color
+     */
+    void buildChildren(scene2::SceneNode* node, const std::shared_ptr<JsonValue>& json,
+                       bool nonrelative) const;
+
+    /**
+     * Adds the given child to its parent, registering its layout information
+     *
+     * @param parent        The parent node
+     * @param child         The child node
+     * @param json          The JSON object defining the child
+     * @param nonrelative   Whether the child ignores the parent color
+     */
+    void attachChild(scene2::SceneNode* parent, const std::shared_ptr<scene2::SceneNode>& child,
+                     const std::shared_ptr<JsonValue>& json, bool nonrelative) const;
+
+    /**
+     * Returns true if the children of the given node should be deferred.
+     *
+     * If so, this method assigns the node a deferred builder (see
+     * {@link SceneNode#setDeferredChildren}), and the children are not
+     * built until the node is first made visible.
+     *
+     * @param node          The node to check
+     * @param json          The JSON object defining the node
+     * @param nonrelative   Whether the children ignore the node color
+     *
+     * @return true if the children of the given node should be deferred.
+     */
+    bool deferChildren(scene2::SceneNode* node, const std::shared_ptr<JsonValue>& json,
+                       bool nonrelative) const;
+
+    /**
+     * Builds the scene from the given JSON tree across several frames.
+     *
+     * This method must be called on the main thread. Each frame, it builds
+     * as many nodes as it can within the frame budget (see {@link #getFrameBudget}).
+     * When the scene is complete, it is laid out and materialized.
+     *
+     * @param key       The key to access the scene after loading
+     * @param json      The JSON object defining the scene
+     * @param callback  An optional callback for asynchronous loading
+     */
+    void stream(const std::string key, const std::shared_ptr<JsonValue>& json,
+                LoaderCallback callback);
     
 public:
 #pragma mark -
@@ -272,7 +375,7 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a loader on
      * the heap, use one of the static constructors instead.
      */
-    Scene2Loader() { _jsonKey = "scene2s"; _priority = 1; }
+    Scene2Loader() : _budget(0), _deferHidden(false) { _jsonKey = "scene2s"; _priority = 1; }
     
     /**
      * Initializes a new asset loader.
@@ -392,6 +495,63 @@ public:
      */
     std::shared_ptr<scene2::SceneNode> build(const std::string key, const std::shared_ptr<JsonValue>& json) const;
     
+#pragma mark -
+#pragma mark Incremental Loading
+    /**
+     * Returns the time to spend building scenes each frame, in microseconds.
+     *
+     * If this value is positive, an asynchronous load does not build its
+     * scene all at once. Instead, the JSON is parsed (on the thread pool, if
+     * there is one) and the scene is built on the main thread a few nodes at
+     * a time, stopping each frame once this time is exceeded. This avoids a
+     * hitch when a large scene is loaded. A value of 0 (the default) builds
+     * the entire scene at once. Synchronous loads are never split.
+     *
+     * @return the time to spend building scenes each frame, in microseconds.
+     */
+    Uint32 getFrameBudget() const { return _budget; }
+
+    /**
+     * Sets the time to spend building scenes each frame, in microseconds.
+     *
+     * If this value is positive, an asynchronous load does not build its
+     * scene all at once. Instead, the JSON is parsed (on the thread pool, if
+     * there is one) and the scene is built on the main thread a few nodes at
+     * a time, stopping each frame once this time is exceeded. This avoids a
+     * hitch when a large scene is loaded. A value of 0 (the default) builds
+     * the entire scene at once. Synchronous loads are never split.
+     *
+     * @param micros    The time to spend building scenes each frame
+     */
+    void setFrameBudget(Uint32 micros) { _budget = micros; }
+
+    /**
+     * Returns true if the children of hidden nodes are built on demand.
+     *
+     * If true, a node that is not visible in its JSON has its children built
+     * the first time that it is made visible (see {@link SceneNode#setVisible}).
+     * This speeds up the loading of scenes with many hidden menus. However,
+     * the deferred children are not registered as assets, and cannot be found
+     * by name until they are built. The default is false.
+     *
+     * @return true if the children of hidden nodes are built on demand.
+     */
+    bool isDeferHidden() const { return _deferHidden; }
+
+    /**
+     * Sets whether the children of hidden nodes are built on demand.
+     *
+     * If true, a node that is not visible in its JSON has its children built
+     * the first time that it is made visible (see {@link SceneNode#setVisible}).
+     * This speeds up the loading of scenes with many hidden menus. However,
+     * the deferred children are not registered as assets, and cannot be found
+     * by name until they are built. Because the children are built by this
+     * loader, it must outlive any such nodes. The default is false.
+     *
+     * @param value Whether the children of hidden nodes are built on demand
+     */
+    void setDeferHidden(bool value) { _deferHidden = value; }
+    
 };
     
 }
@@ -141,6 +141,19 @@ protected:
      */
     virtual bool read(const std::shared_ptr<JsonValue>& json,
                       LoaderCallback callback, bool async) override;
+
+    /**
+     * Returns the estimated memory used by the given sound in bytes
+     *
+     * For an in-memory sample, this is the size of the PCM buffer. For a
+     * compressed sample, it is the size of the encoded data. Samples
+     * streamed from a file, and other sound types, have size 0.
+     *
+     * @param asset The sound to measure
+     *
+     * @return the estimated memory used by the given sound in bytes
+     */
+    virtual size_t measure(const std::shared_ptr<Sound>& asset) const override;
     
     
 public:
@@ -47,6 +47,7 @@
 #define __CU_TEXTURE_LOADER_H__
 #include <cugl/assets/CULoader.h>
 #include <cugl/render/CUTexture.h>
+#include <deque>
 
 namespace cugl {
 
@@ -66,6 +67,19 @@ namespace cugl {
  * remainder of asset loading using {@link Application#schedule}.  This is a
  * good template for asset loaders in general.
  *
+ * Sending a large image to the graphics card can take several milliseconds,
+ * which shows up as a frame spike when assets are loaded during gameplay. To
+ * prevent this, you can give the loader an upload budget with the method
+ * {@link #setUploadBudget}. Asynchronous textures are then sent a few rows at
+ * a time over several animation frames, and no frame sends more than the given
+ * number of bytes. The texture only becomes available (and the callback is
+ * only invoked) once all of its rows have been sent.
+ *
+ * Many small textures mean many texture switches (and hence draw calls) in a
+ * {@link SpriteBatch}. A directory entry with a "pack" object merges several
+ * images into shared atlas pages when they are loaded. Each image is then a
+ * subtexture of its page, with the same key it would have had on its own.
+ *
  * As with all of our loaders, this loader is designed to be attached to an
  * asset manager. Use the method {@link getHook()} to get the appropriate
  * pointer for attaching the loader.
@@ -86,6 +100,47 @@ protected:
     GLuint _wrapt;
     /** The default support for mipmaps */
     bool _mipmaps;
+
+    /**
+     * A texture that is being sent to the graphics card over several frames
+     */
+    class Upload {
+    public:
+        /** The key to access the asset after loading */
+        std::string key;
+        /** The directory entry for the asset (nullptr if there is none) */
+        std::shared_ptr<JsonValue> json;
+        /** The image data (owned by this upload) */
+        SDL_Surface* surface;
+        /** The texture receiving the data (nullptr if not yet allocated) */
+        std::shared_ptr<Texture> texture;
+        /** The number of rows sent so far */
+        int rows;
+        /** An optional callback for asynchronous loading */
+        LoaderCallback callback;
+    };
+
+    /** The maximum number of bytes to send to the graphics card each frame (0 for no limit) */
+    size_t _budget;
+    /** The textures waiting to be sent, in the order that they were loaded */
+    std::deque<Upload> _uploads;
+    /** Whether the upload queue is scheduled with the application */
+    bool _pumping;
+
+    /**
+     * A collection of images packed into shared atlas pages
+     */
+    class PackedAtlas {
+    public:
+        /** The page images (owned by this atlas) */
+        std::vector<SDL_Surface*> pages;
+        /** The key of each packed image */
+        std::vector<std::string> names;
+        /** The page of each packed image */
+        std::vector<size_t> page;
+        /** The pixel bounds of each packed image in its page */
+        std::vector<SDL_Rect> bounds;
+    };
     
 #pragma mark Asset Loading
     /**
@@ -100,6 +155,41 @@ protected:
      * @param texture   The texture loaded for this asset
      */
     void parseAtlas(const std::shared_ptr<JsonValue>& json, const std::shared_ptr<Texture>& texture);
+
+    /**
+     * Loads and packs the images of a packed atlas outside the main thread.
+     *
+     * A packed atlas is a directory entry with a "pack" object mapping keys to
+     * image files. The images are read and arranged into as few atlas pages as
+     * possible with a skyline packer. The pages are images in memory; they are
+     * not yet textures. This method returns nullptr if any image fails to load
+     * or is larger than a page.
+     *
+     * @param json      The asset directory entry
+     *
+     * @return the atlas pages and the position of each image
+     */
+    std::shared_ptr<PackedAtlas> preloadPack(const std::shared_ptr<JsonValue>& json);
+
+    /**
+     * Creates the OpenGL textures for a packed atlas.
+     *
+     * This method finishes the asset loading started in {@link preloadPack}.
+     * The first page is assigned the key of the directory entry, and page n
+     * (n > 0) is assigned that key followed by "_page" and n. Every packed
+     * image is a subtexture of its page, assigned the key that it had in the
+     * "pack" object. Hence code that asks for the image by key does not need
+     * to know that it was packed.
+     *
+     * This method supports an optional callback function which reports whether
+     * the asset was successfully materialized.
+     *
+     * @param json      The asset directory entry
+     * @param atlas     The atlas pages (or nullptr if packing failed)
+     * @param callback  An optional callback for asynchronous loading
+     */
+    void materializePack(const std::shared_ptr<JsonValue>& json, const std::shared_ptr<PackedAtlas>& atlas,
+                         LoaderCallback callback);
     
     /**
      * Loads the portion of this asset that is safe to load outside the main thread.
@@ -152,6 +242,9 @@ protected:
      *      "magfilter":    The name of the min filter ("nearest" or "linear")
      *      "wrapS":        The s-coord wrap rule ("clamp", "repeat", or "mirrored")
      *      "wrapT":        The t-coord wrap rule ("clamp", "repeat", or "mirrored")
+     *      "compressed":   An object mapping the compression families "astc", "etc2",
+     *                      and "bc" to KTX files. The first family (in that order)
+     *                      supported by this device replaces "file".
      *
      * The asset key is the key for the JSON directory entry
      *
@@ -163,6 +256,86 @@ protected:
      * @param callback  An optional callback for asynchronous loading
      */
     void materialize(const std::shared_ptr<JsonValue>& json, SDL_Surface* surface, LoaderCallback callback);
+
+    /**
+     * Adds the SDL_Surface to the upload queue.
+     *
+     * This method is the alternative to {@link materialize} when there is an
+     * upload budget. It takes ownership of the surface. The texture is created
+     * and finished by {@link pumpUploads} over the following animation frames.
+     *
+     * @param key       The key to access the asset after loading
+     * @param json      The asset directory entry (or nullptr if there is none)
+     * @param surface   The SDL_Surface to convert
+     * @param callback  An optional callback for asynchronous loading
+     */
+    void stageUpload(const std::string key, const std::shared_ptr<JsonValue>& json,
+                     SDL_Surface* surface, LoaderCallback callback);
+
+    /**
+     * Sends the next rows of the upload queue to the graphics card.
+     *
+     * This method is called once an animation frame while the upload queue is
+     * not empty. It sends rows from the oldest textures in the queue until the
+     * upload budget is reached. Every frame sends at least one row, even if
+     * that row is larger than the budget. Any finished texture has its settings
+     * applied and is added to the loader.
+     *
+     * @return true if there are still textures in the upload queue
+     */
+    bool pumpUploads();
+
+    /**
+     * Loads the compressed image that is safe to load outside the main thread.
+     *
+     * This is the alternative to {@link preload} for KTX and KTX2 files. The
+     * compressed data is read from the file, but it is not decoded.
+     *
+     * @param source    The pathname to the asset
+     *
+     * @return the compressed image with the texture information
+     */
+    std::shared_ptr<CompressedImage> preloadImage(const std::string source);
+
+    /**
+     * Creates an OpenGL texture from the compressed image, and assigns it the given key.
+     *
+     * This method finishes the asset loading started in {@link preloadImage}.
+     * This step is not safe to be done in a separate thread.  Instead, it takes
+     * place in the main CUGL thread via {@link Application#schedule}.
+     *
+     * The loaded texture will have default parameters for scaling and wrap.
+     * It will only have mipmaps if they are stored in the file.
+     *
+     * This method supports an optional callback function which reports whether
+     * the asset was successfully materialized.
+     *
+     * @param key       The key to access the asset after loading
+     * @param image     The compressed image to upload
+     * @param callback  An optional callback for asynchronous loading
+     */
+    void materialize(const std::string key, const std::shared_ptr<CompressedImage>& image,
+                     LoaderCallback callback);
+
+    /**
+     * Creates an OpenGL texture from the compressed image accoring to the directory entry.
+     *
+     * This method finishes the asset loading started in {@link preloadImage}.
+     * This step is not safe to be done in a separate thread.  Instead, it takes
+     * place in the main CUGL thread via {@link Application#schedule}.
+     *
+     * The asset key is the key for the JSON directory entry. The texture will
+     * only have mipmaps if they are stored in the file.
+     *
+     * This method supports an optional callback function which reports whether
+     * the asset was successfully materialized.
+     *
+     * @param json      The asset directory entry
+     * @param image     The compressed image to upload
+     * @param callback  An optional callback for asynchronous loading
+     */
+    void materialize(const std::shared_ptr<JsonValue>& json, const std::shared_ptr<CompressedImage>& image,
+                     LoaderCallback callback);
     
 
     /**
@@ -208,6 +381,13 @@ protected:
      *      "magfilter":    The name of the min filter ("nearest" or "linear")
      *      "wrapS":        The s-coord wrap rule ("clamp", "repeat", or "mirrored")
      *      "wrapT":        The t-coord wrap rule ("clamp", "repeat", or "mirrored")
+     *      "compressed":   An object mapping the compression families "astc", "etc2",
+     *                      and "bc" to KTX files. The first family (in that order)
+     *                      supported by this device replaces "file".
+     *      "pack":         An object mapping keys to image files. These images are
+     *                      packed into shared atlas pages, replacing "file".
+     *      "pagesize":     The maximum width and height of a packed page (int)
+     *      "padding":      The transparent pixels between packed images (int)
      *
      * @param json      The directory entry for the asset
      * @param callback  An optional callback for asynchronous loading
@@ -235,6 +415,32 @@ protected:
      * @return true if the asset was successfully unloaded
      */
     virtual bool purge(const std::shared_ptr<JsonValue>& json) override;
+
+    /**
+     * Returns the files read to load the given directory entry
+     *
+     * This is the source file chosen for this device (see the "compressed"
+     * attribute), or every image of a packed atlas. This method queries the
+     * OpenGL context, and so it must be called in the main thread.
+     *
+     * @param json      The directory entry for the asset
+     *
+     * @return the files read to load the given directory entry
+     */
+    virtual std::vector<std::string> locate(const std::shared_ptr<JsonValue>& json) const override;
+
+    /**
+     * Returns the estimated GPU memory used by the given texture in bytes
+     *
+     * Subtextures share the memory of their parent, and so have size 0.
+     * Compressed textures are assumed to use one byte per pixel, and mipmaps
+     * add a third to the size of the texture.
+     *
+     * @param asset The texture to measure
+     *
+     * @return the estimated GPU memory used by the given texture in bytes
+     */
+    virtual size_t measure(const std::shared_ptr<Texture>& asset) const override;
     
 public:
 #pragma mark -
@@ -259,6 +465,11 @@ public:
      * fail.  You must reinitialize the loader to begin loading assets again.
      */
     void dispose() override {
+        for(auto it = _uploads.begin(); it != _uploads.end(); ++it) {
+            SDL_FreeSurface(it->surface);
+            _queue.erase(it->key);
+        }
+        _uploads.clear();
         _jsonKey  = "";
         _priority = 0;
         _assets.clear();
@@ -407,6 +618,43 @@ public:
      */
     void setMipMaps(bool flag) { _mipmaps = flag; }
 
+    /**
+     * Returns the maximum number of bytes sent to the graphics card each frame.
+     *
+     * This budget only applies to asynchronous loading. A texture larger than
+     * the budget is sent a few rows at a time over several animation frames.
+     * A budget of 0 (the default) means there is no limit, and every texture
+     * is sent in the frame after it is read.
+     *
+     * @return the maximum number of bytes sent to the graphics card each frame.
+     */
+    size_t getUploadBudget() const { return _budget; }
+
+    /**
+     * Sets the maximum number of bytes sent to the graphics card each frame.
+     *
+     * This budget only applies to asynchronous loading. A texture larger than
+     * the budget is sent a few rows at a time over several animation frames.
+     * A budget of 0 (the default) means there is no limit, and every texture
+     * is sent in the frame after it is read.
+     *
+     * Compressed textures are always sent in a single frame, as they are a
+     * fraction of the size of an uncompressed texture.
+     *
+     * @param bytes The maximum number of bytes sent to the graphics card each frame.
+     */
+    void setUploadBudget(size_t bytes) { _budget = bytes; }
+
+    /**
+     * Returns the number of textures waiting to be sent to the graphics card.
+     *
+     * These textures have been read from their files, but are not yet
+     * available to the loader.
+     *
+     * @return the number of textures waiting to be sent to the graphics card.
+     */
+    size_t uploadCount() const { return _uploads.size(); }
+
 };
 
 }
@@ -30,6 +30,7 @@
 #define __CU_ASSETS_PKG_H__
 
 #include "CUJsonValue.h"
+#include "CUJsonDocument.h"
 #include "CUWidgetValue.h"
 #include "CUAssetManager.h"
 #include "CUTextureLoader.h"
@@ -34,6 +34,7 @@
 #include <SDL.h>
 #include <string>
 #include <memory>
+#include <vector>
 #include "CUAudioTypes.h"
 #include <SDL_codec.h>
 
@@ -94,6 +95,9 @@ protected:
     /** The underlying decoder from SDL_codec */
     CODEC_Source* _source;
 
+    /** The encoded file data for an in-memory decoder (OPTIONAL) */
+    std::shared_ptr<std::vector<Uint8>> _data;
+
 public:
     /**
      * Creates an initialized audio decoder
@@ -134,6 +138,26 @@ public:
      */
     bool init(const std::string file, AudioType type);
 
+    /**
+     * Initializes a new decoder for the given encoded file data.
+     *
+     * The data is the complete contents of an audio file of the given type,
+     * still in its compressed form. The decoder reads from this memory instead
+     * of the file system, and keeps a reference to the data while it is open.
+     * The name is only used for error messages and {@link getFile}.
+     *
+     * If the audio type is not correct for this data, this initializer
+     * will fail and return false.
+     *
+     * @param name  the name of the source file for the data
+     * @param data  the encoded file data
+     * @param type  the codec type for this data
+     *
+     * @return true if the decoder was initialized successfully
+     */
+    bool initWithData(const std::string name, const std::shared_ptr<std::vector<Uint8>>& data,
+                      AudioType type);
+
     /**
      * Deletes the decoder resources and resets all attributes.
      *
@@ -176,6 +200,30 @@ public:
         return (result->init(file,type) ? result : nullptr);
     }
 
+    /**
+     * Creates a newly allocated decoder for the given encoded file data.
+     *
+     * The data is the complete contents of an audio file of the given type,
+     * still in its compressed form. The decoder reads from this memory instead
+     * of the file system, and keeps a reference to the data while it is open.
+     * The name is only used for error messages and {@link getFile}.
+     *
+     * If the audio type is not correct for this data, this allocator
+     * will fail and return nullptr.
+     *
+     * @param name  the name of the source file for the data
+     * @param data  the encoded file data
+     * @param type  the codec type for this data
+     *
+     * @return a newly allocated decoder for the given encoded file data.
+     */
+    static std::shared_ptr<AudioDecoder> allocWithData(const std::string name,
+                                                       const std::shared_ptr<std::vector<Uint8>>& data,
+                                                       AudioType type) {
+        std::shared_ptr<AudioDecoder> result = std::make_shared<AudioDecoder>();
+        return (result->initWithData(name,data,type) ? result : nullptr);
+    }
+
     
 #pragma mark Attributes
     /**
@@ -42,6 +42,7 @@
 #include <cugl/audio/CUAudioDevices.h>
 #include <cugl/audio/CUSound.h>
 #include <cugl/util/CUTimestamp.h>
+#include <cugl/math/CUVec2.h>
 #include <unordered_map>
 #include <functional>
 #include <vector>
@@ -69,8 +70,13 @@ namespace cugl {
         class AudioMixer;
         class AudioFader;
         class AudioPanner;
+        class AudioPlayer;
+        class AudioResampler;
     }
 
+    /** Forward reference for sample pooling */
+    class AudioSample;
+
     /** AudioQueue for music support */
     class AudioQueue;
 
@@ -126,6 +132,40 @@ public:
     };
 
 private:
+    /**
+     * A lightweight sound emitter for the spatial bus
+     *
+     * Emitters are not audio nodes. They only acquire a voice (and with it a
+     * panner and fader) when they are among the loudest emitters.
+     */
+    class Emitter {
+    public:
+        /** The emitter identifier */
+        Uint32 id;
+        /** The sound effect key used when the emitter has a voice */
+        std::string key;
+        /** The sound played by this emitter */
+        std::shared_ptr<Sound> sound;
+        /** The emitter position */
+        Vec2 position;
+        /** The emitter gain */
+        float gain;
+        /** The emitter occlusion (0 for none, 1 for complete) */
+        float occlusion;
+        /** The attenuated gain computed by the last update */
+        float level;
+        /** The stereo pan computed by the last update */
+        float pan;
+        /** Whether the sound loops */
+        bool loop;
+        /** Whether the emitter currently has a voice */
+        bool voiced;
+        /** Whether the emitter was chosen by the last update */
+        bool chosen;
+        /** Whether a non-looping emitter has finished playing */
+        bool done;
+    };
+
     /** Reference to the audio engine singleton */
     static AudioEngine* _gEngine;
     /** The read size to use for the audio devices */
@@ -151,13 +191,41 @@ private:
     
     /** Map keys to identifiers */
     std::unordered_map<std::string,std::shared_ptr<audio::AudioFader>> _actives;
-    /** A queue for slot eviction if necessary */
-    std::deque<std::string> _evicts;
+    /** The priority of the voice in each slot */
+    std::vector<Sint32> _priorities;
+    /** The start order of the voice in each slot (for voice stealing) */
+    std::vector<Uint64> _stamps;
+    /** The start order of the most recent voice */
+    Uint64 _counter;
+    /** The maximum number of simultaneous sound effects */
+    size_t _maxvoices;
 
     /** An object pool of faders for individual sound instances */
     std::deque<std::shared_ptr<audio::AudioFader>>  _fadePool;
     /** An object pool of panners for panning sound assets */
     std::deque<std::shared_ptr<audio::AudioPanner>> _panPool;
+    /** An object pool of (uninitialized) players for sound effect samples */
+    std::deque<std::shared_ptr<audio::AudioPlayer>> _playPool;
+    /** An object pool of resamplers for sounds at a different sample rate */
+    std::vector<std::shared_ptr<audio::AudioResampler>> _samplePool;
+
+    // The spatial bus
+    /** The spatial emitters */
+    std::vector<Emitter> _emitters;
+    /** Map emitter identifiers to their position in _emitters */
+    std::unordered_map<Uint32,size_t> _emitterids;
+    /** The audible emitters found by the last update */
+    std::vector<size_t> _audibles;
+    /** The identifier of the next emitter */
+    Uint32 _nextEmitter;
+    /** The listener position */
+    Vec2 _listener;
+    /** The distance at which emitters begin to attenuate */
+    float _nearDistance;
+    /** The distance at which emitters are silent */
+    float _farDistance;
+    /** The maximum number of emitters with a voice */
+    size_t _spatialVoices;
 
     /**
      * Callback function for the sound effects
@@ -224,6 +292,39 @@ private:
      */
     void removeKey(const std::string key);
 
+    /**
+     * Returns a slot for a new sound effect of the given priority
+     *
+     * This method first looks for an empty slot, provided that the number of
+     * active effects is less than {@link #getMaxVoices}. It then looks for a
+     * slot whose effect is fading out. If neither exists, it steals the
+     * voice of the active effect with the lowest priority. Ties are broken
+     * by choosing the quietest voice, and then the oldest. Only effects of
+     * strictly lower priority may be stolen unless force is true, in which
+     * case the priority is ignored.
+     *
+     * This method returns -1 if there is no slot available.
+     *
+     * @param priority  The priority of the new sound effect
+     * @param force     Whether to ignore priority when stealing a voice
+     *
+     * @return a slot for a new sound effect of the given priority
+     */
+    Sint32 acquireSlot(Sint32 priority, bool force);
+
+    /**
+     * Returns a playback node for the given sound asset
+     *
+     * If the sound is an {@link AudioSample}, this method reinitializes a
+     * player from the object pool, so no allocation is required. Otherwise,
+     * (or if the pool is empty) it uses {@link Sound#createNode}.
+     *
+     * @param sound     The sound asset to play
+     *
+     * @return a playback node for the given sound asset
+     */
+    std::shared_ptr<audio::AudioNode> acquirePlayer(const std::shared_ptr<Sound>& sound);
+
     /**
      * Returns a playable audio node for a given audio instance
      *
@@ -233,10 +334,10 @@ private:
      * arbitrary audio subgraphs. This method uses the object pools to simplify
      * this process.
      *
-     * This method will also allocated an {@link AudioResampler} if the sample
-     * rate is not consistent with the engine.  However, these are extremely
-     * heavy-weight and cannot be easily reused, and this is to be avoided if
-     * at all possible.
+     * This method will also use an {@link AudioResampler} if the sample rate
+     * is not consistent with the engine. These are heavy-weight, so they are
+     * pooled by channels and input rate. A resampler is only allocated if
+     * there is no pooled one with the same settings.
      *
      * @param instance  The audio instance
      *
@@ -487,21 +588,24 @@ public:
      * method will stop the existing sound and replace it with this one. It
      * is the responsibility of the application layer to manage key usage.
      *
-     * There are a limited number of slots available for sounds. If you go
-     * over the number available, the sound will not play unless `force` is
-     * true. In that case, it will grab the channel from the longest playing
-     * sound effect.
+     * There are a limited number of voices available for sounds (see
+     * {@link #getMaxVoices}). If you go over the number available, the sound
+     * will steal the voice of an active effect with lower priority. Among
+     * those, it takes the quietest voice, and then the longest playing one.
+     * If there is no effect with lower priority, the sound will not play
+     * unless `force` is true. In that case, it ignores priority.
      *
      * @param  key      The reference key for the sound effect
      * @param  sound    The sound effect to play
      * @param  loop     Whether to loop the sound effect continuously
      * @param  volume   The music volume (relative to the default asset volume)
      * @param  force    Whether to force another sound to stop.
+     * @param  priority The priority of this sound for voice stealing
      *
      * @return true if there was an available channel for the sound
      */
     bool play(const std::string key, const std::shared_ptr<Sound>& sound,
-              bool loop=false, float volume=1.0f, bool force=false);
+              bool loop=false, float volume=1.0f, bool force=false, Sint32 priority=0);
 
     /**
      * Plays the given audio node, and associates it with the specified key.
@@ -520,37 +624,89 @@ public:
      * method will stop the existing sound and replace it with this one. It
      * is the responsibility of the application layer to manage key usage.
      *
-     * There are a limited number of slots available for sounds. If you go
-     * over the number available, the sound will not play unless `force` is
-     * true. In that case, it will grab the channel from the longest playing
-     * sound effect.
+     * There are a limited number of voices available for sounds (see
+     * {@link #getMaxVoices}). If you go over the number available, the sound
+     * will steal the voice of an active effect with lower priority. Among
+     * those, it takes the quietest voice, and then the longest playing one.
+     * If there is no effect with lower priority, the sound will not play
+     * unless `force` is true. In that case, it ignores priority.
      *
      * @param  key      The reference key for the sound effect
      * @param  graph    The audio graph to play
      * @param  loop     Whether to loop the sound effect continuously
      * @param  volume   The music volume (relative to the default instance volume)
      * @param  force    Whether to force another sound to stop.
+     * @param  priority The priority of this sound for voice stealing
      *
      * @return true if there was an available channel for the sound
      */
     bool play(const std::string key, const std::shared_ptr<audio::AudioNode>& graph,
-              bool loop=false, float volume=1.0f, bool force=false);
+              bool loop=false, float volume=1.0f, bool force=false, Sint32 priority=0);
     
     /**
      * Returns the number of slots available for sound effects.
      *
      * There are a limited number of slots available for sound effects.  If
      * all slots are in use, this method will return 0. If you go over the
-     * number available, you cannot play another sound unless you force it.
-     * In that case, it will grab the slot from the longest playing sound
-     * effect.
+     * number available, another sound will only play if it can steal the
+     * voice of an effect with lower priority (or if you force it).
      *
      * @return the number of slots available for sound effects.
      */
     size_t getAvailableSlots() const {
-        return _capacity-_actives.size();
+        return _maxvoices > _actives.size() ? _maxvoices-_actives.size() : 0;
     }
 
+    /**
+     * Returns the maximum number of simultaneous sound effects.
+     *
+     * This value is a voice budget that may be less than the number of slots
+     * allocated when the engine was started. Limiting the voices limits the
+     * mixing cost when many effects are triggered at once. By default, this
+     * is the number of slots.
+     *
+     * @return the maximum number of simultaneous sound effects.
+     */
+    size_t getMaxVoices() const { return _maxvoices; }
+
+    /**
+     * Sets the maximum number of simultaneous sound effects.
+     *
+     * This value is a voice budget that may be less than the number of slots
+     * allocated when the engine was started. Limiting the voices limits the
+     * mixing cost when many effects are triggered at once. The value is
+     * clamped to the number of slots. Lowering the budget does not stop any
+     * active effects; it only applies to future calls to {@link #play}.
+     *
+     * @param voices    The maximum number of simultaneous sound effects.
+     */
+    void setMaxVoices(size_t voices);
+
+    /**
+     * Returns the voice stealing priority of the sound effect.
+     *
+     * A new sound effect may only steal the voice of an effect with lower
+     * priority (unless it is forced). If the key does not correspond to an
+     * active sound effect, this method returns 0.
+     *
+     * @param  key  the reference key for the sound effect
+     *
+     * @return the voice stealing priority of the sound effect.
+     */
+    Sint32 getPriority(const std::string key) const;
+
+    /**
+     * Sets the voice stealing priority of the sound effect.
+     *
+     * A new sound effect may only steal the voice of an effect with lower
+     * priority (unless it is forced). If the key does not correspond to an
+     * active sound effect, this method does nothing.
+     *
+     * @param  key      the reference key for the sound effect
+     * @param  priority the voice stealing priority of the sound effect
+     */
+    void setPriority(const std::string key, Sint32 priority);
+
     /**
      * Returns the current state of the sound effect for the given key.
      *
@@ -849,6 +1005,172 @@ public:
         return _callback;
     }
 
+#pragma mark -
+#pragma mark Spatial Audio
+    /**
+     * Returns the identifier of a newly added spatial emitter.
+     *
+     * An emitter is a lightweight record of a sound at a position. Adding an
+     * emitter does not play the sound. Each call to {@link #updateSpatial}
+     * computes the attenuation of every emitter from the listener, and only
+     * the loudest emitters (see {@link #getSpatialVoices}) are given a voice.
+     * Those voices are sound effects that are panned by the emitter position,
+     * but they have a lower priority than normal sound effects. So a sound
+     * effect may steal the voice of an emitter.
+     *
+     * A looping emitter restarts its sound whenever it regains a voice. A
+     * non-looping emitter only plays once, and is silent from then on.
+     *
+     * @param sound     The sound for this emitter
+     * @param position  The emitter position
+     * @param gain      The emitter gain (before attenuation)
+     * @param loop      Whether the sound loops
+     *
+     * @return the identifier of a newly added spatial emitter.
+     */
+    Uint32 addEmitter(const std::shared_ptr<Sound>& sound, const Vec2& position,
+                      float gain=1.0f, bool loop=true);
+
+    /**
+     * Removes the given spatial emitter, stopping its voice.
+     *
+     * If the identifier does not correspond to an emitter, this method does
+     * nothing.
+     *
+     * @param id    The emitter identifier
+     * @param fade  The number of seconds to fade out
+     */
+    void removeEmitter(Uint32 id, float fade=DEFAULT_FADE);
+
+    /**
+     * Removes all spatial emitters, stopping their voices.
+     *
+     * @param fade  The number of seconds to fade out
+     */
+    void clearEmitters(float fade=DEFAULT_FADE);
+
+    /**
+     * Returns true if the identifier corresponds to a spatial emitter.
+     *
+     * @param id    The emitter identifier
+     *
+     * @return true if the identifier corresponds to a spatial emitter.
+     */
+    bool hasEmitter(Uint32 id) const {
+        return _emitterids.find(id) != _emitterids.end();
+    }
+
+    /**
+     * Sets the position of the given spatial emitter.
+     *
+     * The change takes effect on the next call to {@link #updateSpatial}.
+     *
+     * @param id        The emitter identifier
+     * @param position  The emitter position
+     */
+    void setEmitterPosition(Uint32 id, const Vec2& position);
+
+    /**
+     * Sets the gain (before attenuation) of the given spatial emitter.
+     *
+     * The change takes effect on the next call to {@link #updateSpatial}.
+     *
+     * @param id    The emitter identifier
+     * @param gain  The emitter gain
+     */
+    void setEmitterGain(Uint32 id, float gain);
+
+    /**
+     * Sets the occlusion of the given spatial emitter.
+     *
+     * Occlusion is a value from 0 (no occlusion) to 1 (completely blocked).
+     * It is computed by the application, typically with a raycast from the
+     * listener. A completely occluded emitter is culled. The change takes
+     * effect on the next call to {@link #updateSpatial}.
+     *
+     * @param id        The emitter identifier
+     * @param occlusion The emitter occlusion
+     */
+    void setEmitterOcclusion(Uint32 id, float occlusion);
+
+    /**
+     * Returns true if the given spatial emitter currently has a voice.
+     *
+     * @param id    The emitter identifier
+     *
+     * @return true if the given spatial emitter currently has a voice.
+     */
+    bool isEmitterAudible(Uint32 id) const;
+
+    /**
+     * Returns the listener position for the spatial emitters.
+     *
+     * @return the listener position for the spatial emitters.
+     */
+    const Vec2& getListenerPosition() const { return _listener; }
+
+    /**
+     * Sets the listener position for the spatial emitters.
+     *
+     * The change takes effect on the next call to {@link #updateSpatial}.
+     *
+     * @param position  The listener position
+     */
+    void setListenerPosition(const Vec2& position) { _listener = position; }
+
+    /**
+     * Returns the distance at which spatial emitters begin to attenuate.
+     *
+     * @return the distance at which spatial emitters begin to attenuate.
+     */
+    float getNearDistance() const { return _nearDistance; }
+
+    /**
+     * Returns the distance at which spatial emitters are silent.
+     *
+     * @return the distance at which spatial emitters are silent.
+     */
+    float getFarDistance() const { return _farDistance; }
+
+    /**
+     * Sets the attenuation range of the spatial emitters.
+     *
+     * Emitters closer than the near distance play at full gain. Emitters
+     * farther than the far distance are culled. In between, the gain falls
+     * off linearly.
+     *
+     * @param inner The distance at which emitters begin to attenuate
+     * @param outer The distance at which emitters are silent
+     */
+    void setSpatialRange(float inner, float outer);
+
+    /**
+     * Returns the maximum number of spatial emitters with a voice.
+     *
+     * @return the maximum number of spatial emitters with a voice.
+     */
+    size_t getSpatialVoices() const { return _spatialVoices; }
+
+    /**
+     * Sets the maximum number of spatial emitters with a voice.
+     *
+     * The value is clamped to the number of slots.
+     *
+     * @param voices    The maximum number of spatial emitters with a voice.
+     */
+    void setSpatialVoices(size_t voices);
+
+    /**
+     * Updates the voices of the spatial emitters.
+     *
+     * This method computes the attenuation and pan of every emitter in a
+     * single pass. It then culls the emitters that are inaudible, and keeps
+     * only the loudest {@link #getSpatialVoices} emitters. Emitters that lost
+     * their place are faded out, and emitters that gained one are started.
+     * This should be called once an animation frame.
+     */
+    void updateSpatial();
+
 #pragma mark -
 #pragma mark Global Management
     /**
@@ -926,6 +1248,27 @@ public:
      * from the background.
      */
     void resume();
+
+#pragma mark -
+#pragma mark Profiling
+    /**
+     * Returns a snapshot of the callback timing for the audio device
+     *
+     * This is the profile of the {@link audio::AudioOutput} for this engine.
+     * It includes the load relative to the buffer period and the number of
+     * underruns. This method is lock-free, and is intended to be reported
+     * alongside the physics and netcode statistics.
+     *
+     * @return a snapshot of the callback timing for the audio device
+     */
+    audio::AudioProfile getProfile() const;
+
+    /**
+     * Resets the callback timing for the audio device
+     *
+     * The timing is cleared at the next callback of the audio device.
+     */
+    void resetProfile();
 };
 
 }
@@ -42,6 +42,7 @@
 #include "CUAudioTypes.h"
 #include "CUSound.h"
 #include <string>
+#include <vector>
 #include <atomic>
 
 namespace  cugl {
@@ -56,6 +57,9 @@ namespace  cugl {
  * The latter introduces some latency and is only ideal for long-playing music.
  *
  * The choice of buffered or streaming is independent of the file type.  
+ * A third option, compressed, keeps the encoded file in memory and streams
+ * from that memory. This is ideal for long sound effects, which would use
+ * too much memory as PCM data, but should not wait on the file system.
  * Currently, we support four file types: WAV (including ADPCM encodings), 
  * MP3, Ogg (Vorbis), and Flac.  As a general rule, we prefer WAV for sound 
  * effects and Ogg for music.
@@ -78,6 +82,9 @@ protected:
 
     /** The in-memory sound buffer for this sound source (OPTIONAL) */
     float* _buffer;
+
+    /** The encoded file data for a compressed sample (OPTIONAL) */
+    std::shared_ptr<std::vector<Uint8>> _bytes;
     
 public:
 #pragma mark Constructors
@@ -107,6 +114,21 @@ public:
      * @return true if the sound source was initialized successfully
      */
     bool init(const std::string file, bool stream=false);
+
+    /**
+     * Initializes a new compressed audio sample for the given file.
+     *
+     * A compressed sample reads the entire (encoded) file into memory, but
+     * does not decode it. Instead, it is streamed from memory, decoding each
+     * page as it is needed. Hence it uses much less memory than an in-memory
+     * sample, while never touching the file system during playback. Seeking
+     * is also much faster than with a streamed sample.
+     *
+     * @param file      The source file for the audio sample
+     *
+     * @return true if the sound source was initialized successfully
+     */
+    bool initCompressed(const std::string file);
     
     /**
      * Initializes an empty audio sample of the given size.
@@ -132,11 +154,14 @@ public:
 	 *
 	 *      "file":     The path to the source, relative to the asset directory
 	 *      "stream":   A boolean, indicating whether to stream the sample
+	 *      "compressed": A boolean, indicating whether to stream from memory
 	 *      "volume":   A float, representing the volume
 	 *
 	 * All attributes are optional.  There are no required attributes. By default,
 	 * audio samples are not streamed, meaning they are fully loaded into memory.
-	 * This is recommended for sound effects, but not for music.
+	 * This is recommended for sound effects, but not for music. A compressed
+	 * sample keeps the encoded file in memory, and takes precedence over
+	 * "stream".
 	 *
 	 * @param data      The JSON object specifying the audio sample
 	 *
@@ -169,6 +194,24 @@ public:
         std::shared_ptr<AudioSample> result = std::make_shared<AudioSample>();
         return (result->init(file,stream) ? result : nullptr);
     }
+
+    /**
+     * Returns a newly allocated compressed audio sample for the given file.
+     *
+     * A compressed sample reads the entire (encoded) file into memory, but
+     * does not decode it. Instead, it is streamed from memory, decoding each
+     * page as it is needed. Hence it uses much less memory than an in-memory
+     * sample, while never touching the file system during playback. Seeking
+     * is also much faster than with a streamed sample.
+     *
+     * @param file      The source file for the audio sample
+     *
+     * @return a newly allocated compressed audio sample for the given file.
+     */
+    static std::shared_ptr<AudioSample> allocCompressed(const std::string file) {
+        std::shared_ptr<AudioSample> result = std::make_shared<AudioSample>();
+        return (result->initCompressed(file) ? result : nullptr);
+    }
     
     /**
      * Returns an empty audio sample of the given size.
@@ -197,11 +240,14 @@ public:
      *
      *      "file":     The path to the source, relative to the asset directory
      *      "stream":   A boolean, indicating whether to stream the sample
+     *      "compressed": A boolean, indicating whether to stream from memory
      *      "volume":   A float, representing the volume
      *
      * All attributes are optional.  There are no required attributes. By default,
      * audio samples are not streamed, meaning they are fully loaded into memory.
-     * This is recommended for sound effects, but not for music.
+     * This is recommended for sound effects, but not for music. A compressed
+     * sample keeps the encoded file in memory, and takes precedence over
+     * "stream".
      *
      * @param data      The JSON object specifying the audio sample
      *
@@ -217,12 +263,32 @@ public:
     /**
      * Returns true if this is an streaming audio asset.
      *
-     * This method is to prevent the overhead of run-time typing.
+     * This method is to prevent the overhead of run-time typing. A compressed
+     * sample is always streamed (from memory).
      *
      * @return true if this is an streaming audio asset.
      */
     bool isStreamed() const { return _stream; }
 
+    /**
+     * Returns true if this audio asset is streamed from its encoded data.
+     *
+     * A compressed sample keeps the encoded file in memory instead of the
+     * decoded PCM data.
+     *
+     * @return true if this audio asset is streamed from its encoded data.
+     */
+    bool isCompressed() const { return _bytes != nullptr; }
+
+    /**
+     * Returns the size of the encoded data in bytes
+     *
+     * This value is 0 if the sample is not compressed.
+     *
+     * @return the size of the encoded data in bytes
+     */
+    size_t getEncodedSize() const { return _bytes == nullptr ? 0 : _bytes->size(); }
+
     /**
      * Returns the encoding type for this audio sample
      *
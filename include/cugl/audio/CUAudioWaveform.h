@@ -70,6 +70,10 @@ namespace  cugl {
  * it is compact and ideal for real-time sound generation. It is also good
  * enough for procedural sound generation in most games.
  *
+ * By default, the sine, triangle, square, and sawtooth waves are not computed
+ * at all. Instead, they are read from precomputed wavetables, with one table
+ * per octave. See {@link setWavetable} for more information.
+ *
  * The audio graph should only be accessed in the main thread.  In addition,
  * no methods marked as AUDIO THREAD ONLY should ever be accessed by the user.
  *
@@ -181,6 +185,8 @@ protected:
     std::atomic<int>    _type;
     /** Whether to limit the waveform to the positive y-axis. */
     std::atomic<bool>   _upper;
+    /** Whether to use the precomputed wavetables */
+    std::atomic<bool>   _tabled;
     /** The (normalized) fundamental frequency */
     std::atomic<float>  _frequency;
     /** Whether the frequency has changed recently */
@@ -323,6 +329,7 @@ public:
      *      "rate":     An int, representing the sample rate
      *      "volume":   A float, representing the volume
      *      "duration"  A float, representing the duration in seconds
+     *      "wavetable" A bool, indicating whether to use the wavetables
      *
      * All attributes are optional.  There are no required attributes. The
      * recognized shapes are as follows: noise, sine, native triangle, naive
@@ -378,6 +385,40 @@ public:
      */
     void setUpper(bool upper);
 
+    /**
+     * Returns true if the band-limited waveforms use precomputed wavetables.
+     *
+     * The wavetables are synthesized from the Fourier series of each shape, with
+     * one table per octave. They are shared by all waveforms, and reading them
+     * is much cheaper than PolyBLEP synthesis. In addition, they have no aliasing
+     * and do not attenuate the higher harmonics. This applies to the sine wave
+     * and the triangle, square, and sawtooth waves. Naive waveforms, noise, and
+     * impulse trains are always computed directly.
+     *
+     * This value is true by default. If it is false, the waveforms are generated
+     * with PolyBLEP as described in {@link Type}.
+     *
+     * @return true if the band-limited waveforms use precomputed wavetables.
+     */
+    bool isWavetable() const;
+
+    /**
+     * Sets whether the band-limited waveforms use precomputed wavetables.
+     *
+     * The wavetables are synthesized from the Fourier series of each shape, with
+     * one table per octave. They are shared by all waveforms, and reading them
+     * is much cheaper than PolyBLEP synthesis. In addition, they have no aliasing
+     * and do not attenuate the higher harmonics. This applies to the sine wave
+     * and the triangle, square, and sawtooth waves. Naive waveforms, noise, and
+     * impulse trains are always computed directly.
+     *
+     * This value is true by default. If it is false, the waveforms are generated
+     * with PolyBLEP as described in {@link Type}.
+     *
+     * @param value Whether the band-limited waveforms use precomputed wavetables.
+     */
+    void setWavetable(bool value);
+
     /**
      * Returns the fundamental frequency of this waveform.
      *
@@ -0,0 +1,225 @@
+//
+//  CUAudioCommandQueue.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a lock-free queue for sending changes from the main
+//  thread to the audio thread. Audio graph nodes use this queue to change
+//  their inputs or parameters without taking a lock in the audio callback.
+//  The commands are applied by the audio thread at the start of a read (at a
+//  buffer boundary), and are then handed back to the main thread to be
+//  deleted. Hence the audio thread never allocates or frees memory when it
+//  applies a command, even if that command drops the last reference to an
+//  audio node.
+//
+//  This is not a class. It is a class template. Templates do not have cpp
+//  files. They only have a header file.  When you include the header, it
+//  compiles the specific template used by your program. Hence all of the code
+//  for this templated class is in this header.
+//
+//  CUGL MIT License:
+//
+//     This software is provided 'as-is', without any express or implied
+//     warranty.  In no event will the authors be held liable for any damages
+//     arising from the use of this software.
+//
+//     Permission is granted to anyone to use this software for any purpose,
+//     including commercial applications, and to alter it and redistribute it
+//     freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_AUDIO_COMMAND_QUEUE_H__
+#define __CU_AUDIO_COMMAND_QUEUE_H__
+#include <atomic>
+
+namespace cugl {
+
+    /**
+     * The audio graph classes.
+     *
+     * This internal namespace is for the audio graph clases.  It was chosen
+     * to distinguish this graph from other graph class collections, such as the
+     * scene graph collections in {@link scene2}.
+     */
+    namespace audio {
+
+/**
+ * Template for a lock-free queue from the main thread to the audio thread.
+ *
+ * The main thread calls {@link #push} to send a command, and the audio thread
+ * calls {@link #apply} at the start of a read to process all of the commands
+ * sent since the last read, in the order that they were sent. Neither side
+ * ever waits on the other.
+ *
+ * The queue is a pair of linked stacks. Pushing a command links it to the
+ * pending stack with a compare-and-swap. The audio thread takes the entire
+ * pending stack with a single exchange, reverses it in place, and applies
+ * each command. It then links the spent commands to a retired stack, which
+ * the main thread deletes on the next push (or with {@link #reclaim}). A
+ * command that swaps a value on the audio thread (such as an input node)
+ * should keep the old value, so that it is released on the main thread.
+ *
+ * Only one thread may push, and only one thread may apply. The type T must
+ * have a move constructor.
+ */
+template <class T>
+class AudioCommandQueue {
+private:
+    /** A single command in a linked stack */
+    class Node {
+    public:
+        /** The command data */
+        T data;
+        /** The next command in the stack */
+        Node* next;
+
+        /**
+         * Creates a stack node acquiring the given command
+         *
+         * @param command   The command to acquire
+         */
+        Node(T&& command) : data(std::move(command)), next(nullptr) {}
+    };
+
+    /** The commands waiting for the audio thread (newest first) */
+    std::atomic<Node*> _pending;
+    /** The commands waiting to be deleted by the main thread */
+    std::atomic<Node*> _retired;
+
+    /**
+     * Deletes every command in the given linked stack
+     *
+     * @param list  The top of the stack to delete
+     */
+    static void release(Node* list) {
+        while (list != nullptr) {
+            Node* next = list->next;
+            delete list;
+            list = next;
+        }
+    }
+
+public:
+    /**
+     * Creates an empty command queue
+     */
+    AudioCommandQueue() : _pending(nullptr), _retired(nullptr) {}
+
+    /**
+     * Deletes this command queue, disposing of all commands
+     */
+    ~AudioCommandQueue() { clear(); }
+
+    /** This class cannot be copied */
+    AudioCommandQueue(const AudioCommandQueue&) = delete;
+    /** This class cannot be copied */
+    AudioCommandQueue& operator=(const AudioCommandQueue&) = delete;
+
+    /**
+     * Returns true if there are no commands waiting for the audio thread
+     *
+     * As the threads may be working concurrently, this value is only a hint.
+     *
+     * @return true if there are no commands waiting for the audio thread
+     */
+    bool empty() const {
+        return _pending.load(std::memory_order_acquire) == nullptr;
+    }
+
+    /**
+     * Sends the given command to the audio thread.
+     *
+     * The command will be applied at the start of the next read. This method
+     * also deletes any commands already applied by the audio thread.
+     *
+     * MAIN THREAD ONLY: This method should only be called by the producer.
+     *
+     * @param command   The command to send
+     */
+    void push(T&& command) {
+        reclaim();
+        Node* node = new Node(std::move(command));
+        node->next = _pending.load(std::memory_order_relaxed);
+        while (!_pending.compare_exchange_weak(node->next, node,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed)) {}
+    }
+
+    /**
+     * Applies all waiting commands with the given function.
+     *
+     * The commands are applied in the order that they were sent. The function
+     * is passed a reference to each command, which it may modify. The spent
+     * commands are handed back to the main thread to be deleted. This method
+     * never allocates or frees memory.
+     *
+     * AUDIO THREAD ONLY: This method should only be called by the consumer.
+     *
+     * @param func  The function to apply to each command
+     *
+     * @return true if any commands were applied
+     */
+    template <typename F>
+    bool apply(F func) {
+        Node* head = _pending.exchange(nullptr, std::memory_order_acquire);
+        if (head == nullptr) {
+            return false;
+        }
+
+        // Reverse in place to get the commands in order
+        Node* first = nullptr;
+        Node* curr = head;
+        while (curr != nullptr) {
+            Node* next = curr->next;
+            curr->next = first;
+            first = curr;
+            curr = next;
+        }
+        for (curr = first; curr != nullptr; curr = curr->next) {
+            func(curr->data);
+        }
+
+        // The old head is now the tail
+        head->next = _retired.load(std::memory_order_relaxed);
+        while (!_retired.compare_exchange_weak(head->next, first,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed)) {}
+        return true;
+    }
+
+    /**
+     * Deletes all commands already applied by the audio thread
+     *
+     * MAIN THREAD ONLY: This method should only be called by the producer.
+     */
+    void reclaim() {
+        release(_retired.exchange(nullptr, std::memory_order_acquire));
+    }
+
+    /**
+     * Deletes all commands, whether or not they have been applied
+     *
+     * This method is not thread safe, and should only be called when the
+     * audio thread is not reading from the owning node.
+     */
+    void clear() {
+        release(_pending.exchange(nullptr, std::memory_order_acquire));
+        reclaim();
+    }
+};
+
+    }
+}
+
+#endif /* __CU_AUDIO_COMMAND_QUEUE_H__ */
@@ -0,0 +1,586 @@
+//
+//  CUAudioConvolver.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a graph node for convolving an audio node with an
+//  impulse response. This is typically used for convolution reverb, where
+//  the impulse response is a recording of a real (or simulated) space. As
+//  impulse responses are often several seconds long, this node uses the
+//  partitioned FFT convolution in dsp::Convolver.
+//
+//  The convolver never takes a lock in the audio thread. Changing the input
+//  or the impulse response sends a command to the audio thread, which is
+//  applied at the start of the next read.
+//
+//  CUGL MIT License:
+//
+//     This software is provided 'as-is', without any express or implied
+//     warranty.  In no event will the authors be held liable for any damages
+//     arising from the use of this software.
+//
+//     Permission is granted to anyone to use this software for any purpose,
+//     including commercial applications, and to alter it and redistribute it
+//     freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_AUDIO_CONVOLVER_H__
+#define __CU_AUDIO_CONVOLVER_H__
+#include <SDL.h>
+#include <cugl/math/dsp/CUConvolver.h>
+#include "CUAudioNode.h"
+#include "CUAudioCommandQueue.h"
+#include <vector>
+
+namespace cugl {
+
+/** Forward reference to an audio sample */
+class AudioSample;
+
+    /**
+     * The audio graph classes.
+     *
+     * This internal namespace is for the audio graph clases.  It was chosen
+     * to distinguish this graph from other graph class collections, such as the
+     * scene graph collections in {@link scene2}.
+     */
+    namespace audio {
+
+/**
+ * This class convolves an audio node with an impulse response.
+ *
+ * The typical use of this node is convolution reverb. The impulse response
+ * is applied to every channel of the input, and the result is mixed with the
+ * original (dry) signal according to {@link #getWet}. When the input node
+ * completes, this node continues to play until the reverb tail has finished.
+ *
+ * The impulse response is a single channel kernel, which may be extracted
+ * from an {@link AudioSample} with {@link #setImpulse}. It should have the
+ * same sample rate as this node. Transforming the impulse response is
+ * expensive, and so it is done in the calling thread, never the audio thread.
+ *
+ * The audio graph should only be accessed in the main thread.  In addition,
+ * no methods marked as AUDIO THREAD ONLY should ever be accessed by the user.
+ *
+ * This class does not support any actions for the {@link AudioNode#setCallback}.
+ */
+class AudioConvolver : public AudioNode {
+protected:
+    /**
+     * A change to this convolver.
+     *
+     * Commands are sent by the main thread and applied by the audio thread at
+     * the start of a read. After it is applied, a command holds the input or
+     * convolution that it replaced, so that it is released on the main thread.
+     */
+    class Command {
+    public:
+        /** The command types */
+        enum class Type : int {
+            /** Replace the input node */
+            ATTACH  = 0,
+            /** Replace the convolution */
+            KERNEL  = 1,
+            /** Clear the convolution state */
+            CLEAR   = 2
+        };
+
+        /** The command type */
+        Type type;
+        /** The input node (ATTACH only) */
+        std::shared_ptr<AudioNode> node;
+        /** The convolution (KERNEL only) */
+        std::shared_ptr<dsp::Convolver> filter;
+
+        /**
+         * Creates a command of the given type
+         *
+         * @param type      The command type
+         */
+        Command(Type type) : type(type) {}
+
+        /**
+         * Creates a command to replace the input node
+         *
+         * @param node  The input node
+         */
+        Command(const std::shared_ptr<AudioNode>& node) :
+        type(Type::ATTACH), node(node) {}
+
+        /**
+         * Creates a command to replace the convolution
+         *
+         * @param filter    The convolution
+         */
+        Command(const std::shared_ptr<dsp::Convolver>& filter) :
+        type(Type::KERNEL), filter(filter) {}
+    };
+
+    /** The audio input node as seen by the main thread */
+    std::shared_ptr<AudioNode> _input;
+    /** The audio input node as seen by the audio thread */
+    std::shared_ptr<AudioNode> _source;
+    /** The convolution as seen by the audio thread (may be nullptr) */
+    std::shared_ptr<dsp::Convolver> _filter;
+    /** The changes waiting for the audio thread */
+    AudioCommandQueue<Command> _commands;
+
+    /** The impulse response as seen by the main thread */
+    std::vector<float> _impulse;
+    /** The partition size of the convolution */
+    size_t _block;
+    /** The proportion of the convolved signal in the output */
+    std::atomic<float> _wet;
+
+    /** The length of the reverb tail in frames (audio thread) */
+    Uint64 _ringing;
+    /** The frames remaining in the reverb tail once the input completes */
+    std::atomic<Uint64> _residue;
+
+    /** An intermediate buffer for the dry signal */
+    float* _buffer;
+
+    /**
+     * Allocates the intermediate buffer for the dry signal
+     */
+    void allocateBuffer();
+
+    /**
+     * Applies the given command to the convolution state
+     *
+     * AUDIO THREAD ONLY: The convolution state belongs to the audio thread.
+     *
+     * @param command   The command to apply
+     */
+    void applyCommand(Command& command);
+
+    /**
+     * Sends the given command to the audio thread.
+     *
+     * If this method is called by the audio thread itself, the command is
+     * applied immediately instead.
+     *
+     * @param command   The command to send
+     */
+    void send(Command&& command);
+
+    /**
+     * Returns the input node for the current thread
+     *
+     * The audio thread has its own reference to the input node, which it
+     * updates at the start of each read. All other threads use the input of
+     * the main thread.
+     *
+     * @return the input node for the current thread
+     */
+    const std::shared_ptr<AudioNode>& getSource() const {
+        return isAudioThread() ? _source : _input;
+    }
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates a degenerate audio convolver.
+     *
+     * The convolver has no channels, so read options will do nothing. The
+     * node must be initialized to be used.
+     */
+    AudioConvolver();
+
+    /**
+     * Deletes this audio convolver, disposing of all resources.
+     */
+    ~AudioConvolver() { dispose(); }
+
+    /**
+     * Initializes the node with default stereo settings
+     *
+     * The number of channels is two, for stereo output.  The sample rate is
+     * the modern standard of 48000 HZ.
+     *
+     * These values determine the buffer the structure for all {@link read}
+     * operations.  In addition, they also detemine whether this node can
+     * serve as an input to other nodes in the audio graph.
+     *
+     * @return true if initialization was successful
+     */
+    virtual bool init() override;
+
+    /**
+     * Initializes the node with the given number of channels and sample rate
+     *
+     * These values determine the buffer the structure for all {@link read}
+     * operations.  In addition, they also detemine whether this node can
+     * serve as an input to other nodes in the audio graph.
+     *
+     * @param channels  The number of audio channels
+     * @param rate      The sample rate (frequency) in HZ
+     *
+     * @return true if initialization was successful
+     */
+    virtual bool init(Uint8 channels, Uint32 rate) override;
+
+    /**
+     * Initializes a convolver for the given input node and impulse response.
+     *
+     * This node acquires the channels and sample rate of the input.  If
+     * input is nullptr, this method will fail.
+     *
+     * @param input     The audio node to convolve
+     * @param impulse   The impulse response
+     *
+     * @return true if initialization was successful
+     */
+    bool init(const std::shared_ptr<AudioNode>& input, const std::vector<float>& impulse);
+
+    /**
+     * Disposes any resources allocated for this convolver
+     *
+     * The state of the node is reset to that of an uninitialized constructor.
+     * Unlike the destructor, this method allows the node to be reinitialized.
+     */
+    virtual void dispose() override;
+
+#pragma mark -
+#pragma mark Static Constructors
+    /**
+     * Returns a newly allocated convolver with the default stereo settings
+     *
+     * The number of channels is two, for stereo output.  The sample rate is
+     * the modern standard of 48000 HZ. Any input node must agree with these
+     * settings.
+     *
+     * @return a newly allocated convolver with the default stereo settings
+     */
+    static std::shared_ptr<AudioConvolver> alloc() {
+        std::shared_ptr<AudioConvolver> result = std::make_shared<AudioConvolver>();
+        return (result->init() ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated convolver with the given number of channels and sample rate
+     *
+     * Any input node must agree with these settings.
+     *
+     * @param channels  The number of audio channels
+     * @param rate      The sample rate (frequency) in HZ
+     *
+     * @return a newly allocated convolver with the given number of channels and sample rate
+     */
+    static std::shared_ptr<AudioConvolver> alloc(Uint8 channels, Uint32 rate) {
+        std::shared_ptr<AudioConvolver> result = std::make_shared<AudioConvolver>();
+        return (result->init(channels,rate) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated convolver for the given input node and impulse response.
+     *
+     * This node acquires the channels and sample rate of the input.  If
+     * input is nullptr, this method will fail.
+     *
+     * @param input     The audio node to convolve
+     * @param impulse   The impulse response
+     *
+     * @return a newly allocated convolver for the given input node and impulse response.
+     */
+    static std::shared_ptr<AudioConvolver> alloc(const std::shared_ptr<AudioNode>& input,
+                                                 const std::vector<float>& impulse) {
+        std::shared_ptr<AudioConvolver> result = std::make_shared<AudioConvolver>();
+        return (result->init(input,impulse) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Convolution Attributes
+    /**
+     * Attaches an audio node to this convolver.
+     *
+     * This method will fail if the channels of the audio node do not agree
+     * with this convolver.
+     *
+     * The change takes effect at the start of the next read in the audio thread.
+     *
+     * @param node  The audio node to convolve
+     *
+     * @return true if the attachment was successful
+     */
+    bool attach(const std::shared_ptr<AudioNode>& node);
+
+    /**
+     * Detaches an audio node from this convolver.
+     *
+     * If the method succeeds, it returns the audio node that was removed.
+     *
+     * The change takes effect at the start of the next read in the audio thread.
+     *
+     * @return  The audio node to detach (or null if failed)
+     */
+    std::shared_ptr<AudioNode> detach();
+
+    /**
+     * Returns the input node of this convolver.
+     *
+     * @return the input node of this convolver.
+     */
+    std::shared_ptr<AudioNode> getInput() { return _input; }
+
+    /**
+     * Returns the impulse response of this convolver.
+     *
+     * @return the impulse response of this convolver.
+     */
+    const std::vector<float>& getImpulse() const { return _impulse; }
+
+    /**
+     * Sets the impulse response of this convolver.
+     *
+     * The impulse response is transformed in this thread, which can take some
+     * time for long responses. The change takes effect at the start of the
+     * next read in the audio thread, and clears any reverb tail.
+     *
+     * @param impulse   The impulse response
+     */
+    void setImpulse(const std::vector<float>& impulse);
+
+    /**
+     * Sets the impulse response of this convolver to the given audio sample.
+     *
+     * The sample must be in memory (e.g. not streamed). If the sample has
+     * more than one channel, the channels are averaged together. The sample
+     * should have the same sample rate as this node. This method returns
+     * false if the impulse response could not be extracted.
+     *
+     * The impulse response is transformed in this thread, which can take some
+     * time for long responses. The change takes effect at the start of the
+     * next read in the audio thread, and clears any reverb tail.
+     *
+     * @param sample    The audio sample with the impulse response
+     *
+     * @return true if the impulse response was set
+     */
+    bool setImpulse(const std::shared_ptr<AudioSample>& sample);
+
+    /**
+     * Returns the partition size of the convolution in frames
+     *
+     * Smaller partitions mean less work per block, but more work per frame.
+     * By default this value is {@link dsp::Convolver#DEFAULT_BLOCK}.
+     *
+     * @return the partition size of the convolution in frames
+     */
+    size_t getBlockSize() const { return _block; }
+
+    /**
+     * Sets the partition size of the convolution in frames
+     *
+     * Smaller partitions mean less work per block, but more work per frame.
+     * The value will be rounded up to a power of two. Changing this value
+     * transforms the impulse response again and clears any reverb tail.
+     *
+     * @param block The partition size of the convolution in frames
+     */
+    void setBlockSize(size_t block);
+
+    /**
+     * Returns the proportion of the convolved signal in the output
+     *
+     * A value of 1 is only the convolved (wet) signal, while a value of 0
+     * is only the original (dry) signal. By default this value is 1.
+     *
+     * @return the proportion of the convolved signal in the output
+     */
+    float getWet() const { return _wet.load(std::memory_order_relaxed); }
+
+    /**
+     * Sets the proportion of the convolved signal in the output
+     *
+     * A value of 1 is only the convolved (wet) signal, while a value of 0
+     * is only the original (dry) signal. By default this value is 1.
+     *
+     * @param wet   The proportion of the convolved signal in the output
+     */
+    void setWet(float wet);
+
+    /**
+     * Clears the convolution state, cutting off any reverb tail.
+     *
+     * The change takes effect at the start of the next read in the audio thread.
+     */
+    void clear();
+
+#pragma mark -
+#pragma mark Overriden Methods
+    /**
+     * Sets the typical read size of this node.
+     *
+     * Some audio nodes need an internal buffer for operations like mixing or
+     * resampling. In that case, it helps to know the requested {@link read}
+     * size ahead of time. The capacity is the minimal required read amount
+     * of the {@link AudioEngine} and corresponds to {@link AudioEngine#getReadSize}.
+     *
+     * It is not actually necessary to set this size. However for nodes with
+     * internal buffer, setting this value can optimize performance.
+     *
+     * This method is not synchronized because it is assumed that this value
+     * will **never** change while the audio engine in running. The average
+     * user should never call this method explicitly. You should always call
+     * {@link AudioEngine#setReadSize} instead.
+     *
+     * @param size  The typical read size of this node.
+     */
+    virtual void setReadSize(Uint32 size) override;
+
+    /**
+     * Reads up to the specified number of frames into the given buffer
+     *
+     * AUDIO THREAD ONLY: Users should never access this method directly.
+     * The only exception is when the user needs to create a custom subclass
+     * of this AudioNode.
+     *
+     * The buffer should have enough room to store frames * channels elements.
+     * The channels are interleaved into the output buffer.
+     *
+     * This method will always forward the read position after reading. Reading
+     * again may return different data.
+     *
+     * @param buffer    The read buffer to store the results
+     * @param frames    The maximum number of frames to read
+     *
+     * @return the actual number of frames read
+     */
+    virtual Uint32 read(float* buffer, Uint32 frames) override;
+
+    /**
+     * Returns true if this audio node has no more data.
+     *
+     * A completed audio node is one that will return 0 (no frames read) on
+     * subsequent threads read. A convolver is not complete until its reverb
+     * tail has finished.
+     *
+     * @return true if this audio node has no more data.
+     */
+    virtual bool completed() override;
+
+    /**
+     * Marks the current read position in the audio steam.
+     *
+     * This method is used by {@link reset()} to determine where to restore
+     * the read position.
+     *
+     * @return true if the read position was marked.
+     */
+    virtual bool mark() override;
+
+    /**
+     * Clears the current marked position.
+     *
+     * Clearing the mark in a player is equivelent to setting the mark at
+     * the beginning of the audio asset.  Future calls to {@link reset()}
+     * will return to the start of the audio stream.
+     *
+     * @return true if the read position was cleared.
+     */
+    virtual bool unmark() override;
+
+    /**
+     * Resets the read position to the marked position of the audio stream.
+     *
+     * If no mark is set, this will reset to the player to the beginning of
+     * the audio sample.
+     *
+     * @return true if the read position was moved.
+     */
+    virtual bool reset() override;
+
+    /**
+     * Advances the stream by the given number of frames.
+     *
+     * This method only advances the read position, it does not actually
+     * read data into a buffer.
+     *
+     * @param frames    The number of frames to advace
+     *
+     * @return the actual number of frames advanced; -1 if not supported
+     */
+    virtual Sint64 advance(Uint32 frames) override;
+
+    /**
+     * Returns the current frame position of this audio node
+     *
+     * The value returned will always be the absolute frame position regardless
+     * of the presence of any marks.
+     *
+     * @return the current frame position of this audio node.
+     */
+    virtual Sint64 getPosition() const override;
+
+    /**
+     * Sets the current frame position of this audio node.
+     *
+     * The value set will always be the absolute frame position regardless
+     * of the presence of any marks.
+     *
+     * @param position  the current frame position of this audio node.
+     *
+     * @return the new frame position of this audio node.
+     */
+    virtual Sint64 setPosition(Uint32 position) override;
+
+    /**
+     * Returns the elapsed time in seconds.
+     *
+     * The value returned is always measured from the start of the steam,
+     * regardless of the presence of any marks.
+     *
+     * @return the elapsed time in seconds.
+     */
+    virtual double getElapsed() const override;
+
+    /**
+     * Sets the read position to the elapsed time in seconds.
+     *
+     * The value returned is always measured from the start of the steam,
+     * regardless of the presence of any marks.
+     *
+     * @param time  The elapsed time in seconds.
+     *
+     * @return the new elapsed time in seconds.
+     */
+    virtual double setElapsed(double time) override;
+
+    /**
+     * Returns the remaining time in seconds.
+     *
+     * The remaining time is duration from the current read position to the
+     * end of the input. It does not include the reverb tail.
+     *
+     * @return the remaining time in seconds.
+     */
+    virtual double getRemaining() const override;
+
+    /**
+     * Sets the remaining time in seconds.
+     *
+     * This method will move the read position so that the distance between
+     * it and the end of the same is the given number of seconds.
+     *
+     * @param time  The remaining time in seconds.
+     *
+     * @return the new remaining time in seconds.
+     */
+    virtual double setRemaining(double time) override;
+};
+    }
+}
+
+#endif /* __CU_AUDIO_CONVOLVER_H__ */
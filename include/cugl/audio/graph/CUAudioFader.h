@@ -39,7 +39,7 @@
 #define __CU_AUDIO_FADER_H__
 #include <SDL.h>
 #include "CUAudioNode.h"
-#include <mutex>
+#include "CUAudioCommandQueue.h"
 
 namespace cugl {
 
@@ -69,17 +69,89 @@ namespace cugl {
  * The audio graph should only be accessed in the main thread.  In addition,
  * no methods marked as AUDIO THREAD ONLY should ever be accessed by the user.
  *
+ * The fader never takes a lock in the audio thread. Attaching an input or
+ * starting a fade sends a command to the audio thread, which is applied at
+ * the start of the next read. Queries like {@link #isFadeIn} reflect these
+ * commands immediately, even before they are applied.
+ *
  * This audio node supports the callback functions in {@link AudioNode#setCallback}.
  * This function function is called whenever a fade-in or fade-out has completed
  * successfully (without interruption).
  */
 class AudioFader : public AudioNode {
 protected:
-    /** The audio input node */
-    std::shared_ptr<AudioNode> _input;
+    /**
+     * A change to this fader.
+     *
+     * Commands are sent by the main thread and applied by the audio thread at
+     * the start of a read. After it is applied, an attach command holds the
+     * input that it replaced, so that this input is released on the main thread.
+     */
+    class Command {
+    public:
+        /** The command types */
+        enum class Type : int {
+            /** Replace the input node */
+            ATTACH    = 0,
+            /** Start (or cancel) a fade-in */
+            FADE_IN   = 1,
+            /** Start (or cancel) a fade-out */
+            FADE_OUT  = 2,
+            /** Start (or cancel) a fade-pause */
+            FADE_DIP  = 3,
+            /** Cancel the first half of a fade-pause */
+            RESUME    = 4,
+            /** Clear the fades after a reset */
+            RESET     = 5,
+            /** Clear all fades after a change in position */
+            CANCEL    = 6
+        };
+
+        /** The command type */
+        Type type;
+        /** The (first) fade length in frames, or -1 to cancel the fade */
+        Sint64 first;
+        /** The second fade length in frames (FADE_DIP only) */
+        Uint64 second;
+        /** Whether to persist the fade-out on a reset (FADE_OUT only) */
+        bool wrap;
+        /** The input node (ATTACH only) */
+        std::shared_ptr<AudioNode> node;
+
+        /**
+         * Creates a command of the given type
+         *
+         * @param type      The command type
+         * @param first     The (first) fade length in frames
+         * @param second    The second fade length in frames
+         * @param wrap      Whether to persist the fade-out on a reset
+         */
+        Command(Type type, Sint64 first=-1, Uint64 second=0, bool wrap=false) :
+        type(type), first(first), second(second), wrap(wrap) {}
 
-    /** This class needs a proper lock guard; too many race conditions */
-    std::mutex _mutex;
+        /**
+         * Creates a command to replace the input node
+         *
+         * @param node  The input node
+         */
+        Command(const std::shared_ptr<AudioNode>& node) :
+        type(Type::ATTACH), first(-1), second(0), wrap(false), node(node) {}
+    };
+
+    /** The audio input node as seen by the main thread */
+    std::shared_ptr<AudioNode> _input;
+    /** The audio input node as seen by the audio thread */
+    std::shared_ptr<AudioNode> _source;
+    /** The changes waiting for the audio thread */
+    AudioCommandQueue<Command> _commands;
+    /**
+     * The fade state flags.
+     *
+     * The lowest bits summarize the fade state for queries from the main
+     * thread. The remaining bits count the changes made outside of a read,
+     * so that the audio thread never overwrites a newer state with an older one.
+     */
+    std::atomic<Uint32> _status;
     
     // Fade-in: For softer starts
     /** The final frame of the current fade-in; -1 if no active fade-in */
@@ -175,6 +247,57 @@ protected:
      */
     Uint32 doFadePause(float* buffer, Uint32 frames);
 
+    /**
+     * Returns the status flags for the current fade state
+     *
+     * AUDIO THREAD ONLY: The fade state belongs to the audio thread.
+     *
+     * @return the status flags for the current fade state
+     */
+    Uint32 getFlags() const;
+
+    /**
+     * Applies the given command to the fade state
+     *
+     * AUDIO THREAD ONLY: The fade state belongs to the audio thread.
+     *
+     * @param command   The command to apply
+     */
+    void applyCommand(Command& command);
+
+    /**
+     * Sends the given command to the audio thread.
+     *
+     * The status flags are updated immediately, clearing the flags in clear
+     * and then setting the flags in set. If this method is called by the
+     * audio thread itself, the command is applied immediately instead.
+     *
+     * @param command   The command to send
+     * @param clear     The status flags to clear
+     * @param set       The status flags to set
+     */
+    void send(Command&& command, Uint32 clear, Uint32 set);
+
+    /**
+     * Cancels all active fades.
+     *
+     * This is used by any method that moves the read position.
+     */
+    void cancelFades();
+
+    /**
+     * Returns the input node for the current thread
+     *
+     * The audio thread has its own reference to the input node, which it
+     * updates at the start of each read. All other threads use the input of
+     * the main thread.
+     *
+     * @return the input node for the current thread
+     */
+    const std::shared_ptr<AudioNode>& getSource() const {
+        return isAudioThread() ? _source : _input;
+    }
+
 public:
 #pragma mark Constructors
     /**
@@ -292,6 +415,8 @@ public:
      * This method will fail if the channels of the audio node do not agree
      * with this fader.
      *
+     * The change takes effect at the start of the next read in the audio thread.
+     *
      * @param node  The audio node to fade
      *
      * @return true if the attachment was successful
@@ -303,6 +428,8 @@ public:
      *
      * If the method succeeds, it returns the audio node that was removed.
      *
+     * The change takes effect at the start of the next read in the audio thread.
+     *
      * @return  The audio node to detach (or null if failed)
      */
     std::shared_ptr<AudioNode> detach();
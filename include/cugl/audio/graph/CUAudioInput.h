@@ -55,6 +55,9 @@
 #include <deque>
 #include <mutex>
 
+/** The maximum number of simultaneous consumers of the capture stream */
+#define AUDIO_INPUT_TAPS    8
+
 namespace cugl {
     
     /** Forward reference to the audio manager */
@@ -167,6 +170,17 @@ private:
     
     /** Whether this device is write locked */
     bool _locked;
+    
+    /** The capture ring buffer (nullptr if there is no capture stream) */
+    float* _capbuffer;
+    /** The capacity of the capture ring buffer in frames */
+    Uint32 _capsize;
+    /** The total number of frames read by each tap of the capture stream */
+    std::atomic<Uint64> _capheads[AUDIO_INPUT_TAPS];
+    /** A bitmask of the open taps of the capture stream */
+    std::atomic<Uint32> _captaps;
+    /** The total number of frames written to the capture stream */
+    std::atomic<Uint64> _captail;
 
 #pragma mark -
 #pragma mark AudioDevices Methods
@@ -626,6 +640,150 @@ public:
      */
     std::shared_ptr<AudioSample> save();
 
+#pragma mark -
+#pragma mark Capture Stream
+    /**
+     * Returns the size of the capture stream in frames.
+     *
+     * If this value is 0, there is no capture stream. See
+     * {@link setCaptureSize} for more information.
+     *
+     * @return the size of the capture stream in frames.
+     */
+    Uint32 getCaptureSize() const { return _capsize; }
+    
+    /**
+     * Sets the size of the capture stream in frames.
+     *
+     * The capture stream is a copy of everything recorded by this node, which
+     * may be read by another thread with {@link capture()}. It is independent
+     * of playback, so an input node does not need to be part of an audio graph
+     * to capture. This is how audio is taken from a microphone without adding
+     * the latency of the graph, such as for voice chat.
+     *
+     * The stream is a lock-free ring buffer, which may be read by several
+     * consumers at once (see {@link openTap}). If the slowest consumer falls
+     * behind by more than this many frames, the new frames are dropped. A size
+     * of 0 disables the capture stream (the default) and closes all taps. Any
+     * other size opens the default tap (tap 0) read by {@link capture()}. As an
+     * unread tap holds back the stream, close the default tap if it is not used.
+     * This method must not be called while another thread is reading the capture
+     * stream.
+     *
+     * Changing this value will temporarily lock this input device.
+     *
+     * @param frames    The size of the capture stream in frames
+     */
+    void setCaptureSize(Uint32 frames);
+    
+    /**
+     * Reads up to the specified number of frames from the capture stream.
+     *
+     * This method reads from the default tap (tap 0), which is opened by
+     * {@link setCaptureSize}. It is the same as calling {@link capture(Uint32,float*,Uint32)}
+     * with a tap of 0.
+     *
+     * The buffer should have enough room to store frames * channels elements.
+     * The channels are interleaved into the buffer. This method never blocks,
+     * and returns 0 if there is no capture stream (see {@link setCaptureSize}).
+     * It is safe to call from any thread, but only one thread may consume
+     * the default tap.
+     *
+     * @param buffer    The buffer to store the captured frames
+     * @param frames    The maximum number of frames to read
+     *
+     * @return the actual number of frames read
+     */
+    Uint32 capture(float* buffer, Uint32 frames) { return capture(0,buffer,frames); }
+    
+    /**
+     * Opens a new tap of the capture stream, returning its index.
+     *
+     * A tap is an independent read cursor in the capture stream. Several
+     * consumers (such as a recorder, voice chat, and beat detection) may each
+     * open a tap and read the same frames, without copying the stream for each
+     * of them. Each tap starts at the newest frame in the stream.
+     *
+     * The capture stream only drops new frames when the slowest open tap falls
+     * behind by {@link getCaptureSize} frames. So a tap that is no longer read
+     * should be closed with {@link closeTap}.
+     *
+     * This method returns -1 if there is no capture stream, or if all
+     * {@link AUDIO_INPUT_TAPS} taps are in use. It is safe to call from any
+     * thread.
+     *
+     * @return the index of the new tap (or -1 on failure)
+     */
+    Sint32 openTap();
+    
+    /**
+     * Closes the given tap of the capture stream.
+     *
+     * A closed tap no longer holds back the capture stream. Its index may
+     * be returned by a later call to {@link openTap}.
+     *
+     * @param tap   The index of the tap to close
+     */
+    void closeTap(Uint32 tap);
+    
+    /**
+     * Returns true if the given tap of the capture stream is open.
+     *
+     * @param tap   The index of the tap
+     *
+     * @return true if the given tap of the capture stream is open.
+     */
+    bool isTapOpen(Uint32 tap) const;
+    
+    /**
+     * Reads up to the specified number of frames from the given tap.
+     *
+     * The buffer should have enough room to store frames * channels elements.
+     * The channels are interleaved into the buffer. This method never blocks,
+     * and returns 0 if the tap is not open. It is safe to call from any
+     * thread, but only one thread may consume each tap.
+     *
+     * @param tap       The index of the tap
+     * @param buffer    The buffer to store the captured frames
+     * @param frames    The maximum number of frames to read
+     *
+     * @return the actual number of frames read
+     */
+    Uint32 capture(Uint32 tap, float* buffer, Uint32 frames);
+    
+    /**
+     * Returns the frames available to the given tap without copying them.
+     *
+     * This method stores a pointer into the capture stream in data, and
+     * returns the number of frames (up to the given maximum) that may be
+     * read from that pointer. The channels are interleaved. As the capture
+     * stream is a ring buffer, this may be fewer frames than are available.
+     * Call this method again after {@link advanceCapture} to get the rest.
+     *
+     * The data remains valid until the tap is advanced. The capture stream
+     * will not overwrite it in the meantime. This method returns 0 if the
+     * tap is not open.
+     *
+     * @param tap       The index of the tap
+     * @param data      The pointer to store the start of the frames
+     * @param frames    The maximum number of frames to peek
+     *
+     * @return the number of frames that may be read from data
+     */
+    Uint32 peekCapture(Uint32 tap, const float** data, Uint32 frames) const;
+    
+    /**
+     * Advances the given tap past the specified number of frames.
+     *
+     * This method releases the frames returned by {@link peekCapture}, so
+     * that they may be overwritten by the capture stream. The tap will not
+     * advance past the newest frame in the stream.
+     *
+     * @param tap       The index of the tap
+     * @param frames    The number of frames to advance
+     */
+    void advanceCapture(Uint32 tap, Uint32 frames);
+
 #pragma mark -
 #pragma mark Audio Graph
     /**
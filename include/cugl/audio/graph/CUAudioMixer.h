@@ -36,7 +36,8 @@
 #ifndef __CU_AUDIO_MIXER_H__
 #define __CU_AUDIO_MIXER_H__
 #include "CUAudioNode.h"
-#include <mutex>
+#include "CUAudioCommandQueue.h"
+#include <memory>
 
 namespace cugl {
 
@@ -65,14 +66,74 @@ namespace cugl {
  * The audio graph should only be accessed in the main thread.  In addition,
  * no methods marked as AUDIO THREAD ONLY should ever be accessed by the user.
  *
+ * The mixer never takes a lock in the audio thread. Attaching or detaching
+ * an input sends a command to the audio thread, which is applied at the start
+ * of the next read. Delegated methods, such as {@link #mark} or
+ * {@link #setPosition}, are forwarded to the inputs as seen by the calling
+ * thread, so they may also be used by the audio thread (as when this mixer
+ * is looped by an {@link AudioScheduler}).
+ *
  * This class does not support any actions for the {@link AudioNode#setCallback}.
  */
 class AudioMixer : public AudioNode {
 private:
-    /** The input nodes to be mixed */
+    /**
+     * A change to the inputs of this mixer.
+     *
+     * Commands are sent by the main thread and applied by the audio thread at
+     * the start of a read. After it is applied, a command holds the value that
+     * it replaced, so that this value is released on the main thread.
+     */
+    class Command {
+    public:
+        /** The command types */
+        enum class Type : int {
+            /** Replace the input at a single slot */
+            ATTACH = 0,
+            /** Replace the entire input array */
+            RESIZE = 1
+        };
+
+        /** The command type */
+        Type type;
+        /** The slot to replace (ATTACH only) */
+        Uint8 slot;
+        /** The input node for the slot (ATTACH only) */
+        std::shared_ptr<AudioNode> node;
+        /** The number of input slots (RESIZE only) */
+        Uint8 width;
+        /** The input slots (RESIZE only) */
+        std::unique_ptr<std::shared_ptr<AudioNode>[]> inputs;
+
+        /**
+         * Creates a command to replace the input at the given slot
+         *
+         * @param slot  The slot to replace
+         * @param node  The input node for the slot
+         */
+        Command(Uint8 slot, const std::shared_ptr<AudioNode>& node) :
+        type(Type::ATTACH), slot(slot), node(node), width(0) {}
+
+        /**
+         * Creates a command to replace the entire input array
+         *
+         * @param inputs    The input slots to acquire
+         * @param width     The number of input slots
+         */
+        Command(std::shared_ptr<AudioNode>* inputs, Uint8 width) :
+        type(Type::RESIZE), slot(0), width(width), inputs(inputs) {}
+    };
+
+    /** The input nodes as seen by the main thread */
     std::shared_ptr<AudioNode>* _inputs;
     /** The number of input nodes supported by this mixer */
     Uint8 _width;
+    /** The input nodes as seen by the audio thread */
+    std::shared_ptr<AudioNode>* _mixing;
+    /** The number of input nodes seen by the audio thread */
+    Uint8 _mixwidth;
+    /** The input changes waiting for the audio thread */
+    AudioCommandQueue<Command> _commands;
 
     /** The intermediate buffer for the mixed result. Its size is determined by _readsize. */
     float* _buffer;
@@ -80,17 +141,64 @@ private:
     /** The knee value for clamping */
     std::atomic<float>  _knee;
 
-    /** This class needs a proper lock guard; too many race conditions */
-    std::mutex _mutex;
     /** The current read position */
     std::atomic<Uint64> _offset;
     /** The last marked position (starts at 0) */
     std::atomic<Uint64> _marked;
+    /**
+     * The completion state of the inputs.
+     *
+     * The lowest bit is set if all inputs are complete. The remaining bits
+     * count the changes made by the main thread, so that the audio thread
+     * never overwrites a newer state with an older one.
+     */
+    std::atomic<Uint32> _status;
     
     /**
      * Allocates the mixing buffer
      */
     void allocateBuffer();
+
+    /**
+     * Returns the input slots for the current thread
+     *
+     * The audio thread has its own copy of the input slots, which it updates
+     * at the start of each read. All other threads use the slots of the main
+     * thread.
+     *
+     * @return the input slots for the current thread
+     */
+    std::shared_ptr<AudioNode>* getSlots() const {
+        return isAudioThread() ? _mixing : _inputs;
+    }
+
+    /**
+     * Returns the number of input slots for the current thread
+     *
+     * The audio thread has its own copy of the input slots, which it updates
+     * at the start of each read. All other threads use the slots of the main
+     * thread.
+     *
+     * @return the number of input slots for the current thread
+     */
+    Uint8 getSlotCount() const {
+        return isAudioThread() ? _mixwidth : _width;
+    }
+
+    /**
+     * Applies the input changes sent since the last read
+     *
+     * AUDIO THREAD ONLY: This method is called at the start of {@link read}.
+     */
+    void applyCommands();
+
+    /**
+     * Updates the completion state from the inputs seen by the current thread
+     *
+     * This method should be called after any change outside of a read that
+     * could change whether the mixer is complete.
+     */
+    void updateStatus();
     
 public:
 #pragma mark Constructors
@@ -232,6 +340,8 @@ public:
      * The input is attached at the given slot. Any input node previously at
      * that slot is removed (and returned by this method).
      *
+     * The change takes effect at the start of the next read in the audio thread.
+     *
      * @param slot  The slot for the input node
      * @param input The input node to attach
      *
@@ -244,6 +354,8 @@ public:
      *
      * The input node detached is returned by this method.
      *
+     * The change takes effect at the start of the next read in the audio thread.
+     *
      * @param slot  The slot for the input node
      *
      * @return the input node detached from the slot
@@ -260,6 +372,10 @@ public:
      * An audio node is typically completed if it return 0 (no frames read) on
      * subsequent calls to {@link read()}.
      *
+     * This value is updated by the audio thread at the end of each read, and by
+     * the main thread whenever the inputs are changed or repositioned. Hence it
+     * is safe to call from either thread.
+     *
      * @return true if this audio node has no more data.
      */
     virtual bool completed() override;
@@ -48,6 +48,7 @@
 #include <memory>
 #include <functional>
 #include <string>
+#include <cugl/audio/graph/CUAudioProfile.h>
 
 namespace cugl {
     
@@ -190,6 +191,40 @@ protected:
     /** Whether this device is read locked */
     bool _locked;
 
+    /** Whether to time the reads of this node */
+    std::atomic<bool> _profiled;
+    
+    /** The timing statistics of this node */
+    AudioCounters _counters;
+
+    /**
+     * A scoped timer for the {@link read} method of a node.
+     *
+     * Subclasses should declare one of these at the start of their read
+     * method. If the node is profiled, the timer records the duration of the
+     * read (including the reads of any input nodes) when it goes out of scope.
+     * Otherwise, it does nothing.
+     */
+    class ReadTimer {
+    private:
+        /** The node to record to (or nullptr if not profiled) */
+        AudioNode* _node;
+        /** The performance counter at the start of the read */
+        Uint64 _start;
+    public:
+        /**
+         * Starts timing a read of the given node
+         *
+         * @param node  The node being read
+         */
+        ReadTimer(AudioNode* node);
+        
+        /**
+         * Stops timing the read, recording it to the node
+         */
+        ~ReadTimer();
+    };
+
     /**
      * Invokes the callback functions for the given action.
      *
@@ -204,6 +239,27 @@ protected:
      * unexpected side effects.
      */
     void notify(const std::shared_ptr<AudioNode>& node, Action action);
+
+    /**
+     * Marks whether the current thread is an audio thread
+     *
+     * This is set by {@link AudioOutput} at the start of each poll by the
+     * audio device, and by {@link AudioRenderer} while it renders a graph.
+     * It should not be set anywhere else.
+     *
+     * @param flag  Whether the current thread is an audio thread
+     */
+    static void setAudioThread(bool flag);
+
+    /**
+     * Marks whether the current thread renders the audio graph offline
+     *
+     * This is set by {@link AudioRenderer} while it renders a graph. It
+     * should not be set anywhere else.
+     *
+     * @param flag  Whether the current thread renders the audio graph offline
+     */
+    static void setOffline(bool flag);
     
 #pragma mark -
 #pragma mark Static Attributes
@@ -213,6 +269,32 @@ public:
     
     /** The default sampling frequency for an audio node */
     const static Uint32 DEFAULT_SAMPLING;
+
+    /**
+     * Returns true if the current thread is an audio thread
+     *
+     * An audio thread is one that reads the audio graph on behalf of an audio
+     * device. Nodes that send their changes to the audio thread (such as
+     * {@link AudioMixer}) use this to apply changes immediately when they
+     * are made by the audio thread itself, as when a {@link AudioScheduler}
+     * resets a looping node.
+     *
+     * @return true if the current thread is an audio thread
+     */
+    static bool isAudioThread();
+
+    /**
+     * Returns true if the current thread renders the audio graph offline
+     *
+     * An offline thread is one that reads the audio graph on behalf of an
+     * {@link AudioRenderer}, as fast as it can and with no device deadline.
+     * Nodes that would normally drop data rather than block the audio
+     * thread (such as a streaming {@link AudioPlayer}) use this to wait
+     * for the data instead. An offline thread is always an audio thread.
+     *
+     * @return true if the current thread renders the audio graph offline
+     */
+    static bool isOffline();
     
 #pragma mark -
 #pragma mark Constructors
@@ -503,6 +585,47 @@ public:
      */
     virtual Uint32 read(float* buffer, Uint32 frames);
 
+#pragma mark -
+#pragma mark Profiling
+    /**
+     * Returns true if the reads of this node are timed
+     *
+     * Profiling is off by default, as timing every node adds a small cost to
+     * the audio thread. Note that the time of a read includes the reads of
+     * any input nodes.
+     *
+     * @return true if the reads of this node are timed
+     */
+    bool isProfiled() const { return _profiled.load(std::memory_order_relaxed); }
+    
+    /**
+     * Sets whether the reads of this node are timed
+     *
+     * Profiling is off by default, as timing every node adds a small cost to
+     * the audio thread. Note that the time of a read includes the reads of
+     * any input nodes.
+     *
+     * @param flag  Whether the reads of this node are timed
+     */
+    void setProfiled(bool flag) { _profiled.store(flag,std::memory_order_relaxed); }
+    
+    /**
+     * Returns a snapshot of the read timing for this node
+     *
+     * This method is lock-free and may be called from any thread. The values
+     * are only updated while the node is profiled.
+     *
+     * @return a snapshot of the read timing for this node
+     */
+    virtual AudioProfile getProfile() const;
+    
+    /**
+     * Resets the read timing for this node
+     *
+     * The timing is cleared at the next read in the audio thread.
+     */
+    virtual void resetProfile() { _counters.reset(); }
+
 #pragma mark -
 #pragma mark Optional Methods
     /**
@@ -535,6 +535,9 @@ public:
      * This method is used by the SDL audio interface to process the audio
      * graph. It should never be called by the developer.
      *
+     * This method times the entire callback for {@link getProfile}. A callback
+     * that takes longer than the buffer period is counted as an underrun.
+     *
      * @param stream    The read buffer to store the results
      * @param len       The maximum number of bytes to read
      *
@@ -558,7 +561,9 @@ public:
     /**
      * Returns the number of microseconds needed to render the last audio frame.
      *
-     * This method is primarily for debugging.
+     * This method is primarily for debugging. Use {@link getProfile} for the
+     * rolling timing and the number of underruns. Unlike other nodes, an output
+     * is always profiled, and its profile times the entire device callback.
      *
      * @return the number of microseconds needed to render the last audio frame.
      */
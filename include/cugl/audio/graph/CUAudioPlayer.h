@@ -75,6 +75,14 @@ namespace  cugl {
  * memory pool of preallocated players (which are reinitialized) than to
  * construct them on the fly.
  *
+ * Streamed samples are never decoded in the audio thread. Instead, a shared
+ * background worker decodes several pages ahead of each streaming player,
+ * and the player only copies the decoded pages in {@link read}. The first
+ * page is decoded when the player is initialized, so resets to the start of
+ * the stream (as with looping) are free. A seek to a page that has already
+ * been decoded is also free. Any other seek plays silence until the worker
+ * has decoded the new page.
+ *
  * A player is always associated with a node in the audio graph. As such, it
  * should only be accessed in the main thread.  In addition, no methods marked
  * as AUDIO THREAD ONLY should ever be accessed by the user. The only exception
@@ -101,7 +109,25 @@ protected:
     float* _buffer;
     
     // Streaming support
-    /** A buffer for storing each chunk as we need it */
+    /**
+     * A single page decoded ahead by the stream worker
+     *
+     * The fields are written by the worker before the page is published
+     * and are only read by the audio thread after it is published.
+     */
+    class StreamPage {
+    public:
+        /** The decoded (interleaved) samples */
+        float* data;
+        /** The number of frames decoded */
+        Uint32 frames;
+        /** The page number in the stream */
+        Uint32 page;
+        /** The seek generation of this page */
+        Uint32 gen;
+    };
+
+    /** The chunk currently being read (either the head page or a stream page) */
     float* _chunker;
     /** The size of a single chunk in frames */
     Uint32 _chksize;
@@ -109,6 +135,33 @@ protected:
     Uint32 _chklimt;
     /** The number of the last read frame in the chunk */
     Uint32 _chklast;
+    /** The page number of the current chunk */
+    Uint32 _chkpage;
+    /** The frames to skip in the next stream page (after a seek) */
+    Uint32 _chkskip;
+    /** Whether the current chunk is the oldest stream page */
+    bool _chkslot;
+
+    /** The first page of the stream, decoded at initialization */
+    float* _headpage;
+    /** The number of frames in the first page */
+    Uint32 _headsize;
+    /** The sample storage for the stream pages */
+    float* _pagedata;
+    /** The ring buffer of pages decoded ahead by the stream worker */
+    StreamPage* _pages;
+    /** The number of pages released by the audio thread */
+    std::atomic<Uint32> _pagehead;
+    /** The number of pages published by the stream worker */
+    std::atomic<Uint32> _pagetail;
+    /** The page the stream worker should decode after a seek */
+    std::atomic<Uint32> _seekpage;
+    /** The current seek generation (incremented by the audio thread) */
+    std::atomic<Uint32> _seekgen;
+    /** The seek generation expected by the audio thread */
+    Uint32 _readgen;
+    /** The seek generation last seen by the stream worker */
+    Uint32 _workgen;
         
     /** Whether or not we need to reposition (STREAMING ACCESS) */
     std::atomic<bool> _dirty;
@@ -313,18 +366,106 @@ public:
 private:
 #pragma mark Stream Decoding
     /**
-     * Decodes the audio stream up to the given position.
+     * Repositions the audio stream at the given position.
      *
      * AUDIO THREAD ONLY: Users should never access this method directly.
      * The only exception is when the user needs to create a custom subclass
      * of this AudioNode.
      *
+     * This method never decodes. If the position is not in a page that is
+     * already decoded, the stream worker is told to seek to that page.
+     *
      * If the frame is longer than the stream length, it goes to the end of
      * the stream.
      *
      * @param frame    The absolute frame to skip to
      */
     void scan(Uint64 frame);
+
+    /**
+     * Moves the stream pages forward to the given page.
+     *
+     * AUDIO THREAD ONLY: Users should never access this method directly.
+     *
+     * All stale pages and pages before the given one are released. If the
+     * oldest remaining page is not the given page, the stream worker is told
+     * to start decoding again from that page.
+     *
+     * @param page  The next page to read
+     */
+    void seekPages(Uint32 page);
+
+    /**
+     * Releases the current chunk if it is a stream page.
+     *
+     * AUDIO THREAD ONLY: Users should never access this method directly.
+     */
+    void releasePage();
+
+    /**
+     * Returns true if the next stream page was acquired as the current chunk.
+     *
+     * AUDIO THREAD ONLY: Users should never access this method directly.
+     *
+     * This method releases the current chunk first. It returns false if the
+     * stream worker has not decoded the next page yet, or if the stream is
+     * complete.
+     *
+     * @return true if the next stream page was acquired as the current chunk.
+     */
+    bool nextPage();
+
+    /**
+     * Returns true if the next stream page was acquired by decoding it now.
+     *
+     * AUDIO THREAD ONLY: Users should never access this method directly.
+     *
+     * This method is used in place of {@link nextPage} when the graph is
+     * rendered offline (see {@link AudioNode#isOffline}). Rather than wait
+     * on the stream worker, it decodes the pages on the reading thread, with
+     * the worker locked out. It only returns false if the stream is complete.
+     *
+     * @return true if the next stream page was acquired by decoding it now.
+     */
+    bool awaitPage();
+
+    /**
+     * Returns true if this player decoded a page ahead.
+     *
+     * WORKER THREAD ONLY: This method is called by the stream worker. It
+     * decodes at most one page, and returns false if the ring buffer is full
+     * or the stream is complete.
+     *
+     * @return true if this player decoded a page ahead.
+     */
+    bool decodeAhead();
+
+#pragma mark Stream Worker
+    /**
+     * Adds a player to the stream worker, starting the worker if necessary.
+     *
+     * @param player    The streaming player
+     */
+    static void startStream(AudioPlayer* player);
+
+    /**
+     * Removes a player from the stream worker.
+     *
+     * The player is no longer accessed by the worker once this method returns.
+     * If there are no more streaming players, the worker is shut down.
+     *
+     * @param player    The streaming player
+     */
+    static void stopStream(AudioPlayer* player);
+
+    /**
+     * Runs the stream worker until there are no more streaming players.
+     *
+     * WORKER THREAD ONLY: This is the task of the stream worker.
+     *
+     * @param epoch The epoch of this worker
+     */
+    static void streamLoop(Uint32 epoch);
 };
 
     }
@@ -0,0 +1,209 @@
+//
+//  CUAudioProfile.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides the timing statistics reported by AudioOutput and
+//  (optionally) the other audio graph nodes. It is the audio equivalent of
+//  NetcodeStats and PhysicsProfile, and is intended to be displayed or logged
+//  alongside them.
+//
+//  Statistics are gathered in atomic counters on the audio thread, so that
+//  reading them never requires a lock. Only the audio thread may record to
+//  the counters, but any thread may take a snapshot of them.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_AUDIO_PROFILE_H__
+#define __CU_AUDIO_PROFILE_H__
+#include <SDL.h>
+#include <atomic>
+#include <algorithm>
+
+namespace cugl {
+
+    /**
+     * The audio graph classes.
+     *
+     * This internal namespace is for the audio graph clases.  It was chosen
+     * to distinguish this graph from other graph class collections, such as the
+     * scene graph collections in {@link scene2}.
+     */
+    namespace audio {
+
+/**
+ * This class is a snapshot of the timing of the audio thread.
+ *
+ * The times are in microseconds. The average is a rolling (exponential)
+ * average, and the peak is the maximum over (roughly) the last 128 reads.
+ *
+ * Some values are only meaningful for an {@link AudioOutput}, which times the
+ * entire device callback. Those values are 0 for any other node. The load is
+ * the read time relative to the buffer period, so a load of 1 means that the
+ * callback used all of its time and is about to miss its deadline.
+ */
+class AudioProfile {
+public:
+    /** The number of timed reads */
+    Uint64 reads;
+    /** The time of the most recent read */
+    Uint64 last;
+    /** The rolling average read time */
+    float average;
+    /** The rolling maximum read time */
+    Uint64 peak;
+    /** The buffer period of the most recent callback (output only) */
+    Uint64 period;
+    /** The average read time relative to the buffer period (output only) */
+    float load;
+    /** The peak read time relative to the buffer period (output only) */
+    float peakLoad;
+    /** The number of callbacks that took longer than the buffer period (output only) */
+    Uint64 underruns;
+    /** The number of callbacks where the audio graph did not fill the buffer (output only) */
+    Uint64 starved;
+
+    /**
+     * Creates a snapshot with all statistics zeroed
+     */
+    AudioProfile() :
+    reads(0), last(0), average(0), peak(0), period(0), load(0), peakLoad(0),
+    underruns(0), starved(0) {}
+};
+
+/**
+ * This class stores the live timing counters for an audio node.
+ *
+ * All counters are atomic, so they may be read from any thread. However,
+ * only the audio thread may record to them. A reset from another thread
+ * only takes effect at the next recording.
+ *
+ * Most users should never need this class. Use {@link AudioProfile} instead.
+ */
+class AudioCounters {
+private:
+    /** The number of reads in the current peak window (audio thread) */
+    Uint32 _window;
+    /** The peak of the current window (audio thread) */
+    Uint64 _current;
+    /** The peak of the previous window (audio thread) */
+    Uint64 _previous;
+    /** Whether to clear the counters at the next recording */
+    std::atomic<bool> _cleared;
+
+public:
+    /** The number of reads in a peak window */
+    static const Uint32 WINDOW = 128;
+
+    /** The number of timed reads */
+    std::atomic<Uint64> reads;
+    /** The time of the most recent read in microseconds */
+    std::atomic<Uint64> last;
+    /** The rolling average read time in microseconds */
+    std::atomic<float> average;
+    /** The rolling maximum read time in microseconds */
+    std::atomic<Uint64> peak;
+    /** The buffer period of the most recent callback in microseconds */
+    std::atomic<Uint64> period;
+    /** The number of callbacks that took longer than the buffer period */
+    std::atomic<Uint64> underruns;
+    /** The number of callbacks where the audio graph did not fill the buffer */
+    std::atomic<Uint64> starved;
+
+    /**
+     * Creates a zeroed set of counters
+     */
+    AudioCounters() :
+    _window(0), _current(0), _previous(0), _cleared(false),
+    reads(0), last(0), average(0), peak(0), period(0), underruns(0), starved(0) {}
+
+    /**
+     * Records a read of the given duration
+     *
+     * AUDIO THREAD ONLY: Only the audio thread may record to the counters.
+     *
+     * @param micros    The read duration in microseconds
+     */
+    void record(Uint64 micros) {
+        if (_cleared.exchange(false,std::memory_order_acquire)) {
+            _window = 0;
+            _current = 0;
+            _previous = 0;
+            reads.store(0,std::memory_order_relaxed);
+            average.store(0,std::memory_order_relaxed);
+            underruns.store(0,std::memory_order_relaxed);
+            starved.store(0,std::memory_order_relaxed);
+        }
+
+        Uint64 count = reads.load(std::memory_order_relaxed)+1;
+        float mean = average.load(std::memory_order_relaxed);
+        mean = count == 1 ? (float)micros : mean+((float)micros-mean)/32.0f;
+        _current = std::max(_current,micros);
+        Uint64 top = std::max(_current,_previous);
+        if (++_window == WINDOW) {
+            _previous = _current;
+            _current = 0;
+            _window = 0;
+        }
+
+        last.store(micros,std::memory_order_relaxed);
+        average.store(mean,std::memory_order_relaxed);
+        peak.store(top,std::memory_order_relaxed);
+        reads.store(count,std::memory_order_relaxed);
+    }
+
+    /**
+     * Clears all of the counters
+     *
+     * The counters are cleared by the audio thread at the next recording.
+     */
+    void reset() {
+        _cleared.store(true,std::memory_order_release);
+    }
+
+    /**
+     * Copies the counters into the given snapshot
+     *
+     * @param profile   The snapshot to store the result
+     */
+    void snapshot(AudioProfile& profile) const {
+        profile.reads = reads.load(std::memory_order_relaxed);
+        profile.last = last.load(std::memory_order_relaxed);
+        profile.average = average.load(std::memory_order_relaxed);
+        profile.peak = peak.load(std::memory_order_relaxed);
+        profile.period = period.load(std::memory_order_relaxed);
+        profile.underruns = underruns.load(std::memory_order_relaxed);
+        profile.starved = starved.load(std::memory_order_relaxed);
+        if (profile.period > 0) {
+            profile.load = profile.average/profile.period;
+            profile.peakLoad = (float)profile.peak/profile.period;
+        } else {
+            profile.load = 0;
+            profile.peakLoad = 0;
+        }
+    }
+};
+
+    }
+}
+
+#endif /* __CU_AUDIO_PROFILE_H__ */
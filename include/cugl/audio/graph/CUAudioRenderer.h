@@ -0,0 +1,403 @@
+//
+//  CUAudioRenderer.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides an offline driver for the audio graph. Like an output
+//  device, it is the final node of an audio graph. But rather than being read
+//  by a device in real time, it reads its graph as fast as the CPU allows,
+//  storing the results in a buffer, a sample, or a file. This makes it
+//  possible to benchmark the cost per frame of a graph, to render stems, and
+//  to check the output of DSP nodes against a reference, all without an
+//  output device.
+//
+//  While rendering, the calling thread is treated as an audio thread. In
+//  addition, it is marked as offline, so that nodes which would normally drop
+//  data to meet a device deadline (such as a streaming AudioPlayer) wait for
+//  that data instead. Therefore, rendering the same graph twice produces the
+//  same output.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_AUDIO_RENDERER_H__
+#define __CU_AUDIO_RENDERER_H__
+#include <SDL.h>
+#include "CUAudioNode.h"
+#include <string>
+#include <memory>
+
+namespace cugl {
+
+    /** Forward reference to an audio sample */
+    class AudioSample;
+
+    /**
+     * The audio graph classes.
+     *
+     * This internal namespace is for the audio graph clases.  It was chosen
+     * to distinguish this graph from other graph class collections, such as the
+     * scene graph collections in {@link scene2}.
+     */
+    namespace audio {
+/**
+ * This class renders an audio graph offline.
+ *
+ * This node plays the same role as an {@link AudioOutput}: you attach the
+ * single terminal node of an audio graph to it, and the channels and sample
+ * rate of that node must match this one. But there is no device. Instead,
+ * the graph is read by one of the render methods, which pull the graph in
+ * blocks of {@link getReadSize} frames as fast as the CPU allows. The render
+ * methods stop early if the graph completes.
+ *
+ * The render methods treat the calling thread as an audio thread (see
+ * {@link AudioNode#isAudioThread}) and mark it as offline (see
+ * {@link AudioNode#isOffline}). Hence a streaming {@link AudioPlayer}
+ * decodes its pages as they are needed, rather than falling silent when
+ * its stream worker falls behind. The graph should not be attached to an
+ * output device while it is rendered, as the two would read it at once.
+ *
+ * This node also records the time spent rendering, so that the cost of a
+ * graph can be measured in nanoseconds per frame. As with all nodes, an
+ * active {@link AudioDevices} manager is required to initialize the node,
+ * but no output device needs to be open.
+ *
+ * This class does not support any actions for the {@link AudioNode#setCallback}.
+ */
+class AudioRenderer : public AudioNode {
+private:
+    /** The terminal node of the audio graph. This pulls data from the sources */
+    std::shared_ptr<AudioNode> _input;
+
+    /** The number of frames rendered since the last timing reset */
+    Uint64 _rendered;
+    /** The time spent rendering since the last timing reset (in nanoseconds) */
+    Uint64 _rendtime;
+
+    /**
+     * Returns the number of frames rendered into the given buffer
+     *
+     * This is the implementation of the render methods. It marks the current
+     * thread as an offline audio thread for the duration of the read, and
+     * records the time spent reading.
+     *
+     * @param buffer    The buffer to store the results
+     * @param frames    The maximum number of frames to render
+     *
+     * @return the number of frames rendered into the given buffer
+     */
+    Uint64 pull(float* buffer, Uint64 frames);
+
+#pragma mark -
+#pragma mark Constructors
+public:
+    /**
+     * Creates a degenerate audio renderer.
+     *
+     * The node has no channels, so read options will do nothing. The node must
+     * be initialized to be used.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a graph node on
+     * the heap, use one of the static constructors instead.
+     */
+    AudioRenderer();
+
+    /**
+     * Deletes the audio renderer, disposing of all resources
+     */
+    ~AudioRenderer() { dispose(); }
+
+    /**
+     * Initializes the node with default stereo settings
+     *
+     * The number of channels is two, for stereo output.  The sample rate is
+     * the modern standard of 48000 HZ.
+     *
+     * @return true if initialization was successful
+     */
+    virtual bool init() override;
+
+    /**
+     * Initializes the node with the given number of channels and sample rate
+     *
+     * The read size is that of the {@link AudioEngine}, if it is active, and
+     * {@link AudioDevices#DEFAULT_READ_SIZE} otherwise.
+     *
+     * @param channels  The number of audio channels
+     * @param rate      The sample rate (frequency) in HZ
+     *
+     * @return true if initialization was successful
+     */
+    virtual bool init(Uint8 channels, Uint32 rate) override;
+
+    /**
+     * Initializes the node with the given channels, sample rate and read size
+     *
+     * The read size is the number of frames pulled from the graph at a time.
+     * It should match that of the device the graph is written for, so that
+     * the graph behaves offline as it does in real time.
+     *
+     * @param channels  The number of audio channels
+     * @param rate      The sample rate (frequency) in HZ
+     * @param readsize  The number of frames to pull from the graph at a time
+     *
+     * @return true if initialization was successful
+     */
+    bool init(Uint8 channels, Uint32 rate, Uint32 readsize);
+
+    /**
+     * Disposes any resources allocated for this renderer.
+     *
+     * The state of the node is reset to that of an uninitialized constructor.
+     * Unlike the destructor, this method allows the node to be reinitialized.
+     */
+    virtual void dispose() override;
+
+#pragma mark -
+#pragma mark Static Constructors
+    /**
+     * Returns a newly allocated renderer with default stereo settings
+     *
+     * The number of channels is two, for stereo output.  The sample rate is
+     * the modern standard of 48000 HZ.
+     *
+     * @return a newly allocated renderer with default stereo settings
+     */
+    static std::shared_ptr<AudioRenderer> alloc() {
+        std::shared_ptr<AudioRenderer> result = std::make_shared<AudioRenderer>();
+        return (result->init() ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated renderer with the given number of channels and sample rate
+     *
+     * The read size is that of the {@link AudioEngine}, if it is active, and
+     * {@link AudioDevices#DEFAULT_READ_SIZE} otherwise.
+     *
+     * @param channels  The number of audio channels
+     * @param rate      The sample rate (frequency) in HZ
+     *
+     * @return a newly allocated renderer with the given number of channels and sample rate
+     */
+    static std::shared_ptr<AudioRenderer> alloc(Uint8 channels, Uint32 rate) {
+        std::shared_ptr<AudioRenderer> result = std::make_shared<AudioRenderer>();
+        return (result->init(channels,rate) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated renderer with the given channels, sample rate and read size
+     *
+     * The read size is the number of frames pulled from the graph at a time.
+     * It should match that of the device the graph is written for, so that
+     * the graph behaves offline as it does in real time.
+     *
+     * @param channels  The number of audio channels
+     * @param rate      The sample rate (frequency) in HZ
+     * @param readsize  The number of frames to pull from the graph at a time
+     *
+     * @return a newly allocated renderer with the given channels, sample rate and read size
+     */
+    static std::shared_ptr<AudioRenderer> alloc(Uint8 channels, Uint32 rate, Uint32 readsize) {
+        std::shared_ptr<AudioRenderer> result = std::make_shared<AudioRenderer>();
+        return (result->init(channels,rate,readsize) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Audio Graph
+    /**
+     * Attaches an audio graph to this renderer.
+     *
+     * This method will fail if the channels or sample rate of the audio node
+     * do not agree with this renderer. The read size of the node is set to
+     * that of this renderer.
+     *
+     * @param node  The terminal node of the audio graph
+     *
+     * @return true if the attachment was successful
+     */
+    bool attach(const std::shared_ptr<AudioNode>& node);
+
+    /**
+     * Detaches an audio graph from this renderer.
+     *
+     * If the method succeeds, it returns the terminal node of the audio graph.
+     *
+     * @return  the terminal node of the audio graph (or null if failed)
+     */
+    std::shared_ptr<AudioNode> detach();
+
+    /**
+     * Returns the terminal node of the audio graph
+     *
+     * @return the terminal node of the audio graph
+     */
+    std::shared_ptr<AudioNode> getInput() { return _input; }
+
+    /**
+     * Sets the typical read size of this node.
+     *
+     * For this node, the read size is the number of frames pulled from the
+     * graph at a time. The value is passed on to the attached graph.
+     *
+     * This method is not synchronized, and should never be called while
+     * the graph is rendering.
+     *
+     * @param size  The typical read size of this node.
+     */
+    virtual void setReadSize(Uint32 size) override;
+
+    /**
+     * Returns true if this audio node has no more data.
+     *
+     * An audio node is typically completed if it return 0 (no frames read) on
+     * subsequent threads read. This node is completed if it has no input, or
+     * if its input is completed.
+     *
+     * @return true if this audio node has no more data.
+     */
+    virtual bool completed() override;
+
+    /**
+     * Reads up to the specified number of frames into the given buffer
+     *
+     * AUDIO THREAD ONLY: Users should never access this method directly.
+     * Use one of the render methods instead.
+     *
+     * The buffer should have enough room to store frames * channels elements.
+     * The channels are interleaved into the output buffer. This node is
+     * silent when paused or when it has no input.
+     *
+     * @param buffer    The read buffer to store the results
+     * @param frames    The maximum number of frames to read
+     *
+     * @return the actual number of frames read
+     */
+    virtual Uint32 read(float* buffer, Uint32 frames) override;
+
+#pragma mark -
+#pragma mark Rendering
+    /**
+     * Returns the number of frames rendered into the given buffer
+     *
+     * The buffer should have enough room to store frames * channels elements.
+     * The channels are interleaved into the buffer. The graph is pulled in
+     * blocks of {@link getReadSize} frames, and the rendering stops early if
+     * the graph completes. Any frames that a node does not produce before it
+     * completes are not written.
+     *
+     * @param buffer    The buffer to store the results
+     * @param frames    The maximum number of frames to render
+     *
+     * @return the number of frames rendered into the given buffer
+     */
+    Uint64 render(float* buffer, Uint64 frames);
+
+    /**
+     * Returns a newly allocated sample with the rendered audio graph
+     *
+     * The sample has the channels and sample rate of this renderer, and is
+     * the given number of frames long. If the graph completes early, the rest
+     * of the sample is silent. This method returns nullptr if the sample
+     * could not be allocated.
+     *
+     * @param frames    The number of frames to render
+     *
+     * @return a newly allocated sample with the rendered audio graph
+     */
+    std::shared_ptr<AudioSample> renderSample(Uint64 frames);
+
+    /**
+     * Returns true if the audio graph was rendered to the given file
+     *
+     * The file is a WAV file of 32-bit float samples, with the channels and
+     * sample rate of this renderer. It has at most the given number of
+     * frames, as the rendering stops early if the graph completes. The path
+     * is used as is, so it should be an absolute path (or a path relative
+     * to the working directory).
+     *
+     * @param path      The file to write
+     * @param frames    The maximum number of frames to render
+     *
+     * @return true if the audio graph was rendered to the given file
+     */
+    bool renderFile(const std::string& path, Uint64 frames);
+
+#pragma mark -
+#pragma mark Timing
+    /**
+     * Returns the number of frames rendered since the last timing reset
+     *
+     * @return the number of frames rendered since the last timing reset
+     */
+    Uint64 getFramesRendered() const { return _rendered; }
+
+    /**
+     * Returns the time spent rendering since the last timing reset
+     *
+     * The time is in nanoseconds. It only includes the time spent reading
+     * the graph, and not (for example) the time spent writing a file.
+     *
+     * @return the time spent rendering since the last timing reset
+     */
+    Uint64 getRenderTime() const { return _rendtime; }
+
+    /**
+     * Returns the average cost of a frame in nanoseconds
+     *
+     * This is the render time divided by the number of frames rendered. It
+     * is 0 if nothing has been rendered since the last timing reset. A graph
+     * can keep up with a device only if this value is less than the period
+     * of a frame (1e9 divided by the sample rate).
+     *
+     * @return the average cost of a frame in nanoseconds
+     */
+    double getNanosPerFrame() const;
+
+    /**
+     * Returns the ratio of real time to render time
+     *
+     * This is how many times faster than real time the graph renders. It is
+     * 0 if nothing has been rendered since the last timing reset.
+     *
+     * @return the ratio of real time to render time
+     */
+    double getSpeedup() const;
+
+    /**
+     * Resets the render timing statistics
+     */
+    void resetTiming();
+
+};
+    }
+}
+#endif /* __CU_AUDIO_RENDERER_H__ */
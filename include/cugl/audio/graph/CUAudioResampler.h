@@ -103,6 +103,14 @@ private:
     float* _filter_table;
     /** The filter coefficient differences */
     float* _filter_diffs;
+    /** The filter kernel for the current output frame */
+    float* _kernel;
+    /** The precomputed kernels for each phase of a rational rate ratio */
+    float* _polytable;
+    /** The number of phases in the polyphase table (0 if there is no table) */
+    Uint32 _polyphases;
+    /** The number of input frames per polyphase cycle */
+    Uint32 _polystep;
     
     /** Intermediate read buffer */
     /** The intermediate sampling buffer. Size set by _readsize. */
@@ -648,6 +656,33 @@ private:
      * does **not** need to be recomputed when the input rate changes.
      */
     void setup();
+
+    /**
+     * Sets up the polyphase table for the current input rate.
+     *
+     * If the ratio of the input rate to the output rate reduces to a fraction
+     * with a small denominator (such as 147/160 for 44.1k to 48k), then the
+     * output frames cycle through a fixed set of filter phases. In that case,
+     * this method precomputes the filter kernel for each phase, so that
+     * filtering a frame is a single dot product per channel. Otherwise, there
+     * is no table, and the kernel is computed for each frame.
+     *
+     * This table must be recomputed any time the filter or the input rate
+     * changes.
+     */
+    void setupPolyphase();
+
+    /**
+     * Computes the filter kernel for the given interpolation phase.
+     *
+     * The kernel has two taps per zero crossing. Tap 0 is applied to the
+     * frame immediately after the current offset into the sampling buffer.
+     * Taps outside of the filter window are 0.
+     *
+     * @param kernel    The array to store the kernel
+     * @param interp0   The fractional part of the offset into the buffer
+     */
+    void fillKernel(float* kernel, double interp0);
     
     /**
      * Filters a single frame (for all channels) of output audio
@@ -656,6 +691,10 @@ private:
      * stores the results in buffer (in order by channel). The current audio frame
      * is determined by the _cvtoffset value.
      *
+     * The kernel is taken from the polyphase table when there is one for the
+     * input rate. Otherwise it is computed once for the frame, and shared by
+     * all of the channels.
+     *
      * The additional parameters passed to this method are to ensure thread safety.
      * For example, inrate is the input sampling rate at the time of the buffer
      * computation, and not necessarily the current input rate.
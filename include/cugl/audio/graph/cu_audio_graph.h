@@ -30,13 +30,17 @@
 #ifndef __CU_AUDIO_GRAPH_PKG_H__
 #define __CU_AUDIO_GRAPH_PKG_H__
 
+#include "CUAudioProfile.h"
 #include "CUAudioNode.h"
+#include "CUAudioCommandQueue.h"
 #include "CUAudioOutput.h"
+#include "CUAudioRenderer.h"
 #include "CUAudioInput.h"
 #include "CUAudioResampler.h"
 #include "CUAudioRedistributor.h"
 #include "CUAudioPlayer.h"
 #include "CUAudioFader.h"
+#include "CUAudioConvolver.h"
 #include "CUAudioScheduler.h"
 #include "CUAudioMixer.h"
 #include "CUAudioPanner.h"
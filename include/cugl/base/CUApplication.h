@@ -36,8 +36,13 @@
 #include <cugl/util/CUTimestamp.h>
 #include <cugl/math/CUColor4.h>
 #include <cugl/math/CURect.h>
+#include <cugl/util/CUMPSCQueue.h>
+#include <cugl/util/CUFrameArena.h>
 #include <unordered_map>
 #include <functional>
+#include <atomic>
+#include <memory>
+#include <vector>
 #include <deque>
 #include <mutex>
 
@@ -48,31 +53,13 @@
 
 #define USING_PHYSICS 1
 
+/** The number of bits (slots) in each level of the callback timer wheel */
+#define CU_TIMER_BITS   8
+/** The number of levels in the callback timer wheel */
+#define CU_TIMER_LEVELS 4
+
 namespace cugl {
 
-/**
- * The storage type for all user-defined callbacks.
- *
- * The application API provides a way for the user to attach one-time or 
- * reoccuring callback functions.  This to allow the user to schedule 
- * activity in a future animation frame without having to create a separate
- * thread.  This is particularly important for functionality that accesses
- * the OpenGL context (or any of the low-level SDL subsystems), as that must 
- * be done in the main thread.
- *
- * To keep things simple, callbacks should never require arguments or
- * return a value.  If you wish to keep state, it should be done through
- * the appropriate closure.
- */
-typedef struct {
-    /** The callback function */
-    std::function<bool()> callback;
-    /** The reoccurrence period (0 if called every frame) */
-    Uint32 period;
-    /** The countdown until the next reoccurrence */
-    Uint32 timer;
-} scheduable;
-    
 /**
  * This class represents a basic CUGL application
  *
@@ -162,6 +149,14 @@ protected:
     bool _highdpi;
 	/** Whether this application supports multisampling */
 	bool _multisamp;
+    /** Whether this application runs without a display or OpenGL context */
+    bool _headless;
+    /** Whether each frame advances a fixed time step without sleeping */
+    bool _unthrottled;
+    /** Whether to profile startup and report it at the end of onStartup() */
+    bool _startupReport;
+    /** Whether to write the log asynchronously (see {@link Logger}) */
+    bool _asyncLog;
     
     /** The target FPS of this application */
     float _fps;
@@ -177,6 +172,7 @@ protected:
 
     Uint32 _leftover;
     Uint64 _updateCounter;
+    /** The frame start when the update count (and leftover) was last advanced */
     Timestamp _lastUpdateTime;
     
 private:
@@ -193,13 +189,92 @@ private:
     /** The timestamp for the end of an animation frame */
     Timestamp _finish;
     
+    /**
+     * The storage type for all user-defined callbacks.
+     *
+     * The application API provides a way for the user to attach one-time or
+     * reoccuring callback functions.  This to allow the user to schedule
+     * activity in a future animation frame without having to create a separate
+     * thread.  This is particularly important for functionality that accesses
+     * the OpenGL context (or any of the low-level SDL subsystems), as that must
+     * be done in the main thread.
+     *
+     * Delayed callbacks are stored in a hierarchical timer wheel. Each timer
+     * is an intrusive node in the list of its wheel slot, so that it can be
+     * added or removed in constant time.
+     */
+    struct Timer {
+        /** The unique identifier of this callback */
+        Uint32 id;
+        /** The callback function */
+        std::function<bool()> callback;
+        /** The reoccurrence period (0 if called every frame) */
+        Uint32 period;
+        /** The wheel time (in milliseconds) when this callback is due */
+        Uint64 expire;
+        /** Whether this callback is currently in the timer wheel */
+        bool wheeled;
+        /** Whether the last call of this callback asked to continue */
+        bool repeat;
+        /** Whether this callback has been unscheduled */
+        std::atomic<bool> cancelled;
+        /** The head of the wheel slot containing this callback */
+        Timer** slot;
+        /** The previous callback in the wheel slot */
+        Timer* prev;
+        /** The next callback in the wheel slot */
+        Timer* next;
+    };
+    
     /** Counter to assign unique keys to callbacks */
-    Uint32 _funcid;
+    std::atomic<Uint32> _funcid;
     
-    /** Callback functions (processed at the start of every loop) */
-    std::unordered_map<Uint32, scheduable> _callbacks;
+    /** All scheduled callbacks, by identifier */
+    std::unordered_map<Uint32, std::unique_ptr<Timer>> _callbacks;
+    /** Callbacks scheduled with no delay, which are added without a lock */
+    MPSCQueue<std::unique_ptr<Timer>> _immediate;
+    /** Callbacks that are executed every animation frame */
+    std::vector<Timer*> _everyframe;
+    /** Callbacks that are being executed this animation frame */
+    std::vector<Timer*> _active;
+    /** Identifiers unscheduled before they were removed from the immediate queue */
+    std::vector<Uint32> _cancelled;
+    /** The slots of the timer wheel, as intrusive lists */
+    Timer* _wheel[CU_TIMER_LEVELS][1 << CU_TIMER_BITS];
+    /** The number of callbacks in the timer wheel */
+    size_t _wheelsize;
+    /** The current time of the timer wheel in milliseconds */
+    Uint64 _clock;
 	/** A mutex lock for the schedule queue */
 	std::mutex _queueMutex;
+    
+    /** A deferred job, which is time-sliced across animation frames */
+    struct Job {
+        /** The unique identifier of this job */
+        Uint32 id;
+        /** The job function, called with the remaining budget in microseconds */
+        std::function<bool(Uint64)> work;
+    };
+    
+    /** The deferred jobs (only accessed by the main thread) */
+    std::deque<Job> _jobs;
+    /** The deferred jobs added since the last animation frame */
+    std::vector<Job> _newjobs;
+    /** The deferred jobs cancelled since they were last processed */
+    std::vector<Uint32> _canceljobs;
+    /** Whether there are any new or cancelled jobs */
+    std::atomic<bool> _jobsDirty;
+    /** The next deferred job to run (for round-robin scheduling) */
+    size_t _jobcursor;
+    /** The maximum time in microseconds to spend on deferred jobs each frame */
+    Uint32 _budget;
+	/** A mutex lock for the new and cancelled jobs */
+	std::mutex _jobMutex;
+    
+    /** The arenas for transient data (swapped every frame) */
+    FrameArena _arenas[2];
+    /** The arena for the current animation frame */
+    Uint32 _arenaIndex;
     /**
      * Processes all of the scheduled callback functions.
      *
@@ -207,10 +282,58 @@ private:
      * If they are a one time callback, they are deleted.  If they are
      * a reoccuring callback, the timer is reset.
      *
+     * The cost of this method only depends on the callbacks that are due,
+     * and not on the total number of callbacks.
+     *
      * @param millis    The number of milliseconds since last called
      */
     void processCallbacks(Uint32 millis);
     
+    /**
+     * Adds a timer to the timer wheel.
+     *
+     * The slot is chosen from the time remaining until the timer expires.
+     * The queue mutex must be held.
+     *
+     * @param timer     The timer to add
+     */
+    void insertTimer(Timer* timer);
+    
+    /**
+     * Removes a timer from the timer wheel.
+     *
+     * The queue mutex must be held.
+     *
+     * @param timer     The timer to remove
+     */
+    void removeTimer(Timer* timer);
+    
+    /**
+     * Advances the timer wheel by the given number of milliseconds.
+     *
+     * Any timers that expire are removed from the wheel and added to the
+     * active callbacks. The queue mutex must be held.
+     *
+     * @param millis    The number of milliseconds to advance
+     */
+    void advanceTimers(Uint32 millis);
+    
+    /**
+     * Runs the deferred jobs for the current animation frame.
+     *
+     * The jobs are run round-robin until the frame budget (or the
+     * remaining frame time) is exhausted. At least one job is run each
+     * frame, so that the jobs always make progress.
+     */
+    void processJobs();
+    
+    /**
+     * Adds any new jobs, and removes any cancelled ones.
+     *
+     * This method may only be called by the main thread.
+     */
+    void updateJobs();
+    
 #pragma mark -
 #pragma mark Constructors
 public:
@@ -240,7 +363,8 @@ public:
      *
      * The initialization will use the current value of all of the attributes,
      * like application name, orientation, and size.  These values should be
-     * set before calling init().
+     * set before calling init(). A headless application (see {@link #setHeadless})
+     * creates neither a window nor an OpenGL context.
      *
      * CUGL only supports one application running at a time.  This method will
      * fail if there is another application object.
@@ -255,6 +379,26 @@ public:
     Uint64 getUpdateCount() const {
         return _updateCounter;
     }
+
+    /**
+     * Returns the (fractional) update count at the given time.
+     *
+     * Input events are timestamped when SDL receives them, which is usually
+     * in the middle of a fixed time step. This method maps such a timestamp
+     * onto the clock of {@link #getUpdateCount}, so that the integer part is
+     * the fixed update the event happened in and the fractional part is how
+     * far into that step it happened. Events received since the last frame
+     * map past the current update count.
+     *
+     * The mapping is only meaningful for a throttled application, as an
+     * unthrottled one (see {@link #setUnthrottled}) does not follow the wall
+     * clock.
+     *
+     * @param stamp The time to convert
+     *
+     * @return the (fractional) update count at the given time.
+     */
+    double getUpdateCountAt(const Timestamp& stamp) const;
     
     Uint32 getLeftOver() const {
         return _leftover;
@@ -286,6 +430,9 @@ public:
      * When overriding this method, you should call the parent method as the
      * very last line.  This ensures that the state will transition to FOREGROUND,
      * causing the application to run.
+     *
+     * If the startup report is enabled (see {@link #setStartupReport}), the
+     * parent method ends the startup capture and logs its report.
      */
     virtual void onStartup();
     
@@ -403,6 +550,13 @@ public:
      *
      * This method processes the input, calls the update method, and then
      * draws it.  It also updates any running statics, like the average FPS.
+     * Any deferred jobs (see {@link #defer}) are run between the update and
+     * the draw. The frame arenas are swapped at the start of the frame (see
+     * {@link #getFrameArena}).
+     *
+     * A headless application (see {@link #setHeadless}) skips the draw. An
+     * unthrottled application (see {@link #setUnthrottled}) advances exactly
+     * one fixed time step and does not sleep.
      *
      * @return false if the application should quit next frame
      */
@@ -493,6 +647,114 @@ public:
      */
     void unschedule(Uint32 id);
 
+#pragma mark -
+#pragma mark Deferred Work
+    /**
+     * Adds a job to be time-sliced across animation frames.
+     *
+     * A deferred job is for incremental work that should never use more
+     * than a small part of an animation frame, like building large assets.
+     * Each animation frame, after {@link update} but before {@link draw},
+     * the application calls its jobs round-robin until the frame budget is
+     * exhausted (see {@link #setFrameBudget}). The budget is also limited by
+     * the time remaining in the frame at the target FPS. However, at least
+     * one job is called every frame, so that the jobs make progress even
+     * when the application is behind.
+     *
+     * The job is called with the number of microseconds left in its budget
+     * (which may be 0). It should do a small amount of work each call, and
+     * return false once it is finished. Otherwise it will be called again,
+     * either later this frame or in a future frame.
+     *
+     * This method may be called from any thread, but the job is always
+     * executed in the main thread.
+     *
+     * @param job   The job function
+     *
+     * @return a unique identifier to cancel the job
+     */
+    Uint32 defer(std::function<bool(Uint64 micros)> job);
+    
+    /**
+     * Stops a deferred job from being executed.
+     *
+     * The job is identified by the unique identifier returned by
+     * {@link #defer}. A job that has already finished is ignored.
+     *
+     * @param id    The job identifier
+     */
+    void cancelDeferred(Uint32 id);
+    
+    /**
+     * Returns the number of deferred jobs that are not finished.
+     *
+     * This value does not include any jobs added since the last animation
+     * frame. It should only be called by the main thread.
+     *
+     * @return the number of deferred jobs that are not finished.
+     */
+    size_t getDeferredCount() const { return _jobs.size(); }
+    
+    /**
+     * Sets the maximum time to spend on deferred jobs each frame.
+     *
+     * The budget is in microseconds. The default is 2 milliseconds. A job
+     * that has already started is never interrupted, so a frame can go over
+     * budget by the length of a single job call.
+     *
+     * @param micros    The deferred work budget in microseconds
+     */
+    void setFrameBudget(Uint32 micros) { _budget = micros; }
+    
+    /**
+     * Returns the maximum time to spend on deferred jobs each frame.
+     *
+     * The budget is in microseconds. The default is 2 milliseconds. A job
+     * that has already started is never interrupted, so a frame can go over
+     * budget by the length of a single job call.
+     *
+     * @return the deferred work budget in microseconds
+     */
+    Uint32 getFrameBudget() const { return _budget; }
+    
+    /**
+     * Returns the time remaining in the current animation frame.
+     *
+     * This value is measured in microseconds from the start of the frame,
+     * using the target FPS (see {@link #setFPS}). It is 0 if the frame has
+     * already taken longer than the target.
+     *
+     * @return the time remaining in the current animation frame.
+     */
+    Uint64 getFrameRemaining() const;
+
+#pragma mark -
+#pragma mark Frame Memory
+    /**
+     * Returns the arena for transient data in the current animation frame.
+     *
+     * The application has two arenas, which it swaps at the start of every
+     * animation frame. The arena for the new frame is reset. So memory
+     * allocated from this arena remains valid until the end of the next
+     * animation frame (see {@link #getPreviousFrameArena}), but no longer.
+     *
+     * The arena is not thread-safe, and should only be used by the main
+     * thread. Use {@link FrameAllocator} to put STL containers in the arena.
+     *
+     * @return the arena for transient data in the current animation frame.
+     */
+    FrameArena& getFrameArena() { return _arenas[_arenaIndex]; }
+    
+    /**
+     * Returns the arena for transient data in the previous animation frame.
+     *
+     * Memory allocated from this arena last frame is still valid. However,
+     * this arena will be reset at the start of the next animation frame.
+     *
+     * @return the arena for transient data in the previous animation frame.
+     */
+    FrameArena& getPreviousFrameArena() { return _arenas[1-_arenaIndex]; }
+
     
 #pragma mark -
 #pragma mark Initialization Attributes
@@ -670,6 +932,40 @@ public:
 	 */
 	bool isMultiSampled() const { return _multisamp; }
 
+    /**
+     * Sets whether this application runs headless.
+     *
+     * A headless application has no window, OpenGL context, or fonts. Only
+     * the SDL timer and event subsystems are initialized. The animation loop
+     * still gathers input, processes callbacks and deferred jobs, and calls
+     * the update methods, but it never clears the screen or calls draw().
+     * This is useful for dedicated servers (which can still use the network
+     * layer) and for benchmarks on machines without a GPU.
+     *
+     * Unless the FPS is set explicitly, a headless application runs at the
+     * rate of the fixed time step, so every frame is one fixedUpdate(). See
+     * {@link #setUnthrottled} to run the simulation as fast as possible.
+     *
+     * This method may only be safely called before the application is
+     * initialized.  Once the application is initialized; this value may not
+     * be changed.
+     *
+     * @param value Whether this application runs headless
+     */
+    void setHeadless(bool value);
+
+    /**
+     * Returns true if this application runs headless.
+     *
+     * A headless application has no window, OpenGL context, or fonts. Only
+     * the SDL timer and event subsystems are initialized. The animation loop
+     * still gathers input, processes callbacks and deferred jobs, and calls
+     * the update methods, but it never clears the screen or calls draw().
+     *
+     * @return true if this application runs headless.
+     */
+    bool isHeadless() const { return _headless; }
+
 #pragma mark -
 #pragma mark Runtime Attributes
 
@@ -831,6 +1127,94 @@ public:
      * @return the average frames per second over the last 10 frames.
      */
     float getAverageFPS() const;
+
+    /**
+     * Sets whether this application runs unthrottled.
+     *
+     * An unthrottled application never sleeps between frames. Instead, each
+     * frame advances the simulation by exactly one fixed time step, no matter
+     * how much time has actually passed. So the simulation runs as fast as
+     * the hardware allows, and is independent of the wall clock. This is
+     * intended for benchmarks and headless simulations (see
+     * {@link #setHeadless}). Timer callbacks scheduled with {@link #schedule}
+     * use the same simulated time.
+     *
+     * This method may be safely changed at any time while the application
+     * is running.
+     *
+     * @param value Whether this application runs unthrottled
+     */
+    void setUnthrottled(bool value) { _unthrottled = value; }
+
+    /**
+     * Returns true if this application runs unthrottled.
+     *
+     * An unthrottled application never sleeps between frames. Instead, each
+     * frame advances the simulation by exactly one fixed time step, no matter
+     * how much time has actually passed.
+     *
+     * @return true if this application runs unthrottled.
+     */
+    bool isUnthrottled() const { return _unthrottled; }
+
+    /**
+     * Sets whether this application reports its startup timeline.
+     *
+     * If this value is true, {@link #init} starts a {@link Profiler} capture,
+     * and the parent {@link #onStartup} stops it and logs the report (see
+     * {@link Profiler#getReport}). The report shows where the startup time
+     * went, such as the network layer, shader compiles, asset directories,
+     * JSON parsing, texture decodes and uploads, and font atlases, together
+     * with the thread, wait time and bytes of each. Any asset still loading
+     * asynchronously at the end of {@link #onStartup} is not in the report.
+     * The events remain available (as with {@link Profiler#save}) until the
+     * next capture.
+     *
+     * The engine phases are only timed when CU_PROFILE_ENABLED is 1, which
+     * is the default for debug builds.
+     *
+     * This method may only be safely called before the application is
+     * initialized.
+     *
+     * @param value Whether this application reports its startup timeline
+     */
+    void setStartupReport(bool value) { _startupReport = value; }
+
+    /**
+     * Returns true if this application reports its startup timeline.
+     *
+     * If this value is true, {@link #init} starts a {@link Profiler} capture,
+     * and the parent {@link #onStartup} stops it and logs the report.
+     *
+     * @return true if this application reports its startup timeline.
+     */
+    bool hasStartupReport() const { return _startupReport; }
+
+    /**
+     * Sets whether this application writes its log asynchronously.
+     *
+     * If this value is true, {@link #init} starts the {@link Logger}, so that
+     * the log macros copy their messages to a per-thread buffer instead of
+     * writing them to the console. The messages are written by a background
+     * thread. Errors are still written synchronously. The parent method
+     * {@link #onShutdown} stops the logger, writing any pending messages.
+     *
+     * This method may only be safely called before the application is
+     * initialized.
+     *
+     * @param value Whether this application writes its log asynchronously
+     */
+    void setAsyncLog(bool value) { _asyncLog = value; }
+
+    /**
+     * Returns true if this application writes its log asynchronously.
+     *
+     * If this value is true, {@link #init} starts the {@link Logger}, and the
+     * parent {@link #onShutdown} stops it.
+     *
+     * @return true if this application writes its log asynchronously.
+     */
+    bool hasAsyncLog() const { return _asyncLog; }
     
     /**
      * Sets the clear color of this application
@@ -879,6 +1263,9 @@ public:
     /** 
      * Returns the OpenGL description for this application
      *
+     * A headless application has no OpenGL context, so this method returns
+     * the empty string in that case.
+     *
      * @return the OpenGL description for this application
      */
     const std::string getOpenGLDescription() const;
@@ -166,6 +166,17 @@ public:
      * @return false if the input indicates that the application should quit.
      */
     bool update(SDL_Event event);
+
+    /**
+     * Finishes the input phase of the current animation frame
+     *
+     * All {@link InputDevice} objects have a method {@link InputDevice#flushState()}
+     * that dispatches any events deferred during the input phase. This method
+     * (which should only be called by the {@link Application} class) invokes
+     * this method for all active devices, after all events have been
+     * processed by {@link update}.
+     */
+    void flush();
     
     // All of the above methods should only be accessed by this class
     friend class Application;
@@ -399,6 +410,15 @@ protected:
      * @return false if the input indicates that the application should quit.
      */
     virtual bool updateState(const SDL_Event& event, const Timestamp& stamp) = 0;
+
+    /**
+     * Finishes the input of this device for the current frame.
+     *
+     * This method is called once all of the SDL events for the current frame
+     * have been processed. Devices that coalesce events use this method to
+     * dispatch anything that they have deferred. By default, it does nothing.
+     */
+    virtual void flushState() {}
     
     /**
      * Determine the SDL events of relevance and store there types in eventset.
@@ -0,0 +1,274 @@
+//
+//  CUListenerTable.h
+//  Cornell University Game Library (CUGL)
+//
+//  This header provides a template for the listener tables of the input
+//  devices. A table is a flat array of key/listener pairs. Input devices
+//  dispatch to every listener on every event, so iterating a contiguous
+//  array is much faster than iterating a hash table. Lookup by key is
+//  linear, but tables rarely have more than a handful of listeners.
+//
+//  This class is a class template. Templates do not have cpp files. Hence
+//  all of the code for this templated class is in this header.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_LISTENER_TABLE_H__
+#define __CU_LISTENER_TABLE_H__
+#include <cugl/base/CUBase.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace cugl {
+
+/**
+ * This template is a flat table of listeners for an input device.
+ *
+ * The listeners are stored in a contiguous array in the order they were
+ * added, and are identified by a unique key. Every listener of an input
+ * device receives a focus flag as its last argument, which is true if its
+ * key has the focus of the device. See {@link #dispatch}.
+ *
+ * It is safe for a listener to add or remove listeners (including itself)
+ * while the table is dispatching. A removed listener is not called again,
+ * and a listener added during a dispatch is not called until the next one.
+ * Neither change takes effect in the array until the dispatch completes.
+ *
+ * @tparam F    The listener type (a std::function)
+ */
+template <typename F>
+class ListenerTable {
+private:
+    /** A listener with its key */
+    struct Entry {
+        /** The listener key */
+        Uint32 key;
+        /** The listener */
+        F listener;
+        /** Whether the listener was removed during a dispatch */
+        bool removed;
+    };
+
+    /** The listeners, in the order they were added */
+    std::vector<Entry> _entries;
+    /** The listeners added during a dispatch */
+    std::vector<Entry> _added;
+    /** The number of dispatches in progress */
+    Uint32 _depth;
+    /** Whether listeners were removed during a dispatch */
+    bool _dirty;
+
+    /**
+     * Returns the entry for the given key, or nullptr if it is not present.
+     *
+     * @param key   The listener key
+     *
+     * @return the entry for the given key, or nullptr if it is not present.
+     */
+    Entry* find(Uint32 key) {
+        for(auto it = _entries.begin(); it != _entries.end(); ++it) {
+            if (it->key == key && !it->removed) {
+                return &(*it);
+            }
+        }
+        for(auto it = _added.begin(); it != _added.end(); ++it) {
+            if (it->key == key && !it->removed) {
+                return &(*it);
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Returns the entry for the given key, or nullptr if it is not present.
+     *
+     * @param key   The listener key
+     *
+     * @return the entry for the given key, or nullptr if it is not present.
+     */
+    const Entry* find(Uint32 key) const {
+        return const_cast<ListenerTable*>(this)->find(key);
+    }
+
+    /**
+     * Applies the changes made during a dispatch.
+     */
+    void commit() {
+        if (_dirty) {
+            _entries.erase(std::remove_if(_entries.begin(), _entries.end(),
+                                          [](const Entry& e) { return e.removed; }),
+                           _entries.end());
+            _dirty = false;
+        }
+        for(auto it = _added.begin(); it != _added.end(); ++it) {
+            if (!it->removed) {
+                _entries.push_back(std::move(*it));
+            }
+        }
+        _added.clear();
+    }
+
+public:
+    /**
+     * Creates an empty listener table.
+     */
+    ListenerTable() : _depth(0), _dirty(false) {}
+
+    /**
+     * Returns true if there are no listeners in this table.
+     *
+     * @return true if there are no listeners in this table.
+     */
+    bool empty() const { return size() == 0; }
+
+    /**
+     * Returns the number of listeners in this table.
+     *
+     * @return the number of listeners in this table.
+     */
+    size_t size() const {
+        if (_depth == 0) {
+            return _entries.size();
+        }
+        size_t result = 0;
+        for(auto it = _entries.begin(); it != _entries.end(); ++it) {
+            result += it->removed ? 0 : 1;
+        }
+        for(auto it = _added.begin(); it != _added.end(); ++it) {
+            result += it->removed ? 0 : 1;
+        }
+        return result;
+    }
+
+    /**
+     * Returns true if there is a listener for the given key.
+     *
+     * @param key   The listener key
+     *
+     * @return true if there is a listener for the given key.
+     */
+    bool contains(Uint32 key) const { return find(key) != nullptr; }
+
+    /**
+     * Returns the listener for the given key
+     *
+     * If there is no listener for the given key, it returns nullptr.
+     *
+     * @param key   The listener key
+     *
+     * @return the listener for the given key
+     */
+    F get(Uint32 key) const {
+        const Entry* entry = find(key);
+        return entry ? entry->listener : nullptr;
+    }
+
+    /**
+     * Adds a listener for the given key
+     *
+     * There can only be one listener for a given key. If there is already a
+     * listener for the key, the method will fail and return false.
+     *
+     * @param key       The listener key
+     * @param listener  The listener to add
+     *
+     * @return true if the listener was succesfully added
+     */
+    bool add(Uint32 key, F listener) {
+        if (contains(key)) {
+            return false;
+        } else if (_depth > 0) {
+            _added.push_back({key,std::move(listener),false});
+        } else {
+            _entries.push_back({key,std::move(listener),false});
+        }
+        return true;
+    }
+
+    /**
+     * Removes the listener for the given key
+     *
+     * If there is no listener for the given key, this method fails and
+     * returns false.
+     *
+     * @param key   The listener key
+     *
+     * @return true if the listener was succesfully removed
+     */
+    bool remove(Uint32 key) {
+        Entry* entry = find(key);
+        if (entry == nullptr) {
+            return false;
+        } else if (_depth > 0) {
+            // The listener may be running, so do not destroy it yet
+            entry->removed = true;
+            _dirty = true;
+        } else {
+            _entries.erase(_entries.begin()+(entry-_entries.data()));
+        }
+        return true;
+    }
+
+    /**
+     * Removes all listeners from this table.
+     */
+    void clear() {
+        if (_depth > 0) {
+            for(auto it = _entries.begin(); it != _entries.end(); ++it) {
+                it->removed = true;
+            }
+            _added.clear();
+            _dirty = true;
+        } else {
+            _entries.clear();
+        }
+    }
+
+    /**
+     * Calls every listener with the given arguments.
+     *
+     * Each listener is called with the given arguments, followed by a flag
+     * that is true if its key is equal to focus.
+     *
+     * @param focus The key with focus
+     * @param args  The listener arguments (before the focus flag)
+     */
+    template <typename... Args>
+    void dispatch(Uint32 focus, const Args&... args) {
+        _depth++;
+        for(size_t ii = 0; ii < _entries.size(); ii++) {
+            const Entry& entry = _entries[ii];
+            if (!entry.removed) {
+                entry.listener(args...,entry.key == focus);
+            }
+        }
+        if (--_depth == 0 && (_dirty || !_added.empty())) {
+            commit();
+        }
+    }
+};
+
+}
+
+#endif /* __CU_LISTENER_TABLE_H__ */
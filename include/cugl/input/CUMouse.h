@@ -35,6 +35,7 @@
 #define __CU_MOUSE_H__
 
 #include <cugl/input/CUInput.h>
+#include <cugl/input/CUListenerTable.h>
 #include <cugl/math/CURect.h>
 #include <cugl/math/CUVec2.h>
 
@@ -546,15 +547,31 @@ protected:
     Vec2 _wheelOffset;
     
     /** The set of listeners called whenever a mouse is pressed */
-    std::unordered_map<Uint32, ButtonListener> _pressListeners;
+    ListenerTable<ButtonListener> _pressListeners;
     /** The set of listeners called whenever a mouse is released */
-    std::unordered_map<Uint32, ButtonListener> _releaseListeners;
+    ListenerTable<ButtonListener> _releaseListeners;
     /** The set of listeners called whenever a mouse is moved */
-    std::unordered_map<Uint32, MotionListener> _moveListeners;
+    ListenerTable<MotionListener> _moveListeners;
     /** The set of listeners called whenever a mouse is dragged */
-    std::unordered_map<Uint32, MotionListener> _dragListeners;
+    ListenerTable<MotionListener> _dragListeners;
     /** The set of listeners called whenever a mouse wheel is moved */
-    std::unordered_map<Uint32, WheelListener> _wheelListeners;
+    ListenerTable<WheelListener> _wheelListeners;
+
+    /** Whether to coalesce motion events into one dispatch per frame */
+    bool _coalesce;
+    /** Whether a coalesced motion event is waiting to be dispatched */
+    bool _pending;
+    /** Whether the pending motion event should go to the motion listeners */
+    bool _pendingMove;
+    /** The most recent motion event coalesced this frame */
+    MouseEvent _pendingEvent;
+    /** The mouse position before the first motion event coalesced this frame */
+    Vec2 _pendingPrevious;
+
+    /** Whether to record the raw motion events of each frame */
+    bool _recordHistory;
+    /** The raw motion events of the current animation frame */
+    std::vector<MouseEvent> _history;
 
 #pragma mark Constructor
     /**
@@ -566,7 +583,8 @@ protected:
      * WARNING: Never allocate a mouse device directly.  Always use the
      * {@link Input#activate()} method instead.
      */
-    Mouse() : InputDevice(), _awareness(PointerAwareness::BUTTON) {}
+    Mouse() : InputDevice(), _awareness(PointerAwareness::BUTTON),
+    _coalesce(false), _pending(false), _pendingMove(false), _recordHistory(false) {}
     
     /**
      * Deletes this input device, disposing of all resources
@@ -615,6 +633,66 @@ public:
      * @param awareness The pointer awareness for this device
      */
     void setPointerAwareness(PointerAwareness awareness) { _awareness = awareness; }
+
+    /**
+     * Returns true if this device coalesces motion events
+     *
+     * SDL can report many motion events in a single animation frame, which
+     * is particularly common with high polling rate mice. When coalescing is
+     * on, this device dispatches at most one drag or motion event per frame.
+     * The event has the last position of the frame, and its previous position
+     * is the position before the first motion event of the frame. Motion is
+     * always dispatched before any button or wheel event that follows it, so
+     * listeners still see events in order.
+     *
+     * Coalescing is off by default. Use {@link #setMotionHistory} if you turn
+     * it on, but still need every motion sample (e.g. for drawing strokes).
+     *
+     * @return true if this device coalesces motion events
+     */
+    bool isCoalescing() const { return _coalesce; }
+
+    /**
+     * Sets whether this device coalesces motion events
+     *
+     * SDL can report many motion events in a single animation frame, which
+     * is particularly common with high polling rate mice. When coalescing is
+     * on, this device dispatches at most one drag or motion event per frame.
+     * The event has the last position of the frame, and its previous position
+     * is the position before the first motion event of the frame. Motion is
+     * always dispatched before any button or wheel event that follows it, so
+     * listeners still see events in order.
+     *
+     * Coalescing is off by default. Use {@link #setMotionHistory} if you turn
+     * it on, but still need every motion sample (e.g. for drawing strokes).
+     *
+     * @param value Whether this device coalesces motion events
+     */
+    void setCoalescing(bool value);
+
+    /**
+     * Returns true if this device records the raw motion history
+     *
+     * When this value is true, every motion event of the current animation
+     * frame is available from {@link #getMotionHistory}, whether or not the
+     * events are coalesced. Only events allowed by the pointer awareness
+     * are recorded.
+     *
+     * @return true if this device records the raw motion history
+     */
+    bool hasMotionHistory() const { return _recordHistory; }
+
+    /**
+     * Sets whether this device records the raw motion history
+     *
+     * When this value is true, every motion event of the current animation
+     * frame is available from {@link #getMotionHistory}, whether or not the
+     * events are coalesced. Only events allowed by the pointer awareness
+     * are recorded.
+     *
+     * @param value Whether this device records the raw motion history
+     */
+    void setMotionHistory(bool value);
     
 
 #pragma mark Data Polling
@@ -670,6 +748,16 @@ public:
      * @return the amount the mouse wheel moved this animation frame.
      */
     Vec2 wheelDirection() const { return _wheelOffset; }
+
+    /**
+     * Returns the raw motion events of this animation frame
+     *
+     * The events are in the order they were received. This list is empty
+     * unless the motion history is on. See {@link #setMotionHistory}.
+     *
+     * @return the raw motion events of this animation frame
+     */
+    const std::vector<MouseEvent>& getMotionHistory() const { return _history; }
     
 #pragma mark Listeners
     /**
@@ -952,6 +1040,19 @@ protected:
      * @return false if the input indicates that the application should quit.
      */
     virtual bool updateState(const SDL_Event& event, const Timestamp& stamp) override;
+
+    /**
+     * Finishes the input of this device for the current frame.
+     *
+     * This method dispatches the coalesced motion event (if any) of this
+     * animation frame.
+     */
+    virtual void flushState() override;
+
+    /**
+     * Dispatches the pending coalesced motion event, if there is one
+     */
+    void flushMotion();
     
     /**
      * Determine the SDL events of relevance and store there types in eventset.
@@ -35,6 +35,7 @@
 #define __CU_TOUCHSCREEN_H__
 
 #include "CUInput.h"
+#include "CUListenerTable.h"
 #include <cugl/math/CURect.h>
 
 namespace cugl {
@@ -189,11 +190,29 @@ protected:
     std::unordered_map<TouchID,Vec2> _current;
     
     /** The set of listeners called whenever a touch begins */
-    std::unordered_map<Uint32, ContactListener> _beginListeners;
+    ListenerTable<ContactListener> _beginListeners;
     /** The set of listeners called whenever a touch ends */
-    std::unordered_map<Uint32, ContactListener> _finishListeners;
+    ListenerTable<ContactListener> _finishListeners;
     /** The set of listeners called whenever a touch is moved */
-    std::unordered_map<Uint32, MotionListener> _moveListeners;
+    ListenerTable<MotionListener> _moveListeners;
+
+    /** A coalesced motion event for a single touch */
+    struct PendingMotion {
+        /** The most recent motion event for the touch this frame */
+        TouchEvent event;
+        /** The touch position before the first motion event this frame */
+        Vec2 previous;
+    };
+
+    /** Whether to coalesce motion events into one dispatch per touch per frame */
+    bool _coalesce;
+    /** The coalesced motion events waiting to be dispatched */
+    std::vector<PendingMotion> _pending;
+
+    /** Whether to record the raw motion events of each frame */
+    bool _recordHistory;
+    /** The raw motion events of the current animation frame */
+    std::vector<TouchEvent> _history;
 
 #pragma mark Constructors
     /**
@@ -202,7 +221,7 @@ protected:
      * WARNING: Never allocate a touch screen device directly.  Always use the
      * {@link Input#activate()} method instead.
      */
-    Touchscreen() : InputDevice() {}
+    Touchscreen() : InputDevice(), _coalesce(false), _recordHistory(false) {}
     
     /**
      * Deletes this input device, disposing of all resources
@@ -223,8 +242,65 @@ protected:
      */
     virtual void dispose() override;
 
-#pragma mark Data Polling
 public:
+#pragma mark Coalescing
+    /**
+     * Returns true if this device coalesces motion events
+     *
+     * SDL can report many motion events for a touch in a single animation
+     * frame. When coalescing is on, this device dispatches at most one motion
+     * event per touch per frame. The event has the last position of the frame,
+     * and its previous position is the position before the first motion event
+     * of the frame. Motion is always dispatched before any touch begins or
+     * ends, so listeners still see events in order.
+     *
+     * Coalescing is off by default. Use {@link #setMotionHistory} if you turn
+     * it on, but still need every motion sample (e.g. for drawing strokes).
+     *
+     * @return true if this device coalesces motion events
+     */
+    bool isCoalescing() const { return _coalesce; }
+
+    /**
+     * Sets whether this device coalesces motion events
+     *
+     * SDL can report many motion events for a touch in a single animation
+     * frame. When coalescing is on, this device dispatches at most one motion
+     * event per touch per frame. The event has the last position of the frame,
+     * and its previous position is the position before the first motion event
+     * of the frame. Motion is always dispatched before any touch begins or
+     * ends, so listeners still see events in order.
+     *
+     * Coalescing is off by default. Use {@link #setMotionHistory} if you turn
+     * it on, but still need every motion sample (e.g. for drawing strokes).
+     *
+     * @param value Whether this device coalesces motion events
+     */
+    void setCoalescing(bool value);
+
+    /**
+     * Returns true if this device records the raw motion history
+     *
+     * When this value is true, every motion event of the current animation
+     * frame is available from {@link #getMotionHistory}, whether or not the
+     * events are coalesced.
+     *
+     * @return true if this device records the raw motion history
+     */
+    bool hasMotionHistory() const { return _recordHistory; }
+
+    /**
+     * Sets whether this device records the raw motion history
+     *
+     * When this value is true, every motion event of the current animation
+     * frame is available from {@link #getMotionHistory}, whether or not the
+     * events are coalesced.
+     *
+     * @param value Whether this device records the raw motion history
+     */
+    void setMotionHistory(bool value);
+
+#pragma mark Data Polling
     /**
      * Returns true if touch is a finger currenly held down on the screen
      *
@@ -305,6 +381,16 @@ public:
      * @return the set of identifiers for the fingers currently held down.
      */
     const std::vector<TouchID> touchSet() const;
+
+    /**
+     * Returns the raw motion events of this animation frame
+     *
+     * The events are in the order they were received, for all touches. This
+     * list is empty unless the motion history is on. See {@link #setMotionHistory}.
+     *
+     * @return the raw motion events of this animation frame
+     */
+    const std::vector<TouchEvent>& getMotionHistory() const { return _history; }
     
 #pragma mark Listeners
     /**
@@ -485,6 +571,19 @@ protected:
      * @return false if the input indicates that the application should quit.
      */
     virtual bool updateState(const SDL_Event& event, const Timestamp& stamp) override;
+
+    /**
+     * Finishes the input of this device for the current frame.
+     *
+     * This method dispatches the coalesced motion events (if any) of this
+     * animation frame.
+     */
+    virtual void flushState() override;
+
+    /**
+     * Dispatches the pending coalesced motion events, in the order received
+     */
+    void flushMotion();
     
     /**
      * Determine the SDL events of relevance and store there types in eventset.
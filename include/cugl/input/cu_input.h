@@ -29,6 +29,7 @@
 #define __CU_INPUT_PKG_H__
 
 #include "CUInput.h"
+#include "CUListenerTable.h"
 #include "CUKeyboard.h"
 #include "CUMouse.h"
 #include "CUTextInput.h"
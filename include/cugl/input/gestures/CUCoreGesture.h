@@ -35,6 +35,7 @@
 #define __CU_CORE_GESTURE_H__
 
 #include <cugl/input/CUInput.h>
+#include <cugl/input/CUListenerTable.h>
 #include <cugl/math/CUVec2.h>
 
 namespace cugl {
@@ -256,11 +257,11 @@ protected:
     size_t _updated;
     
     /** The set of listeners called whenever a gesture begins */
-    std::unordered_map<Uint32, Listener> _startListeners;
+    ListenerTable<Listener> _startListeners;
     /** The set of listeners called whenever a gesture updates */
-    std::unordered_map<Uint32, Listener> _deltaListeners;
+    ListenerTable<Listener> _deltaListeners;
     /** The set of listeners called whenever a gesture ends */
-    std::unordered_map<Uint32, Listener> _endListeners;
+    ListenerTable<Listener> _endListeners;
 
 #pragma mark Constructor
     /**
@@ -35,6 +35,7 @@
 #ifndef __CU_PAN_INPUT_H__
 #define __CU_PAN_INPUT_H__
 #include <cugl/input/CUInput.h>
+#include <cugl/input/CUListenerTable.h>
 #include <cugl/math/CUVec2.h>
 
 namespace cugl {
@@ -190,11 +191,11 @@ protected:
     size_t _updated;
     
     /** The set of listeners called whenever a pan begins */
-    std::unordered_map<Uint32, Listener> _beginListeners;
+    ListenerTable<Listener> _beginListeners;
     /** The set of listeners called whenever a pan ends */
-    std::unordered_map<Uint32, Listener> _finishListeners;
+    ListenerTable<Listener> _finishListeners;
     /** The set of listeners called whenever a pan is moved */
-    std::unordered_map<Uint32, Listener> _motionListeners;
+    ListenerTable<Listener> _motionListeners;
     
     
 #pragma mark Constructor
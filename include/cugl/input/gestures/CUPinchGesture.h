@@ -36,6 +36,7 @@
 #ifndef __CU_PINCH_INPUT_H__
 #define __CU_PINCH_INPUT_H__
 #include <cugl/input/CUInput.h>
+#include <cugl/input/CUListenerTable.h>
 #include <cugl/math/CUVec2.h>
 
 namespace cugl {
@@ -196,11 +197,11 @@ protected:
     size_t _updated;
 
     /** The set of listeners called whenever a pinch begins */
-    std::unordered_map<Uint32, Listener> _beginListeners;
+    ListenerTable<Listener> _beginListeners;
     /** The set of listeners called whenever a pinch ends */
-    std::unordered_map<Uint32, Listener> _finishListeners;
+    ListenerTable<Listener> _finishListeners;
     /** The set of listeners called whenever a pinch is moved */
-    std::unordered_map<Uint32, Listener> _changeListeners;
+    ListenerTable<Listener> _changeListeners;
 
 
 #pragma mark Constructor
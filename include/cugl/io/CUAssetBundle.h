@@ -0,0 +1,367 @@
+//
+//  CUAssetBundle.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides support for asset bundles. A bundle is a single
+//  archive file holding many assets, together with a central index. Opening
+//  a file on some platforms (particularly the APK asset manager on Android)
+//  has a significant fixed cost, and a bundle pays it only once.
+//
+//  Bundles are built offline with the script scripts/bundle.py. Each entry
+//  is aligned so that it may be used directly from a memory mapping, and may
+//  optionally be compressed (with the LZ4 block format).
+//
+//  Once a bundle is mounted, every reader in the io package, as well as the
+//  asset loaders, will read asset files from the bundle instead of the file
+//  system. Files that are not in any mounted bundle are read as normal.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_ASSET_BUNDLE_H__
+#define __CU_ASSET_BUNDLE_H__
+#include <cugl/base/CUBase.h>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace cugl {
+
+/** Forward reference to the bundle storage */
+class BinaryReader;
+
+/**
+ * This class is a read-only archive of asset files.
+ *
+ * A bundle is a single file with a central index, built offline by the
+ * script scripts/bundle.py. Files in the bundle are identified by their
+ * path relative to the root of the packed directory, using forward slashes
+ * as the separator (e.g. "textures/player.png").
+ *
+ * Whenever possible, the bundle is memory mapped. In that case, uncompressed
+ * entries are never copied; {@link getData} returns a pointer directly into
+ * the mapping. Compressed entries are decompressed on each access.
+ *
+ * A bundle becomes transparent to the rest of the engine once it is passed
+ * to {@link mount}. From then on, {@link openStream} (which is used by the io
+ * readers, {@link JsonDocument}, and the texture, font and sound loaders)
+ * will serve any file in the asset directory from the bundle. The bundle
+ * must not be disposed while any stream opened from it is in use.
+ *
+ * Bundles are immutable, and so may be safely read from any thread.
+ */
+class AssetBundle {
+private:
+    /**
+     * An entry in the bundle index
+     */
+    class Entry {
+    public:
+        /** The offset of the data from the start of the bundle */
+        Uint64 offset;
+        /** The number of bytes stored in the bundle */
+        Uint64 stored;
+        /** The number of bytes after decompression */
+        Uint64 length;
+        /** Whether the data is compressed */
+        bool compressed;
+    };
+
+    /** The path to the bundle file */
+    std::string _name;
+    /** The reader holding the bundle mapping (if mapped) */
+    std::shared_ptr<BinaryReader> _reader;
+    /** The bundle contents (if not mapped) */
+    std::vector<Uint8> _storage;
+    /** The start of the bundle contents */
+    const Uint8* _data;
+    /** The size of the bundle in bytes */
+    size_t _size;
+    /** The bundle index */
+    std::unordered_map<std::string,Entry> _index;
+
+    /**
+     * Returns the index entry for the given file, or nullptr if it is missing
+     *
+     * @param file  The path of the file in the bundle
+     *
+     * @return the index entry for the given file, or nullptr if it is missing
+     */
+    const Entry* find(const std::string& file) const;
+
+    /**
+     * Parses the header and index of the bundle contents
+     *
+     * @return true if the bundle is well-formed
+     */
+    bool parse();
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an uninitialized asset bundle.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    AssetBundle() : _data(nullptr), _size(0) {}
+
+    /**
+     * Deletes this asset bundle, disposing all resources
+     */
+    ~AssetBundle() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this bundle.
+     *
+     * Any stream opened from this bundle is invalid after this call.
+     */
+    void dispose();
+
+    /**
+     * Initializes an asset bundle from the given file.
+     *
+     * If the file is a relative path, this bundle will look for the file in
+     * the application save directory {@see Application#getSaveDirectory()}.
+     * If you wish to read a file in any other directory, you must provide
+     * an absolute path.
+     *
+     * @param file  the path (absolute or relative) to the bundle
+     *
+     * @return true if the bundle is initialized properly, false otherwise.
+     */
+    bool init(const std::string file);
+
+    /**
+     * Initializes an asset bundle from the given file.
+     *
+     * This initializer assumes that the file name is a relative path. It will
+     * search the application assert directory {@see Application#getAssetDirectory()}
+     * for the file and return false if it cannot find it there.
+     *
+     * @param file  the relative path to the bundle
+     *
+     * @return true if the bundle is initialized properly, false otherwise.
+     */
+    bool initWithAsset(const std::string file);
+
+#pragma mark Static Constructors
+    /**
+     * Returns a newly allocated asset bundle from the given file.
+     *
+     * If the file is a relative path, this bundle will look for the file in
+     * the application save directory {@see Application#getSaveDirectory()}.
+     * If you wish to read a file in any other directory, you must provide
+     * an absolute path.
+     *
+     * @param file  the path (absolute or relative) to the bundle
+     *
+     * @return a newly allocated asset bundle from the given file.
+     */
+    static std::shared_ptr<AssetBundle> alloc(const std::string file) {
+        std::shared_ptr<AssetBundle> result = std::make_shared<AssetBundle>();
+        return (result->init(file) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated asset bundle from the given file.
+     *
+     * This allocator assumes that the file name is a relative path. It will
+     * search the application assert directory {@see Application#getAssetDirectory()}
+     * for the file and return nullptr if it cannot find it there.
+     *
+     * @param file  the relative path to the bundle
+     *
+     * @return a newly allocated asset bundle from the given file.
+     */
+    static std::shared_ptr<AssetBundle> allocWithAsset(const std::string file) {
+        std::shared_ptr<AssetBundle> result = std::make_shared<AssetBundle>();
+        return (result->initWithAsset(file) ? result : nullptr);
+    }
+
+#pragma mark Attributes
+    /**
+     * Returns the path to the bundle file
+     *
+     * @return the path to the bundle file
+     */
+    const std::string& getName() const { return _name; }
+
+    /**
+     * Returns true if the bundle is memory mapped
+     *
+     * Only a mapped bundle loads uncompressed files with no copy at all.
+     *
+     * @return true if the bundle is memory mapped
+     */
+    bool isMapped() const { return _data != nullptr && _storage.empty(); }
+
+    /**
+     * Returns the number of files in this bundle
+     *
+     * @return the number of files in this bundle
+     */
+    size_t count() const { return _index.size(); }
+
+    /**
+     * Returns the paths of all files in this bundle
+     *
+     * The paths are in no particular order.
+     *
+     * @return the paths of all files in this bundle
+     */
+    std::vector<std::string> getFiles() const;
+
+#pragma mark File Access
+    /**
+     * Returns true if this bundle contains the given file
+     *
+     * @param file  The path of the file in the bundle
+     *
+     * @return true if this bundle contains the given file
+     */
+    bool contains(const std::string& file) const {
+        return find(file) != nullptr;
+    }
+
+    /**
+     * Returns true if the given file is compressed in this bundle
+     *
+     * @param file  The path of the file in the bundle
+     *
+     * @return true if the given file is compressed in this bundle
+     */
+    bool isCompressed(const std::string& file) const;
+
+    /**
+     * Returns the (uncompressed) size of the given file in bytes
+     *
+     * This method returns 0 if the file is not in this bundle.
+     *
+     * @param file  The path of the file in the bundle
+     *
+     * @return the (uncompressed) size of the given file in bytes
+     */
+    size_t getSize(const std::string& file) const;
+
+    /**
+     * Returns a pointer to the contents of the given file
+     *
+     * The pointer is into the bundle itself, and is valid until the bundle
+     * is disposed. This method returns nullptr if the file is missing or is
+     * compressed. Use {@link read} for compressed files.
+     *
+     * @param file  The path of the file in the bundle
+     *
+     * @return a pointer to the contents of the given file
+     */
+    const Uint8* getData(const std::string& file) const;
+
+    /**
+     * Reads the (uncompressed) contents of the given file into a buffer
+     *
+     * The buffer is resized to fit the file. This method returns false if
+     * the file is missing or cannot be decompressed.
+     *
+     * @param file  The path of the file in the bundle
+     * @param data  The buffer to store the result
+     *
+     * @return true if the file was read successfully
+     */
+    bool read(const std::string& file, std::vector<Uint8>& data) const;
+
+    /**
+     * Returns a read-only stream for the given file
+     *
+     * For uncompressed files, the stream reads directly from the bundle. A
+     * compressed file is decompressed into memory owned by the stream, and
+     * freed when the stream is closed. In both cases, the stream is a memory
+     * stream, and so {@link BinaryReader#allocMapped} will use it with no
+     * copy.
+     *
+     * This method returns nullptr if the file is missing or cannot be
+     * decompressed.
+     *
+     * @param file  The path of the file in the bundle
+     *
+     * @return a read-only stream for the given file
+     */
+    SDL_RWops* open(const std::string& file) const;
+
+#pragma mark Mounting
+    /**
+     * Mounts the given bundle, making it visible to {@link openStream}
+     *
+     * The bundle is assumed to hold files from the asset directory. Bundles
+     * mounted later take precedence over those mounted earlier. Mounting a
+     * bundle twice has no effect.
+     *
+     * @param bundle    The bundle to mount
+     */
+    static void mount(const std::shared_ptr<AssetBundle>& bundle);
+
+    /**
+     * Unmounts the given bundle
+     *
+     * Streams already opened from the bundle remain valid for as long as the
+     * caller keeps a reference to the bundle.
+     *
+     * @param bundle    The bundle to unmount
+     */
+    static void unmount(const std::shared_ptr<AssetBundle>& bundle);
+
+    /**
+     * Unmounts all bundles
+     */
+    static void unmountAll();
+
+    /**
+     * Returns a read-only stream for the file at the given path
+     *
+     * If the path is in the asset directory, and the file is in a mounted
+     * bundle, this is the stream from the bundle. Otherwise, this is the
+     * same as calling SDL_RWFromFile with mode "rb". This method returns
+     * nullptr if the file cannot be opened.
+     *
+     * @param path  The (normalized) path to the file
+     *
+     * @return a read-only stream for the file at the given path
+     */
+    static SDL_RWops* openStream(const std::string& path);
+
+};
+
+}
+
+#endif /* __CU_ASSET_BUNDLE_H__ */
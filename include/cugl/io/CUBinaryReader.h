@@ -10,6 +10,10 @@
 //  long, etc.  Those types are NOT cross-platform.  For example, a long is
 //  8 bytes on Unix/OS X, but 4 bytes on Win32 platforms.
 //
+//  A reader may also be memory-mapped, in which case there is no transfer
+//  buffer and bulk reads can return pointers directly into the file. If the
+//  file is in the byte order of the host, values are never byte swapped.
+//
 //  By default, this module (and every module in the io package) accesses the
 //  application save directory.  If you want to access another directory, you
 //  will need to specify an absolute path for the file name.  Keep in mind that
@@ -53,6 +57,7 @@
 #ifndef __CU_BINARY_READER_H__
 #define __CU_BINARY_READER_H__
 #include <cugl/base/CUBase.h>
+#include <type_traits>
 #include <string>
 
 namespace cugl {
@@ -68,6 +73,12 @@ namespace cugl {
  * long, etc.  Those types are NOT cross-platform.  For example, a long is
  * 8 bytes on Unix/OS X, but 4 bytes on Win32 platforms.
  *
+ * Data is in network order unless {@link setLittleEndian} says otherwise.
+ * When the file order matches the host, values are never byte swapped. In
+ * addition, a reader created with {@link allocMapped} reads straight from a
+ * memory mapping of the file. Combined with {@link readSpan}, this allows
+ * large arrays to be used with no copy at all.
+ *
  * By default, this class (and every class in the io package) accesses the
  * application save directory {@see Application#getSaveDirectory()}.  If you
  * want to access another directory, you will need to specify an absolute path
@@ -94,6 +105,17 @@ protected:
     Uint32      _bufsize;
     /** The current offset in the read buffer */
     Sint32      _bufoff;
+
+    /** Whether the buffer is a memory mapping of the entire file */
+    bool        _mapped;
+    /** The memory mapping (nullptr if not mapped, or owned by the stream) */
+    void*       _mapping;
+    /** The platform handle for the memory mapping (Windows only) */
+    void*       _maphandle;
+    /** Whether the file is stored in little-endian order */
+    bool        _little;
+    /** Whether values must be byte swapped to match the host */
+    bool        _swap;
     
 #pragma mark -
 #pragma mark Internal Methods
@@ -106,6 +128,24 @@ protected:
      * @param bytes The minimum number of bytes to ensure in the stream
      */
     void fill(unsigned int bytes=1);
+
+    /**
+     * Attempts to memory map the open file
+     *
+     * On success, the buffer is the mapping of the entire file. Files from an
+     * asset bundle are already in memory, and are used as is. On Android,
+     * assets are mapped through the asset manager. Otherwise this uses the
+     * native mapping of the platform. If mapping fails, the reader should
+     * fall back to buffered reads.
+     *
+     * @return true if the file was mapped
+     */
+    bool map();
+
+    /**
+     * Releases the memory mapping (if any)
+     */
+    void unmap();
     
     
 #pragma mark -
@@ -118,7 +158,9 @@ public:
      * the heap, use one of the static constructors instead.
      */
     BinaryReader() : _name(""), _stream(nullptr), _ssize(-1), _scursor(-1),
-                     _buffer(nullptr), _capacity(0), _bufoff(-1), _bufsize(0) {}
+                     _buffer(nullptr), _capacity(0), _bufoff(-1), _bufsize(0),
+                     _mapped(false), _mapping(nullptr), _maphandle(nullptr),
+                     _little(false), _swap(SDL_BYTEORDER == SDL_LIL_ENDIAN) {}
     
     /**
      * Deletes this reader and all of its resources.
@@ -188,6 +230,43 @@ public:
      * @return true if the reader is initialized properly, false otherwise.
      */
     bool initWithAsset(const std::string file, unsigned int capacity);
+
+    /**
+     * Initializes a memory-mapped reader for the given file.
+     *
+     * A memory-mapped reader has no transfer buffer. Instead, all reads come
+     * directly from a mapping of the file, and {@link readSpan} can return
+     * pointers into the file with no copy at all. If the file cannot be
+     * mapped, this reader falls back to buffered reads.
+     *
+     * If the file is a relative path, this reader will look for the file in
+     * the application save directory {@see Application#getSaveDirectory()}.
+     * If you wish to read a file in any other directory, you must provide
+     * an absolute path.
+     *
+     * @param file  the path (absolute or relative) to the file
+     *
+     * @return true if the reader is initialized properly, false otherwise.
+     */
+    bool initMapped(const std::string file);
+
+    /**
+     * Initializes a memory-mapped reader for the given file.
+     *
+     * A memory-mapped reader has no transfer buffer. Instead, all reads come
+     * directly from a mapping of the file, and {@link readSpan} can return
+     * pointers into the file with no copy at all. If the file cannot be
+     * mapped, this reader falls back to buffered reads.
+     *
+     * This initializer assumes that the file name is a relative path. It will
+     * search the application assert directory {@see Application#getAssetDirectory()}
+     * for the file and return false if it cannot find it there.
+     *
+     * @param file  the relative path to the file
+     *
+     * @return true if the reader is initialized properly, false otherwise.
+     */
+    bool initMappedWithAsset(const std::string file);
     
     
 #pragma mark -
@@ -266,6 +345,49 @@ public:
         std::shared_ptr<BinaryReader> result = std::make_shared<BinaryReader>();
         return (result->initWithAsset(file,capacity) ? result : nullptr);
     }
+
+    /**
+     * Returns a newly allocated memory-mapped reader for the given file.
+     *
+     * A memory-mapped reader has no transfer buffer. Instead, all reads come
+     * directly from a mapping of the file, and {@link readSpan} can return
+     * pointers into the file with no copy at all. If the file cannot be
+     * mapped, this reader falls back to buffered reads.
+     *
+     * If the file is a relative path, this reader will look for the file in
+     * the application save directory {@see Application#getSaveDirectory()}.
+     * If you wish to read a file in any other directory, you must provide
+     * an absolute path.
+     *
+     * @param file  the path (absolute or relative) to the file
+     *
+     * @return a newly allocated memory-mapped reader for the given file.
+     */
+    static std::shared_ptr<BinaryReader> allocMapped(const std::string file) {
+        std::shared_ptr<BinaryReader> result = std::make_shared<BinaryReader>();
+        return (result->initMapped(file) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated memory-mapped reader for the given file.
+     *
+     * A memory-mapped reader has no transfer buffer. Instead, all reads come
+     * directly from a mapping of the file, and {@link readSpan} can return
+     * pointers into the file with no copy at all. If the file cannot be
+     * mapped, this reader falls back to buffered reads.
+     *
+     * This initializer assumes that the file name is a relative path. It will
+     * search the application assert directory {@see Application#getAssetDirectory()}
+     * for the file and return false if it cannot find it there.
+     *
+     * @param file  the relative path to the file
+     *
+     * @return a newly allocated memory-mapped reader for the given file.
+     */
+    static std::shared_ptr<BinaryReader> allocMappedWithAsset(const std::string file) {
+        std::shared_ptr<BinaryReader> result = std::make_shared<BinaryReader>();
+        return (result->initMappedWithAsset(file) ? result : nullptr);
+    }
     
     
 #pragma mark -
@@ -297,6 +419,64 @@ public:
      * @return true if there is enough data left to read
      */
     bool ready(unsigned int bytes=1) const;
+
+    /**
+     * Returns true if this reader is a memory mapping of the file
+     *
+     * A reader may not be mapped, even if it was initialized as such, if the
+     * platform could not map the file.
+     *
+     * @return true if this reader is a memory mapping of the file
+     */
+    bool isMapped() const { return _mapped; }
+
+    /**
+     * Returns the size of the file in bytes
+     *
+     * This value is 0 if the stream is closed.
+     *
+     * @return the size of the file in bytes
+     */
+    size_t getSize() const { return _stream && _ssize > 0 ? (size_t)_ssize : 0; }
+
+#pragma mark -
+#pragma mark Byte Order
+    /**
+     * Returns true if the file is stored in little-endian order
+     *
+     * By default, files are in network (big-endian) order, which is the
+     * order written by {@link BinaryWriter}. Files produced by other tools
+     * are often little-endian, which matches most hosts. When the file order
+     * matches the host, no values are byte swapped at all.
+     *
+     * @return true if the file is stored in little-endian order
+     */
+    bool isLittleEndian() const { return _little; }
+
+    /**
+     * Sets whether the file is stored in little-endian order
+     *
+     * By default, files are in network (big-endian) order, which is the
+     * order written by {@link BinaryWriter}. Files produced by other tools
+     * are often little-endian, which matches most hosts. When the file order
+     * matches the host, no values are byte swapped at all.
+     *
+     * @param value Whether the file is stored in little-endian order
+     */
+    void setLittleEndian(bool value) {
+        _little = value;
+        _swap = (value != (SDL_BYTEORDER == SDL_LIL_ENDIAN));
+    }
+
+    /**
+     * Returns true if the file byte order matches the host
+     *
+     * If this value is true, then {@link readSpan} may return typed pointers
+     * directly into the file.
+     *
+     * @return true if the file byte order matches the host
+     */
+    bool isNativeOrder() const { return !_swap; }
     
     
 #pragma mark -
@@ -561,6 +741,59 @@ public:
      * @return the number of doubles read from the stream
      */
     size_t read(double* buffer, size_t maximum, size_t offset=0);
+
+#pragma mark -
+#pragma mark Zero-Copy Reads
+    /**
+     * Returns a pointer to the next bytes of the stream, advancing past them.
+     *
+     * For a memory-mapped reader, this is a pointer into the mapping, and is
+     * valid until the reader is closed. Otherwise, it is a pointer into the
+     * transfer buffer, and is only valid until the next read. In that case,
+     * the request cannot be larger than the buffer capacity.
+     *
+     * This method returns nullptr (and does not advance) if there are too few
+     * bytes remaining.
+     *
+     * @param bytes The number of bytes to read
+     *
+     * @return a pointer to the next bytes of the stream
+     */
+    const Uint8* readBytes(size_t bytes);
+
+    /**
+     * Returns a pointer to the next elements of the stream, advancing past them.
+     *
+     * This method is the typed version of {@link readBytes}, and has the same
+     * lifetime rules. As no data is copied, no data is byte swapped either.
+     * Therefore this method returns nullptr (and does not advance) if the file
+     * byte order does not match the host (for multibyte types), if the data is
+     * not aligned for the type, or if there are too few elements remaining.
+     * For a buffered reader, it also returns nullptr if the request is larger
+     * than the buffer capacity. Use {@link read} in any of these cases.
+     *
+     * @param count The number of elements to read
+     *
+     * @return a pointer to the next elements of the stream
+     */
+    template <typename T>
+    const T* readSpan(size_t count) {
+        static_assert(std::is_arithmetic<T>::value, "Spans are only supported for numeric types");
+        if ((sizeof(T) > 1 && _swap) || !ready((unsigned int)(count*sizeof(T)))) {
+            return nullptr;
+        }
+        if (!_mapped) {
+            if (count*sizeof(T) > _capacity) {
+                return nullptr;
+            }
+            fill((unsigned int)(count*sizeof(T)));
+        }
+        const Uint8* data = (const Uint8*)(_buffer+_bufoff);
+        if (((uintptr_t)data) % alignof(T) != 0) {
+            return nullptr;
+        }
+        return (const T*)readBytes(count*sizeof(T));
+    }
 };
 
 }
@@ -6,6 +6,11 @@
 //  It does not require that the entire file conform to JSON standards; it can
 //  read a JSON string embedded in a larger text file.
 //
+//  In addition to building a JsonValue (or JsonDocument), this reader has an
+//  event-driven interface for very large files. This interface reports each
+//  node to a JsonHandler as it is read, directly from the stream buffer, so
+//  the memory used is bounded by the nesting depth and the longest string.
+//
 //  By default, this module (and every module in the io package) accesses the
 //  application save directory.  If you want to access another directory, you
 //  will need to specify an absolute path for the file name.  Keep in mind that
@@ -50,9 +55,133 @@
 #define __CU_JSON_READER_H__
 #include <cugl/io/CUTextReader.h>
 #include <cugl/assets/CUJsonValue.h>
+#include <cugl/assets/CUJsonDocument.h>
 
 namespace  cugl {
 
+/**
+ * This class is a receiver for the events of {@link JsonReader#readEvents}.
+ *
+ * The reader calls these methods in document order as it reads the JSON.
+ * Object members are reported as a call to {@link key} followed by the events
+ * for the value. Every method returns true to continue reading. Returning
+ * false stops the reader immediately.
+ *
+ * The default implementation of every method ignores the event, so a
+ * subclass only needs to override the events that it cares about.
+ *
+ * Long numeric arrays (such as tile layers) are reported in batches with
+ * {@link numbers}. By default, this method calls {@link number} for each
+ * value in the batch. Override it to process the values directly.
+ */
+class JsonHandler {
+public:
+    /**
+     * Deletes this handler, disposing all resources
+     */
+    virtual ~JsonHandler() {}
+
+    /**
+     * Called when the reader starts an object
+     *
+     * @return true to continue reading
+     */
+    virtual bool startObject() { return true; }
+
+    /**
+     * Called when the reader finishes an object
+     *
+     * @return true to continue reading
+     */
+    virtual bool endObject() { return true; }
+
+    /**
+     * Called when the reader starts an array
+     *
+     * @return true to continue reading
+     */
+    virtual bool startArray() { return true; }
+
+    /**
+     * Called when the reader finishes an array
+     *
+     * @return true to continue reading
+     */
+    virtual bool endArray() { return true; }
+
+    /**
+     * Called when the reader reads the key of an object member
+     *
+     * The string is only valid for the duration of this call.
+     *
+     * @param key   The member key
+     *
+     * @return true to continue reading
+     */
+    virtual bool key(const std::string& key) { return true; }
+
+    /**
+     * Called when the reader reads a null value
+     *
+     * @return true to continue reading
+     */
+    virtual bool null() { return true; }
+
+    /**
+     * Called when the reader reads a boolean value
+     *
+     * @param value The boolean value
+     *
+     * @return true to continue reading
+     */
+    virtual bool boolean(bool value) { return true; }
+
+    /**
+     * Called when the reader reads a number
+     *
+     * Numbers in arrays are reported with {@link numbers} instead.
+     *
+     * @param value The numeric value
+     *
+     * @return true to continue reading
+     */
+    virtual bool number(double value) { return true; }
+
+    /**
+     * Called when the reader reads a run of numbers in an array
+     *
+     * The numbers are consecutive elements of the current array. A long run
+     * may be split across several calls. The array is only valid for the
+     * duration of this call.
+     *
+     * By default, this method calls {@link number} for each value.
+     *
+     * @param values    The numeric values
+     * @param size      The number of values
+     *
+     * @return true to continue reading
+     */
+    virtual bool numbers(const double* values, size_t size) {
+        for(size_t ii = 0; ii < size; ii++) {
+            if (!number(values[ii])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Called when the reader reads a string value
+     *
+     * The string is only valid for the duration of this call.
+     *
+     * @param value The string value
+     *
+     * @return true to continue reading
+     */
+    virtual bool string(const std::string& value) { return true; }
+};
+
 /**
  * Simple JSON extension to {@link TextReader}.
  *
@@ -68,7 +197,56 @@ namespace  cugl {
  * confine all files to either the asset or the save directory.
  */
 class JsonReader : public TextReader {
-    
+private:
+    /**
+     * Returns the next character in the stream without consuming it
+     *
+     * This method refills the buffer as necessary.
+     *
+     * @return the next character in the stream, or -1 at the end
+     */
+    int peekChar();
+
+    /**
+     * Skips over any whitespace in the stream
+     *
+     * Unlike {@link TextReader#skip}, this method is safe at the end of the
+     * stream.
+     *
+     * @return the next non-whitespace character, or -1 at the end
+     */
+    int skipSpace();
+
+    /**
+     * Reads a string (including the quotes) into the given buffer
+     *
+     * Escape sequences are decoded as they are read.
+     *
+     * @param data  The buffer to store the string
+     *
+     * @return true if the string was read successfully
+     */
+    bool readQuoted(std::string& data);
+
+    /**
+     * Reads a number into the given value
+     *
+     * @param token The scratch buffer for the number text
+     * @param value The value to store the number
+     *
+     * @return true if the number was read successfully
+     */
+    bool readNumber(std::string& token, double& value);
+
+    /**
+     * Reads the given literal (e.g. "true") from the stream
+     *
+     * @param word  The literal to read
+     *
+     * @return true if the literal was read successfully
+     */
+    bool readLiteral(const char* word);
+
 #pragma mark -
 #pragma mark Static Constructors
 public:
@@ -178,6 +356,46 @@ public:
      * @return a newly allocated JsonValue for the next available JSON string.
      */
     std::shared_ptr<JsonValue> readJson();
+
+    /**
+     * Returns a newly allocated JsonDocument for the next available JSON string.
+     *
+     * This method uses {@link readJsonString()} to extract the next available
+     * JSON string and constructs a JsonDocument from that. The document takes
+     * ownership of the string, so it is not copied. This is the preferred way
+     * to read large, read-only files such as levels.
+     *
+     * If there is a parsing error, this  method will return nullptr.  Detailed
+     * information about the parsing error will be passed to an assert.  Hence
+     * error messages are suppressed if asserts are turned off.
+     *
+     * @return a newly allocated JsonDocument for the next available JSON string.
+     */
+    std::shared_ptr<JsonDocument> readDocument();
+
+    /**
+     * Reads the next available JSON value, reporting it to the given handler.
+     *
+     * Unlike {@link readJson}, this method does not build a tree. Each node
+     * is reported to the handler as it is read, straight from the stream
+     * buffer. The memory used is bounded by the nesting depth, the longest
+     * string, and the batch size for numeric arrays. This is the preferred
+     * way to visit a very large file (such as a tile map or replay) once.
+     *
+     * The value must be an object or an array. This method will skip over
+     * any whitespace to find it. It stops after the closing brace or bracket,
+     * so a stream may contain several values in sequence.
+     *
+     * If there is a parsing error, this method will return false.  Detailed
+     * information about the parsing error will be passed to an assert.  Hence
+     * error messages are suppressed if asserts are turned off. This method
+     * also returns false if the handler stops the reader early.
+     *
+     * @param handler   The receiver for the parsing events
+     *
+     * @return true if the value was read completely
+     */
+    bool readEvents(JsonHandler& handler);
     
 };
 
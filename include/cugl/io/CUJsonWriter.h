@@ -68,6 +68,10 @@ namespace cugl {
  * confine all files to either the asset or the save directory.
  */
 class JsonWriter : public TextWriter {
+private:
+    /** The encoding buffer (reused so that writes do not allocate) */
+    std::string _encoding;
+
 #pragma mark -
 #pragma mark Static Constructors
 public:
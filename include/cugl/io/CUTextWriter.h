@@ -50,10 +50,17 @@
 #define __CU_TEXT_WRITER_H__
 #include <cugl/base/CUBase.h>
 #include <cugl/util/CUStrings.h>
+#include <condition_variable>
+#include <atomic>
 #include <string>
+#include <vector>
+#include <mutex>
 
 namespace cugl {
 
+/** Forward reference to the background flush thread */
+class ThreadPool;
+
 /**
  * Simple text-based writer for ASCII or UTF8 files.
  *
@@ -67,6 +74,13 @@ namespace cugl {
  * for the file name.  Keep in mind that absolute paths are very dangerous on
  * mobile devices, because they do not have proper file systems.  You should
  * confine all files to either the asset or the save directory.
+ *
+ * By default, the buffer is flushed on the calling thread. A writer used
+ * during gameplay (e.g. for logging) should instead be made asynchronous
+ * with {@link setAsync}. An asynchronous writer is double buffered: a full
+ * buffer is handed to a background thread, and writing continues into the
+ * other buffer. The writer only blocks if it fills its buffer before the
+ * background thread is done with the previous one.
  */
 class TextWriter {
 protected:
@@ -81,6 +95,42 @@ protected:
     Uint32      _capacity;
     /** The current offset in the writer buffer */
     Sint32      _bufoff;
+
+    /** Whether this writer flushes on a background thread */
+    bool        _async;
+    /** The buffer being written by the background thread */
+    char*       _backbuffer;
+    /** The number of bytes in the back buffer (0 if it is free) */
+    Uint32      _backsize;
+    /** The time between automatic flushes in milliseconds (0 for none) */
+    Uint32      _interval;
+    /** Whether the flush interval has expired */
+    std::atomic<bool> _expired;
+    /** Whether the background thread should exit */
+    bool        _halt;
+    /** The background flush thread (if asynchronous) */
+    std::shared_ptr<ThreadPool> _worker;
+    /** The mutex guarding the back buffer */
+    std::mutex  _mutex;
+    /** The condition signaling a change to the back buffer */
+    std::condition_variable _ready;
+
+    /**
+     * Writes the back buffer to the file until the writer halts
+     *
+     * This is the loop of the background flush thread.
+     */
+    void backflush();
+
+    /**
+     * Starts the background flush thread
+     */
+    void startWorker();
+
+    /**
+     * Stops the background flush thread, writing any pending data
+     */
+    void stopWorker();
     
 #pragma mark -
 #pragma mark Constructors
@@ -91,7 +141,9 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
      * the heap, use one of the static constructors instead.
      */
-    TextWriter() : _name(""), _stream(nullptr), _cbuffer(nullptr), _bufoff(-1) {}
+    TextWriter() : _name(""), _stream(nullptr), _cbuffer(nullptr), _bufoff(-1),
+    _async(false), _backbuffer(nullptr), _backsize(0), _interval(0),
+    _expired(false), _halt(false) {}
 
     /**
      * Deletes this writer and all of its resources.
@@ -184,8 +236,22 @@ public:
      *
      * It is usually unnecessary to call this method. It is called automatically
      * when the buffer fills, or just before the file is closed.
+     *
+     * If the writer is asynchronous, this method hands the buffer to the
+     * background thread and returns immediately (unless the thread is still
+     * writing the previous buffer). Use {@link sync} to wait for the data
+     * to reach the file.
      */
     void flush();
+
+    /**
+     * Flushes the contents of the write buffer, waiting until it is written
+     *
+     * For a synchronous writer, this is the same as {@link flush}. For an
+     * asynchronous writer, this blocks until the background thread has
+     * written every buffered byte to the file.
+     */
+    void sync();
     
     /**
      * Closes the stream, releasing all resources
@@ -193,9 +259,65 @@ public:
      * The contents of the buffer are flushed before the file is closed.  Any 
      * attempts to write to a closed stream will fail.  Calling this method
      * on a previously closed stream has no effect.
+     *
+     * If the writer is asynchronous, this method waits for the background
+     * thread to write all pending data.
      */
     void close();
 
+    /**
+     * Returns true if this writer flushes on a background thread
+     *
+     * An asynchronous writer is double buffered. A full buffer is handed to
+     * a background thread, and writing continues into the other buffer. The
+     * writer only blocks if it fills its buffer before the background thread
+     * is done with the previous one. By default, a writer is synchronous.
+     *
+     * @return true if this writer flushes on a background thread
+     */
+    bool isAsync() const { return _async; }
+
+    /**
+     * Sets whether this writer flushes on a background thread
+     *
+     * An asynchronous writer is double buffered. A full buffer is handed to
+     * a background thread, and writing continues into the other buffer. The
+     * writer only blocks if it fills its buffer before the background thread
+     * is done with the previous one. By default, a writer is synchronous.
+     *
+     * Making an asynchronous writer synchronous waits for all pending data
+     * to be written.
+     *
+     * @param value Whether this writer flushes on a background thread
+     */
+    void setAsync(bool value);
+
+    /**
+     * Returns the time between automatic flushes, in milliseconds
+     *
+     * This value only applies to asynchronous writers. If it is positive,
+     * any data written is flushed once the interval passes, even if the
+     * buffer is not full. The flush happens on the next write after the
+     * interval passes. If it is 0 (the default), data is only written when
+     * the buffer is full, on an explicit flush, or when the file is closed.
+     *
+     * @return the time between automatic flushes, in milliseconds
+     */
+    Uint32 getFlushInterval() const { return _interval; }
+
+    /**
+     * Sets the time between automatic flushes, in milliseconds
+     *
+     * This value only applies to asynchronous writers. If it is positive,
+     * any data written is flushed once the interval passes, even if the
+     * buffer is not full. The flush happens on the next write after the
+     * interval passes. If it is 0 (the default), data is only written when
+     * the buffer is full, on an explicit flush, or when the file is closed.
+     *
+     * @param millis    The time between automatic flushes, in milliseconds
+     */
+    void setFlushInterval(Uint32 millis);
+
 
 #pragma mark -
 #pragma mark Primitive Methods
@@ -351,18 +473,31 @@ public:
      *
      * @param s  the string to write
      */
-    void write(const std::string s);
+    void write(const std::string& s);
     
     /**
      * Writes a string (ASCII or UTF8) to the file, followed by a newline
      *
      * The newline used is a standard Unix newline '\\n'. You should not expect
      * Windows-style carriage returns (e.g. '\\r'). This method automatically
-     * flushes the buffer when done.
+     * flushes the buffer when done, unless the writer is asynchronous. An
+     * asynchronous writer relies on the flush interval instead, so that each
+     * line does not wait on the background thread.
      *
      * @param s  the string to write
      */
-    void writeLine(const std::string s);
+    void writeLine(const std::string& s);
+
+    /**
+     * Writes a sequence of strings (ASCII or UTF8) to the file, each followed by a newline
+     *
+     * The newline used is a standard Unix newline '\\n'. The buffer is flushed
+     * at most once for the entire batch (as with {@link writeLine}), instead
+     * of once per line.
+     *
+     * @param lines  the strings to write
+     */
+    void writeLines(const std::vector<std::string>& lines);
     
 };
 
@@ -34,5 +34,6 @@
 #include "CUJsonWriter.h"
 #include "CUBinaryReader.h"
 #include "CUBinaryWriter.h"
+#include "CUAssetBundle.h"
 
 #endif /* __CU_IO_PKG_H__ */
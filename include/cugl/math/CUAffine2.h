@@ -1057,6 +1057,45 @@ public:
      */
     static float* transform(const Affine2& aff, float const* input, float* output, size_t size);
 
+    /**
+     * Transforms the strided vector array, and stores the result in dst.
+     *
+     * The vector is array is treated as a list of 2 element vectors (@see Vec2),
+     * where consecutive vectors are stride floats apart. This allows the method
+     * to transform the positions of interleaved vertex data in place, such as
+     * an array of {@link SpriteVertex2}. Floats between the vectors are left
+     * untouched. The input and output may be the same array.
+     *
+     * This method uses the vectorized algorithm, if available.
+     *
+     * @param aff       The transform matrix.
+     * @param input     The array of vectors to transform.
+     * @param output    The array to store the transformed vectors.
+     * @param size      The number of vectors in the two arrays.
+     * @param stride    The number of floats from one vector to the next
+     *
+     * @return A reference to dst for chaining
+     */
+    static float* transform(const Affine2& aff, float const* input, float* output,
+                            size_t size, size_t stride);
+
+    /**
+     * Transforms the point array, and stores the result in output.
+     *
+     * The transform is applied in order and written to the output array. The
+     * input and output may be the same array.
+     *
+     * This method uses the vectorized algorithm, if available.
+     *
+     * @param aff       The transform matrix.
+     * @param input     The array of points to transform.
+     * @param output    The array to store the transformed points.
+     * @param size      The size of the two arrays.
+     *
+     * @return A reference to output for chaining
+     */
+    static Vec2* transform(const Affine2& aff, const Vec2* input, Vec2* output, size_t size);
+
     /**
      * Transforms the rectangle and stores the result in dst.
      *
@@ -764,6 +764,24 @@ public:
         }
         return *this;
     }
+
+    /**
+     * Premultiplies the color array, and stores the result in output.
+     *
+     * Each color is premultiplied with its own alpha, which is unchanged.
+     * This class does not store whether a color is already premultiplied.
+     * Hence premultiplying an already premultiplied color will have a
+     * compounding effect. The input and output may be the same array.
+     *
+     * This method uses the vectorized algorithm, if available.
+     *
+     * @param input     The array of colors to premultiply.
+     * @param output    The array to store the premultiplied colors.
+     * @param size      The size of the two arrays.
+     *
+     * @return A reference to output for chaining
+     */
+    static Color4f* premultiply(const Color4f* input, Color4f* output, size_t size);
     
     /**
      * Interpolates the two colors c1 and c2, and stores the result in dst.
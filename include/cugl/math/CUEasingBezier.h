@@ -75,6 +75,8 @@ protected:
     
     /** The rootset of the polynomial x-component (cached for efficiency). */
     std::vector<float> _rootset;
+    /** The lookup table approximating this function (built on initialization) */
+    std::vector<float> _table;
      
     /**
      * Stores the roots of a x^2 + b x + c into the rootset.
@@ -100,6 +102,18 @@ protected:
      * @param d The constant factor
      */
     void solveCubicEquation(float a, float b, float c, float d);
+
+    /**
+     * Returns the bezier parameter for the given x-coordinate.
+     *
+     * The parameter is chosen from the roots of the x-component polynomial,
+     * preferring the first root in [0,1].
+     *
+     * @param x The x-coordinate (e.g. the time)
+     *
+     * @return the bezier parameter for the given x-coordinate.
+     */
+    float solveParameter(float x);
    
     
 #pragma mark -
@@ -262,6 +276,53 @@ public:
      * @return a pointer to the function represented by this object.
      */
     std::function<float(float)> getEvaluator();
+
+    /**
+     * Returns the lookup table approximation of the easing function at t.
+     *
+     * The lookup table has {@link EASING_TABLE_SIZE} intervals and is built
+     * when this function is initialized. It uses monotone cubic interpolation,
+     * so it does not overshoot between samples. If cubic is false, it uses
+     * linear interpolation instead. Unlike {@link evaluate}, this method does
+     * not solve the cubic polynomial, and so it is safe to call from multiple
+     * threads.
+     *
+     * The value t is clamped to [0,1].
+     *
+     * @param t     The time to evaluate
+     * @param cubic Whether to use cubic (as opposed to linear) interpolation
+     *
+     * @return the lookup table approximation of the easing function at t.
+     */
+    float lookup(float t, bool cubic = true) const;
+
+    /**
+     * Evaluates the lookup table approximation of this function on an array.
+     *
+     * This is the batched alternative to {@link lookup}. It evaluates four times
+     * at once when vectorization is enabled. The input and output arrays
+     * may be the same.
+     *
+     * The times are clamped to [0,1].
+     *
+     * @param input     The times to adjust
+     * @param output    The array to store the adjusted times
+     * @param count     The number of times to adjust
+     * @param cubic     Whether to use cubic (as opposed to linear) interpolation
+     */
+    void evaluateLookup(const float* input, float* output, size_t count, bool cubic = true) const;
+
+    /**
+     * Returns a pointer to the lookup table approximation of this function.
+     *
+     * The function retains a shared pointer to the object, so the object
+     * reference can be safely discarded after getting the function pointer.
+     *
+     * @param cubic Whether to use cubic (as opposed to linear) interpolation
+     *
+     * @return a pointer to the lookup table approximation of this function.
+     */
+    std::function<float(float)> getLookup(bool cubic = true);
     
 };
     
@@ -40,6 +40,8 @@
 
 /** The period for the elastic easing functions */
 #define ELASTIC_PERIOD 0.3f
+/** The number of intervals in an easing lookup table */
+#define EASING_TABLE_SIZE 256
 
 namespace cugl {
     
@@ -150,6 +152,85 @@ public:
      */
     static std::function<float(float)> alloc(Type type, float period = ELASTIC_PERIOD);
 
+    /**
+     * Evaluates an easing function of the given type on an array of times.
+     *
+     * This is the batched alternative to {@link alloc}. The type is resolved
+     * once for the whole array, and the easing function is applied in a tight
+     * loop that the compiler is free to vectorize. It is much faster than
+     * calling a function value once per tween. The input and output arrays
+     * may be the same.
+     *
+     * The optional value period only applies to elastic easing functions, as
+     * their bounce factor is adjustable.
+     *
+     * @param type      The easing function type
+     * @param input     The times to adjust
+     * @param output    The array to store the adjusted times
+     * @param count     The number of times to adjust
+     * @param period    The period of an elastic easing function
+     */
+    static void evaluate(Type type, const float* input, float* output, size_t count,
+                         float period = ELASTIC_PERIOD);
+
+    /**
+     * Returns the lookup table approximation of an easing function at time.
+     *
+     * Each easing type has a lookup table of {@link EASING_TABLE_SIZE} intervals,
+     * built on first use. The table uses monotone cubic interpolation, so it does
+     * not overshoot between samples. If cubic is false, it uses linear
+     * interpolation instead, which is faster but less smooth. Either way, this
+     * avoids the transcendental functions in types like elastic, expo or sine.
+     *
+     * The time is clamped to [0,1]. Elastic tables use the default period
+     * {@link ELASTIC_PERIOD}.
+     *
+     * @param type      The easing function type
+     * @param time      The time to adjust
+     * @param cubic     Whether to use cubic (as opposed to linear) interpolation
+     *
+     * @return the lookup table approximation of an easing function at time.
+     */
+    static float lookup(Type type, float time, bool cubic = true);
+
+    /**
+     * Returns the lookup table approximation of an easing function.
+     *
+     * Each easing type has a lookup table of {@link EASING_TABLE_SIZE} intervals,
+     * built on first use. The table uses monotone cubic interpolation, so it does
+     * not overshoot between samples. If cubic is false, it uses linear
+     * interpolation instead, which is faster but less smooth. Either way, this
+     * avoids the transcendental functions in types like elastic, expo or sine.
+     *
+     * The returned function clamps its time to [0,1]. Elastic tables use the
+     * default period {@link ELASTIC_PERIOD}.
+     *
+     * @param type      The easing function type
+     * @param cubic     Whether to use cubic (as opposed to linear) interpolation
+     *
+     * @return the lookup table approximation of an easing function.
+     */
+    static std::function<float(float)> allocLookup(Type type, bool cubic = true);
+
+    /**
+     * Evaluates the lookup table approximation of an easing function on an array.
+     *
+     * This is the batched alternative to {@link lookup}. It evaluates four times
+     * at once when vectorization is enabled. The input and output arrays
+     * may be the same.
+     *
+     * The times are clamped to [0,1]. Elastic tables use the default period
+     * {@link ELASTIC_PERIOD}.
+     *
+     * @param type      The easing function type
+     * @param input     The times to adjust
+     * @param output    The array to store the adjusted times
+     * @param count     The number of times to adjust
+     * @param cubic     Whether to use cubic (as opposed to linear) interpolation
+     */
+    static void evaluateLookup(Type type, const float* input, float* output, size_t count,
+                               bool cubic = true);
+
     /**
      * Returns an adjustment of the tweening time
      *
@@ -508,6 +589,19 @@ public:
      */
     static float elasticInOut(float time, float period);
     
+private:
+    /**
+     * Returns the lookup table for the given easing type.
+     *
+     * The table is built (in a thread-safe way) the first time it is requested.
+     * It is {@link EASING_TABLE_SIZE} rows of four cubic coefficients.
+     *
+     * @param type      The easing function type
+     *
+     * @return the lookup table for the given easing type.
+     */
+    static const float* getTable(Type type);
+    
 };
 
 }
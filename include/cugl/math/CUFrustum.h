@@ -309,6 +309,66 @@ public:
      */
     Region findBox(float x, float y, float z, float halfWidth, float halfHeight, float halfDepth);
     
+#pragma mark -
+#pragma mark Batch Culling
+    /**
+     * Stores the visibility of an array of bounding boxes in the given mask.
+     *
+     * The boxes are given in structure-of-arrays form: each box ii is centered
+     * at (x[ii],y[ii],z[ii]) with half extents (hx[ii],hy[ii],hz[ii]). Bit
+     * ii%32 of mask[ii/32] is set if box ii is not entirely outside of this
+     * frustum. So the mask must have room for (count+31)/32 values. Boxes are
+     * tested four at a time when vectorization is enabled.
+     *
+     * Like {@link findBox}, this test is conservative. A box that straddles
+     * two planes near a corner may be reported as visible even though it is
+     * outside.
+     *
+     * If nearfar is false, the boxes are not tested against the near and far
+     * clipping planes. This is useful for 2d scenes, where the depth of
+     * the content is not meaningful.
+     *
+     * @param x         The x-coordinates of the box centers
+     * @param y         The y-coordinates of the box centers
+     * @param z         The z-coordinates of the box centers
+     * @param hx        The half widths (x-axis) of the boxes
+     * @param hy        The half heights (y-axis) of the boxes
+     * @param hz        The half depths (z-axis) of the boxes
+     * @param count     The number of boxes
+     * @param mask      The bitmask to store the visibility
+     * @param nearfar   Whether to test the near and far clipping planes
+     *
+     * @return the number of visible boxes
+     */
+    size_t cullBoxes(const float* x, const float* y, const float* z,
+                     const float* hx, const float* hy, const float* hz,
+                     size_t count, Uint32* mask, bool nearfar=true) const;
+
+    /**
+     * Stores the visibility of an array of spheres in the given mask.
+     *
+     * The spheres are given in structure-of-arrays form: each sphere ii is
+     * centered at (x[ii],y[ii],z[ii]) with the given radius[ii]. Bit ii%32
+     * of mask[ii/32] is set if sphere ii is not entirely outside of this
+     * frustum. So the mask must have room for (count+31)/32 values. Spheres
+     * are tested four at a time when vectorization is enabled.
+     *
+     * If nearfar is false, the spheres are not tested against the near and
+     * far clipping planes, as in {@link findSphereWithoutNearFar}.
+     *
+     * @param x         The x-coordinates of the sphere centers
+     * @param y         The y-coordinates of the sphere centers
+     * @param z         The z-coordinates of the sphere centers
+     * @param radius    The sphere radii
+     * @param count     The number of spheres
+     * @param mask      The bitmask to store the visibility
+     * @param nearfar   Whether to test the near and far clipping planes
+     *
+     * @return the number of visible spheres
+     */
+    size_t cullSpheres(const float* x, const float* y, const float* z, const float* radius,
+                       size_t count, Uint32* mask, bool nearfar=true) const;
+    
 };
     
 }
@@ -961,6 +961,25 @@ public:
      * @return A reference to dst for chaining
      */
     static float* multiply(const float* m1, const float* m2, float* dst);
+
+    /**
+     * Multiplies each matrix in the input array by mat and stores the results.
+     *
+     * The matrix mat is on the right of each product. This means that it is
+     * applied as a subsequent transform to every matrix in the array, such
+     * as when a single parent transform is combined with many children. The
+     * input and output may be the same array.
+     *
+     * This method uses the vectorized algorithm, if available.
+     *
+     * @param input     The array of matrices to multiply.
+     * @param mat       The matrix to multiply on the right.
+     * @param output    The array to store the products.
+     * @param size      The size of the two arrays.
+     *
+     * @return A reference to output for chaining
+     */
+    static Mat4* multiply(const Mat4* input, const Mat4& mat, Mat4* output, size_t size);
     
     /**
      * Negates m1 and stores the result in dst.
@@ -1632,6 +1651,80 @@ public:
      */
     static float* transform(const float* mat, float const* input, float* output, size_t size);
 
+    /**
+     * Transforms the strided vector array by the given matrix, and stores the result in dst.
+     *
+     * The vector is array is treated as a list of 4 element vectors (@see Vec4),
+     * where consecutive vectors are stride floats apart. Floats between the
+     * vectors are left untouched. The float array for the matrix should be in
+     * column major order. The input and output may be the same array.
+     *
+     * This method uses the vectorized algorithm, if available.
+     *
+     * @param mat       The transform matrix in column major order
+     * @param input     The array of vectors to transform.
+     * @param output    The array to store the transformed vectors.
+     * @param size      The number of vectors in the two arrays.
+     * @param stride    The number of floats from one vector to the next
+     *
+     * @return A reference to dst for chaining
+     */
+    static float* transform(const float* mat, float const* input, float* output,
+                            size_t size, size_t stride);
+
+    /**
+     * Transforms the vector array by the given matrix, and stores the result in dst.
+     *
+     * The vectors are treated as is.  Hence whether or not translation is
+     * applied depends on the value of w. The input and output may be the
+     * same array.
+     *
+     * This method uses the vectorized algorithm, if available.
+     *
+     * @param mat       The transform matrix.
+     * @param input     The array of vectors to transform.
+     * @param output    The array to store the transformed vectors.
+     * @param size      The size of the two arrays.
+     *
+     * @return A reference to dst for chaining
+     */
+    static Vec4* transform(const Mat4& mat, const Vec4* input, Vec4* output, size_t size);
+
+    /**
+     * Transforms the point array by the given matrix, and stores the result in dst.
+     *
+     * The vectors are treated as points, which means that translation is
+     * applied to the result. The input and output may be the same array.
+     *
+     * This method uses the vectorized algorithm, if available.
+     *
+     * @param mat       The transform matrix.
+     * @param input     The array of points to transform.
+     * @param output    The array to store the transformed points.
+     * @param size      The size of the two arrays.
+     *
+     * @return A reference to dst for chaining
+     */
+    static Vec3* transform(const Mat4& mat, const Vec3* input, Vec3* output, size_t size);
+
+    /**
+     * Transforms the point array by the given matrix, and stores the result in dst.
+     *
+     * The vectors are treated as points in the plane z = 0, which means that
+     * translation is applied to the result. The input and output may be the
+     * same array.
+     *
+     * This method uses the vectorized algorithm, if available.
+     *
+     * @param mat       The transform matrix.
+     * @param input     The array of points to transform.
+     * @param output    The array to store the transformed points.
+     * @param size      The size of the two arrays.
+     *
+     * @return A reference to dst for chaining
+     */
+    static Vec2* transform(const Mat4& mat, const Vec2* input, Vec2* output, size_t size);
+
 
 #pragma mark -
 #pragma mark Vector Operations
@@ -45,6 +45,7 @@
 #define __CU_POLY2_H__
 
 #include <vector>
+#include <memory>
 #include <unordered_set>
 #include <cugl/math/CUVec2.h>
 #include <cugl/math/CURect.h>
@@ -117,7 +118,16 @@ public:
     std::vector<Vec2> vertices;
     /** The vector of indices in the triangulation */
     std::vector<Uint32> indices;
+
+private:
+    /** A bounding volume hierarchy for accelerating geometry queries */
+    class Hierarchy;
+    /** Whether to accelerate geometry queries with a bounding volume hierarchy */
+    bool _accelerate;
+    /** The cached hierarchy (built lazily, and shared by copies) */
+    mutable std::shared_ptr<Hierarchy> _tree;
     
+public:
 #pragma mark -
 #pragma mark Constructors
     /**
@@ -126,7 +136,7 @@ public:
      * The created polygon has no vertices and no triangulation. The bounding
      * box is trivial.
      */
-    Poly2() { }
+    Poly2() : _accelerate(false) { }
     
     /**
      * Creates a polygon with the given vertices
@@ -135,7 +145,7 @@ public:
      *
      * @param vertices  The vector of vertices (as Vec2) in this polygon
      */
-    Poly2(const std::vector<Vec2>& vertices) { set(vertices); }
+    Poly2(const std::vector<Vec2>& vertices) : _accelerate(false) { set(vertices); }
 
     /**
      * Creates a polygon with the given vertices
@@ -145,7 +155,9 @@ public:
      * @param vertices  The vector of vertices (as Vec2) in this polygon
      * @param vertsize  The number of elements to use from vertices
      */
-    Poly2(const Vec2* vertices, size_t vertsize) { set(vertices,vertsize); }
+    Poly2(const Vec2* vertices, size_t vertsize) : _accelerate(false) {
+        set(vertices,vertsize);
+    }
     
     /**
      * Creates a polygon with the given vertices and indices.
@@ -159,7 +171,8 @@ public:
      * @param vertices  The vector of vertices (as Vec2) in this polygon
      * @param indices   The vector of indices for the rendering
      */
-    Poly2(const std::vector<Vec2>& vertices, const std::vector<Uint32>& indices) {
+    Poly2(const std::vector<Vec2>& vertices, const std::vector<Uint32>& indices) :
+    _accelerate(false) {
         this->vertices = vertices;
         this->indices = indices;
     }
@@ -172,14 +185,15 @@ public:
      *
      * @param poly  The polygon to copy
      */
-    Poly2(const Poly2& poly) { set(poly); }
+    Poly2(const Poly2& poly) : _accelerate(false) { set(poly); }
 
     /**
      * Creates a copy with the resource of the given polygon.
      *
      * @param poly  The polygon to take from
      */
-    Poly2(Poly2&& poly) : vertices(std::move(poly.vertices)), indices(std::move(poly.indices)) {}
+    Poly2(Poly2&& poly) : vertices(std::move(poly.vertices)), indices(std::move(poly.indices)),
+    _accelerate(poly._accelerate), _tree(std::move(poly._tree)) {}
     
     /**
      * Creates a polygon for the given rectangle.
@@ -190,7 +204,7 @@ public:
      *
      * @param rect  The rectangle to copy
      */
-    Poly2(const Rect rect) { set(rect); }
+    Poly2(const Rect rect) : _accelerate(false) { set(rect); }
     
     /**
      * Creates a polygon from the given JsonValue
@@ -214,7 +228,7 @@ public:
      *
      * @param data      The JSON object specifying the polygon
      */
-    Poly2(const std::shared_ptr<JsonValue>& data) { set(data); }
+    Poly2(const std::shared_ptr<JsonValue>& data) : _accelerate(false) { set(data); }
     
     /**
      * Deletes the given polygon, freeing all resources.
@@ -247,6 +261,8 @@ public:
     Poly2& operator=(Poly2&& other) {
         vertices = std::move(other.vertices);
         indices  = std::move(other.indices);
+        _accelerate = other._accelerate;
+        _tree = std::move(other._tree);
         return *this;
     }
     
@@ -754,6 +770,53 @@ public:
     
 #pragma mark -
 #pragma mark Geometry Methods
+    /**
+     * Returns true if geometry queries on this polygon are accelerated.
+     *
+     * An accelerated polygon answers {@link #contains}, {@link #incident},
+     * {@link #getNearest} and {@link #intersects} with a bounding volume
+     * hierarchy over its triangles and boundary edges. This hierarchy is built
+     * on the first query, and is reused until this polygon changes, so these
+     * queries are O(log n) instead of O(n). It is off by default, as it is
+     * only worth the memory for large polygons that are queried repeatedly.
+     *
+     * The hierarchy is rebuilt automatically whenever this polygon is changed
+     * by one of its methods. However, because {@link #vertices} and
+     * {@link #indices} are public, it cannot detect when those values are
+     * modified in place. Call {@link #invalidate} after any such change.
+     *
+     * @return true if geometry queries on this polygon are accelerated.
+     */
+    bool isAccelerated() const { return _accelerate; }
+    
+    /**
+     * Sets whether geometry queries on this polygon are accelerated.
+     *
+     * An accelerated polygon answers {@link #contains}, {@link #incident},
+     * {@link #getNearest} and {@link #intersects} with a bounding volume
+     * hierarchy over its triangles and boundary edges. This hierarchy is built
+     * on the first query, and is reused until this polygon changes, so these
+     * queries are O(log n) instead of O(n). It is off by default, as it is
+     * only worth the memory for large polygons that are queried repeatedly.
+     *
+     * The hierarchy is rebuilt automatically whenever this polygon is changed
+     * by one of its methods. However, because {@link #vertices} and
+     * {@link #indices} are public, it cannot detect when those values are
+     * modified in place. Call {@link #invalidate} after any such change.
+     *
+     * @param value Whether to accelerate geometry queries
+     */
+    void setAccelerated(bool value);
+    
+    /**
+     * Discards any cached acceleration data for this polygon.
+     *
+     * This method must be called if {@link #vertices} or {@link #indices} are
+     * modified directly on an accelerated polygon. It is not necessary for
+     * changes made by the methods of this class.
+     */
+    void invalidate() { _tree = nullptr; }
+    
     /**
      * Returns the vertex indices forming the convex hull of this polygon.
      *
@@ -836,6 +899,34 @@ public:
      */
     bool incident(float x, float y, float err=CU_MATH_EPSILON) const;
 
+    /**
+     * Returns the point on the boundary of this polygon nearest the given one.
+     *
+     * The boundary consists of the triangle edges that are not shared by
+     * two triangles. If this polygon has no boundary (e.g. it has no indices),
+     * this method returns the point itself.
+     *
+     * @param point The point to check
+     *
+     * @return the point on the boundary of this polygon nearest the given one.
+     */
+    Vec2 getNearest(Vec2 point) const;
+    
+    /**
+     * Returns true if the given line segment crosses the boundary of this polygon.
+     *
+     * The boundary consists of the triangle edges that are not shared by
+     * two triangles. If hit is not null, it will store the boundary crossing
+     * that is closest to start.
+     *
+     * @param start The start of the line segment
+     * @param end   The end of the line segment
+     * @param hit   Optional pointer to store the first crossing
+     *
+     * @return true if the given line segment crosses the boundary of this polygon.
+     */
+    bool intersects(const Vec2& start, const Vec2& end, Vec2* hit=nullptr) const;
+
     /**
      * Returns the set of indices that are on a boundary of this polygon
      *
@@ -941,6 +1032,17 @@ private:
      */
     Vec3 getBarycentric(Vec2 point, Uint32 index) const;
 
+    /**
+     * Returns the acceleration hierarchy for this polygon.
+     *
+     * The hierarchy is built on demand. It is rebuilt if the size of the
+     * vertices or indices has changed since it was last built. This method
+     * returns nullptr if the polygon is not accelerated.
+     *
+     * @return the acceleration hierarchy for this polygon.
+     */
+    Hierarchy* getHierarchy() const;
+
 };
 
 }
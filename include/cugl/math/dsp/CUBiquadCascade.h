@@ -0,0 +1,288 @@
+//
+//  CUBiquadCascade.h
+//  Cornell University Game Library (CUGL)
+//
+//  This class represents a chain of biquad filters applied to the same
+//  multichannel signal, such as the bands of a parametric equalizer. Running
+//  a separate BiquadIIR for each band makes a pass over the whole buffer for
+//  each one. This class instead processes the channels side by side in the
+//  lanes of a vector register, and runs each section over the block while its
+//  state stays in registers. Hence an 8 channel bus is two vectors per frame,
+//  and the whole cascade is a single kernel.
+//
+//  The sections use the transposed direct form II, which is numerically
+//  robust for floats and has no latency. This differs from BiquadIIR, which
+//  delays its output by two frames.
+//
+//  This class supports vector optimizations for SSE and Neon 64. Like the
+//  other DSP classes, our implementation is limited to 128-bit words. Instead
+//  of 256-bit words, the kernel runs two channel groups at once, as the
+//  independent recurrences hide the latency of each multiply-add.
+//
+//  This class is NOT THREAD SAFE.  This is by design, for performance reasons.
+//  External locking may be required when the filter is shared between multiple
+//  threads (such as between an audio thread and the main thread).
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_BIQUAD_CASCADE_H__
+#define __CU_BIQUAD_CASCADE_H__
+
+#include <cugl/math/dsp/CUBiquadIIR.h>
+#include <cugl/math/CUMathBase.h>
+#include <cugl/util/CUAligned.h>
+#include <vector>
+
+namespace cugl {
+    namespace dsp {
+
+/**
+ * This class implements a cascade of biquad filters.
+ *
+ * A cascade applies each of its sections in order to every channel of the
+ * signal. This is the natural structure for a parametric equalizer, where
+ * each band is a peak or shelf biquad, or for a higher-order filter that has
+ * been factored into second-order sections. A new section is a pass-through
+ * filter until its coefficients are set.
+ *
+ * Each section is the difference equation
+ *
+ *   y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]
+ *
+ * computed in transposed direct form II. Unlike {@link BiquadIIR}, there is
+ * no output delay, so the output frame n depends on input frame n.
+ *
+ * This class supports vector optimizations for SSE and Neon 64. The channels
+ * are processed four at a time in the lanes of a vector, so the speed up is
+ * greatest for multichannel buses (4 or 8 channels). Channels that do not
+ * fill a vector are processed with scalar code. For mono signals with only
+ * a single section, {@link BiquadIIR} is faster.
+ *
+ * This class is not thread safe.  External locking may be required when
+ * the filter is shared between multiple threads (such as between an audio
+ * thread and the main thread).
+ */
+class BiquadCascade {
+public:
+    /** Whether to use a vectorization algorithm (Access not thread safe) */
+    static bool VECTORIZE;
+
+private:
+    /** The number of channels to support */
+    unsigned _channels;
+    /** The number of sections in the cascade */
+    size_t _sections;
+    /** The coefficients b0, b1, b2, a1, a2 of each section */
+    std::vector<float> _coeffs;
+    /** The first state variable, by section and then channel */
+    cugl::Aligned<float> _state1;
+    /** The second state variable, by section and then channel */
+    cugl::Aligned<float> _state2;
+
+    /**
+     * Resets the state buffers for the current channels and sections.
+     *
+     * This must be called if the number of channels or sections change.
+     */
+    void reset();
+
+    /**
+     * Applies a single section to interleaved data.
+     *
+     * The input and output may be the same array. The gain is applied to
+     * the input of the section.
+     *
+     * @param section   The section index
+     * @param gain      The input gain factor
+     * @param input     The array of input samples
+     * @param output    The array to write the sample output
+     * @param size      The input size in frames
+     */
+    void section(size_t section, float gain, const float* input, float* output, size_t size);
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an empty cascade for a single channel.
+     *
+     * An empty cascade is a pass-through filter.
+     */
+    BiquadCascade();
+
+    /**
+     * Creates a cascade of pass-through sections for the given channels.
+     *
+     * @param channels  The number of channels
+     * @param sections  The number of sections
+     */
+    BiquadCascade(unsigned channels, size_t sections);
+
+    /**
+     * Creates a copy of the biquad cascade.
+     *
+     * @param copy  The filter to copy
+     */
+    BiquadCascade(const BiquadCascade& copy);
+
+    /**
+     * Creates a biquad cascade with the resources of the original.
+     *
+     * @param filter    The filter to acquire
+     */
+    BiquadCascade(BiquadCascade&& filter);
+
+    /**
+     * Destroys the filter, releasing all resources.
+     */
+    ~BiquadCascade() {}
+
+#pragma mark Attributes
+    /**
+     * Returns the number of channels for this filter
+     *
+     * The data buffers depend on the number of channels.  Changing this value
+     * will reset the data buffers to 0.
+     *
+     * @return the number of channels for this filter
+     */
+    unsigned getChannels() const { return _channels; }
+
+    /**
+     * Sets the number of channels for this filter
+     *
+     * The data buffers depend on the number of channels.  Changing this value
+     * will reset the data buffers to 0.
+     *
+     * @param channels  The number of channels for this filter
+     */
+    void setChannels(unsigned channels);
+
+    /**
+     * Returns the number of sections in this cascade.
+     *
+     * @return the number of sections in this cascade.
+     */
+    size_t getSections() const { return _sections; }
+
+    /**
+     * Sets the number of sections in this cascade.
+     *
+     * Existing sections keep their coefficients, and new sections are
+     * pass-through filters. Changing this value will reset the data buffers
+     * to 0.
+     *
+     * @param sections  The number of sections in this cascade.
+     */
+    void setSections(size_t sections);
+
+    /**
+     * Sets the coefficients of the given section.
+     *
+     * The section implements the difference equation
+     *
+     *   y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]
+     *
+     * This does not reset the data buffers, so the coefficients may be
+     * changed while the filter is running.
+     *
+     * @param index The section index
+     * @param b0    The upper zero-order coefficient
+     * @param b1    The upper first-order coefficient
+     * @param b2    The upper second-order coefficient
+     * @param a1    The lower first-order coefficient
+     * @param a2    The lower second-order coefficient
+     */
+    void setSection(size_t index, float b0, float b1, float b2, float a1, float a2);
+
+    /**
+     * Sets the coefficients of the given section to those of a biquad filter.
+     *
+     * This does not reset the data buffers, so the coefficients may be
+     * changed while the filter is running.
+     *
+     * @param index     The section index
+     * @param filter    The filter to copy the coefficients from
+     */
+    void setSection(size_t index, const BiquadIIR& filter);
+
+    /**
+     * Sets the given section to the special purpose filter of the given type
+     *
+     * This method is equivalent to {@link BiquadIIR#setType}. See that method
+     * for the meaning of the parameters. This does not reset the data
+     * buffers, so the bands of an equalizer may be adjusted while the
+     * filter is running.
+     *
+     * @param index     The section index
+     * @param type      The filter type
+     * @param frequency The (normalized) target frequency
+     * @param gainDB    The gain at the target frequency in decibels
+     * @param qVal      The special Q factor
+     */
+    void setSection(size_t index, BiquadIIR::Type type, float frequency, float gainDB,
+                    float qVal=INV_SQRT2);
+
+#pragma mark Filter Methods
+    /**
+     * Performs a filter of single frame of data.
+     *
+     * The output is written to the given output array, which should be the
+     * same size as the input array. The size should be the number of channels.
+     * The gain parameter is applied at the filter input, but does not affect
+     * the filter coefficients.
+     *
+     * @param gain      The input gain factor
+     * @param input     The input frame
+     * @param output    The frame to receive the output
+     */
+    void step(float gain, const float* input, float* output);
+
+    /**
+     * Performs a filter of interleaved input data.
+     *
+     * The output is written to the given output array, which should be the
+     * same size as the input array. The two arrays may be the same. The size
+     * is the number of frames, not samples.  Hence the arrays must be size
+     * times the number of channels in size. The gain parameter is applied at
+     * the filter input, but does not affect the filter coefficients.
+     *
+     * Each section is applied to the whole array before the next one, so the
+     * array should be a typical audio block (so that it stays in the cache).
+     *
+     * @param gain      The input gain factor
+     * @param input     The array of input samples
+     * @param output    The array to write the sample output
+     * @param size      The input size in frames
+     */
+    void calculate(float gain, const float* input, float* output, size_t size);
+
+    /**
+     * Clears the filter buffers of any cached inputs or outputs
+     */
+    void clear();
+};
+
+    }
+}
+
+#endif /* __CU_BIQUAD_CASCADE_H__ */
@@ -0,0 +1,280 @@
+//
+//  CUConvolver.h
+//  Cornell University Game Library (CUGL)
+//
+//  This class is represents a convolution engine for long kernels, such as
+//  the impulse response of a reverb. It uses a uniformly partitioned FFT
+//  convolution, so the cost per frame grows with the logarithm of the kernel
+//  length instead of the kernel length. The first partition of the kernel is
+//  applied directly, so there is no added latency.
+//
+//  This class uses the FFT in DSPMath, which supports vector optimizations for
+//  SSE and Neon 64. For short kernels (less than a few hundred taps) you
+//  should use FIRFilter instead, which will use this class automatically when
+//  the kernel is long enough.
+//
+//  This class is NOT THREAD SAFE.  This is by design, for performance reasons.
+//  External locking may be required when the filter is shared between multiple
+//  threads (such as between an audio thread and the main thread).
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_CONVOLVER_H__
+#define __CU_CONVOLVER_H__
+
+#include <cugl/math/CUMathBase.h>
+#include <cugl/util/CUAligned.h>
+#include <vector>
+
+namespace cugl {
+    namespace dsp {
+
+/**
+ * This class implements a partitioned FFT convolution.
+ *
+ * In particular, this class computes the same difference equation as
+ * {@link FIRFilter}:
+ *
+ *      y[n] = h[0]*x[n] + ... + h[nh]*x[n-nh]
+ *
+ * where y is the output, x in the input, and h is the kernel. However, the
+ * kernel is split into partitions of the block size. The first partition is
+ * applied directly to each frame. The remaining partitions are applied in the
+ * frequency domain once per block, using an overlap-save algorithm over a
+ * delay line of input spectra. As the tail partitions only depend on input
+ * from previous blocks, the output is never delayed.
+ *
+ * The block size is a tradeoff. The direct partition costs one block worth of
+ * multiplications per frame, while the spectral partitions cost two FFTs per
+ * block, plus one complex multiplication per partition. The default of 256
+ * frames is a good choice for impulse responses of a few seconds.
+ *
+ * This class is not thread safe.  External locking may be required when
+ * the filter is shared between multiple threads (such as between an audio
+ * thread and the main thread).
+ */
+class Convolver {
+private:
+    /** The number of channels to support */
+    unsigned _channels;
+    /** The partition size in frames (a power of two) */
+    size_t _block;
+    /** The number of spectral partitions (not including the direct one) */
+    size_t _parts;
+    /** The current position in the block */
+    size_t _offset;
+    /** The newest position in the spectral delay line */
+    size_t _newest;
+
+    /** The convolution kernel */
+    std::vector<float> _kernel;
+    /** The first partition of the kernel, in reverse order */
+    cugl::Aligned<float> _head;
+    /** The spectra of the remaining partitions (normalized) */
+    cugl::Aligned<float> _spectra;
+    /** The twiddle factors for an FFT of two blocks */
+    cugl::Aligned<float> _table;
+
+    /** The previous and current input block for each channel */
+    cugl::Aligned<float> _inns;
+    /** The spectral delay line for each channel */
+    cugl::Aligned<float> _delay;
+    /** The spectral contribution to the current output block for each channel */
+    cugl::Aligned<float> _tail;
+    /** A scratch buffer for spectral accumulation */
+    cugl::Aligned<float> _work;
+
+    /**
+     * Resets the caching data structures for this filter
+     *
+     * This must be called if the number of channels, the block size, or the
+     * kernel change.
+     */
+    void reset();
+
+    /**
+     * Completes the current input block
+     *
+     * This method adds the input block to the spectral delay line, and then
+     * computes the spectral contribution to the next output block.
+     */
+    void advance();
+
+public:
+    /** The default partition size in frames */
+    static const size_t DEFAULT_BLOCK;
+
+#pragma mark Constructors
+    /**
+     * Creates a pass-through convolution for a single channel.
+     */
+    Convolver();
+
+    /**
+     * Creates a pass-through convolution for the given number of channels.
+     *
+     * @param channels  The number of channels
+     */
+    Convolver(unsigned channels);
+
+    /**
+     * Creates a convolution with the given kernel and number of channels.
+     *
+     * The block size must be a power of two. If it is not, it will be rounded
+     * up to the next power of two.
+     *
+     * @param channels  The number of channels
+     * @param kernel    The convolution kernel
+     * @param block     The partition size in frames
+     */
+    Convolver(unsigned channels, const std::vector<float> &kernel, size_t block=DEFAULT_BLOCK);
+
+    /**
+     * Creates a copy of the convolution.
+     *
+     * @param copy	The convolution to copy
+     */
+    Convolver(const Convolver& copy);
+
+    /**
+     * Creates a convolution with the resources of the original.
+     *
+     * @param filter    The convolution to acquire
+     */
+    Convolver(Convolver&& filter);
+
+    /**
+     * Destroys the convolution, releasing all resources.
+     */
+    ~Convolver();
+
+#pragma mark Attributes
+    /**
+     * Returns the number of channels for this convolution
+     *
+     * The data buffers depend on the number of channels.  Changing this value
+     * will reset the data buffers to 0.
+     *
+     * @return the number of channels for this convolution
+     */
+    unsigned getChannels() const { return _channels; }
+
+    /**
+     * Sets the number of channels for this convolution
+     *
+     * The data buffers depend on the number of channels.  Changing this value
+     * will reset the data buffers to 0.
+     *
+     * @param channels  The number of channels for this convolution
+     */
+    void setChannels(unsigned channels);
+
+    /**
+     * Returns the partition size in frames
+     *
+     * @return the partition size in frames
+     */
+    size_t getBlockSize() const { return _block; }
+
+    /**
+     * Sets the partition size in frames
+     *
+     * The block size must be a power of two. If it is not, it will be rounded
+     * up to the next power of two. Changing this value will reset the data
+     * buffers to 0.
+     *
+     * @param block The partition size in frames
+     */
+    void setBlockSize(size_t block);
+
+    /**
+     * Returns the convolution kernel
+     *
+     * @return the convolution kernel
+     */
+    const std::vector<float>& getKernel() const { return _kernel; }
+
+    /**
+     * Sets the convolution kernel
+     *
+     * This method transforms every partition of the kernel, and allocates the
+     * spectral delay line. Hence it should not be called in the audio thread.
+     * Changing this value will reset the data buffers to 0.
+     *
+     * @param kernel    The convolution kernel
+     */
+    void setKernel(const std::vector<float> &kernel);
+
+#pragma mark Filter Methods
+    /**
+     * Performs a convolution of single frame of data.
+     *
+     * The output is written to the given output array, which should be the
+     * same size as the input array. The size should be the number of channels.
+     * The gain parameter is applied at the filter input, but does not affect
+     * the kernel.
+     *
+     * @param gain      The input gain factor
+     * @param input     The input frame
+     * @param output    The frame to receive the output
+     */
+    void step(float gain, float* input, float* output);
+
+    /**
+     * Performs a convolution of interleaved input data.
+     *
+     * The output is written to the given output array, which should be the
+     * same size as the input array. The size is the number of frames, not
+     * samples.  Hence the arrays must be size times the number of channels
+     * in size. It is safe for the output to be the same as the input.
+     *
+     * The gain parameter is applied at the filter input, but does not affect
+     * the kernel.
+     *
+     * @param gain      The input gain factor
+     * @param input     The array of input samples
+     * @param output    The array to write the sample output
+     * @param size      The input size in frames
+     */
+    void calculate(float gain, float* input, float* output, size_t size);
+
+    /**
+     * Clears the filter buffer of any delayed outputs or cached inputs
+     */
+    void clear();
+
+    /**
+     * Flushes any delayed outputs to the provided array.
+     *
+     * As this filter has no delayed terms, this method will write nothing. It
+     * is only here to standardize the filter signature.
+     *
+     * This method will also clear the buffer.
+     *
+     * @return The number of frames (not samples) written
+     */
+    size_t flush(float* output);
+};
+    }
+}
+#endif /* __CU_CONVOLVER_H__ */
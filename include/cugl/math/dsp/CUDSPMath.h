@@ -196,7 +196,117 @@ public:
      */
     static size_t ease(float* data, float bound, float knee, size_t size);
 
-    // TODO: Add convolution
+#pragma mark Convolution Methods
+    /**
+     * Returns the dot product of a strided input signal and a kernel
+     *
+     * The input signal is read every stride elements, so that this method
+     * can be applied to a single channel of an interleaved buffer. Hence the
+     * value returned is the sum of input[ii*stride]*kernel[ii] for all ii
+     * less than size.
+     *
+     * @param input     The input buffer
+     * @param stride    The stride of the input buffer
+     * @param kernel    The convolution kernel
+     * @param size      The number of elements in the kernel
+     *
+     * @return the dot product of a strided input signal and a kernel
+     */
+    static float dot(float* input, size_t stride, float* kernel, size_t size);
+
+    /**
+     * Redistributes an interleaved input signal with a channel matrix
+     *
+     * The matrix is an MxN matrix in row major order, where N is the number
+     * of input channels and M is the number of output channels. Each output
+     * frame is the product of this matrix and the input frame. The value size
+     * is specified in terms of frames, not samples.
+     *
+     * It is safe for output to be the same as the input buffer, provided that
+     * the buffer is large enough to hold the output data. This method only
+     * supports up to 8 input and output channels (7.1 surround). It does
+     * nothing and returns 0 if there are more channels than this.
+     *
+     * @param input     The input buffer
+     * @param inchans   The number of input channels
+     * @param matrix    The redistribution matrix
+     * @param output    The output buffer
+     * @param outchans  The number of output channels
+     * @param size      The number of frames to process
+     *
+     * @return the number of frames successfully processed
+     */
+    static size_t remix(const float* input, size_t inchans, const float* matrix,
+                        float* output, size_t outchans, size_t size);
+
+#pragma mark Spectral Methods
+    /**
+     * Computes the twiddle factors for an FFT of the given size
+     *
+     * The table is used by {@link #fft} and {@link #ifft}, and is laid out so
+     * that the factors of each butterfly stage are contiguous. The table
+     * should have room for 2*size elements. The value size is the number of
+     * complex elements in the transform, and must be a power of two.
+     *
+     * @param table     The buffer to store the twiddle factors
+     * @param size      The number of complex elements in the transform
+     *
+     * @return the number of complex elements supported by the table
+     */
+    static size_t fft_table(float* table, size_t size);
+
+    /**
+     * Performs an in-place forward FFT of complex data
+     *
+     * The data is interleaved as (real, imaginary) pairs, so the buffer must
+     * have 2*size elements. The value size is the number of complex elements,
+     * and must be a power of two. The table should be computed with
+     * {@link #fft_table} for this size. This method does nothing and returns
+     * 0 if size is not a power of two.
+     *
+     * @param data      The complex data to transform
+     * @param table     The twiddle factors for this size
+     * @param size      The number of complex elements
+     *
+     * @return the number of complex elements transformed
+     */
+    static size_t fft(float* data, const float* table, size_t size);
+
+    /**
+     * Performs an in-place inverse FFT of complex data
+     *
+     * The data is interleaved as (real, imaginary) pairs, so the buffer must
+     * have 2*size elements. The value size is the number of complex elements,
+     * and must be a power of two. The table should be computed with
+     * {@link #fft_table} for this size. This method does nothing and returns
+     * 0 if size is not a power of two.
+     *
+     * The result is not normalized. Following a forward transform with an
+     * inverse transform scales the original data by size.
+     *
+     * @param data      The complex data to transform
+     * @param table     The twiddle factors for this size
+     * @param size      The number of complex elements
+     *
+     * @return the number of complex elements transformed
+     */
+    static size_t ifft(float* data, const float* table, size_t size);
+
+    /**
+     * Multiplies two complex signals, adding the result to output
+     *
+     * The signals are interleaved as (real, imaginary) pairs, so each buffer
+     * must have 2*size elements. This is the inner loop of a frequency domain
+     * convolution.
+     *
+     * @param input1    The first input buffer
+     * @param input2    The second input buffer
+     * @param output    The output buffer
+     * @param size      The number of complex elements to multiply
+     *
+     * @return the number of complex elements successfully multiplied
+     */
+    static size_t complex_mult_add(const float* input1, const float* input2, float* output, size_t size);
 
 };
     }
@@ -9,6 +9,9 @@
 //  filters, you should use one of the more specific filters for performance
 //  reasons.
 //
+//  Long kernels (such as a reverb impulse response) are delegated to a
+//  partitioned FFT convolution, which is much faster than direct convolution.
+//
 //  This class supports vector optimizations for SSE and Neon 64.  In timed
 //  simulations, these optimizations provide at least a 3-4x performance
 //  increase (and in isolated cases, much higher). Our implementation is
@@ -50,10 +53,12 @@
 #define __CU_FIR_FILTER_H__
 
 #include <cugl/math/dsp/CUIIRFilter.h>
+#include <cugl/math/dsp/CUConvolver.h>
 #include <cugl/math/CUMathBase.h>
 #include <cugl/util/CUAligned.h>
 #include <cstring>
 #include <vector>
+#include <memory>
 
 namespace cugl {
     namespace dsp {
@@ -80,6 +85,11 @@ namespace cugl {
  * limited to 128-bit words as 256-bit (e.g. AVX) and higher show no significant
  * increase in performance.
  *
+ * Direct convolution is O(N) per frame in the number of coefficients. So if
+ * there are at least {@link #CONVOLVE_TAPS} coefficients, this filter uses a
+ * {@link Convolver} instead. This produces the same output (up to rounding)
+ * with no added latency.
+ *
  * For performance reasons, this class does not have a (virtualized) subclass
  * relationship with other IIR or FIR filters.  However, the signature of the
  * the calculation and coefficient methods has been standardized so that it
@@ -100,6 +110,8 @@ private:
     cugl::Aligned<float> _bval;
     /** The previously recieved input matching the upper coefficients */
     cugl::Aligned<float> _inns;
+    /** The partitioned convolution for long kernels (may be nullptr) */
+    std::unique_ptr<Convolver> _convolver;
     
     /**
      * Resets the caching data structures for this filter
@@ -107,6 +119,17 @@ private:
      * This must be called if the number of channels or coefficients change.
      */
     void reset();
+
+    /**
+     * Sets the partitioned convolution for the given coefficients
+     *
+     * The convolution is only used if there are at least {@link #CONVOLVE_TAPS}
+     * coefficients. Otherwise, it is set to nullptr.
+     *
+     * @param bvals The upper coefficients
+     * @param a0    The normalization factor
+     */
+    void setConvolver(const std::vector<float> &bvals, float a0);
     
 #pragma mark SPECIALIZED FILTERS
     /**
@@ -271,6 +294,9 @@ public:
     /** Whether to use a vectorization algorithm (Access not thread safe) */
     static bool VECTORIZE;
 
+    /** The number of coefficients at which to use a partitioned convolution */
+    static const size_t CONVOLVE_TAPS;
+
 #pragma mark Constructors
     /**
      * Creates a zero-order pass-through filter for a single channel.
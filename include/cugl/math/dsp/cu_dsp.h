@@ -29,6 +29,7 @@
 #define __CU_DSP_PKG_H__
 
 #include "CUDSPMath.h"
+#include "CUConvolver.h"
 #include "CUFIRFilter.h"
 #include "CUIIRFilter.h"
 #include "CUOneZeroFIR.h"
@@ -37,6 +38,7 @@
 #include "CUTwoPoleIIR.h"
 #include "CUPoleZeroIIR.h"
 #include "CUBiquadIIR.h"
+#include "CUBiquadCascade.h"
 
 #endif /* __CU_DSP_PKG_H__ */
 
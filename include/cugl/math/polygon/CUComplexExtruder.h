@@ -42,6 +42,7 @@
 #include <cugl/math/CUPoly2.h>
 #include <cugl/math/CUPath2.h>
 #include <cugl/math/polygon/CUPolyEnums.h>
+#include <cugl/math/polygon/CUDelaunayTriangulator.h>
 #include <vector>
 
 namespace cugl {
@@ -91,6 +92,16 @@ private:
 
     /** The output boundaries */
     std::vector<Path2> _bounds;
+    /** The input path in Clipper coordinates (kept across calculations) */
+    ClipperLib::Path _inverts;
+    /** Whether _inverts is current with the input path and resolution */
+    bool _scaled;
+    /** The Clipper offsetter (kept across calculations) */
+    ClipperLib::ClipperOffset _worker;
+    /** The Clipper offset solution (kept across calculations) */
+    ClipperLib::PolyTree _solution;
+    /** The triangulator for the output boundaries (kept across calculations) */
+    DelaunayTriangulator _triangulator;
     
     /** The (triangulated) output results */
     Poly2 _output;
@@ -230,6 +241,7 @@ public:
      * @param resolution    The subdivision resolution
      */
     void setResolution(Uint32 resolution) {
+         _scaled = _scaled && _resolution == resolution;
          _resolution = resolution;
     }
     
@@ -41,7 +41,11 @@
 #include <poly2tri/poly2tri.h>
 #include <cugl/math/CUVec2.h>
 #include <cugl/math/CUPoly2.h>
+#include <cugl/util/CUThreadPool.h>
 #include <unordered_map>
+#include <functional>
+#include <atomic>
+#include <memory>
 #include <deque>
 #include <vector>
 
@@ -100,6 +104,8 @@ private:
 
     /** The set of vertices to use in the calculation (hull, holes, and Steiner) */
     std::vector<p2t::Point*> _vertices;
+    /** The vertices of a single hole (scratch space kept across calculations) */
+    std::vector<p2t::Point*> _scratch;
     /** A map to reverse look-up indices from poly2tri triangles */
     std::unordered_map<p2t::Point*, Uint32> _idxmap;
     
@@ -114,6 +120,8 @@ private:
     bool _dualated;
     /** The Vornoi diagram as a collection of solid Polys */
     std::unordered_map<Uint32, Poly2> _voronoi;
+    /** Whether a background calculation is in progress */
+    std::atomic<bool> _pending;
 
 public:
     /**
@@ -315,7 +323,9 @@ public:
      * Performs a triangulation of the current vertex data.
      *
      * This only calculates the triangulation.  It does not compute the
-     * Voronoi dual.
+     * Voronoi dual. The results are cached, so this method does nothing
+     * if the triangulation is current. Changing the hull, or adding a
+     * hole or Steiner point, will invalidate the cache.
      */
     void calculate();
     
@@ -325,9 +335,56 @@ public:
      * This will force a triangulation if one has not been computed
      * already. In cases where triangles are missing to fully define the
      * Voronoi diagram (such as on the boundary of the diagram), the
-     * missing triangles are interpolated.
+     * missing triangles are interpolated. As with {@link #calculate},
+     * the results are cached.
      */
     void calculateDual();
+
+    /**
+     * Calculates the Voronoi diagram, using the given thread pool.
+     *
+     * This method is the same as {@link #calculateDual()}, except that the
+     * Voronoi cells are computed in parallel. The triangulation itself is
+     * still computed on the calling thread, as the poly2tri sweep cannot be
+     * divided. This method blocks until all of the cells are computed, and
+     * the calling thread shares in the work. Hence it is safe to use a pool
+     * that is busy (or even stopped), though it will not be any faster.
+     *
+     * This method should not be called from a task of the given pool.
+     *
+     * @param pool  The thread pool to compute the cells
+     */
+    void calculateDual(const std::shared_ptr<ThreadPool>& pool);
+
+    /**
+     * Performs the calculation in the background, using the given thread pool.
+     *
+     * This method returns immediately. The triangulation (and the Voronoi
+     * diagram, if dual is true) is computed on a thread of the pool. When
+     * it is done, the callback is executed on the main thread at the start
+     * of the next animation frame, using {@link Application#schedule}.
+     *
+     * The triangulator must not be modified, read, or deleted until the
+     * callback is executed. Use {@link #isPending} to check whether a
+     * background calculation is still in progress.
+     *
+     * @param pool      The thread pool to perform the calculation
+     * @param dual      Whether to calculate the Voronoi diagram as well
+     * @param callback  The callback to execute when the calculation is done
+     */
+    void calculateAsync(const std::shared_ptr<ThreadPool>& pool, bool dual,
+                        const std::function<void()>& callback);
+
+    /**
+     * Returns true if a background calculation is in progress
+     *
+     * A background calculation is in progress from the call to
+     * {@link #calculateAsync} until its callback executes. The triangulator
+     * should not be used in this time.
+     *
+     * @return true if a background calculation is in progress
+     */
+    bool isPending() const { return _pending.load(); }
     
 #pragma mark Materialization
     /**
@@ -546,6 +603,20 @@ private:
      */
     const std::deque<Vec2> calculateCell(p2t::Point* p, p2t::Triangle* tri);
 
+    /**
+     * Stores the Voronoi region for the given point in the given buffer.
+     *
+     * The region is a triangle fan about the point p, with the boundary
+     * computed by {@link #calculateCell}. This method only reads the
+     * triangulation, and so it is safe to call it from multiple threads
+     * at once (with different buffers).
+     *
+     * @param p         The point defining the Voronoi region
+     * @param tri       A poly2tri triangle containing p as a vertex.
+     * @param buffer    The buffer to store the region
+     */
+    void buildCell(p2t::Point* p, p2t::Triangle* tri, Poly2* buffer);
+
     /**
      * Returns the circumcenter for the given triangle tri
      *
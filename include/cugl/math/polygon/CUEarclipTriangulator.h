@@ -93,6 +93,8 @@ private:
     std::vector<Vec2> _input;
     /** The offset and size of the hole positions in the input */
     std::vector<size_t> _holes;
+    /** The holes not yet merged into the exterior (scratch space kept across calculations) */
+    std::vector<size_t> _holesleft;
     /** The output results of the triangulation */
     std::vector<Uint32> _output;
     
@@ -86,6 +86,14 @@ private:
     float _epsilon;
     /** Whether or not the calculation has been run */
     bool _calculated;
+    /** Whether the input vertices form a closed path */
+    bool _closed;
+    /** The importance of each input vertex (for level of detail) */
+    std::vector<float> _importance;
+    /** The input vertex indices, in the order they refine the path */
+    std::vector<Uint32> _order;
+    /** The maximum deviation of the path for each prefix of _order */
+    std::vector<float> _tolerance;
 
 #pragma mark -
 #pragma mark Constructors
@@ -126,6 +134,7 @@ public:
     void set(const std::vector<Vec2>& points) {
         reset();
         _input = points;
+        _closed = false;
     }
     
     /**
@@ -133,7 +142,8 @@ public:
      *
      * The vertex data is copied. The smother does not retain any references
      * to the original data.  In addition, only the vertex data is copied.
-     * Whether or not the path is closed is ignored.
+     * Whether or not the path is closed is ignored by {@link #calculate}.
+     * However, it is respected by {@link #calculateDetail}.
      *
      * This method resets all interal data. You will need to reperform the
      * calculation before accessing data.
@@ -143,6 +153,7 @@ public:
     void set(const Path2& path) {
         reset();
         _input = path.vertices;
+        _closed = path.closed;
     }
 
     /**
@@ -198,6 +209,35 @@ public:
      * Performs a triangulation of the current vertex data.
      */
     void calculate();
+
+    /**
+     * Computes a multi-resolution representation of the current vertex data.
+     *
+     * This is a single Douglas-Peucker pass that, instead of stopping at the
+     * epsilon value, always refines the span with the largest deviation until
+     * every vertex is used. The order in which vertices are added describes
+     * every level of detail at once. Any level of detail is then a prefix of
+     * this order, and can be read with methods like {@link #getDetailPoints}
+     * without recomputing anything. The error of each prefix is recorded as
+     * well, so that {@link #getDetailCount} can map a tolerance to a prefix.
+     *
+     * The end points of an open path always have infinite importance. If the
+     * path is closed, the first vertex and the vertex farthest from it are the
+     * two most important vertices.
+     *
+     * This calculation is independent of {@link #calculate}, and does not
+     * use the epsilon value.
+     */
+    void calculateDetail();
+    
+    /**
+     * Returns true if the multi-resolution representation has been computed.
+     *
+     * @return true if the multi-resolution representation has been computed.
+     */
+    bool isDetailed() const {
+        return !_input.empty() && _order.size() == _input.size();
+    }
     
 #pragma mark -
 #pragma mark Materialization
@@ -255,6 +295,94 @@ public:
      */
     Path2* getPath(Path2* buffer) const;
 
+#pragma mark -
+#pragma mark Level of Detail
+    /**
+     * Returns the importance of the given input vertex.
+     *
+     * The importance is the deviation from the simplified path that this
+     * vertex corrected when it was added by {@link #calculateDetail}. The end
+     * points of the path have infinite importance.
+     *
+     * If {@link #calculateDetail} has not been called, this method returns 0.
+     *
+     * @param index The input vertex index
+     *
+     * @return the importance of the given input vertex.
+     */
+    float getImportance(size_t index) const {
+        return index < _importance.size() ? _importance[index] : 0;
+    }
+    
+    /**
+     * Returns the number of vertices needed to match the given tolerance.
+     *
+     * This is the length of the shortest prefix of the detail order whose path
+     * is within epsilon of every input vertex. The result is at least 2 (or the
+     * number of input vertices, if that is smaller) so that the path is never
+     * lost. The value is found with a binary search.
+     *
+     * If {@link #calculateDetail} has not been called, this method returns 0.
+     *
+     * @param epsilon   The tolerance
+     *
+     * @return the number of vertices needed to match the given tolerance.
+     */
+    size_t getDetailCount(float epsilon) const;
+    
+    /**
+     * Stores the given number of detail vertices in the buffer.
+     *
+     * The vertices are stored in their original path order, and are appended
+     * to the buffer. The count is a level of detail, and may be any value up
+     * to the number of input vertices. Use {@link #getDetailCount} to choose
+     * a count from a tolerance (such as one pixel at the current zoom).
+     *
+     * If {@link #calculateDetail} has not been called, this method does nothing.
+     *
+     * @param count     The number of vertices to use
+     * @param buffer    The buffer to store the vertices
+     *
+     * @return the number of elements added to the buffer
+     */
+    size_t getDetailPoints(size_t count, std::vector<Vec2>& buffer) const;
+    
+    /**
+     * Returns a path with the given number of detail vertices.
+     *
+     * The vertices are in their original path order. The count is a level of
+     * detail, and may be any value up to the number of input vertices. Use
+     * {@link #getDetailCount} to choose a count from a tolerance (such as one
+     * pixel at the current zoom). The path is closed if the input was.
+     *
+     * If {@link #calculateDetail} has not been called, this method will return
+     * the empty path.
+     *
+     * @param count     The number of vertices to use
+     *
+     * @return a path with the given number of detail vertices.
+     */
+    Path2 getDetailPath(size_t count) const;
+    
+    /**
+     * Stores a path with the given number of detail vertices.
+     *
+     * The vertices are in their original path order. They are appended to
+     * the end of the buffer. The count is a level of detail, and may be any
+     * value up to the number of input vertices. Use {@link #getDetailCount}
+     * to choose a count from a tolerance (such as one pixel at the current
+     * zoom). The path is closed if the input was.
+     *
+     * If {@link #calculateDetail} has not been called, this method will do
+     * nothing.
+     *
+     * @param count     The number of vertices to use
+     * @param buffer    The buffer to store the path
+     *
+     * @return a reference to the buffer for chaining.
+     */
+    Path2* getDetailPath(size_t count, Path2* buffer) const;
+
 #pragma mark -
 #pragma mark Internal Data Generation
 private:
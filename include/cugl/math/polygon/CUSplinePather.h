@@ -37,12 +37,15 @@
 #define __CU_SPLINE_PATHER_H__
 
 #include <cugl/math/CUSpline2.h>
+#include <cugl/util/CUDebug.h>
 #include <cugl/math/CUVec2.h>
 #include <vector>
 #include <unordered_map>
 
 /** The default tolerance for the polygon approximation functions */
 #define DEFAULT_FLATNESS   0.5
+/** The maximum number of segments generated for a single bezier curve */
+#define MAX_FLATNESS_SEGMENTS   1024
 
 namespace cugl {
 
@@ -88,6 +91,8 @@ private:
     bool _calculated;
     /** The flatness tolerance for generating paths */
     float _tolerance;
+    /** The (screen) scale of the spline when it is drawn */
+    float _scale;
 
 public:
 #pragma mark -
@@ -98,7 +103,8 @@ public:
     SplinePather() :
     _spline(nullptr),
     _calculated(false),
-    _tolerance(DEFAULT_FLATNESS) {
+    _tolerance(DEFAULT_FLATNESS),
+    _scale(1.0f) {
     }
 
     /**
@@ -109,7 +115,8 @@ public:
     SplinePather(const Spline2* spline) :
     _spline(spline),
     _calculated(false),
-    _tolerance(DEFAULT_FLATNESS) {
+    _tolerance(DEFAULT_FLATNESS),
+    _scale(1.0f) {
     }
 
     /**
@@ -149,15 +156,78 @@ public:
      */
     void clear();
 
+    /**
+     * Sets the flatness tolerance of the approximation.
+     *
+     * The tolerance is the maximum distance (in screen units) between the
+     * approximating path and the true curve. Smaller values produce more
+     * vertices. The default value is {@link DEFAULT_FLATNESS}.
+     *
+     * This method resets all interal data.  You will need to reperform the
+     * calculation before accessing data.
+     *
+     * @param tolerance The flatness tolerance of the approximation
+     */
+    void setTolerance(float tolerance) {
+        CUAssertLog(tolerance > 0, "Tolerance %f is not positive", tolerance);
+        reset();
+        _tolerance = tolerance;
+    }
+
+    /**
+     * Returns the flatness tolerance of the approximation.
+     *
+     * The tolerance is the maximum distance (in screen units) between the
+     * approximating path and the true curve. Smaller values produce more
+     * vertices. The default value is {@link DEFAULT_FLATNESS}.
+     *
+     * @return the flatness tolerance of the approximation
+     */
+    float getTolerance() const { return _tolerance; }
+
+    /**
+     * Sets the screen scale of the spline.
+     *
+     * This is the number of screen units per spline unit when the curve is
+     * drawn, such as the camera zoom times the node scale. The flatness
+     * tolerance is measured in screen units, so a curve that is zoomed in
+     * gets more vertices, and one that is zoomed out gets fewer. The default
+     * value is 1.
+     *
+     * This method resets all interal data.  You will need to reperform the
+     * calculation before accessing data.
+     *
+     * @param scale The screen scale of the spline
+     */
+    void setScale(float scale) {
+        CUAssertLog(scale > 0, "Scale %f is not positive", scale);
+        reset();
+        _scale = scale;
+    }
+
+    /**
+     * Returns the screen scale of the spline.
+     *
+     * This is the number of screen units per spline unit when the curve is
+     * drawn, such as the camera zoom times the node scale. The flatness
+     * tolerance is measured in screen units, so a curve that is zoomed in
+     * gets more vertices, and one that is zoomed out gets fewer. The default
+     * value is 1.
+     *
+     * @return the screen scale of the spline
+     */
+    float getScale() const { return _scale; }
+
 
 #pragma mark -
 #pragma mark Calculation
     /**
      * Performs an approximation of the current spline
      *
-     * A polygon approximation is creating by recursively calling de Castlejau's
-     * until we reach a stopping condition. Currently the only supported stopping
-     * condition is the recursion depth.
+     * Each bezier segment is divided into the minimum number of uniform
+     * pieces for which the path is guaranteed to be within the flatness
+     * tolerance of the curve (at the current scale). The pieces are then
+     * evaluated with forward differencing.
      *
      * The calculation uses a reference to the spline; it does not copy it. 
      * Hence this method is not thread-safe. If you are using this method in
@@ -412,21 +482,21 @@ public:
 #pragma mark Internal Data Generation
 private:
     /**
-     * Generates data via recursive use of de Castlejau's
+     * Generates data via forward differencing of the given segment
      *
-     * This method subdivides the spline at the given segment. The results
-     * are put in the output buffers.
+     * This method subdivides the segment into the minimum number of uniform
+     * pieces within the flatness tolerance. The control points of each
+     * piece are put in the output buffers.
      *
      * @param  t        the parameter for the (start of) this segment
      * @param  p0       the left anchor of this segment
      * @param  p1       the left tangent of this segment
      * @param  p2       the right tangent of this segment
      * @param  p3       the right anchor of this segment
-     * @param  depth    the current depth of the recursive call
      *
-     * @return The number of (anchor) points generated by this recursive call.
+     * @return The number of (anchor) points generated for this segment.
      */
-    int generate(float t, const Vec2* p0, const Vec2* p1, const Vec2* p2, const Vec2* p3, int depth);
+    int generate(float t, const Vec2* p0, const Vec2* p1, const Vec2* p2, const Vec2* p3);
 
     /**
      * Returns the currently "active" control points.
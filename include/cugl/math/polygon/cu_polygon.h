@@ -34,6 +34,7 @@
 #include "CUSimpleExtruder.h"
 #include "CUComplexExtruder.h"
 #include "CUEarclipTriangulator.h"
+#include "CUMonotoneTriangulator.h"
 #include "CUDelaunayTriangulator.h"
 #include "CUPathSmoother.h"
 
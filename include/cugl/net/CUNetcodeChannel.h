@@ -47,7 +47,14 @@
 //
 #ifndef __CU_NETCODE_CHANNEL_H__
 #define __CU_NETCODE_CHANNEL_H__
+#include <cugl/net/CUNetcodeStats.h>
+#include <cugl/net/CUNetcodeSerializer.h>
+#include <cugl/net/CUNetcodeSimulator.h>
+#include <cugl/util/CUDebug.h>
+#include <cugl/util/CUFreeList.h>
 #include <rtc/rtc.hpp>
+#include <unordered_map>
+#include <deque>
 #include <future>
 #include <memory>
 #include <string>
@@ -70,6 +77,11 @@ namespace cugl {
 class NetcodePeer;
 class NetcodeConnection;
 
+/** The label of the reliable, ordered data channel between two peers */
+#define NETCODE_RELIABLE_CHANNEL    "public"
+/** The label of the unreliable, unordered data channel between two peers */
+#define NETCODE_UNRELIABLE_CHANNEL  "sync"
+
 /**
  * This class represents a single data channel
  *
@@ -79,23 +91,117 @@ class NetcodeConnection;
  * providing bi-directional communication. It is possible for two devices to have more
  * than one data channel between them, such as conversations marked private or public.
  *
+ * Data channels may either be reliable (ordered, with retransmission) or unreliable
+ * (unordered, with no retransmission). Unreliable channels are intended for state
+ * synchronization traffic, where a newer message always supersedes an older one.
+ * In that case a lost message should not block the delivery of later messages.
+ *
+ * A data channel transparently splits any large message into fragments, and
+ * reassembles them on the other side. Hence a message is not limited by the
+ * maximum message size of the underlying channel (see {@link NetcodeConfig#maxMessage}).
+ * The fragments are only sent as the channel drains, so that a large transfer
+ * never holds up the messages on the other channels to the same peer.
+ *
  * Users should not create data channels directly, and as such all constructors and 
  * allocators for this class are private.  All data channels are associated with a
  * {@link NetcodePeer} and should be constructed from them. We have only exposed this 
  * class to simplify development.
  */
-class NetcodeChannel {
+class NetcodeChannel : public std::enable_shared_from_this<NetcodeChannel> {
+public:
+    /**
+     * An enum representing how a congested channel handles new messages.
+     *
+     * A channel is congested when the number of bytes buffered (but not yet
+     * sent) by the underlying RTC data channel exceeds its high watermark. It
+     * stays congested until the buffered amount drops below its low watermark.
+     */
+    enum class Backpressure : int {
+        /** Buffer the message anyway (the default) */
+        QUEUE    = 0,
+        /** Discard the message, causing send to fail */
+        DROP     = 1,
+        /** Keep only the latest message, sending it once the channel drains */
+        COALESCE = 2
+    };
+    
 private:
+    /**
+     * A message being reassembled from its fragments.
+     *
+     * Every fragment except the last has the same size, so each fragment can
+     * be copied into place as soon as it arrives, in any order. These objects
+     * are kept in a free list, so that their buffers are reused.
+     */
+    class Reassembly {
+    public:
+        /** The total size of the message */
+        size_t size;
+        /** The size of each fragment (except possibly the last) */
+        size_t chunk;
+        /** The number of fragments received */
+        size_t received;
+        /** Whether each fragment has been received */
+        std::vector<bool> arrived;
+        /** The message data */
+        std::vector<std::byte> data;
+        
+        /** Creates an empty reassembly buffer */
+        Reassembly() : size(0), chunk(0), received(0) {}
+        
+        /** Resets this buffer so that it can be reused */
+        void reset() {
+            size = 0;
+            chunk = 0;
+            received = 0;
+            arrived.clear();
+            data.clear();
+        }
+    };
+    
     /** The name of this data channel */
     std::string _label;
     /** The peer UUID (to prevent an unnecessary "join") */
     std::string _uuid;
+    /** The peer handle for the UUID (assigned by the connection on first receipt) */
+    Uint32 _handle;
     /** The NetcodePeer that owns this data channel. */
     std::weak_ptr<NetcodePeer> _parent;
     /** The NetcodeConnection ultimately associated with this data channel */
     std::weak_ptr<NetcodeConnection> _grandparent;
     /** The associated RTC data channel */
     std::shared_ptr<rtc::DataChannel> _channel;
+    /** Whether this channel is reliable and ordered */
+    bool _reliable;
+    /** The RTC peer connection for this channel (to sample the round trip time) */
+    std::weak_ptr<rtc::PeerConnection> _connection;
+    /** The statistics counters for this channel (forwarded to the peer) */
+    std::shared_ptr<NetcodeCounters> _stats;
+    /** The buffered amount at the time of the last sample */
+    size_t _buffered;
+    /** The number of packets received, used to throttle round trip time samples */
+    size_t _samples;
+    /** The buffered amount at which this channel becomes congested (0 for never) */
+    size_t _highWater;
+    /** The buffered amount at which this channel is no longer congested */
+    size_t _lowWater;
+    /** How this channel handles messages when congested */
+    Backpressure _policy;
+    /** Whether this channel is currently congested */
+    bool _congested;
+    /** The coalesced message waiting to be sent (nullptr for none) */
+    NetcodeMessage _pending;
+    /** The simulated network conditions for this channel (nullptr for none) */
+    std::shared_ptr<NetcodeSimulator> _simulator;
+    
+    /** The id of the next fragmented message */
+    uint32_t _fragmentId;
+    /** The fragments (and the datagrams ordered after them) waiting to be sent */
+    std::deque<NetcodeMessage> _outgoing;
+    /** The messages currently being reassembled, by id */
+    std::unordered_map<uint32_t, Reassembly*> _incoming;
+    /** The free list of reassembly buffers */
+    std::shared_ptr<FreeList<Reassembly>> _reassembly;
 
     // To prevent race conditions
     /** Whether this data channel prints out debugging information */
@@ -149,12 +255,16 @@ private:
      *
      * This initializer assumes the peer is the offerer of the data channel.
      *
+     * If the channel is not reliable, it will be unordered and will never
+     * retransmit a lost message (e.g. maxRetransmits is 0).
+     *
      * @param parent    The parent RTC peer connection
      * @param label     The unique label for this data channel
+     * @param reliable  Whether the data channel is reliable and ordered
      *
      * @return true if initialization was successful
      */
-    bool init(const std::weak_ptr<NetcodePeer>& parent, std::string label);
+    bool init(const std::weak_ptr<NetcodePeer>& parent, std::string label, bool reliable=true);
     
     /**
      * Initializes a new netcode wrapper for the given RTC data channel.
@@ -173,14 +283,19 @@ private:
      *
      * This initializer assumes the peer is the offerer of the data channel.
      *
+     * If the channel is not reliable, it will be unordered and will never
+     * retransmit a lost message (e.g. maxRetransmits is 0).
+     *
      * @param parent    The parent RTC peer connection
      * @param label     The unique label for this data channel
+     * @param reliable  Whether the data channel is reliable and ordered
      *
      * @return a newly allocated RTC data channel for the given label.
      */
-    static std::shared_ptr<NetcodeChannel> alloc(const std::weak_ptr<NetcodePeer>& parent, std::string label) {
+    static std::shared_ptr<NetcodeChannel> alloc(const std::weak_ptr<NetcodePeer>& parent, std::string label,
+                                                 bool reliable=true) {
         std::shared_ptr<NetcodeChannel> result = std::make_shared<NetcodeChannel>();
-        return (result->init(parent,label) ? result : nullptr);
+        return (result->init(parent,label,reliable) ? result : nullptr);
     }
 
     /**
@@ -220,6 +335,141 @@ private:
      */
     void onMessage(rtc::message_variant data);
     
+    /**
+     * Processes a data channel message once it has arrived
+     *
+     * This is the body of {@link #onMessage}. It is split off so that a
+     * {@link NetcodeSimulator} can delay the message before it is processed.
+     *
+     * @param data  The message data (a string or byte vector)
+     */
+    void receive(rtc::message_variant data);
+    
+    /**
+     * Called when the buffered amount drops to the low watermark
+     *
+     * This sends any coalesced message and notifies the {@link NetcodeConnection}
+     * if the channel was previously congested.
+     */
+    void onBufferedAmountLow();
+    
+    /**
+     * Applies the backpressure settings of the {@link NetcodeConnection}
+     *
+     * The settings are chosen according to the lane of this channel. They are
+     * atomic, so this does not require a lock on the connection.
+     */
+    void applyBackpressure();
+    
+    /**
+     * Sets the backpressure settings for this channel
+     *
+     * The channel becomes congested when the buffered amount reaches the high
+     * watermark, and remains so until it drops to the low watermark. A high
+     * watermark of 0 disables backpressure.
+     *
+     * @param high      The high watermark in bytes
+     * @param low       The low watermark in bytes
+     * @param policy    How to handle messages when congested
+     */
+    void setBackpressure(size_t high, size_t low, Backpressure policy);
+    
+    /**
+     * Applies the network simulator of the {@link NetcodeConnection}
+     *
+     * The simulator is accessed atomically, so this does not require a lock
+     * on the connection.
+     */
+    void applySimulator();
+    
+    /**
+     * Sets the network simulator for this channel.
+     *
+     * Any datagrams already held by the previous simulator are still
+     * delivered. A nullptr value disables simulation.
+     *
+     * @param simulator The network simulator
+     */
+    void setSimulator(const std::shared_ptr<NetcodeSimulator>& simulator);
+    
+    /**
+     * Passes a single datagram to the RTC data channel.
+     *
+     * If this channel has a {@link NetcodeSimulator}, the datagram is posted
+     * to the simulator, which calls {@link #release} once it is due. This
+     * method must be called while holding the lock for this channel.
+     *
+     * The datagram is only copied if it is simulated and message is nullptr.
+     *
+     * @param data      The datagram to send
+     * @param message   The shared buffer for the datagram (nullptr for none)
+     */
+    void emit(const std::vector<std::byte>& data, const NetcodeMessage& message);
+    
+    /**
+     * Passes a datagram delayed by the network simulator to the RTC data channel.
+     *
+     * The datagram is discarded if this channel closed in the meantime.
+     *
+     * @param datagram  The datagram to send
+     */
+    void release(const NetcodeMessage& datagram);
+    
+    /**
+     * Sends a datagram along the RTC data channel, ignoring backpressure.
+     *
+     * If the datagram is larger than a single fragment, or begins with the
+     * fragment marker, it is split into fragments which are queued for
+     * {@link #pump}. On a reliable channel, any datagram sent while fragments
+     * are queued is queued behind them, so that order is preserved. This
+     * method must be called while holding the lock for this channel.
+     *
+     * The datagram is only copied if it must be queued and message is nullptr.
+     * Otherwise the queue shares message, which must hold the same bytes as
+     * data.
+     *
+     * @param data      The datagram to send
+     * @param message   The shared buffer for the datagram (nullptr for none)
+     */
+    void transmit(const std::vector<std::byte>& data, const NetcodeMessage& message);
+    
+    /**
+     * Sends queued fragments until the channel has enough buffered.
+     *
+     * The channel stops when its buffered amount is above the low watermark,
+     * so that {@link #onBufferedAmountLow} resumes it. This method must be
+     * called while holding the lock for this channel.
+     */
+    void pump();
+    
+    /**
+     * Adds a received fragment to its reassembly buffer.
+     *
+     * If this fragment completes a message, data is replaced by the message and
+     * this method returns true. Otherwise it returns false. This method must be
+     * called while holding the lock for this channel.
+     *
+     * @param data  The received fragment
+     *
+     * @return true if data now holds a complete message
+     */
+    bool reassemble(std::vector<std::byte>& data);
+    
+    /**
+     * Sends data along this data channel, subject to backpressure.
+     *
+     * This is the implementation of both versions of {@link #send}. The data
+     * is only copied if it must be stored (queued or coalesced) and message is
+     * nullptr. Otherwise the channel shares message, which must hold the same
+     * bytes as data.
+     *
+     * @param data      The data to send
+     * @param message   The shared buffer for the data (nullptr for none)
+     *
+     * @return true if transmission was (apparently) successful
+     */
+    bool enqueue(const std::vector<std::byte>& data, const NetcodeMessage& message);
+    
     /** Allow access to the other netcode classes */
     friend class NetcodePeer;
     friend class NetcodeConnection;
@@ -235,6 +485,36 @@ public:
      */
     const std::string getLabel() const { return _label; }
     
+    /**
+     * Returns true if this data channel is reliable and ordered.
+     *
+     * An unreliable channel is unordered and never retransmits lost messages.
+     * It is appropriate for state snapshots, but not for game state changes.
+     *
+     * @return true if this data channel is reliable and ordered.
+     */
+    bool isReliable() const { return _reliable; }
+    
+    /**
+     * Returns true if this data channel is currently open.
+     *
+     * A channel may be active before it is open. No messages can be sent
+     * along the channel until it is open.
+     *
+     * @return true if this data channel is currently open.
+     */
+    bool isOpen() const { return _open; }
+    
+    /**
+     * Returns the network statistics for this data channel.
+     *
+     * Only the byte, packet, and buffered amounts are meaningful for a data
+     * channel. This method never takes a lock.
+     *
+     * @return the network statistics for this data channel.
+     */
+    NetcodeStats getStats() const;
+    
     /**
      * Returns the parent {@link NetcodePeer} of this data channel
      *
@@ -276,6 +556,13 @@ public:
      * Most users should never need  to access this method. All communication should take 
      * place using the associated {@link NetcodeConnection}. It is provided for debugging
      * purposes only.
+     *
+     * If the channel is congested (see {@link Backpressure}), the message may be
+     * discarded or coalesced according to the channel policy. This method returns
+     * false if the message was discarded.
+     *
+     * Messages larger than the maximum message size of the channel are split into
+     * fragments and reassembled by the recipient.
      * 
      * @param data  The data to send
      *
@@ -283,6 +570,19 @@ public:
      */
     bool send(const std::vector<std::byte>& data);
     
+    /**
+     * Sends a shared message buffer along this data channel to its recipient
+     *
+     * This method is identical to {@link #send}, except that the message is
+     * never copied by this channel. If the message has to wait (because it
+     * is queued or coalesced), the channel holds a reference to it instead.
+     *
+     * @param message   The message to send
+     *
+     * @return true if transmission was (apparently) successful
+     */
+    bool send(const NetcodeMessage& message);
+    
 #pragma mark Debugging
     /**
      * Toggles the debugging status of this channel.
@@ -0,0 +1,194 @@
+//
+//  CUNetcodeCompressor.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module is part of a Web RTC implementation of the classic CUGL networking
+//  library. It provides the compression codec used by NetcodeConnection for large
+//  messages, such as state checkpoints and full physics synchronizations.
+//
+//  The codec is a fast LZ77 block compressor in the style of LZ4. It can be
+//  primed with a preset dictionary, so that even mid-size messages compress
+//  well when they share structure with the dictionary. A dictionary is best
+//  trained over samples of typical NetcodeSerializer output.
+//
+//  This class does not QUITE use our standard shared-pointer architecture. A
+//  compressor is immutable once constructed (so it is safe to share across
+//  threads), and so an init method is not necessary. However, we do still
+//  include an alloc method for creating shared pointers.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_NETCODE_COMPRESSOR_H__
+#define __CU_NETCODE_COMPRESSOR_H__
+#include <SDL_stdinc.h>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace cugl {
+
+    /**
+     * The CUGL networking classes.
+     *
+     * This internal namespace is for optional networking package. Currently CUGL
+     * supports ad-hoc game lobbies using web-sockets. The sockets must connect
+     * connect to a CUGL game lobby server.
+     */
+    namespace net {
+
+/**
+ * This class is a block compressor for network messages.
+ *
+ * The compressed format is a sequence of LZ4-style sequences: a token byte with
+ * the literal and match lengths, the literal bytes, and a two byte offset back
+ * into the output. Matches may reach back up to 64 KB. Compression only takes a
+ * single pass with a small hash table, so it is cheap enough to run on every
+ * large message. Decompression is bounds checked, and so it is safe to run on
+ * untrusted data.
+ *
+ * A compressor may have a preset dictionary. The dictionary acts as if it were
+ * placed right before every message, so matches can refer to it. This is what
+ * makes small messages compress: a 500 byte snapshot has little redundancy on
+ * its own, but a lot in common with other snapshots. Use {@link #train} to build
+ * a dictionary from sample messages. Both sides must use the same dictionary,
+ * which is identified by {@link #getDictionaryHash}.
+ *
+ * A compressor is never modified once it is constructed, and so it is safe to
+ * use the same compressor from several threads at once.
+ */
+class NetcodeCompressor {
+private:
+    /** The preset dictionary (empty for none) */
+    std::vector<std::byte> _dictionary;
+    /** The hash of the preset dictionary (0 for none) */
+    Uint32 _hash;
+    /** The match table primed with the dictionary positions */
+    std::vector<Uint32> _table;
+
+public:
+    /**
+     * Creates a new compressor with the given preset dictionary.
+     *
+     * Only the last 64 KB of the dictionary can be reached by a match, so any
+     * bytes before that are ignored. An empty dictionary means no dictionary.
+     *
+     * @param dictionary    The preset dictionary
+     */
+    NetcodeCompressor(const std::vector<std::byte>& dictionary = std::vector<std::byte>());
+
+    /**
+     * Returns a newly created compressor with the given preset dictionary.
+     *
+     * Only the last 64 KB of the dictionary can be reached by a match, so any
+     * bytes before that are ignored. An empty dictionary means no dictionary.
+     *
+     * @param dictionary    The preset dictionary
+     *
+     * @return a newly created compressor with the given preset dictionary.
+     */
+    static std::shared_ptr<NetcodeCompressor> alloc(const std::vector<std::byte>& dictionary = std::vector<std::byte>()) {
+        return std::make_shared<NetcodeCompressor>(dictionary);
+    }
+
+#pragma mark Attributes
+    /**
+     * Returns true if this compressor has a preset dictionary.
+     *
+     * @return true if this compressor has a preset dictionary.
+     */
+    bool hasDictionary() const { return !_dictionary.empty(); }
+
+    /**
+     * Returns the preset dictionary of this compressor.
+     *
+     * @return the preset dictionary of this compressor.
+     */
+    const std::vector<std::byte>& getDictionary() const { return _dictionary; }
+
+    /**
+     * Returns the hash identifying the preset dictionary.
+     *
+     * Two compressors with the same dictionary have the same hash. This value
+     * is 0 if there is no dictionary.
+     *
+     * @return the hash identifying the preset dictionary.
+     */
+    Uint32 getDictionaryHash() const { return _hash; }
+
+#pragma mark Compression
+    /**
+     * Compresses the given data, appending it to the end of dst.
+     *
+     * If the data would not get strictly smaller, this method returns false and
+     * dst may be left with partial output. The caller should then truncate dst
+     * and send the data as is. The original size is not part of the output, and
+     * must be stored separately for {@link #decompress}.
+     *
+     * @param data          The data to compress
+     * @param size          The number of bytes to compress
+     * @param dst           The buffer to append to
+     * @param dictionary    Whether to use the preset dictionary
+     *
+     * @return true if the data was compressed
+     */
+    bool compress(const std::byte* data, size_t size, std::vector<std::byte>& dst, bool dictionary) const;
+
+    /**
+     * Decompresses the given data, appending it to the end of dst.
+     *
+     * The original size must be the size of the data before compression. This
+     * method returns false if the data is malformed or does not decompress to
+     * exactly that size. In that case dst may be left with partial output.
+     *
+     * @param data          The data to decompress
+     * @param size          The number of bytes to decompress
+     * @param original      The size of the data before compression
+     * @param dst           The buffer to append to
+     * @param dictionary    Whether the data was compressed with the preset dictionary
+     *
+     * @return true if the data was decompressed
+     */
+    bool decompress(const std::byte* data, size_t size, size_t original,
+                    std::vector<std::byte>& dst, bool dictionary) const;
+
+    /**
+     * Returns a preset dictionary trained on the given samples.
+     *
+     * The samples should be typical messages, such as the output of a
+     * {@link NetcodeSerializer} for a handful of game states. The dictionary
+     * is assembled from the byte segments that occur in the most samples, with
+     * the most common ones last (closest to the message). It is at most the
+     * given capacity, which cannot exceed 64 KB.
+     *
+     * @param samples   The sample messages
+     * @param capacity  The maximum size of the dictionary
+     *
+     * @return a preset dictionary trained on the given samples.
+     */
+    static std::vector<std::byte> train(const std::vector<std::vector<std::byte>>& samples, size_t capacity);
+};
+
+    }
+}
+
+#endif /* __CU_NETCODE_COMPRESSOR_H__ */
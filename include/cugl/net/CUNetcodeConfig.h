@@ -80,6 +80,29 @@ class JsonValue;
  */
 class NetcodeConfig {
 public:
+    /**
+     * This enum represents how the players of a room are connected.
+     *
+     * All players in a room must use the same topology.
+     */
+    enum class Topology : int {
+        /**
+         * Every player has a peer connection to every other player.
+         *
+         * This has the lowest latency, but every broadcast costs N-1 sends on
+         * every player. This is the default.
+         */
+        MESH = 0,
+        /**
+         * Clients only have a peer connection to the host.
+         *
+         * Messages between clients are relayed by the host. This doubles the
+         * latency between clients, but a client only ever sends once per
+         * broadcast. This is recommended for rooms of eight or more players.
+         */
+        STAR = 1
+    };
+    
     /** Whether the lobby requires an SSL connection */
     bool secure;
     
@@ -88,6 +111,14 @@ public:
     
     /** The collection of STUN/TURN servers to use (default None) */
     std::vector<ICEAddress> iceServers;
+
+    /**
+     * The maximum number of TURN servers offered to each peer (default 0 for all)
+     *
+     * The ICE servers are ranked by their round trip time (see
+     * {@link NetworkLayer#rank}), so this keeps only the nearest relays.
+     */
+    size_t maxRelays;
     
     /** Whether to multiplex connections over a single UDP port (default false) */
     bool multiplex;
@@ -101,12 +132,30 @@ public:
     /** The maximum transmission unit (default 0 for automatic) */
     uint16_t mtu;
     
-    /** The maximum message size (default 0 for automatic) */
+    /**
+     * The maximum message size (default 0 for automatic)
+     *
+     * This is the largest message a data channel can send at once. Larger
+     * messages are split into fragments by {@link NetcodeChannel}.
+     */
     size_t maxMessage;
     
     /** The maximum number of players allowed (default 2) */
     uint16_t maxPlayers;
     
+    /** How the players are connected (default MESH) */
+    Topology topology;
+    
+    /**
+     * Whether this connection only watches the game (default false)
+     *
+     * A spectator only connects to the host, whatever the topology. It
+     * cannot send gameplay messages to the other players, and it never
+     * accepts a promotion to host. The host announces the spectators to its
+     * clients, and does not include them in any broadcast.
+     */
+    bool spectator;
+    
     /**
      * The API version number.
      *
@@ -148,11 +197,14 @@ public:
      *
      *      "secure":       A boolean indicating if the lobby uses SSL
      *      "ICE servers":  A list of {@link ICEAddress} JSONs
+     *      "max relays":   An int representing the maximum number of TURN servers
      *      "multiplex":    A boolean specifying whether to use UDP multiplexing
      *      "port range":   A list pair of the ports to scan
      *      "MTU":          An int representing the maximum transmission unit
      *      "max message":  An int respresenting the maximum transmission size
      *      "max players":  An int respresenting the maximum number of players
+     *      "topology":     Either "mesh" or "star"
+     *      "spectator":    A boolean indicating if this connection only watches
      *      "API version":  An int respresenting the API version
      *
      * @param prefs     The configuration settings
@@ -229,11 +281,14 @@ public:
      *
      *      "secure":       A boolean indicating if the lobby uses SSL
      *      "ICE servers":  A list of {@link ICEAddress} JSONs
+     *      "max relays":   An int representing the maximum number of TURN servers
      *      "multiplex":    A boolean specifying whether to use UDP multiplexing
      *      "port range":   A list pair of the ports to scan
      *      "MTU":          An int representing the maximum transmission unit
      *      "max message":  An int respresenting the maximum transmission size
      *      "max players":  An int respresenting the maximum number of players
+     *      "topology":     Either "mesh" or "star"
+     *      "spectator":    A boolean indicating if this connection only watches
      *      "API version":  An int respresenting the API version
      *
      * @param pref      The address settings
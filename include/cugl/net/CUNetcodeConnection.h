@@ -60,10 +60,17 @@
 #ifndef __CU_NETCODE_CONNECTION_H__
 #define __CU_NETCODE_CONNECTION_H__
 #include <cugl/net/CUNetcodeConfig.h>
+#include <cugl/net/CUNetcodeStats.h>
+#include <cugl/net/CUNetcodeCompressor.h>
+#include <cugl/net/CUNetcodeRecorder.h>
+#include <cugl/net/CUNetcodeSimulator.h>
+#include <cugl/net/CUNetcodeChannel.h>
+#include <cugl/util/CUMPSCQueue.h>
 #include <rtc/rtc.hpp>
 #include <unordered_map>
 #include <unordered_set>
 #include <functional>
+#include <deque>
 #include <future>
 #include <memory>
 #include <string>
@@ -87,6 +94,10 @@ class JsonValue;
 /** Forward reference to other netcode classes */
 class NetcodeChannel;
 class NetcodePeer;
+class NetcodeVoice;
+
+/** The peer handle that is never assigned to a peer */
+#define NETCODE_NO_HANDLE   0
 
 /**
  * This class to supports a connection to other players with a peer-to-peer interface.
@@ -105,6 +116,13 @@ class NetcodePeer;
  * with calls to {@link #sendTo}. That way clients can send to the host and the host can
  * broadcast its responses.
  *
+ * By default every player has a peer connection to every other player (a mesh).
+ * For large rooms, set {@link NetcodeConfig#topology} to STAR. Clients then only
+ * connect to the host, and the host relays messages between clients. The API is
+ * the same in both cases, and messages keep their original source. A client sends
+ * a broadcast only once, and the host forwards the same shared buffer to all of the
+ * other clients, so the uplink of a client no longer grows with the room size.
+ *
  * Using this class requires an external lobby websocket server to enable Web RTC data
  * channels. This server does not handle actual game data. In only connects that players,
  * an occasionally monitors for disconnects requiring host migration. This reduces
@@ -205,6 +223,33 @@ public:
         DISPOSED   = 10
     };
     
+    /**
+     * An enum representing the delivery lane of a message.
+     *
+     * Every peer connection has two data channels. The reliable lane is ordered
+     * and retransmits lost messages. It should be used for any message that
+     * changes the game state, such as object creation or ownership. The
+     * unreliable lane is unordered and never retransmits. It should be used for
+     * state snapshots, where a late message is worse than a lost one.
+     *
+     * The unreliable lane is opened after the reliable lane. Messages sent on
+     * the unreliable lane before it is open are sent on the reliable lane instead.
+     *
+     * The bulk lane is for large transfers, such as the world state for a player
+     * that joins late. It shares the reliable data channel, and so it is ordered
+     * and reliable. But when scheduling is enabled (see {@link #setBandwidth}),
+     * it only uses the bandwidth left over by the other two lanes. The lanes
+     * are listed in order of priority.
+     */
+    enum class Lane : int {
+        /** The reliable, ordered data channel */
+        RELIABLE   = 0,
+        /** The unreliable, unordered data channel */
+        UNRELIABLE = 1,
+        /** The reliable data channel, at the lowest priority */
+        BULK       = 2
+    };
+    
 #pragma mark Callbacks
     /**
      * @typedef ConnectionCallback
@@ -293,13 +338,78 @@ public:
      *
      * The function type is equivalent to
      *
-     *      const std::function<void(const std::string source,
+     *      const std::function<void(const std::string& source,
      *                               const std::vector<std::byte>& message)>
      * 
      * @param source    The message source
      * @param message   The message data
      */
-    typedef std::function<void(const std::string source, const std::vector<std::byte>& message)> Dispatcher;
+    typedef std::function<void(const std::string& source, const std::vector<std::byte>& message)> Dispatcher;
+    
+    /**
+     * @typedef Consumer
+     *
+     * The consumer is called by the {@link #consume} function to take data from
+     * the message buffer. It is identical to {@link Dispatcher}, except that the
+     * message data is moved to the consumer. This allows the consumer to keep the
+     * message without copying it.
+     *
+     * The function type is equivalent to
+     *
+     *      const std::function<void(const std::string& source,
+     *                               std::vector<std::byte>&& message)>
+     *
+     * @param source    The message source
+     * @param message   The message data
+     */
+    typedef std::function<void(const std::string& source, std::vector<std::byte>&& message)> Consumer;
+
+    /**
+     * @typedef PeerHandle
+     *
+     * A peer handle is a compact identifier for a message source. Handles are
+     * assigned by this connection the first time it sees a UUID, and are never
+     * reused for the lifetime of the connection. The value {@link NETCODE_NO_HANDLE}
+     * is never assigned to a peer. Use {@link #getPeerName} and {@link #getPeerHandle}
+     * to convert between handles and UUIDs.
+     */
+    typedef Uint32 PeerHandle;
+
+    /**
+     * @typedef HandleConsumer
+     *
+     * The handle consumer is called by the {@link #consumeByHandle} function to
+     * take data from the message buffer. It is identical to {@link Consumer},
+     * except that the source is a {@link PeerHandle}. This avoids copying or
+     * comparing a UUID string for every message.
+     *
+     * The function type is equivalent to
+     *
+     *      const std::function<void(PeerHandle source,
+     *                               std::vector<std::byte>&& message)>
+     *
+     * @param source    The message source handle
+     * @param message   The message data
+     */
+    typedef std::function<void(PeerHandle source, std::vector<std::byte>&& message)> HandleConsumer;
+
+    /**
+     * @typedef Scheduler
+     *
+     * The scheduler is called to deliver user callbacks to the thread that owns
+     * this connection. Network events arrive on the threads of the network layer,
+     * so the callbacks ({@link #onStateChange}, {@link #onReceipt}, and so on) are
+     * never invoked directly. Instead they are handed to the scheduler, which
+     * should invoke them on the owning thread. The callback returns true if it
+     * should be invoked again, just like {@link Application#schedule}.
+     *
+     * The function type is equivalent to
+     *
+     *      const std::function<void(std::function<bool()> callback)>
+     *
+     * @param callback  The callback to deliver
+     */
+    typedef std::function<void(std::function<bool()> callback)> Scheduler;
      
 private:
     /**
@@ -312,12 +422,21 @@ private:
     class Envelope {
     public:
         /** The message source */
-        std::string source;
+        PeerHandle source;
         /** The message (as a byte vector) */
         std::vector<std::byte> message;
         
         /** Creates an empty message envelope */
-        Envelope() {}
+        Envelope() : source(NETCODE_NO_HANDLE) {}
+        
+        /**
+         * Creates a message envelope acquiring the given message
+         *
+         * @param src   The message source
+         * @param msg   The message to acquire
+         */
+        Envelope(PeerHandle src, std::vector<std::byte>&& msg) :
+        source(src), message(std::move(msg)) {}
         
         /**
          * Creates a copy of the given message envelope
@@ -335,7 +454,7 @@ private:
          * @param env the message envelope to acquire
          */
         Envelope(Envelope&& env) {
-            source  = std::move(env.source);
+            source  = env.source;
             message = std::move(env.message); 
          }
         
@@ -356,12 +475,67 @@ private:
          * @param env the message envelope to acquire
          */
         Envelope& operator=(Envelope&& env) {
-            source  = std::move(env.source);
+            source  = env.source;
             message = std::move(env.message); 
             return *this;
         }
     };
     
+    /**
+     * A message waiting for the scheduler.
+     *
+     * When scheduling is enabled, messages are queued by lane instead of being
+     * sent immediately. They are sent by {@link #flush} in order of priority.
+     */
+    struct Scheduled {
+        /** The UUID of the peer to receive the message (or skip, for a fanout) */
+        std::string dst;
+        /** Whether the message goes to every peer but dst */
+        bool fanout;
+        /** The delivery lane */
+        Lane lane;
+        /** The message data */
+        NetcodeMessage message;
+        /** The bytes this message costs the bandwidth (across all peers) */
+        size_t cost;
+    };
+    
+    /**
+     * An immutable snapshot of the peers and players of this connection.
+     *
+     * The peer set changes rarely, but is read on every send. So whenever it
+     * changes, the connection publishes a new snapshot (copy-on-write). The
+     * send methods and the accessors read the latest snapshot without taking
+     * the lock for this connection.
+     */
+    struct Roster {
+        /** The peer connections */
+        std::unordered_map<std::string, std::shared_ptr<NetcodePeer>> peers;
+        /** The active connection UUIDs (including this connection) */
+        std::unordered_set<std::string> players;
+        /** The players (a subset of players) that only watch the game */
+        std::unordered_set<std::string> spectators;
+        /** The globally unique identifer for the host connection */
+        std::string host;
+        /** The UUID for each peer handle (the first is always empty) */
+        std::vector<std::shared_ptr<const std::string>> names;
+        /** The peer handle for each UUID */
+        std::unordered_map<std::string, PeerHandle> handles;
+        
+        /**
+         * Returns the UUID for the given peer handle.
+         *
+         * This method returns the empty string if the handle is not valid.
+         *
+         * @param handle    The peer handle
+         *
+         * @return the UUID for the given peer handle.
+         */
+        const std::string& getName(PeerHandle handle) const {
+            return *names[handle < names.size() ? handle : NETCODE_NO_HANDLE];
+        }
+    };
+    
     /** The configuration of this connection */
     NetcodeConfig _config;
     /** The RTC equivalent */
@@ -386,8 +560,20 @@ private:
     std::shared_ptr<rtc::WebSocket> _socket;
     /** The associated RTC peer connections */
     std::unordered_map<std::string, std::shared_ptr<NetcodePeer>> _peers;
+    /** A peer connection created ahead of time, before we know who it is for */
+    std::shared_ptr<NetcodePeer> _spare;
     /** The active connection UUIDs (including this connection) */
     std::unordered_set<std::string> _players;
+    /** The players that have announced that they only watch the game */
+    std::unordered_set<std::string> _spectators;
+    /** The latest snapshot of the peers and players (accessed atomically) */
+    std::shared_ptr<const Roster> _roster;
+    /** The UUID for each peer handle (the first is always empty) */
+    std::vector<std::shared_ptr<const std::string>> _names;
+    /** The peer handle for each UUID */
+    std::unordered_map<std::string, PeerHandle> _handles;
+    /** The peer handle for this connection */
+    PeerHandle _selfHandle;
     /** The total number of players when the game started */
     uint16_t _initialPlayers;
     
@@ -399,8 +585,14 @@ private:
     StateCallback _onStateChange;
     /* A user defined callback to be invoked if a player is asked to become host. */
     PromotionCallback _onPromotion;
+    /* A user defined callback to be invoked when a congested peer becomes writable. */
+    ConnectionCallback _onWritable;
     /** Alternatively make the dispatcher a callback */
     Dispatcher _onReceipt;
+    /** Whether a receipt callback is set (so that append can check without a lock) */
+    std::atomic<bool> _hasReceipt;
+    /** The scheduler for user callbacks (nullptr for the application) */
+    Scheduler _scheduler;
     /** A counter to indicate when host migration is complete */
     size_t _migration;
 
@@ -413,16 +605,55 @@ private:
      * it is possible to receive multiple network messages before a read. This buffer
      * stores this messages.
      *
-     * This is a classic ring buffer. It it fills up (because the application is too
-     * slow to read), then the oldest messages are deleted first.
+     * This is a lock-free queue, written by the data channel threads and read by
+     * {@link #receive}. Neither side ever blocks the other. If it fills up (because
+     * the application is too slow to read), the overflow policy decides whether
+     * to drop the oldest message, drop the newest message, or grow the buffer.
      */
-    std::vector<Envelope> _buffer;
-    /** The number of messages in the data ring buffer */
-    size_t _buffsize;
-    /** The head of the data ring buffer */
-    size_t _buffhead;
-    /** The tail of the data ring buffer */
-    size_t _bufftail;
+    MPSCQueue<Envelope> _inbound;
+    
+    /** The statistics counters for all peers of this connection */
+    std::shared_ptr<NetcodeCounters> _stats;
+    /** The number of messages sent to other peers */
+    std::atomic<size_t> _messagesSent;
+    /** The number of messages received from other peers */
+    std::atomic<size_t> _messagesReceived;
+    
+    /** The buffered amount at which a channel is congested, indexed by lane */
+    std::atomic<size_t> _highWater[2];
+    /** The buffered amount at which a channel is no longer congested, indexed by lane */
+    std::atomic<size_t> _lowWater[2];
+    /** How a congested channel handles new messages, indexed by lane */
+    std::atomic<NetcodeChannel::Backpressure> _backpressure[2];
+    
+    /** Whether outgoing messages are batched into MTU-sized datagrams */
+    std::atomic<bool> _batching;
+    /** The pending outgoing batches, indexed by lane and then by peer UUID */
+    std::unordered_map<std::string, std::vector<std::byte>> _batches[2];
+    
+    /** The number of bytes to send each flush (0 to disable scheduling) */
+    std::atomic<size_t> _bandwidth;
+    /** The bytes sent beyond the bandwidth in the last flush */
+    size_t _deficit;
+    /** The messages waiting for the scheduler, indexed by lane */
+    std::deque<Scheduled> _queues[3];
+    /** The maximum bytes to send each flush (0 for no limit), indexed by lane */
+    size_t _laneBudget[3];
+    /** The maximum number of queued messages (0 for no limit), indexed by lane */
+    size_t _laneDepth[3];
+    
+    /** The minimum size of a message to compress (0 to disable) */
+    std::atomic<size_t> _compression;
+    /** The codec (and dictionary) for compressed messages */
+    std::shared_ptr<NetcodeCompressor> _compressor;
+    /** The peers accepting compressed messages, with the hash of their dictionary */
+    std::unordered_map<std::string, Uint32> _codecs;
+    /** The recorder tapping this connection (accessed atomically) */
+    std::shared_ptr<NetcodeRecorder> _recorder;
+    /** The simulated network conditions of this connection (accessed atomically) */
+    std::shared_ptr<NetcodeSimulator> _simulator;
+    /** The voice chat attached to this connection (accessed atomically) */
+    std::shared_ptr<NetcodeVoice> _voice;
     
     // To prevent race conditions
     /** Whether this websocket connection prints out debugging information */
@@ -549,7 +780,77 @@ private:
      */
     void onPeerClosed(const std::string uuid);
 
+    /**
+     * Delivers the given user callback to the thread owning this connection.
+     *
+     * If there is no scheduler, the callback is scheduled with the running
+     * {@link Application}.
+     *
+     * @param callback  The callback to deliver
+     */
+    void deliver(std::function<bool()> callback);
+
+    /**
+     * Publishes a new snapshot of the peers, players and host.
+     *
+     * This method must be called (while holding the lock for this connection)
+     * after any change to these values. It returns the previous snapshot, so
+     * that the caller may release it outside of the lock.
+     *
+     * @return the previous snapshot
+     */
+    std::shared_ptr<const Roster> publish();
+    
+    /**
+     * Returns the latest snapshot of the peers, players and host.
+     *
+     * This method does not lock, and never returns nullptr.
+     *
+     * @return the latest snapshot of the peers, players and host.
+     */
+    std::shared_ptr<const Roster> getRoster() const {
+        return std::atomic_load(&_roster);
+    }
+    
+    /**
+     * Returns the peer handle for the given UUID, assigning one if necessary.
+     *
+     * If the UUID already has a handle, this method does not lock. Otherwise,
+     * it locks this connection to assign the next handle, and publishes a new
+     * snapshot. So this method must never be called while holding the lock of
+     * a peer or a channel (locking downwards).
+     *
+     * @param uuid  The peer UUID
+     *
+     * @return the peer handle for the given UUID
+     */
+    PeerHandle intern(const std::string& uuid);
+
 #pragma mark Internal Communication
+    /**
+     * Creates a spare peer connection for the next peer.
+     *
+     * Creating a peer connection is expensive (it generates a certificate),
+     * and ICE gathering takes a while on a mobile network. A spare connection
+     * gets this out of the way while the lobby is still negotiating. On a
+     * client, the spare is offered, so that ICE gathering starts right away.
+     * On the host, the spare is used to answer the next incoming offer.
+     */
+    void prewarm();
+    
+    /**
+     * Returns the spare peer connection, assigned to the given UUID.
+     *
+     * This method returns nullptr if there is no spare connection, or if it
+     * was prepared for the other role (offered versus received).
+     *
+     * @param uuid      The UUID of the peer
+     * @param offered   Whether the connection is offered (not received)
+     *
+     * @return the spare peer connection, assigned to the given UUID.
+     */
+    std::shared_ptr<NetcodePeer> claimSpare(const std::string uuid, bool offered);
+    
     /**
      * Offers a peer connection to the host with the given UUID
      *
@@ -610,17 +911,324 @@ private:
      *
      * This method is used to store an incoming message for later consumption.
      *
-     * @param source    The message source
+     * @param source    The message source handle
+     * @param data      The message data
+     *
+     * @return if the message was successfully added to the buffer.
+     */
+    bool append(PeerHandle source, const std::vector<std::byte>& data);
+    
+    /**
+     * Appends the given data to the ring buffer.
+     *
+     * This method is used to store an incoming message for later consumption.
+     * This version acquires the message data, and does not copy it. It is the
+     * version used for all messages arriving on a data channel.
+     *
+     * @param source    The message source handle
      * @param data      The message data
      *
      * @return if the message was successfully added to the buffer.
      */
-    bool append(const std::string source, const std::vector<std::byte>& data);
+    bool append(PeerHandle source, std::vector<std::byte>&& data);
+    
+    /**
+     * Returns the data channel of the given peer for the specified lane.
+     *
+     * If the unreliable lane is requested but is not yet open, this method
+     * returns the reliable channel instead. It returns nullptr if the peer has
+     * no open channel at all. This method locks the peer, and so must never be
+     * called while holding the lock of another peer (locking downwards).
+     *
+     * @param peer  The peer connection
+     * @param lane  The delivery lane
+     *
+     * @return the data channel of the given peer for the specified lane.
+     */
+    std::shared_ptr<NetcodeChannel> getLaneChannel(const std::shared_ptr<NetcodePeer>& peer, Lane lane);
+    
+    /**
+     * Adds the message to the outgoing batch for the given peer and lane.
+     *
+     * If the message does not fit in the current batch, the batch is moved to
+     * ready and a new batch is started. If the message is too large to batch
+     * at all, it is moved to ready (after the current batch) as is. The datagrams
+     * in ready must be sent immediately, in order.
+     *
+     * This method must be called while holding the lock for this connection.
+     *
+     * @param dst   The UUID of the peer to receive the message
+     * @param lane  The delivery lane
+     * @param data  The message to batch
+     * @param ready The datagrams that must be sent now
+     */
+    void batch(const std::string& dst, Lane lane, const std::vector<std::byte>& data,
+               std::vector<std::vector<std::byte>>& ready);
+    
+    /**
+     * Processes a datagram received from a data channel.
+     *
+     * If the datagram is a batch, it is unpacked into its individual messages,
+     * which are appended to the ring buffer in order. Otherwise the datagram is
+     * appended as is.
+     *
+     * @param source    The message source handle
+     * @param data      The datagram
+     * @param lane      The lane the datagram arrived on
+     */
+    void unbatch(PeerHandle source, std::vector<std::byte>&& data, Lane lane);
+    
+    /**
+     * Returns the message to send to the given peer in place of data.
+     *
+     * If the threshold is not 0, the peer accepts compressed messages, and the
+     * data is large enough, this method returns a compressed frame (using the
+     * dictionary if the peer has the same one). A message that begins with the
+     * compression marker is escaped. Otherwise, this method returns message,
+     * the shared buffer for data. A result of nullptr means data is sent as is.
+     *
+     * Frames are cached in frames (indexed by codec), so that a broadcast only
+     * compresses a message once per codec. The bitmask tried records which
+     * codecs have been attempted. This method must be called while holding the
+     * lock for this connection, unless the threshold is 0.
+     *
+     * @param dst       The UUID of the peer to receive the message
+     * @param data      The message to send
+     * @param message   The shared buffer for data (nullptr for none)
+     * @param threshold The compression threshold (0 for no compression)
+     * @param frames    The frames encoded so far for this message
+     * @param tried     The codecs attempted so far for this message
+     *
+     * @return the message to send to the given peer in place of data.
+     */
+    NetcodeMessage encode(const std::string& dst, const std::vector<std::byte>& data,
+                          const NetcodeMessage& message, size_t threshold,
+                          NetcodeMessage* frames, Uint8& tried);
+    
+    /**
+     * Sends a byte array to the specified connection.
+     *
+     * This is the implementation of both versions of {@link #sendTo}. If message
+     * is not nullptr, it must hold the same bytes as data, and it is shared by the
+     * send stack instead of data being copied.
+     *
+     * @param dst       The UUID of the peer to receive the message
+     * @param data      The byte array to send.
+     * @param message   The shared buffer for data (nullptr for none)
+     * @param lane      The delivery lane
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool sendTo(const std::string dst, const std::vector<std::byte>& data,
+                const NetcodeMessage& message, Lane lane);
+    
+    /**
+     * Sends a byte array along the peer connection with the given UUID.
+     *
+     * This is the shared back end of all of the send methods. It does not
+     * relay, and it does not record the message. If message is not nullptr,
+     * it must hold the same bytes as data, and it is shared by the send stack
+     * instead of data being copied. This method must NOT be called while
+     * holding the lock for this connection.
+     *
+     * If scheduling is enabled, the message is queued for {@link #flush}
+     * instead, unless direct is true.
+     *
+     * @param dst       The UUID of the peer connection
+     * @param data      The byte array to send.
+     * @param message   The shared buffer for data (nullptr for none)
+     * @param lane      The delivery lane
+     * @param direct    Whether to bypass the scheduler
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool transmit(const std::string& dst, const std::vector<std::byte>& data,
+                  const NetcodeMessage& message, Lane lane, bool direct=false);
+    
+    /**
+     * Sends a byte array along every peer connection but the given one.
+     *
+     * Like {@link #transmit}, this method does not relay, and it does not
+     * record the message. If message is not nullptr, it must hold the same
+     * bytes as data, and it is shared by every channel instead of data being
+     * copied for each peer. Spectators are always skipped. This method must
+     * NOT be called while holding the lock for this connection.
+     *
+     * If scheduling is enabled, the message is queued for {@link #flush}
+     * instead, unless direct is true.
+     *
+     * @param data      The byte array to send.
+     * @param message   The shared buffer for data (nullptr for none)
+     * @param lane      The delivery lane
+     * @param except    The UUID of the peer to skip (empty for none)
+     * @param direct    Whether to bypass the scheduler
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool fanout(const std::vector<std::byte>& data, const NetcodeMessage& message,
+                Lane lane, const std::string& except, bool direct=false);
+    
+    /**
+     * Queues a message for the scheduler.
+     *
+     * If the queue for the lane is at its depth limit, the oldest message is
+     * dropped for the unreliable lane (it is a stale snapshot). For the other
+     * lanes, the new message is rejected and this method returns false. This
+     * method must NOT be called while holding the lock for this connection.
+     *
+     * @param dst       The UUID of the peer to receive the message (or skip)
+     * @param fanout    Whether the message goes to every peer but dst
+     * @param data      The byte array to send.
+     * @param message   The shared buffer for data (nullptr for none)
+     * @param lane      The delivery lane
+     *
+     * @return true if the message was queued
+     */
+    bool enqueue(const std::string& dst, bool fanout, const std::vector<std::byte>& data,
+                 const NetcodeMessage& message, Lane lane);
+    
+    /**
+     * Removes the messages to send this flush from the scheduler queues.
+     *
+     * The reliable lane is never held back. The unreliable lane is sent up to
+     * its budget, and the bulk lane only uses what is left of the bandwidth. A
+     * lane always sends its next message if there is any bandwidth left, so a
+     * flush may go over the bandwidth. The excess is taken from the next flush.
+     * If scheduling is disabled, every queued message is removed.
+     *
+     * This method must be called while holding the lock for this connection.
+     *
+     * @param sends The messages to send, in order
+     */
+    void schedule(std::vector<Scheduled>& sends);
+    
+    /**
+     * Sends a byte array to the host player.
+     *
+     * This is the implementation of both versions of {@link #sendToHost}. If
+     * message is not nullptr, it must hold the same bytes as data, and it is
+     * shared by the send stack instead of data being copied.
+     *
+     * @param data      The byte array to send.
+     * @param message   The shared buffer for data (nullptr for none)
+     * @param lane      The delivery lane
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool sendToHost(const std::vector<std::byte>& data, const NetcodeMessage& message, Lane lane);
+    
+    /**
+     * Sends a byte array to all other players.
+     *
+     * This is the implementation of both versions of {@link #broadcast}. If
+     * message is not nullptr, it must hold the same bytes as data, and it is
+     * shared by every channel instead of data being copied for each peer.
+     *
+     * @param data      The byte array to send.
+     * @param message   The shared buffer for data (nullptr for none)
+     * @param lane      The delivery lane
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool broadcast(const std::vector<std::byte>& data, const NetcodeMessage& message, Lane lane);
+    
+    /**
+     * Processes a single message received from a data channel.
+     *
+     * If the message is a compression frame, it is decompressed (or unescaped)
+     * before it is appended to the ring buffer. Compression handshakes from the
+     * peer are consumed, and never appended.
+     *
+     * @param source    The message source handle
+     * @param data      The message
+     * @param lane      The lane the message arrived on
+     *
+     * @return true if a message was appended to the ring buffer
+     */
+    bool decode(PeerHandle source, std::vector<std::byte>&& data, Lane lane);
+    
+    /**
+     * Processes a single decoded message received from a data channel.
+     *
+     * In the star topology, this unwraps any relay frame. If this connection
+     * is the host, and the message is addressed to other players, it is
+     * forwarded along the same lane. Otherwise the message is appended to the
+     * ring buffer with its original source.
+     *
+     * @param source    The message source handle
+     * @param data      The message
+     * @param lane      The lane the message arrived on
+     *
+     * @return true if a message was appended to the ring buffer
+     */
+    bool deliver(PeerHandle source, std::vector<std::byte>&& data, Lane lane);
+    
+    /**
+     * Records that the given player is a spectator.
+     *
+     * The host learns of a spectator from the control frame that it sends
+     * once their peer connection is established. In the star topology, the
+     * host then announces the spectator to every other client. This method
+     * must NOT be called while holding the lock for this connection.
+     *
+     * @param uuid  The UUID of the spectator
+     */
+    void addSpectator(const std::string& uuid);
+    
+    /**
+     * Returns true if this connection uses the star topology.
+     *
+     * The configuration cannot change once the connection is initialized, so
+     * this method does not require a lock.
+     *
+     * @return true if this connection uses the star topology.
+     */
+    bool isStar() const {
+        return _config.topology == NetcodeConfig::Topology::STAR;
+    }
+    
+    /**
+     * Called when a congested data channel drains to its low watermark
+     *
+     * This method schedules the {@link #onWritable} callback (if any).
+     *
+     * @param uuid  The UUID of the peer for the data channel
+     */
+    void onChannelWritable(const std::string uuid);
+    
+    /**
+     * Sets the voice chat attached to this connection.
+     *
+     * While a voice chat is attached, every message starting with
+     * {@link NETCODE_VOICE_MARKER} is given to it on the network thread,
+     * and never reaches {@link #receive}. The connection keeps the voice
+     * chat alive until it is replaced or this connection is disposed.
+     *
+     * @param voice The voice chat for this connection
+     */
+    void setVoice(const std::shared_ptr<NetcodeVoice>& voice) {
+        std::atomic_store(&_voice,voice);
+    }
+    
+    /**
+     * Sends a voice frame to all other players.
+     *
+     * This method is like {@link #broadcast} on the unreliable lane, except
+     * that the frame is neither recorded nor delivered to this connection.
+     * Like any other message, a voice frame is batched and scheduled if those
+     * features are enabled, and so leaves on the next {@link #flush}.
+     *
+     * @param message   The voice frame to send.
+     *
+     * @return true if the frame was (apparently) sent
+     */
+    bool sendVoice(const NetcodeMessage& message);
     
     /** Allow access to the other netcode classes */
     friend class NetcodeManager;
     friend class NetcodeChannel;
     friend class NetcodePeer;
+    friend class NetcodeVoice;
 
 public: 
 #pragma mark Static Allocators
@@ -699,11 +1307,9 @@ public:
     /**
      * Returns the UUID for the (current) game host
      *
-     * This method is not const because it requires a lock.
-     *
      * @return the UUID for the (current) game host
      */
-    const std::string getHost();
+    const std::string getHost() const;
 
     /**
      * Returns true if this connection is open
@@ -757,9 +1363,57 @@ public:
      * Note that this is NOT the same as the capacity of a single message. That value
      * was set as part of the initial {@link NetcodeConfig}.
      *
+     * This method should only be called on the same thread as {@link #receive}.
+     *
      * @param capacity  The new message buffer capacity.
      */
     void setCapacity(size_t capacity);
+    
+    /**
+     * Returns the overflow policy of the message buffer.
+     *
+     * This policy decides what happens when a message arrives and the message
+     * buffer is full. By default, the oldest message is dropped.
+     *
+     * @return the overflow policy of the message buffer.
+     */
+    OverflowPolicy getOverflowPolicy() const { return _inbound.getPolicy(); }
+    
+    /**
+     * Sets the overflow policy of the message buffer.
+     *
+     * This policy decides what happens when a message arrives and the message
+     * buffer is full. By default, the oldest message is dropped. With the policy
+     * {@link OverflowPolicy#GROW}, no messages are dropped and the capacity is
+     * increased as necessary.
+     *
+     * @param policy    The overflow policy of the message buffer.
+     */
+    void setOverflowPolicy(OverflowPolicy policy) { _inbound.setPolicy(policy); }
+    
+    /**
+     * Returns the number of incoming messages dropped because the buffer was full.
+     *
+     * @return the number of incoming messages dropped because the buffer was full.
+     */
+    size_t getDroppedMessages() const { return _inbound.getDropped(); }
+    
+    /**
+     * Returns the network statistics for this connection.
+     *
+     * The statistics include the bytes and packets sent and received across all
+     * peers, the number of messages sent and received, the number of incoming
+     * messages dropped because the message buffer was full, and the number of
+     * messages waiting in that buffer. Use {@link NetcodePeer#getStats} for the
+     * round trip time of an individual peer.
+     *
+     * All of these values are atomic, so this method never takes a lock. However,
+     * the queue depth is only accurate when called on the same thread as
+     * {@link #receive}.
+     *
+     * @return the network statistics for this connection.
+     */
+    NetcodeStats getStats() const;
 
     /**
      * Returns the room ID or empty string.
@@ -781,11 +1435,24 @@ public:
      * This vector stores the UUIDs of all the players who are currently playing the
      * game. This list will continually update as players join and leave the game.
      *
-     * This method is not const because it requires a lock.
+     * This method copies the latest snapshot of the players, but does not lock.
+     * Use {@link #getPlayerView} to avoid the copy.
      *
      * @return the list of active players
      */
-    const std::unordered_set<std::string> getPlayers();
+    const std::unordered_set<std::string> getPlayers() const;
+
+    /**
+     * Returns a read-only snapshot of the active players
+     *
+     * This is the same set as {@link #getPlayers}, but it is neither copied nor
+     * locked. The snapshot never changes. Instead, the connection publishes a
+     * new one whenever the players change, so this method should be called
+     * again to see the latest players.
+     *
+     * @return a read-only snapshot of the active players
+     */
+    std::shared_ptr<const std::unordered_set<std::string>> getPlayerView() const;
     
     /**
      * Returns the list of peer connections for this websocket connection
@@ -796,33 +1463,69 @@ public:
      * be initiated through the websocket. It is provided for debugging purposes
      * only.
      *
-     * This method is not const because it requires a lock.
+     * This method copies the latest snapshot of the peers, but does not lock.
+     * Use {@link #getPeerView} to avoid the copy.
      *
      * @return the list of peer connections for this websocket connection
      */
-    const std::unordered_map<std::string, std::shared_ptr<NetcodePeer>> getPeers();
+    const std::unordered_map<std::string, std::shared_ptr<NetcodePeer>> getPeers() const;
+
+    /**
+     * Returns a read-only snapshot of the peer connections
+     *
+     * This is the same map as {@link #getPeers}, but it is neither copied nor
+     * locked. The snapshot never changes. Instead, the connection publishes a
+     * new one whenever the peers change, so this method should be called
+     * again to see the latest peers.
+     *
+     * @return a read-only snapshot of the peer connections
+     */
+    std::shared_ptr<const std::unordered_map<std::string, std::shared_ptr<NetcodePeer>>> getPeerView() const;
     
     /**
      * Returns true if the given player UUID is currently connected to the game.
      *
-     * This method is not const because it requires a lock.
-     *
      * @param player    The player to test for connection
      *
      * @return true if the given player UUID is currently connected to the game.
      */
-    bool isPlayerActive(const std::string player);
+    bool isPlayerActive(const std::string player) const;
+    
+    /**
+     * Returns the peer handle for the given UUID.
+     *
+     * Handles are assigned to peers the first time this connection receives a
+     * message from them (this connection always has a handle). This method
+     * returns {@link NETCODE_NO_HANDLE} if the UUID does not have a handle yet.
+     * It does not lock.
+     *
+     * @param uuid  The peer UUID
+     *
+     * @return the peer handle for the given UUID.
+     */
+    PeerHandle getPeerHandle(const std::string& uuid) const;
+    
+    /**
+     * Returns the UUID for the given peer handle.
+     *
+     * The UUID is shared, so that it may be attached to every message from a
+     * peer without copying it. This method returns an empty string (never
+     * nullptr) if the handle is not valid. It does not lock.
+     *
+     * @param handle    The peer handle
+     *
+     * @return the UUID for the given peer handle.
+     */
+    std::shared_ptr<const std::string> getPeerName(PeerHandle handle) const;
 
     /**
      * Returns the number of players currently connected to this game 
      *
      * This does not include any players that have been disconnected.
      *
-     * This method is not const because it requires a lock.
-     *
      * @return the number of players currently connected to this game 
      */
-    size_t getNumPlayers();
+    size_t getNumPlayers() const;
 
     /**
      * Returns the number of players present when the game was started
@@ -836,6 +1539,54 @@ public:
      */
     size_t getTotalPlayers();
     
+    /**
+     * Returns true if this connection only watches the game.
+     *
+     * A spectator only connects to the host, and never accepts a promotion
+     * to host. See {@link NetcodeConfig#spectator}.
+     *
+     * @return true if this connection only watches the game.
+     */
+    bool isSpectator() const {
+        return _config.spectator;
+    }
+    
+    /**
+     * Returns true if the given player only watches the game.
+     *
+     * Spectators are still players (see {@link #getPlayers}), but broadcasts
+     * never reach them. Only the host is guaranteed to know every spectator.
+     * In the star topology, the host announces them to the other clients. In
+     * the mesh topology, the other clients never connect to them at all.
+     *
+     * This method does not lock.
+     *
+     * @param uuid  The UUID of the player
+     *
+     * @return true if the given player only watches the game.
+     */
+    bool isSpectator(const std::string& uuid) const;
+    
+    /**
+     * Returns a read-only snapshot of the spectators
+     *
+     * This is the subset of {@link #getPlayers} that only watch the game. Like
+     * {@link #getPlayerView}, it is neither copied nor locked, and a new
+     * snapshot is published whenever the spectators change.
+     *
+     * @return a read-only snapshot of the spectators
+     */
+    std::shared_ptr<const std::unordered_set<std::string>> getSpectatorView() const;
+    
+    /**
+     * Returns the number of spectators currently connected to this game
+     *
+     * These are included in {@link #getNumPlayers}.
+     *
+     * @return the number of spectators currently connected to this game
+     */
+    size_t getNumSpectators() const;
+    
 #pragma mark Communication
     /**
      * Opens the connection to the game lobby sever
@@ -894,8 +1645,59 @@ public:
      *
      * @return true if the message was (apparently) sent
      */
+    bool sendTo(const std::string dst, const std::vector<std::byte>& data) {
+        return sendTo(dst,data,Lane::RELIABLE);
+    }
+
+    /**
+     * Sends a byte array to the specified connection along the given lane.
+     *
+     * This method is identical to {@link #sendTo}, except that it allows the
+     * user to choose the delivery lane. Messages on the {@link Lane#UNRELIABLE}
+     * lane are not guaranteed to be ordered, or even to arrive at all. They are
+     * intended for state snapshots that are superseded by the next snapshot.
+     *
+     * This requires a connection be established. Otherwise it will return false. It
+     * will also return false if the host is currently migrating.
+     *
+     * @param dst   The UUID of the peer to receive the message
+     * @param data  The byte array to send.
+     * @param lane  The delivery lane
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool sendTo(const std::string dst, const std::vector<std::byte>& data, Lane lane);
 
-    bool sendTo(const std::string dst, const std::vector<std::byte>& data);
+    /**
+     * Sends a shared message buffer to the specified connection.
+     *
+     * This method is identical to {@link #sendTo}, except that the message is
+     * never copied on its way to the data channel. If this connection is the
+     * recipient, the message is still copied into the receipt buffer.
+     *
+     * @param dst       The UUID of the peer to receive the message
+     * @param message   The message to send.
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool sendTo(const std::string dst, const NetcodeMessage& message) {
+        return sendTo(dst,message,Lane::RELIABLE);
+    }
+
+    /**
+     * Sends a shared message buffer to the specified connection.
+     *
+     * This method is identical to {@link #sendTo}, except that the message is
+     * never copied on its way to the data channel. If this connection is the
+     * recipient, the message is still copied into the receipt buffer.
+     *
+     * @param dst       The UUID of the peer to receive the message
+     * @param message   The message to send.
+     * @param lane      The delivery lane
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool sendTo(const std::string dst, const NetcodeMessage& message, Lane lane);
 
     /**
      * Sends a byte array to the host player.
@@ -920,7 +1722,55 @@ public:
      *
      * @return true if the message was (apparently) sent
      */
-    bool sendToHost(const std::vector<std::byte>& data);
+    bool sendToHost(const std::vector<std::byte>& data) {
+        return sendToHost(data,Lane::RELIABLE);
+    }
+
+    /**
+     * Sends a byte array to the host player along the given lane.
+     *
+     * This method is identical to {@link #sendToHost}, except that it allows the
+     * user to choose the delivery lane. Messages on the {@link Lane#UNRELIABLE}
+     * lane are not guaranteed to be ordered, or even to arrive at all.
+     *
+     * This requires a connection be established. Otherwise it will return false. It
+     * will also return false if the host is currently migrating.
+     *
+     * @param data  The byte array to send.
+     * @param lane  The delivery lane
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool sendToHost(const std::vector<std::byte>& data, Lane lane);
+
+    /**
+     * Sends a shared message buffer to the host player.
+     *
+     * This method is identical to {@link #sendToHost}, except that the message is
+     * never copied on its way to the data channel. If this connection is the host,
+     * the message is still copied into the receipt buffer.
+     *
+     * @param message   The message to send.
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool sendToHost(const NetcodeMessage& message) {
+        return sendToHost(message,Lane::RELIABLE);
+    }
+
+    /**
+     * Sends a shared message buffer to the host player.
+     *
+     * This method is identical to {@link #sendToHost}, except that the message is
+     * never copied on its way to the data channel. If this connection is the host,
+     * the message is still copied into the receipt buffer.
+     *
+     * @param message   The message to send.
+     * @param lane      The delivery lane
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool sendToHost(const NetcodeMessage& message, Lane lane);
     
     /**
      * Sends a byte array to all other players.
@@ -935,6 +1785,9 @@ public:
      * will receive those messages in the same order. However, there is no relationship
      * between the messages coming from different sources.
      *
+     * Spectators (see {@link #isSpectator}) never receive a broadcast. Messages for
+     * a spectator must be sent to it with {@link #sendTo}.
+     *
      * You may choose to either send a byte array directly, or you can use the
      * {@link NetcodeSerializer} and {@link NetcodeDeserializer} classes to encode
      * more complex data.
@@ -946,7 +1799,227 @@ public:
      *
      * @return true if the message was (apparently) sent
      */
-    bool broadcast(const std::vector<std::byte>& data);
+    bool broadcast(const std::vector<std::byte>& data) {
+        return broadcast(data,Lane::RELIABLE);
+    }
+
+    /**
+     * Sends a byte array to all other players along the given lane.
+     *
+     * This method is identical to {@link #broadcast}, except that it allows the
+     * user to choose the delivery lane. Messages on the {@link Lane#UNRELIABLE}
+     * lane are not guaranteed to be ordered, or even to arrive at all. The copy
+     * of the message delivered to this player is always received.
+     *
+     * This requires a connection be established. Otherwise it will return false. It
+     * will also return false if the host is currently migrating.
+     *
+     * @param data The byte array to send.
+     * @param lane The delivery lane
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool broadcast(const std::vector<std::byte>& data, Lane lane);
+
+    /**
+     * Sends a shared message buffer to all other players.
+     *
+     * This method is identical to {@link #broadcast}, except that the message is
+     * never copied on its way to the data channels. So a message sent to several
+     * peers is only stored once, even if some channels must queue it. The message
+     * is still copied into the receipt buffer of this connection.
+     *
+     * @param message   The message to send.
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool broadcast(const NetcodeMessage& message) {
+        return broadcast(message,Lane::RELIABLE);
+    }
+
+    /**
+     * Sends a shared message buffer to all other players.
+     *
+     * This method is identical to {@link #broadcast}, except that the message is
+     * never copied on its way to the data channels. So a message sent to several
+     * peers is only stored once, even if some channels must queue it. The message
+     * is still copied into the receipt buffer of this connection.
+     *
+     * @param message   The message to send.
+     * @param lane      The delivery lane
+     *
+     * @return true if the message was (apparently) sent
+     */
+    bool broadcast(const NetcodeMessage& message, Lane lane);
+    
+    /**
+     * Returns true if outgoing messages are batched.
+     *
+     * When batching is enabled, messages to the same peer along the same lane are
+     * packed together into a single datagram no larger than the MTU (as specified
+     * by {@link NetcodeConfig#mtu}). A datagram is sent once it is full, or when
+     * {@link #flush} is called.
+     *
+     * @return true if outgoing messages are batched.
+     */
+    bool isBatching() const { return _batching; }
+    
+    /**
+     * Sets whether outgoing messages are batched.
+     *
+     * When batching is enabled, messages to the same peer along the same lane are
+     * packed together into a single datagram no larger than the MTU (as specified
+     * by {@link NetcodeConfig#mtu}). A datagram is sent once it is full, or when
+     * {@link #flush} is called. The receiving side unpacks these datagrams
+     * transparently, so this setting does not need to agree across connections.
+     *
+     * Disabling batching will flush any pending messages.
+     *
+     * @param value Whether outgoing messages are batched.
+     */
+    void setBatching(bool value);
+    
+    /**
+     * Sends all pending batched messages.
+     *
+     * If batching is enabled, this method should be called at the end of every
+     * network frame. Otherwise messages may never be sent. If scheduling is
+     * enabled, this method first sends the queued messages allowed by the
+     * bandwidth (see {@link #setBandwidth}). If neither is enabled, this method
+     * does nothing.
+     *
+     * @return true if the messages were (apparently) sent
+     */
+    bool flush();
+    
+    /**
+     * Returns the number of bytes to send each flush.
+     *
+     * A value of 0 means that scheduling is disabled (the default). See
+     * {@link #setBandwidth} for more information.
+     *
+     * @return the number of bytes to send each flush.
+     */
+    size_t getBandwidth() const { return _bandwidth; }
+    
+    /**
+     * Sets the number of bytes to send each flush.
+     *
+     * When scheduling is enabled, messages to other peers are queued by lane,
+     * and are only sent when {@link #flush} is called. Each flush divides the
+     * bandwidth by priority. Messages on the reliable lane are always sent first,
+     * and are never held back. The unreliable lane comes next, up to its budget.
+     * The bulk lane only gets the bandwidth that is left over. So a large
+     * transfer on the bulk lane can never starve the state snapshots. Messages
+     * that do not fit stay queued for the next flush. The cost of a broadcast is
+     * its size times the number of peers.
+     *
+     * The bandwidth is a budget per flush, so it should be the uplink rate
+     * divided by the network frame rate. A value of 0 disables scheduling, and
+     * sends every queued message on the next flush.
+     *
+     * @param bytes The number of bytes to send each flush
+     */
+    void setBandwidth(size_t bytes);
+    
+    /**
+     * Sets the scheduling limits for the given lane.
+     *
+     * The budget is the maximum number of bytes the lane may send each flush,
+     * within the overall bandwidth. The depth is the maximum number of messages
+     * queued for the lane. When the unreliable lane is at its depth, it drops
+     * its oldest message. The other lanes refuse new messages, so that their
+     * senders know the message was not sent. A value of 0 means no limit. The
+     * budget has no effect on the reliable lane, which is never held back.
+     *
+     * These limits only matter if scheduling is enabled. By default, no lane
+     * has any limits.
+     *
+     * @param lane      The delivery lane
+     * @param budget    The maximum bytes to send each flush
+     * @param depth     The maximum number of queued messages
+     */
+    void setLaneSchedule(Lane lane, size_t budget, size_t depth);
+    
+    /**
+     * Returns the minimum size of a message to compress.
+     *
+     * A value of 0 means that compression is disabled (the default). See
+     * {@link #setCompression} for more information.
+     *
+     * @return the minimum size of a message to compress.
+     */
+    size_t getCompression() const { return _compression; }
+    
+    /**
+     * Sets the minimum size of a message to compress.
+     *
+     * When compression is enabled, any message sent to another peer that is at
+     * least this many bytes is compressed with a {@link NetcodeCompressor}. If
+     * compression does not make it smaller, it is sent as is. This is intended
+     * for large messages such as checkpoints or full state synchronizations,
+     * which may otherwise exceed {@link NetcodeConfig#maxMessage}. Small messages
+     * are rarely worth the effort, unless there is a dictionary.
+     *
+     * Compression is negotiated per peer. Each connection announces itself to
+     * every peer when the data channels are established, and messages are only
+     * compressed for peers that have announced themselves. The receiving side
+     * decompresses transparently, so this setting does not need to agree across
+     * connections. A value of 0 disables compression.
+     *
+     * @param threshold The minimum size of a message to compress
+     */
+    void setCompression(size_t threshold) { _compression = threshold; }
+    
+    /**
+     * Returns the compression dictionary of this connection.
+     *
+     * If no dictionary has been set, this method returns an empty vector.
+     *
+     * @return the compression dictionary of this connection.
+     */
+    std::vector<std::byte> getDictionary();
+    
+    /**
+     * Sets the compression dictionary of this connection.
+     *
+     * A dictionary makes mid-size messages compress much better, particularly
+     * if it is trained on typical messages with {@link NetcodeCompressor#train}.
+     * The dictionary is only used for a peer that has the same dictionary, as
+     * announced during compression negotiation. Changing the dictionary will
+     * announce the new dictionary to all peers.
+     *
+     * The dictionary should be set before the connection is opened, and be the
+     * same on every connection. Otherwise messages compressed with the previous
+     * dictionary may be dropped while the announcement is in flight.
+     *
+     * @param dictionary    The compression dictionary
+     */
+    void setDictionary(const std::vector<std::byte>& dictionary);
+    
+    /**
+     * Sets the backpressure settings for the given lane.
+     *
+     * A data channel is congested when the number of bytes buffered (but not
+     * yet sent) reaches the high watermark, and stays congested until the buffered
+     * amount drops to the low watermark. While congested, messages are handled
+     * according to the policy. For example, stale state snapshots on the
+     * unreliable lane can be coalesced so that only the latest is sent.
+     *
+     * A high watermark of 0 disables backpressure. These settings apply to all
+     * existing and future data channels for that lane.
+     *
+     * By default, both lanes have a high watermark of 256 KB and a low watermark
+     * of 64 KB. The reliable lane queues messages, while the unreliable lane
+     * coalesces them. The bulk lane shares the settings of the reliable lane, as
+     * it uses the same data channel.
+     *
+     * @param lane      The delivery lane
+     * @param high      The high watermark in bytes
+     * @param low       The low watermark in bytes
+     * @param policy    How to handle messages when congested
+     */
+    void setBackpressure(Lane lane, size_t high, size_t low, NetcodeChannel::Backpressure policy);
     
     /**
      * Receives incoming network messages.
@@ -959,6 +2032,10 @@ public:
      * function should be prepared to be called multiple times a render frame, or even
      * not at all.
      *
+     * No locks are held while the dispatcher runs, so a slow dispatcher never stalls
+     * the threads delivering network messages. Messages that arrive during the call
+     * may be dispatched as part of this call.
+     *
      * If a dispatcher callback has been registered with {@link #onReceipt}, this
      * method will never do anything. In that case, messages are not buffered and are
      * processed as soon as they are received.
@@ -967,6 +2044,38 @@ public:
      */
     void receive(const Dispatcher& dispatcher);
     
+    /**
+     * Consumes incoming network messages.
+     *
+     * This method is identical to {@link #receive}, except that the message data
+     * is moved to the consumer instead of passed by reference. Use this method
+     * when the messages need to outlive the call (e.g. they are queued for later
+     * processing), as it avoids copying each message.
+     *
+     * If a dispatcher callback has been registered with {@link #onReceipt}, this
+     * method will never do anything. In that case, messages are not buffered and are
+     * processed as soon as they are received.
+     *
+     * @param consumer  The function to take the received data
+     */
+    void consume(const Consumer& consumer);
+    
+    /**
+     * Consumes incoming network messages, identifying sources by handle.
+     *
+     * This method is identical to {@link #consume}, except that the source of
+     * each message is a {@link PeerHandle} instead of a UUID. No strings are
+     * copied on this path. Use {@link #getPeerName} to recover the UUID of a
+     * handle when it is needed.
+     *
+     * If a dispatcher callback has been registered with {@link #onReceipt}, this
+     * method will never do anything. In that case, messages are not buffered and are
+     * processed as soon as they are received.
+     *
+     * @param consumer  The function to take the received data
+     */
+    void consumeByHandle(const HandleConsumer& consumer);
+    
     /**
      * Marks the game as started and bans incoming connections.
      *
@@ -985,6 +2094,22 @@ public:
     void endSession();
 
 #pragma mark Callbacks
+    /**
+     * Sets the scheduler for the user callbacks of this connection.
+     *
+     * By default, all callback functions are scheduled with {@link Application},
+     * so that they are called on the main thread at the start of an animation
+     * frame. A connection that is not owned by the main thread (such as one of
+     * many sessions on a dedicated server) should provide a scheduler that runs
+     * the callbacks on its own thread. See {@link Scheduler}.
+     *
+     * This method must be called before {@link #open}. Setting the scheduler to
+     * nullptr restores the default.
+     *
+     * @param scheduler The scheduler for user callbacks
+     */
+    void setScheduler(Scheduler scheduler);
+
     /**
      * Sets a callback function to invoke on message receipt
      *
@@ -999,6 +2124,22 @@ public:
      * @param callback  The dispatcher callback
      */
     void onReceipt(Dispatcher callback);
+    
+    /**
+     * Sets a callback function to invoke when a congested peer becomes writable
+     *
+     * A peer is congested when one of its data channels buffers more bytes than
+     * the high watermark set by {@link #setBackpressure}. This callback is invoked
+     * once that data channel drains to its low watermark. The uuid sent to the
+     * callback identifies the peer.
+     *
+     * All callback functions are guaranteed to be called on the main thread. They
+     * are called at the start of an animation frame, before the method
+     * {@link Application#update(float) }.
+     *
+     * @param callback  The writable callback
+     */
+    void onWritable(ConnectionCallback callback);
 
     /**
      * Sets a callback function to invoke on player connections
@@ -1098,6 +2239,64 @@ public:
      * @return the debugging status of this connection.
      */
     bool getDebug() const { return _debug; }
+    
+    /**
+     * Returns the recorder tapping this connection.
+     *
+     * If this value is nullptr, no messages are recorded.
+     *
+     * @return the recorder tapping this connection.
+     */
+    std::shared_ptr<NetcodeRecorder> getRecorder() const {
+        return std::atomic_load(&_recorder);
+    }
+    
+    /**
+     * Sets the recorder tapping this connection.
+     *
+     * Once set, every message sent or received by this connection is recorded
+     * to the trace of the recorder. Inbound messages are recorded when they
+     * are added to the receipt buffer, after they are unbatched, reassembled,
+     * and decompressed. Outbound messages are recorded before any of that.
+     * Messages sent to this connection itself are only recorded as inbound.
+     *
+     * This method is safe to call at any time. Setting it to nullptr stops
+     * recording, though the recorder must be disposed to close the trace.
+     *
+     * @param recorder  The recorder tapping this connection
+     */
+    void setRecorder(const std::shared_ptr<NetcodeRecorder>& recorder) {
+        std::atomic_store(&_recorder,recorder);
+    }
+    
+    /**
+     * Returns the network simulator of this connection.
+     *
+     * If this value is nullptr, no network conditions are simulated.
+     *
+     * @return the network simulator of this connection.
+     */
+    std::shared_ptr<NetcodeSimulator> getSimulator() const {
+        return std::atomic_load(&_simulator);
+    }
+    
+    /**
+     * Sets the network simulator of this connection.
+     *
+     * Once set, every datagram sent or received on a data channel of this
+     * connection passes through the simulator, which can delay, drop, or
+     * duplicate it according to the conditions for that peer. The conditions
+     * apply to each direction, so a simulated latency is added twice to the
+     * round trip time. This setting applies to all existing and future data
+     * channels of this connection.
+     *
+     * This is a debugging tool, and is off by default. Setting it to nullptr
+     * stops the simulation, though datagrams already held by the simulator
+     * are still delivered.
+     *
+     * @param simulator The network simulator of this connection
+     */
+    void setSimulator(const std::shared_ptr<NetcodeSimulator>& simulator);
 };
 
     }
@@ -48,8 +48,11 @@
 //
 #ifndef __CU_NETCODE_PEER_H__
 #define __CU_NETCODE_PEER_H__
+#include <cugl/net/CUNetcodeStats.h>
+#include <cugl/net/CUNetcodeSerializer.h>
 #include <rtc/rtc.hpp>
 #include <unordered_map>
+#include <vector>
 #include <future>
 #include <memory>
 #include <string>
@@ -88,6 +91,25 @@ class NetcodeConnection;
  * this class to simplify development.
  */
 class NetcodePeer  : public std::enable_shared_from_this<NetcodePeer> {
+public:
+    /**
+     * The network path selected for a peer connection.
+     *
+     * This is determined by the ICE candidate pair that the connection uses.
+     * A relayed path goes through a TURN server, and so is typically slower
+     * than the others.
+     */
+    enum class Path : int {
+        /** The connection has not selected a candidate pair */
+        UNKNOWN = 0,
+        /** Both candidates are host addresses (such as on a LAN) */
+        DIRECT = 1,
+        /** At least one candidate is translated through a NAT (found with STUN) */
+        REFLEXIVE = 2,
+        /** At least one candidate is a TURN relay */
+        RELAYED = 3
+    };
+
 private:
     /** 
      * The globally unique identifier for this peer.
@@ -105,6 +127,12 @@ private:
     std::shared_ptr<rtc::PeerConnection> _connection;
     /** The data channels associated with this peer */
     std::unordered_map<std::string, std::shared_ptr<NetcodeChannel>> _channels;
+    /** The statistics counters for this peer (forwarded to the connection) */
+    std::shared_ptr<NetcodeCounters> _stats;
+    /** Whether signaling messages are held back (because there is no id yet) */
+    bool _holding;
+    /** The signaling messages held back until this peer is assigned an id */
+    std::vector<std::shared_ptr<JsonValue>> _signals;
     
     // To prevent race conditions
     /** Whether this data channel prints out debugging information */
@@ -246,6 +274,8 @@ private:
      *
      * In our experiments, it is only safe to open one data channel at a time.
      * This callback informs this peer when it is safe to make a new channel.
+     * Hence the offering peer creates the unreliable channel only once the
+     * reliable channel has opened.
      *
      * @param label The data channel label
      */
@@ -256,9 +286,26 @@ private:
      *
      * There can only be one data channel of any label.
      *
+     * @param label     The data channel label
+     * @param reliable  Whether the data channel is reliable and ordered
+     *
      * @return true if creation was successful.
      */
-    bool createChannel(const std::string label);
+    bool createChannel(const std::string label, bool reliable=true);
+    
+    /**
+     * Assigns this peer connection to the device with the given id.
+     *
+     * A {@link NetcodeConnection} creates a spare peer connection with an empty
+     * id before it knows who it will connect to. That way, the expensive setup
+     * (and for an offered connection, ICE gathering) overlaps with the lobby
+     * negotiation. The local description and candidates gathered so far are
+     * held back until this method is called, at which point they are sent in
+     * order.
+     *
+     * @param id        The unique id for this peer
+     */
+    void assign(const std::string id);
     
     /** Allow access to the other netcode classes */
     friend class NetcodeChannel;
@@ -275,6 +322,20 @@ public:
      * @return the UUID of this peer
      */
     std::string getUUID() const { return _uuid; }
+    
+    /**
+     * Returns the network statistics for this peer.
+     *
+     * The statistics include the bytes and packets sent and received along all
+     * data channels, the number of bytes buffered in the data channels, and
+     * the most recent round trip time. The message counts, drops, and queue
+     * depth are only tracked by {@link NetcodeConnection#getStats}.
+     *
+     * All of these values are atomic, so this method never takes a lock.
+     *
+     * @return the network statistics for this peer.
+     */
+    NetcodeStats getStats() const;
 
     /**
      * Returns the data channel with the associated label.
@@ -299,6 +360,32 @@ public:
      * @return the parent {@link NetcodeConnection} of this data channel
      */
     const std::shared_ptr<NetcodeConnection> getConnection();
+
+    /**
+     * Returns the network path of this peer connection.
+     *
+     * The path is given by the ICE candidate pair selected by the connection.
+     * Use this method to spot relayed sessions. The round trip time of the
+     * path is the rtt of {@link #getStats}.
+     *
+     * This method is not const because it requires a lock.
+     *
+     * @return the network path of this peer connection.
+     */
+    Path getPath();
+
+    /**
+     * Returns a description of the selected candidate pair.
+     *
+     * The description has the type and address of the local and the remote
+     * candidate, such as "srflx 1.2.3.4:5000 <-> relay 5.6.7.8:3478". It is
+     * the empty string if no pair is selected yet.
+     *
+     * This method is not const because it requires a lock.
+     *
+     * @return a description of the selected candidate pair.
+     */
+    std::string getPathDescription();
     
 #pragma mark Communication
     /**
@@ -325,6 +412,20 @@ public:
      */
     bool send(const std::string channel, const std::vector<std::byte>& data);
 
+    /**
+     * Sends a shared message buffer along the data channel of the given name
+     *
+     * This method is identical to {@link #send}, except that the message is
+     * never copied on its way to the data channel. So the same message can be
+     * sent to several peers while only being stored once.
+     *
+     * @param channel   The data channel label
+     * @param message   The message to send
+     *
+     * @return true if transmission was (apparently) successful
+     */
+    bool send(const std::string channel, const NetcodeMessage& message);
+
 #pragma mark Debugging
     /**
      * Toggles the debugging status of this peer.
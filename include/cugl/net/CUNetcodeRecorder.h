@@ -0,0 +1,390 @@
+//
+//  CUNetcodeRecorder.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module is part of a Web RTC implementation of the classic CUGL networking
+//  library. It provides a tap for NetcodeConnection that records every message
+//  sent or received to a trace file. The trace can be read back with the class
+//  NetcodeReplay, which is how a desynchronized match is debugged offline.
+//
+//  The trace is written on a background thread, so that recording never delays
+//  the threads delivering network messages. The format is a compact binary
+//  format written with BinaryWriter.
+//
+//  These classes uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_NETCODE_RECORDER_H__
+#define __CU_NETCODE_RECORDER_H__
+#include <cugl/util/CUMPSCQueue.h>
+#include <cugl/util/CUTimestamp.h>
+#include <SDL_stdinc.h>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstddef>
+
+namespace cugl {
+
+/** Forward reference to the binary writer */
+class BinaryWriter;
+/** Forward reference to the binary reader */
+class BinaryReader;
+
+    /**
+     * The CUGL networking classes.
+     *
+     * This internal namespace is for optional networking package. Currently CUGL
+     * supports ad-hoc game lobbies using web-sockets. The sockets must connect
+     * connect to a CUGL game lobby server.
+     */
+    namespace net {
+
+#pragma mark -
+#pragma mark NetcodeRecorder
+/**
+ * This class records network messages to a trace file.
+ *
+ * A recorder is attached to a {@link NetcodeConnection} with the method
+ * {@link NetcodeConnection#setRecorder}. From then on, the connection records
+ * every message that it sends, and every message that it receives, together
+ * with the time and the peer on the other end. Inbound messages are recorded
+ * as they are given to the application, after they are unbatched, reassembled,
+ * and decompressed. So a trace can be fed back into the code that consumed the
+ * messages, using {@link NetcodeReplay}.
+ *
+ * The method {@link #record} only copies the message into a lock-free queue.
+ * The file itself is written by a background thread, which drains that queue.
+ * No record is ever dropped, so a recorder on a busy connection will use more
+ * memory until the thread catches up.
+ *
+ * The trace starts with a four byte magic number and a version. It is then a
+ * sequence of records. Each peer UUID is written once, the first time that it
+ * is used, and messages refer to it by a two byte index. Every message record
+ * has its time (in microseconds since the recorder was initialized), the peer
+ * index, the size, and the message bytes.
+ */
+class NetcodeRecorder {
+public:
+    /**
+     * An enumeration of the direction of a recorded message.
+     */
+    enum class Direction : int {
+        /** A message received by the connection */
+        INBOUND  = 0,
+        /** A message sent by the connection */
+        OUTBOUND = 1
+    };
+
+    /**
+     * A single message in a trace
+     *
+     * For inbound messages, the peer is the message source. For outbound
+     * messages, it is the message destination. A broadcast is recorded with
+     * an empty destination.
+     */
+    class Record {
+    public:
+        /** The time of the message in microseconds since the trace started */
+        Uint64 time;
+        /** The message direction */
+        Direction direction;
+        /** The UUID of the peer on the other end */
+        std::string peer;
+        /** The message data */
+        std::vector<std::byte> message;
+
+        /** Creates an empty record */
+        Record() : time(0), direction(Direction::INBOUND) {}
+    };
+
+private:
+    /** The file writer (only accessed by the writing thread once started) */
+    std::shared_ptr<BinaryWriter> _writer;
+    /** The records waiting to be written */
+    MPSCQueue<Record> _queue;
+    /** The thread writing the trace to the file */
+    std::thread _thread;
+    /** Whether this recorder is accepting new records */
+    std::atomic<bool> _active;
+    /** The time that the trace started */
+    Timestamp _start;
+    /** The number of records accepted so far */
+    std::atomic<size_t> _count;
+    /** The index of each peer written to the file (writing thread only) */
+    std::unordered_map<std::string, Uint16> _peers;
+
+    /**
+     * Writes records to the file until this recorder is disposed.
+     *
+     * This is the body of the writing thread. It drains the queue of records,
+     * flushing the file after each batch, and sleeps when there are none.
+     */
+    void run();
+
+    /**
+     * Writes a single record to the file.
+     *
+     * If the peer of this record has not been seen before, this method writes
+     * the peer UUID first. This method must only be called by the writing
+     * thread.
+     *
+     * @param record    The record to write
+     */
+    void write(const Record& record);
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates a degenerate recorder.
+     *
+     * This object has not been initialized with a file and cannot be used.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    NetcodeRecorder();
+
+    /**
+     * Deletes this recorder, disposing all resources
+     */
+    ~NetcodeRecorder() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this recorder.
+     *
+     * This method blocks until every record accepted so far is written to the
+     * file, and then closes the file. A disposed recorder can be safely
+     * reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes a recorder for the given file.
+     *
+     * If the file is a relative path, it is placed in the application save
+     * directory (see {@link BinaryWriter}). Any existing file is replaced.
+     * The trace starts at the time of this call.
+     *
+     * @param file  The path to the trace file
+     *
+     * @return true if the recorder is initialized properly, false otherwise.
+     */
+    bool init(const std::string file);
+
+    /**
+     * Returns a newly allocated recorder for the given file.
+     *
+     * If the file is a relative path, it is placed in the application save
+     * directory (see {@link BinaryWriter}). Any existing file is replaced.
+     * The trace starts at the time of this call.
+     *
+     * @param file  The path to the trace file
+     *
+     * @return a newly allocated recorder for the given file.
+     */
+    static std::shared_ptr<NetcodeRecorder> alloc(const std::string file) {
+        std::shared_ptr<NetcodeRecorder> result = std::make_shared<NetcodeRecorder>();
+        return (result->init(file) ? result : nullptr);
+    }
+
+#pragma mark Recording
+    /**
+     * Returns true if this recorder is accepting new records.
+     *
+     * @return true if this recorder is accepting new records.
+     */
+    bool isActive() const { return _active.load(); }
+
+    /**
+     * Returns the number of records accepted so far.
+     *
+     * @return the number of records accepted so far.
+     */
+    size_t getCount() const { return _count.load(); }
+
+    /**
+     * Records a single message.
+     *
+     * This method may be called from any thread. It copies the message and
+     * returns immediately, as the record is written by the background thread.
+     * It returns false if this recorder is not active.
+     *
+     * @param direction The message direction
+     * @param peer      The UUID of the peer on the other end
+     * @param data      The message data
+     *
+     * @return true if the message was recorded
+     */
+    bool record(Direction direction, const std::string& peer, const std::vector<std::byte>& data);
+};
+
+#pragma mark -
+#pragma mark NetcodeReplay
+/**
+ * This class reads back a trace written by a {@link NetcodeRecorder}.
+ *
+ * A replay reads the records of the trace in the order that they were
+ * recorded. It always reads one record ahead, so that {@link #getTime} can
+ * be used to pace the replay. Use {@link NetEventController#replay} to apply
+ * the inbound messages of a trace to a game offline.
+ *
+ * A truncated trace (for example, if the game crashed while recording) is read
+ * up to the last complete record.
+ */
+class NetcodeReplay {
+private:
+    /** The path to the trace file */
+    std::string _file;
+    /** The file reader */
+    std::shared_ptr<BinaryReader> _reader;
+    /** The peer UUIDs read so far, by index */
+    std::vector<std::string> _peers;
+    /** The next record (valid only if _ready is true) */
+    NetcodeRecorder::Record _next;
+    /** Whether there is a next record */
+    bool _ready;
+
+    /**
+     * Opens the trace file and reads its header, returning true if it is valid.
+     *
+     * If the header is valid, this method also reads the first record.
+     *
+     * @return true if the file header is valid
+     */
+    bool start();
+
+    /**
+     * Reads the next message record into _next
+     *
+     * Any peer records along the way are added to the peer table. This
+     * method sets _ready to false if there are no more complete records.
+     */
+    void advance();
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates a degenerate replay.
+     *
+     * This object has not been initialized with a file and cannot be used.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    NetcodeReplay() : _ready(false) {}
+
+    /**
+     * Deletes this replay, disposing all resources
+     */
+    ~NetcodeReplay() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this replay.
+     *
+     * A disposed replay can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes a replay of the given trace file.
+     *
+     * If the file is a relative path, it is read from the application save
+     * directory (see {@link BinaryReader}). This method returns false if the
+     * file does not exist or is not a trace.
+     *
+     * @param file  The path to the trace file
+     *
+     * @return true if the replay is initialized properly, false otherwise.
+     */
+    bool init(const std::string file);
+
+    /**
+     * Returns a newly allocated replay of the given trace file.
+     *
+     * If the file is a relative path, it is read from the application save
+     * directory (see {@link BinaryReader}). This method returns nullptr if
+     * the file does not exist or is not a trace.
+     *
+     * @param file  The path to the trace file
+     *
+     * @return a newly allocated replay of the given trace file.
+     */
+    static std::shared_ptr<NetcodeReplay> alloc(const std::string file) {
+        std::shared_ptr<NetcodeReplay> result = std::make_shared<NetcodeReplay>();
+        return (result->init(file) ? result : nullptr);
+    }
+
+#pragma mark Playback
+    /**
+     * Returns true if there are no more records in the trace.
+     *
+     * @return true if there are no more records in the trace.
+     */
+    bool isDone() const { return !_ready; }
+
+    /**
+     * Returns the time of the next record.
+     *
+     * The time is in microseconds since the trace started. This value is
+     * meaningless if {@link #isDone} is true.
+     *
+     * @return the time of the next record.
+     */
+    Uint64 getTime() const { return _next.time; }
+
+    /**
+     * Reads the next record of the trace.
+     *
+     * This method returns false if there are no more records, in which case
+     * record is unchanged.
+     *
+     * @param record    The record to store the result
+     *
+     * @return true if a record was read
+     */
+    bool next(NetcodeRecorder::Record& record);
+
+    /**
+     * Rewinds this replay to the start of the trace.
+     */
+    void reset();
+};
+
+    }
+}
+
+#endif /* __CU_NETCODE_RECORDER_H__ */
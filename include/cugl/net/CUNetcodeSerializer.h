@@ -53,6 +53,7 @@
 #include <variant>
 #include <string>
 #include <vector>
+#include <memory>
 #include <cstdint>
 #include <cstddef>
 
@@ -70,6 +71,18 @@ class JsonValue;
      */
     namespace net {
 
+/**
+ * An immutable, reference counted message buffer.
+ *
+ * The {@link NetcodeConnection} accepts messages of this type everywhere that
+ * it accepts byte vectors. The difference is that a message buffer is shared,
+ * and never copied, by the send stack. So a message broadcast to several peers
+ * (or queued behind backpressure) is only stored once. A message buffer must
+ * never be modified once it is created. Use {@link NetcodeSerializer#share} to
+ * serialize directly into one.
+ */
+typedef std::shared_ptr<const std::vector<std::byte>> NetcodeMessage;
+
 /**
  * Represents the type of the of a serialized value.
  *
@@ -145,11 +158,22 @@ enum NetcodeType : std::uint8_t {
  * 
  * Note that if a char* (not a C++ string) is written, it will be deserialized as a 
  * std::string. The same applies to vectors of char*.
+ *
+ * By default, every value is prefixed by its {@link NetcodeType}. This allows the
+ * {@link NetcodeDeserializer} to read a message without knowing its contents in
+ * advance. However, that can add a lot of overhead to small messages. If both sides
+ * agree on the order and type of the values (a schema), you should use compact mode
+ * instead. In compact mode, there are no type tags. Integers are written as variable
+ * length integers (so small values take a single byte), and all other values are
+ * written directly. A message written in compact mode can only be read by a
+ * {@link NetcodeDeserializer} that is also in compact mode.
  */
 class NetcodeSerializer {
 private:
     /** Buffer of data that has not been written out yet. */
     std::vector<std::byte> _data;
+    /** Whether to omit type tags and use variable length integers */
+    bool _compact;
 
 public:
     /**
@@ -158,20 +182,62 @@ public:
      * Netcode serializers do not have any nontrivial state and so it is unnecessary
      * to use an init method. However, we do include a static {@link #alloc} method
      * for creating shared pointers.
+     *
+     * @param compact   Whether to use the compact (tagless) encoding
      */
-    NetcodeSerializer() {} 
+    NetcodeSerializer(bool compact=false) : _compact(compact) {}
 
     /**
      * Returns a newly created Netcode Serializer.
      *
      * This method is solely include for convenience purposes.
      *
+     * @param compact   Whether to use the compact (tagless) encoding
+     *
      * @return a newly created Netcode Serializer.
      */
-    static std::shared_ptr<NetcodeSerializer> alloc() {
-        return std::make_shared<NetcodeSerializer>();
+    static std::shared_ptr<NetcodeSerializer> alloc(bool compact=false) {
+        return std::make_shared<NetcodeSerializer>(compact);
     }
     
+    /**
+     * Returns true if this serializer uses the compact encoding.
+     *
+     * In compact mode, values are not prefixed by their type, and integers are
+     * encoded as variable length integers. Such messages can only be read by a
+     * {@link NetcodeDeserializer} that is also in compact mode, and must be read
+     * back with the type-specific read methods in the order written.
+     *
+     * @return true if this serializer uses the compact encoding.
+     */
+    bool isCompact() const { return _compact; }
+    
+    /**
+     * Sets whether this serializer uses the compact encoding.
+     *
+     * In compact mode, values are not prefixed by their type, and integers are
+     * encoded as variable length integers. Such messages can only be read by a
+     * {@link NetcodeDeserializer} that is also in compact mode, and must be read
+     * back with the type-specific read methods in the order written.
+     *
+     * You should only change the mode when the buffer is empty. Mixing the two
+     * encodings in a single message will produce a message that cannot be read.
+     *
+     * @param value Whether to use the compact encoding
+     */
+    void setCompact(bool value) { _compact = value; }
+    
+    /**
+     * Reserves space for the given number of bytes in the input buffer.
+     *
+     * The capacity of the buffer is preserved by {@link #reset}. So if you reuse
+     * this serializer for messages of similar size, you only need to call this
+     * method once.
+     *
+     * @param bytes The number of bytes to reserve
+     */
+    void reserve(size_t bytes) { _data.reserve(bytes); }
+    
     /**
      * Writes a single boolean value.
      *
@@ -398,6 +464,19 @@ public:
      */
     void writeJsonVector(std::vector<std::shared_ptr<JsonValue>> j);
 
+    /**
+     * Writes a block of raw bytes.
+     *
+     * The bytes are prefixed by their length, and are read back (as a single
+     * vector) with {@link NetcodeDeserializer#readBytes}. This is useful for
+     * embedding data that was packed by some other serializer.
+     *
+     * This method is only supported in compact mode.
+     *
+     * @param v The bytes to write
+     */
+    void writeBytes(const std::vector<std::byte>& v);
+
     /**
      * Returns a byte vector of all written values suitable for network transit.
      *
@@ -416,6 +495,21 @@ public:
      */
     const std::vector<std::byte>& serialize();
 
+    /**
+     * Returns a shared message buffer of all written values.
+     *
+     * This method is the same as {@link #serialize}, except that the written
+     * values are moved into an immutable {@link NetcodeMessage} without being
+     * copied. This is the preferred way to create a message that will be
+     * broadcast to several peers.
+     *
+     * This method resets the serializer. Unlike {@link #reset}, the capacity
+     * of the buffer is NOT preserved, as the buffer belongs to the message.
+     *
+     * @returns a shared message buffer of all written values.
+     */
+    NetcodeMessage share();
+
     /**
      * Clears the input buffer.
      */
@@ -431,6 +525,12 @@ public:
  *
  * This class only handles messages serialized using {@link NetcodeSerializer}.
  * You should use {@link NetcodeType} to guide your deserialization process. 
+ *
+ * If the message was written in compact mode, this deserializer must be in
+ * compact mode as well. As compact messages have no type tags, they can only be
+ * read with the type-specific read methods, in the same order they were written.
+ * All reads are bounds checked. Reading past the end of a message returns the
+ * default value and exhausts the stream.
  */
 class NetcodeDeserializer {
 private:
@@ -438,6 +538,31 @@ private:
     std::vector<std::byte> _data;
     /** Position in the data of next byte to read */
     size_t _pos;
+    /** Whether the message uses the compact (tagless) encoding */
+    bool _compact;
+    
+    /**
+     * Copies the given number of bytes from the stream, advancing the read position.
+     *
+     * If there are not enough bytes left, nothing is copied, the stream is
+     * exhausted, and this method returns false.
+     *
+     * @param dst   The buffer to copy into
+     * @param len   The number of bytes to copy
+     *
+     * @return true if the bytes were copied
+     */
+    bool fetch(void* dst, size_t len);
+    
+    /**
+     * Returns the next variable length integer, advancing the read position.
+     *
+     * If the stream ends before the integer does, the stream is exhausted and
+     * this method returns 0.
+     *
+     * @return the next variable length integer
+     */
+    Uint64 fetchVarint();
 
 public:
     /**
@@ -478,20 +603,46 @@ public:
      * Netcode deserializers do not have any nontrivial state and so it is unnecessary
      * to use an init method. However, we do include a static {@link #alloc} method
      * for creating shared pointers.
+     *
+     * @param compact   Whether to read the compact (tagless) encoding
      */
-    NetcodeDeserializer() : _pos(0) {}
+    NetcodeDeserializer(bool compact=false) : _pos(0), _compact(compact) {}
 
     /**
      * Returns a newly created Netcode ,l Deserializer.
      *
      * This method is solely include for convenience purposes.
      *
+     * @param compact   Whether to read the compact (tagless) encoding
+     *
      * @return a newly created Netcode Deserializer.
      */
-    static std::shared_ptr<NetcodeDeserializer> alloc() {
-        return std::make_shared<NetcodeDeserializer>();
+    static std::shared_ptr<NetcodeDeserializer> alloc(bool compact=false) {
+        return std::make_shared<NetcodeDeserializer>(compact);
     }
     
+    /**
+     * Returns true if this deserializer reads the compact encoding.
+     *
+     * A compact message has no type tags. It can only be read with the
+     * type-specific read methods, in the same order the values were written.
+     * Neither {@link #read} nor {@link #nextType} are supported in this mode.
+     *
+     * @return true if this deserializer reads the compact encoding.
+     */
+    bool isCompact() const { return _compact; }
+    
+    /**
+     * Sets whether this deserializer reads the compact encoding.
+     *
+     * A compact message has no type tags. It can only be read with the
+     * type-specific read methods, in the same order the values were written.
+     * Neither {@link #read} nor {@link #nextType} are supported in this mode.
+     *
+     * @param value Whether to read the compact encoding
+     */
+    void setCompact(bool value) { _compact = value; }
+    
     /**
      * Loads a new message to be read.
      * 
@@ -511,6 +662,16 @@ public:
      */
     void receive(const std::vector<std::byte>& msg);
 
+    /**
+     * Loads a new message to be read.
+     *
+     * This version of the method takes ownership of the message, and so avoids
+     * copying it. Otherwise it is the same as {@link #receive}.
+     *
+     * @param msg The byte vector serialized by {@link NetcodeSerializer}
+     */
+    void receive(std::vector<std::byte>&& msg);
+
     /**
      * Reads the next unreturned value or vector from the currently loaded byte vector.
      * 
@@ -524,6 +685,9 @@ public:
      * value should be of a certain type T and to extract that value directly. This 
      * avoids the overhead of a pattern match on every value. In addition, it is
      * guaranteed to never corrupt the stream (unlike the other read methods)
+     *
+     * This method is not supported in compact mode, and will always return the
+     * monostate.
      */
     Message read();
     
@@ -538,7 +702,8 @@ public:
      * Returns the type of the next data value to be read.
      *
      * This method returns {@link NetcodeType#InvalidType} if the stream is exhausted
-     * (nothing left to be read) or corrupted.
+     * (nothing left to be read) or corrupted. As compact messages have no type
+     * tags, it also returns InvalidType in compact mode.
      *
      * @return the type of the next data value to be read.
      */
@@ -779,6 +944,19 @@ public:
      */
     std::vector<std::shared_ptr<JsonValue>> readJsonVector();
 
+    /**
+     * Returns a block of raw bytes.
+     *
+     * This method reads a block written by {@link NetcodeSerializer#writeBytes}.
+     * It is only supported in compact mode.
+     *
+     * The method advances the read position. If called when no more data is available,
+     * this method will return an empty vector.
+     *
+     * @return a block of raw bytes.
+     */
+    std::vector<std::byte> readBytes();
+
     /**
      * Clears the buffer and ignore any remaining data in it.
      */
@@ -0,0 +1,346 @@
+//
+//  CUNetcodeSimulator.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module is part of a Web RTC implementation of the classic CUGL networking
+//  library. It provides a network condition simulator for debugging. When it is
+//  attached to a NetcodeConnection, every datagram between a data channel and its
+//  RTC data channel is delayed, dropped, or duplicated according to the simulated
+//  conditions of its peer. This makes it possible to tune interpolation and
+//  prediction settings without a bad network at hand.
+//
+//  All delayed datagrams are kept in a single timer wheel serviced by one thread.
+//  So the simulator never sleeps on a network thread, and never distorts the
+//  timing of anything else.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_NETCODE_SIMULATOR_H__
+#define __CU_NETCODE_SIMULATOR_H__
+#include <cugl/util/CUTimestamp.h>
+#include <SDL_stdinc.h>
+#include <condition_variable>
+#include <unordered_map>
+#include <functional>
+#include <vector>
+#include <memory>
+#include <string>
+#include <thread>
+#include <random>
+#include <mutex>
+#include <cstddef>
+
+namespace cugl {
+
+    /**
+     * The CUGL networking classes.
+     *
+     * This internal namespace is for optional networking package. Currently CUGL
+     * supports ad-hoc game lobbies using web-sockets. The sockets must connect
+     * connect to a CUGL game lobby server.
+     */
+    namespace net {
+
+/**
+ * This class represents the simulated conditions of a network link.
+ *
+ * The conditions apply to each direction of the link separately. So a latency
+ * of 50 ms adds 100 ms to the round trip time. Loss and duplication only apply
+ * to unreliable data channels as such. A reliable data channel never loses or
+ * duplicates a message, and so a lost message is instead delivered late, as if
+ * it were retransmitted. Reliable channels also stay ordered, no matter the
+ * jitter, while jitter reorders the datagrams of unreliable channels.
+ */
+class NetcodeConditions {
+public:
+    /** The one way delay in milliseconds */
+    Uint32 latency;
+    /** The maximum random delay added to the latency in milliseconds */
+    Uint32 jitter;
+    /** The probability that a datagram is lost (0 to 1) */
+    float loss;
+    /** The probability that an unreliable datagram is delivered twice (0 to 1) */
+    float duplicate;
+    /** The bandwidth of the link in bytes per second (0 for unlimited) */
+    size_t bandwidth;
+
+    /**
+     * Creates the conditions of a perfect link
+     */
+    NetcodeConditions() : latency(0), jitter(0), loss(0), duplicate(0), bandwidth(0) {}
+
+    /**
+     * Returns true if these are the conditions of a perfect link
+     *
+     * A perfect link passes datagrams through immediately.
+     *
+     * @return true if these are the conditions of a perfect link
+     */
+    bool isPerfect() const {
+        return latency == 0 && jitter == 0 && loss <= 0 && duplicate <= 0 && bandwidth == 0;
+    }
+};
+
+/**
+ * This class simulates network conditions for a {@link NetcodeConnection}.
+ *
+ * A simulator is attached to a connection with {@link NetcodeConnection#setSimulator}.
+ * From then on, every datagram sent along a data channel, and every datagram
+ * received from one, is passed through the simulator. If the peer of the data
+ * channel has simulated conditions, the datagram is dropped, delayed, and possibly
+ * duplicated according to those conditions. Otherwise it passes through.
+ *
+ * Delayed datagrams are stored in a timer wheel with one millisecond slots, which
+ * is serviced by a single thread. This thread only wakes up when there is a
+ * datagram due, and the datagrams are delivered on it. The random choices
+ * come from a seeded generator, so that a simulation can be repeated.
+ *
+ * The simulator is a debugging tool. The backpressure settings of a data channel
+ * only see the real buffered amount, and not any datagrams held by the simulator.
+ */
+class NetcodeSimulator {
+private:
+    /**
+     * A datagram waiting in the timer wheel
+     */
+    class Event {
+    public:
+        /** The time to deliver the datagram, in microseconds */
+        Uint64 deadline;
+        /** The order this event was scheduled (to break ties) */
+        Uint64 order;
+        /** The function that delivers the datagram */
+        std::function<void()> action;
+    };
+
+    /**
+     * The state of one direction of a link
+     */
+    class Link {
+    public:
+        /** The time at which the simulated bandwidth is next available */
+        Uint64 free;
+        /** The latest deadline of a datagram (for ordered channels) */
+        Uint64 last;
+
+        /** Creates an idle link */
+        Link() : free(0), last(0) {}
+    };
+
+    /** The mutex for the simulator state */
+    std::mutex _mutex;
+    /** The condition that the timer thread waits on */
+    std::condition_variable _wakeup;
+    /** The thread servicing the timer wheel */
+    std::thread _thread;
+    /** Whether the simulator is running */
+    bool _active;
+    /** Whether the timer thread may still access this simulator */
+    std::shared_ptr<bool> _alive;
+    /** The time the simulator started */
+    Timestamp _start;
+
+    /** The timer wheel slots */
+    std::vector<std::vector<Event>> _wheel;
+    /** The next tick (in milliseconds) of the wheel to service */
+    Uint64 _tick;
+    /** The number of events in the wheel */
+    size_t _pending;
+    /** The number of events scheduled so far */
+    Uint64 _order;
+
+    /** The conditions for peers without their own */
+    NetcodeConditions _default;
+    /** The conditions for individual peers */
+    std::unordered_map<std::string, NetcodeConditions> _conditions;
+    /** The state of each link direction */
+    std::unordered_map<std::string, Link> _links;
+    /** The random number generator for all simulated choices */
+    std::mt19937 _random;
+
+    /**
+     * Services the timer wheel until the simulator is disposed.
+     *
+     * This is the body of the timer thread.
+     */
+    void run();
+
+    /**
+     * Adds an event to the timer wheel.
+     *
+     * This method must be called while holding the lock for this simulator.
+     *
+     * @param deadline  The time to run the event, in microseconds
+     * @param action    The function to run
+     */
+    void schedule(Uint64 deadline, const std::function<void()>& action);
+
+    /**
+     * Returns a random delay for the given conditions, in microseconds
+     *
+     * This method must be called while holding the lock for this simulator.
+     *
+     * @param conditions    The link conditions
+     *
+     * @return a random delay for the given conditions, in microseconds
+     */
+    Uint64 delay(const NetcodeConditions& conditions);
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates a degenerate simulator.
+     *
+     * This object has not been initialized and cannot be used.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    NetcodeSimulator();
+
+    /**
+     * Deletes this simulator, disposing all resources
+     */
+    ~NetcodeSimulator() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this simulator.
+     *
+     * Any datagrams still held by the simulator are discarded. A disposed
+     * simulator can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes a simulator with the given random seed.
+     *
+     * The simulator starts with perfect conditions for every peer.
+     *
+     * @param seed  The seed for the simulated random choices
+     *
+     * @return true if the simulator is initialized properly, false otherwise.
+     */
+    bool init(Uint32 seed=0);
+
+    /**
+     * Returns a newly allocated simulator with the given random seed.
+     *
+     * The simulator starts with perfect conditions for every peer.
+     *
+     * @param seed  The seed for the simulated random choices
+     *
+     * @return a newly allocated simulator with the given random seed.
+     */
+    static std::shared_ptr<NetcodeSimulator> alloc(Uint32 seed=0) {
+        std::shared_ptr<NetcodeSimulator> result = std::make_shared<NetcodeSimulator>();
+        return (result->init(seed) ? result : nullptr);
+    }
+
+#pragma mark Conditions
+    /**
+     * Returns the conditions for peers without their own.
+     *
+     * @return the conditions for peers without their own.
+     */
+    NetcodeConditions getConditions();
+
+    /**
+     * Sets the conditions for peers without their own.
+     *
+     * @param conditions    The link conditions
+     */
+    void setConditions(const NetcodeConditions& conditions);
+
+    /**
+     * Returns the conditions for the given peer.
+     *
+     * @param uuid  The peer UUID
+     *
+     * @return the conditions for the given peer.
+     */
+    NetcodeConditions getConditions(const std::string uuid);
+
+    /**
+     * Sets the conditions for the given peer.
+     *
+     * @param uuid          The peer UUID
+     * @param conditions    The link conditions
+     */
+    void setConditions(const std::string uuid, const NetcodeConditions& conditions);
+
+    /**
+     * Removes the conditions for the given peer.
+     *
+     * The peer will then have the conditions for peers without their own.
+     *
+     * @param uuid  The peer UUID
+     */
+    void clearConditions(const std::string uuid);
+
+    /**
+     * Returns the number of datagrams currently held by this simulator.
+     *
+     * @return the number of datagrams currently held by this simulator.
+     */
+    size_t getPending();
+
+#pragma mark Simulation
+    /**
+     * Passes a datagram through the simulated link to the given peer.
+     *
+     * If the peer has perfect conditions, this method returns false, and the
+     * caller should deliver the datagram immediately. Otherwise, the simulator
+     * takes over the datagram and returns true. In that case, the action is run
+     * on the timer thread once the datagram is due, unless the datagram is lost.
+     * The action may be run twice if the datagram is duplicated.
+     *
+     * The link is the channel label and direction, so that every direction of
+     * every data channel to a peer has its own bandwidth and ordering.
+     *
+     * @param uuid      The peer UUID
+     * @param link      The data channel label and direction
+     * @param reliable  Whether the data channel is reliable and ordered
+     * @param size      The size of the datagram in bytes
+     * @param action    The function to deliver the datagram
+     *
+     * @return true if the simulator took over the datagram
+     */
+    bool post(const std::string& uuid, const std::string& link, bool reliable,
+              size_t size, const std::function<void()>& action);
+};
+
+    }
+}
+
+#endif /* __CU_NETCODE_SIMULATOR_H__ */
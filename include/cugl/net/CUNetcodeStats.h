@@ -0,0 +1,185 @@
+//
+//  CUNetcodeStats.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module is part of a Web RTC implementation of the classic CUGL networking
+//  library. It provides the network statistics reported by NetcodeConnection and
+//  NetcodePeer.
+//
+//  Statistics are gathered in atomic counters on the data channel threads. They
+//  are shared by a data channel, its peer, and the connection, so that reading
+//  them never requires a lock.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_NETCODE_STATS_H__
+#define __CU_NETCODE_STATS_H__
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace cugl {
+
+    /**
+     * The CUGL networking classes.
+     *
+     * This internal namespace is for optional networking package. Currently CUGL
+     * supports ad-hoc game lobbies using web-sockets. The sockets must connect
+     * connect to a CUGL game lobby server.
+     */
+    namespace net {
+
+/**
+ * This class is a snapshot of network statistics.
+ *
+ * A packet is a single datagram sent along a data channel. A message is a
+ * single call to a send method (or a single message received). These differ
+ * when {@link NetcodeConnection#setBatching} is enabled, as several messages
+ * are packed into each packet.
+ *
+ * Some values are only meaningful for either a connection or a peer. Those
+ * values are 0 (or -1 for the round trip time) when not applicable.
+ */
+class NetcodeStats {
+public:
+    /** The number of bytes sent along all data channels */
+    size_t bytesSent;
+    /** The number of bytes received along all data channels */
+    size_t bytesReceived;
+    /** The number of packets (datagrams) sent */
+    size_t packetsSent;
+    /** The number of packets (datagrams) received */
+    size_t packetsReceived;
+    /** The number of messages sent (connection only) */
+    size_t messagesSent;
+    /** The number of messages received (connection only) */
+    size_t messagesReceived;
+    /** The number of inbound messages dropped because the buffer was full (connection only) */
+    size_t messagesDropped;
+    /** The number of messages waiting to be read by {@link NetcodeConnection#receive} (connection only) */
+    size_t queueDepth;
+    /** The number of bytes queued in the data channels but not yet sent */
+    size_t bufferedAmount;
+    /** The most recent round trip time in milliseconds, or -1 if unknown (peer only) */
+    int64_t rtt;
+
+    /**
+     * Creates a snapshot with all statistics zeroed
+     */
+    NetcodeStats() :
+    bytesSent(0), bytesReceived(0), packetsSent(0), packetsReceived(0),
+    messagesSent(0), messagesReceived(0), messagesDropped(0), queueDepth(0),
+    bufferedAmount(0), rtt(-1) {}
+};
+
+/**
+ * This class stores the live statistics counters for a netcode object.
+ *
+ * All counters are atomic, and so they may be updated from any thread. Updates
+ * are forwarded to the parent counters (if any). That way a data channel updates
+ * the counters of its peer, which in turn update the counters of the connection.
+ *
+ * Most users should never need this class. Use {@link NetcodeStats} instead.
+ */
+class NetcodeCounters {
+public:
+    /** The number of bytes sent */
+    std::atomic<size_t> bytesSent;
+    /** The number of bytes received */
+    std::atomic<size_t> bytesReceived;
+    /** The number of packets sent */
+    std::atomic<size_t> packetsSent;
+    /** The number of packets received */
+    std::atomic<size_t> packetsReceived;
+    /** The number of bytes queued but not yet sent */
+    std::atomic<size_t> bufferedAmount;
+    /** The round trip time in milliseconds, or -1 if unknown */
+    std::atomic<int64_t> rtt;
+    /** The counters to forward all updates to */
+    std::shared_ptr<NetcodeCounters> parent;
+
+    /**
+     * Creates a zeroed set of counters with the given parent
+     *
+     * @param parent    The counters to forward updates to (may be nullptr)
+     */
+    NetcodeCounters(const std::shared_ptr<NetcodeCounters>& parent=nullptr) :
+    bytesSent(0), bytesReceived(0), packetsSent(0), packetsReceived(0),
+    bufferedAmount(0), rtt(-1), parent(parent) {}
+
+    /**
+     * Records a packet sent of the given size
+     *
+     * @param bytes The packet size
+     */
+    void recordSent(size_t bytes) {
+        bytesSent.fetch_add(bytes,std::memory_order_relaxed);
+        packetsSent.fetch_add(1,std::memory_order_relaxed);
+        if (parent) { parent->recordSent(bytes); }
+    }
+
+    /**
+     * Records a packet received of the given size
+     *
+     * @param bytes The packet size
+     */
+    void recordReceived(size_t bytes) {
+        bytesReceived.fetch_add(bytes,std::memory_order_relaxed);
+        packetsReceived.fetch_add(1,std::memory_order_relaxed);
+        if (parent) { parent->recordReceived(bytes); }
+    }
+
+    /**
+     * Records a change in the number of buffered bytes
+     *
+     * As several data channels contribute to the same counters, each channel
+     * reports the change since its last sample. Unsigned overflow makes this
+     * work for negative changes as well.
+     *
+     * @param delta The change in buffered bytes
+     */
+    void recordBuffered(size_t delta) {
+        bufferedAmount.fetch_add(delta,std::memory_order_relaxed);
+        if (parent) { parent->recordBuffered(delta); }
+    }
+
+    /**
+     * Copies the counters into the given snapshot
+     *
+     * @param stats The snapshot to store the result
+     */
+    void snapshot(NetcodeStats& stats) const {
+        stats.bytesSent = bytesSent.load(std::memory_order_relaxed);
+        stats.bytesReceived = bytesReceived.load(std::memory_order_relaxed);
+        stats.packetsSent = packetsSent.load(std::memory_order_relaxed);
+        stats.packetsReceived = packetsReceived.load(std::memory_order_relaxed);
+        stats.bufferedAmount = bufferedAmount.load(std::memory_order_relaxed);
+        stats.rtt = rtt.load(std::memory_order_relaxed);
+    }
+};
+
+    }
+}
+
+#endif /* __CU_NETCODE_STATS_H__ */
@@ -0,0 +1,541 @@
+//
+//  CUNetcodeVoice.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module is part of a Web RTC implementation of the classic CUGL networking
+//  library. It provides voice chat over a NetcodeConnection. Audio is taken
+//  from an AudioInput capture stream, encoded on a background thread, and sent
+//  along the unreliable lane. On the receiving side, an audio node buffers the
+//  frames of each speaker in an adaptive jitter buffer, conceals lost frames,
+//  and mixes the speakers for an audio graph.
+//
+//  Voice is encoded as 16 kHz mono IMA ADPCM in 20 ms frames. Every frame
+//  carries its own codec state, so a lost frame never corrupts the next one.
+//
+//  These classes uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_NETCODE_VOICE_H__
+#define __CU_NETCODE_VOICE_H__
+#include <cugl/audio/graph/CUAudioNode.h>
+#include <cugl/util/CUMPSCQueue.h>
+#include <SDL_stdinc.h>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <cstddef>
+
+/** The first byte of every voice frame (reserved by the connection) */
+#define NETCODE_VOICE_MARKER    std::byte{0xFC}
+/** The sample rate of encoded voice */
+#define NETCODE_VOICE_RATE      16000
+/** The number of samples in a voice frame (20 ms) */
+#define NETCODE_VOICE_FRAME     320
+/** The size of a voice frame header (marker, sequence, and codec state) */
+#define NETCODE_VOICE_HEADER    6
+/** The maximum number of speakers mixed at once */
+#define NETCODE_VOICE_SPEAKERS  8
+/** The number of frames each speaker can buffer (must be a power of two) */
+#define NETCODE_VOICE_JITTER    16
+
+namespace cugl {
+
+    /** Forward reference to the audio graph classes */
+    namespace audio {
+        class AudioInput;
+    }
+
+    /**
+     * The CUGL networking classes.
+     *
+     * This internal namespace is for optional networking package. Currently CUGL
+     * supports ad-hoc game lobbies using web-sockets. The sockets must connect
+     * connect to a CUGL game lobby server.
+     */
+    namespace net {
+
+/** Forward reference to the network connection */
+class NetcodeConnection;
+
+#pragma mark -
+#pragma mark NetcodeVoiceNode
+/**
+ * This class is an audio node that plays the voice received from other players.
+ *
+ * This node is the root of an audio DAG, much like {@link audio::AudioPlayer}.
+ * It mixes every speaker into a single stream, and so it typically feeds an
+ * {@link audio::AudioMixer}. The node must have the sample rate of the graph
+ * it is attached to. Voice is upsampled from {@link NETCODE_VOICE_RATE}, and
+ * is copied to every channel.
+ *
+ * Each speaker has a jitter buffer. Playback of a speaker starts once it has
+ * buffered its target number of frames, which starts at two (40 ms). If a
+ * frame arrives after it should have played, the target grows, up to the
+ * maximum delay. If the buffer stays above the target, a frame is skipped to
+ * bring the delay back down. And the target shrinks again after a while with
+ * no late frames. A frame that is missing when it is due is concealed by
+ * repeating the previous frame at reduced volume. After several missing
+ * frames in a row, the speaker goes silent until it starts talking again.
+ *
+ * Frames are given to this node with {@link #push}, which may be called from
+ * any thread. It never allocates memory and never takes a lock. Neither does
+ * {@link #read}. You should never need to call push yourself, as that is done
+ * by {@link NetcodeVoice}.
+ *
+ * The audio graph should only be accessed in the main thread. In addition,
+ * no methods marked as AUDIO THREAD ONLY should ever be accessed by the
+ * user.
+ *
+ * This class does not support any actions for the {@link AudioNode#setCallback}.
+ */
+class NetcodeVoiceNode : public audio::AudioNode {
+public:
+    /**
+     * A single encoded voice frame.
+     *
+     * This is a plain value, so that it can be passed to the audio thread
+     * without allocating any memory.
+     */
+    struct Frame {
+        /** The speaker of this frame (a {@link NetcodeConnection::PeerHandle}) */
+        Uint32 source;
+        /** The frame sequence number */
+        Uint16 sequence;
+        /** The codec predictor at the start of the frame */
+        Sint16 predictor;
+        /** The codec step index at the start of the frame */
+        Uint8 index;
+        /** The encoded samples (two per byte) */
+        Uint8 data[NETCODE_VOICE_FRAME/2];
+    };
+
+private:
+    /** The playback state of a single speaker (AUDIO THREAD ONLY) */
+    struct Speaker {
+        /** The speaker of this slot (0 if the slot is free) */
+        Uint32 source;
+        /** Whether this speaker is currently playing */
+        bool playing;
+        /** The sequence number of the next frame to play */
+        Uint16 next;
+        /** The number of frames to buffer before playback */
+        Uint32 target;
+        /** The number of frames buffered (but not yet played) */
+        Uint32 depth;
+        /** The number of consecutive frames concealed */
+        Uint32 losses;
+        /** The number of consecutive frames played above the target */
+        Uint32 excess;
+        /** The number of frames played since the last late frame */
+        Uint32 stable;
+        /** The number of output frames since the last frame arrived */
+        Uint64 idle;
+        /** Whether each jitter buffer slot holds a frame */
+        bool valid[NETCODE_VOICE_JITTER];
+        /** The jitter buffer, indexed by sequence number */
+        Frame frames[NETCODE_VOICE_JITTER];
+        /** The decoded samples of the current frame */
+        float pcm[NETCODE_VOICE_FRAME];
+        /** The position of the next decoded sample */
+        Uint32 position;
+        /** The previous decoded sample (for interpolation) */
+        float previous;
+        /** The current decoded sample (for interpolation) */
+        float current;
+        /** The fractional position between the previous and current sample */
+        double phase;
+    };
+
+    /** The frames waiting for the audio thread */
+    MPSCQueue<Frame> _queue;
+    /** The speakers (AUDIO THREAD ONLY) */
+    Speaker* _speakers;
+    /** The number of frames concealed since this node was initialized */
+    std::atomic<size_t> _concealed;
+    /** The number of frames that arrived too late to play */
+    std::atomic<size_t> _late;
+
+    /**
+     * Stores a frame in the jitter buffer of its speaker
+     *
+     * AUDIO THREAD ONLY: Users should never access this method directly.
+     *
+     * @param frame The frame to store
+     */
+    void store(const Frame& frame);
+
+    /**
+     * Decodes the next frame of the given speaker
+     *
+     * If the frame is missing, it is concealed. This method returns false if
+     * the speaker has stopped playing.
+     *
+     * AUDIO THREAD ONLY: Users should never access this method directly.
+     *
+     * @param speaker   The speaker to advance
+     *
+     * @return true if the speaker is still playing
+     */
+    bool advance(Speaker& speaker);
+
+public:
+    /**
+     * Creates a degenerate voice node.
+     *
+     * The node has not been initialized, so it is not active.  The node
+     * must be initialized to be used.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a node on
+     * the heap, use one of the static constructors instead.
+     */
+    NetcodeVoiceNode();
+
+    /**
+     * Deletes the voice node, disposing of all resources
+     */
+    ~NetcodeVoiceNode() { dispose(); }
+
+    /**
+     * Initializes the node with default stereo settings
+     *
+     * The number of channels is two, for stereo output. The sample rate is
+     * the modern standard of 48000 HZ.
+     *
+     * @return true if initialization was successful
+     */
+    virtual bool init() override;
+
+    /**
+     * Initializes the node with the given number of channels and sample rate
+     *
+     * @param channels  The number of audio channels
+     * @param rate      The sample rate (frequency) in HZ
+     *
+     * @return true if initialization was successful
+     */
+    virtual bool init(Uint8 channels, Uint32 rate) override;
+
+    /**
+     * Disposes any resources allocated for this node
+     *
+     * The state of the node is reset to that of an uninitialized constructor.
+     * Unlike the destructor, this method allows the node to be reinitialized.
+     */
+    virtual void dispose() override;
+
+    /**
+     * Returns a newly allocated voice node with default stereo settings
+     *
+     * The number of channels is two, for stereo output. The sample rate is
+     * the modern standard of 48000 HZ.
+     *
+     * @return a newly allocated voice node with default stereo settings
+     */
+    static std::shared_ptr<NetcodeVoiceNode> alloc() {
+        std::shared_ptr<NetcodeVoiceNode> result = std::make_shared<NetcodeVoiceNode>();
+        return (result->init() ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated voice node with the given channels and sample rate
+     *
+     * @param channels  The number of audio channels
+     * @param rate      The sample rate (frequency) in HZ
+     *
+     * @return a newly allocated voice node with the given channels and sample rate
+     */
+    static std::shared_ptr<NetcodeVoiceNode> alloc(Uint8 channels, Uint32 rate) {
+        std::shared_ptr<NetcodeVoiceNode> result = std::make_shared<NetcodeVoiceNode>();
+        return (result->init(channels,rate) ? result : nullptr);
+    }
+
+#pragma mark Voice Frames
+    /**
+     * Adds a voice frame to this node.
+     *
+     * This method may be called from any thread. It never blocks. If the audio
+     * thread has fallen behind, the frame is dropped.
+     *
+     * @param frame The voice frame
+     */
+    void push(const Frame& frame);
+
+    /**
+     * Returns the number of frames concealed since this node was initialized.
+     *
+     * A frame is concealed if it is missing when it is due to be played, either
+     * because it was lost or because it arrived late.
+     *
+     * @return the number of frames concealed since this node was initialized.
+     */
+    size_t getConcealed() const { return _concealed.load(std::memory_order_relaxed); }
+
+    /**
+     * Returns the number of frames that arrived after they were due.
+     *
+     * Each late frame increases the jitter buffer delay for its speaker.
+     *
+     * @return the number of frames that arrived after they were due.
+     */
+    size_t getLate() const { return _late.load(std::memory_order_relaxed); }
+
+#pragma mark Audio Graph
+    /**
+     * Returns true if this audio node has no more data.
+     *
+     * A voice node never completes, as a speaker may talk at any time.
+     *
+     * @return true if this audio node has no more data.
+     */
+    virtual bool completed() override { return false; }
+
+    /**
+     * Reads up to the specified number of frames into the given buffer
+     *
+     * AUDIO THREAD ONLY: Users should never access this method directly.
+     * The only exception is when the user needs to create a custom subclass
+     * of this AudioNode.
+     *
+     * The buffer should have enough room to store frames * channels elements.
+     * The channels are interleaved into the output buffer. This node always
+     * reads the requested number of frames, filling in silence when no one
+     * is talking.
+     *
+     * @param buffer    The read buffer to store the results
+     * @param frames    The maximum number of frames to read
+     *
+     * @return the actual number of frames read
+     */
+    virtual Uint32 read(float* buffer, Uint32 frames) override;
+};
+
+#pragma mark -
+#pragma mark NetcodeVoice
+/**
+ * This class provides voice chat over a {@link NetcodeConnection}.
+ *
+ * A voice object does two things. It transmits the audio of an
+ * {@link audio::AudioInput} to every other player, and it plays the voice of
+ * every other player through a {@link NetcodeVoiceNode}, which is available
+ * with {@link #getOutput}. Attach that node to the audio graph (e.g. to an
+ * {@link audio::AudioMixer}) to hear the other players.
+ *
+ * To transmit, call {@link #start} with an input node. This enables the capture
+ * stream of the input (see {@link audio::AudioInput#setCaptureSize}), so the
+ * input does not need to be part of an audio graph. A background thread takes
+ * the captured audio, downmixes and resamples it, encodes it in 20 ms frames,
+ * and sends it on the unreliable lane. Frames that are nearly silent are not
+ * sent at all. The audio thread is never blocked.
+ *
+ * Received frames never reach {@link NetcodeConnection#receive}. The connection
+ * hands them straight to this object on the network thread, and they go from
+ * there to the audio thread without a lock. Voice frames start with the byte
+ * {@link NETCODE_VOICE_MARKER}, which the connection reserves while a voice
+ * object is attached. Without batching, the added latency is the capture
+ * buffer, one frame, the network, and the jitter buffer. That is typically well
+ * under 150 ms. If batching or scheduling is enabled, frames leave on the next
+ * {@link NetcodeConnection#flush} like any other message.
+ *
+ * There may only be one voice object per connection.
+ */
+class NetcodeVoice : public std::enable_shared_from_this<NetcodeVoice> {
+private:
+    /** The connection for this voice chat */
+    std::weak_ptr<NetcodeConnection> _network;
+    /** The node for playing the voice of the other players */
+    std::shared_ptr<NetcodeVoiceNode> _output;
+    /** The input node being transmitted (nullptr if not transmitting) */
+    std::shared_ptr<audio::AudioInput> _input;
+    /** The thread encoding and sending the captured audio */
+    std::thread _thread;
+    /** Whether the encoding thread should keep running */
+    std::atomic<bool> _running;
+    /** The minimum RMS level of a frame to transmit (0 to send everything) */
+    std::atomic<float> _gate;
+    /** The number of frames sent since this object was initialized */
+    std::atomic<size_t> _sent;
+
+    /**
+     * Runs the encoding thread until {@link #stop} is called.
+     */
+    void run();
+
+    /** Allow the connection to deliver voice frames */
+    friend class NetcodeConnection;
+
+    /**
+     * Delivers a voice frame received from a peer.
+     *
+     * This method is called by the connection on the network thread. Invalid
+     * frames are ignored.
+     *
+     * @param source    The peer handle of the speaker
+     * @param data      The voice frame
+     */
+    void receive(Uint32 source, const std::vector<std::byte>& data);
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates a degenerate voice chat.
+     *
+     * This object has not been initialized, and cannot be used.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    NetcodeVoice();
+
+    /**
+     * Deletes this voice chat, disposing of all resources
+     */
+    ~NetcodeVoice() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this voice chat.
+     *
+     * This stops any transmission, and detaches this object from the connection.
+     * A disposed voice chat can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes a voice chat for the given connection.
+     *
+     * The voice of the other players is played by an audio node with the given
+     * number of channels and sample rate. These should match the audio graph
+     * that the node is attached to. This object replaces any voice chat already
+     * attached to the connection.
+     *
+     * @param network   The network connection
+     * @param channels  The number of channels of the output node
+     * @param rate      The sample rate of the output node
+     *
+     * @return true if initialization was successful
+     */
+    bool init(const std::shared_ptr<NetcodeConnection>& network, Uint8 channels, Uint32 rate);
+
+    /**
+     * Returns a newly allocated voice chat for the given connection.
+     *
+     * The voice of the other players is played by an audio node with the given
+     * number of channels and sample rate. These should match the audio graph
+     * that the node is attached to. This object replaces any voice chat already
+     * attached to the connection.
+     *
+     * @param network   The network connection
+     * @param channels  The number of channels of the output node
+     * @param rate      The sample rate of the output node
+     *
+     * @return a newly allocated voice chat for the given connection.
+     */
+    static std::shared_ptr<NetcodeVoice> alloc(const std::shared_ptr<NetcodeConnection>& network,
+                                               Uint8 channels, Uint32 rate) {
+        std::shared_ptr<NetcodeVoice> result = std::make_shared<NetcodeVoice>();
+        return (result->init(network,channels,rate) ? result : nullptr);
+    }
+
+#pragma mark Transmission
+    /**
+     * Starts transmitting the given input node.
+     *
+     * This enables the capture stream of the input node, and starts the
+     * encoding thread. If this object is already transmitting, it switches
+     * to the new input.
+     *
+     * @param input The input node to transmit
+     *
+     * @return true if transmission started
+     */
+    bool start(const std::shared_ptr<audio::AudioInput>& input);
+
+    /**
+     * Stops transmitting.
+     *
+     * This disables the capture stream of the input node. The voice of the
+     * other players is still played. If this object is not transmitting, this
+     * method does nothing.
+     */
+    void stop();
+
+    /**
+     * Returns true if this object is transmitting.
+     *
+     * @return true if this object is transmitting.
+     */
+    bool isTransmitting() const { return _running.load(); }
+
+    /**
+     * Returns the minimum level of a frame to transmit.
+     *
+     * See {@link #setGate} for more information.
+     *
+     * @return the minimum level of a frame to transmit.
+     */
+    float getGate() const { return _gate.load(); }
+
+    /**
+     * Sets the minimum level of a frame to transmit.
+     *
+     * The level is the root mean square of the frame samples. Frames below
+     * this level are not sent, which saves bandwidth when the player is not
+     * talking. Frames are sent for a short while after the level drops, so
+     * that the ends of words are not clipped. A value of 0 sends every frame.
+     *
+     * @param level The minimum level of a frame to transmit
+     */
+    void setGate(float level) { _gate.store(level); }
+
+    /**
+     * Returns the number of frames sent since this object was initialized.
+     *
+     * @return the number of frames sent since this object was initialized.
+     */
+    size_t getSent() const { return _sent.load(); }
+
+#pragma mark Playback
+    /**
+     * Returns the audio node playing the voice of the other players.
+     *
+     * Attach this node to the audio graph to hear the other players.
+     *
+     * @return the audio node playing the voice of the other players.
+     */
+    const std::shared_ptr<NetcodeVoiceNode>& getOutput() const { return _output; }
+};
+
+    }
+}
+
+#endif /* __CU_NETCODE_VOICE_H__ */
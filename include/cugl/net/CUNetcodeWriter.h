@@ -0,0 +1,400 @@
+//
+//  CUNetcodeWriter.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides the low level byte writer and reader shared by all of
+//  the serializers in the networking libraries (NetcodeSerializer in the net
+//  package, and LWSerializer in the netphysics package). The serializers differ
+//  only in their format. All of the byte handling is here.
+//
+//  Values are always written in network (big-endian) order. The byte order of
+//  the platform is determined at compile time by CUEndian.h, so there is no
+//  cost on big-endian platforms. All loads and stores go through memcpy, so
+//  they are safe on platforms that do not support unaligned access.
+//
+//  These classes are lightweight views on memory owned by the caller. They have
+//  no allocators, and should be created on the stack as needed.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_NETCODE_WRITER_H__
+#define __CU_NETCODE_WRITER_H__
+#include <cugl/base/CUEndian.h>
+#include <SDL_stdinc.h>
+#include <type_traits>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+
+/** The maximum number of bytes in a variable length 64 bit integer */
+#define NETCODE_VARINT_MAXLEN   10
+
+namespace cugl {
+
+    /**
+     * The CUGL networking classes.
+     *
+     * This internal namespace is for optional networking package. Currently CUGL
+     * supports ad-hoc game lobbies using web-sockets. The sockets must connect
+     * connect to a CUGL game lobby server.
+     */
+    namespace net {
+
+/**
+ * Returns the given value converted between host and network order.
+ *
+ * This conversion is its own inverse, so it is used for both reading and
+ * writing. Single byte values are returned as is.
+ *
+ * @param value The value to convert
+ *
+ * @return the given value converted between host and network order.
+ */
+template <typename T>
+inline T netcode_order(T value) {
+    static_assert(std::is_arithmetic<T>::value, "Only arithmetic types have a byte order");
+    if constexpr (sizeof(T) == 1) {
+        return value;
+    } else {
+        return static_cast<T>(marshall(value));
+    }
+}
+
+#pragma mark -
+#pragma mark NetcodeWriter
+/**
+ * This class writes values in network order to memory owned by the caller.
+ *
+ * A writer either appends to an arena (a byte vector, which grows as needed)
+ * or fills a span (a fixed block of memory). A writer to a span never allocates.
+ * If a value does not fit in the span, nothing is written, and the writer is
+ * marked as overflowed. A writer to an arena appends with a single resize and
+ * memcpy per value. Use {@link #reserve} to size the arena ahead of time, so that
+ * it never reallocates while writing.
+ *
+ * A writer is a view, and it does not own the memory. The memory must outlive
+ * the writer.
+ */
+class NetcodeWriter {
+private:
+    /** The arena to append to (nullptr if writing to a span) */
+    std::vector<std::byte>* _arena;
+    /** The span to write to (nullptr if writing to an arena) */
+    std::byte* _span;
+    /** The capacity of the span */
+    size_t _capacity;
+    /** The number of bytes written to the span */
+    size_t _size;
+    /** Whether a write did not fit in the span */
+    bool _overflow;
+
+    /**
+     * Returns a pointer to the given number of bytes at the end of the output
+     *
+     * This method returns nullptr (and marks the writer as overflowed) if the
+     * bytes do not fit in the span.
+     *
+     * @param len   The number of bytes to add
+     *
+     * @return a pointer to the given number of bytes at the end of the output
+     */
+    std::byte* extend(size_t len) {
+        if (_arena != nullptr) {
+            size_t pos = _arena->size();
+            _arena->resize(pos+len);
+            return _arena->data()+pos;
+        } else if (_capacity-_size < len) {
+            _overflow = true;
+            return nullptr;
+        }
+        std::byte* result = _span+_size;
+        _size += len;
+        return result;
+    }
+
+public:
+    /**
+     * Creates a writer that appends to the given arena.
+     *
+     * Any bytes already in the arena are preserved.
+     *
+     * @param arena The byte vector to append to
+     */
+    NetcodeWriter(std::vector<std::byte>& arena) :
+        _arena(&arena), _span(nullptr), _capacity(0), _size(0), _overflow(false) {}
+
+    /**
+     * Creates a writer that fills the given span.
+     *
+     * @param span      The memory to write to
+     * @param capacity  The size of the span in bytes
+     */
+    NetcodeWriter(std::byte* span, size_t capacity) :
+        _arena(nullptr), _span(span), _capacity(capacity), _size(0), _overflow(false) {}
+
+    /**
+     * Returns the number of bytes in the output.
+     *
+     * For an arena, this includes any bytes that were there before the writer
+     * was created.
+     *
+     * @return the number of bytes in the output.
+     */
+    size_t size() const { return _arena != nullptr ? _arena->size() : _size; }
+
+    /**
+     * Returns true if a write did not fit in the span.
+     *
+     * A writer to an arena never overflows.
+     *
+     * @return true if a write did not fit in the span.
+     */
+    bool overflowed() const { return _overflow; }
+
+    /**
+     * Ensures that the given number of bytes can be written without allocating.
+     *
+     * This method has no effect on a span.
+     *
+     * @param bytes The number of bytes to be written
+     */
+    void reserve(size_t bytes) {
+        if (_arena != nullptr) {
+            _arena->reserve(_arena->size()+bytes);
+        }
+    }
+
+    /**
+     * Writes the given bytes as is.
+     *
+     * @param src   The bytes to write
+     * @param len   The number of bytes to write
+     *
+     * @return true if the bytes were written
+     */
+    bool writeBytes(const void* src, size_t len) {
+        if (len == 0) {
+            return true;
+        }
+        std::byte* dst = extend(len);
+        if (dst == nullptr) {
+            return false;
+        }
+        std::memcpy(dst,src,len);
+        return true;
+    }
+
+    /**
+     * Writes the given value in network order.
+     *
+     * @param value The value to write
+     *
+     * @return true if the value was written
+     */
+    template <typename T>
+    bool write(T value) {
+        T ordered = netcode_order(value);
+        return writeBytes(&ordered,sizeof(T));
+    }
+
+    /**
+     * Writes the given value as a variable length integer.
+     *
+     * The integer is written 7 bits at a time, least significant group first. The
+     * high bit of each byte indicates whether there are more bytes to follow (LEB128).
+     *
+     * @param value The value to write
+     *
+     * @return true if the value was written
+     */
+    bool writeVarint(Uint64 value) {
+        std::byte buffer[NETCODE_VARINT_MAXLEN];
+        size_t len = 0;
+        while (value >= 0x80) {
+            buffer[len++] = static_cast<std::byte>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        buffer[len++] = static_cast<std::byte>(value);
+        return writeBytes(buffer,len);
+    }
+
+    /**
+     * Overwrites the value at the given position in network order.
+     *
+     * This is used to fill in a header (such as a length or a count) once the
+     * rest of the output is known. The value must fit entirely in the output
+     * written so far.
+     *
+     * @param pos   The position of the value in the output
+     * @param value The value to write
+     *
+     * @return true if the value was written
+     */
+    template <typename T>
+    bool rewrite(size_t pos, T value) {
+        if (pos > size() || size()-pos < sizeof(T)) {
+            return false;
+        }
+        T ordered = netcode_order(value);
+        std::byte* base = (_arena != nullptr ? _arena->data() : _span);
+        std::memcpy(base+pos,&ordered,sizeof(T));
+        return true;
+    }
+};
+
+#pragma mark -
+#pragma mark NetcodeReader
+/**
+ * This class reads values in network order from memory owned by the caller.
+ *
+ * A reader is a view on a span of bytes, and never copies them. If a value
+ * extends past the end of the span, nothing is read, and the reader is
+ * exhausted. So a truncated or malicious message can never cause a read out
+ * of bounds.
+ *
+ * A reader does not own the memory. The memory must outlive the reader.
+ */
+class NetcodeReader {
+private:
+    /** The span to read from */
+    const std::byte* _data;
+    /** The size of the span */
+    size_t _size;
+    /** The position of the next byte to read */
+    size_t _pos;
+
+public:
+    /**
+     * Creates a reader with nothing to read.
+     */
+    NetcodeReader() : _data(nullptr), _size(0), _pos(0) {}
+
+    /**
+     * Creates a reader for the given span.
+     *
+     * @param data  The bytes to read
+     * @param size  The number of bytes to read
+     */
+    NetcodeReader(const std::byte* data, size_t size) : _data(data), _size(size), _pos(0) {}
+
+    /**
+     * Creates a reader for the given byte vector.
+     *
+     * The vector must not be modified while it is being read.
+     *
+     * @param data  The bytes to read
+     */
+    NetcodeReader(const std::vector<std::byte>& data) : _data(data.data()), _size(data.size()), _pos(0) {}
+
+    /**
+     * Returns the position of the next byte to read.
+     *
+     * @return the position of the next byte to read.
+     */
+    size_t position() const { return _pos; }
+
+    /**
+     * Returns the number of bytes left to read.
+     *
+     * @return the number of bytes left to read.
+     */
+    size_t remaining() const { return _size-_pos; }
+
+    /**
+     * Returns true if there is nothing left to read.
+     *
+     * @return true if there is nothing left to read.
+     */
+    bool isExhausted() const { return _pos >= _size; }
+
+    /**
+     * Copies the given number of bytes as is.
+     *
+     * If there are not enough bytes left, nothing is copied, the reader is
+     * exhausted, and this method returns false.
+     *
+     * @param dst   The buffer to copy into
+     * @param len   The number of bytes to copy
+     *
+     * @return true if the bytes were copied
+     */
+    bool readBytes(void* dst, size_t len) {
+        if (_size-_pos < len) {
+            _pos = _size;
+            return false;
+        } else if (len > 0) {
+            std::memcpy(dst,_data+_pos,len);
+            _pos += len;
+        }
+        return true;
+    }
+
+    /**
+     * Reads a value in network order.
+     *
+     * If there are not enough bytes left, value is unchanged, the reader is
+     * exhausted, and this method returns false.
+     *
+     * @param value The value to store the result
+     *
+     * @return true if the value was read
+     */
+    template <typename T>
+    bool read(T& value) {
+        T ordered;
+        if (!readBytes(&ordered,sizeof(T))) {
+            return false;
+        }
+        value = netcode_order(ordered);
+        return true;
+    }
+
+    /**
+     * Reads a variable length integer.
+     *
+     * If the span ends before the integer does, value is unchanged, the reader
+     * is exhausted, and this method returns false.
+     *
+     * @param value The value to store the result
+     *
+     * @return true if the value was read
+     */
+    bool readVarint(Uint64& value) {
+        Uint64 result = 0;
+        for (size_t ii = 0; ii < NETCODE_VARINT_MAXLEN && _pos < _size; ii++) {
+            Uint8 next = static_cast<Uint8>(_data[_pos++]);
+            result |= static_cast<Uint64>(next & 0x7F) << (7*ii);
+            if ((next & 0x80) == 0) {
+                value = result;
+                return true;
+            }
+        }
+        _pos = _size;
+        return false;
+    }
+};
+
+    }
+}
+
+#endif /* __CU_NETCODE_WRITER_H__ */
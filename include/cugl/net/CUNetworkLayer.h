@@ -41,9 +41,12 @@
 //
 #ifndef __CU_NETWORK_LAYER_H__
 #define __CU_NETWORK_LAYER_H__
+#include <cugl/net/CUICEAddress.h>
 #include <unordered_map>
+#include <vector>
 #include <string>
 #include <memory>
+#include <future>
 #include <mutex>
 #include <atomic>
 
@@ -164,6 +167,74 @@ public:
      * @return true if the networking layer is in debug mode.
      */
      bool isDebug() const { return _debug; }
+    
+#pragma mark ICE Servers
+    /**
+     * Starts resolving the hostnames of the given ICE servers.
+     *
+     * Every STUN/TURN server specified by hostname must be resolved before ICE
+     * gathering can contact it. On mobile networks this can add noticeably to
+     * the time it takes to join a game. This method resolves the hostnames in
+     * the background, and caches the results for {@link #resolve}. It never
+     * blocks, and each hostname is only resolved once.
+     *
+     * Once a server is resolved, it is also probed with STUN binding requests
+     * to measure its round trip time (see {@link #getRTT}). Both STUN and TURN
+     * servers answer these requests. The measurements are used by
+     * {@link #rank} to prefer nearby servers.
+     *
+     * This method is called by {@link NetcodeConnection} when it is initialized,
+     * well before it needs to create any peer connections.
+     *
+     * @param servers   The ICE servers to resolve
+     */
+    void prewarm(const std::vector<ICEAddress>& servers);
+    
+    /**
+     * Returns the given ICE server with its hostname resolved.
+     *
+     * If the hostname of this server has been resolved by {@link #prewarm},
+     * the result has the numeric address instead. Otherwise, the server is
+     * returned as is (so that the RTC layer resolves it). This method never
+     * blocks on a lookup that has not finished.
+     *
+     * @param server    The ICE server to resolve
+     *
+     * @return the given ICE server with its hostname resolved.
+     */
+    ICEAddress resolve(const ICEAddress& server);
+
+    /**
+     * Returns the measured round trip time to the given ICE server.
+     *
+     * The value is in milliseconds. It is the best of several STUN binding
+     * requests sent after {@link #prewarm}. This method returns -1 if the
+     * server was never probed, if the probe has not finished, or if the
+     * server did not answer. It never blocks.
+     *
+     * @param server    The ICE server
+     *
+     * @return the measured round trip time to the given ICE server.
+     */
+    int64_t getRTT(const ICEAddress& server);
+
+    /**
+     * Returns the given ICE servers resolved and ranked by round trip time.
+     *
+     * The servers that answered their probe come first, nearest first. They
+     * are followed by the servers whose probe has not finished, and then by
+     * the servers that did not answer. Servers in the same group keep their
+     * original order. Each server is resolved as with {@link #resolve}.
+     *
+     * The RTC layer only uses the first STUN server, and it prefers relays
+     * in the order they are given. Hence this ranking keeps peers from
+     * gathering through a distant server. This method never blocks.
+     *
+     * @param servers   The ICE servers to rank
+     *
+     * @return the given ICE servers resolved and ranked by round trip time.
+     */
+    std::vector<ICEAddress> rank(const std::vector<ICEAddress>& servers);
 
 private:
     /** The networking layer singleton */
@@ -171,6 +242,25 @@ private:
 
     /** Whether this manager is in debug mode */
     bool _debug;
+    /** The hostname lookups for the ICE servers (empty if the lookup failed) */
+    std::unordered_map<std::string, std::shared_future<std::string>> _lookups;
+    /** The round trip probes (in microseconds) keyed by address and port */
+    std::unordered_map<std::string, std::shared_future<int64_t>> _probes;
+    /** A mutex to protect the lookups */
+    std::mutex _mutex;
+
+    /**
+     * Returns the probe result for the given ICE server.
+     *
+     * The result is the round trip time in microseconds. It is -1 if there
+     * is no probe result yet, and -2 if the server did not answer. This
+     * method never blocks.
+     *
+     * @param server    The ICE server
+     *
+     * @return the probe result for the given ICE server.
+     */
+    int64_t getProbe(const ICEAddress& server);
 
     /**
      * Creates the RTC networking layer
@@ -35,6 +35,12 @@
 #include "CUNetcodeConnection.h"
 #include "CUNetcodePeer.h"
 #include "CUNetcodeChannel.h"
+#include "CUNetcodeStats.h"
+#include "CUNetcodeWriter.h"
 #include "CUNetcodeSerializer.h"
+#include "CUNetcodeCompressor.h"
+#include "CUNetcodeRecorder.h"
+#include "CUNetcodeSimulator.h"
+#include "CUNetcodeVoice.h"
 
 #endif /* __CU_NET_PKG_H__ */
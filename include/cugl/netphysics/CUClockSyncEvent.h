@@ -0,0 +1,224 @@
+//
+//  CUClockSyncEvent.h
+//  Networked Physics Library
+//
+//  This class represents a clock synchronization message. Clients send pings
+//  to the host, and the host answers with a pong carrying its game tick. The
+//  NetEventController uses these to estimate the round trip time and the
+//  offset between the local game tick and the game tick of the host.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_CLOCK_SYNC_EVENT_H__
+#define __CU_CLOCK_SYNC_EVENT_H__
+
+#include <cugl/netphysics/CUNetEvent.h>
+#include <cugl/netphysics/CULWBitSerializer.h>
+#include <SDL_stdinc.h>
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+/**
+ * This class represents a clock synchronization ping or pong.
+ *
+ * A ping holds the local game tick of the client when it was sent (the origin
+ * tick). The host answers with a pong that echoes the origin tick, together
+ * with the host game tick when the ping was received and when the pong was
+ * sent. These are the four timestamps of an NTP exchange, with the last one
+ * being the tick at which the client receives the pong.
+ *
+ * Clock sync events are created and consumed by the {@link NetEventController},
+ * and are never added to the inbound event queue.
+ */
+class ClockSyncEvent : public NetEvent {
+public:
+    /** The kind of clock synchronization message */
+    enum Type {
+        /** A request from a client */
+        PING = 0,
+        /** An answer from the host */
+        PONG = 1
+    };
+    
+private:
+    /** The serializer for packing messages into byte vectors. */
+    LWBitSerializer _serializer;
+    /** The deserializer for unpacking messages from byte vectors. */
+    LWBitDeserializer _deserializer;
+protected:
+    /** The kind of this message */
+    Type _type;
+    /** The client game tick when the ping was sent */
+    Uint64 _originTick;
+    /** The host game tick when the ping was received (pong only) */
+    Uint64 _receiveTick;
+    /** The host game tick when the pong was sent (pong only) */
+    Uint64 _transmitTick;
+
+public:
+    /**
+     * Constructs an empty ping.
+     */
+    ClockSyncEvent() : _type(PING), _originTick(0), _receiveTick(0), _transmitTick(0) {}
+
+    /**
+     * Returns a newly allocated empty ping.
+     */
+    static std::shared_ptr<ClockSyncEvent> alloc() {
+        return std::make_shared<ClockSyncEvent>();
+    }
+
+    /**
+     * Returns a newly allocated ping sent at the given tick.
+     *
+     * @param origin    The client game tick when the ping is sent
+     */
+    static std::shared_ptr<ClockSyncEvent> allocPing(Uint64 origin) {
+        auto result = std::make_shared<ClockSyncEvent>();
+        result->_originTick = origin;
+        return result;
+    }
+
+    /**
+     * Returns a newly allocated pong answering the given ping.
+     *
+     * @param origin    The origin tick of the ping
+     * @param receive   The host game tick when the ping was received
+     * @param transmit  The host game tick when the pong is sent
+     */
+    static std::shared_ptr<ClockSyncEvent> allocPong(Uint64 origin, Uint64 receive, Uint64 transmit) {
+        auto result = std::make_shared<ClockSyncEvent>();
+        result->_type = PONG;
+        result->_originTick = origin;
+        result->_receiveTick = receive;
+        result->_transmitTick = transmit;
+        return result;
+    }
+
+    /**
+     * Returns a newly allocated empty NetEvent
+     */
+    std::shared_ptr<NetEvent> newEvent() override {
+        return std::make_shared<ClockSyncEvent>();
+    }
+
+    /**
+     * Returns the kind of this message.
+     *
+     * @return the kind of this message.
+     */
+    Type getType() const {
+        return _type;
+    }
+
+    /**
+     * Returns the client game tick when the ping was sent.
+     *
+     * @return the client game tick when the ping was sent.
+     */
+    Uint64 getOriginTick() const {
+        return _originTick;
+    }
+
+    /**
+     * Returns the host game tick when the ping was received.
+     *
+     * This value is only meaningful for a pong.
+     *
+     * @return the host game tick when the ping was received.
+     */
+    Uint64 getReceiveTick() const {
+        return _receiveTick;
+    }
+
+    /**
+     * Returns the host game tick when the pong was sent.
+     *
+     * This value is only meaningful for a pong.
+     *
+     * @return the host game tick when the pong was sent.
+     */
+    Uint64 getTransmitTick() const {
+        return _transmitTick;
+    }
+
+    /**
+     * Resets this event so that it can be reused.
+     */
+    void reset() override {
+        NetEvent::reset();
+        _type = PING;
+        _originTick = 0;
+        _receiveTick = 0;
+        _transmitTick = 0;
+    }
+
+    /**
+     * Serializes all information in the event to a byte vector.
+     *
+     * A ping is a single varint after the type bit. A pong stores the host
+     * ticks relative to each other, so it is only a few bytes as well.
+     */
+    std::vector<std::byte> serialize() override {
+        _serializer.reset();
+        _serializer.writeBool(_type == PONG);
+        _serializer.writeVarint(_originTick);
+        if (_type == PONG) {
+            _serializer.writeVarint(_receiveTick);
+            _serializer.writeVarint(_transmitTick-_receiveTick);
+        }
+        return _serializer.serialize();
+    }
+
+    /**
+     * This method unpacks all information from the byte vector
+     * and stores it in this event.
+     */
+    void deserialize(const std::vector<std::byte>& data) override {
+        if (data.empty())
+            return;
+
+        _deserializer.reset();
+        _deserializer.receive(data);
+        _type = _deserializer.readBool() ? PONG : PING;
+        _originTick = _deserializer.readVarint();
+        if (_type == PONG) {
+            _receiveTick = _deserializer.readVarint();
+            _transmitTick = _receiveTick+_deserializer.readVarint();
+        }
+    }
+};
+
+    }
+}
+
+#endif /* __CU_CLOCK_SYNC_EVENT_H__ */
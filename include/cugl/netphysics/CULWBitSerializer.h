@@ -0,0 +1,438 @@
+//
+//  CULWBitSerializer.h
+//  Networked Physics Library
+//
+//  This class provides a bit-level serializer for networked physics. Like the
+//  LWSerializer, it has no type information and relies on the user to know
+//  the layout of the data. However, values are packed at the bit level rather
+//  than the byte level. Combined with quantization, this allows physics
+//  snapshots to be sent at a fraction of their original size.
+//
+//  Bits are packed least significant first. As all values are packed through
+//  integer shifts, the format does not depend on the endianness of the machine.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_LW_BIT_SERIALIZER_H__
+#define __CU_LW_BIT_SERIALIZER_H__
+
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cmath>
+#include <cugl/math/CUMathBase.h>
+#include <SDL_stdinc.h>
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+#pragma mark -
+#pragma mark LWBitSerializer
+/**
+ * This class packs values into a byte vector at the bit level.
+ *
+ * Values are written least significant bit first. You must call {@link #serialize}
+ * only after all values have been written, as it pads the final byte.
+ */
+class LWBitSerializer {
+private:
+    /** The buffered serialized data */
+    std::vector<std::byte> _data;
+    /** The bits that have not yet been written to the buffer */
+    Uint64 _scratch;
+    /** The number of bits in the scratch space */
+    Uint32 _count;
+
+public:
+    /**
+     * Constructor LWBitSerializer, no initialization required.
+     */
+    LWBitSerializer() : _scratch(0), _count(0) {}
+
+    /**
+     * Allocates a new LWBitSerializer.
+     */
+    static std::shared_ptr<LWBitSerializer> alloc() {
+        return std::make_shared<LWBitSerializer>();
+    }
+
+    /**
+     * Reserves space for the given number of bytes in the output buffer.
+     *
+     * @param bytes The number of bytes to reserve
+     */
+    void reserve(size_t bytes) {
+        _data.reserve(bytes);
+    }
+
+    /**
+     * Writes the given number of low order bits of the value.
+     *
+     * @param value The value to write
+     * @param bits  The number of bits to write (at most 32)
+     */
+    void writeBits(Uint32 value, Uint32 bits) {
+        if (bits == 0) {
+            return;
+        }
+        Uint64 mask = (((Uint64)1) << bits)-1;
+        _scratch |= (value & mask) << _count;
+        _count += bits;
+        while (_count >= 8) {
+            _data.push_back(static_cast<std::byte>(_scratch & 0xFF));
+            _scratch >>= 8;
+            _count -= 8;
+        }
+    }
+
+    /**
+     * Writes a boolean as a single bit.
+     *
+     * @param b The boolean to write
+     */
+    void writeBool(bool b) {
+        writeBits(b ? 1 : 0, 1);
+    }
+
+    /**
+     * Writes a float at full (32 bit) precision.
+     *
+     * @param f The float to write
+     */
+    void writeFloat(float f) {
+        Uint32 bits;
+        std::memcpy(&bits, &f, sizeof(Uint32));
+        writeBits(bits, 32);
+    }
+
+    /**
+     * Writes an unsigned integer as a variable length integer.
+     *
+     * The integer is written in 7 bit groups, each followed by a bit indicating
+     * if there are more groups to follow. Small values are therefore very cheap.
+     *
+     * @param value The value to write
+     */
+    void writeVarint(Uint64 value) {
+        while (value >= 0x80) {
+            writeBits((Uint32)(value & 0x7F), 7);
+            writeBits(1, 1);
+            value >>= 7;
+        }
+        writeBits((Uint32)value, 7);
+        writeBits(0, 1);
+    }
+
+    /**
+     * Writes a float quantized to the given range.
+     *
+     * The value is clamped to the range [min,max] and then mapped evenly onto
+     * the integers representable in the given number of bits. The error is at
+     * most half of (max-min)/(2^bits-1).
+     *
+     * @param value The value to write
+     * @param min   The minimum value of the range
+     * @param max   The maximum value of the range
+     * @param bits  The number of bits to use (at most 32)
+     */
+    void writeQuantized(float value, float min, float max, Uint32 bits) {
+        writeBits(quantize(value, min, max, bits), bits);
+    }
+
+    /**
+     * Writes an angle quantized to the given number of bits.
+     *
+     * The angle is taken modulo 2 pi, so only the direction is preserved. The
+     * error is at most pi/2^bits radians.
+     *
+     * @param angle The angle (in radians) to write
+     * @param bits  The number of bits to use (at most 32)
+     */
+    void writeAngle(float angle, Uint32 bits) {
+        writeBits(quantizeAngle(angle, bits), bits);
+    }
+
+    /**
+     * Returns the quantized value used by {@link #writeQuantized}.
+     *
+     * @param value The value to quantize
+     * @param min   The minimum value of the range
+     * @param max   The maximum value of the range
+     * @param bits  The number of bits to use (at most 32)
+     *
+     * @return the quantized value used by {@link #writeQuantized}.
+     */
+    static Uint32 quantize(float value, float min, float max, Uint32 bits) {
+        double steps = (double)((((Uint64)1) << bits)-1);
+        double t = max > min ? (value-min)/(double)(max-min) : 0;
+        t = t < 0 ? 0 : (t > 1 ? 1 : t);
+        return (Uint32)std::llround(t*steps);
+    }
+
+    /**
+     * Returns the quantized angle used by {@link #writeAngle}.
+     *
+     * @param angle The angle (in radians) to quantize
+     * @param bits  The number of bits to use (at most 32)
+     *
+     * @return the quantized angle used by {@link #writeAngle}.
+     */
+    static Uint32 quantizeAngle(float angle, Uint32 bits) {
+        Uint64 steps = ((Uint64)1) << bits;
+        double t = std::fmod((double)angle, 2*M_PI)/(2*M_PI);
+        if (t < 0) {
+            t += 1;
+        }
+        return (Uint32)(((Uint64)std::llround(t*steps)) & (steps-1));
+    }
+
+    /**
+     * Returns the serialized data.
+     *
+     * This method pads any partially written byte with zeroes. Hence it should
+     * only be called once all values have been written.
+     *
+     * @return A const reference to the serialized data. (Will be lost if reset)
+     */
+    const std::vector<std::byte>& serialize() {
+        if (_count > 0) {
+            _data.push_back(static_cast<std::byte>(_scratch & 0xFF));
+            _scratch = 0;
+            _count = 0;
+        }
+        return _data;
+    }
+
+    /**
+     * Clears the input buffer.
+     *
+     * !! This will make previous serialize() returns invalid !!
+     */
+    void reset() {
+        _data.clear();
+        _scratch = 0;
+        _count = 0;
+    }
+};
+
+#pragma mark -
+#pragma mark LWBitDeserializer
+/**
+ * This class unpacks values written by a {@link LWBitSerializer}.
+ *
+ * Reads are bounds checked. Reading past the end of the message returns 0, and
+ * marks the deserializer as exhausted (see {@link #isExhausted}).
+ */
+class LWBitDeserializer {
+private:
+    /** The data to deserialize */
+    std::vector<std::byte> _data;
+    /** The position of the next byte to load */
+    size_t _pos;
+    /** The bits loaded but not yet read */
+    Uint64 _scratch;
+    /** The number of bits in the scratch space */
+    Uint32 _count;
+    /** Whether a read went past the end of the data */
+    bool _exhausted;
+
+public:
+    /**
+     * Constructor LWBitDeserializer, no initialization required.
+     */
+    LWBitDeserializer() : _pos(0), _scratch(0), _count(0), _exhausted(false) {}
+
+    /**
+     * Allocates a new LWBitDeserializer.
+     */
+    static std::shared_ptr<LWBitDeserializer> alloc() {
+        return std::make_shared<LWBitDeserializer>();
+    }
+
+    /**
+     * Loads a new message to be read.
+     *
+     * @param data  The byte vector serialized by {@link LWBitSerializer}
+     */
+    void receive(const std::vector<std::byte>& data) {
+        _data = data;
+        _pos = 0;
+        _scratch = 0;
+        _count = 0;
+        _exhausted = false;
+    }
+
+    /**
+     * Returns true if a read has gone past the end of the message.
+     *
+     * @return true if a read has gone past the end of the message.
+     */
+    bool isExhausted() const {
+        return _exhausted;
+    }
+
+    /**
+     * Returns the given number of bits as an unsigned integer.
+     *
+     * @param bits  The number of bits to read (at most 32)
+     *
+     * @return the given number of bits as an unsigned integer.
+     */
+    Uint32 readBits(Uint32 bits) {
+        if (bits == 0) {
+            return 0;
+        }
+        while (_count < bits && _pos < _data.size()) {
+            _scratch |= ((Uint64)static_cast<Uint8>(_data[_pos++])) << _count;
+            _count += 8;
+        }
+        if (_count < bits) {
+            _exhausted = true;
+            _scratch = 0;
+            _count = 0;
+            return 0;
+        }
+        Uint64 mask = (((Uint64)1) << bits)-1;
+        Uint32 result = (Uint32)(_scratch & mask);
+        _scratch >>= bits;
+        _count -= bits;
+        return result;
+    }
+
+    /**
+     * Returns a boolean stored as a single bit.
+     *
+     * @return a boolean stored as a single bit.
+     */
+    bool readBool() {
+        return readBits(1) != 0;
+    }
+
+    /**
+     * Returns a float stored at full (32 bit) precision.
+     *
+     * @return a float stored at full (32 bit) precision.
+     */
+    float readFloat() {
+        Uint32 bits = readBits(32);
+        float result;
+        std::memcpy(&result, &bits, sizeof(float));
+        return result;
+    }
+
+    /**
+     * Returns an unsigned variable length integer.
+     *
+     * @return an unsigned variable length integer.
+     */
+    Uint64 readVarint() {
+        Uint64 result = 0;
+        for (Uint32 shift = 0; shift < 64 && !_exhausted; shift += 7) {
+            result |= ((Uint64)readBits(7)) << shift;
+            if (!readBits(1)) {
+                return result;
+            }
+        }
+        _exhausted = true;
+        return 0;
+    }
+
+    /**
+     * Returns a float quantized to the given range.
+     *
+     * @param min   The minimum value of the range
+     * @param max   The maximum value of the range
+     * @param bits  The number of bits used (at most 32)
+     *
+     * @return a float quantized to the given range.
+     */
+    float readQuantized(float min, float max, Uint32 bits) {
+        return dequantize(readBits(bits), min, max, bits);
+    }
+
+    /**
+     * Returns an angle quantized to the given number of bits.
+     *
+     * The angle is in the range [0, 2 pi).
+     *
+     * @param bits  The number of bits used (at most 32)
+     *
+     * @return an angle quantized to the given number of bits.
+     */
+    float readAngle(Uint32 bits) {
+        return dequantizeAngle(readBits(bits), bits);
+    }
+
+    /**
+     * Returns the value for a quantized value read by {@link #readQuantized}.
+     *
+     * @param value The quantized value
+     * @param min   The minimum value of the range
+     * @param max   The maximum value of the range
+     * @param bits  The number of bits used (at most 32)
+     *
+     * @return the value for a quantized value read by {@link #readQuantized}.
+     */
+    static float dequantize(Uint32 value, float min, float max, Uint32 bits) {
+        double steps = (double)((((Uint64)1) << bits)-1);
+        double t = value/steps;
+        return (float)(min+t*(max-min));
+    }
+
+    /**
+     * Returns the angle for a quantized angle read by {@link #readAngle}.
+     *
+     * @param value The quantized angle
+     * @param bits  The number of bits used (at most 32)
+     *
+     * @return the angle for a quantized angle read by {@link #readAngle}.
+     */
+    static float dequantizeAngle(Uint32 value, Uint32 bits) {
+        double steps = (double)(((Uint64)1) << bits);
+        return (float)(value*2*M_PI/steps);
+    }
+
+    /**
+     * Clears the buffer and ignores any remaining data in it.
+     */
+    void reset() {
+        _data.clear();
+        _pos = 0;
+        _scratch = 0;
+        _count = 0;
+        _exhausted = false;
+    }
+};
+
+    }
+}
+
+#endif /* __CU_LW_BIT_SERIALIZER_H__ */
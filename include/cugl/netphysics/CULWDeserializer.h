@@ -34,7 +34,9 @@
 #define __CU_LW_DESERIALIZER_H__
 
 #include <vector>
+#include <memory>
 #include <SDL_stdinc.h>
+#include <cugl/net/CUNetcodeWriter.h>
 
 namespace cugl {
 
@@ -53,6 +55,21 @@ private:
     /** Position in the data of next byte to read */
     size_t _pos;
 
+    /**
+     * Returns the next value of the given type from the loaded byte vector.
+     *
+     * If the value extends past the end of the data, this method returns 0
+     * and the rest of the data is skipped.
+     */
+    template <typename T>
+    T fetch() {
+        T result = 0;
+        net::NetcodeReader reader(_data.data()+_pos, _data.size()-_pos);
+        reader.read(result);
+        _pos += reader.position();
+        return result;
+    }
+
 public:
     /**
      * Constructor LWDeserializer, no initialization required.
@@ -73,6 +90,14 @@ public:
         _data = msg;
         _pos = 0;
     }
+
+    /**
+     * Loads a byte vector into the deserializer, taking ownership of it.
+     */
+    void receive(std::vector<std::byte>&& msg){
+        _data = std::move(msg);
+        _pos = 0;
+    }
     
     /**
      * Reads a boolean from the loaded byte vector.
@@ -100,60 +125,35 @@ public:
      * Reads a float from the loaded byte vector.
      */
     float readFloat(){
-        if (_pos >= _data.size()) {
-            return 0.0f;
-        }
-        const float* r = reinterpret_cast<const float*>(_data.data() + _pos);
-        _pos += sizeof(float);
-        return marshall(*r);
+        return fetch<float>();
     }
     
     /**
      * Reads a Sint32 from the loaded byte vector.
      */
     Sint32 readSint32(){
-        if (_pos >= _data.size()) {
-            return 0;
-        }
-        const Sint32* r = reinterpret_cast<const Sint32*>(_data.data() + _pos);
-        _pos += sizeof(Sint32);
-        return marshall(*r);
+        return fetch<Sint32>();
     }
     
     /**
      * Reads a Uint16 from the loaded byte vector.
      */
     Uint16 readUint16(){
-        if (_pos >= _data.size()) {
-            return 0;
-        }
-        const Uint16* r = reinterpret_cast<const Uint16*>(_data.data() + _pos);
-        _pos += sizeof(Uint16);
-        return marshall(*r);
+        return fetch<Uint16>();
     }
     
     /**
      * Reads a Uint32 from the loaded byte vector.
      */
     Uint32 readUint32(){
-        if (_pos >= _data.size()) {
-            return 0;
-        }
-        const Uint32* r = reinterpret_cast<const Uint32*>(_data.data() + _pos);
-        _pos += sizeof(Uint32);
-        return marshall(*r);
+        return fetch<Uint32>();
     }
     
     /**
      * Reads a Uint64 from the loaded byte vector.
      */
     Uint64 readUint64(){
-        if (_pos >= _data.size()) {
-            return 0;
-        }
-        const Uint64* r = reinterpret_cast<const Uint64*>(_data.data() + _pos);
-        _pos += sizeof(Uint64);
-        return marshall(*r);
+        return fetch<Uint64>();
     }
     
     /**
@@ -37,6 +37,7 @@
 #include <memory>
 #include <SDL_stdinc.h>
 #include <cugl/base/CUEndian.h>
+#include <cugl/net/CUNetcodeWriter.h>
 
 namespace cugl {
 
@@ -101,11 +102,7 @@ public:
     * @param i The byte vector to write
     */
     void rewriteFirstUint32(Uint32 i){
-        Uint32 ii = marshall(i);
-        const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-        for (size_t j = 0; j < sizeof(Uint32); j++) {
-            _data[j] = bytes[j];
-        }
+        net::NetcodeWriter(_data).rewrite<Uint32>(0,i);
     }
     
     /**
@@ -114,11 +111,7 @@ public:
      * @param f The float to write
      */
     void writeFloat(float f){
-        float ii = marshall(f);
-        const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-        for (size_t j = 0; j < sizeof(float); j++) {
-            _data.push_back(bytes[j]);
-        }
+        net::NetcodeWriter(_data).write<float>(f);
     }
     
     /**
@@ -127,11 +120,7 @@ public:
 	 * @param i The Sint32 to write
 	 */
     void writeSint32(Sint32 i){
-        Sint32 ii = marshall(i);
-        const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-        for (size_t j = 0; j < sizeof(Sint32); j++) {
-            _data.push_back(bytes[j]);
-        }
+        net::NetcodeWriter(_data).write<Sint32>(i);
     }
     
     /**
@@ -140,11 +129,7 @@ public:
      * @param i The Uint16 to write
      */
     void writeUint16(Uint16 i){
-        Uint16 ii = marshall(i);
-        const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-        for (size_t j = 0; j < sizeof(Uint16); j++) {
-            _data.push_back(bytes[j]);
-        }
+        net::NetcodeWriter(_data).write<Uint16>(i);
     }
     
     /**
@@ -153,11 +138,7 @@ public:
      * @param i the unsigned Uint32 to write
      */
     void writeUint32(Uint32 i){
-        Uint32 ii = marshall(i);
-        const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-        for (size_t j = 0; j < sizeof(Uint32); j++) {
-            _data.push_back(bytes[j]);
-        }
+        net::NetcodeWriter(_data).write<Uint32>(i);
     }
     
     /**
@@ -166,13 +147,21 @@ public:
 	 * @param i the unsigned Uint64 to write
 	 */
     void writeUint64(Uint64 i){
-        Uint64 ii = marshall(i);
-        const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-        for (size_t j = 0; j < sizeof(Uint64); j++) {
-            _data.push_back(bytes[j]);
-        }
+        net::NetcodeWriter(_data).write<Uint64>(i);
     }
     
+    /**
+     * Reserves space for the given number of additional bytes.
+     *
+     * Calling this ahead of a batch of writes ensures that the input buffer is
+     * allocated at most once for the whole batch.
+     *
+     * @param bytes The number of bytes to be written
+     */
+    void reserve(size_t bytes) {
+        _data.reserve(_data.size()+bytes);
+    }
+
     /** 
      * Returns the serialized data.
      * 
@@ -69,8 +69,12 @@ private:
     Uint64 _eventTimeStamp;
     /** The time when the event was received by the recipient. */
     Uint64 _receiveTimeStamp;
-    /** The ID of the sender. */
-    std::string _sourceID;
+    /** The connection handle of the sender (0 if there is none). */
+    Uint32 _sourceHandle = 0;
+    /** The ID of the sender (shared by all events from that sender). */
+    std::shared_ptr<const std::string> _sourceID;
+    /** The ID of the recipient, or empty if the event is broadcast. */
+    std::string _destID;
 
     //==============================META DATA================================
 
@@ -79,17 +83,25 @@ private:
      * 
      * @param eventTimeStamp    the timestamp of the event from the sender
      * @param receiveTimeStamp  the timestamp when the event was received by the recipient
+     * @param sourceHandle      the connection handle of the sender
      * @param sourceID          the ID of the sender
      */
-    void setMetaData(Uint64 eventTimeStamp, Uint64 receiveTimeStamp, const std::string sourceID) {
+    void setMetaData(Uint64 eventTimeStamp, Uint64 receiveTimeStamp, Uint32 sourceHandle,
+                     const std::shared_ptr<const std::string>& sourceID) {
         _eventTimeStamp = eventTimeStamp;
         _receiveTimeStamp = receiveTimeStamp;
+        _sourceHandle = sourceHandle;
         _sourceID = sourceID;
     }
 
     friend class NetEventController;
 
 public:
+    /**
+     * Deletes this event, releasing all resources.
+     */
+    virtual ~NetEvent() = default;
+    
     /**
      * This method is used by the NetEventController to create a new event of using a
      * reference of the same type.
@@ -118,6 +130,22 @@ public:
      * useful parameters of this class.
      */
     virtual void deserialize(const std::vector<std::byte>& data) { }
+    
+    /**
+     * Resets this event so that it can be reused.
+     *
+     * This method is called when an event is returned to a {@link NetEventPool}.
+     * Pooled subclasses must override this method to clear all of their
+     * fields (and call this method to clear the meta data). Containers should
+     * be cleared rather than reassigned, so that their memory is reused.
+     */
+    virtual void reset() {
+        _eventTimeStamp = 0;
+        _receiveTimeStamp = 0;
+        _sourceHandle = 0;
+        _sourceID = nullptr;
+        _destID.clear();
+    }
 
     /**
      * This method returns the timestamp of the event from the sender.
@@ -139,7 +167,36 @@ public:
 	 * 
 	 * Valid only if the event was received by this client.
 	 */
-    const std::string getSourceId() const { return _sourceID; }
+    const std::string& getSourceId() const {
+        static const std::string empty;
+        return _sourceID ? *_sourceID : empty;
+    }
+
+    /**
+     * This method returns the connection handle of the sender.
+     *
+     * Handles are assigned per connection, and are cheaper to compare than
+     * the sender ID. This is 0 if the event was not received from a peer
+     * connection (e.g. it was replayed from a trace).
+     */
+    Uint32 getSourceHandle() const { return _sourceHandle; }
+
+    /**
+     * This method returns the ID of the recipient.
+     *
+     * If the ID is empty, the event is broadcast to all clients.
+     */
+    const std::string& getDestinationId() const { return _destID; }
+
+    /**
+     * This method sets the ID of the recipient.
+     *
+     * By default, the NetEventController broadcasts every event. If the ID is
+     * not empty, the event is only sent to the client with that ID.
+     *
+     * @param destID    the ID of the recipient, or empty to broadcast
+     */
+    void setDestinationId(const std::string& destID) { _destID = destID; }
 };
     }
 }
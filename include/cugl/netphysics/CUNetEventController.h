@@ -30,13 +30,20 @@
 #define __CU_NET_EVENT_CONTROLLER_H__
 
 #include <unordered_map>
+#include <unordered_set>
 #include <typeindex>
 #include <vector>
 #include <concepts>
 #include <queue>
+#include <deque>
+#include <map>
 #include <memory>
+#include <cmath>
+#include <atomic>
 #include "cu_net_events.h"
+#include <functional>
 #include <cugl/netphysics/CUNetEvent.h>
+#include <cugl/netphysics/CUNetEventPool.h>
 #include <cugl/netphysics/CUNetPhysicsController.h>
 #include <cugl/assets/CUAssetManager.h>
 #include <cugl/base/CUApplication.h>
@@ -44,6 +51,8 @@
 #include <cugl/net/CUNetcodeConnection.h>
 #include <cugl/physics2/CUObstacle.h>
 #include <cugl/physics2/CUObstacleWorld.h>
+#include <cugl/util/CUMPSCQueue.h>
+#include <cugl/util/CUThreadPool.h>
 
 namespace cugl {
 
@@ -76,9 +85,25 @@ namespace cugl {
  * created to handle physics synchronization. For fine-tuning and more info, 
  * check {@link NetPhysicsController}.
  * 
- * There are three built-in event types: {@link GameStateEvent}, 
- * {@link PhysSyncEvent}, and {@link PhysObjEvent}. See the {@link NetEvent}
- * class and {@link attachEventType()} for how to add and setup custom events.
+ * By default, every client simulates the world and sends the state of the
+ * obstacles it owns. In host-authoritative mode (see {@link setAuthoritative()}),
+ * only the host sends physics state. Clients send their input commands to
+ * the host every tick instead (see {@link setInput()}).
+ * 
+ * There are four built-in event types: {@link GameStateEvent}, 
+ * {@link PhysSyncEvent}, {@link PhysObjEvent}, and {@link PhysInputEvent}.
+ * See the {@link NetEvent} class and {@link attachEventType()} for how to add
+ * and setup custom events.
+ * 
+ * By default, a controller is tied to the running {@link Application}. It
+ * uses the application update count as its clock, and network callbacks are
+ * scheduled on the main thread. A detached controller (see {@link allocDetached})
+ * does not use the application at all. Its owner advances the clock with
+ * {@link advanceTick()}, and network callbacks are run in {@link updateNet()}.
+ * So a dedicated server can run many sessions (each a detached controller
+ * with its own {@link physics2::ObstacleWorld}) across a {@link ThreadPool},
+ * as long as each session is only updated by one thread at a time. The
+ * sessions still share the {@link net::NetworkLayer} and its threads.
  */
 class NetEventController {
 public:
@@ -100,10 +125,62 @@ public:
     };
 
 protected:
+    /** A single round trip measurement of the host clock */
+    typedef struct {
+        /** The round trip time in ticks, excluding the host processing time */
+        double rtt;
+        /** The host game tick minus the local game tick */
+        double offset;
+    } ClockSample;
+    
+    /** The measured quality of the link to a single peer */
+    typedef struct {
+        /** The smoothed round trip time in ticks */
+        double rtt;
+        /** The smallest round trip time seen in ticks */
+        double minRtt;
+        /** The smoothed fraction of pings that were not answered */
+        double loss;
+        /** Whether the last ping to this peer was answered */
+        bool answered;
+    } LinkStats;
+    
+    /** A reliable event waiting to be acknowledged by a peer */
+    typedef struct {
+        /** The sequence number of the event */
+        Uint32 sequence;
+        /** The local game tick when the event is next due to be sent */
+        Uint64 due;
+        /** The wrapped event (shared by all recipients) */
+        std::shared_ptr<std::vector<std::byte>> data;
+    } SequencedEntry;
+    
+    /** The sequenced delivery state between this peer and another */
+    typedef struct {
+        /** The sequence number of the last outbound event */
+        Uint32 lastSequence;
+        /** The unacknowledged outbound events, oldest first */
+        std::deque<SequencedEntry> pending;
+        /** The latest inbound sequence number delivered in order */
+        Uint32 received;
+        /** The inbound events received out of order, by sequence number */
+        std::map<Uint32,std::vector<std::byte>> early;
+        /** Whether the peer is owed an acknowledgement */
+        bool ackOwed;
+    } SequencedLink;
+    
     /** The asset manager for the controller. */
     ::std::shared_ptr<AssetManager> _assets;
     /** Reference to the App */
     cugl::Application* _appRef;
+    /** Whether this controller is driven by its owner instead of the App */
+    bool _detached;
+    /** The fixed-time stamp of a detached controller */
+    Uint64 _ticks;
+    /** The time of the last call to advanceTick() for a detached controller */
+    Timestamp _tickTime;
+    /** The network callbacks waiting for a detached controller */
+    std::shared_ptr<MPSCQueue<std::function<bool()>>> _callbacks;
     /** The App fixed-time stamp when the game starts */
     Uint64 _startGameTimeStamp;
 
@@ -111,6 +188,8 @@ protected:
     cugl::net::NetcodeConfig _config;
     /** The network connection */
     std::shared_ptr<net::NetcodeConnection> _network;
+    /** The sender IDs of the connection, indexed by peer handle */
+    std::vector<std::shared_ptr<const std::string>> _peerNames;
 
     /** The network controller status */
     Status _status;
@@ -125,6 +204,40 @@ protected:
     std::unordered_map<std::type_index, Uint8> _eventTypeMap;
     /** Vector of NetEvents instances for constructing new events */
     std::vector<std::shared_ptr<NetEvent>> _newEventVector;
+    /** The pool for each attached event type (empty if the type is not pooled) */
+    std::vector<std::function<std::shared_ptr<NetEvent>()>> _eventPools;
+    /** The handler for each attached event type (empty for the inbound queue) */
+    std::vector<std::function<void(const std::shared_ptr<NetEvent>&)>> _eventHandlers;
+    /** The delivery lane for each attached event type */
+    std::vector<net::NetcodeConnection::Lane> _eventLanes;
+    /** Whether this controller wants each attached event type (by type id) */
+    std::vector<bool> _subscribed;
+    /** The number of built-in event types, which are always delivered */
+    size_t _coreTypes;
+    /** The event types wanted by each peer (by UUID), once it has announced them */
+    std::unordered_map<std::string, std::vector<bool>> _peerSubscriptions;
+    /** The peers (by UUID) that have been sent our current subscriptions */
+    std::unordered_set<std::string> _announced;
+    /** Whether our subscriptions have changed since the controller was created */
+    bool _resubscribe;
+    /** The recipients of a filtered broadcast (reused every update) */
+    std::vector<std::string> _recipients;
+    /** The spectators that receive a broadcast (reused every update) */
+    std::vector<std::string> _audience;
+    /** Whether spectators are sent each attached event type (by type id) */
+    std::vector<bool> _spectated;
+    /** The spectators that have been sent the game start (host only) */
+    std::unordered_set<std::string> _admitted;
+    /** The number of ticks between spectator snapshots */
+    Uint32 _spectatorInterval;
+    /** The number of ticks that spectator snapshots lag behind the game */
+    Uint32 _spectatorDelay;
+    /** The tick of the last spectator snapshot */
+    Uint64 _lastSpectatorTick;
+    /** The spectator snapshot to send this update (or nullptr for none) */
+    std::shared_ptr<PhysSyncEvent> _spectatorSync;
+    /** The pool for the per-tick input events split from a client message (host only) */
+    std::shared_ptr<NetEventPool<PhysInputEvent>> _inputPool;
 
     /** Queue for all received custom events. Preserved across updates.*/
     std::queue<std::shared_ptr<NetEvent>> _inEventQueue;
@@ -132,6 +245,27 @@ protected:
     std::queue<std::shared_ptr<NetEvent>> _reservedInEventQueue;
     /** Queue for all outbound events. Cleared every update */
     std::vector<std::shared_ptr<NetEvent>> _outEventQueue;
+    /** Timestamp of the latest physics sync received from each peer (unreliable lane) */
+    std::unordered_map<std::string, Uint64> _lastSyncStamp;
+    /** Timestamp of the latest group snapshot received from each peer (unreliable lane) */
+    std::unordered_map<std::string, Uint64> _lastGroupStamp;
+    /** Reusable output buffer that every outbound event is wrapped into */
+    std::vector<std::byte> _outArena;
+    /** Reusable input buffer for the payload of every inbound event */
+    std::vector<std::byte> _inArena;
+    /** The number of messages sent in the last update */
+    size_t _frameMsgCount;
+    /** The number of bytes sent in the last update */
+    size_t _frameByteCount;
+    
+    /** Whether the host is the only authority on the physics state */
+    bool _authoritative;
+    /** The input commands for the next tick (client only) */
+    std::vector<std::byte> _input;
+    /** The input commands of the most recent ticks, oldest first (client only) */
+    std::deque<std::vector<std::byte>> _inputHistory;
+    /** The tick of the latest input received from each client (host only) */
+    std::unordered_map<std::string, Uint64> _lastInputTick;
     
     /** Short user id assigned by the host during session */
     Uint32 _shortUID;
@@ -139,6 +273,50 @@ protected:
     bool _physEnabled;
     /** The physics synchronization controller */
     std::shared_ptr<NetPhysicsController> _physController;
+    
+    /** The most recent clock samples, oldest first (client only) */
+    std::deque<ClockSample> _clockSamples;
+    /** The estimated host game tick minus the local game tick */
+    double _clockOffset;
+    /** The smoothed round trip time to the host in ticks */
+    double _roundTrip;
+    /** The smoothed deviation of the round trip time in ticks */
+    double _roundTripVar;
+    /** Whether the clock offset has been estimated at least once */
+    bool _clockSynced;
+    /** The local game tick of the last ping */
+    Uint64 _lastPingTick;
+    /** The number of pings sent since the game started */
+    Uint32 _pingCount;
+    
+    /** The measured quality of the link to each peer (by UUID) */
+    std::unordered_map<std::string, LinkStats> _links;
+    /** Whether the snapshot rate adapts to the measured links */
+    bool _congestionControl;
+    /** The estimated number of bytes per tick the links can carry */
+    double _sendBudget;
+    /** The number of bytes that may be sent before the next snapshot is skipped */
+    double _sendCredit;
+    /** The local game tick of the last physics snapshot */
+    Uint64 _lastSyncTick;
+    
+    /** Whether reliable events are sequenced over the unreliable lane in game */
+    bool _sequenced;
+    /** The sequenced delivery state with each peer (by UUID) */
+    std::unordered_map<std::string, SequencedLink> _seqLinks;
+    /** The pool for sequenced envelopes */
+    std::shared_ptr<NetEventPool<SequencedEvent>> _sequencedPool;
+    
+    /** The inbound events decoded by the worker as (type,event) pairs, in order */
+    MPSCQueue<std::pair<Uint8,std::shared_ptr<NetEvent>>> _decoded;
+    /** The number of message batches not yet decoded by the worker */
+    std::atomic<size_t> _decodePending;
+    /** The payload buffer of the worker (only touched by the worker) */
+    std::vector<std::byte> _decodeArena;
+    /** The worker that decodes inbound messages (nullptr to decode on the main thread) */
+    std::shared_ptr<ThreadPool> _decoder;
+    /** The network trace being replayed offline (nullptr for none) */
+    std::shared_ptr<net::NetcodeReplay> _replay;
 
     /* 
      * =================== Note for clarification ===================
@@ -154,7 +332,39 @@ protected:
      * {@link NetEvent#deserialize()} method. This method is only called on 
      * outbound events.
      */
-    std::shared_ptr<NetEvent> unwrap(const std::vector<std::byte>& data,std::string source);
+    std::shared_ptr<NetEvent> unwrap(const std::vector<std::byte>& data, Uint32 handle,
+                                     const std::shared_ptr<const std::string>& source);
+    
+    /**
+     * Returns the sender ID for the given peer handle.
+     *
+     * The IDs are cached, so that the connection is only consulted the first
+     * time a handle is seen. All events from the same sender share the ID.
+     *
+     * @param handle    The peer handle
+     *
+     * @return the sender ID for the given peer handle.
+     */
+    const std::shared_ptr<const std::string>& getPeerName(Uint32 handle);
+    
+    /**
+     * Decodes a byte vector into a NetEvent without a receive timestamp.
+     *
+     * This is the part of {@link unwrap()} that is safe to run on the decoder
+     * thread, provided that pooled is false. The event pools are not thread
+     * safe, so the decoder thread always allocates its events.
+     *
+     * @param data      The message data
+     * @param handle    The peer handle of the sender
+     * @param source    The UUID of the sender
+     * @param arena     The buffer to copy the payload into
+     * @param pooled    Whether to take the event from its pool (if it has one)
+     *
+     * @return the decoded event.
+     */
+    std::shared_ptr<NetEvent> decode(const std::vector<std::byte>& data, Uint32 handle,
+                                     const std::shared_ptr<const std::string>& source,
+                                     std::vector<std::byte>& arena, bool pooled);
 
     /**
      * Wraps a NetEvent into a byte vector. 
@@ -165,6 +375,59 @@ protected:
      */
     const std::vector<std::byte> wrap(const std::shared_ptr<NetEvent>& e);
     
+    /**
+     * Wraps a NetEvent into the given byte vector.
+     *
+     * This is the same as {@link wrap()}, except that the bytes are written
+     * into the given buffer (which is cleared first). Reusing the buffer
+     * avoids an allocation for every event on the outbound path.
+     */
+    void wrapInto(const std::shared_ptr<NetEvent>& e, std::vector<std::byte>& out);
+    
+    /**
+     * Returns the delivery lane for the given event.
+     *
+     * Physics snapshots ({@link PhysSyncEvent}) are superseded by the next
+     * snapshot, so they are sent on the unreliable lane. So are inputs, which
+     * are repeated, checksums, which are only compared if they arrive, and
+     * clock pings. All other events change the game state, and are sent on
+     * the reliable lane. The lane is looked up by the type id of the event.
+     */
+    net::NetcodeConnection::Lane getLane(const std::shared_ptr<NetEvent>& e);
+    
+    /**
+     * Sets the delivery lane for the events of type T.
+     *
+     * Requires T to be attached.
+     *
+     * @param T     The event type
+     * @param lane  The delivery lane for the events of type T
+     */
+    template <typename T>
+    void setEventLane(net::NetcodeConnection::Lane lane) {
+        auto it = _eventTypeMap.find(std::type_index(typeid(T)));
+        CUAssertLog(it != _eventTypeMap.end(), "Event type is not attached");
+        _eventLanes[it->second] = lane;
+    }
+    
+    /**
+     * Sets a built-in handler for the events of type T.
+     *
+     * Unlike {@link setEventHandler()}, the handler is called in every state
+     * of the controller. It is up to the handler to check the status.
+     *
+     * @param T         The event type
+     * @param handler   The method to handle the events of type T
+     */
+    template <typename T>
+    void setBuiltinHandler(void (NetEventController::*handler)(const std::shared_ptr<T>&)) {
+        auto it = _eventTypeMap.find(std::type_index(typeid(T)));
+        CUAssertLog(it != _eventTypeMap.end(), "Event type is not attached");
+        _eventHandlers[it->second] = [this,handler](const std::shared_ptr<NetEvent>& e) {
+            (this->*handler)(std::static_pointer_cast<T>(e));
+        };
+    }
+    
     /**
      * Processes all received packets received during the last update.
      * 
@@ -172,14 +435,35 @@ protected:
      * {@link processReceivedEvent()}.
      */
     void processReceivedData();
+    
+    /**
+     * Processes all events decoded by the decoder thread so far.
+     *
+     * The events are stamped with the current server tick as they are
+     * processed, and then passed to {@link processReceivedEvent()} in the
+     * order they arrived.
+     */
+    void processDecodedEvents();
+    
+    /**
+     * Blocks until the decoder thread has decoded every message given to it.
+     *
+     * This must be called before the event type tables are changed, as the
+     * decoder thread reads them.
+     */
+    void drainDecoder();
 
     /**
-     * Processes all events received during the last update.
+     * Processes an event received during the last update.
      *
-     * This method either processes events internally if it is a built-in event
-     * and adds them to the inbound event queue otherwise.
+     * The event is passed to the handler for its type id, if there is one.
+     * This includes all of the built-in events. Otherwise, the event is added
+     * to the inbound event queue if the game is in progress.
+     *
+     * @param type  The type id of the event
+     * @param e     The received event
      */
-    void processReceivedEvent(const std::shared_ptr<NetEvent>& e);
+    void processReceivedEvent(Uint8 type, const std::shared_ptr<NetEvent>& e);
 
     /**
      * Processes a GameStateEvent.
@@ -193,11 +477,240 @@ protected:
      */
     bool checkConnection();
     
+    /**
+     * Processes an input event from a client.
+     *
+     * Input events repeat the inputs of the last few ticks. This method splits
+     * the event into one event for every tick not yet received, and adds them
+     * to the inbound event queue.
+     */
+    void processPhysInputEvent(const std::shared_ptr<PhysInputEvent>& e);
+    
+    /**
+     * Processes a physics snapshot from a peer.
+     *
+     * Snapshots arrive unordered, so any snapshot older than the latest one
+     * from the same peer is dropped.
+     */
+    void processPhysSyncEvent(const std::shared_ptr<PhysSyncEvent>& e);
+    
+    /**
+     * Processes an obstacle event from a peer.
+     */
+    void processPhysObjEvent(const std::shared_ptr<PhysObjEvent>& e);
+    
+    /**
+     * Processes a batch of obstacle changes from a peer.
+     */
+    void processPhysDeltaEvent(const std::shared_ptr<PhysDeltaEvent>& e);
+    
+    /**
+     * Processes a checksum event from a peer.
+     */
+    void processPhysChecksumEvent(const std::shared_ptr<PhysChecksumEvent>& e);
+    
+    /**
+     * Processes an ownership checkpoint from the host.
+     */
+    void processPhysCheckpointEvent(const std::shared_ptr<PhysCheckpointEvent>& e);
+    
+    /**
+     * Processes a chunk of a late-join world transfer from the host.
+     */
+    void processPhysWorldEvent(const std::shared_ptr<PhysWorldEvent>& e);
+    
+    /**
+     * Processes a change to a shared joint from a peer.
+     */
+    void processPhysJointEvent(const std::shared_ptr<PhysJointEvent>& e);
+    
+    /**
+     * Processes a snapshot of groups of jointed obstacles from a peer.
+     *
+     * Snapshots arrive unordered, so any snapshot older than the latest one
+     * from the same peer is dropped.
+     */
+    void processPhysGroupEvent(const std::shared_ptr<PhysGroupEvent>& e);
+    
+    /**
+     * Takes over as host after this client was promoted in a host migration.
+     *
+     * The clock offset is kept, so the server tick carries on from the old
+     * host. The physics controller takes over the obstacles of the old host
+     * from its last checkpoint (see {@link NetPhysicsController#promote}).
+     */
+    void promoteToHost();
+    
+    /**
+     * Processes an envelope of sequenced events from a peer.
+     *
+     * The acknowledgements in the envelope stop the resending of our events.
+     * The events in the envelope are buffered, and delivered (unwrapped and
+     * processed) strictly in sequence order. Duplicates are ignored.
+     */
+    void processSequencedEvent(const std::shared_ptr<SequencedEvent>& e);
+    
+    /**
+     * Queues a wrapped reliable event for sequenced delivery.
+     *
+     * If the event is for all peers, it is only queued for the peers that
+     * subscribe to its type.
+     *
+     * @param dest  The UUID of the recipient (empty for all peers)
+     * @param type  The type id of the event
+     * @param data  The wrapped event
+     */
+    void queueSequenced(const std::string& dest, Uint8 type, const std::vector<std::byte>& data);
+    
+    /**
+     * Sends an envelope to every peer that is due one.
+     *
+     * An envelope holds the events never sent or not acknowledged within the
+     * resend interval (about one and a half round trips), up to a byte limit.
+     * A peer that sent us events gets an envelope even if there is nothing to
+     * send, so that it can stop resending.
+     */
+    void sendSequenced();
+
+    /**
+     * Processes the event subscriptions of a peer.
+     *
+     * From now on, events with a type the peer does not want are no longer
+     * sent to it.
+     */
+    void processSubscriptionEvent(const std::shared_ptr<SubscriptionEvent>& e);
+
+    /**
+     * Sends our event subscriptions to every peer that does not have them.
+     *
+     * Nothing is sent until the subscriptions have changed at least once,
+     * since peers assume that every type is wanted.
+     */
+    void sendSubscriptions();
+
+    /**
+     * Sets whether this controller wants the events with the given type id.
+     *
+     * The built-in event types are always wanted.
+     *
+     * @param type  The type id
+     * @param value Whether this controller wants the events with that type id
+     */
+    void subscribe(Uint8 type, bool value);
+
+    /**
+     * Returns true if the given peer wants the events with the given type id.
+     *
+     * A peer wants every event type until it announces its subscriptions.
+     *
+     * @param peer  The UUID of the peer
+     * @param type  The type id
+     *
+     * @return true if the given peer wants the events with the given type id.
+     */
+    bool isPeerSubscribed(const std::string& peer, Uint8 type) const;
+
+    /**
+     * Starts the game for every spectator that has not seen it start.
+     *
+     * A spectator does not take part in the start handshake. Instead, the
+     * host sends it the game start once the game is in progress, followed by
+     * the world (if physics is enabled).
+     */
+    void admitSpectators();
+
+    /**
+     * Sends the spectator snapshot of this update to every spectator.
+     *
+     * The snapshot is serialized once, and the same message is shared by the
+     * connections to all of the spectators.
+     */
+    void sendSpectatorSync();
+
+    /**
+     * Returns true if received events with the given type id are dropped.
+     *
+     * These are the types this controller has unsubscribed from. They are
+     * dropped before they are decoded, in case a peer sends them before it
+     * learns our subscriptions.
+     *
+     * @param type  The type id
+     *
+     * @return true if received events with the given type id are dropped.
+     */
+    bool isDropped(Uint8 type) const {
+        return type < _subscribed.size() && !_subscribed[type];
+    }
+    
+    /**
+     * Sends the input commands of this tick to the host.
+     *
+     * This method is only used by clients in host-authoritative mode. Inputs
+     * are sent every tick, even if they are empty, as they carry the
+     * acknowledgements for the host snapshots.
+     */
+    void sendInput();
+    
     /**
      * Broadcasts all queued outbound events.
+     *
+     * Events with a destination are only sent to that client.
      */
     void sendQueuedOutData();
     
+    /**
+     * Processes a clock synchronization event.
+     *
+     * Every peer answers pings with a pong, and records the round trip of
+     * every pong for its link statistics. Clients also turn a pong from the
+     * host into a clock sample, and update the clock offset and round trip
+     * estimates.
+     */
+    void processClockSyncEvent(const std::shared_ptr<ClockSyncEvent>& e);
+    
+    /**
+     * Sends a clock synchronization ping if one is due.
+     *
+     * Clients ping the host, and the host pings every client. The first few
+     * pings are sent in quick succession so that the clock is synchronized soon
+     * after the game starts. After that, pings are only sent every so often to
+     * follow the clock drift and latency changes.
+     *
+     * The steady pings are also how the links are measured. A ping that has not
+     * been answered by the time the next one is due counts as lost, and the send
+     * budget is updated before every such ping.
+     */
+    void sendClockPing();
+    
+    /**
+     * Resets the clock synchronization estimates.
+     */
+    void resetClock();
+    
+    /**
+     * Records a round trip to the given peer.
+     *
+     * @param source    The UUID of the peer
+     * @param rtt       The round trip time in ticks
+     * @param origin    The local game tick of the answered ping
+     */
+    void recordRoundTrip(const std::string& source, double rtt, Uint64 origin);
+    
+    /**
+     * Adjusts the send budget to the measured quality of the links.
+     *
+     * The budget is adjusted AIMD style, as in TCP. If the worst link loses
+     * pings, or its round trip time has grown well beyond its minimum (so the
+     * packets are queueing up somewhere), the budget is halved. Otherwise, it
+     * grows by a fixed amount.
+     */
+    void updateCongestion();
+    
+    /**
+     * Resets the send budget and the link measurements.
+     */
+    void resetCongestion();
+    
     /**
      * Returns the discrete timestamp since the game started. 
      * 
@@ -206,8 +719,214 @@ protected:
      * latency. 
      */
     Uint64 getGameTick() const {
-        return _appRef->getUpdateCount() - _startGameTimeStamp;
+        return getUpdateCount() - _startGameTimeStamp;
+    }
+
+    /**
+     * Returns the number of fixed updates so far.
+     *
+     * This is the update count of the application, unless this controller
+     * is detached.
+     */
+    Uint64 getUpdateCount() const {
+        return _detached ? _ticks : _appRef->getUpdateCount();
+    }
+
+    /**
+     * Routes the callbacks of the network connection to this controller.
+     *
+     * A detached controller queues the callbacks, to be run in updateNet().
+     * Otherwise the connection schedules them with the application.
+     */
+    void attachScheduler();
+
+    /**
+     * Runs the network callbacks waiting for a detached controller.
+     */
+    void processCallbacks();
+
+public:
+    /**
+     * Returns the estimated game tick of the host.
+     *
+     * Every peer starts counting game ticks when it learns that the game has
+     * started, so the raw game ticks of two peers differ by about the latency
+     * of the start message. This value is the local game tick corrected by
+     * the clock offset (see {@link getClockOffset()}), and is the time base
+     * for the timestamps of all events. Hence timestamps from different peers
+     * are directly comparable.
+     *
+     * On the host, and on clients before the first pong, this is the same as
+     * the local game tick.
+     *
+     * @return the estimated game tick of the host.
+     */
+    Uint64 getServerTick() const {
+        Sint64 tick = (Sint64)getGameTick()+(Sint64)std::llround(_clockOffset);
+        return tick < 0 ? 0 : (Uint64)tick;
     }
+    
+    /**
+     * Returns the estimated offset of the host game tick to the local one.
+     *
+     * The offset is estimated NTP style from pings to the host, taking the
+     * sample with the smallest round trip time in a sliding window. Small
+     * corrections are applied gradually, so that the server tick does not
+     * jump around with network jitter.
+     *
+     * @return the estimated offset of the host game tick to the local one.
+     */
+    double getClockOffset() const { return _clockOffset; }
+
+    /**
+     * Returns the estimated (fractional) game tick of the host at the given time.
+     *
+     * This method maps a timestamp, such as that of a {@link KeyEvent},
+     * {@link MouseEvent} or {@link TouchEvent}, onto the same clock as
+     * {@link getServerTick()}. The fractional part is how far into the
+     * tick the event happened. Clients can use this to tag their input
+     * commands (see {@link setInput()}) with the exact moment of the input,
+     * so that the host can compensate for lag.
+     *
+     * A detached controller assumes that {@link advanceTick()} is called
+     * once every FIXED_TIMESTEP, starting at the time of the call.
+     *
+     * @param stamp The time to convert
+     *
+     * @return the estimated (fractional) game tick of the host at the given time.
+     */
+    double getServerTickAt(const Timestamp& stamp) const;
+    
+    /**
+     * Returns the smoothed round trip time to the host in ticks.
+     *
+     * This value is 0 on the host, and on clients before the first pong.
+     *
+     * @return the smoothed round trip time to the host in ticks.
+     */
+    double getRoundTripTime() const { return _roundTrip; }
+    
+    /**
+     * Returns the smoothed deviation of the round trip time in ticks.
+     *
+     * This is a measure of the network jitter to the host.
+     *
+     * @return the smoothed deviation of the round trip time in ticks.
+     */
+    double getRoundTripJitter() const { return _roundTripVar; }
+    
+    /**
+     * Returns true if the clock has been synchronized with the host.
+     *
+     * The host is always synchronized with itself once the game starts.
+     *
+     * @return true if the clock has been synchronized with the host.
+     */
+    bool isClockSynced() const { return _clockSynced; }
+    
+    /**
+     * Returns the estimated number of bytes per tick the network can carry.
+     *
+     * The estimate is based on the round trip time and ping loss of every
+     * peer (see {@link updateCongestion}). With congestion control, physics
+     * snapshots are only sent while the bytes sent stay within this budget.
+     * This lowers the snapshot rate on a poor link instead of queueing
+     * packets and increasing the latency.
+     *
+     * @return the estimated number of bytes per tick the network can carry.
+     */
+    double getSendBudget() const { return _sendBudget; }
+    
+    /**
+     * Returns the smoothed ping loss of the worst link.
+     *
+     * @return the smoothed ping loss of the worst link.
+     */
+    double getPacketLoss() const;
+    
+    /**
+     * Returns true if the snapshot rate adapts to the network.
+     *
+     * Congestion control is enabled by default. See {@link getSendBudget}.
+     *
+     * @return true if the snapshot rate adapts to the network.
+     */
+    bool isCongestionControlled() const { return _congestionControl; }
+    
+    /**
+     * Sets whether the snapshot rate adapts to the network.
+     *
+     * With congestion control, physics snapshots are only sent while the bytes
+     * sent stay within the send budget, and the byte budget of PRIO_SYNC is
+     * set to the send budget. Without it, a snapshot is sent every tick.
+     *
+     * @param value Whether the snapshot rate adapts to the network
+     */
+    void setCongestionControl(bool value) { _congestionControl = value; }
+    
+    /**
+     * Returns true if inbound messages are decoded off the main thread.
+     *
+     * See {@link setAsyncDecoding}.
+     *
+     * @return true if inbound messages are decoded off the main thread.
+     */
+    bool isAsyncDecoding() const { return _decoder != nullptr; }
+    
+    /**
+     * Sets whether inbound messages are decoded off the main thread.
+     *
+     * By default, every message is deserialized on the main thread in
+     * {@link updateNet()}. With asynchronous decoding, each update hands the
+     * raw messages to a worker thread, and only applies the events that the
+     * worker has finished decoding. Hence the main thread no longer pays for
+     * the deserialization, but received events are applied one update later.
+     *
+     * The decoded events are not pooled, as the event pools are not thread
+     * safe. This is off by default.
+     *
+     * @param value Whether inbound messages are decoded off the main thread
+     */
+    void setAsyncDecoding(bool value);
+    
+    /**
+     * Returns true if reliable events are sequenced over the unreliable lane.
+     *
+     * See {@link setSequencedDelivery}.
+     *
+     * @return true if reliable events are sequenced over the unreliable lane.
+     */
+    bool isSequencedDelivery() const { return _sequenced; }
+    
+    /**
+     * Sets whether reliable events are sequenced over the unreliable lane.
+     *
+     * By default, reliable events (such as obstacle creation and deletion) are
+     * sent on the reliable lane. A lost message there blocks every later one
+     * until it is resent. With sequenced delivery, reliable events are instead
+     * sent over the unreliable lane during the game, bundled with the snapshots
+     * of the same update. Each event has a sequence number, and is resent until
+     * it is acknowledged. The acknowledgements ride along with the events going
+     * the other way. Events are still delivered exactly once and in order, but
+     * a loss only delays the reliable events, and never the snapshots.
+     *
+     * This must be set the same way on every peer. It is off by default.
+     *
+     * @param value Whether reliable events are sequenced over the unreliable lane
+     */
+    void setSequencedDelivery(bool value) { _sequenced = value; }
+    
+    /**
+     * Returns the number of sequenced events not yet acknowledged.
+     *
+     * This is the total over all peers. A steadily growing backlog means a
+     * peer has stopped acknowledging.
+     *
+     * @return the number of sequenced events not yet acknowledged.
+     */
+    size_t getSequencedBacklog() const;
+
+protected:
 
     /**
      * Returns the type id of a NetEvent.
@@ -231,6 +950,8 @@ public:
      */
     NetEventController(void):
         _appRef{ nullptr },
+        _detached{ false },
+        _ticks{ 0 },
         _status{ Status::IDLE },
         _isHost{ false },
         _startGameTimeStamp{ 0 },
@@ -240,7 +961,29 @@ public:
         _assets{ nullptr },
         _network{ nullptr },
         _physController { nullptr },
-        _physEnabled{ false }
+        _physEnabled{ false },
+        _frameMsgCount{ 0 },
+        _frameByteCount{ 0 },
+        _authoritative{ false },
+        _clockOffset{ 0 },
+        _roundTrip{ 0 },
+        _roundTripVar{ 0 },
+        _clockSynced{ false },
+        _lastPingTick{ 0 },
+        _pingCount{ 0 },
+        _congestionControl{ true },
+        _sendBudget{ 0 },
+        _sendCredit{ 0 },
+        _lastSyncTick{ 0 },
+        _sequenced{ false },
+        _coreTypes{ 0 },
+        _resubscribe{ false },
+        _spectatorInterval{ 0 },
+        _spectatorDelay{ 0 },
+        _lastSpectatorTick{ 0 },
+        _decoded{ 0, OverflowPolicy::GROW },
+        _decodePending{ 0 },
+        _decoder{ nullptr }
     {};
     
     /**
@@ -283,6 +1026,50 @@ public:
 		return (result->init(assets) ? result : nullptr);
 	}
 
+    /**
+     * Initializes a detached controller with the given asset manager.
+     *
+     * A detached controller does not use the {@link Application}. Its clock
+     * only advances with {@link advanceTick()}, and its network callbacks are
+     * run at the start of {@link updateNet()}, on whichever thread calls it.
+     * So many detached controllers can run in the same process, each on a
+     * thread of its own (or a task of a {@link ThreadPool}).
+     *
+     * The asset manager has the same requirements as {@link init}.
+     */
+    bool initDetached(const std::shared_ptr<AssetManager>& assets);
+
+    /**
+     * Allocates and initializes a new detached NetEventController instance.
+     *
+     * See {@link initDetached}. Returns nullptr if initialization failed.
+     */
+    static std::shared_ptr<NetEventController> allocDetached(const std::shared_ptr<AssetManager>& assets) {
+		std::shared_ptr<NetEventController> result = std::make_shared<NetEventController>();
+		return (result->initDetached(assets) ? result : nullptr);
+	}
+
+    /**
+     * Returns true if this controller is detached from the application.
+     *
+     * See {@link initDetached}.
+     */
+    bool isDetached() const { return _detached; }
+
+    /**
+     * Advances the clock of a detached controller by one fixed update.
+     *
+     * This should be called once per fixed time step, where an attached
+     * controller would rely on {@link Application#getUpdateCount}. This
+     * method does nothing if the controller is not detached.
+     */
+    void advanceTick() {
+        if (_detached) {
+            _ticks++;
+            _tickTime.mark();
+        }
+    }
+
     /**
      * Connect to a new lobby as host. 
      *
@@ -298,6 +1085,21 @@ public:
      */
     bool connectAsClient(std::string roomID);
 
+    /**
+     * Connect to an existing lobby as a spectator.
+     *
+     * A spectator only connects to the host (or its relay), and cannot send
+     * gameplay events. It does not take part in the start handshake, and it
+     * is not assigned a UID. Once the game is in progress, the host starts it
+     * and sends it the world. From then on it receives a delayed physics
+     * snapshot every few ticks (see {@link setSpectatorInterval} and
+     * {@link setSpectatorDelay}), along with the events marked with
+     * {@link setSpectated}.
+     *
+     * If successful, the controller status changes to CONNECTED.
+     */
+    bool connectAsSpectator(std::string roomID);
+
     /**
      * Disconnect from the current lobby.
      */
@@ -323,19 +1125,50 @@ public:
      * The linkSceneToObsFunc should be a function that links a scene node to 
      * an obstacle with a listener and adds the scene node to a scene graph,
      * typically the addObstacle method in GameScene or analogous class.
+     * If the world accumulates fixed steps (see {@link ObstacleWorld#setAccumulating}),
+     * the listener should position the node with {@link Obstacle#getRenderPosition}
+     * and {@link Obstacle#getRenderAngle} so that it moves smoothly between steps.
      * 
      * @param world The physics world to be synchronized.
      * @param linkSceneToObsFunc Function that links a scene node to an obstacle.
      * 
      */
     void enablePhysics(std::shared_ptr<physics2::ObstacleWorld>& world, std::function<void(const std::shared_ptr<physics2::Obstacle>&,const std::shared_ptr<scene2::SceneNode>&)> linkSceneToObsFunc) {
-        CUAssertLog(_shortUID, "You must receive a UID assigned from host before enabling physics.");
+        CUAssertLog(_shortUID || isSpectator(), "You must receive a UID assigned from host before enabling physics.");
         _physEnabled = true;
         _physController = NetPhysicsController::alloc();
         _physController->init(world,_shortUID,_isHost,linkSceneToObsFunc);
         CULog("ENABLED PHYSICS");
-        attachEventType<PhysSyncEvent>();
-        attachEventType<PhysObjEvent>();
+        _inputPool = NetEventPool<PhysInputEvent>::alloc();
+        attachEventType<PhysSyncEvent>(NetEventPool<PhysSyncEvent>::alloc());
+        attachEventType<PhysObjEvent>(NetEventPool<PhysObjEvent>::alloc());
+        attachEventType<PhysInputEvent>(NetEventPool<PhysInputEvent>::alloc());
+        attachEventType<PhysChecksumEvent>(NetEventPool<PhysChecksumEvent>::alloc());
+        attachEventType<PhysDeltaEvent>(NetEventPool<PhysDeltaEvent>::alloc());
+        attachEventType<PhysCheckpointEvent>(NetEventPool<PhysCheckpointEvent>::alloc());
+        attachEventType<PhysWorldEvent>(NetEventPool<PhysWorldEvent>::alloc());
+        attachEventType<PhysJointEvent>(NetEventPool<PhysJointEvent>::alloc());
+        attachEventType<PhysGroupEvent>(NetEventPool<PhysGroupEvent>::alloc());
+        setBuiltinHandler<PhysSyncEvent>(&NetEventController::processPhysSyncEvent);
+        setBuiltinHandler<PhysObjEvent>(&NetEventController::processPhysObjEvent);
+        setBuiltinHandler<PhysInputEvent>(&NetEventController::processPhysInputEvent);
+        setBuiltinHandler<PhysChecksumEvent>(&NetEventController::processPhysChecksumEvent);
+        setBuiltinHandler<PhysDeltaEvent>(&NetEventController::processPhysDeltaEvent);
+        setBuiltinHandler<PhysCheckpointEvent>(&NetEventController::processPhysCheckpointEvent);
+        setBuiltinHandler<PhysWorldEvent>(&NetEventController::processPhysWorldEvent);
+        setBuiltinHandler<PhysJointEvent>(&NetEventController::processPhysJointEvent);
+        // Spectators need the live world, and get the states as snapshots
+        setSpectated<PhysObjEvent>(true);
+        setSpectated<PhysDeltaEvent>(true);
+        setSpectated<PhysJointEvent>(true);
+        setSpectated<PhysWorldEvent>(true);
+        setBuiltinHandler<PhysGroupEvent>(&NetEventController::processPhysGroupEvent);
+        setEventLane<PhysSyncEvent>(net::NetcodeConnection::Lane::UNRELIABLE);
+        setEventLane<PhysInputEvent>(net::NetcodeConnection::Lane::UNRELIABLE);
+        setEventLane<PhysChecksumEvent>(net::NetcodeConnection::Lane::UNRELIABLE);
+        setEventLane<PhysCheckpointEvent>(net::NetcodeConnection::Lane::UNRELIABLE);
+        setEventLane<PhysWorldEvent>(net::NetcodeConnection::Lane::BULK);
+        setEventLane<PhysGroupEvent>(net::NetcodeConnection::Lane::UNRELIABLE);
         if(_isHost)
             _physController->ownAll();
 	}
@@ -348,6 +1181,45 @@ public:
         _physController = nullptr;
 	}
 
+    /**
+     * Returns true if the host is the only authority on the physics state.
+     *
+     * See {@link setAuthoritative()} for more information.
+     */
+    bool isAuthoritative() const { return _authoritative; }
+    
+    /**
+     * Sets whether the host is the only authority on the physics state.
+     *
+     * In host-authoritative mode, only the host sends physics snapshots and
+     * obstacle changes. Physics events from clients are ignored. Instead,
+     * clients send their input commands (see {@link setInput()}) to the host
+     * every tick. These arrive at the host as {@link PhysInputEvent} events
+     * in the inbound event queue, and the game should apply them to the host
+     * simulation.
+     *
+     * Clients may still step their world locally for prediction (see
+     * {@link NetPhysicsController#addPredicted}), but they should not add
+     * shared obstacles or acquire ownership. In that case, {@link updateNet()}
+     * should be called after the world is stepped each tick. Every client must
+     * use the same mode, and the mode should be set before the game starts.
+     *
+     * @param value Whether the host is the only authority on the physics state
+     */
+    void setAuthoritative(bool value) { _authoritative = value; }
+    
+    /**
+     * Sets the input commands for the current tick.
+     *
+     * The format of the input is up to the game. It is sent to the host at the
+     * next call to {@link updateNet()}, and is then cleared. This method has no
+     * effect unless this client is in host-authoritative mode and is not the
+     * host.
+     *
+     * @param input The input commands for the current tick
+     */
+    void setInput(const std::vector<std::byte>& input) { _input = input; }
+    
     /**
      * Returns the physics synchronization controller.
      * 
@@ -377,6 +1249,25 @@ public:
         return 1;
     }
 
+    /**
+     * Returns true if this device is a spectator. Only valid after connection.
+     */
+    bool isSpectator() const {
+        return _network != nullptr && _network->isSpectator();
+    }
+
+    /**
+     * Returns the number of spectators in lobby. Only valid after connection.
+     *
+     * Spectators are included in {@link getNumPlayers}.
+     */
+    int getNumSpectators() const {
+        if (_network) {
+            return (int)(_network->getNumSpectators());
+        }
+        return 0;
+    }
+
     /**
      * Returns the current status of the controller.
      */
@@ -391,6 +1282,16 @@ public:
      */
     Uint32 getShortUID() const { return _shortUID; }
     
+    /**
+     * Returns the number of messages sent during the last update.
+     */
+    size_t getFrameMessageCount() const { return _frameMsgCount; }
+    
+    /**
+     * Returns the number of bytes sent during the last update.
+     */
+    size_t getFrameByteCount() const { return _frameByteCount; }
+    
     /**
      * Starts handshake process for starting game. 
      
@@ -409,9 +1310,48 @@ public:
 
     /**
      * Updates the network controller.
+     *
+     * A detached controller runs its pending network callbacks first.
      */
     void updateNet();
 
+    /**
+     * Starts an offline replay of the given network trace.
+     *
+     * A trace is recorded by attaching a {@link net::NetcodeRecorder} to the
+     * connection of a live session. This method puts the controller in the
+     * INGAME state, as the host or as a client, without any connection. The
+     * inbound messages of the trace are then applied by {@link replay}.
+     *
+     * The controller must not be connected. Any event types and physics
+     * settings must be the same as those of the recorded session.
+     *
+     * @param trace The network trace
+     * @param host  Whether the trace was recorded by the host
+     *
+     * @return true if the replay was started
+     */
+    bool startReplay(const std::shared_ptr<net::NetcodeReplay>& trace, bool host);
+
+    /**
+     * Applies the inbound messages of the replay trace up to the given time.
+     *
+     * Every inbound message recorded up to the given time (in microseconds
+     * since the trace started) is unwrapped and processed as if it had just
+     * been received. Outbound messages are skipped. Messages are always decoded
+     * on the calling thread, even with asynchronous decoding, so a replay is
+     * deterministic. Calling this method with the largest Uint64 applies the
+     * rest of the trace at once, which is useful for timing decode and apply.
+     *
+     * Nothing is sent during a replay, as there is no connection. Built-in
+     * events that need a connection (such as ownership checkpoints) are ignored.
+     *
+     * @param until The time to replay up to
+     *
+     * @return the number of messages applied
+     */
+    size_t replay(Uint64 until);
+
     /**
      * Attaches a new NetEvent type to the controller. 
      
@@ -422,10 +1362,193 @@ public:
     template <typename T>
     void attachEventType() {
         if (!_eventTypeMap.count(std::type_index(typeid(T)))) {
+            drainDecoder();
             _eventTypeMap.insert(std::make_pair(std::type_index(typeid(T)), _newEventVector.size()));
             _newEventVector.push_back(std::make_shared<T>());
+            _eventPools.push_back(nullptr);
+            _eventHandlers.push_back(nullptr);
+            _eventLanes.push_back(net::NetcodeConnection::Lane::RELIABLE);
+            _subscribed.push_back(true);
+            _spectated.push_back(false);
         }
     }
+    
+    /**
+     * Attaches a new NetEvent type to the controller, using the given pool.
+     *
+     * This is the same as {@link attachEventType()}, except that received
+     * events of this type are taken from the pool instead of being allocated.
+     * T must override {@link NetEvent#reset} to clear all of its fields. The
+     * type must be attached in the same order on every client, whether it is
+     * pooled or not.
+     *
+     * @param T     The event type to be attached, must be a subclass of NetEvent.
+     * @param pool  The pool for received events of this type
+     */
+    template <typename T>
+    void attachEventType(const std::shared_ptr<NetEventPool<T>>& pool) {
+        if (!_eventTypeMap.count(std::type_index(typeid(T)))) {
+            drainDecoder();
+            _eventTypeMap.insert(std::make_pair(std::type_index(typeid(T)), _newEventVector.size()));
+            _newEventVector.push_back(std::make_shared<T>());
+            _eventPools.push_back([pool]() -> std::shared_ptr<NetEvent> { return pool->get(); });
+            _eventHandlers.push_back(nullptr);
+            _eventLanes.push_back(net::NetcodeConnection::Lane::RELIABLE);
+            _subscribed.push_back(true);
+            _spectated.push_back(false);
+        }
+    }
+    
+    /**
+     * Sets the handler for the events of type T.
+     *
+     * By default, received custom events are added to the inbound event
+     * queue (see {@link popInEvent()}). If a handler is set, received events of
+     * type T are instead passed to the handler as soon as they are unwrapped,
+     * skipping the queue. As with the queue, the handler is only called while
+     * the game is in progress. Setting a nullptr handler restores the queue.
+     *
+     * Handlers are looked up by type id, and the event is passed already cast
+     * to type T. Requires T to be attached. This method should not be used
+     * for the built-in events.
+     *
+     * @param T         The event type, must be a subclass of NetEvent.
+     * @param handler   The handler for the events of type T
+     */
+    template <typename T>
+    void setEventHandler(const std::function<void(const std::shared_ptr<T>&)>& handler) {
+        auto it = _eventTypeMap.find(std::type_index(typeid(T)));
+        CUAssertLog(it != _eventTypeMap.end(), "Event type is not attached");
+        if (handler == nullptr) {
+            _eventHandlers[it->second] = nullptr;
+            return;
+        }
+        _eventHandlers[it->second] = [this,handler](const std::shared_ptr<NetEvent>& e) {
+            if (_status == INGAME) {
+                handler(std::static_pointer_cast<T>(e));
+            }
+        };
+    }
+
+    /**
+     * Sets whether this controller wants the events of type T.
+     *
+     * By default, every attached event type is sent to every peer. If this
+     * controller unsubscribes from a type, the other peers are told, and they
+     * stop sending events of that type to this controller. They do not even
+     * serialize an event that no peer wants. This is useful for spectators
+     * and other clients that would only drop high-rate events, such as the
+     * physics events. Events of that type are also dropped (before they are
+     * decoded) if they arrive anyway.
+     *
+     * Requires T to be attached. The built-in events (game state, clock
+     * synchronization, sequenced envelopes and subscriptions) are always
+     * wanted.
+     *
+     * @param T     The event type, must be a subclass of NetEvent.
+     * @param value Whether this controller wants the events of type T
+     */
+    template <typename T>
+    void setSubscribed(bool value) {
+        auto it = _eventTypeMap.find(std::type_index(typeid(T)));
+        CUAssertLog(it != _eventTypeMap.end(), "Event type is not attached");
+        subscribe(it->second,value);
+    }
+
+    /**
+     * Returns true if this controller wants the events of type T.
+     *
+     * Requires T to be attached.
+     *
+     * @param T     The event type, must be a subclass of NetEvent.
+     *
+     * @return true if this controller wants the events of type T.
+     */
+    template <typename T>
+    bool isSubscribed() const {
+        auto it = _eventTypeMap.find(std::type_index(typeid(T)));
+        CUAssertLog(it != _eventTypeMap.end(), "Event type is not attached");
+        return _subscribed[it->second];
+    }
+
+    /**
+     * Sets whether the events of type T are sent to spectators.
+     *
+     * Spectators are only sent the broadcasts of the types they watch (and
+     * the built-in events). By default, no custom type is watched. Enabling
+     * physics marks the obstacle, delta, joint and world events, since a
+     * spectator needs them to build its copy of the world. The states of the
+     * obstacles are not sent live, but as delayed snapshots.
+     *
+     * This only matters on the host. Requires T to be attached.
+     *
+     * @param T     The event type, must be a subclass of NetEvent.
+     * @param value Whether the events of type T are sent to spectators
+     */
+    template <typename T>
+    void setSpectated(bool value) {
+        auto it = _eventTypeMap.find(std::type_index(typeid(T)));
+        CUAssertLog(it != _eventTypeMap.end(), "Event type is not attached");
+        _spectated[it->second] = value;
+    }
+
+    /**
+     * Returns true if the events of type T are sent to spectators.
+     *
+     * Requires T to be attached.
+     *
+     * @param T     The event type, must be a subclass of NetEvent.
+     *
+     * @return true if the events of type T are sent to spectators.
+     */
+    template <typename T>
+    bool isSpectated() const {
+        auto it = _eventTypeMap.find(std::type_index(typeid(T)));
+        CUAssertLog(it != _eventTypeMap.end(), "Event type is not attached");
+        return _spectated[it->second];
+    }
+
+    /**
+     * Returns the number of ticks between spectator snapshots.
+     *
+     * Spectators are sent a physics snapshot at this lower rate, and show the
+     * game with interpolation in between.
+     *
+     * @return the number of ticks between spectator snapshots.
+     */
+    Uint32 getSpectatorInterval() const { return _spectatorInterval; }
+
+    /**
+     * Sets the number of ticks between spectator snapshots.
+     *
+     * Spectators are sent a physics snapshot at this lower rate, and show the
+     * game with interpolation in between.
+     *
+     * @param value The number of ticks between spectator snapshots.
+     */
+    void setSpectatorInterval(Uint32 value) { _spectatorInterval = value; }
+
+    /**
+     * Returns the number of ticks that spectator snapshots lag behind.
+     *
+     * The snapshots are taken from the rewind history of the host, so that
+     * spectators cannot be used to see the game live. The host extends its
+     * rewind history to cover this delay when a spectator is admitted.
+     *
+     * @return the number of ticks that spectator snapshots lag behind.
+     */
+    Uint32 getSpectatorDelay() const { return _spectatorDelay; }
+
+    /**
+     * Sets the number of ticks that spectator snapshots lag behind.
+     *
+     * The snapshots are taken from the rewind history of the host, so that
+     * spectators cannot be used to see the game live. The host extends its
+     * rewind history to cover this delay when a spectator is admitted.
+     *
+     * @param value The number of ticks that spectator snapshots lag behind.
+     */
+    void setSpectatorDelay(Uint32 value) { _spectatorDelay = value; }
 
     /**
      * Returns if there are remaining custom inbound events.
@@ -447,7 +1570,7 @@ public:
      * Queues an outbound event to be sent to peers. 
      * 
      * Queued events are sent when {@link updateNet()} is called. and cleared
-     * after sending.
+     * after sending. A spectator can only send the built-in events.
      */
     void pushOutEvent(const std::shared_ptr<NetEvent>& e);
 };
@@ -0,0 +1,250 @@
+//
+//  CUNetEventPool.h
+//  Networked Physics Library
+//
+//  This header provides a template for a pool of NetEvents. The networked
+//  physics library creates hundreds of short lived events every frame, both
+//  when receiving messages and when packing physics state. A pool recycles
+//  these events (and the memory of their shared pointers), so that steady
+//  state networking does not need to allocate any events at all.
+//
+//  This is not a class. It is a class template. Templates do not have cpp
+//  files. They only have a header file. When you include the header, it
+//  compiles the specific template used by your program. Hence all of the code
+//  for this templated class is in this header.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_NET_EVENT_POOL_H__
+#define __CU_NET_EVENT_POOL_H__
+
+#include <memory>
+#include <vector>
+#include <new>
+#include <cugl/util/CUDebug.h>
+#include <cugl/util/CUFreeList.h>
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+#pragma mark -
+#pragma mark NetEventPool Template
+/**
+ * This class is a pool of recycled events of type T.
+ *
+ * The events are stored in a {@link FreeList}, and handed out as ordinary
+ * shared pointers. When the last reference to an event is dropped, the event
+ * is not deleted. Instead, it is returned to the free list, which calls its
+ * reset() method. Hence T must override {@link NetEvent#reset} to clear all of
+ * its state. A good reset() clears vectors instead of reassigning them, so that
+ * a recycled event keeps the capacity of its buffers.
+ *
+ * The control block of each shared pointer is recycled as well. Once the pool
+ * has grown to the peak number of live events, getting an event does not touch
+ * the heap at all.
+ *
+ * Every event holds a reference to its pool, so it is safe for an event to
+ * outlive the object that created the pool. The pool is not thread safe.
+ */
+template <class T>
+class NetEventPool : public std::enable_shared_from_this<NetEventPool<T>> {
+private:
+    /** The recycled events */
+    FreeList<T> _events;
+    /** The recycled control blocks */
+    std::vector<void*> _blocks;
+    /** The size of a control block (0 if not yet known) */
+    size_t _blockSize;
+
+    /**
+     * The deleter that returns an event to its pool.
+     */
+    struct Recycler {
+        /** The pool of the event */
+        std::shared_ptr<NetEventPool<T>> pool;
+
+        void operator()(T* event) const {
+            pool->_events.free(event);
+        }
+    };
+
+    /**
+     * The allocator that recycles the control blocks of the pool.
+     */
+    template <class U>
+    struct BlockAllocator {
+        typedef U value_type;
+        /** The pool of the control block */
+        std::shared_ptr<NetEventPool<T>> pool;
+
+        BlockAllocator(const std::shared_ptr<NetEventPool<T>>& p) : pool(p) {}
+
+        template <class V>
+        BlockAllocator(const BlockAllocator<V>& other) : pool(other.pool) {}
+
+        U* allocate(size_t n) {
+            return static_cast<U*>(pool->mallocBlock(n*sizeof(U)));
+        }
+
+        void deallocate(U* p, size_t n) {
+            pool->freeBlock(p,n*sizeof(U));
+        }
+
+        template <class V>
+        bool operator==(const BlockAllocator<V>& other) const { return pool == other.pool; }
+
+        template <class V>
+        bool operator!=(const BlockAllocator<V>& other) const { return pool != other.pool; }
+    };
+
+    /**
+     * Returns a block of memory of the given size.
+     *
+     * All control blocks of a pool have the same size, so blocks of that size
+     * are recycled. Any other size (which should not happen) is passed on to
+     * the heap.
+     *
+     * @param size  The size of the block in bytes
+     *
+     * @return a block of memory of the given size.
+     */
+    void* mallocBlock(size_t size) {
+        if (_blockSize == 0) {
+            _blockSize = size;
+        }
+        if (size == _blockSize && !_blocks.empty()) {
+            void* result = _blocks.back();
+            _blocks.pop_back();
+            return result;
+        }
+        return ::operator new(size);
+    }
+
+    /**
+     * Recycles a block allocated by {@link #mallocBlock}.
+     *
+     * @param block The block to recycle
+     * @param size  The size of the block in bytes
+     */
+    void freeBlock(void* block, size_t size) {
+        if (size == _blockSize) {
+            _blocks.push_back(block);
+        } else {
+            ::operator delete(block);
+        }
+    }
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an empty pool.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    NetEventPool() : _blockSize(0) {}
+
+    /**
+     * Deletes this pool, releasing all memory.
+     *
+     * This is only called once every event of the pool has been recycled.
+     */
+    ~NetEventPool() {
+        for (auto it = _blocks.begin(); it != _blocks.end(); ++it) {
+            ::operator delete(*it);
+        }
+        _blocks.clear();
+    }
+
+    /**
+     * Initializes a pool with the given number of preallocated events.
+     *
+     * The pool is always expandable, so the capacity is only a hint.
+     *
+     * @param capacity  The number of preallocated events
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(size_t capacity) {
+        _blocks.reserve(capacity);
+        return _events.init(capacity,true);
+    }
+
+    /**
+     * Returns a newly allocated pool with the given number of preallocated events.
+     *
+     * The pool is always expandable, so the capacity is only a hint.
+     *
+     * @param capacity  The number of preallocated events
+     *
+     * @return a newly allocated pool with the given number of preallocated events.
+     */
+    static std::shared_ptr<NetEventPool<T>> alloc(size_t capacity=0) {
+        std::shared_ptr<NetEventPool<T>> result = std::make_shared<NetEventPool<T>>();
+        return (result->init(capacity) ? result : nullptr);
+    }
+
+#pragma mark Accessors
+    /**
+     * Returns the number of events currently in use.
+     *
+     * @return the number of events currently in use.
+     */
+    size_t getUsage() const { return _events.getUsage(); }
+
+    /**
+     * Returns the maximum number of events in use at any one time.
+     *
+     * @return the maximum number of events in use at any one time.
+     */
+    size_t getPeakUsage() const { return _events.getPeakUsage(); }
+
+#pragma mark Allocation
+    /**
+     * Returns a recycled event.
+     *
+     * The event is in the state left by its reset() method. It is returned
+     * to the pool once the last reference to it is dropped.
+     *
+     * @return a recycled event.
+     */
+    std::shared_ptr<T> get() {
+        T* event = _events.malloc();
+        CUAssertLog(event, "Event pool is exhausted");
+        std::shared_ptr<NetEventPool<T>> self = this->shared_from_this();
+        return std::shared_ptr<T>(event, Recycler{self}, BlockAllocator<T>(self));
+    }
+};
+
+    }
+}
+
+#endif /* __CU_NET_EVENT_POOL_H__ */
@@ -29,7 +29,10 @@
 #define __CU_NET_PHYSICS_CONTROLLER_H__
 
 #include <queue>
+#include <deque>
+#include <unordered_set>
 #include <cugl/netphysics/cu_net_events.h>
+#include <cugl/netphysics/CUNetEventPool.h>
 #include <cugl/physics2/CUObstacleWorld.h>
 
 namespace cugl {
@@ -61,6 +64,121 @@ typedef struct{
     Uint64 numI; // (For PID interpolation) Number of Integral terms summed
 } targetParam;
 
+/**
+ * Struct for storing all active interpolations as a structure of arrays
+ *
+ * Entry ii of every array belongs to the obstacle objects[ii]. The state,
+ * target and weight arrays are split into six blocks of capacity floats each
+ * (x, y, vx, vy, angle, angular velocity), so that every field of every
+ * interpolation can be advanced in one vector pass. The capacity is a
+ * multiple of 4.
+ */
+typedef struct {
+    size_t size; // number of active interpolations
+    size_t capacity; // number of floats in each block
+    std::vector<std::shared_ptr<physics2::Obstacle>> objects; // interpolated obstacles
+    std::vector<Uint8> method; // the interpolation method of each obstacle
+    std::vector<Uint8> direct; // whether to write the body directly (instead of the setters)
+    std::vector<b2Body*> bodies; // the body of each obstacle this step (nullptr to use the setters)
+    std::vector<int> curStep; // current step of each interpolation
+    std::vector<int> numSteps; // total steps of each interpolation
+    std::vector<float> weight; // the interpolation weight of this step, by block
+    std::vector<float> state; // the state of each obstacle, by block
+    std::vector<float> target; // the target state of each obstacle, by block
+    std::vector<Vec2> P2; // (For spline interpolation) control point 2
+    std::vector<Vec2> I; // (For PID interpolation) Integral term sum
+    std::vector<Uint64> numI; // (For PID interpolation) Number of Integral terms summed
+} InterpolationBatch;
+
+/**
+ * Struct for storing the recent snapshots of an obstacle with buffered interpolation
+ *
+ * The obstacle is shown at a fixed delay behind the newest snapshot, by
+ * interpolating between the two snapshots around the render tick.
+ */
+typedef struct {
+    double renderTick; // the (sender) tick currently shown
+    std::deque<std::pair<Uint64,ObjParam>> samples; // recent snapshots with their sender ticks, oldest first
+} EntityBuffer;
+
+/** A decoded physics snapshot, mapping object ids to their state */
+typedef std::unordered_map<Uint64, ObjParam> SyncState;
+
+/** The recent physics snapshots, paired with their sequence numbers */
+typedef std::deque<std::pair<Uint32,SyncState>> SyncHistory;
+
+/**
+ * Struct for storing the snapshots received from another client
+ *
+ * This struct is used to reconstruct delta snapshots against their baseline.
+ */
+typedef struct {
+    Uint32 last; // sequence number of the latest decoded snapshot
+    SyncState current; // state of the latest decoded snapshot
+    std::deque<std::pair<Uint32,SyncState>> history; // recent decoded snapshots
+} SyncStream;
+
+/**
+ * Struct for storing the acknowledgements from another client
+ */
+typedef struct {
+    Uint32 acked; // sequence number of the latest snapshot received by the client
+    Uint32 heard; // our sequence number when we last heard from the client
+} SyncAck;
+
+/**
+ * Struct for storing the predicted state of a single tick
+ *
+ * This struct is used to rewind and replay the predicted obstacles.
+ */
+typedef struct {
+    Uint64 tick; // the game tick of this frame
+    bool valid; // whether this frame has been recorded
+    std::vector<std::byte> input; // the input commands of the tick
+    std::vector<ObjParam> states; // the state of each predicted obstacle after the tick
+} PredictionFrame;
+
+/**
+ * Struct for storing a checksum of the shared state at a single tick
+ */
+typedef struct {
+    Uint64 tick; // the game tick of the checksum
+    bool valid; // whether this record has been computed
+    std::vector<Uint32> buckets; // the hash of each bucket
+} ChecksumRecord;
+
+/**
+ * Struct for tracking the agreement with the checksums of another client
+ */
+typedef struct {
+    Uint64 lastTick; // the latest tick compared
+    Uint64 firstTick; // the first tick of the current run of mismatches
+    Uint32 strikes; // the number of consecutive mismatched checksums
+    bool reported; // whether the current run has been reported
+} DesyncState;
+
+/**
+ * Struct for the result of a ray cast against a past tick
+ *
+ * See {@link NetPhysicsController#rayCastAt}.
+ */
+typedef struct {
+    std::shared_ptr<physics2::Obstacle> obstacle; // the obstacle hit
+    Vec2 point; // the point of the hit (in physics coordinates)
+    Vec2 normal; // the surface normal at the hit
+    float fraction; // the fraction of the ray at the hit
+} RewindHit;
+
+/**
+ * Struct for the smallest change of an object that is worth a FULL_SYNC update
+ */
+typedef struct {
+    float position; // the smallest change in position
+    float angle; // the smallest change in angle (radians)
+    float velocity; // the smallest change in linear velocity
+    float angularVelocity; // the smallest change in angular velocity
+} SyncThreshold;
+
 
 /**
  * This class is the physics controller for the networked physics library.
@@ -86,14 +204,20 @@ protected:
     /** Whether this instance acts as host. */
     bool _isHost;
 
-    /** The next available obstacle ID */
-    Uint64 _objRotation;
     /** The physics world instance */
     std::shared_ptr<physics2::ObstacleWorld> _world;
-    /** Cache of all on-ogoing interpolations */
-    std::unordered_map<std::shared_ptr<physics2::Obstacle>,std::shared_ptr<netphysics::targetParam>> _cache;
-    /** Temporary cache for removal after traversal */
-    std::vector<std::shared_ptr<physics2::Obstacle>> _deleteCache;
+    /** The physics worlds, indexed by shard (the first is the primary world) */
+    std::vector<std::shared_ptr<physics2::ObstacleWorld>> _worlds;
+    /** All on-going interpolations */
+    InterpolationBatch _itpr;
+    /** The index of each interpolated obstacle in the batch */
+    std::unordered_map<physics2::Obstacle*,size_t> _itprIndex;
+    /** The snapshots of each obstacle with buffered interpolation (by global id) */
+    std::unordered_map<Uint64,EntityBuffer> _entityBuffers;
+    /** The default interpolation method */
+    Uint8 _itprMethod;
+    /** The delay in ticks of buffered interpolation */
+    Uint32 _itprDelay;
 
     /** Vector of attached obstacle factories for obstacle creation */
     std::vector<std::shared_ptr<ObstacleFactory>> _obstacleFacts;
@@ -108,11 +232,451 @@ protected:
      * Formula: (target-source)/stepsLeft + source
      */
     float interpolate(int stepsLeft, float target, float source);
+    
+    /**
+     * Starts interpolating the obstacle to the given target.
+     *
+     * If the obstacle is already interpolating, the new target replaces the
+     * old one.
+     *
+     * @param obj       The obstacle to interpolate
+     * @param param     The target parameters for interpolation
+     */
+    void addInterpolation(const std::shared_ptr<physics2::Obstacle>& obj, const targetParam& param);
+    
+    /**
+     * Returns the interpolation method to use for the given obstacle.
+     *
+     * This is the method of the obstacle, or the default method if the
+     * obstacle does not have one.
+     *
+     * @param obj   The obstacle to check
+     *
+     * @return the interpolation method to use for the given obstacle.
+     */
+    Uint8 getInterpolationMethod(const physics2::Obstacle* obj) const;
+    
+    /**
+     * Adds a snapshot to the buffer of the given obstacle.
+     *
+     * Snapshots older than the newest one in the buffer are ignored.
+     *
+     * @param obj   The obstacle with buffered interpolation
+     * @param tick  The sender tick of the snapshot
+     * @param param The state of the obstacle in the snapshot
+     */
+    void addEntitySample(const std::shared_ptr<physics2::Obstacle>& obj, Uint64 tick, const ObjParam& param);
+    
+    /**
+     * Advances all obstacles with buffered interpolation by one tick.
+     *
+     * Each obstacle is moved to the state between the two snapshots around
+     * its render tick. If the render tick is past the newest snapshot, the
+     * obstacle holds the newest state.
+     */
+    void updateEntityBuffers();
+    
+    /**
+     * Stops interpolating the given obstacle.
+     *
+     * This does nothing if the obstacle is not interpolating.
+     *
+     * @param obj   The obstacle to stop interpolating
+     */
+    void removeInterpolation(const std::shared_ptr<physics2::Obstacle>& obj);
+    
+    /**
+     * Stops all interpolations.
+     */
+    void clearInterpolations();
+    
+    /**
+     * Advances all interpolations by one step.
+     *
+     * The state of every interpolated obstacle is gathered into the batch,
+     * advanced in one vector pass per field, and written back. Obstacles with
+     * a single body are written to the body directly, with one transform
+     * update each. Finished interpolations are removed.
+     */
+    void updateInterpolations();
 
     /** Vector of generated events to be sent */
     std::vector<std::shared_ptr<NetEvent>> _outEvents;
+    /** The pool for outbound obstacle events */
+    std::shared_ptr<NetEventPool<PhysObjEvent>> _objEventPool;
+    /** The pool for outbound obstacle changes */
+    std::shared_ptr<NetEventPool<PhysDeltaEvent>> _deltaEventPool;
+    /** The pool for outbound physics snapshots */
+    std::shared_ptr<NetEventPool<PhysSyncEvent>> _syncEventPool;
+    /** The pool for outbound input events */
+    std::shared_ptr<NetEventPool<PhysInputEvent>> _inputEventPool;
+    /** The pool for outbound checksum events */
+    std::shared_ptr<NetEventPool<PhysChecksumEvent>> _checksumEventPool;
+    /** The quantization settings for physics snapshots */
+    SyncPrecision _precision;
+    
+    /** The short UID of this client */
+    Uint32 _shortUID;
+    /** The sequence number of the last delta snapshot sent */
+    Uint32 _syncSeq;
+    /** The recent delta snapshots sent, used as baselines */
+    SyncHistory _syncHistory;
+    /** The acknowledgements from each client (by short UID) */
+    std::unordered_map<Uint32,SyncAck> _syncAcks;
+    /** The snapshots received from each client (by short UID) */
+    std::unordered_map<Uint32,SyncStream> _syncStreams;
+    
+    /** The view rectangle of each client with interest management (by UUID) */
+    std::unordered_map<std::string,Rect> _peerViews;
+    /** The UUID of each client we have heard from (by short UID) */
+    std::unordered_map<Uint32,std::string> _peerUUIDs;
+    /** The recent snapshots sent to each client with interest management (by short UID) */
+    std::unordered_map<Uint32,SyncHistory> _peerHistory;
+    /** The distance an object may leave a view before it stops syncing */
+    float _viewMargin;
+    /** The byte budget of a PRIO_SYNC snapshot */
+    size_t _prioBudget;
+    /** The smallest change of an object that is sent in a FULL_SYNC */
+    SyncThreshold _syncThreshold;
+    /** The ids of the obstacles whose rest state has been prioritized */
+    std::unordered_set<Uint64> _restingIds;
+    
+    /** The tick of the latest input received from each client (by short UID) */
+    std::unordered_map<Uint32,Uint64> _inputAcks;
+    /** The obstacles predicted by this client */
+    std::vector<std::shared_ptr<physics2::Obstacle>> _predicted;
+    /** The ring buffer of recent predicted states, indexed by tick */
+    std::vector<PredictionFrame> _predictionFrames;
+    /** The latest tick recorded for prediction */
+    Uint64 _predictionTick;
+    /** The position error allowed before a prediction is rolled back */
+    float _predictionTolerance;
+    /** Function for applying input commands during a replay */
+    std::function<void(Uint64, const std::vector<std::byte>&)> _inputFunc;
+    /** Total number of rollbacks done */
+    long _rollbackCount;
+    /** The reusable world states for rollbacks (one per shard) */
+    std::vector<physics2::WorldState> _rollbackStates;
+    
+    /** The number of ticks between checksums (0 to disable) */
+    Uint32 _checksumInterval;
+    /** The size of a position or velocity quantum in a checksum */
+    float _checksumQuantum;
+    /** The ring buffer of recent checksums, indexed by check */
+    std::vector<ChecksumRecord> _checksums;
+    /** The agreement with the checksums of each client (by short UID) */
+    std::unordered_map<Uint32,DesyncState> _desyncs;
+    /** Function called when a divergence is detected */
+    std::function<void(Uint32, Uint64, const std::vector<Uint64>&)> _desyncFunc;
+    /** Total number of divergences reported */
+    long _desyncCount;
+    
+    /** The number of ticks between ownership checkpoints (0 to disable) */
+    Uint32 _checkpointInterval;
+    /** The UUID of the client holding each held obstacle (by global id) */
+    std::unordered_map<Uint64,std::string> _owners;
+    /** The pool for outbound checkpoint events */
+    std::shared_ptr<NetEventPool<PhysCheckpointEvent>> _checkpointEventPool;
+    
+    /** The number of ticks of past states to keep for rewinding (0 to disable) */
+    Uint32 _rewindLength;
+    /** The past states of the moving shared obstacles, paired with their ticks, oldest first */
+    std::deque<std::pair<Uint64,SyncState>> _rewindHistory;
+    /** The sequence number of the last spectator snapshot */
+    Uint32 _spectatorSeq;
+    /** The recent spectator snapshots, used as baselines */
+    SyncHistory _spectatorHistory;
+    /** The game tick of the state in the last spectator snapshot */
+    Uint64 _spectatorTick;
+    
+    /** An ownership lease: its expiry tick and the global id of its obstacle */
+    typedef std::pair<Uint64,Uint64> OwnerLease;
+    /** The ownership leases of this client, soonest first (including stale leases) */
+    std::priority_queue<OwnerLease,std::vector<OwnerLease>,std::greater<OwnerLease>> _leases;
+    /** The expiry tick of the current lease on each leased obstacle (by global id) */
+    std::unordered_map<Uint64,Uint64> _leaseExpiry;
+    /** The number of calls to fixedUpdate, which is the clock for leases */
+    Uint64 _leaseTick;
+    
+    /** A late-join world transfer to a single client */
+    typedef struct {
+        /** The ids of the obstacles to send, nearest first */
+        std::vector<Uint64> pending;
+        /** The position in pending of the next obstacle to send */
+        size_t next;
+        /** The number of obstacles in the near region */
+        size_t near;
+        /** The index of the next chunk */
+        Uint32 chunk;
+        /** Whether the end of the near region has been sent */
+        bool sentNear;
+    } WorldTransfer;
+    
+    /** The factory and parameters of each obstacle made by a factory (by global id) */
+    std::unordered_map<Uint64,std::pair<Uint32,std::shared_ptr<std::vector<std::byte>>>> _factoryMade;
+    /** The world transfers in progress (by UUID) */
+    std::unordered_map<std::string,WorldTransfer> _transfers;
+    /** The bytes of world transfer sent each tick after the near region */
+    size_t _transferRate;
+    /** The progress of the world transfer to this client */
+    Uint8 _transferState;
+    /** The ids of the obstacles removed before their world transfer arrived */
+    std::unordered_set<Uint64> _transferRemoved;
+    /** Function called when the world transfer to this client progresses */
+    std::function<void(bool)> _worldFunc;
+    /** The pool for outbound world events */
+    std::shared_ptr<NetEventPool<PhysWorldEvent>> _worldEventPool;
+    
+    /** The definition of each shared joint when last sent or received (by joint id) */
+    std::unordered_map<Uint64,JointParam> _joints;
+    /** The root of the group of each jointed obstacle (by global id) */
+    std::unordered_map<Uint64,Uint64> _groupOf;
+    /** The members of each group, root first (by global id of the root) */
+    std::unordered_map<Uint64,std::vector<Uint64>> _groups;
+    /** Whether the groups must be rebuilt from the shared joints */
+    bool _groupsDirty;
+    /** The pool for outbound joint events */
+    std::shared_ptr<NetEventPool<PhysJointEvent>> _jointEventPool;
+    /** The pool for outbound group events */
+    std::shared_ptr<NetEventPool<PhysGroupEvent>> _groupEventPool;
+    
+    /**
+     * Returns the sequence number of the baseline for the next delta snapshot.
+     *
+     * The baseline is the latest snapshot acknowledged by every client heard
+     * from recently. This method returns 0 if there is no such snapshot in the
+     * history, in which case the next snapshot is a key snapshot.
+     *
+     * @return the sequence number of the baseline for the next delta snapshot.
+     */
+    Uint32 getSyncBaseline() const;
+    
+    /**
+     * Records how much of our snapshot stream the given client has received.
+     *
+     * @param source    The short UID of the client
+     * @param uuid      The UUID of the client
+     * @param acks      The acknowledgements sent by the client
+     */
+    void recordAcks(Uint32 source, const std::string& uuid,
+                    const std::vector<std::pair<Uint32,Uint32>>& acks);
+    
+    /**
+     * Returns the estimated size in bytes of one object in a snapshot.
+     *
+     * This assumes that the object is a full (not delta) entry in the world
+     * bounds, and is used to convert the PRIO_SYNC budget into an object count.
+     *
+     * @return the estimated size in bytes of one object in a snapshot.
+     */
+    size_t getSyncObjectSize() const;
+    
+    /**
+     * Returns the bounds that contain every world of this controller.
+     *
+     * This is the quantization bounds of the snapshots that span all of the
+     * worlds (see {@link #addWorld}). With a single world, it is just the
+     * bounds of that world.
+     *
+     * @return the bounds that contain every world of this controller.
+     */
+    Rect getSyncBounds() const;
+    
+    /**
+     * Returns a new physics snapshot with the header of this client.
+     *
+     * The header includes the quantization settings and the acknowledgements for
+     * the snapshots received from the other clients. The positions in the
+     * snapshot are quantized to the given bounds.
+     *
+     * @param bounds    The quantization bounds of the snapshot
+     *
+     * @return a new physics snapshot with the header of this client.
+     */
+    std::shared_ptr<PhysSyncEvent> allocSyncEvent(const Rect& bounds) const;
+    
+    /**
+     * Returns the shard of the world with the given obstacle id.
+     *
+     * Ids from a shard that this controller does not have belong to the
+     * primary world.
+     *
+     * @param id    The global obstacle id
+     *
+     * @return the shard of the world with the given obstacle id.
+     */
+    size_t worldIndex(Uint64 id) const {
+        size_t shard = physics2::ObstacleWorld::shardOf(id);
+        return shard < _worlds.size() ? shard : 0;
+    }
+    
+    /**
+     * Returns the world with the given obstacle id.
+     *
+     * See {@link #worldIndex}.
+     *
+     * @param id    The global obstacle id
+     *
+     * @return the world with the given obstacle id.
+     */
+    const std::shared_ptr<physics2::ObstacleWorld>& worldOf(Uint64 id) const {
+        return _worlds[worldIndex(id)];
+    }
+    
+    /**
+     * Returns the obstacle with the given global id in any world.
+     *
+     * If there is no obstacle with that id, this method returns nullptr.
+     *
+     * @param id    The global obstacle id
+     *
+     * @return the obstacle with the given global id in any world.
+     */
+    const std::shared_ptr<physics2::Obstacle>& findObstacle(Uint64 id) const {
+        return worldOf(id)->getObstacle(id);
+    }
+    
+    /**
+     * Packs a delta snapshot of the given objects into the event.
+     *
+     * The snapshot is delta compressed against the baseline, provided that it is
+     * still in the history. Otherwise it is a key snapshot. The new snapshot is
+     * appended to the history with the given sequence number.
+     *
+     * If interest is not nullptr, only the objects with ids in that set are sent.
+     * Any other objects are marked as removed, so the recipient stops syncing them.
+     *
+     * Any field of an awake object that changed less than the sync threshold
+     * keeps its baseline value, so it is not sent. Resting objects are compared
+     * exactly, so their final state is sent once and then never again.
+     *
+     * @param event     The event to store the snapshot
+     * @param params    The (quantized) state of every object to sync
+     * @param resting   Whether each object is asleep (parallel to params)
+     * @param history   The recent snapshots sent to the recipient(s)
+     * @param baseline  The sequence number of the requested baseline
+     * @param interest  The ids of the objects to send (nullptr for all)
+     * @param sequence  The sequence number of the new snapshot
+     */
+    void packDeltaSync(const std::shared_ptr<PhysSyncEvent>& event,
+                       const std::vector<ObjParam>& params,
+                       const std::vector<bool>& resting,
+                       SyncHistory& history, Uint32 baseline,
+                       const std::unordered_set<Uint64>* interest, Uint32 sequence);
+    
+    /**
+     * Computes the ids of the objects of interest for the given view.
+     *
+     * An object enters the view when its bounding box overlaps the view. It only
+     * leaves once its bounding box no longer overlaps the view expanded by the
+     * view margin. This hysteresis keeps objects at the edge of a view from
+     * flickering in and out of the snapshots.
+     *
+     * @param view      The view rectangle of the recipient
+     * @param previous  The last snapshot sent to the recipient (may be nullptr)
+     * @param result    The set to store the object ids
+     */
+    void queryInterest(const Rect& view, const SyncState* previous,
+                       std::unordered_set<Uint64>& result) const;
+    
+    /**
+     * Sets the state of an obstacle without marking it as changed.
+     *
+     * @param obj   The obstacle to modify
+     * @param param The state to apply
+     */
+    void applyState(const std::shared_ptr<physics2::Obstacle>& obj, const ObjParam& param);
+    
+    /**
+     * Reconciles the predicted obstacles with an authoritative state.
+     *
+     * If any prediction for the given tick is off by more than the tolerance,
+     * the predicted obstacles are rewound to the authoritative state and the
+     * recorded inputs since then are replayed. Otherwise, this method does
+     * nothing.
+     *
+     * Only the predicted obstacles are rewound. The world state is captured
+     * before the replay and restored afterwards (see
+     * {@link ObstacleWorld#captureState}), so the replay costs one world step
+     * per tick plus one state copy per predicted obstacle.
+     *
+     * @param tick          The tick of the authoritative state
+     * @param corrections   The authoritative state of the predicted obstacles
+     */
+    void reconcile(Uint64 tick, const std::vector<ObjParam>& corrections);
+    
+    /**
+     * Computes the checksum of the shared state into the given buckets.
+     *
+     * Each shared obstacle contributes a hash of its quantized position, angle
+     * and velocities to the bucket for its id. The contributions are summed,
+     * so the result does not depend on the order of the obstacles.
+     *
+     * Unless the world is deterministic, only obstacles at rest are included.
+     * Moving obstacles on a remote client lag behind by the latency, and so
+     * would never match.
+     *
+     * @param buckets   The vector to store the bucket hashes
+     */
+    void computeChecksum(std::vector<Uint32>& buckets) const;
+    
+    /**
+     * Packs the chunks of a world transfer due this tick.
+     *
+     * The whole near region is packed at once. After that, chunks are packed
+     * until they exceed the transfer rate. This method returns true once the
+     * last chunk has been packed.
+     *
+     * @param uuid      The UUID of the recipient
+     * @param transfer  The world transfer to the recipient
+     *
+     * @return true once the last chunk has been packed
+     */
+    bool packWorldChunks(const std::string& uuid, WorldTransfer& transfer);
+    
+    /**
+     * Moves the given obstacle to a remote state.
+     *
+     * The obstacle is interpolated to the state with its interpolation method.
+     * Buffered obstacles add the state to their buffer instead.
+     *
+     * @param obj   The obstacle to move
+     * @param param The remote state
+     * @param stamp The time stamp of the remote state
+     */
+    void steerObstacle(const std::shared_ptr<physics2::Obstacle>& obj, const ObjParam& param, Uint64 stamp);
+    
+    /**
+     * Rebuilds the groups of jointed obstacles from the shared joints.
+     *
+     * A group is the set of obstacles connected by shared joints. Joints to
+     * static obstacles do not join groups, as otherwise everything pinned to
+     * the ground would be a single group. The root of a group is the member
+     * with the smallest id, so every client agrees on it.
+     */
+    void rebuildGroups();
+    
+    /**
+     * Packs the changes to the shared joints since the last tick.
+     *
+     * A shared joint whose tunable parameters changed sends a JOINT_PARAMS
+     * event. A shared joint that was destroyed with one of its bodies is
+     * forgotten without an event, as every client destroys it with the body.
+     */
+    void packJoints();
+    
+    /**
+     * Adds the given group to a group snapshot.
+     *
+     * @param event The group snapshot
+     * @param root  The global id of the root of the group
+     */
+    void packGroup(const std::shared_ptr<PhysGroupEvent>& event, Uint64 root);
     
 public:
+    /** Whether to use a vectorization algorithm (Access not thread safe) */
+    static bool VECTORIZE;
+    
     enum SyncType {
         /** 
          * Synchronize all objects (Shared or unshared) in the world 
@@ -121,15 +685,70 @@ public:
         OVERRIDE_FULL_SYNC,
         /** Synchronize all shared objects in the world */
         FULL_SYNC,
-        /** Prioritize syncing volatile objects */
+        /**
+         * Synchronize the shared objects of highest priority.
+         *
+         * Objects accrue priority every PRIO_SYNC until they are sent. Fast
+         * objects, objects in contact, and objects that changed ownership
+         * accrue faster (see {@link Obstacle#setSyncWeight}). The number of
+         * objects is limited by the byte budget.
+         */
         PRIO_SYNC
     };
     
+    /**
+     * The methods for smoothing remote updates of an obstacle.
+     *
+     * Snapshot based methods move an obstacle from its current state to each
+     * new snapshot over a number of steps. They add little latency, but may
+     * overshoot. Buffered interpolation instead shows the obstacle a fixed
+     * delay behind the newest snapshot ({@link #setInterpolationDelay}). This
+     * is the smoothest, but adds that delay to the latency.
+     *
+     * The method can be set per obstacle with {@link Obstacle#setInterpolation}.
+     */
+    enum InterpolationMethod {
+        /** Use the default method of the controller (only valid for obstacles) */
+        DEFAULT_INTERPOLATION = 0,
+        /** Move each field linearly to the snapshot */
+        LINEAR_INTERPOLATION,
+        /** Move along a cubic Bezier curve through the snapshot velocities */
+        BEZIER_INTERPOLATION,
+        /** Move along a cubic Hermite spline through the snapshot velocities */
+        HERMITE_INTERPOLATION,
+        /** Steer the velocity to the snapshot with a PID controller */
+        PID_INTERPOLATION,
+        /** Show the obstacle a fixed delay behind the newest snapshot */
+        BUFFERED_INTERPOLATION
+    };
+    
+    /**
+     * The progress of a late-join world transfer to this client.
+     *
+     * See {@link #sendWorld}.
+     */
+    enum TransferState {
+        /** No world transfer has been received */
+        TRANSFER_NONE = 0,
+        /** The near region of the world is still arriving */
+        TRANSFER_LOADING,
+        /** The near region has arrived, and the rest is still arriving */
+        TRANSFER_NEAR,
+        /** The whole world has arrived */
+        TRANSFER_COMPLETE
+    };
+    
     /**
      * Constructor for the controller without initialization. 
      */
     NetPhysicsController():
-        _itprCount(0),_ovrdCount(0),_stepSum(0),_objRotation(0),_isHost(false) {};
+        _itprCount(0),_ovrdCount(0),_stepSum(0),_isHost(false),_itpr(),
+        _itprMethod(LINEAR_INTERPOLATION),_itprDelay(6),
+        _shortUID(0),_syncSeq(0),_viewMargin(1.0f),_prioBudget(1024),_syncThreshold({0,0,0,0}),
+        _predictionTick(0),_predictionTolerance(0.05f),_rollbackCount(0),
+        _checksumInterval(0),_checksumQuantum(0.1f),_desyncCount(0),
+        _checkpointInterval(30),_transferRate(1024),_transferState(TRANSFER_NONE),
+        _rewindLength(0),_spectatorSeq(0),_spectatorTick(0),_leaseTick(0),_groupsDirty(false) {};
 
     /**
      * Allocates a new physics controller with the default values.
@@ -158,8 +777,19 @@ public:
     void init(std::shared_ptr<physics2::ObstacleWorld>& world, Uint32 shortUID, bool isHost, std::function<void(const std::shared_ptr<physics2::Obstacle>&, const std::shared_ptr<scene2::SceneNode>&)> linkSceneToObsFunc) {
         _world = world;
         _world->setShortUID(shortUID);
+        _worlds.assign(1,world);
+        _shortUID = shortUID;
         _linkSceneToObsFunc = linkSceneToObsFunc;
         _isHost = isHost;
+        _objEventPool = NetEventPool<PhysObjEvent>::alloc();
+        _deltaEventPool = NetEventPool<PhysDeltaEvent>::alloc();
+        _syncEventPool = NetEventPool<PhysSyncEvent>::alloc();
+        _inputEventPool = NetEventPool<PhysInputEvent>::alloc();
+        _checksumEventPool = NetEventPool<PhysChecksumEvent>::alloc();
+        _checkpointEventPool = NetEventPool<PhysCheckpointEvent>::alloc();
+        _worldEventPool = NetEventPool<PhysWorldEvent>::alloc();
+        _jointEventPool = NetEventPool<PhysJointEvent>::alloc();
+        _groupEventPool = NetEventPool<PhysGroupEvent>::alloc();
     }
 
     /**
@@ -167,6 +797,8 @@ public:
      */
     void dispose() {
     	_world = nullptr;
+    	_worlds.clear();
+    	_rollbackStates.clear();
 		_linkSceneToObsFunc = nullptr;
     }
 
@@ -177,6 +809,46 @@ public:
 		dispose();
 	}
 
+    /**
+     * Adds another physics world to this controller, returning its shard.
+     *
+     * A game with several disconnected play areas may simulate each in its own
+     * world, and step them in parallel with {@link physics2::ObstacleWorld#updateAll}.
+     * The world passed to {@link #init} is the primary world, with shard 0. Each
+     * added world gets the next shard, and the short UID of this client. Every
+     * client must add the same worlds in the same order, so that the shards agree.
+     * The worlds must be added before any obstacles.
+     *
+     * The shard is part of every obstacle id (see {@link physics2::ObstacleWorld#setShard}),
+     * so the ids are unique across the worlds, and every event is routed to the
+     * right world. Object changes and prioritized snapshots are sent as one event
+     * per world, quantized to the bounds of that world. Delta snapshots are one
+     * stream over all of the worlds, quantized to the bounds of them all. View
+     * rectangles (see {@link #setPeerView}) apply to every world.
+     *
+     * @param world The physics world to add
+     *
+     * @return the shard of the added world
+     */
+    Uint8 addWorld(const std::shared_ptr<physics2::ObstacleWorld>& world) {
+        CUAssertLog(!_worlds.empty() && _worlds.size() < 0xFF, "Cannot add another world");
+        Uint8 shard = (Uint8)_worlds.size();
+        world->setShortUID(_shortUID);
+        world->setShard(shard);
+        _worlds.push_back(world);
+        return shard;
+    }
+    
+    /**
+     * Returns the physics worlds of this controller, indexed by shard.
+     *
+     * The first world is the primary world passed to {@link #init}. These
+     * may be updated together with {@link physics2::ObstacleWorld#updateAll}.
+     *
+     * @return the physics worlds of this controller, indexed by shard.
+     */
+    const std::vector<std::shared_ptr<physics2::ObstacleWorld>>& getWorlds() const { return _worlds; }
+
     /**
      * Add a custom obstacle factory to the controller.
      * 
@@ -197,21 +869,60 @@ public:
      * This method is called automatically by the NetEventController
      */
     void processPhysObjEvent(const std::shared_ptr<PhysObjEvent>& event);
+    
+    /**
+     * Processes a batch of obstacle changes from a peer.
+     *
+     * Each record only updates the fields in its mask. Records for unknown
+     * obstacles are ignored. This method is called automatically by the
+     * NetEventController.
+     */
+    void processPhysDeltaEvent(const std::shared_ptr<PhysDeltaEvent>& event);
 
     /**
      * Adds a shared obstacle to the physics world.
      * 
      * This method is used to add a shared obstacle across all clients.
+     *
+     * The obstacle is added to the world with the given shard (see {@link #addWorld}).
+     * Its id is allocated by that world, so every client adds it to the world with
+     * the same shard.
      * 
      * @param factoryID The ID of the obstacle factory to use
      * @param bytes The serialized parameters taken by the obstacle factory
+     * @param shard The shard of the world to add the obstacle to
      * 
      * @return A pair of the added obstacle and its corresponding scene node
      * 
      * Users can uses the returned references to manually link the obstacle,
      * or for custom obstacle setups.
      */
-    std::pair<std::shared_ptr<physics2::Obstacle>,std::shared_ptr<scene2::SceneNode>> addSharedObstacle(Uint32 factoryID, std::shared_ptr<std::vector<std::byte>> bytes);
+    std::pair<std::shared_ptr<physics2::Obstacle>,std::shared_ptr<scene2::SceneNode>> addSharedObstacle(Uint32 factoryID, std::shared_ptr<std::vector<std::byte>> bytes, Uint8 shard=0);
+    
+    /**
+     * Adds several shared obstacles from the same factory parameters.
+     *
+     * This is the batch version of {@link #addSharedObstacle}, for spawning
+     * many similar obstacles at once. Every obstacle is made from the same
+     * parameters (with {@link ObstacleFactory#createObstacles}), and then moved
+     * to its own position and angle. All of the obstacles are sent in a single
+     * {@link PhysObjEvent}, which carries the parameters once, and only the id,
+     * position and angle of each obstacle.
+     *
+     * If angles is empty, each obstacle keeps the angle given to it by the
+     * factory. Otherwise, it must be parallel to positions.
+     *
+     * @param factoryID The ID of the obstacle factory to use
+     * @param bytes     The serialized parameters shared by the obstacles
+     * @param positions The position of each obstacle
+     * @param angles    The angle of each obstacle (may be empty)
+     * @param shard     The shard of the world to add the obstacles to
+     *
+     * @return the added obstacles and their corresponding scene nodes
+     */
+    std::vector<std::pair<std::shared_ptr<physics2::Obstacle>,std::shared_ptr<scene2::SceneNode>>> addSharedObstacles(Uint32 factoryID, std::shared_ptr<std::vector<std::byte>> bytes,
+                                                                                                                     const std::vector<Vec2>& positions, const std::vector<float>& angles,
+                                                                                                                     Uint8 shard=0);
     
     /**
      * Acquires the ownership of the object for an amount of time
@@ -224,6 +935,9 @@ public:
      *
      * @param duration  the amount of physics steps to hold ownership for, if 0, then ownership will last until it is released.
      *
+     * Leases with a duration are kept in a heap by expiry, so {@link #fixedUpdate}
+     * only visits the leases that actually expire.
+     *
      * REQUIRES: only one client should call it on an object within a period of time to avoid race conditions.
      */
     void acquireObs(std::shared_ptr<physics2::Obstacle> obs, Uint64 duration);
@@ -262,47 +976,784 @@ public:
         _itprCount = 0;
         _ovrdCount = 0;
         _stepSum = 0;
-        _cache.clear();
-        _deleteCache.clear();
+        clearInterpolations();
+        _entityBuffers.clear();
         _outEvents.clear();
         _sharedObsToNodeMap.clear();
+        _syncSeq = 0;
+        _syncHistory.clear();
+        _syncAcks.clear();
+        _syncStreams.clear();
+        _peerViews.clear();
+        _peerUUIDs.clear();
+        _peerHistory.clear();
+        _inputAcks.clear();
+        _predicted.clear();
+        _predictionFrames.clear();
+        _predictionTick = 0;
+        _rollbackCount = 0;
+        _checksums.clear();
+        _desyncs.clear();
+        _desyncCount = 0;
+        _transfers.clear();
+        _transferRemoved.clear();
+        _transferState = TRANSFER_NONE;
+        _joints.clear();
+        _groupOf.clear();
+        _groups.clear();
+        _groupsDirty = false;
+        _leases = decltype(_leases)();
+        _leaseExpiry.clear();
+        _leaseTick = 0;
+        _rewindHistory.clear();
+        _spectatorSeq = 0;
+        _spectatorHistory.clear();
+        _spectatorTick = 0;
     }
     
     /**
-     * Returns true if the given obstacle is being interpolated.
+     * Returns the quantization settings for physics snapshots.
+     *
+     * Positions are quantized to the bounds of the physics world, so the bit
+     * counts determine the precision of each snapshot. Velocities outside of the
+     * given ranges are clamped.
+     *
+     * @return the quantization settings for physics snapshots.
      */
-    bool isInSync(std::shared_ptr<physics2::Obstacle> obj);
+    const SyncPrecision& getSyncPrecision() const { return _precision; }
 
     /**
-     * Adds an object to interpolate with the given target parameters.
-     * 
-     * @param obj The obstacle to interpolate
-     * @param param The target parameters for interpolation
+     * Sets the quantization settings for physics snapshots.
+     *
+     * Positions are quantized to the bounds of the physics world, so the bit
+     * counts determine the precision of each snapshot. Velocities outside of the
+     * given ranges are clamped.
+     *
+     * These settings are sent with each snapshot, so there is no need for the
+     * clients to agree on them.
+     *
+     * @param precision The quantization settings for physics snapshots
      */
-    void addSyncObject(std::shared_ptr<physics2::Obstacle> obj, std::shared_ptr<netphysics::targetParam> param);
-
+    void setSyncPrecision(const SyncPrecision& precision) { _precision = precision; }
+    
+#pragma mark -
+#pragma mark Interest Management
     /**
-     * Packs object dynamics data for synchronization and add it to _outEvents.
+     * Sets the view rectangle of the given client.
      *
-     * This method can be used to prompt the physics controller to synchronize objects,
-     * It is called automatically, but additional calls to it can help fix potential desyncing.
+     * Once any client has a view, physics snapshots are no longer broadcast.
+     * Instead, every client gets its own snapshot, which only includes the
+     * objects in its view (if it has one). This saves bandwidth on large
+     * maps, at the cost of serializing a snapshot for each client.
      *
-     * @param type  the type of synchronization
+     * @param uuid  The UUID of the client
+     * @param view  The view rectangle in physics coordinates
      */
-    void packPhysSync(SyncType type);
-
+    void setPeerView(const std::string& uuid, const Rect& view);
+    
     /**
-     * Packs any changed object information and add them to _outEvents.
+     * Removes the view rectangle of the given client.
      *
-     * This method helps synchronize any method calls to the obstacles that set its properties.
-     * This includes explicit setPosition(), setVelocity(), setBodyType(), etc.
+     * That client will receive every object again. If no client has a view
+     * any more, physics snapshots are broadcast as before.
+     *
+     * @param uuid  The UUID of the client
      */
-    void packPhysObj();
+    void clearPeerView(const std::string& uuid);
     
     /**
-     * Processes a physics synchronization event.
+     * Returns the distance an object may leave a view before it stops syncing.
+     *
+     * Objects enter a view as soon as they overlap it, but only leave once
+     * they are this far outside of it. This keeps objects at the edge of a
+     * view from flickering.
+     *
+     * @return the distance an object may leave a view before it stops syncing.
      */
-    void processPhysSyncEvent(const std::shared_ptr<PhysSyncEvent>& event);
+    float getViewMargin() const { return _viewMargin; }
+    
+    /**
+     * Sets the distance an object may leave a view before it stops syncing.
+     *
+     * Objects enter a view as soon as they overlap it, but only leave once
+     * they are this far outside of it. This keeps objects at the edge of a
+     * view from flickering.
+     *
+     * @param margin    The distance in physics coordinates
+     */
+    void setViewMargin(float margin) { _viewMargin = margin; }
+    
+    /**
+     * Returns the byte budget of a PRIO_SYNC snapshot.
+     *
+     * A PRIO_SYNC sends as many of the highest priority objects as fit in
+     * this budget (but always at least one).
+     *
+     * @return the byte budget of a PRIO_SYNC snapshot.
+     */
+    size_t getPrioritySyncBudget() const { return _prioBudget; }
+    
+    /**
+     * Sets the byte budget of a PRIO_SYNC snapshot.
+     *
+     * A PRIO_SYNC sends as many of the highest priority objects as fit in
+     * this budget (but always at least one).
+     *
+     * @param budget    The byte budget of a PRIO_SYNC snapshot
+     */
+    void setPrioritySyncBudget(size_t budget) { _prioBudget = budget; }
+    
+    /**
+     * Returns the smallest change of an object that is sent in a FULL_SYNC.
+     *
+     * A field of an awake object is only sent once it differs from the last
+     * acknowledged snapshot by more than its threshold. Hence the error on the
+     * other clients is bounded by the threshold. All thresholds are 0 by
+     * default, which sends every change.
+     *
+     * Sleeping obstacles ignore the thresholds. Their rest state is sent once,
+     * and then nothing more until they wake up.
+     *
+     * @return the smallest change of an object that is sent in a FULL_SYNC.
+     */
+    const SyncThreshold& getSyncThreshold() const { return _syncThreshold; }
+    
+    /**
+     * Sets the smallest change of an object that is sent in a FULL_SYNC.
+     *
+     * A field of an awake object is only sent once it differs from the last
+     * acknowledged snapshot by more than its threshold. Hence the error on the
+     * other clients is bounded by the threshold. All thresholds are 0 by
+     * default, which sends every change.
+     *
+     * Sleeping obstacles ignore the thresholds. Their rest state is sent once,
+     * and then nothing more until they wake up.
+     *
+     * @param threshold The smallest change of an object that is sent
+     */
+    void setSyncThreshold(const SyncThreshold& threshold) { _syncThreshold = threshold; }
+    
+#pragma mark -
+#pragma mark Prediction
+    /**
+     * Adds an obstacle to predict locally.
+     *
+     * Prediction is for clients in host-authoritative mode. A predicted
+     * obstacle is simulated locally from the inputs of this client, instead of
+     * interpolated towards the host snapshots. When a host snapshot disagrees
+     * with the prediction for the same tick, the predicted obstacles are
+     * rewound to the host state, and the inputs since then are replayed (see
+     * {@link setInputFunc}).
+     *
+     * @param obj   The obstacle to predict
+     */
+    void addPredicted(const std::shared_ptr<physics2::Obstacle>& obj);
+    
+    /**
+     * Removes an obstacle from prediction.
+     *
+     * The obstacle will be interpolated towards the host snapshots again.
+     *
+     * @param obj   The obstacle to stop predicting
+     */
+    void removePredicted(const std::shared_ptr<physics2::Obstacle>& obj);
+    
+    /**
+     * Returns true if the given obstacle is predicted locally.
+     *
+     * @param obj   The obstacle to check
+     *
+     * @return true if the given obstacle is predicted locally.
+     */
+    bool isPredicted(const std::shared_ptr<physics2::Obstacle>& obj) const;
+    
+    /**
+     * Sets the function for applying input commands during a replay.
+     *
+     * During a rollback, the world is stepped once for every tick replayed.
+     * Before each step, this function is called with the tick and the input
+     * that was recorded for it. It should apply the input to the predicted
+     * obstacles, exactly as the game did originally.
+     *
+     * @param func  The function for applying input commands
+     */
+    void setInputFunc(std::function<void(Uint64, const std::vector<std::byte>&)> func) {
+        _inputFunc = func;
+    }
+    
+    /**
+     * Records the input and predicted state of the given tick.
+     *
+     * This method is called automatically by the {@link NetEventController}
+     * in host-authoritative mode. It should be called after the world has been
+     * stepped for the tick.
+     *
+     * @param tick  The game tick
+     * @param input The input commands of the tick
+     */
+    void recordPrediction(Uint64 tick, const std::vector<std::byte>& input);
+    
+    /**
+     * Returns the position error allowed before a prediction is rolled back.
+     *
+     * An angle error of the same amount (in radians) also triggers a rollback.
+     *
+     * @return the position error allowed before a prediction is rolled back.
+     */
+    float getPredictionTolerance() const { return _predictionTolerance; }
+    
+    /**
+     * Sets the position error allowed before a prediction is rolled back.
+     *
+     * An angle error of the same amount (in radians) also triggers a rollback.
+     * Rollbacks are expensive, as they step the whole world, so this should
+     * be a bit larger than the snapshot precision.
+     *
+     * @param tolerance The position error allowed
+     */
+    void setPredictionTolerance(float tolerance) { _predictionTolerance = tolerance; }
+    
+    /**
+     * Returns the total number of rollbacks done.
+     *
+     * @return the total number of rollbacks done.
+     */
+    long getRollbackCount() const { return _rollbackCount; }
+    
+#pragma mark -
+#pragma mark Desync Detection
+    /**
+     * Returns the number of ticks between checksums.
+     *
+     * See {@link #setChecksumInterval}.
+     *
+     * @return the number of ticks between checksums.
+     */
+    Uint32 getChecksumInterval() const { return _checksumInterval; }
+    
+    /**
+     * Sets the number of ticks between checksums.
+     *
+     * Every this many ticks, each client sends a small {@link PhysChecksumEvent}
+     * with a hash of its shared obstacles. When the hash of another client does
+     * not match ours for the same tick twice in a row, the desync function is
+     * called (see {@link #setDesyncFunc}). The ticks are the game ticks of the
+     * {@link NetEventController}, so they must be roughly aligned across peers.
+     *
+     * Outside of a deterministic world, only obstacles at rest are compared.
+     * This detects objects that settled in different places, and is intended
+     * to replace sending full snapshots every frame as insurance.
+     *
+     * A value of 0 disables checksums. This is the default.
+     *
+     * @param ticks The number of ticks between checksums
+     */
+    void setChecksumInterval(Uint32 ticks) { _checksumInterval = ticks; }
+    
+    /**
+     * Returns the size of a position or velocity quantum in a checksum.
+     *
+     * @return the size of a position or velocity quantum in a checksum.
+     */
+    float getChecksumQuantum() const { return _checksumQuantum; }
+    
+    /**
+     * Sets the size of a position or velocity quantum in a checksum.
+     *
+     * Values are rounded to a multiple of the quantum before they are hashed,
+     * so differences much smaller than this are ignored. Obstacles with a
+     * speed of at least half a quantum are considered to be moving.
+     *
+     * @param quantum   The size of a position or velocity quantum
+     */
+    void setChecksumQuantum(float quantum) { _checksumQuantum = quantum; }
+    
+    /**
+     * Sets the function called when a divergence is detected.
+     *
+     * The function is called once per run of mismatches with the short UID of
+     * the other client, the first tick that did not match, and the ids of the
+     * local obstacles that may have diverged (those in the mismatched buckets).
+     * Obstacles that only exist on the other client cannot be listed.
+     *
+     * A typical response is for the host to send a key snapshot with
+     * {@link #packPhysSync}.
+     *
+     * @param func  The function called when a divergence is detected
+     */
+    void setDesyncFunc(std::function<void(Uint32, Uint64, const std::vector<Uint64>&)> func) {
+        _desyncFunc = func;
+    }
+    
+    /**
+     * Returns the total number of divergences reported.
+     *
+     * @return the total number of divergences reported.
+     */
+    long getDesyncCount() const { return _desyncCount; }
+    
+    /**
+     * Records a checksum of the shared state if one is due at this tick.
+     *
+     * If a checksum is due, it is added to the out events as a
+     * {@link PhysChecksumEvent}. This method is called automatically by the
+     * {@link NetEventController} each tick.
+     *
+     * @param tick  The game tick
+     */
+    void packChecksum(Uint64 tick);
+    
+    /**
+     * Processes a checksum event from another client.
+     *
+     * The checksum is compared to the one recorded for the same tick. If that
+     * tick is no longer (or not yet) recorded, the event is ignored.
+     */
+    void processChecksumEvent(const std::shared_ptr<PhysChecksumEvent>& event);
+
+#pragma mark -
+#pragma mark Host Migration
+    /**
+     * Returns the number of ticks between ownership checkpoints.
+     *
+     * See {@link #setCheckpointInterval}.
+     *
+     * @return the number of ticks between ownership checkpoints.
+     */
+    Uint32 getCheckpointInterval() const { return _checkpointInterval; }
+    
+    /**
+     * Sets the number of ticks between ownership checkpoints.
+     *
+     * Every this many ticks, the host sends a {@link PhysCheckpointEvent} with
+     * the obstacles held by clients. The state of the obstacles is already in
+     * the physics snapshots, so with the checkpoint every client knows enough
+     * to take over as host (see {@link #promote}). Ownership changes between
+     * checkpoints are tracked from the obstacle events.
+     *
+     * A value of 0 disables checkpoints. The default is 30 ticks.
+     *
+     * @param ticks The number of ticks between ownership checkpoints
+     */
+    void setCheckpointInterval(Uint32 ticks) { _checkpointInterval = ticks; }
+    
+    /**
+     * Records an ownership checkpoint if one is due at this tick.
+     *
+     * Only the host sends checkpoints. If one is due, it is added to the out
+     * events. This method is called automatically by the
+     * {@link NetEventController} each tick.
+     *
+     * @param tick  The game tick
+     */
+    void packCheckpoint(Uint64 tick);
+    
+    /**
+     * Processes an ownership checkpoint from the host.
+     *
+     * The checkpoint replaces the ownership table of this client.
+     */
+    void processCheckpointEvent(const std::shared_ptr<PhysCheckpointEvent>& event);
+    
+    /**
+     * Makes this client the host of the physics state.
+     *
+     * This is called by the {@link NetEventController} when this client is
+     * promoted during a host migration. The obstacles held by a client in the
+     * given set stay with that client. This client takes every other shared
+     * obstacle, starting from the latest state received for it. Any pending
+     * interpolation is skipped, so the new host simulates each obstacle from
+     * the tick it takes over, and there is no need to resynchronize.
+     *
+     * Snapshot baselines are reset, so the first snapshots of the new host
+     * are key snapshots.
+     *
+     * @param players   The UUIDs of the clients still in the game
+     */
+    void promote(const std::unordered_set<std::string>& players);
+    
+#pragma mark -
+#pragma mark Lag Compensation
+    /**
+     * Returns the number of ticks of past states kept for rewinding.
+     *
+     * A value of 0 (the default) disables the history. See {@link #rayCastAt}.
+     *
+     * @return the number of ticks of past states kept for rewinding.
+     */
+    Uint32 getRewindLength() const { return _rewindLength; }
+    
+    /**
+     * Sets the number of ticks of past states kept for rewinding.
+     *
+     * This should cover the largest round trip time that the game will
+     * compensate for, plus the interpolation delay of the clients. Every
+     * tick of history holds a state for every moving shared obstacle. A
+     * value of 0 (the default) disables the history. See {@link #rayCastAt}.
+     *
+     * @param ticks The number of ticks of past states kept for rewinding
+     */
+    void setRewindLength(Uint32 ticks) {
+        _rewindLength = ticks;
+        while (_rewindHistory.size() > _rewindLength) {
+            _rewindHistory.pop_front();
+        }
+    }
+    
+    /**
+     * Records the state of the moving shared obstacles at the given tick.
+     *
+     * This method is called automatically by the NetEventController on the
+     * host. It does nothing if the rewind history is disabled.
+     *
+     * @param tick  The current game tick
+     */
+    void recordRewind(Uint64 tick);
+    
+    /**
+     * Returns true if a ray hits an obstacle as it was at the given tick.
+     *
+     * This is for validating instant hits (such as hitscan weapons) on the
+     * host. A shot should be checked against where the targets were on the
+     * screen of the shooter, which is the tick that the shooter saw (its
+     * estimate of the host tick, minus its interpolation delay). The shooter
+     * should send this tick with the shot.
+     *
+     * The moving shared obstacles are tested at their recorded state at the
+     * given tick, without moving their bodies. Everything else (such as
+     * static walls) is tested where it is now with the live broadphase. A
+     * tick older than the history uses the oldest recorded tick, and a tick
+     * newer than the history uses the live world. Sensors are ignored.
+     *
+     * @param tick      The game tick to rewind to
+     * @param p1        The start of the ray (in physics coordinates)
+     * @param p2        The end of the ray (in physics coordinates)
+     * @param hit       The nearest hit, if any
+     * @param filter    Returns true for the obstacles that may be hit (optional)
+     * @param shard     The world to cast in
+     *
+     * @return true if a ray hits an obstacle as it was at the given tick.
+     */
+    bool rayCastAt(Uint64 tick, const Vec2& p1, const Vec2& p2, RewindHit& hit,
+                   std::function<bool(const physics2::Obstacle*)> filter=nullptr, Uint8 shard=0) const;
+    
+#pragma mark -
+#pragma mark Spectators
+    /**
+     * Returns the delayed snapshot for the spectators, if one is due.
+     *
+     * The snapshot is the recorded state of the moving shared obstacles at
+     * the given tick (or the latest tick before it) in the rewind history.
+     * So the history must be at least as long as the spectator delay. It is
+     * delta compressed against the previous spectator snapshot, and so must
+     * be sent on an ordered lane to every spectator. There is one snapshot
+     * for all of the spectators, no matter how many there are.
+     *
+     * This method returns nullptr if the history has no state at or before
+     * the given tick, or if that state was already sent.
+     *
+     * @param tick  The (delayed) game tick to show the spectators
+     *
+     * @return the delayed snapshot for the spectators, if one is due.
+     */
+    std::shared_ptr<PhysSyncEvent> packSpectatorSync(Uint64 tick);
+    
+    /**
+     * Restarts the spectator snapshots with a key snapshot.
+     *
+     * This must be called when a spectator joins, as it has none of the
+     * baselines of the earlier spectator snapshots.
+     */
+    void resetSpectatorSync() {
+        _spectatorHistory.clear();
+    }
+    
+#pragma mark -
+#pragma mark Joints
+    /**
+     * Adds a shared joint to the physics world, returning its id.
+     *
+     * Both bodies of the joint must belong to shared obstacles with global
+     * ids in the same world. The joint is created on every client with a
+     * {@link PhysJointEvent}. Only revolute, prismatic, distance, weld and
+     * wheel joints can be shared (see {@link PhysJointEvent#isSupported}).
+     *
+     * The tunable parameters of a shared joint (limits, motors and springs)
+     * may be changed directly on the joint. The changes are sent on the next
+     * call to {@link #fixedUpdate}.
+     *
+     * Obstacles connected by shared joints form a group, which is synced as
+     * a single unit with a {@link PhysGroupEvent} instead of with the other
+     * obstacles in FULL_SYNC and PRIO_SYNC snapshots. The root of the group
+     * has its full state, and the other members are relative to the root.
+     * Groups are synced by the owner of the root, and ignore peer views.
+     *
+     * @param def   The joint definition
+     *
+     * @return the id of the joint (or 0 if it could not be shared)
+     */
+    Uint64 addSharedJoint(const b2JointDef& def);
+    
+    /**
+     * Removes a shared joint from the physics world.
+     *
+     * The joint is removed on every client. Removing a body of the joint
+     * also removes the joint, so there is no need to call this method first.
+     *
+     * @param id    The id of the joint
+     */
+    void removeSharedJoint(Uint64 id);
+    
+    /**
+     * Returns true if the given joint is shared.
+     *
+     * @param id    The id of the joint
+     *
+     * @return true if the given joint is shared.
+     */
+    bool isSharedJoint(Uint64 id) const { return _joints.count(id) > 0; }
+    
+    /**
+     * Returns true if the given obstacle is in a group of jointed obstacles.
+     *
+     * @param obj   The obstacle to check
+     *
+     * @return true if the given obstacle is in a group of jointed obstacles.
+     */
+    bool isGrouped(const std::shared_ptr<physics2::Obstacle>& obj) const {
+        return obj->hasGlobalId() && _groupOf.count(obj->getGlobalId()) > 0;
+    }
+    
+    /**
+     * Processes a change to a shared joint from a peer.
+     *
+     * This method is called automatically by the NetEventController.
+     */
+    void processJointEvent(const std::shared_ptr<PhysJointEvent>& event);
+    
+    /**
+     * Processes a snapshot of groups of jointed obstacles from a peer.
+     *
+     * This method is called automatically by the NetEventController.
+     */
+    void processGroupEvent(const std::shared_ptr<PhysGroupEvent>& event);
+    
+#pragma mark -
+#pragma mark Late Join
+    /**
+     * Starts sending the world to a client that joined a game in progress.
+     *
+     * This replaces an OVERRIDE_FULL_SYNC followed by a creation event for
+     * every obstacle made by a factory, which is one large burst for every
+     * client. Instead, the shared obstacles are streamed to the new client in
+     * {@link PhysWorldEvent} chunks on the bulk lane. Each chunk has the state
+     * of its obstacles, and the factory parameters of those made by a factory.
+     *
+     * The obstacles in the given view (typically the area around the spawn
+     * point of the new client) are sent first, nearest first, all in the next
+     * tick. The client can start to simulate once they arrive (see
+     * {@link #setWorldFunc}). The rest of the world follows, also nearest
+     * first, at the transfer rate (see {@link #setWorldTransferRate}).
+     *
+     * Only the host can send the world. Sending it again to the same client
+     * starts the transfer over.
+     *
+     * @param uuid  The UUID of the new client
+     * @param view  The region to send first, in physics coordinates
+     */
+    void sendWorld(const std::string& uuid, const Rect& view);
+    
+    /**
+     * Stops sending the world to the given client.
+     *
+     * This should be called if the client leaves during the transfer. It does
+     * nothing if there is no transfer to that client.
+     *
+     * @param uuid  The UUID of the client
+     */
+    void cancelWorld(const std::string& uuid) { _transfers.erase(uuid); }
+    
+    /**
+     * Returns true if the world is still being sent to the given client.
+     *
+     * @param uuid  The UUID of the client
+     *
+     * @return true if the world is still being sent to the given client.
+     */
+    bool isSendingWorld(const std::string& uuid) const { return _transfers.count(uuid) > 0; }
+    
+    /**
+     * Returns the bytes of world transfer sent each tick after the near region.
+     *
+     * @return the bytes of world transfer sent each tick after the near region.
+     */
+    size_t getWorldTransferRate() const { return _transferRate; }
+    
+    /**
+     * Sets the bytes of world transfer sent each tick after the near region.
+     *
+     * This is the background rate of the transfer, per client. At least one
+     * chunk is sent every tick. A value of 0 sends the rest of the world at
+     * once, in the same tick as the near region. The default is 1024 bytes.
+     *
+     * @param rate  The bytes of world transfer sent each tick
+     */
+    void setWorldTransferRate(size_t rate) { _transferRate = rate; }
+    
+    /**
+     * Packs the world transfer chunks due this tick.
+     *
+     * Only the host sends chunks. They are added to the out events. This
+     * method is called automatically by the {@link NetEventController} each
+     * tick.
+     */
+    void packWorldTransfer();
+    
+    /**
+     * Processes a chunk of a world transfer from the host.
+     *
+     * Any obstacle this client does not have is made with its factory, and
+     * every obstacle is moved to its state in the chunk. Obstacles that are
+     * neither known nor made by a factory are ignored.
+     */
+    void processWorldEvent(const std::shared_ptr<PhysWorldEvent>& event);
+    
+    /**
+     * Returns the progress of the world transfer to this client.
+     *
+     * @return the progress of the world transfer to this client.
+     */
+    TransferState getTransferState() const { return (TransferState)_transferState; }
+    
+    /**
+     * Sets the function called when the world transfer to this client progresses.
+     *
+     * The function is called with false when the near region has arrived, at
+     * which point the game can start to simulate. It is called again with true
+     * when the whole world has arrived.
+     *
+     * @param func  The function called when the world transfer progresses
+     */
+    void setWorldFunc(std::function<void(bool)> func) { _worldFunc = func; }
+    
+#pragma mark -
+#pragma mark Interpolation
+    /**
+     * Returns the default interpolation method.
+     *
+     * @return the default interpolation method.
+     */
+    InterpolationMethod getInterpolationMethod() const {
+        return (InterpolationMethod)_itprMethod;
+    }
+    
+    /**
+     * Sets the default interpolation method.
+     *
+     * This method is used for every obstacle that does not have its own
+     * method (see {@link Obstacle#setInterpolation}). The default is
+     * LINEAR_INTERPOLATION. Any change takes effect at the next remote update
+     * of each obstacle.
+     *
+     * @param method    The default interpolation method
+     */
+    void setInterpolationMethod(InterpolationMethod method) {
+        _itprMethod = method == DEFAULT_INTERPOLATION ? LINEAR_INTERPOLATION : method;
+    }
+    
+    /**
+     * Returns the delay in ticks of buffered interpolation.
+     *
+     * @return the delay in ticks of buffered interpolation.
+     */
+    Uint32 getInterpolationDelay() const { return _itprDelay; }
+    
+    /**
+     * Sets the delay in ticks of buffered interpolation.
+     *
+     * Obstacles with BUFFERED_INTERPOLATION are shown this many (sender) ticks
+     * behind the newest snapshot. The delay should cover the interval between
+     * snapshots plus the jitter, or the obstacles will stall waiting for the
+     * next snapshot. The default is 6 ticks.
+     *
+     * @param ticks The delay in ticks of buffered interpolation
+     */
+    void setInterpolationDelay(Uint32 ticks) { _itprDelay = ticks; }
+    
+    /**
+     * Returns true if the given obstacle is being interpolated.
+     */
+    bool isInSync(std::shared_ptr<physics2::Obstacle> obj);
+
+    /**
+     * Adds an object to interpolate with the given target parameters.
+     * 
+     * @param obj The obstacle to interpolate
+     * @param param The target parameters for interpolation
+     */
+    void addSyncObject(std::shared_ptr<physics2::Obstacle> obj, std::shared_ptr<netphysics::targetParam> param);
+
+    /**
+     * Packs object dynamics data for synchronization and add it to _outEvents.
+     *
+     * This method can be used to prompt the physics controller to synchronize objects,
+     * It is called automatically, but additional calls to it can help fix potential desyncing.
+     *
+     * A FULL_SYNC is delta compressed against the latest snapshot acknowledged
+     * by every other client. Objects that have not changed since then (such as
+     * sleeping bodies) are not sent at all. The other types of synchronization
+     * always send the full state of every object.
+     *
+     * If any client has a view (see {@link #setPeerView}), a FULL_SYNC sends
+     * each client its own snapshot, limited to the objects in its view.
+     *
+     * @param type  the type of synchronization
+     */
+    void packPhysSync(SyncType type);
+
+    /**
+     * Packs any changed object information and add them to _outEvents.
+     *
+     * This method helps synchronize any method calls to the obstacles that set its properties.
+     * This includes explicit setPosition(), setVelocity(), setBodyType(), etc.
+     *
+     * Every obstacle with a dirty bit gets one record with the changed fields,
+     * and all of the records are sent in a single {@link PhysDeltaEvent}. No
+     * event is sent if nothing has changed. Only the obstacles in the dirty list
+     * of the world are visited, so the cost scales with the number of changed
+     * obstacles rather than the size of the world.
+     */
+    void packPhysObj();
+    
+    /**
+     * Processes a physics synchronization event.
+     *
+     * Delta snapshots are reconstructed against their baseline. If the baseline
+     * has not been received, the snapshot is ignored and the sender will fall
+     * back to a key snapshot once it sees our acknowledgements.
+     */
+    void processPhysSyncEvent(const std::shared_ptr<PhysSyncEvent>& event);
+    
+    /**
+     * Processes an input event from a client.
+     *
+     * The inputs are for the game to handle. This method only records the
+     * acknowledgements of the event, so that the snapshots sent to the client
+     * can be delta compressed.
+     */
+    void processPhysInputEvent(const std::shared_ptr<PhysInputEvent>& event);
+    
+    /**
+     * Returns a new input event for the given tick.
+     *
+     * The event includes the acknowledgements for the snapshots received from
+     * the other clients (typically the host), but no inputs.
+     *
+     * @param tick  The game tick of the input
+     *
+     * @return a new input event for the given tick.
+     */
+    std::shared_ptr<PhysInputEvent> allocInputEvent(Uint64 tick) const;
     
     /**
      * Updates the physics controller.
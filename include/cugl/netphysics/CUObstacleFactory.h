@@ -33,6 +33,7 @@
 #define __CU_OBSTACLE_FACTORY_H__
 
 #include <cugl/physics2/CUObstacle.h>
+#include <vector>
 
 namespace cugl {
 
@@ -87,6 +88,30 @@ public:
     virtual std::pair<std::shared_ptr<physics2::Obstacle>, std::shared_ptr<scene2::SceneNode>> createObstacle(const std::vector<std::byte>& params) {
         return std::make_pair(std::make_shared<physics2::Obstacle>(), std::make_shared<scene2::SceneNode>());
     }
+    
+    /**
+     * Creates several obstacles (and optionally scene nodes) from the same parameters.
+     *
+     * The obstacles are appended to result. This is used for batch creation
+     * (see {@link NetPhysicsController#addSharedObstacles}), where every obstacle
+     * shares the same parameters, and only differs in its position and angle.
+     * Those are set on each obstacle after this method returns.
+     *
+     * By default, this method calls {@link #createObstacle} for each obstacle.
+     * Override it to share work between the obstacles, such as parsing the
+     * parameters or building a shape, only once.
+     *
+     * @param params    The serialized parameters shared by the obstacles
+     * @param count     The number of obstacles to create
+     * @param result    The vector to store the created obstacles
+     */
+    virtual void createObstacles(const std::vector<std::byte>& params, size_t count,
+                                 std::vector<std::pair<std::shared_ptr<physics2::Obstacle>, std::shared_ptr<scene2::SceneNode>>>& result) {
+        result.reserve(result.size()+count);
+        for (size_t ii = 0; ii < count; ii++) {
+            result.push_back(createObstacle(params));
+        }
+    }
 };
 
     }
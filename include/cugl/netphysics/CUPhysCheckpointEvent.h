@@ -0,0 +1,233 @@
+//
+//  CUPhysCheckpointEvent.h
+//  Networked Physics Library
+//
+//  This class represents a checkpoint of the host's authority over the shared
+//  physics state. The host sends one every so often, so that any client can
+//  take over as host after a host migration without a full resynchronization.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_PHYS_CHECKPOINT_EVENT_H__
+#define __CU_PHYS_CHECKPOINT_EVENT_H__
+
+#include <cugl/netphysics/CUNetEvent.h>
+#include <cugl/netphysics/CULWBitSerializer.h>
+#include <SDL_stdinc.h>
+#include <algorithm>
+#include <string>
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+/**
+ * This class represents a checkpoint of the ownership of the shared obstacles.
+ *
+ * The state of every shared obstacle is already replicated by the physics
+ * snapshots. What only the host knows is who owns what: the host owns every
+ * obstacle that is not held by a client. A checkpoint lists the obstacles held
+ * by clients, together with their owners. Every other shared obstacle is owned
+ * by the host.
+ *
+ * The owners are stored once in a small table of UUIDs, and each obstacle only
+ * refers to its owner by index. The obstacle ids are sorted and delta encoded,
+ * so a checkpoint of a few dozen held obstacles takes a few hundred bytes.
+ *
+ * Checkpoint events are created by the {@link NetPhysicsController}. See
+ * {@link NetPhysicsController#setCheckpointInterval}.
+ */
+class PhysCheckpointEvent : public NetEvent {
+private:
+    /** The serializer for packing checkpoints into byte vectors. */
+    LWBitSerializer _serializer;
+    /** The deserializer for unpacking checkpoints from byte vectors. */
+    LWBitDeserializer _deserializer;
+protected:
+    /** The game tick of the checkpoint */
+    Uint64 _tick;
+    /** The UUIDs of the owners */
+    std::vector<std::string> _peers;
+    /** The held obstacles as (object id, owner index) pairs */
+    std::vector<std::pair<Uint64,Uint32>> _owners;
+
+public:
+    /**
+     * Constructs an empty checkpoint event.
+     */
+    PhysCheckpointEvent() : _tick(0) {}
+
+    /**
+     * Returns a newly allocated empty checkpoint event.
+     */
+    static std::shared_ptr<PhysCheckpointEvent> alloc() {
+        return std::make_shared<PhysCheckpointEvent>();
+    }
+
+    /**
+     * Initializes this event as an empty checkpoint at the given tick.
+     *
+     * @param tick  The game tick of the checkpoint
+     */
+    void init(Uint64 tick) {
+        _tick = tick;
+        _peers.clear();
+        _owners.clear();
+    }
+
+    /**
+     * Returns a newly allocated empty NetEvent
+     */
+    std::shared_ptr<NetEvent> newEvent() override {
+        return std::make_shared<PhysCheckpointEvent>();
+    }
+
+    /**
+     * Returns the game tick of the checkpoint.
+     *
+     * @return the game tick of the checkpoint.
+     */
+    Uint64 getTick() const {
+        return _tick;
+    }
+
+    /**
+     * Records that the given client holds the given obstacle.
+     *
+     * @param objId The global id of the obstacle
+     * @param owner The UUID of the client holding it
+     */
+    void addOwner(Uint64 objId, const std::string& owner) {
+        Uint32 index = 0;
+        while (index < _peers.size() && _peers[index] != owner) {
+            index++;
+        }
+        if (index == _peers.size()) {
+            _peers.push_back(owner);
+        }
+        _owners.push_back(std::make_pair(objId,index));
+    }
+
+    /**
+     * Returns the UUIDs of the owners in this checkpoint.
+     *
+     * @return the UUIDs of the owners in this checkpoint.
+     */
+    const std::vector<std::string>& getPeers() const {
+        return _peers;
+    }
+
+    /**
+     * Returns the held obstacles as (object id, owner index) pairs.
+     *
+     * The owner index is a position in {@link #getPeers}.
+     *
+     * @return the held obstacles as (object id, owner index) pairs.
+     */
+    const std::vector<std::pair<Uint64,Uint32>>& getOwners() const {
+        return _owners;
+    }
+
+    /**
+     * Resets this event so that it can be reused.
+     */
+    void reset() override {
+        NetEvent::reset();
+        _tick = 0;
+        _peers.clear();
+        _owners.clear();
+    }
+
+    /**
+     * Serializes all information in the event to a byte vector.
+     *
+     * The obstacles are sorted by id, and each id is written as its
+     * difference to the previous one.
+     */
+    std::vector<std::byte> serialize() override {
+        std::sort(_owners.begin(), _owners.end());
+        _serializer.reset();
+        _serializer.writeVarint(_tick);
+        _serializer.writeVarint((Uint64)_peers.size());
+        for (auto it = _peers.begin(); it != _peers.end(); it++) {
+            _serializer.writeVarint((Uint64)it->size());
+            for (auto jt = it->begin(); jt != it->end(); jt++) {
+                _serializer.writeBits((Uint32)(Uint8)(*jt), 8);
+            }
+        }
+        _serializer.writeVarint((Uint64)_owners.size());
+        Uint64 prev = 0;
+        for (auto it = _owners.begin(); it != _owners.end(); it++) {
+            _serializer.writeVarint(it->first-prev);
+            _serializer.writeVarint(it->second);
+            prev = it->first;
+        }
+        return _serializer.serialize();
+    }
+
+    /**
+     * This method unpacks all information from the byte vector
+     * and stores it in this event.
+     */
+    void deserialize(const std::vector<std::byte>& data) override {
+        if (data.empty())
+            return;
+
+        _deserializer.reset();
+        _deserializer.receive(data);
+        _tick = _deserializer.readVarint();
+        Uint64 numPeers = _deserializer.readVarint();
+        for (size_t ii = 0; ii < numPeers && !_deserializer.isExhausted(); ii++) {
+            Uint64 size = _deserializer.readVarint();
+            std::string peer;
+            for (size_t jj = 0; jj < size && !_deserializer.isExhausted(); jj++) {
+                peer.push_back((char)_deserializer.readBits(8));
+            }
+            if (!_deserializer.isExhausted()) {
+                _peers.push_back(std::move(peer));
+            }
+        }
+        Uint64 numOwners = _deserializer.readVarint();
+        Uint64 prev = 0;
+        for (size_t ii = 0; ii < numOwners && !_deserializer.isExhausted(); ii++) {
+            Uint64 objId = prev+_deserializer.readVarint();
+            Uint32 index = (Uint32)_deserializer.readVarint();
+            if (!_deserializer.isExhausted() && index < _peers.size()) {
+                _owners.push_back(std::make_pair(objId,index));
+            }
+            prev = objId;
+        }
+    }
+};
+
+    }
+}
+
+#endif /* __CU_PHYS_CHECKPOINT_EVENT_H__ */
@@ -0,0 +1,197 @@
+//
+//  CUPhysChecksumEvent.h
+//  Networked Physics Library
+//
+//  This class represents a checksum of the shared physics state of a client at
+//  a given tick. It is used by the NetPhysicsController to detect when clients
+//  drift apart, without sending the state itself.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_PHYS_CHECKSUM_EVENT_H__
+#define __CU_PHYS_CHECKSUM_EVENT_H__
+
+#include <cugl/netphysics/CUNetEvent.h>
+#include <cugl/netphysics/CULWBitSerializer.h>
+#include <SDL_stdinc.h>
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+/**
+ * This class represents a checksum of the shared physics state at a tick.
+ *
+ * The obstacles are split into buckets by global id, and the event holds one
+ * hash per bucket. Two clients agree on a bucket if they agree on every
+ * obstacle in it. Hence a mismatch narrows the divergence down to the
+ * obstacles of a few buckets, and the event stays small (four bytes per
+ * bucket).
+ *
+ * Checksum events are created by the {@link NetPhysicsController}. See
+ * {@link NetPhysicsController#setChecksumInterval}.
+ */
+class PhysChecksumEvent : public NetEvent {
+private:
+    /** The serializer for packing checksums into byte vectors. */
+    LWBitSerializer _serializer;
+    /** The deserializer for unpacking checksums from byte vectors. */
+    LWBitDeserializer _deserializer;
+protected:
+    /** The short UID of the sender */
+    Uint32 _sourceUID;
+    /** The tick of the checksum */
+    Uint64 _tick;
+    /** The hash of each bucket */
+    std::vector<Uint32> _buckets;
+
+public:
+    /**
+     * Constructs a checksum event with no buckets.
+     */
+    PhysChecksumEvent() : _sourceUID(0), _tick(0) {}
+
+    /**
+     * Returns a newly allocated checksum event with no buckets.
+     */
+    static std::shared_ptr<PhysChecksumEvent> alloc() {
+        return std::make_shared<PhysChecksumEvent>();
+    }
+
+    /**
+     * Returns a newly allocated checksum event with the given buckets.
+     *
+     * @param uid       The short UID of the sender
+     * @param tick      The game tick of the checksum
+     * @param buckets   The hash of each bucket
+     */
+    static std::shared_ptr<PhysChecksumEvent> alloc(Uint32 uid, Uint64 tick, const std::vector<Uint32>& buckets) {
+        auto result = std::make_shared<PhysChecksumEvent>();
+        result->init(uid,tick,buckets);
+        return result;
+    }
+
+    /**
+     * Initializes this event with the given buckets.
+     *
+     * @param uid       The short UID of the sender
+     * @param tick      The game tick of the checksum
+     * @param buckets   The hash of each bucket
+     */
+    void init(Uint32 uid, Uint64 tick, const std::vector<Uint32>& buckets) {
+        _sourceUID = uid;
+        _tick = tick;
+        _buckets.assign(buckets.begin(),buckets.end());
+    }
+
+    /**
+     * Returns a newly allocated empty NetEvent
+     */
+    std::shared_ptr<NetEvent> newEvent() override {
+        return std::make_shared<PhysChecksumEvent>();
+    }
+
+    /**
+     * Returns the short UID of the sender.
+     *
+     * @return the short UID of the sender.
+     */
+    Uint32 getSourceUID() const {
+        return _sourceUID;
+    }
+
+    /**
+     * Returns the game tick of the checksum.
+     *
+     * @return the game tick of the checksum.
+     */
+    Uint64 getTick() const {
+        return _tick;
+    }
+
+    /**
+     * Returns the hash of each bucket.
+     *
+     * @return the hash of each bucket.
+     */
+    const std::vector<Uint32>& getBuckets() const {
+        return _buckets;
+    }
+
+    /**
+     * Resets this event so that it can be reused.
+     */
+    void reset() override {
+        NetEvent::reset();
+        _sourceUID = 0;
+        _tick = 0;
+        _buckets.clear();
+    }
+
+    /**
+     * Serializes all information in the event to a byte vector.
+     */
+    std::vector<std::byte> serialize() override {
+        _serializer.reset();
+        _serializer.writeVarint(_sourceUID);
+        _serializer.writeVarint(_tick);
+        _serializer.writeVarint((Uint64)_buckets.size());
+        for (auto it = _buckets.begin(); it != _buckets.end(); it++) {
+            _serializer.writeBits(*it, 32);
+        }
+        return _serializer.serialize();
+    }
+
+    /**
+     * This method unpacks all information from the byte vector
+     * and stores it in this event.
+     */
+    void deserialize(const std::vector<std::byte>& data) override {
+        if (data.empty())
+            return;
+
+        _deserializer.reset();
+        _deserializer.receive(data);
+        _sourceUID = (Uint32)_deserializer.readVarint();
+        _tick = _deserializer.readVarint();
+        Uint64 count = _deserializer.readVarint();
+        for (size_t i = 0; i < count && !_deserializer.isExhausted(); i++) {
+            Uint32 hash = _deserializer.readBits(32);
+            if (!_deserializer.isExhausted()) {
+                _buckets.push_back(hash);
+            }
+        }
+    }
+};
+
+    }
+}
+
+#endif /* __CU_PHYS_CHECKSUM_EVENT_H__ */
@@ -0,0 +1,388 @@
+//
+//  CUPhysDeltaEvent.h
+//  Networked Physics Library
+//
+//  This class represents the changes made by the game to shared obstacles in
+//  a single tick. These are the changes recorded by the dirty bits of each
+//  Obstacle. Each changed obstacle has one record with a mask of the changed
+//  fields, followed only by those fields.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_PHYS_DELTA_EVENT_H__
+#define __CU_PHYS_DELTA_EVENT_H__
+
+#include <cugl/netphysics/CUNetEvent.h>
+#include <cugl/netphysics/CULWBitSerializer.h>
+#include <cugl/physics2/CUObstacle.h>
+#include <SDL_stdinc.h>
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+/**
+ * The struct for the changed fields of an obstacle.
+ *
+ * Only the fields in the mask are valid. The mask is a combination of the
+ * values of {@link PhysDeltaEvent#Field}.
+ */
+typedef struct {
+    /** The obstacle global id */
+    Uint64 objId;
+    /** The changed fields */
+    Uint8 fields;
+    /** The position (DELTA_POSITION) */
+    Vec2 pos;
+    /** The angle (DELTA_ANGLE) */
+    float angle;
+    /** The linear velocity (DELTA_VELOCITY) */
+    Vec2 vel;
+    /** The angular velocity (DELTA_ANGULAR) */
+    float angularVel;
+    /** The body type (DELTA_BODY_TYPE) */
+    b2BodyType bodyType;
+    /** The boolean constants as a bitmask of {@link PhysDeltaEvent#Flag} (DELTA_BOOL_CONSTS) */
+    Uint8 flags;
+    /** The density (DELTA_FLOAT_CONSTS) */
+    float density;
+    /** The friction (DELTA_FLOAT_CONSTS) */
+    float friction;
+    /** The restitution (DELTA_FLOAT_CONSTS) */
+    float restitution;
+    /** The linear damping (DELTA_FLOAT_CONSTS) */
+    float linearDamping;
+    /** The angular damping (DELTA_FLOAT_CONSTS) */
+    float angularDamping;
+    /** The gravity scale (DELTA_FLOAT_CONSTS) */
+    float gravityScale;
+    /** The mass (DELTA_FLOAT_CONSTS) */
+    float mass;
+    /** The rotational inertia (DELTA_FLOAT_CONSTS) */
+    float inertia;
+    /** The center of mass (DELTA_FLOAT_CONSTS) */
+    Vec2 centroid;
+} ObjDelta;
+
+/**
+ * This class represents the changes to shared obstacles made in one tick.
+ *
+ * When the game calls a setter on a shared obstacle, the obstacle marks the
+ * changed category with a dirty bit. Each tick, the {@link NetPhysicsController}
+ * gathers one record for every obstacle with a dirty bit, and sends all of
+ * the records in a single event. A record is the obstacle id, a mask of the
+ * changed fields, and then only those fields.
+ *
+ * These changes are set by the game, not the simulation, so they are sent
+ * at full precision on the reliable lane.
+ */
+class PhysDeltaEvent : public NetEvent {
+public:
+    /**
+     * The fields of a record.
+     *
+     * These values are combined as a bitmask to indicate which fields of a
+     * record have changed.
+     */
+    enum Field : Uint8 {
+        /** The position of the obstacle */
+        DELTA_POSITION     = 1,
+        /** The angle of the obstacle */
+        DELTA_ANGLE        = 2,
+        /** The linear velocity of the obstacle */
+        DELTA_VELOCITY     = 4,
+        /** The angular velocity of the obstacle */
+        DELTA_ANGULAR      = 8,
+        /** The body type of the obstacle */
+        DELTA_BODY_TYPE    = 16,
+        /** The boolean constants of the obstacle */
+        DELTA_BOOL_CONSTS  = 32,
+        /** The float constants of the obstacle */
+        DELTA_FLOAT_CONSTS = 64
+    };
+
+    /**
+     * The boolean constants of an obstacle.
+     *
+     * These values are combined as a bitmask in the flags of a record.
+     */
+    enum Flag : Uint8 {
+        /** Whether the obstacle is enabled */
+        FLAG_ENABLED          = 1,
+        /** Whether the obstacle is awake */
+        FLAG_AWAKE            = 2,
+        /** Whether the obstacle may sleep */
+        FLAG_SLEEPING_ALLOWED = 4,
+        /** Whether the obstacle has fixed rotation */
+        FLAG_FIXED_ROTATION   = 8,
+        /** Whether the obstacle is a bullet */
+        FLAG_BULLET           = 16,
+        /** Whether the obstacle is a sensor */
+        FLAG_SENSOR           = 32
+    };
+
+private:
+    /** The serializer for packing records into byte vectors. */
+    LWBitSerializer _serializer;
+    /** The deserializer for unpacking records from byte vectors. */
+    LWBitDeserializer _deserializer;
+protected:
+    /** The records of this event */
+    std::vector<ObjDelta> _records;
+
+public:
+    /**
+     * Constructs an event with no records.
+     */
+    PhysDeltaEvent() {}
+
+    /**
+     * Returns a newly allocated event with no records.
+     */
+    static std::shared_ptr<PhysDeltaEvent> alloc() {
+        return std::make_shared<PhysDeltaEvent>();
+    }
+
+    /**
+     * Returns a newly allocated empty NetEvent
+     */
+    std::shared_ptr<NetEvent> newEvent() override {
+        return std::make_shared<PhysDeltaEvent>();
+    }
+
+    /**
+     * Returns the changed fields of an obstacle, as recorded by its dirty bits.
+     *
+     * @param obj   The obstacle to check
+     *
+     * @return the changed fields of an obstacle (a bitmask of {@link Field})
+     */
+    static Uint8 getDirtyFields(const physics2::Obstacle& obj) {
+        Uint8 fields = 0;
+        if (obj.isPosDirty()) fields |= DELTA_POSITION;
+        if (obj.isAngleDirty()) fields |= DELTA_ANGLE;
+        if (obj.isVelDirty()) fields |= DELTA_VELOCITY;
+        if (obj.isAngVelDirty()) fields |= DELTA_ANGULAR;
+        if (obj.isTypeDirty()) fields |= DELTA_BODY_TYPE;
+        if (obj.isBoolConstDirty()) fields |= DELTA_BOOL_CONSTS;
+        if (obj.isFloatConstDirty()) fields |= DELTA_FLOAT_CONSTS;
+        return fields;
+    }
+
+    /**
+     * Adds a record for the given fields of an obstacle.
+     *
+     * The fields are read from the obstacle now. If the mask is 0, no record
+     * is added.
+     *
+     * @param obj       The obstacle
+     * @param id        The global id of the obstacle
+     * @param fields    The fields to record (a bitmask of {@link Field})
+     */
+    void addObj(const physics2::Obstacle& obj, Uint64 id, Uint8 fields) {
+        if (fields == 0) {
+            return;
+        }
+        ObjDelta record;
+        record.objId = id;
+        record.fields = fields;
+        if (fields & DELTA_POSITION) {
+            record.pos = obj.getPosition();
+        }
+        if (fields & DELTA_ANGLE) {
+            record.angle = obj.getAngle();
+        }
+        if (fields & DELTA_VELOCITY) {
+            record.vel = obj.getLinearVelocity();
+        }
+        if (fields & DELTA_ANGULAR) {
+            record.angularVel = obj.getAngularVelocity();
+        }
+        if (fields & DELTA_BODY_TYPE) {
+            record.bodyType = obj.getBodyType();
+        }
+        if (fields & DELTA_BOOL_CONSTS) {
+            record.flags = 0;
+            if (obj.isEnabled()) record.flags |= FLAG_ENABLED;
+            if (obj.isAwake()) record.flags |= FLAG_AWAKE;
+            if (obj.isSleepingAllowed()) record.flags |= FLAG_SLEEPING_ALLOWED;
+            if (obj.isFixedRotation()) record.flags |= FLAG_FIXED_ROTATION;
+            if (obj.isBullet()) record.flags |= FLAG_BULLET;
+            if (obj.isSensor()) record.flags |= FLAG_SENSOR;
+        }
+        if (fields & DELTA_FLOAT_CONSTS) {
+            record.density = obj.getDensity();
+            record.friction = obj.getFriction();
+            record.restitution = obj.getRestitution();
+            record.linearDamping = obj.getLinearDamping();
+            record.angularDamping = obj.getAngularDamping();
+            record.gravityScale = obj.getGravityScale();
+            record.mass = obj.getMass();
+            record.inertia = obj.getInertia();
+            record.centroid = obj.getCentroid();
+        }
+        _records.push_back(record);
+    }
+
+    /**
+     * Returns true if this event has no records.
+     *
+     * @return true if this event has no records.
+     */
+    bool isEmpty() const {
+        return _records.empty();
+    }
+
+    /**
+     * Returns the records of this event.
+     *
+     * @return the records of this event.
+     */
+    const std::vector<ObjDelta>& getRecords() const {
+        return _records;
+    }
+
+    /**
+     * Resets this event so that it can be reused.
+     */
+    void reset() override {
+        NetEvent::reset();
+        _records.clear();
+    }
+
+    /**
+     * Serializes all information in the event to a byte vector.
+     *
+     * Object ids are written as a (shortUID,counter) pair of variable length
+     * integers, followed by the 7 bit field mask. Floats are written at full
+     * precision, the body type in 2 bits, and the boolean constants in 6 bits.
+     */
+    std::vector<std::byte> serialize() override {
+        _serializer.reset();
+        _serializer.writeVarint((Uint64)_records.size());
+        for (auto it = _records.begin(); it != _records.end(); ++it) {
+            _serializer.writeVarint(it->objId >> 32);
+            _serializer.writeVarint(it->objId & 0xFFFFFFFF);
+            _serializer.writeBits(it->fields, 7);
+            if (it->fields & DELTA_POSITION) {
+                _serializer.writeFloat(it->pos.x);
+                _serializer.writeFloat(it->pos.y);
+            }
+            if (it->fields & DELTA_ANGLE) {
+                _serializer.writeFloat(it->angle);
+            }
+            if (it->fields & DELTA_VELOCITY) {
+                _serializer.writeFloat(it->vel.x);
+                _serializer.writeFloat(it->vel.y);
+            }
+            if (it->fields & DELTA_ANGULAR) {
+                _serializer.writeFloat(it->angularVel);
+            }
+            if (it->fields & DELTA_BODY_TYPE) {
+                _serializer.writeBits((Uint32)it->bodyType, 2);
+            }
+            if (it->fields & DELTA_BOOL_CONSTS) {
+                _serializer.writeBits(it->flags, 6);
+            }
+            if (it->fields & DELTA_FLOAT_CONSTS) {
+                _serializer.writeFloat(it->density);
+                _serializer.writeFloat(it->friction);
+                _serializer.writeFloat(it->restitution);
+                _serializer.writeFloat(it->linearDamping);
+                _serializer.writeFloat(it->angularDamping);
+                _serializer.writeFloat(it->gravityScale);
+                _serializer.writeFloat(it->mass);
+                _serializer.writeFloat(it->inertia);
+                _serializer.writeFloat(it->centroid.x);
+                _serializer.writeFloat(it->centroid.y);
+            }
+        }
+        return _serializer.serialize();
+    }
+
+    /**
+     * This method unpacks all information from the byte vector
+     * and stores it in this event.
+     */
+    void deserialize(const std::vector<std::byte>& data) override {
+        if (data.empty())
+            return;
+
+        _deserializer.reset();
+        _deserializer.receive(data);
+        Uint64 count = _deserializer.readVarint();
+        for (size_t ii = 0; ii < count && !_deserializer.isExhausted(); ii++) {
+            ObjDelta record;
+            Uint64 uid = _deserializer.readVarint();
+            record.objId = (uid << 32) | _deserializer.readVarint();
+            record.fields = (Uint8)_deserializer.readBits(7);
+            if (record.fields & DELTA_POSITION) {
+                record.pos.x = _deserializer.readFloat();
+                record.pos.y = _deserializer.readFloat();
+            }
+            if (record.fields & DELTA_ANGLE) {
+                record.angle = _deserializer.readFloat();
+            }
+            if (record.fields & DELTA_VELOCITY) {
+                record.vel.x = _deserializer.readFloat();
+                record.vel.y = _deserializer.readFloat();
+            }
+            if (record.fields & DELTA_ANGULAR) {
+                record.angularVel = _deserializer.readFloat();
+            }
+            if (record.fields & DELTA_BODY_TYPE) {
+                record.bodyType = (b2BodyType)_deserializer.readBits(2);
+            }
+            if (record.fields & DELTA_BOOL_CONSTS) {
+                record.flags = (Uint8)_deserializer.readBits(6);
+            }
+            if (record.fields & DELTA_FLOAT_CONSTS) {
+                record.density = _deserializer.readFloat();
+                record.friction = _deserializer.readFloat();
+                record.restitution = _deserializer.readFloat();
+                record.linearDamping = _deserializer.readFloat();
+                record.angularDamping = _deserializer.readFloat();
+                record.gravityScale = _deserializer.readFloat();
+                record.mass = _deserializer.readFloat();
+                record.inertia = _deserializer.readFloat();
+                record.centroid.x = _deserializer.readFloat();
+                record.centroid.y = _deserializer.readFloat();
+            }
+            if (!_deserializer.isExhausted()) {
+                _records.push_back(record);
+            }
+        }
+    }
+};
+
+    }
+}
+
+#endif /* __CU_PHYS_DELTA_EVENT_H__ */
@@ -0,0 +1,291 @@
+//
+//  CUPhysGroupEvent.h
+//  Networked Physics Library
+//
+//  This class represents a snapshot of groups of jointed obstacles. Each
+//  group is sent as a single unit: the root of the group has its full state,
+//  and every other member is sent relative to the root. The joints keep these
+//  relative transforms small, so they quantize to far fewer bits than
+//  absolute states.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_PHYS_GROUP_EVENT_H__
+#define __CU_PHYS_GROUP_EVENT_H__
+
+#include <cugl/netphysics/CUNetEvent.h>
+#include <cugl/netphysics/CUPhysSyncEvent.h>
+#include <cugl/netphysics/CULWBitSerializer.h>
+#include <SDL_stdinc.h>
+#include <cmath>
+#include <vector>
+
+/** The largest offset of a member from the root of its group (in world units) */
+#define GROUP_POS_RANGE     8.0f
+/** The number of bits for an offset from the root */
+#define GROUP_POS_BITS      14
+/** The largest velocity of a member relative to the root of its group */
+#define GROUP_VEL_RANGE     32.0f
+/** The number of bits for a velocity relative to the root */
+#define GROUP_VEL_BITS      10
+/** The number of bits for an angle relative to the root */
+#define GROUP_ANGLE_BITS    12
+/** The estimated size of a relative member in bytes */
+#define GROUP_MEMBER_BYTES  10
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+/**
+ * This class represents a snapshot of groups of jointed obstacles.
+ *
+ * A group is a set of obstacles connected by shared joints, such as a
+ * ragdoll or a vehicle. The root of a group is sent with its full state. The
+ * position and velocity of every other member is sent in the frame of the
+ * root, and its angle relative to the angle of the root. These are quantized
+ * to a fixed range (see {@link GROUP_POS_RANGE} and {@link GROUP_VEL_RANGE}).
+ * A member outside of this range (because of a long chain, for example) is
+ * sent with its full state instead.
+ *
+ * The states in this event are always absolute. The conversion to and from
+ * relative transforms happens on serialization.
+ *
+ * Group events are created by the {@link NetPhysicsController}. See
+ * {@link NetPhysicsController#addSharedJoint}.
+ */
+class PhysGroupEvent : public NetEvent {
+public:
+    /** A single group in the snapshot */
+    struct Group {
+        /** The state of the root */
+        ObjParam root;
+        /** The states of the other members */
+        std::vector<ObjParam> members;
+    };
+
+private:
+    /** The serializer for packing groups into byte vectors. */
+    LWBitSerializer _serializer;
+    /** The deserializer for unpacking groups from byte vectors. */
+    LWBitDeserializer _deserializer;
+
+protected:
+    /** The groups in this snapshot */
+    std::vector<Group> _groups;
+
+    /**
+     * Writes the full state of an obstacle.
+     *
+     * @param param The obstacle state
+     */
+    void writeFull(const ObjParam& param) {
+        _serializer.writeFloat(param.x);
+        _serializer.writeFloat(param.y);
+        _serializer.writeFloat(param.vx);
+        _serializer.writeFloat(param.vy);
+        _serializer.writeFloat(param.angle);
+        _serializer.writeFloat(param.vAngular);
+    }
+
+    /**
+     * Reads the full state of an obstacle.
+     *
+     * @param param The obstacle state to read into
+     */
+    void readFull(ObjParam& param) {
+        param.x = _deserializer.readFloat();
+        param.y = _deserializer.readFloat();
+        param.vx = _deserializer.readFloat();
+        param.vy = _deserializer.readFloat();
+        param.angle = _deserializer.readFloat();
+        param.vAngular = _deserializer.readFloat();
+    }
+
+public:
+    /**
+     * Constructs an empty group event.
+     */
+    PhysGroupEvent() {}
+
+    /**
+     * Returns a newly allocated empty group event.
+     */
+    static std::shared_ptr<PhysGroupEvent> alloc() {
+        return std::make_shared<PhysGroupEvent>();
+    }
+
+    /**
+     * Returns a newly allocated empty NetEvent
+     */
+    std::shared_ptr<NetEvent> newEvent() override {
+        return std::make_shared<PhysGroupEvent>();
+    }
+
+    /**
+     * Adds a group to this snapshot.
+     *
+     * @param root      The state of the root
+     * @param members   The states of the other members
+     */
+    void addGroup(const ObjParam& root, const std::vector<ObjParam>& members) {
+        _groups.push_back({root,members});
+    }
+
+    /**
+     * Returns the groups in this snapshot.
+     *
+     * @return the groups in this snapshot.
+     */
+    const std::vector<Group>& getGroups() const { return _groups; }
+
+    /**
+     * Returns true if this snapshot has no groups.
+     *
+     * @return true if this snapshot has no groups.
+     */
+    bool isEmpty() const { return _groups.empty(); }
+
+    /**
+     * Resets this event so that it can be reused.
+     */
+    void reset() override {
+        NetEvent::reset();
+        _groups.clear();
+    }
+
+    /**
+     * Serializes all information in the event to a byte vector.
+     *
+     * Member ids are written relative to the root, as the members of a
+     * group are usually created together.
+     */
+    std::vector<std::byte> serialize() override {
+        _serializer.reset();
+        _serializer.writeVarint((Uint64)_groups.size());
+        for (auto it = _groups.begin(); it != _groups.end(); ++it) {
+            const ObjParam& root = it->root;
+            _serializer.writeVarint(root.objId);
+            writeFull(root);
+
+            float c = std::cos(root.angle);
+            float s = std::sin(root.angle);
+            _serializer.writeVarint((Uint64)it->members.size());
+            for (auto jt = it->members.begin(); jt != it->members.end(); ++jt) {
+                const ObjParam& member = *jt;
+                Sint64 delta = (Sint64)(member.objId-root.objId);
+                _serializer.writeVarint((Uint64)((delta << 1) ^ (delta >> 63)));
+
+                // Move into the frame of the root
+                float dx = member.x-root.x;
+                float dy = member.y-root.y;
+                float dvx = member.vx-root.vx;
+                float dvy = member.vy-root.vy;
+                float px =  c*dx+s*dy;
+                float py = -s*dx+c*dy;
+                float vx =  c*dvx+s*dvy;
+                float vy = -s*dvx+c*dvy;
+                float va = member.vAngular-root.vAngular;
+                bool far = (std::fabs(px) > GROUP_POS_RANGE || std::fabs(py) > GROUP_POS_RANGE ||
+                            std::fabs(vx) > GROUP_VEL_RANGE || std::fabs(vy) > GROUP_VEL_RANGE ||
+                            std::fabs(va) > GROUP_VEL_RANGE);
+                _serializer.writeBool(far);
+                if (far) {
+                    writeFull(member);
+                } else {
+                    _serializer.writeQuantized(px, -GROUP_POS_RANGE, GROUP_POS_RANGE, GROUP_POS_BITS);
+                    _serializer.writeQuantized(py, -GROUP_POS_RANGE, GROUP_POS_RANGE, GROUP_POS_BITS);
+                    _serializer.writeQuantized(vx, -GROUP_VEL_RANGE, GROUP_VEL_RANGE, GROUP_VEL_BITS);
+                    _serializer.writeQuantized(vy, -GROUP_VEL_RANGE, GROUP_VEL_RANGE, GROUP_VEL_BITS);
+                    _serializer.writeAngle(member.angle-root.angle, GROUP_ANGLE_BITS);
+                    _serializer.writeQuantized(va, -GROUP_VEL_RANGE, GROUP_VEL_RANGE, GROUP_VEL_BITS);
+                }
+            }
+        }
+        return _serializer.serialize();
+    }
+
+    /**
+     * This method unpacks all information from the byte vector
+     * and stores it in this event.
+     */
+    void deserialize(const std::vector<std::byte>& data) override {
+        if (data.empty())
+            return;
+
+        _deserializer.reset();
+        _deserializer.receive(data);
+        Uint64 count = _deserializer.readVarint();
+        for (size_t ii = 0; ii < count && !_deserializer.isExhausted(); ii++) {
+            Group group;
+            group.root.objId = _deserializer.readVarint();
+            readFull(group.root);
+
+            const ObjParam& root = group.root;
+            float c = std::cos(root.angle);
+            float s = std::sin(root.angle);
+            Uint64 size = _deserializer.readVarint();
+            for (size_t jj = 0; jj < size && !_deserializer.isExhausted(); jj++) {
+                ObjParam member;
+                Uint64 zigzag = _deserializer.readVarint();
+                member.objId = root.objId+(Uint64)((Sint64)(zigzag >> 1) ^ -(Sint64)(zigzag & 1));
+                if (_deserializer.readBool()) {
+                    readFull(member);
+                } else {
+                    float px = _deserializer.readQuantized(-GROUP_POS_RANGE, GROUP_POS_RANGE, GROUP_POS_BITS);
+                    float py = _deserializer.readQuantized(-GROUP_POS_RANGE, GROUP_POS_RANGE, GROUP_POS_BITS);
+                    float vx = _deserializer.readQuantized(-GROUP_VEL_RANGE, GROUP_VEL_RANGE, GROUP_VEL_BITS);
+                    float vy = _deserializer.readQuantized(-GROUP_VEL_RANGE, GROUP_VEL_RANGE, GROUP_VEL_BITS);
+                    float angle = _deserializer.readAngle(GROUP_ANGLE_BITS);
+                    float va = _deserializer.readQuantized(-GROUP_VEL_RANGE, GROUP_VEL_RANGE, GROUP_VEL_BITS);
+
+                    // Move out of the frame of the root
+                    member.x = root.x+c*px-s*py;
+                    member.y = root.y+s*px+c*py;
+                    member.vx = root.vx+c*vx-s*vy;
+                    member.vy = root.vy+s*vx+c*vy;
+                    member.angle = root.angle+angle;
+                    member.vAngular = root.vAngular+va;
+                }
+                if (!_deserializer.isExhausted()) {
+                    group.members.push_back(member);
+                }
+            }
+            if (!_deserializer.isExhausted()) {
+                _groups.push_back(std::move(group));
+            }
+        }
+    }
+};
+
+    }
+}
+
+#endif /* __CU_PHYS_GROUP_EVENT_H__ */
@@ -0,0 +1,278 @@
+//
+//  CUPhysInputEvent.h
+//  Networked Physics Library
+//
+//  This class represents the input commands of a client. It is used by the
+//  host-authoritative mode of the NetEventController, where clients do not
+//  send any physics state. Instead, they send their input to the host every
+//  tick, together with the acknowledgements for the host snapshots.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_PHYS_INPUT_EVENT_H__
+#define __CU_PHYS_INPUT_EVENT_H__
+
+#include <cugl/netphysics/CUNetEvent.h>
+#include <cugl/netphysics/CULWBitSerializer.h>
+#include <SDL_stdinc.h>
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+/**
+ * This class represents the input commands of a client for a range of ticks.
+ *
+ * Inputs are opaque byte vectors supplied by the game. Input events are sent
+ * on the unreliable lane, so each event repeats the inputs of the last few
+ * ticks. The inputs are stored oldest first, and the last input is the one
+ * for {@link #getTick}.
+ *
+ * When the host receives an input event, the {@link NetEventController} splits
+ * it into one event per new tick. Hence every input event popped by the game
+ * has exactly one input.
+ *
+ * Every event also carries acknowledgements for the physics snapshots that its
+ * sender has received, just like a {@link PhysSyncEvent}.
+ */
+class PhysInputEvent : public NetEvent {
+private:
+    /** The serializer for packing inputs into byte vectors. */
+    LWBitSerializer _serializer;
+    /** The deserializer for unpacking inputs from byte vectors. */
+    LWBitDeserializer _deserializer;
+protected:
+    /** The short UID of the sender */
+    Uint32 _sourceUID;
+    /** The tick of the most recent input */
+    Uint64 _tick;
+    /** The acknowledged snapshots as (shortUID,sequence) pairs */
+    std::vector<std::pair<Uint32,Uint32>> _acks;
+    /** The inputs, oldest first */
+    std::vector<std::vector<std::byte>> _inputs;
+
+public:
+    /**
+     * Constructs an input event with no inputs.
+     */
+    PhysInputEvent() : _sourceUID(0), _tick(0) {}
+
+    /**
+     * Returns a newly allocated input event with no inputs.
+     */
+    static std::shared_ptr<PhysInputEvent> alloc() {
+        return std::make_shared<PhysInputEvent>();
+    }
+
+    /**
+     * Returns a newly allocated input event with the given input.
+     *
+     * @param tick  The game tick of the input
+     * @param input The input commands
+     */
+    static std::shared_ptr<PhysInputEvent> alloc(Uint64 tick, const std::vector<std::byte>& input) {
+        auto result = std::make_shared<PhysInputEvent>();
+        result->_tick = tick;
+        result->_inputs.push_back(input);
+        return result;
+    }
+
+    /**
+     * Returns a newly allocated empty NetEvent
+     */
+    std::shared_ptr<NetEvent> newEvent() override {
+        return std::make_shared<PhysInputEvent>();
+    }
+
+    /**
+     * Returns the short UID of the sender.
+     *
+     * @return the short UID of the sender.
+     */
+    Uint32 getSourceUID() const {
+        return _sourceUID;
+    }
+
+    /**
+     * Sets the short UID of the sender.
+     *
+     * @param uid   The short UID of the sender
+     */
+    void setSourceUID(Uint32 uid) {
+        _sourceUID = uid;
+    }
+
+    /**
+     * Returns the game tick of the most recent input.
+     *
+     * @return the game tick of the most recent input.
+     */
+    Uint64 getTick() const {
+        return _tick;
+    }
+
+    /**
+     * Sets the game tick of the most recent input.
+     *
+     * @param tick  The game tick of the most recent input
+     */
+    void setTick(Uint64 tick) {
+        _tick = tick;
+    }
+
+    /**
+     * Appends an input to this event.
+     *
+     * The inputs must be added oldest first, one per tick, and the last one
+     * must be the input for {@link #getTick}.
+     *
+     * @param input The input commands
+     */
+    void addInput(const std::vector<std::byte>& input) {
+        _inputs.push_back(input);
+    }
+
+    /**
+     * Returns the inputs of this event, oldest first.
+     *
+     * The last input is the one for {@link #getTick}, and each earlier input
+     * is for the tick before.
+     *
+     * @return the inputs of this event, oldest first.
+     */
+    const std::vector<std::vector<std::byte>>& getInputs() const {
+        return _inputs;
+    }
+
+    /**
+     * Returns the most recent input of this event.
+     *
+     * If there are no inputs, this method returns an empty vector.
+     *
+     * @return the most recent input of this event.
+     */
+    const std::vector<std::byte>& getInput() const {
+        static const std::vector<std::byte> none;
+        return _inputs.empty() ? none : _inputs.back();
+    }
+
+    /**
+     * Records that the sender has received the given snapshot.
+     *
+     * @param uid       The short UID of the snapshot sender
+     * @param sequence  The sequence number of the latest snapshot received
+     */
+    void addAck(Uint32 uid, Uint32 sequence) {
+        _acks.push_back(std::make_pair(uid,sequence));
+    }
+
+    /**
+     * Returns the acknowledgements sent with this event.
+     *
+     * See {@link PhysSyncEvent#getAcks}.
+     *
+     * @return the acknowledgements sent with this event.
+     */
+    const std::vector<std::pair<Uint32,Uint32>>& getAcks() const {
+        return _acks;
+    }
+
+    /**
+     * Resets this event so that it can be reused.
+     */
+    void reset() override {
+        NetEvent::reset();
+        _sourceUID = 0;
+        _tick = 0;
+        _acks.clear();
+        _inputs.clear();
+    }
+
+    /**
+     * Serializes all information in the event to a byte vector.
+     *
+     * All integers are variable length, and the input bytes are copied as is.
+     * An event with one short input thus only takes a handful of bytes.
+     */
+    std::vector<std::byte> serialize() override {
+        _serializer.reset();
+        _serializer.writeVarint(_sourceUID);
+        _serializer.writeVarint(_tick);
+        _serializer.writeVarint((Uint64)_acks.size());
+        for (auto it = _acks.begin(); it != _acks.end(); it++) {
+            _serializer.writeVarint(it->first);
+            _serializer.writeVarint(it->second);
+        }
+        _serializer.writeVarint((Uint64)_inputs.size());
+        for (auto it = _inputs.begin(); it != _inputs.end(); it++) {
+            _serializer.writeVarint((Uint64)it->size());
+            for (auto jt = it->begin(); jt != it->end(); jt++) {
+                _serializer.writeBits((Uint32)(*jt), 8);
+            }
+        }
+        return _serializer.serialize();
+    }
+
+    /**
+     * This method unpacks all information from the byte vector
+     * and stores it in this event.
+     */
+    void deserialize(const std::vector<std::byte>& data) override {
+        if (data.empty())
+            return;
+
+        _deserializer.reset();
+        _deserializer.receive(data);
+        _sourceUID = (Uint32)_deserializer.readVarint();
+        _tick = _deserializer.readVarint();
+        Uint64 numAcks = _deserializer.readVarint();
+        for (size_t i = 0; i < numAcks && !_deserializer.isExhausted(); i++) {
+            Uint32 uid = (Uint32)_deserializer.readVarint();
+            Uint32 seq = (Uint32)_deserializer.readVarint();
+            _acks.push_back(std::make_pair(uid,seq));
+        }
+        Uint64 numInputs = _deserializer.readVarint();
+        for (size_t i = 0; i < numInputs && !_deserializer.isExhausted(); i++) {
+            Uint64 size = _deserializer.readVarint();
+            std::vector<std::byte> input;
+            for (size_t j = 0; j < size && !_deserializer.isExhausted(); j++) {
+                input.push_back((std::byte)_deserializer.readBits(8));
+            }
+            if (!_deserializer.isExhausted()) {
+                _inputs.push_back(std::move(input));
+            }
+        }
+    }
+};
+
+    }
+}
+
+#endif /* __CU_PHYS_INPUT_EVENT_H__ */
@@ -0,0 +1,570 @@
+//
+//  CUPhysJointEvent.h
+//  Networked Physics Library
+//
+//  This class represents a change to a shared joint: its creation, its
+//  destruction, or a change to one of its tunable parameters (such as the
+//  speed of a motor). Only the fields that matter to the type of the joint
+//  are sent, so these events are small.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_PHYS_JOINT_EVENT_H__
+#define __CU_PHYS_JOINT_EVENT_H__
+
+#include <cugl/netphysics/CUNetEvent.h>
+#include <cugl/netphysics/CULWBitSerializer.h>
+#include <cugl/physics2/CUObstacle.h>
+#include <box2d/b2_distance_joint.h>
+#include <box2d/b2_prismatic_joint.h>
+#include <box2d/b2_revolute_joint.h>
+#include <box2d/b2_weld_joint.h>
+#include <box2d/b2_wheel_joint.h>
+#include <SDL_stdinc.h>
+
+/** The number of bits for the type of a joint */
+#define JOINT_TYPE_BITS 4
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+/**
+ * The struct for the definition of a shared joint.
+ *
+ * This struct covers the revolute, prismatic, distance, weld and wheel
+ * joints, which are the joints that connect two bodies in a game. Fields
+ * that do not apply to the type of a joint are ignored. The bodies are
+ * identified by the global ids of their obstacles.
+ *
+ * The anchors, axis and reference angle are fixed when the joint is made.
+ * The remaining fields are tunable, and are resent whenever they change.
+ */
+typedef struct {
+    /** The type of the joint */
+    b2JointType type;
+    /** The global id of the obstacle of the first body */
+    Uint64 bodyA;
+    /** The global id of the obstacle of the second body */
+    Uint64 bodyB;
+    /** Whether the two bodies may collide with each other */
+    bool collide;
+    /** The anchor relative to the first body */
+    b2Vec2 anchorA;
+    /** The anchor relative to the second body */
+    b2Vec2 anchorB;
+    /** The axis relative to the first body (prismatic and wheel) */
+    b2Vec2 axis;
+    /** The reference angle (revolute, prismatic and weld) */
+    float reference;
+    /** Whether the limits are enabled (revolute, prismatic and wheel) */
+    bool enableLimit;
+    /** Whether the motor is enabled (revolute, prismatic and wheel) */
+    bool enableMotor;
+    /** The lower limit (or the minimum length of a distance joint) */
+    float lower;
+    /** The upper limit (or the maximum length of a distance joint) */
+    float upper;
+    /** The speed of the motor */
+    float motorSpeed;
+    /** The maximum torque (or force for a prismatic joint) of the motor */
+    float maxMotor;
+    /** The rest length (distance) */
+    float length;
+    /** The stiffness of the spring (distance, weld and wheel) */
+    float stiffness;
+    /** The damping of the spring (distance, weld and wheel) */
+    float damping;
+} JointParam;
+
+/**
+ * This class represents a change to a shared joint.
+ *
+ * Joint events are created by the {@link NetPhysicsController} when a shared
+ * joint is added or removed, and when a tunable parameter of a shared joint
+ * changes. See {@link NetPhysicsController#addSharedJoint}. They must be
+ * sent on a reliable lane, after the creation of the obstacles they join.
+ */
+class PhysJointEvent : public NetEvent {
+public:
+    /** Enum for the type of the event. */
+    enum Type
+    {
+        JOINT_CREATION,
+        JOINT_DELETION,
+        JOINT_PARAMS
+    };
+
+private:
+    /** The serializer for packing joints into byte vectors. */
+    LWBitSerializer _serializer;
+    /** The deserializer for unpacking joints from byte vectors. */
+    LWBitDeserializer _deserializer;
+
+protected:
+    /** The type of the event. */
+    Type _type;
+    /** The joint id. */
+    Uint64 _jointId;
+    /** The joint definition (JOINT_CREATION and JOINT_PARAMS) */
+    JointParam _param;
+
+public:
+    /**
+     * Constructs an empty joint event.
+     */
+    PhysJointEvent() : _type(JOINT_CREATION), _jointId(0), _param() {}
+
+    /**
+     * Returns a newly allocated empty joint event.
+     */
+    static std::shared_ptr<PhysJointEvent> alloc() {
+        return std::make_shared<PhysJointEvent>();
+    }
+
+    /**
+     * Returns a newly allocated empty NetEvent
+     */
+    std::shared_ptr<NetEvent> newEvent() override {
+        return std::make_shared<PhysJointEvent>();
+    }
+
+    /**
+     * Returns true if the joint type can be shared.
+     *
+     * @param type  The joint type
+     *
+     * @return true if the joint type can be shared.
+     */
+    static bool isSupported(b2JointType type) {
+        switch (type) {
+            case e_revoluteJoint:
+            case e_prismaticJoint:
+            case e_distanceJoint:
+            case e_weldJoint:
+            case e_wheelJoint:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * Returns true if the definition of the joint was captured.
+     *
+     * This fails if the joint type is not supported, or if either body does
+     * not belong to an obstacle with a global id.
+     *
+     * @param joint The joint to capture
+     * @param param The definition to store the joint in
+     *
+     * @return true if the definition of the joint was captured.
+     */
+    static bool capture(b2Joint* joint, JointParam& param) {
+        if (joint == nullptr || !isSupported(joint->GetType())) {
+            return false;
+        }
+        physics2::Obstacle* objA = reinterpret_cast<physics2::Obstacle*>(joint->GetBodyA()->GetUserData().pointer);
+        physics2::Obstacle* objB = reinterpret_cast<physics2::Obstacle*>(joint->GetBodyB()->GetUserData().pointer);
+        if (objA == nullptr || objB == nullptr || !objA->hasGlobalId() || !objB->hasGlobalId()) {
+            return false;
+        }
+
+        param = JointParam();
+        param.type  = joint->GetType();
+        param.bodyA = objA->getGlobalId();
+        param.bodyB = objB->getGlobalId();
+        param.collide = joint->GetCollideConnected();
+        switch (param.type) {
+            case e_revoluteJoint:
+            {
+                b2RevoluteJoint* revolute = (b2RevoluteJoint*)joint;
+                param.anchorA = revolute->GetLocalAnchorA();
+                param.anchorB = revolute->GetLocalAnchorB();
+                param.reference = revolute->GetReferenceAngle();
+                param.enableLimit = revolute->IsLimitEnabled();
+                param.lower = revolute->GetLowerLimit();
+                param.upper = revolute->GetUpperLimit();
+                param.enableMotor = revolute->IsMotorEnabled();
+                param.motorSpeed = revolute->GetMotorSpeed();
+                param.maxMotor = revolute->GetMaxMotorTorque();
+            }
+                break;
+            case e_prismaticJoint:
+            {
+                b2PrismaticJoint* prismatic = (b2PrismaticJoint*)joint;
+                param.anchorA = prismatic->GetLocalAnchorA();
+                param.anchorB = prismatic->GetLocalAnchorB();
+                param.axis = prismatic->GetLocalAxisA();
+                param.reference = prismatic->GetReferenceAngle();
+                param.enableLimit = prismatic->IsLimitEnabled();
+                param.lower = prismatic->GetLowerLimit();
+                param.upper = prismatic->GetUpperLimit();
+                param.enableMotor = prismatic->IsMotorEnabled();
+                param.motorSpeed = prismatic->GetMotorSpeed();
+                param.maxMotor = prismatic->GetMaxMotorForce();
+            }
+                break;
+            case e_distanceJoint:
+            {
+                b2DistanceJoint* distance = (b2DistanceJoint*)joint;
+                param.anchorA = distance->GetLocalAnchorA();
+                param.anchorB = distance->GetLocalAnchorB();
+                param.length = distance->GetLength();
+                param.lower = distance->GetMinLength();
+                param.upper = distance->GetMaxLength();
+                param.stiffness = distance->GetStiffness();
+                param.damping = distance->GetDamping();
+            }
+                break;
+            case e_weldJoint:
+            {
+                b2WeldJoint* weld = (b2WeldJoint*)joint;
+                param.anchorA = weld->GetLocalAnchorA();
+                param.anchorB = weld->GetLocalAnchorB();
+                param.reference = weld->GetReferenceAngle();
+                param.stiffness = weld->GetStiffness();
+                param.damping = weld->GetDamping();
+            }
+                break;
+            case e_wheelJoint:
+            {
+                b2WheelJoint* wheel = (b2WheelJoint*)joint;
+                param.anchorA = wheel->GetLocalAnchorA();
+                param.anchorB = wheel->GetLocalAnchorB();
+                param.axis = wheel->GetLocalAxisA();
+                param.enableLimit = wheel->IsLimitEnabled();
+                param.lower = wheel->GetLowerLimit();
+                param.upper = wheel->GetUpperLimit();
+                param.enableMotor = wheel->IsMotorEnabled();
+                param.motorSpeed = wheel->GetMotorSpeed();
+                param.maxMotor = wheel->GetMaxMotorTorque();
+                param.stiffness = wheel->GetStiffness();
+                param.damping = wheel->GetDamping();
+            }
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    /**
+     * Returns true if the tunable parameters of the two definitions differ.
+     *
+     * Only the fields that apply to the joint type are compared.
+     *
+     * @param a The first joint definition
+     * @param b The second joint definition
+     *
+     * @return true if the tunable parameters of the two definitions differ.
+     */
+    static bool changed(const JointParam& a, const JointParam& b) {
+        switch (a.type) {
+            case e_revoluteJoint:
+            case e_prismaticJoint:
+                return (a.enableLimit != b.enableLimit || a.lower != b.lower || a.upper != b.upper ||
+                        a.enableMotor != b.enableMotor || a.motorSpeed != b.motorSpeed ||
+                        a.maxMotor != b.maxMotor);
+            case e_distanceJoint:
+                return (a.length != b.length || a.lower != b.lower || a.upper != b.upper ||
+                        a.stiffness != b.stiffness || a.damping != b.damping);
+            case e_weldJoint:
+                return (a.stiffness != b.stiffness || a.damping != b.damping);
+            case e_wheelJoint:
+                return (a.enableLimit != b.enableLimit || a.lower != b.lower || a.upper != b.upper ||
+                        a.enableMotor != b.enableMotor || a.motorSpeed != b.motorSpeed ||
+                        a.maxMotor != b.maxMotor || a.stiffness != b.stiffness ||
+                        a.damping != b.damping);
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * Applies the tunable parameters of a definition to the given joint.
+     *
+     * The joint must have the same type as the definition.
+     *
+     * @param joint The joint to modify
+     * @param param The joint definition
+     */
+    static void apply(b2Joint* joint, const JointParam& param) {
+        if (joint == nullptr || joint->GetType() != param.type) {
+            return;
+        }
+        switch (param.type) {
+            case e_revoluteJoint:
+            {
+                b2RevoluteJoint* revolute = (b2RevoluteJoint*)joint;
+                revolute->EnableLimit(param.enableLimit);
+                revolute->SetLimits(param.lower, param.upper);
+                revolute->EnableMotor(param.enableMotor);
+                revolute->SetMotorSpeed(param.motorSpeed);
+                revolute->SetMaxMotorTorque(param.maxMotor);
+            }
+                break;
+            case e_prismaticJoint:
+            {
+                b2PrismaticJoint* prismatic = (b2PrismaticJoint*)joint;
+                prismatic->EnableLimit(param.enableLimit);
+                prismatic->SetLimits(param.lower, param.upper);
+                prismatic->EnableMotor(param.enableMotor);
+                prismatic->SetMotorSpeed(param.motorSpeed);
+                prismatic->SetMaxMotorForce(param.maxMotor);
+            }
+                break;
+            case e_distanceJoint:
+            {
+                b2DistanceJoint* distance = (b2DistanceJoint*)joint;
+                distance->SetMinLength(param.lower);
+                distance->SetMaxLength(param.upper);
+                distance->SetLength(param.length);
+                distance->SetStiffness(param.stiffness);
+                distance->SetDamping(param.damping);
+            }
+                break;
+            case e_weldJoint:
+            {
+                b2WeldJoint* weld = (b2WeldJoint*)joint;
+                weld->SetStiffness(param.stiffness);
+                weld->SetDamping(param.damping);
+            }
+                break;
+            case e_wheelJoint:
+            {
+                b2WheelJoint* wheel = (b2WheelJoint*)joint;
+                wheel->EnableLimit(param.enableLimit);
+                wheel->SetLimits(param.lower, param.upper);
+                wheel->EnableMotor(param.enableMotor);
+                wheel->SetMotorSpeed(param.motorSpeed);
+                wheel->SetMaxMotorTorque(param.maxMotor);
+                wheel->SetStiffness(param.stiffness);
+                wheel->SetDamping(param.damping);
+            }
+                break;
+            default:
+                break;
+        }
+        // Wake the bodies so that the new parameters take effect
+        joint->GetBodyA()->SetAwake(true);
+        joint->GetBodyB()->SetAwake(true);
+    }
+
+    /**
+     * Initializes this event as the creation of a shared joint.
+     *
+     * @param id    The joint id
+     * @param param The joint definition
+     */
+    void initCreation(Uint64 id, const JointParam& param) {
+        _type = JOINT_CREATION;
+        _jointId = id;
+        _param = param;
+    }
+
+    /**
+     * Initializes this event as the removal of a shared joint.
+     *
+     * @param id    The joint id
+     */
+    void initDeletion(Uint64 id) {
+        _type = JOINT_DELETION;
+        _jointId = id;
+        _param = JointParam();
+    }
+
+    /**
+     * Initializes this event as a change to the parameters of a shared joint.
+     *
+     * @param id    The joint id
+     * @param param The joint definition
+     */
+    void initParams(Uint64 id, const JointParam& param) {
+        _type = JOINT_PARAMS;
+        _jointId = id;
+        _param = param;
+    }
+
+    /**
+     * Returns the type of this event.
+     *
+     * @return the type of this event.
+     */
+    Type getType() const { return _type; }
+
+    /**
+     * Returns the joint id.
+     *
+     * @return the joint id.
+     */
+    Uint64 getJointId() const { return _jointId; }
+
+    /**
+     * Returns the joint definition.
+     *
+     * For JOINT_PARAMS, only the type and the tunable parameters are set.
+     *
+     * @return the joint definition.
+     */
+    const JointParam& getParam() const { return _param; }
+
+    /**
+     * Resets this event so that it can be reused.
+     */
+    void reset() override {
+        NetEvent::reset();
+        _type = JOINT_CREATION;
+        _jointId = 0;
+        _param = JointParam();
+    }
+
+    /**
+     * Serializes all information in the event to a byte vector.
+     *
+     * The fixed fields are only written on creation, and only the tunable
+     * fields of the joint type are written at all. Limits and motors are
+     * skipped while they are disabled.
+     */
+    std::vector<std::byte> serialize() override {
+        _serializer.reset();
+        _serializer.writeBits((Uint32)_type, 2);
+        _serializer.writeVarint(_jointId);
+        if (_type == JOINT_DELETION) {
+            return _serializer.serialize();
+        }
+
+        _serializer.writeBits((Uint32)_param.type, JOINT_TYPE_BITS);
+        if (_type == JOINT_CREATION) {
+            _serializer.writeVarint(_param.bodyA);
+            _serializer.writeVarint(_param.bodyB);
+            _serializer.writeBool(_param.collide);
+            _serializer.writeFloat(_param.anchorA.x);
+            _serializer.writeFloat(_param.anchorA.y);
+            _serializer.writeFloat(_param.anchorB.x);
+            _serializer.writeFloat(_param.anchorB.y);
+            if (_param.type == e_prismaticJoint || _param.type == e_wheelJoint) {
+                _serializer.writeFloat(_param.axis.x);
+                _serializer.writeFloat(_param.axis.y);
+            }
+            if (_param.type != e_distanceJoint && _param.type != e_wheelJoint) {
+                _serializer.writeFloat(_param.reference);
+            }
+        }
+
+        if (_param.type == e_distanceJoint) {
+            _serializer.writeFloat(_param.length);
+            _serializer.writeFloat(_param.lower);
+            _serializer.writeFloat(_param.upper);
+        } else if (_param.type != e_weldJoint) {
+            _serializer.writeBool(_param.enableLimit);
+            if (_param.enableLimit) {
+                _serializer.writeFloat(_param.lower);
+                _serializer.writeFloat(_param.upper);
+            }
+            _serializer.writeBool(_param.enableMotor);
+            if (_param.enableMotor) {
+                _serializer.writeFloat(_param.motorSpeed);
+                _serializer.writeFloat(_param.maxMotor);
+            }
+        }
+        if (_param.type == e_distanceJoint || _param.type == e_weldJoint || _param.type == e_wheelJoint) {
+            _serializer.writeFloat(_param.stiffness);
+            _serializer.writeFloat(_param.damping);
+        }
+        return _serializer.serialize();
+    }
+
+    /**
+     * This method unpacks all information from the byte vector
+     * and stores it in this event.
+     *
+     * Limits and motors that were skipped because they are disabled are
+     * set to zero. {@link #apply} disables them, so their values do not
+     * matter.
+     */
+    void deserialize(const std::vector<std::byte>& data) override {
+        if (data.empty())
+            return;
+
+        _deserializer.reset();
+        _deserializer.receive(data);
+        _type = (Type)_deserializer.readBits(2);
+        _jointId = _deserializer.readVarint();
+        _param = JointParam();
+        if (_type == JOINT_DELETION) {
+            return;
+        }
+
+        _param.type = (b2JointType)_deserializer.readBits(JOINT_TYPE_BITS);
+        if (_type == JOINT_CREATION) {
+            _param.bodyA = _deserializer.readVarint();
+            _param.bodyB = _deserializer.readVarint();
+            _param.collide = _deserializer.readBool();
+            _param.anchorA.x = _deserializer.readFloat();
+            _param.anchorA.y = _deserializer.readFloat();
+            _param.anchorB.x = _deserializer.readFloat();
+            _param.anchorB.y = _deserializer.readFloat();
+            if (_param.type == e_prismaticJoint || _param.type == e_wheelJoint) {
+                _param.axis.x = _deserializer.readFloat();
+                _param.axis.y = _deserializer.readFloat();
+            }
+            if (_param.type != e_distanceJoint && _param.type != e_wheelJoint) {
+                _param.reference = _deserializer.readFloat();
+            }
+        }
+
+        if (_param.type == e_distanceJoint) {
+            _param.length = _deserializer.readFloat();
+            _param.lower = _deserializer.readFloat();
+            _param.upper = _deserializer.readFloat();
+        } else if (_param.type != e_weldJoint) {
+            _param.enableLimit = _deserializer.readBool();
+            if (_param.enableLimit) {
+                _param.lower = _deserializer.readFloat();
+                _param.upper = _deserializer.readFloat();
+            }
+            _param.enableMotor = _deserializer.readBool();
+            if (_param.enableMotor) {
+                _param.motorSpeed = _deserializer.readFloat();
+                _param.maxMotor = _deserializer.readFloat();
+            }
+        }
+        if (_param.type == e_distanceJoint || _param.type == e_weldJoint || _param.type == e_wheelJoint) {
+            _param.stiffness = _deserializer.readFloat();
+            _param.damping = _deserializer.readFloat();
+        }
+    }
+};
+
+    }
+}
+
+#endif /* __CU_PHYS_JOINT_EVENT_H__ */
@@ -35,6 +35,7 @@
 #include <cugl/netphysics/CUNetEvent.h>
 #include <cugl/netphysics/CUObstacleFactory.h>
 #include <cugl/physics2/CUObstacle.h>
+#include <cugl/net/CUNetcodeSerializer.h>
 #include <SDL_stdinc.h>
 
 namespace cugl {
@@ -71,7 +72,8 @@ public:
         OBJ_BOOL_CONSTS,
         OBJ_FLOAT_CONSTS,
         OBJ_OWNER_ACQUIRE,
-        OBJ_OWNER_RELEASE
+        OBJ_OWNER_RELEASE,
+        OBJ_BATCH_CREATION
     };
 
 protected:
@@ -89,6 +91,13 @@ protected:
     
     /** The packed parameter for obstacle creation. */
     std::shared_ptr<std::vector<std::byte>> _packedParam;
+    
+    /** The obstacle global ids for OBJ_BATCH_CREATION */
+    std::vector<Uint64> _batchIds;
+    /** The obstacle positions for OBJ_BATCH_CREATION */
+    std::vector<Vec2> _batchPos;
+    /** The obstacle angles for OBJ_BATCH_CREATION */
+    std::vector<float> _batchAngles;
 
 public:
     /** field for OBJ_POSITION */
@@ -126,10 +135,10 @@ public:
     /** field for OBJ_OWNER_ACQUIRE */
     Uint64 _duration;
 
-    /** Serializer for packing data */
-    LWSerializer _serializer;
-    /** Deserializer for unpacking data */
-    LWDeserializer _deserializer;
+    /** Serializer for packing data (in compact mode) */
+    net::NetcodeSerializer _serializer{true};
+    /** Deserializer for unpacking data (in compact mode) */
+    net::NetcodeDeserializer _deserializer{true};
 
 public:
 
@@ -158,6 +167,29 @@ public:
      * Only valid for OBJ_CREATION events.
      */  
     const std::shared_ptr<std::vector<std::byte>> getPackedParam() const { return _packedParam; }
+    
+    /**
+     * Returns the global ids of the obstacles created.
+     *
+     * Only valid for OBJ_BATCH_CREATION events.
+     */
+    const std::vector<Uint64>& getBatchIds() const { return _batchIds; }
+    
+    /**
+     * Returns the positions of the obstacles created.
+     *
+     * This is parallel to {@link #getBatchIds}. Only valid for
+     * OBJ_BATCH_CREATION events.
+     */
+    const std::vector<Vec2>& getBatchPositions() const { return _batchPos; }
+    
+    /**
+     * Returns the angles of the obstacles created.
+     *
+     * This is parallel to {@link #getBatchIds}. Only valid for
+     * OBJ_BATCH_CREATION events.
+     */
+    const std::vector<float>& getBatchAngles() const { return _batchAngles; }
 
     /**
 	 * Initializes an empty event to OBJ_CREATION.
@@ -175,6 +207,43 @@ public:
         _packedParam = packedParam;
     }
 
+    /**
+     * Initializes an empty event to OBJ_BATCH_CREATION.
+     *
+     * This event symbolizes the creation of several obstacles from the same
+     * factory parameters. The parameters are a template shared by every
+     * obstacle, and each obstacle only adds its own id, position and angle
+     * (see {@link #addBatchInstance}).
+     *
+     * @param obstacleFactId The obstacle factory id.
+     * @param packedParam The packed parameters shared by the obstacles.
+     */
+    void initBatchCreation(Uint32 obstacleFactId, std::shared_ptr<std::vector<std::byte>> packedParam) {
+        _type = OBJ_BATCH_CREATION;
+        _obstacleFactId = obstacleFactId;
+        _objId = 0;
+        _packedParam = packedParam;
+        _batchIds.clear();
+        _batchPos.clear();
+        _batchAngles.clear();
+    }
+    
+    /**
+     * Adds an obstacle to an OBJ_BATCH_CREATION event.
+     *
+     * @param objId The obstacle global id.
+     * @param pos   The obstacle position.
+     * @param angle The obstacle angle.
+     */
+    void addBatchInstance(Uint64 objId, Vec2 pos, float angle) {
+        if (_batchIds.empty()) {
+            _objId = objId;
+        }
+        _batchIds.push_back(objId);
+        _batchPos.push_back(pos);
+        _batchAngles.push_back(angle);
+    }
+
     /**
      * Initializes an empty event to OBJ_DELETION.
      * 
@@ -445,6 +514,23 @@ public:
         return std::make_shared<PhysObjEvent>();
     }
 
+    /**
+     * Resets this event so that it can be reused.
+     *
+     * Only the type, the id, and the creation fields are cleared. Every
+     * other field is set by the initializer of the matching type.
+     */
+    void reset() override {
+        NetEvent::reset();
+        _type = OBJ_CREATION;
+        _objId = 0;
+        _obstacleFactId = 0;
+        _packedParam = nullptr;
+        _batchIds.clear();
+        _batchPos.clear();
+        _batchAngles.clear();
+    }
+
     /**
      * Serializes this event into a byte vector.
      */
@@ -455,7 +541,7 @@ public:
         switch (_type) {
         case PhysObjEvent::OBJ_CREATION:
             _serializer.writeUint32(_obstacleFactId);
-            _serializer.writeByteVector(*_packedParam);
+            _serializer.writeBytes(*_packedParam);
             break;
         case PhysObjEvent::OBJ_DELETION:
             break;
@@ -501,6 +587,22 @@ public:
             break;
         case PhysObjEvent::OBJ_OWNER_RELEASE:
             break;
+        case PhysObjEvent::OBJ_BATCH_CREATION:
+        {
+            // Ids are consecutive in practice, so send the differences
+            _serializer.writeUint32(_obstacleFactId);
+            _serializer.writeBytes(*_packedParam);
+            _serializer.writeUint32((Uint32)_batchIds.size());
+            Uint64 prev = _objId;
+            for (size_t ii = 0; ii < _batchIds.size(); ii++) {
+                _serializer.writeUint64(_batchIds[ii]-prev);
+                _serializer.writeFloat(_batchPos[ii].x);
+                _serializer.writeFloat(_batchPos[ii].y);
+                _serializer.writeFloat(_batchAngles[ii]);
+                prev = _batchIds[ii];
+            }
+        }
+            break;
         default:
             CUAssertLog(false, "Serializing invalid obstacle event type");
         }
@@ -513,7 +615,7 @@ public:
      * This method will set the type of the event and all relevant fields.
 	 */
     void deserialize(const std::vector<std::byte>& data) override {
-        if (data.size() < sizeof(Uint32) + sizeof(Uint64))
+        if (data.size() < 2)
             return;
         _deserializer.reset();
         _deserializer.receive(data);
@@ -522,7 +624,7 @@ public:
         switch (_type) {
         case PhysObjEvent::OBJ_CREATION:
             _obstacleFactId = _deserializer.readUint32();
-            _packedParam = std::make_shared<std::vector<std::byte>>(data.begin() + 2 * sizeof(Uint32) + sizeof(Uint64), data.end());
+            _packedParam = std::make_shared<std::vector<std::byte>>(_deserializer.readBytes());
             break;
         case PhysObjEvent::OBJ_DELETION:
             break;
@@ -568,6 +670,25 @@ public:
             break;
         case PhysObjEvent::OBJ_OWNER_RELEASE:
             break;
+        case PhysObjEvent::OBJ_BATCH_CREATION:
+        {
+            _obstacleFactId = _deserializer.readUint32();
+            _packedParam = std::make_shared<std::vector<std::byte>>(_deserializer.readBytes());
+            Uint32 count = _deserializer.readUint32();
+            _batchIds.clear();
+            _batchPos.clear();
+            _batchAngles.clear();
+            Uint64 prev = _objId;
+            for (Uint32 ii = 0; ii < count; ii++) {
+                prev += _deserializer.readUint64();
+                float x = _deserializer.readFloat();
+                float y = _deserializer.readFloat();
+                _batchIds.push_back(prev);
+                _batchPos.push_back(Vec2(x,y));
+                _batchAngles.push_back(_deserializer.readFloat());
+            }
+        }
+            break;
         default:
             CUAssertLog(false, "Deserializing invalid obstacle event type");
         }
@@ -34,8 +34,9 @@
 #include <cugl/netphysics/CUNetEvent.h>
 #include <SDL_stdinc.h>
 #include <unordered_set>
-#include <cugl/net/CUNetcodeSerializer.h>
+#include <cugl/netphysics/CULWBitSerializer.h>
 #include <cugl/physics2/CUObstacle.h>
+#include <cugl/math/CURect.h>
 
 namespace cugl {
 
@@ -61,27 +62,121 @@ typedef struct {
     float vAngular;
 } ObjParam;
 
+/**
+ * This class describes the precision of a physics snapshot.
+ *
+ * Snapshots are quantized before they are sent. Positions are quantized to the
+ * bounds of the {@link ObstacleWorld}, and velocities are quantized to the given
+ * ranges (and clamped if they exceed them). Angles are sent as directions only.
+ *
+ * These settings are only needed by the sender. They are included in each
+ * snapshot so that the receiver can always decode it. Each bit count must be
+ * between 1 and 31.
+ */
+class SyncPrecision {
+public:
+    /** The number of bits for each position coordinate */
+    Uint8 positionBits;
+    /** The number of bits for each linear velocity component */
+    Uint8 velocityBits;
+    /** The number of bits for an angle */
+    Uint8 angleBits;
+    /** The number of bits for an angular velocity */
+    Uint8 angularBits;
+    /** The maximum linear velocity component (in world units per second) */
+    float maxVelocity;
+    /** The maximum angular velocity (in radians per second) */
+    float maxAngularVelocity;
+
+    /**
+     * Creates the default snapshot precision.
+     *
+     * This is 16 bits for each coordinate, 12 bits for each velocity component,
+     * 12 bits for the angle and 12 bits for the angular velocity. Velocities are
+     * limited to 64 units per second, and angular velocities to 32 radians per
+     * second.
+     */
+    SyncPrecision() :
+    positionBits(16), velocityBits(12), angleBits(12), angularBits(12),
+    maxVelocity(64.0f), maxAngularVelocity(32.0f) {}
+};
+
 /**
  * This class represents a message for the networked physics library to synchronize object 
  * positions. It should only be used by the networked physics library, not for custom game 
  * informations.
+ *
+ * A synchronization event may be a delta snapshot. A delta snapshot is encoded
+ * against an earlier snapshot of the same sender (the baseline), and only has
+ * entries for objects that changed since the baseline. Each entry records which
+ * fields changed (see {@link Field}). Objects that were in the baseline but are
+ * no longer synchronized are listed in {@link #getRemoved}. A snapshot with no
+ * baseline is a key snapshot, and every entry contains every field.
+ *
+ * Every event also carries acknowledgements for the snapshots its sender has
+ * received from other clients. These acknowledgements determine which baseline
+ * a sender may use. Reconstructing a delta snapshot is the job of the
+ * {@link NetPhysicsController}.
  */
 class PhysSyncEvent : public NetEvent {
+public:
+    /**
+     * The fields of an object snapshot.
+     *
+     * These values are combined as a bitmask to indicate which fields of an
+     * entry have changed since the baseline.
+     */
+    enum Field : Uint8 {
+        /** The position of the obstacle */
+        FIELD_POSITION = 1,
+        /** The linear velocity of the obstacle */
+        FIELD_VELOCITY = 2,
+        /** The angle of the obstacle */
+        FIELD_ANGLE    = 4,
+        /** The angular velocity of the obstacle */
+        FIELD_ANGULAR  = 8,
+        /** All of the fields */
+        FIELD_ALL      = 15
+    };
+
 private:
     /** 
      * The set of objectIds of all objects added to be serialized. 
      * Used to prevent duplicate objects. 
      */
     std::unordered_set<Uint64> _objSet;
-    /** The serializer for converting basic types to byte vectors. */
-    net::NetcodeSerializer _serializer;
-    /** The deserializer for converting byte vectors to basic types. */
-    net::NetcodeDeserializer _deserializer;
+    /** The serializer for packing snapshots into byte vectors. */
+    LWBitSerializer _serializer;
+    /** The deserializer for unpacking snapshots from byte vectors. */
+    LWBitDeserializer _deserializer;
 protected:
     /** The vector of added object snapshots. */
     std::vector<ObjParam> _syncList;
+    /** The changed fields for each object snapshot (parallel to _syncList) */
+    std::vector<Uint8> _fieldList;
+    /** The ids of objects removed since the baseline */
+    std::vector<Uint64> _removed;
+    /** The acknowledged snapshots as (shortUID,sequence) pairs */
+    std::vector<std::pair<Uint32,Uint32>> _acks;
+    /** The latest input received from each client as (shortUID,tick) pairs */
+    std::vector<std::pair<Uint32,Uint64>> _inputAcks;
+    /** The short UID of the sender */
+    Uint32 _sourceUID;
+    /** The sequence number of this snapshot (0 if not part of a delta stream) */
+    Uint32 _sequence;
+    /** The sequence number of the baseline (0 if this is a key snapshot) */
+    Uint32 _baseline;
+    /** The world bounds used to quantize positions */
+    Rect _bounds;
+    /** The quantization settings for this snapshot */
+    SyncPrecision _precision;
 
 public:
+    /**
+     * Creates an empty key snapshot.
+     */
+    PhysSyncEvent() : _sourceUID(0), _sequence(0), _baseline(0) {}
+
     /**
      * This method takes a snapshot of an obstacle's current position and velocity, and adds 
      * the snapshot to the list for serialization.
@@ -94,6 +189,19 @@ public:
             return;
 
         _objSet.insert(id);
+        _syncList.push_back(snapshot(obj, id));
+        _fieldList.push_back(FIELD_ALL);
+    }
+
+    /**
+     * Returns a snapshot of an obstacle's current position and velocity.
+     *
+     * @param obj the obstacle reference to snapshot
+     * @param id the global Id of the obstacle
+     *
+     * @return a snapshot of an obstacle's current position and velocity.
+     */
+    static ObjParam snapshot(const std::shared_ptr<physics2::Obstacle>& obj, Uint64 id) {
         ObjParam param;
         param.objId = id;
         param.x = obj->getX();
@@ -102,16 +210,250 @@ public:
         param.vy = obj->getVY();
         param.angle = obj->getAngle();
         param.vAngular = obj->getAngularVelocity();
+        return param;
+    }
+
+    /**
+     * Returns the fields that differ between two object snapshots.
+     *
+     * @param a The first object snapshot
+     * @param b The second object snapshot
+     *
+     * @return the fields that differ between two object snapshots (a bitmask of {@link Field})
+     */
+    static Uint8 diff(const ObjParam& a, const ObjParam& b) {
+        Uint8 fields = 0;
+        if (a.x != b.x || a.y != b.y) fields |= FIELD_POSITION;
+        if (a.vx != b.vx || a.vy != b.vy) fields |= FIELD_VELOCITY;
+        if (a.angle != b.angle) fields |= FIELD_ANGLE;
+        if (a.vAngular != b.vAngular) fields |= FIELD_ANGULAR;
+        return fields;
+    }
+
+    /**
+     * Copies the given fields from one object snapshot to another.
+     *
+     * @param dst       The object snapshot to update
+     * @param src       The object snapshot to copy from
+     * @param fields    The fields to copy (a bitmask of {@link Field})
+     */
+    static void merge(ObjParam& dst, const ObjParam& src, Uint8 fields) {
+        if (fields & FIELD_POSITION) { dst.x = src.x; dst.y = src.y; }
+        if (fields & FIELD_VELOCITY) { dst.vx = src.vx; dst.vy = src.vy; }
+        if (fields & FIELD_ANGLE) { dst.angle = src.angle; }
+        if (fields & FIELD_ANGULAR) { dst.vAngular = src.vAngular; }
+    }
+
+    /**
+     * Adds an object snapshot with the given changed fields.
+     *
+     * Only the fields in the bitmask are serialized. Duplicate objects are ignored.
+     *
+     * @param param     The object snapshot
+     * @param fields    The changed fields (a bitmask of {@link Field})
+     */
+    void addParam(const ObjParam& param, Uint8 fields) {
+        if (_objSet.count(param.objId))
+            return;
+        
+        _objSet.insert(param.objId);
         _syncList.push_back(param);
+        _fieldList.push_back(fields & FIELD_ALL);
+    }
+
+    /**
+     * Records that an object in the baseline is no longer synchronized.
+     *
+     * @param id    The global Id of the obstacle
+     */
+    void addRemoved(Uint64 id) {
+        _removed.push_back(id);
+    }
+
+    /**
+     * Records that the sender has received the given snapshot.
+     *
+     * @param uid       The short UID of the snapshot sender
+     * @param sequence  The sequence number of the latest snapshot received
+     */
+    void addAck(Uint32 uid, Uint32 sequence) {
+        _acks.push_back(std::make_pair(uid,sequence));
+    }
+
+    /**
+     * Records that the sender has received the input of a client.
+     *
+     * This is used by the host in host-authoritative mode, so that clients
+     * know which of their inputs a snapshot reflects.
+     *
+     * @param uid   The short UID of the client
+     * @param tick  The tick of the latest input received from the client
+     */
+    void addInputAck(Uint32 uid, Uint64 tick) {
+        _inputAcks.push_back(std::make_pair(uid,tick));
     }
 
     /**
 	 * This method returns a reference of the current vector of object snapshots added.
+     *
+     * For a delta snapshot, only the fields in {@link #getFieldList} are valid.
 	 */
     const std::vector<ObjParam>& getSyncList() const {
         return _syncList;
     }
 
+    /**
+     * Returns the changed fields for each object snapshot.
+     *
+     * This vector is parallel to {@link #getSyncList}. Each value is a bitmask of
+     * {@link Field}. For a key snapshot, every entry is FIELD_ALL.
+     *
+     * @return the changed fields for each object snapshot.
+     */
+    const std::vector<Uint8>& getFieldList() const {
+        return _fieldList;
+    }
+
+    /**
+     * Returns the ids of the objects removed since the baseline.
+     *
+     * @return the ids of the objects removed since the baseline.
+     */
+    const std::vector<Uint64>& getRemoved() const {
+        return _removed;
+    }
+
+    /**
+     * Returns the acknowledgements sent with this event.
+     *
+     * Each acknowledgement is a pair of the short UID of a snapshot sender and
+     * the sequence number of the latest snapshot received from it. A sequence
+     * number of 0 means that the sender is known, but that no snapshot from
+     * it could be decoded.
+     *
+     * @return the acknowledgements sent with this event.
+     */
+    const std::vector<std::pair<Uint32,Uint32>>& getAcks() const {
+        return _acks;
+    }
+
+    /**
+     * Returns the input acknowledgements sent with this event.
+     *
+     * Each acknowledgement is a pair of the short UID of a client and the tick
+     * of the latest input received from it. This is only used in
+     * host-authoritative mode.
+     *
+     * @return the input acknowledgements sent with this event.
+     */
+    const std::vector<std::pair<Uint32,Uint64>>& getInputAcks() const {
+        return _inputAcks;
+    }
+
+    /**
+     * Returns the short UID of the sender.
+     *
+     * @return the short UID of the sender.
+     */
+    Uint32 getSourceUID() const {
+        return _sourceUID;
+    }
+
+    /**
+     * Sets the short UID of the sender.
+     *
+     * @param uid   The short UID of the sender
+     */
+    void setSourceUID(Uint32 uid) {
+        _sourceUID = uid;
+    }
+
+    /**
+     * Returns the sequence number of this snapshot.
+     *
+     * A sequence number of 0 means that this snapshot is not part of the delta
+     * stream of its sender. It can neither be acknowledged nor used as a
+     * baseline.
+     *
+     * @return the sequence number of this snapshot.
+     */
+    Uint32 getSequence() const {
+        return _sequence;
+    }
+
+    /**
+     * Returns the sequence number of the baseline snapshot.
+     *
+     * A baseline of 0 means this is a key snapshot.
+     *
+     * @return the sequence number of the baseline snapshot.
+     */
+    Uint32 getBaseline() const {
+        return _baseline;
+    }
+
+    /**
+     * Sets the sequence numbers of this snapshot and its baseline.
+     *
+     * @param sequence  The sequence number of this snapshot
+     * @param baseline  The sequence number of the baseline (0 for none)
+     */
+    void setSequence(Uint32 sequence, Uint32 baseline) {
+        _sequence = sequence;
+        _baseline = baseline;
+    }
+
+    /**
+     * Sets the bounds used to quantize positions.
+     *
+     * These should be the bounds of the {@link ObstacleWorld}. Any object outside
+     * of these bounds has its position sent at full precision. If the bounds are
+     * empty, all positions are sent at full precision.
+     *
+     * @param bounds    The world bounds
+     */
+    void setBounds(const Rect& bounds) {
+        _bounds = bounds;
+    }
+
+    /**
+     * Sets the quantization settings for this snapshot.
+     *
+     * @param precision The quantization settings
+     */
+    void setPrecision(const SyncPrecision& precision) {
+        _precision = precision;
+    }
+
+    /**
+     * Rounds the object snapshot to the values the receiver will decode.
+     *
+     * This applies the quantization of this event to the snapshot. Values that
+     * are equal after quantization will be equal when received, which makes it
+     * possible to compare snapshots against a baseline exactly.
+     *
+     * @param param The object snapshot to quantize
+     */
+    void quantize(ObjParam& param) const {
+        float maxv  = _precision.maxVelocity;
+        float maxav = _precision.maxAngularVelocity;
+        if (isQuantized(param)) {
+            Uint32 bits = _precision.positionBits;
+            param.x = LWBitDeserializer::dequantize(LWBitSerializer::quantize(param.x, _bounds.getMinX(), _bounds.getMaxX(), bits),
+                                                    _bounds.getMinX(), _bounds.getMaxX(), bits);
+            param.y = LWBitDeserializer::dequantize(LWBitSerializer::quantize(param.y, _bounds.getMinY(), _bounds.getMaxY(), bits),
+                                                    _bounds.getMinY(), _bounds.getMaxY(), bits);
+        }
+        Uint32 bits = _precision.velocityBits;
+        param.vx = LWBitDeserializer::dequantize(LWBitSerializer::quantize(param.vx, -maxv, maxv, bits), -maxv, maxv, bits);
+        param.vy = LWBitDeserializer::dequantize(LWBitSerializer::quantize(param.vy, -maxv, maxv, bits), -maxv, maxv, bits);
+        bits = _precision.angleBits;
+        param.angle = LWBitDeserializer::dequantizeAngle(LWBitSerializer::quantizeAngle(param.angle, bits), bits);
+        bits = _precision.angularBits;
+        param.vAngular = LWBitDeserializer::dequantize(LWBitSerializer::quantize(param.vAngular, -maxav, maxav, bits),
+                                                       -maxav, maxav, bits);
+    }
+
     /**
 	 * This method allocates a new physic synchronization event.
 	 */
@@ -132,21 +474,116 @@ public:
         return std::make_shared<PhysSyncEvent>();
     }
 
+    /**
+     * Resets this event to an empty key snapshot so that it can be reused.
+     *
+     * The snapshot lists are cleared but keep their capacity.
+     */
+    void reset() override {
+        NetEvent::reset();
+        _objSet.clear();
+        _syncList.clear();
+        _fieldList.clear();
+        _removed.clear();
+        _acks.clear();
+        _inputAcks.clear();
+        _sourceUID = 0;
+        _sequence = 0;
+        _baseline = 0;
+        _bounds = Rect();
+        _precision = SyncPrecision();
+    }
+
     /**
      * This method takes the current list of snapshots and serializes them to a byte vector.
+     *
+     * The snapshots are bit-packed and quantized according to the bounds and
+     * precision of this event. The message starts with a header recording these
+     * settings, so the receiver does not need to know them in advance. This
+     * header is omitted if there are no entries.
+     *
+     * Object ids are (shortUID,counter) pairs. As most objects share the same
+     * shortUID, each entry only records a shortUID when it differs from the
+     * previous entry. The counter is sent as a variable length integer. Each
+     * entry is followed by its changed fields.
      */
     std::vector<std::byte> serialize() override {
         _serializer.reset();
-        _serializer.writeUint64((Uint64)_syncList.size());
-        for (auto it = _syncList.begin(); it != _syncList.end(); it++) {
-            ObjParam& obj = (*it);
-            _serializer.writeUint64(obj.objId);
-            _serializer.writeFloat(obj.x);
-            _serializer.writeFloat(obj.y);
-            _serializer.writeFloat(obj.vx);
-            _serializer.writeFloat(obj.vy);
-            _serializer.writeFloat(obj.angle);
-            _serializer.writeFloat(obj.vAngular);
+        _serializer.reserve(48+_syncList.size()*16+_acks.size()*4);
+        _serializer.writeVarint(_sourceUID);
+        _serializer.writeVarint(_sequence);
+        _serializer.writeVarint(_baseline);
+        _serializer.writeVarint((Uint64)_acks.size());
+        for (auto it = _acks.begin(); it != _acks.end(); it++) {
+            _serializer.writeVarint(it->first);
+            _serializer.writeVarint(it->second);
+        }
+        _serializer.writeVarint((Uint64)_inputAcks.size());
+        for (auto it = _inputAcks.begin(); it != _inputAcks.end(); it++) {
+            _serializer.writeVarint(it->first);
+            _serializer.writeVarint(it->second);
+        }
+
+        _serializer.writeVarint((Uint64)_syncList.size());
+        if (!_syncList.empty()) {
+            _serializer.writeFloat(_bounds.origin.x);
+            _serializer.writeFloat(_bounds.origin.y);
+            _serializer.writeFloat(_bounds.size.width);
+            _serializer.writeFloat(_bounds.size.height);
+            _serializer.writeBits(_precision.positionBits, 5);
+            _serializer.writeBits(_precision.velocityBits, 5);
+            _serializer.writeBits(_precision.angleBits, 5);
+            _serializer.writeBits(_precision.angularBits, 5);
+            _serializer.writeFloat(_precision.maxVelocity);
+            _serializer.writeFloat(_precision.maxAngularVelocity);
+        }
+
+        float minx = _bounds.getMinX();
+        float maxx = _bounds.getMaxX();
+        float miny = _bounds.getMinY();
+        float maxy = _bounds.getMaxY();
+        float maxv  = _precision.maxVelocity;
+        float maxav = _precision.maxAngularVelocity;
+
+        Uint32 space = 0;
+        for (size_t ii = 0; ii < _syncList.size(); ii++) {
+            ObjParam& obj = _syncList[ii];
+            Uint8 fields = _fieldList[ii];
+            Uint32 uid = (Uint32)(obj.objId >> 32);
+            _serializer.writeBool(uid != space);
+            if (uid != space) {
+                _serializer.writeVarint(uid);
+                space = uid;
+            }
+            _serializer.writeVarint(obj.objId & 0xFFFFFFFF);
+            _serializer.writeBits(fields, 4);
+
+            if (fields & FIELD_POSITION) {
+                bool inside = isQuantized(obj);
+                _serializer.writeBool(inside);
+                if (inside) {
+                    _serializer.writeQuantized(obj.x, minx, maxx, _precision.positionBits);
+                    _serializer.writeQuantized(obj.y, miny, maxy, _precision.positionBits);
+                } else {
+                    _serializer.writeFloat(obj.x);
+                    _serializer.writeFloat(obj.y);
+                }
+            }
+            if (fields & FIELD_VELOCITY) {
+                _serializer.writeQuantized(obj.vx, -maxv, maxv, _precision.velocityBits);
+                _serializer.writeQuantized(obj.vy, -maxv, maxv, _precision.velocityBits);
+            }
+            if (fields & FIELD_ANGLE) {
+                _serializer.writeAngle(obj.angle, _precision.angleBits);
+            }
+            if (fields & FIELD_ANGULAR) {
+                _serializer.writeQuantized(obj.vAngular, -maxav, maxav, _precision.angularBits);
+            }
+        }
+
+        _serializer.writeVarint((Uint64)_removed.size());
+        for (auto it = _removed.begin(); it != _removed.end(); it++) {
+            _serializer.writeVarint(*it);
         }
         return _serializer.serialize();
     }
@@ -154,27 +591,109 @@ public:
     /**
      * This method unpacks a byte vector to a list of snapshots that can be read and used for 
      * physics synchronizations.
+     *
+     * Angles are unpacked in the range [0, 2 pi). The receiver is responsible
+     * for unwrapping them relative to the local angle of each obstacle. Fields
+     * that were not sent are left at 0.
      * 
      * @param data the byte vector to deserialize
      */
     void deserialize(const std::vector<std::byte>& data) override {
-        if (data.size() < 4)
+        if (data.empty())
             return;
 
         _deserializer.reset();
         _deserializer.receive(data);
-        Uint64 numObjs = _deserializer.readUint64();
-        for (size_t i = 0; i < numObjs; i++) {
-            ObjParam param;
-            param.objId = _deserializer.readUint64();
-            param.x = _deserializer.readFloat();
-            param.y = _deserializer.readFloat();
-            param.vx = _deserializer.readFloat();
-            param.vy = _deserializer.readFloat();
-            param.angle = _deserializer.readFloat();
-            param.vAngular = _deserializer.readFloat();
-            _syncList.push_back(param);
+        _sourceUID = (Uint32)_deserializer.readVarint();
+        _sequence = (Uint32)_deserializer.readVarint();
+        _baseline = (Uint32)_deserializer.readVarint();
+        Uint64 numAcks = _deserializer.readVarint();
+        for (size_t i = 0; i < numAcks && !_deserializer.isExhausted(); i++) {
+            Uint32 uid = (Uint32)_deserializer.readVarint();
+            Uint32 seq = (Uint32)_deserializer.readVarint();
+            _acks.push_back(std::make_pair(uid,seq));
+        }
+        Uint64 numInputs = _deserializer.readVarint();
+        for (size_t i = 0; i < numInputs && !_deserializer.isExhausted(); i++) {
+            Uint32 uid = (Uint32)_deserializer.readVarint();
+            Uint64 tick = _deserializer.readVarint();
+            _inputAcks.push_back(std::make_pair(uid,tick));
+        }
+
+        Uint64 numObjs = _deserializer.readVarint();
+        if (numObjs > 0) {
+            _bounds.origin.x = _deserializer.readFloat();
+            _bounds.origin.y = _deserializer.readFloat();
+            _bounds.size.width  = _deserializer.readFloat();
+            _bounds.size.height = _deserializer.readFloat();
+            _precision.positionBits = _deserializer.readBits(5);
+            _precision.velocityBits = _deserializer.readBits(5);
+            _precision.angleBits = _deserializer.readBits(5);
+            _precision.angularBits = _deserializer.readBits(5);
+            _precision.maxVelocity = _deserializer.readFloat();
+            _precision.maxAngularVelocity = _deserializer.readFloat();
+        }
+
+        float minx = _bounds.getMinX();
+        float maxx = _bounds.getMaxX();
+        float miny = _bounds.getMinY();
+        float maxy = _bounds.getMaxY();
+        float maxv  = _precision.maxVelocity;
+        float maxav = _precision.maxAngularVelocity;
+
+        Uint64 space = 0;
+        for (size_t i = 0; i < numObjs && !_deserializer.isExhausted(); i++) {
+            ObjParam param = {0, 0, 0, 0, 0, 0, 0};
+            if (_deserializer.readBool()) {
+                space = _deserializer.readVarint();
+            }
+            param.objId = (space << 32) | (_deserializer.readVarint() & 0xFFFFFFFF);
+            Uint8 fields = (Uint8)_deserializer.readBits(4);
+            if (fields & FIELD_POSITION) {
+                if (_deserializer.readBool()) {
+                    param.x = _deserializer.readQuantized(minx, maxx, _precision.positionBits);
+                    param.y = _deserializer.readQuantized(miny, maxy, _precision.positionBits);
+                } else {
+                    param.x = _deserializer.readFloat();
+                    param.y = _deserializer.readFloat();
+                }
+            }
+            if (fields & FIELD_VELOCITY) {
+                param.vx = _deserializer.readQuantized(-maxv, maxv, _precision.velocityBits);
+                param.vy = _deserializer.readQuantized(-maxv, maxv, _precision.velocityBits);
+            }
+            if (fields & FIELD_ANGLE) {
+                param.angle = _deserializer.readAngle(_precision.angleBits);
+            }
+            if (fields & FIELD_ANGULAR) {
+                param.vAngular = _deserializer.readQuantized(-maxav, maxav, _precision.angularBits);
+            }
+            if (!_deserializer.isExhausted()) {
+                _syncList.push_back(param);
+                _fieldList.push_back(fields);
+            }
         }
+
+        Uint64 numRemoved = _deserializer.readVarint();
+        for (size_t i = 0; i < numRemoved && !_deserializer.isExhausted(); i++) {
+            _removed.push_back(_deserializer.readVarint());
+        }
+    }
+
+private:
+    /**
+     * Returns true if the position of the given snapshot is quantized.
+     *
+     * Positions are only quantized if they are inside of the world bounds.
+     *
+     * @param param The object snapshot
+     *
+     * @return true if the position of the given snapshot is quantized.
+     */
+    bool isQuantized(const ObjParam& param) const {
+        return (_bounds.size.width > 0 && _bounds.size.height > 0 &&
+                param.x >= _bounds.getMinX() && param.x <= _bounds.getMaxX() &&
+                param.y >= _bounds.getMinY() && param.y <= _bounds.getMaxY());
     }
 };
 
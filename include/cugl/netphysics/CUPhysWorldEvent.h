@@ -0,0 +1,279 @@
+//
+//  CUPhysWorldEvent.h
+//  Networked Physics Library
+//
+//  This class represents a chunk of the world sent to a client that joins a
+//  game in progress. The host streams the shared obstacles to the new client
+//  over several of these, nearest first, instead of sending the whole world
+//  in a single burst.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_PHYS_WORLD_EVENT_H__
+#define __CU_PHYS_WORLD_EVENT_H__
+
+#include <cugl/netphysics/CUNetEvent.h>
+#include <cugl/netphysics/CUPhysSyncEvent.h>
+#include <cugl/netphysics/CULWBitSerializer.h>
+#include <SDL_stdinc.h>
+#include <memory>
+#include <vector>
+
+/** The factory id of an obstacle that was not made by a factory */
+#define WORLD_NO_FACTORY    0xFFFFFFFF
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+/**
+ * This class represents a chunk of a late-join world transfer.
+ *
+ * A client that joins a game in progress knows nothing about the obstacles
+ * made by factories since the game started, nor the current state of any of
+ * the others. The host sends it this information as a stream of chunks. Each
+ * chunk lists some shared obstacles with their full (unquantized) state, and
+ * the factory parameters of those made by a factory. The client creates any
+ * obstacle it does not have, and moves every obstacle to its state.
+ *
+ * The first chunks cover the region around the view of the new client. The
+ * last of these is marked as the end of the near region, at which point the
+ * client can start to simulate. The rest of the world follows at a background
+ * rate, and the last chunk is marked as final.
+ *
+ * World events are created by the {@link NetPhysicsController}. See
+ * {@link NetPhysicsController#sendWorld}.
+ */
+class PhysWorldEvent : public NetEvent {
+public:
+    /** A single obstacle in the transfer */
+    struct Entry {
+        /** The current state of the obstacle */
+        ObjParam state;
+        /** The factory of the obstacle (WORLD_NO_FACTORY for none) */
+        Uint32 factory;
+        /** The factory parameters of the obstacle (nullptr for none) */
+        std::shared_ptr<std::vector<std::byte>> params;
+    };
+
+private:
+    /** The serializer for packing chunks into byte vectors. */
+    LWBitSerializer _serializer;
+    /** The deserializer for unpacking chunks from byte vectors. */
+    LWBitDeserializer _deserializer;
+protected:
+    /** The index of this chunk in the transfer */
+    Uint32 _chunk;
+    /** Whether this chunk completes the near region */
+    bool _near;
+    /** Whether this is the last chunk of the transfer */
+    bool _final;
+    /** The obstacles in this chunk */
+    std::vector<Entry> _entries;
+
+public:
+    /**
+     * Constructs an empty world event.
+     */
+    PhysWorldEvent() : _chunk(0), _near(false), _final(false) {}
+
+    /**
+     * Returns a newly allocated empty world event.
+     */
+    static std::shared_ptr<PhysWorldEvent> alloc() {
+        return std::make_shared<PhysWorldEvent>();
+    }
+
+    /**
+     * Initializes this event as an empty chunk with the given index.
+     *
+     * @param chunk The index of this chunk in the transfer
+     */
+    void init(Uint32 chunk) {
+        _chunk = chunk;
+        _near  = false;
+        _final = false;
+        _entries.clear();
+    }
+
+    /**
+     * Returns a newly allocated empty NetEvent
+     */
+    std::shared_ptr<NetEvent> newEvent() override {
+        return std::make_shared<PhysWorldEvent>();
+    }
+
+    /**
+     * Returns the index of this chunk in the transfer.
+     *
+     * @return the index of this chunk in the transfer.
+     */
+    Uint32 getChunk() const { return _chunk; }
+
+    /**
+     * Returns true if this chunk completes the near region.
+     *
+     * @return true if this chunk completes the near region.
+     */
+    bool isNear() const { return _near; }
+
+    /**
+     * Sets whether this chunk completes the near region.
+     *
+     * @param value Whether this chunk completes the near region
+     */
+    void setNear(bool value) { _near = value; }
+
+    /**
+     * Returns true if this is the last chunk of the transfer.
+     *
+     * @return true if this is the last chunk of the transfer.
+     */
+    bool isFinal() const { return _final; }
+
+    /**
+     * Sets whether this is the last chunk of the transfer.
+     *
+     * @param value Whether this is the last chunk of the transfer
+     */
+    void setFinal(bool value) { _final = value; }
+
+    /**
+     * Adds an obstacle to this chunk.
+     *
+     * If the obstacle was not made by a factory, the factory should be
+     * WORLD_NO_FACTORY and the parameters nullptr.
+     *
+     * @param state     The current state of the obstacle
+     * @param factory   The factory of the obstacle
+     * @param params    The factory parameters of the obstacle
+     */
+    void addEntry(const ObjParam& state, Uint32 factory,
+                  const std::shared_ptr<std::vector<std::byte>>& params) {
+        _entries.push_back({state,factory,params});
+    }
+
+    /**
+     * Returns the obstacles in this chunk.
+     *
+     * @return the obstacles in this chunk.
+     */
+    const std::vector<Entry>& getEntries() const { return _entries; }
+
+    /**
+     * Resets this event so that it can be reused.
+     */
+    void reset() override {
+        NetEvent::reset();
+        _chunk = 0;
+        _near  = false;
+        _final = false;
+        _entries.clear();
+    }
+
+    /**
+     * Serializes all information in the event to a byte vector.
+     *
+     * Factory ids are written off by one, so that obstacles without a
+     * factory only take a single byte for it.
+     */
+    std::vector<std::byte> serialize() override {
+        _serializer.reset();
+        _serializer.writeVarint(_chunk);
+        _serializer.writeBool(_near);
+        _serializer.writeBool(_final);
+        _serializer.writeVarint((Uint64)_entries.size());
+        for (auto it = _entries.begin(); it != _entries.end(); it++) {
+            const ObjParam& state = it->state;
+            _serializer.writeVarint(state.objId);
+            _serializer.writeFloat(state.x);
+            _serializer.writeFloat(state.y);
+            _serializer.writeFloat(state.vx);
+            _serializer.writeFloat(state.vy);
+            _serializer.writeFloat(state.angle);
+            _serializer.writeFloat(state.vAngular);
+            if (it->factory == WORLD_NO_FACTORY || it->params == nullptr) {
+                _serializer.writeVarint(0);
+            } else {
+                _serializer.writeVarint((Uint64)it->factory+1);
+                _serializer.writeVarint((Uint64)it->params->size());
+                for (auto jt = it->params->begin(); jt != it->params->end(); jt++) {
+                    _serializer.writeBits((Uint32)(Uint8)(*jt), 8);
+                }
+            }
+        }
+        return _serializer.serialize();
+    }
+
+    /**
+     * This method unpacks all information from the byte vector
+     * and stores it in this event.
+     */
+    void deserialize(const std::vector<std::byte>& data) override {
+        if (data.empty())
+            return;
+
+        _deserializer.reset();
+        _deserializer.receive(data);
+        _chunk = (Uint32)_deserializer.readVarint();
+        _near  = _deserializer.readBool();
+        _final = _deserializer.readBool();
+        Uint64 count = _deserializer.readVarint();
+        for (size_t ii = 0; ii < count && !_deserializer.isExhausted(); ii++) {
+            Entry entry;
+            entry.state.objId = _deserializer.readVarint();
+            entry.state.x  = _deserializer.readFloat();
+            entry.state.y  = _deserializer.readFloat();
+            entry.state.vx = _deserializer.readFloat();
+            entry.state.vy = _deserializer.readFloat();
+            entry.state.angle = _deserializer.readFloat();
+            entry.state.vAngular = _deserializer.readFloat();
+            Uint64 factory = _deserializer.readVarint();
+            entry.factory = WORLD_NO_FACTORY;
+            if (factory > 0) {
+                entry.factory = (Uint32)(factory-1);
+                Uint64 size = _deserializer.readVarint();
+                entry.params = std::make_shared<std::vector<std::byte>>();
+                entry.params->reserve(size);
+                for (size_t jj = 0; jj < size && !_deserializer.isExhausted(); jj++) {
+                    entry.params->push_back((std::byte)_deserializer.readBits(8));
+                }
+            }
+            if (!_deserializer.isExhausted()) {
+                _entries.push_back(std::move(entry));
+            }
+        }
+    }
+};
+
+    }
+}
+
+#endif /* __CU_PHYS_WORLD_EVENT_H__ */
@@ -0,0 +1,532 @@
+//
+//  CUSchemaEvent.h
+//  Networked Physics Library
+//
+//  This module provides events whose wire format is declared rather than written
+//  by hand. A subclass lists its fields, with a quantization range for each, and
+//  the packing, unpacking, and delta encoding code is generated from that list at
+//  compile time. The size of the message is also known at compile time.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_SCHEMA_EVENT_H__
+#define __CU_SCHEMA_EVENT_H__
+
+#include <cugl/netphysics/CUNetEvent.h>
+#include <cugl/netphysics/CULWBitSerializer.h>
+#include <cugl/math/CUVec2.h>
+#include <SDL_stdinc.h>
+#include <type_traits>
+#include <utility>
+#include <tuple>
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+#pragma mark -
+#pragma mark Field Descriptors
+/**
+ * This class is a collection of field descriptors for a {@link SchemaEvent}.
+ *
+ * Each static method returns a constexpr description of a single field of an
+ * event class E. The description knows the number of bits of the field (at
+ * compile time), and how to write, read, and compare the field. Use these to
+ * build the tuple returned by the schema() method of a {@link SchemaEvent}.
+ */
+class NetSchema {
+public:
+    /**
+     * Returns the number of bits needed to store every value up to range.
+     *
+     * @param range The largest value to store
+     *
+     * @return the number of bits needed to store every value up to range.
+     */
+    static constexpr Uint32 bitsFor(Uint64 range) {
+        Uint32 result = 0;
+        while (range > 0) {
+            range >>= 1;
+            result++;
+        }
+        return result;
+    }
+
+    /**
+     * A boolean field, stored as a single bit.
+     */
+    template <typename E>
+    class Bool {
+    public:
+        /** The number of bits on the wire */
+        static constexpr Uint32 bits = 1;
+        /** The field of the event */
+        bool E::*member;
+
+        /** Writes the field of the event */
+        void write(LWBitSerializer& out, const E& event) const {
+            out.writeBool(event.*member);
+        }
+        /** Reads the field of the event */
+        void read(LWBitDeserializer& in, E& event) const {
+            event.*member = in.readBool();
+        }
+        /** Returns true if the field has the same wire value in both events */
+        bool same(const E& a, const E& b) const {
+            return a.*member == b.*member;
+        }
+    };
+
+    /**
+     * An integer field in the range [Min,Max], stored relative to Min.
+     *
+     * Values outside of the range are clamped.
+     */
+    template <typename E, typename T, Sint64 Min, Sint64 Max>
+    class Int {
+        static_assert(std::is_integral<T>::value, "Integer fields must have an integral type");
+        static_assert(Min <= Max, "The integer range is empty");
+        static_assert(bitsFor((Uint64)(Max-Min)) <= 32, "The integer range needs more than 32 bits");
+    public:
+        /** The number of bits on the wire */
+        static constexpr Uint32 bits = bitsFor((Uint64)(Max-Min));
+        /** The field of the event */
+        T E::*member;
+
+        /** Returns the wire value of the field */
+        Uint32 encode(const E& event) const {
+            Sint64 value = (Sint64)(event.*member);
+            value = value < Min ? Min : (value > Max ? Max : value);
+            return (Uint32)(value-Min);
+        }
+        /** Writes the field of the event */
+        void write(LWBitSerializer& out, const E& event) const {
+            out.writeBits(encode(event), bits);
+        }
+        /** Reads the field of the event */
+        void read(LWBitDeserializer& in, E& event) const {
+            event.*member = (T)((Sint64)in.readBits(bits)+Min);
+        }
+        /** Returns true if the field has the same wire value in both events */
+        bool same(const E& a, const E& b) const {
+            return encode(a) == encode(b);
+        }
+    };
+
+    /**
+     * A float field stored at full (32 bit) precision.
+     */
+    template <typename E>
+    class Real {
+    public:
+        /** The number of bits on the wire */
+        static constexpr Uint32 bits = 32;
+        /** The field of the event */
+        float E::*member;
+
+        /** Writes the field of the event */
+        void write(LWBitSerializer& out, const E& event) const {
+            out.writeFloat(event.*member);
+        }
+        /** Reads the field of the event */
+        void read(LWBitDeserializer& in, E& event) const {
+            event.*member = in.readFloat();
+        }
+        /** Returns true if the field has the same wire value in both events */
+        bool same(const E& a, const E& b) const {
+            return a.*member == b.*member;
+        }
+    };
+
+    /**
+     * A float field quantized to the range [min,max] with the given bits.
+     */
+    template <typename E, Uint32 Bits>
+    class Quantized {
+        static_assert(Bits > 0 && Bits <= 32, "Quantized fields must have 1 to 32 bits");
+    public:
+        /** The number of bits on the wire */
+        static constexpr Uint32 bits = Bits;
+        /** The field of the event */
+        float E::*member;
+        /** The minimum value of the range */
+        float min;
+        /** The maximum value of the range */
+        float max;
+
+        /** Writes the field of the event */
+        void write(LWBitSerializer& out, const E& event) const {
+            out.writeQuantized(event.*member, min, max, Bits);
+        }
+        /** Reads the field of the event */
+        void read(LWBitDeserializer& in, E& event) const {
+            event.*member = in.readQuantized(min, max, Bits);
+        }
+        /** Returns true if the field has the same wire value in both events */
+        bool same(const E& a, const E& b) const {
+            return (LWBitSerializer::quantize(a.*member, min, max, Bits) ==
+                    LWBitSerializer::quantize(b.*member, min, max, Bits));
+        }
+    };
+
+    /**
+     * An angle field (in radians) quantized to the given bits.
+     *
+     * Only the direction of the angle is preserved.
+     */
+    template <typename E, Uint32 Bits>
+    class Angle {
+        static_assert(Bits > 0 && Bits <= 32, "Angle fields must have 1 to 32 bits");
+    public:
+        /** The number of bits on the wire */
+        static constexpr Uint32 bits = Bits;
+        /** The field of the event */
+        float E::*member;
+
+        /** Writes the field of the event */
+        void write(LWBitSerializer& out, const E& event) const {
+            out.writeAngle(event.*member, Bits);
+        }
+        /** Reads the field of the event */
+        void read(LWBitDeserializer& in, E& event) const {
+            event.*member = in.readAngle(Bits);
+        }
+        /** Returns true if the field has the same wire value in both events */
+        bool same(const E& a, const E& b) const {
+            return (LWBitSerializer::quantizeAngle(a.*member, Bits) ==
+                    LWBitSerializer::quantizeAngle(b.*member, Bits));
+        }
+    };
+
+    /**
+     * A vector field with both components quantized to the range [min,max].
+     */
+    template <typename E, Uint32 Bits>
+    class Vector {
+        static_assert(Bits > 0 && Bits <= 32, "Vector fields must have 1 to 32 bits");
+    public:
+        /** The number of bits on the wire */
+        static constexpr Uint32 bits = 2*Bits;
+        /** The field of the event */
+        Vec2 E::*member;
+        /** The minimum value of each component */
+        float min;
+        /** The maximum value of each component */
+        float max;
+
+        /** Writes the field of the event */
+        void write(LWBitSerializer& out, const E& event) const {
+            const Vec2& v = event.*member;
+            out.writeQuantized(v.x, min, max, Bits);
+            out.writeQuantized(v.y, min, max, Bits);
+        }
+        /** Reads the field of the event */
+        void read(LWBitDeserializer& in, E& event) const {
+            Vec2& v = event.*member;
+            v.x = in.readQuantized(min, max, Bits);
+            v.y = in.readQuantized(min, max, Bits);
+        }
+        /** Returns true if the field has the same wire value in both events */
+        bool same(const E& a, const E& b) const {
+            const Vec2& u = a.*member;
+            const Vec2& v = b.*member;
+            return (LWBitSerializer::quantize(u.x, min, max, Bits) ==
+                    LWBitSerializer::quantize(v.x, min, max, Bits) &&
+                    LWBitSerializer::quantize(u.y, min, max, Bits) ==
+                    LWBitSerializer::quantize(v.y, min, max, Bits));
+        }
+    };
+
+    /**
+     * Returns a boolean field descriptor.
+     *
+     * @param member    The field of the event
+     *
+     * @return a boolean field descriptor.
+     */
+    template <typename E>
+    static constexpr Bool<E> boolean(bool E::*member) {
+        return Bool<E>{member};
+    }
+
+    /**
+     * Returns an integer field descriptor for the range [Min,Max].
+     *
+     * @param member    The field of the event
+     *
+     * @return an integer field descriptor for the range [Min,Max].
+     */
+    template <Sint64 Min, Sint64 Max, typename E, typename T>
+    static constexpr Int<E,T,Min,Max> integer(T E::*member) {
+        return Int<E,T,Min,Max>{member};
+    }
+
+    /**
+     * Returns a full precision float field descriptor.
+     *
+     * @param member    The field of the event
+     *
+     * @return a full precision float field descriptor.
+     */
+    template <typename E>
+    static constexpr Real<E> real(float E::*member) {
+        return Real<E>{member};
+    }
+
+    /**
+     * Returns a quantized float field descriptor.
+     *
+     * @param member    The field of the event
+     * @param min       The minimum value of the range
+     * @param max       The maximum value of the range
+     *
+     * @return a quantized float field descriptor.
+     */
+    template <Uint32 Bits, typename E>
+    static constexpr Quantized<E,Bits> quantized(float E::*member, float min, float max) {
+        return Quantized<E,Bits>{member, min, max};
+    }
+
+    /**
+     * Returns a quantized angle field descriptor.
+     *
+     * @param member    The field of the event
+     *
+     * @return a quantized angle field descriptor.
+     */
+    template <Uint32 Bits, typename E>
+    static constexpr Angle<E,Bits> angle(float E::*member) {
+        return Angle<E,Bits>{member};
+    }
+
+    /**
+     * Returns a quantized vector field descriptor.
+     *
+     * @param member    The field of the event
+     * @param min       The minimum value of each component
+     * @param max       The maximum value of each component
+     *
+     * @return a quantized vector field descriptor.
+     */
+    template <Uint32 Bits, typename E>
+    static constexpr Vector<E,Bits> vector(Vec2 E::*member, float min, float max) {
+        return Vector<E,Bits>{member, min, max};
+    }
+};
+
+#pragma mark -
+#pragma mark Schema Event
+/**
+ * This class is a base for events with a declared wire format.
+ *
+ * A subclass E must inherit from SchemaEvent<E>, and provide a public static
+ * constexpr method schema() returning a tuple of {@link NetSchema} descriptors,
+ * one per field. For example
+ *
+ *     class ShipEvent : public SchemaEvent<ShipEvent> {
+ *     public:
+ *         Vec2  pos;
+ *         float angle;
+ *         Uint8 health;
+ *         bool  firing;
+ *
+ *         static constexpr auto schema() {
+ *             return std::make_tuple(
+ *                 NetSchema::vector<16>(&ShipEvent::pos, 0, 1024),
+ *                 NetSchema::angle<10>(&ShipEvent::angle),
+ *                 NetSchema::integer<0,100>(&ShipEvent::health),
+ *                 NetSchema::boolean(&ShipEvent::firing));
+ *         }
+ *     };
+ *
+ * The methods {@link #serialize} and {@link #deserialize} are then generated
+ * from the schema, and there is no need to override them. The message is
+ * exactly {@link #wireSize} bytes, as the fields are packed at the bit level.
+ * The subclass must still override {@link NetEvent#reset} if it is pooled.
+ *
+ * In addition, an event may be delta encoded against a baseline that the
+ * recipient already has (see {@link #packDelta}). Each field then costs a single
+ * bit if its quantized value is unchanged.
+ */
+template <typename E>
+class SchemaEvent : public NetEvent {
+private:
+    /** The serializer for packing events into byte vectors. */
+    LWBitSerializer _serializer;
+    /** The deserializer for unpacking events from byte vectors. */
+    LWBitDeserializer _deserializer;
+
+    /**
+     * Returns this event as an instance of the subclass.
+     *
+     * @return this event as an instance of the subclass.
+     */
+    const E& self() const { return static_cast<const E&>(*this); }
+
+    /**
+     * Returns this event as an instance of the subclass.
+     *
+     * @return this event as an instance of the subclass.
+     */
+    E& self() { return static_cast<E&>(*this); }
+
+public:
+    /**
+     * Returns the number of bits in a packed event.
+     *
+     * @return the number of bits in a packed event.
+     */
+    static constexpr Uint32 wireBits() {
+        return std::apply([](const auto&... field) {
+            return (Uint32)(0 + ... + std::decay_t<decltype(field)>::bits);
+        }, E::schema());
+    }
+
+    /**
+     * Returns the number of bytes in a serialized event.
+     *
+     * @return the number of bytes in a serialized event.
+     */
+    static constexpr size_t wireSize() {
+        return (wireBits()+7)/8;
+    }
+
+    /**
+     * Returns the maximum number of bytes in a delta encoded event.
+     *
+     * @return the maximum number of bytes in a delta encoded event.
+     */
+    static constexpr size_t deltaSize() {
+        return (wireBits()+std::tuple_size<decltype(E::schema())>::value+7)/8;
+    }
+
+    /**
+     * Returns a newly allocated empty NetEvent
+     */
+    std::shared_ptr<NetEvent> newEvent() override {
+        return std::make_shared<E>();
+    }
+
+    /**
+     * Writes every field of this event to the given serializer.
+     *
+     * This allows several events to be packed into one message.
+     *
+     * @param out   The serializer to write to
+     */
+    void pack(LWBitSerializer& out) const {
+        std::apply([&](const auto&... field) {
+            (field.write(out, self()), ...);
+        }, E::schema());
+    }
+
+    /**
+     * Reads every field of this event from the given deserializer.
+     *
+     * @param in    The deserializer to read from
+     *
+     * @return true if the event was read completely
+     */
+    bool unpack(LWBitDeserializer& in) {
+        std::apply([&](const auto&... field) {
+            (field.read(in, self()), ...);
+        }, E::schema());
+        return !in.isExhausted();
+    }
+
+    /**
+     * Writes this event to the given serializer, relative to the given baseline.
+     *
+     * Each field is preceded by a bit indicating whether it differs from the
+     * baseline. Only the changed fields are written. The recipient must unpack
+     * the event with the same baseline.
+     *
+     * @param out   The serializer to write to
+     * @param base  The baseline event
+     */
+    void packDelta(LWBitSerializer& out, const E& base) const {
+        std::apply([&](const auto&... field) {
+            ([&]() {
+                bool changed = !field.same(self(), base);
+                out.writeBool(changed);
+                if (changed) {
+                    field.write(out, self());
+                }
+            }(), ...);
+        }, E::schema());
+    }
+
+    /**
+     * Reads this event from the given deserializer, relative to the given baseline.
+     *
+     * Every field not in the message is copied from the baseline.
+     *
+     * @param in    The deserializer to read from
+     * @param base  The baseline event
+     *
+     * @return true if the event was read completely
+     */
+    bool unpackDelta(LWBitDeserializer& in, const E& base) {
+        std::apply([&](const auto&... field) {
+            ([&]() {
+                if (in.readBool()) {
+                    field.read(in, self());
+                } else {
+                    self().*(field.member) = base.*(field.member);
+                }
+            }(), ...);
+        }, E::schema());
+        return !in.isExhausted();
+    }
+
+    /**
+     * Serializes all information in the event to a byte vector.
+     */
+    std::vector<std::byte> serialize() override {
+        _serializer.reset();
+        _serializer.reserve(wireSize());
+        pack(_serializer);
+        return _serializer.serialize();
+    }
+
+    /**
+     * Unpacks all information from the byte vector and stores it in this event.
+     *
+     * @param data  The byte vector packed by {@link #serialize}
+     */
+    void deserialize(const std::vector<std::byte>& data) override {
+        _deserializer.receive(data);
+        unpack(_deserializer);
+    }
+};
+
+    }
+}
+#endif /* __CU_SCHEMA_EVENT_H__ */
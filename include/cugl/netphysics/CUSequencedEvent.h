@@ -0,0 +1,228 @@
+//
+//  CUSequencedEvent.h
+//  Networked Physics Library
+//
+//  This class is the envelope of the sequenced delivery of the NetEventController.
+//  It carries reliable events over the unreliable lane, together with the
+//  acknowledgements for the events received from the recipient. Events are
+//  resent until they are acknowledged, and delivered in order.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_SEQUENCED_EVENT_H__
+#define __CU_SEQUENCED_EVENT_H__
+
+#include <cugl/netphysics/CUNetEvent.h>
+#include <cugl/netphysics/CULWBitSerializer.h>
+#include <SDL_stdinc.h>
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+/**
+ * This class is an envelope of sequenced events between two peers.
+ *
+ * Every sequenced event has a sequence number, and is stored as the wrapped
+ * byte vector of the original event. The envelope also acknowledges the
+ * events received from the recipient. The acknowledgement is cumulative (every
+ * event up to {@link #getAck} was received), with a bitfield for the events
+ * received out of order after that. Bit i of {@link #getAckBits} is set if event
+ * ack+2+i was received.
+ *
+ * Envelopes are created and consumed by the {@link NetEventController}. See
+ * {@link NetEventController#setSequencedDelivery}.
+ */
+class SequencedEvent : public NetEvent {
+private:
+    /** The serializer for packing envelopes into byte vectors. */
+    LWBitSerializer _serializer;
+    /** The deserializer for unpacking envelopes from byte vectors. */
+    LWBitDeserializer _deserializer;
+protected:
+    /** The latest sequence number received in order from the recipient */
+    Uint32 _ack;
+    /** The events received out of order after the acknowledgement */
+    Uint32 _ackBits;
+    /** The sequence numbers of the events */
+    std::vector<Uint32> _sequences;
+    /** The wrapped events (parallel to _sequences) */
+    std::vector<std::vector<std::byte>> _events;
+
+public:
+    /**
+     * Constructs an empty envelope.
+     */
+    SequencedEvent() : _ack(0), _ackBits(0) {}
+
+    /**
+     * Returns a newly allocated empty envelope.
+     */
+    static std::shared_ptr<SequencedEvent> alloc() {
+        return std::make_shared<SequencedEvent>();
+    }
+
+    /**
+     * Returns a newly allocated empty NetEvent
+     */
+    std::shared_ptr<NetEvent> newEvent() override {
+        return std::make_shared<SequencedEvent>();
+    }
+
+    /**
+     * Returns the latest sequence number received in order.
+     *
+     * @return the latest sequence number received in order.
+     */
+    Uint32 getAck() const {
+        return _ack;
+    }
+
+    /**
+     * Returns the events received out of order after the acknowledgement.
+     *
+     * Bit i is set if event {@link #getAck}+2+i was received.
+     *
+     * @return the events received out of order after the acknowledgement.
+     */
+    Uint32 getAckBits() const {
+        return _ackBits;
+    }
+
+    /**
+     * Sets the acknowledgement for the events received from the recipient.
+     *
+     * @param ack   The latest sequence number received in order
+     * @param bits  The events received out of order after that
+     */
+    void setAck(Uint32 ack, Uint32 bits) {
+        _ack = ack;
+        _ackBits = bits;
+    }
+
+    /**
+     * Appends a wrapped event with the given sequence number.
+     *
+     * The sequence number must be larger than the acknowledgement.
+     *
+     * @param sequence  The sequence number of the event
+     * @param data      The wrapped event
+     */
+    void addEvent(Uint32 sequence, const std::vector<std::byte>& data) {
+        _sequences.push_back(sequence);
+        _events.push_back(data);
+    }
+
+    /**
+     * Returns the sequence numbers of the events in this envelope.
+     *
+     * @return the sequence numbers of the events in this envelope.
+     */
+    const std::vector<Uint32>& getSequences() const {
+        return _sequences;
+    }
+
+    /**
+     * Returns the wrapped events in this envelope.
+     *
+     * @return the wrapped events in this envelope.
+     */
+    const std::vector<std::vector<std::byte>>& getEvents() const {
+        return _events;
+    }
+
+    /**
+     * Resets this event so that it can be reused.
+     */
+    void reset() override {
+        NetEvent::reset();
+        _ack = 0;
+        _ackBits = 0;
+        _sequences.clear();
+        _events.clear();
+    }
+
+    /**
+     * Serializes all information in the event to a byte vector.
+     *
+     * Sequence numbers are written relative to the previous one, so they
+     * usually take a single byte.
+     */
+    std::vector<std::byte> serialize() override {
+        _serializer.reset();
+        _serializer.writeVarint(_ack);
+        _serializer.writeBits(_ackBits, 32);
+        _serializer.writeVarint((Uint64)_events.size());
+        Uint32 prev = 0;
+        for (size_t ii = 0; ii < _events.size(); ii++) {
+            _serializer.writeVarint(_sequences[ii]-prev);
+            _serializer.writeVarint((Uint64)_events[ii].size());
+            for (auto it = _events[ii].begin(); it != _events[ii].end(); it++) {
+                _serializer.writeBits((Uint32)(*it), 8);
+            }
+            prev = _sequences[ii];
+        }
+        return _serializer.serialize();
+    }
+
+    /**
+     * This method unpacks all information from the byte vector
+     * and stores it in this event.
+     */
+    void deserialize(const std::vector<std::byte>& data) override {
+        if (data.empty())
+            return;
+
+        _deserializer.reset();
+        _deserializer.receive(data);
+        _ack = (Uint32)_deserializer.readVarint();
+        _ackBits = _deserializer.readBits(32);
+        Uint64 count = _deserializer.readVarint();
+        Uint32 prev = 0;
+        for (size_t ii = 0; ii < count && !_deserializer.isExhausted(); ii++) {
+            Uint32 sequence = prev+(Uint32)_deserializer.readVarint();
+            Uint64 size = _deserializer.readVarint();
+            std::vector<std::byte> event;
+            for (size_t jj = 0; jj < size && !_deserializer.isExhausted(); jj++) {
+                event.push_back((std::byte)_deserializer.readBits(8));
+            }
+            if (!_deserializer.isExhausted()) {
+                _sequences.push_back(sequence);
+                _events.push_back(std::move(event));
+            }
+            prev = sequence;
+        }
+    }
+};
+
+    }
+}
+
+#endif /* __CU_SEQUENCED_EVENT_H__ */
@@ -0,0 +1,156 @@
+//
+//  CUSubscriptionEvent.h
+//  Networked Physics Library
+//
+//  This class announces the event types that a peer wants to receive. The
+//  NetEventController sends it to every other peer whenever the subscriptions
+//  change, and the peers stop sending (or even serializing) the events that
+//  the subscriber does not want.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Barry Lyu
+//  Version: 10/14/26
+//
+
+#ifndef __CU_SUBSCRIPTION_EVENT_H__
+#define __CU_SUBSCRIPTION_EVENT_H__
+
+#include <cugl/netphysics/CUNetEvent.h>
+#include <cugl/netphysics/CULWBitSerializer.h>
+#include <SDL_stdinc.h>
+
+namespace cugl {
+
+    /**
+     * The CUGL networked physics classes.
+     *
+     * This internal namespace is for optional networking physics management package.
+     * This package provides automatic synchronization of physics objects across devices.
+     */
+    namespace netphysics {
+
+/**
+ * This class is the set of event types that a peer subscribes to.
+ *
+ * An event type is identified by its type id, which is the order in which it
+ * was attached to the {@link NetEventController}. Bit i of the subscription
+ * is set if the peer wants the events with type id i. Types beyond the end
+ * of the subscription are assumed to be wanted.
+ *
+ * Subscription events are created and consumed by the {@link NetEventController},
+ * and are never added to the inbound event queue.
+ */
+class SubscriptionEvent : public NetEvent {
+private:
+    /** The serializer for packing messages into byte vectors. */
+    LWBitSerializer _serializer;
+    /** The deserializer for unpacking messages from byte vectors. */
+    LWBitDeserializer _deserializer;
+protected:
+    /** Whether the peer wants each event type (by type id) */
+    std::vector<bool> _types;
+
+public:
+    /**
+     * Constructs an empty subscription.
+     */
+    SubscriptionEvent() {}
+
+    /**
+     * Returns a newly allocated empty subscription.
+     */
+    static std::shared_ptr<SubscriptionEvent> alloc() {
+        return std::make_shared<SubscriptionEvent>();
+    }
+
+    /**
+     * Returns a newly allocated subscription to the given event types.
+     *
+     * @param types Whether the peer wants each event type (by type id)
+     */
+    static std::shared_ptr<SubscriptionEvent> alloc(const std::vector<bool>& types) {
+        auto result = std::make_shared<SubscriptionEvent>();
+        result->_types = types;
+        return result;
+    }
+
+    /**
+     * Returns a newly allocated empty NetEvent
+     */
+    std::shared_ptr<NetEvent> newEvent() override {
+        return std::make_shared<SubscriptionEvent>();
+    }
+
+    /**
+     * Returns whether the peer wants each event type (by type id).
+     *
+     * @return whether the peer wants each event type (by type id).
+     */
+    const std::vector<bool>& getTypes() const {
+        return _types;
+    }
+
+    /**
+     * Resets this event so that it can be reused.
+     */
+    void reset() override {
+        NetEvent::reset();
+        _types.clear();
+    }
+
+    /**
+     * Serializes all information in the event to a byte vector.
+     *
+     * The subscription is the number of types, followed by one bit per type.
+     */
+    std::vector<std::byte> serialize() override {
+        _serializer.reset();
+        _serializer.writeVarint(_types.size());
+        for (auto it = _types.begin(); it != _types.end(); ++it) {
+            _serializer.writeBool(*it);
+        }
+        return _serializer.serialize();
+    }
+
+    /**
+     * This method unpacks all information from the byte vector
+     * and stores it in this event.
+     */
+    void deserialize(const std::vector<std::byte>& data) override {
+        _types.clear();
+        if (data.empty())
+            return;
+
+        _deserializer.reset();
+        _deserializer.receive(data);
+        // Type ids are a single byte
+        size_t size = SDL_min((size_t)_deserializer.readVarint(),(size_t)256);
+        _types.reserve(size);
+        for (size_t ii = 0; ii < size; ii++) {
+            _types.push_back(_deserializer.readBool());
+        }
+    }
+};
+
+    }
+}
+
+#endif /* __CU_SUBSCRIPTION_EVENT_H__ */
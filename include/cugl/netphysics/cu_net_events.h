@@ -31,5 +31,16 @@
 #include "CUGameStateEvent.h"
 #include "CUPhysSyncEvent.h"
 #include "CUPhysObjEvent.h"
+#include "CUPhysInputEvent.h"
+#include "CUPhysChecksumEvent.h"
+#include "CUClockSyncEvent.h"
+#include "CUPhysDeltaEvent.h"
+#include "CUPhysCheckpointEvent.h"
+#include "CUPhysWorldEvent.h"
+#include "CUPhysJointEvent.h"
+#include "CUPhysGroupEvent.h"
+#include "CUSequencedEvent.h"
+#include "CUSubscriptionEvent.h"
+#include "CUSchemaEvent.h"
 
 #endif /* __CU_NET_EVENTS_PKGS_H__ */
\ No newline at end of file
@@ -31,6 +31,7 @@
 #include "cu_net_events.h"
 #include "CULWDeserializer.h"
 #include "CULWSerializer.h"
+#include "CULWBitSerializer.h"
 #include "CUObstacleFactory.h"
 #include "CUNetPhysicsController.h"
 #include "CUNetEventController.h"
@@ -56,8 +56,14 @@
 #include <box2d/b2_fixture.h>
 #include <box2d/b2_world.h>
 #include <iostream>
+#include <vector>
 #include <cugl/scene2/graph/CUWireNode.h>
 
+/** The global id of an obstacle that has not been added to an ObstacleWorld */
+#define OBSTACLE_NO_ID  0xFFFFFFFFFFFFFFFFULL
+/** The pool of an obstacle that was not spawned from an ObstacleWorld pool */
+#define OBSTACLE_NO_POOL 0xFFFFFFFF
+
 namespace cugl {
     /**
      * The classes to represent 2-d physics.
@@ -123,8 +129,63 @@ protected:
     unsigned long _angFact;
     
     bool _shared;
+    /** The global id assigned by the ObstacleWorld (OBSTACLE_NO_ID if none) */
+    Uint64 _globalId;
+    /** Whether this client owns the obstacle for synchronization */
+    bool _owned;
+    /** The number of steps of ownership left (0 if ownership is permanent) */
+    Uint64 _ownedSteps;
+    /** The synchronization priority accumulated since this obstacle was last sent */
+    float _syncPriority;
+    /** The game-supplied weight for the synchronization priority */
+    float _syncWeight;
+    /** The interpolation method for remote updates (0 for the default) */
+    Uint8 _interpolation;
+    
+    /** The position of the body before the last physics step */
+    Vec2 _prevPosition;
+    /** The angle of the body before the last physics step */
+    float _prevAngle;
+    /** The fraction of a physics step to interpolate when drawing */
+    float _renderAlpha;
+    /** Whether the transform must be pushed to the scene graph on the next update */
+    bool _transformDirty;
+    /** The cached wireframe of the fixtures (see {@link ObstacleWireBatch}) */
+    std::shared_ptr<const Mesh<SpriteVertex2>> _wireMesh;
+    /** The first fixture when the wireframe was cached */
+    b2Fixture* _wireFixture;
     
     bool _isPosDirty, _isVelDirty, _isTypeDirty, _isAngleDirty, _isAngVelDirty, _isBoolConstDirty, _isFloatConstDirty;
+    /** The list of obstacles with dirty bits in the world of this obstacle (nullptr if none) */
+    std::vector<Obstacle*>* _dirtyList;
+    /** Whether this obstacle is in the dirty list of its world */
+    bool _inDirtyList;
+    /** The position of this obstacle in the obstacle list of its world */
+    size_t _worldIndex;
+    /** The world pool of this obstacle (OBSTACLE_NO_POOL if none) */
+    Uint32 _pool;
+    /** Whether the level of detail of the world has put this obstacle to sleep */
+    bool _parked;
+    /** The linear velocity of this obstacle when it was parked */
+    b2Vec2 _parkedVelocity;
+    /** The angular velocity of this obstacle when it was parked */
+    float _parkedSpin;
+    
+    /**
+     * Adds this obstacle to the dirty list of its world.
+     *
+     * This is called whenever a setter marks a dirty bit. It does nothing if
+     * the obstacle is not in a world, or is already in the list.
+     */
+    void markSharingDirty() {
+        if (_dirtyList != nullptr && !_inDirtyList) {
+            _dirtyList->push_back(this);
+            _inDirtyList = true;
+        }
+    }
+    
+    friend class ObstacleWorld;
+    friend class ObstacleWireBatch;
     
 #pragma mark -
 #pragma mark Scene Graph Internals
@@ -227,7 +288,8 @@ public:
         } else {
             _bodyinfo.type = value;
         }
-        if(_shared){ _isTypeDirty = true; };
+        _transformDirty = true;
+        if(_shared){ _isTypeDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -269,7 +331,8 @@ public:
         } else {
             _bodyinfo.position.Set(x,y);
         }
-        if(_shared){ _isPosDirty = true; };
+        _transformDirty = true;
+        if(_shared){ _isPosDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -292,7 +355,8 @@ public:
         } else {
             _bodyinfo.position.x = value;
         }
-        if(_shared){ _isPosDirty = true; };
+        _transformDirty = true;
+        if(_shared){ _isPosDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -315,7 +379,8 @@ public:
         } else {
             _bodyinfo.position.y = value;
         }
-        if(_shared){ _isPosDirty = true; };
+        _transformDirty = true;
+        if(_shared){ _isPosDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -340,7 +405,8 @@ public:
         } else {
             _bodyinfo.angle = value;
         }
-        if(_shared){ _isAngleDirty = true; };
+        _transformDirty = true;
+        if(_shared){ _isAngleDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -382,7 +448,7 @@ public:
         } else {
             _bodyinfo.linearVelocity.Set(x,y);
         }
-        if(_shared){ _isVelDirty = true; };
+        if(_shared){ _isVelDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -409,7 +475,7 @@ public:
         } else {
             _bodyinfo.linearVelocity.x = value;
         }
-        if(_shared){ _isVelDirty = true; };
+        if(_shared){ _isVelDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -436,7 +502,7 @@ public:
         } else {
             _bodyinfo.linearVelocity.y = value;
         }
-        if(_shared){ _isVelDirty = true; };
+        if(_shared){ _isVelDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -461,7 +527,7 @@ public:
         } else {
             _bodyinfo.angularVelocity = value;
         }
-        if(_shared){ _isAngVelDirty = true; };
+        if(_shared){ _isAngVelDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -494,7 +560,7 @@ public:
         } else {
             _bodyinfo.enabled = value;
         }
-        if(_shared){ _isBoolConstDirty = true; };
+        if(_shared){ _isBoolConstDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -512,6 +578,17 @@ public:
         return (_body != nullptr ? _body->IsAwake() : _bodyinfo.awake);
     }
     
+    /**
+     * Returns true if the level of detail of the world put this body to sleep
+     *
+     * A parked body is asleep because it is outside of every area of interest
+     * of its world (see {@link ObstacleWorld#setLODAreas}). Its velocity is
+     * saved, and restored when it is woken again.
+     *
+     * @return true if the level of detail of the world put this body to sleep
+     */
+    bool isParked() const { return _parked; }
+    
     /**
      * Sets whether the body is awake
      *
@@ -529,7 +606,8 @@ public:
         } else {
             _bodyinfo.awake = value;
         }
-        if(_shared){ _isBoolConstDirty = true; };
+        _transformDirty = true;
+        if(_shared){ _isBoolConstDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -564,7 +642,7 @@ public:
         } else {
             _bodyinfo.allowSleep = value;
         }
-        if(_shared){ _isBoolConstDirty = true; };
+        if(_shared){ _isBoolConstDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -609,7 +687,7 @@ public:
         } else {
             _bodyinfo.bullet = value;
         }
-        if(_shared){ _isBoolConstDirty = true; };
+        if(_shared){ _isBoolConstDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -636,7 +714,7 @@ public:
         } else {
             _bodyinfo.fixedRotation = value;
         }
-        if(_shared){ _isBoolConstDirty = true; };
+        if(_shared){ _isBoolConstDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -665,7 +743,7 @@ public:
         } else {
             _bodyinfo.gravityScale = value;
         }
-        if(_shared){ _isFloatConstDirty = true; };
+        if(_shared){ _isFloatConstDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -706,7 +784,7 @@ public:
         } else {
             _bodyinfo.linearDamping = value;
         }
-        if(_shared){ _isFloatConstDirty = true; };
+        if(_shared){ _isFloatConstDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -747,7 +825,7 @@ public:
         } else {
             _bodyinfo.angularDamping = value;
         }
-        if(_shared){ _isBoolConstDirty = true; };
+        if(_shared){ _isBoolConstDirty = true; markSharingDirty(); };
     }
     
     /**
@@ -975,7 +1053,7 @@ public:
         if (_body != nullptr) {
             _body->ResetMassData();
         }
-        if(_shared){ _isFloatConstDirty = true; };
+        if(_shared){ _isFloatConstDirty = true; markSharingDirty(); };
     }
 
 #pragma mark -
@@ -983,6 +1061,9 @@ public:
     
     void setShared(bool shared){
         _shared = shared;
+        if (_shared && isSharingDirty()) {
+            markSharingDirty();
+        }
     }
     
     bool isShared() const { return _shared; }
@@ -1004,6 +1085,154 @@ public:
     bool isAngVelDirty() const { return _isAngVelDirty; }
     bool isBoolConstDirty() const { return _isBoolConstDirty; }
     bool isFloatConstDirty() const { return _isFloatConstDirty; }
+    
+    /**
+     * Returns true if any of the sharing dirty bits are set.
+     *
+     * @return true if any of the sharing dirty bits are set.
+     */
+    bool isSharingDirty() const {
+        return _isPosDirty || _isVelDirty || _isTypeDirty || _isAngleDirty ||
+               _isAngVelDirty || _isBoolConstDirty || _isFloatConstDirty;
+    }
+    
+    /**
+     * Returns the global id of this obstacle.
+     *
+     * This id is assigned when the obstacle is added to an {@link ObstacleWorld},
+     * and is the same on all clients. If the obstacle has not been added to a
+     * world, this method returns OBSTACLE_NO_ID.
+     *
+     * @return the global id of this obstacle.
+     */
+    Uint64 getGlobalId() const { return _globalId; }
+    
+    /**
+     * Returns true if this obstacle has a global id.
+     *
+     * @return true if this obstacle has a global id.
+     */
+    bool hasGlobalId() const { return _globalId != OBSTACLE_NO_ID; }
+    
+    /**
+     * Sets the global id of this obstacle.
+     *
+     * This method is called by {@link ObstacleWorld} and should not be called
+     * directly.
+     *
+     * @param id    The global id of this obstacle
+     */
+    void setGlobalId(Uint64 id) { _globalId = id; }
+    
+    /**
+     * Returns true if this client owns this obstacle.
+     *
+     * The owner of an obstacle is responsible for synchronizing it.
+     *
+     * @return true if this client owns this obstacle.
+     */
+    bool isOwned() const { return _owned; }
+    
+    /**
+     * Returns the number of physics steps in the ownership lease.
+     *
+     * A value of 0 means the ownership is permanent (or the obstacle is not
+     * owned at all). This value is not counted down. The networked physics
+     * controller tracks the expiry of each lease itself.
+     *
+     * @return the number of physics steps in the ownership lease.
+     */
+    Uint64 getOwnedSteps() const { return _ownedSteps; }
+    
+    /**
+     * Sets this obstacle as owned for the given number of physics steps.
+     *
+     * A duration of 0 means the ownership is permanent.
+     *
+     * @param steps The number of steps of ownership
+     */
+    void setOwned(Uint64 steps) {
+        _owned = true;
+        _ownedSteps = steps;
+    }
+    
+    /**
+     * Releases ownership of this obstacle.
+     */
+    void clearOwned() {
+        _owned = false;
+        _ownedSteps = 0;
+    }
+    
+    /**
+     * Returns the synchronization priority of this obstacle.
+     *
+     * Priority accumulates every physics snapshot that this obstacle is not
+     * sent, and is reset when it is. Obstacles with the highest priority are
+     * sent first.
+     *
+     * @return the synchronization priority of this obstacle.
+     */
+    float getSyncPriority() const { return _syncPriority; }
+    
+    /**
+     * Adds to the synchronization priority of this obstacle.
+     *
+     * This can be used to make sure an important change (such as a collision)
+     * is sent as soon as possible. This amount is not scaled by the weight.
+     *
+     * @param amount    The priority to add
+     */
+    void addSyncPriority(float amount) { _syncPriority += amount; }
+    
+    /**
+     * Resets the synchronization priority of this obstacle to 0.
+     */
+    void clearSyncPriority() { _syncPriority = 0; }
+    
+    /**
+     * Returns the weight for the synchronization priority of this obstacle.
+     *
+     * The priority accumulated by the networked physics controller is scaled
+     * by this weight. The default weight is 1.
+     *
+     * @return the weight for the synchronization priority of this obstacle.
+     */
+    float getSyncWeight() const { return _syncWeight; }
+    
+    /**
+     * Sets the weight for the synchronization priority of this obstacle.
+     *
+     * The priority accumulated by the networked physics controller is scaled
+     * by this weight. The default weight is 1. An obstacle with weight 0 is never prioritized, and
+     * is only sent with full synchronizations.
+     *
+     * @param weight    The weight for the synchronization priority
+     */
+    void setSyncWeight(float weight) { _syncWeight = weight; }
+    
+    /**
+     * Returns the interpolation method for remote updates of this obstacle.
+     *
+     * The value is one of the methods of the networked physics controller
+     * (see {@link NetPhysicsController#InterpolationMethod}). A value of 0
+     * means that the controller uses its default method. This is the default.
+     *
+     * @return the interpolation method for remote updates of this obstacle.
+     */
+    Uint8 getInterpolation() const { return _interpolation; }
+    
+    /**
+     * Sets the interpolation method for remote updates of this obstacle.
+     *
+     * The value is one of the methods of the networked physics controller
+     * (see {@link NetPhysicsController#InterpolationMethod}). A value of 0
+     * means that the controller uses its default method. Any change takes
+     * effect at the next remote update.
+     *
+     * @param method    The interpolation method for remote updates
+     */
+    void setInterpolation(Uint8 method) { _interpolation = method; }
 
 #pragma mark -
 #pragma mark Garbage Collection
@@ -1027,6 +1256,17 @@ public:
      */
     void markRemoved(bool value) { _remove = value; }
     
+    /**
+     * Returns true if this obstacle was spawned from a world pool
+     *
+     * A pooled obstacle is never deactivated when it is garbage collected.
+     * Instead, it is disabled and returned to its pool to be spawned again.
+     * See {@link ObstacleWorld#createPool}.
+     *
+     * @return true if this obstacle was spawned from a world pool
+     */
+    bool isPooled() const { return _pool != OBSTACLE_NO_POOL; }
+    
     /**
      * Returns true if the shape information must be updated.
      *
@@ -1047,7 +1287,10 @@ public:
      *
      * @param value  whether the shape information must be updated.
      */
-    void markDirty(bool value) { _dirty = value; }
+    void markDirty(bool value) {
+        _dirty = value;
+        if (value) { _wireMesh = nullptr; }
+    }
     
 #pragma mark -
 #pragma mark Physics Methods
@@ -1114,17 +1357,114 @@ public:
      * @param delta Timing values from parent loop
      */
     virtual void update(float delta) {
-        if (_scene) { updateDebug(); }
-        if (_listener) { _listener(this); }
+        if (checkTransformDirty()) {
+            if (_scene) { updateDebug(); }
+            if (_listener) { _listener(this); }
+        }
         if (isDirty()) {
             createFixtures();
         }
     }
     
+    /**
+     * Returns true if the transform must be pushed to the scene graph.
+     *
+     * An obstacle only needs to update its debug wireframe and call its listener
+     * if its drawing transform may have changed. That is the case if the body is
+     * awake, if it is still being interpolated between steps, if its fixtures are
+     * dirty, or if it was moved by hand (see {@link #markTransformDirty}). It is
+     * also true for one update after the body falls asleep, to draw its final
+     * resting position. Static and sleeping bodies are otherwise skipped, so the
+     * cost of an update is proportional to the number of moving bodies.
+     *
+     * This method clears the dirty transform, and so should only be called
+     * once per update.
+     *
+     * @return true if the transform must be pushed to the scene graph.
+     */
+    bool checkTransformDirty() {
+        bool awake = _body != nullptr && _body->IsAwake();
+        bool result = awake || _transformDirty || _dirty;
+        if (!result && _renderAlpha < 1) {
+            result = _prevPosition != getPosition() || _prevAngle != getAngle();
+        }
+        _transformDirty = awake;
+        return result;
+    }
+    
+    /**
+     * Marks the transform of this obstacle as changed.
+     *
+     * The next update will push the transform to the scene graph, even if the
+     * body is static or asleep (see {@link #checkTransformDirty}). The setters
+     * of this class call this method automatically. You only need to call it
+     * if you move the Box2D body directly.
+     */
+    void markTransformDirty() { _transformDirty = true; }
+    
+    /**
+     * Records the current transform as the transform before a physics step.
+     *
+     * This is called by {@link ObstacleWorld} before the last (fixed) step of
+     * each frame, so that the obstacle can be drawn between steps. You should
+     * call it yourself after teleporting an obstacle, so that it does not
+     * appear to slide to its new position.
+     */
+    void snapshot() {
+        _prevPosition = getPosition();
+        _prevAngle = getAngle();
+    }
+    
+    /**
+     * Returns the fraction of a physics step to interpolate when drawing.
+     *
+     * This value is set by {@link ObstacleWorld#update} before this obstacle
+     * is updated. It is 1 unless the world is accumulating steps (see
+     * {@link ObstacleWorld#setAccumulating}).
+     *
+     * @return the fraction of a physics step to interpolate when drawing.
+     */
+    float getRenderAlpha() const { return _renderAlpha; }
+    
+    /**
+     * Returns the position at which to draw this obstacle.
+     *
+     * This is the position interpolated between the last two physics steps,
+     * according to {@link #getRenderAlpha}. Scene graph listeners should use
+     * this method instead of {@link #getPosition} for smooth motion.
+     *
+     * @return the position at which to draw this obstacle.
+     */
+    Vec2 getRenderPosition() const {
+        Vec2 pos = getPosition();
+        if (_renderAlpha >= 1) {
+            return pos;
+        }
+        return _prevPosition+(pos-_prevPosition)*_renderAlpha;
+    }
+    
+    /**
+     * Returns the angle at which to draw this obstacle.
+     *
+     * This is the angle interpolated between the last two physics steps,
+     * according to {@link #getRenderAlpha}. Scene graph listeners should use
+     * this method instead of {@link #getAngle} for smooth motion.
+     *
+     * @return the angle at which to draw this obstacle.
+     */
+    float getRenderAngle() const {
+        float angle = getAngle();
+        if (_renderAlpha >= 1) {
+            return angle;
+        }
+        return _prevAngle+(angle-_prevAngle)*_renderAlpha;
+    }
+    
     /**
      * Returns the active listener to this object.
      *
-     * Listeners are called after every physics update, to notify them of any
+     * Listeners are called after every physics update in which this object may
+     * have moved (see {@link #checkTransformDirty}), to notify them of any
      * changes in this object state.  For performance reasons, a physics 
      * obstacle can have only one listener.  If you need multiple objects 
      * listening to a single physics obstacle, the listener should handle the
@@ -1139,7 +1479,8 @@ public:
     /**
      * Sets the active listener to this object.
      *
-     * Listeners are called after every physics update, to notify them of any
+     * Listeners are called after every physics update in which this object may
+     * have moved (see {@link #checkTransformDirty}), to notify them of any
      * changes in this object state.  For performance reasons, a physics
      * obstacle can have only one listener.  If you need multiple objects
      * listening to a single physics obstacle, the listener should handle the
@@ -1149,6 +1490,7 @@ public:
      */
     void setListener(const std::function<void(Obstacle* obstacle)>& listener) {
         _listener = listener;
+        _transformDirty = true;
     }
     
 #pragma mark -
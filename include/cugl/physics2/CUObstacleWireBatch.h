@@ -0,0 +1,249 @@
+//
+//  CUObstacleWireBatch.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a batched alternative to the debug wireframes of the
+//  obstacles. The wireframe of each distinct shape is built once, as a line
+//  mesh in body coordinates, and shared by every obstacle with that shape.
+//  Each frame, the meshes are drawn to a SpriteBatch with the transform of
+//  their obstacle. So the debug view of a large level costs one batch of lines,
+//  instead of a scene graph node (and a draw call) per obstacle.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_OBSTACLE_WIRE_BATCH_H__
+#define __CU_OBSTACLE_WIRE_BATCH_H__
+
+#include <cugl/render/CUMesh.h>
+#include <cugl/render/CUSpriteVertex.h>
+#include <cugl/math/CUAffine2.h>
+#include <unordered_map>
+#include <string>
+#include <memory>
+
+namespace cugl {
+
+/** Forward reference to a sprite batch */
+class SpriteBatch;
+
+    /**
+     * The classes to represent 2-d physics.
+     *
+     * This namespace was chosen to future-proof the game engine. We will
+     * eventually want to add a 3-d physics engine as well, and this namespace
+     * will prevent any collisions with those scene graph nodes.
+     */
+    namespace physics2 {
+
+/** Forward reference to an obstacle */
+class Obstacle;
+/** Forward reference to the obstacle world */
+class ObstacleWorld;
+
+/**
+ * This class draws the debug wireframes of many obstacles in a single batch.
+ *
+ * The wireframe of an obstacle is the outline of its Box2D fixtures, in body
+ * coordinates. It is built the first time the obstacle is drawn, and again
+ * only when its shape changes (see {@link Obstacle#markDirty}). Obstacles with
+ * identical fixtures share the same mesh, so a level of a few repeated shapes
+ * only ever builds a few meshes. Each frame, every mesh is drawn with the render
+ * transform of its obstacle (see {@link Obstacle#getRenderPosition}), tinted by
+ * its debug color.
+ *
+ * This is an alternative to {@link Obstacle#setDebugScene}, which gives every
+ * obstacle its own wireframe node. The two should not be used together. Any
+ * sprite batch flushes its vertices in as few draw calls as possible, so the
+ * wireframes of a whole world are typically drawn with a single call.
+ *
+ * A wire batch is not thread-safe, and should only be used on the render thread.
+ */
+class ObstacleWireBatch {
+private:
+    /** The shared line meshes, indexed by the geometry of their fixtures */
+    std::unordered_map<std::string, std::weak_ptr<const Mesh<SpriteVertex2>>> _cache;
+    /** The number of segments in the wireframe of a circle */
+    Uint32 _segments;
+    /** The number of meshes built since the last call to {@link #resetStats} */
+    size_t _builds;
+
+    /**
+     * Returns the key of the fixture geometry of the given obstacle.
+     *
+     * Obstacles with the same key have identical fixtures, and so share the
+     * same wireframe.
+     *
+     * @param obj   The obstacle with the fixtures
+     *
+     * @return the key of the fixture geometry of the given obstacle.
+     */
+    static std::string makeKey(const Obstacle* obj);
+
+    /**
+     * Stores the wireframe of the fixtures of the given obstacle in the mesh.
+     *
+     * The mesh is a set of lines in the coordinates of the body.
+     *
+     * @param obj   The obstacle with the fixtures
+     * @param mesh  The mesh to store the wireframe
+     */
+    void buildMesh(const Obstacle* obj, Mesh<SpriteVertex2>& mesh) const;
+
+    /**
+     * Returns the wireframe of the given obstacle.
+     *
+     * The wireframe is cached in the obstacle, and is only rebuilt when its
+     * shape changes. This method returns nullptr if the obstacle has no body.
+     *
+     * @param obj   The obstacle to outline
+     *
+     * @return the wireframe of the given obstacle.
+     */
+    std::shared_ptr<const Mesh<SpriteVertex2>> acquire(Obstacle* obj);
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates a degenerate wire batch.
+     *
+     * This object has not been initialized and cannot be used.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    ObstacleWireBatch() : _segments(0), _builds(0) {}
+
+    /**
+     * Deletes this wire batch, disposing all resources
+     */
+    ~ObstacleWireBatch() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this wire batch.
+     *
+     * Meshes still held by obstacles are not deleted until the obstacles let
+     * go of them. A disposed wire batch can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes a wire batch with the given circle resolution.
+     *
+     * Circles (and the rounded ends of capsules) are outlined as regular
+     * polygons with the given number of segments.
+     *
+     * @param segments  The number of segments in the wireframe of a circle
+     *
+     * @return true if the wire batch is initialized properly, false otherwise.
+     */
+    bool init(Uint32 segments=16);
+
+    /**
+     * Returns a newly allocated wire batch with the given circle resolution.
+     *
+     * Circles (and the rounded ends of capsules) are outlined as regular
+     * polygons with the given number of segments.
+     *
+     * @param segments  The number of segments in the wireframe of a circle
+     *
+     * @return a newly allocated wire batch with the given circle resolution.
+     */
+    static std::shared_ptr<ObstacleWireBatch> alloc(Uint32 segments=16) {
+        std::shared_ptr<ObstacleWireBatch> result = std::make_shared<ObstacleWireBatch>();
+        return (result->init(segments) ? result : nullptr);
+    }
+
+#pragma mark Drawing
+    /**
+     * Draws the wireframe of the given obstacle to the sprite batch.
+     *
+     * The wireframe is drawn with the render transform of the obstacle, followed
+     * by the given transform (typically the drawing scale of the world). It is
+     * tinted by the debug color of the obstacle. The sprite batch must be active,
+     * and should have no texture.
+     *
+     * @param batch     The sprite batch to draw to
+     * @param obj       The obstacle to outline
+     * @param transform The transform from physics to screen coordinates
+     */
+    void draw(const std::shared_ptr<SpriteBatch>& batch, Obstacle* obj, const Affine2& transform);
+
+    /**
+     * Draws the wireframes of every obstacle in the world to the sprite batch.
+     *
+     * Each wireframe is drawn with the render transform of its obstacle,
+     * followed by the given transform (typically the drawing scale of the
+     * world). It is tinted by the debug color of the obstacle. The sprite batch
+     * must be active, and should have no texture. The color of the sprite batch
+     * is restored afterwards.
+     *
+     * @param batch     The sprite batch to draw to
+     * @param world     The world with the obstacles to outline
+     * @param transform The transform from physics to screen coordinates
+     */
+    void draw(const std::shared_ptr<SpriteBatch>& batch, const ObstacleWorld& world,
+              const Affine2& transform);
+
+#pragma mark Statistics
+    /**
+     * Returns the number of distinct wireframes still in use.
+     *
+     * This is the number of distinct fixture geometries among the obstacles
+     * drawn by this batch (that still exist).
+     *
+     * @return the number of distinct wireframes still in use.
+     */
+    size_t getCacheSize() const;
+
+    /**
+     * Returns the number of wireframes built since the last reset.
+     *
+     * A wireframe is only built when an obstacle with a new shape is drawn.
+     * A number that keeps growing from frame to frame suggests that shapes
+     * are being changed every frame.
+     *
+     * @return the number of wireframes built since the last reset.
+     */
+    size_t getBuilds() const { return _builds; }
+
+    /**
+     * Resets the number of wireframes built to zero.
+     */
+    void resetStats() { _builds = 0; }
+};
+
+    }
+}
+
+#endif /* __CU_OBSTACLE_WIRE_BATCH_H__ */
@@ -46,15 +46,21 @@
 #define __CU_PHYSICS_WORLD_H__
 
 #include <vector>
+#include <memory>
 #include <optional>
 #include <box2d/b2_world_callbacks.h>
 #include <box2d/b2_world.h>
+#include <box2d/b2_collision.h>
 #include <cugl/math/cu_math.h>
 #include "CUJointSet.h"
 
 class b2World;
 
 namespace cugl {
+
+// Forward declaration of the thread pool
+class ThreadPool;
+
     /**
      * The classes to represent 2-d physics.
      *
@@ -74,6 +80,207 @@ class Obstacle;
 /** Default number of position iterations for the constrain solvers */
 #define DEFAULT_WORLD_POSIT 2
 
+#pragma mark -
+#pragma mark Ray Hit
+/**
+ * This class is the result of a single ray-cast in a batch.
+ *
+ * A batch of ray-casts (see {@link ObstacleWorld#rayCastClosest}) writes one
+ * hit per ray into an array provided by the caller. A ray that hits nothing
+ * has a nullptr fixture, the ray end as its point, and a fraction of 1.
+ */
+class RayHit {
+public:
+    /** The closest fixture hit by the ray (nullptr if none) */
+    b2Fixture* fixture;
+    /** The point of intersection */
+    Vec2 point;
+    /** The normal vector at the point of intersection */
+    Vec2 normal;
+    /** The fraction of the ray before the point of intersection */
+    float fraction;
+    
+    /**
+     * Creates a hit for a ray that hits nothing.
+     */
+    RayHit() : fixture(nullptr), fraction(1) {}
+};
+
+#pragma mark -
+#pragma mark Physics Profile
+/**
+ * This class is a snapshot of the performance of an {@link ObstacleWorld}.
+ *
+ * The times are in milliseconds, and are rolling averages per call to
+ * update, taken over (roughly) the last second at 60 fps. The step times
+ * come from the Box2D profiler, and are summed over every step in an update.
+ * The counts are taken when the snapshot is made.
+ *
+ * This is the physics equivalent of NetcodeStats, and is intended to be
+ * displayed or logged alongside it.
+ */
+class PhysicsProfile {
+public:
+    /** The average time spent in b2World::Step */
+    float step;
+    /** The average time spent finding and updating contacts */
+    float collide;
+    /** The average time spent in the constraint solver */
+    float solve;
+    /** The average time spent in the broad-phase */
+    float broadphase;
+    /** The average time spent in the continuous (time of impact) solver */
+    float solveTOI;
+    /** The average time spent updating the obstacles after the steps */
+    float postStep;
+    /** The number of updates in the averages (up to the window size) */
+    size_t samples;
+    /** The number of Box2D bodies (including disabled pool bodies) */
+    size_t bodies;
+    /** The number of obstacles in the world */
+    size_t obstacles;
+    /** The number of Box2D contacts */
+    size_t contacts;
+    /** The number of Box2D joints */
+    size_t joints;
+    /** The number of broad-phase proxies */
+    size_t proxies;
+    
+    /**
+     * Creates a snapshot with all statistics zeroed
+     */
+    PhysicsProfile() :
+    step(0), collide(0), solve(0), broadphase(0), solveTOI(0), postStep(0),
+    samples(0), bodies(0), obstacles(0), contacts(0), joints(0), proxies(0) {}
+};
+
+#pragma mark -
+#pragma mark Contact Event
+/**
+ * This class is a compact record of a single contact callback.
+ *
+ * When contact buffering is enabled (see {@link ObstacleWorld#setContactBuffer}),
+ * the world records one of these for each contact callback during a step,
+ * instead of requiring game logic to run inside of the solver. The events can
+ * then be processed after the step, when it is safe to change the world.
+ *
+ * The fixtures are only valid as long as their obstacles are in the world.
+ * The normal and point are in world coordinates, and point from fixture A to
+ * fixture B. They are zero for an {@link Type#END} event.
+ */
+class ContactEvent {
+public:
+    /** The contact callback recorded by this event */
+    enum class Type : Uint8 {
+        /** Two fixtures began to touch */
+        BEGIN,
+        /** Two fixtures ceased to touch */
+        END,
+        /** The solver finished with two touching fixtures */
+        SOLVE
+    };
+    
+    /** The first fixture of the contact */
+    b2Fixture* fixtureA;
+    /** The second fixture of the contact */
+    b2Fixture* fixtureB;
+    /** The contact normal (from A to B) */
+    Vec2 normal;
+    /** The first contact point */
+    Vec2 point;
+    /** The total normal impulse of the solver (only for a SOLVE event) */
+    float impulse;
+    /** The contact callback recorded by this event */
+    Type type;
+};
+
+#pragma mark -
+#pragma mark World State
+/**
+ * This class is a saved copy of the dynamic state of an {@link ObstacleWorld}.
+ *
+ * A world state is a pair of flat arrays of plain data, one entry per Box2D
+ * body and one per Box2D contact. The arrays only grow, so once a state has
+ * been captured (or reserved) with enough room, capturing into it again does
+ * not allocate. That makes it cheap to capture and restore a world many times
+ * a second, as is necessary for rollback.
+ *
+ * Bodies are stored in the order of the Box2D body list. A state can only be
+ * restored to the same world, with the same bodies, that it was captured from.
+ * The body pointers are stored to validate this, and are never dereferenced.
+ *
+ * Contacts are sorted by their fixtures, so that they can be matched on
+ * restore. Only the warm starting impulses and the enabled flag are restored.
+ * Contacts that did not exist at capture have their impulses cleared.
+ */
+class WorldState {
+public:
+    /** Flag for a body that is awake */
+    static const Uint32 BODY_AWAKE   = 1;
+    /** Flag for a body that is enabled */
+    static const Uint32 BODY_ENABLED = 2;
+    /** Flag for a contact that is enabled */
+    static const Uint32 CONTACT_ENABLED  = 1;
+    /** Flag for a contact that is touching */
+    static const Uint32 CONTACT_TOUCHING = 2;
+    
+    /** The saved state of a single body */
+    typedef struct {
+        const b2Body* body; // the body (for validation only)
+        float x;            // the x-coordinate of the body origin
+        float y;            // the y-coordinate of the body origin
+        float angle;        // the body angle in radians (not normalized)
+        float vx;           // the x-component of the linear velocity
+        float vy;           // the y-component of the linear velocity
+        float vangular;     // the angular velocity in radians per second
+        Uint32 flags;       // a combination of BODY_AWAKE and BODY_ENABLED
+    } Body;
+    
+    /** The saved state of a single contact */
+    typedef struct {
+        const b2Fixture* fixtureA; // the first fixture of the contact
+        const b2Fixture* fixtureB; // the second fixture of the contact
+        int childA;                // the child index of the first fixture
+        int childB;                // the child index of the second fixture
+        Uint32 flags;              // a combination of CONTACT_ENABLED and CONTACT_TOUCHING
+        int pointCount;            // the number of manifold points
+        Uint32 ids[b2_maxManifoldPoints];           // the manifold point ids
+        float normalImpulse[b2_maxManifoldPoints];  // the normal impulse of each point
+        float tangentImpulse[b2_maxManifoldPoints]; // the tangent impulse of each point
+    } Contact;
+    
+    /** The saved bodies (only the first bodyCount are valid) */
+    std::vector<Body> bodies;
+    /** The number of saved bodies */
+    size_t bodyCount;
+    /** The saved contacts (only the first contactCount are valid) */
+    std::vector<Contact> contacts;
+    /** The number of saved contacts */
+    size_t contactCount;
+    
+    /**
+     * Creates an empty world state.
+     */
+    WorldState() : bodyCount(0), contactCount(0) {}
+    
+    /**
+     * Reserves room for the given number of bodies and contacts.
+     *
+     * Once a world state has enough room, capturing into it does not allocate.
+     *
+     * @param numBodies     The number of bodies to reserve
+     * @param numContacts   The number of contacts to reserve
+     */
+    void reserve(size_t numBodies, size_t numContacts) {
+        if (bodies.size() < numBodies) {
+            bodies.resize(numBodies);
+        }
+        if (contacts.size() < numContacts) {
+            contacts.resize(numContacts);
+        }
+    }
+};
+
 
 #pragma mark -
 #pragma mark World Controller
@@ -101,19 +308,70 @@ protected:
     int _itvelocity;
     /** The number of position iterations for the constrain solvers */
     int _itposition;
+    /** Whether the simulation is deterministic (fixed step and stable order) */
+    bool _deterministic;
+    /** Whether to accumulate frame time into fixed steps */
+    bool _accumulating;
+    /** The frame time not yet consumed by a fixed step */
+    float _accumulator;
+    /** The maximum number of fixed steps in a single update */
+    Uint32 _maxSubsteps;
+    /** The number of steps taken in the last update */
+    Uint32 _substeps;
+    /** The fraction of a step left in the accumulator after the last update */
+    float _alpha;
+    /** The thread pool for updating the obstacles (nullptr to update serially) */
+    std::shared_ptr<ThreadPool> _workers;
+    /** The minimum number of obstacles in a single parallel task */
+    Uint32 _grain;
+    /** Whether the obstacles are currently being updated in parallel */
+    bool _parallel;
+    /** The ring buffer of contact events (empty if not buffering) */
+    std::vector<ContactEvent> _contacts;
+    /** The position of the oldest event in the ring buffer */
+    size_t _contactHead;
+    /** The number of events in the ring buffer */
+    size_t _contactSize;
+    /** The number of events dropped since the last update */
+    size_t _contactDropped;
+    
+    /** A pool of disabled obstacles created from the same template */
+    class ObstaclePool {
+    public:
+        /** The function to create a new obstacle for this pool */
+        std::function<std::shared_ptr<Obstacle>()> factory;
+        /** The obstacles (with disabled bodies) ready to spawn */
+        std::vector<std::shared_ptr<Obstacle>> idle;
+        /** The total number of obstacles created for this pool */
+        size_t total;
+    };
+    /** The obstacle pools of this world */
+    std::vector<ObstaclePool> _pools;
+    /** The rolling averages of the performance of this world */
+    PhysicsProfile _profile;
     /** The current gravitational value of the world */
     Vec2 _gravity;
     /** UUID of the Application NetcodeConnection that established this world */
     std::string _UUID;
     
     Uint32 _shortUID;
+    /** The shard of this world among independently simulated worlds */
+    Uint8 _shard;
 
     
     /** The list of objects in this world */
     std::vector<std::shared_ptr<Obstacle>> _objects;
-    std::unordered_map<Uint64, std::shared_ptr<physics2::Obstacle>> _idToObj;
-    std::unordered_map<std::shared_ptr<physics2::Obstacle>, Uint64> _objToId;
-    std::unordered_map<std::shared_ptr<physics2::Obstacle>,Uint64> _owned;
+    /** The obstacles whose sharing dirty bits were set since the last clear */
+    std::vector<Obstacle*> _dirtyObjects;
+    /**
+     * The obstacles with global ids, indexed by id.
+     *
+     * A global id is a (namespace,counter) pair, where the namespace is the short
+     * UID of the client that created it. Counters are allocated sequentially, so
+     * each namespace is a dense array indexed by counter. There are only a handful
+     * of namespaces, so they are searched linearly.
+     */
+    std::vector<std::pair<Uint32, std::vector<std::shared_ptr<Obstacle>>>> _slots;
     
     std::unordered_map<Uint64, b2Joint*> _idToJoint;
     
@@ -130,6 +388,17 @@ protected:
     bool _filters;
     /** Whether or not to activate the destruction listener */
     bool _destroy;
+    
+    /** The areas of interest for the level of detail (empty to disable) */
+    std::vector<Rect> _lodAreas;
+    /** The distance a body may leave every area before it is parked */
+    float _lodMargin;
+    /** The number of updates between level of detail passes */
+    Uint32 _lodInterval;
+    /** The number of updates since the last level of detail pass */
+    Uint32 _lodCounter;
+    /** The number of parked obstacles after the last level of detail pass */
+    size_t _lodParked;
 
     /**
      * Immediately adds the obstacle to the physics world
@@ -149,6 +418,137 @@ public:
 
      void addJoint(Uint64 id, const b2JointDef& jointDef);
     
+private:
+    /**
+     * Releases the id slot of the given obstacle.
+     *
+     * After this method, the id of the obstacle may not be used to look it up.
+     *
+     * @param obj   The obstacle to release
+     */
+    void releaseSlot(Obstacle* obj);
+    
+    /**
+     * Assigns the id slot of the given obstacle.
+     *
+     * After this method, the obstacle may be looked up by the given id.
+     *
+     * @param obj   The obstacle to assign
+     * @param id    The global obstacle id
+     */
+    void claimSlot(const std::shared_ptr<Obstacle>& obj, Uint64 id);
+    
+    /**
+     * Updates the stored position of every obstacle starting at the given one.
+     *
+     * This must be called whenever obstacles are inserted or erased in the
+     * middle of the obstacle list.
+     *
+     * @param first The position of the first obstacle to update
+     */
+    void reindex(size_t first);
+    
+    /**
+     * Adds the given pooled obstacle back to the obstacle list.
+     *
+     * The obstacle keeps the global id that it had when it was last despawned,
+     * so that spawning does not allocate new id slots.
+     *
+     * @param obj   The obstacle to activate
+     */
+    void activatePooled(const std::shared_ptr<Obstacle>& obj);
+    
+    /**
+     * Disables the given pooled obstacle and returns it to its pool.
+     *
+     * The obstacle must already have been removed from the obstacle list.
+     *
+     * @param obj   The obstacle to retire
+     */
+    void retirePooled(const std::shared_ptr<Obstacle>& obj);
+    
+    /**
+     * Detaches the given obstacle from the dirty list of this world.
+     *
+     * This is called whenever an obstacle leaves the world, so that the
+     * dirty list never refers to an obstacle that may be deleted.
+     *
+     * @param obj   The obstacle to detach
+     */
+    void detachDirty(Obstacle* obj);
+    
+    /**
+     * Updates every obstacle after a physics step.
+     *
+     * This assigns the interpolation factor to each obstacle and then calls
+     * {@link Obstacle#update}. If this world has a thread pool, and there are
+     * more obstacles than the grain size, the obstacles are split into tasks of
+     * the grain size and updated in parallel. This method does not return until
+     * every obstacle is updated.
+     *
+     * @param dt    Number of seconds since last animation frame
+     * @param alpha The interpolation factor for each obstacle
+     */
+    void postStep(float dt, float alpha);
+    
+    /**
+     * Returns a new global id for an obstacle created by this world.
+     *
+     * The namespace of the id is the short UID of this world, tagged with its
+     * shard (see {@link #setShard}).
+     *
+     * @return a new global id for an obstacle created by this world.
+     */
+    Uint64 nextGlobalId();
+    
+    /**
+     * Runs the given loop body over a range, in parallel if possible.
+     *
+     * The range is split into chunks of the given grain size, and the body is
+     * called with the start and end of each chunk. If this world has no thread
+     * pool, or the range is no bigger than a chunk, the body is called once on
+     * the whole range. Otherwise the chunks are shared between the pool and the
+     * calling thread. Either way, this method does not return until the body
+     * has been called on the whole range.
+     *
+     * @param size  The size of the range
+     * @param grain The size of a chunk
+     * @param body  The loop body, called with the start and end of each chunk
+     */
+    void parallelFor(size_t size, size_t grain,
+                     const std::function<void(size_t,size_t)>& body) const;
+    
+    /**
+     * Adds the timings of an update to the rolling averages.
+     *
+     * @param total The Box2D timings summed over every step in the update
+     * @param post  The time spent updating the obstacles (in milliseconds)
+     */
+    void recordProfile(const b2Profile& total, float post);
+    
+    /**
+     * Parks or wakes the obstacles according to the level of detail.
+     *
+     * An obstacle that is more than {@link #getLODMargin} outside of every
+     * area of interest is put to sleep, and its velocity is saved. A parked
+     * obstacle that overlaps an area again is woken with its saved velocity.
+     * If there are no areas, every parked obstacle is woken.
+     *
+     * This pass only runs every {@link #getLODInterval} updates.
+     */
+    void updateLOD();
+    
+    /**
+     * Records a contact callback in the contact buffer.
+     *
+     * If the buffer is full, the oldest event is overwritten.
+     *
+     * @param type      The contact callback
+     * @param contact   The contact information
+     * @param impulse   The impulse produced by the solver (or nullptr)
+     */
+    void bufferContact(ContactEvent::Type type, b2Contact* contact, const b2ContactImpulse* impulse);
+    
     
 #pragma mark -
 #pragma mark Constructors
@@ -221,9 +621,27 @@ public:
      */
     bool init(const Rect bounds, const Vec2 gravity, std::string UUID);
 
-    const std::unordered_map<std::shared_ptr<physics2::Obstacle>,Uint64>& getObjToId() { return _objToId; }
-    const std::unordered_map<Uint64, std::shared_ptr<physics2::Obstacle>>& getIdToObj() { return _idToObj; }
-    std::unordered_map<std::shared_ptr<physics2::Obstacle>,Uint64>& getOwned() { return _owned; }
+    /**
+     * Returns the obstacle with the given global id.
+     *
+     * This method is constant time. If there is no obstacle with that id, this
+     * method returns nullptr. To get the id of an obstacle, use the method
+     * {@link Obstacle#getGlobalId}.
+     *
+     * @param id    The global obstacle id
+     *
+     * @return the obstacle with the given global id.
+     */
+    const std::shared_ptr<Obstacle>& getObstacle(Uint64 id) const;
+    
+    /**
+     * Returns true if there is an obstacle with the given global id.
+     *
+     * @param id    The global obstacle id
+     *
+     * @return true if there is an obstacle with the given global id.
+     */
+    bool hasObstacle(Uint64 id) const { return getObstacle(id) != nullptr; }
 
     const std::unordered_map<Uint64, b2Joint*>& getIdToJoint() { return _idToJoint; }
     
@@ -352,6 +770,197 @@ public:
      */
     void setPositionIterations(int position) { _itposition = position; }
     
+    /**
+     * Returns true if this world accumulates frame time into fixed steps.
+     *
+     * See {@link #setAccumulating}.
+     *
+     * @return true if this world accumulates frame time into fixed steps.
+     */
+    bool isAccumulating() const { return _accumulating; }
+    
+    /**
+     * Sets whether this world accumulates frame time into fixed steps.
+     *
+     * When accumulating, each call to update adds the frame time to an
+     * accumulator, and then takes as many steps of {@link #getStepsize} as fit
+     * (possibly none). So the simulation keeps up with real time, and is still
+     * reproducible. The time left over is exposed as {@link #getAlpha}, and
+     * each obstacle can be drawn between its last two steps with
+     * {@link Obstacle#getRenderPosition} and {@link Obstacle#getRenderAngle}.
+     *
+     * If the frame rate drops so far that more than {@link #getMaxSubsteps}
+     * steps are due, the extra time is dropped, and the simulation runs slower
+     * than real time. This prevents a slow frame from causing an even slower
+     * frame (the "spiral of death").
+     *
+     * Changing this value resets the accumulator.
+     *
+     * @param flag  Whether this world accumulates frame time into fixed steps
+     */
+    void setAccumulating(bool flag);
+    
+    /**
+     * Returns the maximum number of fixed steps in a single update.
+     *
+     * This value is only used when accumulating (see {@link #setAccumulating}).
+     * The default is 5.
+     *
+     * @return the maximum number of fixed steps in a single update.
+     */
+    Uint32 getMaxSubsteps() const { return _maxSubsteps; }
+    
+    /**
+     * Sets the maximum number of fixed steps in a single update.
+     *
+     * This value is only used when accumulating (see {@link #setAccumulating}).
+     * It must be at least 1.
+     *
+     * @param steps The maximum number of fixed steps in a single update.
+     */
+    void setMaxSubsteps(Uint32 steps) { _maxSubsteps = steps > 0 ? steps : 1; }
+    
+    /**
+     * Returns the number of steps taken by the last call to update.
+     *
+     * This is always 1 unless the world is accumulating.
+     *
+     * @return the number of steps taken by the last call to update.
+     */
+    Uint32 getSubsteps() const { return _substeps; }
+    
+    /**
+     * Returns the interpolation factor for drawing after the last update.
+     *
+     * This is the fraction of a fixed step left in the accumulator, in the
+     * range [0,1). It is 1 unless the world is accumulating.
+     *
+     * @return the interpolation factor for drawing after the last update.
+     */
+    float getAlpha() const { return _alpha; }
+    
+    /**
+     * Returns the thread pool for updating the obstacles after each step.
+     *
+     * See {@link #setThreadPool}.
+     *
+     * @return the thread pool for updating the obstacles after each step.
+     */
+    std::shared_ptr<ThreadPool> getThreadPool() const { return _workers; }
+    
+    /**
+     * Sets the thread pool for updating the obstacles after each step.
+     *
+     * By default, every call to update calls {@link Obstacle#update} on each
+     * obstacle in turn. With a thread pool, the obstacles are split into tasks
+     * of {@link #getParallelGrain} obstacles, which are updated in parallel. The
+     * calling thread takes part, so update still returns only once every
+     * obstacle is updated. Setting the pool to nullptr restores serial updates.
+     *
+     * This is only safe if every {@link Obstacle#update} (and every obstacle
+     * listener) touches nothing but its own obstacle and its own scene graph
+     * nodes. In particular, it may not add or remove obstacles, or change the
+     * shared state of an obstacle (which marks it dirty in this world). The
+     * default update only rebuilds fixtures when an obstacle is dirty, and this
+     * is done serially before the parallel tasks start. In debug builds, this
+     * world asserts if the world was modified during a parallel update.
+     *
+     * The pool may be shared with other systems, but tasks already in the pool
+     * will delay the update.
+     *
+     * @param pool  The thread pool for updating the obstacles
+     */
+    void setThreadPool(const std::shared_ptr<ThreadPool>& pool) { _workers = pool; }
+    
+    /**
+     * Returns the minimum number of obstacles in a single parallel task.
+     *
+     * A world with fewer obstacles than this is updated serially, even with
+     * a thread pool. The default is 256.
+     *
+     * @return the minimum number of obstacles in a single parallel task.
+     */
+    Uint32 getParallelGrain() const { return _grain; }
+    
+    /**
+     * Sets the minimum number of obstacles in a single parallel task.
+     *
+     * A world with fewer obstacles than this is updated serially, even with
+     * a thread pool. It must be at least 1.
+     *
+     * @param grain The minimum number of obstacles in a single parallel task.
+     */
+    void setParallelGrain(Uint32 grain) { _grain = grain > 0 ? grain : 1; }
+    
+    /**
+     * Copies the drawing transform of every obstacle into the given arrays.
+     *
+     * The transforms are stored as a structure of arrays, in the order of
+     * {@link #getObstacles}. Each array is resized to the number of obstacles.
+     * Each transform is the one returned by {@link Obstacle#getRenderPosition}
+     * and {@link Obstacle#getRenderAngle}, so it is interpolated if this world
+     * is accumulating. This allows a renderer to draw all of the obstacles in
+     * a single (vectorizable) loop, instead of with a listener per obstacle.
+     *
+     * The arrays are only reallocated if they grow, so they should be reused
+     * from frame to frame.
+     *
+     * @param xs        The array to store the x-coordinates
+     * @param ys        The array to store the y-coordinates
+     * @param angles    The array to store the angles
+     */
+    void exportTransforms(std::vector<float>& xs, std::vector<float>& ys,
+                          std::vector<float>& angles) const;
+    
+    /**
+     * Returns a snapshot of the performance of this world.
+     *
+     * The timings are rolling averages of the recent calls to {@link #update}
+     * (and {@link #step}). The counts are the current size of the world. The
+     * profiler is always on, and only costs a few clock reads per update.
+     *
+     * @return a snapshot of the performance of this world.
+     */
+    PhysicsProfile getProfile() const;
+    
+    /**
+     * Resets the rolling averages of the profiler.
+     *
+     * The next update starts the averages over.
+     */
+    void resetProfile() { _profile = PhysicsProfile(); }
+    
+    /**
+     * Returns true if this world is in deterministic mode.
+     *
+     * See {@link #setDeterministic}.
+     *
+     * @return true if this world is in deterministic mode.
+     */
+    bool isDeterministic() const { return _deterministic; }
+    
+    /**
+     * Sets whether this world is in deterministic mode.
+     *
+     * In deterministic mode, every call to update steps the world by exactly
+     * {@link #getStepsize}, regardless of {@link #isLockStep}, and the obstacles
+     * are kept sorted by global id. Two worlds that receive the same obstacles
+     * and the same forces at the same steps will then produce the same state,
+     * as long as the Box2D library is built with B2_DETERMINISTIC (this is the
+     * default). Use {@link #computeChecksum} to detect when they do not.
+     *
+     * The order of the Box2D bodies is the order in which the obstacles were
+     * added. Hence obstacles must be added in the same order on every machine
+     * within a step. This is the case when they are created by the simulation
+     * itself, but not when they arrive over the network.
+     *
+     * The iteration counts are not changed, but they must match on every
+     * machine. Enabling this mode sorts the existing obstacles.
+     *
+     * @param flag  Whether this world is in deterministic mode
+     */
+    void setDeterministic(bool flag);
+    
     /**
      * Returns the global gravity vector.
      *
@@ -380,10 +989,53 @@ public:
      * physics.  The primary method is the step() method in world.  This implementation
      * works for all applications and should not need to be overwritten.
      *
+     * If the world is accumulating (see {@link #setAccumulating}), this may take
+     * several steps, or none at all. The obstacles are updated once either way.
+     *
+     * This method empties the contact buffer (see {@link #setContactBuffer})
+     * before the first step. It also parks or wakes obstacles for the level of
+     * detail (see {@link #setLODAreas}).
+     *
      * @param dt Number of seconds since last animation frame
      */
     void update(float dt);
     
+    /**
+     * Executes exactly one step of the physics engine.
+     *
+     * This is the same as {@link #update} when the world is not accumulating.
+     * When it is, this method ignores the accumulator, and draws every obstacle
+     * at its current transform. It is intended for replaying steps (such as for
+     * rollback), which must not disturb the timing of the real frames.
+     *
+     * @param dt Number of seconds since last animation frame
+     */
+    void step(float dt);
+    
+    /**
+     * Executes a single update of each of the given worlds, in parallel.
+     *
+     * This is the same as calling {@link #update} on each world in turn, except
+     * that the worlds are updated at the same time on the given thread pool. The
+     * calling thread takes part, so this method only returns once every world is
+     * updated. Without a pool (or with only one world), the worlds are updated
+     * serially.
+     *
+     * This is only safe if the worlds never interact, as they are independent
+     * Box2D worlds. Every callback of a world (the contact callbacks, and every
+     * obstacle update and listener) may run on a pool thread, at the same time
+     * as the callbacks of the other worlds. So they may not touch any state that
+     * is shared between the worlds without their own synchronization. A world may
+     * still have its own thread pool (see {@link #setThreadPool}), and it may be
+     * the same pool.
+     *
+     * @param worlds    The worlds to update
+     * @param dt        Number of seconds since last animation frame
+     * @param pool      The thread pool for the updates (may be nullptr)
+     */
+    static void updateAll(const std::vector<std::shared_ptr<ObstacleWorld>>& worlds, float dt,
+                          const std::shared_ptr<ThreadPool>& pool);
+    
     /**
      * Returns the bounds for the world controller.
      *
@@ -402,6 +1054,154 @@ public:
      */
     bool inBounds(Obstacle* obj);
     
+    /**
+     * Captures the dynamic state of this world into the given state.
+     *
+     * This saves the transform, velocity and sleep state of every body, and
+     * the warm starting impulses of every contact. It does not save fixtures,
+     * joints or obstacle properties, which are assumed to be unchanged on
+     * restore. This method does not allocate if the state already has enough
+     * room (see {@link WorldState#reserve}).
+     *
+     * This method may not be called during a physics step.
+     *
+     * @param state The state to store the result
+     */
+    void captureState(WorldState& state) const;
+    
+    /**
+     * Restores the dynamic state of this world from the given state.
+     *
+     * The state must have been captured from this world, and no bodies may
+     * have been added or removed since. Otherwise, this method returns false
+     * and does not change the world.
+     *
+     * Box2D does not expose the sleep timer, the order of its contacts, or the
+     * touching flag of contacts. Hence bodies whose velocity changed restart
+     * their sleep timer, and contacts recompute the touching flag on the next
+     * step. Freely moving bodies replay to within float rounding. Stacked bodies
+     * are sensitive to the contact order, and may drift slightly.
+     *
+     * This method may not be called during a physics step.
+     *
+     * @param state The state to restore
+     *
+     * @return true if the state was restored
+     */
+    bool restoreState(const WorldState& state);
+    
+    /**
+     * Returns a checksum of the dynamic state of this world.
+     *
+     * The checksum covers the global id, position, angle, velocities and
+     * sleep state of every non-static obstacle, in the order of the global ids.
+     * It hashes the exact bits of each value, so two worlds have the same checksum
+     * only if they are bit identical. This is intended for deterministic mode
+     * (see {@link #setDeterministic}), where peers can compare checksums each
+     * step instead of the state itself.
+     *
+     * This method does not allocate and is linear in the number of obstacles.
+     *
+     * @return a checksum of the dynamic state of this world.
+     */
+    Uint64 computeChecksum() const;
+    
+    
+#pragma mark -
+#pragma mark Level of Detail
+    /**
+     * Returns the areas of interest for the level of detail.
+     *
+     * See {@link #setLODAreas} for more information.
+     *
+     * @return the areas of interest for the level of detail.
+     */
+    const std::vector<Rect>& getLODAreas() const { return _lodAreas; }
+    
+    /**
+     * Sets the areas of interest for the level of detail.
+     *
+     * Box2D spends nothing on a sleeping body. So on a large map, the bodies
+     * far from every player can be put to sleep (parked) without changing
+     * anything that a player could see. An obstacle is parked once it is more
+     * than {@link #getLODMargin} outside of every area, and it is woken as soon
+     * as it overlaps an area again. Its velocity is saved while it is parked,
+     * so it resumes its motion when woken. A parked body still wakes up as
+     * usual if an awake body collides with it.
+     *
+     * These areas should cover every player, such as the view of each player
+     * (see {@link netphysics::NetPhysicsController#setPeerView}). Static bodies
+     * and bodies with joints are never parked. Neither are shared obstacles
+     * that this client does not own, as their state comes from their owner.
+     * In deterministic mode (see {@link #setDeterministic}), every client
+     * must use the same areas.
+     *
+     * An empty list disables the level of detail, and wakes every parked
+     * obstacle at the next update.
+     *
+     * @param areas The areas of interest in physics coordinates
+     */
+    void setLODAreas(const std::vector<Rect>& areas);
+    
+    /**
+     * Removes all areas of interest, disabling the level of detail.
+     *
+     * Every parked obstacle is woken at the next update.
+     */
+    void clearLODAreas() { _lodAreas.clear(); _lodCounter = 0; }
+    
+    /**
+     * Returns the distance a body may leave every area before it is parked.
+     *
+     * Bodies are woken as soon as they overlap an area, but are only parked
+     * once they are this far outside of all of them. This keeps bodies at
+     * the edge of an area from waking and sleeping every update.
+     *
+     * @return the distance a body may leave every area before it is parked.
+     */
+    float getLODMargin() const { return _lodMargin; }
+    
+    /**
+     * Sets the distance a body may leave every area before it is parked.
+     *
+     * Bodies are woken as soon as they overlap an area, but are only parked
+     * once they are this far outside of all of them. This keeps bodies at
+     * the edge of an area from waking and sleeping every update.
+     *
+     * @param margin    The distance in physics coordinates
+     */
+    void setLODMargin(float margin) { _lodMargin = margin; }
+    
+    /**
+     * Returns the number of updates between level of detail passes.
+     *
+     * Each pass visits every obstacle, so it need not run every update. A
+     * body cannot move very far in a few updates, and the margin (see
+     * {@link #setLODMargin}) should account for this.
+     *
+     * @return the number of updates between level of detail passes.
+     */
+    Uint32 getLODInterval() const { return _lodInterval; }
+    
+    /**
+     * Sets the number of updates between level of detail passes.
+     *
+     * Each pass visits every obstacle, so it need not run every update. A
+     * body cannot move very far in a few updates, and the margin (see
+     * {@link #setLODMargin}) should account for this.
+     *
+     * @param interval  The number of updates between passes (at least 1)
+     */
+    void setLODInterval(Uint32 interval) { _lodInterval = std::max(interval,(Uint32)1); }
+    
+    /**
+     * Returns the number of parked obstacles.
+     *
+     * This value is only updated by a level of detail pass.
+     *
+     * @return the number of parked obstacles.
+     */
+    size_t getParkedCount() const { return _lodParked; }
     
 #pragma mark -
 #pragma mark Object Management
@@ -410,10 +1210,74 @@ public:
      *
      * @return a read-only reference to the list of active obstacles.
      */
-    const std::vector<std::shared_ptr<Obstacle>>& getObstacles() { return _objects; }
+    const std::vector<std::shared_ptr<Obstacle>>& getObstacles() const { return _objects; }
+    
+    /**
+     * Returns the obstacles whose sharing dirty bits have been set.
+     *
+     * An obstacle is added to this list when a setter first marks one of its
+     * dirty bits (see {@link Obstacle#isSharingDirty}), and stays there until
+     * {@link #clearDirtyObstacles} is called. Hence the list is in the order
+     * that the obstacles were changed, and has no duplicates. An obstacle may
+     * be in the list even if its dirty bits were since cleared by hand.
+     *
+     * This allows the networking layer to find the changed obstacles without
+     * scanning the entire world.
+     *
+     * @return the obstacles whose sharing dirty bits have been set.
+     */
+    const std::vector<Obstacle*>& getDirtyObstacles() const { return _dirtyObjects; }
+    
+    /**
+     * Empties the list of dirty obstacles.
+     *
+     * This does not clear the dirty bits of the obstacles themselves. An
+     * obstacle that is changed again is readded to the list.
+     */
+    void clearDirtyObstacles();
 
     void setShortUID(Uint32 uid) { _shortUID = uid; }
 
+    /**
+     * Returns the shard of this world.
+     *
+     * See {@link #setShard}.
+     *
+     * @return the shard of this world.
+     */
+    Uint8 getShard() const { return _shard; }
+
+    /**
+     * Sets the shard of this world.
+     *
+     * A game may split disconnected play areas into several independent worlds
+     * (see {@link #updateAll}). The shard is stored in the namespace of every
+     * global id allocated by this world, so ids are unique across all of the
+     * worlds, and {@link #shardOf} recovers the world of any id. The shard must
+     * be set before any obstacles are added, and must be less than 255. The
+     * default is 0, which leaves the ids exactly as they were with one world.
+     *
+     * With a nonzero shard, the short UID must fit in 24 bits.
+     *
+     * @param shard The shard of this world
+     */
+    void setShard(Uint8 shard);
+
+    /**
+     * Returns the shard of the world that allocated the given global id.
+     *
+     * See {@link #setShard}. Ids of the initial obstacles (see {@link #addInitObstacle})
+     * of the world with shard 0 are also in shard 0.
+     *
+     * @param id    The global obstacle id
+     *
+     * @return the shard of the world that allocated the given global id.
+     */
+    static Uint8 shardOf(Uint64 id) {
+        Uint8 shard = (Uint8)(id >> 56);
+        return shard == 0xFF ? 0 : shard;
+    }
+
     /**
      * Immediately adds the obstacle to the physics world
      *
@@ -466,7 +1330,8 @@ public:
      *
      * Removing an obstacle does not automatically delete the obstacle itself.
      * However, this world releases ownership, which may lead to it being
-     * garbage collected.
+     * garbage collected. Pooled obstacles are returned to their pool instead
+     * (see {@link #createPool}).
      *
      * This method is the efficient, preferred way to remove objects.
      */
@@ -476,11 +1341,148 @@ public:
      * Remove all objects, emptying this physics world.
      *
      * This method is different from {@link dispose()} in that the world can
-     * still receive new objects.
+     * still receive new objects. All obstacle pools are deleted.
      */
     void clear();
+    
+    /**
+     * Removes all objects, keeping the Box2D world and the obstacle pools.
+     *
+     * This method is intended for restarting a round. Unlike {@link clear()}
+     * or {@link dispose()}, the Box2D world is not rebuilt. Its allocators
+     * keep the memory of the destroyed bodies, fixtures and joints, and so the
+     * next round reuses it instead of allocating. Spawned pool obstacles are
+     * returned to their pools rather than destroyed, so that the pools (see
+     * {@link #createPool}) are the cheapest way to build the next round.
+     *
+     * The obstacle ids start over, so that {@link #addInitObstacle} gives the
+     * same ids as in the first round. Hence, in a networked game, every client
+     * must reset its world at the same time. All other settings of this world
+     * (including the callbacks) are unchanged.
+     */
+    void reset();
 
     
+#pragma mark -
+#pragma mark Obstacle Pools
+    /**
+     * Creates a pool of obstacles for the given template, returning its key.
+     *
+     * A pool is for obstacles that are spawned and despawned in bursts, like
+     * bullets or debris. The factory creates a new obstacle from the template,
+     * and this world creates count of them immediately. Each one has a body
+     * in the Box2D world, but the body is disabled, so it takes no part in the
+     * simulation. Spawning an obstacle only resets and enables its body, and
+     * despawning it only disables the body. Hence, as long as a pool has
+     * enough obstacles, neither allocates.
+     *
+     * Pooled obstacles keep their global ids between spawns, and are intended
+     * for obstacles local to this world. They should not be shared.
+     *
+     * @param factory   The function to create a new obstacle for the pool
+     * @param count     The number of obstacles to create now
+     *
+     * @return the key of the new pool
+     */
+    Uint32 createPool(const std::function<std::shared_ptr<Obstacle>()>& factory, size_t count);
+    
+    /**
+     * Ensures that the given pool has at least count obstacles ready to spawn.
+     *
+     * The obstacle list of this world is also reserved so that spawning all of
+     * them does not reallocate it.
+     *
+     * @param pool  The pool key
+     * @param count The number of obstacles to have ready
+     */
+    void reservePool(Uint32 pool, size_t count);
+    
+    /**
+     * Returns the number of obstacles in the given pool ready to spawn.
+     *
+     * @param pool  The pool key
+     *
+     * @return the number of obstacles in the given pool ready to spawn.
+     */
+    size_t getPoolIdle(Uint32 pool) const { return _pools[pool].idle.size(); }
+    
+    /**
+     * Returns the total number of obstacles created for the given pool.
+     *
+     * This includes both the obstacles in the world and the ones ready to spawn.
+     *
+     * @param pool  The pool key
+     *
+     * @return the total number of obstacles created for the given pool.
+     */
+    size_t getPoolSize(Uint32 pool) const { return _pools[pool].total; }
+    
+    /**
+     * Spawns an obstacle from the given pool, returning it.
+     *
+     * The obstacle is placed at the given position, with the given angle and
+     * linear velocity, no angular velocity, and is awake. Any other state is
+     * what it was when it was despawned. If the pool is empty, it is grown
+     * with the factory, which allocates.
+     *
+     * @param pool      The pool key
+     * @param pos       The initial position
+     * @param angle     The initial angle
+     * @param velocity  The initial linear velocity
+     *
+     * @return the spawned obstacle
+     */
+    const std::shared_ptr<Obstacle>& spawn(Uint32 pool, const Vec2 pos, float angle=0,
+                                           const Vec2 velocity=Vec2::ZERO);
+    
+    /**
+     * Spawns several obstacles from the given pool.
+     *
+     * Obstacle ii is placed at positions[ii] with velocity velocities[ii] (or
+     * no velocity if velocities is nullptr) and no rotation. If results is not
+     * nullptr, the spawned obstacles are stored there. The pool is grown at
+     * most once, if it does not have enough obstacles.
+     *
+     * @param pool          The pool key
+     * @param positions     The initial positions
+     * @param velocities    The initial linear velocities (or nullptr)
+     * @param count         The number of obstacles to spawn
+     * @param results       The array to store the spawned obstacles (or nullptr)
+     */
+    void spawn(Uint32 pool, const Vec2* positions, const Vec2* velocities, size_t count,
+               std::shared_ptr<Obstacle>* results=nullptr);
+    
+    /**
+     * Returns a pooled obstacle to its pool immediately.
+     *
+     * Unlike {@link #removeObstacle}, this method is constant time. The last
+     * obstacle in the obstacle list takes the place of this one. The only
+     * exception is deterministic mode, where the order of the obstacles must
+     * be preserved, and so this method is linear time.
+     *
+     * Marking a pooled obstacle for removal and calling {@link #garbageCollect}
+     * also returns it to its pool. That is the better choice for despawning
+     * many obstacles at once in deterministic mode.
+     *
+     * @param obj   The pooled obstacle to despawn
+     */
+    void despawn(Obstacle* obj);
+    
+    /**
+     * Returns several pooled obstacles to their pools immediately.
+     *
+     * This is the same as calling {@link #despawn} on each obstacle.
+     *
+     * @param objs  The pooled obstacles to despawn
+     * @param count The number of obstacles to despawn
+     */
+    void despawn(Obstacle* const* objs, size_t count) {
+        for(size_t ii = 0; ii < count; ii++) {
+            despawn(objs[ii]);
+        }
+    }
+    
+    
 #pragma mark -
 #pragma mark Collision Callback Functions
     /**
@@ -503,6 +1505,82 @@ public:
      */
     bool enabledCollisionCallbacks() const { return _collide; }
     
+    /**
+     * Sets the capacity of the contact buffer.
+     *
+     * A world with a contact buffer records a {@link ContactEvent} for every
+     * call to BeginContact, EndContact and PostSolve, in a ring buffer of the
+     * given capacity. The buffer is emptied at the start of each call to
+     * {@link #update}, so after an update it holds the events of every step in
+     * that update. Steps taken with {@link #step} (such as for rollback) add to
+     * the buffer without emptying it. If there are more events than the
+     * capacity, the oldest are dropped.
+     *
+     * This allows game logic to respond to contacts after the step, when it
+     * is safe to modify the world, and keeps the solver free of closures.
+     * Buffering is independent of {@link #activateCollisionCallbacks}. The
+     * {@link #beforeSolve} callback is never buffered, since it must be able
+     * to modify the contact.
+     *
+     * A capacity of 0 disables buffering, which is the default.
+     *
+     * @param capacity  The capacity of the contact buffer
+     */
+    void setContactBuffer(size_t capacity);
+    
+    /**
+     * Returns the capacity of the contact buffer.
+     *
+     * See {@link #setContactBuffer}.
+     *
+     * @return the capacity of the contact buffer.
+     */
+    size_t getContactBuffer() const { return _contacts.size(); }
+    
+    /**
+     * Returns the number of contact events recorded since the last update.
+     *
+     * This is never more than the capacity of the buffer.
+     *
+     * @return the number of contact events recorded since the last update.
+     */
+    size_t getContactCount() const { return _contactSize; }
+    
+    /**
+     * Returns the contact event at the given position.
+     *
+     * The events are in the order that they were recorded, with the oldest at
+     * position 0. The position must be less than {@link #getContactCount}.
+     *
+     * @param pos   The event position
+     *
+     * @return the contact event at the given position.
+     */
+    const ContactEvent& getContact(size_t pos) const {
+        return _contacts[(_contactHead+pos) % _contacts.size()];
+    }
+    
+    /**
+     * Returns the number of contact events dropped since the last update.
+     *
+     * Events are dropped when the buffer is full. If this is not zero, the
+     * buffer should be made larger.
+     *
+     * @return the number of contact events dropped since the last update.
+     */
+    size_t getContactsDropped() const { return _contactDropped; }
+    
+    /**
+     * Empties the contact buffer.
+     *
+     * This is done automatically at the start of each call to {@link #update}.
+     */
+    void clearContacts() {
+        _contactHead = 0;
+        _contactSize = 0;
+        _contactDropped = 0;
+    }
+    
     /**
      * Called when two fixtures begin to touch
      *
@@ -574,7 +1652,10 @@ public:
      * @param  contact  the contact information
      */
     void BeginContact(b2Contact* contact) override {
-        if (onBeginContact != nullptr) {
+        if (!_contacts.empty()) {
+            bufferContact(ContactEvent::Type::BEGIN,contact,nullptr);
+        }
+        if (_collide && onBeginContact != nullptr) {
             onBeginContact(contact);
         }
     }
@@ -588,7 +1669,10 @@ public:
      * @param  contact  the contact information
      */
     void EndContact(b2Contact* contact) override {
-        if (onEndContact != nullptr) {
+        if (!_contacts.empty()) {
+            bufferContact(ContactEvent::Type::END,contact,nullptr);
+        }
+        if (_collide && onEndContact != nullptr) {
             onEndContact(contact);
         }
     }
@@ -615,7 +1699,7 @@ public:
      * @param  oldManifold  the contact manifold last iteration
      */
     void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) override {
-        if (beforeSolve != nullptr) {
+        if (_collide && beforeSolve != nullptr) {
             beforeSolve(contact,oldManifold);
         }
     }
@@ -638,7 +1722,10 @@ public:
      * @param  impulse  the impulse produced by the solver
      */
     void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) override {
-        if (afterSolve != nullptr) {
+        if (!_contacts.empty()) {
+            bufferContact(ContactEvent::Type::SOLVE,contact,impulse);
+        }
+        if (_collide && afterSolve != nullptr) {
             afterSolve(contact,impulse);
         }
     }
@@ -752,8 +1839,8 @@ public:
     void SayGoodbye(b2Joint* joint) override {
         Uint64 id = 0;
         for (auto it = _idToJoint.begin(); it != _idToJoint.end(); it++) {
+            // Box2D destroys the joint itself after this call
             if (it->second == joint) {
-                _world->DestroyJoint(joint);
                 id = it->first;
             }
         }
@@ -806,6 +1893,53 @@ public:
                                      const Vec2 normal, float fraction)> callback,
                  const Vec2 point1, const Vec2 point2) const;
     
+    /**
+     * Ray-casts the world for the closest fixture along each of the given rays.
+     *
+     * Ray ii goes from starts[ii] to ends[ii], and its closest hit is stored in
+     * hits[ii]. A ray that hits nothing has a hit with a nullptr fixture and a
+     * fraction of 1. Like {@link #rayCast}, each ray ignores the shapes that
+     * contain its starting point.
+     *
+     * Ray-casts only read the world, so a batch larger than a single task is
+     * split across the thread pool (see {@link #setThreadPool}). This method
+     * does not allocate unless it uses the pool, and may not be called during
+     * a physics step.
+     *
+     * @param starts    The ray starting points
+     * @param ends      The ray ending points
+     * @param hits      The array to store the closest hits
+     * @param count     The number of rays
+     *
+     * @return the number of rays that hit a fixture
+     */
+    size_t rayCastClosest(const Vec2* starts, const Vec2* ends,
+                          RayHit* hits, size_t count) const;
+    
+    /**
+     * Queries the world for the fixtures that potentially overlap each of the given AABBs.
+     *
+     * The fixtures for box ii are stored in fixtures[ii*limit], up to limit
+     * fixtures per box, and their number is stored in counts[ii]. Hence fixtures
+     * must have room for count*limit values. A box that overlaps more than limit
+     * fixtures has only the first limit that Box2D finds.
+     *
+     * Queries only read the world, so a batch larger than a single task is
+     * split across the thread pool (see {@link #setThreadPool}). This method
+     * does not allocate unless it uses the pool, and may not be called during
+     * a physics step.
+     *
+     * @param boxes     The axis-aligned bounding boxes
+     * @param count     The number of boxes
+     * @param fixtures  The array to store the fixtures
+     * @param limit     The maximum number of fixtures per box
+     * @param counts    The array to store the number of fixtures per box
+     *
+     * @return the total number of fixtures found
+     */
+    size_t queryAABB(const Rect* boxes, size_t count, b2Fixture** fixtures,
+                     size_t limit, size_t* counts) const;
+    
 };
     }
 }
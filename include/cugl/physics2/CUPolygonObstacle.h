@@ -48,6 +48,9 @@
 
 #include "CUObstacle.h"
 #include <cugl/math/CUPoly2.h>
+#include <box2d/b2_polygon_shape.h>
+#include <memory>
+#include <vector>
 
 namespace cugl {
     /**
@@ -59,6 +62,72 @@ namespace cugl {
      */
     namespace physics2 {
 
+#pragma mark -
+#pragma mark Polygon Shapes
+/**
+ * An immutable set of convex Box2D shapes for a polygon.
+ *
+ * Box2D only supports convex shapes with a bounded number of vertices. So a
+ * polygon is split into convex pieces. The triangles of the polygon are
+ * merged greedily across shared edges for as long as the result is convex and
+ * has no more than b2_maxPolygonVertices vertices. This usually gives far
+ * fewer shapes (and so fewer fixtures and broad-phase proxies) than one per
+ * triangle.
+ *
+ * These shapes are cached by geometry. All polygon obstacles with the same
+ * polygon (relative to their position) share the same shapes, which are
+ * only computed once. The shapes are released when the last obstacle using
+ * them is deleted. The cache is thread safe, so obstacles may be created
+ * on a loading thread.
+ */
+class PolygonShapes {
+private:
+    /** The polygon vertices relative to the origin (the cache key) */
+    std::vector<Vec2> _vertices;
+    /** The polygon triangulation (the cache key) */
+    std::vector<Uint32> _indices;
+    /** The convex shapes for the polygon */
+    std::vector<b2PolygonShape> _shapes;
+    
+public:
+    /**
+     * Returns the shapes for the given polygon and origin.
+     *
+     * The shapes are relative to the origin, which is the position of the
+     * body. If these shapes are already in the cache, this method does not
+     * compute them again.
+     *
+     * @param poly      The polygon
+     * @param origin    The origin of the shapes
+     *
+     * @return the shapes for the given polygon and origin.
+     */
+    static std::shared_ptr<const PolygonShapes> get(const Poly2& poly, const Vec2 origin);
+    
+    /**
+     * Returns the number of shape sets currently in the cache.
+     *
+     * @return the number of shape sets currently in the cache.
+     */
+    static size_t getCacheSize();
+    
+    /**
+     * Returns the number of convex shapes in this set.
+     *
+     * @return the number of convex shapes in this set.
+     */
+    size_t size() const { return _shapes.size(); }
+    
+    /**
+     * Returns the convex shape at the given position.
+     *
+     * @param pos   The shape position
+     *
+     * @return the convex shape at the given position.
+     */
+    const b2PolygonShape* at(size_t pos) const { return &_shapes[pos]; }
+};
+
 #pragma mark -
 #pragma mark Polygon Obstacle
 
@@ -67,19 +136,20 @@ namespace cugl {
  *
  * The polygon can be any one that is representable by a Poly2 object.  That means that
  * it does not need to be convex, but it cannot have holes or self intersections.
+ *
+ * The fixtures are the convex pieces of the polygon, which are shared with
+ * every other obstacle of the same shape (see {@link PolygonShapes}).
  */
 class PolygonObstacle : public Obstacle {
 protected:
     /** The polygon vertices (for resizing) */
     Poly2 _polygon;
-    /** Shape information for this physics object */
-    b2PolygonShape* _shapes;
+    /** Shape information for this physics object (shared with similar obstacles) */
+    std::shared_ptr<const PolygonShapes> _shapes;
     /** A cache value for the fixtures (for resizing) */
-    b2Fixture** _geoms;
+    std::vector<b2Fixture*> _geoms;
     /** Anchor point to synchronize with the scene graph */
     Vec2 _anchor;
-    /** In case the number of polygons changes */
-    int _fixCount;
     
     
 #pragma mark -
@@ -119,7 +189,7 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
      * the heap, use one of the static constructors instead.
      */
-    PolygonObstacle(void) : Obstacle(), _shapes(nullptr), _geoms(nullptr) { }
+    PolygonObstacle(void) : Obstacle(), _shapes(nullptr) { }
     
     /**
      * Deletes this physics object and all of its resources.
@@ -36,5 +36,6 @@
 #include "CUPolygonObstacle.h"
 #include "CUCapsuleObstacle.h"
 #include "CUObstacleSelector.h"
+#include "CUObstacleWireBatch.h"
 
 #endif /* __CU_PHYSICS_2_PKG_H__ */
@@ -0,0 +1,289 @@
+//
+//  CUCompressedImage.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides support for GPU-compressed images (ETC2, ASTC, and the
+//  BCn formats) stored in KTX or KTX2 containers. These images are uploaded to
+//  the graphics card as is, without any decoding. They use a fraction of the
+//  memory of an RGBA texture, and they load much faster.
+//
+//  Reading an image is separate from creating a texture. It does not use
+//  OpenGL, so it is safe to do outside of the main thread. See the class
+//  Texture for how to turn one of these images into a texture.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_COMPRESSED_IMAGE_H__
+#define __CU_COMPRESSED_IMAGE_H__
+#include <cugl/render/CURenderBase.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace cugl {
+
+/**
+ * This class is a GPU-compressed image read from a KTX or KTX2 file.
+ *
+ * A compressed image is a sequence of mipmap levels, each of which is a block
+ * of compressed data in the format given by {@link #getFormat}. The first level
+ * is the full size image. The data is never decoded. It is is passed as is to
+ * glCompressedTexImage2D by {@link Texture#initWithImage}.
+ *
+ * Only 2d images are supported. Array textures, cube maps, and KTX2 files that
+ * use supercompression (such as Basis Universal) are rejected. Supported
+ * formats are the ETC2/EAC family, the ASTC LDR family, and the BCn (S3TC,
+ * RGTC, and BPTC) family. Not every platform supports every format. Mobile
+ * devices support ETC2 (and usually ASTC), while desktops support BCn. Use
+ * {@link #isSupported} to check whether a format can be used on this device.
+ */
+class CompressedImage {
+public:
+    /**
+     * An enumeration of the compression families.
+     *
+     * Every compressed format belongs to a family, and a device typically
+     * supports all or none of the formats in a family.
+     */
+    enum class Family : int {
+        /** A format that is not compressed (or not recognized) */
+        NONE = 0,
+        /** The ETC2 and EAC formats (required by OpenGLES 3) */
+        ETC2 = 1,
+        /** The ASTC LDR formats (most modern mobile devices) */
+        ASTC = 2,
+        /** The BCn formats, including S3TC, RGTC, and BPTC (desktops) */
+        BC   = 3
+    };
+
+private:
+    /** The OpenGL internal format of the compressed data */
+    GLenum _format;
+    /** The width of the first level in pixels */
+    GLuint _width;
+    /** The height of the first level in pixels */
+    GLuint _height;
+    /** The compressed data of all levels */
+    std::vector<char> _data;
+    /** The position of each level in the data */
+    std::vector<size_t> _offsets;
+    /** The number of bytes in each level */
+    std::vector<size_t> _sizes;
+
+    /**
+     * Returns true if the bytes are a valid KTX (version 1) image.
+     *
+     * If successful, this method initializes the format, size, and levels of
+     * this image. It does not copy the data.
+     *
+     * @param bytes The file contents
+     *
+     * @return true if the bytes are a valid KTX (version 1) image.
+     */
+    bool parseKTX(const std::vector<char>& bytes);
+
+    /**
+     * Returns true if the bytes are a valid KTX2 image.
+     *
+     * If successful, this method initializes the format, size, and levels of
+     * this image. It does not copy the data.
+     *
+     * @param bytes The file contents
+     *
+     * @return true if the bytes are a valid KTX2 image.
+     */
+    bool parseKTX2(const std::vector<char>& bytes);
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an empty image.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    CompressedImage() : _format(0), _width(0), _height(0) {}
+
+    /**
+     * Deletes this image, disposing all resources
+     */
+    ~CompressedImage() { dispose(); }
+
+    /**
+     * Deletes the image data and resets all attributes.
+     *
+     * You must reinitialize the image to use it.
+     */
+    void dispose();
+
+    /**
+     * Initializes this image with the contents of the given file.
+     *
+     * The file must be a KTX or KTX2 container (detected from its contents,
+     * not its extension). The path is used as is, and is not resolved against
+     * the asset directory. This method does not use OpenGL, and so it is safe
+     * to call outside of the main thread.
+     *
+     * @param path  The path to the file
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(const std::string& path);
+
+    /**
+     * Returns a newly allocated image with the contents of the given file.
+     *
+     * The file must be a KTX or KTX2 container (detected from its contents,
+     * not its extension). The path is used as is, and is not resolved against
+     * the asset directory. This method does not use OpenGL, and so it is safe
+     * to call outside of the main thread.
+     *
+     * @param path  The path to the file
+     *
+     * @return a newly allocated image with the contents of the given file.
+     */
+    static std::shared_ptr<CompressedImage> alloc(const std::string& path) {
+        std::shared_ptr<CompressedImage> result = std::make_shared<CompressedImage>();
+        return (result->init(path) ? result : nullptr);
+    }
+
+#pragma mark Attributes
+    /**
+     * Returns the OpenGL internal format of the compressed data
+     *
+     * @return the OpenGL internal format of the compressed data
+     */
+    GLenum getFormat() const { return _format; }
+
+    /**
+     * Returns the compression family of this image
+     *
+     * @return the compression family of this image
+     */
+    Family getFamily() const { return getFamily(_format); }
+
+    /**
+     * Returns the width of the full size image in pixels
+     *
+     * @return the width of the full size image in pixels
+     */
+    GLuint getWidth() const { return _width; }
+
+    /**
+     * Returns the height of the full size image in pixels
+     *
+     * @return the height of the full size image in pixels
+     */
+    GLuint getHeight() const { return _height; }
+
+    /**
+     * Returns the number of mipmap levels in this image
+     *
+     * This value is 1 if the image has no mipmaps.
+     *
+     * @return the number of mipmap levels in this image
+     */
+    size_t getLevelCount() const { return _sizes.size(); }
+
+    /**
+     * Returns the compressed data of the given mipmap level
+     *
+     * @param level The mipmap level
+     *
+     * @return the compressed data of the given mipmap level
+     */
+    const char* getLevelData(size_t level) const { return _data.data()+_offsets[level]; }
+
+    /**
+     * Returns the number of bytes in the given mipmap level
+     *
+     * @param level The mipmap level
+     *
+     * @return the number of bytes in the given mipmap level
+     */
+    size_t getLevelSize(size_t level) const { return _sizes[level]; }
+
+#pragma mark Platform Support
+    /**
+     * Returns the compression family of the given format
+     *
+     * If the format is not a recognized compressed format, this method
+     * returns {@link Family#NONE}.
+     *
+     * @param format    The OpenGL internal format
+     *
+     * @return the compression family of the given format
+     */
+    static Family getFamily(GLenum format);
+
+    /**
+     * Returns true if this device can use the given compressed format.
+     *
+     * This method queries the formats supported by the OpenGL context, and so
+     * it must be called in the main thread. The query is only performed once.
+     *
+     * @param format    The OpenGL internal format
+     *
+     * @return true if this device can use the given compressed format.
+     */
+    static bool isSupported(GLenum format);
+
+    /**
+     * Returns true if this device supports the given compression family.
+     *
+     * A family is supported if its most common format is supported. This
+     * method queries the formats supported by the OpenGL context, and so it
+     * must be called in the main thread.
+     *
+     * @param family    The compression family
+     *
+     * @return true if this device supports the given compression family.
+     */
+    static bool isSupported(Family family);
+
+    /**
+     * Returns true if the given file name is a KTX or KTX2 container
+     *
+     * This method only checks the file extension.
+     *
+     * @param path  The file name
+     *
+     * @return true if the given file name is a KTX or KTX2 container
+     */
+    static bool isContainer(const std::string& path);
+};
+
+}
+
+#endif /* __CU_COMPRESSED_IMAGE_H__ */
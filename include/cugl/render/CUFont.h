@@ -201,6 +201,8 @@ protected:
         Size _size;
         /** A (temporary) SDL surface for computing the atlas textures */
         SDL_Surface* _surface;
+        /** The first free x-coordinate of each row of glyphs */
+        std::vector<float> _cursor;
         
         /**
          * Lays out the glyphs in reasonably efficient packing.
@@ -402,6 +404,25 @@ protected:
          * @return true if texture creation was successful.
          */
         bool materialize();
+
+        /**
+         * Adds the given glyphs to the free space of this materialized atlas.
+         *
+         * Each glyph is placed at the end of the first glyph row with enough
+         * room, and is rendered directly into that region of the texture. The
+         * texture is not resized and no other glyphs are touched. This method
+         * will consume glyphs from the provided glyphset as it places them.
+         * So if it successfully adds all glyphs, the value glyphset will be
+         * emptied. Any remaining glyphs must be processed by another atlas.
+         *
+         * This method must be called on the main thread. It is only safe to
+         * call this method after a succesful call to {@link #materialize()}.
+         *
+         * @param glyphset  The glyphs to add to this atlas
+         *
+         * @return true if any glyph was added to this atlas
+         */
+        bool extend(std::deque<Uint32>& glyphset);
     };
 
 #pragma mark -
@@ -445,12 +466,16 @@ protected:
     std::vector<std::shared_ptr<Atlas>> _atlases;
     /** The number of pixels to pad around each edge of a glyph.  Necessary to support font blurs. */
     Uint32 _atlasPadding;
+    /** Whether the atlases are signed distance fields (for scalable text) */
+    bool _distanceField;
     /** The atlas storing any particular character */
     std::unordered_map<Uint32, size_t> _atlasmap;
 
     // GlyphRun generation
     /** Whether to generate an impromptu atlas for missing glyphs */
     bool _fallback;
+    /** Whether to add missing glyphs to the atlases on demand */
+    bool _paging;
     /** The maximum number of pixels to reduce the advance when shrinking a line */
     int _shrinkLimit;
     /** The maximum number of pixels to grow the advance when stretching a line */
@@ -782,6 +807,47 @@ public:
      * @param padding   The additional atlas padding
      */
     void setPadding(Uint32 padding);
+
+    /**
+     * Returns true if the atlases of this font are signed distance fields.
+     *
+     * A normal atlas stores the coverage of each glyph, rasterized at the size
+     * of this font. Scaling the text will blur or pixellate it. A distance
+     * field atlas instead stores the distance from each pixel to the edge of a
+     * glyph. When drawn by a {@link SpriteBatch} (which detects these atlases
+     * in its text methods), the edges are reconstructed in the shader and stay
+     * sharp at any scale. So one font (loaded at the largest size needed) can
+     * serve every UI scale, instead of loading the same file at several sizes.
+     *
+     * Distance field atlases are single color, and the glyph corners are
+     * slightly rounded at large scales. The padding (see {@link #setPadding})
+     * and fallback atlases (see {@link #setAtlasFallback}) work as before, but
+     * blur effects are softer.
+     *
+     * @return true if the atlases of this font are signed distance fields
+     */
+    bool hasDistanceField() const { return _distanceField; }
+
+    /**
+     * Sets whether the atlases of this font are signed distance fields.
+     *
+     * A normal atlas stores the coverage of each glyph, rasterized at the size
+     * of this font. Scaling the text will blur or pixellate it. A distance
+     * field atlas instead stores the distance from each pixel to the edge of a
+     * glyph. When drawn by a {@link SpriteBatch} (which detects these atlases
+     * in its text methods), the edges are reconstructed in the shader and stay
+     * sharp at any scale. So one font (loaded at the largest size needed) can
+     * serve every UI scale, instead of loading the same file at several sizes.
+     *
+     * Distance field atlases are single color, and the glyph corners are
+     * slightly rounded at large scales. The padding (see {@link #setPadding})
+     * and fallback atlases (see {@link #setAtlasFallback}) work as before, but
+     * blur effects are softer. Reseting this value will clear any existing
+     * atlas collection.
+     *
+     * @param field    Whether the atlases of this font are signed distance fields
+     */
+    void setDistanceField(bool field);
     
     /**
      * Sets whether to generate a fallback atlas for glyph runs.
@@ -822,6 +888,42 @@ public:
      * @return true if this font generates a fallback atlas for glyph runs.
      */
     bool hasAtlasFallback() const { return _fallback; }
+
+    /**
+     * Sets whether to add missing glyphs to the atlases on demand.
+     *
+     * Building an atlas for a large character set (such as CJK) up front is
+     * slow and wastes texture memory on glyphs that are never displayed. If
+     * this value is true, a {@link TextLayout} for this font will call
+     * {@link #addGlyphs} on its text before layout. Missing glyphs are then
+     * rendered into the free rows of the existing atlases, and a new atlas
+     * page is only created when those are full. Unlike a fallback atlas,
+     * these glyphs are stored for future use.
+     *
+     * Because this creates OpenGL textures, text layout for a font with
+     * paging is no longer safe to be used outside of the main thread.
+     *
+     * @param paging    Whether to add missing glyphs to the atlases on demand
+     */
+    void setAtlasPaging(bool paging) { _paging = paging; }
+
+    /**
+     * Returns true if this font adds missing glyphs to the atlases on demand.
+     *
+     * Building an atlas for a large character set (such as CJK) up front is
+     * slow and wastes texture memory on glyphs that are never displayed. If
+     * this value is true, a {@link TextLayout} for this font will call
+     * {@link #addGlyphs} on its text before layout. Missing glyphs are then
+     * rendered into the free rows of the existing atlases, and a new atlas
+     * page is only created when those are full. Unlike a fallback atlas,
+     * these glyphs are stored for future use.
+     *
+     * Because this creates OpenGL textures, text layout for a font with
+     * paging is no longer safe to be used outside of the main thread.
+     *
+     * @return true if this font adds missing glyphs to the atlases on demand.
+     */
+    bool hasAtlasPaging() const { return _paging; }
     
     /**
      * Sets the limit for shrinking the advance during tracking
@@ -1289,6 +1391,49 @@ public:
      */
     bool storeAtlases();
 
+    /**
+     * Adds any missing glyphs in the given text to the atlas collection.
+     *
+     * Glyphs that are already in an atlas, or that are not provided by this
+     * font, are ignored. The remaining glyphs are rendered into the free rows
+     * of the existing atlas textures. Only when these are full does this
+     * method create a new atlas. So adding a few glyphs at a time (such as
+     * the text of each new label) never rebuilds an existing texture.
+     *
+     * The text should be in UTF8 or ASCII format.
+     *
+     * WARNING: This method is not thread safe.  It generates OpenGL textures,
+     * which means that it may only be called in the main thread.
+     *
+     * @param text  The text with the glyphs to add (as UTF8 or ASCII)
+     *
+     * @return true if all provided glyphs in the text have atlas support.
+     */
+    bool addGlyphs(const std::string& text);
+
+    /**
+     * Adds any missing glyphs in the given character set to the atlas collection.
+     *
+     * Glyphs that are already in an atlas, or that are not provided by this
+     * font, are ignored. The remaining glyphs are rendered into the free rows
+     * of the existing atlas textures. Only when these are full does this
+     * method create a new atlas. So adding a few glyphs at a time (such as
+     * the text of each new label) never rebuilds an existing texture.
+     *
+     * The character set provided must be a collection of UNICODE encodings.
+     * The Unicode representation uses the endianness native to the platform.
+     * Therefore, this value should not be serialized. Use UTF8 to represent
+     * unicode in a platform-independent manner.
+     *
+     * WARNING: This method is not thread safe.  It generates OpenGL textures,
+     * which means that it may only be called in the main thread.
+     *
+     * @param charset   The characters to add (as UNICODE)
+     *
+     * @return true if all provided glyphs in the set have atlas support.
+     */
+    bool addGlyphs(const std::vector<Uint32>& charset);
+
     /**
      * Returns the OpenGL textures for the associated atlas collection.
      *
@@ -0,0 +1,351 @@
+//
+//  CUFrameReader.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides asynchronous readback of rendered frames, for tools
+//  such as screen capture, replays, and streaming. Reading the framebuffer
+//  directly with glReadPixels stalls the CPU until the GPU has finished every
+//  pending draw command. This class instead reads into pixel buffer objects,
+//  and waits on a fence for the transfer to complete. The pixels are handed
+//  to a callback a frame or two later, without ever blocking the render loop.
+//  Frames may be downscaled on the GPU first, which reduces the transfer.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_FRAME_READER_H__
+#define __CU_FRAME_READER_H__
+#include <cugl/render/CURenderTarget.h>
+#include <cugl/math/CURect.h>
+#include <functional>
+#include <vector>
+#include <memory>
+
+/** The default number of pixel buffers (the maximum reads in flight) */
+#define FRAME_READER_BUFFERS    3
+
+namespace cugl {
+
+/**
+ * This class reads rendered frames back to the CPU asynchronously.
+ *
+ * A read is started with {@link #read} (for a render target) or with
+ * {@link #readScreen} (for the display). This issues the transfer into a
+ * pixel buffer object and returns immediately. The method {@link #update}
+ * should be called once a frame. It checks which transfers have completed,
+ * and passes their pixels to the callback of each read, in the order that
+ * the reads were issued. This is typically a frame or two after the read.
+ *
+ * The pixels are always 8-bit RGBA. By default, the rows are ordered top
+ * to bottom (as in an image file), though this can be changed with
+ * {@link #setFlipped}. The pixel data is only valid during the callback,
+ * and must be copied if it is needed later.
+ *
+ * A read may be given an output size smaller than the source. In that case,
+ * the frame is downscaled with linear filtering on the GPU before it is
+ * transferred. This is much cheaper than downscaling on the CPU.
+ *
+ * The number of reads in flight is limited to the number of pixel buffers.
+ * If every buffer is busy, a read fails (and is counted in {@link #getDropped})
+ * rather than stall. Hence a slow consumer drops frames and never slows the
+ * game.
+ *
+ * Starting a read binds the framebuffer of the display (see
+ * {@link Display#restoreRenderTarget}), so it should not be called between
+ * {@link RenderTarget#begin} and {@link RenderTarget#end}.
+ *
+ * A frame reader is not thread-safe, and should only be used on the render
+ * thread. The callbacks are also invoked on the render thread.
+ */
+class FrameReader {
+public:
+    /**
+     * @typedef Callback
+     *
+     * This type represents a consumer of the pixels of a read.
+     *
+     * The pixels are 8-bit RGBA, with the given width and height, and no
+     * padding between rows. The pointer is only valid during the callback.
+     *
+     * The function type is equivalent to
+     *
+     *      std::function<void(const Uint8* pixels, int width, int height)>
+     */
+    typedef std::function<void(const Uint8* pixels, int width, int height)> Callback;
+
+private:
+    /**
+     * A pixel buffer and the read that is using it
+     */
+    class Slot {
+    public:
+        /** The pixel buffer object */
+        GLuint buffer;
+        /** The capacity of the pixel buffer in bytes */
+        size_t capacity;
+        /** The fence for the transfer (or 0 if there is no transfer) */
+        GLsync fence;
+        /** The width of the transferred image */
+        int width;
+        /** The height of the transferred image */
+        int height;
+        /** The consumer of the transferred image */
+        Callback callback;
+    };
+
+    /** The pixel buffers, used as a ring */
+    std::vector<Slot> _slots;
+    /** The slot of the oldest read in flight */
+    size_t _head;
+    /** The number of reads in flight */
+    size_t _pending;
+    /** The number of reads that failed because every buffer was busy */
+    size_t _dropped;
+    /** The framebuffer for downscaling (or 0 if not yet needed) */
+    GLuint _scalebo;
+    /** The color buffer for downscaling */
+    GLuint _scalerb;
+    /** The width of the downscaling buffer */
+    int _scalew;
+    /** The height of the downscaling buffer */
+    int _scaleh;
+    /** Whether the rows are delivered top to bottom */
+    bool _flipped;
+    /** The scratch buffer for reordering rows */
+    std::vector<Uint8> _scratch;
+
+    /**
+     * Returns true if the downscaling buffer has the given size.
+     *
+     * The buffer is (re)allocated if necessary.
+     *
+     * @param width     The buffer width
+     * @param height    The buffer height
+     *
+     * @return true if the downscaling buffer has the given size.
+     */
+    bool prepareScale(int width, int height);
+
+    /**
+     * Returns true if the read of the given framebuffer region started.
+     *
+     * This is the shared implementation of {@link #read} and {@link #readScreen}.
+     *
+     * @param framebo   The framebuffer to read
+     * @param attach    The color buffer to read
+     * @param bounds    The region to read, in pixels
+     * @param width     The output width
+     * @param height    The output height
+     * @param callback  The consumer of the pixels
+     *
+     * @return true if the read started.
+     */
+    bool readFramebuffer(GLuint framebo, GLenum attach, const Rect bounds,
+                         int width, int height, const Callback& callback);
+
+    /**
+     * Delivers the pixels of the given slot and releases the slot.
+     *
+     * The fence of the slot must have signaled.
+     *
+     * @param slot  The slot to deliver
+     */
+    void deliver(Slot& slot);
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates a degenerate frame reader.
+     *
+     * This object has not been initialized and cannot be used.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    FrameReader();
+
+    /**
+     * Deletes this frame reader, disposing all resources
+     */
+    ~FrameReader() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this frame reader.
+     *
+     * Any reads in flight are abandoned, and their callbacks are never
+     * invoked. Use {@link #flush} first to deliver them. A disposed frame
+     * reader can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes a frame reader with the given number of pixel buffers.
+     *
+     * The number of buffers is the maximum number of reads in flight. Three
+     * buffers are enough to read every frame as long as the transfers finish
+     * within two frames.
+     *
+     * @param buffers   The number of pixel buffers
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(size_t buffers=FRAME_READER_BUFFERS);
+
+    /**
+     * Returns a newly allocated frame reader with the given number of pixel buffers.
+     *
+     * The number of buffers is the maximum number of reads in flight. Three
+     * buffers are enough to read every frame as long as the transfers finish
+     * within two frames.
+     *
+     * @param buffers   The number of pixel buffers
+     *
+     * @return a newly allocated frame reader with the given number of pixel buffers.
+     */
+    static std::shared_ptr<FrameReader> alloc(size_t buffers=FRAME_READER_BUFFERS) {
+        std::shared_ptr<FrameReader> result = std::make_shared<FrameReader>();
+        return (result->init(buffers) ? result : nullptr);
+    }
+
+#pragma mark Reading
+    /**
+     * Returns true if a read of the given render target started.
+     *
+     * This reads the primary output texture of the render target. It should
+     * be called after {@link RenderTarget#end}. If width or height is 0, it
+     * is the size of the render target. Otherwise, the frame is downscaled
+     * to the given size on the GPU.
+     *
+     * This method fails if every pixel buffer is in use. The callback is
+     * invoked by a later call to {@link #update} or {@link #flush}.
+     *
+     * @param target    The render target to read
+     * @param callback  The consumer of the pixels
+     * @param width     The output width (0 for the target width)
+     * @param height    The output height (0 for the target height)
+     *
+     * @return true if a read of the given render target started.
+     */
+    bool read(const std::shared_ptr<RenderTarget>& target, const Callback& callback,
+              int width=0, int height=0);
+
+    /**
+     * Returns true if a read of the display started.
+     *
+     * The region is given in pixels, with the origin at the bottom left of
+     * the display. This should be called after drawing, but before the
+     * display is swapped. If width or height is 0, it is the size of the
+     * region. Otherwise, the frame is downscaled to the given size on the GPU.
+     *
+     * This method fails if every pixel buffer is in use. The callback is
+     * invoked by a later call to {@link #update} or {@link #flush}.
+     *
+     * @param bounds    The region to read, in pixels
+     * @param callback  The consumer of the pixels
+     * @param width     The output width (0 for the region width)
+     * @param height    The output height (0 for the region height)
+     *
+     * @return true if a read of the display started.
+     */
+    bool readScreen(const Rect bounds, const Callback& callback, int width=0, int height=0);
+
+    /**
+     * Delivers every completed read, returning the number delivered.
+     *
+     * This method never blocks. Reads are delivered in the order they were
+     * issued, so a completed read waits for any earlier read that is still
+     * in flight. This method should be called once a frame.
+     *
+     * @return the number of reads delivered.
+     */
+    size_t update();
+
+    /**
+     * Delivers every read in flight, returning the number delivered.
+     *
+     * Unlike {@link #update}, this method blocks until every transfer is
+     * complete. It is intended for the end of a capture, and should not be
+     * called every frame.
+     *
+     * @return the number of reads delivered.
+     */
+    size_t flush();
+
+#pragma mark Attributes
+    /**
+     * Returns the number of reads in flight.
+     *
+     * @return the number of reads in flight.
+     */
+    size_t getPending() const { return _pending; }
+
+    /**
+     * Returns the maximum number of reads in flight.
+     *
+     * @return the maximum number of reads in flight.
+     */
+    size_t getCapacity() const { return _slots.size(); }
+
+    /**
+     * Returns the number of reads that failed because every buffer was busy.
+     *
+     * @return the number of reads that failed because every buffer was busy.
+     */
+    size_t getDropped() const { return _dropped; }
+
+    /**
+     * Returns true if the rows are delivered top to bottom.
+     *
+     * OpenGL stores images bottom to top, while image files (and most video
+     * encoders) expect them top to bottom. Reordering the rows costs a copy
+     * of each frame on the CPU. This value is true by default.
+     *
+     * @return true if the rows are delivered top to bottom.
+     */
+    bool isFlipped() const { return _flipped; }
+
+    /**
+     * Sets whether the rows are delivered top to bottom.
+     *
+     * OpenGL stores images bottom to top, while image files (and most video
+     * encoders) expect them top to bottom. Reordering the rows costs a copy
+     * of each frame on the CPU. This value is true by default.
+     *
+     * @param value Whether the rows are delivered top to bottom.
+     */
+    void setFlipped(bool value) { _flipped = value; }
+};
+
+}
+
+#endif /* __CU_FRAME_READER_H__ */
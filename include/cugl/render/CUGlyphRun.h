@@ -88,6 +88,19 @@ public:
         texture = nullptr;
     }
     
+    /**
+     * Removes all glyphs from this glyph run, keeping the texture.
+     *
+     * Unlike {@link #dispose}, this method keeps the storage of the mesh.
+     * So a glyph run that is reset and refilled with a similar amount of
+     * text (e.g. a score or a timer) does not allocate any memory.
+     */
+    void reset() {
+        contents.clear();
+        mesh.vertices.clear();
+        mesh.indices.clear();
+    }
+    
     /**
      * Returns a newly allocated glyph run
      *
@@ -0,0 +1,401 @@
+//
+//  CURenderState.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module is a cache of the OpenGL state used by the render classes.
+//  Classes like SpriteBatch only track their state relative to their own
+//  previous draw call. They have no idea what a different sprite batch, a
+//  render target, or a texture bind did in the meantime. So they end up
+//  re-issuing state that the driver already has. All binds and all changes
+//  to the blend, depth, and stencil settings go through this module instead,
+//  which drops any call that would not change the state.
+//
+//  The cache only knows about changes made through this module. Code that
+//  calls OpenGL directly must call invalidate() before returning control.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_RENDER_STATE_H__
+#define __CU_RENDER_STATE_H__
+#include "CURenderBase.h"
+
+/** The number of texture units tracked by the cache */
+#define RENDER_STATE_TEXTURES   32
+/** The number of uniform buffer bind points tracked by the cache */
+#define RENDER_STATE_UNIFORMS   16
+
+namespace cugl {
+
+    /**
+     * Functions for a cache of the OpenGL state.
+     *
+     * Each function in this namespace mirrors the OpenGL function of the
+     * same name. It only calls OpenGL if the request would change the state
+     * in the cache. These functions must only be called on the render thread.
+     *
+     * Initially nothing is known, and the first call to each function always
+     * reaches OpenGL. Call {@link #invalidate} to return to this state (for
+     * example, after calling OpenGL directly, or after code from another
+     * library has drawn to the screen).
+     */
+    namespace renderstate {
+#pragma mark Cache Management
+        /**
+         * Forgets all cached OpenGL state.
+         *
+         * The next call to each function in this namespace will reach OpenGL.
+         * This must be called whenever the OpenGL state is changed outside of
+         * this namespace.
+         */
+        void invalidate();
+
+        /**
+         * Returns the number of OpenGL calls made through the cache.
+         *
+         * This only counts calls since the last call to {@link #resetCounters}.
+         *
+         * @return the number of OpenGL calls made through the cache.
+         */
+        Uint64 getIssuedCalls();
+
+        /**
+         * Returns the number of redundant OpenGL calls dropped by the cache.
+         *
+         * This only counts calls since the last call to {@link #resetCounters}.
+         *
+         * @return the number of redundant OpenGL calls dropped by the cache.
+         */
+        Uint64 getAvoidedCalls();
+
+        /**
+         * Resets the call counters to 0.
+         */
+        void resetCounters();
+
+#pragma mark Object Bindings
+        /**
+         * Makes the given shader program active.
+         *
+         * @param program   The shader program
+         */
+        void useProgram(GLuint program);
+
+        /**
+         * Returns the active shader program.
+         *
+         * @return the active shader program.
+         */
+        GLuint getProgram();
+
+        /**
+         * Binds the given vertex array object.
+         *
+         * As the element array buffer belongs to the vertex array, changing
+         * the vertex array forgets the cached element array buffer.
+         *
+         * @param array     The vertex array object
+         */
+        void bindVertexArray(GLuint array);
+
+        /**
+         * Returns the bound vertex array object.
+         *
+         * @return the bound vertex array object.
+         */
+        GLuint getVertexArray();
+
+        /**
+         * Binds the given buffer to the given target.
+         *
+         * Only GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER and GL_UNIFORM_BUFFER
+         * are cached. All other targets are passed through to OpenGL.
+         *
+         * @param target    The buffer target
+         * @param buffer    The buffer object
+         */
+        void bindBuffer(GLenum target, GLuint buffer);
+
+        /**
+         * Returns the buffer bound to the given target.
+         *
+         * @param target    The buffer target
+         *
+         * @return the buffer bound to the given target.
+         */
+        GLuint getBuffer(GLenum target);
+
+        /**
+         * Binds the whole of the given buffer to an indexed bind point.
+         *
+         * Only GL_UNIFORM_BUFFER is cached. As in OpenGL, this also binds the
+         * buffer to the generic target.
+         *
+         * @param target    The buffer target
+         * @param index     The bind point
+         * @param buffer    The buffer object
+         */
+        void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+        /**
+         * Binds a range of the given buffer to an indexed bind point.
+         *
+         * The range is not cached, so this call always reaches OpenGL. As in
+         * OpenGL, this also binds the buffer to the generic target.
+         *
+         * @param target    The buffer target
+         * @param index     The bind point
+         * @param buffer    The buffer object
+         * @param offset    The start of the range in bytes
+         * @param size      The size of the range in bytes
+         */
+        void bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                             GLintptr offset, GLsizeiptr size);
+
+        /**
+         * Returns the buffer bound to the given indexed bind point.
+         *
+         * @param target    The buffer target
+         * @param index     The bind point
+         *
+         * @return the buffer bound to the given indexed bind point.
+         */
+        GLuint getBufferBase(GLenum target, GLuint index);
+
+        /**
+         * Sets the active texture unit.
+         *
+         * @param unit      The texture unit (GL_TEXTURE0 + n)
+         */
+        void activeTexture(GLenum unit);
+
+        /**
+         * Returns the active texture unit.
+         *
+         * @return the active texture unit.
+         */
+        GLenum getActiveTexture();
+
+        /**
+         * Binds the given 2d texture to the active texture unit.
+         *
+         * @param texture   The texture object
+         */
+        void bindTexture(GLuint texture);
+
+        /**
+         * Binds the given 2d texture to the given texture unit.
+         *
+         * This makes the given unit the active texture unit, so that texture
+         * parameters may be set afterwards.
+         *
+         * @param unit      The texture unit (GL_TEXTURE0 + n)
+         * @param texture   The texture object
+         */
+        void bindTexture(GLenum unit, GLuint texture);
+
+        /**
+         * Returns the 2d texture bound to the given texture unit.
+         *
+         * @param unit      The texture unit (GL_TEXTURE0 + n)
+         *
+         * @return the 2d texture bound to the given texture unit.
+         */
+        GLuint getTexture(GLenum unit);
+
+        /**
+         * Binds the given framebuffer to the given target.
+         *
+         * The target GL_FRAMEBUFFER sets both the read and draw framebuffers.
+         *
+         * @param target    The framebuffer target
+         * @param buffer    The framebuffer object
+         */
+        void bindFramebuffer(GLenum target, GLuint buffer);
+
+        /**
+         * Binds the given renderbuffer.
+         *
+         * @param buffer    The renderbuffer object
+         */
+        void bindRenderbuffer(GLuint buffer);
+
+        /**
+         * Sets the viewport
+         *
+         * @param x         The left edge of the viewport
+         * @param y         The bottom edge of the viewport
+         * @param width     The width of the viewport
+         * @param height    The height of the viewport
+         */
+        void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+        /**
+         * Stores the current viewport in the given array.
+         *
+         * The array must have four elements. This only queries OpenGL if the
+         * viewport is not cached.
+         *
+         * @param viewport  The array to store the viewport
+         */
+        void getViewport(GLint* viewport);
+
+        /**
+         * Notifies the cache that the given texture has been deleted.
+         *
+         * OpenGL unbinds a deleted texture from every texture unit.
+         *
+         * @param texture   The deleted texture object
+         */
+        void forgetTexture(GLuint texture);
+
+        /**
+         * Notifies the cache that the given buffer has been deleted.
+         *
+         * OpenGL unbinds a deleted buffer from every target.
+         *
+         * @param buffer    The deleted buffer object
+         */
+        void forgetBuffer(GLuint buffer);
+
+        /**
+         * Notifies the cache that the given vertex array has been deleted.
+         *
+         * @param array     The deleted vertex array object
+         */
+        void forgetVertexArray(GLuint array);
+
+        /**
+         * Notifies the cache that the given shader program has been deleted.
+         *
+         * @param program   The deleted shader program
+         */
+        void forgetProgram(GLuint program);
+
+        /**
+         * Notifies the cache that the given framebuffer has been deleted.
+         *
+         * @param buffer    The deleted framebuffer object
+         */
+        void forgetFramebuffer(GLuint buffer);
+
+        /**
+         * Notifies the cache that the given renderbuffer has been deleted.
+         *
+         * @param buffer    The deleted renderbuffer object
+         */
+        void forgetRenderbuffer(GLuint buffer);
+
+#pragma mark Pipeline Settings
+        /**
+         * Enables or disables the given capability.
+         *
+         * Only GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST and
+         * GL_STENCIL_TEST are cached. All other capabilities are passed
+         * through to OpenGL.
+         *
+         * @param cap       The capability
+         * @param value     Whether to enable the capability
+         */
+        void setEnabled(GLenum cap, bool value);
+
+        /**
+         * Sets the blend equation for both the RGB and alpha components.
+         *
+         * @param mode      The blend equation
+         */
+        void blendEquation(GLenum mode);
+
+        /**
+         * Sets the blend functions for the RGB and alpha components.
+         *
+         * This uses glBlendFunc if the RGB and alpha functions agree, and
+         * glBlendFuncSeparate otherwise.
+         *
+         * @param srcRGB    The source function for the RGB components
+         * @param dstRGB    The destination function for the RGB components
+         * @param srcAlpha  The source function for the alpha component
+         * @param dstAlpha  The destination function for the alpha component
+         */
+        void blendFunc(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+
+        /**
+         * Sets whether writing to the depth buffer is enabled.
+         *
+         * @param flag      Whether writing to the depth buffer is enabled
+         */
+        void depthMask(GLboolean flag);
+
+        /**
+         * Sets the depth comparison function.
+         *
+         * @param func      The depth comparison function
+         */
+        void depthFunc(GLenum func);
+
+        /**
+         * Sets which color components are written to the frame buffer.
+         *
+         * @param red       Whether to write the red component
+         * @param green     Whether to write the green component
+         * @param blue      Whether to write the blue component
+         * @param alpha     Whether to write the alpha component
+         */
+        void colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+
+        /**
+         * Sets the stencil write mask for both faces.
+         *
+         * @param mask      The stencil write mask
+         */
+        void stencilMask(GLuint mask);
+
+        /**
+         * Sets the stencil test function for both faces.
+         *
+         * @param func      The stencil test function
+         * @param ref       The stencil reference value
+         * @param mask      The stencil test mask
+         */
+        void stencilFunc(GLenum func, GLint ref, GLuint mask);
+
+        /**
+         * Sets the stencil operations for both faces.
+         *
+         * @param sfail     The operation when the stencil test fails
+         * @param dpfail    The operation when the depth test fails
+         * @param dppass    The operation when both tests pass
+         */
+        void stencilOp(GLenum sfail, GLenum dpfail, GLenum dppass);
+
+        /**
+         * Sets the stencil operations for the given face.
+         *
+         * @param face      The face (GL_FRONT, GL_BACK, or GL_FRONT_AND_BACK)
+         * @param sfail     The operation when the stencil test fails
+         * @param dpfail    The operation when the depth test fails
+         * @param dppass    The operation when both tests pass
+         */
+        void stencilOpSeparate(GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass);
+    }
+}
+#endif /* __CU_RENDER_STATE_H__ */
@@ -76,6 +76,12 @@ namespace cugl {
  * {@link Texture::PixelFormat}. Finally, all output textures are bound sequentially
  * to output locations 0..\#outputs-1. However, we find that still allows us to handle
  * the vast majority of applications with a framebuffer.
+ *
+ * A render target may also be multisampled (see {@link #initMultisample}). Such a
+ * target draws to multisampled buffers, and resolves them to the output textures when
+ * {@link #end} is called. This gives antialiased results without drawing at a higher
+ * resolution. Only the color outputs are resolved; the depth/stencil texture of a
+ * multisampled target is undefined.
  */
 class RenderTarget {
 private:
@@ -103,6 +109,13 @@ private:
     /** The bind points for linking up the shader output variables */
     std::vector<GLuint> _bindpoints;
 
+    /** The number of samples per pixel (0 if this target is not multisampled) */
+    int _samples;
+    /** The multisampled framebuffer that is resolved to the output textures */
+    GLuint _samplebo;
+    /** The multisampled renderbuffers (one per output, then the depth/stencil) */
+    std::vector<GLuint> _samplebufs;
+
 #pragma mark -
 #pragma mark Setup
     /**
@@ -149,6 +162,27 @@ private:
      */
     bool completeBuffer();
 
+    /**
+     * Initializes the multisampled framebuffer and its renderbuffers
+     *
+     * This method must be called after the output textures are attached, as
+     * it creates a multisampled renderbuffer for each output.
+     *
+     * If this method fails, it will safely clean up any previously allocated
+     * objects before quitting.
+     *
+     * @return true if the multisampled framebuffer was successfully created.
+     */
+    bool prepareSamples();
+
+    /**
+     * Resolves the multisampled buffers to the output textures.
+     *
+     * This method blits each multisampled color buffer to the output texture
+     * at the same location. It does nothing if this target is not multisampled.
+     */
+    void resolve();
+
     
 #pragma mark -
 #pragma mark Constructors
@@ -293,6 +327,23 @@ public:
      */
     bool init(int width, int height, Texture::PixelFormat* outputs, size_t outsize);
 
+    /**
+     * Initializes this target with multisampled RGBA output textures.
+     *
+     * Drawing takes place in multisampled buffers, which are resolved to the
+     * output textures when {@link #end} is called. The number of samples is
+     * clamped to the maximum supported by this platform. If the number of
+     * samples is 1 or less, this is the same as {@link #init(int,int,size_t)}.
+     *
+     * @param width     The drawing width of this render target
+     * @param height    The drawing width of this render target
+     * @param samples   The number of samples per pixel
+     * @param outputs   The number of output textures
+     *
+     * @return true if initialization was successful.
+     */
+    bool initMultisample(int width, int height, int samples, size_t outputs=1);
+
     
 #pragma mark -
 #pragma mark Static Constructors
@@ -434,6 +485,27 @@ public:
         std::shared_ptr<RenderTarget> result = std::make_shared<RenderTarget>();
         return (result->init(width,height,outputs,outsize) ? result : nullptr);
     }
+
+    /**
+     * Returns a new render target with multisampled RGBA output textures.
+     *
+     * Drawing takes place in multisampled buffers, which are resolved to the
+     * output textures when {@link #end} is called. The number of samples is
+     * clamped to the maximum supported by this platform. If the number of
+     * samples is 1 or less, this is the same as {@link #alloc(int,int,size_t)}.
+     *
+     * @param width     The drawing width of this render target
+     * @param height    The drawing width of this render target
+     * @param samples   The number of samples per pixel
+     * @param outputs   The number of output textures
+     *
+     * @return a new render target with multisampled RGBA output textures.
+     */
+    static std::shared_ptr<RenderTarget> allocMultisample(int width, int height, int samples,
+                                                          size_t outputs=1) {
+        std::shared_ptr<RenderTarget> result = std::make_shared<RenderTarget>();
+        return (result->initMultisample(width,height,samples,outputs) ? result : nullptr);
+    }
     
     
 #pragma mark -
@@ -452,6 +524,15 @@ public:
      */
     int getHeight() const { return _height; }
 
+    /**
+     * Returns the number of samples per pixel of this render target
+     *
+     * This value is 0 if the render target is not multisampled.
+     *
+     * @return the number of samples per pixel of this render target
+     */
+    int getSamples() const { return _samples; }
+
     /**
      * Returns the clear color for this render target.
      *
@@ -505,6 +586,18 @@ public:
      */
     const std::shared_ptr<Texture>& getDepthStencil() const { return _depthst; }
 
+    /**
+     * Returns the OpenGL framebuffer for this render target.
+     *
+     * This is the framebuffer that the output textures are attached to. It
+     * is intended for low-level operations, such as reading the pixels back
+     * with a {@link FrameReader}. Binding it directly bypasses the state
+     * managed by {@link #begin} and {@link #end}.
+     *
+     * @return the OpenGL framebuffer for this render target.
+     */
+    GLuint getFramebuffer() const { return _framebo; }
+
 
 #pragma mark -
 #pragma mark Drawing
@@ -526,7 +619,8 @@ public:
      * Stops sendinging draw commands to this render target.
      *
      * When this method is called, the original viewport will be restored. Future
-     * draw commands will be sent directly to the screen.
+     * draw commands will be sent directly to the screen. If this target is
+     * multisampled, the samples are resolved to the output textures.
      *
      * It is NOT safe to call a begin/end pair of a render target inside of 
      * another render target.  Render targets do not keep a stack.  They alway
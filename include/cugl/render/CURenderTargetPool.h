@@ -0,0 +1,259 @@
+//
+//  CURenderTargetPool.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a pool of offscreen render targets. Post-processing
+//  effects and cached scene graph nodes need render targets of the same few
+//  sizes over and over again. Allocating a framebuffer (and its textures) each
+//  time churns GPU memory, so this pool keeps released targets, indexed by
+//  size and format, and hands them out again. Idle targets are deleted if they
+//  are not reused within a few frames.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_RENDER_TARGET_POOL_H__
+#define __CU_RENDER_TARGET_POOL_H__
+#include <cugl/render/CURenderTarget.h>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+namespace cugl {
+
+/**
+ * This class is a pool of reusable render targets.
+ *
+ * Targets are acquired with a size, a pixel format, and a number of samples
+ * (see {@link RenderTarget#initMultisample}). A released target is kept idle,
+ * and is returned by the next request with the same size, format, and samples.
+ * Every target in the pool has a single output texture. Multisampled targets
+ * must use the RGBA format.
+ *
+ * A pool has a notion of a frame, which ends each time {@link #advance} is
+ * called. Transient targets (see {@link #acquireTransient}) only last for
+ * the current frame, and are released automatically when it ends. This is the
+ * natural way to allocate intermediate targets for post-processing. Idle targets
+ * that are not reused for {@link #getLifetime} frames are deleted.
+ *
+ * A render target pool is not thread-safe, and should only be used on the
+ * render thread.
+ */
+class RenderTargetPool {
+private:
+    /**
+     * An idle render target
+     */
+    class Idle {
+    public:
+        /** The idle render target */
+        std::shared_ptr<RenderTarget> target;
+        /** The frame in which the target was released */
+        Uint64 frame;
+    };
+
+    /** The idle render targets, indexed by their size and format */
+    std::unordered_map<Uint64, std::vector<Idle>> _idle;
+    /** The render targets to release at the end of this frame */
+    std::vector<std::shared_ptr<RenderTarget>> _transient;
+    /** The number of frames an idle target is kept */
+    Uint32 _lifetime;
+    /** The current frame */
+    Uint64 _frame;
+    /** The number of idle render targets */
+    size_t _idleCount;
+
+    /**
+     * Returns the pool key for the given target attributes
+     *
+     * The number of samples should be normalized to what the platform
+     * supports, as this is the value stored in the render target.
+     *
+     * @param width     The target width
+     * @param height    The target height
+     * @param format    The target pixel format
+     * @param samples   The number of samples per pixel
+     *
+     * @return the pool key for the given target attributes
+     */
+    static Uint64 makeKey(int width, int height, Texture::PixelFormat format, int samples);
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates a degenerate render target pool.
+     *
+     * This object has not been initialized and cannot be used.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    RenderTargetPool() : _lifetime(0), _frame(0), _idleCount(0) {}
+
+    /**
+     * Deletes this render target pool, disposing all resources
+     */
+    ~RenderTargetPool() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this pool.
+     *
+     * All idle targets are deleted. Targets that are still acquired are not
+     * affected. A disposed pool can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes a render target pool that keeps idle targets for the given frames.
+     *
+     * @param lifetime  The number of frames an idle target is kept
+     *
+     * @return true if the pool is initialized properly, false otherwise.
+     */
+    bool init(Uint32 lifetime=120);
+
+    /**
+     * Returns a newly allocated pool that keeps idle targets for the given frames.
+     *
+     * @param lifetime  The number of frames an idle target is kept
+     *
+     * @return a newly allocated pool that keeps idle targets for the given frames.
+     */
+    static std::shared_ptr<RenderTargetPool> alloc(Uint32 lifetime=120) {
+        std::shared_ptr<RenderTargetPool> result = std::make_shared<RenderTargetPool>();
+        return (result->init(lifetime) ? result : nullptr);
+    }
+
+#pragma mark Targets
+    /**
+     * Returns a render target with the given attributes.
+     *
+     * If there is an idle target with these attributes, it is returned.
+     * Otherwise a new target is allocated. The target should be returned to
+     * the pool with {@link #release} when it is no longer needed. The clear
+     * color of the target is unchanged, so it should be set after acquisition.
+     *
+     * This method returns nullptr if the target could not be allocated.
+     *
+     * @param width     The drawing width of the render target
+     * @param height    The drawing height of the render target
+     * @param format    The pixel format of the output texture
+     * @param samples   The number of samples per pixel (1 or less to disable)
+     *
+     * @return a render target with the given attributes.
+     */
+    std::shared_ptr<RenderTarget> acquire(int width, int height,
+                                          Texture::PixelFormat format=Texture::PixelFormat::RGBA,
+                                          int samples=0);
+
+    /**
+     * Returns a render target with the given attributes for this frame only.
+     *
+     * This method is the same as {@link #acquire}, except that the target is
+     * released automatically at the next call to {@link #advance}. The target
+     * should not be used after that, even if a reference is still held.
+     * Transient targets should never be released explicitly.
+     *
+     * This method returns nullptr if the target could not be allocated.
+     *
+     * @param width     The drawing width of the render target
+     * @param height    The drawing height of the render target
+     * @param format    The pixel format of the output texture
+     * @param samples   The number of samples per pixel (1 or less to disable)
+     *
+     * @return a render target with the given attributes for this frame only.
+     */
+    std::shared_ptr<RenderTarget> acquireTransient(int width, int height,
+                                                   Texture::PixelFormat format=Texture::PixelFormat::RGBA,
+                                                   int samples=0);
+
+    /**
+     * Returns a render target to this pool.
+     *
+     * The target becomes idle, and may be returned by a later acquisition. Only
+     * targets with a single output texture are kept. Other targets are ignored.
+     *
+     * @param target    The render target to release
+     */
+    void release(const std::shared_ptr<RenderTarget>& target);
+
+    /**
+     * Ends the current frame of this pool.
+     *
+     * This method releases all transient targets, and deletes any idle targets
+     * that have not been reused within the lifetime of this pool. It should be
+     * called once a frame, after all drawing is done.
+     */
+    void advance();
+
+    /**
+     * Deletes all idle render targets.
+     *
+     * Targets that are still acquired (including transient ones) are not
+     * affected.
+     */
+    void clear();
+
+#pragma mark Attributes
+    /**
+     * Returns the number of frames an idle target is kept.
+     *
+     * @return the number of frames an idle target is kept.
+     */
+    Uint32 getLifetime() const { return _lifetime; }
+
+    /**
+     * Sets the number of frames an idle target is kept.
+     *
+     * @param lifetime  The number of frames an idle target is kept.
+     */
+    void setLifetime(Uint32 lifetime) { _lifetime = lifetime; }
+
+    /**
+     * Returns the number of idle render targets in this pool.
+     *
+     * @return the number of idle render targets in this pool.
+     */
+    size_t getIdleCount() const { return _idleCount; }
+
+    /**
+     * Returns the number of transient render targets in use this frame.
+     *
+     * @return the number of transient render targets in use this frame.
+     */
+    size_t getTransientCount() const { return _transient.size(); }
+};
+
+}
+
+#endif /* __CU_RENDER_TARGET_POOL_H__ */
@@ -7,6 +7,12 @@
 //  shader is general enough that it should not need to be subclassed.
 //  However, to use a shader, it must be attached to a VertexBuffer.
 //
+//  Linked programs may be cached as driver binaries in a directory set with
+//  setBinaryCache. Later launches load the binary instead of compiling the
+//  source, falling back to the source if the driver rejects the binary.
+//  Shaders may also be compiled asynchronously with initAsync, so that the
+//  driver can compile them while the application draws a splash screen.
+//
 //  This class uses our standard shared-pointer architecture.
 //
 //  1. The constructor does not perform any initialization; it just sets all
@@ -39,7 +45,7 @@
 //      3. This notice may not be removed or altered from any source distribution.
 //
 //  Author: Walker White
-//  Version: 2/10/20
+//  Version: 10/14/26
 
 #ifndef __CU_SHADER_H__
 #define __CU_SHADER_H__
@@ -63,6 +69,48 @@
 #pragma mark -
 namespace cugl {
 
+/**
+ * This class is a typed handle to a uniform variable of a shader.
+ *
+ * A handle is just a program offset, resolved ahead of time with the method
+ * {@link Shader#getUniformHandle}. Setting a uniform through a handle with
+ * {@link Shader#setUniform} requires no string hashing and no OpenGL query.
+ * In addition, the type parameter ensures at compile time that the value
+ * matches the uniform. The supported types are GLfloat, GLint, GLuint, Vec2,
+ * Vec3, Vec4, Color4f, Mat4, and Affine2.
+ *
+ * A handle is only valid for the shader that created it. It must be resolved
+ * again if that shader is recompiled.
+ */
+template <typename T>
+class UniformHandle {
+public:
+    /** The program offset of the uniform (-1 if the uniform is not active) */
+    GLint location;
+
+    /**
+     * Creates a handle to no uniform.
+     *
+     * Setting a uniform with this handle has no effect.
+     */
+    UniformHandle() : location(-1) {}
+
+    /**
+     * Creates a handle for the uniform at the given program offset.
+     *
+     * @param pos   The program offset of the uniform
+     */
+    explicit UniformHandle(GLint pos) : location(pos) {}
+
+    /**
+     * Returns true if this handle refers to an active uniform.
+     *
+     * @return true if this handle refers to an active uniform.
+     */
+    bool isValid() const { return location >= 0; }
+};
+
+#pragma mark -
 /**
  * This class defines a GLSL shader.
  *
@@ -136,18 +184,29 @@ protected:
     std::unordered_map<GLint, std::string>  _attribnames;
     /** The attribute locations of this shader */
     std::unordered_map<std::string, GLint>  _attribsizes;
+    /** The program offsets of the attributes, reflected at link time */
+    std::unordered_map<std::string, GLint>  _attriblocs;
     /** The uniform locations of this shader */
     std::unordered_map<std::string, GLenum> _uniformtypes;
     /** The uniform variable names for this shader (includes samplers) */
     std::unordered_map<GLint,std::string>   _uniformnames;
     /** The uniform locations of this shader (includes samplers) */
     std::unordered_map<std::string, GLint>  _uniformsizes;
+    /** The program offsets of the uniforms, reflected at link time */
+    std::unordered_map<std::string, GLint>  _uniformlocs;
     /** The uniform block variable names for this shader */
     std::unordered_map<GLint,std::string>   _uniblocknames;
     /** The uniform block locations of this shader */
     std::unordered_map<std::string, GLint>  _uniblocksizes;
     /** Mappings of uniforms to a uniform block */
     std::unordered_map<GLint, GLint>        _uniblockfields;
+    /** Whether the program was submitted but not yet finished */
+    bool _pending;
+    /** Whether the program was loaded from a cached binary */
+    bool _binary;
+
+    /** The directory for cached program binaries (empty if disabled) */
+    static std::string _cacheDir;
 
     
 #pragma mark -
@@ -166,6 +225,69 @@ private:
      */
     virtual bool compile();
     
+    /**
+     * Submits this shader to the driver without waiting for the result.
+     *
+     * If there is a valid cached binary for this shader, it is loaded in
+     * place of the source. Otherwise this method compiles the vertex and
+     * fragment sources and links them. In either case, the status is not
+     * queried, so that the driver can finish in the background.
+     *
+     * @return true if the shader was submitted.
+     */
+    bool submit();
+    
+    /**
+     * Completes a shader submitted with {@link #submit}.
+     *
+     * This method blocks until the driver is done. If a cached binary was
+     * rejected, it compiles the source instead. If the source was compiled,
+     * the linked program is saved to the binary cache.
+     *
+     * If compilation fails, it will display error messages on the log.
+     *
+     * @return true if compilation was successful.
+     */
+    bool complete();
+    
+    /**
+     * Compiles the vertex and fragment sources and links them.
+     *
+     * The status is not queried, so that the driver can finish in the
+     * background.
+     *
+     * @return true if the program was allocated.
+     */
+    bool submitSource();
+    
+    /**
+     * Returns the path of the cached binary for this shader.
+     *
+     * The path is a hash of the shader sources and the driver version, so
+     * a driver update or a change to the source never loads a stale binary.
+     *
+     * @return the path of the cached binary for this shader.
+     */
+    std::string getBinaryPath() const;
+    
+    /**
+     * Loads a cached binary for this shader, returning true on success.
+     *
+     * The binary is only submitted to the driver. Whether the driver
+     * accepts it is known in {@link #complete}.
+     *
+     * @return true if a cached binary was submitted
+     */
+    bool loadBinary();
+    
+    /**
+     * Saves the binary of the linked program to the cache.
+     *
+     * This method does nothing if the cache is disabled or the driver does
+     * not support program binaries.
+     */
+    void saveBinary();
+    
     /**
      * Returns true if the shader was compiled properly.
      *
@@ -198,13 +320,18 @@ private:
     
     /**
      * Querys all of the shader attributes and caches them for fast look-ups
+     *
+     * This includes the attribute locations, so that they are never queried
+     * from OpenGL after linking.
      */
     void cacheAttributes();
     
     /**
      * Querys all of the shader uniforms and caches them for fast look-ups
      *
-     * This includes uniform buffer blocks as well.
+     * This includes uniform buffer blocks as well. It also includes the
+     * uniform locations, so that they are never queried from OpenGL after
+     * linking.
      */
     void cacheUniforms();
     
@@ -217,7 +344,7 @@ public:
      *
      * You must initialize the shader to add a source and compile it.
      */
-    Shader() :  _program(0), _vertShader(0), _fragShader(0) {};
+    Shader() :  _program(0), _vertShader(0), _fragShader(0), _pending(false), _binary(false) {};
 
     /**
      * Deletes this shader, disposing all resources.
@@ -262,6 +389,94 @@ public:
         return (result->init(vsource, fsource) ? result : nullptr);
     }
 
+    /**
+     * Initializes this shader with the given source, without waiting for it.
+     *
+     * The shader is submitted to the driver, but this method does not wait
+     * for compilation to finish. The shader is not ready for use until
+     * {@link #finish} is called. Use {@link #isPending} to poll whether
+     * {@link #finish} would block. This allows the driver to compile several
+     * shaders while the application draws a splash screen.
+     *
+     * This method only reports failures to allocate the program. Errors in
+     * the source are reported by {@link #finish}.
+     *
+     * @param vsource   The source string for the vertex shader.
+     * @param fsource   The source string for the fragment shader.
+     *
+     * @return true if the shader was submitted.
+     */
+    bool initAsync(const std::string vsource, std::string fsource);
+
+    /**
+     * Returns a new shader with the given source, without waiting for it.
+     *
+     * The shader is submitted to the driver, but this method does not wait
+     * for compilation to finish. The shader is not ready for use until
+     * {@link #finish} is called. See {@link #initAsync}.
+     *
+     * @param vsource   The source string for the vertex shader.
+     * @param fsource   The source string for the fragment shader.
+     *
+     * @return a new shader with the given vertex and fragment source.
+     */
+    static std::shared_ptr<Shader> allocAsync(const std::string vsource, std::string fsource) {
+        std::shared_ptr<Shader> result = std::make_shared<Shader>();
+        return (result->initAsync(vsource, fsource) ? result : nullptr);
+    }
+
+    /**
+     * Returns true if the driver is still compiling this shader.
+     *
+     * This is only meaningful for shaders initialized with {@link #initAsync}.
+     * If the driver cannot report its progress (it does not support the
+     * parallel shader compile extension), this method returns false once
+     * the shader is submitted, and {@link #finish} may block.
+     *
+     * @return true if the driver is still compiling this shader.
+     */
+    bool isPending() const;
+
+    /**
+     * Completes a shader initialized with {@link #initAsync}.
+     *
+     * This method blocks until compilation is done, and then prepares the
+     * shader for use. When it is done, the shader will be bound and active.
+     * If compilation fails, it will display error messages on the log. This
+     * method does nothing if the shader is already finished.
+     *
+     * @return true if compilation was successful.
+     */
+    bool finish();
+
+#pragma mark -
+#pragma mark Binary Cache
+    /**
+     * Sets the directory for cached program binaries.
+     *
+     * When this directory is set, the program of each compiled shader is
+     * saved there as a driver binary. Later initializations of a shader
+     * with the same source load the binary instead, which is much faster
+     * on some mobile drivers. Binaries are keyed by the shader source and
+     * the driver version, and any binary the driver rejects is replaced.
+     *
+     * If the path is relative, it is placed in the application save
+     * directory. An empty path disables the cache, which is the default.
+     * The cache is also disabled if the driver has no binary formats.
+     *
+     * @param dir   The directory for cached program binaries
+     */
+    static void setBinaryCache(const std::string dir);
+
+    /**
+     * Returns the directory for cached program binaries.
+     *
+     * An empty path means that the cache is disabled, which is the default.
+     *
+     * @return the directory for cached program binaries.
+     */
+    static const std::string& getBinaryCache() { return _cacheDir; }
+
 
 #pragma mark -
 #pragma mark Binding
@@ -285,7 +500,7 @@ public:
      *
      * @return true if this shader has been compiled and is ready for use.
      */
-    bool isReady() const { return _program != 0; }
+    bool isReady() const { return _program != 0 && !_pending; }
 
     /**
      * Returns true if this shader is currently bound.
@@ -343,13 +558,15 @@ public:
     /**
      * Returns the program offset of the given attribute
      *
-     * If name is not a valid attribute, this method returns -1.
+     * If name is not a valid attribute, this method returns -1. The offsets
+     * are reflected when the shader is linked, so this method does not query
+     * OpenGL.
      *
      * @param name  The attribute variable name
      *
      * @return the program offset of the given attribute
      */
-    GLint getAttributeLocation(const std::string name) const;
+    GLint getAttributeLocation(const std::string& name) const;
     
     /**
      * Returns the size (in bytes) of the given attribute
@@ -360,7 +577,7 @@ public:
      *
      * @return the size (in bytes) of the given attribute
      */
-    GLint getAttributeSize(const std::string name) const;
+    GLint getAttributeSize(const std::string& name) const;
 
     /**
      * Returns the type of the given attribute
@@ -371,7 +588,7 @@ public:
      *
      * @return the type of the given attribute
      */
-    GLenum getAttributeType(const std::string name) const;
+    GLenum getAttributeType(const std::string& name) const;
 
     /**
      * Returns the program offset of the given output variable.
@@ -394,7 +611,7 @@ public:
      *
      * @return the program offset of the given output variable.
      */
-    GLint getOutputLocation(const std::string name) const;
+    GLint getOutputLocation(const std::string& name) const;
 
     
 #pragma mark -
@@ -409,13 +626,16 @@ public:
     /**
      * Returns the program offset of the given uniform
      *
-     * If name is not a valid uniform, this method returns -1.
+     * If name is not a valid uniform, this method returns -1. The offsets
+     * are reflected when the shader is linked, so this method does not query
+     * OpenGL. The only exception is an element of a uniform array other than
+     * the first (e.g. "uTextures[1]").
      *
      * @param name  The uniform variable name
      *
      * @return the program offset of the given uniform
      */
-    GLint getUniformLocation(const std::string name) const;
+    GLint getUniformLocation(const std::string& name) const;
 
     /**
      * Returns the size (in bytes) of the given uniform
@@ -426,7 +646,7 @@ public:
      *
      * @return the size (in bytes) of the given uniform
      */
-    GLint getUniformSize(const std::string name) const;
+    GLint getUniformSize(const std::string& name) const;
 
     /**
      * Returns the type of the given uniform
@@ -437,9 +657,155 @@ public:
      *
      * @return the type of the given uniform
      */
-    GLenum getUniformType(const std::string name) const;
+    GLenum getUniformType(const std::string& name) const;
 
     
+#pragma mark -
+#pragma mark Uniform Handles
+    /**
+     * Returns a typed handle to the given uniform.
+     *
+     * The handle should be resolved once (such as when the shader is
+     * assigned) and then used with {@link #setUniform} in the render loop.
+     * The type parameter must agree with the type of the uniform in the
+     * shader. If name is not a valid uniform, the handle returned is not
+     * valid, and setting it will have no effect.
+     *
+     * @param name  The uniform variable name
+     *
+     * @return a typed handle to the given uniform.
+     */
+    template <typename T>
+    UniformHandle<T> getUniformHandle(const std::string& name) const {
+        return UniformHandle<T>(getUniformLocation(name));
+    }
+
+    /**
+     * Sets the uniform of the given handle to the given float.
+     *
+     * This method requires no string work and no OpenGL query. It will only
+     * succeed if the shader is actively bound. It has no effect if the handle
+     * is not valid.
+     *
+     * @param handle    The handle of the uniform
+     * @param value     The value to assign
+     */
+    void setUniform(UniformHandle<GLfloat> handle, GLfloat value) {
+        setUniform1f(handle.location, value);
+    }
+
+    /**
+     * Sets the uniform of the given handle to the given int.
+     *
+     * This method requires no string work and no OpenGL query. It will only
+     * succeed if the shader is actively bound. It has no effect if the handle
+     * is not valid.
+     *
+     * @param handle    The handle of the uniform
+     * @param value     The value to assign
+     */
+    void setUniform(UniformHandle<GLint> handle, GLint value) {
+        setUniform1i(handle.location, value);
+    }
+
+    /**
+     * Sets the uniform of the given handle to the given unsigned int.
+     *
+     * This method requires no string work and no OpenGL query. It will only
+     * succeed if the shader is actively bound. It has no effect if the handle
+     * is not valid.
+     *
+     * @param handle    The handle of the uniform
+     * @param value     The value to assign
+     */
+    void setUniform(UniformHandle<GLuint> handle, GLuint value) {
+        setUniform1ui(handle.location, value);
+    }
+
+    /**
+     * Sets the uniform of the given handle to the given vector.
+     *
+     * This method requires no string work and no OpenGL query. It will only
+     * succeed if the shader is actively bound. It has no effect if the handle
+     * is not valid.
+     *
+     * @param handle    The handle of the uniform
+     * @param value     The value to assign
+     */
+    void setUniform(UniformHandle<Vec2> handle, const Vec2& value) {
+        setUniformVec2(handle.location, value);
+    }
+
+    /**
+     * Sets the uniform of the given handle to the given vector.
+     *
+     * This method requires no string work and no OpenGL query. It will only
+     * succeed if the shader is actively bound. It has no effect if the handle
+     * is not valid.
+     *
+     * @param handle    The handle of the uniform
+     * @param value     The value to assign
+     */
+    void setUniform(UniformHandle<Vec3> handle, const Vec3& value) {
+        setUniformVec3(handle.location, value);
+    }
+
+    /**
+     * Sets the uniform of the given handle to the given vector.
+     *
+     * This method requires no string work and no OpenGL query. It will only
+     * succeed if the shader is actively bound. It has no effect if the handle
+     * is not valid.
+     *
+     * @param handle    The handle of the uniform
+     * @param value     The value to assign
+     */
+    void setUniform(UniformHandle<Vec4> handle, const Vec4& value) {
+        setUniformVec4(handle.location, value);
+    }
+
+    /**
+     * Sets the uniform of the given handle to the given color.
+     *
+     * This method requires no string work and no OpenGL query. It will only
+     * succeed if the shader is actively bound. It has no effect if the handle
+     * is not valid.
+     *
+     * @param handle    The handle of the uniform
+     * @param value     The value to assign
+     */
+    void setUniform(UniformHandle<Color4f> handle, const Color4f& value) {
+        setUniformColor4f(handle.location, value);
+    }
+
+    /**
+     * Sets the uniform of the given handle to the given matrix.
+     *
+     * This method requires no string work and no OpenGL query. It will only
+     * succeed if the shader is actively bound. It has no effect if the handle
+     * is not valid.
+     *
+     * @param handle    The handle of the uniform
+     * @param value     The value to assign
+     */
+    void setUniform(UniformHandle<Mat4> handle, const Mat4& value) {
+        setUniformMat4(handle.location, value);
+    }
+
+    /**
+     * Sets the uniform of the given handle to the given affine transform.
+     *
+     * This method requires no string work and no OpenGL query. It will only
+     * succeed if the shader is actively bound. It has no effect if the handle
+     * is not valid.
+     *
+     * @param handle    The handle of the uniform
+     * @param value     The value to assign
+     */
+    void setUniform(UniformHandle<Affine2> handle, const Affine2& value) {
+        setUniformAffine2(handle.location, value);
+    }
+
 #pragma mark -
 #pragma mark Sampler Properties
     /**
@@ -466,7 +832,7 @@ public:
      *
      * @return the program offset of the given sampler variable
      */
-    GLint getSamplerLocation(const std::string name) const;
+    GLint getSamplerLocation(const std::string& name) const;
 
     /**
      * Sets the given sampler variable to a texture bindpoint.
@@ -502,7 +868,7 @@ public:
      * @param name      The name of the sampler variable
      * @param bpoint   The bindpoint for the sampler
      */
-    void setSampler(const std::string name, GLuint bpoint);
+    void setSampler(const std::string& name, GLuint bpoint);
 
     /**
      * Sets the given sampler variable to the bindpoint of the given texture.
@@ -534,7 +900,7 @@ public:
      * @param name      The name of the sampler variable
      * @param texture   The texture to initialize the bindpoint
      */
-    void setSampler(const std::string name, const std::shared_ptr<Texture>& texture);
+    void setSampler(const std::string& name, const std::shared_ptr<Texture>& texture);
     
     /**
      * Returns the texture bindpoint associated with the given sampler variable.
@@ -560,7 +926,7 @@ public:
      *
      * @return the texture bindpoint associated with the given sampler variable.
      */
-    GLuint getSampler(const std::string name) const;
+    GLuint getSampler(const std::string& name) const;
     
     
 #pragma mark -
@@ -609,7 +975,7 @@ public:
      *
      * @return a vector of all uniform blocks used by this shader
      */
-    std::vector<std::string> getUniformsForBlock(std::string name) const;
+    std::vector<std::string> getUniformsForBlock(const std::string& name) const;
 
     /**
      * Sets the given uniform block variable to a uniform buffer bindpoint.
@@ -639,7 +1005,7 @@ public:
      * @param name      The name of the uniform block in the shader
      * @param bpoint   The bindpoint for the uniform block
      */
-    void setUniformBlock(const std::string name, GLuint bpoint);
+    void setUniformBlock(const std::string& name, GLuint bpoint);
 
     /**
      * Sets the given uniform block variable to the bindpoint of the given uniform buffer.
@@ -679,7 +1045,7 @@ public:
      * @param name      The name of the uniform block in the shader
      * @param buffer    The buffer to bind to this uniform block
      */
-    void setUniformBlock(const std::string name,
+    void setUniformBlock(const std::string& name,
                          const std::shared_ptr<UniformBuffer>& buffer);
 
     /**
@@ -706,7 +1072,7 @@ public:
      *
      * @return the buffer bindpoint associated with the given uniform block.
      */
-    GLuint getUniformBlock(const std::string name) const;
+    GLuint getUniformBlock(const std::string& name) const;
 
     
 #pragma mark -
@@ -729,7 +1095,7 @@ public:
      * @param name  The name of the uniform
      * @param vec   The value for the uniform
      */
-    void setUniformVec2(const std::string name, const Vec2 vec);
+    void setUniformVec2(const std::string& name, const Vec2 vec);
 
     /**
      * Returns true if it can access the given uniform as a vector.
@@ -755,7 +1121,7 @@ public:
      *
      * @return true if it can access the given uniform as a vector.
      */
-    bool getUniformVec2(const std::string name, Vec2& vec) const;
+    bool getUniformVec2(const std::string& name, Vec2& vec) const;
     
     /**
      * Sets the given uniform to a vector value.
@@ -775,7 +1141,7 @@ public:
      * @param name  The name of the uniform
      * @param vec   The value for the uniform
      */
-    void setUniformVec3(const std::string name, const Vec3 vec);
+    void setUniformVec3(const std::string& name, const Vec3 vec);
 
     /**
      * Returns true if it can access the given uniform as a vector.
@@ -801,7 +1167,7 @@ public:
      *
      * @return true if it can access the given uniform as a vector.
      */
-    bool getUniformVec3(const std::string name, Vec3& vec) const;
+    bool getUniformVec3(const std::string& name, Vec3& vec) const;
 
     /**
      * Sets the given uniform to a vector value.
@@ -821,7 +1187,7 @@ public:
      * @param name  The name of the uniform
      * @param vec   The value for the uniform
      */
-    void setUniformVec4(const std::string name, const Vec4 vec);
+    void setUniformVec4(const std::string& name, const Vec4 vec);
 
     /**
      * Returns true if it can access the given uniform as a vector.
@@ -847,7 +1213,7 @@ public:
      *
      * @return true if it can access the given uniform as a vector.
      */
-    bool getUniformVec4(const std::string name, Vec4& vec) const;
+    bool getUniformVec4(const std::string& name, Vec4& vec) const;
 
     /**
      * Sets the given uniform to a color value.
@@ -867,7 +1233,7 @@ public:
      * @param name  The name of the uniform
      * @param color The value for the uniform
      */
-    void setUniformColor4(const std::string name, const Color4 color);
+    void setUniformColor4(const std::string& name, const Color4 color);
 
     /**
      * Returns true if it can access the given uniform as a color.
@@ -893,7 +1259,7 @@ public:
      *
      * @return true if it can access the given uniform as a color.
      */
-    bool getUniformColor4(const std::string name, Color4& color) const;
+    bool getUniformColor4(const std::string& name, Color4& color) const;
 
     /**
      * Sets the given uniform to a color value.
@@ -913,7 +1279,7 @@ public:
      * @param name  The name of the uniform
      * @param color The value for the uniform
      */
-    void setUniformColor4f(const std::string name, const Color4f color);
+    void setUniformColor4f(const std::string& name, const Color4f color);
 
     /**
      * Returns true if it can access the given uniform as a color.
@@ -939,7 +1305,7 @@ public:
      *
      * @return true if it can access the given uniform as a color.
      */
-    bool getUniformColor4f(const std::string name, Color4f& color) const;
+    bool getUniformColor4f(const std::string& name, Color4f& color) const;
 
     /**
      * Sets the given uniform to a matrix value.
@@ -961,7 +1327,7 @@ public:
      * @param name  The name of the uniform
      * @param mat   The value for the uniform
      */
-    void setUniformMat4(const std::string name, const Mat4& mat);
+    void setUniformMat4(const std::string& name, const Mat4& mat);
 
     /**
      * Returns true if it can access the given uniform as a matrix.
@@ -987,7 +1353,7 @@ public:
      *
      * @return true if it can access the given uniform as a matrix.
      */
-    bool getUniformMat4(const std::string name, Mat4& mat) const;
+    bool getUniformMat4(const std::string& name, Mat4& mat) const;
 
     /**
      * Sets the given uniform to an affine transform.
@@ -1013,7 +1379,7 @@ public:
      * @param name  The name of the uniform
      * @param mat   The value for the uniform
      */
-    void setUniformAffine2(const std::string name, const Affine2& mat);
+    void setUniformAffine2(const std::string& name, const Affine2& mat);
 
     /**
      * Returns true if it can access the given uniform as an affine transform.
@@ -1041,7 +1407,7 @@ public:
      *
      * @return true if it can access the given uniform as an affine transform.
      */
-    bool getUniformAffine2(const std::string name, Affine2& mat) const;
+    bool getUniformAffine2(const std::string& name, Affine2& mat) const;
 
     /**
      * Sets the given uniform to a quaternion.
@@ -1061,7 +1427,7 @@ public:
      * @param name  The name of the uniform
      * @param quat  The value for the uniform
      */
-    void setUniformQuaternion(const std::string name, const Quaternion& quat);
+    void setUniformQuaternion(const std::string& name, const Quaternion& quat);
 
     /**
      * Returns true if it can access the given uniform as a quaternion.
@@ -1087,7 +1453,7 @@ public:
      *
      * @return true if it can access the given uniform as a quaternion.
      */
-    bool getUniformQuaternion(const std::string name, Quaternion& quat) const;
+    bool getUniformQuaternion(const std::string& name, Quaternion& quat) const;
 
 
 #pragma mark -
@@ -1112,7 +1478,7 @@ public:
      * @param name  The name of the uniform
      * @param v0    The value for the uniform
      */
-    void setUniform1f(const std::string name, GLfloat v0);
+    void setUniform1f(const std::string& name, GLfloat v0);
 
     /**
      * Sets the given uniform to a pair of float values.
@@ -1136,7 +1502,7 @@ public:
      * @param v0    The first value for the uniform
      * @param v1    The second value for the uniform
      */
-    void setUniform2f(const std::string name, GLfloat v0, GLfloat v1);
+    void setUniform2f(const std::string& name, GLfloat v0, GLfloat v1);
 
     /**
      * Sets the given uniform to a trio of float values.
@@ -1162,7 +1528,7 @@ public:
      * @param v1    The second value for the uniform
      * @param v2    The third value for the uniform
      */
-    void setUniform3f(const std::string name, GLfloat v0, GLfloat v1, GLfloat v2);
+    void setUniform3f(const std::string& name, GLfloat v0, GLfloat v1, GLfloat v2);
 
     /**
      * Sets the given uniform to a quartet of float values.
@@ -1190,7 +1556,7 @@ public:
      * @param v2    The third value for the uniform
      * @param v3    The fourth value for the uniform
      */
-    void setUniform4f(const std::string name, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+    void setUniform4f(const std::string& name, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
 
     /**
      * Sets the given uniform to a single int value.
@@ -1212,7 +1578,7 @@ public:
      * @param name  The name of the uniform
      * @param v0    The value for the uniform
      */
-    void setUniform1i(const std::string name, GLint v0);
+    void setUniform1i(const std::string& name, GLint v0);
 
     /**
      * Sets the given uniform to a pair of int values.
@@ -1236,7 +1602,7 @@ public:
      * @param v0    The first value for the uniform
      * @param v1    The second value for the uniform
      */
-    void setUniform2i(const std::string name, GLint v0, GLint v1);
+    void setUniform2i(const std::string& name, GLint v0, GLint v1);
 
     /**
      * Sets the given uniform to a trio of int values.
@@ -1262,7 +1628,7 @@ public:
      * @param v1    The second value for the uniform
      * @param v2    The third value for the uniform
      */
-    void setUniform3i(const std::string name, GLint v0, GLint v1, GLint v2);
+    void setUniform3i(const std::string& name, GLint v0, GLint v1, GLint v2);
 
     /**
      * Sets the given uniform to a quartet of int values.
@@ -1290,7 +1656,7 @@ public:
      * @param v2    The third value for the uniform
      * @param v3    The fourth value for the uniform
      */
-    void setUniform4i(const std::string name, GLint v0, GLint v1, GLint v2, GLint v3);
+    void setUniform4i(const std::string& name, GLint v0, GLint v1, GLint v2, GLint v3);
 
     /**
      * Sets the given uniform to a single unsigned value.
@@ -1312,7 +1678,7 @@ public:
      * @param name  The name of the uniform
      * @param v0    The value for the uniform
      */
-    void setUniform1ui(const std::string name, GLuint v0);
+    void setUniform1ui(const std::string& name, GLuint v0);
 
     /**
      * Sets the given uniform to a pair of unsigned values.
@@ -1336,7 +1702,7 @@ public:
      * @param v0    The first value for the uniform
      * @param v1    The second value for the uniform
      */
-    void setUniform2ui(const std::string name, GLuint v0, GLuint v1);
+    void setUniform2ui(const std::string& name, GLuint v0, GLuint v1);
 
     /**
      * Sets the given uniform to a trio of unsigned values.
@@ -1362,7 +1728,7 @@ public:
      * @param v1    The second value for the uniform
      * @param v2    The third value for the uniform
      */
-    void setUniform3ui(const std::string name, GLuint v0, GLuint v1, GLuint v2);
+    void setUniform3ui(const std::string& name, GLuint v0, GLuint v1, GLuint v2);
 
     /**
      * Sets the given uniform to a quartet of unsigned values.
@@ -1390,7 +1756,7 @@ public:
      * @param v2    The third value for the uniform
      * @param v3    The fourth value for the uniform
      */
-    void setUniform4ui(const std::string name, GLuint v0, GLuint v1, GLuint v2, GLuint v3);
+    void setUniform4ui(const std::string& name, GLuint v0, GLuint v1, GLuint v2, GLuint v3);
 
     /**
      * Sets the given uniform to an array of 1-element floats.
@@ -1414,7 +1780,7 @@ public:
      * @param count The number of elements in the array
      * @param value The array of floats
      */
-    void setUniform1fv(const std::string name, GLsizei count, const GLfloat *value);
+    void setUniform1fv(const std::string& name, GLsizei count, const GLfloat *value);
 
     /**
      * Sets the given uniform to an array of 2-element floats.
@@ -1438,7 +1804,7 @@ public:
      * @param count The number of elements in the array
      * @param value The array of floats
      */
-    void setUniform2fv(const std::string name, GLsizei count, const GLfloat *value);
+    void setUniform2fv(const std::string& name, GLsizei count, const GLfloat *value);
 
     /**
      * Sets the given uniform to an array of 3-element floats.
@@ -1462,7 +1828,7 @@ public:
      * @param count The number of elements in the array
      * @param value The array of floats
      */
-    void setUniform3fv(const std::string name, GLsizei count, const GLfloat *value);
+    void setUniform3fv(const std::string& name, GLsizei count, const GLfloat *value);
 
     /**
      * Sets the given uniform to an array of 4-element floats.
@@ -1486,7 +1852,7 @@ public:
      * @param count The number of elements in the array
      * @param value The array of floats
      */
-    void setUniform4fv(const std::string name, GLsizei count, const GLfloat *value);
+    void setUniform4fv(const std::string& name, GLsizei count, const GLfloat *value);
 
     /**
      * Sets the given uniform to an array of 1-element ints.
@@ -1510,7 +1876,7 @@ public:
      * @param count The number of elements in the array
      * @param value The array of ints
      */
-    void setUniform1iv(const std::string name, GLsizei count, const GLint *value);
+    void setUniform1iv(const std::string& name, GLsizei count, const GLint *value);
 
     /**
      * Sets the given uniform to an array of 2-element ints.
@@ -1534,7 +1900,7 @@ public:
      * @param count The number of elements in the array
      * @param value The array of ints
      */
-    void setUniform2iv(const std::string name, GLsizei count, const GLint *value);
+    void setUniform2iv(const std::string& name, GLsizei count, const GLint *value);
 
     
     /**
@@ -1557,7 +1923,7 @@ public:
      * @param count The number of elements in the array
      * @param value The array of ints
      */
-    void setUniform3iv(const std::string name, GLsizei count, const GLint *value);
+    void setUniform3iv(const std::string& name, GLsizei count, const GLint *value);
 
     /**
      * Sets the given uniform to an array of 4-element ints.
@@ -1581,7 +1947,7 @@ public:
      * @param count The number of elements in the array
      * @param value The array of ints
      */
-    void setUniform4iv(const std::string name, GLsizei count, const GLint *value);
+    void setUniform4iv(const std::string& name, GLsizei count, const GLint *value);
 
     /**
      * Sets the given uniform to an array of 1-element unsigned ints.
@@ -1605,7 +1971,7 @@ public:
      * @param count The number of elements in the array
      * @param value The array of unsigned ints
      */
-    void setUniform1uiv(const std::string name, GLsizei count, const GLuint *value);
+    void setUniform1uiv(const std::string& name, GLsizei count, const GLuint *value);
 
     /**
      * Sets the given uniform to an array of 2-element unsigned ints.
@@ -1629,7 +1995,7 @@ public:
      * @param count The number of elements in the array
      * @param value The array of unsigned ints
      */
-    void setUniform2uiv(const std::string name, GLsizei count, const GLuint *value);
+    void setUniform2uiv(const std::string& name, GLsizei count, const GLuint *value);
 
     /**
      * Sets the given uniform to an array of 3-element unsigned ints.
@@ -1653,7 +2019,7 @@ public:
      * @param count The number of elements in the array
      * @param value The array of unsigned ints
      */
-    void setUniform3uiv(const std::string name, GLsizei count, const GLuint *value);
+    void setUniform3uiv(const std::string& name, GLsizei count, const GLuint *value);
 
     /**
      * Sets the given uniform to an array of 4-element unsigned ints.
@@ -1677,7 +2043,7 @@ public:
      * @param count The number of elements in the array
      * @param value The array of unsigned ints
      */
-    void setUniform4uiv(const std::string name, GLsizei count, const GLuint *value);
+    void setUniform4uiv(const std::string& name, GLsizei count, const GLuint *value);
     
     /**
      * Sets the given uniform to an array 2x2 matrices.
@@ -1703,7 +2069,7 @@ public:
      * @param value The array of matrices
      * @param tpose Whether to transpose the matrices
      */
-    void setUniformMatrix2fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
+    void setUniformMatrix2fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
 
     /**
      * Sets the given uniform to an array 3x3 matrices.
@@ -1729,7 +2095,7 @@ public:
      * @param value The array of matrices
      * @param tpose Whether to transpose the matrices
      */
-    void setUniformMatrix3fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
+    void setUniformMatrix3fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
 
     /**
      * Sets the given uniform to an array 4x4 matrices.
@@ -1755,7 +2121,7 @@ public:
      * @param value The array of matrices
      * @param tpose Whether to transpose the matrices
      */
-    void setUniformMatrix4fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
+    void setUniformMatrix4fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
 
     /**
      * Sets the given uniform to an array 2x3 matrices.
@@ -1781,7 +2147,7 @@ public:
      * @param value The array of matrices
      * @param tpose Whether to transpose the matrices
      */
-    void setUniformMatrix2x3fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
+    void setUniformMatrix2x3fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
 
     
     /**
@@ -1808,7 +2174,7 @@ public:
      * @param value The array of matrices
      * @param tpose Whether to transpose the matrices
      */
-    void setUniformMatrix3x2fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
+    void setUniformMatrix3x2fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
     
     /**
      * Sets the given uniform to an array 2x4 matrices.
@@ -1834,7 +2200,7 @@ public:
      * @param value The array of matrices
      * @param tpose Whether to transpose the matrices
      */
-    void setUniformMatrix2x4fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
+    void setUniformMatrix2x4fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
 
     /**
      * Sets the given uniform to an array 4x2 matrices.
@@ -1860,7 +2226,7 @@ public:
      * @param value The array of matrices
      * @param tpose Whether to transpose the matrices
      */
-    void setUniformMatrix4x2fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
+    void setUniformMatrix4x2fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
 
     /**
      * Sets the given uniform to an array 3x4 matrices.
@@ -1886,7 +2252,7 @@ public:
      * @param value The array of matrices
      * @param tpose Whether to transpose the matrices
      */
-    void setUniformMatrix3x4fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
+    void setUniformMatrix3x4fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
     
     /**
      * Sets the given uniform to an array 4x3 matrices.
@@ -1912,7 +2278,7 @@ public:
      * @param value The array of matrices
      * @param tpose Whether to transpose the matrices
      */
-    void setUniformMatrix4x3fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
+    void setUniformMatrix4x3fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose=false);
 
     /**
      * Gets the given uniform as an array of float values
@@ -1940,7 +2306,7 @@ public:
      *
      * @return true if data was successfully read into value
      */
-    bool getUniformfv(const std::string name, GLsizei size, GLfloat *value) const;
+    bool getUniformfv(const std::string& name, GLsizei size, GLfloat *value) const;
 
     /**
      * Gets the given uniform as an array of integer values
@@ -1968,7 +2334,7 @@ public:
      *
      * @return true if data was successfully read into value
      */
-    bool getUniformiv(const std::string name, GLsizei size, GLint *value) const;
+    bool getUniformiv(const std::string& name, GLsizei size, GLint *value) const;
 
     /**
      * Gets the given uniform as an array of unsigned integer values
@@ -1996,7 +2362,7 @@ public:
      *
      * @return true if data was successfully read into value
      */
-    bool getUniformuiv(const std::string name, GLsizei size, GLuint *value) const;
+    bool getUniformuiv(const std::string& name, GLsizei size, GLuint *value) const;
 };
     
 }
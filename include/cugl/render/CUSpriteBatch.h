@@ -52,6 +52,7 @@
 #include "CUStencilEffect.h"
 #include "CUMesh.h"
 #include <cugl/render/CURenderBase.h>
+#include <cugl/render/CUShader.h>
 #include <cugl/math/CUMathBase.h>
 #include <cugl/math/CUMat4.h>
 #include <cugl/math/CUColor4.h>
@@ -146,10 +147,26 @@ private:
     
     /** The shader for this sprite batch */
     std::shared_ptr<Shader> _shader;
+    /** The depth uniform of the active shader */
+    UniformHandle<GLfloat> _uDepth;
+    /** The draw type uniform of the active shader */
+    UniformHandle<GLint>   _uType;
+    /** The perspective uniform of the active shader */
+    UniformHandle<Mat4>    _uPerspective;
+    /** The blur offset uniform of the active shader */
+    UniformHandle<Vec2>    _uBlur;
+    /** The multitexture sampler array of the active shader */
+    UniformHandle<GLint>   _uTextures;
     /** The vertex buffer for this sprite batch */
     std::shared_ptr<VertexBuffer>  _vertbuff;
     /** The vertex buffer for this sprite batch */
     std::shared_ptr<UniformBuffer> _unifbuff;
+    /** The uniform buffer for the gradient table */
+    std::shared_ptr<UniformBuffer> _gradbuff;
+    /** The shader for instanced sprites (created on first use) */
+    std::shared_ptr<Shader> _instShader;
+    /** The vertex buffer for instanced sprites (created on first use) */
+    std::shared_ptr<VertexBuffer>  _instbuff;
     
     /** The sprite batch vertex mesh */
     SpriteVertex2* _vertData;
@@ -171,6 +188,29 @@ private:
     bool _inflight;
     /** The drawing context history */
     std::vector<Context*> _history;
+    /** The recycled drawing contexts (to avoid allocation on each state change) */
+    std::vector<Context*> _spares;
+
+    /** Whether this sprite batch only records (and never draws) */
+    bool _recording;
+    /** The scissor and gradient of each uniform block (recorders only) */
+    std::vector<std::pair<std::shared_ptr<Scissor>,std::shared_ptr<Gradient>>> _blocks;
+
+    /** The number of texture units in multitexture mode (0 if disabled) */
+    Uint32 _multiMax;
+    /** The texture slot of the vertices since the last stamp (-1 for none) */
+    GLint  _texSlot;
+    /** The first vertex that does not yet have a texture slot */
+    unsigned int _texMark;
+
+    /** The number of gradient rows in gradient table mode (0 if disabled) */
+    Uint32 _gradMax;
+    /** The gradient row of the vertices since the last stamp (-1 for none) */
+    GLint  _gradSlot;
+    /** The first vertex that does not yet have a gradient row */
+    unsigned int _gradMark;
+    /** The gradient data of each row in the gradient table */
+    std::vector<GLfloat> _gradRows;
     
     /** The active color */
     Color4 _color;
@@ -185,6 +225,10 @@ private:
     unsigned int _vertTotal;
     /** The number of OpenGL calls in this pass (so far) */
     unsigned int _callTotal;
+    /** The number of state changes applied in this pass (so far) */
+    unsigned int _stateTotal;
+    /** The microseconds spent flushing in this pass (so far) */
+    Uint64 _flushTime;
     
 
 #pragma mark -
@@ -304,6 +348,26 @@ public:
      */
     bool init(unsigned int capacity, const std::shared_ptr<Shader>& shader);
     
+    /**
+     * Initializes a recording sprite batch with the given vertex capacity.
+     *
+     * A recorder is a sprite batch without any OpenGL resources. All drawing
+     * commands are supported (except {@link #drawInstances} and multitexture
+     * mode), but the vertices and state changes are only recorded. They are
+     * drawn when another, ordinary sprite batch calls {@link #replay} on this
+     * recording. Instead of flushing, a recorder grows as needed.
+     *
+     * As a recorder makes no OpenGL calls, it may be drawn to on any thread.
+     * This allows independent subtrees of a scene graph to generate their
+     * vertices in parallel (see {@link Scene2#renderParallel}). However, a recorder
+     * is not thread-safe itself, and should only be used by one thread at a
+     * time.
+     *
+     * @param capacity The initial vertex capacity of this recorder
+     *
+     * @return true if initialization was successful.
+     */
+    bool initRecorder(unsigned int capacity=DEFAULT_CAPACITY);
     
 #pragma mark -
 #pragma mark Static Constructors
@@ -412,6 +476,30 @@ public:
         return (result->init(capacity,shader) ? result : nullptr);
     }
 
+    /**
+     * Returns a new recording sprite batch with the given vertex capacity.
+     *
+     * A recorder is a sprite batch without any OpenGL resources. All drawing
+     * commands are supported (except {@link #drawInstances} and multitexture
+     * mode), but the vertices and state changes are only recorded. They are
+     * drawn when another, ordinary sprite batch calls {@link #replay} on this
+     * recording. Instead of flushing, a recorder grows as needed.
+     *
+     * As a recorder makes no OpenGL calls, it may be drawn to on any thread.
+     * This allows independent subtrees of a scene graph to generate their
+     * vertices in parallel (see {@link Scene2#renderParallel}). However, a recorder
+     * is not thread-safe itself, and should only be used by one thread at a
+     * time.
+     *
+     * @param capacity The initial vertex capacity of this recorder
+     *
+     * @return a new recording sprite batch with the given vertex capacity.
+     */
+    static std::shared_ptr<SpriteBatch> allocRecorder(unsigned int capacity=DEFAULT_CAPACITY) {
+        std::shared_ptr<SpriteBatch> result = std::make_shared<SpriteBatch>();
+        return (result->initRecorder(capacity) ? result : nullptr);
+    }
+
 #pragma mark -
 #pragma mark Attributes
     /**
@@ -421,6 +509,17 @@ public:
      */
     bool isReady() const { return _initialized; }
     
+    /**
+     * Returns true if this sprite batch is a recorder.
+     *
+     * A recorder has no OpenGL resources, and only records its vertices and
+     * state changes. They are drawn with the {@link #replay} method of an
+     * ordinary sprite batch.
+     *
+     * @return true if this sprite batch is a recorder.
+     */
+    bool isRecorder() const { return _recording; }
+    
     /**
      * Returns whether this sprite batch is actively drawing.
      *
@@ -449,6 +548,32 @@ public:
      */
     unsigned int getCallsMade() const { return _callTotal; }
 
+    /**
+     * Returns the number of state changes in the latest pass (so far).
+     *
+     * A state change is a draw call that needed new uniforms, a new texture,
+     * or a new blend mode, stencil, or scissor. Each one breaks up a batch,
+     * so this number should be as small as possible.
+     *
+     * This value will be reset to 0 whenever begin() is called.
+     *
+     * @return the number of state changes in the latest pass (so far).
+     */
+    unsigned int getStateChanges() const { return _stateTotal; }
+
+    /**
+     * Returns the time spent flushing in the latest pass (so far).
+     *
+     * The time is measured in microseconds. It includes the time to stream
+     * the vertices to the graphics card and to issue the draw calls, but not
+     * the time the graphics card spends drawing.
+     *
+     * This value will be reset to 0 whenever begin() is called.
+     *
+     * @return the time spent flushing in the latest pass (so far).
+     */
+    Uint64 getFlushTime() const { return _flushTime; }
+
     /**
      * Sets the shader for this sprite batch
      *
@@ -547,7 +672,9 @@ public:
      * drawing with an active gradient.
      *
      * This method acquires a copy of the gradient. Changes to the original
-     * gradient after calling this method have no effect.
+     * gradient after calling this method have no effect. Changing this value
+     * will cause the sprite batch to flush, unless gradient table mode is
+     * enabled (see {@link #setGradientTable}).
      *
      * @param gradient   The active gradient for this sprite batch
      */
@@ -585,6 +712,12 @@ public:
      * If this value is nullptr, then no scissor mask is active. This value
      * is nullptr by default.
      *
+     * A scissor mask that is an axis-aligned rectangle (with a fringe of at
+     * most one pixel) under an unrotated perspective is applied with glScissor
+     * instead of the shader. Changing between two such masks does not use a
+     * uniform block, and does not break the batch at all if the rectangle is
+     * unchanged. All other masks are applied by the shader.
+     *
      * This method acquires a copy of the scissor. Changes to the original
      * scissor mask after calling this method have no effect.
      *
@@ -829,6 +962,42 @@ public:
      */
     GLfloat getBlur() const;
 
+    /**
+     * Sets whether textures are treated as signed distance fields.
+     *
+     * This sprite batch supports the distance field atlases of a {@link Font}
+     * (see {@link Font#setDistanceField}). In this mode, the alpha value of
+     * the texture is a distance to the edge of a glyph (with 0.5 on the edge),
+     * and not a coverage value. The shader converts this to an antialiased
+     * edge at any scale. So a single atlas can render its text crisply at any
+     * size.
+     *
+     * This mode only makes sense for distance field textures. The text drawing
+     * methods of this sprite batch set it automatically. This value is false
+     * by default.
+     *
+     * @param field    Whether textures are treated as signed distance fields
+     */
+    void setDistanceField(bool field);
+
+    /**
+     * Returns true if textures are treated as signed distance fields.
+     *
+     * This sprite batch supports the distance field atlases of a {@link Font}
+     * (see {@link Font#setDistanceField}). In this mode, the alpha value of
+     * the texture is a distance to the edge of a glyph (with 0.5 on the edge),
+     * and not a coverage value. The shader converts this to an antialiased
+     * edge at any scale. So a single atlas can render its text crisply at any
+     * size.
+     *
+     * This mode only makes sense for distance field textures. The text drawing
+     * methods of this sprite batch set it automatically. This value is false
+     * by default.
+     *
+     * @return true if textures are treated as signed distance fields
+     */
+    bool getDistanceField() const;
+
     /**
      * Sets the current stencil effect
      *
@@ -883,6 +1052,81 @@ public:
      */
     void clearHalfStencil(bool lower);
     
+    /**
+     * Sets the number of texture units to use in multitexture mode.
+     *
+     * Normally, every change of texture in a sprite batch (other than to a
+     * subtexture of the same atlas) is a state break, which requires a
+     * separate draw call. In multitexture mode, the default shader samples
+     * from several texture units at once, and each vertex records the unit
+     * of its texture. So up to this many textures can be drawn with a single
+     * draw call. Shapes are still drawn in the order submitted.
+     *
+     * A value of 0 or 1 disables multitexture mode. The value is clamped to
+     * the number of units supported by both the shader and the platform.
+     * Multitexture mode requires the default sprite batch shader (or one
+     * that has the same aTexIndex attribute and uTextures samplers). Blurred
+     * textures cannot share a draw call, so each blurred texture breaks the
+     * batch as usual. This value is 0 by default.
+     *
+     * @param units The number of texture units to use
+     */
+    void setMultiTexture(Uint32 units);
+
+    /**
+     * Returns the number of texture units to use in multitexture mode.
+     *
+     * Normally, every change of texture in a sprite batch (other than to a
+     * subtexture of the same atlas) is a state break, which requires a
+     * separate draw call. In multitexture mode, the default shader samples
+     * from several texture units at once, and each vertex records the unit
+     * of its texture. So up to this many textures can be drawn with a single
+     * draw call. Shapes are still drawn in the order submitted.
+     *
+     * A value of 0 indicates that multitexture mode is disabled. This value
+     * is 0 by default.
+     *
+     * @return the number of texture units to use in multitexture mode.
+     */
+    Uint32 getMultiTexture() const { return _multiMax; }
+
+    /**
+     * Sets the number of gradient rows to use in gradient table mode.
+     *
+     * Normally, every change of gradient in a sprite batch is a state break,
+     * as the gradient is part of the uniform block. In gradient table mode,
+     * each distinct gradient is stored as a row of a shared table, and each
+     * vertex records the row of its gradient. So shapes with up to this many
+     * different gradients can be drawn with a single draw call. The rows are
+     * cached by value, and persist between flushes. When the table is full,
+     * the sprite batch flushes and starts a new table.
+     *
+     * A value of 0 or 1 disables gradient table mode. The value is clamped to
+     * the number of rows supported by the default shader. Gradient table mode
+     * requires the default sprite batch shader (or one that has the same
+     * aGradIndex attribute and uGradients uniform block). Changing this value
+     * (other than to increase it) causes the sprite batch to flush. This value
+     * is 0 by default.
+     *
+     * @param rows  The number of gradient rows to use
+     */
+    void setGradientTable(Uint32 rows);
+
+    /**
+     * Returns the number of gradient rows to use in gradient table mode.
+     *
+     * Normally, every change of gradient in a sprite batch is a state break,
+     * as the gradient is part of the uniform block. In gradient table mode,
+     * each distinct gradient is stored as a row of a shared table, and each
+     * vertex records the row of its gradient. So shapes with up to this many
+     * different gradients can be drawn with a single draw call.
+     *
+     * A value of 0 indicates that gradient table mode is disabled. This value
+     * is 0 by default.
+     *
+     * @return the number of gradient rows to use in gradient table mode.
+     */
+    Uint32 getGradientTable() const { return _gradMax; }
 
 #pragma mark -
 #pragma mark Rendering
@@ -934,6 +1178,28 @@ public:
      */
     void flush();
 
+    /**
+     * Draws the contents of the given recording with this sprite batch.
+     *
+     * The recording must be a recorder (see {@link #initRecorder}) that has
+     * completed its drawing pass with {@link #end}. Its vertices are appended
+     * to this sprite batch as is, with the recorded texture, gradient, scissor,
+     * blending, depth, blur, and stencil settings. The vertices were tinted
+     * and transformed when they were recorded, so the active color has no
+     * effect. The recorded perspective is ignored, as the recording is drawn
+     * with the perspective of this sprite batch.
+     *
+     * This sprite batch must be active, and this method must be called on
+     * the render thread. Recordings are drawn in the order that they are
+     * replayed, so replaying several recordings in a fixed order produces
+     * the same image independent of the order in which they were recorded.
+     * The state of this sprite batch is restored afterwards, and the recording
+     * is unchanged, so a recording may be replayed more than once.
+     *
+     * @param recording The recording to draw
+     */
+    void replay(const std::shared_ptr<SpriteBatch>& recording);
+
     
 #pragma mark -
 #pragma mark Solid Shapes
@@ -2024,6 +2290,57 @@ public:
      */
     void drawMesh(const SpriteVertex2* vertices, size_t size, const Affine2& transform, bool tint = true);
     
+#pragma mark -
+#pragma mark Instanced Drawing
+    /**
+     * Draws the given sprite instances with the given texture.
+     *
+     * Each instance is a quad, described by its center, size, angle, color
+     * and texture coordinates (see {@link SpriteInstance}). Instances are
+     * uploaded as is, and expanded into quads by the shader, so this is much
+     * faster than drawing the same quads one at a time. It is ideal for
+     * particles, bullets, and other large groups of identical sprites.
+     *
+     * Instances are drawn immediately, after anything batched so far, so the
+     * drawing order is preserved. They use the current perspective, blending
+     * and stencil effect. However, they use their own colors (which are not
+     * tinted by the active color) and ignore any gradient, scissor mask or
+     * blur. If texture is nullptr, the quads are drawn with solid colors.
+     *
+     * Instancing requires the default sprite batch fragment shader.
+     *
+     * @param texture   The texture to draw on each instance
+     * @param instances The instances to draw
+     * @param count     The number of instances
+     */
+    void drawInstances(const std::shared_ptr<Texture>& texture,
+                       const SpriteInstance* instances, size_t count);
+
+    /**
+     * Draws the given sprite instances with the given texture.
+     *
+     * Each instance is a quad, described by its center, size, angle, color
+     * and texture coordinates (see {@link SpriteInstance}). Instances are
+     * uploaded as is, and expanded into quads by the shader, so this is much
+     * faster than drawing the same quads one at a time. It is ideal for
+     * particles, bullets, and other large groups of identical sprites.
+     *
+     * Instances are drawn immediately, after anything batched so far, so the
+     * drawing order is preserved. They use the current perspective, blending
+     * and stencil effect. However, they use their own colors (which are not
+     * tinted by the active color) and ignore any gradient, scissor mask or
+     * blur. If texture is nullptr, the quads are drawn with solid colors.
+     *
+     * Instancing requires the default sprite batch fragment shader.
+     *
+     * @param texture   The texture to draw on each instance
+     * @param instances The instances to draw
+     */
+    void drawInstances(const std::shared_ptr<Texture>& texture,
+                       const std::vector<SpriteInstance>& instances) {
+        drawInstances(texture,instances.data(),instances.size());
+    }
+
 #pragma mark -
 #pragma mark Text Drawing
     /**
@@ -2133,11 +2450,78 @@ private:
     void record();
     
     /**
-     * Deletes the recorded uniforms.
+     * Recycles the recorded uniforms.
      *
-     * This method is called upon flushing or cleanup.
+     * This method is called upon flushing or cleanup. The contexts are kept for
+     * reuse by {@link #record}, so that a state change does not allocate once
+     * the sprite batch has warmed up.
      */
     void unwind();
+
+    /**
+     * Appends the given range of recorded indices to this sprite batch.
+     *
+     * The indices are taken from the recording, along with the vertices that
+     * they reference. The range is split if it is too large for the capacity
+     * of this sprite batch.
+     *
+     * @param recording The recording with the vertices
+     * @param first     The first index to append
+     * @param last      The index after the last one to append
+     */
+    void splice(const SpriteBatch* recording, GLuint first, GLuint last);
+
+    /**
+     * Assigns the current texture slot to the vertices added since the last stamp.
+     *
+     * This method is only used in multitexture mode. It must be called before
+     * the texture slot changes, and before the vertices are flushed.
+     */
+    void stampTextures();
+
+    /**
+     * Assigns the current gradient row to the vertices added since the last stamp.
+     *
+     * This method is only used in gradient table mode. It must be called before
+     * the gradient row changes, and before the vertices are flushed.
+     */
+    void stampGradients();
+
+    /**
+     * Returns the gradient table row for the active gradient.
+     *
+     * This method is only used in gradient table mode. If the active gradient
+     * matches an existing row, that row is returned. Otherwise, the gradient
+     * is added as a new row. If the table is full, this method flushes the
+     * sprite batch and starts a new table.
+     *
+     * @return the gradient table row for the active gradient.
+     */
+    GLint acquireGradient();
+
+    /**
+     * Creates the shader and vertex buffer for instanced sprites.
+     *
+     * This method is called on the first call to {@link #drawInstances}.
+     *
+     * @return true if instancing is supported
+     */
+    bool initInstancing();
+
+    /**
+     * Assigns the sampler uniforms of the texture units in multitexture mode.
+     *
+     * The shader must be bound.
+     */
+    void bindSamplers();
+
+    /**
+     * Resolves the uniform handles of the active shader.
+     *
+     * This is called whenever the shader changes, so that flushing the
+     * vertices does no uniform lookups.
+     */
+    void resolveUniforms();
     
     /**
      * Sets the active uniform block to agree with the gradient and stroke.
@@ -59,6 +59,10 @@ public:
     cugl::Vec2    texcoord;
     /** The vertex gradient coordinate */
     cugl::Vec2    gradcoord;
+    /** The texture slot of the vertex in a multitexture batch (-1 for none) */
+    GLfloat       texindex;
+    /** The gradient row of the vertex in a gradient table batch (-1 for none) */
+    GLfloat       gradindex;
 
     /** The memory offset of the vertex position */
     static const GLvoid* positionOffset()   { return (GLvoid*)offsetof(SpriteVertex2, position);  }
@@ -68,6 +72,10 @@ public:
     static const GLvoid* texcoordOffset()   { return (GLvoid*)offsetof(SpriteVertex2, texcoord);  }
     /** The memory offset of the vertex texture coordinate */
     static const GLvoid* gradcoordOffset()   { return (GLvoid*)offsetof(SpriteVertex2,gradcoord);  }
+    /** The memory offset of the vertex texture slot */
+    static const GLvoid* texindexOffset()    { return (GLvoid*)offsetof(SpriteVertex2,texindex);   }
+    /** The memory offset of the vertex gradient row */
+    static const GLvoid* gradindexOffset()   { return (GLvoid*)offsetof(SpriteVertex2,gradindex);  }
 };
 
 /**
@@ -105,6 +113,49 @@ public:
     static const GLvoid* gradcoordOffset()  { return (GLvoid*)offsetof(SpriteVertex3, gradcoord);  }
 };
 
+/**
+ * This class/struct is rendering information for an instanced sprite.
+ *
+ * The class is intended to be used as a struct.  An instance is a single
+ * textured quad drawn by {@link SpriteBatch#drawInstances}. The quad is
+ * centered at the position, with the given size, and rotated about its
+ * center by the angle (in radians, counter clockwise). The shader expands
+ * each instance into its four corners, so an instance is much smaller than
+ * the four vertices and six indices of the same quad.
+ *
+ * The texture coordinates are the bounds of the (sub)texture drawn on the
+ * quad. As with {@link SpriteBatch#draw}, the coordinate (minS,maxT) is
+ * placed at the bottom left corner of the quad.
+ */
+class SpriteInstance {
+public:
+    /** The center of the quad */
+    cugl::Vec2 position;
+    /** The width and height of the quad */
+    cugl::Vec2 size;
+    /** The rotation of the quad (in radians, counter clockwise) */
+    GLfloat    angle;
+    /** The quad color (packed) */
+    GLuint     color;
+    /** The minimum texture coordinates (minS,minT) */
+    cugl::Vec2 texmin;
+    /** The maximum texture coordinates (maxS,maxT) */
+    cugl::Vec2 texmax;
+
+    /** The memory offset of the instance position */
+    static const GLvoid* positionOffset()   { return (GLvoid*)offsetof(SpriteInstance, position); }
+    /** The memory offset of the instance size */
+    static const GLvoid* sizeOffset()       { return (GLvoid*)offsetof(SpriteInstance, size);     }
+    /** The memory offset of the instance angle */
+    static const GLvoid* angleOffset()      { return (GLvoid*)offsetof(SpriteInstance, angle);    }
+    /** The memory offset of the instance color */
+    static const GLvoid* colorOffset()      { return (GLvoid*)offsetof(SpriteInstance, color);    }
+    /** The memory offset of the minimum texture coordinates */
+    static const GLvoid* texminOffset()     { return (GLvoid*)offsetof(SpriteInstance, texmin);   }
+    /** The memory offset of the maximum texture coordinates */
+    static const GLvoid* texmaxOffset()     { return (GLvoid*)offsetof(SpriteInstance, texmax);   }
+};
+
 }
 
 #endif /* __CU_SPRITE_VERTEX_H__ */
@@ -354,7 +354,7 @@ public:
      *
      * @return the text associated with this layout.
      */
-    const std::string getText() const { return _text; }
+    const std::string& getText() const { return _text; }
     
     /**
      * Sets the text associated with this layout.
@@ -502,6 +502,10 @@ public:
      * layout. For performance reasons, we do not automatically recompute the
      * layout in that case. Instead, the user must call {@link #layout} to
      * arrange the text.
+     *
+     * If the font has atlas paging (see {@link Font#setAtlasPaging}), any
+     * glyphs of the text missing from the font atlases are added first. In
+     * that case, this method may only be called in the main thread.
      */
     void layout();
 
@@ -47,6 +47,7 @@
 #include <cugl/render/CURenderBase.h>
 #include <cugl/math/CUMathBase.h>
 #include <cugl/math/CUSize.h>
+#include <cugl/render/CUCompressedImage.h>
 
 namespace cugl {
 
@@ -176,6 +177,9 @@ private:
     /** Whether or not the texture has mip maps */
     bool _hasMipmaps;
 
+    /** The internal format of a GPU-compressed texture (0 if uncompressed) */
+    GLenum _compressed;
+
     /** An all purpose blank texture for coloring */
     static std::shared_ptr<Texture> _blank;
 
@@ -269,12 +273,15 @@ public:
      * texture bound to that point will be unbound. In addition, once 
      * initialization is done, this texture will not longer be bound as well.
      *
-     * This method can load any file format supported by SDL_Image. This
+     * This method can load any file format supported by SDL_Image.  This
      * includes (but is not limited to) PNG, JPEG, GIF, TIFF, BMP and PCX.
      *
      * The texture will be stored in RGBA format, even if it is a file format
      * that does not support transparency (e.g. JPEG).
      *
+     * Files with the extension .ktx or .ktx2 are instead read as GPU-compressed
+     * images (see {@link CompressedImage}), and are loaded with {@link #initWithImage}.
+     *
      * IMPORTANT: In CUGL, relative path names always refer to the asset
      * directory. If you wish to load a texture from somewhere else, you must
      * use an absolute pathname.
@@ -285,6 +292,26 @@ public:
      */
     bool initWithFile(const std::string filename);
 
+    /**
+     * Initializes a texture with the given GPU-compressed image.
+     *
+     * Initializing a texture requires the use of the binding point at 0. Any
+     * texture bound to that point will be unbound. In addition, once
+     * initialization is done, this texture will not longer be bound as well.
+     *
+     * The compressed data is sent to the graphics card as is, with no decoding.
+     * If the image has a mipmap chain, all of the levels are loaded, and
+     * {@link #hasMipMaps} will be true. Mipmaps cannot be generated for a
+     * compressed texture, and the data of a compressed texture cannot be
+     * changed with {@link #set}. This method fails if the format of the image
+     * is not supported by this device (see {@link CompressedImage#isSupported}).
+     *
+     * @param image     The compressed image
+     *
+     * @return true if initialization was successful.
+     */
+    bool initWithImage(const std::shared_ptr<CompressedImage>& image);
+
     
 #pragma mark -
 #pragma mark Static Constructors
@@ -345,6 +372,9 @@ public:
      * The texture will be stored in RGBA format, even if it is a file format
      * that does not support transparency (e.g. JPEG).
      *
+     * Files with the extension .ktx or .ktx2 are instead read as GPU-compressed
+     * images (see {@link CompressedImage}), and are loaded with {@link #initWithImage}.
+     *
      * @param filename  The file supporting the texture file.
      *
      * @return a new texture with the given data
@@ -353,6 +383,29 @@ public:
         std::shared_ptr<Texture> result = std::make_shared<Texture>();
         return (result->initWithFile(filename) ? result : nullptr);
     }
+
+    /**
+     * Returns a new texture with the given GPU-compressed image.
+     *
+     * Allocating a texture requires the use of the binding point at 0. Any
+     * texture bound to that point will be unbound. In addition, once
+     * allocation is done, this texture will not longer be bound as well.
+     *
+     * The compressed data is sent to the graphics card as is, with no decoding.
+     * If the image has a mipmap chain, all of the levels are loaded, and
+     * {@link #hasMipMaps} will be true. Mipmaps cannot be generated for a
+     * compressed texture, and the data of a compressed texture cannot be
+     * changed with {@link #set}. This method fails if the format of the image
+     * is not supported by this device (see {@link CompressedImage#isSupported}).
+     *
+     * @param image     The compressed image
+     *
+     * @return a new texture with the given GPU-compressed image.
+     */
+    static std::shared_ptr<Texture> allocWithImage(const std::shared_ptr<CompressedImage>& image) {
+        std::shared_ptr<Texture> result = std::make_shared<Texture>();
+        return (result->initWithImage(image) ? result : nullptr);
+    }
     
     /**
      * Returns a blank texture that can be used to make solid shapes.
@@ -407,6 +460,28 @@ public:
      */
     const Texture& set(const void *data);
 
+    /**
+     * Sets a rectangular region of this texture to the contents of the buffer.
+     *
+     * The buffer must have the correct data format. In addition, the buffer
+     * must be size width*height*bytesize, and the region must lie inside of
+     * the texture. Rows are assumed to be tightly packed. See {@link #getByteSize}
+     * for a description of the latter.
+     *
+     * This method does not rebuild any mipmaps.  Call {@link #buildMipMaps}
+     * when all regions have been updated. This method is only successful if
+     * the texture is currently active.
+     *
+     * @param data      The buffer to read into the texture
+     * @param x         The x-coordinate of the region origin
+     * @param y         The y-coordinate of the region origin
+     * @param width     The region width
+     * @param height    The region height
+     *
+     * @return a reference to this (modified) texture for chaining.
+     */
+    const Texture& set(const void *data, int x, int y, int width, int height);
+
     
 #pragma mark -
 #pragma mark Attributes
@@ -475,6 +550,18 @@ public:
      */
     PixelFormat getFormat() const { return _pixelFormat; }
 
+    /**
+     * Returns true if this texture is GPU-compressed.
+     *
+     * A compressed texture is created from a {@link CompressedImage}. Its
+     * data cannot be changed, and it cannot generate mipmaps.
+     *
+     * @return true if this texture is GPU-compressed.
+     */
+    bool isCompressed() const {
+        return (_parent != nullptr ? _parent->isCompressed() : _compressed != 0);
+    }
+
     /**
      * Returns whether this texture has generated mipmaps.
      *
@@ -492,7 +579,8 @@ public:
      *
      * This method will fail if this texture is a subtexture.  Only the parent
      * texture can have mipmaps. In addition, mipmaps can only be built if the
-     * texture size is a power of two.
+     * texture size is a power of two. Compressed textures cannot build mipmaps,
+     * and this method does nothing for them (see {@link #initWithImage}).
      *
      * This method is only successful if the texture is currently active.
      */
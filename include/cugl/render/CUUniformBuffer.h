@@ -48,6 +48,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <algorithm>
 #include <cugl/math/cu_math.h>
 #include <cugl/render/CURenderBase.h>
 
@@ -101,13 +102,34 @@ private:
     GLenum _drawtype;
     /** Whether the byte buffer flushes automatically */
     bool _autoflush;
-    /** Whether the byte buffer must be flushed to the graphics card */
-    bool _dirty;
+    /** The first byte that must be flushed to the graphics card */
+    GLsizei _dirtyBegin;
+    /** The byte after the last one that must be flushed to the graphics card */
+    GLsizei _dirtyEnd;
     /** A mapping of struct names to their std140 offsets */
     std::unordered_map<std::string, GLsizei> _offsets;
     /** The decriptive buffer name */
     std::string _name;
 
+    /**
+     * Extends the pending changes to include the given byte range.
+     *
+     * The pending changes are a single range, which is sent to the graphics
+     * card on the next flush.
+     *
+     * @param begin The first byte changed
+     * @param end   The byte after the last one changed
+     */
+    void markDirty(GLsizei begin, GLsizei end) {
+        if (_dirtyBegin >= _dirtyEnd) {
+            _dirtyBegin = begin;
+            _dirtyEnd = end;
+        } else {
+            _dirtyBegin = std::min(_dirtyBegin,begin);
+            _dirtyEnd = std::max(_dirtyEnd,end);
+        }
+    }
+
 public:
 #pragma mark Constructors
 
@@ -309,10 +331,14 @@ public:
      * any of these changes until {@link #flush()} is called.
      *
      * The buffer returned will have a capacity of (block count) x (block stride).
+     * As the changes are unknown, the next flush will send the entire buffer.
      *
      * @return the backing byte-buffer for the uniform buffer
      */
-    char* getData() { return _bytebuffer; }
+    char* getData() {
+        markDirty(0,_blockstride*_blockcount);
+        return _bytebuffer;
+    }
 
     /**
      * Returns true if this uniform buffer supports autoflushing.
@@ -509,6 +535,10 @@ public:
      * turned on, it must be called if the user has accessed the backing byte buffer
      * directly via {@link #getData}.
      *
+     * Only the range of bytes changed since the last flush is sent to the
+     * graphics card. The buffer storage is never reallocated, so this method
+     * does nothing if there are no pending changes.
+     *
      * This method requires the byte buffer to be active.
      */
     void flush();
@@ -51,6 +51,8 @@
 #include <cugl/math/CUMathBase.h>
 #include <cugl/math/CUMat4.h>
 
+/** The number of regions in the ring of a streaming vertex buffer */
+#define VERTEX_STREAM_REGIONS   3
 
 namespace cugl {
 
@@ -98,6 +100,8 @@ private:
         GLboolean norm;
         /** The offset of the attribute in the vertex buffer */
         GLsizeiptr offset;
+        /** The number of instances between updates (0 for per-vertex) */
+        GLuint divisor;
     };
     
     /** The data stride of this buffer (0 if there is only one attribute) */
@@ -118,6 +122,24 @@ private:
     /** The settings for each attribute */
     std::unordered_map<std::string, AttribData> _attributes;
     
+    /** The vertex capacity of each streaming region (0 if not streaming) */
+    GLsizei _streamVerts;
+    /** The index capacity of each streaming region (0 if not streaming) */
+    GLsizei _streamIndxs;
+    /** The streaming region of the most recent load */
+    Uint32  _region;
+    /** Whether the current region has been drawn without a fence */
+    bool    _pending;
+    /** The fences guarding each streaming region */
+    GLsync  _fences[VERTEX_STREAM_REGIONS];
+    /** The offset of the loaded indices in the index buffer */
+    GLsizei _indxBase;
+
+    /**
+     * Releases any fences guarding the streaming regions.
+     */
+    void clearFences();
+
 public:
 #pragma mark Constructors
     /**
@@ -307,6 +329,60 @@ public:
      * @param usage The type of data load
      */
     void loadIndexData(const void * data, GLsizei size, GLenum usage=GL_STREAM_DRAW);
+
+    /**
+     * Enables streaming with the given capacity.
+     *
+     * A streaming vertex buffer divides its buffers into a ring of regions
+     * (currently three). Each call to {@link #streamData} writes to the next
+     * region with an unsynchronized map, while the GPU is free to read
+     * from the regions drawn previously. A fence guards each region, so a
+     * region is only reused once the GPU is done with it. This avoids the
+     * driver stalls that can happen when {@link #loadVertexData} replaces a
+     * buffer that is still in use.
+     *
+     * Streaming is disabled by any call to {@link #loadVertexData} or
+     * {@link #loadIndexData}, as these reallocate the buffers.
+     *
+     * This method will only succeed if this buffer is actively bound.
+     *
+     * @param vertices  The number of vertices in each region
+     * @param indices   The number of indices in each region
+     */
+    void enableStreaming(GLsizei vertices, GLsizei indices);
+
+    /**
+     * Disables streaming, releasing the streaming regions.
+     *
+     * The buffers are not reallocated until the next load.
+     */
+    void disableStreaming();
+
+    /**
+     * Returns true if this vertex buffer is streaming.
+     *
+     * @return true if this vertex buffer is streaming.
+     */
+    bool isStreaming() const { return _streamVerts > 0; }
+
+    /**
+     * Loads the given vertices and indices into the next streaming region.
+     *
+     * The data will be used by all draw commands until the next load. Indices
+     * are relative to the given vertices, exactly as with {@link #loadIndexData},
+     * and draw offsets are relative to the given indices. If the data does not
+     * fit in a region, the regions are grown to fit. If this buffer is not
+     * streaming, this method falls back to {@link #loadVertexData} and
+     * {@link #loadIndexData}.
+     *
+     * This method will only succeed if this buffer is actively bound.
+     *
+     * @param vertices  The vertices to load
+     * @param vsize     The number of vertices to load
+     * @param indices   The indices to load
+     * @param isize     The number of indices to load
+     */
+    void streamData(const void* vertices, GLsizei vsize, const GLuint* indices, GLsizei isize);
     
     /**
      * Draws to the active framebuffer using this vertex buffer
@@ -399,6 +475,23 @@ public:
     void setupAttribute(const std::string name, GLint size, GLenum type,
                         GLboolean norm, GLsizei offset);
     
+    /**
+     * Sets the instance divisor of the given attribute.
+     *
+     * An attribute with divisor 0 (the default) advances once per vertex. An
+     * attribute with divisor n advances once every n instances in a call to
+     * {@link #drawInstanced}. This allows a buffer to hold per-instance data,
+     * such as the transform of a sprite, which is shared by all of the vertices
+     * of that instance.
+     *
+     * The attribute must have been set up with {@link #setupAttribute}. The
+     * divisor is cached and applied whenever a shader is attached.
+     *
+     * @param name      The attribute name
+     * @param divisor   The number of instances between updates of the attribute
+     */
+    void setAttributeDivisor(const std::string name, GLuint divisor);
+    
     
     /**
      * Enables the given attribute
@@ -29,8 +29,10 @@
 #define __CU_RENDER_PKG_H__
 
 #include "CURenderBase.h"
+#include "CURenderState.h"
 #include "CUSpriteVertex.h"
 #include "CUTexture.h"
+#include "CUCompressedImage.h"
 #include "CUMesh.h"
 #include "CUScissor.h"
 #include "CUGradient.h"
@@ -41,6 +43,8 @@
 #include "CUShader.h"
 #include "CUUniformBuffer.h"
 #include "CURenderTarget.h"
+#include "CURenderTargetPool.h"
+#include "CUFrameReader.h"
 #include "CUStencilEffect.h"
 #include "CUSpriteBatch.h"
 #include "CUSpriteSheet.h"
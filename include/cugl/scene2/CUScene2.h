@@ -46,8 +46,20 @@
 #include <cugl/math/cu_math.h>
 #include <cugl/scene2/graph/CUSceneNode.h>
 #include <cugl/render/CUOrthographicCamera.h>
+#include <cugl/render/CURenderTargetPool.h>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace cugl {
+
+/** Forward reference to a thread pool */
+class ThreadPool;
+/** Forward reference to a font */
+class Font;
+namespace scene2 {
+    /** Forward reference to a label batch */
+    class LabelBatch;
+}
     
 /**
  * This class provides the root node of a two-dimensional scene graph.
@@ -87,6 +99,70 @@ protected:
 
     /** Whether or note this scene is still active */
     bool _active;
+    
+    /** The recordings for parallel rendering (one per group of children) */
+    std::vector<std::shared_ptr<SpriteBatch>> _recorders;
+
+    /** Whether to skip subtrees outside of the camera view */
+    bool _culling;
+    /** The camera view in world coordinates (updated each render) */
+    Rect _cullRect;
+    /** The camera frustum in world coordinates (updated each render) */
+    Frustum _cullFrustum;
+
+    /**
+     * The range of pick grid cells covered by an interactive node
+     */
+    class PickCells {
+    public:
+        /** The leftmost cell column */
+        int left;
+        /** The bottommost cell row */
+        int bottom;
+        /** The rightmost cell column */
+        int right;
+        /** The topmost cell row */
+        int top;
+    };
+
+    /** The size of a pick grid cell in world coordinates (0 if there is no grid) */
+    float _pickCell;
+    /** The interactive nodes in this scene */
+    std::unordered_set<scene2::SceneNode*> _pickables;
+    /** The interactive nodes whose grid cells are out of date */
+    std::unordered_set<scene2::SceneNode*> _pickDirty;
+    /** The interactive nodes overlapping each cell of the pick grid */
+    std::unordered_map<Uint64, std::vector<scene2::SceneNode*>> _pickGrid;
+    /** The grid cells covered by each interactive node in the pick grid */
+    std::unordered_map<scene2::SceneNode*, PickCells> _pickRanges;
+
+    /** Whether this scene renders to a render target (which cannot be nested) */
+    bool _offscreen;
+    /** The render targets for cached subtrees (see {@link scene2::SceneNode#setCacheAsTexture}) */
+    std::shared_ptr<RenderTargetPool> _targets;
+
+    /** The font for the profiler overlay (nullptr for no overlay) */
+    std::shared_ptr<Font> _profileFont;
+    /** The merged label text (nullptr if label batching is disabled) */
+    std::shared_ptr<scene2::LabelBatch> _labelBatch;
+
+    /**
+     * Updates the culling rectangle to match the current camera view.
+     *
+     * This also updates the culling frustum. This method should be called at
+     * the start of each render pass.
+     */
+    void updateCullRect();
+
+    /**
+     * Draws the profiler overlay in the top left corner of the camera view.
+     *
+     * The overlay shows the statistics of the last complete profiler frame
+     * (see {@link scene2::Scene2Profiler}). The sprite batch must be active.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     */
+    void drawProfile(const std::shared_ptr<SpriteBatch>& batch);
 
 #pragma mark -
 #pragma mark Constructors
@@ -324,6 +400,123 @@ public:
      * @param color  The tint color for this scene.
      */
     void setColor(Color4 color) { _color = color; }
+
+    /**
+     * Returns true if this scene skips nodes outside of the camera view.
+     *
+     * When culling is enabled, any subtree whose bounds (see
+     * {@link scene2::SceneNode#getSubtreeBounds}) do not intersect the camera
+     * view is neither drawn nor traversed. This assumes that every node draws
+     * inside of its content size. Nodes that draw outside of it (such as a
+     * {@link scene2::PathNode} with a wide stroke) may be culled too early,
+     * so culling is disabled by default.
+     *
+     * @return true if this scene skips nodes outside of the camera view.
+     */
+    bool isCulling() const { return _culling; }
+
+    /**
+     * Sets whether this scene skips nodes outside of the camera view.
+     *
+     * When culling is enabled, any subtree whose bounds (see
+     * {@link scene2::SceneNode#getSubtreeBounds}) do not intersect the camera
+     * view is neither drawn nor traversed. This assumes that every node draws
+     * inside of its content size. Nodes that draw outside of it (such as a
+     * {@link scene2::PathNode} with a wide stroke) may be culled too early,
+     * so culling is disabled by default.
+     *
+     * @param value Whether this scene skips nodes outside of the camera view.
+     */
+    void setCulling(bool value) { _culling = value; }
+
+    /**
+     * Returns the font of the profiler overlay
+     *
+     * If this value is not nullptr, and {@link scene2::Scene2Profiler} is
+     * enabled, this scene draws the statistics of the last profiler frame
+     * on top of its children. The overlay lists the frame time, the sprite
+     * batch statistics, and the most expensive scopes by self time.
+     *
+     * @return the font of the profiler overlay
+     */
+    const std::shared_ptr<Font>& getProfileFont() const { return _profileFont; }
+
+    /**
+     * Sets the font of the profiler overlay
+     *
+     * If this value is not nullptr, and {@link scene2::Scene2Profiler} is
+     * enabled, this scene draws the statistics of the last profiler frame
+     * on top of its children. The overlay lists the frame time, the sprite
+     * batch statistics, and the most expensive scopes by self time.
+     *
+     * @param font  The font of the profiler overlay
+     */
+    void setProfileFont(const std::shared_ptr<Font>& font) { _profileFont = font; }
+
+    /**
+     * Returns true if this scene merges the text of its labels.
+     *
+     * When label batching is enabled, the glyphs of every {@link scene2::Label}
+     * in this scene are merged into one mesh for each font atlas page, and
+     * drawn after the rest of the scene (see {@link scene2::LabelBatch}). So a
+     * text-heavy HUD costs only a few draw calls. Labels are drawn in order
+     * of their priority (see {@link scene2::SceneNode#setPriority}), but they
+     * are always on top of the other nodes. Hence this is disabled by default.
+     *
+     * Labels are not merged by {@link #renderParallel}.
+     *
+     * @return true if this scene merges the text of its labels.
+     */
+    bool isLabelBatching() const { return _labelBatch != nullptr; }
+
+    /**
+     * Sets whether this scene merges the text of its labels.
+     *
+     * When label batching is enabled, the glyphs of every {@link scene2::Label}
+     * in this scene are merged into one mesh for each font atlas page, and
+     * drawn after the rest of the scene (see {@link scene2::LabelBatch}). So a
+     * text-heavy HUD costs only a few draw calls. Labels are drawn in order
+     * of their priority (see {@link scene2::SceneNode#setPriority}), but they
+     * are always on top of the other nodes. Hence this is disabled by default.
+     *
+     * Labels are not merged by {@link #renderParallel}.
+     *
+     * @param value Whether this scene merges the text of its labels.
+     */
+    void setLabelBatching(bool value);
+
+    /**
+     * Returns the label batch of this scene (or nullptr if it is disabled)
+     *
+     * This is used by {@link scene2::Label} to merge its glyphs, and may be
+     * queried for statistics.
+     *
+     * @return the label batch of this scene (or nullptr if it is disabled)
+     */
+    const std::shared_ptr<scene2::LabelBatch>& getLabelBatch() const { return _labelBatch; }
+
+    /**
+     * Returns the camera view used for culling, in world coordinates.
+     *
+     * This rectangle is computed from the camera at the start of each call
+     * to {@link #render}. It is the bounding box of the camera view when the
+     * camera is rotated.
+     *
+     * @return the camera view used for culling, in world coordinates.
+     */
+    const Rect& getCullRect() const { return _cullRect; }
+
+    /**
+     * Returns the camera frustum used for culling, in world coordinates.
+     *
+     * This frustum is computed from the camera at the start of each call
+     * to {@link #render}. Unlike {@link #getCullRect}, it is exact when the
+     * camera is rotated. Scene nodes use it to cull their children in
+     * batches (see {@link Frustum#cullBoxes}).
+     *
+     * @return the camera frustum used for culling, in world coordinates.
+     */
+    const Frustum& getCullFrustum() const { return _cullFrustum; }
     
     /**
      * Returns a string representation of this scene for debugging purposes.
@@ -795,9 +988,178 @@ public:
      */
     virtual void render(const std::shared_ptr<SpriteBatch>& batch);
     
+    /**
+     * Draws all of the children in this scene, recording them in parallel.
+     *
+     * This method is identical to {@link #render}, except that the children
+     * are split into (at most) the given number of contiguous groups. Each
+     * group is traversed on the thread pool (or this thread), drawing to its
+     * own recording sprite batch (see {@link SpriteBatch#initRecorder}). The
+     * recordings are then replayed to the given sprite batch in the order of
+     * the children. So the result is the same as {@link #render}, and all
+     * OpenGL calls still take place on this thread. This method blocks until
+     * every group is recorded.
+     *
+     * This is only safe if the children are independent, and if their draw
+     * methods only use the sprite batch. In particular, no node may be
+     * modified (or lazily build OpenGL resources) while the scene renders.
+     * The sprite batch must not be active, and the recordings are reused on
+     * the next call to this method.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param pool      The thread pool to record with.
+     * @param tasks     The maximum number of groups to record in parallel.
+     */
+    void renderParallel(const std::shared_ptr<SpriteBatch>& batch,
+                        const std::shared_ptr<ThreadPool>& pool, Uint32 tasks=4);
+
+#pragma mark -
+#pragma mark Picking
+    /**
+     * Returns the size of a pick grid cell in world coordinates.
+     *
+     * The pick grid is a spatial index of the interactive nodes in this scene
+     * (see {@link scene2::SceneNode#setInteractive}). Each interactive node is
+     * stored in every cell that its bounding box overlaps, and the cells are
+     * only updated when the node (or one of its ancestors) is transformed.
+     * Hence {@link #pick} only tests the nodes in a single cell. A value of 0
+     * means that there is no grid, and every interactive node is tested.
+     *
+     * A good cell size is about the size of a typical interactive node.
+     *
+     * @return the size of a pick grid cell in world coordinates.
+     */
+    float getPickGrid() const { return _pickCell; }
+
+    /**
+     * Sets the size of a pick grid cell in world coordinates.
+     *
+     * The pick grid is a spatial index of the interactive nodes in this scene
+     * (see {@link scene2::SceneNode#setInteractive}). Each interactive node is
+     * stored in every cell that its bounding box overlaps, and the cells are
+     * only updated when the node (or one of its ancestors) is transformed.
+     * Hence {@link #pick} only tests the nodes in a single cell. A value of 0
+     * means that there is no grid, and every interactive node is tested.
+     *
+     * A good cell size is about the size of a typical interactive node.
+     *
+     * @param size  The size of a pick grid cell in world coordinates.
+     */
+    void setPickGrid(float size);
+
+    /**
+     * Returns the topmost interactive node containing the given world point.
+     *
+     * A node contains a point if the point is inside its content bounds, and
+     * the node and all of its ancestors are visible. If several nodes contain
+     * the point, this method returns the one drawn last in a pre-order
+     * traversal. It returns nullptr if no interactive node contains the point.
+     *
+     * @param point     The point in world coordinates
+     *
+     * @return the topmost interactive node containing the given world point.
+     */
+    std::shared_ptr<scene2::SceneNode> pick(const Vec2 point);
+
+    /**
+     * Returns the topmost interactive node containing the given screen point.
+     *
+     * A node contains a point if the point is inside its content bounds, and
+     * the node and all of its ancestors are visible. If several nodes contain
+     * the point, this method returns the one drawn last in a pre-order
+     * traversal. It returns nullptr if no interactive node contains the point.
+     *
+     * @param point     The point in screen coordinates
+     *
+     * @return the topmost interactive node containing the given screen point.
+     */
+    std::shared_ptr<scene2::SceneNode> pickScreen(const Vec2 point) {
+        Vec3 world = screenToWorldCoords(point);
+        return pick(Vec2(world.x,world.y));
+    }
+
+    /**
+     * Returns true if the given node might contain the given world point.
+     *
+     * This is a fast rejection test for input handlers. It returns false
+     * only if the node is interactive, and the pick grid shows that it is
+     * nowhere near the point. A true result must be confirmed with an exact
+     * test of the node bounds.
+     *
+     * @param node      The node to test
+     * @param point     The point in world coordinates
+     *
+     * @return true if the given node might contain the given world point.
+     */
+    bool mayPick(const scene2::SceneNode* node, const Vec2 point);
+    
 private:
 #pragma mark -
 #pragma mark Internal Helpers
+    /**
+     * Adds an interactive node to the pick index.
+     *
+     * @param node  The interactive node
+     */
+    void addPickable(scene2::SceneNode* node);
+
+    /**
+     * Removes an interactive node from the pick index.
+     *
+     * @param node  The interactive node
+     */
+    void removePickable(scene2::SceneNode* node);
+
+    /**
+     * Marks the grid cells of an interactive node as out of date.
+     *
+     * @param node  The interactive node
+     */
+    void dirtyPickable(scene2::SceneNode* node) { _pickDirty.emplace(node); }
+
+    /**
+     * Removes an interactive node from all of its grid cells.
+     *
+     * @param node  The interactive node
+     */
+    void unlinkPickable(scene2::SceneNode* node);
+
+    /**
+     * Recomputes the grid cells of all out of date interactive nodes.
+     */
+    void updatePickGrid();
+
+    /**
+     * Returns true if node a is drawn before node b in a pre-order traversal.
+     *
+     * @param a     The first node
+     * @param b     The second node
+     *
+     * @return true if node a is drawn before node b in a pre-order traversal.
+     */
+    bool drawsBefore(const scene2::SceneNode* a, const scene2::SceneNode* b) const;
+
+    /**
+     * Returns a render target at least the given size for a cached subtree.
+     *
+     * The size is rounded up so that targets can be shared by subtrees of
+     * similar size. An idle target of that size is reused if possible.
+     * This method returns nullptr if the target could not be allocated.
+     *
+     * @param width     The minimum width in pixels
+     * @param height    The minimum height in pixels
+     *
+     * @return a render target at least the given size for a cached subtree.
+     */
+    std::shared_ptr<RenderTarget> acquireTarget(Uint32 width, Uint32 height);
+
+    /**
+     * Returns a render target to the pool of idle targets.
+     *
+     * @param target    The render target to release
+     */
+    void releaseTarget(const std::shared_ptr<RenderTarget>& target);
+
     // Tightly couple with Node
     friend class scene2::SceneNode;
 };
@@ -0,0 +1,344 @@
+//
+//  CUScene2Profiler.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides an opt-in hierarchical profiler for the scene graph.
+//  When enabled, the scene graph times the rendering, layout, and actions of
+//  each node, aggregating the results per named node and per frame. The
+//  results can be shown as an overlay in a Scene2 (see Scene2#setProfileFont)
+//  or saved as a Chrome trace (chrome://tracing or https://ui.perfetto.dev).
+//
+//  This class is a static class. It has no constructors, and all of its
+//  methods are static. The profiler only records on the thread that began
+//  the current frame, so it does not record parallel rendering.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_SCENE2_PROFILER_H__
+#define __CU_SCENE2_PROFILER_H__
+#include <cugl/base/CUBase.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace cugl {
+
+/** Forward reference to a sprite batch */
+class SpriteBatch;
+/** Forward reference to a JSON value */
+class JsonValue;
+
+    /**
+     * The classes to construct a 2-d scene graph.
+     *
+     * Even though this is an optional package, we promote these classes to
+     * the main namespace for convenience.
+     */
+    namespace scene2 {
+
+/** Forward reference to a scene graph node */
+class SceneNode;
+
+/**
+ * This class is a hierarchical frame profiler for the scene graph.
+ *
+ * The profiler is disabled by default, and costs a single branch per scope
+ * when disabled. When enabled, every call to {@link SceneNode#render},
+ * {@link SceneNode#doLayout}, and {@link ActionManager#update} is timed. The
+ * times are aggregated by node name (or class name for unnamed nodes), so
+ * the sprites of a level report as one entry. Each entry records both the
+ * total time of the call (including its children) and the self time (not
+ * including its children).
+ *
+ * A frame is the time between calls to {@link #beginFrame} and {@link #endFrame}.
+ * Only scopes inside of a frame are recorded. The statistics of the most
+ * recent complete frame are available from {@link #getEntries} and
+ * {@link #getFrameStats}. The profiler also keeps the scopes of recent frames
+ * (see {@link #setTraceCapacity}), which can be saved as a Chrome trace with
+ * {@link #writeTrace}.
+ *
+ * The profiler only records scopes on the thread that called {@link #beginFrame}.
+ * Scopes on any other thread, such as those of {@link Scene2#renderParallel},
+ * are ignored.
+ */
+class Scene2Profiler {
+public:
+    /**
+     * The category of a profiler scope
+     */
+    enum class Category : int {
+        /** A call to {@link SceneNode#render} */
+        RENDER  = 0,
+        /** A call to {@link SceneNode#doLayout} */
+        LAYOUT  = 1,
+        /** A call to {@link ActionManager#update} */
+        ACTIONS = 2,
+        /** A user-defined scope */
+        USER    = 3
+    };
+
+    /**
+     * The aggregated time of all scopes with the same name and category
+     */
+    class Entry {
+    public:
+        /** The scope name */
+        std::string name;
+        /** The scope category */
+        Category category;
+        /** The time in microseconds, including nested scopes */
+        Uint64 total;
+        /** The time in microseconds, excluding nested scopes */
+        Uint64 self;
+        /** The number of timed calls */
+        Uint32 calls;
+    };
+
+    /**
+     * The statistics of a single frame
+     */
+    class FrameStats {
+    public:
+        /** The frame number */
+        Uint64 frame;
+        /** The length of the frame in microseconds */
+        Uint64 duration;
+        /** The number of draw calls made by the sprite batch */
+        Uint32 calls;
+        /** The number of vertices drawn by the sprite batch */
+        Uint32 vertices;
+        /** The number of state changes made by the sprite batch */
+        Uint32 states;
+        /** The time in microseconds spent flushing the sprite batch */
+        Uint64 flush;
+
+        /**
+         * Creates an empty frame record
+         */
+        FrameStats() : frame(0), duration(0), calls(0), vertices(0), states(0), flush(0) {}
+    };
+
+    /**
+     * A timer for the lifetime of a C++ scope
+     *
+     * Creating this object opens a profiler scope, and deleting it closes the
+     * scope. So a block is timed by creating one of these at the start. If
+     * the profiler is disabled, this object does nothing.
+     */
+    class Scope {
+    private:
+        /** Whether this scope is recorded */
+        bool _active;
+
+    public:
+        /**
+         * Opens a profiler scope with the given category and name.
+         *
+         * @param category  The scope category
+         * @param name      The scope name
+         */
+        Scope(Category category, const std::string& name) : _active(false) {
+            if (Scene2Profiler::_enabled) {
+                _active = Scene2Profiler::push(category,name);
+            }
+        }
+
+        /**
+         * Opens a profiler scope for the given scene graph node.
+         *
+         * The name of the scope is the name of the node. If the node has no
+         * name, it is the class name of the node.
+         *
+         * @param category  The scope category
+         * @param node      The node being timed
+         */
+        Scope(Category category, const SceneNode* node) : _active(false) {
+            if (Scene2Profiler::_enabled) {
+                _active = Scene2Profiler::push(category,node);
+            }
+        }
+
+        /**
+         * Closes this profiler scope
+         */
+        ~Scope() {
+            if (_active) {
+                Scene2Profiler::pop();
+            }
+        }
+    };
+
+private:
+    /** Whether the profiler is enabled */
+    static bool _enabled;
+
+    /**
+     * Returns true if a scope with the given category and name was opened
+     *
+     * This method fails if called outside of a frame, or on a thread other
+     * than the one that began the frame.
+     *
+     * @param category  The scope category
+     * @param name      The scope name
+     *
+     * @return true if a scope with the given category and name was opened
+     */
+    static bool push(Category category, const std::string& name);
+
+    /**
+     * Returns true if a scope for the given scene graph node was opened
+     *
+     * This method fails if called outside of a frame, or on a thread other
+     * than the one that began the frame.
+     *
+     * @param category  The scope category
+     * @param node      The node being timed
+     *
+     * @return true if a scope for the given scene graph node was opened
+     */
+    static bool push(Category category, const SceneNode* node);
+
+    /**
+     * Closes the innermost profiler scope
+     */
+    static void pop();
+
+public:
+#pragma mark Activation
+    /**
+     * Sets whether the profiler is enabled
+     *
+     * Disabling the profiler in the middle of a frame abandons that frame.
+     *
+     * @param flag  Whether the profiler is enabled
+     */
+    static void setEnabled(bool flag);
+
+    /**
+     * Returns true if the profiler is enabled
+     *
+     * @return true if the profiler is enabled
+     */
+    static bool isEnabled() { return _enabled; }
+
+    /**
+     * Starts a new profiler frame
+     *
+     * This should be called once per animation frame, typically at the start
+     * of the update. The profiler records scopes on this thread until the
+     * next call to {@link #endFrame}. This method does nothing if the
+     * profiler is disabled.
+     */
+    static void beginFrame();
+
+    /**
+     * Completes the current profiler frame
+     *
+     * The sprite batch statistics are read from the given batch, which should
+     * be the one that rendered the frame. As these statistics are reset by
+     * {@link SpriteBatch#begin}, this method should be called after the last
+     * drawing pass of the frame. The batch may be nullptr. This method does
+     * nothing if no frame was started.
+     *
+     * @param batch The sprite batch that rendered this frame
+     */
+    static void endFrame(const std::shared_ptr<SpriteBatch>& batch=nullptr);
+
+#pragma mark Statistics
+    /**
+     * Returns the aggregated scopes of the most recent complete frame
+     *
+     * The entries are sorted from the largest to the smallest self time.
+     *
+     * @return the aggregated scopes of the most recent complete frame
+     */
+    static const std::vector<Entry>& getEntries();
+
+    /**
+     * Returns the statistics of the most recent complete frame
+     *
+     * @return the statistics of the most recent complete frame
+     */
+    static const FrameStats& getFrameStats();
+
+    /**
+     * Returns the name of the given category
+     *
+     * @param category  The scope category
+     *
+     * @return the name of the given category
+     */
+    static const char* getCategoryName(Category category);
+
+#pragma mark Tracing
+    /**
+     * Returns the number of recent frames kept for tracing
+     *
+     * By default this value is 120.
+     *
+     * @return the number of recent frames kept for tracing
+     */
+    static size_t getTraceCapacity();
+
+    /**
+     * Sets the number of recent frames kept for tracing
+     *
+     * Every scope of a traced frame is kept, so large scenes should use a
+     * small value. A value of 0 disables tracing. By default this value is 120.
+     *
+     * @param frames    The number of recent frames kept for tracing
+     */
+    static void setTraceCapacity(size_t frames);
+
+    /**
+     * Returns the recent frames as a Chrome trace
+     *
+     * The trace is a JSON object in the Trace Event Format. Each scope is a
+     * complete ("X") event, and the sprite batch statistics of each frame are
+     * counter ("C") events.
+     *
+     * @return the recent frames as a Chrome trace
+     */
+    static std::shared_ptr<JsonValue> getTrace();
+
+    /**
+     * Returns true if the recent frames were saved as a Chrome trace
+     *
+     * The file can be opened with chrome://tracing or https://ui.perfetto.dev.
+     *
+     * @param path  The file to write
+     *
+     * @return true if the recent frames were saved as a Chrome trace
+     */
+    static bool writeTrace(const std::string& path);
+
+    /**
+     * Deletes all frame statistics and traced frames
+     */
+    static void clear();
+};
+
+    }
+}
+
+#endif /* __CU_SCENE2_PROFILER_H__ */
@@ -42,10 +42,11 @@
 #define __CU_ACTION_MANAGER_H__
 
 #include "CUAction.h"
+#include <cugl/math/CUEasingFunction.h>
 #include <SDL.h>
 #include <unordered_map>
-#include <unordered_set>
 #include <algorithm>
+#include <vector>
 
 namespace cugl {
     /**
@@ -65,6 +66,19 @@ namespace cugl {
  * is complete. Each update frame, the manager moves the animation further along 
  * until it is complete.
  *
+ * Keys may either be strings or integer handles. A handle is returned when an
+ * animation is activated without a string key. Handles are much faster, as they
+ * require no hashing, and are the preferred way to run thousands of animations.
+ * A handle is never reused, so a stale handle (for a completed animation) is
+ * simply inactive. The handle 0 is never a valid animation.
+ *
+ * Animations may be eased with an arbitrary function, or with one of the
+ * types in {@link EasingFunction}. Typed easing is preferred for large numbers
+ * of animations. Each update, the manager gathers the tweening times of all
+ * animations into contiguous arrays, grouped by their easing type, and
+ * evaluates each group in a single batch (see {@link EasingFunction#evaluate}).
+ * Only the final write to each node is done one animation at a time.
+ *
  * An action manager is not implemented as a singleton.  However, you typically
  * only need one manager per application.
  */
@@ -83,6 +97,15 @@ class ActionManager {
      */
     class ActionInstance {
     public:
+        /** The string key of this animation (empty if there is none) */
+        std::string key;
+
+        /** The handle of this animation */
+        Uint64 handle;
+
+        /** The position of this instance in the array of active animations */
+        size_t index;
+
         /** The node the action is performed on */
         std::shared_ptr<scene2::SceneNode> target;
         
@@ -91,6 +114,12 @@ class ActionManager {
         
         /** The interpolation function on [0,1] to allow non-linear behavior */
         std::function<float(float)> interpolant;
+
+        /** The easing type, if this animation is eased in batch */
+        EasingFunction::Type easing;
+
+        /** Whether this animation uses a typed (batched) easing function */
+        bool batched;
         
         /** Any internal state needed by this action */
         void* state;
@@ -111,7 +140,7 @@ class ActionManager {
          * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
          * the heap, use one of the static constructors instead.
          */
-        ActionInstance() : state(NULL), duration(0.0f), elapsed(0.0f), paused(false) {}
+        ActionInstance() : handle(0), index(0), easing(EasingFunction::Type::LINEAR), batched(false), state(NULL), duration(0.0f), elapsed(0.0f), paused(false) {}
         
         /**
          * Deletes this action instance, disposing all resources
@@ -121,12 +150,78 @@ class ActionManager {
     
 #pragma mark Values
 protected:
+    /** The active animations, stored contiguously for updates */
+    std::vector<ActionInstance*> _actions;
+
+    /** The animation for each handle slot (nullptr if the slot is free) */
+    std::vector<ActionInstance*> _slots;
+    /** The current generation of each handle slot */
+    std::vector<Uint32> _generations;
+    /** The handle slots available for reuse */
+    std::vector<Uint32> _freeslots;
+    /** The animation instances available for reuse */
+    std::vector<ActionInstance*> _recycled;
+
+    /** A map that associates string keys with animation handles */
+    std::unordered_map<std::string, Uint64> _keys;
     /** A map that associates nodes with their (multiple) animations */
-    std::unordered_map<SceneNode*, std::unordered_set<std::string>> _keys;
-    
-    /** A map that associates keys with animations */
-    std::unordered_map<std::string, ActionInstance*> _actions;
-    
+    std::unordered_map<SceneNode*, std::vector<Uint64>> _targets;
+
+    /** The eased start time of each animation this update (by array position) */
+    std::vector<float> _tweenStart;
+    /** The eased end time of each animation this update (by array position) */
+    std::vector<float> _tweenEnd;
+    /** The array positions of the batched animations, grouped by easing type */
+    std::vector<size_t> _tweenOrder;
+    /** The tweening times of the batched animations, grouped by easing type */
+    std::vector<float> _tweenTimes;
+
+    /**
+     * Returns the animation for the given handle
+     *
+     * This method returns nullptr if the handle is not active.
+     *
+     * @param handle    The animation handle
+     *
+     * @return the animation for the given handle
+     */
+    ActionInstance* lookup(Uint64 handle) const;
+
+    /**
+     * Returns the animation for the given string key
+     *
+     * This method returns nullptr if the key is not active.
+     *
+     * @param key       The identifying key
+     *
+     * @return the animation for the given string key
+     */
+    ActionInstance* lookup(const std::string& key) const;
+
+    /**
+     * Returns a newly started animation with the given target and action
+     *
+     * The animation is assigned a fresh handle, but no string key.
+     *
+     * @param action    The action to animate with
+     * @param target    The node to animate on
+     * @param easing    The easing (interpolation) function
+     *
+     * @return a newly started animation with the given target and action
+     */
+    ActionInstance* acquire(const std::shared_ptr<Action>& action,
+                            const std::shared_ptr<SceneNode>& target,
+                            std::function<float(float)> easing);
+
+    /**
+     * Stops the given animation and recycles its instance
+     *
+     * The handle (and string key) of this animation become inactive.
+     *
+     * @param instance  The animation to stop
+     */
+    void release(ActionInstance* instance);
+
 
 public:
 #pragma mark Constructors
@@ -178,7 +273,7 @@ public:
      *
      * @return true if the given key represents an active animation
      */
-    bool isActive(std::string key) const;
+    bool isActive(const std::string& key) const;
     
     /**
      * Actives an animation with the given target and action
@@ -191,7 +286,7 @@ public:
      *
      * @return true if the animation was successfully started
      */
-    bool activate(std::string key,
+    bool activate(const std::string& key,
                   const std::shared_ptr<Action>& action,
                   const std::shared_ptr<SceneNode>& target) {
         return activate(key,action,target, nullptr);
@@ -214,10 +309,98 @@ public:
      *
      * @return true if the animation was successfully started
      */
-    bool activate(std::string key,
+    bool activate(const std::string& key,
                   const std::shared_ptr<Action>& action,
                   const std::shared_ptr<SceneNode>& target,
                   std::function<float(float)> easing);
+
+    /**
+     * Actives an animation with the given target and action, returning its handle
+     *
+     * The easing function allows for effects like bouncing or elasticity in
+     * the linear interpolation. If null, the animation will use the standard
+     * linear easing.
+     *
+     * The animation has no string key. The handle should be used to pause or
+     * remove it instead. This is the fastest way to start an animation.
+     *
+     * @param action    The action to animate with
+     * @param target    The node to animate on
+     * @param easing    The easing (interpolation) function
+     *
+     * @return the handle of the new animation
+     */
+    Uint64 activate(const std::shared_ptr<Action>& action,
+                    const std::shared_ptr<SceneNode>& target,
+                    std::function<float(float)> easing=nullptr);
+
+    /**
+     * Actives an animation with the given target, action, and easing type
+     *
+     * Unlike an arbitrary easing function, a typed easing function is
+     * evaluated in batch with all other animations of the same type. This is
+     * the preferred way to ease large numbers of animations.
+     *
+     * This method will fail if the provided key is already in use.
+     *
+     * @param key       The identifying key
+     * @param action    The action to animate with
+     * @param target    The node to animate on
+     * @param easing    The easing function type
+     *
+     * @return true if the animation was successfully started
+     */
+    bool activate(const std::string& key,
+                  const std::shared_ptr<Action>& action,
+                  const std::shared_ptr<SceneNode>& target,
+                  EasingFunction::Type easing);
+
+    /**
+     * Actives an animation with the given target, action, and easing type
+     *
+     * Unlike an arbitrary easing function, a typed easing function is
+     * evaluated in batch with all other animations of the same type. This is
+     * the preferred way to ease large numbers of animations.
+     *
+     * The animation has no string key. The handle should be used to pause or
+     * remove it instead.
+     *
+     * @param action    The action to animate with
+     * @param target    The node to animate on
+     * @param easing    The easing function type
+     *
+     * @return the handle of the new animation
+     */
+    Uint64 activate(const std::shared_ptr<Action>& action,
+                    const std::shared_ptr<SceneNode>& target,
+                    EasingFunction::Type easing);
+
+    /**
+     * Returns true if the given handle represents an active animation
+     *
+     * @param handle    The animation handle
+     *
+     * @return true if the given handle represents an active animation
+     */
+    bool isActive(Uint64 handle) const { return lookup(handle) != nullptr; }
+
+    /**
+     * Returns the handle for the animation with the given key
+     *
+     * This method returns 0 if there is no active animation for the key.
+     *
+     * @param key       The identifying key
+     *
+     * @return the handle for the animation with the given key
+     */
+    Uint64 getHandle(const std::string& key) const;
+
+    /**
+     * Returns the number of active animations
+     *
+     * @return the number of active animations
+     */
+    size_t size() const { return _actions.size(); }
     
     /**
      * Removes the animation for the given key.
@@ -232,7 +415,22 @@ public:
      *
      * @return true if the animation was successfully removed
      */
-    bool remove(std::string key);
+    bool remove(const std::string& key);
+
+    /**
+     * Removes the animation for the given handle.
+     *
+     * This act will immediately stop the animation.  The animated node will
+     * continue to have whatever state it had when the animation stopped.
+     *
+     * If there is no animation for the give handle (e.g. the animation is
+     * complete) this method will return false.
+     *
+     * @param handle    The animation handle
+     *
+     * @return true if the animation was successfully removed
+     */
+    bool remove(Uint64 handle);
 
     /**
      * Updates all non-paused animations by dt seconds
@@ -257,7 +455,19 @@ public:
      *
      * @return true if the animation for the given key is paused
      */
-    bool isPaused(std::string key);
+    bool isPaused(const std::string& key);
+
+    /**
+     * Returns true if the animation for the given handle is paused
+     *
+     * This method will return false if there is no active animation with the
+     * given handle.
+     *
+     * @param handle    The animation handle
+     *
+     * @return true if the animation for the given handle is paused
+     */
+    bool isPaused(Uint64 handle);
 
     /** 
      * Pauses the animation for the given key.
@@ -267,7 +477,17 @@ public:
      *
      * @param key       The identifying key
      */
-    void pause(std::string key);
+    void pause(const std::string& key);
+
+    /**
+     * Pauses the animation for the given handle.
+     *
+     * If there is no active animation for the given handle, or if it is
+     * already paused, this method does nothing.
+     *
+     * @param handle    The animation handle
+     */
+    void pause(Uint64 handle);
 
     /**
      * Unpauses the animation for the given key.
@@ -277,7 +497,17 @@ public:
      *
      * @param key       The identifying key
      */
-    void unpause(std::string key);
+    void unpause(const std::string& key);
+
+    /**
+     * Unpauses the animation for the given handle.
+     *
+     * If there is no active animation for the given handle, or if it is not
+     * currently paused, this method does nothing.
+     *
+     * @param handle    The animation handle
+     */
+    void unpause(Uint64 handle);
 
 #pragma mark -
 #pragma mark Node Management
@@ -314,7 +544,8 @@ public:
      * Returns the keys for all active animations of the given target
      *
      * The returned vector is a copy of the keys.  Modifying it has no affect
-     * on the underlying animation.
+     * on the underlying animation. Animations without a string key are not
+     * included (see {@link #getAllHandles}).
      *
      * @param target    The node to query animations
      *
@@ -322,6 +553,18 @@ public:
      */
     std::vector<std::string> getAllActions(const std::shared_ptr<SceneNode>& target) const;
 
+    /**
+     * Returns the handles for all active animations of the given target
+     *
+     * The returned vector is a copy of the handles.  Modifying it has no
+     * affect on the underlying animation.
+     *
+     * @param target    The node to query animations
+     *
+     * @return the handles for all active animations of the given target
+     */
+    std::vector<Uint64> getAllHandles(const std::shared_ptr<SceneNode>& target) const;
+
 };
     }
 }
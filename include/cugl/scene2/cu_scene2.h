@@ -30,6 +30,7 @@
 
 #include "CUScene2.h"
 #include "CUScene2Texture.h"
+#include "CUScene2Profiler.h"
 #include "graph/CUSceneNode.h"
 #include "graph/CUTexturedNode.h"
 #include "graph/CUPolygonNode.h"
@@ -38,8 +39,11 @@
 #include "graph/CUSpriteNode.h"
 #include "graph/CUOrderedNode.h"
 #include "graph/CUCanvasNode.h"
+#include "graph/CUParticleNode.h"
+#include "graph/CUSpriteLayerNode.h"
 #include "ui/CUButton.h"
 #include "ui/CULabel.h"
+#include "ui/CULabelBatch.h"
 #include "ui/CUProgressBar.h"
 #include "ui/CUSlider.h"
 #include "ui/CUNinePatch.h"
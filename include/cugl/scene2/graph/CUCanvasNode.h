@@ -58,6 +58,7 @@
 #define __CU_CANVAS_NODE_H__
 #include <cugl/scene2/graph/CUSceneNode.h>
 #include <cugl/render/CUTextAlignment.h>
+#include <unordered_map>
 
 namespace cugl {
 /** Forward reference for fonts */
@@ -146,6 +147,16 @@ protected:
      * and the render state (as a sequence of {@link Command} objects).
      */
     class Page;
+
+    /**
+     * A cached extrusion of a single path
+     *
+     * Extruding strokes (and anti-aliasing fringes) is the most expensive
+     * part of a drawing command. Animated canvases typically redraw the same
+     * paths every frame, so these meshes are saved, indexed by the path
+     * geometry and the stroke settings.
+     */
+    class Tessellation;
     
 #pragma mark -
 #pragma mark Paints
@@ -719,6 +730,18 @@ protected:
     size_t _draw;
     /** The active page for editing */
     size_t _edit;
+    /** The cached path extrusions, indexed by geometry hash */
+    std::unordered_map<Uint64, Tessellation*> _tessellations;
+    /** The screen scale used to flatten curves */
+    float _pathscale;
+
+    /**
+     * Removes all cached extrusions not used since the last sweep
+     *
+     * This method is called when the cache is full. If every extrusion
+     * was used, the cache is emptied.
+     */
+    void sweepTessellations();
     
 public:
 #pragma mark -
@@ -731,7 +754,7 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a Node on the
      * heap, use one of the static constructors instead.
      */
-    CanvasNode() : _draw(0), _edit(0) {}
+    CanvasNode() : _draw(0), _edit(0), _pathscale(1.0f) {}
     
     /**
      * Deletes this canvas node, disposing all resources
@@ -1082,6 +1105,28 @@ public:
      * Clears the drawing commands from all pages.
      */
     void clearAll();
+
+    /**
+     * Returns the number of cached path extrusions
+     *
+     * Stroking a path (or adding an anti-aliasing fringe to a fill) extrudes
+     * it into a mesh. These meshes are cached, indexed by the path geometry
+     * and the stroke settings, so redrawing an unchanged path (with any color
+     * or paint) does not extrude it again. The cache is shared by all pages.
+     *
+     * @return the number of cached path extrusions
+     */
+    size_t getTessellationCount() const { return _tessellations.size(); }
+
+    /**
+     * Deletes all cached path extrusions
+     *
+     * Stroking a path (or adding an anti-aliasing fringe to a fill) extrudes
+     * it into a mesh. These meshes are cached, indexed by the path geometry
+     * and the stroke settings, so redrawing an unchanged path (with any color
+     * or paint) does not extrude it again. The cache is shared by all pages.
+     */
+    void clearTessellations();
     
     /**
      * Draws the drawing page via the given SpriteBatch.
@@ -1179,6 +1224,36 @@ public:
      * @param fringe    The antialiasing fringe for this canvas node
      */
     void setFringe(float fringe);
+
+    /**
+     * Returns the screen scale used to flatten curves
+     *
+     * Curves (such as arcs and bezier segments) are approximated by the
+     * minimum number of line segments that keep the path within a fixed
+     * tolerance in screen space. This value is the number of screen units
+     * per unit of this canvas, such as the camera zoom times the scale of
+     * this node. Larger values produce smoother curves. The default is 1.
+     *
+     * This value is applied when each path is committed.
+     *
+     * @return the screen scale used to flatten curves
+     */
+    float getPathScale() const { return _pathscale; }
+
+    /**
+     * Sets the screen scale used to flatten curves
+     *
+     * Curves (such as arcs and bezier segments) are approximated by the
+     * minimum number of line segments that keep the path within a fixed
+     * tolerance in screen space. This value is the number of screen units
+     * per unit of this canvas, such as the camera zoom times the scale of
+     * this node. Larger values produce smoother curves. The default is 1.
+     *
+     * This value is applied when each path is committed.
+     *
+     * @param scale The screen scale used to flatten curves
+     */
+    void setPathScale(float scale);
     
     /**
      * Returns the transparency to apply to all rendered shapes.
@@ -165,7 +165,24 @@ public:
          * first and then the parent. However, children are sorted with respect
          * to their priority.  Children with the highest priority are drawn first.
          */
-        POST_DESCEND
+        POST_DESCEND,
+
+        /**
+         * Render the nodes in ascending order by priority, batched by render state
+         *
+         * Each node is given a 64 bit sort key. The high bits are the priority
+         * (which acts as a layer), followed by the texture and blend mode of the
+         * node. Nodes are radix sorted on this key, so that nodes of the same
+         * priority are grouped by texture and blend mode, minimizing the state
+         * changes (and draw calls) in the sprite batch. Ties are broken by the
+         * pre-order traversal value.
+         *
+         * This order assumes that nodes with the same priority may be drawn in
+         * any order. So a parent is not guaranteed to be drawn before a child
+         * of the same priority. Only use this order when nodes of the same
+         * priority do not overlap, or when their overlap does not matter.
+         */
+        BATCHED
     };
     
 protected:
@@ -193,6 +210,8 @@ protected:
         Color4 tint;
         /** The canonical order (for pre-order and post-order traversals) */
         Uint32 canonical;
+        /** The sort key (for batched order) */
+        Uint64 key;
         
         /**
          * Creates a drawing context with the given parent object
@@ -233,6 +252,35 @@ protected:
     std::shared_ptr<Scissor> _viewport;
     /** The current render order */
     Order _order;
+    /** The keyed render queue (for radix sorting in batched order) */
+    std::vector<std::pair<Uint64,Context*>> _keyed;
+    /** The scratch buffer for radix sorting */
+    std::vector<std::pair<Uint64,Context*>> _scratch;
+    
+    /**
+     * Sorts the render queue in batched order.
+     *
+     * Each entry is assigned a sort key from its priority, texture, and blend
+     * mode. The entries are then radix sorted on these keys. As radix sort is
+     * stable, entries with the same key remain in pre-order.
+     */
+    void sortBatched();
+
+    /** The sorted render queue of the previous frame, as canonical positions */
+    std::vector<Uint32> _permutation;
+    /** The render queue being sorted (for incremental sorting) */
+    std::vector<Context*> _sorted;
+
+    /**
+     * Sorts the render queue in a priority order.
+     *
+     * The entries are first placed in the sorted order of the previous frame.
+     * In a typical frame only a few priorities change, so this order is nearly
+     * sorted, and an insertion sort only has to move the changed entries. If
+     * the queue has changed size, or if the insertion sort does too much work,
+     * this method falls back to a full sort.
+     */
+    void sortIncremental();
     
     /**
      * Adds the given node ot the render queue.
@@ -587,7 +635,7 @@ public:
      *
      * @param order The render order of this node
      */
-    void setOrder(Order order) { _order = order; }
+    void setOrder(Order order) { _order = order; _permutation.clear(); }
 
     /**
      * Draws this node and all of its children with the given SpriteBatch.
@@ -0,0 +1,641 @@
+//
+//  CUParticleNode.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a scene graph node for a simple particle emitter.
+//  The particles are simulated on the CPU in a structure-of-arrays layout,
+//  so that each step of the simulation is a tight loop over a single array.
+//  They are drawn to the SpriteBatch as sprite instances, so that the entire
+//  emitter costs a single draw call, no matter how many particles it has.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_PARTICLE_NODE_H__
+#define __CU_PARTICLE_NODE_H__
+#include <cugl/scene2/graph/CUSceneNode.h>
+#include <cugl/render/CUSpriteVertex.h>
+#include <cugl/render/CUTexture.h>
+#include <random>
+#include <vector>
+
+/** The default maximum number of live particles */
+#define DEFAULT_PARTICLE_CAPACITY   256
+
+namespace cugl {
+
+    /**
+     * The classes to construct a 2-d scene graph.
+     *
+     * Even though this is an optional package, we promote these classes to
+     * the main namespace for convenience.
+     */
+    namespace scene2 {
+
+/**
+ * This is a scene graph node for a simple particle emitter.
+ *
+ * A particle node emits textured particles from a point (or disc) in its
+ * node space. Each particle is born with a random lifetime, speed, direction
+ * and spin, chosen from the ranges of this emitter. Over its life, it is
+ * pulled by gravity, slowed by damping, and its size and color are blended
+ * from the start values to the end values. Particles are in the coordinate
+ * space of this node, so moving the node moves every live particle with it.
+ *
+ * The particles are not simulated automatically. You must call {@link #update}
+ * each animation frame. The particles are stored as a structure of arrays,
+ * with one array per attribute, and every step of the simulation is a single
+ * loop over an array. Dead particles are swapped with the last live particle,
+ * so the live particles are always the first {@link #getCount} entries.
+ *
+ * The particles are drawn with {@link SpriteBatch#drawInstances}, so the
+ * emitter is drawn in a single call, regardless of the number of particles.
+ * Sprite instances ignore the scissor of the sprite batch, and so a particle
+ * node should not be placed inside of a scissored node. Particles do not use
+ * the gradient or shader effects of the sprite batch.
+ */
+class ParticleNode : public SceneNode {
+protected:
+    /** The texture of each particle (nullptr for a solid square) */
+    std::shared_ptr<Texture> _texture;
+    /** The blending equation for this texture */
+    GLenum _blendEquation;
+    /** The source factor for the blend function */
+    GLenum _srcFactor;
+    /** The destination factor for the blend function */
+    GLenum _dstFactor;
+
+    /** The maximum number of live particles */
+    size_t _capacity;
+    /** The current number of live particles */
+    size_t _count;
+    /** The x-coordinate of each particle */
+    std::vector<float> _posx;
+    /** The y-coordinate of each particle */
+    std::vector<float> _posy;
+    /** The x-velocity of each particle */
+    std::vector<float> _velx;
+    /** The y-velocity of each particle */
+    std::vector<float> _vely;
+    /** The angle of each particle in radians */
+    std::vector<float> _angle;
+    /** The angular velocity of each particle in radians per second */
+    std::vector<float> _spin;
+    /** The age of each particle in seconds */
+    std::vector<float> _age;
+    /** The lifetime of each particle in seconds */
+    std::vector<float> _life;
+    /** The sprite instances built when drawing */
+    std::vector<SpriteInstance> _instances;
+    /** The bounding box of the live particles in node space */
+    Rect _extent;
+
+    /** The emission point in node space */
+    Vec2 _emitter;
+    /** The radius of the emission disc */
+    float _radius;
+    /** The number of particles emitted per second */
+    float _rate;
+    /** The fractional particles left over from the last emission */
+    float _accumulator;
+    /** The minimum lifetime of a particle */
+    float _minLife;
+    /** The maximum lifetime of a particle */
+    float _maxLife;
+    /** The minimum initial speed of a particle */
+    float _minSpeed;
+    /** The maximum initial speed of a particle */
+    float _maxSpeed;
+    /** The angle of the emission direction in radians */
+    float _direction;
+    /** The width of the emission cone in radians */
+    float _spread;
+    /** The minimum angular velocity of a particle */
+    float _minSpin;
+    /** The maximum angular velocity of a particle */
+    float _maxSpin;
+    /** The acceleration applied to every particle */
+    Vec2 _gravity;
+    /** The fraction of velocity lost per second */
+    float _damping;
+    /** The size of a particle at birth */
+    float _startSize;
+    /** The size of a particle at death */
+    float _endSize;
+    /** The color of a particle at birth */
+    Color4f _startColor;
+    /** The color of a particle at death */
+    Color4f _endColor;
+    /** The random number generator for new particles */
+    std::minstd_rand _random;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an empty particle node.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    ParticleNode();
+
+    /**
+     * Deletes this node, disposing all resources
+     */
+    ~ParticleNode() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this node.
+     *
+     * A disposed node can be safely reinitialized. Any children owned by this
+     * node will be released. They will be deleted if no other object owns them.
+     *
+     * It is unsafe to call this on a node that is still currently inside of
+     * a scene graph.
+     */
+    virtual void dispose() override;
+
+    /**
+     * Initializes a particle node with untextured particles.
+     *
+     * Each particle is a solid square, and the node can have at most
+     * {@link DEFAULT_PARTICLE_CAPACITY} live particles.
+     *
+     * @return true if initialization was successful.
+     */
+    virtual bool init() override {
+        return initWithTexture(nullptr,DEFAULT_PARTICLE_CAPACITY);
+    }
+
+    /**
+     * Initializes a particle node with the given texture and capacity.
+     *
+     * The capacity is the maximum number of live particles. Particles emitted
+     * while the node is at capacity are discarded. If the texture is nullptr,
+     * each particle is a solid square.
+     *
+     * @param texture   The texture of each particle
+     * @param capacity  The maximum number of live particles
+     *
+     * @return true if initialization was successful.
+     */
+    bool initWithTexture(const std::shared_ptr<Texture>& texture,
+                         size_t capacity=DEFAULT_PARTICLE_CAPACITY);
+
+    /**
+     * Returns a newly allocated particle node with untextured particles.
+     *
+     * Each particle is a solid square, and the node can have at most
+     * {@link DEFAULT_PARTICLE_CAPACITY} live particles.
+     *
+     * @return a newly allocated particle node with untextured particles.
+     */
+    static std::shared_ptr<ParticleNode> alloc() {
+        std::shared_ptr<ParticleNode> result = std::make_shared<ParticleNode>();
+        return (result->init() ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated particle node with the given texture and capacity.
+     *
+     * The capacity is the maximum number of live particles. Particles emitted
+     * while the node is at capacity are discarded. If the texture is nullptr,
+     * each particle is a solid square.
+     *
+     * @param texture   The texture of each particle
+     * @param capacity  The maximum number of live particles
+     *
+     * @return a newly allocated particle node with the given texture and capacity.
+     */
+    static std::shared_ptr<ParticleNode> allocWithTexture(const std::shared_ptr<Texture>& texture,
+                                                          size_t capacity=DEFAULT_PARTICLE_CAPACITY) {
+        std::shared_ptr<ParticleNode> result = std::make_shared<ParticleNode>();
+        return (result->initWithTexture(texture,capacity) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Rendering Attributes
+    /**
+     * Returns the texture of each particle
+     *
+     * If this value is nullptr, each particle is a solid square.
+     *
+     * @return the texture of each particle
+     */
+    const std::shared_ptr<Texture>& getTexture() const { return _texture; }
+
+    /**
+     * Sets the texture of each particle
+     *
+     * If this value is nullptr, each particle is a solid square.
+     *
+     * @param texture   The texture of each particle
+     */
+    void setTexture(const std::shared_ptr<Texture>& texture) { _texture = texture; }
+
+    /**
+     * Sets the blending function for the particles
+     *
+     * The enums are the standard ones supported by OpenGL. See
+     *
+     *      https://www.opengl.org/sdk/docs/man/html/glBlendFunc.xhtml
+     *
+     * By default, srcFactor is GL_SRC_ALPHA while dstFactor is
+     * GL_ONE_MINUS_SRC_ALPHA. Additive particles (such as sparks or fire)
+     * should use GL_ONE for the dstFactor.
+     *
+     * @param srcFactor Specifies how the source blending factors are computed
+     * @param dstFactor Specifies how the destination blending factors are computed.
+     */
+    void setBlendFunc(GLenum srcFactor, GLenum dstFactor) { _srcFactor = srcFactor; _dstFactor = dstFactor; }
+
+    /**
+     * Returns the source blending factor
+     *
+     * @return the source blending factor
+     */
+    GLenum getSourceBlendFactor() const { return _srcFactor; }
+
+    /**
+     * Returns the destination blending factor
+     *
+     * @return the destination blending factor
+     */
+    GLenum getDestinationBlendFactor() const { return _dstFactor; }
+
+    /**
+     * Sets the blending equation for the particles
+     *
+     * The enum must be a standard ones supported by OpenGL. See
+     *
+     *      https://www.opengl.org/sdk/docs/man/html/glBlendEquation.xhtml
+     *
+     * By default this value is GL_FUNC_ADD.
+     *
+     * @param equation  Specifies how source and destination colors are combined
+     */
+    void setBlendEquation(GLenum equation) { _blendEquation = equation; }
+
+    /**
+     * Returns the blending equation for the particles
+     *
+     * @return the blending equation for the particles
+     */
+    GLenum getBlendEquation() const { return _blendEquation; }
+
+#pragma mark -
+#pragma mark Emitter Attributes
+    /**
+     * Returns the emission point in node space
+     *
+     * @return the emission point in node space
+     */
+    const Vec2& getEmitter() const { return _emitter; }
+
+    /**
+     * Sets the emission point in node space
+     *
+     * @param point The emission point in node space
+     */
+    void setEmitter(const Vec2 point) { _emitter = point; }
+
+    /**
+     * Returns the radius of the emission disc
+     *
+     * New particles are placed uniformly in a disc of this radius about the
+     * emission point. By default this value is 0.
+     *
+     * @return the radius of the emission disc
+     */
+    float getEmitterRadius() const { return _radius; }
+
+    /**
+     * Sets the radius of the emission disc
+     *
+     * New particles are placed uniformly in a disc of this radius about the
+     * emission point. By default this value is 0.
+     *
+     * @param radius    The radius of the emission disc
+     */
+    void setEmitterRadius(float radius) { _radius = radius; }
+
+    /**
+     * Returns the number of particles emitted per second
+     *
+     * A rate of 0 only emits particles on a call to {@link #emit}.
+     *
+     * @return the number of particles emitted per second
+     */
+    float getRate() const { return _rate; }
+
+    /**
+     * Sets the number of particles emitted per second
+     *
+     * A rate of 0 only emits particles on a call to {@link #emit}.
+     *
+     * @param rate  The number of particles emitted per second
+     */
+    void setRate(float rate) { _rate = rate; }
+
+    /**
+     * Returns the minimum lifetime of a particle in seconds
+     *
+     * @return the minimum lifetime of a particle in seconds
+     */
+    float getMinLifetime() const { return _minLife; }
+
+    /**
+     * Returns the maximum lifetime of a particle in seconds
+     *
+     * @return the maximum lifetime of a particle in seconds
+     */
+    float getMaxLifetime() const { return _maxLife; }
+
+    /**
+     * Sets the range of lifetimes of a particle in seconds
+     *
+     * @param min   The minimum lifetime
+     * @param max   The maximum lifetime
+     */
+    void setLifetime(float min, float max);
+
+    /**
+     * Returns the minimum initial speed of a particle
+     *
+     * @return the minimum initial speed of a particle
+     */
+    float getMinSpeed() const { return _minSpeed; }
+
+    /**
+     * Returns the maximum initial speed of a particle
+     *
+     * @return the maximum initial speed of a particle
+     */
+    float getMaxSpeed() const { return _maxSpeed; }
+
+    /**
+     * Sets the range of initial speeds of a particle
+     *
+     * @param min   The minimum speed
+     * @param max   The maximum speed
+     */
+    void setSpeed(float min, float max);
+
+    /**
+     * Returns the emission direction in radians
+     *
+     * @return the emission direction in radians
+     */
+    float getDirection() const { return _direction; }
+
+    /**
+     * Returns the width of the emission cone in radians
+     *
+     * @return the width of the emission cone in radians
+     */
+    float getSpread() const { return _spread; }
+
+    /**
+     * Sets the emission cone of this emitter
+     *
+     * Particles move away from the emission point at an angle chosen
+     * uniformly within spread/2 of the direction. A spread of 2π emits
+     * particles in every direction.
+     *
+     * @param direction The emission direction in radians
+     * @param spread    The width of the emission cone in radians
+     */
+    void setDirection(float direction, float spread) { _direction = direction; _spread = spread; }
+
+    /**
+     * Returns the minimum angular velocity of a particle in radians per second
+     *
+     * @return the minimum angular velocity of a particle in radians per second
+     */
+    float getMinSpin() const { return _minSpin; }
+
+    /**
+     * Returns the maximum angular velocity of a particle in radians per second
+     *
+     * @return the maximum angular velocity of a particle in radians per second
+     */
+    float getMaxSpin() const { return _maxSpin; }
+
+    /**
+     * Sets the range of angular velocities of a particle in radians per second
+     *
+     * @param min   The minimum angular velocity
+     * @param max   The maximum angular velocity
+     */
+    void setSpin(float min, float max);
+
+    /**
+     * Returns the acceleration applied to every particle
+     *
+     * @return the acceleration applied to every particle
+     */
+    const Vec2& getGravity() const { return _gravity; }
+
+    /**
+     * Sets the acceleration applied to every particle
+     *
+     * @param gravity   The acceleration applied to every particle
+     */
+    void setGravity(const Vec2 gravity) { _gravity = gravity; }
+
+    /**
+     * Returns the fraction of velocity lost per second
+     *
+     * @return the fraction of velocity lost per second
+     */
+    float getDamping() const { return _damping; }
+
+    /**
+     * Sets the fraction of velocity lost per second
+     *
+     * @param damping   The fraction of velocity lost per second
+     */
+    void setDamping(float damping) { _damping = damping; }
+
+    /**
+     * Returns the size of a particle at birth
+     *
+     * @return the size of a particle at birth
+     */
+    float getStartSize() const { return _startSize; }
+
+    /**
+     * Returns the size of a particle at death
+     *
+     * @return the size of a particle at death
+     */
+    float getEndSize() const { return _endSize; }
+
+    /**
+     * Sets the size of a particle at birth and at death
+     *
+     * The size is the width (and height) of a particle in node space. It is
+     * interpolated linearly over the life of the particle.
+     *
+     * @param start The size of a particle at birth
+     * @param end   The size of a particle at death
+     */
+    void setSize(float start, float end) { _startSize = start; _endSize = end; }
+
+    /**
+     * Returns the color of a particle at birth
+     *
+     * @return the color of a particle at birth
+     */
+    Color4 getStartColor() const { return _startColor; }
+
+    /**
+     * Returns the color of a particle at death
+     *
+     * @return the color of a particle at death
+     */
+    Color4 getEndColor() const { return _endColor; }
+
+    /**
+     * Sets the color of a particle at birth and at death
+     *
+     * The color is interpolated linearly over the life of the particle. It
+     * is tinted by the color of this node when drawn.
+     *
+     * @param start The color of a particle at birth
+     * @param end   The color of a particle at death
+     */
+    void setColors(Color4 start, Color4 end) { _startColor = start; _endColor = end; }
+
+#pragma mark -
+#pragma mark Simulation
+    /**
+     * Returns the maximum number of live particles
+     *
+     * @return the maximum number of live particles
+     */
+    size_t getCapacity() const { return _capacity; }
+
+    /**
+     * Sets the maximum number of live particles
+     *
+     * If the capacity is less than the current number of particles, the
+     * newest particles are discarded.
+     *
+     * @param capacity  The maximum number of live particles
+     */
+    void setCapacity(size_t capacity);
+
+    /**
+     * Returns the current number of live particles
+     *
+     * @return the current number of live particles
+     */
+    size_t getCount() const { return _count; }
+
+    /**
+     * Emits the given number of particles immediately
+     *
+     * Particles beyond the capacity of this node are discarded. This method
+     * is independent of the emission rate, and is ideal for bursts such as
+     * explosions.
+     *
+     * @param count The number of particles to emit
+     */
+    void emit(size_t count);
+
+    /**
+     * Removes all of the live particles
+     *
+     * This does not change the emission rate.
+     */
+    void clear();
+
+    /**
+     * Advances the particle simulation by the given number of seconds.
+     *
+     * This method ages and moves the live particles, removes the particles
+     * that have died, and then emits new particles at the emission rate.
+     *
+     * @param dt    The number of seconds since the last update
+     */
+    void update(float dt);
+
+    /**
+     * Draws this node via the given SpriteBatch.
+     *
+     * This method only worries about drawing the current node. It does not
+     * attempt to render the children.
+     *
+     * The particles are drawn as sprite instances, in a single call. As the
+     * instances do not have a transform, the particles are transformed now.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param transform The global transformation matrix.
+     * @param tint      The tint to blend with the Node color.
+     */
+    virtual void draw(const std::shared_ptr<SpriteBatch>& batch,
+                      const Affine2& transform, Color4 tint) override;
+
+protected:
+    /**
+     * Returns an AABB containing this node and all of its descendants.
+     *
+     * This bounding box includes the live particles, which may lie outside
+     * of the content bounds of this node.
+     *
+     * @return an AABB containing this node and all of its descendants.
+     */
+    virtual Rect computeSubtreeBounds() override;
+
+    /**
+     * Returns a random value between min and max (inclusive)
+     *
+     * @param min   The minimum value
+     * @param max   The maximum value
+     *
+     * @return a random value between min and max (inclusive)
+     */
+    float random(float min, float max);
+
+    /**
+     * Recomputes the extent of the live particles
+     */
+    void computeExtent();
+};
+
+    }
+}
+
+#endif /* __CU_PARTICLE_NODE_H__ */
@@ -134,6 +134,8 @@ protected:
     bool _stencil;
     /** The extruder for this node */
     SimpleExtruder _extruder;
+    /** The fringe outlines (scratch space kept across extrusions) */
+    std::vector<Path2> _outlines;
     /** The fringe mesh */
     Mesh<SpriteVertex2> _border;
     
@@ -689,6 +691,15 @@ private:
      * of the texture.
      */
     virtual void updateTextureCoords() override;
+
+    /**
+     * Appends the settings that determine the render data to the given key
+     *
+     * Nodes with equal keys have identical render data.
+     *
+     * @param key   The key to extend
+     */
+    virtual void appendGeometryKey(std::string& key) const override;
     
     /**
      * Updates the extrusion polygon, based on the current settings.
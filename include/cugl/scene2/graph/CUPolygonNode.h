@@ -45,6 +45,8 @@
 #include <string>
 #include <cugl/scene2/graph/CUTexturedNode.h>
 #include <cugl/math/polygon/CUEarclipTriangulator.h>
+#include <cugl/math/polygon/CUMonotoneTriangulator.h>
+#include <cugl/math/polygon/CUSimpleExtruder.h>
 
 namespace cugl {
     /**
@@ -97,6 +99,10 @@ protected:
     Poly2 _polygon;
     /** The border fringe for the mesh */
     float _fringe;
+    /** The extruder for the fringe (kept so its buffers persist across updates) */
+    SimpleExtruder _extruder;
+    /** The current fringe boundary (scratch space kept across updates) */
+    std::vector<Vec2> _outline;
 
 public:
 #pragma mark -
@@ -609,7 +615,9 @@ public:
     /**
      * Sets the polgon to the vertices expressed in texture space.
      *
-     * The vertices will be triangulated with {@link EarclipTriangulator}.
+     * The vertices will be triangulated with {@link EarclipTriangulator}, or
+     * with {@link MonotoneTriangulator} if there are at least
+     * {@link CU_MONOTONE_THRESHOLD} vertices.
      *
      * @param vertices    The vertices to texture
      */
@@ -683,6 +691,16 @@ private:
      */
     virtual void updateTextureCoords() override;
 
+protected:
+    /**
+     * Appends the settings that determine the render data to the given key
+     *
+     * Nodes with equal keys have identical render data.
+     *
+     * @param key   The key to extend
+     */
+    virtual void appendGeometryKey(std::string& key) const override;
+
     /** This macro disables the copy constructor (not allowed on scene graphs) */
     CU_DISALLOW_COPY_AND_ASSIGN(PolygonNode);
 
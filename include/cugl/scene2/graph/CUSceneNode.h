@@ -55,6 +55,8 @@ namespace cugl {
 /** Forward references for scene loading support */
 class Scene2;
 class Scene2Loader;
+/** Forward reference to a render target */
+class RenderTarget;
 
     /**
      * The classes to construct an 2-d scene graph.
@@ -182,6 +184,18 @@ protected:
     Scene2* _graph;
     /** A layout manager for complex scene graphs */
     std::shared_ptr<Layout> _layout;
+    /** A function to build the children of this node on demand (may be null) */
+    std::function<void(SceneNode* node)> _deferred;
+    /** Whether this node must redo its layout */
+    bool _layoutDirty;
+    /** Whether a descendant of this node must redo its layout */
+    bool _layoutPending;
+    /** Whether this node is in the middle of its layout */
+    bool _inLayout;
+    /** The layout revision (see {@link Layout#getVersion}) of the last layout */
+    Uint64 _layoutVersion;
+    /** The layout bounds of the last layout */
+    Rect _layoutBounds;
 
     /** The (current) child offset of this node (-1 if root) */
     int _childOffset;
@@ -216,6 +230,36 @@ protected:
     /** The rendering priority; used by {@link OrderedNode} */
     float _priority;
 
+    /** The cached bounds of this node and all its descendants in parent space */
+    Rect _bounds;
+    /** Whether the cached bounds must be recomputed */
+    bool _boundsDirty;
+    /** Whether the parent has already culled this node for the next render */
+    bool _preculled;
+
+    /** The cached node-to-world transform */
+    mutable Affine2 _world;
+    /** The cached world-to-node transform */
+    mutable Affine2 _inverse;
+    /** Whether the cached node-to-world transform must be recomputed */
+    mutable bool _worldDirty;
+    /** Whether the cached world-to-node transform must be recomputed */
+    mutable bool _inverseDirty;
+    
+    /** Whether this node is stored in the pick index of its scene */
+    bool _interactive;
+
+    /** Whether this subtree is drawn from a cached texture */
+    bool _cacheTexture;
+    /** Whether the cached texture must be redrawn */
+    bool _cacheDirty;
+    /** The render target holding the cached texture (from the scene pool) */
+    std::shared_ptr<RenderTarget> _cache;
+    /** The region of the render target covered by this subtree */
+    std::shared_ptr<Texture> _cacheRegion;
+    /** The subtree bounds (in node space) of the cached texture */
+    Rect _cacheBounds;
+
     /** The defining JSON data for this node (if any) */
     std::shared_ptr<JsonValue> _json;
     
@@ -592,6 +636,9 @@ public:
     void setName(const std::string name) {
         _name = name;
         _hashOfName = std::hash<std::string>()(_name);
+        if (_parent && _parent->_layout) {
+            _parent->setNeedsLayout();
+        }
     }
 
     /**
@@ -899,6 +946,35 @@ public:
     Rect getBoundingBox() const {
         return getNodeToParentTransform().transform(Rect(Vec2::ZERO, getContentSize()));
     }
+
+    /**
+     * Returns an AABB containing this node and all of its descendants.
+     *
+     * The bounding box is in the parent's coordinates. It is the union of the
+     * bounding box of this node (see {@link #getBoundingBox}) and the subtree
+     * bounds of every child. This value is cached, and is only recomputed
+     * when a transform, content size, or child in this subtree changes.
+     *
+     * These bounds assume that every node draws inside of its content size.
+     * They are used by {@link Scene2#setCulling} to skip off-screen subtrees.
+     *
+     * @return an AABB containing this node and all of its descendants.
+     */
+    const Rect& getSubtreeBounds();
+
+    /**
+     * Returns true if this subtree is entirely outside the scene view.
+     *
+     * This method always returns false if the node is not in a scene, or if
+     * culling is disabled for the scene (see {@link Scene2#setCulling}).
+     * Otherwise, it compares the subtree bounds of this node, transformed by
+     * the given parent-to-world transform, with the view of the scene camera.
+     *
+     * @param transform The transform from parent to world coordinates
+     *
+     * @return true if this subtree is entirely outside the scene view.
+     */
+    bool isCulled(const Affine2& transform);
     
 #pragma mark -
 #pragma mark Anchors
@@ -1009,7 +1085,7 @@ public:
      *
      * @param color the color tinting this node.
      */
-    virtual void setColor(Color4 color) { _tintColor = color; }
+    virtual void setColor(Color4 color) { _tintColor = color; invalidateCache(); }
 
     /**
      * Returns the absolute color tinting this node.
@@ -1042,7 +1118,70 @@ public:
      *
      * @param visible   true if the node is visible.
      */
-    void setVisible(bool visible) { _isVisible = visible; }
+    void setVisible(bool visible) {
+        if (visible && _deferred) {
+            buildDeferredChildren();
+        }
+        _isVisible = visible;
+        if (_parent) { _parent->invalidateCache(); }
+    }
+
+    /**
+     * Returns true if the children of this node have not been built yet.
+     *
+     * A node may be given a function to build its children on demand (see
+     * {@link #setDeferredChildren}). This is typically done by a scene loader
+     * for nodes that are initially hidden.
+     *
+     * @return true if the children of this node have not been built yet.
+     */
+    bool hasDeferredChildren() const { return _deferred != nullptr; }
+
+    /**
+     * Sets a function to build the children of this node on demand.
+     *
+     * The function is called (once) the first time this node is made visible,
+     * or when {@link #buildDeferredChildren} is called, whichever comes first.
+     * It is passed this node, and should add the children to it.
+     *
+     * @param builder   The function to build the children of this node
+     */
+    void setDeferredChildren(const std::function<void(SceneNode* node)>& builder) {
+        _deferred = builder;
+    }
+
+    /**
+     * Builds the children of this node if they have been deferred.
+     *
+     * This method does nothing if the children of this node are not deferred.
+     * Otherwise it builds them immediately, instead of waiting for this node
+     * to be made visible.
+     */
+    void buildDeferredChildren();
+
+    /**
+     * Returns true if this node can be found by {@link Scene2#pick}.
+     *
+     * Interactive nodes are stored in the pick index of their scene, which
+     * makes it fast to find the node under a touch or mouse click. UI widgets
+     * (such as {@link Button}) are interactive while they are active. The
+     * default value is false.
+     *
+     * @return true if this node can be found by {@link Scene2#pick}.
+     */
+    bool isInteractive() const { return _interactive; }
+
+    /**
+     * Sets whether this node can be found by {@link Scene2#pick}.
+     *
+     * Interactive nodes are stored in the pick index of their scene, which
+     * makes it fast to find the node under a touch or mouse click. UI widgets
+     * (such as {@link Button}) are interactive while they are active. The
+     * default value is false.
+     *
+     * @param value Whether this node can be found by {@link Scene2#pick}.
+     */
+    void setInteractive(bool value);
     
     /**
      * Returns true if this node is tinted by its parent.
@@ -1064,7 +1203,10 @@ public:
      *
      * @param flag  Whether this node is tinted by its parent.
      */
-    void setRelativeColor(bool flag) { _hasParentColor = flag; }
+    void setRelativeColor(bool flag) {
+        _hasParentColor = flag;
+        if (_parent) { _parent->invalidateCache(); }
+    }
     
     /**
      * Returns the scissor associated with this node.
@@ -1120,7 +1262,7 @@ public:
      *
      * @param scissor   The scissor associated with this node.
      */
-    void setScissor(const std::shared_ptr<Scissor>& scissor) { _scissor = scissor;}
+    void setScissor(const std::shared_ptr<Scissor>& scissor) { _scissor = scissor; invalidateCache(); }
 
     /**
      * Sets a content-bounded scissor associated with this node.
@@ -1144,7 +1286,7 @@ public:
      * of the same orientation. The rule for this intersection will
      * be the same as {@link Scissor#intersect}.
      */
-    void setScissor() { _scissor = Scissor::alloc(getContentSize());}
+    void setScissor() { _scissor = Scissor::alloc(getContentSize()); invalidateCache(); }
 
     
 #pragma mark -
@@ -1366,9 +1508,12 @@ public:
      * It is the recursive (left-multiplied) node-to-parent transforms of all 
      * of its ancestors.
      *
+     * This matrix is cached, and is only recomputed when the transform of this
+     * node or one of its ancestors changes. So repeated calls are O(1).
+     *
      * @return the matrix transforming node space to world space.
      */
-    Affine2 getNodeToWorldTransform() const;
+    const Affine2& getNodeToWorldTransform() const;
     
     /**
      * Returns the matrix transforming node space to world space.
@@ -1378,11 +1523,31 @@ public:
      * or mouse clicks. It is the recursive (right-multiplied) parent-to-node
      * transforms of all of its ancestors.
      *
+     * Like {@link #getNodeToWorldTransform}, this matrix is cached.
+     *
      * @return the matrix transforming node space to world space.
      */
-    Affine2 getWorldToNodeTransform() const {
-        return getNodeToWorldTransform().getInverse();
+    const Affine2& getWorldToNodeTransform() const {
+        if (_inverseDirty) {
+            Affine2::invert(getNodeToWorldTransform(),&_inverse);
+            _inverseDirty = false;
+        }
+        return _inverse;
     }
+
+    /**
+     * Returns the transform to draw this node with, given its parent transform.
+     *
+     * This is the product of the node-to-parent transform and the given
+     * transform. When the given transform is the node-to-world transform of
+     * the parent (as it is when a {@link Scene2} renders), this method
+     * returns the cached node-to-world transform instead of recomputing it.
+     *
+     * @param transform The parent-to-world transform used for rendering
+     *
+     * @return the transform to draw this node with, given its parent transform.
+     */
+    Affine2 getRenderTransform(const Affine2& transform) const;
     
     /**
      * Converts a screen position to node (local) space coordinates.
@@ -1419,6 +1584,22 @@ public:
         return getWorldToNodeTransform().transform(worldPoint);
     }
 
+    /**
+     * Converts an array of OpenGL positions to node (local) space coordinates.
+     *
+     * Unlike the single point version, this method computes the transform
+     * matrix only once, and converts the points with the vectorized batch
+     * transform of {@link Affine2}. The input and output may be the same
+     * array.
+     *
+     * @param input     The array of OpenGL positions
+     * @param output    The array to store the node (local) space coordinates
+     * @param size      The size of the two arrays
+     */
+    void worldToNodeCoords(const Vec2* input, Vec2* output, size_t size) const {
+        Affine2::transform(getWorldToNodeTransform(),input,output,size);
+    }
+
     /**
      * Converts an node (local) position to screen coordinates.
      *
@@ -1452,6 +1633,22 @@ public:
     Vec2 nodeToWorldCoords(const Vec2 nodePoint) const {
         return getNodeToWorldTransform().transform(nodePoint);
     }
+
+    /**
+     * Converts an array of node (local) positions to OpenGL coordinates.
+     *
+     * Unlike the single point version, this method computes the transform
+     * matrix only once, and converts the points with the vectorized batch
+     * transform of {@link Affine2}. The input and output may be the same
+     * array.
+     *
+     * @param input     The array of local positions
+     * @param output    The array to store the OpenGL coordinates
+     * @param size      The size of the two arrays
+     */
+    void nodeToWorldCoords(const Vec2* input, Vec2* output, size_t size) const {
+        Affine2::transform(getNodeToWorldTransform(),input,output,size);
+    }
     
     /**
      * Converts an parent space position to node (local) space coordinates.
@@ -1890,6 +2087,50 @@ public:
      */
     virtual void draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {}
     
+    /**
+     * Returns true if this subtree is drawn from a cached texture.
+     *
+     * A cached subtree is drawn once to an offscreen texture, and that texture
+     * is drawn as a single quad on every frame after. The texture is only
+     * redrawn when something in the subtree changes (see {@link #invalidateCache}).
+     * This is ideal for large, static subtrees such as backgrounds and HUD
+     * panels. Moving, rotating, or tinting this node does not redraw the
+     * texture. The default value is false.
+     *
+     * @return true if this subtree is drawn from a cached texture.
+     */
+    bool isCachedAsTexture() const { return _cacheTexture; }
+
+    /**
+     * Sets whether this subtree is drawn from a cached texture.
+     *
+     * A cached subtree is drawn once to an offscreen texture, and that texture
+     * is drawn as a single quad on every frame after. The texture is only
+     * redrawn when something in the subtree changes (see {@link #invalidateCache}).
+     * This is ideal for large, static subtrees such as backgrounds and HUD
+     * panels. Moving, rotating, or tinting this node does not redraw the
+     * texture. The default value is false.
+     *
+     * The texture has one pixel per unit of node space, so a cached node that
+     * is scaled up will look blurry. The texture is borrowed from a pool in
+     * the scene, and so the node is only cached while it is in a scene. Nodes
+     * rendered to a {@link Scene2Texture}, or with a parallel recording, are
+     * drawn normally whenever the texture is out of date.
+     *
+     * @param value Whether this subtree is drawn from a cached texture.
+     */
+    void setCacheAsTexture(bool value);
+
+    /**
+     * Marks the cached textures of this node and its ancestors as out of date.
+     *
+     * This method is called automatically when a node is added, removed,
+     * resized, moved, recolored, or changes its drawing data. Custom nodes
+     * should call it whenever their {@link #draw} method would produce a
+     * different result. It does nothing if no ancestor is cached.
+     */
+    void invalidateCache();
+
     
 #pragma mark -
 #pragma mark Layout Automation
@@ -1920,7 +2161,33 @@ public:
      *
      * @param layout	The layout manager for this node
      */
-    void setLayout(const std::shared_ptr<Layout>& layout) { _layout = layout; }
+    void setLayout(const std::shared_ptr<Layout>& layout) {
+        _layout = layout;
+        setNeedsLayout();
+    }
+
+    /**
+     * Marks this node as needing to redo its layout.
+     *
+     * The layout is not performed immediately. It happens the next time
+     * {@link doLayout()} is called on this node or any of its ancestors.
+     * Changes to the size, name, or children of a node mark the appropriate
+     * nodes automatically. So do changes to the layout information of a
+     * layout manager. This method is only needed when some other state read
+     * by a layout manager has changed.
+     */
+    void setNeedsLayout();
+
+    /**
+     * Returns true if this node or one of its descendants needs layout.
+     *
+     * A node needs layout if it has been marked by {@link setNeedsLayout},
+     * if its layout information has changed, or if its layout bounds have
+     * changed since the last layout.
+     *
+     * @return true if this node or one of its descendants needs layout.
+     */
+    bool needsLayout() const;
     
     /**
      * Arranges the child of this node using the layout manager.
@@ -1928,12 +2195,72 @@ public:
      * This process occurs recursively and top-down. A layout manager may end
      * up resizing the children.  That is why the parent must finish its layout
      * before we can apply a layout manager to the children.
+     *
+     * The layout of this node is always performed. However, the layout is
+     * incremental below this node. A descendant is only visited if it (or one
+     * of its own descendants) needs layout, as determined by {@link needsLayout}.
+     * So repeated calls to this method on an unchanged scene graph are cheap.
      */
     virtual void doLayout();
 
+protected:
+#pragma mark -
+#pragma mark Subtree Bounds
+    /**
+     * Returns an AABB containing this node and all of its descendants.
+     *
+     * Unlike {@link #getSubtreeBounds}, this bounding box is in the coordinate
+     * space of this node, and it is never cached. Subclasses that transform
+     * their children (such as {@link ScrollPane}) should override this method.
+     *
+     * @return an AABB containing this node and all of its descendants.
+     */
+    virtual Rect computeSubtreeBounds();
+
+    /**
+     * Marks the subtree bounds of this node and its ancestors as invalid.
+     *
+     * Subclasses should call this method whenever they change how their
+     * children are positioned.
+     */
+    void invalidateBounds();
+
 private:
 #pragma mark -
 #pragma mark Internal Helpers
+    /**
+     * Draws the cached texture of this subtree, returning true on success.
+     *
+     * If the texture is out of date, this method redraws it first. This
+     * method returns false if the texture is out of date and cannot be
+     * redrawn with this sprite batch. In that case the subtree should be
+     * drawn normally.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param transform The node-to-world transform of this node.
+     * @param tint      The tint inherited from the parent.
+     *
+     * @return true if the cached texture was drawn
+     */
+    bool drawCache(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint);
+
+    /**
+     * Redraws the cached texture of this subtree, returning true on success.
+     *
+     * The sprite batch is ended and restarted with the same perspective,
+     * with all other drawing state restored.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     *
+     * @return true if the cached texture was redrawn
+     */
+    bool bakeCache(const std::shared_ptr<SpriteBatch>& batch);
+
+    /**
+     * Returns the cached texture (if any) to the pool of the scene.
+     */
+    void releaseCache();
+
     /**
      * Sets the parent node.
      *
@@ -1971,6 +2298,14 @@ private:
      * transform, and positional translation, in that order.
      */
     void updateTransform();
+
+    /**
+     * Marks the cached world transforms of this node and its descendants invalid.
+     *
+     * This method must be called whenever the node-to-parent transform of this
+     * node changes, or when this node changes parents.
+     */
+    void invalidateWorld();
     
     // Copying is only allowed via shared pointer.
     CU_DISALLOW_COPY_AND_ASSIGN(SceneNode);
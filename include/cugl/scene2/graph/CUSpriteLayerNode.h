@@ -0,0 +1,453 @@
+//
+//  CUSpriteLayerNode.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a scene graph node for a large number of simple
+//  sprites, such as tiles or bullets. A scene graph node is too heavy for
+//  this purpose, as it has a name, a child list, layout data and more. This
+//  node instead stores each sprite as a small record in a contiguous array.
+//  The sprites are referenced by handle, culled as a batch, and drawn to the
+//  SpriteBatch as sprite instances in a single call.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_SPRITE_LAYER_NODE_H__
+#define __CU_SPRITE_LAYER_NODE_H__
+#include <cugl/scene2/graph/CUSceneNode.h>
+#include <cugl/render/CUSpriteVertex.h>
+#include <cugl/render/CUTexture.h>
+#include <vector>
+
+/** The handle of a sprite that does not exist */
+#define SPRITE_LAYER_NONE   0xFFFFFFFF
+
+namespace cugl {
+
+    /**
+     * The classes to construct a 2-d scene graph.
+     *
+     * Even though this is an optional package, we promote these classes to
+     * the main namespace for convenience.
+     */
+    namespace scene2 {
+
+/**
+ * This is a scene graph node for a large number of simple sprites.
+ *
+ * Each sprite is a (possibly rotated) rectangle with a color and a region
+ * of the texture of this node. Sprites are not scene graph nodes. They are
+ * stored as records in a single contiguous array, and are referenced by the
+ * handle returned from {@link #addSprite}. A handle stays valid until its
+ * sprite is removed, after which it may be reused by a new sprite. Sprites
+ * are drawn in the order they were added, except that removing a sprite
+ * moves the last sprite into its place.
+ *
+ * Sprites are in the coordinate space of this node, and their positions are
+ * their centers. When the scene has culling enabled (see {@link Scene2#setCulling}),
+ * the sprites are culled against the camera as a batch. The visible sprites
+ * are drawn with {@link SpriteBatch#drawInstances}, so the entire layer is
+ * drawn in a single call. Sprite instances ignore the scissor of the sprite
+ * batch, and so a sprite layer should not be placed inside of a scissored
+ * node. Sprites do not use the gradient or shader effects of the sprite
+ * batch.
+ */
+class SpriteLayerNode : public SceneNode {
+public:
+    /** A single sprite in the layer */
+    struct Sprite {
+        /** The center of the sprite in node space */
+        Vec2 position;
+        /** The width and height of the sprite */
+        Vec2 size;
+        /** The angle of the sprite in radians (counter clockwise) */
+        float angle;
+        /** The color of the sprite */
+        Color4 color;
+        /** The minimum texture coordinates of the sprite (minS,minT) */
+        Vec2 texmin;
+        /** The maximum texture coordinates of the sprite (maxS,maxT) */
+        Vec2 texmax;
+    };
+
+protected:
+    /** The texture of the sprites (nullptr for solid rectangles) */
+    std::shared_ptr<Texture> _texture;
+    /** The blending equation for this texture */
+    GLenum _blendEquation;
+    /** The source factor for the blend function */
+    GLenum _srcFactor;
+    /** The destination factor for the blend function */
+    GLenum _dstFactor;
+
+    /** The sprites of this layer (in drawing order) */
+    std::vector<Sprite> _sprites;
+    /** The handle of each sprite in the sprite array */
+    std::vector<Uint32> _owners;
+    /** The position of each handle in the sprite array (SPRITE_LAYER_NONE if free) */
+    std::vector<Uint32> _slots;
+    /** The handles available for reuse */
+    std::vector<Uint32> _freed;
+    /** The sprite instances built when drawing */
+    std::vector<SpriteInstance> _instances;
+    /** The bounding box of the sprites in node space */
+    Rect _extent;
+    /** Whether the extent must be recomputed */
+    bool _extentDirty;
+
+public:
+#pragma mark -
+#pragma mark Constructors
+    /**
+     * Creates an empty sprite layer node.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    SpriteLayerNode();
+
+    /**
+     * Deletes this node, disposing all resources
+     */
+    ~SpriteLayerNode() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this node.
+     *
+     * A disposed node can be safely reinitialized. Any children owned by this
+     * node will be released. They will be deleted if no other object owns them.
+     *
+     * It is unsafe to call this on a node that is still currently inside of
+     * a scene graph.
+     */
+    virtual void dispose() override;
+
+    /**
+     * Initializes a sprite layer with untextured sprites.
+     *
+     * Each sprite is a solid rectangle.
+     *
+     * @return true if initialization was successful.
+     */
+    virtual bool init() override {
+        return initWithTexture(nullptr);
+    }
+
+    /**
+     * Initializes a sprite layer with the given texture.
+     *
+     * The texture is typically an atlas, and each sprite draws a region of
+     * it. If the texture is nullptr, each sprite is a solid rectangle.
+     *
+     * @param texture   The texture of the sprites
+     *
+     * @return true if initialization was successful.
+     */
+    bool initWithTexture(const std::shared_ptr<Texture>& texture);
+
+    /**
+     * Returns a newly allocated sprite layer with untextured sprites.
+     *
+     * Each sprite is a solid rectangle.
+     *
+     * @return a newly allocated sprite layer with untextured sprites.
+     */
+    static std::shared_ptr<SpriteLayerNode> alloc() {
+        std::shared_ptr<SpriteLayerNode> result = std::make_shared<SpriteLayerNode>();
+        return (result->init() ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated sprite layer with the given texture.
+     *
+     * The texture is typically an atlas, and each sprite draws a region of
+     * it. If the texture is nullptr, each sprite is a solid rectangle.
+     *
+     * @param texture   The texture of the sprites
+     *
+     * @return a newly allocated sprite layer with the given texture.
+     */
+    static std::shared_ptr<SpriteLayerNode> allocWithTexture(const std::shared_ptr<Texture>& texture) {
+        std::shared_ptr<SpriteLayerNode> result = std::make_shared<SpriteLayerNode>();
+        return (result->initWithTexture(texture) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Rendering Attributes
+    /**
+     * Returns the texture of the sprites
+     *
+     * If this value is nullptr, each sprite is a solid rectangle.
+     *
+     * @return the texture of the sprites
+     */
+    const std::shared_ptr<Texture>& getTexture() const { return _texture; }
+
+    /**
+     * Sets the texture of the sprites
+     *
+     * If this value is nullptr, each sprite is a solid rectangle. Changing
+     * the texture resets the region of every sprite to the entire texture.
+     *
+     * @param texture   The texture of the sprites
+     */
+    void setTexture(const std::shared_ptr<Texture>& texture);
+
+    /**
+     * Sets the blending function for the sprites
+     *
+     * The enums are the standard ones supported by OpenGL. See
+     *
+     *      https://www.opengl.org/sdk/docs/man/html/glBlendFunc.xhtml
+     *
+     * By default, srcFactor is GL_SRC_ALPHA while dstFactor is
+     * GL_ONE_MINUS_SRC_ALPHA.
+     *
+     * @param srcFactor Specifies how the source blending factors are computed
+     * @param dstFactor Specifies how the destination blending factors are computed.
+     */
+    void setBlendFunc(GLenum srcFactor, GLenum dstFactor) { _srcFactor = srcFactor; _dstFactor = dstFactor; }
+
+    /**
+     * Returns the source blending factor
+     *
+     * @return the source blending factor
+     */
+    GLenum getSourceBlendFactor() const { return _srcFactor; }
+
+    /**
+     * Returns the destination blending factor
+     *
+     * @return the destination blending factor
+     */
+    GLenum getDestinationBlendFactor() const { return _dstFactor; }
+
+    /**
+     * Sets the blending equation for the sprites
+     *
+     * The enum must be a standard ones supported by OpenGL. See
+     *
+     *      https://www.opengl.org/sdk/docs/man/html/glBlendEquation.xhtml
+     *
+     * By default this value is GL_FUNC_ADD.
+     *
+     * @param equation  Specifies how source and destination colors are combined
+     */
+    void setBlendEquation(GLenum equation) { _blendEquation = equation; }
+
+    /**
+     * Returns the blending equation for the sprites
+     *
+     * @return the blending equation for the sprites
+     */
+    GLenum getBlendEquation() const { return _blendEquation; }
+
+#pragma mark -
+#pragma mark Sprites
+    /**
+     * Returns the number of sprites in this layer
+     *
+     * @return the number of sprites in this layer
+     */
+    size_t getCount() const { return _sprites.size(); }
+
+    /**
+     * Reserves space for the given number of sprites
+     *
+     * This method allows the sprite arrays to be allocated once, up front.
+     *
+     * @param capacity  The number of sprites to reserve space for
+     */
+    void reserve(size_t capacity);
+
+    /**
+     * Returns the handle of a newly added sprite
+     *
+     * The sprite is white, has no rotation, and draws the entire texture.
+     * The position is the center of the sprite in node space.
+     *
+     * @param position  The center of the sprite
+     * @param size      The width and height of the sprite
+     *
+     * @return the handle of a newly added sprite
+     */
+    Uint32 addSprite(const Vec2 position, const Size size);
+
+    /**
+     * Returns the handle of a newly added sprite
+     *
+     * The sprite is white, has no rotation, and draws the given region of
+     * the texture. The region is in pixels, with the origin at the bottom
+     * left corner of the texture. The position is the center of the sprite
+     * in node space.
+     *
+     * @param position  The center of the sprite
+     * @param size      The width and height of the sprite
+     * @param region    The region of the texture in pixels
+     *
+     * @return the handle of a newly added sprite
+     */
+    Uint32 addSprite(const Vec2 position, const Size size, const Rect region);
+
+    /**
+     * Removes the sprite with the given handle
+     *
+     * The last sprite of this layer takes the place of the removed one in
+     * the drawing order. The handle may be reused by a later sprite.
+     *
+     * @param handle    The sprite handle
+     */
+    void removeSprite(Uint32 handle);
+
+    /**
+     * Removes all of the sprites in this layer
+     *
+     * This invalidates every handle.
+     */
+    void clearSprites();
+
+    /**
+     * Returns true if the handle refers to a sprite in this layer
+     *
+     * @param handle    The sprite handle
+     *
+     * @return true if the handle refers to a sprite in this layer
+     */
+    bool isValid(Uint32 handle) const {
+        return handle < _slots.size() && _slots[handle] != SPRITE_LAYER_NONE;
+    }
+
+    /**
+     * Returns the sprite with the given handle
+     *
+     * The handle must be valid.
+     *
+     * @param handle    The sprite handle
+     *
+     * @return the sprite with the given handle
+     */
+    const Sprite& getSprite(Uint32 handle) const;
+
+    /**
+     * Sets the center of the sprite with the given handle
+     *
+     * @param handle    The sprite handle
+     * @param position  The center of the sprite in node space
+     */
+    void setSpritePosition(Uint32 handle, const Vec2 position);
+
+    /**
+     * Sets the size of the sprite with the given handle
+     *
+     * @param handle    The sprite handle
+     * @param size      The width and height of the sprite
+     */
+    void setSpriteSize(Uint32 handle, const Size size);
+
+    /**
+     * Sets the angle of the sprite with the given handle
+     *
+     * @param handle    The sprite handle
+     * @param angle     The angle of the sprite in radians (counter clockwise)
+     */
+    void setSpriteAngle(Uint32 handle, float angle);
+
+    /**
+     * Sets the color of the sprite with the given handle
+     *
+     * The color is tinted by the color of this node when drawn.
+     *
+     * @param handle    The sprite handle
+     * @param color     The color of the sprite
+     */
+    void setSpriteColor(Uint32 handle, Color4 color);
+
+    /**
+     * Sets the texture region of the sprite with the given handle
+     *
+     * The region is in pixels, with the origin at the bottom left corner of
+     * the texture. This method has no effect if there is no texture.
+     *
+     * @param handle    The sprite handle
+     * @param region    The region of the texture in pixels
+     */
+    void setSpriteRegion(Uint32 handle, const Rect region);
+
+#pragma mark -
+#pragma mark Rendering
+    /**
+     * Draws this node via the given SpriteBatch.
+     *
+     * This method only worries about drawing the current node. It does not
+     * attempt to render the children.
+     *
+     * The sprites are culled as a batch, and the visible ones are drawn as
+     * sprite instances in a single call. As the instances do not have a
+     * transform, the sprites are transformed now.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param transform The global transformation matrix.
+     * @param tint      The tint to blend with the Node color.
+     */
+    virtual void draw(const std::shared_ptr<SpriteBatch>& batch,
+                      const Affine2& transform, Color4 tint) override;
+
+protected:
+    /**
+     * Returns an AABB containing this node and all of its descendants.
+     *
+     * This bounding box includes the sprites, which may lie outside of the
+     * content bounds of this node.
+     *
+     * @return an AABB containing this node and all of its descendants.
+     */
+    virtual Rect computeSubtreeBounds() override;
+
+    /**
+     * Marks the extent of the sprites as changed
+     */
+    void invalidateExtent();
+
+    /**
+     * Stores the texture coordinates of the given region in the sprite
+     *
+     * @param sprite    The sprite to modify
+     * @param region    The region of the texture in pixels
+     */
+    void applyRegion(Sprite& sprite, const Rect region) const;
+};
+
+    }
+}
+
+#endif /* __CU_SPRITE_LAYER_NODE_H__ */
@@ -326,6 +326,15 @@ private:
      * of the texture.
      */
     virtual void updateTextureCoords() override;
+
+    /**
+     * Appends the settings that determine the render data to the given key
+     *
+     * Nodes with equal keys have identical render data.
+     *
+     * @param key   The key to extend
+     */
+    virtual void appendGeometryKey(std::string& key) const override;
     
     /** This macro disables the copy constructor (not allowed on scene graphs) */
     CU_DISALLOW_COPY_AND_ASSIGN(SpriteNode);
@@ -92,8 +92,35 @@ namespace cugl {
  * absolute positions in Node space.  This will also disable anchor functions
  * (setting the anchor as the bottom left corner), since anchors do not make
  * sense when we are drawing vertices directly into the coordinate space.
+ *
+ * By default, the render data of a textured node is shared. When a subclass
+ * generates its mesh, it first looks for a mesh built from identical settings
+ * (geometry, texture, offset, size, and flips) by another node. If there is
+ * one, the node draws that mesh instead of building its own. So a scene with
+ * many copies of the same decoration only builds and stores one mesh. Shared
+ * meshes are never modified, and any change to a node simply releases its
+ * shared mesh. Use {@link #setGeometryShared} to disable this feature.
  */
 class TexturedNode : public SceneNode {
+public:
+    /**
+     * The render data shared by textured nodes with identical settings
+     *
+     * A shared mesh is immutable. The extra attributes are only used by the
+     * subclasses that need them.
+     */
+    class Geometry {
+    public:
+        /** The primary mesh */
+        Mesh<SpriteVertex2> mesh;
+        /** The secondary (border) mesh */
+        Mesh<SpriteVertex2> border;
+        /** The shape used to generate the mesh */
+        Poly2 shape;
+        /** The bounds of the generated shape */
+        Rect bounds;
+    };
+
 #pragma mark Values
 protected:
     /** Texture associated with this node */
@@ -110,6 +137,10 @@ protected:
     bool _rendered;
     /** The render data for this node */
     Mesh<SpriteVertex2> _mesh;
+    /** The shared render data for this node (replaces _mesh if not null) */
+    std::shared_ptr<const Geometry> _geometry;
+    /** Whether to share render data with other nodes */
+    bool _shared;
     
     /** The blending equation for this texture */
     GLenum _blendEquation;
@@ -398,6 +429,45 @@ public:
      * @return the blending equation for this sprite batch
      */
     GLenum getBlendEquation() const { return _blendEquation; }
+
+    /**
+     * Sets whether this node shares its render data with other nodes
+     *
+     * If true, this node will draw the mesh of any other node with identical
+     * settings (geometry, texture, offset, size, and flips), instead of
+     * building its own. This saves both the time to generate the mesh and
+     * the memory to store it. Nodes that are unique, or that change every
+     * frame, gain nothing from sharing, and may disable it.
+     *
+     * By default this value is true.
+     *
+     * @param flag  Whether this node shares its render data with other nodes
+     */
+    void setGeometryShared(bool flag) { _shared = flag; clearRenderData(); }
+
+    /**
+     * Returns true if this node shares its render data with other nodes
+     *
+     * If true, this node will draw the mesh of any other node with identical
+     * settings (geometry, texture, offset, size, and flips), instead of
+     * building its own. This saves both the time to generate the mesh and
+     * the memory to store it. Nodes that are unique, or that change every
+     * frame, gain nothing from sharing, and may disable it.
+     *
+     * By default this value is true.
+     *
+     * @return true if this node shares its render data with other nodes
+     */
+    bool isGeometryShared() const { return _shared; }
+
+    /**
+     * Returns the number of distinct meshes shared by textured nodes
+     *
+     * This only counts meshes that are still in use by some node.
+     *
+     * @return the number of distinct meshes shared by textured nodes
+     */
+    static size_t getGeometryCacheSize();
     
     /**
      * Flips the texture coordinates horizontally if flag is true.
@@ -624,6 +694,87 @@ protected:
      */
     void clearRenderData();
 
+    /**
+     * Returns the mesh to draw for this node
+     *
+     * This is the shared mesh if there is one, and the node mesh otherwise.
+     *
+     * @return the mesh to draw for this node
+     */
+    const Mesh<SpriteVertex2>& getRenderMesh() const {
+        return _geometry != nullptr ? _geometry->mesh : _mesh;
+    }
+
+    /**
+     * Appends the settings that determine the render data to the given key
+     *
+     * Nodes with equal keys have identical render data. This method appends
+     * the texture attributes. Subclasses should call this method and then
+     * append a tag for the class, followed by their geometry settings.
+     *
+     * @param key   The key to extend
+     */
+    virtual void appendGeometryKey(std::string& key) const;
+
+    /**
+     * Appends the bytes of the given value to the key
+     *
+     * @param key   The key to extend
+     * @param value The value to append
+     */
+    template <typename T>
+    static void appendKey(std::string& key, const T& value) {
+        key.append(reinterpret_cast<const char*>(&value),sizeof(T));
+    }
+
+    /**
+     * Appends the given array, prefixed by its length, to the key
+     *
+     * @param key   The key to extend
+     * @param data  The array to append
+     */
+    template <typename T>
+    static void appendKey(std::string& key, const std::vector<T>& data) {
+        appendKey(key,(Uint64)data.size());
+        key.append(reinterpret_cast<const char*>(data.data()),data.size()*sizeof(T));
+    }
+
+    /**
+     * Returns true if this node found shared render data for the given key
+     *
+     * If successful, this node will draw the shared mesh. This method always
+     * fails if sharing is disabled.
+     *
+     * @param key   The render data key (see {@link #appendGeometryKey})
+     *
+     * @return true if this node found shared render data for the given key
+     */
+    bool acquireGeometry(const std::string& key);
+
+    /**
+     * Shares the render data of this node under the given key
+     *
+     * The node mesh is moved into the given geometry, which becomes read-only.
+     * Subclasses should set any extra attributes of the geometry beforehand.
+     * This method does nothing if sharing is disabled.
+     *
+     * @param key       The render data key (see {@link #appendGeometryKey})
+     * @param geometry  The geometry to share
+     */
+    void shareGeometry(const std::string& key, const std::shared_ptr<Geometry>& geometry);
+
+    /**
+     * Shares the render data of this node under the given key
+     *
+     * The node mesh is moved into a new shared geometry, which is read-only.
+     * This method does nothing if sharing is disabled.
+     *
+     * @param key       The render data key (see {@link #appendGeometryKey})
+     */
+    void shareGeometry(const std::string& key) {
+        shareGeometry(key,std::make_shared<Geometry>());
+    }
+
     /** This macro disables the copy constructor (not allowed on scene graphs) */
     CU_DISALLOW_COPY_AND_ASSIGN(TexturedNode);
 
@@ -743,6 +743,15 @@ private:
      * of the texture.
      */
     virtual void updateTextureCoords() override;
+
+    /**
+     * Appends the settings that determine the render data to the given key
+     *
+     * Nodes with equal keys have identical render data.
+     *
+     * @param key   The key to extend
+     */
+    virtual void appendGeometryKey(std::string& key) const override;
     
 #pragma mark -
 #pragma mark Traversal Methods
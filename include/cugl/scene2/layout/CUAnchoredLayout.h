@@ -130,7 +130,7 @@ public:
      *
      * A disposed layout manager can be safely reinitialized.
      */
-    virtual void dispose() override { _entries.clear(); }
+    virtual void dispose() override { _entries.clear(); touch(); }
 
     /**
      * Returns a newly allocated layout manager.
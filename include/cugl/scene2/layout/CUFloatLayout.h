@@ -353,7 +353,7 @@ public:
      *
      * @param value Whether the layout orientation is horizontal.
      */
-    void setHorizontal(bool value) { _horizontal = value; }
+    void setHorizontal(bool value) { _horizontal = value; touch(); }
     
     /**
      * Returns the alignment of this layout.
@@ -371,7 +371,7 @@ public:
      *
      * @param value The alignment of this layout.
      */
-    void setAlignment(Alignment value) { _alignment = value; }
+    void setAlignment(Alignment value) { _alignment = value; touch(); }
 
     /**
      * Assigns layout information for a given key.
@@ -67,6 +67,18 @@ namespace  cugl {
  * in order to consolidate code.
  */
 class Layout {
+protected:
+    /** The revision of the layout information (increased on any change) */
+    Uint64 _version;
+
+    /**
+     * Records a change to the layout information.
+     *
+     * This method must be called whenever the layout information changes,
+     * so that the nodes using this layout know to redo their layout.
+     */
+    void touch() { _version++; }
+
 #pragma mark -
 #pragma mark Constructors
 public:
@@ -121,7 +133,7 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
      * the heap, use one of the static constructors instead.
      */
-    Layout() {}
+    Layout() : _version(1) {}
     
     /**
      * Deletes this layout manager, disposing of all resources.
@@ -160,6 +172,17 @@ public:
     virtual bool initWithData(const std::shared_ptr<JsonValue>& data) { return false; }
 
 #pragma mark Layout
+    /**
+     * Returns the revision of the layout information.
+     *
+     * This value increases every time the layout information is changed. A
+     * node uses it to know whether its layout is up to date, without having
+     * to redo the layout every pass.
+     *
+     * @return the revision of the layout information.
+     */
+    Uint64 getVersion() const { return _version; }
+
     /**
      * Assigns layout information for a given key.
      *
@@ -625,11 +625,47 @@ public:
      * Changing this value will regenerate the render data, and is potentially
      * expensive, particularly if the font is using a fallback atlas.
      *
+     * Setting the text that the label already has (without resizing) does
+     * nothing. Otherwise the glyph meshes are rebuilt in place, so text that
+     * changes every frame (e.g. a score or a timer) does not allocate new
+     * glyph runs.
+     *
      * @param text      The text for this label.
      * @param resize    Whether to resize the label to fit the new text.
      */
     virtual void setText(const std::string text, bool resize=false);
     
+    /**
+     * Sets the text for this label to the given integer.
+     *
+     * This is a convenience method for counters, such as a score. The number
+     * is formatted into a stack buffer (independent of the locale) and is
+     * compared to the current text before any string is allocated. Hence
+     * setting the same number every frame costs almost nothing.
+     *
+     * @param value     The number to display
+     * @param resize    Whether to resize the label to fit the new text.
+     */
+    void setNumber(Sint64 value, bool resize=false);
+
+    /**
+     * Sets the text for this label to the given decimal number.
+     *
+     * This is a convenience method for counters, such as a timer. The number
+     * is formatted into a stack buffer (independent of the locale) and is
+     * compared to the current text before any string is allocated. Hence
+     * setting the same number every frame costs almost nothing.
+     *
+     * The precision is the number of digits after the decimal point. If it
+     * is negative, the number is displayed with the fewest digits that
+     * represent it exactly.
+     *
+     * @param value     The number to display
+     * @param precision The number of digits after the decimal point
+     * @param resize    Whether to resize the label to fit the new text.
+     */
+    void setNumber(double value, int precision, bool resize=false);
+    
     /**
      * Returns the font to use for this label
      *
@@ -1359,6 +1395,9 @@ protected:
     
     /**
      * Clears the render data, releasing all vertices and indices.
+     *
+     * The glyph runs are kept (though empty), so that the next call to
+     * {@link #generateRenderData} can reuse their storage.
      */
     void clearRenderData();
     
@@ -0,0 +1,263 @@
+//
+//  CULabelBatch.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module merges the text of many labels into a few draw calls. Each
+//  label normally draws its own glyph runs, and a HUD full of small labels
+//  becomes a long series of small sprite batch submissions, many of which
+//  break the batch to change the blur or distance field settings. When a
+//  scene enables label batching, every label it draws adds its transformed
+//  glyphs to this object instead. The glyphs are then drawn at the end of the
+//  scene, with one mesh for each atlas page and sort key.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_LABEL_BATCH_H__
+#define __CU_LABEL_BATCH_H__
+#include <cugl/render/CUSpriteBatch.h>
+#include <cugl/render/CUScissor.h>
+#include <cugl/render/CUMesh.h>
+#include <cugl/render/CUSpriteVertex.h>
+#include <vector>
+#include <memory>
+
+namespace cugl {
+
+/** Forward reference to a texture */
+class Texture;
+
+    /**
+     * The classes to construct an 2-d scene graph.
+     *
+     * This namespace was chosen to future-proof the game engine. We will
+     * eventually want to add 3-d scene graphs as well, and this namespace
+     * will prevent any collisions with those scene graph nodes.
+     */
+    namespace scene2 {
+
+/**
+ * This class merges the glyphs of many labels into a few meshes.
+ *
+ * A label batch is owned by a {@link Scene2} (see {@link Scene2#setLabelBatching}).
+ * It is active between {@link #begin} and {@link #end}, which the scene calls
+ * around the traversal of its children. While it is active, a {@link Label}
+ * drawn to the same sprite batch does not draw its glyphs. Instead it adds
+ * them with {@link #add}, already transformed and tinted. The method
+ * {@link #end} then draws every glyph, with one mesh for each group.
+ *
+ * A group is the glyphs that share a sort key, an atlas page, and the sprite
+ * batch settings that affect text (the scissor, the blend mode, the blur and
+ * the distance field setting). Groups are drawn in order of their sort key,
+ * which is the {@link SceneNode#getPriority} of the label. Within a sort key,
+ * drop shadows are drawn before the glyphs, and groups are otherwise drawn in
+ * the order they were created. So labels that overlap should have different
+ * sort keys if their order matters.
+ *
+ * Because the text is drawn at the end of the scene, merged text is always on
+ * top of the nodes that are not labels. This is the intended use (text in a
+ * HUD or menu). Label backgrounds are not merged, and are drawn in the normal
+ * order of the scene graph.
+ *
+ * A label batch is not thread-safe. Labels drawn to any other sprite batch
+ * (such as a recording batch or a cached subtree) are drawn normally.
+ */
+class LabelBatch {
+private:
+    /**
+     * The glyphs that share a sort key, an atlas page and text settings
+     */
+    class Group {
+    public:
+        /** The sort key of this group */
+        float priority;
+        /** Whether this group holds drop shadows */
+        bool shadow;
+        /** The order in which this group was created */
+        size_t order;
+        /** The atlas page */
+        std::shared_ptr<Texture> texture;
+        /** The active scissor (or nullptr for none) */
+        std::shared_ptr<Scissor> scissor;
+        /** The blend equation */
+        GLenum equation;
+        /** The source blend function for color */
+        GLenum srcRGB;
+        /** The source blend function for alpha */
+        GLenum srcAlpha;
+        /** The destination blend function for color */
+        GLenum dstRGB;
+        /** The destination blend function for alpha */
+        GLenum dstAlpha;
+        /** The blur radius (for drop shadows) */
+        GLfloat blur;
+        /** Whether the page is a distance field */
+        bool field;
+        /** The merged glyphs */
+        Mesh<SpriteVertex2> mesh;
+    };
+
+    /** The sprite batch to merge labels for (or nullptr if inactive) */
+    SpriteBatch* _batch;
+    /** The groups of the current frame */
+    std::vector<Group> _groups;
+    /** The number of groups in use this frame (others are kept for reuse) */
+    size_t _active;
+    /** The group of the last call to add */
+    size_t _last;
+    /** The number of labels added this frame */
+    size_t _labels;
+    /** The number of labels added last frame */
+    size_t _lastLabels;
+    /** The number of groups drawn last frame */
+    size_t _lastGroups;
+
+    /**
+     * Returns the group for the given glyphs, creating it if necessary
+     *
+     * The scissor and blend mode of the group are read from the active
+     * sprite batch.
+     *
+     * @param texture   The atlas page
+     * @param priority  The sort key
+     * @param field     Whether the page is a distance field
+     * @param shadow    Whether the glyphs are a drop shadow
+     * @param blur      The blur radius of the drop shadow
+     *
+     * @return the group for the given glyphs
+     */
+    Group& acquire(const std::shared_ptr<Texture>& texture, float priority,
+                   bool field, bool shadow, GLfloat blur);
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an inactive label batch.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    LabelBatch();
+
+    /**
+     * Deletes this label batch, disposing all resources
+     */
+    ~LabelBatch() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this label batch.
+     *
+     * Any glyphs that have not been drawn are discarded.
+     */
+    void dispose();
+
+    /**
+     * Returns a newly allocated label batch.
+     *
+     * @return a newly allocated label batch.
+     */
+    static std::shared_ptr<LabelBatch> alloc() {
+        return std::make_shared<LabelBatch>();
+    }
+
+#pragma mark Batching
+    /**
+     * Starts merging the labels drawn to the given sprite batch.
+     *
+     * The sprite batch should be active.
+     *
+     * @param batch     The sprite batch to merge labels for
+     */
+    void begin(const std::shared_ptr<SpriteBatch>& batch);
+
+    /**
+     * Draws every merged glyph and stops merging.
+     *
+     * The sprite batch must still be active. Its color, texture, scissor, blend
+     * mode, blur and distance field settings are restored afterwards.
+     */
+    void end();
+
+    /**
+     * Returns true if labels drawn to the given sprite batch should be merged.
+     *
+     * @param batch     The sprite batch the label is drawn to
+     *
+     * @return true if labels drawn to the given sprite batch should be merged.
+     */
+    bool isMerging(const std::shared_ptr<SpriteBatch>& batch) const {
+        return _batch != nullptr && _batch == batch.get();
+    }
+
+    /**
+     * Adds the glyphs of a label to this batch.
+     *
+     * The mesh vertices are transformed, and their colors are multiplied by
+     * the given color. The scissor and blend mode are read from the sprite
+     * batch, so they should be set as if the mesh were drawn directly. The
+     * distance field and blur are not, as changing them would break the
+     * sprite batch for every label. Drop shadows are drawn beneath all of the
+     * glyphs with the same sort key.
+     *
+     * @param mesh      The glyph mesh
+     * @param texture   The atlas page of the glyphs
+     * @param transform The glyph transform
+     * @param color     The color to tint the glyphs
+     * @param priority  The sort key of the label
+     * @param field     Whether the page is a distance field
+     * @param shadow    Whether the glyphs are a drop shadow
+     * @param blur      The blur radius of the drop shadow
+     */
+    void add(const Mesh<SpriteVertex2>& mesh, const std::shared_ptr<Texture>& texture,
+             const Affine2& transform, Color4 color, float priority,
+             bool field, bool shadow=false, GLfloat blur=0);
+
+    /**
+     * Notes that a label has been added to this batch.
+     *
+     * This is only used for statistics.
+     */
+    void count() { _labels++; }
+
+#pragma mark Statistics
+    /**
+     * Returns the number of labels merged in the last frame.
+     *
+     * @return the number of labels merged in the last frame.
+     */
+    size_t getLabelCount() const { return _lastLabels; }
+
+    /**
+     * Returns the number of groups drawn in the last frame.
+     *
+     * Each group is a single mesh, so this is the number of meshes that
+     * replaced the glyph runs of {@link #getLabelCount} labels.
+     *
+     * @return the number of groups drawn in the last frame.
+     */
+    size_t getGroupCount() const { return _lastGroups; }
+};
+
+    }
+}
+
+#endif /* __CU_LABEL_BATCH_H__ */
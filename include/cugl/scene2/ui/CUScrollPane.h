@@ -53,6 +53,8 @@
 #ifndef __CU_SCROLL_PANE_H__
 #define __CU_SCROLL_PANE_H__
 #include <cugl/scene2/graph/CUSceneNode.h>
+#include <functional>
+#include <vector>
 
 namespace cugl {
     /**
@@ -125,8 +127,48 @@ namespace cugl {
  * block the rotation. If this is a problem you should either ignore spin
  * input in your application or set {@link #setConstrained} to false. However,
  * the latter will mean that the user can navigate outside of the backing area.
+ *
+ * A scroll pane can also act as a virtual list (see {@link #setVirtualList}).
+ * A virtual list shows a very long vertical list of rows without a scene graph
+ * node for every row. Instead, the pane keeps a small pool of row nodes, just
+ * enough to cover the visible area, and rebinds them to new data indices as
+ * the pane is navigated. The interior bounds are computed from the row count
+ * and row height, so no row is ever created just to measure it.
  */
 class ScrollPane : public SceneNode {
+public:
+    /**
+     * @typedef RowFactory
+     *
+     * This type represents a factory for the rows of a virtual list.
+     *
+     * The factory is called only when the pool of rows must grow. The row
+     * is not bound to any data when it is created.
+     *
+     * The function type is equivalent to
+     *
+     *      std::function<std::shared_ptr<SceneNode>()>
+     */
+    typedef std::function<std::shared_ptr<SceneNode>()> RowFactory;
+
+    /**
+     * @typedef RowBinder
+     *
+     * This type represents a function to bind a row of a virtual list.
+     *
+     * The function should update the row node (text, images, and so on) to
+     * display the data with the given index. It should not change the
+     * position of the row, as that is managed by the pane.
+     *
+     * The function type is equivalent to
+     *
+     *      std::function<void(const std::shared_ptr<SceneNode>& row, size_t index)>
+     *
+     * @param row       The row node to bind
+     * @param index     The data index to display
+     */
+    typedef std::function<void(const std::shared_ptr<SceneNode>& row, size_t index)> RowBinder;
+
 #pragma mark Values
 protected:
     /** The interior rectangle representing the internal content bounds */
@@ -152,6 +194,30 @@ protected:
     /** The masking scissor for this scroll pane */
     std::shared_ptr<Scissor> _panemask;
 
+    /** The factory for the rows of a virtual list (nullptr if not virtualized) */
+    RowFactory _rowfactory;
+    /** The function to bind a row node to its data index */
+    RowBinder _rowbinder;
+    /** The pool of row nodes of a virtual list */
+    std::vector<std::shared_ptr<SceneNode>> _rows;
+    /** The data index bound to each row node (or the row count if unbound) */
+    std::vector<size_t> _rowbound;
+    /** The number of data rows in the virtual list */
+    size_t _rowcount;
+    /** The height of each row in the virtual list */
+    float _rowheight;
+    /** The top of the virtual list at the last update */
+    float _rowtop;
+
+    /**
+     * Rebinds the rows of the virtual list to the visible area.
+     *
+     * Only the rows that have moved to a new data index are rebound. The
+     * pool of rows grows if the visible area needs more rows than it has.
+     * This method does nothing if this pane is not a virtual list.
+     */
+    void updateRows();
+
 #pragma mark -
 #pragma mark Constructors
 public:
@@ -867,8 +933,104 @@ public:
      */
     void resetPane();
 
+#pragma mark -
+#pragma mark Virtual Lists
+    /**
+     * Makes this scroll pane a virtual list with the given rows.
+     *
+     * A virtual list is a vertical list of rows of the given height, with the
+     * first row at the top. The interior bounds are as wide as the content
+     * bounds and tall enough to hold every row. This replaces any previous
+     * interior, and resets the pane (see {@link #resetPane}).
+     *
+     * The rows are nodes created by the factory on demand. There are only
+     * ever enough of them to cover the visible area, and they are rebound to
+     * new data indices by the binder as the pane is navigated. These nodes are
+     * added as children of this pane, and their position is managed by the
+     * pane. Other children are unaffected. A virtual list should not have a
+     * layout manager.
+     *
+     * @param count     The number of data rows
+     * @param height    The height of each row
+     * @param factory   The factory to create row nodes
+     * @param binder    The function to bind a row node to a data index
+     *
+     * @return true if the virtual list was successfully created
+     */
+    bool setVirtualList(size_t count, float height, RowFactory factory, RowBinder binder);
+
+    /**
+     * Returns true if this scroll pane is a virtual list.
+     *
+     * @return true if this scroll pane is a virtual list.
+     */
+    bool isVirtualList() const { return _rowfactory != nullptr; }
+
+    /**
+     * Removes the virtual list from this scroll pane.
+     *
+     * All row nodes are removed from the pane. The interior bounds are not
+     * changed.
+     */
+    void clearVirtualList();
+
+    /**
+     * Returns the number of data rows in the virtual list.
+     *
+     * @return the number of data rows in the virtual list.
+     */
+    size_t getRowCount() const { return _rowcount; }
+
+    /**
+     * Sets the number of data rows in the virtual list.
+     *
+     * The interior bounds grow or shrink to fit the new row count, but the
+     * pane is not reset. Instead, the current pan is adjusted if necessary to
+     * stay within the new interior. All visible rows are rebound, as the data
+     * has presumably changed.
+     *
+     * @param count     The number of data rows
+     */
+    void setRowCount(size_t count);
+
+    /**
+     * Returns the height of each row in the virtual list.
+     *
+     * @return the height of each row in the virtual list.
+     */
+    float getRowHeight() const { return _rowheight; }
+
+    /**
+     * Returns the number of row nodes created for the virtual list.
+     *
+     * This is the number of rows needed to cover the visible area, and is
+     * independent of the number of data rows.
+     *
+     * @return the number of row nodes created for the virtual list.
+     */
+    size_t getRowPoolSize() const { return _rows.size(); }
+
+    /**
+     * Rebinds all of the visible rows of the virtual list.
+     *
+     * This method should be called when the data displayed by the rows has
+     * changed, but the number of rows has not.
+     */
+    void refreshRows();
+
 #pragma mark -
 #pragma mark Rendering
+    /**
+     * Returns an AABB containing this node and all of its descendants.
+     *
+     * The children of a scroll pane are moved by the pane transform. If the
+     * pane has a mask, the children cannot be seen outside of the mask, so only
+     * the content bounds are used.
+     *
+     * @return an AABB containing this node and all of its descendants.
+     */
+    virtual Rect computeSubtreeBounds() override;
+
     /**
      * Draws this Node and all of its children with the given SpriteBatch.
      *
@@ -0,0 +1,691 @@
+//
+//  CUConcurrentFreeList.h
+//  Cornell University Game Library (CUGL)
+//
+//  This header provides a template for a thread-safe free list class. It is
+//  like FreeList, except that objects may be allocated and freed from any
+//  thread. In particular, an object may be allocated on one thread and freed
+//  on another (such as an event decoded on a network thread and released on
+//  the main thread).
+//
+//  Each thread keeps a small cache (a pair of magazines) of free objects, so
+//  most allocations and releases never touch shared state. Full and empty
+//  magazines are exchanged through a lock-free global depot. A lock is only
+//  taken when the free list must allocate more memory.
+//
+//  This is not a class. It is a class template. Templates do not have cpp
+//  files. They only have a header file.  When you include the header, it
+//  compiles the specific template used by your program. Hence all of the code
+//  for this templated class is in this header.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_CONCURRENT_FREE_LIST_H__
+#define __CU_CONCURRENT_FREE_LIST_H__
+#include <cugl/base/CUBase.h>
+#include <cugl/util/CUAligned.h>
+#include <cugl/util/CUDebug.h>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <new>
+
+/** The number of objects in a single magazine */
+#define CU_MAGAZINE_SIZE    32
+/** The number of magazines in a single block of the magazine directory */
+#define CU_MAGAZINE_BLOCK   64
+/** The maximum number of blocks in the magazine directory */
+#define CU_MAGAZINE_BLOCKS  1024
+/** The number of free lists (of the same type) a thread caches at once */
+#define CU_FREELIST_CACHES  4
+
+namespace cugl {
+
+#pragma mark -
+#pragma mark ConcurrentFreeList Template
+
+/**
+ * Template for a thread-safe free list class
+ *
+ * This class is a variation of {@link FreeList} that may be used from any
+ * number of threads at once. As with FreeList, you use the methods
+ * {@link malloc()} and {@link free()} in place of new and delete, and the
+ * free list owns all of the memory that it allocates. Unlike FreeList, an
+ * object may be freed by a different thread than the one that allocated it.
+ *
+ * Free objects are stored in magazines, which are small stacks of at most
+ * CU_MAGAZINE_SIZE objects. Each thread has two magazines for each free list
+ * that it uses, and most calls to {@link malloc()} and {@link free()} only
+ * touch these magazines. When both are empty (or full), the thread exchanges
+ * a magazine with a global depot. The depot is a lock-free stack, so threads
+ * never block each other. The only lock is when the free list needs more
+ * memory, which it allocates in slabs of objects.
+ *
+ * As objects may be cached by other threads, {@link malloc()} can fail on a
+ * free list that is not expandable even when {@link getUsage()} is less than
+ * the capacity. Expandable free lists always succeed. A thread that exits
+ * returns its magazines to the depot.
+ *
+ * In order to work properly, the objects allocated must all have the method
+ *
+ *    void reset();
+ *
+ * This method resets the object when it is recycled, just as in FreeList. In
+ * addition, the class must have a default constructor with no arguments.
+ *
+ * The objects may be allocated with a stricter alignment than their type
+ * requires (see {@link Aligned}), which is useful for vectorized data. Each
+ * object is aligned, so the objects are padded to a multiple of the
+ * alignment. The alignment must be a power of two.
+ *
+ * The methods {@link init} and {@link dispose} are not thread-safe. They
+ * should only be called when no other thread is using the free list.
+ */
+template <class T>
+class ConcurrentFreeList {
+private:
+    /** A stack of free objects, cached by a thread or the depot */
+    struct Magazine {
+        /** The free objects */
+        T* items[CU_MAGAZINE_SIZE];
+        /** The number of free objects */
+        size_t size;
+        /** The next magazine in the depot stack (index+1, or 0 for none) */
+        std::atomic<Uint32> next;
+
+        /** Creates an empty magazine */
+        Magazine() : size(0), next(0) {}
+    };
+
+    /** The magazines cached by a thread for a single free list */
+    struct LocalCache {
+        /** The identifier of the free list (0 if unused) */
+        Uint64 owner;
+        /** The magazine to allocate from */
+        Uint32 loaded;
+        /** The backup magazine */
+        Uint32 previous;
+    };
+
+    /** The magazines cached by a thread for all free lists of this type */
+    struct LocalCaches {
+        /** The caches for individual free lists */
+        LocalCache entries[CU_FREELIST_CACHES];
+
+        /** Creates an empty set of caches */
+        LocalCaches() {
+            for(int ii = 0; ii < CU_FREELIST_CACHES; ii++) {
+                entries[ii].owner = 0;
+            }
+        }
+
+        /** Returns the magazines to their free lists when the thread exits */
+        ~LocalCaches() {
+            for(int ii = 0; ii < CU_FREELIST_CACHES; ii++) {
+                ConcurrentFreeList<T>::release(entries[ii]);
+            }
+        }
+    };
+
+    /** The unique identifier of this free list (never reused) */
+    Uint64 _id;
+    /** The number of objects allocated so far */
+    std::atomic<size_t> _allocated;
+    /** The number of objects released. */
+    std::atomic<size_t> _released;
+    /** The memory high water mark */
+    std::atomic<size_t> _peaksize;
+
+    /** The capacity of the preallocated objects */
+    size_t _capacity;
+    /** The total number of objects in all slabs */
+    size_t _total;
+    /** Whether or not we can add objects beyond the ones preallocated */
+    bool _expandable;
+    /** The alignment of the allocated objects */
+    size_t _alignment;
+    /** The distance in bytes between consecutive objects in a slab */
+    size_t _stride;
+
+    /** The memory for the allocated objects */
+    std::vector<std::unique_ptr<Aligned<Uint8>>> _slabs;
+    /** The blocks of magazines */
+    Magazine* _directory[CU_MAGAZINE_BLOCKS];
+    /** The number of magazines allocated */
+    Uint32 _magazines;
+    /** A mutex for allocating slabs and magazines */
+    std::mutex _growMutex;
+
+    /** The stack of non-empty magazines (tag in the high bits, index+1 in the low bits) */
+    std::atomic<Uint64> _fullDepot;
+    /** The stack of empty magazines (tag in the high bits, index+1 in the low bits) */
+    std::atomic<Uint64> _emptyDepot;
+
+#pragma mark Internal Helpers
+    /**
+     * Returns the registry of active free lists of this type.
+     *
+     * The registry allows a thread to return its magazines when it exits,
+     * but only if the free list still exists.
+     *
+     * @return the registry of active free lists of this type.
+     */
+    static std::unordered_map<Uint64,ConcurrentFreeList<T>*>& registry() {
+        static std::unordered_map<Uint64,ConcurrentFreeList<T>*> lists;
+        return lists;
+    }
+
+    /**
+     * Returns the mutex for the registry of active free lists.
+     *
+     * @return the mutex for the registry of active free lists.
+     */
+    static std::mutex& registryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    /**
+     * Returns a new unique identifier for a free list.
+     *
+     * @return a new unique identifier for a free list.
+     */
+    static Uint64 nextIdentifier() {
+        static std::atomic<Uint64> counter(1);
+        return counter.fetch_add(1);
+    }
+
+    /**
+     * Returns the magazine caches for the current thread.
+     *
+     * @return the magazine caches for the current thread.
+     */
+    static LocalCaches& locals() {
+        static thread_local LocalCaches caches;
+        return caches;
+    }
+
+    /**
+     * Returns the cached magazines to the free list that owns them.
+     *
+     * If the free list has been disposed, this method does nothing, as the
+     * magazines were deleted with the free list.
+     *
+     * @param cache The thread cache to release
+     */
+    static void release(LocalCache& cache) {
+        if (cache.owner == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto it = registry().find(cache.owner);
+        if (it != registry().end()) {
+            ConcurrentFreeList<T>* list = it->second;
+            list->deposit(cache.loaded);
+            list->deposit(cache.previous);
+        }
+        cache.owner = 0;
+    }
+
+    /**
+     * Returns the magazine with the given index.
+     *
+     * @param index The magazine index
+     *
+     * @return the magazine with the given index.
+     */
+    Magazine* magazine(Uint32 index) const {
+        return _directory[index/CU_MAGAZINE_BLOCK]+(index % CU_MAGAZINE_BLOCK);
+    }
+
+    /**
+     * Pushes a magazine on to the given depot stack.
+     *
+     * @param depot The depot stack
+     * @param index The magazine index
+     */
+    void push(std::atomic<Uint64>& depot, Uint32 index) {
+        Magazine* mag = magazine(index);
+        Uint64 head = depot.load(std::memory_order_relaxed);
+        Uint64 next;
+        do {
+            mag->next.store((Uint32)(head & 0xffffffff), std::memory_order_relaxed);
+            next = ((head >> 32)+1) << 32 | (Uint64)(index+1);
+        } while (!depot.compare_exchange_weak(head, next, std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    /**
+     * Pops a magazine from the given depot stack, returning true on success.
+     *
+     * The tag in the stack head prevents ABA errors.
+     *
+     * @param depot The depot stack
+     * @param index The address to store the magazine index
+     *
+     * @return true if a magazine was removed
+     */
+    bool pop(std::atomic<Uint64>& depot, Uint32& index) {
+        Uint64 head = depot.load(std::memory_order_acquire);
+        Uint64 next;
+        do {
+            Uint32 top = (Uint32)(head & 0xffffffff);
+            if (top == 0) {
+                return false;
+            }
+            index = top-1;
+            next = ((head >> 32)+1) << 32 | magazine(index)->next.load(std::memory_order_relaxed);
+        } while (!depot.compare_exchange_weak(head, next, std::memory_order_acquire,
+                                              std::memory_order_acquire));
+        return true;
+    }
+
+    /**
+     * Adds a magazine to the appropriate depot stack.
+     *
+     * @param index The magazine index
+     */
+    void deposit(Uint32 index) {
+        push(magazine(index)->size > 0 ? _fullDepot : _emptyDepot, index);
+    }
+
+    /**
+     * Returns the index of a new empty magazine.
+     *
+     * The growth mutex must be held.
+     *
+     * @return the index of a new empty magazine.
+     */
+    Uint32 createMagazine() {
+        Uint32 index = _magazines;
+        Uint32 block = index/CU_MAGAZINE_BLOCK;
+        CUAssertLog(block < CU_MAGAZINE_BLOCKS, "The free list has too many magazines");
+        if (_directory[block] == nullptr) {
+            _directory[block] = new Magazine[CU_MAGAZINE_BLOCK];
+        }
+        _magazines++;
+        return index;
+    }
+
+    /**
+     * Returns the index of an empty magazine.
+     *
+     * @return the index of an empty magazine.
+     */
+    Uint32 acquireEmpty() {
+        Uint32 index;
+        if (pop(_emptyDepot, index)) {
+            return index;
+        }
+        std::lock_guard<std::mutex> lock(_growMutex);
+        return createMagazine();
+    }
+
+    /**
+     * Allocates a new slab of objects, returning false if not possible.
+     *
+     * The objects fill the given magazine, and any remaining objects are
+     * added to the depot in full magazines.
+     *
+     * @param count     The number of objects in the slab
+     * @param index     The magazine to fill (must be empty)
+     *
+     * @return true if the slab was allocated
+     */
+    bool grow(size_t count, Uint32 index) {
+        std::lock_guard<std::mutex> lock(_growMutex);
+        if (count == 0) {
+            return false;
+        }
+        std::unique_ptr<Aligned<Uint8>> slab = std::make_unique<Aligned<Uint8>>(count*_stride,_alignment);
+        Uint8* memory = (Uint8*)(*slab);
+        if (memory == nullptr) {
+            return false;
+        }
+        for(size_t ii = 0; ii < count; ii++) {
+            new (memory+ii*_stride) T();
+        }
+        _slabs.push_back(std::move(slab));
+        _total += count;
+
+        size_t pos = 0;
+        Magazine* mag = magazine(index);
+        while (pos < count && mag->size < CU_MAGAZINE_SIZE) {
+            mag->items[mag->size++] = (T*)(memory+(pos++)*_stride);
+        }
+        while (pos < count) {
+            Uint32 other = createMagazine();
+            Magazine* full = magazine(other);
+            while (pos < count && full->size < CU_MAGAZINE_SIZE) {
+                full->items[full->size++] = (T*)(memory+(pos++)*_stride);
+            }
+            push(_fullDepot, other);
+        }
+        return true;
+    }
+
+    /**
+     * Returns the magazine cache of the current thread for this free list.
+     *
+     * If this thread has no cache for this free list, one is created. This
+     * may evict the cache of another free list, returning its magazines.
+     *
+     * @return the magazine cache of the current thread for this free list.
+     */
+    LocalCache& local() {
+        LocalCaches& caches = locals();
+        LocalCache* slot = nullptr;
+        for(int ii = 0; ii < CU_FREELIST_CACHES; ii++) {
+            LocalCache& entry = caches.entries[ii];
+            if (entry.owner == _id) {
+                return entry;
+            } else if (slot == nullptr && entry.owner == 0) {
+                slot = &entry;
+            }
+        }
+        if (slot == nullptr) {
+            // Evict the oldest cache
+            slot = &caches.entries[0];
+            release(*slot);
+        }
+        slot->owner = _id;
+        slot->loaded = acquireEmpty();
+        slot->previous = acquireEmpty();
+        return *slot;
+    }
+
+    /**
+     * Records an allocation, updating the high water mark.
+     */
+    void recordAllocation() {
+        size_t usage = (_allocated.fetch_add(1)+1)-_released.load();
+        size_t peak = _peaksize.load();
+        while (peak < usage && !_peaksize.compare_exchange_weak(peak, usage)) {}
+    }
+
+#pragma mark Constructors
+public:
+    /**
+     * Creates a new free list with no capacity.
+     *
+     * You must initialize this free list before use.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a free list on
+     * the heap, use one of the static constructors instead.
+     */
+    ConcurrentFreeList() : _id(0), _allocated(0), _released(0), _peaksize(0),
+    _capacity(0), _total(0), _expandable(false), _alignment(alignof(T)),
+    _stride(sizeof(T)), _magazines(0), _fullDepot(0), _emptyDepot(0) {
+        for(int ii = 0; ii < CU_MAGAZINE_BLOCKS; ii++) {
+            _directory[ii] = nullptr;
+        }
+    }
+
+    /**
+     * Deletes this free list, releasing all memory.
+     *
+     * A free list is the owner of all memory it allocates. Any object allocated
+     * by this free list will be deleted and unsafe to access.
+     */
+    ~ConcurrentFreeList() { dispose(); }
+
+    /**
+     * Disposes this free list, releasing all memory.
+     *
+     * A disposed free list can be safely reinitialized. However, a free list
+     * is the owner of all memory it allocates.  Any object allocated by this
+     * free list will be deleted and unsafe to access.
+     *
+     * This method is not thread-safe, and no other thread may use the free
+     * list while it is disposed.
+     */
+    void dispose() {
+        if (_id != 0) {
+            std::lock_guard<std::mutex> lock(registryMutex());
+            registry().erase(_id);
+        }
+        // Caches of other threads will never match the old identifier
+        LocalCaches& caches = locals();
+        for(int ii = 0; ii < CU_FREELIST_CACHES; ii++) {
+            if (caches.entries[ii].owner == _id) {
+                caches.entries[ii].owner = 0;
+            }
+        }
+
+        for(auto it = _slabs.begin(); it != _slabs.end(); ++it) {
+            Uint8* memory = (Uint8*)(**it);
+            for(size_t ii = 0; ii < (*it)->size()/_stride; ii++) {
+                ((T*)(memory+ii*_stride))->~T();
+            }
+        }
+        _slabs.clear();
+        for(int ii = 0; ii < CU_MAGAZINE_BLOCKS; ii++) {
+            if (_directory[ii] != nullptr) {
+                delete[] _directory[ii];
+                _directory[ii] = nullptr;
+            }
+        }
+        _id = 0;
+        _magazines = 0;
+        _fullDepot  = 0;
+        _emptyDepot = 0;
+        _allocated = 0;
+        _released  = 0;
+        _peaksize  = 0;
+        _capacity  = 0;
+        _total = 0;
+    }
+
+    /**
+     * Initializes a free list with the given capacity.
+     *
+     * If capacity is non-zero, then it will allocate that many objects ahead
+     * of time. If expand is false, then it will never allocate any objects
+     * beyond those preallocated in this constructor.
+     *
+     * The objects are aligned to the given alignment, or the alignment of
+     * the type if that is larger. The alignment must be a power of two.
+     *
+     * @param  capacity     the number of objects to preallocate
+     * @param  expand       whether to allow non-preallocated objects
+     * @param  alignment    the alignment of the allocated objects
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(size_t capacity, bool expand, size_t alignment=0) {
+        CUAssertLog(capacity || expand, "The free list must be expandable or have capacity non-zero");
+        CUAssertLog((alignment & (alignment-1)) == 0, "The alignment %zu is not a power of two", alignment);
+        _id = nextIdentifier();
+        _expandable = expand;
+        _capacity   = capacity;
+        _alignment  = std::max(alignment,alignof(T));
+        _stride = (sizeof(T)+_alignment-1) & ~(_alignment-1);
+        {
+            std::lock_guard<std::mutex> lock(registryMutex());
+            registry()[_id] = this;
+        }
+
+        if (capacity > 0) {
+            Uint32 index;
+            {
+                std::lock_guard<std::mutex> lock(_growMutex);
+                index = createMagazine();
+            }
+            if (!grow(capacity,index)) {
+                return false;
+            }
+            push(_fullDepot, index);
+        }
+        return true;
+    }
+
+    /**
+     * Returns a newly allocated free list with the given capacity.
+     *
+     * If capacity is non-zero, then it will allocate that many objects ahead
+     * of time. If expand is false, then it will never allocate any objects
+     * beyond those preallocated in this constructor.
+     *
+     * The objects are aligned to the given alignment, or the alignment of
+     * the type if that is larger. The alignment must be a power of two.
+     *
+     * @param  capacity     the number of objects to preallocate
+     * @param  expand       whether to allow non-preallocated objects
+     * @param  alignment    the alignment of the allocated objects
+     *
+     * @return a newly allocated free list with the given capacity.
+     */
+    static std::shared_ptr<ConcurrentFreeList<T>> alloc(size_t capacity=0, bool expand=false,
+                                                        size_t alignment=0) {
+        std::shared_ptr<ConcurrentFreeList<T>> result = std::make_shared<ConcurrentFreeList<T>>();
+        return (result->init(capacity,expand,alignment) ? result : nullptr);
+    }
+
+
+#pragma mark Accessors
+    /**
+     * Returns the preallocated capacity of this list.
+     *
+     * If the free list is not expandable, this it the maximum number of objects
+     * that may be allocated at any given time.
+     *
+     * @return the preallocated capacity of this list.
+     */
+    size_t getCapacity() const { return _capacity; }
+
+    /**
+     * Returns the number of objects that have been allocated but not released yet.
+     *
+     * Allocating an object will increase this value; free an object will decrease
+     * the value. As other threads may be allocating objects, this value is
+     * only approximate.
+     *
+     * @return the number of objects that have been allocated but not released yet.
+     */
+    size_t getUsage() const { return _allocated.load()-_released.load(); }
+
+    /**
+     * Returns the maximum usage value at any given time in this object's lifecycle.
+     *
+     * This value represents the high-water mark for memory.  It is very useful if
+     * this is an expandable free list.
+     *
+     * @return the maximum usage value at any given time in this object's lifecycle.
+     */
+    size_t getPeakUsage() const { return _peaksize.load(); }
+
+    /**
+     * Returns whether this free list is allowed to allocate additional memory.
+     *
+     * If the free list is not expandable, the capacity is the maximum number of
+     * objects that may be allocated at any given time.
+     *
+     * @return whether this free list is allowed to allocate additional memory.
+     */
+    bool isExpandable() const { return _expandable; }
+
+    /**
+     * Returns the alignment of the allocated objects.
+     *
+     * @return the alignment of the allocated objects.
+     */
+    size_t getAlignment() const { return _alignment; }
+
+
+#pragma mark Memory Managment
+    /**
+     * Returns a pointer to a newly allocated T object.
+     *
+     * This method first looks in the magazines of the current thread, and
+     * then in the global depot. If both are empty, and the list is
+     * expandable, it allocates a new slab of objects. Otherwise, it will
+     * return nullptr.
+     *
+     * This method is thread-safe.
+     *
+     * @return a pointer to a newly allocated T object.
+     */
+    T* malloc() {
+        LocalCache& cache = local();
+        Magazine* loaded = magazine(cache.loaded);
+        if (loaded->size == 0) {
+            Magazine* previous = magazine(cache.previous);
+            Uint32 index;
+            if (previous->size > 0) {
+                std::swap(cache.loaded,cache.previous);
+            } else if (pop(_fullDepot, index)) {
+                push(_emptyDepot, cache.previous);
+                cache.previous = cache.loaded;
+                cache.loaded = index;
+            } else if (!_expandable || !grow(std::max((size_t)(4*CU_MAGAZINE_SIZE),_capacity/4),
+                                             cache.loaded)) {
+                return nullptr;
+            }
+            loaded = magazine(cache.loaded);
+        }
+        recordAllocation();
+        return loaded->items[--loaded->size];
+    }
+
+    /**
+     * Frees the object, adding it to the free list.
+     *
+     * This method will call the reset() method in the object, erasing its
+     * contents.  The class should be designed so that it cannot be used until
+     * it is reintialized.
+     *
+     * The object must have been allocated by this free list, but it may
+     * have been allocated by a different thread. This method is thread-safe.
+     *
+     * @param  obj  the object to free
+     */
+    void free(T* obj) {
+        CUAssertLog(obj != nullptr, "Attempt to free null pointer");
+        obj->reset();
+        LocalCache& cache = local();
+        Magazine* loaded = magazine(cache.loaded);
+        if (loaded->size == CU_MAGAZINE_SIZE) {
+            Magazine* previous = magazine(cache.previous);
+            if (previous->size < CU_MAGAZINE_SIZE) {
+                std::swap(cache.loaded,cache.previous);
+            } else {
+                push(_fullDepot, cache.previous);
+                cache.previous = cache.loaded;
+                cache.loaded = acquireEmpty();
+            }
+            loaded = magazine(cache.loaded);
+        }
+        loaded->items[loaded->size++] = obj;
+        _released.fetch_add(1);
+    }
+
+private:
+    /** This class cannot be copied */
+    CU_DISALLOW_COPY_AND_ASSIGN(ConcurrentFreeList);
+};
+
+}
+#endif /* __CU_CONCURRENT_FREE_LIST_H__ */
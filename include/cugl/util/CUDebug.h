@@ -36,6 +36,28 @@
 #include <cugl/math/CUMathBase.h>
 #include <cassert>
 
+/**
+ * The minimum priority of the log messages compiled into the application.
+ *
+ * The values match SDL_LogPriority: 1 is verbose, 2 is debug, 3 is info (the
+ * priority of {@link CULog}), 4 is a warning, 5 is an error, and 6 is critical.
+ * Log macros below this priority compile to nothing, so their arguments are
+ * not even evaluated. Logs at or above this priority are filtered at runtime
+ * by SDL_LogSetPriority. By default, every log message is compiled in.
+ */
+#ifndef CU_LOG_LEVEL
+    #define CU_LOG_LEVEL 1
+#endif
+
+/**
+ * The log category for the networking debug messages.
+ *
+ * Like all custom SDL categories, this category only shows critical messages
+ * by default. The {@link NetworkLayer} lowers its priority when network
+ * debugging is enabled.
+ */
+#define CU_LOG_CATEGORY_NETCODE     SDL_LOG_CATEGORY_CUSTOM
+
 namespace cugl {
 
 /**
@@ -50,12 +72,59 @@ namespace cugl {
  * @param msg       The message to display
  * @param args...   Formatting arguments for printf
  */
-#if defined(__WINDOWS__)
+#if CU_LOG_LEVEL > 3
+#define CULog(...)              ((void)0)
+#elif defined(__WINDOWS__)
 #define CULog(msg,...)			SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION,SDL_LOG_PRIORITY_INFO,msg, ##__VA_ARGS__)
 #else
 #define CULog(msg,args...)		SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION,SDL_LOG_PRIORITY_INFO,msg, ##args)
 #endif
 
+/**
+ * @def CULogDebug(msg,args...)
+ *
+ * Writes a debug message to the application log.
+ *
+ * Debug messages are for tracing that is too verbose for {@link CULog}. They
+ * are hidden unless the priority of SDL_LOG_CATEGORY_APPLICATION is lowered
+ * to SDL_LOG_PRIORITY_DEBUG, and they are compiled out entirely when
+ * CU_LOG_LEVEL is more than 2. The log message takes printf style formatting
+ * arguments.
+ *
+ * @param msg       The message to display
+ * @param args...   Formatting arguments for printf
+ */
+#if CU_LOG_LEVEL > 2
+#define CULogDebug(...)         ((void)0)
+#elif defined(__WINDOWS__)
+#define CULogDebug(msg,...)		SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION,SDL_LOG_PRIORITY_DEBUG,msg, ##__VA_ARGS__)
+#else
+#define CULogDebug(msg,args...)	SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION,SDL_LOG_PRIORITY_DEBUG,msg, ##args)
+#endif
+
+/**
+ * @def CULogCategory(category,msg,args...)
+ *
+ * Writes an info message to the given log category.
+ *
+ * This is the same as {@link CULog}, except that the message belongs to the
+ * given SDL log category (such as {@link CU_LOG_CATEGORY_NETCODE}). Each
+ * category has its own runtime priority, and may be rate limited with
+ * {@link Logger#setRateLimit}. The log message takes printf style formatting
+ * arguments.
+ *
+ * @param category  The log category
+ * @param msg       The message to display
+ * @param args...   Formatting arguments for printf
+ */
+#if CU_LOG_LEVEL > 3
+#define CULogCategory(...)      ((void)0)
+#elif defined(__WINDOWS__)
+#define CULogCategory(category,msg,...)     SDL_LogMessage(category,SDL_LOG_PRIORITY_INFO,msg, ##__VA_ARGS__)
+#else
+#define CULogCategory(category,msg,args...) SDL_LogMessage(category,SDL_LOG_PRIORITY_INFO,msg, ##args)
+#endif
+
 /**
  * @def CULogError(msg,args...)
  *
@@ -68,7 +137,9 @@ namespace cugl {
  * @param msg       The message to display
  * @param args...   Formatting arguments for printf
  */
-#if defined(__WINDOWS__)
+#if CU_LOG_LEVEL > 5
+#define CULogError(...)         ((void)0)
+#elif defined(__WINDOWS__)
 #define CULogError(msg,...)		SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION,SDL_LOG_PRIORITY_ERROR,msg, ##__VA_ARGS__)
 #else
 #define CULogError(msg,args...)		SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION,SDL_LOG_PRIORITY_ERROR,msg, ##args)
@@ -87,7 +158,9 @@ namespace cugl {
  * @param msg       The message to display
  * @param args...   Formatting arguments for printf
  */
-#if defined(__WINDOWS__)
+#if CU_LOG_LEVEL > 6
+#define CULogCritical(...)      ((void)0)
+#elif defined(__WINDOWS__)
 #define CULogCritical(msg,...)		SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION,SDL_LOG_PRIORITY_CRITICAL,msg, ##__VA_ARGS__)
 #else
 #define CULogCritical(msg,args...)	SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION,SDL_LOG_PRIORITY_CRITICAL,msg, ##args)
@@ -106,7 +179,9 @@ namespace cugl {
  * @param msg       The message to display
  * @param args...   Formatting arguments for printf
  */
-#if defined(__WINDOWS__)
+#if CU_LOG_LEVEL > 4
+#define CUWarn(...)             ((void)0)
+#elif defined(__WINDOWS__)
 #define CUWarn(msg,...)		SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION,SDL_LOG_PRIORITY_WARN,msg,##__VA_ARGS__)
 #else
 #define CUWarn(msg,args...)		SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION,SDL_LOG_PRIORITY_WARN,msg, ##args)
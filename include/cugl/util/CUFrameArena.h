@@ -0,0 +1,315 @@
+//
+//  CUFrameArena.h
+//  Cornell University Game Library (CUGL)
+//
+//  This header provides a linear (bump) allocator for transient data. Memory
+//  from an arena is never freed individually. Instead, the entire arena is
+//  reset at once, typically at the start of an animation frame. This makes
+//  allocation a pointer increment, and it never fragments the heap.
+//
+//  The class Application owns two of these arenas, which it swaps every
+//  frame. So memory allocated in one frame remains valid through the next
+//  frame.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_FRAME_ARENA_H__
+#define __CU_FRAME_ARENA_H__
+#include <cugl/base/CUBase.h>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/** The default size of a block in a frame arena (64 KB) */
+#define CU_ARENA_BLOCK  65536
+
+namespace cugl {
+
+#pragma mark -
+#pragma mark Frame Arena
+
+/**
+ * This class is a linear allocator for transient data.
+ *
+ * An arena allocates memory by advancing a pointer in a large block. The
+ * memory is never freed individually. Instead, {@link #reset} releases
+ * everything allocated at once. If an allocation does not fit in the current
+ * block, the arena adds another block. On reset, these blocks are merged into
+ * a single block big enough for everything allocated. So once an arena has
+ * seen its largest frame, it never allocates from the heap again.
+ *
+ * The class {@link Application} has two arenas, which it swaps (and resets)
+ * at the start of every animation frame. See {@link Application#getFrameArena}.
+ * You can use {@link FrameAllocator} to put STL containers in an arena.
+ *
+ * Objects in an arena are never destroyed. So an arena should only be used for
+ * types whose destructors do nothing (or whose destructors only free memory
+ * from the same arena). This class is not thread-safe.
+ */
+class FrameArena {
+private:
+    /** A single block of memory */
+    struct Block {
+        /** The block memory */
+        Uint8* data;
+        /** The capacity of this block in bytes */
+        size_t capacity;
+    };
+
+    /** The memory blocks */
+    std::vector<Block> _blocks;
+    /** The block currently being allocated from */
+    size_t _current;
+    /** The offset of the next allocation in the current block */
+    size_t _offset;
+    /** The minimum size of a block */
+    size_t _blocksize;
+    /** The number of bytes allocated since the last reset */
+    size_t _usage;
+    /** The memory high water mark */
+    size_t _peaksize;
+
+    /**
+     * Adds a new block with at least the given capacity.
+     *
+     * @param capacity  The minimum block capacity in bytes
+     */
+    void addBlock(size_t capacity);
+
+public:
+#pragma mark Constructors
+    /**
+     * Creates an empty arena with the default block size.
+     *
+     * The arena does not allocate any memory until it is first used. Unlike
+     * most classes in CUGL, an arena is usable without initialization. This
+     * allows it to be a field of other classes.
+     */
+    FrameArena();
+
+    /**
+     * Deletes this arena, releasing all memory.
+     *
+     * Any memory allocated from this arena is no longer valid.
+     */
+    ~FrameArena() { dispose(); }
+
+    /**
+     * Disposes this arena, releasing all memory.
+     *
+     * Any memory allocated from this arena is no longer valid. A disposed
+     * arena may still be used, and will allocate new blocks as necessary.
+     */
+    void dispose();
+
+    /**
+     * Initializes this arena with a block of the given size.
+     *
+     * The block size is the minimum size of any block that the arena adds.
+     * Allocations larger than this get a block of their own (until they are
+     * merged on reset).
+     *
+     * @param blocksize The minimum block size in bytes
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(size_t blocksize=CU_ARENA_BLOCK);
+
+    /**
+     * Returns a newly allocated arena with a block of the given size.
+     *
+     * The block size is the minimum size of any block that the arena adds.
+     * Allocations larger than this get a block of their own (until they are
+     * merged on reset).
+     *
+     * @param blocksize The minimum block size in bytes
+     *
+     * @return a newly allocated arena with a block of the given size.
+     */
+    static std::shared_ptr<FrameArena> alloc(size_t blocksize=CU_ARENA_BLOCK) {
+        std::shared_ptr<FrameArena> result = std::make_shared<FrameArena>();
+        return (result->init(blocksize) ? result : nullptr);
+    }
+
+#pragma mark Allocation
+    /**
+     * Returns a pointer to the given number of bytes with the given alignment.
+     *
+     * The memory is valid until the next call to {@link #reset}. The
+     * alignment must be a power of two.
+     *
+     * @param size      The number of bytes to allocate
+     * @param alignment The memory alignment
+     *
+     * @return a pointer to the given number of bytes with the given alignment.
+     */
+    void* allocate(size_t size, size_t alignment=alignof(std::max_align_t));
+
+    /**
+     * Returns a pointer to an uninitialized array of the given type.
+     *
+     * The memory is valid until the next call to {@link #reset}.
+     *
+     * @param count The number of elements
+     *
+     * @return a pointer to an uninitialized array of the given type.
+     */
+    template <typename T>
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocate(count*sizeof(T),alignof(T)));
+    }
+
+    /**
+     * Releases all memory allocated from this arena.
+     *
+     * The arena keeps its memory for future allocations. If the last frame
+     * needed more than one block, the blocks are merged into one.
+     */
+    void reset();
+
+#pragma mark Attributes
+    /**
+     * Returns the number of bytes allocated since the last reset.
+     *
+     * This value includes any padding for alignment.
+     *
+     * @return the number of bytes allocated since the last reset.
+     */
+    size_t getUsage() const { return _usage; }
+
+    /**
+     * Returns the maximum usage at any time in this arena's lifecycle.
+     *
+     * @return the maximum usage at any time in this arena's lifecycle.
+     */
+    size_t getPeakUsage() const { return _peaksize; }
+
+    /**
+     * Returns the total capacity of all blocks in this arena.
+     *
+     * @return the total capacity of all blocks in this arena.
+     */
+    size_t getCapacity() const;
+
+    /**
+     * Returns the minimum size of a block in this arena.
+     *
+     * @return the minimum size of a block in this arena.
+     */
+    size_t getBlockSize() const { return _blocksize; }
+
+private:
+    /** This class cannot be copied */
+    CU_DISALLOW_COPY_AND_ASSIGN(FrameArena);
+};
+
+#pragma mark -
+#pragma mark STL Allocator
+
+/**
+ * This template is an STL allocator that allocates from a {@link FrameArena}.
+ *
+ * This allocator allows STL containers to use an arena for their storage.
+ * Deallocation does nothing, as the arena releases all of its memory at once.
+ * So a container with this allocator must be destroyed before the arena is
+ * reset. The arenas of {@link Application} are reset between frames, so this
+ * is always the case for a container local to a single frame.
+ *
+ * Example:
+ *
+ *     FrameArena& arena = Application::get()->getFrameArena();
+ *     std::vector<Vec2,FrameAllocator<Vec2>> points(FrameAllocator<Vec2>(&arena));
+ */
+template <class T>
+class FrameAllocator {
+public:
+    /** The allocated type */
+    typedef T value_type;
+
+    /** The arena to allocate from */
+    FrameArena* arena;
+
+    /**
+     * Creates an allocator for the given arena.
+     *
+     * @param arena The arena to allocate from
+     */
+    FrameAllocator(FrameArena* arena) noexcept : arena(arena) {}
+
+    /**
+     * Creates a copy of an allocator for a different type.
+     *
+     * @param other The allocator to copy
+     */
+    template <class U>
+    FrameAllocator(const FrameAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    /**
+     * Returns an uninitialized array of the given size.
+     *
+     * @param n The number of elements
+     *
+     * @return an uninitialized array of the given size.
+     */
+    T* allocate(size_t n) { return arena->allocate<T>(n); }
+
+    /**
+     * Does nothing, as the arena frees all memory at once.
+     *
+     * @param p The array to deallocate
+     * @param n The number of elements
+     */
+    void deallocate(T* p, size_t n) noexcept {}
+
+    /**
+     * Returns true if the allocators share the same arena.
+     *
+     * @param other The allocator to compare
+     *
+     * @return true if the allocators share the same arena.
+     */
+    template <class U>
+    bool operator==(const FrameAllocator<U>& other) const noexcept {
+        return arena == other.arena;
+    }
+
+    /**
+     * Returns true if the allocators have different arenas.
+     *
+     * @param other The allocator to compare
+     *
+     * @return true if the allocators have different arenas.
+     */
+    template <class U>
+    bool operator!=(const FrameAllocator<U>& other) const noexcept {
+        return arena != other.arena;
+    }
+};
+
+/** A vector whose storage is in a frame arena */
+template <class T>
+using FrameVector = std::vector<T,FrameAllocator<T>>;
+
+}
+
+#endif /* __CU_FRAME_ARENA_H__ */
@@ -0,0 +1,151 @@
+//
+//  CULogger.h
+//  Cornell University Game Library (CUGL)
+//
+//  This header provides an asynchronous backend for the CUGL log macros. The
+//  macros in CUDebug.h still format their messages with SDL, but once the
+//  logger is started, SDL hands the formatted messages to the logger instead
+//  of writing them. Each thread copies its messages into a lock-free ring of
+//  its own, and a background thread drains the rings in order and writes the
+//  messages with the original SDL output function. Hence logging no longer
+//  blocks the calling thread on the console (or logcat).
+//
+//  The logger can also rate limit a log category, so that chatty subsystems
+//  (such as the network debug messages) cannot flood the log.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_LOGGER_H__
+#define __CU_LOGGER_H__
+#include <cugl/base/CUBase.h>
+#include <atomic>
+
+/** The number of messages in the ring of each thread */
+#define CU_LOG_RING_SIZE        128
+/** The maximum message length (in bytes) held by a ring */
+#define CU_LOG_ENTRY_SIZE       240
+/** The time (in milliseconds) between drains of the background thread */
+#define CU_LOG_DRAIN_INTERVAL   10
+/** The number of log categories that may be rate limited */
+#define CU_LOG_MAX_CATEGORIES   64
+
+namespace cugl {
+
+#pragma mark -
+#pragma mark Logger
+/**
+ * This class is an asynchronous backend for the log macros.
+ *
+ * The log macros (such as {@link CULog}) write through SDL_LogMessage, which
+ * normally writes every message synchronously. After a call to {@link #start},
+ * SDL passes each formatted message to this class instead. The message is
+ * copied into a ring buffer belonging to the calling thread, which takes no
+ * lock, and a background thread writes the messages every
+ * {@link CU_LOG_DRAIN_INTERVAL} milliseconds. Messages are written in the
+ * order that they were logged, even across threads.
+ *
+ * Some messages are still written synchronously, after first writing every
+ * pending message. This is the case for errors and critical messages (so
+ * that they are not lost if the application crashes), messages longer than
+ * {@link CU_LOG_ENTRY_SIZE}, and messages logged while the ring of the thread
+ * is full. Hence the logger never drops a message.
+ *
+ * Any log category may also be rate limited with {@link #setRateLimit}. This
+ * works whether or not the logger is started. Messages over the limit are
+ * discarded, and the number discarded is logged when the limit resets.
+ *
+ * This class is entirely static. All of its methods are thread-safe.
+ */
+class Logger {
+private:
+    /** Whether the background thread is running */
+    static std::atomic<bool> _active;
+
+public:
+#pragma mark Activation
+    /**
+     * Starts the asynchronous logger.
+     *
+     * This replaces the SDL log output function, and starts the background
+     * thread that writes the messages. It does nothing if the logger is
+     * already started.
+     *
+     * @return true if the logger was started
+     */
+    static bool start();
+
+    /**
+     * Stops the asynchronous logger.
+     *
+     * This writes every pending message and stops the background thread.
+     * Messages logged after this method are written synchronously.
+     */
+    static void stop();
+
+    /**
+     * Returns true if the asynchronous logger is active.
+     *
+     * @return true if the asynchronous logger is active.
+     */
+    static bool isActive() {
+        return _active.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Writes every pending message now.
+     *
+     * This method blocks until the messages are written. It is safe to call
+     * whether or not the logger is active.
+     */
+    static void flush();
+
+#pragma mark Rate Limits
+    /**
+     * Limits the number of messages in the given category.
+     *
+     * The category is an SDL log category, such as SDL_LOG_CATEGORY_APPLICATION
+     * or {@link CU_LOG_CATEGORY_NETCODE}. At most count messages are written
+     * every millis milliseconds. A count of 0 removes the limit. Categories of
+     * {@link CU_LOG_MAX_CATEGORIES} or more are ignored.
+     *
+     * Errors and critical messages are never rate limited.
+     *
+     * @param category  The log category
+     * @param count     The number of messages allowed in each period
+     * @param millis    The period length in milliseconds
+     */
+    static void setRateLimit(int category, Uint32 count, Uint32 millis=1000);
+
+    /**
+     * Returns the number of messages discarded by rate limits.
+     *
+     * This is the total over all categories since the application started.
+     *
+     * @return the number of messages discarded by rate limits.
+     */
+    static Uint64 getSuppressed();
+};
+
+}
+
+#endif /* __CU_LOGGER_H__ */
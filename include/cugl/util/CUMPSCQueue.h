@@ -0,0 +1,557 @@
+//
+//  CUMPSCQueue.h
+//  Cornell University Game Library (CUGL)
+//
+//  This header provides a template for a bounded, lock-free queue with many
+//  producers and a single consumer. It is designed for handing data from
+//  background threads (such as network callbacks) to the main thread without
+//  making either side wait on the other.
+//
+//  The queue is a classic sequence-numbered ring buffer. Producers never take
+//  a lock unless the queue is full and the overflow policy is GROW. In that
+//  case the message is spilled to a locked overflow list, and the consumer
+//  grows the ring buffer the next time it empties it.
+//
+//  This is not a class. It is a class template. Templates do not have cpp
+//  files. They only have a header file.  When you include the header, it
+//  compiles the specific template used by your program. Hence all of the code
+//  for this templated class is in this header.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_MPSC_QUEUE_H__
+#define __CU_MPSC_QUEUE_H__
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <cstdint>
+
+namespace cugl {
+
+/**
+ * This enum specifies what a bounded queue does when it is full.
+ */
+enum class OverflowPolicy : int {
+    /** Drop the oldest item in the queue to make room for the new one */
+    DROP_OLDEST = 0,
+    /** Drop the new item, leaving the queue unchanged */
+    DROP_NEWEST = 1,
+    /** Keep all items, growing the queue capacity as necessary */
+    GROW        = 2
+};
+
+#pragma mark -
+#pragma mark MPSCQueue Template
+/**
+ * Template for a bounded, lock-free multi-producer single-consumer queue.
+ *
+ * Any thread may call {@link #push}, but only one thread (typically the main
+ * thread) may call {@link #pop}, {@link #clear}, or {@link #resize}. Items
+ * pushed by the same producer are popped in the order that they were pushed.
+ * There is no ordering guarantee between items from different producers.
+ *
+ * Producers never take a lock on the fast path. If the queue is full, the
+ * behavior depends on the {@link OverflowPolicy}. With DROP_OLDEST, the
+ * producer discards the item at the front of the queue. With DROP_NEWEST,
+ * the producer discards the item it is pushing. With GROW, the item is spilled
+ * to a locked overflow list, and the consumer doubles the capacity the next
+ * time it drains the queue.
+ *
+ * The type T must have a default constructor and a move assignment operator.
+ */
+template <class T>
+class MPSCQueue {
+private:
+    /** A single slot in the ring buffer */
+    class Cell {
+    public:
+        /** The sequence number marking whether this slot is full or empty */
+        std::atomic<size_t> sequence;
+        /** The item stored in this slot */
+        T data;
+    };
+
+    /** The ring buffer slots */
+    std::unique_ptr<Cell[]> _cells;
+    /** The number of slots in the ring buffer */
+    size_t _capacity;
+    /** The next position to write (producers) */
+    std::atomic<size_t> _enqueue;
+    /** The next position to read (consumer) */
+    std::atomic<size_t> _dequeue;
+    /** The number of producers currently writing to the ring buffer */
+    std::atomic<size_t> _inflight;
+    /** The policy to apply when the ring buffer is full */
+    std::atomic<OverflowPolicy> _policy;
+    /** The number of items dropped because of overflow */
+    std::atomic<size_t> _dropped;
+
+    /** Whether producers must currently write to the overflow list */
+    std::atomic<bool> _spilled;
+    /** The lock protecting the overflow list */
+    std::mutex _spillMutex;
+    /** The overflow list (only used with the GROW policy) */
+    std::deque<T> _spill;
+    /** Items reclaimed from the overflow, to be popped first (consumer only) */
+    std::deque<T> _local;
+
+#pragma mark Constructors
+public:
+    /**
+     * Creates a new queue with the given capacity and policy.
+     *
+     * @param capacity  The initial queue capacity
+     * @param policy    The overflow policy
+     */
+    MPSCQueue(size_t capacity=0, OverflowPolicy policy=OverflowPolicy::DROP_OLDEST) :
+    _capacity(0), _enqueue(0), _dequeue(0), _inflight(0), _policy(policy),
+    _dropped(0), _spilled(false) {
+        allocate(capacity);
+    }
+
+    /**
+     * Deletes this queue, releasing all items
+     */
+    ~MPSCQueue() {}
+
+    /** This class cannot be copied */
+    MPSCQueue(const MPSCQueue&) = delete;
+    /** This class cannot be copied */
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+#pragma mark Attributes
+    /**
+     * Returns the capacity of the ring buffer
+     *
+     * This value can increase during {@link #pop} if the policy is GROW.
+     *
+     * @return the capacity of the ring buffer
+     */
+    size_t capacity() const { return _capacity; }
+
+    /**
+     * Returns the overflow policy of this queue
+     *
+     * @return the overflow policy of this queue
+     */
+    OverflowPolicy getPolicy() const { return _policy.load(); }
+
+    /**
+     * Sets the overflow policy of this queue
+     *
+     * This method is safe to call from any thread.
+     *
+     * @param policy    The overflow policy
+     */
+    void setPolicy(OverflowPolicy policy) { _policy.store(policy); }
+
+    /**
+     * Returns the number of items dropped because the queue was full
+     *
+     * @return the number of items dropped because the queue was full
+     */
+    size_t getDropped() const { return _dropped.load(); }
+
+    /**
+     * Returns true if this queue appears empty.
+     *
+     * As producers may be writing concurrently, this value is only a hint.
+     * It should only be called by the consumer.
+     *
+     * @return true if this queue appears empty.
+     */
+    bool empty() const {
+        return _local.empty() && !_spilled.load() && _enqueue.load() == _dequeue.load();
+    }
+
+    /**
+     * Returns the number of items in this queue.
+     *
+     * As producers may be writing concurrently, this value is only approximate.
+     * It should only be called by the consumer.
+     *
+     * @return the number of items in this queue.
+     */
+    size_t size() const {
+        size_t head = _dequeue.load();
+        size_t tail = _enqueue.load();
+        return _local.size() + (tail > head ? tail-head : 0);
+    }
+
+#pragma mark Queue Operations
+    /**
+     * Pushes the item to the back of the queue.
+     *
+     * This method may be called from any thread. It returns false if the item
+     * was dropped because of the overflow policy.
+     *
+     * @param item  The item to push
+     *
+     * @return true if the item was added to the queue.
+     */
+    bool push(T&& item);
+
+    /**
+     * Pops the item at the front of the queue.
+     *
+     * This method may only be called by the consumer thread. It returns false
+     * if the queue is empty, in which case item is unchanged.
+     *
+     * @param item  The item to store the result
+     *
+     * @return true if an item was removed from the queue.
+     */
+    bool pop(T& item);
+
+    /**
+     * Removes all items from the queue.
+     *
+     * This method may only be called by the consumer thread.
+     */
+    void clear();
+
+    /**
+     * Resizes the ring buffer to the given capacity.
+     *
+     * This method may only be called by the consumer thread. Producers spill
+     * to the overflow list while the resize is in progress. If there are more
+     * items than the new capacity, then the overflow policy decides which
+     * items are kept (GROW keeps them all).
+     *
+     * @param capacity  The new queue capacity
+     */
+    void resize(size_t capacity);
+
+private:
+    /**
+     * Allocates an empty ring buffer of the given capacity
+     *
+     * This method is not thread safe and should only be called when there are
+     * no producers writing to the ring buffer.
+     *
+     * @param capacity  The ring buffer capacity
+     */
+    void allocate(size_t capacity);
+
+    /**
+     * Attempts to write the item to the ring buffer.
+     *
+     * The item is only moved if this method succeeds.
+     *
+     * @param item  The item to write
+     *
+     * @return true if the item was written
+     */
+    bool tryPush(T& item);
+
+    /**
+     * Attempts to read an item from the ring buffer.
+     *
+     * @param item  The item to store the result
+     *
+     * @return true if an item was read
+     */
+    bool tryPop(T& item);
+
+    /**
+     * Moves every item in the ring buffer and overflow to the local list.
+     *
+     * This method must be called while holding the overflow lock, and with the
+     * spill flag set, so that no producer writes to the ring buffer afterwards.
+     * It waits for any producer still writing to the ring buffer to finish.
+     */
+    void reclaim();
+};
+
+#pragma mark -
+#pragma mark Method Implementations
+/**
+ * Allocates an empty ring buffer of the given capacity
+ *
+ * This method is not thread safe and should only be called when there are
+ * no producers writing to the ring buffer.
+ *
+ * @param capacity  The ring buffer capacity
+ */
+template <class T>
+void MPSCQueue<T>::allocate(size_t capacity) {
+    _capacity = (capacity == 0 ? 1 : capacity);
+    _cells.reset(new Cell[_capacity]);
+    for (size_t ii = 0; ii < _capacity; ii++) {
+        _cells[ii].sequence.store(ii, std::memory_order_relaxed);
+    }
+    _enqueue.store(0, std::memory_order_relaxed);
+    _dequeue.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * Attempts to write the item to the ring buffer.
+ *
+ * The item is only moved if this method succeeds.
+ *
+ * @param item  The item to write
+ *
+ * @return true if the item was written
+ */
+template <class T>
+bool MPSCQueue<T>::tryPush(T& item) {
+    Cell* cell = nullptr;
+    size_t pos = _enqueue.load(std::memory_order_relaxed);
+    while (true) {
+        cell = &(_cells[pos % _capacity]);
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (_enqueue.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = _enqueue.load(std::memory_order_relaxed);
+        }
+    }
+    cell->data = std::move(item);
+    cell->sequence.store(pos+1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * Attempts to read an item from the ring buffer.
+ *
+ * @param item  The item to store the result
+ *
+ * @return true if an item was read
+ */
+template <class T>
+bool MPSCQueue<T>::tryPop(T& item) {
+    Cell* cell = nullptr;
+    size_t pos = _dequeue.load(std::memory_order_relaxed);
+    while (true) {
+        cell = &(_cells[pos % _capacity]);
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos+1);
+        if (diff == 0) {
+            // Producers may pop too (DROP_OLDEST), so we need a CAS
+            if (_dequeue.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = _dequeue.load(std::memory_order_relaxed);
+        }
+    }
+    item = std::move(cell->data);
+    cell->sequence.store(pos+_capacity, std::memory_order_release);
+    return true;
+}
+
+/**
+ * Moves every item in the ring buffer and overflow to the local list.
+ *
+ * This method must be called while holding the overflow lock, and with the
+ * spill flag set, so that no producer writes to the ring buffer afterwards.
+ * It waits for any producer still writing to the ring buffer to finish.
+ */
+template <class T>
+void MPSCQueue<T>::reclaim() {
+    while (_inflight.load() > 0) {
+        std::this_thread::yield();
+    }
+    T item;
+    while (tryPop(item)) {
+        _local.push_back(std::move(item));
+    }
+    for (auto it = _spill.begin(); it != _spill.end(); ++it) {
+        _local.push_back(std::move(*it));
+    }
+    _spill.clear();
+}
+
+/**
+ * Pushes the item to the back of the queue.
+ *
+ * This method may be called from any thread. It returns false if the item
+ * was dropped because of the overflow policy.
+ *
+ * @param item  The item to push
+ *
+ * @return true if the item was added to the queue.
+ */
+template <class T>
+bool MPSCQueue<T>::push(T&& item) {
+    // Fast path
+    _inflight.fetch_add(1);
+    if (!_spilled.load()) {
+        bool done = tryPush(item);
+        if (!done && _policy.load() == OverflowPolicy::DROP_OLDEST) {
+            T discard;
+            while (!done) {
+                if (tryPop(discard)) {
+                    _dropped.fetch_add(1);
+                }
+                done = tryPush(item);
+            }
+        }
+        if (done) {
+            _inflight.fetch_sub(1);
+            return true;
+        }
+    }
+    _inflight.fetch_sub(1);
+
+    // Slow path
+    std::lock_guard<std::mutex> lock(_spillMutex);
+    if (!_spilled.load()) {
+        if (tryPush(item)) {
+            return true;
+        }
+        switch (_policy.load()) {
+            case OverflowPolicy::DROP_NEWEST:
+                _dropped.fetch_add(1);
+                return false;
+            case OverflowPolicy::DROP_OLDEST:
+            {
+                T discard;
+                while (!tryPush(item)) {
+                    if (tryPop(discard)) {
+                        _dropped.fetch_add(1);
+                    }
+                }
+                return true;
+            }
+            case OverflowPolicy::GROW:
+                break;
+        }
+    }
+    _spill.push_back(std::move(item));
+    _spilled.store(true);
+    return true;
+}
+
+/**
+ * Pops the item at the front of the queue.
+ *
+ * This method may only be called by the consumer thread. It returns false
+ * if the queue is empty, in which case item is unchanged.
+ *
+ * @param item  The item to store the result
+ *
+ * @return true if an item was removed from the queue.
+ */
+template <class T>
+bool MPSCQueue<T>::pop(T& item) {
+    // Reclaimed items are always older than those in the ring buffer
+    if (_local.empty()) {
+        if (tryPop(item)) {
+            return true;
+        } else if (!_spilled.load()) {
+            return false;
+        }
+
+        // The ring buffer overflowed. Reclaim everything and grow.
+        std::lock_guard<std::mutex> lock(_spillMutex);
+        size_t needed = _capacity+_spill.size();
+        reclaim();
+        size_t capacity = _capacity;
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        allocate(capacity);
+        _spilled.store(false);
+        if (_local.empty()) {
+            return false;
+        }
+    }
+
+    item = std::move(_local.front());
+    _local.pop_front();
+    return true;
+}
+
+/**
+ * Removes all items from the queue.
+ *
+ * This method may only be called by the consumer thread.
+ */
+template <class T>
+void MPSCQueue<T>::clear() {
+    std::lock_guard<std::mutex> lock(_spillMutex);
+    _spilled.store(true);
+    reclaim();
+    _local.clear();
+    _spilled.store(false);
+}
+
+/**
+ * Resizes the ring buffer to the given capacity.
+ *
+ * This method may only be called by the consumer thread. Producers spill
+ * to the overflow list while the resize is in progress. If there are more
+ * items than the new capacity, then the overflow policy decides which
+ * items are kept (GROW keeps them all).
+ *
+ * @param capacity  The new queue capacity
+ */
+template <class T>
+void MPSCQueue<T>::resize(size_t capacity) {
+    std::lock_guard<std::mutex> lock(_spillMutex);
+    _spilled.store(true);
+    reclaim();
+    capacity = (capacity == 0 ? 1 : capacity);
+    switch (_policy.load()) {
+        case OverflowPolicy::DROP_OLDEST:
+            while (_local.size() > capacity) {
+                _local.pop_front();
+                _dropped.fetch_add(1);
+            }
+            break;
+        case OverflowPolicy::DROP_NEWEST:
+            while (_local.size() > capacity) {
+                _local.pop_back();
+                _dropped.fetch_add(1);
+            }
+            break;
+        case OverflowPolicy::GROW:
+            while (capacity < _local.size()) {
+                capacity *= 2;
+            }
+            break;
+    }
+    allocate(capacity);
+    // Put the items back into the ring buffer
+    T item;
+    while (!_local.empty()) {
+        item = std::move(_local.front());
+        _local.pop_front();
+        tryPush(item);
+    }
+    _spilled.store(false);
+}
+
+}
+
+#endif /* __CU_MPSC_QUEUE_H__ */
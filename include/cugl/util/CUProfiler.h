@@ -0,0 +1,405 @@
+//
+//  CUProfiler.h
+//  Cornell University Game Library (CUGL)
+//
+//  This header provides a lightweight hierarchical profiler. Code is timed
+//  with scoped macros, which record a begin and end time (in nanoseconds)
+//  to a buffer local to the current thread. Nested scopes form a hierarchy
+//  per thread. A capture can be exported as a Chrome trace (JSON), which can
+//  be viewed in chrome://tracing or https://ui.perfetto.dev.
+//
+//  The macros compile to nothing when CU_PROFILE_ENABLED is 0, which is the
+//  default for release (NDEBUG) builds. Even when compiled in, a scope costs
+//  a single atomic load unless a capture is active.
+//
+//  A scope may be annotated with the bytes it processed, the time it spent
+//  waiting, and a detail string (such as an asset name). A capture can also
+//  be summarized as a plain text report, which is how the startup timeline
+//  of Application is presented.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#ifndef __CU_PROFILER_H__
+#define __CU_PROFILER_H__
+#include <cugl/base/CUBase.h>
+#include <atomic>
+#include <string>
+
+/**
+ * Whether the profiling macros are compiled in.
+ *
+ * By default, profiling is removed from release (NDEBUG) builds. Define this
+ * as 0 or 1 to override the default.
+ */
+#ifndef CU_PROFILE_ENABLED
+    #if defined (NDEBUG)
+        #define CU_PROFILE_ENABLED 0
+    #else
+        #define CU_PROFILE_ENABLED 1
+    #endif
+#endif
+
+/** The maximum number of events recorded per thread in a single capture */
+#define CU_PROFILE_CAPACITY 262144
+/** The default minimum duration (in nanoseconds) of a report timeline event */
+#define CU_PROFILE_REPORT_MIN   100000
+
+namespace cugl {
+
+/** Forward reference to a profile scope */
+class ProfileScope;
+
+#pragma mark -
+#pragma mark Profiler
+/**
+ * This class is a hierarchical profiler for timing engine phases.
+ *
+ * Code is timed with the macros {@link CU_PROFILE_SCOPE} and
+ * {@link CU_PROFILE_FUNCTION}, which time the enclosing block. Each thread
+ * records to a buffer of its own, so threads never contend when recording.
+ * Nested scopes on the same thread form a hierarchy, which is visible when
+ * the capture is exported.
+ *
+ * Nothing is recorded until a capture is started with {@link #start}. A
+ * capture ends with {@link #stop}, and can then be exported with {@link #save}
+ * or {@link #getTrace}. The export format is the Chrome trace event format,
+ * which can be viewed in chrome://tracing or in Perfetto.
+ *
+ * The innermost open scope on a thread may be annotated with the macros
+ * {@link CU_PROFILE_BYTES}, {@link CU_PROFILE_WAIT} and
+ * {@link CU_PROFILE_DETAIL}. These appear as arguments of the event in the
+ * trace, and as columns of the report (see {@link #getReport}).
+ *
+ * This class is entirely static. All of its methods are thread-safe. Scope
+ * names must be string literals (or otherwise outlive the capture), as the
+ * profiler only stores the pointer. Details are copied.
+ */
+class Profiler {
+private:
+    /** Whether a capture is active */
+    static std::atomic<bool> _active;
+
+    /**
+     * Opens the given scope on the current thread.
+     *
+     * The scope becomes the target of any annotations until it is closed.
+     *
+     * @param scope The scope to open
+     */
+    static void enter(ProfileScope* scope);
+
+    /**
+     * Closes the given scope on the current thread, recording its event.
+     *
+     * The scope must be the innermost open scope on this thread.
+     *
+     * @param scope The scope to close
+     */
+    static void leave(ProfileScope* scope);
+
+    /** Allow scopes to open and close themselves */
+    friend class ProfileScope;
+
+public:
+#pragma mark Capture
+    /**
+     * Starts a new capture.
+     *
+     * This discards all events from any previous capture. Timestamps in the
+     * new capture are relative to the moment that this method is called.
+     */
+    static void start();
+
+    /**
+     * Stops the current capture.
+     *
+     * The events are retained until the next call to {@link #start} or
+     * {@link #clear}. Any scope still open on another thread when this
+     * method is called is dropped.
+     */
+    static void stop();
+
+    /**
+     * Discards all recorded events.
+     *
+     * This does not stop an active capture.
+     */
+    static void clear();
+
+    /**
+     * Returns true if a capture is active.
+     *
+     * @return true if a capture is active.
+     */
+    static bool isActive() {
+        return _active.load(std::memory_order_relaxed);
+    }
+
+#pragma mark Recording
+    /**
+     * Returns the time since the start of the capture in nanoseconds.
+     *
+     * @return the time since the start of the capture in nanoseconds.
+     */
+    static Uint64 now();
+
+    /**
+     * Records a completed event for the current thread.
+     *
+     * The times should be values returned by {@link #now}. An event is
+     * dropped if there is no active capture, or if the thread has exceeded
+     * {@link CU_PROFILE_CAPACITY} events.
+     *
+     * @param name  The event name (which must outlive the capture)
+     * @param begin The event start time in nanoseconds
+     * @param end   The event end time in nanoseconds
+     */
+    static void record(const char* name, Uint64 begin, Uint64 end);
+
+    /**
+     * Sets the display name of the current thread.
+     *
+     * This name is used to label the thread in the exported trace. Threads
+     * without a name are labeled by their index.
+     *
+     * @param name  The thread name
+     */
+    static void setThreadName(const std::string name);
+
+#pragma mark Annotation
+    /**
+     * Adds the given number of bytes to the innermost open scope.
+     *
+     * This is the amount of data processed by the scope, such as the size of
+     * a file or of a texture upload. It does nothing if there is no open
+     * scope on this thread, or if there is no active capture.
+     *
+     * @param bytes The number of bytes processed
+     */
+    static void addBytes(Uint64 bytes);
+
+    /**
+     * Adds the given wait time to the innermost open scope.
+     *
+     * This is the time that the work of the scope spent blocked or queued,
+     * such as an asset waiting for the main thread. It need not overlap the
+     * scope itself. It does nothing if there is no open scope on this
+     * thread, or if there is no active capture.
+     *
+     * @param nanos The wait time in nanoseconds
+     */
+    static void addWait(Uint64 nanos);
+
+    /**
+     * Sets the detail string of the innermost open scope.
+     *
+     * The detail distinguishes events with the same name, such as the file
+     * of an asset load. Unlike the scope name, it is copied. It does nothing
+     * if there is no open scope on this thread, or if there is no active
+     * capture.
+     *
+     * @param detail    The detail string
+     */
+    static void setDetail(const std::string& detail);
+
+#pragma mark Export
+    /**
+     * Returns the number of events recorded in the current capture.
+     *
+     * @return the number of events recorded in the current capture.
+     */
+    static size_t getEventCount();
+
+    /**
+     * Returns the number of events dropped from the current capture.
+     *
+     * Events are dropped when a thread exceeds {@link CU_PROFILE_CAPACITY}
+     * events in a single capture.
+     *
+     * @return the number of events dropped from the current capture.
+     */
+    static size_t getDroppedCount();
+
+    /**
+     * Returns the current capture as a Chrome trace.
+     *
+     * The result is a JSON string in the Chrome trace event format. It can
+     * be loaded in chrome://tracing or https://ui.perfetto.dev. This method
+     * may be called during a capture, but it is best called after
+     * {@link #stop}.
+     *
+     * @return the current capture as a Chrome trace.
+     */
+    static std::string getTrace();
+
+    /**
+     * Returns a plain text report of the current capture.
+     *
+     * The report has two parts. The timeline lists every event at least as
+     * long as the given threshold, in order of start time. Each line has the
+     * start time, the duration, the wait time, the bytes, the thread, and
+     * the event name (indented by its depth in the hierarchy of its thread)
+     * followed by any detail. The summary aggregates the events by name,
+     * ordered by total time, with the number of threads that recorded them.
+     *
+     * Times are in milliseconds. This method may be called during a capture,
+     * but it is best called after {@link #stop}.
+     *
+     * @param threshold The minimum duration of a timeline event in nanoseconds
+     *
+     * @return a plain text report of the current capture.
+     */
+    static std::string getReport(Uint64 threshold=CU_PROFILE_REPORT_MIN);
+
+    /**
+     * Saves the current capture as a Chrome trace to the given file.
+     *
+     * See {@link #getTrace} for the file format. If the path is relative,
+     * it is relative to the save directory of the application.
+     *
+     * @param path  The file to write to
+     *
+     * @return true if the capture was successfully saved.
+     */
+    static bool save(const std::string path);
+};
+
+#pragma mark -
+#pragma mark Profile Scope
+/**
+ * This class times the lifetime of a scope for {@link Profiler}.
+ *
+ * This class is meant to be created on the stack, typically by the macro
+ * {@link CU_PROFILE_SCOPE}. It records an event when it is destroyed. If no
+ * capture is active when it is created, it does nothing.
+ */
+class ProfileScope {
+private:
+    /** The event name */
+    const char* _name;
+    /** The start time of this scope */
+    Uint64 _begin;
+    /** The bytes processed by this scope */
+    Uint64 _bytes;
+    /** The time this scope spent waiting (in nanoseconds) */
+    Uint64 _wait;
+    /** The detail of this scope (an index into the thread details, plus 1) */
+    Uint32 _detail;
+    /** The enclosing open scope on this thread */
+    ProfileScope* _parent;
+    /** Whether a capture was active when this scope began */
+    bool _active;
+
+    /** Allow the profiler to annotate this scope */
+    friend class Profiler;
+
+public:
+    /**
+     * Creates a scope with the given name, starting now.
+     *
+     * @param name  The event name (which must outlive the capture)
+     */
+    ProfileScope(const char* name) : _name(name), _begin(0), _bytes(0), _wait(0),
+    _detail(0), _parent(nullptr) {
+        _active = Profiler::isActive();
+        if (_active) {
+            Profiler::enter(this);
+            _begin = Profiler::now();
+        }
+    }
+
+    /**
+     * Destroys this scope, recording its event.
+     */
+    ~ProfileScope() {
+        if (_active) {
+            Profiler::leave(this);
+        }
+    }
+
+private:
+    /** This class cannot be copied */
+    CU_DISALLOW_COPY_AND_ASSIGN(ProfileScope);
+};
+
+}
+
+#pragma mark -
+#pragma mark Profiling Macros
+
+/** Helper to concatenate tokens after expansion */
+#define __cu_profile_concat__(a,b)  a##b
+/** Helper to generate a unique variable name per line */
+#define __cu_profile_name__(a,b)    __cu_profile_concat__(a,b)
+
+#if CU_PROFILE_ENABLED
+/**
+ * Times the enclosing scope under the given name
+ *
+ * The name must be a string literal. This macro compiles to nothing if
+ * CU_PROFILE_ENABLED is 0.
+ */
+#define CU_PROFILE_SCOPE(name)  cugl::ProfileScope __cu_profile_name__(__cu_profile_scope__,__LINE__)(name)
+
+/**
+ * Times the enclosing function
+ *
+ * This macro compiles to nothing if CU_PROFILE_ENABLED is 0.
+ */
+#define CU_PROFILE_FUNCTION()   CU_PROFILE_SCOPE(__func__)
+
+/**
+ * Adds the given number of bytes to the innermost open scope
+ *
+ * The argument is not evaluated unless a capture is active. This macro
+ * compiles to nothing if CU_PROFILE_ENABLED is 0.
+ */
+#define CU_PROFILE_BYTES(bytes) \
+    do { if (cugl::Profiler::isActive()) { cugl::Profiler::addBytes(bytes); } } while(0)
+
+/**
+ * Adds the given wait time (in nanoseconds) to the innermost open scope
+ *
+ * The argument is not evaluated unless a capture is active. This macro
+ * compiles to nothing if CU_PROFILE_ENABLED is 0.
+ */
+#define CU_PROFILE_WAIT(nanos)  \
+    do { if (cugl::Profiler::isActive()) { cugl::Profiler::addWait(nanos); } } while(0)
+
+/**
+ * Sets the detail string of the innermost open scope
+ *
+ * The argument is not evaluated unless a capture is active. This macro
+ * compiles to nothing if CU_PROFILE_ENABLED is 0.
+ */
+#define CU_PROFILE_DETAIL(detail)   \
+    do { if (cugl::Profiler::isActive()) { cugl::Profiler::setDetail(detail); } } while(0)
+#else
+#define CU_PROFILE_SCOPE(name)      do {} while(0)
+#define CU_PROFILE_FUNCTION()       do {} while(0)
+#define CU_PROFILE_BYTES(bytes)     do {} while(0)
+#define CU_PROFILE_WAIT(nanos)      do {} while(0)
+#define CU_PROFILE_DETAIL(detail)   do {} while(0)
+#endif
+
+#endif /* __CU_PROFILER_H__ */
@@ -129,7 +129,8 @@ namespace cugl {
      *
      * This function differs from std::to_string(float) in that it allows us
      * to specify a precision (the number of digits to display after the decimal
-     * point).  If precision is negative, then maximum precision will be used.
+     * point).  If precision is negative, this is the shortest string that
+     * converts back to the same value.
      *
      * @param  value        the numeric value to convert
      * @param  precision    the number of digits to display after the decimal
@@ -143,7 +144,8 @@ namespace cugl {
      *
      * This function differs from std::to_string(double) in that it allows us
      * to specify a precision (the number of digits to display after the decimal
-     * point).  If precision is negative, then maximum precision will be used.
+     * point).  If precision is negative, this is the shortest string that
+     * converts back to the same value.
      *
      * @param  value        the numeric value to convert
      * @param  precision    the number of digits to display after the decimal
@@ -166,6 +168,206 @@ namespace cugl {
      */
     std::string to_hexstring(Uint32 value, size_t len=0);
 
+#pragma mark -
+#pragma mark BUFFER FUNCTIONS
+    /**
+     * Writes the given signed 32 bit integer to a character buffer
+     *
+     * This function is locale-independent and does not allocate memory. The
+     * result is not null-terminated. If the buffer is too small, this function
+     * returns 0 and the contents of the buffer are unspecified.
+     *
+     * @param  value    the numeric value to convert
+     * @param  buffer   the buffer to store the characters
+     * @param  size     the size of the buffer
+     *
+     * @return the number of characters written
+     */
+    size_t to_chars(Sint32 value, char* buffer, size_t size);
+
+    /**
+     * Writes the given unsigned 32 bit integer to a character buffer
+     *
+     * This function is locale-independent and does not allocate memory. The
+     * result is not null-terminated. If the buffer is too small, this function
+     * returns 0 and the contents of the buffer are unspecified.
+     *
+     * @param  value    the numeric value to convert
+     * @param  buffer   the buffer to store the characters
+     * @param  size     the size of the buffer
+     *
+     * @return the number of characters written
+     */
+    size_t to_chars(Uint32 value, char* buffer, size_t size);
+
+    /**
+     * Writes the given signed 64 bit integer to a character buffer
+     *
+     * This function is locale-independent and does not allocate memory. The
+     * result is not null-terminated. If the buffer is too small, this function
+     * returns 0 and the contents of the buffer are unspecified.
+     *
+     * @param  value    the numeric value to convert
+     * @param  buffer   the buffer to store the characters
+     * @param  size     the size of the buffer
+     *
+     * @return the number of characters written
+     */
+    size_t to_chars(Sint64 value, char* buffer, size_t size);
+
+    /**
+     * Writes the given unsigned 64 bit integer to a character buffer
+     *
+     * This function is locale-independent and does not allocate memory. The
+     * result is not null-terminated. If the buffer is too small, this function
+     * returns 0 and the contents of the buffer are unspecified.
+     *
+     * @param  value    the numeric value to convert
+     * @param  buffer   the buffer to store the characters
+     * @param  size     the size of the buffer
+     *
+     * @return the number of characters written
+     */
+    size_t to_chars(Uint64 value, char* buffer, size_t size);
+
+    /**
+     * Writes the given float value to a character buffer
+     *
+     * The value is written in fixed point notation, with the given number of
+     * digits after the decimal point. If precision is negative, this is the
+     * shortest string that converts back to the same value.
+     *
+     * This function is locale-independent and does not allocate memory. The
+     * result is not null-terminated. If the buffer is too small, this function
+     * returns 0 and the contents of the buffer are unspecified.
+     *
+     * @param  value        the numeric value to convert
+     * @param  buffer       the buffer to store the characters
+     * @param  size         the size of the buffer
+     * @param  precision    the number of digits to display after the decimal
+     *
+     * @return the number of characters written
+     */
+    size_t to_chars(float value, char* buffer, size_t size, int precision=-1);
+
+    /**
+     * Writes the given double value to a character buffer
+     *
+     * The value is written in fixed point notation, with the given number of
+     * digits after the decimal point. If precision is negative, this is the
+     * shortest string that converts back to the same value.
+     *
+     * This function is locale-independent and does not allocate memory. The
+     * result is not null-terminated. If the buffer is too small, this function
+     * returns 0 and the contents of the buffer are unspecified.
+     *
+     * @param  value        the numeric value to convert
+     * @param  buffer       the buffer to store the characters
+     * @param  size         the size of the buffer
+     * @param  precision    the number of digits to display after the decimal
+     *
+     * @return the number of characters written
+     */
+    size_t to_chars(double value, char* buffer, size_t size, int precision=-1);
+
+    /**
+     * Reads a signed 32 bit integer from a character buffer
+     *
+     * Unlike {@link stos32}, this function does not skip whitespace, and it
+     * does not accept a leading '+' or a base prefix. It is locale-independent
+     * and does not allocate memory. If the number is out of range, the result
+     * is clamped to the range of the type.
+     *
+     * @param  buffer   the characters to read
+     * @param  size     the number of characters in the buffer
+     * @param  value    the variable to store the result
+     * @param  base     the number base
+     *
+     * @return the number of characters read (0 if there is no number)
+     */
+    size_t from_chars(const char* buffer, size_t size, Sint32& value, int base=10);
+
+    /**
+     * Reads an unsigned 32 bit integer from a character buffer
+     *
+     * Unlike {@link stou32}, this function does not skip whitespace, and it
+     * does not accept a leading '+' or a base prefix. It is locale-independent
+     * and does not allocate memory. If the number is out of range, the result
+     * is clamped to the range of the type.
+     *
+     * @param  buffer   the characters to read
+     * @param  size     the number of characters in the buffer
+     * @param  value    the variable to store the result
+     * @param  base     the number base
+     *
+     * @return the number of characters read (0 if there is no number)
+     */
+    size_t from_chars(const char* buffer, size_t size, Uint32& value, int base=10);
+
+    /**
+     * Reads a signed 64 bit integer from a character buffer
+     *
+     * Unlike {@link stos64}, this function does not skip whitespace, and it
+     * does not accept a leading '+' or a base prefix. It is locale-independent
+     * and does not allocate memory. If the number is out of range, the result
+     * is clamped to the range of the type.
+     *
+     * @param  buffer   the characters to read
+     * @param  size     the number of characters in the buffer
+     * @param  value    the variable to store the result
+     * @param  base     the number base
+     *
+     * @return the number of characters read (0 if there is no number)
+     */
+    size_t from_chars(const char* buffer, size_t size, Sint64& value, int base=10);
+
+    /**
+     * Reads an unsigned 64 bit integer from a character buffer
+     *
+     * Unlike {@link stou64}, this function does not skip whitespace, and it
+     * does not accept a leading '+' or a base prefix. It is locale-independent
+     * and does not allocate memory. If the number is out of range, the result
+     * is clamped to the range of the type.
+     *
+     * @param  buffer   the characters to read
+     * @param  size     the number of characters in the buffer
+     * @param  value    the variable to store the result
+     * @param  base     the number base
+     *
+     * @return the number of characters read (0 if there is no number)
+     */
+    size_t from_chars(const char* buffer, size_t size, Uint64& value, int base=10);
+
+    /**
+     * Reads a float from a character buffer
+     *
+     * Unlike {@link stof}, this function does not skip whitespace, and it does
+     * not accept a leading '+'. It is locale-independent and does not allocate
+     * memory (on platforms with floating point support for std::from_chars).
+     *
+     * @param  buffer   the characters to read
+     * @param  size     the number of characters in the buffer
+     * @param  value    the variable to store the result
+     *
+     * @return the number of characters read (0 if there is no number)
+     */
+    size_t from_chars(const char* buffer, size_t size, float& value);
+
+    /**
+     * Reads a double from a character buffer
+     *
+     * Unlike {@link stod}, this function does not skip whitespace, and it does
+     * not accept a leading '+'. It is locale-independent and does not allocate
+     * memory (on platforms with floating point support for std::from_chars).
+     *
+     * @param  buffer   the characters to read
+     * @param  size     the number of characters in the buffer
+     * @param  value    the variable to store the result
+     *
+     * @return the number of characters read (0 if there is no number)
+     */
+    size_t from_chars(const char* buffer, size_t size, double& value);
+
 #pragma mark -
 #pragma mark ARRAY TO STRING FUNCTIONS
     /**
@@ -266,7 +468,7 @@ namespace cugl {
      *
      * As with to_string(float), this function allows us to specify a precision
      * (the number of digits to display after the decimal point).  If precision is
-     * negative, then maximum precision will be used.
+     * negative, each value is the shortest string that converts back to it.
      *
      * @param array     the array to convert
      * @param length    the array length
@@ -284,7 +486,7 @@ namespace cugl {
      *
      * As with to_string(double), this function allows us to specify a precision
      * (the number of digits to display after the decimal point).  If precision is
-     * negative, then maximum precision will be used.
+     * negative, each value is the shortest string that converts back to it.
      *
      * @param array     the array to convert
      * @param length    the array length
@@ -306,13 +508,16 @@ namespace cugl {
      * as possible to form a valid base-n (where n=base) integer number representation
      * and converts them to an integer value.
      *
+     * If no conversion can be performed, this function returns 0 (and stores
+     * 0 in pos). It never throws an exception.
+     *
      * @param  str  the string to convert
      * @param  pos  address of an integer to store the number of characters processed
      * @param  base the number base
      *
      * @return the byte equivalent to the given string
      */
-    Uint8 stou8(const std::string str, std::size_t* pos = 0, int base = 10);
+    Uint8 stou8(const std::string& str, std::size_t* pos = 0, int base = 10);
     
     /**
      * Returns the signed 16 bit integer equivalent to the given string
@@ -322,13 +527,16 @@ namespace cugl {
      * as possible to form a valid base-n (where n=base) integer number representation
      * and converts them to a long value.
      *
+     * If no conversion can be performed, this function returns 0 (and stores
+     * 0 in pos). It never throws an exception.
+     *
      * @param  str  the string to convert
      * @param  pos  address of an integer to store the number of characters processed
      * @param  base the number base
      *
      * @return the signed 16 bit integer equivalent to the given string
      */
-    Sint16 stos16(const std::string str, std::size_t* pos = 0, int base = 10);
+    Sint16 stos16(const std::string& str, std::size_t* pos = 0, int base = 10);
     
     /**
      * Returns the unsigned 16 bit integer equivalent to the given string
@@ -338,13 +546,16 @@ namespace cugl {
      * as possible to form a valid base-n (where n=base) integer number representation
      * and converts them to a long value.
      *
+     * If no conversion can be performed, this function returns 0 (and stores
+     * 0 in pos). It never throws an exception.
+     *
      * @param  str  the string to convert
      * @param  pos  address of an integer to store the number of characters processed
      * @param  base the number base
      *
      * @return the unsigned 16 bit integer equivalent to the given string
      */
-    Uint16 stou16(const std::string str, std::size_t* pos = 0, int base = 10);
+    Uint16 stou16(const std::string& str, std::size_t* pos = 0, int base = 10);
     
     /**
      * Returns the signed 32 bit integer equivalent to the given string
@@ -354,13 +565,16 @@ namespace cugl {
      * as possible to form a valid base-n (where n=base) integer number representation
      * and converts them to a long value.
      *
+     * If no conversion can be performed, this function returns 0 (and stores
+     * 0 in pos). It never throws an exception.
+     *
      * @param  str  the string to convert
      * @param  pos  address of an integer to store the number of characters processed
      * @param  base the number base
      *
      * @return the signed 32 bit integer equivalent to the given string
      */
-    Sint32 stos32(const std::string str, std::size_t* pos = 0, int base = 10);
+    Sint32 stos32(const std::string& str, std::size_t* pos = 0, int base = 10);
     
     /**
      * Returns the unsigned 32 bit integer equivalent to the given string
@@ -370,13 +584,16 @@ namespace cugl {
      * as possible to form a valid base-n (where n=base) integer number representation
      * and converts them to a long value.
      *
+     * If no conversion can be performed, this function returns 0 (and stores
+     * 0 in pos). It never throws an exception.
+     *
      * @param  str  the string to convert
      * @param  pos  address of an integer to store the number of characters processed
      * @param  base the number base
      *
      * @return the unsigned 32 bit integer equivalent to the given string
      */
-    Uint32 stou32(const std::string str, std::size_t* pos = 0, int base = 10);
+    Uint32 stou32(const std::string& str, std::size_t* pos = 0, int base = 10);
     
     /**
      * Returns the signed 64 bit integer equivalent to the given string
@@ -386,13 +603,16 @@ namespace cugl {
      * as possible to form a valid base-n (where n=base) integer number representation
      * and converts them to a long value.
      *
+     * If no conversion can be performed, this function returns 0 (and stores
+     * 0 in pos). It never throws an exception.
+     *
      * @param  str  the string to convert
      * @param  pos  address of an integer to store the number of characters processed
      * @param  base the number base
      *
      * @return the signed 64 bit integer equivalent to the given string
      */
-    Sint64 stos64(const std::string str, std::size_t* pos = 0, int base = 10);
+    Sint64 stos64(const std::string& str, std::size_t* pos = 0, int base = 10);
     
     /**
      * Returns the unsigned 64 bit integer equivalent to the given string
@@ -402,13 +622,16 @@ namespace cugl {
      * as possible to form a valid base-n (where n=base) integer number representation
      * and converts them to a long value.
      *
+     * If no conversion can be performed, this function returns 0 (and stores
+     * 0 in pos). It never throws an exception.
+     *
      * @param  str  the string to convert
      * @param  pos  address of an integer to store the number of characters processed
      * @param  base the number base
      *
      * @return the unsigned 64 bit integer equivalent to the given string
      */
-    Uint64 stou64(const std::string str, std::size_t* pos = 0, int base = 10);
+    Uint64 stou64(const std::string& str, std::size_t* pos = 0, int base = 10);
     
     /**
      * Returns the float equivalent to the given string
@@ -418,12 +641,15 @@ namespace cugl {
      * possible to form a valid floating point representation and converts them to a floating
      * point value.
      *
+     * If no conversion can be performed, this function returns 0 (and stores
+     * 0 in pos). It never throws an exception.
+     *
      * @param  str  the string to convert
      * @param  pos  address of an integer to store the number of characters processed
      *
      * @return the float equivalent to the given string
      */
-    float stof(const std::string str, std::size_t* pos = 0);
+    float stof(const std::string& str, std::size_t* pos = 0);
     
     /**
      * Returns the double equivalent to the given string
@@ -433,12 +659,15 @@ namespace cugl {
      * possible to form a valid floating point representation and converts them to a floating
      * point value.
      *
+     * If no conversion can be performed, this function returns 0 (and stores
+     * 0 in pos). It never throws an exception.
+     *
      * @param  str  the string to convert
      * @param  pos  address of an integer to store the number of characters processed
      *
      * @return the double equivalent to the given string
      */
-    double stod(const std::string str, std::size_t* pos = 0);
+    double stod(const std::string& str, std::size_t* pos = 0);
 
     
 #pragma mark -
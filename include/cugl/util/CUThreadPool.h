@@ -6,6 +6,11 @@
 //  task is specified by a void function.  There are no guarantees about thread
 //  safety; that is responsibility of the author of each task.
 //
+//  Each worker has its own task queue, and an idle worker steals from the
+//  queues of the other workers. So submitting a task only locks a single
+//  queue. Tasks are stored without std::function, so that small tasks do not
+//  allocate any memory.
+//
 //  This code is largely inspired from the Cocos2d file AudioEngine.cpp, from
 //  the code for asynchronous asset loading. We generalized that class added
 //  some notable safety changes.
@@ -30,7 +35,7 @@
 //      3. This notice may not be removed or altered from any source distribution.
 //
 //  Author: Walker White
-//  Version: 11/29/16
+//  Version: 10/14/26
 //
 #ifndef __CU_THREAD_POOL_H__
 #define __CU_THREAD_POOL_H__
@@ -38,7 +43,12 @@
 #include <condition_variable>
 #include <functional>
 #include <stdio.h>
-#include <queue>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <type_traits>
 #include <vector>
 #include <thread>
 
@@ -47,17 +57,264 @@
     #define CU_SDL_THREADS 1
 #endif
 
+/** The number of bytes a task may capture before it is allocated on the heap */
+#define CU_TASK_STORAGE 56
+
 namespace cugl {
 
+#pragma mark -
+#pragma mark Task
+
+/**
+ * This class is a void function with no parameters, for use in a thread pool.
+ *
+ * This class is a replacement for std::function that is move-only, and which
+ * stores small functions (those that capture no more than CU_TASK_STORAGE
+ * bytes) inline. So creating and moving a small task never allocates memory.
+ * Larger functions are allocated on the heap, just as with std::function.
+ *
+ * A task may be created implicitly from any function object, including a
+ * lambda expression or a std::function.
+ */
+class Task {
+private:
+    /** The operations for a stored function type */
+    struct Ops {
+        /** Calls the function stored at the given address */
+        void (*invoke)(void* data);
+        /** Moves the function at src to dst, destroying the original */
+        void (*move)(void* dst, void* src);
+        /** Destroys the function stored at the given address */
+        void (*destroy)(void* data);
+    };
+    
+    /** The operations for a function stored inline */
+    template<typename F>
+    struct InlineOps {
+        static void invoke(void* data) { (*static_cast<F*>(data))(); }
+        static void move(void* dst, void* src) {
+            new (dst) F(std::move(*static_cast<F*>(src)));
+            static_cast<F*>(src)->~F();
+        }
+        static void destroy(void* data) { static_cast<F*>(data)->~F(); }
+        static constexpr Ops table = { &invoke, &move, &destroy };
+    };
+    
+    /** The operations for a function stored on the heap */
+    template<typename F>
+    struct HeapOps {
+        static void invoke(void* data) { (**static_cast<F**>(data))(); }
+        static void move(void* dst, void* src) {
+            *static_cast<F**>(dst) = *static_cast<F**>(src);
+        }
+        static void destroy(void* data) { delete *static_cast<F**>(data); }
+        static constexpr Ops table = { &invoke, &move, &destroy };
+    };
+    
+    /** The storage for the function (or a pointer to the function) */
+    alignas(std::max_align_t) unsigned char _data[CU_TASK_STORAGE];
+    /** The operations for the stored function (nullptr if empty) */
+    const Ops* _ops;
+    
+public:
+    /**
+     * Creates an empty task.
+     *
+     * An empty task may not be called.
+     */
+    Task() : _ops(nullptr) {}
+    
+    /**
+     * Creates a task for the given function.
+     *
+     * The function is stored inline if it is small enough, and can be moved
+     * without exceptions. Otherwise it is allocated on the heap.
+     *
+     * @param func  The function to call
+     */
+    template<typename F, typename = typename std::enable_if<
+        !std::is_same<typename std::decay<F>::type,Task>::value>::type>
+    Task(F&& func) {
+        typedef typename std::decay<F>::type Func;
+        if constexpr (sizeof(Func) <= CU_TASK_STORAGE && alignof(Func) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible<Func>::value) {
+            new (_data) Func(std::forward<F>(func));
+            _ops = &InlineOps<Func>::table;
+        } else {
+            *reinterpret_cast<Func**>(_data) = new Func(std::forward<F>(func));
+            _ops = &HeapOps<Func>::table;
+        }
+    }
+    
+    /**
+     * Creates a task with the resources of the original.
+     *
+     * The original task will be empty.
+     *
+     * @param task  The task to move
+     */
+    Task(Task&& task) noexcept : _ops(task._ops) {
+        if (_ops) {
+            _ops->move(_data,task._data);
+            task._ops = nullptr;
+        }
+    }
+    
+    /**
+     * Deletes this task, destroying the stored function.
+     */
+    ~Task() { clear(); }
+    
+    /**
+     * Assigns this task the resources of the original.
+     *
+     * The original task will be empty.
+     *
+     * @param task  The task to move
+     *
+     * @return a reference to this task for chaining
+     */
+    Task& operator=(Task&& task) noexcept {
+        if (this != &task) {
+            clear();
+            _ops = task._ops;
+            if (_ops) {
+                _ops->move(_data,task._data);
+                task._ops = nullptr;
+            }
+        }
+        return *this;
+    }
+    
+    /**
+     * Destroys the stored function, making this task empty.
+     */
+    void clear() {
+        if (_ops) {
+            _ops->destroy(_data);
+            _ops = nullptr;
+        }
+    }
+    
+    /**
+     * Returns true if this task has a function to call.
+     *
+     * @return true if this task has a function to call.
+     */
+    explicit operator bool() const { return _ops != nullptr; }
+    
+    /**
+     * Calls the stored function.
+     *
+     * The task must not be empty.
+     */
+    void operator()() { _ops->invoke(_data); }
+    
+private:
+    /** Tasks may only be moved */
+    CU_DISALLOW_COPY_AND_ASSIGN(Task);
+};
+
+// Forward declaration
+class ThreadPool;
+
+#pragma mark -
+#pragma mark Task Handle
+
+/**
+ * This class is a handle to a task submitted to a thread pool.
+ *
+ * A handle is returned by {@link ThreadPool#submit}. It can be used to check
+ * whether the task is complete, to wait on the task, or to schedule further
+ * tasks (continuations) to run once the task is complete.
+ *
+ * Continuations are run on the same thread pool as the original task. So the
+ * thread pool must not be disposed while there are continuations waiting on
+ * an unfinished task.
+ */
+class TaskHandle {
+private:
+    /** The thread pool running the task */
+    ThreadPool* _pool;
+    /** Whether the task has completed */
+    std::atomic<bool> _done;
+    /** A mutex for the completion state */
+    std::mutex _mutex;
+    /** A condition variable signaled when the task is complete */
+    std::condition_variable _finished;
+    /** The tasks to run once this task is complete */
+    std::vector<Task> _continuations;
+    
+    /**
+     * Marks this task as complete, scheduling any continuations.
+     */
+    void complete();
+    
+    /** Allow the thread pool to complete the task */
+    friend class ThreadPool;
+    
+public:
+    /**
+     * Creates a handle for a task on the given thread pool.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. Handles are created by the method
+     * {@link ThreadPool#submit}.
+     *
+     * @param pool  The thread pool running the task
+     */
+    TaskHandle(ThreadPool* pool) : _pool(pool), _done(false) {}
+    
+    /**
+     * Returns true if the task is complete.
+     *
+     * @return true if the task is complete.
+     */
+    bool isDone() const { return _done.load(std::memory_order_acquire); }
+    
+    /**
+     * Blocks until the task is complete.
+     *
+     * If this method is called from a worker of the same thread pool, that
+     * worker runs other tasks while it waits. So it is safe to wait on a
+     * task from within another task, even in a pool with a single thread.
+     */
+    void wait();
+    
+    /**
+     * Schedules a task to run once this task is complete.
+     *
+     * The continuation is added to the same thread pool as this task. If this
+     * task is already complete, the continuation is added immediately.
+     *
+     * @param task  The task to run once this task is complete
+     */
+    void then(Task task);
+    
+private:
+    /** Handles are only shared via pointer */
+    CU_DISALLOW_COPY_AND_ASSIGN(TaskHandle);
+};
+
 #pragma mark -
 #pragma mark Thread Pool
 
 /**
  *  Class to providing a collection of worker threads.
  *
- *  This is a general purpose class for performing tasks asynchronously.  There 
- *  is no notification process for when a task is complete.  Instead, your task 
- *  should either set a flag, or execute a callback when it is done.
+ *  This is a general purpose class for performing tasks asynchronously. A
+ *  task added with {@link #addTask} has no notification for when it is
+ *  complete.  Instead, your task should either set a flag, or execute a
+ *  callback when it is done. Alternatively, a task added with {@link #submit}
+ *  returns a {@link TaskHandle}, which can wait on the task or schedule tasks
+ *  to run after it.
+ *
+ *  Each worker thread has its own queue of tasks. Tasks added from outside
+ *  of the pool are spread across these queues, while tasks added by a worker
+ *  go to the queue of that worker. A worker with nothing to do steals from
+ *  the queues of the other workers. So adding a task only locks one queue,
+ *  and the workers do not contend on a single lock. Each queue is first in,
+ *  first out. In particular, a pool with a single thread runs its tasks in
+ *  the order they were added.
  *
  *  There are some important safety considerations for using this class over
  *  direct thread objects. For example, stopping a thread pool does not shut it 
@@ -65,15 +322,62 @@ namespace cugl {
  *  it is not safe to delete a thread pool until it is completely shutdown.
  *
  *  More importantly, we do not allow for detached threads. This makes no sense
- *  in this application, because the threads share a resource (_taskQueue) with 
- *  the main thread that will be deleted.  It is therefore unsafe for the 
- *  threads to ever detach.
+ *  in this application, because the threads share a resource (the task 
+ *  queues) with the main thread that will be deleted.  It is therefore unsafe
+ *  for the threads to ever detach.
  *
  *  See the class {@link AssetManager} for an example of how to use a thread 
  *  pool.
  */
 class ThreadPool {
 private:
+    /** A task waiting in a queue */
+    struct Entry {
+        /** The task to run */
+        Task task;
+        /** The handle to complete when the task is done (may be nullptr) */
+        std::shared_ptr<TaskHandle> handle;
+    };
+    
+    /** The task queue for a single worker */
+    struct WorkQueue {
+        /** A mutex lock for this queue */
+        std::mutex mutex;
+        /** Tasks waiting to be assigned to a thread */
+        std::deque<Entry> tasks;
+    };
+    
+    /** The shared state for a parallel loop */
+    struct Loop {
+        /** The number of chunks */
+        size_t chunks;
+        /** The next chunk to claim */
+        std::atomic<size_t> next;
+        /** The number of chunks completed */
+        std::atomic<size_t> done;
+        /** A mutex for the completion state */
+        std::mutex mutex;
+        /** A condition variable signaled when all chunks are complete */
+        std::condition_variable finished;
+        
+        /**
+         * Creates the shared state for a loop with the given number of chunks
+         *
+         * @param chunks    The number of chunks
+         */
+        Loop(size_t chunks) : chunks(chunks), next(0), done(0) {}
+        
+        /**
+         * Records that a chunk is complete.
+         */
+        void finish() {
+            if (done.fetch_add(1)+1 == chunks) {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.notify_all();
+            }
+        }
+    };
+
     /** The individual worker threads for this thread pool */
 #ifdef CU_SDL_THREADS
     std::vector<SDL_Thread*> _workers;
@@ -81,23 +385,31 @@ private:
     std::vector<std::thread> _workers;
 #endif
     
-    /** Tasks waiting to be assigned to a thread */
-    std::queue< std::function<void()> > _taskQueue;
+    /** The task queues, one per worker */
+    std::vector<std::unique_ptr<WorkQueue>> _queues;
+    /** The queue for the next task added from outside of the pool */
+    std::atomic<size_t> _nextQueue;
+    /** The number of tasks in all of the queues */
+    std::atomic<size_t> _pending;
+    /** The number of workers that have started */
+    std::atomic<size_t> _started;
+    /** The number of workers waiting for a task */
+    std::atomic<size_t> _sleeping;
     
-    /** A mutex lock for the task queue */
-    std::mutex _queueMutex;
+    /** A mutex lock for idle workers */
+    std::mutex _sleepMutex;
     /** A condition variable to manage tasks waiting for a worker */
     std::condition_variable _taskCondition;
     
     /** Whether or not the thread pool has been marked for shutdown */
-    bool _stop;
+    std::atomic<bool> _stop;
     /** The number of child threads that are completed */
-    int _complete;
+    std::atomic<size_t> _complete;
     
     /**
      * The body function of a single thread.
      *
-     * This function pulls tasks from the task queue.  
+     * This function pulls tasks from the task queues.  
      *
      * This implementation is safe to use with std::thread.
      */
@@ -106,13 +418,55 @@ private:
     /**
      * The body function of a single thread.
      *
-     * This function pulls tasks from the task queue.
+     * This function pulls tasks from the task queues.
      *
      * This static implementation uses the SDL thread API.  It should be used
      * on Android and Windows, which have special thread requirements.
      */
     static int sdlThreadFunc(void* ptr);
     
+    /**
+     * Adds a task entry to the thread pool.
+     *
+     * @param entry     The task entry
+     * @param priority  Whether to run the task before the ones waiting
+     */
+    void push(Entry&& entry, bool priority);
+    
+    /**
+     * Removes a task entry from the queues, returning true if successful.
+     *
+     * The given queue is checked first. If it is empty, this method steals
+     * from the other queues.
+     *
+     * @param index     The queue to check first
+     * @param entry     The entry to store the task
+     *
+     * @return true if a task was removed
+     */
+    bool pop(size_t index, Entry& entry);
+    
+    /**
+     * Runs a single waiting task on the current thread.
+     *
+     * This method is used by the workers to make progress while waiting on
+     * other tasks. It does nothing if there are no tasks waiting.
+     *
+     * @return true if a task was run
+     */
+    bool runOne();
+    
+    /**
+     * Blocks until every chunk of the given loop is complete.
+     *
+     * A worker of this pool runs other tasks while it waits.
+     *
+     * @param loop  The parallel loop
+     */
+    void wait(Loop& loop);
+    
+    /** Allow handles to wait */
+    friend class TaskHandle;
 
 #pragma mark Constructors
 public:
@@ -124,15 +478,16 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a thread pool 
      * on the heap, use one of the static constructors instead.
      */
-    ThreadPool() :_stop(false), _complete(0) { }
+    ThreadPool() : _nextQueue(0), _pending(0), _started(0), _sleeping(0),
+    _stop(false), _complete(0) { }
     
     /**
      * Deletes this thread pool, destroying all resources.
      *
      * It is a bad idea to destroy the thread pool if the pool is not yet shut
-     * down. The task queue is shared by the child threads, so we cannot delete
-     * it until all the threads complete.  This destructor will block unti 
-     * showndown.
+     * down. The task queues are shared by the child threads, so we cannot 
+     * delete them until all the threads complete.  This destructor will block 
+     * until showndown.
      */
     ~ThreadPool() { dispose(); }
     
@@ -141,8 +496,9 @@ public:
      *
      * A disposed thread pool can be safely reinitialized. However, it is a bad 
      * idea to destroy the thread pool if the pool is not yet shut down. The 
-     * task queue is shared by the child threads, so we cannot delete it until 
-     * all the threads complete.  This destructor will block unti showndown.
+     * task queues are shared by the child threads, so we cannot delete them 
+     * until all the threads complete.  This destructor will block until 
+     * showndown. Any tasks that have not started are discarded.
      */
     void dispose();
     
@@ -187,9 +543,119 @@ public:
      * will not be executed immediately, but must wait for the first available 
      * worker.
      *
-     * @param  task     the task function to add to the thread pool
+     * If priority is true, the task is placed ahead of the tasks waiting in
+     * its queue. This does not affect tasks that are already running.
+     *
+     * @param task      the task function to add to the thread pool
+     * @param priority  whether to run the task before the ones waiting
+     */
+    void addTask(Task task, bool priority=false);
+    
+    /**
+     * Adds a task to the thread pool, returning a handle to the task.
+     *
+     * This method is the same as {@link #addTask}, except that the handle
+     * can be used to wait on the task, or to schedule other tasks to run once
+     * it is complete.
+     *
+     * @param task      the task function to add to the thread pool
+     * @param priority  whether to run the task before the ones waiting
+     *
+     * @return a handle to the task
+     */
+    std::shared_ptr<TaskHandle> submit(Task task, bool priority=false);
+    
+    /**
+     * Runs the given loop body over a range, in parallel if possible.
+     *
+     * The range [0,size) is split into chunks of the given grain size, and
+     * the body is called with the start and end of each chunk. The chunks
+     * are shared between the pool and the calling thread. If the pool is
+     * stopped, or the range is no bigger than a chunk, the body is called once
+     * on the whole range on this thread. Either way, this method does not
+     * return until the body has been called on the whole range.
+     *
+     * It is safe to call this method from within a task of this pool.
+     *
+     * @param size  The size of the range
+     * @param grain The size of a chunk
+     * @param body  The loop body, called with the start and end of each chunk
+     */
+    template<typename F>
+    void parallelFor(size_t size, size_t grain, const F& body) {
+        grain = grain == 0 ? 1 : grain;
+        size_t chunks = (size+grain-1)/grain;
+        if (chunks <= 1 || _stop || _workers.empty()) {
+            if (size > 0) {
+                body(0,size);
+            }
+            return;
+        }
+        
+        // Tasks that start after the loop is done find nothing to claim
+        std::shared_ptr<Loop> loop = std::make_shared<Loop>(chunks);
+        const F* func = &body;
+        auto run = [=]() {
+            size_t chunk;
+            while ((chunk = loop->next.fetch_add(1)) < chunks) {
+                (*func)(chunk*grain,std::min(size,(chunk+1)*grain));
+                loop->finish();
+            }
+        };
+        
+        size_t helpers = std::min(chunks-1,_workers.size());
+        for(size_t ii = 0; ii < helpers; ii++) {
+            addTask(run);
+        }
+        run();
+        wait(*loop);
+    }
+    
+    /**
+     * Returns the reduction of the given loop body over a range.
+     *
+     * The range [0,size) is split into chunks as in {@link #parallelFor}.
+     * The body is called with the start and end of each chunk, returning the
+     * value for that chunk. The values are then combined (starting from the
+     * identity) in the order of the chunks. So the result does not depend on
+     * how the chunks were scheduled.
+     *
+     * @param size      The size of the range
+     * @param grain     The size of a chunk
+     * @param identity  The identity value of the reduction
+     * @param body      The loop body, returning the value of each chunk
+     * @param reduce    The function to combine two values
+     *
+     * @return the reduction of the given loop body over a range.
+     */
+    template<typename T, typename F, typename R>
+    T parallelReduce(size_t size, size_t grain, const T& identity,
+                     const F& body, const R& reduce) {
+        grain = grain == 0 ? 1 : grain;
+        std::vector<T> partial((size+grain-1)/grain,identity);
+        parallelFor(size,grain,[&](size_t first, size_t last) {
+            partial[first/grain] = body(first,last);
+        });
+        T result = identity;
+        for(auto it = partial.begin(); it != partial.end(); ++it) {
+            result = reduce(result,*it);
+        }
+        return result;
+    }
+    
+    /**
+     * Returns the number of worker threads in this pool.
+     *
+     * @return the number of worker threads in this pool.
+     */
+    size_t getThreadCount() const { return _workers.size(); }
+    
+    /**
+     * Returns true if the current thread is a worker of this pool.
+     *
+     * @return true if the current thread is a worker of this pool.
      */
-    void addTask(const std::function<void()> &task);
+    bool isWorkerThread() const;
     
     /**
      * Stop the thread pool, marking it for shut down.
@@ -34,6 +34,11 @@
 #include "CUFiletools.h"
 #include "CUFreeList.h"
 #include "CUGreedyFreeList.h"
+#include "CUConcurrentFreeList.h"
+#include "CUFrameArena.h"
+#include "CUProfiler.h"
 #include "CUThreadPool.h"
+#include "CUMPSCQueue.h"
+#include "CULogger.h"
 
 #endif /* __CU_UTIL_PKG_H__ */
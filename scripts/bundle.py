@@ -0,0 +1,241 @@
+"""
+Script to pack CUGL assets into a bundle
+
+Every asset normally requires its own file open, which is expensive on some platforms
+(particularly Android, where assets are read through the APK asset manager). This script
+packs an asset directory into a single bundle file that is read by AssetBundle. Once the
+bundle is mounted, the asset loaders read from the bundle instead of the file system.
+
+The bundle format is little-endian and consists of a 32 byte header, the index (32 bytes
+per file), the name table, and the file data. Each file is aligned (to 16 bytes by
+default) so that it may be used directly from a memory mapping. Files may optionally be
+compressed with the LZ4 block format. Compression is skipped for formats that are already
+compressed, and for any file where it does not save at least 10%.
+
+Bundles are NOT checked for staleness at runtime. This script should be rerun (as part of
+the build) whenever the assets change.
+
+Author: Walker White
+Date: October 14, 2026
+"""
+import os, os.path
+import struct
+import argparse
+
+
+#mark CONSTANTS
+
+# The bundle header: magic, version, file count, name bytes, alignment, and reserved
+HEADER = struct.Struct('<4sIIIIIII')
+# A single index entry: offset, stored size, original size, name offset, name length, flags
+ENTRY  = struct.Struct('<QQQIHH')
+
+# The current format version
+VERSION = 1
+
+# The flag for an LZ4 compressed entry
+LZ4_FLAG = 1
+
+# The file extensions that are already compressed
+COMPRESSED = set(['.png','.jpg','.jpeg','.webp','.ogg','.mp3','.flac','.ktx','.ktx2',
+                  '.pvr','.astc','.zip','.gz','.cugb'])
+
+# The minimum (match) length for LZ4
+MIN_MATCH = 4
+# The maximum match offset for LZ4
+MAX_OFFSET = 65535
+
+
+#mark LZ4 COMPRESSION
+
+def lz4_length(out,length):
+    """
+    Appends the extension bytes for an LZ4 length that does not fit in a nibble
+
+    :param out: The buffer to append to
+    :type out:  ``bytearray``
+
+    :param length: The length beyond the nibble (i.e. length-15)
+    :type length:  ``int``
+    """
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def lz4_sequence(out,literals,offset,match):
+    """
+    Appends a single LZ4 sequence to the buffer
+
+    If match is 0, this is the final sequence, with no match.
+
+    :param out: The buffer to append to
+    :type out:  ``bytearray``
+
+    :param literals: The literal bytes of the sequence
+    :type literals:  ``bytes``
+
+    :param offset: The match offset
+    :type offset:  ``int``
+
+    :param match: The match length (or 0 for the final sequence)
+    :type match:  ``int``
+    """
+    litlen = len(literals)
+    extra  = match-MIN_MATCH if match else 0
+    out.append((min(litlen,15) << 4) | min(extra,15))
+    if litlen >= 15:
+        lz4_length(out,litlen-15)
+    out.extend(literals)
+    if match:
+        out.extend(struct.pack('<H',offset))
+        if extra >= 15:
+            lz4_length(out,extra-15)
+
+
+def lz4_compress(data):
+    """
+    Returns the LZ4 block compression of the given data
+
+    This is a simple greedy compressor. It does not compress as well as the reference
+    implementation, but it produces valid blocks. It obeys the end of block rules: the
+    last 5 bytes are always literals, and the last match starts at least 12 bytes before
+    the end of the block.
+
+    :param data: The data to compress
+    :type data:  ``bytes``
+
+    :return: The LZ4 block compression of the given data
+    :rtype:  ``bytes``
+    """
+    size   = len(data)
+    limit  = size-12
+    out    = bytearray()
+    table  = {}
+    anchor = 0
+    pos    = 0
+    while pos < limit:
+        key  = data[pos:pos+MIN_MATCH]
+        cand = table.get(key)
+        table[key] = pos
+        if cand is None or pos-cand > MAX_OFFSET:
+            pos += 1
+            continue
+
+        match = MIN_MATCH
+        stop  = size-5-pos
+        while match < stop and data[cand+match] == data[pos+match]:
+            match += 1
+        lz4_sequence(out,data[anchor:pos],pos-cand,match)
+        pos += match
+        anchor = pos
+
+    lz4_sequence(out,data[anchor:],0,0)
+    return bytes(out)
+
+
+#mark PACKING
+
+def collect(root):
+    """
+    Returns the (name,path) pairs for every file in the given directory
+
+    The names are relative to the root, with forward slashes as separators, and are
+    sorted so that the bundle is deterministic.
+
+    :param root: The directory to search
+    :type root:  ``str``
+
+    :return: The (name,path) pairs for every file in the given directory
+    :rtype:  ``list``
+    """
+    result = []
+    for (path, dirs, files) in os.walk(root):
+        dirs.sort()
+        for name in sorted(files):
+            if name.startswith('.'):
+                continue
+            full = os.path.join(path,name)
+            result.append((os.path.relpath(full,root).replace(os.sep,'/'),full))
+    return result
+
+
+def pack(root,target,compress=False,align=16):
+    """
+    Packs the given asset directory into a bundle
+
+    :param root: The asset directory to pack
+    :type root:  ``str``
+
+    :param target: The bundle file to write
+    :type target:  ``str``
+
+    :param compress: Whether to compress the files with LZ4
+    :type compress:  ``bool``
+
+    :param align: The alignment of each file in bytes
+    :type align:  ``int``
+
+    :return: The number of files packed
+    :rtype:  ``int``
+    """
+    target = os.path.abspath(target)
+    entries = [(name,path) for (name,path) in collect(root) if os.path.abspath(path) != target]
+
+    # Build the name table
+    names = bytearray()
+    for (name,path) in entries:
+        names.extend(name.encode('utf-8'))
+
+    start = HEADER.size+ENTRY.size*len(entries)+len(names)
+    index = bytearray()
+    blobs = bytearray()
+    noff  = 0
+    for (name,path) in entries:
+        with open(path,'rb') as file:
+            data = file.read()
+
+        flags  = 0
+        stored = data
+        if compress and data and not os.path.splitext(name)[1].lower() in COMPRESSED:
+            packed = lz4_compress(data)
+            if len(packed) < 0.9*len(data):
+                flags  = LZ4_FLAG
+                stored = packed
+
+        offset = start+len(blobs)
+        padding = (-offset) % align
+        blobs.extend(b'\0'*padding)
+        offset += padding
+
+        encoded = name.encode('utf-8')
+        index.extend(ENTRY.pack(offset,len(stored),len(data),noff,len(encoded),flags))
+        noff += len(encoded)
+        blobs.extend(stored)
+
+    with open(target,'wb') as file:
+        file.write(HEADER.pack(b'CUGB',VERSION,len(entries),len(names),align,0,0,0))
+        file.write(index)
+        file.write(names)
+        file.write(blobs)
+    return len(entries)
+
+
+def main():
+    """
+    Runs the script from the command line
+    """
+    parser = argparse.ArgumentParser(description='Pack a CUGL asset directory into a bundle.')
+    parser.add_argument('root', type=str, help='the asset directory')
+    parser.add_argument('output', type=str, help='the bundle file to write')
+    parser.add_argument('-c', '--compress', action='store_true', help='compress files with LZ4')
+    parser.add_argument('-a', '--align', type=int, default=16, help='the alignment of each file')
+    args = parser.parse_args()
+
+    count = pack(args.root,args.output,args.compress,max(1,args.align))
+    print('Packed %d files into %s' % (count,args.output))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,226 @@
+"""
+Script to compile CUGL JSON assets
+
+Large JSON assets, like scene graphs, widgets and level files, are parsed every time the
+application launches. This script compiles them offline into the binary format read by
+JsonDocument, so that they can be loaded with no parsing at all. AssetManager (and the
+JSON, widget and scene loaders) will load a .cbin file in place of a .json file whenever
+the two sit next to each other.
+
+The binary format is little-endian and consists of a 32 byte header, the node arena, and
+the string table. Every distinct key and string is stored only once in the table. See
+the class JsonDocument for the details.
+
+Compiled files are NOT checked for staleness at runtime. This script should be rerun
+(as part of the build) whenever the JSON assets change.
+
+Author: Walker White
+Date: October 14, 2026
+"""
+import os, os.path
+import struct
+import json
+import argparse
+
+
+#mark CONSTANTS
+
+# The binary header: magic, version, node count, root, string bytes, and reserved
+HEADER = struct.Struct('<4sIIIIIII')
+# A single node: type, key offset, key length, start, size, padding, and number
+ENTRY  = struct.Struct('<IIIIIId')
+
+# The current format version
+VERSION = 1
+
+# The node types (these must agree with JsonValue::Type)
+NULL_TYPE   = 0
+BOOL_TYPE   = 1
+NUMBER_TYPE = 2
+STRING_TYPE = 3
+ARRAY_TYPE  = 4
+OBJECT_TYPE = 5
+
+
+#mark COMPILER
+
+class Pairs(list):
+    """
+    The (key,value) pairs of a JSON object, in file order
+    """
+    pass
+
+
+class Compiler(object):
+    """
+    A compiler converting a single JSON value into the binary format
+
+    The compiler writes the nodes in post-order, so that the children of every container
+    are contiguous and precede their parent. The root is always the last node.
+    """
+
+    def __init__(self):
+        """
+        Initializes an empty compiler
+        """
+        self._nodes = []
+        self._table = bytearray()
+        self._interned = {}
+
+    def intern(self,text):
+        """
+        Returns the (offset,length) of the given string in the string table
+
+        Each distinct string is only added to the table once.
+
+        :param text: The string to intern
+        :type text:  ``str``
+
+        :return: The (offset,length) of the given string in the string table
+        :rtype:  ``tuple``
+        """
+        data = text.encode('utf-8')
+        if not data:
+            return (0,0)
+        if not data in self._interned:
+            self._interned[data] = len(self._table)
+            self._table.extend(data)
+        return (self._interned[data],len(data))
+
+    def add(self,value):
+        """
+        Adds the given value (and all of its children) to the node arena as the root
+
+        :param value: The value to add
+        :type value:  JSON value
+        """
+        self._nodes.append(self.node(None,value))
+
+    def node(self,key,value):
+        """
+        Returns the node for the given value, adding its children to the arena
+
+        The children of a container are compiled first (so that their descendants
+        precede them), and are then written together as a contiguous block.
+
+        :param key: The key of this value (or None if it has no key)
+        :type key:  ``str``
+
+        :param value: The value to convert
+        :type value:  JSON value
+
+        :return: The node for the given value
+        :rtype:  ``tuple``
+        """
+        (koff,klen) = self.intern(key) if key is not None else (0,0)
+        start  = 0
+        size   = 0
+        number = 0.0
+
+        # Check bool before int, as bool is a subclass of int
+        if value is None:
+            kind = NULL_TYPE
+        elif isinstance(value,bool):
+            kind = BOOL_TYPE
+            number = 1.0 if value else 0.0
+        elif isinstance(value,(int,float)):
+            kind = NUMBER_TYPE
+            number = float(value)
+        elif isinstance(value,str):
+            kind = STRING_TYPE
+            (start,size) = self.intern(value)
+        else:
+            if isinstance(value,Pairs):
+                kind = OBJECT_TYPE
+                heads = [self.node(k,v) for (k,v) in value]
+            else:
+                kind = ARRAY_TYPE
+                heads = [self.node(None,v) for v in value]
+            start = len(self._nodes)
+            size  = len(heads)
+            self._nodes.extend(heads)
+
+        return (kind,koff,klen,start,size,number)
+
+    def encode(self):
+        """
+        Returns the binary encoding of the compiled value
+
+        :return: The binary encoding of the compiled value
+        :rtype:  ``bytes``
+        """
+        result = bytearray()
+        result.extend(HEADER.pack(b'CBIN',VERSION,len(self._nodes),len(self._nodes)-1,
+                                  len(self._table),0,0,0))
+        for node in self._nodes:
+            result.extend(ENTRY.pack(node[0],node[1],node[2],node[3],node[4],0,node[5]))
+        result.extend(self._table)
+        return bytes(result)
+
+
+def compile_file(source,target=None):
+    """
+    Compiles the given JSON file to the binary format
+
+    If target is None, the compiled file is placed next to the source with the
+    extension .cbin.
+
+    :param source: The JSON file to compile
+    :type source:  ``str``
+
+    :param target: The file to write
+    :type target:  ``str``
+
+    :return: The path of the compiled file
+    :rtype:  ``str``
+    """
+    if target is None:
+        target = os.path.splitext(source)[0]+'.cbin'
+    with open(source,encoding='utf-8') as file:
+        # Preserve duplicate keys and key order, as the runtime parser does
+        value = json.load(file,object_pairs_hook=Pairs)
+
+    compiler = Compiler()
+    compiler.add(value)
+    with open(target,'wb') as file:
+        file.write(compiler.encode())
+    return target
+
+
+def compile_directory(root):
+    """
+    Compiles every JSON file in the given directory (recursively)
+
+    :param root: The directory to search
+    :type root:  ``str``
+
+    :return: The number of files compiled
+    :rtype:  ``int``
+    """
+    count = 0
+    for (path, dirs, files) in os.walk(root):
+        for name in files:
+            if os.path.splitext(name)[1].lower() == '.json':
+                compile_file(os.path.join(path,name))
+                count += 1
+    return count
+
+
+def main():
+    """
+    Runs the script from the command line
+    """
+    parser = argparse.ArgumentParser(description='Compile CUGL JSON assets to .cbin files.')
+    parser.add_argument('path', type=str, nargs='+', help='the JSON files or asset directories')
+    args = parser.parse_args()
+
+    for path in args.path:
+        if os.path.isdir(path):
+            count = compile_directory(path)
+            print('Compiled %d files in %s' % (count,path))
+        else:
+            print('Compiled %s' % compile_file(path))
+
+
+if __name__ == '__main__':
+    main()
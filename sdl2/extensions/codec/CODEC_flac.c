@@ -357,6 +357,29 @@ CODEC_Source* CODEC_OpenFLAC(const char* filename) {
         SDL_SetError("Could not open '%s'",filename);
         return NULL;
     }
+    return CODEC_OpenFLACRW(stream);
+}
+
+/**
+ * Creates a new CODEC_Source from an Xiph FLAC data stream
+ *
+ * This function is the same as {@link CODEC_OpenFLAC}, except that the data
+ * is read from the given stream. This allows the data to be read from memory
+ * (with SDL_RWFromConstMem). The source takes ownership of the stream, and
+ * will close it when done, even if this function fails.
+ *
+ * Is the responsibility of the caller of this function to close the CODEC_Source
+ * (with {@link CODEC_Close}) when done.
+ *
+ * @param stream    The data stream to read
+ *
+ * @return a new CODEC_Source from an Xiph FLAC data stream
+ */
+CODEC_Source* CODEC_OpenFLACRW(SDL_RWops* stream) {
+    if (stream == NULL) {
+        SDL_SetError("Attempt to read a NULL stream");
+        return NULL;
+    }
 
     FLAC__StreamDecoder *flac;
     if (!(flac = FLAC__stream_decoder_new())) {
@@ -405,7 +428,7 @@ CODEC_Source* CODEC_OpenFLAC(const char* filename) {
 
     int ok = FLAC__stream_decoder_process_until_end_of_metadata(flac);
     if (!ok || decoder->pagesize == 0) {
-        SDL_SetError("FLAC '%s' does not have a stream_info header",filename);
+        SDL_SetError("FLAC stream does not have a stream_info header");
         FLAC__stream_decoder_delete(flac);
         free(decoder);
         free(source);
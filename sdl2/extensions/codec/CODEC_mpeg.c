@@ -115,7 +115,31 @@ Sint32 mpeg_read_page(CODEC_Source* source, CODEC_MPEG* decoder, float* buffer)
  * @return a new CODEC_Source from an MP3 file
  */
 CODEC_Source* CODEC_OpenMPEG(const char* filename) {
-	MP3Stream* converter = MP3Stream_Alloc(filename);
+	SDL_RWops* stream = SDL_RWFromFile(filename, "rb");
+	if (stream == NULL) {
+		SDL_SetError("Could not open '%s'",filename);
+		return NULL;
+	}
+	return CODEC_OpenMPEGRW(stream);
+}
+
+/**
+ * Creates a new CODEC_Source from an MP3 data stream
+ *
+ * This function is the same as {@link CODEC_OpenMPEG}, except that the data
+ * is read from the given stream. This allows the data to be read from memory
+ * (with SDL_RWFromConstMem). The source takes ownership of the stream, and
+ * will close it when done, even if this function fails.
+ *
+ * Is the responsibility of the caller of this function to close the CODEC_Source
+ * (with {@link CODEC_Close}) when done.
+ *
+ * @param stream    The data stream to read
+ *
+ * @return a new CODEC_Source from an MP3 data stream
+ */
+CODEC_Source* CODEC_OpenMPEGRW(SDL_RWops* stream) {
+	MP3Stream* converter = MP3Stream_AllocRW(stream);
 	if (converter == NULL) {
 		return NULL;
 	}
@@ -182,6 +182,29 @@ CODEC_Source* CODEC_OpenVorbis(const char* filename) {
     if (stream == NULL) {
         return NULL;
     }
+    return CODEC_OpenVorbisRW(stream);
+}
+
+/**
+ * Creates a new CODEC_Source from an OGG Vorbis data stream
+ *
+ * This function is the same as {@link CODEC_OpenVorbis}, except that the data
+ * is read from the given stream. This allows the data to be read from memory
+ * (with SDL_RWFromConstMem). The source takes ownership of the stream, and
+ * will close it when done, even if this function fails.
+ *
+ * Is the responsibility of the caller of this function to close the CODEC_Source
+ * (with {@link CODEC_Close}) when done.
+ *
+ * @param stream    The data stream to read
+ *
+ * @return a new CODEC_Source from an OGG Vorbis data stream
+ */
+CODEC_Source* CODEC_OpenVorbisRW(SDL_RWops* stream) {
+    if (stream == NULL) {
+        CODEC_SetError("Attempt to read a NULL stream");
+        return NULL;
+    }
     
     CODEC_Vorbis* decoder = malloc(sizeof(CODEC_Vorbis));
     if (!decoder) {
@@ -198,7 +221,7 @@ CODEC_Source* CODEC_OpenVorbis(const char* filename) {
 
     int error = ov_open_callbacks(stream, &(decoder->oggfile), NULL, 0, calls);
     if (error) {
-        CODEC_SetError("File '%s' is not an OGG Vorbis file", filename);
+        CODEC_SetError("Stream is not an OGG Vorbis file");
         SDL_RWclose(stream);
         free(decoder);
         return NULL;
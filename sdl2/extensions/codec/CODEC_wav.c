@@ -765,6 +765,30 @@ Sint32 wav_read_page(CODEC_Source* source, CODEC_WAV* decoder, float* buffer) {
  * @return a new CODEC_Source from an WAV file
  */
 CODEC_Source* CODEC_OpenWAV(const char* filename) {
+    SDL_RWops *stream = SDL_RWFromFile(filename,"r");
+    if (stream == NULL) {
+        SDL_SetError("'%s' not found",filename);
+        return NULL;
+    }
+    return CODEC_OpenWAVRW(stream);
+}
+
+/**
+ * Creates a new CODEC_Source from a WAV data stream
+ *
+ * This function is the same as {@link CODEC_OpenWAV}, except that the data
+ * is read from the given stream. This allows the data to be read from memory
+ * (with SDL_RWFromConstMem). The source takes ownership of the stream, and
+ * will close it when done, even if this function fails.
+ *
+ * Is the responsibility of the caller of this function to close the CODEC_Source
+ * (with {@link CODEC_Close}) when done.
+ *
+ * @param stream    The data stream to read
+ *
+ * @return a new CODEC_Source from a WAV data stream
+ */
+CODEC_Source* CODEC_OpenWAVRW(SDL_RWops* stream) {
 	WaveChunk chunk;
     CODEC_WAV* decoder = NULL;
     
@@ -790,10 +814,9 @@ CODEC_Source* CODEC_OpenWAV(const char* filename) {
     
     SDL_zero(chunk);
     
-    SDL_RWops *stream = SDL_RWFromFile(filename,"r");
 	was_error = 0;
     if (stream == NULL) {
-        SDL_SetError("'%s' not found",filename);
+        SDL_SetError("Attempt to read a NULL stream");
         was_error = 1;
         goto done;
     }
@@ -811,7 +834,7 @@ CODEC_Source* CODEC_OpenWAV(const char* filename) {
     }
     
     if ((RIFFchunk != RIFF) || (WAVEmagic != WAVE)) {
-        SDL_SetError("'%s' has unrecognized file type (not WAVE)", filename);
+        SDL_SetError("Stream has unrecognized file type (not WAVE)");
         was_error = 1;
         goto done;
     }
@@ -70,6 +70,29 @@ int seek_stream(uint64_t position, void *user_data) {
  */
 MP3Stream* MP3Stream_Alloc(const char* file) {
 	SDL_RWops *source = SDL_RWFromFile(file, "rb");
+	if (source == NULL) {
+		SDL_SetError("Could not open '%s'", file);
+		return NULL;
+	}
+	return MP3Stream_AllocRW(source);
+}
+
+/**
+ * Allocates a new MP3 stream for the given data stream
+ *
+ * The MP3 stream takes ownership of the data stream, and will close it when
+ * freed, even if this function fails. It the responsibility of the user to
+ * free this stream when done.
+ *
+ * @param source	The MP3 data stream
+ *
+ * @return a new MP3 stream for the given data stream
+ */
+MP3Stream* MP3Stream_AllocRW(SDL_RWops* source) {
+	if (source == NULL) {
+		SDL_SetError("Attempt to read a NULL stream");
+		return NULL;
+	}
 	MP3Stream* result = (MP3Stream*)malloc(sizeof(MP3Stream));
 	
 	result->source = source;
@@ -80,7 +103,7 @@ MP3Stream* MP3Stream_Alloc(const char* file) {
 
 	int error = mp3dec_ex_open_cb(&(result->context), &(result->stream), MP3D_SEEK_TO_SAMPLE);
 	if (error) {
-		SDL_SetError("Could not open '%s': Code %d\n", file,error);
+		SDL_SetError("Could not open MP3 stream: Code %d\n", error);
 		SDL_RWclose(source);
 		free(result);
         return NULL;
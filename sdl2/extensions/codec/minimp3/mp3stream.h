@@ -54,6 +54,19 @@ typedef struct MP3Stream MP3Stream;
  */
 extern DECLSPEC MP3Stream* MP3Stream_Alloc(const char* file);
 
+/**
+ * Allocates a new MP3 stream for the given data stream
+ *
+ * The MP3 stream takes ownership of the data stream, and will close it when
+ * freed, even if this function fails. It the responsibility of the user to
+ * free this stream when done.
+ *
+ * @param source	The MP3 data stream
+ *
+ * @return a new MP3 stream for the given data stream
+ */
+extern DECLSPEC MP3Stream* MP3Stream_AllocRW(SDL_RWops* source);
+
 /**
  * Frees the given MP3 stream
  *
@@ -97,6 +97,23 @@ typedef struct {
  */
 extern DECLSPEC CODEC_Source* CODEC_OpenVorbis(const char* filename);
 
+/**
+ * Creates a new CODEC_Source from an OGG Vorbis data stream
+ *
+ * This function is the same as {@link CODEC_OpenVorbis}, except that the data
+ * is read from the given stream. This allows the data to be read from memory
+ * (with SDL_RWFromConstMem). The source takes ownership of the stream, and
+ * will close it when done, even if this function fails.
+ *
+ * Is the responsibility of the caller of this function to close the CODEC_Source
+ * (with {@link CODEC_Close}) when done.
+ *
+ * @param stream    The data stream to read
+ *
+ * @return a new CODEC_Source from an OGG Vorbis data stream
+ */
+extern DECLSPEC CODEC_Source* CODEC_OpenVorbisRW(SDL_RWops* stream);
+
 /** 
  * Creates a new CODEC_Source from an Xiph FLAC file
  * 
@@ -113,6 +130,23 @@ extern DECLSPEC CODEC_Source* CODEC_OpenVorbis(const char* filename);
  */
 extern DECLSPEC CODEC_Source* CODEC_OpenFLAC(const char* filename);
 
+/**
+ * Creates a new CODEC_Source from an Xiph FLAC data stream
+ *
+ * This function is the same as {@link CODEC_OpenFLAC}, except that the data
+ * is read from the given stream. This allows the data to be read from memory
+ * (with SDL_RWFromConstMem). The source takes ownership of the stream, and
+ * will close it when done, even if this function fails.
+ *
+ * Is the responsibility of the caller of this function to close the CODEC_Source
+ * (with {@link CODEC_Close}) when done.
+ *
+ * @param stream    The data stream to read
+ *
+ * @return a new CODEC_Source from an Xiph FLAC data stream
+ */
+extern DECLSPEC CODEC_Source* CODEC_OpenFLACRW(SDL_RWops* stream);
+
 /** 
  * Creates a new CODEC_Source from an MP3 file
  * 
@@ -129,6 +163,23 @@ extern DECLSPEC CODEC_Source* CODEC_OpenFLAC(const char* filename);
  */
 extern DECLSPEC CODEC_Source* CODEC_OpenMPEG(const char* filename);
 
+/**
+ * Creates a new CODEC_Source from an MP3 data stream
+ *
+ * This function is the same as {@link CODEC_OpenMPEG}, except that the data
+ * is read from the given stream. This allows the data to be read from memory
+ * (with SDL_RWFromConstMem). The source takes ownership of the stream, and
+ * will close it when done, even if this function fails.
+ *
+ * Is the responsibility of the caller of this function to close the CODEC_Source
+ * (with {@link CODEC_Close}) when done.
+ *
+ * @param stream    The data stream to read
+ *
+ * @return a new CODEC_Source from an MP3 data stream
+ */
+extern DECLSPEC CODEC_Source* CODEC_OpenMPEGRW(SDL_RWops* stream);
+
 /** 
  * Creates a new CODEC_Source from an WAV file
  * 
@@ -148,6 +199,23 @@ extern DECLSPEC CODEC_Source* CODEC_OpenMPEG(const char* filename);
  */
 extern DECLSPEC CODEC_Source* CODEC_OpenWAV(const char* filename);
 
+/**
+ * Creates a new CODEC_Source from a WAV data stream
+ *
+ * This function is the same as {@link CODEC_OpenWAV}, except that the data
+ * is read from the given stream. This allows the data to be read from memory
+ * (with SDL_RWFromConstMem). The source takes ownership of the stream, and
+ * will close it when done, even if this function fails.
+ *
+ * Is the responsibility of the caller of this function to close the CODEC_Source
+ * (with {@link CODEC_Close}) when done.
+ *
+ * @param stream    The data stream to read
+ *
+ * @return a new CODEC_Source from a WAV data stream
+ */
+extern DECLSPEC CODEC_Source* CODEC_OpenWAVRW(SDL_RWops* stream);
+
 /**
  * Closes a CODEC_Source, releasing all memory
  *
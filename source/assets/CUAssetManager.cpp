@@ -47,18 +47,24 @@
 //
 #include <cugl/assets/CUAssetManager.h>
 #include <cugl/base/CUApplication.h>
-#include <cugl/io/CUJsonReader.h>
+#include <cugl/util/CUTimestamp.h>
+#include <cugl/util/CUProfiler.h>
+#include <cugl/util/CUFiletools.h>
+#include <unordered_set>
+#include <map>
+#include <cugl/assets/CUJsonDocument.h>
 
 using namespace cugl;
 
 #pragma mark -
 #pragma mark Constructors
 /**
- * Initializes a new asset manager with two auxiliary threads.
+ * Initializes a new asset manager.
  *
- * The asset manager will have a thread pool of size 2, giving it two
- * threads to load assets asynchronously.  These threads have no effect on
- * synchronous loading and will sleep when no assets are being loaded.
+ * The asset manager has one fewer worker thread than the number of cores
+ * (but always at least one). Loaders that are not thread-safe, such as
+ * fonts, share an additional single thread (see {@link BaseLoader#isSerial}).
+ * All of these threads are distinct from the main application thread.
  *
  * This initializer does not attach any loaders.  It simply creates an
  * object that is ready to accept loader objects.
@@ -66,8 +72,29 @@ using namespace cugl;
  * @return true if the asset manager was initialized successfully
  */
 bool AssetManager::init() {
-    _workers = ThreadPool::alloc(1);
-    return true;
+    return init((Uint32)SDL_max(SDL_GetCPUCount()-1,1));
+}
+
+/**
+ * Initializes a new asset manager with the given number of worker threads.
+ *
+ * Loaders that are not thread-safe, such as fonts, share an additional
+ * single thread (see {@link BaseLoader#isSerial}), unless there is only
+ * one worker thread. All of these threads are distinct from the main
+ * application thread.
+ *
+ * This initializer does not attach any loaders.  It simply creates an
+ * object that is ready to accept loader objects.
+ *
+ * @param threads   The number of worker threads
+ *
+ * @return true if the asset manager was initialized successfully
+ */
+bool AssetManager::init(Uint32 threads) {
+    CUAssertLog(threads, "The asset manager must have at least one thread");
+    _workers = ThreadPool::alloc(threads);
+    _serial  = threads > 1 ? ThreadPool::alloc(1) : _workers;
+    return _workers != nullptr && _serial != nullptr;
 }
 
 /**
@@ -78,8 +105,23 @@ bool AssetManager::init() {
  * threads) and reattach all loaders to use the asset manager again.
  */
 void AssetManager::dispose() {
+    if (_watcher && Application::get()) {
+        Application::get()->unschedule(_watcher);
+    }
+    _watcher  = 0;
+    _watching = false;
+    _stamps.clear();
     detachAll();
     _workers = nullptr;
+    _serial  = nullptr;
+    if (_drainer && Application::get()) {
+        Application::get()->unschedule(_drainer);
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _finish.clear();
+    _drainer = 0;
+    _preload = 0;
+    _scanning = false;
 }
 
 #pragma mark -
@@ -147,7 +189,7 @@ bool AssetManager::readCategory(size_t hash, const std::shared_ptr<JsonValue>& j
  * As an asynchronous read, all asset loading will take place outside of
  * the main thread.  However, assets such as fonts and textures will need
  * the OpenGL context to complete, so part of their asset loading may take
- * place in the main thread via the {@link Application#schedule} interface.
+ * place in the main thread, limited by the frame budget {@see setFrameBudget}.
  * You may either poll this interface to determine when the assets are
  * loaded or use optional callbacks.
  *
@@ -214,49 +256,200 @@ bool AssetManager::purgeCategory(size_t hash, const std::shared_ptr<JsonValue>&
 }
 
 /**
- * Synchronizes the asset manager to wait until all assets have finished.
+ * Starts the next stage of the given asset directory
+ *
+ * The categories of an asset directory are grouped into stages by the
+ * priority of their loaders. This method is called on the main thread
+ * (once a frame) until every stage has started. A stage only starts
+ * once every loader of the previous stages has no pending assets.
  *
- * This method is necessary for assets whose construction depends on
- * previously loaded assets (e.g. scene graphs).  In the current architecture,
- * this method is only correct if the asset manager loads assets in a
- * single thread.
+ * @param stages    The remaining stages of the directory
+ * @param started   The loaders of the stages already started
+ * @param callback  An optional callback after each asset is loaded
+ *
+ * @return true if there are stages remaining
  */
-void AssetManager::sync() {
-    _workers->addTask([=](void) {
-        this->block();
-        this->block(); // Two blocks force one complete cycle
-    });
+bool AssetManager::advance(const std::shared_ptr<std::deque<std::vector<std::shared_ptr<JsonValue>>>>& stages,
+                           const std::shared_ptr<std::vector<std::shared_ptr<BaseLoader>>>& started,
+                           LoaderCallback callback) {
+    for(auto it = started->begin(); it != started->end(); ++it) {
+        if ((*it)->waitCount() > 0) {
+            return true;
+        }
+    }
+
+    std::vector<std::shared_ptr<JsonValue>>& stage = stages->front();
+    for(auto it = stage.begin(); it != stage.end(); ++it) {
+        size_t hash = _jsonKeys[(*it)->key()];
+        auto loader = _handlers.find(hash);
+        if (loader != _handlers.end()) {
+            started->push_back(loader->second);
+        }
+        readCategory(hash,*it,callback);
+    }
+    stages->pop_front();
+
+    if (stages->empty()) {
+        _preload--;
+        return false;
+    }
+    return true;
 }
 
 /**
- * Blocks the asset manager until the next animation frame.
+ * Runs the queued materialization callbacks for this frame
+ *
+ * This method is called on the main thread once each animation frame
+ * while there are queued callbacks. It stops once the frame budget is
+ * exceeded, leaving the remaining callbacks for the next frame.
  *
- * Any assets queued after a block will not be added to thread pool
- * until at least one animation frame has passed.  This method is used
- * to implement the {@link sync()} method.
+ * @return true if there are callbacks remaining
  */
-void AssetManager::block() {
-    Application::get()->schedule([=](void){
-        this->resume();
-        return false;
-    });
-    _wait = true;
-    while (_wait) {
-        int delay = (int)(500/Application::get()->getFPS());
-        SDL_Delay(delay);
+bool AssetManager::drain() {
+    Timestamp start;
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        count = _finish.size();
+    }
+
+    // Only run the callbacks present at the start of the frame
+    bool working = true;
+    while (count > 0 && working) {
+        std::function<bool()> callback;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_finish.empty()) {
+                break;
+            }
+            callback = std::move(_finish.front());
+            _finish.pop_front();
+        }
+        count--;
+
+        if (callback()) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _finish.push_back(std::move(callback));
+        }
+
+        if (_budget > 0) {
+            Timestamp now;
+            working = Timestamp::ellapsedMicros(start,now) < _budget;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_finish.empty()) {
+            return true;
+        }
+        _drainer = 0;
+    }
+    trim();
+    return false;
+}
+
+#pragma mark -
+#pragma mark Materialization
+/**
+ * Queues the given callback to run on the main thread within the frame budget
+ *
+ * This method is used by the attached loaders to materialize assets. The
+ * callbacks are run in the order that they are queued. As with the method
+ * {@link Application#schedule}, a callback that returns true is run again.
+ * It is placed at the back of the queue.
+ *
+ * This method is safe to call from any thread.
+ *
+ * @param callback  The materialization callback
+ */
+void AssetManager::schedule(std::function<bool()> callback) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _finish.push_back(std::move(callback));
+    if (!_drainer) {
+        _drainer = Application::get()->schedule([this](void) {
+            return this->drain();
+        });
     }
-    return;
 }
 
 /**
- * Resumes a previously blocked the asset manager.
+ * Schedules the given callback to materialize an asset on the main thread
+ *
+ * If this loader is attached to an {@link AssetManager}, the callback is
+ * queued with the manager, which runs these callbacks within its frame
+ * budget. Otherwise, it is passed to {@link Application#schedule}. As
+ * with that method, a callback that returns true is run again (on a
+ * later frame, if the budget is exhausted).
  *
- * Any assets queued after a block will not be added to thread pool
- * until at least one animation frame has passed.  This method is used
- * to implement the {@link sync()} method.
+ * This method is safe to call from any thread.
+ *
+ * @param callback  The materialization callback
  */
-void AssetManager::resume() {
-    _wait = false;
+void BaseLoader::schedule(std::function<bool()> callback) {
+#if CU_PROFILE_ENABLED
+    // Time the asset spends queued for the main thread is part of its load
+    if (Profiler::isActive()) {
+        Uint64 queued = Profiler::now();
+        std::function<bool()> inner = std::move(callback);
+        callback = [=](void) mutable {
+            CU_PROFILE_SCOPE("AssetManager::materialize");
+            if (queued) {
+                CU_PROFILE_WAIT(Profiler::now()-queued);
+                queued = 0;
+            }
+            return inner();
+        };
+    }
+#endif
+    if (_manager != nullptr) {
+        _manager->schedule(callback);
+    } else {
+        Application::get()->schedule(callback);
+    }
+}
+
+#pragma mark -
+#pragma mark Memory Management
+/**
+ * Returns the estimated memory used by all assets in bytes
+ *
+ * This is the sum of the memory used by each attached loader. See
+ * {@link BaseLoader#getMemoryUsage}.
+ *
+ * @return the estimated memory used by all assets in bytes
+ */
+size_t AssetManager::getMemoryUsage() const {
+    size_t result = 0;
+    for(auto it = _handlers.begin(); it != _handlers.end(); ++it) {
+        result += it->second->getMemoryUsage();
+    }
+    return result;
+}
+
+/**
+ * Evicts unused assets until every loader is within its memory limit
+ *
+ * Only assets that are referenced by nothing but this manager, and that
+ * were loaded from a file or directory entry, may be evicted. The least
+ * recently requested are evicted first. This method is called
+ * automatically at the end of {@link loadDirectory}, and whenever the
+ * materialization queue empties. It should also be called after a level
+ * transition releases its assets.
+ *
+ * This method should only be called on the main thread.
+ *
+ * @return the number of assets evicted
+ */
+size_t AssetManager::trim() {
+    size_t result = 0;
+    for(auto it = _handlers.begin(); it != _handlers.end(); ++it) {
+        result += it->second->trim();
+    }
+    if (result > 0) {
+        CULog("Evicted %zu assets to meet memory limits",result);
+    }
+    return result;
 }
 
 #pragma mark -
@@ -292,6 +485,7 @@ void AssetManager::resume() {
  * @return true if all assets specified in the directory were successfully loaded.
  */
 bool AssetManager::loadDirectory(const std::shared_ptr<JsonValue>& json) {
+    CU_PROFILE_SCOPE("AssetManager::loadDirectory");
     bool success = true;
     size_t entries = json->size();
 
@@ -325,6 +519,7 @@ bool AssetManager::loadDirectory(const std::shared_ptr<JsonValue>& json) {
         }
         curr = next;
     }
+    trim();
     return success;
 }
 
@@ -359,13 +554,13 @@ bool AssetManager::loadDirectory(const std::shared_ptr<JsonValue>& json) {
  * @return true if all assets specified in the directory were successfully loaded.
  */
 bool AssetManager::loadDirectory(const std::string directory) {
-    std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(directory);
-    if (reader == nullptr) {
+    std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(directory);
+    if (doc == nullptr) {
         CULogError("No asset directory located at '%s'",directory.c_str());
         return false;
     }
     
-    std::shared_ptr<JsonValue> json = reader->readJson();
+    std::shared_ptr<JsonValue> json = doc->getRoot().toJsonValue();
     return loadDirectory(json);
 }
 
@@ -394,7 +589,7 @@ bool AssetManager::loadDirectory(const std::string directory) {
  * As an asynchronous load, all asset loading will take place outside of
  * the main thread.  However, assets such as fonts and textures will need
  * the OpenGL context to complete, so part of their asset loading may take
- * place in the main thread via the {@link Application#schedule} interface.
+ * place in the main thread, limited by the frame budget {@see setFrameBudget}.
  * You may either poll this interface to determine when the assets are
  * loaded or use optional callbacks.
  *
@@ -407,40 +602,36 @@ bool AssetManager::loadDirectory(const std::string directory) {
  * @param callback  An optional callback after each asset is loaded
  */
 void AssetManager::loadDirectoryAsync(const std::shared_ptr<JsonValue>& json, LoaderCallback callback) {
-    size_t entries = json->size();
-    
-    // Process entries by priority
-    Uint32 curr = 0;
-    Uint32 next = 0;
-    Uint32 err  = 0;
-    while (entries > err) {
-        for(int ii = 0; ii < json->size(); ii++) {
-            std::shared_ptr<JsonValue> child = json->get(ii);
-            auto hash = _jsonKeys.find(child->key());
-            if (hash != _jsonKeys.end()) {
-                auto rank = _priority.find(child->key());
-                CUAssertLog(rank != _priority.end(), "AssetDirectory loaders are corrupted");
-                if (rank->second == curr) {
-                    readCategory(hash->second,child,callback);
-                    entries--;
-                } else if (rank->second > curr) {
-                    // We are looking for the NEXT available rank
-                    if (next == curr) {
-                        next = rank->second;
-                    } else if (rank->second < next) {
-                        next = rank->second;
-                    }
-                }
-            } else {
-                CULogError("Unknown asset category '%s'",child->key().c_str());
-                err++;
-            }
-        }
-        if (entries != err) {
-            curr = next;
-            sync();
+    // Group the categories into stages by priority
+    std::map<Uint32,std::vector<std::shared_ptr<JsonValue>>> ranks;
+    for(int ii = 0; ii < json->size(); ii++) {
+        std::shared_ptr<JsonValue> child = json->get(ii);
+        auto hash = _jsonKeys.find(child->key());
+        if (hash != _jsonKeys.end()) {
+            auto rank = _priority.find(child->key());
+            CUAssertLog(rank != _priority.end(), "AssetDirectory loaders are corrupted");
+            ranks[rank->second].push_back(child);
+        } else {
+            CULogError("Unknown asset category '%s'",child->key().c_str());
         }
     }
+    if (ranks.empty()) {
+        return;
+    }
+
+    auto stages  = std::make_shared<std::deque<std::vector<std::shared_ptr<JsonValue>>>>();
+    auto started = std::make_shared<std::vector<std::shared_ptr<BaseLoader>>>();
+    for(auto it = ranks.begin(); it != ranks.end(); ++it) {
+        stages->push_back(std::move(it->second));
+    }
+
+    // Categories of the same priority load together; later stages wait
+    _preload++;
+    if (advance(stages,started,callback)) {
+        Application::get()->schedule([=](void) {
+            return this->advance(stages,started,callback);
+        });
+    }
 }
 
 /**
@@ -463,7 +654,7 @@ void AssetManager::loadDirectoryAsync(const std::shared_ptr<JsonValue>& json, Lo
  * As an asynchronous load, all asset loading will take place outside of
  * the main thread.  However, assets such as fonts and textures will need
  * the OpenGL context to complete, so part of their asset loading may take
- * place in the main thread via the {@link Application#schedule} interface.
+ * place in the main thread, limited by the frame budget {@see setFrameBudget}.
  * You may either poll this interface to determine when the assets are
  * loaded or use optional callbacks.
  *
@@ -476,18 +667,24 @@ void AssetManager::loadDirectoryAsync(const std::shared_ptr<JsonValue>& json, Lo
  * @param callback  An optional callback after each asset is loaded
  */
 void AssetManager::loadDirectoryAsync(const std::string directory, LoaderCallback callback) {
-    _preload = true;
-    
-    std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(directory);
-    if (reader == nullptr && callback != nullptr) {
-        callback("",false);
-        return;
-    }
+    _preload++;
     
     _workers->addTask([=](void) {
-        std::shared_ptr<JsonValue> json = reader->readJson();
-        loadDirectoryAsync(json,callback);
-        _preload = false;
+        std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(directory);
+        std::shared_ptr<JsonValue> json = (doc == nullptr ? nullptr : doc->getRoot().toJsonValue());
+        if (json == nullptr) {
+            CULogError("No asset directory located at '%s'",directory.c_str());
+        }
+        // The loaders must be started on the main thread
+        Application::get()->schedule([=](void){
+            if (json != nullptr) {
+                this->loadDirectoryAsync(json,callback);
+            } else if (callback != nullptr) {
+                callback("",false);
+            }
+            _preload--;
+            return false;
+        });
     });
 }
 
@@ -528,13 +725,13 @@ bool AssetManager::unloadDirectory(const std::shared_ptr<JsonValue>& json) {
  * @param directory The path to the JSON asset directory
  */
 bool AssetManager::unloadDirectory(const std::string directory) {
-    std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(directory);
-    if (reader == nullptr) {
+    std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(directory);
+    if (doc == nullptr) {
         CULogError("No asset directory located at '%s'",directory.c_str());
         return false;
     }
     
-    std::shared_ptr<JsonValue> json = reader->readJson();
+    std::shared_ptr<JsonValue> json = doc->getRoot().toJsonValue();
     return unloadDirectory(json);
 }
 
@@ -578,5 +775,253 @@ size_t AssetManager::waitCount() const {
     for(auto it = _handlers.begin(); it != _handlers.end(); ++it) {
         result += it->second->waitCount();
     }
-    return _preload ? result+1 : result;
+    return result+_preload;
+}
+
+#pragma mark -
+#pragma mark Hot Reloading
+/**
+ * Sets whether assets are reloaded when their files change
+ *
+ * Hot reloading is intended for development builds, so that assets can
+ * be edited without restarting the application. The asset files are
+ * checked every reload period (on a worker thread). Only the assets read
+ * from a changed file are reloaded, through their loaders. Dependent
+ * assets, such as scene graphs using a reloaded texture or font, are
+ * updated to use the new asset instead of being reloaded. See
+ * {@link BaseLoader#rebind}.
+ *
+ * Reloaded assets are new objects. Any other references to the previous
+ * asset must be updated with the reload callback (see
+ * {@link setReloadCallback}).
+ *
+ * Note that file times are only precise to the second, and that assets
+ * loaded from an asset bundle or the Android APK never change. By
+ * default, hot reloading is off.
+ *
+ * @param value Whether assets are reloaded when their files change
+ */
+void AssetManager::setHotReload(bool value) {
+    if (_watcher) {
+        Application::get()->unschedule(_watcher);
+        _watcher = 0;
+    }
+    if (value != _watching) {
+        _stamps.clear();
+    }
+    _watching = value;
+    if (_watching) {
+        // The first check records the current file times
+        poll();
+        _watcher = Application::get()->schedule([this](void) {
+            return this->poll();
+        }, _period, _period);
+    }
+}
+
+/**
+ * Sets the time between checks for changed files, in milliseconds
+ *
+ * The default is 500 milliseconds.
+ *
+ * @param millis    The time between checks for changed files
+ */
+void AssetManager::setReloadPeriod(Uint32 millis) {
+    _period = millis;
+    if (_watching) {
+        setHotReload(true);
+    }
+}
+
+/**
+ * Returns the files read by the given loader to load the given asset
+ *
+ * The paths are normalized, and relative to the asset directory.
+ *
+ * @param loader    The loader for the asset
+ * @param source    The source of the asset
+ *
+ * @return the files read by the given loader to load the given asset
+ */
+std::vector<std::string> AssetManager::locate(const std::shared_ptr<BaseLoader>& loader,
+                                              const BaseLoader::Source& source) const {
+    std::vector<std::string> result;
+    if (source.json != nullptr) {
+        result = loader->locate(source.json);
+    } else if (!source.path.empty()) {
+        result.push_back(source.path);
+    }
+    for(auto it = result.begin(); it != result.end(); ++it) {
+        *it = filetool::normalize_path(*it);
+    }
+    return result;
+}
+
+/**
+ * Starts a check for changed asset files
+ *
+ * This method is called on the main thread every reload period while
+ * hot reloading is active. The files are checked by a worker thread.
+ * Any changed files are reloaded on the main thread, within the frame
+ * budget, by {@link invalidate}.
+ *
+ * @return true if hot reloading is still active
+ */
+bool AssetManager::poll() {
+    if (!_watching || _workers == nullptr) {
+        return _watching;
+    } else if (_scanning) {
+        return true;
+    }
+
+    std::unordered_set<std::string> seen;
+    std::shared_ptr<std::vector<std::string>> files = std::make_shared<std::vector<std::string>>();
+    for(auto it = _handlers.begin(); it != _handlers.end(); ++it) {
+        for(auto jt = it->second->_sources.begin(); jt != it->second->_sources.end(); ++jt) {
+            std::vector<std::string> paths = locate(it->second,jt->second);
+            for(auto kt = paths.begin(); kt != paths.end(); ++kt) {
+                if (seen.insert(*kt).second) {
+                    files->push_back(*kt);
+                }
+            }
+        }
+    }
+    if (files->empty()) {
+        return true;
+    }
+
+    _scanning = true;
+    _workers->addTask([=](void) {
+        std::shared_ptr<std::vector<Uint64>> stamps = std::make_shared<std::vector<Uint64>>();
+        stamps->reserve(files->size());
+        for(auto it = files->begin(); it != files->end(); ++it) {
+            stamps->push_back(filetool::file_timestamp(*it));
+        }
+        this->schedule([=](void) {
+            this->_scanning = false;
+            this->invalidate(*files,*stamps);
+            return false;
+        });
+    });
+    return true;
+}
+
+/**
+ * Reloads the assets of every file that changed since the last check
+ *
+ * A file seen for the first time is recorded, but not reloaded.
+ *
+ * @param files     The watched files
+ * @param stamps    The modification time of each file
+ */
+void AssetManager::invalidate(const std::vector<std::string>& files, const std::vector<Uint64>& stamps) {
+    if (!_watching) {
+        return;
+    }
+
+    std::vector<std::string> changed;
+    for(size_t ii = 0; ii < files.size(); ii++) {
+        auto it = _stamps.find(files[ii]);
+        if (it == _stamps.end()) {
+            _stamps.emplace(files[ii],stamps[ii]);
+        } else if (it->second != stamps[ii]) {
+            it->second = stamps[ii];
+            changed.push_back(files[ii]);
+        }
+    }
+    if (!changed.empty()) {
+        reloadFiles(changed);
+    }
+}
+
+/**
+ * Synchronously reloads every asset read from the given files
+ *
+ * The assets are reloaded in loader priority order, so that an asset is
+ * always reloaded before any asset of a lower priority.
+ *
+ * @param files     The normalized file paths, relative to the asset directory
+ *
+ * @return the number of assets successfully reloaded
+ */
+size_t AssetManager::reloadFiles(const std::vector<std::string>& files) {
+    std::unordered_set<std::string> lookup(files.begin(), files.end());
+
+    // Order by priority, as with directory stages (lower values come first)
+    std::multimap<Uint32,std::pair<size_t,std::string>> order;
+    for(auto it = _handlers.begin(); it != _handlers.end(); ++it) {
+        for(auto jt = it->second->_sources.begin(); jt != it->second->_sources.end(); ++jt) {
+            std::vector<std::string> paths = locate(it->second,jt->second);
+            for(auto kt = paths.begin(); kt != paths.end(); ++kt) {
+                if (lookup.find(*kt) != lookup.end()) {
+                    order.emplace(it->second->getPriority(),std::make_pair(it->first,jt->first));
+                    break;
+                }
+            }
+        }
+    }
+
+    size_t count = 0;
+    for(auto it = order.begin(); it != order.end(); ++it) {
+        if (refresh(it->second.first,it->second.second)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Synchronously reloads every asset read from the given file.
+ *
+ * The assets are reloaded in loader priority order, and their dependent
+ * assets are updated to use the new assets. This is the method used by
+ * hot reloading when a file changes. It may be used whether or not hot
+ * reloading is active.
+ *
+ * @param file  The file path, relative to the asset directory
+ *
+ * @return the number of assets successfully reloaded
+ */
+size_t AssetManager::reloadFile(const std::string file) {
+    std::vector<std::string> files;
+    files.push_back(filetool::normalize_path(file));
+    return reloadFiles(files);
+}
+
+/**
+ * Synchronously reloads the given asset, rebinding its dependents
+ *
+ * If the asset is successfully reloaded, every attached loader is given
+ * the chance to replace the previous asset with the new one (see
+ * {@link BaseLoader#rebind}). The reload callback is invoked either way.
+ *
+ * @param hash  The hash of the asset type
+ * @param key   The key associated with the asset
+ *
+ * @return true if the asset was successfully reloaded
+ */
+bool AssetManager::refresh(size_t hash, const std::string key) {
+    auto it = _handlers.find(hash);
+    if (it == _handlers.end()) {
+        return false;
+    }
+
+    std::shared_ptr<void> previous;
+    std::shared_ptr<void> current;
+    bool success = it->second->refresh(key,previous,current);
+    if (success) {
+        if (previous != nullptr) {
+            for(auto jt = _handlers.begin(); jt != _handlers.end(); ++jt) {
+                jt->second->rebind(hash,previous,current);
+            }
+        }
+        CULog("Reloaded asset '%s'",key.c_str());
+    } else {
+        CUWarn("Could not reload asset '%s'",key.c_str());
+    }
+
+    if (_onreload) {
+        _onreload(key,success);
+    }
+    return success;
 }
@@ -45,6 +45,7 @@
 //
 #include <cugl/assets/CUFontLoader.h>
 #include <cugl/base/CUApplication.h>
+#include <cugl/util/CUProfiler.h>
 #include <SDL_ttf.h>
 
 using namespace cugl;
@@ -70,6 +71,7 @@ _fontsize(UNKNOWN_SIZE),
 _charset(UNKNOWN_CHARS) {
     _jsonKey  = "fonts";
     _priority = 0;
+    _serial   = true; // SDL_ttf is not thread-safe
 }
 
 
@@ -90,6 +92,8 @@ _charset(UNKNOWN_CHARS) {
  * @return the font asset with no generated atlas
  */
 std::shared_ptr<Font> FontLoader::preload(const std::string source, const std::string charset, int size) {
+    CU_PROFILE_SCOPE("FontLoader::preload");
+    CU_PROFILE_DETAIL(source);
     std::shared_ptr<Font> result = Font::alloc(source.c_str(),size);
     if (result == nullptr) {
         return result;
@@ -119,6 +123,8 @@ std::shared_ptr<Font> FontLoader::preload(const std::string source, const std::s
  *      "size":         This font size (int)
  *      "charset":      The set of characters for the font atlas (string)
  *      "padding":      The atlas padding (to prevent blur bleedthrough)
+ *      "distance":     Whether to use signed distance field atlases (bool)
+ *      "paging":       Whether to add missing glyphs to the atlases on demand (bool)
  *      "hinting":      The rendering hints ("normal", "light", "mono", "none")
  *      "bold":         Whether to make the font an (ad hoc) bold
  *      "italic":       Whether to make the font an (ad hoc) italic
@@ -135,6 +141,8 @@ std::shared_ptr<Font> FontLoader::preload(const std::shared_ptr<JsonValue>& json
     std::string source  = json->getString("file",UNKNOWN_SOURCE);
     std::string charset = json->getString("charset",_charset);
     int size = json->getInt("size",_fontsize);
+    CU_PROFILE_SCOPE("FontLoader::preload");
+    CU_PROFILE_DETAIL(source);
     
     Font::Style style = json->getBool("bold",false) ? Font::Style::BOLD : Font::Style::NORMAL;
     style = style | (json->getBool("italic",false) ? Font::Style::ITALIC : Font::Style::NORMAL);
@@ -152,6 +160,8 @@ std::shared_ptr<Font> FontLoader::preload(const std::shared_ptr<JsonValue>& json
     }
     
     Uint32 padding = json->getInt("padding",0);
+    bool distance  = json->getBool("distance",false);
+    bool paging    = json->getBool("paging",false);
     Uint32 stretch = json->getInt("stretch",0);
     Uint32 shrink  = json->getInt("shrink", 0);
 
@@ -163,6 +173,8 @@ std::shared_ptr<Font> FontLoader::preload(const std::shared_ptr<JsonValue>& json
     result->setStyle(style);
     result->setHinting(hinting);
     result->setPadding(padding);
+    result->setDistanceField(distance);
+    result->setAtlasPaging(paging);
     result->setStretchLimit(stretch);
     result->setShrinkLimit(shrink);
     if (charset.empty()) {
@@ -245,7 +257,7 @@ bool FontLoader::read(const std::string key, const std::string source, int size,
     } else {
         _loader->addTask([=](void) {
             std::shared_ptr<Font> font = this->preload(source,_charset,size);
-            Application::get()->schedule([=](void){
+            this->schedule([=](void){
                 this->materialize(key,font,callback);
                 return false;
             });
@@ -273,6 +285,8 @@ bool FontLoader::read(const std::string key, const std::string source, int size,
  *      "size":         This font size (int)
  *      "charset":      The set of characters for the font atlas (string)
  *      "padding":      The atlas padding (to prevent blur bleedthrough)
+ *      "distance":     Whether to use signed distance field atlases (bool)
+ *      "paging":       Whether to add missing glyphs to the atlases on demand (bool)
  *      "hinting":        The rendering hints ("normal", "light", "mono", "none")
  *      "bold":          Whether to make the font an (ad hoc) bold
  *      "italic":          Whether to make the font an (ad hoc) italic
@@ -304,7 +318,7 @@ bool FontLoader::read(const std::shared_ptr<JsonValue>& json, LoaderCallback cal
     } else {
         _loader->addTask([=](void) {
             std::shared_ptr<Font> font = this->preload(json);
-            Application::get()->schedule([=](void){
+            this->schedule([=](void){
                 this->materialize(key,font,callback);
                 return false;
             });
@@ -313,3 +327,25 @@ bool FontLoader::read(const std::shared_ptr<JsonValue>& json, LoaderCallback cal
     
     return success;
 }
+
+/**
+ * Returns the estimated GPU memory used by the given font in bytes
+ *
+ * This is the size of the font atlas textures. A font with no atlases
+ * has size 0.
+ *
+ * @param asset The font to measure
+ *
+ * @return the estimated GPU memory used by the given font in bytes
+ */
+size_t FontLoader::measure(const std::shared_ptr<Font>& asset) const {
+    size_t result = 0;
+    if (asset == nullptr) {
+        return result;
+    }
+    std::vector<std::shared_ptr<Texture>> atlases = asset->getAtlases();
+    for(auto it = atlases.begin(); it != atlases.end(); ++it) {
+        result += (size_t)(*it)->getWidth()*(*it)->getHeight()*(*it)->getByteSize();
+    }
+    return result;
+}
@@ -0,0 +1,1294 @@
+//
+//  CUJsonDocument.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a read-only alternative to JsonValue for very large
+//  JSON files, such as level files. Unlike JsonValue, it does not build a tree
+//  of shared pointers. Instead, the parser makes a single pass over the JSON,
+//  writing the nodes into a single contiguous arena. Strings (and keys) are
+//  views into the source buffer, which the document owns. Escape sequences
+//  are decoded in place, so parsing never allocates a string.
+//
+//  The nodes are accessed through JsonView, which is a lightweight handle that
+//  presents the same read API as JsonValue. This view is only valid as long as
+//  the document that created it.
+//
+//  A document can also be saved in (and loaded from) a compiled binary format,
+//  which is the arena and string table written out directly. Loading this
+//  format requires no parsing at all. By convention, these files have the
+//  extension .cbin, and are placed next to the .json file they replace.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/assets/CUJsonDocument.h>
+#include <cugl/util/CUDebug.h>
+#include <cugl/util/CUStrings.h>
+#include <cugl/util/CUFiletools.h>
+#include <cugl/util/CUProfiler.h>
+#include <cugl/io/CUJsonReader.h>
+#include <cugl/io/CUAssetBundle.h>
+#include <cugl/base/CUApplication.h>
+#include <unordered_map>
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+
+using namespace cugl;
+
+/** The maximum nesting depth of arrays and objects (same as cJSON) */
+#define MAX_DEPTH   1000
+/** The magic number identifying a compiled binary document */
+#define CBIN_MAGIC      "CBIN"
+/** The current version of the compiled binary format */
+#define CBIN_VERSION    1
+/** The size of the binary header in bytes */
+#define CBIN_HEADER     32
+/** The size of a binary node entry in bytes */
+#define CBIN_ENTRY      32
+
+/**
+ * Returns the value of the given hexadecimal digit, or -1 if it is not one
+ *
+ * @param c     The hexadecimal digit
+ *
+ * @return the value of the given hexadecimal digit, or -1 if it is not one
+ */
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c-'0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c-'a'+10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c-'A'+10;
+    }
+    return -1;
+}
+
+/**
+ * Returns the code unit of the four hexadecimal digits at data, or -1 if invalid
+ *
+ * @param data  The hexadecimal digits
+ *
+ * @return the code unit of the four hexadecimal digits at data, or -1 if invalid
+ */
+static long hex_unit(const char* data) {
+    long result = 0;
+    for(int ii = 0; ii < 4; ii++) {
+        int digit = hex_digit(data[ii]);
+        if (digit < 0) {
+            return -1;
+        }
+        result = (result << 4) | digit;
+    }
+    return result;
+}
+
+/**
+ * Writes the code point as UTF-8, returning the number of bytes written
+ *
+ * @param code  The unicode code point
+ * @param out   The buffer to write to
+ *
+ * @return the number of bytes written
+ */
+static size_t utf8_encode(Uint32 code, char* out) {
+    if (code < 0x80) {
+        out[0] = (char)code;
+        return 1;
+    } else if (code < 0x800) {
+        out[0] = (char)(0xC0 | (code >> 6));
+        out[1] = (char)(0x80 | (code & 0x3F));
+        return 2;
+    } else if (code < 0x10000) {
+        out[0] = (char)(0xE0 | (code >> 12));
+        out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (code & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (code >> 18));
+    out[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (code & 0x3F));
+    return 4;
+}
+
+/**
+ * Parses the number at data, returning the number of characters read
+ *
+ * Numbers with at most 15 significant digits and a small exponent are
+ * converted exactly by hand, which is the bulk of the numbers in a typical
+ * level file. All other numbers fall back to strtool::from_chars, which
+ * (unlike strtod) is independent of the locale. This function returns 0 if
+ * there is no number at data.
+ *
+ * @param data  The (null-terminated) number string
+ * @param value The variable to store the result
+ *
+ * @return the number of characters read
+ */
+static size_t parse_number(const char* data, double& value) {
+    static const double POWERS[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* pos = data;
+    bool negate = *pos == '-';
+    if (negate) {
+        pos++;
+    }
+    if (*pos < '0' || *pos > '9') {
+        return 0;
+    }
+
+    Uint64 mantissa = 0;
+    int digits = 0;
+    int scale  = 0;
+    while (*pos >= '0' && *pos <= '9') {
+        if (digits < 18) {
+            mantissa = mantissa*10+(*pos-'0');
+            digits += mantissa > 0;
+        } else {
+            scale++;
+        }
+        pos++;
+    }
+    if (*pos == '.') {
+        pos++;
+        while (*pos >= '0' && *pos <= '9') {
+            if (digits < 18) {
+                mantissa = mantissa*10+(*pos-'0');
+                digits += mantissa > 0;
+                scale--;
+            }
+            pos++;
+        }
+    }
+    if (*pos == 'e' || *pos == 'E') {
+        const char* mark = pos++;
+        bool minus = *pos == '-';
+        if (*pos == '-' || *pos == '+') {
+            pos++;
+        }
+        if (*pos < '0' || *pos > '9') {
+            pos = mark;
+        } else {
+            int exponent = 0;
+            while (*pos >= '0' && *pos <= '9') {
+                exponent = std::min(exponent*10+(*pos-'0'),100000);
+                pos++;
+            }
+            scale += minus ? -exponent : exponent;
+        }
+    }
+
+    if (digits <= 15 && scale >= -22 && scale <= 22) {
+        double result = (double)mantissa;
+        result = scale < 0 ? result/POWERS[-scale] : result*POWERS[scale];
+        value = negate ? -result : result;
+        return pos-data;
+    }
+
+    return strtool::from_chars(data,pos-data,value);
+}
+
+/**
+ * Returns the little-endian 32 bit integer at the given address
+ *
+ * @param data  The address to read
+ *
+ * @return the little-endian 32 bit integer at the given address
+ */
+static Uint32 read_uint32(const Uint8* data) {
+    Uint32 value;
+    std::memcpy(&value,data,sizeof(Uint32));
+    return SDL_SwapLE32(value);
+}
+
+/**
+ * Writes a 32 bit integer in little-endian order to the given address
+ *
+ * @param data  The address to write
+ * @param value The value to write
+ */
+static void write_uint32(Uint8* data, Uint32 value) {
+    value = SDL_SwapLE32(value);
+    std::memcpy(data,&value,sizeof(Uint32));
+}
+
+/**
+ * Returns the little-endian double at the given address
+ *
+ * @param data  The address to read
+ *
+ * @return the little-endian double at the given address
+ */
+static double read_double(const Uint8* data) {
+    Uint64 bits;
+    std::memcpy(&bits,data,sizeof(Uint64));
+    bits = SDL_SwapLE64(bits);
+    double value;
+    std::memcpy(&value,&bits,sizeof(double));
+    return value;
+}
+
+/**
+ * Writes a double in little-endian order to the given address
+ *
+ * @param data  The address to write
+ * @param value The value to write
+ */
+static void write_double(Uint8* data, double value) {
+    Uint64 bits;
+    std::memcpy(&bits,&value,sizeof(double));
+    bits = SDL_SwapLE64(bits);
+    std::memcpy(data,&bits,sizeof(Uint64));
+}
+
+/**
+ * Returns the compiled binary file for the given JSON file
+ *
+ * If the file does not end in .json, this function returns the empty string.
+ *
+ * @param file  The JSON file name
+ *
+ * @return the compiled binary file for the given JSON file
+ */
+static std::string binary_path(const std::string& file) {
+    size_t dot = file.rfind('.');
+    if (dot == std::string::npos || strtool::tolower(file.substr(dot)) != ".json") {
+        return "";
+    }
+    return file.substr(0,dot)+".cbin";
+}
+
+#pragma mark -
+#pragma mark JsonView Type
+/**
+ * Returns the type of this node.
+ *
+ * An invalid view has type NullType.
+ *
+ * @return the type of this node.
+ */
+JsonValue::Type JsonView::type() const {
+    if (_document == nullptr) {
+        return JsonValue::Type::NullType;
+    }
+    return _document->_nodes[_index].type;
+}
+
+/**
+ * Returns true if this node is not NULL nor an array or object.
+ *
+ * @return true if this node is not NULL nor an array or object.
+ */
+bool JsonView::isValue() const {
+    switch (type()) {
+        case JsonValue::Type::StringType:
+        case JsonValue::Type::NumberType:
+        case JsonValue::Type::BoolType:
+            return true;
+        default:
+            break;
+    }
+    return false;
+}
+
+#pragma mark -
+#pragma mark JsonView Value Access
+/**
+ * Returns this node as a string view into the document buffer.
+ *
+ * If the node is not a StringType, this returns an empty view.
+ *
+ * @return this node as a string view into the document buffer.
+ */
+std::string_view JsonView::view() const {
+    if (!isString()) {
+        return std::string_view();
+    }
+    const JsonDocument::Entry& entry = _document->_nodes[_index];
+    return std::string_view(_document->_source.data()+entry.start,entry.size);
+}
+
+/**
+ * Returns this node as a string.
+ *
+ * This method will fail if the node is not a value type.  Otherwise, if
+ * the node is not a StringType, it will return the default value instead.
+ *
+ * @param defaultValue  The value to return if the node is not a string
+ *
+ * @return this node as a string.
+ */
+std::string JsonView::asString(const std::string defaultValue) const {
+    CUAssertLog(isValue() || isNull(), "JSON node is not a value type");
+    switch (type()) {
+        case JsonValue::Type::NullType:
+            return std::string("NULL");
+        case JsonValue::Type::BoolType:
+            return std::string(asBool() ? "true" : "false");
+        case JsonValue::Type::NumberType:
+        {
+            double value = asDouble();
+            if (asLong() == value) {
+                return cugl::strtool::to_string((Sint64)asLong());
+            } else {
+                return cugl::strtool::to_string(value);
+            }
+        }
+        case JsonValue::Type::StringType:
+            return std::string(view());
+        default:
+            return std::string(defaultValue);
+    }
+    return std::string(defaultValue);
+}
+
+/**
+ * Returns this node as a float.
+ *
+ * This method will fail if the node is not a value type.  Otherwise, if
+ * the node is not a NumberType, it will return the default value instead.
+ *
+ * @param defaultValue  The value to return if the node is not a number
+ *
+ * @return this node as a float.
+ */
+float JsonView::asFloat(float defaultValue) const {
+    return (float)asDouble(defaultValue);
+}
+
+/**
+ * Returns this node as a double.
+ *
+ * This method will fail if the node is not a value type.  Otherwise, if
+ * the node is not a NumberType, it will return the default value instead.
+ *
+ * @param defaultValue  The value to return if the node is not a number
+ *
+ * @return this node as a double.
+ */
+double JsonView::asDouble(double defaultValue) const {
+    CUAssertLog(isValue() || isNull(), "JSON node is not a value type");
+    if (isNumber()) {
+        return _document->_nodes[_index].number;
+    }
+    return defaultValue;
+}
+
+/**
+ * Returns this node as a long.
+ *
+ * This method will fail if the node is not a value type.  Otherwise, if
+ * the node is not a NumberType, it will return the default value instead.
+ *
+ * @param defaultValue  The value to return if the node is not a number
+ *
+ * @return this node as a long.
+ */
+long JsonView::asLong(long defaultValue) const {
+    CUAssertLog(isValue() || isNull(), "JSON node is not a value type");
+    if (isNumber()) {
+        double value = _document->_nodes[_index].number;
+        if (value >= (double)std::numeric_limits<long>::max()) {
+            return std::numeric_limits<long>::max();
+        } else if (value <= (double)std::numeric_limits<long>::min()) {
+            return std::numeric_limits<long>::min();
+        }
+        return (long)value;
+    }
+    return defaultValue;
+}
+
+/**
+ * Returns this node as a int.
+ *
+ * This method will fail if the node is not a value type.  Otherwise, if
+ * the node is not a NumberType, it will return the default value instead.
+ *
+ * @param defaultValue  The value to return if the node is not a number
+ *
+ * @return this node as a int.
+ */
+int JsonView::asInt(int defaultValue) const {
+    return (int)asLong(defaultValue);
+}
+
+/**
+ * Returns this node as a bool.
+ *
+ * This method will fail if the node is not a value type.  Otherwise, if
+ * the node is not a BoolType, it will return the default value instead.
+ *
+ * @param defaultValue  The value to return if the node is not a boolean
+ *
+ * @return this node as a bool.
+ */
+bool JsonView::asBool(bool defaultValue) const {
+    CUAssertLog(isValue() || isNull(), "JSON node is not a value type");
+    if (isBool()) {
+        return _document->_nodes[_index].number != 0;
+    }
+    return defaultValue;
+}
+
+#pragma mark -
+#pragma mark JsonView Child Access
+/**
+ * Returns the number of children of this node.
+ *
+ * This is 0 for any node that is not an array or object.
+ *
+ * @return the number of children of this node.
+ */
+size_t JsonView::size() const {
+    if (isArray() || isObject()) {
+        return _document->_nodes[_index].size;
+    }
+    return 0;
+}
+
+/**
+ * Returns the key for this object value.
+ *
+ * If this node is not the child of an object, this returns an empty view.
+ *
+ * @return the key for this object value.
+ */
+std::string_view JsonView::key() const {
+    if (_document == nullptr) {
+        return std::string_view();
+    }
+    const JsonDocument::Entry& entry = _document->_nodes[_index];
+    return std::string_view(_document->_source.data()+entry.key,entry.keylen);
+}
+
+/**
+ * Returns true if a child with the specified name exists.
+ *
+ * This method will always return false if the node is not an object type
+ *
+ * @param key   The key identifying the child
+ *
+ * @return true if a child with the specified name exists.
+ */
+bool JsonView::has(std::string_view key) const {
+    CUAssertLog(isObject(), "Node is not an object type");
+    return (bool)get(key);
+}
+
+/**
+ * Returns the child at the specified index.
+ *
+ * This method will fail if the node is not an array or object type.
+ * If the index is out of bounds, this method returns an invalid view.
+ *
+ * @param index The index into the child array.
+ *
+ * @return the child at the specified index.
+ */
+JsonView JsonView::get(size_t index) const {
+    CUAssertLog(isArray() || isObject(), "Node is a value type");
+    CUAssertLog(index < size(), "Index %zu out of range", index);
+    if (index >= size()) {
+        return JsonView();
+    }
+    return JsonView(_document,_document->_nodes[_index].start+index);
+}
+
+/**
+ * Returns the child with the specified key.
+ *
+ * This method will fail if the node is not an object type. If there is no
+ * child with this key, the method returns an invalid view. If there is more
+ * than one child of this name, it will return the first one.
+ *
+ * @param key   The key identifying the child.
+ *
+ * @return the child with the specified key.
+ */
+JsonView JsonView::get(std::string_view key) const {
+    CUAssertLog(isObject(), "Node is not an object type");
+    if (!isObject()) {
+        return JsonView();
+    }
+    const JsonDocument::Entry& entry = _document->_nodes[_index];
+    const char* source = _document->_source.data();
+    for(size_t ii = entry.start; ii < entry.start+entry.size; ii++) {
+        const JsonDocument::Entry& child = _document->_nodes[ii];
+        if (child.keylen == key.size() && std::memcmp(source+child.key,key.data(),key.size()) == 0) {
+            return JsonView(_document,ii);
+        }
+    }
+    return JsonView();
+}
+
+#pragma mark -
+#pragma mark JsonView Child Values
+/**
+ * Returns the string value of the child with the specified key.
+ *
+ * If there is no child with the given key, or if that child cannot be
+ * represented as a string value, it returns the default value instead.
+ *
+ * @param key           The key identifying the child
+ * @param defaultValue  The value to use if child does not exist or is not a string
+ *
+ * @return the string value of the child with the specified key.
+ */
+std::string JsonView::getString(std::string_view key, const std::string defaultValue) const {
+    JsonView child = get(key);
+    return child.isValue() ? child.asString(defaultValue) : std::string(defaultValue);
+}
+
+/**
+ * Returns the float value of the child with the specified key.
+ *
+ * If there is no child with the given key, or if that child cannot be
+ * represented as a numeric value, it returns the default value instead.
+ *
+ * @param key           The key identifying the child
+ * @param defaultValue  The value to use if child does not exist or is not a number
+ *
+ * @return the float value of the child with the specified key.
+ */
+float JsonView::getFloat(std::string_view key, float defaultValue) const {
+    JsonView child = get(key);
+    return child.isNumber() ? child.asFloat(defaultValue) : defaultValue;
+}
+
+/**
+ * Returns the double value of the child with the specified key.
+ *
+ * If there is no child with the given key, or if that child cannot be
+ * represented as a numeric value, it returns the default value instead.
+ *
+ * @param key           The key identifying the child
+ * @param defaultValue  The value to use if child does not exist or is not a number
+ *
+ * @return the double value of the child with the specified key.
+ */
+double JsonView::getDouble(std::string_view key, double defaultValue) const {
+    JsonView child = get(key);
+    return child.isNumber() ? child.asDouble(defaultValue) : defaultValue;
+}
+
+/**
+ * Returns the long value of the child with the specified key.
+ *
+ * If there is no child with the given key, or if that child cannot be
+ * represented as a numeric value, it returns the default value instead.
+ *
+ * @param key           The key identifying the child
+ * @param defaultValue  The value to use if child does not exist or is not a number
+ *
+ * @return the long value of the child with the specified key.
+ */
+long JsonView::getLong(std::string_view key, long defaultValue) const {
+    JsonView child = get(key);
+    return child.isNumber() ? child.asLong(defaultValue) : defaultValue;
+}
+
+/**
+ * Returns the int value of the child with the specified key.
+ *
+ * If there is no child with the given key, or if that child cannot be
+ * represented as a numeric value, it returns the default value instead.
+ *
+ * @param key           The key identifying the child
+ * @param defaultValue  The value to use if child does not exist or is not a number
+ *
+ * @return the int value of the child with the specified key.
+ */
+int JsonView::getInt(std::string_view key, int defaultValue) const {
+    JsonView child = get(key);
+    return child.isNumber() ? child.asInt(defaultValue) : defaultValue;
+}
+
+/**
+ * Returns the boolean value of the child with the specified key.
+ *
+ * If there is no child with the given key, or if that child cannot be
+ * represented as a boolean value, it returns the default value instead.
+ *
+ * @param key           The key identifying the child
+ * @param defaultValue  The value to use if child does not exist or is not a boolean
+ *
+ * @return the boolean value of the child with the specified key.
+ */
+bool JsonView::getBool(std::string_view key, bool defaultValue) const {
+    JsonView child = get(key);
+    return child.isBool() ? child.asBool(defaultValue) : defaultValue;
+}
+
+#pragma mark -
+#pragma mark JsonView Conversion
+/**
+ * Returns a newly allocated JsonValue equivalent to this node
+ *
+ * This method copies the entire subtree of this node. It is intended for
+ * code that still requires a JsonValue, such as the data of a single
+ * scene in a large level file.
+ *
+ * @return a newly allocated JsonValue equivalent to this node
+ */
+std::shared_ptr<JsonValue> JsonView::toJsonValue() const {
+    return JsonValue::allocWithView(*this);
+}
+
+#pragma mark -
+#pragma mark JsonDocument
+/**
+ * Creates an empty document.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+JsonDocument::JsonDocument() :
+_root(0),
+_offset(0) {
+}
+
+/**
+ * Disposes all of the resources used by this document.
+ *
+ * All views of this document are invalid after this method is called.
+ */
+void JsonDocument::dispose() {
+    _source.clear();
+    _source.shrink_to_fit();
+    _nodes.clear();
+    _nodes.shrink_to_fit();
+    _stack.clear();
+    _stack.shrink_to_fit();
+    _root = 0;
+    _offset = 0;
+}
+
+/**
+ * Initializes a new document from the given JSON string.
+ *
+ * The document makes a copy of the string to use as its buffer.
+ *
+ * If there is a parsing error, this method will return false.  Detailed
+ * information about the parsing error will be passed to an assert.  Hence
+ * error messages are suppressed if asserts are turned off.
+ *
+ * @param json  The JSON string to parse.
+ *
+ * @return true if the document is initialized properly, false otherwise.
+ */
+bool JsonDocument::initWithJson(const std::string& json) {
+    return initWithJson(std::string(json));
+}
+
+/**
+ * Initializes a new document from the given JSON string.
+ *
+ * The document acquires the string to use as its buffer, so no copy is made.
+ *
+ * If there is a parsing error, this method will return false.  Detailed
+ * information about the parsing error will be passed to an assert.  Hence
+ * error messages are suppressed if asserts are turned off.
+ *
+ * @param json  The JSON string to parse.
+ *
+ * @return true if the document is initialized properly, false otherwise.
+ */
+bool JsonDocument::initWithJson(std::string&& json) {
+    if (!_nodes.empty()) {
+        CUAssertLog(false, "Document is already initialized");
+        return false;
+    }
+    CU_PROFILE_SCOPE("JsonDocument::parse");
+    CU_PROFILE_BYTES(json.size());
+    _source = std::move(json);
+    if (parse()) {
+        return true;
+    }
+    dispose();
+    return false;
+}
+
+/**
+ * Initializes a new document from the given compiled binary data.
+ *
+ * See the class description for the binary format. The data is copied
+ * into the arena and string table, with no parsing. If the data is not
+ * a valid binary document, this method returns false.
+ *
+ * @param data  The binary data
+ * @param size  The number of bytes of data
+ *
+ * @return true if the document is initialized properly, false otherwise.
+ */
+bool JsonDocument::initWithBinary(const Uint8* data, size_t size) {
+    CU_PROFILE_SCOPE("JsonDocument::decode");
+    CU_PROFILE_BYTES(size);
+    if (!_nodes.empty()) {
+        CUAssertLog(false, "Document is already initialized");
+        return false;
+    }
+    if (data == nullptr || size < CBIN_HEADER || std::memcmp(data,CBIN_MAGIC,4)) {
+        CUAssertLog(false, "Data is not a compiled JSON document");
+        return false;
+    }
+    if (read_uint32(data+4) != CBIN_VERSION) {
+        CUAssertLog(false, "Unsupported compiled JSON version %u",read_uint32(data+4));
+        return false;
+    }
+
+    size_t count = read_uint32(data+8);
+    size_t root  = read_uint32(data+12);
+    size_t bytes = read_uint32(data+16);
+    if (count == 0 || root >= count || CBIN_HEADER+count*CBIN_ENTRY+bytes != size) {
+        CUAssertLog(false, "Compiled JSON document is truncated or corrupt");
+        return false;
+    }
+
+    // Decode field by field so that byte order and padding never matter
+    _nodes.resize(count);
+    const Uint8* next = data+CBIN_HEADER;
+    for(size_t ii = 0; ii < count; ii++) {
+        Uint32 type = read_uint32(next);
+        Entry& entry = _nodes[ii];
+        entry.type   = (JsonValue::Type)(type > (Uint32)JsonValue::Type::ObjectType ? 0xff : type);
+        entry.key    = read_uint32(next+4);
+        entry.keylen = read_uint32(next+8);
+        entry.start  = read_uint32(next+12);
+        entry.size   = read_uint32(next+16);
+        entry.number = read_double(next+24);
+        next += CBIN_ENTRY;
+    }
+    _source.assign((const char*)next,bytes);
+    _root = root;
+
+    if (validate()) {
+        return true;
+    }
+    CUAssertLog(false, "Compiled JSON document is truncated or corrupt");
+    dispose();
+    return false;
+}
+
+/**
+ * Initializes a new document from the given asset file.
+ *
+ * This initializer assumes that the file name is a relative path. It will
+ * search the application assert directory {@see Application#getAssetDirectory()}
+ * for the file. If the file ends in .json, and there is a file of the same
+ * name ending in .cbin, it will load that compiled file instead. Otherwise,
+ * it parses the JSON file.
+ *
+ * If there is a parsing error, this method will return false.  Detailed
+ * information about the parsing error will be passed to an assert.  Hence
+ * error messages are suppressed if asserts are turned off.
+ *
+ * @param file  The relative path to the file
+ *
+ * @return true if the document is initialized properly, false otherwise.
+ */
+bool JsonDocument::initWithAsset(const std::string& file) {
+    CU_PROFILE_SCOPE("JsonDocument::load");
+    CU_PROFILE_DETAIL(file);
+    std::string compiled = binary_path(file);
+    if (!compiled.empty()) {
+        std::string path = Application::get()->getAssetDirectory();
+        path.append(compiled);
+        path = filetool::normalize_path(path);
+
+        SDL_RWops* stream = AssetBundle::openStream(path);
+        if (stream) {
+            Sint64 size = SDL_RWsize(stream);
+            std::vector<Uint8> data(size > 0 ? (size_t)size : 0);
+            size_t read = data.empty() ? 0 : SDL_RWread(stream, data.data(), 1, data.size());
+            SDL_RWclose(stream);
+            if (read == data.size() && initWithBinary(data.data(), data.size())) {
+                return true;
+            }
+            CUWarn("Could not load %s; falling back to %s",compiled.c_str(),file.c_str());
+        }
+    }
+
+    std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(file);
+    if (reader == nullptr) {
+        return false;
+    }
+    std::string json = reader->readJsonString();
+    reader->close();
+    return !json.empty() && initWithJson(std::move(json));
+}
+
+/**
+ * Returns a view of the root node of this document.
+ *
+ * If the document is not initialized, this returns an invalid view.
+ *
+ * @return a view of the root node of this document.
+ */
+JsonView JsonDocument::getRoot() const {
+    if (_nodes.empty()) {
+        return JsonView();
+    }
+    return JsonView(this,_root);
+}
+
+#pragma mark -
+#pragma mark Parsing
+/**
+ * Parses the source buffer, returning true if successful
+ *
+ * @return true if the source buffer was parsed successfully
+ */
+bool JsonDocument::parse() {
+    // A rough guess that avoids most reallocation
+    _nodes.reserve(_source.size()/8+1);
+    _offset = 0;
+
+    Entry root;
+    root.key = 0;
+    root.keylen = 0;
+    skip();
+    bool success = parseValue(root,0);
+    if (success) {
+        _root = _nodes.size();
+        _nodes.push_back(root);
+    }
+    _stack.clear();
+    _stack.shrink_to_fit();
+    return success;
+}
+
+/**
+ * Advances the parse position past any whitespace
+ */
+void JsonDocument::skip() {
+    const char* data = _source.data();
+    size_t size = _source.size();
+    while (_offset < size && (unsigned char)data[_offset] <= 32) {
+        _offset++;
+    }
+}
+
+/**
+ * Parses the value at the current position into the given entry
+ *
+ * This does not set the key of the entry.
+ *
+ * @param entry The entry to store the result
+ * @param depth The current nesting depth
+ *
+ * @return true if the value was parsed successfully
+ */
+bool JsonDocument::parseValue(Entry& entry, int depth) {
+    if (_offset >= _source.size()) {
+        return error();
+    }
+
+    const char* data = _source.data()+_offset;
+    size_t left = _source.size()-_offset;
+    entry.start  = 0;
+    entry.size   = 0;
+    entry.number = 0;
+    switch (*data) {
+        case '{':
+        case '[':
+            return parseContainer(entry,depth);
+        case '"':
+            entry.type = JsonValue::Type::StringType;
+            return parseString(entry.start,entry.size);
+        case 't':
+            if (left >= 4 && std::strncmp(data,"true",4) == 0) {
+                entry.type = JsonValue::Type::BoolType;
+                entry.number = 1;
+                _offset += 4;
+                return true;
+            }
+            break;
+        case 'f':
+            if (left >= 5 && std::strncmp(data,"false",5) == 0) {
+                entry.type = JsonValue::Type::BoolType;
+                _offset += 5;
+                return true;
+            }
+            break;
+        case 'n':
+            if (left >= 4 && std::strncmp(data,"null",4) == 0) {
+                entry.type = JsonValue::Type::NullType;
+                _offset += 4;
+                return true;
+            }
+            break;
+        default:
+            {
+                size_t amt = parse_number(data,entry.number);
+                if (amt > 0) {
+                    entry.type = JsonValue::Type::NumberType;
+                    _offset += amt;
+                    return true;
+                }
+            }
+            break;
+    }
+    return error();
+}
+
+/**
+ * Parses the string at the current position
+ *
+ * The string is decoded in place, so this method records the offset and
+ * length of the decoded string in the source buffer.
+ *
+ * @param start The variable to store the string offset
+ * @param size  The variable to store the string length
+ *
+ * @return true if the string was parsed successfully
+ */
+bool JsonDocument::parseString(Uint32& start, Uint32& size) {
+    char* data = &_source[0];
+    size_t total = _source.size();
+    size_t read  = _offset+1;
+    size_t write = read;
+    start = (Uint32)read;
+    while (read < total && data[read] != '"') {
+        if (data[read] != '\\') {
+            data[write++] = data[read++];
+            continue;
+        }
+
+        // Decode the escape sequence
+        if (read+1 >= total) {
+            _offset = read;
+            return error();
+        }
+        char code = data[read+1];
+        read += 2;
+        switch (code) {
+            case 'b':
+                data[write++] = '\b';
+                break;
+            case 'f':
+                data[write++] = '\f';
+                break;
+            case 'n':
+                data[write++] = '\n';
+                break;
+            case 'r':
+                data[write++] = '\r';
+                break;
+            case 't':
+                data[write++] = '\t';
+                break;
+            case '"':
+            case '\\':
+            case '/':
+                data[write++] = code;
+                break;
+            case 'u':
+            {
+                long unit = read+4 <= total ? hex_unit(data+read) : -1;
+                if (unit < 0) {
+                    _offset = read-2;
+                    return error();
+                }
+                read += 4;
+                Uint32 point = (Uint32)unit;
+                if (unit >= 0xD800 && unit <= 0xDBFF) {
+                    // Surrogate pair
+                    long low = -1;
+                    if (read+6 <= total && data[read] == '\\' && data[read+1] == 'u') {
+                        low = hex_unit(data+read+2);
+                    }
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        _offset = read-6;
+                        return error();
+                    }
+                    read += 6;
+                    point = 0x10000+(((Uint32)unit-0xD800) << 10)+((Uint32)low-0xDC00);
+                } else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+                    _offset = read-6;
+                    return error();
+                }
+                // UTF-8 is never longer than the escape sequence
+                write += utf8_encode(point,data+write);
+                break;
+            }
+            default:
+                _offset = read-2;
+                return error();
+        }
+    }
+
+    if (read >= total) {
+        _offset = start-1;
+        return error();
+    }
+    size = (Uint32)(write-start);
+    _offset = read+1;
+    return true;
+}
+
+/**
+ * Parses the array or object at the current position into the given entry
+ *
+ * The children are parsed onto the stack, and are moved to the arena when
+ * the container is closed. This is what keeps them contiguous.
+ *
+ * @param entry The entry to store the result
+ * @param depth The current nesting depth
+ *
+ * @return true if the container was parsed successfully
+ */
+bool JsonDocument::parseContainer(Entry& entry, int depth) {
+    if (depth >= MAX_DEPTH) {
+        return error();
+    }
+
+    bool object = _source[_offset] == '{';
+    char close  = object ? '}' : ']';
+    entry.type = object ? JsonValue::Type::ObjectType : JsonValue::Type::ArrayType;
+    _offset++;
+
+    size_t mark = _stack.size();
+    skip();
+    if (_offset < _source.size() && _source[_offset] == close) {
+        _offset++;
+        entry.start = (Uint32)_nodes.size();
+        entry.size  = 0;
+        return true;
+    }
+
+    while (true) {
+        Entry child;
+        child.key = 0;
+        child.keylen = 0;
+        skip();
+        if (object) {
+            if (_offset >= _source.size() || _source[_offset] != '"') {
+                return error();
+            }
+            if (!parseString(child.key,child.keylen)) {
+                return false;
+            }
+            skip();
+            if (_offset >= _source.size() || _source[_offset] != ':') {
+                return error();
+            }
+            _offset++;
+            skip();
+        }
+        if (!parseValue(child,depth+1)) {
+            return false;
+        }
+        _stack.push_back(child);
+
+        skip();
+        if (_offset >= _source.size()) {
+            return error();
+        } else if (_source[_offset] == ',') {
+            _offset++;
+        } else if (_source[_offset] == close) {
+            _offset++;
+            break;
+        } else {
+            return error();
+        }
+    }
+
+    // Grandchildren are already in the arena, so the children are contiguous
+    entry.start = (Uint32)_nodes.size();
+    entry.size  = (Uint32)(_stack.size()-mark);
+    _nodes.insert(_nodes.end(),_stack.begin()+mark,_stack.end());
+    _stack.resize(mark);
+    return true;
+}
+
+/**
+ * Reports a parsing error at the current position
+ *
+ * Detailed information about the parsing error will be passed to an
+ * assert. Hence error messages are suppressed if asserts are turned off.
+ *
+ * @return false (for convenience)
+ */
+bool JsonDocument::error() {
+    size_t pos = std::min(_offset,_source.size());
+    int line = 1;
+    for(size_t ii = 0; ii < pos; ii++) {
+        if (_source[ii] == '\n') {
+            line++;
+        }
+    }
+    size_t end = _source.find('\n',pos);
+    if (end == std::string::npos) {
+        end = _source.size();
+    }
+    std::string source = _source.substr(pos,end-pos);
+    CUAssertLog(false, "Invalid token at line %d:\n  %s",line,source.c_str());
+    return false; // If asserts turned off
+}
+
+/**
+ * Returns true if the arena and string table are consistent
+ *
+ * This method is used to validate a binary document. It checks that all
+ * string offsets are in range, and that every container refers to nodes
+ * that precede it in the arena (so that there are no cycles).
+ *
+ * @return true if the arena and string table are consistent
+ */
+bool JsonDocument::validate() const {
+    size_t bytes = _source.size();
+    for(size_t ii = 0; ii < _nodes.size(); ii++) {
+        const Entry& entry = _nodes[ii];
+        if ((size_t)entry.key+entry.keylen > bytes) {
+            return false;
+        }
+        switch (entry.type) {
+            case JsonValue::Type::NullType:
+            case JsonValue::Type::BoolType:
+            case JsonValue::Type::NumberType:
+                break;
+            case JsonValue::Type::StringType:
+                if ((size_t)entry.start+entry.size > bytes) {
+                    return false;
+                }
+                break;
+            case JsonValue::Type::ArrayType:
+            case JsonValue::Type::ObjectType:
+                if ((size_t)entry.start+entry.size > ii) {
+                    return false;
+                }
+                break;
+            default:
+                return false;
+        }
+    }
+    return _root < _nodes.size();
+}
+
+#pragma mark -
+#pragma mark Binary Encoding
+/**
+ * Returns the compiled binary encoding of this document.
+ *
+ * See the class description for the binary format. All keys and strings
+ * are interned, so each distinct string is stored only once.
+ *
+ * @return the compiled binary encoding of this document.
+ */
+std::vector<Uint8> JsonDocument::toBinary() const {
+    std::vector<Uint8> result;
+    if (_nodes.empty()) {
+        return result;
+    }
+
+    // Intern the strings first so we know the table size
+    std::string table;
+    std::unordered_map<std::string_view, Uint32> interned;
+    std::vector<Uint32> keys(_nodes.size());
+    std::vector<Uint32> strings(_nodes.size());
+    auto intern = [&](Uint32 start, Uint32 size) {
+        std::string_view text(_source.data()+start,size);
+        auto it = interned.find(text);
+        if (it != interned.end()) {
+            return it->second;
+        }
+        Uint32 offset = (Uint32)table.size();
+        table.append(text);
+        interned.emplace(text,offset);
+        return offset;
+    };
+    for(size_t ii = 0; ii < _nodes.size(); ii++) {
+        const Entry& entry = _nodes[ii];
+        keys[ii] = entry.keylen ? intern(entry.key,entry.keylen) : 0;
+        if (entry.type == JsonValue::Type::StringType) {
+            strings[ii] = entry.size ? intern(entry.start,entry.size) : 0;
+        } else {
+            strings[ii] = entry.start;
+        }
+    }
+
+    result.resize(CBIN_HEADER+_nodes.size()*CBIN_ENTRY+table.size(),0);
+    Uint8* next = result.data();
+    std::memcpy(next,CBIN_MAGIC,4);
+    write_uint32(next+4, CBIN_VERSION);
+    write_uint32(next+8, (Uint32)_nodes.size());
+    write_uint32(next+12,(Uint32)_root);
+    write_uint32(next+16,(Uint32)table.size());
+    next += CBIN_HEADER;
+
+    for(size_t ii = 0; ii < _nodes.size(); ii++) {
+        const Entry& entry = _nodes[ii];
+        write_uint32(next,   (Uint32)entry.type);
+        write_uint32(next+4, keys[ii]);
+        write_uint32(next+8, entry.keylen);
+        write_uint32(next+12,strings[ii]);
+        write_uint32(next+16,entry.size);
+        write_double(next+24,entry.number);
+        next += CBIN_ENTRY;
+    }
+    if (!table.empty()) {
+        std::memcpy(next,table.data(),table.size());
+    }
+    return result;
+}
+
+/**
+ * Writes the compiled binary encoding of this document to a file.
+ *
+ * The path is used as is, so it should be an absolute path (or a path
+ * relative to the working directory). This method is intended for offline
+ * tools that compile JSON assets.
+ *
+ * @param path  The file to write
+ *
+ * @return true if the file was written successfully
+ */
+bool JsonDocument::writeBinary(const std::string& path) const {
+    std::vector<Uint8> data = toBinary();
+    if (data.empty()) {
+        return false;
+    }
+    SDL_RWops* stream = SDL_RWFromFile(path.c_str(), "wb");
+    if (!stream) {
+        return false;
+    }
+    size_t written = SDL_RWwrite(stream, data.data(), 1, data.size());
+    SDL_RWclose(stream);
+    return written == data.size();
+}
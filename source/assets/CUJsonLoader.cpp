@@ -43,7 +43,7 @@
 //  Version: 12/23/22
 //
 #include <cugl/assets/CUJsonLoader.h>
-#include <cugl/io/CUJsonReader.h>
+#include <cugl/assets/CUJsonDocument.h>
 #include <cugl/base/CUApplication.h>
 
 using namespace cugl;
@@ -104,15 +104,15 @@ bool JsonLoader::read(const std::string key, const std::string source, LoaderCal
     
     bool success = false;
     if (_loader == nullptr || !async) {
-        std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(source);
-        std::shared_ptr<JsonValue> json = (reader == nullptr ? nullptr : reader->readJson());
+        std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(source);
+        std::shared_ptr<JsonValue> json = (doc == nullptr ? nullptr : doc->getRoot().toJsonValue());
         success = (json != nullptr);
         materialize(key,json,callback);
     } else {
         _loader->addTask([=](void) {
-            std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(source);
-            std::shared_ptr<JsonValue> json = (reader == nullptr ? nullptr : reader->readJson());
-            Application::get()->schedule([=](void) {
+            std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(source);
+            std::shared_ptr<JsonValue> json = (doc == nullptr ? nullptr : doc->getRoot().toJsonValue());
+            this->schedule([=](void) {
                 this->materialize(key,json,callback);
                 return false;
             });
@@ -155,15 +155,15 @@ bool JsonLoader::read(const std::shared_ptr<JsonValue>& json, LoaderCallback cal
     
     bool success = false;
     if (_loader == nullptr || !async) {
-        std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(source);
-        std::shared_ptr<JsonValue> json = (reader == nullptr ? nullptr : reader->readJson());
+        std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(source);
+        std::shared_ptr<JsonValue> json = (doc == nullptr ? nullptr : doc->getRoot().toJsonValue());
         success = (json != nullptr);
         materialize(key,json,callback);
     } else {
         _loader->addTask([=](void) {
-            std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(source);
-            std::shared_ptr<JsonValue> json = (reader == nullptr ? nullptr : reader->readJson());
-            Application::get()->schedule([=](void) {
+            std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(source);
+            std::shared_ptr<JsonValue> json = (doc == nullptr ? nullptr : doc->getRoot().toJsonValue());
+            this->schedule([=](void) {
                 this->materialize(key,json,callback);
                 return false;
             });
@@ -4,8 +4,8 @@
 //
 //  This module a modern C++ alternative to the cJSON interface for reading
 //  JSON files.  In particular, this gives us better type-checking and memory
-//  management.  With that said, it still uses cJSON as the underlying parsing
-//  engine.
+//  management.  Parsing is done by JsonDocument, while cJSON is still used
+//  to encode JSON strings.
 //
 //  This class uses our standard shared-pointer architecture.
 //
@@ -42,46 +42,17 @@
 //  Version: 1/7/18
 //
 #include <cugl/assets/CUJsonValue.h>
+#include <cugl/assets/CUJsonDocument.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUStrings.h>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
 
 using namespace cugl;
 
-/**
- * Returns the line of JSON with the offending error.
- *
- * Error messages in this library correspond to the tail of the JSON after the error is encounterd.  These
- * can be hard to read if the error happens early.  This function truncates the error to only include the
- * first line of the error.  It also indicates (via the reference variable) the line on which the error occurred.
- *
- * @param data      The JSON value being parsed
- * @param error     The tail of the JSON after encountering an error
- * @param lineno    The variable to store the line number
- *
- * @return the line of JSON with the offending error.
- */
-static std::string isolate_error(const char* data, const char* error, int& lineno) {
-    lineno = 1;
-    const char* pos = data;
-    while (pos != error) {
-        if (*pos == '\n') {
-            lineno++;
-        }
-        pos++;
-    }
-    size_t len = 0;
-    bool goon = true;
-    pos = error;
-    while (*pos && goon) {
-        if (*pos == '\n') {
-            goon = false;
-        } else {
-            len++;
-        }
-        pos++;
-    }
-    return std::string(error,len);
-}
+/** The largest magnitude at which every integer is exactly a double */
+#define JSON_EXACT_INTEGER  9007199254740992.0
 
 #pragma mark -
 #pragma mark JSON Conversions
@@ -278,6 +249,64 @@ cJSON* JsonValue::toCJSON(const JsonValue* value) {
     return result;
 }
 
+#pragma mark -
+#pragma mark JsonView Conversions
+/**
+ * Returns a newly allocated JsonValue equivalent to the document node
+ *
+ * This allocator recursively allocates child nodes as necessary. These
+ * nodes will be owned by the parent node and deleted when it is deleted
+ * (provided there are no other references).
+ *
+ * @param node  The document node to convert
+ *
+ * @return a newly allocated JsonValue equivalent to the document node
+ */
+std::shared_ptr<JsonValue> JsonValue::toJsonValue(const JsonView& node) {
+    std::shared_ptr<JsonValue> result = std::make_shared<JsonValue>();
+    toJsonValue(result.get(),node);
+    return result;
+}
+
+/**
+ * Modifies value so that it is equivalent to the document node
+ *
+ * This allocator recursively allocates child nodes as necessary. These
+ * nodes will be owned by the parent node value and deleted when it is
+ * deleted (provided there are no other references).
+ *
+ * @param value The JsonValue to store the result
+ * @param node  The document node to convert
+ */
+void JsonValue::toJsonValue(JsonValue* value, const JsonView& node) {
+    value->_type = node.type();
+    value->_key  = std::string(node.key());
+    value->_longValue = 0;
+    value->_doubleValue = 0;
+    switch (value->_type) {
+        case Type::BoolType:
+            value->_longValue = node.asBool();
+            break;
+        case Type::NumberType:
+            value->_longValue = node.asLong();
+            value->_doubleValue = node.asDouble();
+            break;
+        case Type::StringType:
+            value->_stringValue = std::string(node.view());
+            break;
+        default:
+            break;
+    }
+
+    size_t size = node.size();
+    value->_children.clear();
+    value->_children.reserve(size);
+    for(size_t ii = 0; ii < size; ii++) {
+        value->_children.push_back(toJsonValue(node.get(ii)));
+        value->_children.back()->_parent = value;
+    }
+}
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -400,23 +429,33 @@ bool JsonValue::init(double value) {
  * @return  true if the JSON node is initialized properly, false otherwise.
  */
 bool JsonValue::initWithJson(const std::string json) {
-    const char *error = NULL;
-    cJSON* node = cJSON_ParseWithOpts(json.c_str(), &error, 0);
-    if (node) {
-        toJsonValue(this,node);
-        cJSON_Delete(node);
+    JsonDocument document;
+    if (document.initWithJson(json)) {
+        toJsonValue(this,document.getRoot());
         return true;
     }
-    if (error) {
-        int line = 0;
-        std::string source = isolate_error(json.c_str(),error,line);
-        CUAssertLog(false, "Invalid token at line %d:\n  %s",line,source.c_str());
-    } else {
-        CUAssertLog(false, "Invalid JSON");
-    }
     return false; // If asserts turned off
 }
 
+/**
+ * Initializes a new JsonValue equivalent to the given document node.
+ *
+ * This initializer copies the entire subtree of the node, so the result
+ * does not depend on the {@link JsonDocument}. The children are all owned
+ * by this node will be deleted when this node is deleted (provided there
+ * are no other references).
+ *
+ * @param node  The document node to copy.
+ *
+ * @return  true if the JSON node is initialized properly, false otherwise.
+ */
+bool JsonValue::initWithView(const JsonView& node) {
+    if (!node) {
+        return false;
+    }
+    toJsonValue(this,node);
+    return true;
+}
 
 #pragma mark -
 #pragma mark Type
@@ -459,7 +498,7 @@ const std::string JsonValue::asString(const std::string defaultValue) const {
             return std::string(_longValue ? "true" : "false");
         case Type::NumberType:
             if (_longValue == _doubleValue) {
-                return cugl::strtool::to_string((Uint64)_longValue);
+                return cugl::strtool::to_string((Sint64)_longValue);
             } else {
                 return cugl::strtool::to_string(_doubleValue);
             }
@@ -1215,6 +1254,153 @@ void JsonValue::insertChild(unsigned int index, const std::string key,
 
 #pragma mark -
 #pragma mark Encoding
+/**
+ * Appends the given string to the buffer as a JSON string literal
+ *
+ * Runs of characters that need no escaping are appended in one piece.
+ *
+ * @param buffer    The output buffer
+ * @param value     The string to quote
+ */
+static void encode_string(std::string& buffer, const std::string& value) {
+    static const char* hex = "0123456789abcdef";
+    buffer.push_back('"');
+    const char* data = value.data();
+    size_t start = 0;
+    for(size_t ii = 0; ii < value.size(); ii++) {
+        unsigned char c = (unsigned char)data[ii];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        buffer.append(data+start,ii-start);
+        start = ii+1;
+        buffer.push_back('\\');
+        switch (c) {
+            case '"':
+            case '\\':
+                buffer.push_back((char)c);
+                break;
+            case '\b':
+                buffer.push_back('b');
+                break;
+            case '\f':
+                buffer.push_back('f');
+                break;
+            case '\n':
+                buffer.push_back('n');
+                break;
+            case '\r':
+                buffer.push_back('r');
+                break;
+            case '\t':
+                buffer.push_back('t');
+                break;
+            default:
+                buffer.append("u00");
+                buffer.push_back(hex[c >> 4]);
+                buffer.push_back(hex[c & 0xf]);
+                break;
+        }
+    }
+    buffer.append(data+start,value.size()-start);
+    buffer.push_back('"');
+}
+
+/**
+ * Appends the given number to the buffer
+ *
+ * Integral values are written without a decimal point. All other values
+ * are written with the shortest representation that parses back to the
+ * same double. JSON has no representation of NaN or infinity, so these
+ * are written as null (as cJSON does).
+ *
+ * @param buffer    The output buffer
+ * @param value     The number to write
+ */
+static void encode_number(std::string& buffer, double value) {
+    char digits[32];
+    char* end = digits;
+    if (!std::isfinite(value)) {
+        buffer.append("null");
+        return;
+    } else if (value == std::floor(value) && std::fabs(value) < JSON_EXACT_INTEGER) {
+        end = std::to_chars(digits, digits+sizeof(digits), (long long)value).ptr;
+    } else {
+#if defined(__cpp_lib_to_chars)
+        end = std::to_chars(digits, digits+sizeof(digits), value).ptr;
+#else
+        // Fall back to the shortest of the two round trip precisions
+        int len = snprintf(digits, sizeof(digits), "%.15g", value);
+        if (std::strtod(digits, nullptr) != value) {
+            len = snprintf(digits, sizeof(digits), "%.17g", value);
+        }
+        end = digits+len;
+#endif
+    }
+    buffer.append(digits,end-digits);
+}
+
+/**
+ * Appends the given JSON value to the buffer
+ *
+ * The formatted layout matches that of cJSON, with tab indentation.
+ *
+ * @param buffer    The output buffer
+ * @param value     The JSON value to write
+ * @param depth     The depth of the value in the tree
+ * @param format    Whether to pretty-print the JSON value
+ */
+static void encode_value(std::string& buffer, const JsonValue* value, size_t depth, bool format) {
+    switch (value->type()) {
+        case JsonValue::Type::NullType:
+            buffer.append("null");
+            break;
+        case JsonValue::Type::BoolType:
+            buffer.append(value->asBool() ? "true" : "false");
+            break;
+        case JsonValue::Type::NumberType:
+            encode_number(buffer, value->asDouble());
+            break;
+        case JsonValue::Type::StringType:
+            encode_string(buffer, value->_stringValue);
+            break;
+        case JsonValue::Type::ArrayType:
+            buffer.push_back('[');
+            for(auto it = value->_children.begin(); it != value->_children.end(); ++it) {
+                if (it != value->_children.begin()) {
+                    buffer.append(format ? ", " : ",");
+                }
+                encode_value(buffer, it->get(), depth+1, format);
+            }
+            buffer.push_back(']');
+            break;
+        case JsonValue::Type::ObjectType:
+            buffer.push_back('{');
+            if (format) {
+                buffer.push_back('\n');
+            }
+            for(auto it = value->_children.begin(); it != value->_children.end(); ++it) {
+                if (it != value->_children.begin()) {
+                    buffer.append(format ? ",\n" : ",");
+                }
+                if (format) {
+                    buffer.append(depth+1, '\t');
+                }
+                encode_string(buffer, (*it)->_key);
+                buffer.append(format ? ":\t" : ":");
+                encode_value(buffer, it->get(), depth+1, format);
+            }
+            if (format) {
+                if (!value->_children.empty()) {
+                    buffer.push_back('\n');
+                }
+                buffer.append(depth, '\t');
+            }
+            buffer.push_back('}');
+            break;
+    }
+}
+
 /**
  * Returns a string representation of this JSON.
  *
@@ -1230,19 +1416,26 @@ void JsonValue::insertChild(unsigned int index, const std::string key,
  * @return a string representation of this JSON.
  */
 std::string JsonValue::toString(bool format) const {
-    cJSON* ast = toCJSON(this);
-    char* data = nullptr;
-    if (format) {
-        data = cJSON_Print(ast);
-    } else {
-        data = cJSON_PrintUnformatted(ast);
-    }
-    if (data) {
-        std::string result(data);
-        
-        free(data);
-        cJSON_Delete(ast);
-        return result;
-    }
-    return "";
+    std::string result;
+    toString(result,format);
+    return result;
+}
+
+/**
+ * Appends a string representation of this JSON to the given buffer.
+ *
+ * This method is the same as {@link toString(bool)}, except that the
+ * result is appended to an existing buffer. The JSON is serialized
+ * directly to the buffer, so reusing a buffer (clearing it between uses)
+ * means that serialization does not allocate once the buffer is large
+ * enough.
+ *
+ * Numbers are written in the shortest form that reads back to the same
+ * value, and the formatted layout is that of {@link toString(bool)}.
+ *
+ * @param buffer    The buffer to append to
+ * @param format    Whether to pretty-print the JSON string
+ */
+void JsonValue::toString(std::string& buffer, bool format) const {
+    encode_value(buffer,this,0,format);
 }
@@ -53,9 +53,10 @@
 #include <cugl/assets/CUWidgetValue.h>
 #include <cugl/base/CUApplication.h>
 #include <cugl/base/CUDisplay.h>
-#include <cugl/io/CUJsonReader.h>
+#include <cugl/assets/CUJsonDocument.h>
 #include <cugl/util/CUStrings.h>
 #include <cugl/scene2/cu_scene2.h>
+#include <cugl/render/CUFont.h>
 #include <locale>
 #include <algorithm>
 
@@ -64,6 +65,46 @@ using namespace cugl;
 /** If the type is unknown */
 #define UNKNOWN_STR  "<unknown>"
 
+/**
+ * Returns a deep copy of the given JSON tree
+ *
+ * This is much faster than writing the tree to a string and parsing it
+ * again, which is how widgets were originally instantiated.
+ *
+ * @param json  The JSON tree to copy
+ *
+ * @return a deep copy of the given JSON tree
+ */
+static std::shared_ptr<JsonValue> copy_json(const std::shared_ptr<JsonValue>& json) {
+    std::shared_ptr<JsonValue> result = JsonValue::alloc(json->type());
+    result->_stringValue = json->_stringValue;
+    result->_longValue   = json->_longValue;
+    result->_doubleValue = json->_doubleValue;
+    bool object = json->isObject();
+    for(auto it = json->children().begin(); it != json->children().end(); ++it) {
+        if (object) {
+            result->appendChild((*it)->key(),copy_json(*it));
+        } else {
+            result->appendChild(copy_json(*it));
+        }
+    }
+    return result;
+}
+
+/**
+ * A node waiting to be built by an incremental load
+ */
+struct BuildTask {
+    /** The parent of the node (nullptr for the root) */
+    std::shared_ptr<scene2::SceneNode> parent;
+    /** Whether the node ignores the parent color */
+    bool nonrelative;
+    /** The name of the node */
+    std::string key;
+    /** The JSON defining the node */
+    std::shared_ptr<JsonValue> json;
+};
+
 /**
  * Initializes a new asset loader.
  *
@@ -144,13 +185,60 @@ bool Scene2Loader::init(const std::shared_ptr<ThreadPool>& threads) {
  */
 std::shared_ptr<scene2::SceneNode> Scene2Loader::build(const std::string key,
                                                       const std::shared_ptr<JsonValue>& json) const {
+    std::shared_ptr<JsonValue> source = resolveJson(json);
+    bool nonrelative = false;
+    std::shared_ptr<scene2::SceneNode> node = buildNode(key,source,&nonrelative);
+    if (node != nullptr && !deferChildren(node.get(),source,nonrelative)) {
+        buildChildren(node.get(),source,nonrelative);
+    }
+    
+    // Do not perform layout yet.
+    return node;
+}
+
+/**
+ * Returns the JSON of the node encoded by the given JSON.
+ *
+ * If the JSON is a widget, this returns the JSON of the node that it
+ * encodes (see {@link #getWidgetJson}). Otherwise, it returns the JSON
+ * unchanged.
+ *
+ * @param json      The JSON object defining a node or widget
+ *
+ * @return the JSON of the node encoded by the given JSON.
+ */
+std::shared_ptr<JsonValue> Scene2Loader::resolveJson(const std::shared_ptr<JsonValue>& json) const {
+    std::string type = json->getString("type",UNKNOWN_STR);
+    auto it = _types.find(cugl::strtool::tolower(type));
+    if (it != _types.end() && it->second == Widget::EXTERNAL_IMPORT) {
+        return getWidgetJson(json);
+    }
+    return json;
+}
+
+/**
+ * Returns a single node built from the given JSON, without its children.
+ *
+ * The node has its layout manager (if any) and name, but no children.
+ * The JSON should already be resolved (see {@link #resolveJson}). This
+ * method returns nullptr if the JSON does not define a supported node.
+ *
+ * @param key           The name of the node
+ * @param json          The JSON object defining the node
+ * @param nonrelative   Pointer to store whether children ignore the node color
+ *
+ * @return a single node built from the given JSON, without its children.
+ */
+std::shared_ptr<scene2::SceneNode> Scene2Loader::buildNode(const std::string key,
+                                                          const std::shared_ptr<JsonValue>& json,
+                                                          bool* nonrelative) const {
     std::string type = json->getString("type",UNKNOWN_STR);
     auto it = _types.find(cugl::strtool::tolower(type));
     if (it == _types.end()) {
         return nullptr;
     }
     
-    bool nonrelative = false;
+    *nonrelative = false;
     std::shared_ptr<JsonValue> data = json->get("data");
     std::shared_ptr<scene2::SceneNode> node = nullptr;
     switch (it->second) {
@@ -164,7 +252,7 @@ std::shared_ptr<scene2::SceneNode> Scene2Loader::build(const std::string key,
         // TODO: Replace with polygon as first child and sized to fill
         // That will keep us from breaking the tint abstraction
         node = scene2::PolygonNode::allocWithData(this,data);
-        nonrelative = true;
+        *nonrelative = true;
         break;
     case Widget::POLY:
         node = scene2::PolygonNode::allocWithData(this,data);
@@ -205,11 +293,8 @@ std::shared_ptr<scene2::SceneNode> Scene2Loader::build(const std::string key,
     case Widget::TEXTFIELD:
         node = scene2::TextField::allocWithData(this,data);
         break;
-	case Widget::EXTERNAL_IMPORT:
-	{
-		const std::shared_ptr<JsonValue> widgetJson = getWidgetJson(json);
-		return build(key, widgetJson);
-	}
+    case Widget::EXTERNAL_IMPORT:
+        // Resolved before we get here
     case Widget::UNKNOWN:
         break;
     }
@@ -223,7 +308,6 @@ std::shared_ptr<scene2::SceneNode> Scene2Loader::build(const std::string key,
         node->setContentSize(Display::get()->getBounds().size);
     }
     
-    
     std::shared_ptr<JsonValue> form = json->get("format");
     std::string ftype =  (form == nullptr ? UNKNOWN_STR : form->getString("type",UNKNOWN_STR));
     auto jt = _forms.find(cugl::strtool::tolower(ftype));
@@ -246,37 +330,91 @@ std::shared_ptr<scene2::SceneNode> Scene2Loader::build(const std::string key,
         }
     }
     node->setLayout(layout);
-    
+    node->setName(key);
+    return node;
+}
+
+/**
+ * Recursively builds the children of a node from the given JSON.
+ *
+ * The children are defined by the "children" attribute of the JSON.
+ *
+ * @param node          The node to add the children to
+ * @param json          The JSON object defining the node
+ * @param nonrelative   Whether the children ignore the node color
+ */
+void Scene2Loader::buildChildren(scene2::SceneNode* node, const std::shared_ptr<JsonValue>& json,
+                                 bool nonrelative) const {
     std::shared_ptr<JsonValue> children = json->get("children");
-	if (children != nullptr) {
-		for (int ii = 0; ii < children->size(); ii++) {
-			std::shared_ptr<JsonValue> item = children->get(ii);
-			std::string key = item->key();
-			if (key != "comment") {
-				// If this is a widget, use the loaded widget json instead
-				if (item->has("type") && item->getString("type") == "Widget") {
-					item = getWidgetJson(item);
-				}
-
-				std::shared_ptr<scene2::SceneNode> kid = build(key, item);
-                if (nonrelative) {
-                    kid->setRelativeColor(false);
-                }
-				node->addChild(kid);
+    if (children == nullptr) {
+        return;
+    }
+    for (int ii = 0; ii < children->size(); ii++) {
+        std::shared_ptr<JsonValue> item = children->get(ii);
+        std::string key = item->key();
+        if (key != "comment") {
+            // If this is a widget, use the loaded widget json instead
+            item = resolveJson(item);
+            
+            bool local = false;
+            std::shared_ptr<scene2::SceneNode> kid = buildNode(key,item,&local);
+            if (kid == nullptr) {
+                CULogError("Could not build child '%s'",key.c_str());
+                continue;
+            }
+            if (!deferChildren(kid.get(),item,local)) {
+                buildChildren(kid.get(),item,local);
+            }
+            attachChild(node,kid,item,nonrelative);
+        }
+    }
+}
 
-				if (layout != nullptr && item->has("layout")) {
-					std::shared_ptr<JsonValue> posit = item->get("layout");
-					layout->add(key, posit);
-				}
-			}
-		}
-	}
+/**
+ * Adds the given child to its parent, registering its layout information
+ *
+ * @param parent        The parent node
+ * @param child         The child node
+ * @param json          The JSON object defining the child
+ * @param nonrelative   Whether the child ignores the parent color
+ */
+void Scene2Loader::attachChild(scene2::SceneNode* parent, const std::shared_ptr<scene2::SceneNode>& child,
+                               const std::shared_ptr<JsonValue>& json, bool nonrelative) const {
+    if (nonrelative) {
+        child->setRelativeColor(false);
+    }
+    parent->addChild(child);
     
-    // Do not perform layout yet.
-    node->setName(key);
-    return node;
+    std::shared_ptr<scene2::Layout> layout = parent->getLayout();
+    if (layout != nullptr && json->has("layout")) {
+        layout->add(child->getName(), json->get("layout"));
+    }
 }
 
+/**
+ * Returns true if the children of the given node should be deferred.
+ *
+ * If so, this method assigns the node a deferred builder (see
+ * {@link SceneNode#setDeferredChildren}), and the children are not
+ * built until the node is first made visible.
+ *
+ * @param node          The node to check
+ * @param json          The JSON object defining the node
+ * @param nonrelative   Whether the children ignore the node color
+ *
+ * @return true if the children of the given node should be deferred.
+ */
+bool Scene2Loader::deferChildren(scene2::SceneNode* node, const std::shared_ptr<JsonValue>& json,
+                                 bool nonrelative) const {
+    if (!_deferHidden || node->isVisible() || !json->has("children")) {
+        return false;
+    }
+    node->setDeferredChildren([=](scene2::SceneNode* parent) {
+        buildChildren(parent,json,nonrelative);
+        parent->doLayout();
+    });
+    return true;
+}
 
 /**
  * Translates the JSON of a widget to the JSON of the node that it encodes.
@@ -301,8 +439,15 @@ std::shared_ptr<JsonValue> Scene2Loader::getWidgetJson(const std::shared_ptr<Jso
 
 	std::shared_ptr<JsonValue> variables = widgetJson->get("variables");
 	std::shared_ptr<JsonValue> contents = widgetJson->get("contents");
-	std::string contentString = contents->toString();
-	std::shared_ptr<JsonValue> contentCopy = JsonValue::allocWithJson(contentString);
+    
+    // The widget is only copied if this instance changes it
+    if ((widgetVars == nullptr || widgetVars->size() == 0) && layout == nullptr) {
+        if (contents->has("type") && contents->getString("type") == "Widget") {
+            return getWidgetJson(contents);
+        }
+        return contents;
+    }
+	std::shared_ptr<JsonValue> contentCopy = copy_json(contents);
     if (widgetVars) {
         for (int ii = 0; ii < widgetVars->size(); ii++) {
             auto child = widgetVars->get(ii);
@@ -405,24 +550,40 @@ bool Scene2Loader::read(const std::string key, const std::string source,
     _queue.emplace(key);
 
     bool success = false;
-    if (_loader == nullptr || !async) {
-        std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(source);
-        std::shared_ptr<JsonValue> json = (reader == nullptr ? nullptr : reader->readJson());
-        std::shared_ptr<scene2::SceneNode> node = build(key,json);
-        node->doLayout();
+    if (!async || (_loader == nullptr && _budget == 0)) {
+        std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(source);
+        std::shared_ptr<JsonValue> json = (doc == nullptr ? nullptr : doc->getRoot().toJsonValue());
+        std::shared_ptr<scene2::SceneNode> node = (json == nullptr ? nullptr : build(key,json));
         if (node != nullptr) {
+            node->doLayout();
             success = true;
             materialize(node,callback);
         } else {
             _queue.erase(key);
         }
+    } else if (_loader == nullptr) {
+        std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(source);
+        std::shared_ptr<JsonValue> json = (doc == nullptr ? nullptr : doc->getRoot().toJsonValue());
+        stream(key,json,callback);
+        success = true;
     } else {
+        Uint32 budget = _budget;
         _loader->addTask([=](void) {
-            std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(source);
-            std::shared_ptr<JsonValue> json = (reader == nullptr ? nullptr : reader->readJson());
-            std::shared_ptr<scene2::SceneNode> node = build(key,json);
-            node->doLayout();
-            Application::get()->schedule([=](void) {
+            std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(source);
+            std::shared_ptr<JsonValue> json = (doc == nullptr ? nullptr : doc->getRoot().toJsonValue());
+            if (budget > 0) {
+                // Only the parsing happens off the main thread
+                this->schedule([=](void) {
+                    this->stream(key,json,callback);
+                    return false;
+                });
+                return;
+            }
+            std::shared_ptr<scene2::SceneNode> node = (json == nullptr ? nullptr : build(key,json));
+            if (node != nullptr) {
+                node->doLayout();
+            }
+            this->schedule([=](void) {
                 this->materialize(node,callback);
                 return false;
             });
@@ -473,20 +634,26 @@ bool Scene2Loader::read(const std::shared_ptr<JsonValue>& json, LoaderCallback c
     _queue.emplace(key);
     
     bool success = false;
-    if (_loader == nullptr || !async) {
+    if (!async || (_loader == nullptr && _budget == 0)) {
         std::shared_ptr<scene2::SceneNode> node = build(key,json);
-        node->doLayout();
         if (node != nullptr) {
+            node->doLayout();
             success = true;
             materialize(node,callback);
         } else {
             _queue.erase(key);
         }
+    } else if (_budget > 0) {
+        // The JSON is already parsed, so there is nothing for the thread pool
+        stream(key,json,callback);
+        success = true;
     } else {
         _loader->addTask([=](void) {
             std::shared_ptr<scene2::SceneNode> node = build(key,json);
-            node->doLayout();
-            Application::get()->schedule([=](void) {
+            if (node != nullptr) {
+                node->doLayout();
+            }
+            this->schedule([=](void) {
                 this->materialize(node,callback);
                 return false;
             });
@@ -496,6 +663,86 @@ bool Scene2Loader::read(const std::shared_ptr<JsonValue>& json, LoaderCallback c
     return success;
 }
 
+/**
+ * Builds the scene from the given JSON tree across several frames.
+ *
+ * This method must be called on the main thread. Each frame, it builds
+ * as many nodes as it can within the frame budget (see {@link #getFrameBudget}).
+ * When the scene is complete, it is laid out and materialized.
+ *
+ * @param key       The key to access the scene after loading
+ * @param json      The JSON object defining the scene
+ * @param callback  An optional callback for asynchronous loading
+ */
+void Scene2Loader::stream(const std::string key, const std::shared_ptr<JsonValue>& json,
+                          LoaderCallback callback) {
+    if (json == nullptr) {
+        materialize(nullptr,callback);
+        _queue.erase(key);
+        return;
+    }
+    
+    // The nodes are built depth first, so children are added in order
+    auto tasks = std::make_shared<std::vector<BuildTask>>();
+    auto root  = std::make_shared<std::shared_ptr<scene2::SceneNode>>();
+    tasks->push_back({nullptr,false,key,json});
+    Application::get()->schedule([=](void) {
+        Timestamp start;
+        Uint32 budget = SDL_max(_budget,1);
+        bool failed = false;
+        while (!tasks->empty() && !failed) {
+            BuildTask task = tasks->back();
+            tasks->pop_back();
+            
+            std::shared_ptr<JsonValue> source = resolveJson(task.json);
+            bool nonrelative = false;
+            std::shared_ptr<scene2::SceneNode> node = buildNode(task.key,source,&nonrelative);
+            if (node == nullptr) {
+                if (task.parent == nullptr) {
+                    failed = true;
+                } else {
+                    CULogError("Could not build child '%s'",task.key.c_str());
+                }
+            } else {
+                if (task.parent == nullptr) {
+                    *root = node;
+                } else {
+                    attachChild(task.parent.get(),node,source,task.nonrelative);
+                }
+                
+                std::shared_ptr<JsonValue> children = source->get("children");
+                if (children != nullptr && !deferChildren(node.get(),source,nonrelative)) {
+                    for (int ii = (int)children->size()-1; ii >= 0; ii--) {
+                        std::shared_ptr<JsonValue> item = children->get(ii);
+                        if (item->key() != "comment") {
+                            tasks->push_back({node,nonrelative,item->key(),item});
+                        }
+                    }
+                }
+            }
+            
+            Timestamp now;
+            if (Timestamp::ellapsedMicros(start,now) >= budget) {
+                break;
+            }
+        }
+        
+        if (!tasks->empty() && !failed) {
+            return true;
+        }
+        
+        std::shared_ptr<scene2::SceneNode> result = (failed ? nullptr : *root);
+        if (result != nullptr) {
+            result->doLayout();
+            this->materialize(result,callback);
+        } else {
+            this->materialize(nullptr,callback);
+            _queue.erase(key);
+        }
+        return false;
+    });
+}
+
 /**
  * Unloads the asset for the given directory entry
  *
@@ -516,6 +763,53 @@ bool Scene2Loader::purge(const std::shared_ptr<JsonValue>& json) {
     return false;
 }
 
+/**
+ * Replaces every use of the given asset in the loaded scenes
+ *
+ * This method is called by {@link AssetManager} when an asset is hot
+ * reloaded. Scene nodes using a reloaded texture (textured nodes, nine
+ * patches and particle nodes) or font (labels) are given the new asset.
+ * The scenes themselves are not reloaded.
+ *
+ * @param type      The hash of the type of the reloaded asset
+ * @param previous  The asset before the reload
+ * @param current   The asset after the reload
+ */
+void Scene2Loader::rebind(size_t type, const std::shared_ptr<void>& previous,
+                          const std::shared_ptr<void>& current) {
+    // Every node of a scene is an asset (see attach)
+    if (type == typeid(Texture).hash_code()) {
+        std::shared_ptr<Texture> before = std::static_pointer_cast<Texture>(previous);
+        std::shared_ptr<Texture> after  = std::static_pointer_cast<Texture>(current);
+        for(auto it = _assets.begin(); it != _assets.end(); ++it) {
+            scene2::SceneNode* node = it->second.get();
+            if (auto textured = dynamic_cast<scene2::TexturedNode*>(node)) {
+                if (textured->getTexture() == before) {
+                    textured->setTexture(after);
+                }
+            } else if (auto patch = dynamic_cast<scene2::NinePatch*>(node)) {
+                if (patch->getTexture() == before) {
+                    patch->setTexture(after);
+                }
+            } else if (auto particles = dynamic_cast<scene2::ParticleNode*>(node)) {
+                if (particles->getTexture() == before) {
+                    particles->setTexture(after);
+                }
+            }
+        }
+    } else if (type == typeid(Font).hash_code()) {
+        std::shared_ptr<Font> before = std::static_pointer_cast<Font>(previous);
+        std::shared_ptr<Font> after  = std::static_pointer_cast<Font>(current);
+        for(auto it = _assets.begin(); it != _assets.end(); ++it) {
+            if (auto label = dynamic_cast<scene2::Label*>(it->second.get())) {
+                if (label->getFont() == before) {
+                    label->setFont(after);
+                }
+            }
+        }
+    }
+}
+
 /**
  * Attaches all generate nodes to the asset dictionary.
  *
@@ -153,6 +153,8 @@ bool SoundLoader::read(const std::string key, const std::string source, LoaderCa
         if (success) {
             sound->setVolume(_volume);
             materialize(key,sound,callback);
+        } else {
+            _queue.erase(key);
         }
     } else {
         _loader->addTask([=](void) {
@@ -162,11 +164,12 @@ bool SoundLoader::read(const std::string key, const std::string source, LoaderCa
             }
             if (sound != nullptr) {
                 sound->setVolume(_volume);
-                Application::get()->schedule([=](void){
-                    this->materialize(key,sound,callback);
-                    return false;
-                });
             }
+            // Materialize even on failure, so the asset leaves the queue
+            this->schedule([=](void){
+                this->materialize(key,sound,callback);
+                return false;
+            });
         });
     }
     
@@ -218,6 +221,8 @@ bool SoundLoader::read(const std::shared_ptr<JsonValue>& json, LoaderCallback ca
         if (success) {
             sound->setVolume(volume);
             materialize(key,sound,callback);
+        } else {
+            _queue.erase(key);
         }
     } else {
         _loader->addTask([=](void) {
@@ -229,13 +234,37 @@ bool SoundLoader::read(const std::shared_ptr<JsonValue>& json, LoaderCallback ca
             }
             if (sound != nullptr) {
                 sound->setVolume(volume);
-                Application::get()->schedule([=](void) {
-                    this->materialize(key,sound,callback);
-                    return false;
-                });
             }
+            // Materialize even on failure, so the asset leaves the queue
+            this->schedule([=](void) {
+                this->materialize(key,sound,callback);
+                return false;
+            });
         });
     }
     
     return success;
 }
+
+/**
+ * Returns the estimated memory used by the given sound in bytes
+ *
+ * For an in-memory sample, this is the size of the PCM buffer. For a
+ * compressed sample, it is the size of the encoded data. Samples
+ * streamed from a file, and other sound types, have size 0.
+ *
+ * @param asset The sound to measure
+ *
+ * @return the estimated memory used by the given sound in bytes
+ */
+size_t SoundLoader::measure(const std::shared_ptr<Sound>& asset) const {
+    AudioSample* sample = dynamic_cast<AudioSample*>(asset.get());
+    if (sample == nullptr) {
+        return 0;
+    } else if (sample->isCompressed()) {
+        return sample->getEncodedSize();
+    } else if (sample->isStreamed()) {
+        return 0;
+    }
+    return (size_t)sample->getLength()*sample->getChannels()*sizeof(float);
+}
@@ -45,6 +45,10 @@
 //
 #include <cugl/assets/CUTextureLoader.h>
 #include <cugl/base/CUApplication.h>
+#include <cugl/render/CUCompressedImage.h>
+#include <cugl/io/CUAssetBundle.h>
+#include <cugl/util/CUFiletools.h>
+#include <cugl/util/CUProfiler.h>
 #include <SDL_image.h>
 
 using namespace cugl;
@@ -58,6 +62,10 @@ using namespace cugl;
 #define UNKNOWN_MAGFLT  "linear"
 /** The default wrap rule */
 #define UNKNOWN_WRAP    "clamp"
+/** The default maximum size of a packed atlas page */
+#define DEFAULT_PAGE    2048
+/** The default number of pixels between packed images */
+#define DEFAULT_PADDING 2
 
 /**
  * Returns the OpenGL enum for the given min filter name
@@ -124,6 +132,139 @@ static GLuint decodeWrap(const std::string name) {
     return GL_CLAMP_TO_EDGE;
 }
 
+/**
+ * Returns the source file for the given directory entry
+ *
+ * If the entry has a "compressed" object, this function returns the file of
+ * the first compression family supported by this device, checking ASTC, then
+ * ETC2, then BC. Otherwise, it returns the "file" entry. This function queries
+ * the OpenGL context, and so it must be called in the main thread.
+ *
+ * @param json  The asset directory entry
+ *
+ * @return the source file for the given directory entry
+ */
+static std::string select_source(const std::shared_ptr<JsonValue>& json) {
+    JsonValue* variants = json->get("compressed").get();
+    if (variants != nullptr) {
+        static const std::pair<const char*,CompressedImage::Family> families[] = {
+            { "astc", CompressedImage::Family::ASTC },
+            { "etc2", CompressedImage::Family::ETC2 },
+            { "bc",   CompressedImage::Family::BC   }
+        };
+        for(const auto& family : families) {
+            if (variants->has(family.first) && CompressedImage::isSupported(family.second)) {
+                return variants->getString(family.first);
+            }
+        }
+    }
+    return json->getString("file",UNKNOWN_SOURCE);
+}
+
+/**
+ * A segment of the top edge of the packed region of an atlas page
+ */
+typedef struct {
+    /** The left edge of the segment */
+    int x;
+    /** The height of the packed region under this segment */
+    int y;
+    /** The width of the segment */
+    int width;
+} skyline_node;
+
+/**
+ * Returns the y-position to place a rectangle at the given skyline segment
+ *
+ * The rectangle has its left edge at the start of the segment, and rests on
+ * the highest segment underneath it. This function returns -1 if the rectangle
+ * does not fit in the page at that position.
+ *
+ * @param skyline   The skyline of the page
+ * @param index     The segment for the left edge of the rectangle
+ * @param width     The rectangle width
+ * @param height    The rectangle height
+ * @param size      The page width and height
+ *
+ * @return the y-position to place a rectangle at the given skyline segment
+ */
+static int skyline_fit(const std::vector<skyline_node>& skyline, size_t index,
+                       int width, int height, int size) {
+    if (skyline[index].x+width > size) {
+        return -1;
+    }
+    int y = 0;
+    int remain = width;
+    for(size_t ii = index; remain > 0 && ii < skyline.size(); ii++) {
+        y = std::max(y,skyline[ii].y);
+        if (y+height > size) {
+            return -1;
+        }
+        remain -= skyline[ii].width;
+    }
+    return y;
+}
+
+/**
+ * Returns true if the rectangle was added to the page skyline
+ *
+ * The rectangle is placed at the lowest position available, breaking ties in
+ * favor of the narrowest segment. On success, the position is stored in the
+ * rectangle and the skyline is raised to cover it.
+ *
+ * @param skyline   The skyline of the page
+ * @param rect      The rectangle to place (width and height must be set)
+ * @param size      The page width and height
+ *
+ * @return true if the rectangle was added to the page skyline
+ */
+static bool skyline_insert(std::vector<skyline_node>& skyline, SDL_Rect& rect, int size) {
+    int bestY = size;
+    int bestW = size+1;
+    size_t best = skyline.size();
+    for(size_t ii = 0; ii < skyline.size(); ii++) {
+        int y = skyline_fit(skyline, ii, rect.w, rect.h, size);
+        if (y >= 0 && (y+rect.h < bestY || (y+rect.h == bestY && skyline[ii].width < bestW))) {
+            bestY = y+rect.h;
+            bestW = skyline[ii].width;
+            best = ii;
+        }
+    }
+    if (best == skyline.size()) {
+        return false;
+    }
+
+    rect.x = skyline[best].x;
+    rect.y = bestY-rect.h;
+    skyline_node node = { rect.x, bestY, rect.w };
+    skyline.insert(skyline.begin()+best, node);
+
+    // Trim the segments now covered by the new one
+    size_t ii = best+1;
+    while (ii < skyline.size()) {
+        int overlap = (node.x+node.width)-skyline[ii].x;
+        if (overlap <= 0) {
+            break;
+        } else if (overlap < skyline[ii].width) {
+            skyline[ii].x += overlap;
+            skyline[ii].width -= overlap;
+            break;
+        }
+        skyline.erase(skyline.begin()+ii);
+    }
+
+    // Merge neighbors at the same height
+    for(ii = 1; ii < skyline.size(); ) {
+        if (skyline[ii-1].y == skyline[ii].y) {
+            skyline[ii-1].width += skyline[ii].width;
+            skyline.erase(skyline.begin()+ii);
+        } else {
+            ii++;
+        }
+    }
+    return true;
+}
+
 #pragma mark -
 #pragma mark Constructor
 
@@ -138,7 +279,9 @@ _minfilter(GL_LINEAR),
 _magfilter(GL_LINEAR),
 _wraps(GL_CLAMP_TO_EDGE),
 _wrapt(GL_CLAMP_TO_EDGE),
-_mipmaps(false) {
+_mipmaps(false),
+_budget(0),
+_pumping(false) {
     _jsonKey  = "textures";
     _priority = 0;
 }
@@ -159,6 +302,8 @@ _mipmaps(false) {
  * @return the SDL_Surface with the texture information
  */
 SDL_Surface* TextureLoader::preload(const std::string source) {
+    CU_PROFILE_SCOPE("TextureLoader::decode");
+    CU_PROFILE_DETAIL(source);
     // Make sure we reference the asset directory
 #if defined (__WINDOWS__)
     bool absolute = (bool)strstr(source.c_str(),":") || source[0] == '\\';
@@ -169,7 +314,8 @@ SDL_Surface* TextureLoader::preload(const std::string source) {
     
     std::string path = Application::get()->getAssetDirectory();
     path.append(source);
-    SDL_Surface* surface = IMG_Load(path.c_str());
+    SDL_RWops* stream = AssetBundle::openStream(filetool::normalize_path(path));
+    SDL_Surface* surface = stream ? IMG_Load_RW(stream, 1) : nullptr;
     if (surface == nullptr) {
         return nullptr;
     }
@@ -181,6 +327,9 @@ SDL_Surface* TextureLoader::preload(const std::string source) {
     normal = SDL_ConvertSurfaceFormat(surface,SDL_PIXELFORMAT_RGBA8888,0);
 #endif
     SDL_FreeSurface(surface);
+    if (normal != nullptr) {
+        CU_PROFILE_BYTES((Uint64)normal->pitch*normal->h);
+    }
     return normal;
 }
 
@@ -202,7 +351,15 @@ SDL_Surface* TextureLoader::preload(const std::string source) {
  * @param callback  An optional callback for asynchronous loading
  */
 void TextureLoader::materialize(const std::string key, SDL_Surface* surface, LoaderCallback callback) {
-    std::shared_ptr<Texture> texture = Texture::allocWithData(surface->pixels, surface->w, surface->h);
+    if (_budget > 0 && surface != nullptr) {
+        stageUpload(key, nullptr, surface, callback);
+        return;
+    }
+    
+    std::shared_ptr<Texture> texture = nullptr;
+    if (surface != nullptr) {
+        texture = Texture::allocWithData(surface->pixels, surface->w, surface->h);
+    }
     
     bool success = false;
     if (texture != nullptr) {
@@ -242,6 +399,9 @@ void TextureLoader::materialize(const std::string key, SDL_Surface* surface, Loa
  *      "magfilter":    The name of the min filter ("nearest" or "linear")
  *      "wrapS":        The s-coord wrap rule ("clamp", "repeat", or "mirrored")
  *      "wrapT":        The t-coord wrap rule ("clamp", "repeat", or "mirrored")
+ *      "compressed":   An object mapping the compression families "astc", "etc2",
+ *                      and "bc" to KTX files. The first family (in that order)
+ *                      supported by this device replaces "file".
  *
  * The asset key is the key for the JSON directory entry
  *
@@ -253,8 +413,16 @@ void TextureLoader::materialize(const std::string key, SDL_Surface* surface, Loa
  * @param callback  An optional callback for asynchronous loading
  */
 void TextureLoader::materialize(const std::shared_ptr<JsonValue>& json, SDL_Surface* surface, LoaderCallback callback) {
-    std::shared_ptr<Texture> texture = Texture::allocWithData(surface->pixels, surface->w, surface->h);
     std::string key = json->key();
+    if (_budget > 0 && surface != nullptr) {
+        stageUpload(key, json, surface, callback);
+        return;
+    }
+    
+    std::shared_ptr<Texture> texture = nullptr;
+    if (surface != nullptr) {
+        texture = Texture::allocWithData(surface->pixels, surface->w, surface->h);
+    }
 
     bool success = false;
     if (texture != nullptr) {
@@ -284,6 +452,241 @@ void TextureLoader::materialize(const std::shared_ptr<JsonValue>& json, SDL_Surf
     _queue.erase(key);
 }
 
+/**
+ * Adds the SDL_Surface to the upload queue.
+ *
+ * This method is the alternative to {@link materialize} when there is an
+ * upload budget. It takes ownership of the surface. The texture is created
+ * and finished by {@link pumpUploads} over the following animation frames.
+ *
+ * @param key       The key to access the asset after loading
+ * @param json      The asset directory entry (or nullptr if there is none)
+ * @param surface   The SDL_Surface to convert
+ * @param callback  An optional callback for asynchronous loading
+ */
+void TextureLoader::stageUpload(const std::string key, const std::shared_ptr<JsonValue>& json,
+                                SDL_Surface* surface, LoaderCallback callback) {
+    Upload upload;
+    upload.key = key;
+    upload.json = json;
+    upload.surface = surface;
+    upload.texture = nullptr;
+    upload.rows = 0;
+    upload.callback = callback;
+    _uploads.push_back(upload);
+    
+    if (!_pumping) {
+        _pumping = true;
+        // This is called from a scheduled callback, so start next frame
+        Application::get()->schedule([=](void){
+            return this->pumpUploads();
+        });
+    }
+}
+
+/**
+ * Sends the next rows of the upload queue to the graphics card.
+ *
+ * This method is called once an animation frame while the upload queue is
+ * not empty. It sends rows from the oldest textures in the queue until the
+ * upload budget is reached. Every frame sends at least one row, even if
+ * that row is larger than the budget. Any finished texture has its settings
+ * applied and is added to the loader.
+ *
+ * @return true if there are still textures in the upload queue
+ */
+bool TextureLoader::pumpUploads() {
+    size_t sent = 0;
+    // A budget of 0 (set while uploading) flushes the queue
+    while (!_uploads.empty() && (sent == 0 || _budget == 0 || sent < _budget)) {
+        Upload& upload = _uploads.front();
+        SDL_Surface* surface = upload.surface;
+        bool success = true;
+        if (upload.texture == nullptr) {
+            // Allocate the storage now, and fill it in later
+            upload.texture = Texture::allocWithData(nullptr, surface->w, surface->h);
+            success = (upload.texture != nullptr);
+        }
+        
+        if (success) {
+            // RGBA rows are always tightly packed
+            size_t pitch = surface->pitch;
+            size_t space = _budget == 0 ? SIZE_MAX : (_budget > sent ? _budget-sent : 0);
+            int rows = (int)std::max(space/pitch,(size_t)1);
+            rows = std::min(rows,surface->h-upload.rows);
+            
+            const Uint8* pixels = (const Uint8*)surface->pixels;
+            upload.texture->bind();
+            upload.texture->set(pixels+upload.rows*pitch, 0, upload.rows, surface->w, rows);
+            upload.texture->unbind();
+            upload.rows += rows;
+            sent += rows*pitch;
+            if (upload.rows < surface->h) {
+                continue;
+            }
+        }
+        
+        // The texture is complete (or failed)
+        std::shared_ptr<Texture> texture = upload.texture;
+        if (success) {
+            GLuint minflt = _minfilter;
+            GLuint magflt = _magfilter;
+            GLuint wrapS  = _wraps;
+            GLuint wrapT  = _wrapt;
+            bool mipmaps  = _mipmaps;
+            if (upload.json != nullptr) {
+                minflt = decodeMinFilter(upload.json->getString("minfilter",UNKNOWN_MINFLT));
+                magflt = decodeMinFilter(upload.json->getString("magfilter",UNKNOWN_MAGFLT));
+                wrapS = decodeWrap(upload.json->getString("wrapS",UNKNOWN_WRAP));
+                wrapT = decodeWrap(upload.json->getString("wrapT",UNKNOWN_WRAP));
+                mipmaps = upload.json->getBool("mipmaps",false);
+            }
+            
+            _assets[upload.key] = texture;
+            texture->bind();
+            if (mipmaps) { texture->buildMipMaps(); }
+            texture->setMinFilter(minflt);
+            texture->setMagFilter(magflt);
+            texture->setWrapS(wrapS);
+            texture->setWrapT(wrapT);
+            texture->unbind();
+            if (upload.json != nullptr) {
+                parseAtlas(upload.json,texture);
+            }
+        }
+        
+        std::string key = upload.key;
+        LoaderCallback callback = upload.callback;
+        SDL_FreeSurface(surface);
+        _uploads.pop_front();
+        _queue.erase(key);
+        if (callback != nullptr) {
+            callback(key,success);
+        }
+    }
+    
+    _pumping = !_uploads.empty();
+    return _pumping;
+}
+
+/**
+ * Loads the compressed image that is safe to load outside the main thread.
+ *
+ * This is the alternative to {@link preload} for KTX and KTX2 files. The
+ * compressed data is read from the file, but it is not decoded.
+ *
+ * @param source    The pathname to the asset
+ *
+ * @return the compressed image with the texture information
+ */
+std::shared_ptr<CompressedImage> TextureLoader::preloadImage(const std::string source) {
+    CU_PROFILE_SCOPE("TextureLoader::decode");
+    CU_PROFILE_DETAIL(source);
+    // Make sure we reference the asset directory
+#if defined (__WINDOWS__)
+    bool absolute = (bool)strstr(source.c_str(),":") || source[0] == '\\';
+#else
+    bool absolute = source[0] == '/';
+#endif
+    CUAssertLog(!absolute, "This loader does not accept absolute paths for assets");
+    
+    std::string path = Application::get()->getAssetDirectory();
+    path.append(source);
+    return CompressedImage::alloc(path);
+}
+
+/**
+ * Creates an OpenGL texture from the compressed image, and assigns it the given key.
+ *
+ * This method finishes the asset loading started in {@link preloadImage}.
+ * This step is not safe to be done in a separate thread.  Instead, it takes
+ * place in the main CUGL thread via {@link Application#schedule}.
+ *
+ * The loaded texture will have default parameters for scaling and wrap.
+ * It will only have mipmaps if they are stored in the file.
+ *
+ * This method supports an optional callback function which reports whether
+ * the asset was successfully materialized.
+ *
+ * @param key       The key to access the asset after loading
+ * @param image     The compressed image to upload
+ * @param callback  An optional callback for asynchronous loading
+ */
+void TextureLoader::materialize(const std::string key, const std::shared_ptr<CompressedImage>& image,
+                                LoaderCallback callback) {
+    std::shared_ptr<Texture> texture = nullptr;
+    if (image != nullptr) {
+        texture = Texture::allocWithImage(image);
+    }
+    
+    bool success = false;
+    if (texture != nullptr) {
+        _assets[key] = texture;
+        texture->bind();
+        texture->setMinFilter(_minfilter);
+        texture->setMagFilter(_magfilter);
+        texture->setWrapS(_wraps);
+        texture->setWrapT(_wrapt);
+        texture->unbind();
+        success = true;
+    }
+    
+    if (callback != nullptr) {
+        callback(key,success);
+    }
+    _queue.erase(key);
+}
+
+/**
+ * Creates an OpenGL texture from the compressed image accoring to the directory entry.
+ *
+ * This method finishes the asset loading started in {@link preloadImage}.
+ * This step is not safe to be done in a separate thread.  Instead, it takes
+ * place in the main CUGL thread via {@link Application#schedule}.
+ *
+ * The asset key is the key for the JSON directory entry. The texture will
+ * only have mipmaps if they are stored in the file.
+ *
+ * This method supports an optional callback function which reports whether
+ * the asset was successfully materialized.
+ *
+ * @param json      The asset directory entry
+ * @param image     The compressed image to upload
+ * @param callback  An optional callback for asynchronous loading
+ */
+void TextureLoader::materialize(const std::shared_ptr<JsonValue>& json, const std::shared_ptr<CompressedImage>& image,
+                                LoaderCallback callback) {
+    std::shared_ptr<Texture> texture = nullptr;
+    if (image != nullptr) {
+        texture = Texture::allocWithImage(image);
+    }
+    std::string key = json->key();
+    
+    bool success = false;
+    if (texture != nullptr) {
+        GLuint minflt = decodeMinFilter(json->getString("minfilter",UNKNOWN_MINFLT));
+        GLuint magflt = decodeMinFilter(json->getString("magfilter",UNKNOWN_MAGFLT));
+        GLuint wrapS = decodeWrap(json->getString("wrapS",UNKNOWN_WRAP));
+        GLuint wrapT = decodeWrap(json->getString("wrapT",UNKNOWN_WRAP));
+        
+        _assets[key] = texture;
+        texture->bind();
+        texture->setMinFilter(minflt);
+        texture->setMagFilter(magflt);
+        texture->setWrapS(wrapS);
+        texture->setWrapT(wrapT);
+        texture->unbind();
+        parseAtlas(json,texture);
+        
+        success = true;
+    }
+    
+    if (callback != nullptr) {
+        callback(key,success);
+    }
+    _queue.erase(key);
+}
+
 /**
  * Internal method to support asset loading.
  *
@@ -316,10 +719,18 @@ bool TextureLoader::read(const std::string key, const std::string source, Loader
 			_assets[key] = texture;
 		}
         _queue.erase(key);
+    } else if (CompressedImage::isContainer(source)) {
+        _loader->addTask([=](void) {
+            std::shared_ptr<CompressedImage> image = this->preloadImage(source);
+            this->schedule([=](void){
+                this->materialize(key,image,callback);
+                return false;
+            });
+        });
     } else {
         _loader->addTask([=](void) {
             SDL_Surface* surface = this->preload(source);
-            Application::get()->schedule([=](void){
+            this->schedule([=](void){
                 this->materialize(key,surface,callback);
                 return false;
             });
@@ -362,6 +773,13 @@ bool TextureLoader::read(const std::string key, const std::string source, Loader
  *      "magfilter":    The name of the min filter ("nearest" or "linear")
  *      "wrapS":        The s-coord wrap rule ("clamp", "repeat", or "mirrored")
  *      "wrapT":        The t-coord wrap rule ("clamp", "repeat", or "mirrored")
+ *      "compressed":   An object mapping the compression families "astc", "etc2",
+ *                      and "bc" to KTX files. The first family (in that order)
+ *                      supported by this device replaces "file".
+ *      "pack":         An object mapping keys to image files. These images are
+ *                      packed into shared atlas pages, replacing "file".
+ *      "pagesize":     The maximum width and height of a packed page (int)
+ *      "padding":      The transparent pixels between packed images (int)
  *
  * @param json      The directory entry for the asset
  * @param callback  An optional callback for asynchronous loading
@@ -376,7 +794,22 @@ bool TextureLoader::read(const std::shared_ptr<JsonValue>& json, LoaderCallback
     }
     _queue.emplace(key);
     
-    std::string source = json->getString("file",UNKNOWN_SOURCE);
+    if (json->has("pack")) {
+        if (_loader == nullptr || !async) {
+            materializePack(json,preloadPack(json),nullptr);
+            return _assets.find(key) != _assets.end();
+        }
+        _loader->addTask([=](void) {
+            std::shared_ptr<PackedAtlas> atlas = this->preloadPack(json);
+            this->schedule([=](void){
+                this->materializePack(json,atlas,callback);
+                return false;
+            });
+        });
+        return false;
+    }
+    
+    std::string source = select_source(json);
     bool success = false;
     if (_loader == nullptr || !async) {
         std::shared_ptr<Texture> texture = Texture::allocWithFile(source);
@@ -385,10 +818,18 @@ bool TextureLoader::read(const std::shared_ptr<JsonValue>& json, LoaderCallback
 			_assets[key] = texture;
 		}
         _queue.erase(key);
+    } else if (CompressedImage::isContainer(source)) {
+        _loader->addTask([=](void) {
+            std::shared_ptr<CompressedImage> image = this->preloadImage(source);
+            this->schedule([=](void){
+                this->materialize(json,image,callback);
+                return false;
+            });
+        });
     } else {
         _loader->addTask([=](void) {
             SDL_Surface* surface = this->preload(source);
-            Application::get()->schedule([=](void){
+            this->schedule([=](void){
                 this->materialize(json,surface,callback);
                 return false;
             });
@@ -441,6 +882,14 @@ bool TextureLoader::purge(const std::shared_ptr<JsonValue>& json) {
     }
     _assets.erase(it);
     
+    JsonValue* packed = json->get("pack").get();
+    if (packed) {
+        for(int ii = 0; ii < packed->size(); ii++) {
+            _assets.erase(packed->get(ii)->key());
+        }
+        for(int ii = 1; _assets.erase(key+"_page"+std::to_string(ii)) > 0; ii++) {}
+    }
+    
     JsonValue* child = json->get("atlas").get();
     bool success = true;
     if (child) {
@@ -458,6 +907,59 @@ bool TextureLoader::purge(const std::shared_ptr<JsonValue>& json) {
     return success;
 }
 
+/**
+ * Returns the files read to load the given directory entry
+ *
+ * This is the source file chosen for this device (see the "compressed"
+ * attribute), or every image of a packed atlas. This method queries the
+ * OpenGL context, and so it must be called in the main thread.
+ *
+ * @param json      The directory entry for the asset
+ *
+ * @return the files read to load the given directory entry
+ */
+std::vector<std::string> TextureLoader::locate(const std::shared_ptr<JsonValue>& json) const {
+    std::vector<std::string> result;
+    JsonValue* packed = json->get("pack").get();
+    if (packed) {
+        for(int ii = 0; ii < packed->size(); ii++) {
+            result.push_back(packed->get(ii)->asString());
+        }
+        return result;
+    }
+    
+    std::string source = select_source(json);
+    if (source != UNKNOWN_SOURCE) {
+        result.push_back(source);
+    }
+    return result;
+}
+
+/**
+ * Returns the estimated GPU memory used by the given texture in bytes
+ *
+ * Subtextures share the memory of their parent, and so have size 0.
+ * Compressed textures are assumed to use one byte per pixel, and mipmaps
+ * add a third to the size of the texture.
+ *
+ * @param asset The texture to measure
+ *
+ * @return the estimated GPU memory used by the given texture in bytes
+ */
+size_t TextureLoader::measure(const std::shared_ptr<Texture>& asset) const {
+    if (asset == nullptr || asset->getParent() != nullptr) {
+        return 0;
+    }
+    size_t result = (size_t)asset->getWidth()*(size_t)asset->getHeight();
+    if (!asset->isCompressed()) {
+        result *= asset->getByteSize();
+    }
+    if (asset->hasMipMaps()) {
+        result += result/3;
+    }
+    return result;
+}
+
 #pragma mark -
 #pragma mark Atlas Support
 /**
@@ -487,3 +989,181 @@ void TextureLoader::parseAtlas(const std::shared_ptr<JsonValue>& json, const std
     }
 }
 
+/**
+ * Loads and packs the images of a packed atlas outside the main thread.
+ *
+ * A packed atlas is a directory entry with a "pack" object mapping keys to
+ * image files. The images are read and arranged into as few atlas pages as
+ * possible with a skyline packer. The pages are images in memory; they are
+ * not yet textures. This method returns nullptr if any image fails to load
+ * or is larger than a page.
+ *
+ * @param json      The asset directory entry
+ *
+ * @return the atlas pages and the position of each image
+ */
+std::shared_ptr<TextureLoader::PackedAtlas> TextureLoader::preloadPack(const std::shared_ptr<JsonValue>& json) {
+    JsonValue* packed = json->get("pack").get();
+    int size = json->getInt("pagesize",DEFAULT_PAGE);
+    int padding = json->getInt("padding",DEFAULT_PADDING);
+
+    std::vector<SDL_Surface*> images;
+    std::shared_ptr<PackedAtlas> atlas = std::make_shared<PackedAtlas>();
+    bool success = true;
+    for(int ii = 0; success && ii < packed->size(); ii++) {
+        JsonValue* item = packed->get(ii).get();
+        SDL_Surface* image = preload(item->asString());
+        if (image == nullptr) {
+            CULogError("Could not load packed image %s. %s", item->asString().c_str(), SDL_GetError());
+            success = false;
+        } else if (image->w+padding > size || image->h+padding > size) {
+            CULogError("Packed image %s is larger than the page size %d", item->asString().c_str(), size);
+            SDL_FreeSurface(image);
+            success = false;
+        } else {
+            SDL_Rect rect = { 0, 0, image->w, image->h };
+            atlas->names.push_back(item->key());
+            atlas->bounds.push_back(rect);
+            atlas->page.push_back(0);
+            images.push_back(image);
+        }
+    }
+    if (!success) {
+        for(auto it = images.begin(); it != images.end(); ++it) {
+            SDL_FreeSurface(*it);
+        }
+        return nullptr;
+    }
+
+    // Skyline packing works best on images sorted by height
+    std::vector<size_t> order(images.size());
+    for(size_t ii = 0; ii < order.size(); ii++) {
+        order[ii] = ii;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return images[a]->h > images[b]->h;
+    });
+
+    std::vector<std::vector<skyline_node>> skylines;
+    std::vector<int> heights;
+    for(auto it = order.begin(); it != order.end(); ++it) {
+        SDL_Rect rect = { 0, 0, images[*it]->w+padding, images[*it]->h+padding };
+        size_t page = 0;
+        while (page < skylines.size() && !skyline_insert(skylines[page], rect, size)) {
+            page++;
+        }
+        if (page == skylines.size()) {
+            skyline_node node = { 0, 0, size };
+            skylines.push_back(std::vector<skyline_node>(1,node));
+            heights.push_back(0);
+            skyline_insert(skylines[page], rect, size);
+        }
+        heights[page] = std::max(heights[page],rect.y+rect.h);
+        atlas->page[*it] = page;
+        atlas->bounds[*it].x = rect.x;
+        atlas->bounds[*it].y = rect.y;
+    }
+
+    // Pages only need to be as tall as their content
+#if CU_MEMORY_ORDER == CU_ORDER_REVERSED
+    Uint32 format = SDL_PIXELFORMAT_ABGR8888;
+#else
+    Uint32 format = SDL_PIXELFORMAT_RGBA8888;
+#endif
+    for(size_t ii = 0; ii < skylines.size(); ii++) {
+        int height = std::min((int)nextPOT(heights[ii]),size);
+        SDL_Surface* page = SDL_CreateRGBSurfaceWithFormat(0, size, height, 32, format);
+        if (page == nullptr) {
+            CULogError("Could not allocate atlas page. %s", SDL_GetError());
+            success = false;
+        }
+        atlas->pages.push_back(page);
+    }
+    for(size_t ii = 0; ii < images.size(); ii++) {
+        if (success) {
+            SDL_SetSurfaceBlendMode(images[ii], SDL_BLENDMODE_NONE);
+            SDL_Rect dst = atlas->bounds[ii];
+            SDL_BlitSurface(images[ii], nullptr, atlas->pages[atlas->page[ii]], &dst);
+        }
+        SDL_FreeSurface(images[ii]);
+    }
+    if (!success) {
+        for(auto it = atlas->pages.begin(); it != atlas->pages.end(); ++it) {
+            SDL_FreeSurface(*it);
+        }
+        return nullptr;
+    }
+    return atlas;
+}
+
+/**
+ * Creates the OpenGL textures for a packed atlas.
+ *
+ * This method finishes the asset loading started in {@link preloadPack}.
+ * The first page is assigned the key of the directory entry, and page n
+ * (n > 0) is assigned that key followed by "_page" and n. Every packed
+ * image is a subtexture of its page, assigned the key that it had in the
+ * "pack" object. Hence code that asks for the image by key does not need
+ * to know that it was packed.
+ *
+ * This method supports an optional callback function which reports whether
+ * the asset was successfully materialized.
+ *
+ * @param json      The asset directory entry
+ * @param atlas     The atlas pages (or nullptr if packing failed)
+ * @param callback  An optional callback for asynchronous loading
+ */
+void TextureLoader::materializePack(const std::shared_ptr<JsonValue>& json,
+                                    const std::shared_ptr<PackedAtlas>& atlas,
+                                    LoaderCallback callback) {
+    std::string key = json->key();
+    bool success = (atlas != nullptr);
+    std::vector<std::shared_ptr<Texture>> pages;
+    if (success) {
+        GLuint minflt = decodeMinFilter(json->getString("minfilter",UNKNOWN_MINFLT));
+        GLuint magflt = decodeMinFilter(json->getString("magfilter",UNKNOWN_MAGFLT));
+        GLuint wrapS = decodeWrap(json->getString("wrapS",UNKNOWN_WRAP));
+        GLuint wrapT = decodeWrap(json->getString("wrapT",UNKNOWN_WRAP));
+        bool mipmaps = json->getBool("mipmaps",false);
+        
+        for(auto it = atlas->pages.begin(); success && it != atlas->pages.end(); ++it) {
+            std::shared_ptr<Texture> texture = Texture::allocWithData((*it)->pixels, (*it)->w, (*it)->h);
+            if (texture == nullptr) {
+                success = false;
+            } else {
+                texture->bind();
+                if (mipmaps) { texture->buildMipMaps(); }
+                texture->setMinFilter(minflt);
+                texture->setMagFilter(magflt);
+                texture->setWrapS(wrapS);
+                texture->setWrapT(wrapT);
+                texture->unbind();
+                pages.push_back(texture);
+            }
+        }
+        for(auto it = atlas->pages.begin(); it != atlas->pages.end(); ++it) {
+            SDL_FreeSurface(*it);
+        }
+        atlas->pages.clear();
+    }
+    
+    if (success) {
+        for(size_t ii = 0; ii < pages.size(); ii++) {
+            _assets[ii == 0 ? key : key+"_page"+std::to_string(ii)] = pages[ii];
+        }
+        for(size_t ii = 0; ii < atlas->names.size(); ii++) {
+            const std::shared_ptr<Texture>& page = pages[atlas->page[ii]];
+            const SDL_Rect& rect = atlas->bounds[ii];
+            float w = (float)page->getWidth();
+            float h = (float)page->getHeight();
+            _assets[atlas->names[ii]] = page->getSubTexture(rect.x/w, (rect.x+rect.w)/w,
+                                                              rect.y/h, (rect.y+rect.h)/h);
+        }
+        parseAtlas(json,pages[0]);
+    }
+    
+    if (callback != nullptr) {
+        callback(key,success);
+    }
+    _queue.erase(key);
+}
@@ -43,7 +43,7 @@
 //  Version: 12/23/22
 //
 #include <cugl/assets/CUWidgetLoader.h>
-#include <cugl/io/CUJsonReader.h>
+#include <cugl/assets/CUJsonDocument.h>
 #include <cugl/base/CUApplication.h>
 
 using namespace cugl;
@@ -111,17 +111,17 @@ bool WidgetLoader::read(const std::string key, const std::string source, LoaderC
     
     bool success = false;
     if (_loader == nullptr || !async) {
-        std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(source);
-        std::shared_ptr<JsonValue> json = (reader == nullptr ? nullptr : reader->readJson());
+        std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(source);
+        std::shared_ptr<JsonValue> json = (doc == nullptr ? nullptr : doc->getRoot().toJsonValue());
 		std::shared_ptr<WidgetValue> widget = WidgetValue::alloc(json);
         success = (widget != nullptr);
         materialize(key,widget,callback);
     } else {
         _loader->addTask([=](void) {
-            std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(source);
-            std::shared_ptr<JsonValue> json = (reader == nullptr ? nullptr : reader->readJson());
+            std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(source);
+            std::shared_ptr<JsonValue> json = (doc == nullptr ? nullptr : doc->getRoot().toJsonValue());
 			std::shared_ptr<WidgetValue> widget = WidgetValue::alloc(json);
-            Application::get()->schedule([=](void) {
+            this->schedule([=](void) {
                 this->materialize(key,widget,callback);
                 return false;
             });
@@ -161,17 +161,17 @@ bool WidgetLoader::read(const std::shared_ptr<JsonValue>& json, LoaderCallback c
     
     bool success = false;
     if (_loader == nullptr || !async) {
-        std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(source);
-        std::shared_ptr<JsonValue> json = (reader == nullptr ? nullptr : reader->readJson());
+        std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(source);
+        std::shared_ptr<JsonValue> json = (doc == nullptr ? nullptr : doc->getRoot().toJsonValue());
 		std::shared_ptr<WidgetValue> widget = WidgetValue::alloc(json);
         success = (widget != nullptr);
         materialize(key,widget,callback);
     } else {
         _loader->addTask([=](void) {
-            std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(source);
-            std::shared_ptr<JsonValue> json = (reader == nullptr ? nullptr : reader->readJson());
+            std::shared_ptr<JsonDocument> doc = JsonDocument::allocWithAsset(source);
+            std::shared_ptr<JsonValue> json = (doc == nullptr ? nullptr : doc->getRoot().toJsonValue());
 			std::shared_ptr<WidgetValue> widget = WidgetValue::alloc(json);
-            Application::get()->schedule([=](void) {
+            this->schedule([=](void) {
                 this->materialize(key,widget,callback);
                 return false;
             });
@@ -31,6 +31,7 @@
 //
 #include <cugl/audio/CUAudioDecoder.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/io/CUAssetBundle.h>
 
 using namespace cugl;
 
@@ -84,21 +85,28 @@ bool AudioDecoder::init(const std::string file) {
  * @return true if the decoder was initialized successfully
  */
 bool AudioDecoder::init(const std::string file, AudioType type) {
+    // Open through the bundles, as the file may be packed. The codec takes ownership.
+    SDL_RWops* stream = AssetBundle::openStream(file);
+    if (stream == NULL) {
+        CULogError("File %s not found.", file.c_str());
+        return false;
+    }
     switch(type) {
     case AudioType::WAV_FILE:
-        _source = CODEC_OpenWAV(file.c_str());
+        _source = CODEC_OpenWAVRW(stream);
         break;
     case AudioType::MP3_FILE:
-        _source = CODEC_OpenMPEG(file.c_str());
+        _source = CODEC_OpenMPEGRW(stream);
         break;
     case AudioType::OGG_FILE:
-        _source = CODEC_OpenVorbis(file.c_str());
+        _source = CODEC_OpenVorbisRW(stream);
         break;
     case AudioType::FLAC_FILE:
-        _source = CODEC_OpenFLAC(file.c_str());
+        _source = CODEC_OpenFLACRW(stream);
         break;
     default:
         CULogError("No decoder support for type %s", audio::typeName(type).c_str());
+        SDL_RWclose(stream);
         return false;
     }
     if (_source == NULL) {
@@ -118,6 +126,70 @@ bool AudioDecoder::init(const std::string file, AudioType type) {
     return true;
 }
 
+/**
+ * Initializes a new decoder for the given encoded file data.
+ *
+ * The data is the complete contents of an audio file of the given type,
+ * still in its compressed form. The decoder reads from this memory instead
+ * of the file system, and keeps a reference to the data while it is open.
+ * The name is only used for error messages and {@link getFile}.
+ *
+ * If the audio type is not correct for this data, this initializer
+ * will fail and return false.
+ *
+ * @param name  the name of the source file for the data
+ * @param data  the encoded file data
+ * @param type  the codec type for this data
+ *
+ * @return true if the decoder was initialized successfully
+ */
+bool AudioDecoder::initWithData(const std::string name, const std::shared_ptr<std::vector<Uint8>>& data,
+                                AudioType type) {
+    if (data == nullptr || data->empty()) {
+        CULogError("No data for audio source %s.", name.c_str());
+        return false;
+    }
+
+    // The codec takes ownership of this stream
+    SDL_RWops* stream = SDL_RWFromConstMem(data->data(), (int)data->size());
+    switch(type) {
+    case AudioType::WAV_FILE:
+        _source = CODEC_OpenWAVRW(stream);
+        break;
+    case AudioType::MP3_FILE:
+        _source = CODEC_OpenMPEGRW(stream);
+        break;
+    case AudioType::OGG_FILE:
+        _source = CODEC_OpenVorbisRW(stream);
+        break;
+    case AudioType::FLAC_FILE:
+        _source = CODEC_OpenFLACRW(stream);
+        break;
+    default:
+        CULogError("No decoder support for type %s", audio::typeName(type).c_str());
+        if (stream != NULL) {
+            SDL_RWclose(stream);
+        }
+        return false;
+    }
+    if (_source == NULL) {
+        CULogError("Data for %s is not a valid %s.",name.c_str(),audio::typeName(type).c_str());
+        return false;
+    }
+    _file = name;
+    _type = type;
+    _data = data;
+
+    _channels = _source->channels;
+    _rate   = _source->rate;
+    _frames = _source->frames;
+
+    _pagesize = CODEC_PageSize(_source);
+    _lastpage = CODEC_LastPage(_source);
+    _currpage = 0;
+    return true;
+}
+
 /**
  * Deletes the decoder resources and resets all attributes.
  *
@@ -129,6 +201,7 @@ void AudioDecoder::dispose() {
         CODEC_Close(_source);
         _source = NULL;
     }
+    _data = nullptr;
     _rate = 0;
     _file = "";
     _frames = 0;
@@ -48,6 +48,17 @@ AudioEngine* AudioEngine::_gEngine = nullptr;
 /** The read size to use for the audio devices */
 Uint32 AudioEngine::_readsize = 0;
 
+/** The default number of spatial emitters with a voice */
+#define SPATIAL_VOICES      8
+/** The default distance at which emitters begin to attenuate */
+#define SPATIAL_NEAR        1.0f
+/** The default distance at which emitters are silent */
+#define SPATIAL_FAR         100.0f
+/** The gain below which an emitter is culled */
+#define SPATIAL_EPSILON     0.001f
+/** The voice priority of a spatial emitter (below normal effects) */
+#define SPATIAL_PRIORITY    -1
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -57,7 +68,13 @@ Uint32 AudioEngine::_readsize = 0;
  */
 AudioEngine::AudioEngine() :
 _capacity(0),
-_primary(false) {
+_primary(false),
+_counter(0),
+_maxvoices(0),
+_nextEmitter(0),
+_nearDistance(SPATIAL_NEAR),
+_farDistance(SPATIAL_FAR),
+_spatialVoices(0) {
     _output = nullptr;
     _mixer  = nullptr;
 }
@@ -81,6 +98,11 @@ bool AudioEngine::init(const std::shared_ptr<AudioOutput>& device, Uint32 slots)
     }
     
     _capacity = slots;
+    _maxvoices = slots;
+    _counter  = 0;
+    _spatialVoices = std::min((size_t)SPATIAL_VOICES,_capacity);
+    _priorities.resize(_capacity+1,0);
+    _stamps.resize(_capacity+1,0);
     _output = device;
     _mixer  = AudioMixer::alloc(_capacity+1,_output->getChannels(),_output->getRate());
     
@@ -115,6 +137,7 @@ bool AudioEngine::init(const std::shared_ptr<AudioOutput>& device, Uint32 slots)
     for(int ii = 0; ii < 2*_capacity; ii++) {
         _fadePool.push_back(AudioFader::alloc(_mixer->getChannels(),_mixer->getRate()));
         _panPool.push_back(AudioPanner::alloc(_mixer->getChannels(),2,_mixer->getRate()));
+        _playPool.push_back(std::make_shared<AudioPlayer>());
     }
     
     _output->attach(_mixer);
@@ -141,14 +164,24 @@ void AudioEngine::dispose() {
         
         _fadePool.clear();
         _panPool.clear();
+        _playPool.clear();
+        _samplePool.clear();
+        _priorities.clear();
+        _stamps.clear();
         _capacity = 0;
+        _maxvoices = 0;
+        _counter = 0;
+        
+        _emitters.clear();
+        _emitterids.clear();
+        _audibles.clear();
+        _spatialVoices = 0;
         
 		_output = nullptr;
         _mixer = nullptr;
         
         _queues.clear();
 		_actives.clear();
-        _evicts.clear();
 	}
 }
 
@@ -165,14 +198,115 @@ void AudioEngine::dispose() {
  */
 void AudioEngine::removeKey(const std::string key) {
     _actives.erase(key);
-    for(auto it = _evicts.begin(); it != _evicts.end(); ) {
-        if (*it == key) {
-            it = _evicts.erase(it);
-            break;
-        } else {
-            it++;
+}
+
+/**
+ * Returns a slot for a new sound effect of the given priority
+ *
+ * This method first looks for an empty slot, provided that the number of
+ * active effects is less than {@link #getMaxVoices}. It then looks for a
+ * slot whose effect is fading out. If neither exists, it steals the
+ * voice of the active effect with the lowest priority. Ties are broken
+ * by choosing the quietest voice, and then the oldest. Only effects of
+ * strictly lower priority may be stolen unless force is true, in which
+ * case the priority is ignored.
+ *
+ * This method returns -1 if there is no slot available.
+ *
+ * @param priority  The priority of the new sound effect
+ * @param force     Whether to ignore priority when stealing a voice
+ *
+ * @return a slot for a new sound effect of the given priority
+ */
+Sint32 AudioEngine::acquireSlot(Sint32 priority, bool force) {
+    // Find an empty scheduler
+    Sint32 audioID = -1;
+    if (_actives.size() < _maxvoices) {
+        for(auto it = _slots.begin()+1; audioID == -1 && it != _slots.end(); ++it) {
+            if (!(*it)->isPlaying()) {
+                audioID = (*it)->getTag();
+            }
+        }
+    }
+    
+    // Try again for soon to be deleted.
+    for(auto it = _actives.begin(); audioID == -1 && it != _actives.end(); ++it) {
+        if (it->second->isFadeOut()) {
+            Uint32 tag = it->second->getTag();
+            if (!_slots[tag]->getTailSize()) {
+                audioID = tag;
+            }
+        }
+    }
+    
+    if (audioID != -1) {
+        return audioID;
+    }
+
+    // Steal the lowest priority, then quietest, then oldest voice
+    auto victim = _actives.end();
+    Sint32 bestprio = 0;
+    float  bestgain = 0;
+    Uint64 beststamp = 0;
+    for(auto it = _actives.begin(); it != _actives.end(); ++it) {
+        Uint32 tag = it->second->getTag();
+        Sint32 prio = _priorities[tag];
+        if (!force && prio >= priority) {
+            continue;
+        }
+        float gain = it->second->getGain();
+        Uint64 stamp = _stamps[tag];
+        bool better = victim == _actives.end();
+        if (!better) {
+            if (prio != bestprio) {
+                better = prio < bestprio;
+            } else if (gain != bestgain) {
+                better = gain < bestgain;
+            } else {
+                better = stamp < beststamp;
+            }
+        }
+        if (better) {
+            victim = it;
+            bestprio = prio;
+            bestgain = gain;
+            beststamp = stamp;
+        }
+    }
+    
+    if (victim == _actives.end()) {
+        return -1;
+    }
+
+    std::string altkey = victim->first;
+    audioID = victim->second->getTag();
+    clear(altkey,0);
+    removeKey(altkey);
+    return audioID;
+}
+
+/**
+ * Returns a playback node for the given sound asset
+ *
+ * If the sound is an {@link AudioSample}, this method reinitializes a
+ * player from the object pool, so no allocation is required. Otherwise,
+ * (or if the pool is empty) it uses {@link Sound#createNode}.
+ *
+ * @param sound     The sound asset to play
+ *
+ * @return a playback node for the given sound asset
+ */
+std::shared_ptr<audio::AudioNode> AudioEngine::acquirePlayer(const std::shared_ptr<Sound>& sound) {
+    std::shared_ptr<AudioSample> sample = std::dynamic_pointer_cast<AudioSample>(sound);
+    if (sample != nullptr && !_playPool.empty()) {
+        std::shared_ptr<AudioPlayer> player = _playPool.front();
+        _playPool.pop_front();
+        if (player->init(sample)) {
+            player->setGain(sample->getVolume());
+            return player;
         }
     }
+    return sound->createNode();
 }
 
 /**
@@ -184,10 +318,10 @@ void AudioEngine::removeKey(const std::string key) {
  * arbitrary audio subgraphs. This method uses the object pools to simplify
  * this process.
  *
- * This method will also allocated an {@link AudioResampler} if the sample
- * rate is not consistent with the engine.  However, these are extremely
- * heavy-weight and cannot be easily reused, and this is to be avoided if
- * at all possible.
+ * This method will also use an {@link AudioResampler} if the sample rate
+ * is not consistent with the engine. These are heavy-weight, so they are
+ * pooled by channels and input rate. A resampler is only allocated if
+ * there is no pooled one with the same settings.
  *
  * @param instance  The audio instance
  *
@@ -217,9 +351,20 @@ std::shared_ptr<audio::AudioFader> AudioEngine::wrapInstance(const std::shared_p
     if (instance->getRate() == panner->getRate()) {
         panner->attach(instance);
     } else {
-        std::shared_ptr<audio::AudioResampler> sampler;
-        sampler = audio::AudioResampler::alloc(instance->getChannels(),panner->getRate());
-        sampler->setName("__engine_resampler__");
+        std::shared_ptr<audio::AudioResampler> sampler = nullptr;
+        for(auto it = _samplePool.begin(); it != _samplePool.end(); ++it) {
+            if ((*it)->getChannels() == instance->getChannels() &&
+                (*it)->getInputRate() == instance->getRate()) {
+                sampler = *it;
+                *it = _samplePool.back();
+                _samplePool.pop_back();
+                break;
+            }
+        }
+        if (sampler == nullptr) {
+            sampler = audio::AudioResampler::alloc(instance->getChannels(),panner->getRate());
+            sampler->setName("__engine_resampler__");
+        }
         sampler->attach(instance);
         panner->attach(sampler);
     }
@@ -276,6 +421,9 @@ std::shared_ptr<audio::AudioNode> AudioEngine::disposeWrapper(const std::shared_
                 source = sampler->getInput();
                 sampler->detach();
                 sampler->reset();
+                if (_samplePool.size() < 2*_capacity) {
+                    _samplePool.push_back(sampler);
+                }
             }
 
             fader->detach();
@@ -307,8 +455,21 @@ std::shared_ptr<audio::AudioNode> AudioEngine::disposeWrapper(const std::shared_
  */
 void AudioEngine::gcollect(const std::shared_ptr<audio::AudioNode>& sound, bool status) {
     std::string key = sound->getName();
-    disposeWrapper(sound);
-    removeKey(key);
+    
+    // The key may have been reused by a voice that replaced this one
+    auto it = _actives.find(key);
+    if (it != _actives.end() && it->second == sound) {
+        removeKey(key);
+    }
+
+    std::shared_ptr<AudioNode> source = disposeWrapper(sound);
+    if (source != nullptr && source->getName() == "__engine_playback__") {
+        std::shared_ptr<AudioPlayer> player = std::dynamic_pointer_cast<AudioPlayer>(source);
+        if (player != nullptr && player.use_count() == 2 && _playPool.size() < 2*_capacity) {
+            player->dispose();
+            _playPool.push_back(player);
+        }
+    }
     if (_callback) {
         _callback(key,status);
     }
@@ -600,21 +761,24 @@ void AudioEngine::freeQueue(const std::shared_ptr<AudioQueue>& queue) {
  * method will stop the existing sound and replace it with this one. It
  * is the responsibility of the application layer to manage key usage.
  *
- * There are a limited number of slots available for sounds. If you go
- * over the number available, the sound will not play unless `force` is
- * true. In that case, it will grab the channel from the longest playing
- * sound effect.
+ * There are a limited number of voices available for sounds (see
+ * {@link #getMaxVoices}). If you go over the number available, the sound
+ * will steal the voice of an active effect with lower priority. Among
+ * those, it takes the quietest voice, and then the longest playing one.
+ * If there is no effect with lower priority, the sound will not play
+ * unless `force` is true. In that case, it ignores priority.
  *
  * @param  key      The reference key for the sound effect
  * @param  sound    The sound effect to play
  * @param  loop     Whether to loop the sound effect continuously
  * @param  volume   The music volume (relative to the default asset volume)
  * @param  force    Whether to force another sound to stop.
+ * @param  priority The priority of this sound for voice stealing
  *
  * @return true if there was an available channel for the sound
  */
 bool AudioEngine::play(const std::string key, const std::shared_ptr<Sound>& sound,
-                       bool loop, float volume, bool force) {
+                       bool loop, float volume, bool force, Sint32 priority) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
 
     if (isActive(key)) {
@@ -627,37 +791,14 @@ bool AudioEngine::play(const std::string key, const std::shared_ptr<Sound>& soun
         }
     }
     
-    // Find an empty scheduler
-    int audioID = -1;
-    for(auto it = _slots.begin()+1; audioID == -1 && it != _slots.end(); ++it) {
-        if (!(*it)->isPlaying()) {
-            audioID = (*it)->getTag();
-        }
-    }
-    
-    // Try again for soon to be deleted.
-    for(auto it = _actives.begin(); audioID == -1 && it != _actives.end(); ++it) {
-        if (it->second->isFadeOut()) {
-            Uint32 tag = it->second->getTag();
-            if (!_slots[tag]->getTailSize()) {
-                audioID = tag;
-            }
-        }
-    }
-    
+    Sint32 audioID = acquireSlot(priority,force);
     if (audioID == -1) {
-        if (force && !_evicts.empty()) {
-            std::string altkey = _evicts.front();
-            audioID = _actives[altkey]->getTag();
-            clear(altkey);
-        } else {
-            // Fail if nothing available
-            CULogError("No available sound channels");
-            return false;
-        }
+        // Fail if nothing available
+        CULogError("No available sound channels");
+        return false;
     }
     //CULog("Slot %d",audioID);
-    std::shared_ptr<audio::AudioNode> player = sound->createNode();
+    std::shared_ptr<audio::AudioNode> player = acquirePlayer(sound);
     player->setName("__engine_playback__");
 
     std::shared_ptr<AudioFader> fader = wrapInstance(player);
@@ -666,7 +807,8 @@ bool AudioEngine::play(const std::string key, const std::shared_ptr<Sound>& soun
     fader->setName(key);
     _slots[audioID]->play(fader, loop ? -1 : 0);
     _actives.emplace(key,fader);
-    _evicts.push_back(key);
+    _priorities[audioID] = priority;
+    _stamps[audioID] = ++_counter;
     return true;
 }
 
@@ -687,21 +829,24 @@ bool AudioEngine::play(const std::string key, const std::shared_ptr<Sound>& soun
  * method will stop the existing sound and replace it with this one. It
  * is the responsibility of the application layer to manage key usage.
  *
- * There are a limited number of slots available for sounds. If you go
- * over the number available, the sound will not play unless `force` is
- * true. In that case, it will grab the channel from the longest playing
- * sound effect.
+ * There are a limited number of voices available for sounds (see
+ * {@link #getMaxVoices}). If you go over the number available, the sound
+ * will steal the voice of an active effect with lower priority. Among
+ * those, it takes the quietest voice, and then the longest playing one.
+ * If there is no effect with lower priority, the sound will not play
+ * unless `force` is true. In that case, it ignores priority.
  *
  * @param  key      The reference key for the sound effect
  * @param  graph    The audio graph to play
  * @param  loop     Whether to loop the sound effect continuously
  * @param  volume   The music volume (relative to the default instance volume)
  * @param  force    Whether to force another sound to stop.
+ * @param  priority The priority of this sound for voice stealing
  *
  * @return true if there was an available channel for the sound
  */
 bool AudioEngine::play(const std::string key, const std::shared_ptr<audio::AudioNode>& graph,
-                       bool loop, float volume, bool force) {
+                       bool loop, float volume, bool force, Sint32 priority) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
     CUAssertLog(graph->getName() != "__engine_playback__",  "Audio node uses reserved name '__engine_playback__'");
     CUAssertLog(graph->getName() != "__engine_resampler__", "Audio node uses reserved name '__engine_resampler__'");
@@ -716,34 +861,11 @@ bool AudioEngine::play(const std::string key, const std::shared_ptr<audio::Audio
         }
     }
     
-    // Find an empty scheduler
-    int audioID = -1;
-    for(auto it = _slots.begin()+1; audioID == -1 && it != _slots.end(); ++it) {
-        if (!(*it)->isPlaying()) {
-            audioID = (*it)->getTag();
-        }
-    }
-    
-    // Try again for soon to be deleted.
-    for(auto it = _actives.begin(); audioID == -1 && it != _actives.end(); ++it) {
-        if (it->second->isFadeOut()) {
-            Uint32 tag = it->second->getTag();
-            if (!_slots[tag]->getTailSize()) {
-                audioID = tag;
-            }
-        }
-    }
-    
+    Sint32 audioID = acquireSlot(priority,force);
     if (audioID == -1) {
-        if (force && !_evicts.empty()) {
-            std::string altkey = _evicts.front();
-            audioID = _actives[altkey]->getTag();
-            clear(altkey);
-        } else {
-            // Fail if nothing available
-            CULogError("No available sound channels");
-            return false;
-        }
+        // Fail if nothing available
+        CULogError("No available sound channels");
+        return false;
     }
 
     std::shared_ptr<AudioFader> fader = wrapInstance(graph);
@@ -752,10 +874,61 @@ bool AudioEngine::play(const std::string key, const std::shared_ptr<audio::Audio
     fader->setName(key);
     _slots[audioID]->play(fader, loop ? -1 : 0);
     _actives.emplace(key,fader);
-    _evicts.push_back(key);
+    _priorities[audioID] = priority;
+    _stamps[audioID] = ++_counter;
     return true;
 }
 
+/**
+ * Sets the maximum number of simultaneous sound effects.
+ *
+ * This value is a voice budget that may be less than the number of slots
+ * allocated when the engine was started. Limiting the voices limits the
+ * mixing cost when many effects are triggered at once. The value is
+ * clamped to the number of slots. Lowering the budget does not stop any
+ * active effects; it only applies to future calls to {@link #play}.
+ *
+ * @param voices    The maximum number of simultaneous sound effects.
+ */
+void AudioEngine::setMaxVoices(size_t voices) {
+    _maxvoices = voices < _capacity ? voices : _capacity;
+}
+
+/**
+ * Returns the voice stealing priority of the sound effect.
+ *
+ * A new sound effect may only steal the voice of an effect with lower
+ * priority (unless it is forced). If the key does not correspond to an
+ * active sound effect, this method returns 0.
+ *
+ * @param  key  the reference key for the sound effect
+ *
+ * @return the voice stealing priority of the sound effect.
+ */
+Sint32 AudioEngine::getPriority(const std::string key) const {
+    CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
+    if (_actives.find(key) != _actives.end()) {
+        return _priorities[_actives.at(key)->getTag()];
+    }
+    return 0;
+}
+
+/**
+ * Sets the voice stealing priority of the sound effect.
+ *
+ * A new sound effect may only steal the voice of an effect with lower
+ * priority (unless it is forced). If the key does not correspond to an
+ * active sound effect, this method does nothing.
+ *
+ * @param  key      the reference key for the sound effect
+ * @param  priority the voice stealing priority of the sound effect
+ */
+void AudioEngine::setPriority(const std::string key, Sint32 priority) {
+    CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
+    if (_actives.find(key) != _actives.end()) {
+        _priorities[_actives.at(key)->getTag()] = priority;
+    }
+}
 
 /**
  * Returns the current state of the sound effect for the given key.
@@ -1173,6 +1346,260 @@ void AudioEngine::resume(std::string key) {
 }
 
 
+#pragma mark -
+#pragma mark Spatial Audio
+/**
+ * Returns the identifier of a newly added spatial emitter.
+ *
+ * An emitter is a lightweight record of a sound at a position. Adding an
+ * emitter does not play the sound. Each call to {@link #updateSpatial}
+ * computes the attenuation of every emitter from the listener, and only
+ * the loudest emitters (see {@link #getSpatialVoices}) are given a voice.
+ * Those voices are sound effects that are panned by the emitter position,
+ * but they have a lower priority than normal sound effects. So a sound
+ * effect may steal the voice of an emitter.
+ *
+ * A looping emitter restarts its sound whenever it regains a voice. A
+ * non-looping emitter only plays once, and is silent from then on.
+ *
+ * @param sound     The sound for this emitter
+ * @param position  The emitter position
+ * @param gain      The emitter gain (before attenuation)
+ * @param loop      Whether the sound loops
+ *
+ * @return the identifier of a newly added spatial emitter.
+ */
+Uint32 AudioEngine::addEmitter(const std::shared_ptr<Sound>& sound, const Vec2& position,
+                               float gain, bool loop) {
+    CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
+    Emitter emitter;
+    emitter.id  = _nextEmitter++;
+    emitter.key = "__spatial_"+std::to_string(emitter.id)+"__";
+    emitter.sound = sound;
+    emitter.position = position;
+    emitter.gain = gain;
+    emitter.occlusion = 0;
+    emitter.level = 0;
+    emitter.pan   = 0;
+    emitter.loop  = loop;
+    emitter.voiced = false;
+    emitter.chosen = false;
+    emitter.done   = false;
+    _emitterids[emitter.id] = _emitters.size();
+    _emitters.push_back(emitter);
+    return emitter.id;
+}
+
+/**
+ * Removes the given spatial emitter, stopping its voice.
+ *
+ * If the identifier does not correspond to an emitter, this method does
+ * nothing.
+ *
+ * @param id    The emitter identifier
+ * @param fade  The number of seconds to fade out
+ */
+void AudioEngine::removeEmitter(Uint32 id, float fade) {
+    auto it = _emitterids.find(id);
+    if (it == _emitterids.end()) {
+        return;
+    }
+    
+    size_t pos = it->second;
+    if (_emitters[pos].voiced) {
+        clear(_emitters[pos].key,fade);
+    }
+    _emitterids.erase(it);
+    
+    // Swap with the last emitter
+    if (pos+1 < _emitters.size()) {
+        _emitters[pos] = std::move(_emitters.back());
+        _emitterids[_emitters[pos].id] = pos;
+    }
+    _emitters.pop_back();
+}
+
+/**
+ * Removes all spatial emitters, stopping their voices.
+ *
+ * @param fade  The number of seconds to fade out
+ */
+void AudioEngine::clearEmitters(float fade) {
+    for(auto it = _emitters.begin(); it != _emitters.end(); ++it) {
+        if (it->voiced) {
+            clear(it->key,fade);
+        }
+    }
+    _emitters.clear();
+    _emitterids.clear();
+    _audibles.clear();
+}
+
+/**
+ * Sets the position of the given spatial emitter.
+ *
+ * The change takes effect on the next call to {@link #updateSpatial}.
+ *
+ * @param id        The emitter identifier
+ * @param position  The emitter position
+ */
+void AudioEngine::setEmitterPosition(Uint32 id, const Vec2& position) {
+    auto it = _emitterids.find(id);
+    if (it != _emitterids.end()) {
+        _emitters[it->second].position = position;
+    }
+}
+
+/**
+ * Sets the gain (before attenuation) of the given spatial emitter.
+ *
+ * The change takes effect on the next call to {@link #updateSpatial}.
+ *
+ * @param id    The emitter identifier
+ * @param gain  The emitter gain
+ */
+void AudioEngine::setEmitterGain(Uint32 id, float gain) {
+    auto it = _emitterids.find(id);
+    if (it != _emitterids.end()) {
+        _emitters[it->second].gain = gain;
+    }
+}
+
+/**
+ * Sets the occlusion of the given spatial emitter.
+ *
+ * Occlusion is a value from 0 (no occlusion) to 1 (completely blocked).
+ * It is computed by the application, typically with a raycast from the
+ * listener. A completely occluded emitter is culled. The change takes
+ * effect on the next call to {@link #updateSpatial}.
+ *
+ * @param id        The emitter identifier
+ * @param occlusion The emitter occlusion
+ */
+void AudioEngine::setEmitterOcclusion(Uint32 id, float occlusion) {
+    CUAssertLog(occlusion >= 0 && occlusion <= 1, "Occlusion %f is out of range",occlusion);
+    auto it = _emitterids.find(id);
+    if (it != _emitterids.end()) {
+        _emitters[it->second].occlusion = occlusion;
+    }
+}
+
+/**
+ * Returns true if the given spatial emitter currently has a voice.
+ *
+ * @param id    The emitter identifier
+ *
+ * @return true if the given spatial emitter currently has a voice.
+ */
+bool AudioEngine::isEmitterAudible(Uint32 id) const {
+    auto it = _emitterids.find(id);
+    if (it != _emitterids.end()) {
+        return _emitters[it->second].voiced;
+    }
+    return false;
+}
+
+/**
+ * Sets the attenuation range of the spatial emitters.
+ *
+ * Emitters closer than the near distance play at full gain. Emitters
+ * farther than the far distance are culled. In between, the gain falls
+ * off linearly.
+ *
+ * @param inner The distance at which emitters begin to attenuate
+ * @param outer The distance at which emitters are silent
+ */
+void AudioEngine::setSpatialRange(float inner, float outer) {
+    CUAssertLog(inner > 0 && inner < outer, "The range [%f,%f] is invalid",inner,outer);
+    _nearDistance = inner;
+    _farDistance  = outer;
+}
+
+/**
+ * Sets the maximum number of spatial emitters with a voice.
+ *
+ * The value is clamped to the number of slots.
+ *
+ * @param voices    The maximum number of spatial emitters with a voice.
+ */
+void AudioEngine::setSpatialVoices(size_t voices) {
+    _spatialVoices = voices < _capacity ? voices : _capacity;
+}
+
+/**
+ * Updates the voices of the spatial emitters.
+ *
+ * This method computes the attenuation and pan of every emitter in a
+ * single pass. It then culls the emitters that are inaudible, and keeps
+ * only the loudest {@link #getSpatialVoices} emitters. Emitters that lost
+ * their place are faded out, and emitters that gained one are started.
+ * This should be called once an animation frame.
+ */
+void AudioEngine::updateSpatial() {
+    CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
+
+    // Attenuate everything in one pass
+    float inner = _nearDistance;
+    float outer = _farDistance;
+    float range = outer-inner;
+    _audibles.clear();
+    for(size_t ii = 0; ii < _emitters.size(); ii++) {
+        Emitter& emitter = _emitters[ii];
+        float dx = emitter.position.x-_listener.x;
+        float dy = emitter.position.y-_listener.y;
+        float distance = std::sqrt(dx*dx+dy*dy);
+        float atten = distance <= inner ? 1 : (distance >= outer ? 0 : (outer-distance)/range);
+        emitter.level = emitter.gain*(1-emitter.occlusion)*atten;
+        emitter.pan = std::max(-1.0f,std::min(1.0f,dx/std::max(distance,inner)));
+        emitter.chosen = false;
+        if (emitter.level > SPATIAL_EPSILON && !emitter.done) {
+            _audibles.push_back(ii);
+        }
+    }
+    
+    // Keep the loudest
+    if (_audibles.size() > _spatialVoices) {
+        std::partial_sort(_audibles.begin(), _audibles.begin()+_spatialVoices, _audibles.end(),
+                          [this](size_t a, size_t b) {
+                              return _emitters[a].level > _emitters[b].level;
+                          });
+        _audibles.resize(_spatialVoices);
+    }
+    for(auto it = _audibles.begin(); it != _audibles.end(); ++it) {
+        _emitters[*it].chosen = true;
+    }
+    
+    // Release voices first so that they can be reused
+    for(auto it = _emitters.begin(); it != _emitters.end(); ++it) {
+        if (it->voiced && (!it->chosen || !isActive(it->key))) {
+            if (isActive(it->key)) {
+                clear(it->key);
+            } else if (!it->loop) {
+                it->done = true;
+                it->chosen = false;
+            }
+            it->voiced = false;
+        }
+    }
+    
+    for(auto it = _audibles.begin(); it != _audibles.end(); ++it) {
+        Emitter& emitter = _emitters[*it];
+        if (!emitter.chosen) {
+            continue;
+        } else if (emitter.voiced) {
+            _actives.at(emitter.key)->setGain(emitter.level);
+            setPanFactor(emitter.key,emitter.pan);
+        } else if (isActive(emitter.key)) {
+            // Wait for the previous voice to finish fading out
+            continue;
+        } else if (play(emitter.key, emitter.sound, emitter.loop, emitter.level,
+                        false, SPATIAL_PRIORITY)) {
+            emitter.voiced = true;
+            setPanFactor(emitter.key,emitter.pan);
+        }
+    }
+}
+
 #pragma mark -
 #pragma mark Global Management
 /**
@@ -1195,7 +1622,6 @@ void AudioEngine::clearEffects(float fade) {
         it->second->fadeOut(fade);
     }
     _actives.clear();
-    _evicts.clear();
 }
 
 /**
@@ -1292,3 +1718,30 @@ void AudioEngine::resume()  {
     }
 }
 
+
+#pragma mark -
+#pragma mark Profiling
+/**
+ * Returns a snapshot of the callback timing for the audio device
+ *
+ * This is the profile of the {@link audio::AudioOutput} for this engine.
+ * It includes the load relative to the buffer period and the number of
+ * underruns. This method is lock-free, and is intended to be reported
+ * alongside the physics and netcode statistics.
+ *
+ * @return a snapshot of the callback timing for the audio device
+ */
+audio::AudioProfile AudioEngine::getProfile() const {
+    CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
+    return _output->getProfile();
+}
+
+/**
+ * Resets the callback timing for the audio device
+ *
+ * The timing is cleared at the next callback of the audio device.
+ */
+void AudioEngine::resetProfile() {
+    CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
+    _output->resetProfile();
+}
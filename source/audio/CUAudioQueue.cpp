@@ -151,6 +151,12 @@ std::shared_ptr<audio::AudioFader> AudioQueue::wrapInstance(const std::shared_pt
         sampler->attach(instance);
         panner->attach(sampler);
     }
+    
+    // Size the buffers now so the crossfade does not allocate on the audio thread
+    Uint32 size = _queue->getReadSize();
+    if (size && fader->getReadSize() != size) {
+        fader->setReadSize(size);
+    }
     return fader;
 }
 
@@ -332,6 +338,9 @@ void AudioQueue::play(const std::shared_ptr<audio::AudioNode>& graph, bool loop,
 const std::string AudioQueue::current() const {
     CUAssertLog(_cover != nullptr, "Attempt to use a disposed audio queue");
     std::shared_ptr<audio::AudioNode> source = accessInstance(_queue->getCurrent());
+    if (source == nullptr) {
+        return "";
+    }
     std::string id = source->getName();
     AudioPlayer* player = dynamic_cast<AudioPlayer*>(source.get());
     if (player && id == "__queue_playback__") {
@@ -512,6 +521,9 @@ void AudioQueue::setPanFactor(float pan) {
 float AudioQueue::getDuration() const {
     CUAssertLog(_cover != nullptr, "Attempt to use a disposed audio queue");
     std::shared_ptr<audio::AudioNode> source = accessInstance(_queue->getCurrent());
+    if (source == nullptr) {
+        return 0;
+    }
     AudioPlayer* player = dynamic_cast<AudioPlayer*>(source.get());
     if (player && player->getName() == "__queue_playback__") {
         return player->getSource()->getDuration();
@@ -39,6 +39,7 @@
 #include <cugl/audio/graph/CUAudioPlayer.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUFiletools.h>
+#include <cugl/io/CUAssetBundle.h>
 
 using namespace cugl;
 
@@ -70,12 +71,8 @@ _buffer(nullptr) {
  * @return true if the sound source was initialized successfully
  */
 bool AudioSample::init(const std::string file, bool stream) {
+    // The decoder reports missing files (which may be in a bundle)
     std::string path = filetool::normalize_path(file);
-    if (!filetool::file_exists(path)) {
-        CULogError("Cannot find file %s",path.c_str());
-        return false;
-    }
-    
     _file = file;
     _type = audio::guessType(file);
     _stream = stream;
@@ -97,6 +94,59 @@ bool AudioSample::init(const std::string file, bool stream) {
     return true;
 }
 
+/**
+ * Initializes a new compressed audio sample for the given file.
+ *
+ * A compressed sample reads the entire (encoded) file into memory, but
+ * does not decode it. Instead, it is streamed from memory, decoding each
+ * page as it is needed. Hence it uses much less memory than an in-memory
+ * sample, while never touching the file system during playback. Seeking
+ * is also much faster than with a streamed sample.
+ *
+ * @param file      The source file for the audio sample
+ *
+ * @return true if the sound source was initialized successfully
+ */
+bool AudioSample::initCompressed(const std::string file) {
+    std::string path = filetool::normalize_path(file);
+    SDL_RWops* stream = AssetBundle::openStream(path);
+    if (stream == NULL) {
+        CULogError("Cannot find file %s",path.c_str());
+        return false;
+    }
+
+    Sint64 size = SDL_RWsize(stream);
+    if (size <= 0) {
+        CULogError("Could not read '%s': %s\n", path.c_str(), SDL_GetError());
+        SDL_RWclose(stream);
+        return false;
+    }
+    
+    _bytes = std::make_shared<std::vector<Uint8>>((size_t)size);
+    size_t read = SDL_RWread(stream, _bytes->data(), 1, (size_t)size);
+    SDL_RWclose(stream);
+    if (read != (size_t)size) {
+        CULogError("Could not read '%s': %s\n", path.c_str(), SDL_GetError());
+        _bytes = nullptr;
+        return false;
+    }
+
+    _file = file;
+    _type = audio::guessType(file);
+    _stream = true;
+    std::shared_ptr<AudioDecoder> decoder = getDecoder();
+    if (decoder == nullptr) {
+        CULogError("Could not open '%s': %s\n", path.c_str(), SDL_GetError());
+        _bytes = nullptr;
+        return false;
+    }
+    
+    _channels = decoder->getChannels();
+    _frames = decoder->getLength();
+    _rate   = decoder->getSampleRate();
+    return true;
+}
+
 /**
  * Initializes an empty audio sample of the given size.
  *
@@ -129,11 +179,14 @@ bool AudioSample::init(Uint8 channels, Uint32 rate, Uint32 frames) {
  *
  *      "file":     The path to the source, relative to the asset directory
  *      "stream":   A boolean, indicating whether to stream the sample
+ *      "compressed": A boolean, indicating whether to stream from memory
  *      "volume":   A float, representing the volume
  *
  * All attributes are optional.  There are no required attributes. By default,
  * audio samples are not streamed, meaning they are fully loaded into memory.
- * This is recommended for sound effects, but not for music.
+ * This is recommended for sound effects, but not for music. A compressed
+ * sample keeps the encoded file in memory, and takes precedence over
+ * "stream".
  *
  * @param data      The JSON object specifying the audio sample
  *
@@ -142,7 +195,13 @@ bool AudioSample::init(Uint8 channels, Uint32 rate, Uint32 frames) {
 bool AudioSample::initWithData(const std::shared_ptr<JsonValue>& data) {
     std::string source = data->has("file") ? filetool::normalize_path(data->getString("file","")) : "";
     bool stream = data->getBool("stream",false);
-    if (init(source,stream)) {
+    bool success = false;
+    if (data->getBool("compressed",false)) {
+        success = initCompressed(source);
+    } else {
+        success = init(source,stream);
+    }
+    if (success) {
         _volume = data->getFloat("volume",1.0f);
         return true;
     }
@@ -164,6 +223,7 @@ void AudioSample::dispose() {
         SDL_free(_buffer);
         _buffer = nullptr;
     }
+    _bytes = nullptr;
     _type = AudioType::UNKNOWN;
 }
 
@@ -179,6 +239,9 @@ void AudioSample::dispose() {
  * @return a new decoder for this audio sample
  */
 std::shared_ptr<AudioDecoder> AudioSample::getDecoder() {
+    if (_bytes != nullptr) {
+        return AudioDecoder::allocWithData(_file,_bytes,_type);
+    }
     return AudioDecoder::alloc(_file,_type);
 }
 
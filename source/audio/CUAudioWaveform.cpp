@@ -45,9 +45,18 @@
 #include <cugl/util/CUStrings.h>
 #include <chrono>
 #include <algorithm>
+#include <mutex>
+#include <vector>
 
 using namespace cugl;
 
+/** The number of samples in a single cycle of a wavetable */
+#define TABLE_SIZE      4096
+/** The number of octave tables for each band-limited waveform */
+#define TABLE_OCTAVES   11
+/** The number of waveforms with wavetables (sine, triangle, square, sawtooth) */
+#define TABLE_SHAPES    4
+
 /**
  * Returns the value of a PolyBLEP curve at time t.
  *
@@ -76,6 +85,155 @@ double poly_blep(double t, double dt) {
     return 0.0;
 }
 
+#pragma mark -
+#pragma mark Wavetables
+/**
+ * The precomputed wavetables
+ *
+ * Each shape has TABLE_OCTAVES tables (except the sine wave, which has one).
+ * Octave k has the first 2^k harmonics of the shape. Each table has one more
+ * sample than TABLE_SIZE, repeating the first, so that lookups can interpolate
+ * without wrapping.
+ */
+static std::vector<float> wave_tables[TABLE_SHAPES];
+
+/** Guard to ensure the wavetables are only built once */
+static std::once_flag wave_built;
+
+/**
+ * Returns the wavetable index for the given waveform type.
+ *
+ * This function returns -1 if the type does not use a wavetable.
+ *
+ * @param type  The waveform type
+ *
+ * @return the wavetable index for the given waveform type.
+ */
+static int wave_shape(AudioWaveform::Type type) {
+    switch (type) {
+        case AudioWaveform::Type::SINE:
+            return 0;
+        case AudioWaveform::Type::POLY_TRIANG:
+            return 1;
+        case AudioWaveform::Type::POLY_SQUARE:
+            return 2;
+        case AudioWaveform::Type::POLY_TOOTH:
+            return 3;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * Builds the wavetables for all band-limited shapes.
+ *
+ * Each table is synthesized from its Fourier series with an inverse FFT.
+ * The shapes match their naive counterparts, so that the triangle is 1 at
+ * phase 0, the square is 1 in the first half period, and the sawtooth rises
+ * from -1 to 1.
+ */
+static void build_wavetables() {
+    std::vector<float> twiddle(2*TABLE_SIZE);
+    std::vector<float> spectrum(2*TABLE_SIZE);
+    dsp::DSPMath::fft_table(twiddle.data(),TABLE_SIZE);
+
+    for(int shape = 0; shape < TABLE_SHAPES; shape++) {
+        int octaves = shape == 0 ? 1 : TABLE_OCTAVES;
+        wave_tables[shape].resize(octaves*(TABLE_SIZE+1));
+        for(int oct = 0; oct < octaves; oct++) {
+            // A bin of (c,-s) produces c*cos + s*sin in the real part
+            std::fill(spectrum.begin(),spectrum.end(),0.0f);
+            Uint32 harmonics = 1 << oct;
+            for(Uint32 kk = 1; kk <= harmonics; kk++) {
+                switch (shape) {
+                    case 0:
+                        spectrum[2*kk+1] = -1.0f;
+                        break;
+                    case 1:
+                        if (kk % 2) {
+                            spectrum[2*kk] = (float)(8.0/(M_PI*M_PI*kk*kk));
+                        }
+                        break;
+                    case 2:
+                        if (kk % 2) {
+                            spectrum[2*kk+1] = (float)(-4.0/(M_PI*kk));
+                        }
+                        break;
+                    case 3:
+                        spectrum[2*kk+1] = (float)(2.0/(M_PI*kk));
+                        break;
+                }
+            }
+            dsp::DSPMath::ifft(spectrum.data(),twiddle.data(),TABLE_SIZE);
+
+            float* table = wave_tables[shape].data()+oct*(TABLE_SIZE+1);
+            for(Uint32 ii = 0; ii < TABLE_SIZE; ii++) {
+                table[ii] = spectrum[2*ii];
+            }
+            table[TABLE_SIZE] = table[0];
+        }
+    }
+}
+
+/**
+ * Returns the wavetable for the given shape and normalized frequency
+ *
+ * The table is the one with the most harmonics that lie below the Nyquist
+ * frequency. Hence the result is free of aliasing.
+ *
+ * @param shape The wavetable index
+ * @param ratio The frequency divided by the sample rate
+ *
+ * @return the wavetable for the given shape and normalized frequency
+ */
+static const float* wave_lookup(int shape, double ratio) {
+    int oct = 0;
+    if (shape > 0) {
+        double limit = 0.5/ratio;
+        while (oct+1 < TABLE_OCTAVES && (double)(1 << (oct+1)) <= limit) {
+            oct++;
+        }
+    }
+    return wave_tables[shape].data()+oct*(TABLE_SIZE+1);
+}
+
+/**
+ * Reads the given number of frames from a wavetable
+ *
+ * The table is read with linear interpolation, starting at the given phase
+ * (in the range [0,1)). The output is duplicated across all channels. If
+ * upper is true, the result is shifted to the range [0,1], except for a sine
+ * wave (shape 0), which is rectified.
+ *
+ * @param table     The wavetable
+ * @param shape     The wavetable index
+ * @param output    The buffer to store the results
+ * @param frames    The number of frames to generate
+ * @param channels  The number of channels
+ * @param phase     The initial phase
+ * @param ratio     The frequency divided by the sample rate
+ * @param upper     Whether to limit the waveform to the positive y-axis
+ */
+static void wave_read(const float* table, int shape, float* output, Uint32 frames,
+                      Uint8 channels, double phase, double ratio, bool upper) {
+    for(Uint32 jj = 0; jj < frames; jj++) {
+        double pos  = phase*TABLE_SIZE;
+        Uint32 indx = (Uint32)pos;
+        float  frac = (float)(pos-indx);
+        float value = table[indx]+frac*(table[indx+1]-table[indx]);
+        if (upper) {
+            value = shape == 0 ? std::fabs(value) : 0.5f*(value+1.0f);
+        }
+        for(int ii = 0; ii < channels; ii++) {
+            *output++ = value;
+        }
+        phase += ratio;
+        if (phase >= 1.0) {
+            phase -= std::floor(phase);
+        }
+    }
+}
+
 #pragma mark -
 #pragma mark AudioWaveNode Interface
 
@@ -448,6 +606,7 @@ void AudioWaveNode::dispose() {
  * @return the actual number of frames read
  */
 Uint32 AudioWaveNode::read(float* buffer, Uint32 frames) {
+    ReadTimer timer(this);
     if (_paused.load(std::memory_order_relaxed)) {
         std::memset(buffer,0,frames*sizeof(float)*_channels);
         return frames;
@@ -658,6 +817,7 @@ const float AudioWaveform::DEFAULT_FREQUENCY = 480.0f;
 AudioWaveform::AudioWaveform() : Sound(),
 _type(0),
 _upper(false),
+_tabled(true),
 _newfreq(false),
 _duration(-1),
 _frequency(-1) {
@@ -714,6 +874,7 @@ bool AudioWaveform::init(Uint8 channels, Uint32 rate, Type type, float frequency
     _newfreq = true;
     _rate = rate;
     _type = (int)type;
+    std::call_once(wave_built,build_wavetables);
     return type != AudioWaveform::Type::UNKNOWN;
 }
 
@@ -730,6 +891,7 @@ bool AudioWaveform::init(Uint8 channels, Uint32 rate, Type type, float frequency
  *      "rate":     An int, representing the sample rate
  *      "volume":   A float, representing the volume
  *      "duration"  A float, representing the duration in seconds
+ *      "wavetable" A bool, indicating whether to use the wavetables
  *
  * All attributes are optional.  There are no required attributes. The
  * recognized shapes are as follows: noise, sine, native triangle, naive
@@ -774,6 +936,7 @@ std::shared_ptr<AudioWaveform> AudioWaveform::allocWithData(const std::shared_pt
     std::shared_ptr<AudioWaveform> wave = AudioWaveform::alloc(channels,sampling,type,frequency);
     if (wave) {
         wave->setUpper(data->getBool("upper",false));
+        wave->setWavetable(data->getBool("wavetable",true));
         wave->setDuration(data->getFloat("duration",-1));
     }
     return wave;
@@ -789,6 +952,7 @@ void AudioWaveform::dispose() {
     Sound::dispose();
     _type.store(0);
     _upper.store(false);
+    _tabled.store(true);
     _newfreq.store(false);
     _frequency.store(-1);
     _duration.store(-1);
@@ -846,6 +1010,44 @@ void AudioWaveform::setUpper(bool upper) {
     _upper.store(upper,std::memory_order_relaxed);
 }
 
+/**
+ * Returns true if the band-limited waveforms use precomputed wavetables.
+ *
+ * The wavetables are synthesized from the Fourier series of each shape, with
+ * one table per octave. They are shared by all waveforms, and reading them
+ * is much cheaper than PolyBLEP synthesis. In addition, they have no aliasing
+ * and do not attenuate the higher harmonics. This applies to the sine wave
+ * and the triangle, square, and sawtooth waves. Naive waveforms, noise, and
+ * impulse trains are always computed directly.
+ *
+ * This value is true by default. If it is false, the waveforms are generated
+ * with PolyBLEP as described in {@link Type}.
+ *
+ * @return true if the band-limited waveforms use precomputed wavetables.
+ */
+bool AudioWaveform::isWavetable() const {
+    return _tabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Sets whether the band-limited waveforms use precomputed wavetables.
+ *
+ * The wavetables are synthesized from the Fourier series of each shape, with
+ * one table per octave. They are shared by all waveforms, and reading them
+ * is much cheaper than PolyBLEP synthesis. In addition, they have no aliasing
+ * and do not attenuate the higher harmonics. This applies to the sine wave
+ * and the triangle, square, and sawtooth waves. Naive waveforms, noise, and
+ * impulse trains are always computed directly.
+ *
+ * This value is true by default. If it is false, the waveforms are generated
+ * with PolyBLEP as described in {@link Type}.
+ *
+ * @param value Whether the band-limited waveforms use precomputed wavetables.
+ */
+void AudioWaveform::setWavetable(bool value) {
+    _tabled.store(value,std::memory_order_relaxed);
+}
+
 /**
  * Returns the fundamental frequency of this waveform.
  *
@@ -958,6 +1160,13 @@ Uint32 AudioWaveform::generate(float* buffer, Uint32 frames, Uint64 offset, floa
     
     Uint32 pos = (Uint32)offset;
     float* output = buffer;
+    int shape = wave_shape(type);
+    if (shape >= 0 && _tabled.load(std::memory_order_relaxed)) {
+        double phase = std::fmod(ratio*pos,1);
+        wave_read(wave_lookup(shape,ratio),shape,output,amt,_channels,phase,ratio,upper);
+        return amt;
+    }
+
     switch (type) {
         case Type::NOISE:
             while (tmp--) {
@@ -0,0 +1,650 @@
+//
+//  CUAudioConvolver.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a graph node for convolving an audio node with an
+//  impulse response. This is typically used for convolution reverb, where
+//  the impulse response is a recording of a real (or simulated) space. As
+//  impulse responses are often several seconds long, this node uses the
+//  partitioned FFT convolution in dsp::Convolver.
+//
+//  The convolver never takes a lock in the audio thread. Changing the input
+//  or the impulse response sends a command to the audio thread, which is
+//  applied at the start of the next read.
+//
+//  CUGL MIT License:
+//
+//     This software is provided 'as-is', without any express or implied
+//     warranty.  In no event will the authors be held liable for any damages
+//     arising from the use of this software.
+//
+//     Permission is granted to anyone to use this software for any purpose,
+//     including commercial applications, and to alter it and redistribute it
+//     freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not
+//     be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/audio/graph/CUAudioConvolver.h>
+#include <cugl/audio/CUAudioSample.h>
+#include <cugl/math/dsp/CUDSPMath.h>
+#include <cugl/util/CUDebug.h>
+#include <algorithm>
+#include <utility>
+#include <cstring>
+
+using namespace cugl;
+using namespace cugl::audio;
+
+/**
+ * Creates a degenerate audio convolver.
+ *
+ * The convolver has no channels, so read options will do nothing. The
+ * node must be initialized to be used.
+ */
+AudioConvolver::AudioConvolver() :
+_block(dsp::Convolver::DEFAULT_BLOCK),
+_wet(1.0f),
+_ringing(0),
+_residue(0),
+_buffer(nullptr) {
+    _classname = "AudioConvolver";
+}
+
+/**
+ * Initializes the node with default stereo settings
+ *
+ * The number of channels is two, for stereo output.  The sample rate is
+ * the modern standard of 48000 HZ.
+ *
+ * These values determine the buffer the structure for all {@link read}
+ * operations.  In addition, they also detemine whether this node can
+ * serve as an input to other nodes in the audio graph.
+ *
+ * @return true if initialization was successful
+ */
+bool AudioConvolver::init() {
+    if (AudioNode::init()) {
+        _input = nullptr;
+        _source = nullptr;
+        allocateBuffer();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Initializes the node with the given number of channels and sample rate
+ *
+ * These values determine the buffer the structure for all {@link read}
+ * operations.  In addition, they also detemine whether this node can
+ * serve as an input to other nodes in the audio graph.
+ *
+ * @param channels  The number of audio channels
+ * @param rate      The sample rate (frequency) in HZ
+ *
+ * @return true if initialization was successful
+ */
+bool AudioConvolver::init(Uint8 channels, Uint32 rate) {
+    if (AudioNode::init(channels,rate)) {
+        _input = nullptr;
+        _source = nullptr;
+        allocateBuffer();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Initializes a convolver for the given input node and impulse response.
+ *
+ * This node acquires the channels and sample rate of the input.  If
+ * input is nullptr, this method will fail.
+ *
+ * @param input     The audio node to convolve
+ * @param impulse   The impulse response
+ *
+ * @return true if initialization was successful
+ */
+bool AudioConvolver::init(const std::shared_ptr<AudioNode>& input, const std::vector<float>& impulse) {
+    if (input && AudioNode::init(input->getChannels(),input->getRate())) {
+        _input = input;
+        _source = input;
+        allocateBuffer();
+
+        // Nothing is reading yet, so there is no need for a command
+        _impulse = impulse;
+        if (!_impulse.empty()) {
+            _filter = std::make_shared<dsp::Convolver>(_channels,_impulse,_block);
+            _ringing = _impulse.size()-1;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Disposes any resources allocated for this convolver
+ *
+ * The state of the node is reset to that of an uninitialized constructor.
+ * Unlike the destructor, this method allows the node to be reinitialized.
+ */
+void AudioConvolver::dispose() {
+    if (_booted) {
+        AudioNode::dispose();
+        _commands.clear();
+        _input = nullptr;
+        _source = nullptr;
+        _filter = nullptr;
+        _impulse.clear();
+        _block = dsp::Convolver::DEFAULT_BLOCK;
+        _wet.store(1.0f,std::memory_order_relaxed);
+        _ringing = 0;
+        _residue.store(0,std::memory_order_relaxed);
+        if (_buffer != nullptr) {
+            free(_buffer);
+            _buffer = nullptr;
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Command Support
+/**
+ * Allocates the intermediate buffer for the dry signal
+ */
+void AudioConvolver::allocateBuffer() {
+    if (_buffer != nullptr) {
+        free(_buffer);
+    }
+    _buffer = (float*)malloc(_readsize*_channels*sizeof(float));
+}
+
+/**
+ * Applies the given command to the convolution state
+ *
+ * AUDIO THREAD ONLY: The convolution state belongs to the audio thread.
+ *
+ * @param command   The command to apply
+ */
+void AudioConvolver::applyCommand(Command& command) {
+    switch (command.type) {
+        case Command::Type::ATTACH:
+            std::swap(_source,command.node);
+            break;
+        case Command::Type::KERNEL:
+            std::swap(_filter,command.filter);
+            _ringing = _filter ? _filter->getKernel().size()-1 : 0;
+            _residue.store(0,std::memory_order_relaxed);
+            break;
+        case Command::Type::CLEAR:
+            if (_filter) {
+                _filter->clear();
+            }
+            _residue.store(0,std::memory_order_relaxed);
+            break;
+    }
+}
+
+/**
+ * Sends the given command to the audio thread.
+ *
+ * If this method is called by the audio thread itself, the command is
+ * applied immediately instead.
+ *
+ * @param command   The command to send
+ */
+void AudioConvolver::send(Command&& command) {
+    if (isAudioThread()) {
+        applyCommand(command);
+    } else {
+        _commands.push(std::move(command));
+    }
+}
+
+#pragma mark -
+#pragma mark Convolution Attributes
+/**
+ * Attaches an audio node to this convolver.
+ *
+ * This method will fail if the channels of the audio node do not agree
+ * with this convolver.
+ *
+ * The change takes effect at the start of the next read in the audio thread.
+ *
+ * @param node  The audio node to convolve
+ *
+ * @return true if the attachment was successful
+ */
+bool AudioConvolver::attach(const std::shared_ptr<AudioNode>& node) {
+    if (!_booted) {
+        CUAssertLog(_booted, "Cannot attach to an uninitialized audio node");
+        return false;
+    } else if (node == nullptr) {
+        detach();
+        return true;
+    } else if (node->getChannels() != _channels) {
+        CUAssertLog(false,"Input node has wrong number of channels: %d", node->getChannels());
+        return false;
+    } else if (node->getRate() != _sampling) {
+        CUAssertLog(false,"Input node has wrong sample rate: %d", node->getRate());
+        return false;
+    }
+
+    // Reset the read size if necessary
+    if (node->getReadSize() != _readsize) {
+        node->setReadSize(_readsize);
+    }
+
+    _input = node;
+    send(Command(node));
+    return true;
+}
+
+/**
+ * Detaches an audio node from this convolver.
+ *
+ * If the method succeeds, it returns the audio node that was removed.
+ *
+ * The change takes effect at the start of the next read in the audio thread.
+ *
+ * @return  The audio node to detach (or null if failed)
+ */
+std::shared_ptr<AudioNode> AudioConvolver::detach() {
+    if (!_booted) {
+        CUAssertLog(_booted, "Cannot detach from an uninitialized audio node");
+        return nullptr;
+    }
+
+    std::shared_ptr<AudioNode> result = _input;
+    _input = nullptr;
+    send(Command(std::shared_ptr<AudioNode>()));
+    return result;
+}
+
+/**
+ * Sets the impulse response of this convolver.
+ *
+ * The impulse response is transformed in this thread, which can take some
+ * time for long responses. The change takes effect at the start of the
+ * next read in the audio thread, and clears any reverb tail.
+ *
+ * @param impulse   The impulse response
+ */
+void AudioConvolver::setImpulse(const std::vector<float>& impulse) {
+    std::shared_ptr<dsp::Convolver> filter;
+    if (!impulse.empty()) {
+        filter = std::make_shared<dsp::Convolver>(_channels,impulse,_block);
+    }
+    _impulse = impulse;
+    send(Command(filter));
+}
+
+/**
+ * Sets the impulse response of this convolver to the given audio sample.
+ *
+ * The sample must be in memory (e.g. not streamed). If the sample has
+ * more than one channel, the channels are averaged together. The sample
+ * should have the same sample rate as this node. This method returns
+ * false if the impulse response could not be extracted.
+ *
+ * The impulse response is transformed in this thread, which can take some
+ * time for long responses. The change takes effect at the start of the
+ * next read in the audio thread, and clears any reverb tail.
+ *
+ * @param sample    The audio sample with the impulse response
+ *
+ * @return true if the impulse response was set
+ */
+bool AudioConvolver::setImpulse(const std::shared_ptr<AudioSample>& sample) {
+    if (sample == nullptr || sample->isStreamed() || sample->getBuffer() == nullptr) {
+        CUAssertLog(false, "The impulse response must be an in-memory sample");
+        return false;
+    } else if (sample->getRate() != _sampling) {
+        CUWarn("Impulse response has sample rate %d, not %d", sample->getRate(), _sampling);
+    }
+
+    const float* data = sample->getBuffer();
+    size_t frames = (size_t)sample->getLength();
+    size_t chans  = sample->getChannels();
+    std::vector<float> impulse(frames,0.0f);
+    for(size_t ii = 0; ii < frames; ii++) {
+        float total = 0;
+        for(size_t jj = 0; jj < chans; jj++) {
+            total += data[ii*chans+jj];
+        }
+        impulse[ii] = total/chans;
+    }
+    setImpulse(impulse);
+    return true;
+}
+
+/**
+ * Sets the partition size of the convolution in frames
+ *
+ * Smaller partitions mean less work per block, but more work per frame.
+ * The value will be rounded up to a power of two. Changing this value
+ * transforms the impulse response again and clears any reverb tail.
+ *
+ * @param block The partition size of the convolution in frames
+ */
+void AudioConvolver::setBlockSize(size_t block) {
+    _block = block;
+    if (!_impulse.empty()) {
+        std::vector<float> impulse(_impulse);
+        setImpulse(impulse);
+    }
+}
+
+/**
+ * Sets the proportion of the convolved signal in the output
+ *
+ * A value of 1 is only the convolved (wet) signal, while a value of 0
+ * is only the original (dry) signal. By default this value is 1.
+ *
+ * @param wet   The proportion of the convolved signal in the output
+ */
+void AudioConvolver::setWet(float wet) {
+    _wet.store(std::max(0.0f,std::min(wet,1.0f)),std::memory_order_relaxed);
+}
+
+/**
+ * Clears the convolution state, cutting off any reverb tail.
+ *
+ * The change takes effect at the start of the next read in the audio thread.
+ */
+void AudioConvolver::clear() {
+    send(Command(Command::Type::CLEAR));
+}
+
+#pragma mark -
+#pragma mark Overriden Methods
+/**
+ * Sets the typical read size of this node.
+ *
+ * Some audio nodes need an internal buffer for operations like mixing or
+ * resampling. In that case, it helps to know the requested {@link read}
+ * size ahead of time. The capacity is the minimal required read amount
+ * of the {@link AudioEngine} and corresponds to {@link AudioEngine#getReadSize}.
+ *
+ * It is not actually necessary to set this size. However for nodes with
+ * internal buffer, setting this value can optimize performance.
+ *
+ * This method is not synchronized because it is assumed that this value
+ * will **never** change while the audio engine in running. The average
+ * user should never call this method explicitly. You should always call
+ * {@link AudioEngine#setReadSize} instead.
+ *
+ * @param size  The typical read size of this node.
+ */
+void AudioConvolver::setReadSize(Uint32 size) {
+    if (_readsize != size) {
+        _readsize = size;
+        allocateBuffer();
+    }
+    std::shared_ptr<AudioNode> node = getSource();
+    if (node != nullptr) {
+        node->setReadSize(size);
+    }
+}
+
+/**
+ * Reads up to the specified number of frames into the given buffer
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ * The only exception is when the user needs to create a custom subclass
+ * of this AudioNode.
+ *
+ * The buffer should have enough room to store frames * channels elements.
+ * The channels are interleaved into the output buffer.
+ *
+ * This method will always forward the read position after reading. Reading
+ * again may return different data.
+ *
+ * @param buffer    The read buffer to store the results
+ * @param frames    The maximum number of frames to read
+ *
+ * @return the actual number of frames read
+ */
+Uint32 AudioConvolver::read(float* buffer, Uint32 frames) {
+    ReadTimer timer(this);
+    _commands.apply([this](Command& command) {
+        applyCommand(command);
+    });
+
+    if (_source == nullptr || _paused.load(std::memory_order_relaxed)) {
+        std::memset(buffer,0,frames*_channels*sizeof(float));
+        return frames;
+    }
+
+    // Keep ringing with silent input once the source has finished
+    Uint32 amt = _source->completed() ? 0 : _source->read(buffer,frames);
+    Uint64 ring = amt > 0 ? _ringing : _residue.load(std::memory_order_relaxed);
+    if (amt < frames && ring > 0) {
+        Uint32 extra = (Uint32)std::min((Uint64)(frames-amt),ring);
+        std::memset(buffer+amt*_channels,0,extra*_channels*sizeof(float));
+        amt  += extra;
+        ring -= extra;
+    }
+    _residue.store(ring,std::memory_order_release);
+
+    float gain = _ndgain.load(std::memory_order_relaxed);
+    if (_filter == nullptr) {
+        if (gain != 1) {
+            dsp::DSPMath::scale(buffer,gain,buffer,amt*_channels);
+        }
+        return amt;
+    }
+
+    float wet = _wet.load(std::memory_order_relaxed);
+    Uint32 done = 0;
+    while (done < amt) {
+        Uint32 chunk = std::min(amt-done,_readsize);
+        float* output = buffer+done*_channels;
+        if (wet < 1) {
+            std::memcpy(_buffer,output,chunk*_channels*sizeof(float));
+        }
+        _filter->calculate(gain*wet,output,output,chunk);
+        if (wet < 1) {
+            dsp::DSPMath::scale_add(_buffer,output,gain*(1-wet),output,chunk*_channels);
+        }
+        done += chunk;
+    }
+    return amt;
+}
+
+/**
+ * Returns true if this audio node has no more data.
+ *
+ * A completed audio node is one that will return 0 (no frames read) on
+ * subsequent threads read. A convolver is not complete until its reverb
+ * tail has finished.
+ *
+ * @return true if this audio node has no more data.
+ */
+bool AudioConvolver::completed() {
+    const std::shared_ptr<AudioNode>& input = getSource();
+    if (input == nullptr) {
+        return true;
+    }
+    return input->completed() && _residue.load(std::memory_order_acquire) == 0;
+}
+
+/**
+ * Marks the current read position in the audio steam.
+ *
+ * This method is used by {@link reset()} to determine where to restore
+ * the read position.
+ *
+ * @return true if the read position was marked.
+ */
+bool AudioConvolver::mark() {
+    const std::shared_ptr<AudioNode>& input = getSource();
+    if (input) {
+        return input->mark();
+    }
+    return false;
+}
+
+/**
+ * Clears the current marked position.
+ *
+ * Clearing the mark in a player is equivelent to setting the mark at
+ * the beginning of the audio asset.  Future calls to {@link reset()}
+ * will return to the start of the audio stream.
+ *
+ * @return true if the read position was cleared.
+ */
+bool AudioConvolver::unmark() {
+    const std::shared_ptr<AudioNode>& input = getSource();
+    if (input) {
+        return input->unmark();
+    }
+    return false;
+}
+
+/**
+ * Resets the read position to the marked position of the audio stream.
+ *
+ * If no mark is set, this will reset to the player to the beginning of
+ * the audio sample.
+ *
+ * @return true if the read position was moved.
+ */
+bool AudioConvolver::reset() {
+    const std::shared_ptr<AudioNode>& input = getSource();
+    if (input) {
+        return input->reset();
+    }
+    return false;
+}
+
+/**
+ * Advances the stream by the given number of frames.
+ *
+ * This method only advances the read position, it does not actually
+ * read data into a buffer.
+ *
+ * @param frames    The number of frames to advace
+ *
+ * @return the actual number of frames advanced; -1 if not supported
+ */
+Sint64 AudioConvolver::advance(Uint32 frames) {
+    const std::shared_ptr<AudioNode>& input = getSource();
+    if (input) {
+        return input->advance(frames);
+    }
+    return -1;
+}
+
+/**
+ * Returns the current frame position of this audio node
+ *
+ * The value returned will always be the absolute frame position regardless
+ * of the presence of any marks.
+ *
+ * @return the current frame position of this audio node.
+ */
+Sint64 AudioConvolver::getPosition() const {
+    const std::shared_ptr<AudioNode>& input = getSource();
+    if (input) {
+        return input->getPosition();
+    }
+    return -1;
+}
+
+/**
+ * Sets the current frame position of this audio node.
+ *
+ * The value set will always be the absolute frame position regardless
+ * of the presence of any marks.
+ *
+ * @param position  the current frame position of this audio node.
+ *
+ * @return the new frame position of this audio node.
+ */
+Sint64 AudioConvolver::setPosition(Uint32 position) {
+    const std::shared_ptr<AudioNode>& input = getSource();
+    if (input) {
+        return input->setPosition(position);
+    }
+    return -1;
+}
+
+/**
+ * Returns the elapsed time in seconds.
+ *
+ * The value returned is always measured from the start of the steam,
+ * regardless of the presence of any marks.
+ *
+ * @return the elapsed time in seconds.
+ */
+double AudioConvolver::getElapsed() const {
+    const std::shared_ptr<AudioNode>& input = getSource();
+    if (input) {
+        return input->getElapsed();
+    }
+    return -1;
+}
+
+/**
+ * Sets the read position to the elapsed time in seconds.
+ *
+ * The value returned is always measured from the start of the steam,
+ * regardless of the presence of any marks.
+ *
+ * @param time  The elapsed time in seconds.
+ *
+ * @return the new elapsed time in seconds.
+ */
+double AudioConvolver::setElapsed(double time) {
+    const std::shared_ptr<AudioNode>& input = getSource();
+    if (input) {
+        return input->setElapsed(time);
+    }
+    return -1;
+}
+
+/**
+ * Returns the remaining time in seconds.
+ *
+ * The remaining time is duration from the current read position to the
+ * end of the input. It does not include the reverb tail.
+ *
+ * @return the remaining time in seconds.
+ */
+double AudioConvolver::getRemaining() const {
+    const std::shared_ptr<AudioNode>& input = getSource();
+    if (input) {
+        return input->getRemaining();
+    }
+    return -1;
+}
+
+/**
+ * Sets the remaining time in seconds.
+ *
+ * This method will move the read position so that the distance between
+ * it and the end of the same is the given number of seconds.
+ *
+ * @param time  The remaining time in seconds.
+ *
+ * @return the new remaining time in seconds.
+ */
+double AudioConvolver::setRemaining(double time) {
+    const std::shared_ptr<AudioNode>& input = getSource();
+    if (input) {
+        return input->setRemaining(time);
+    }
+    return -1;
+}
@@ -39,10 +39,27 @@
 #include <cugl/math/dsp/CUDSPMath.h>
 #include <cugl/util/CUDebug.h>
 #include <algorithm>
-#include <thread>
+#include <utility>
 
 using namespace cugl::audio;
 
+/** The status flag for an active fade-in */
+#define FADE_IN_FLAG    0x01
+/** The status flag for an active fade-out */
+#define FADE_OUT_FLAG   0x02
+/** The status flag for a fade-out that persists on a reset */
+#define FADE_KEEP_FLAG  0x04
+/** The status flag for an active fade-pause */
+#define FADE_DIP_FLAG   0x08
+/** The status flag for the second half of a fade-pause */
+#define FADE_HALF_FLAG  0x10
+/** The status flag for a completed fade-out */
+#define FADE_DONE_FLAG  0x20
+/** All of the status flags */
+#define FADE_ALL_FLAGS  0x3F
+/** The status increment for each change outside of a read */
+#define STATUS_CHANGE   0x40
+
 /**
  * Creates a degenerate audio fader.
  *
@@ -59,7 +76,9 @@ _dipmark(-1),
 _dipstop(0),
 _outdone(false),
 _outkeep(false),
-_diphalf(false) {
+_diphalf(false),
+_dipstart(false),
+_status(0) {
     _classname = "AudioFader";
 }
 
@@ -78,6 +97,7 @@ _diphalf(false) {
 bool AudioFader::init() {
     if (AudioNode::init()) {
         _input = nullptr;
+        _source = nullptr;
         return true;
     }
     return false;
@@ -98,6 +118,7 @@ bool AudioFader::init() {
 bool AudioFader::init(Uint8 channels, Uint32 rate) {
     if (AudioNode::init(channels,rate)) {
         _input = nullptr;
+        _source = nullptr;
         return true;
     }
     return false;
@@ -117,6 +138,7 @@ bool AudioFader::init(Uint8 channels, Uint32 rate) {
 bool AudioFader::init(const std::shared_ptr<AudioNode>& input) {
     if (input && AudioNode::init(input->getChannels(),input->getRate())) {
         _input = input;
+        _source = input;
         return true;
     }
     return false;
@@ -132,6 +154,10 @@ bool AudioFader::init(const std::shared_ptr<AudioNode>& input) {
 void AudioFader::dispose() {
     if (_booted) {
         AudioNode::dispose();
+        _commands.clear();
+        _input = nullptr;
+        _source = nullptr;
+        _status.store(0,std::memory_order_relaxed);
         _fadein = 0;
         _inmark = -1;
         _fadeout = 0;
@@ -141,9 +167,145 @@ void AudioFader::dispose() {
         _dipmark = -1;
         _dipstop = 0;
         _diphalf = false;
+        _dipstart = false;
+    }
+}
+
+#pragma mark -
+#pragma mark Command Support
+/**
+ * Returns the status flags for the current fade state
+ *
+ * AUDIO THREAD ONLY: The fade state belongs to the audio thread.
+ *
+ * @return the status flags for the current fade state
+ */
+Uint32 AudioFader::getFlags() const {
+    Uint32 flags = 0;
+    if (_inmark >= 0) {
+        flags |= FADE_IN_FLAG;
+    }
+    if (_outmark >= 0) {
+        flags |= FADE_OUT_FLAG;
+    }
+    if (_outkeep) {
+        flags |= FADE_KEEP_FLAG;
+    }
+    if (_outdone) {
+        flags |= FADE_DONE_FLAG;
+    }
+    if (_dipmark >= 0) {
+        flags |= FADE_DIP_FLAG;
+    }
+    if (_diphalf) {
+        flags |= FADE_HALF_FLAG;
+    }
+    return flags;
+}
+
+/**
+ * Applies the given command to the fade state
+ *
+ * AUDIO THREAD ONLY: The fade state belongs to the audio thread.
+ *
+ * @param command   The command to apply
+ */
+void AudioFader::applyCommand(Command& command) {
+    switch (command.type) {
+        case Command::Type::ATTACH:
+            std::swap(_source,command.node);
+            break;
+        case Command::Type::FADE_IN:
+            _inmark = command.first;
+            _fadein = 0;
+            break;
+        case Command::Type::FADE_OUT:
+            _outmark = command.first;
+            _fadeout = 0;
+            _outkeep = command.wrap;
+            _outdone = false;
+            break;
+        case Command::Type::FADE_DIP:
+            // Do not pause twice
+            if (_dipmark < 0) {
+                _dipmark = command.first;
+                _dipstop = command.second;
+                _fadedip = 0;
+                _diphalf = false;
+            }
+            break;
+        case Command::Type::RESUME:
+            if (_dipmark >= 0 && !_diphalf) {
+                _dipmark = -1;
+                _fadedip = 0;
+                _dipstart = false;
+            }
+            break;
+        case Command::Type::RESET:
+            _inmark = -1;
+            _fadein = 0;
+            if (_outmark >= 0 && !_outkeep) {
+                _outmark = -1;
+                _fadeout = 0;
+            }
+            _outdone = false;
+            _dipmark = -1;
+            _fadedip = 0;
+            _dipstop = 0;
+            _diphalf = false;
+            break;
+        case Command::Type::CANCEL:
+            _inmark = -1;
+            _fadein = 0;
+            _outmark = -1;
+            _fadeout = 0;
+            _outdone = false;
+            _outkeep = false;
+            _dipmark = -1;
+            _fadedip = 0;
+            _dipstop = 0;
+            _diphalf = false;
+            break;
     }
 }
 
+/**
+ * Sends the given command to the audio thread.
+ *
+ * The status flags are updated immediately, clearing the flags in clear
+ * and then setting the flags in set. If this method is called by the
+ * audio thread itself, the command is applied immediately instead.
+ *
+ * @param command   The command to send
+ * @param clear     The status flags to clear
+ * @param set       The status flags to set
+ */
+void AudioFader::send(Command&& command, Uint32 clear, Uint32 set) {
+    if (isAudioThread()) {
+        applyCommand(command);
+        clear = FADE_ALL_FLAGS;
+        set = getFlags();
+    } else {
+        _commands.push(std::move(command));
+    }
+    
+    Uint32 state = _status.load(std::memory_order_relaxed);
+    Uint32 next;
+    do {
+        next = ((state+STATUS_CHANGE) & ~clear) | set;
+    } while (!_status.compare_exchange_weak(state,next,std::memory_order_release,
+                                            std::memory_order_relaxed));
+}
+
+/**
+ * Cancels all active fades.
+ *
+ * This is used by any method that moves the read position.
+ */
+void AudioFader::cancelFades() {
+    send(Command(Command::Type::CANCEL),FADE_ALL_FLAGS,0);
+}
+
 #pragma mark -
 #pragma mark Fade In/Out Support
 /**
@@ -152,6 +314,8 @@ void AudioFader::dispose() {
  * This method will fail if the channels of the audio node do not agree
  * with this fader.
  *
+ * The change takes effect at the start of the next read in the audio thread.
+ *
  * @param node  The audio node to fade
  *
  * @return true if the attachment was successful
@@ -176,7 +340,8 @@ bool AudioFader::attach(const std::shared_ptr<AudioNode>& node) {
         node->setReadSize(_readsize);
     }
     
-    std::atomic_exchange_explicit(&_input,node,std::memory_order_relaxed);
+    _input = node;
+    send(Command(node),0,0);
     return true;
 }
 
@@ -185,6 +350,8 @@ bool AudioFader::attach(const std::shared_ptr<AudioNode>& node) {
  *
  * If the method succeeds, it returns the audio node that was removed.
  *
+ * The change takes effect at the start of the next read in the audio thread.
+ *
  * @return  The audio node to detach (or null if failed)
  */
 std::shared_ptr<AudioNode> AudioFader::detach() {
@@ -193,7 +360,9 @@ std::shared_ptr<AudioNode> AudioFader::detach() {
         return nullptr;
     }
     
-    std::shared_ptr<AudioNode> result = std::atomic_exchange_explicit(&_input,{},std::memory_order_relaxed);
+    std::shared_ptr<AudioNode> result = _input;
+    _input = nullptr;
+    send(Command(std::shared_ptr<AudioNode>()),0,0);
     return result;
 }
 
@@ -211,14 +380,8 @@ std::shared_ptr<AudioNode> AudioFader::detach() {
  * @param duration  The fade-in time in seconds
  */
 void AudioFader::fadeIn(double duration) {
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (duration <= 0) {
-        _inmark = -1;
-        _fadein = 0;
-    } else {
-        _inmark = (Sint64)(duration*getRate());
-        _fadein = 0;
-    }
+    Sint64 mark = duration <= 0 ? -1 : (Sint64)(duration*getRate());
+    send(Command(Command::Type::FADE_IN,mark),FADE_IN_FLAG,mark >= 0 ? FADE_IN_FLAG : 0);
 }
 
 /**
@@ -227,8 +390,7 @@ void AudioFader::fadeIn(double duration) {
  * @return true if this node is in an active fade-in.
  */
 bool AudioFader::isFadeIn() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _inmark >= 0;
+    return _status.load(std::memory_order_acquire) & FADE_IN_FLAG;
 }
 
 /**
@@ -251,16 +413,10 @@ bool AudioFader::isFadeIn() {
  * @param wrap      Whether to support a fade-out after reset
  */
 void AudioFader::fadeOut(double duration, bool wrap) {
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (duration <= 0) {
-        _outmark = -1;
-        _fadeout = 0;
-    } else {
-        _outmark = (Sint64)(duration*getRate());
-        _fadeout = 0;
-    }
-    _outkeep = wrap;
-    _outdone = false;
+    Sint64 mark = duration <= 0 ? -1 : (Sint64)(duration*getRate());
+    Uint32 flags = (mark >= 0 ? FADE_OUT_FLAG : 0) | (wrap ? FADE_KEEP_FLAG : 0);
+    send(Command(Command::Type::FADE_OUT,mark,0,wrap),
+         FADE_OUT_FLAG | FADE_KEEP_FLAG | FADE_DONE_FLAG, flags);
 }
 
 /**
@@ -269,8 +425,7 @@ void AudioFader::fadeOut(double duration, bool wrap) {
  * @return true if this node is in an active fade-out.
  */
 bool AudioFader::isFadeOut() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _outmark >= 0;
+    return _status.load(std::memory_order_acquire) & FADE_OUT_FLAG;
 }
 
 /**
@@ -315,24 +470,20 @@ void AudioFader::fadePause(double duration) {
  * @param fadein   The fade-in time in seconds
  */
 void AudioFader::fadePause(double fadeout, double fadein) {
-    std::lock_guard<std::mutex> lock(_mutex);
-
     // Do not pause twice
-    if (_dipmark >= 0) {
+    if (_status.load(std::memory_order_acquire) & FADE_DIP_FLAG) {
         return;
     }
     
     // Now pause
-    if (fadein < 0 || fadeout < 0) {
-        _dipmark = -1;
-        _fadedip = 0;
-        _dipstop = 0;
-    } else {
-        _dipmark = (Sint64)(fadeout*getRate());
-        _dipstop = (Uint64)(fadein*getRate());
-        _fadedip = 0;
+    Sint64 mark = -1;
+    Uint64 stop = 0;
+    if (fadein >= 0 && fadeout >= 0) {
+        mark = (Sint64)(fadeout*getRate());
+        stop = (Uint64)(fadein*getRate());
     }
-    _diphalf = false;
+    send(Command(Command::Type::FADE_DIP,mark,stop),
+         FADE_DIP_FLAG | FADE_HALF_FLAG, mark >= 0 ? FADE_DIP_FLAG : 0);
 }
 
 /**
@@ -344,8 +495,7 @@ void AudioFader::fadePause(double fadeout, double fadein) {
  * @return true if this node is in an active fade-pause.
  */
 bool AudioFader::isFadePause() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _dipmark >= 0;
+    return _status.load(std::memory_order_acquire) & FADE_DIP_FLAG;
 }
 
 /**
@@ -505,7 +655,7 @@ Uint32 AudioFader::doFadePause(float* buffer, Uint32 frames) {
  */
 void AudioFader::setReadSize(Uint32 size) {
     _readsize = size;
-    std::shared_ptr<AudioNode> node = _input;
+    std::shared_ptr<AudioNode> node = getSource();
     if (node != nullptr) {
         node->setReadSize(size);
     }
@@ -517,8 +667,9 @@ void AudioFader::setReadSize(Uint32 size) {
  * @return true if this node is currently paused
  */
 bool AudioFader::isPaused() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _paused.load(std::memory_order_relaxed) || (_dipmark >= 0 && !_diphalf);
+    Uint32 flags = _status.load(std::memory_order_acquire);
+    bool dipping = (flags & FADE_DIP_FLAG) && !(flags & FADE_HALF_FLAG);
+    return _paused.load(std::memory_order_relaxed) || dipping;
 }
 
 /**
@@ -530,8 +681,8 @@ bool AudioFader::isPaused() {
  * @return true if the node was successfully paused
  */
 bool AudioFader::pause() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (_dipmark < 0 || _diphalf) {
+    Uint32 flags = _status.load(std::memory_order_acquire);
+    if (!(flags & FADE_DIP_FLAG) || (flags & FADE_HALF_FLAG)) {
         return !_paused.exchange(true);
     }
     return false;
@@ -545,11 +696,9 @@ bool AudioFader::pause() {
  * @return true if the node was successfully resumed
  */
 bool AudioFader::resume() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (_dipmark >= 0 && !_diphalf) {
-        _dipmark = -1;
-        _fadedip = 0;
-        _dipstart = 0;
+    Uint32 flags = _status.load(std::memory_order_acquire);
+    if ((flags & FADE_DIP_FLAG) && !(flags & FADE_HALF_FLAG)) {
+        send(Command(Command::Type::RESUME),FADE_DIP_FLAG | FADE_HALF_FLAG,0);
         _paused.store(false,std::memory_order_relaxed);
         return true;
     }
@@ -575,25 +724,32 @@ bool AudioFader::resume() {
  * @return the actual number of frames read
  */
 Uint32 AudioFader::read(float* buffer, Uint32 frames) {
-    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
-    if (input == nullptr || _paused.load(std::memory_order_relaxed)) {
+    ReadTimer timer(this);
+    Uint32 state = _status.load(std::memory_order_acquire);
+    _commands.apply([this](Command& command) {
+        applyCommand(command);
+    });
+    
+    Uint32 amt = 0;
+    if (_source == nullptr || _paused.load(std::memory_order_relaxed)) {
         std::memset(buffer,0,frames*_channels*sizeof(float));
-        return frames;
-    } else {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (!_outdone) {
-            Uint32 amt = input->read(buffer, frames);
-            float gain = _ndgain.load(std::memory_order_relaxed);
-            if (gain != 1) {
-                dsp::DSPMath::scale(buffer,gain,buffer,amt*_channels);
-            }
-            amt = doFadeIn(buffer,amt);
-            amt = doFadeOut(buffer,amt);
-            amt = doFadePause(buffer,amt);
-            return amt;
+        amt = frames;
+    } else if (!_outdone) {
+        amt = _source->read(buffer, frames);
+        float gain = _ndgain.load(std::memory_order_relaxed);
+        if (gain != 1) {
+            dsp::DSPMath::scale(buffer,gain,buffer,amt*_channels);
         }
+        amt = doFadeIn(buffer,amt);
+        amt = doFadeOut(buffer,amt);
+        amt = doFadePause(buffer,amt);
     }
-    return 0;
+    
+    // Publish the fade state, unless it was changed during the read
+    Uint32 next = (state & ~FADE_ALL_FLAGS) | getFlags();
+    _status.compare_exchange_strong(state,next,std::memory_order_release,
+                                    std::memory_order_relaxed);
+    return amt;
 }
 
 /**
@@ -605,12 +761,8 @@ Uint32 AudioFader::read(float* buffer, Uint32 frames) {
  * @return true if this audio node has no more data.
  */
 bool AudioFader::completed() {
-    bool outdone = false;
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        outdone = _outdone;
-    }
-    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    bool outdone = _status.load(std::memory_order_acquire) & FADE_DONE_FLAG;
+    const std::shared_ptr<AudioNode>& input = getSource();
     return (input == nullptr || input->completed() || outdone);
 }
 
@@ -623,7 +775,7 @@ bool AudioFader::completed() {
  * @return true if the read position was marked.
  */
 bool AudioFader::mark() {
-    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    const std::shared_ptr<AudioNode>& input = getSource();
     if (input) {
         return input->mark();
     }
@@ -641,7 +793,7 @@ bool AudioFader::mark() {
  * @return true if the read position was cleared.
  */
 bool AudioFader::unmark() {
-    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    const std::shared_ptr<AudioNode>& input = getSource();
     if (input) {
         return input->unmark();
     }
@@ -657,27 +809,14 @@ bool AudioFader::unmark() {
  * @return true if the read position was moved.
  */
 bool AudioFader::reset() {
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_inmark >= 0) {
-            _inmark = -1;
-            _fadein = 0;
-        }
-        if (_outmark >= 0) {
-            if (!_outkeep) {
-                _outmark = -1;
-                _fadeout = 0;
-            }
-        }
-        _outdone = false;
-        if (_dipmark >= 0) {
-            _dipmark = -1;
-            _fadedip = 0;
-            _dipstop = 0;
-        }
-        _diphalf = false;
+    Uint32 flags = _status.load(std::memory_order_acquire);
+    Uint32 clear = FADE_IN_FLAG | FADE_DONE_FLAG | FADE_DIP_FLAG | FADE_HALF_FLAG;
+    if (!(flags & FADE_KEEP_FLAG)) {
+        clear |= FADE_OUT_FLAG;
     }
-    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    send(Command(Command::Type::RESET),clear,0);
+    
+    const std::shared_ptr<AudioNode>& input = getSource();
     if (input) {
         return input->reset();
     }
@@ -697,26 +836,8 @@ bool AudioFader::reset() {
  * @return the actual number of frames advanced; -1 if not supported
  */
 Sint64 AudioFader::advance(Uint32 frames) {
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_inmark >= 0) {
-            _inmark = -1;
-            _fadein = 0;
-        }
-        if (_outmark >= 0) {
-            _outmark = -1;
-            _fadeout = 0;
-        }
-        _outdone = false;
-        _outkeep = false;
-        if (_dipmark >= 0) {
-            _dipmark = -1;
-            _fadedip = 0;
-            _dipstop = 0;
-        }
-        _diphalf = false;
-    }
-    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    cancelFades();
+    const std::shared_ptr<AudioNode>& input = getSource();
     if (input) {
         return input->advance(frames);
     }
@@ -732,7 +853,7 @@ Sint64 AudioFader::advance(Uint32 frames) {
  * @return the current frame position of this audio node.
  */
 Sint64 AudioFader::getPosition() const {
-    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    const std::shared_ptr<AudioNode>& input = getSource();
     if (input) {
         return input->getPosition();
     }
@@ -752,26 +873,8 @@ Sint64 AudioFader::getPosition() const {
  * @return the new frame position of this audio node.
  */
 Sint64 AudioFader::setPosition(Uint32 position)  {
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_inmark >= 0) {
-            _inmark = -1;
-            _fadein = 0;
-        }
-        if (_outmark >= 0) {
-            _outmark = -1;
-            _fadeout = 0;
-        }
-        _outdone = false;
-        _outkeep = false;
-        if (_dipmark >= 0) {
-            _dipmark = -1;
-            _fadedip = 0;
-            _dipstop = 0;
-        }
-        _diphalf = false;
-    }
-    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    cancelFades();
+    const std::shared_ptr<AudioNode>& input = getSource();
     if (input) {
         return input->setPosition(position);
     }
@@ -787,7 +890,7 @@ Sint64 AudioFader::setPosition(Uint32 position)  {
  * @return the elapsed time in seconds.
  */
 double AudioFader::getElapsed() const {
-    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    const std::shared_ptr<AudioNode>& input = getSource();
     if (input) {
         return input->getElapsed();
     }
@@ -807,26 +910,8 @@ double AudioFader::getElapsed() const {
  * @return the new elapsed time in seconds.
  */
 double AudioFader::setElapsed(double time) {
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_inmark >= 0) {
-            _inmark = -1;
-            _fadein = 0;
-        }
-        if (_outmark >= 0) {
-            _outmark = -1;
-            _fadeout = 0;
-        }
-        _outdone = false;
-        _outkeep = false;
-        if (_dipmark >= 0) {
-            _dipmark = -1;
-            _fadedip = 0;
-            _dipstop = 0;
-        }
-        _diphalf = false;
-    }
-    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    cancelFades();
+    const std::shared_ptr<AudioNode>& input = getSource();
     if (input) {
         return input->setElapsed(time);
     }
@@ -842,7 +927,7 @@ double AudioFader::setElapsed(double time) {
  * @return the remaining time in seconds.
  */
 double AudioFader::getRemaining() const  {
-    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    const std::shared_ptr<AudioNode>& input = getSource();
     if (_outmark >= 0) {
         Sint64 temp =  std::max((Sint64)0,_outmark-(Sint64)_fadeout);
         return ((double)temp)/_sampling;
@@ -866,26 +951,8 @@ double AudioFader::getRemaining() const  {
  * @return the new remaining time in seconds.
  */
 double AudioFader::setRemaining(double time) {
-    {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_inmark >= 0) {
-            _inmark = -1;
-            _fadein = 0;
-        }
-        if (_outmark >= 0) {
-            _outmark = -1;
-            _fadeout = 0;
-        }
-        _outdone = false;
-        _outkeep = false;
-        if (_dipmark >= 0) {
-            _dipmark = -1;
-            _fadedip = 0;
-            _dipstop = 0;
-        }
-        _diphalf = false;
-    }
-    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    cancelFades();
+    const std::shared_ptr<AudioNode>& input = getSource();
     if (input) {
         return input->setRemaining(time);
     }
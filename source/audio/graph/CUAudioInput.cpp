@@ -49,6 +49,7 @@
 #include <cugl/audio/CUAudioSample.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUTimestamp.h>
+#include <cugl/util/CUProfiler.h>
 #include <algorithm>
 
 using namespace cugl::audio;
@@ -65,6 +66,7 @@ const static std::string DEFAULT_NAME("(DEFAULT DEVICE)");
  * This is the function that SDL uses to pass the recorded audio
  */
 static void audioCallback(void*  userdata, Uint8* stream, int len) {
+    CU_PROFILE_SCOPE("AudioInput::record");
     AudioInput* device = (AudioInput*)userdata;
     Uint32 count = (Uint32)(len/(device->getChannels()*sizeof(float)));
     float* output = (float*)stream;
@@ -96,8 +98,15 @@ _bufftail(0),
 _timeout(-1),
 _playpost(-1),
 _playmark(-1),
-_locked(false) {
+_locked(false),
+_capbuffer(nullptr),
+_capsize(0),
+_captaps(0),
+_captail(0) {
     _classname  = "AudioInput";
+    for(int ii = 0; ii < AUDIO_INPUT_TAPS; ii++) {
+        _capheads[ii] = 0;
+    }
 }
 
 /**
@@ -341,6 +350,16 @@ void AudioInput::dispose() {
             free(_buffer);
             _buffer = nullptr;
         }
+        if (_capbuffer != nullptr) {
+            free(_capbuffer);
+            _capbuffer = nullptr;
+        }
+        _capsize = 0;
+        _captaps = 0;
+        _captail = 0;
+        for(int ii = 0; ii < AUDIO_INPUT_TAPS; ii++) {
+            _capheads[ii] = 0;
+        }
     }
 }
 
@@ -651,6 +670,205 @@ std::shared_ptr<cugl::AudioSample> AudioInput::save() {
     return sample;
 }
 
+#pragma mark -
+#pragma mark Capture Stream
+/**
+ * Sets the size of the capture stream in frames.
+ *
+ * The capture stream is a copy of everything recorded by this node, which
+ * may be read by another thread with {@link capture()}. It is independent
+ * of playback, so an input node does not need to be part of an audio graph
+ * to capture. This is how audio is taken from a microphone without adding
+ * the latency of the graph, such as for voice chat.
+ *
+ * The stream is a lock-free ring buffer, which may be read by several
+ * consumers at once (see {@link openTap}). If the slowest consumer falls
+ * behind by more than this many frames, the new frames are dropped. A size
+ * of 0 disables the capture stream (the default) and closes all taps. Any
+ * other size opens the default tap (tap 0) read by {@link capture()}. As an
+ * unread tap holds back the stream, close the default tap if it is not used.
+ * This method must not be called while another thread is reading the capture
+ * stream.
+ *
+ * Changing this value will temporarily lock this input device.
+ *
+ * @param frames    The size of the capture stream in frames
+ */
+void AudioInput::setCaptureSize(Uint32 frames) {
+    float* buffer = nullptr;
+    if (frames > 0) {
+        buffer = (float*)malloc(frames*_channels*sizeof(float));
+        std::memset(buffer,0,frames*_channels*sizeof(float));
+    }
+    
+    SDL_LockAudioDevice(_device);
+    float* previous = _capbuffer;
+    _capbuffer = buffer;
+    _capsize = frames;
+    for(int ii = 0; ii < AUDIO_INPUT_TAPS; ii++) {
+        _capheads[ii].store(0,std::memory_order_relaxed);
+    }
+    _captail.store(0,std::memory_order_relaxed);
+    if (frames > 0) {
+        _captaps.fetch_or(1,std::memory_order_release);
+    } else {
+        _captaps.store(0,std::memory_order_release);
+    }
+    SDL_UnlockAudioDevice(_device);
+    
+    if (previous != nullptr) {
+        free(previous);
+    }
+}
+
+/**
+ * Opens a new tap of the capture stream, returning its index.
+ *
+ * A tap is an independent read cursor in the capture stream. Several
+ * consumers (such as a recorder, voice chat, and beat detection) may each
+ * open a tap and read the same frames, without copying the stream for each
+ * of them. Each tap starts at the newest frame in the stream.
+ *
+ * The capture stream only drops new frames when the slowest open tap falls
+ * behind by {@link getCaptureSize} frames. So a tap that is no longer read
+ * should be closed with {@link closeTap}.
+ *
+ * This method returns -1 if there is no capture stream, or if all
+ * {@link AUDIO_INPUT_TAPS} taps are in use. It is safe to call from any
+ * thread.
+ *
+ * @return the index of the new tap (or -1 on failure)
+ */
+Sint32 AudioInput::openTap() {
+    if (_capbuffer == nullptr) {
+        return -1;
+    }
+    
+    Uint32 taps = _captaps.load(std::memory_order_acquire);
+    for(Uint32 ii = 0; ii < AUDIO_INPUT_TAPS; ii++) {
+        Uint32 bit = 1 << ii;
+        while (!(taps & bit)) {
+            // The cursor must be set before the tap is visible to the audio thread
+            _capheads[ii].store(_captail.load(std::memory_order_acquire),std::memory_order_relaxed);
+            if (_captaps.compare_exchange_weak(taps,taps | bit,std::memory_order_acq_rel)) {
+                return (Sint32)ii;
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * Closes the given tap of the capture stream.
+ *
+ * A closed tap no longer holds back the capture stream. Its index may
+ * be returned by a later call to {@link openTap}.
+ *
+ * @param tap   The index of the tap to close
+ */
+void AudioInput::closeTap(Uint32 tap) {
+    CUAssertLog(tap < AUDIO_INPUT_TAPS, "Tap %d is out of range",tap);
+    _captaps.fetch_and(~(1 << tap),std::memory_order_release);
+}
+
+/**
+ * Returns true if the given tap of the capture stream is open.
+ *
+ * @param tap   The index of the tap
+ *
+ * @return true if the given tap of the capture stream is open.
+ */
+bool AudioInput::isTapOpen(Uint32 tap) const {
+    if (tap >= AUDIO_INPUT_TAPS || _capbuffer == nullptr) {
+        return false;
+    }
+    return _captaps.load(std::memory_order_acquire) & (1 << tap);
+}
+
+/**
+ * Reads up to the specified number of frames from the given tap.
+ *
+ * The buffer should have enough room to store frames * channels elements.
+ * The channels are interleaved into the buffer. This method never blocks,
+ * and returns 0 if the tap is not open. It is safe to call from any
+ * thread, but only one thread may consume each tap.
+ *
+ * @param tap       The index of the tap
+ * @param buffer    The buffer to store the captured frames
+ * @param frames    The maximum number of frames to read
+ *
+ * @return the actual number of frames read
+ */
+Uint32 AudioInput::capture(Uint32 tap, float* buffer, Uint32 frames) {
+    Uint32 amt = 0;
+    while (amt < frames) {
+        const float* data = nullptr;
+        Uint32 size = peekCapture(tap,&data,frames-amt);
+        if (size == 0) {
+            break;
+        }
+        std::memcpy(buffer+amt*_channels,data,size*_channels*sizeof(float));
+        advanceCapture(tap,size);
+        amt += size;
+    }
+    return amt;
+}
+
+/**
+ * Returns the frames available to the given tap without copying them.
+ *
+ * This method stores a pointer into the capture stream in data, and
+ * returns the number of frames (up to the given maximum) that may be
+ * read from that pointer. The channels are interleaved. As the capture
+ * stream is a ring buffer, this may be fewer frames than are available.
+ * Call this method again after {@link advanceCapture} to get the rest.
+ *
+ * The data remains valid until the tap is advanced. The capture stream
+ * will not overwrite it in the meantime. This method returns 0 if the
+ * tap is not open.
+ *
+ * @param tap       The index of the tap
+ * @param data      The pointer to store the start of the frames
+ * @param frames    The maximum number of frames to peek
+ *
+ * @return the number of frames that may be read from data
+ */
+Uint32 AudioInput::peekCapture(Uint32 tap, const float** data, Uint32 frames) const {
+    if (!isTapOpen(tap)) {
+        *data = nullptr;
+        return 0;
+    }
+    
+    Uint64 head = _capheads[tap].load(std::memory_order_relaxed);
+    Uint64 tail = _captail.load(std::memory_order_acquire);
+    Uint32 start = (Uint32)(head % _capsize);
+    Uint32 amt = (Uint32)std::min<Uint64>(tail-head,frames);
+    amt = std::min(amt,_capsize-start);
+    *data = _capbuffer+start*_channels;
+    return amt;
+}
+
+/**
+ * Advances the given tap past the specified number of frames.
+ *
+ * This method releases the frames returned by {@link peekCapture}, so
+ * that they may be overwritten by the capture stream. The tap will not
+ * advance past the newest frame in the stream.
+ *
+ * @param tap       The index of the tap
+ * @param frames    The number of frames to advance
+ */
+void AudioInput::advanceCapture(Uint32 tap, Uint32 frames) {
+    if (!isTapOpen(tap)) {
+        return;
+    }
+    
+    Uint64 head = _capheads[tap].load(std::memory_order_relaxed);
+    Uint64 tail = _captail.load(std::memory_order_acquire);
+    head += std::min<Uint64>(tail-head,frames);
+    _capheads[tap].store(head,std::memory_order_release);
+}
+
 #pragma mark -
 #pragma mark Audio Graph
 /**
@@ -704,6 +922,7 @@ bool AudioInput::completed() {
  * @return the actual number of frames read
  */
 Uint32 AudioInput::read(float* buffer, Uint32 frames) {
+    ReadTimer timer(this);
     Sint64 timeout = _timeout.load(std::memory_order_relaxed);
     if (_paused.load(std::memory_order_relaxed) || timeout == 0) {
         std::memset(buffer,0,frames*_channels*sizeof(float));
@@ -776,6 +995,25 @@ Uint32 AudioInput::read(float* buffer, Uint32 frames) {
  */
 Uint32 AudioInput::record(float* buffer, Uint32 frames) {
     if (_timeout.load(std::memory_order_relaxed) && _record.load(std::memory_order_relaxed)) {
+        // The capture stream is lock-free (new frames are dropped if it is full)
+        if (_capbuffer != nullptr) {
+            // Only the slowest open tap can hold back the stream
+            Uint32 taps = _captaps.load(std::memory_order_acquire);
+            Uint64 tail = _captail.load(std::memory_order_relaxed);
+            Uint64 head = tail;
+            for(Uint32 ii = 0; taps; ii++, taps >>= 1) {
+                if (taps & 1) {
+                    head = std::min(head,_capheads[ii].load(std::memory_order_acquire));
+                }
+            }
+            Uint32 amt = (Uint32)std::min<Uint64>(_capsize-(tail-head),frames);
+            Uint32 start = (Uint32)(tail % _capsize);
+            Uint32 first = std::min(amt,_capsize-start);
+            std::memcpy(_capbuffer+start*_channels,buffer,first*_channels*sizeof(float));
+            std::memcpy(_capbuffer,buffer+first*_channels,(amt-first)*_channels*sizeof(float));
+            _captail.store(tail+amt,std::memory_order_release);
+        }
+        
         std::unique_lock<std::mutex> lock(_buffmtex);
         float* input = buffer;
         Uint32 temp = frames;
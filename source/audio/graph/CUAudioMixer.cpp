@@ -38,6 +38,7 @@
 #include <cugl/math/dsp/CUDSPMath.h>
 #include <cugl/util/CUDebug.h>
 #include <atomic>
+#include <utility>
 
 using namespace cugl;
 using namespace cugl::audio;
@@ -60,6 +61,9 @@ AudioMixer::AudioMixer() :
 _width(0),
 _knee(-1),
 _inputs(nullptr),
+_mixing(nullptr),
+_mixwidth(0),
+_status(1),
 _buffer(nullptr) {
     _classname = "AudioScheduler";
 #if CU_PLATFORM == CU_PLATFORM_ANDROID
@@ -78,6 +82,54 @@ void AudioMixer::allocateBuffer() {
     _buffer = (float*)malloc(_readsize*_channels*sizeof(float));
 }
 
+/**
+ * Applies the input changes sent since the last read
+ *
+ * AUDIO THREAD ONLY: This method is called at the start of {@link read}.
+ */
+void AudioMixer::applyCommands() {
+    _commands.apply([this](Command& command) {
+        switch (command.type) {
+            case Command::Type::ATTACH:
+                if (command.slot < _mixwidth) {
+                    std::swap(_mixing[command.slot],command.node);
+                }
+                break;
+            case Command::Type::RESIZE:
+            {
+                std::shared_ptr<AudioNode>* old = _mixing;
+                _mixing = command.inputs.release();
+                command.inputs.reset(old);
+                std::swap(_mixwidth,command.width);
+            }
+                break;
+        }
+    });
+}
+
+/**
+ * Updates the completion state from the inputs seen by the current thread
+ *
+ * This method should be called after any change outside of a read that
+ * could change whether the mixer is complete.
+ */
+void AudioMixer::updateStatus() {
+    std::shared_ptr<AudioNode>* inputs = getSlots();
+    Uint8 width = getSlotCount();
+    bool done = true;
+    for(int ii = 0; ii < width; ii++) {
+        if (inputs[ii]) {
+            done = inputs[ii]->completed() && done;
+        }
+    }
+    Uint32 state = _status.load(std::memory_order_relaxed);
+    Uint32 next;
+    do {
+        next = ((state+2) & ~1) | (done ? 1 : 0);
+    } while (!_status.compare_exchange_weak(state,next,std::memory_order_release,
+                                            std::memory_order_relaxed));
+}
+
 /**
  * Initializes the mixer with default stereo settings
  *
@@ -154,8 +206,11 @@ bool AudioMixer::init(Uint8 width, Uint8 channels, Uint32 rate) {
         _width = width;
         _knee  = -1;
         _inputs = new std::shared_ptr<AudioNode>[_width];
+        _mixing = new std::shared_ptr<AudioNode>[_width];
+        _mixwidth = _width;
         for (int ii = 0; ii < _width; ii++) {
             _inputs[ii] = nullptr;
+            _mixing[ii] = nullptr;
         }
         allocateBuffer();
         return true;
@@ -172,10 +227,15 @@ bool AudioMixer::init(Uint8 width, Uint8 channels, Uint32 rate) {
 void AudioMixer::dispose() {
     if (_booted) {
         AudioNode::dispose();
+        _commands.clear();
         if (_inputs != nullptr) {
             delete[] _inputs;
             _inputs = nullptr;
         }
+        if (_mixing != nullptr) {
+            delete[] _mixing;
+            _mixing = nullptr;
+        }
         if (_buffer != nullptr) {
             free(_buffer);
             _buffer = nullptr;
@@ -183,6 +243,7 @@ void AudioMixer::dispose() {
         _inputs = nullptr;
         _buffer = nullptr;
         _width = 0;
+        _mixwidth = 0;
         _knee  = -1;
     }
 }
@@ -196,6 +257,8 @@ void AudioMixer::dispose() {
  * The input is attached at the given slot. Any input node previously at
  * that slot is removed (and returned by this method).
  *
+ * The change takes effect at the start of the next read in the audio thread.
+ *
  * @param slot  The slot for the input node
  * @param input The input node to attach
  *
@@ -222,7 +285,11 @@ std::shared_ptr<AudioNode> AudioMixer::attach(Uint8 slot, const std::shared_ptr<
     
     _marked.store(0,std::memory_order_relaxed);
     _offset.store(0,std::memory_order_relaxed);
-    return std::atomic_exchange_explicit(_inputs+slot,input,std::memory_order_relaxed);
+    std::shared_ptr<AudioNode> result = _inputs[slot];
+    _inputs[slot] = input;
+    _commands.push(Command(slot,input));
+    updateStatus();
+    return result;
 }
 
 /**
@@ -230,13 +297,19 @@ std::shared_ptr<AudioNode> AudioMixer::attach(Uint8 slot, const std::shared_ptr<
  *
  * The input node detached is returned by this method.
  *
+ * The change takes effect at the start of the next read in the audio thread.
+ *
  * @param slot  The slot for the input node
  *
  * @return the input node detached from the slot
  */
 std::shared_ptr<AudioNode> AudioMixer::detach(Uint8 slot) {
     CUAssertLog(slot < _width, "Slot %d is out of range",slot);
-    return std::atomic_exchange_explicit(_inputs+slot,{},std::memory_order_relaxed);
+    std::shared_ptr<AudioNode> result = _inputs[slot];
+    _inputs[slot] = nullptr;
+    _commands.push(Command(slot,std::shared_ptr<AudioNode>()));
+    updateStatus();
+    return result;
 }
 
 /**
@@ -249,19 +322,14 @@ std::shared_ptr<AudioNode> AudioMixer::detach(Uint8 slot) {
  * An audio node is typically completed if it return 0 (no frames read) on
  * subsequent calls to {@link read()}.
  *
+ * This value is updated by the audio thread at the end of each read, and by
+ * the main thread whenever the inputs are changed or repositioned. Hence it
+ * is safe to call from either thread.
+ *
  * @return true if this audio node has no more data.
  */
 bool AudioMixer::completed() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    bool success = true;
-    std::shared_ptr<AudioNode> temp;
-    for(int ii = 0; ii < _width; ii++) {
-        temp = std::atomic_load_explicit(_inputs+ii,std::memory_order_relaxed);
-        if (temp) {
-            success = success && temp->completed();
-        }
-    }
-    return success;
+    return _status.load(std::memory_order_acquire) & 1;
 }
 
 /**
@@ -283,25 +351,26 @@ bool AudioMixer::completed() {
  * @return the actual number of frames read
  */
 Uint32 AudioMixer::read(float* buffer, Uint32 frames) {
+    ReadTimer timer(this);
+    Uint32 state = _status.load(std::memory_order_acquire);
+    applyCommands();
     std::memset(buffer,0,frames*_channels*sizeof(float));
     Uint32 actual = 0;
     if (!_paused.load(std::memory_order_relaxed)) {
-        std::lock_guard<std::mutex> lock(_mutex);
-        std::shared_ptr<AudioNode> temp;
+        AudioNode* temp;
         Uint32 remain = frames;
         float* output = buffer;
+        float gain = _ndgain.load(std::memory_order_relaxed);
         while (remain > 0) {
             Uint32 chunk = std::min(remain,_readsize);
             Uint32 taken = 0;
-            for(int ii = 0; ii < _width; ii++) {
-                temp = std::atomic_load_explicit(_inputs+ii,std::memory_order_relaxed);
+            for(int ii = 0; ii < _mixwidth; ii++) {
+                temp = _mixing[ii].get();
                 if (temp) {
+                    // Output is zeroed, so only accumulate what was read
                     Uint32 amt = temp->read(_buffer,chunk);
                     taken = std::max(amt,taken);
-                    if (amt < chunk) {
-                        std::memset(_buffer+amt*_channels,0,(chunk-amt)*_channels*sizeof(float));
-                    }
-                    dsp::DSPMath::add(_buffer,output,output,chunk*_channels);
+                    dsp::DSPMath::scale_add(_buffer,output,gain,output,amt*_channels);
                 }
             }
             output += taken*_channels;
@@ -312,7 +381,6 @@ Uint32 AudioMixer::read(float* buffer, Uint32 frames) {
                 remain -= taken;
             }
         }
-        dsp::DSPMath::scale(buffer,_ndgain.load(std::memory_order_relaxed),buffer,actual*_channels);
         float knee = _knee.load(std::memory_order_relaxed);
         if (knee == 1) {
             dsp::DSPMath::clamp(buffer,-1,1,actual*_channels);
@@ -324,8 +392,17 @@ Uint32 AudioMixer::read(float* buffer, Uint32 frames) {
         actual = frames;
     }
     
-    Uint64 pos = _offset.load(std::memory_order_relaxed);
-    _offset.store(pos+actual,std::memory_order_relaxed);
+    _offset.fetch_add(actual,std::memory_order_relaxed);
+
+    // Publish completion, unless the main thread changed something meanwhile
+    bool done = true;
+    for(int ii = 0; ii < _mixwidth; ii++) {
+        if (_mixing[ii]) {
+            done = _mixing[ii]->completed() && done;
+        }
+    }
+    _status.compare_exchange_strong(state,(state & ~1) | (done ? 1 : 0),
+                                    std::memory_order_release,std::memory_order_relaxed);
     return actual;
 }
 
@@ -350,6 +427,15 @@ bool AudioMixer::setWidth(Uint8 width) {
         }
         delete[] _inputs;
         _inputs = replace;
+        _width = width;
+
+        // The audio thread gets its own copy of the slots
+        std::shared_ptr<AudioNode>* mixing = new std::shared_ptr<AudioNode>[width];
+        for(int ii = 0; ii < width; ii++) {
+            mixing[ii] = replace[ii];
+        }
+        _commands.push(Command(mixing,width));
+        updateStatus();
         return true;
     }
     return false;
@@ -378,7 +464,7 @@ void AudioMixer::setReadSize(Uint32 size) {
         _readsize = size;
         allocateBuffer();
         for(int ii = 0; ii < _width; ii++) {
-            std::shared_ptr<AudioNode> temp = std::atomic_load_explicit(_inputs+ii,std::memory_order_relaxed);
+            std::shared_ptr<AudioNode> temp = _inputs[ii];
             if (temp != nullptr) {
                 temp->setReadSize(_readsize);
             }
@@ -443,11 +529,12 @@ void AudioMixer::setKnee(float knee) {
  * @return true if the read position was marked across all inputs.
  */
 bool AudioMixer::mark() {
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::shared_ptr<AudioNode>* inputs = getSlots();
+    Uint8 width = getSlotCount();
     bool success = true;
     std::shared_ptr<AudioNode> temp;
-    for(int ii = 0; ii < _width; ii++) {
-        temp = std::atomic_load_explicit(_inputs+ii,std::memory_order_relaxed);
+    for(int ii = 0; ii < width; ii++) {
+        temp = inputs[ii];
         if (temp) {
             success = temp->mark() && success;
         }
@@ -476,11 +563,12 @@ bool AudioMixer::mark() {
  * @return true if the read position was marked.
  */
 bool AudioMixer::unmark() {
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::shared_ptr<AudioNode>* inputs = getSlots();
+    Uint8 width = getSlotCount();
     bool success = true;
     std::shared_ptr<AudioNode> temp;
-    for(int ii = 0; ii < _width; ii++) {
-        temp = std::atomic_load_explicit(_inputs+ii,std::memory_order_relaxed);
+    for(int ii = 0; ii < width; ii++) {
+        temp = inputs[ii];
         if (temp) {
             success = temp->unmark() && success;
         }
@@ -504,16 +592,18 @@ bool AudioMixer::unmark() {
  * @return true if the read position was moved.
  */
 bool AudioMixer::reset() {
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::shared_ptr<AudioNode>* inputs = getSlots();
+    Uint8 width = getSlotCount();
     bool success = true;
     std::shared_ptr<AudioNode> temp;
-    for(int ii = 0; ii < _width; ii++) {
-        temp = std::atomic_load_explicit(_inputs+ii,std::memory_order_relaxed);
+    for(int ii = 0; ii < width; ii++) {
+        temp = inputs[ii];
         if (temp) {
             success = temp->reset() && success;
         }
     }
     _offset.store(_marked.load(std::memory_order_relaxed),std::memory_order_relaxed);
+    updateStatus();
     return success;
 }
 
@@ -534,12 +624,13 @@ bool AudioMixer::reset() {
  * @return the actual number of frames advanced; -1 if not supported
  */
 Sint64 AudioMixer::advance(Uint32 frames) {
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::shared_ptr<AudioNode>* inputs = getSlots();
+    Uint8 width = getSlotCount();
     Sint64 actual = 0;
     bool fail = false;
     std::shared_ptr<AudioNode> temp;
-    for(int ii = 0; ii < _width; ii++) {
-        temp = std::atomic_load_explicit(_inputs+ii,std::memory_order_relaxed);
+    for(int ii = 0; ii < width; ii++) {
+        temp = inputs[ii];
         if (temp) {
             Sint64 amt = temp->advance(frames);
             actual = std::max(actual,amt);
@@ -547,8 +638,8 @@ Sint64 AudioMixer::advance(Uint32 frames) {
         }
     }
     
-    Uint64 pos = _offset.load(std::memory_order_relaxed);
-    _offset.store(pos+actual,std::memory_order_relaxed);
+    _offset.fetch_add(actual,std::memory_order_relaxed);
+    updateStatus();
     return fail ? -1 : actual;
 }
 
@@ -588,12 +679,13 @@ Sint64 AudioMixer::getPosition() const {
  * @return the new frame position of this audio node.
  */
 Sint64 AudioMixer::setPosition(Uint32 position) {
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::shared_ptr<AudioNode>* inputs = getSlots();
+    Uint8 width = getSlotCount();
     Sint64 actual = 0;
     bool fail = false;
     std::shared_ptr<AudioNode> temp;
-    for(int ii = 0; ii < _width; ii++) {
-        temp = std::atomic_load_explicit(_inputs+ii,std::memory_order_relaxed);
+    for(int ii = 0; ii < width; ii++) {
+        temp = inputs[ii];
         if (temp) {
             Sint64 amt = temp->setPosition(position);
             actual = std::max(actual,amt);
@@ -602,6 +694,7 @@ Sint64 AudioMixer::setPosition(Uint32 position) {
     }
     
     _offset.store(actual,std::memory_order_relaxed);
+    updateStatus();
     return fail ? -1 : actual;
 }
 
@@ -662,12 +755,14 @@ double AudioMixer::setElapsed(double time) {
  * @return the remaining time in seconds.
  */
 double AudioMixer::getRemaining() const {
+    std::shared_ptr<AudioNode>* inputs = getSlots();
+    Uint8 width = getSlotCount();
     // An unavoidable race condition has minor effects on accuracy
     double actual = 0;
     bool fail = false;
     std::shared_ptr<AudioNode> temp;
-    for(int ii = 0; ii < _width; ii++) {
-        temp = std::atomic_load_explicit(_inputs+ii,std::memory_order_relaxed);
+    for(int ii = 0; ii < width; ii++) {
+        temp = inputs[ii];
         if (temp) {
             double amt = temp->getRemaining();
             actual = std::max(actual,amt);
@@ -700,14 +795,14 @@ double AudioMixer::getRemaining() const {
  * @return the new remaining time in seconds.
  */
 double AudioMixer::setRemaining(double time) {
-    std::lock_guard<std::mutex> lock(_mutex);
-    
+    std::shared_ptr<AudioNode>* inputs = getSlots();
+    Uint8 width = getSlotCount();
     // Get longest time remaining
     double actual = 0;
     bool fail = false;
     std::shared_ptr<AudioNode> temp;
-    for(int ii = 0; ii < _width; ii++) {
-        temp = std::atomic_load_explicit(_inputs+ii,std::memory_order_relaxed);
+    for(int ii = 0; ii < width; ii++) {
+        temp = inputs[ii];
         if (temp) {
             double amt = temp->getRemaining();
             actual = std::max(actual,amt);
@@ -718,8 +813,8 @@ double AudioMixer::setRemaining(double time) {
     Uint64 pos = _offset.load(std::memory_order_relaxed)+actual*getRate();
     
     // Now push forward
-    for(int ii = 0; ii < _width; ii++) {
-        temp = std::atomic_load_explicit(_inputs+ii,std::memory_order_relaxed);
+    for(int ii = 0; ii < width; ii++) {
+        temp = inputs[ii];
         if (temp) {
             Uint64 off = temp->setPosition((Uint32)pos);
             if (off < 0) {
@@ -732,5 +827,6 @@ double AudioMixer::setRemaining(double time) {
     }
     
     _offset.store(pos,std::memory_order_relaxed);
+    updateStatus();
     return fail ? -1 : actual;
 }
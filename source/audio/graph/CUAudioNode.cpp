@@ -58,6 +58,24 @@ const Uint32 AudioNode::DEFAULT_CHANNELS = 2;
 /** The default sampling frequency for an audio graph node */
 const Uint32 AudioNode::DEFAULT_SAMPLING = 48000;
 
+/** Whether the current thread reads the audio graph for an audio device */
+static thread_local bool audio_thread = false;
+/** Whether the current thread reads the audio graph for an offline renderer */
+static thread_local bool offline_thread = false;
+
+/**
+ * Returns the number of microseconds between two performance counter values
+ *
+ * @param start The initial counter value
+ * @param end   The final counter value
+ *
+ * @return the number of microseconds between two performance counter values
+ */
+static Uint64 ticks_to_micros(Uint64 start, Uint64 end) {
+    static const Uint64 freq = SDL_GetPerformanceFrequency();
+    return ((end-start)*1000000)/freq;
+}
+
 #pragma mark -
 #pragma mark Constructors
 
@@ -77,6 +95,7 @@ AudioNode::AudioNode() : _channels(0), _sampling(0) {
     _paused = false;
     _polling = false;
     _booted = false;
+    _profiled = false;
     _tag = -1;
 }
 
@@ -152,6 +171,8 @@ void AudioNode::dispose() {
     _paused.store(false);
     _hashOfName = 0;
     _localname = "";
+    _profiled.store(false);
+    _counters.reset();
     _tag = -1;
 }
 
@@ -292,6 +313,61 @@ void AudioNode::notify(const std::shared_ptr<AudioNode>& node, AudioNode::Action
     });
 }
 
+/**
+ * Marks whether the current thread is an audio thread
+ *
+ * This is set by {@link AudioOutput} at the start of each poll by the
+ * audio device, and by {@link AudioRenderer} while it renders a graph.
+ * It should not be set anywhere else.
+ *
+ * @param flag  Whether the current thread is an audio thread
+ */
+void AudioNode::setAudioThread(bool flag) {
+    audio_thread = flag;
+}
+
+/**
+ * Marks whether the current thread renders the audio graph offline
+ *
+ * This is set by {@link AudioRenderer} while it renders a graph. It
+ * should not be set anywhere else.
+ *
+ * @param flag  Whether the current thread renders the audio graph offline
+ */
+void AudioNode::setOffline(bool flag) {
+    offline_thread = flag;
+}
+
+/**
+ * Returns true if the current thread is an audio thread
+ *
+ * An audio thread is one that reads the audio graph on behalf of an audio
+ * device. Nodes that send their changes to the audio thread (such as
+ * {@link AudioMixer}) use this to apply changes immediately when they
+ * are made by the audio thread itself, as when a {@link AudioScheduler}
+ * resets a looping node.
+ *
+ * @return true if the current thread is an audio thread
+ */
+bool AudioNode::isAudioThread() {
+    return audio_thread;
+}
+
+/**
+ * Returns true if the current thread renders the audio graph offline
+ *
+ * An offline thread is one that reads the audio graph on behalf of an
+ * {@link AudioRenderer}, as fast as it can and with no device deadline.
+ * Nodes that would normally drop data rather than block the audio
+ * thread (such as a streaming {@link AudioPlayer}) use this to wait
+ * for the data instead. An offline thread is always an audio thread.
+ *
+ * @return true if the current thread renders the audio graph offline
+ */
+bool AudioNode::isOffline() {
+    return offline_thread;
+}
+
 /**
  * Returns true if this node is currently paused
  *
@@ -344,6 +420,47 @@ bool AudioNode::resume() {
  * @return the actual number of frames read
  */
 Uint32 AudioNode::read(float* buffer, Uint32 frames) {
+    ReadTimer timer(this);
     std::memset(buffer, 0, sizeof(float)*frames*_channels);
     return frames;
 }
+
+#pragma mark -
+#pragma mark Profiling
+/**
+ * Returns a snapshot of the read timing for this node
+ *
+ * This method is lock-free and may be called from any thread. The values
+ * are only updated while the node is profiled.
+ *
+ * @return a snapshot of the read timing for this node
+ */
+AudioProfile AudioNode::getProfile() const {
+    AudioProfile result;
+    _counters.snapshot(result);
+    return result;
+}
+
+/**
+ * Starts timing a read of the given node
+ *
+ * @param node  The node being read
+ */
+AudioNode::ReadTimer::ReadTimer(AudioNode* node) {
+    if (node->_profiled.load(std::memory_order_relaxed)) {
+        _node  = node;
+        _start = SDL_GetPerformanceCounter();
+    } else {
+        _node  = nullptr;
+        _start = 0;
+    }
+}
+
+/**
+ * Stops timing the read, recording it to the node
+ */
+AudioNode::ReadTimer::~ReadTimer() {
+    if (_node != nullptr) {
+        _node->_counters.record(ticks_to_micros(_start,SDL_GetPerformanceCounter()));
+    }
+}
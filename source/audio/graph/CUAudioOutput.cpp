@@ -50,6 +50,7 @@
 #include <cugl/audio/CUAudioDevices.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUTimestamp.h>
+#include <cugl/util/CUProfiler.h>
 #include <atomic>
 #include <cstring>
 
@@ -68,6 +69,7 @@ const static std::string DEFAULT_NAME("(DEFAULT DEVICE)");
  * This is the function that SDL uses to populate the audio buffer
  */
 static void audioCallback(void*  userdata, Uint8* stream, int len) {
+    CU_PROFILE_SCOPE("AudioOutput::poll");
     AudioOutput* device = (AudioOutput*)userdata;
     device->poll(stream,len);
 }
@@ -833,12 +835,10 @@ bool AudioOutput::completed() {
  * @return the actual number of frames read
  */
 Uint32 AudioOutput::read(float* buffer, Uint32 frames) {
-    Timestamp start;
-
     std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
     Uint32 take = 0;
     if (input == nullptr || _paused.load(std::memory_order_relaxed)) {
-        std::memset(buffer,0,frames*_audiospec.channels*_bitrate);
+        std::memset(buffer,0,frames*_audiospec.channels*sizeof(float));
         take = frames;
     } else if (_resampler != nullptr) {
         take = _resampler->read(buffer,frames);
@@ -850,16 +850,35 @@ Uint32 AudioOutput::read(float* buffer, Uint32 frames) {
     
     // Buck stops here.  Fill remainder with 0s.
     if (take < frames) {
-        std::memset(buffer+take*_audiospec.channels,0,(frames-take)*_audiospec.channels);
+        if (!input->completed()) {
+            _counters.starved.fetch_add(1,std::memory_order_relaxed);
+        }
+        std::memset(buffer+take*_audiospec.channels,0,(frames-take)*_audiospec.channels*sizeof(float));
     }
-
-    Timestamp end;
-    Uint64 micros = Timestamp::ellapsedMicros(start,end);
-    _overhd.store(micros,std::memory_order_relaxed);
     return frames;
 }
 
+/**
+ * Reads up to the specified number of bytes into the given buffer
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ * The only exception is when the user needs to create a custom subclass
+ * of this AudioOutput.
+ *
+ * This method is used by the SDL audio interface to process the audio
+ * graph. It should never be called by the developer.
+ *
+ * This method times the entire callback for {@link getProfile}. A callback
+ * that takes longer than the buffer period is counted as an underrun.
+ *
+ * @param stream    The read buffer to store the results
+ * @param len       The maximum number of bytes to read
+ *
+ * @return the actual number of bytes read
+ */
 Uint32 AudioOutput::poll(Uint8* stream, int len) {
+    Timestamp start;
+    setAudioThread(true);
     Uint32 wordsize = SDL_AUDIO_BITSIZE(_audiospec.format)/8;
     Uint32 take = 0;
     Uint32 frames = len/(_audiospec.channels*wordsize);
@@ -873,6 +892,16 @@ Uint32 AudioOutput::poll(Uint8* stream, int len) {
     } else {
         take = read((float*)stream,frames);
     }
+
+    Timestamp end;
+    Uint64 micros = Timestamp::ellapsedMicros(start,end);
+    Uint64 period = ((Uint64)frames*1000000)/_audiospec.freq;
+    _overhd.store(micros,std::memory_order_relaxed);
+    _counters.period.store(period,std::memory_order_relaxed);
+    _counters.record(micros);
+    if (micros > period) {
+        _counters.underruns.fetch_add(1,std::memory_order_relaxed);
+    }
     return take;
 }
 
@@ -911,7 +940,9 @@ void AudioOutput::reboot() {
 /**
  * Returns the number of microseconds needed to render the last audio frame.
  *
- * This method is primarily for debugging.
+ * This method is primarily for debugging. Use {@link getProfile} for the
+ * rolling timing and the number of underruns. Unlike other nodes, an output
+ * is always profiled, and its profile times the entire device callback.
  *
  * @return the number of microseconds needed to render the last audio frame.
  */
@@ -920,6 +951,7 @@ Uint64 AudioOutput::getOverhead() const {
 }
 
 
+
 #pragma mark -
 #pragma mark Optional Methods
 /**
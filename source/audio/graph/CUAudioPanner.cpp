@@ -33,11 +33,15 @@
 //
 #include <cugl/audio/graph/CUAudioPanner.h>
 #include <cugl/audio/CUAudioDevices.h>
+#include <cugl/math/dsp/CUDSPMath.h>
 #include <cugl/util/CUDebug.h>
 #include <cmath>
 
 using namespace cugl::audio;
 
+/** The most channels (input or output) supported by the vectorized remix */
+#define PAN_REMIX_LIMIT 8
+
 /**
  * Creates a degenerate audio panner
  *
@@ -321,6 +325,7 @@ bool AudioPanner::completed() {
  * @return the actual number of frames read
  */
 Uint32 AudioPanner::read(float* buffer, Uint32 frames) {
+    ReadTimer timer(this);
     std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
     bool identity = _identity.load(std::memory_order_relaxed);
     if (input == nullptr || _paused.load(std::memory_order_relaxed)) {
@@ -329,6 +334,18 @@ Uint32 AudioPanner::read(float* buffer, Uint32 frames) {
     } else if (identity) {
         return input->read(buffer, frames);
     } else {
+        // Snapshot the pan matrix (output major) for the vectorized remix
+        float matrix[PAN_REMIX_LIMIT*PAN_REMIX_LIMIT];
+        bool remix = _field <= PAN_REMIX_LIMIT && _channels <= PAN_REMIX_LIMIT;
+        if (remix) {
+            for(int ii = 0; ii < _field; ii++) {
+                for(int jj = 0; jj < _channels; jj++) {
+                    float percent =  _mapper[ii*_channels+jj].load(std::memory_order_relaxed);
+                    matrix[jj*_field+ii] = percent > 0 ? percent : 0;
+                }
+            }
+        }
+        
         Uint32 actual = 0;
         Uint32 remain = frames;
         float* current = buffer;
@@ -336,17 +353,21 @@ Uint32 AudioPanner::read(float* buffer, Uint32 frames) {
             Uint32 chunk = std::min(remain,_readsize);
             std::memset(current,0,chunk*_channels*sizeof(float));
             Uint32 taken = input->read(_buffer, chunk);
-            for(int ii = 0; ii < _field; ii++) {
-                for(int jj = 0; jj < _channels; jj++) {
-                    float percent =  _mapper[ii*_channels+jj].load(std::memory_order_relaxed);
-                    if (percent > 0) {
-                        float* output = current+jj;
-                        float* input  = _buffer+ii;
-                        Uint32 amt = taken;
-                        while (amt--) {
-                            *output += *input*percent;
-                            output += _channels;
-                            input  += _field;
+            if (remix) {
+                dsp::DSPMath::remix(_buffer,_field,matrix,current,_channels,taken);
+            } else {
+                for(int ii = 0; ii < _field; ii++) {
+                    for(int jj = 0; jj < _channels; jj++) {
+                        float percent =  _mapper[ii*_channels+jj].load(std::memory_order_relaxed);
+                        if (percent > 0) {
+                            float* output = current+jj;
+                            float* input  = _buffer+ii;
+                            Uint32 amt = taken;
+                            while (amt--) {
+                                *output += *input*percent;
+                                output += _channels;
+                                input  += _field;
+                            }
                         }
                     }
                 }
@@ -42,11 +42,33 @@
 #include <cugl/base/CUApplication.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUTimestamp.h>
+#include <cugl/util/CUThreadPool.h>
 #include <cugl/math/dsp/CUDSPMath.h>
+#include <condition_variable>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
 
 using namespace cugl::audio;
 using namespace cugl;
 
+/** The number of pages decoded ahead of a streaming player (a power of two) */
+#define STREAM_PAGES    4
+/** The time in milliseconds the stream worker waits when it has no work */
+#define STREAM_SLEEP    5
+
+/** The players currently serviced by the stream worker */
+static std::vector<AudioPlayer*> stream_players;
+/** The lock for the stream players (never taken by the audio thread) */
+static std::mutex stream_mutex;
+/** The condition for waking the stream worker */
+static std::condition_variable stream_cond;
+/** The thread running the stream worker */
+static std::shared_ptr<ThreadPool> stream_thread;
+/** The current stream worker; a worker stops once this changes */
+static Uint32 stream_epoch = 0;
+
 #pragma mark Constructors
 /**
  * Creates a degenerate audio player with no associated source.
@@ -64,6 +86,19 @@ _chunker(nullptr),
 _chklimt(0),
 _chklast(0),
 _chksize(0),
+_chkpage(0),
+_chkskip(0),
+_chkslot(false),
+_headpage(nullptr),
+_headsize(0),
+_pagedata(nullptr),
+_pages(nullptr),
+_pagehead(0),
+_pagetail(0),
+_seekpage(0),
+_seekgen(0),
+_readgen(0),
+_workgen(0),
 _dirty(false) {
     _classname = "AudioPlayer";
 }
@@ -88,10 +123,33 @@ bool AudioPlayer::init(const std::shared_ptr<AudioSample>& source) {
         if (source->isStreamed() && _decoder != nullptr) {
             Uint32 channels = _decoder->getChannels();
             _chksize  = _decoder->getPageSize();
-            _chklimt  = _chksize;
-            _chklast  = _chksize;
-            _chunker  = (float*)malloc(_chksize*channels*sizeof(float));
-            std::memset(_chunker,0,_chksize*channels*sizeof(float));
+            size_t pagesize = _chksize*channels;
+            _headpage = (float*)malloc(pagesize*sizeof(float));
+            _pagedata = (float*)malloc(STREAM_PAGES*pagesize*sizeof(float));
+            _pages = new StreamPage[STREAM_PAGES];
+            for(int ii = 0; ii < STREAM_PAGES; ii++) {
+                _pages[ii].data = _pagedata+ii*pagesize;
+                _pages[ii].frames = 0;
+                _pages[ii].page = 0;
+                _pages[ii].gen  = 0;
+            }
+            
+            // Decode the first page now so that resets are free
+            Sint32 amt = _decoder->pagein(_headpage);
+            _headsize = amt < 0 ? 0 : (Uint32)amt;
+            _chunker  = _headpage;
+            _chklimt  = _headsize;
+            _chklast  = 0;
+            _chkpage  = 0;
+            _chkskip  = 0;
+            _chkslot  = false;
+            _pagehead.store(0,std::memory_order_relaxed);
+            _pagetail.store(0,std::memory_order_relaxed);
+            _seekpage.store(_decoder->getPage(),std::memory_order_relaxed);
+            _seekgen.store(0,std::memory_order_relaxed);
+            _readgen = 0;
+            _workgen = 0;
+            startStream(this);
         }
         return true;
     }
@@ -106,6 +164,9 @@ bool AudioPlayer::init(const std::shared_ptr<AudioSample>& source) {
  */
 void AudioPlayer::dispose() {
     if (_booted) {
+        if (_pages) {
+            stopStream(this);
+        }
         AudioNode::dispose();
         _source = nullptr;
         _decoder = nullptr;
@@ -114,13 +175,26 @@ void AudioPlayer::dispose() {
         _buffer  = nullptr;
         _calling.store(false);
         _callback = nullptr;
+        if (_pages) {
+            delete[] _pages;
+            _pages = nullptr;
+        }
+        if (_headpage) {
+            free(_headpage);
+            _headpage = nullptr;
+        }
+        if (_pagedata) {
+            free(_pagedata);
+            _pagedata = nullptr;
+        }
+        _chunker = nullptr;
         _chksize = 0;
         _chklimt = 0;
         _chklast = 0;
-        if (_chunker) {
-            free(_chunker);
-            _chunker = nullptr;
-        }
+        _chkpage = 0;
+        _chkskip = 0;
+        _chkslot = false;
+        _headsize = 0;
     }
 }
 
@@ -145,6 +219,7 @@ void AudioPlayer::dispose() {
  * @return the actual number of frames read
  */
 Uint32 AudioPlayer::read(float* buffer, Uint32 frames) {
+    ReadTimer timer(this);
     if (_paused.load(std::memory_order_relaxed)) {
         std::memset(buffer,0,frames*sizeof(float)*_channels);
         return frames;
@@ -170,17 +245,14 @@ Uint32 AudioPlayer::read(float* buffer, Uint32 frames) {
         }
         
         Uint32 remnant  = frames;
-        Uint32 channels = _decoder->getChannels();
+        Uint32 channels = _channels;
         bool okay = true;
         while (okay && remnant) {
             if (_chklast >= _chklimt) {
-                _chklimt = _decoder->pagein(_chunker);
-                _chklast = 0;
+                okay = nextPage() || (isOffline() && awaitPage());
             }
-            Uint32 avail = std::min((_chklimt-_chklast),remnant);
-            if (avail == 0) {
-                okay = false;
-            } else {
+            if (okay) {
+                Uint32 avail = std::min((_chklimt-_chklast),remnant);
                 std::memcpy(buffer+(frames-remnant)*channels, _chunker+_chklast*channels, avail*channels*sizeof(float));
                 remnant  -= avail;
                 _chklast += avail;
@@ -188,12 +260,18 @@ Uint32 AudioPlayer::read(float* buffer, Uint32 frames) {
         }
         amt -= remnant;
     }
+    
+    // A late stream worker is an underrun, not the end of the stream
+    Uint32 result = amt;
+    if (amt < frames && off+amt < _source->getLength()) {
+        std::memset(buffer+amt*_channels,0,(frames-amt)*_channels*sizeof(float));
+        result = frames;
+    }
 
     dsp::DSPMath::scale(buffer,_ndgain.load(std::memory_order_relaxed),buffer,amt*_channels);
     _offset.store(off+amt,std::memory_order_release);
     _polling.store(false);
-    Timestamp end;
-    return amt;
+    return result;
 }
 
 /**
@@ -378,12 +456,15 @@ double AudioPlayer::setRemaining(double time) {
 #pragma mark -
 #pragma mark Stream Decoding
 /**
- * Decodes the audio stream up to the given position.
+ * Repositions the audio stream at the given position.
  *
  * AUDIO THREAD ONLY: Users should never access this method directly.
  * The only exception is when the user needs to create a custom subclass
  * of this AudioNode.
  *
+ * This method never decodes. If the position is not in a page that is
+ * already decoded, the stream worker is told to seek to that page.
+ *
  * If the frame is longer than the stream length, it goes to the end of
  * the stream.
  *
@@ -391,7 +472,229 @@ double AudioPlayer::setRemaining(double time) {
  */
 void AudioPlayer::scan(Uint64 frame) {
     Uint32 page = (Uint32)(frame/_chksize);
-    _decoder->setPage(page);
-    _chklimt = (Uint32)_decoder->pagein(_chunker);
-    _chklast = (Uint32)(_chklimt == 0 ? _chksize : frame % _chksize);
+    Uint32 skip = (Uint32)(frame % _chksize);
+    if (page == 0) {
+        // The head page is always available
+        releasePage();
+        _chunker = _headpage;
+        _chklimt = _headsize;
+        _chklast = std::min(skip,_headsize);
+        _chkpage = 0;
+        seekPages(1);
+    } else if (_chkslot && _chkpage == page) {
+        _chklast = std::min(skip,_chklimt);
+    } else {
+        releasePage();
+        seekPages(page);
+        _chunker = nullptr;
+        _chklimt = 0;
+        _chklast = 0;
+        _chkskip = skip;
+    }
+}
+
+/**
+ * Moves the stream pages forward to the given page.
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ *
+ * All stale pages and pages before the given one are released. If the
+ * oldest remaining page is not the given page, the stream worker is told
+ * to start decoding again from that page.
+ *
+ * @param page  The next page to read
+ */
+void AudioPlayer::seekPages(Uint32 page) {
+    Uint32 head = _pagehead.load(std::memory_order_relaxed);
+    Uint32 tail = _pagetail.load(std::memory_order_acquire);
+    while (head != tail) {
+        StreamPage* slot = _pages+(head % STREAM_PAGES);
+        if (slot->gen == _readgen && slot->page >= page) {
+            break;
+        }
+        head++;
+    }
+    _pagehead.store(head,std::memory_order_release);
+    if (head != tail && _pages[head % STREAM_PAGES].page == page) {
+        return;
+    }
+
+    // Drop everything and restart the worker at this page
+    _pagehead.store(tail,std::memory_order_release);
+    _seekpage.store(page,std::memory_order_relaxed);
+    _seekgen.store(++_readgen,std::memory_order_release);
+}
+
+/**
+ * Releases the current chunk if it is a stream page.
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ */
+void AudioPlayer::releasePage() {
+    if (_chkslot) {
+        Uint32 head = _pagehead.load(std::memory_order_relaxed);
+        _pagehead.store(head+1,std::memory_order_release);
+        _chkslot = false;
+    }
+}
+
+/**
+ * Returns true if the next stream page was acquired as the current chunk.
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ *
+ * This method releases the current chunk first. It returns false if the
+ * stream worker has not decoded the next page yet, or if the stream is
+ * complete.
+ *
+ * @return true if the next stream page was acquired as the current chunk.
+ */
+bool AudioPlayer::nextPage() {
+    releasePage();
+    Uint32 head = _pagehead.load(std::memory_order_relaxed);
+    Uint32 tail = _pagetail.load(std::memory_order_acquire);
+    while (head != tail && _pages[head % STREAM_PAGES].gen != _readgen) {
+        head++;
+    }
+    _pagehead.store(head,std::memory_order_release);
+    if (head == tail) {
+        _chunker = nullptr;
+        _chklimt = 0;
+        _chklast = 0;
+        return false;
+    }
+    
+    StreamPage* slot = _pages+(head % STREAM_PAGES);
+    _chunker = slot->data;
+    _chklimt = slot->frames;
+    _chklast = std::min(_chkskip,_chklimt);
+    _chkpage = slot->page;
+    _chkskip = 0;
+    _chkslot = true;
+    return _chklast < _chklimt;
+}
+
+/**
+ * Returns true if the next stream page was acquired by decoding it now.
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ *
+ * This method is used in place of {@link nextPage} when the graph is
+ * rendered offline (see {@link AudioNode#isOffline}). Rather than wait
+ * on the stream worker, it decodes the pages on the reading thread, with
+ * the worker locked out. It only returns false if the stream is complete.
+ *
+ * @return true if the next stream page was acquired by decoding it now.
+ */
+bool AudioPlayer::awaitPage() {
+    bool more = true;
+    while (more) {
+        {
+            std::lock_guard<std::mutex> lock(stream_mutex);
+            more = decodeAhead();
+        }
+        if (nextPage()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns true if this player decoded a page ahead.
+ *
+ * WORKER THREAD ONLY: This method is called by the stream worker. It
+ * decodes at most one page, and returns false if the ring buffer is full
+ * or the stream is complete.
+ *
+ * @return true if this player decoded a page ahead.
+ */
+bool AudioPlayer::decodeAhead() {
+    Uint32 gen = _seekgen.load(std::memory_order_acquire);
+    if (gen != _workgen) {
+        _workgen = gen;
+        _decoder->setPage(_seekpage.load(std::memory_order_relaxed));
+    }
+    
+    Uint32 tail = _pagetail.load(std::memory_order_relaxed);
+    Uint32 head = _pagehead.load(std::memory_order_acquire);
+    if (tail-head >= STREAM_PAGES || !_decoder->ready()) {
+        return false;
+    }
+    
+    StreamPage* slot = _pages+(tail % STREAM_PAGES);
+    slot->page = _decoder->getPage();
+    Sint32 amt = _decoder->pagein(slot->data);
+    slot->frames = amt < 0 ? 0 : (Uint32)amt;
+    slot->gen = gen;
+    _pagetail.store(tail+1,std::memory_order_release);
+    return true;
+}
+
+#pragma mark -
+#pragma mark Stream Worker
+/**
+ * Adds a player to the stream worker, starting the worker if necessary.
+ *
+ * @param player    The streaming player
+ */
+void AudioPlayer::startStream(AudioPlayer* player) {
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    stream_players.push_back(player);
+    if (stream_thread == nullptr) {
+        Uint32 epoch = ++stream_epoch;
+        stream_thread = ThreadPool::alloc(1);
+        stream_thread->addTask([epoch](void) {
+            AudioPlayer::streamLoop(epoch);
+        });
+    }
+    stream_cond.notify_one();
+}
+
+/**
+ * Removes a player from the stream worker.
+ *
+ * The player is no longer accessed by the worker once this method returns.
+ * If there are no more streaming players, the worker is shut down.
+ *
+ * @param player    The streaming player
+ */
+void AudioPlayer::stopStream(AudioPlayer* player) {
+    std::shared_ptr<ThreadPool> thread;
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        auto it = std::find(stream_players.begin(),stream_players.end(),player);
+        if (it != stream_players.end()) {
+            stream_players.erase(it);
+        }
+        if (stream_players.empty() && stream_thread != nullptr) {
+            stream_epoch++;
+            thread = stream_thread;
+            stream_thread = nullptr;
+        }
+        stream_cond.notify_all();
+    }
+    
+    // Releasing the thread pool joins the worker
+    thread = nullptr;
+}
+
+/**
+ * Runs the stream worker until there are no more streaming players.
+ *
+ * WORKER THREAD ONLY: This is the task of the stream worker.
+ *
+ * @param epoch The epoch of this worker
+ */
+void AudioPlayer::streamLoop(Uint32 epoch) {
+    std::unique_lock<std::mutex> lock(stream_mutex);
+    while (stream_epoch == epoch) {
+        bool work = false;
+        for(auto it = stream_players.begin(); it != stream_players.end(); ++it) {
+            work = (*it)->decodeAhead() || work;
+        }
+        if (!work) {
+            stream_cond.wait_for(lock,std::chrono::milliseconds(STREAM_SLEEP));
+        }
+    }
 }
@@ -38,6 +38,7 @@
 //
 #include <cugl/audio/graph/CUAudioRedistributor.h>
 #include <cugl/audio/CUAudioDevices.h>
+#include <cugl/math/dsp/CUDSPMath.h>
 #include <cugl/util/CUDebug.h>
 #include <cmath>
 
@@ -1044,6 +1045,7 @@ void AudioRedistributor::setReadSize(Uint32 size) {
  * @return the actual number of frames read
  */
 Uint32 AudioRedistributor::read(float* buffer, Uint32 frames) {
+    ReadTimer timer(this);
     std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
     Uint32 take = 0;
     if (input == nullptr || _paused.load(std::memory_order_relaxed)) {
@@ -1317,6 +1319,10 @@ void AudioRedistributor::scaleUp(const float* input, float* output, size_t size)
     Uint32 cols = _conduits;
     Uint32 work = rows*cols;
     
+    if (dsp::DSPMath::remix(input,cols,_matrix,output,rows,size) == size) {
+        return;
+    }
+
     const float* src = input + size*cols;
     float* dst = output + size*rows;
     
@@ -1358,6 +1364,10 @@ void AudioRedistributor::scaleDown(const float* input, float* output, size_t siz
     Uint32 cols = _conduits;
     Uint32 work = rows*cols;
     
+    if (dsp::DSPMath::remix(input,cols,_matrix,output,rows,size) == size) {
+        return;
+    }
+
     const float* src = input;
     float* dst = output;
     
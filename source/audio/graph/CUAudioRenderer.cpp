@@ -0,0 +1,482 @@
+//
+//  CUAudioRenderer.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides an offline driver for the audio graph. Like an output
+//  device, it is the final node of an audio graph. But rather than being read
+//  by a device in real time, it reads its graph as fast as the CPU allows,
+//  storing the results in a buffer, a sample, or a file. This makes it
+//  possible to benchmark the cost per frame of a graph, to render stems, and
+//  to check the output of DSP nodes against a reference, all without an
+//  output device.
+//
+//  While rendering, the calling thread is treated as an audio thread. In
+//  addition, it is marked as offline, so that nodes which would normally drop
+//  data to meet a device deadline (such as a streaming AudioPlayer) wait for
+//  that data instead. Therefore, rendering the same graph twice produces the
+//  same output.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/audio/graph/CUAudioRenderer.h>
+#include <cugl/audio/CUAudioSample.h>
+#include <cugl/util/CUDebug.h>
+#include <cugl/util/CUTimestamp.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace cugl;
+using namespace cugl::audio;
+
+/** The size of a WAV header with a 16 byte format chunk */
+#define WAV_HEADER      44
+/** The WAV format tag for IEEE float samples */
+#define WAV_IEEE_FLOAT  3
+
+/**
+ * Returns true if the WAV header was written to the given stream
+ *
+ * The sizes in the header are for the given number of bytes of data.
+ *
+ * @param stream    The stream to write to
+ * @param channels  The number of audio channels
+ * @param rate      The sample rate (frequency) in HZ
+ * @param bytes     The size of the audio data in bytes
+ *
+ * @return true if the WAV header was written to the given stream
+ */
+static bool write_wav_header(SDL_RWops* stream, Uint8 channels, Uint32 rate, Uint32 bytes) {
+    size_t okay = 1;
+    okay &= SDL_RWwrite(stream, "RIFF", 4, 1);
+    okay &= SDL_WriteLE32(stream, WAV_HEADER-8+bytes);
+    okay &= SDL_RWwrite(stream, "WAVEfmt ", 8, 1);
+    okay &= SDL_WriteLE32(stream, 16);
+    okay &= SDL_WriteLE16(stream, WAV_IEEE_FLOAT);
+    okay &= SDL_WriteLE16(stream, channels);
+    okay &= SDL_WriteLE32(stream, rate);
+    okay &= SDL_WriteLE32(stream, rate*channels*sizeof(float));
+    okay &= SDL_WriteLE16(stream, channels*sizeof(float));
+    okay &= SDL_WriteLE16(stream, 8*sizeof(float));
+    okay &= SDL_RWwrite(stream, "data", 4, 1);
+    okay &= SDL_WriteLE32(stream, bytes);
+    return okay != 0;
+}
+
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates a degenerate audio renderer.
+ *
+ * The node has no channels, so read options will do nothing. The node must
+ * be initialized to be used.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a graph node on
+ * the heap, use one of the static constructors instead.
+ */
+AudioRenderer::AudioRenderer() : AudioNode(),
+_input(nullptr),
+_rendered(0),
+_rendtime(0) {
+    _classname = "AudioRenderer";
+}
+
+/**
+ * Initializes the node with default stereo settings
+ *
+ * The number of channels is two, for stereo output.  The sample rate is
+ * the modern standard of 48000 HZ.
+ *
+ * @return true if initialization was successful
+ */
+bool AudioRenderer::init() {
+    return init(DEFAULT_CHANNELS,DEFAULT_SAMPLING);
+}
+
+/**
+ * Initializes the node with the given number of channels and sample rate
+ *
+ * The read size is that of the {@link AudioEngine}, if it is active, and
+ * {@link AudioDevices#DEFAULT_READ_SIZE} otherwise.
+ *
+ * @param channels  The number of audio channels
+ * @param rate      The sample rate (frequency) in HZ
+ *
+ * @return true if initialization was successful
+ */
+bool AudioRenderer::init(Uint8 channels, Uint32 rate) {
+    return AudioNode::init(channels,rate);
+}
+
+/**
+ * Initializes the node with the given channels, sample rate and read size
+ *
+ * The read size is the number of frames pulled from the graph at a time.
+ * It should match that of the device the graph is written for, so that
+ * the graph behaves offline as it does in real time.
+ *
+ * @param channels  The number of audio channels
+ * @param rate      The sample rate (frequency) in HZ
+ * @param readsize  The number of frames to pull from the graph at a time
+ *
+ * @return true if initialization was successful
+ */
+bool AudioRenderer::init(Uint8 channels, Uint32 rate, Uint32 readsize) {
+    if (AudioNode::init(channels,rate)) {
+        _readsize = readsize;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Disposes any resources allocated for this renderer.
+ *
+ * The state of the node is reset to that of an uninitialized constructor.
+ * Unlike the destructor, this method allows the node to be reinitialized.
+ */
+void AudioRenderer::dispose() {
+    if (_booted) {
+        AudioNode::dispose();
+        _input = nullptr;
+        _rendered = 0;
+        _rendtime = 0;
+    }
+}
+
+#pragma mark -
+#pragma mark Audio Graph
+/**
+ * Attaches an audio graph to this renderer.
+ *
+ * This method will fail if the channels or sample rate of the audio node
+ * do not agree with this renderer. The read size of the node is set to
+ * that of this renderer.
+ *
+ * @param node  The terminal node of the audio graph
+ *
+ * @return true if the attachment was successful
+ */
+bool AudioRenderer::attach(const std::shared_ptr<AudioNode>& node) {
+    if (!_booted) {
+        CUAssertLog(_booted, "Cannot attach to an uninitialized audio renderer");
+        return false;
+    } else if (node == nullptr) {
+        detach();
+        return true;
+    } else if (node->getChannels() != _channels) {
+        CUAssertLog(false,"Terminal node of audio graph has wrong number of channels: %d",
+                    node->getChannels());
+        return false;
+    } else if (node->getRate() != _sampling) {
+        CUAssertLog(false,"Terminal node of audio graph has wrong sample rate: %d",
+                    node->getRate());
+        return false;
+    }
+
+    // Reset the read size if necessary
+    if (node->getReadSize() != _readsize) {
+        node->setReadSize(_readsize);
+    }
+
+    std::atomic_exchange_explicit(&_input,node,std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * Detaches an audio graph from this renderer.
+ *
+ * If the method succeeds, it returns the terminal node of the audio graph.
+ *
+ * @return  the terminal node of the audio graph (or null if failed)
+ */
+std::shared_ptr<AudioNode> AudioRenderer::detach() {
+    if (!_booted) {
+        CUAssertLog(_booted, "Cannot detach from an uninitialized audio renderer");
+        return nullptr;
+    }
+
+    std::shared_ptr<AudioNode> result = std::atomic_exchange_explicit(&_input,{},std::memory_order_relaxed);
+    return result;
+}
+
+/**
+ * Sets the typical read size of this node.
+ *
+ * For this node, the read size is the number of frames pulled from the
+ * graph at a time. The value is passed on to the attached graph.
+ *
+ * This method is not synchronized, and should never be called while
+ * the graph is rendering.
+ *
+ * @param size  The typical read size of this node.
+ */
+void AudioRenderer::setReadSize(Uint32 size) {
+    if (_readsize != size) {
+        _readsize = size;
+        std::shared_ptr<AudioNode> node = _input;
+        if (node != nullptr) {
+            node->setReadSize(size);
+        }
+    }
+}
+
+/**
+ * Returns true if this audio node has no more data.
+ *
+ * An audio node is typically completed if it return 0 (no frames read) on
+ * subsequent threads read. This node is completed if it has no input, or
+ * if its input is completed.
+ *
+ * @return true if this audio node has no more data.
+ */
+bool AudioRenderer::completed() {
+    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    return (input == nullptr || input->completed());
+}
+
+/**
+ * Reads up to the specified number of frames into the given buffer
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ * Use one of the render methods instead.
+ *
+ * The buffer should have enough room to store frames * channels elements.
+ * The channels are interleaved into the output buffer. This node is
+ * silent when paused or when it has no input.
+ *
+ * @param buffer    The read buffer to store the results
+ * @param frames    The maximum number of frames to read
+ *
+ * @return the actual number of frames read
+ */
+Uint32 AudioRenderer::read(float* buffer, Uint32 frames) {
+    ReadTimer timer(this);
+    std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_relaxed);
+    Uint32 take = 0;
+    if (input == nullptr || _paused.load(std::memory_order_relaxed)) {
+        std::memset(buffer,0,frames*_channels*sizeof(float));
+        take = frames;
+    } else {
+        take = input->read(buffer,frames);
+        // Only a completed graph may come up short
+        if (take < frames && !input->completed()) {
+            std::memset(buffer+take*_channels,0,(frames-take)*_channels*sizeof(float));
+            take = frames;
+        }
+    }
+    return take;
+}
+
+#pragma mark -
+#pragma mark Rendering
+/**
+ * Returns the number of frames rendered into the given buffer
+ *
+ * This is the implementation of the render methods. It marks the current
+ * thread as an offline audio thread for the duration of the read, and
+ * records the time spent reading.
+ *
+ * @param buffer    The buffer to store the results
+ * @param frames    The maximum number of frames to render
+ *
+ * @return the number of frames rendered into the given buffer
+ */
+Uint64 AudioRenderer::pull(float* buffer, Uint64 frames) {
+    if (!_booted || frames == 0) {
+        return 0;
+    }
+
+    bool audio = isAudioThread();
+    bool offline = isOffline();
+    setAudioThread(true);
+    setOffline(true);
+
+    Timestamp start;
+    Uint64 done = 0;
+    bool abort = false;
+    while (done < frames && !abort) {
+        Uint32 amt  = (Uint32)std::min((Uint64)_readsize,frames-done);
+        Uint32 take = read(buffer+done*_channels,amt);
+        done += take;
+        abort = take < amt;
+    }
+    Timestamp end;
+
+    setAudioThread(audio);
+    setOffline(offline);
+    _rendtime += Timestamp::ellapsedNanos(start,end);
+    _rendered += done;
+    return done;
+}
+
+/**
+ * Returns the number of frames rendered into the given buffer
+ *
+ * The buffer should have enough room to store frames * channels elements.
+ * The channels are interleaved into the buffer. The graph is pulled in
+ * blocks of {@link getReadSize} frames, and the rendering stops early if
+ * the graph completes. Any frames that a node does not produce before it
+ * completes are not written.
+ *
+ * @param buffer    The buffer to store the results
+ * @param frames    The maximum number of frames to render
+ *
+ * @return the number of frames rendered into the given buffer
+ */
+Uint64 AudioRenderer::render(float* buffer, Uint64 frames) {
+    return pull(buffer,frames);
+}
+
+/**
+ * Returns a newly allocated sample with the rendered audio graph
+ *
+ * The sample has the channels and sample rate of this renderer, and is
+ * the given number of frames long. If the graph completes early, the rest
+ * of the sample is silent. This method returns nullptr if the sample
+ * could not be allocated.
+ *
+ * @param frames    The number of frames to render
+ *
+ * @return a newly allocated sample with the rendered audio graph
+ */
+std::shared_ptr<AudioSample> AudioRenderer::renderSample(Uint64 frames) {
+    std::shared_ptr<AudioSample> result = AudioSample::alloc(_channels,_sampling,(Uint32)frames);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    pull(result->getBuffer(),frames);
+    return result;
+}
+
+/**
+ * Returns true if the audio graph was rendered to the given file
+ *
+ * The file is a WAV file of 32-bit float samples, with the channels and
+ * sample rate of this renderer. It has at most the given number of
+ * frames, as the rendering stops early if the graph completes. The path
+ * is used as is, so it should be an absolute path (or a path relative
+ * to the working directory).
+ *
+ * @param path      The file to write
+ * @param frames    The maximum number of frames to render
+ *
+ * @return true if the audio graph was rendered to the given file
+ */
+bool AudioRenderer::renderFile(const std::string& path, Uint64 frames) {
+    if (!_booted) {
+        CUAssertLog(_booted, "Cannot render from an uninitialized audio renderer");
+        return false;
+    }
+
+    // The sizes in a WAV header are 32 bits
+    Uint64 limit = (SDL_MAX_UINT32-WAV_HEADER)/(_channels*sizeof(float));
+    if (frames > limit) {
+        CULogError("Render of %llu frames is too long for a WAV file",(unsigned long long)frames);
+        frames = limit;
+    }
+
+    SDL_RWops* stream = SDL_RWFromFile(path.c_str(), "wb");
+    if (!stream) {
+        CULogError("Could not open '%s' for rendering",path.c_str());
+        return false;
+    }
+
+    // Write the header now and patch the sizes later
+    bool okay = write_wav_header(stream,_channels,_sampling,0);
+    std::vector<float> block(_readsize*_channels);
+    Uint64 done = 0;
+    bool abort = !okay;
+    while (done < frames && !abort) {
+        Uint32 amt  = (Uint32)std::min((Uint64)_readsize,frames-done);
+        Uint32 take = (Uint32)pull(block.data(),amt);
+        for(size_t ii = 0; ii < take*_channels; ii++) {
+            block[ii] = SDL_SwapFloatLE(block[ii]);
+        }
+        if (take && SDL_RWwrite(stream, block.data(), take*_channels*sizeof(float), 1) != 1) {
+            okay = false;
+        }
+        done += take;
+        abort = !okay || take < amt;
+    }
+
+    if (okay) {
+        okay = SDL_RWseek(stream, 0, RW_SEEK_SET) == 0;
+        okay = okay && write_wav_header(stream,_channels,_sampling,(Uint32)(done*_channels*sizeof(float)));
+    }
+    if (SDL_RWclose(stream) != 0) {
+        okay = false;
+    }
+    return okay;
+}
+
+#pragma mark -
+#pragma mark Timing
+/**
+ * Returns the average cost of a frame in nanoseconds
+ *
+ * This is the render time divided by the number of frames rendered. It
+ * is 0 if nothing has been rendered since the last timing reset. A graph
+ * can keep up with a device only if this value is less than the period
+ * of a frame (1e9 divided by the sample rate).
+ *
+ * @return the average cost of a frame in nanoseconds
+ */
+double AudioRenderer::getNanosPerFrame() const {
+    return _rendered ? (double)_rendtime/_rendered : 0.0;
+}
+
+/**
+ * Returns the ratio of real time to render time
+ *
+ * This is how many times faster than real time the graph renders. It is
+ * 0 if nothing has been rendered since the last timing reset.
+ *
+ * @return the ratio of real time to render time
+ */
+double AudioRenderer::getSpeedup() const {
+    if (_rendtime == 0) {
+        return 0.0;
+    }
+    return (_rendered*1e9)/((double)_sampling*_rendtime);
+}
+
+/**
+ * Resets the render timing statistics
+ */
+void AudioRenderer::resetTiming() {
+    _rendered = 0;
+    _rendtime = 0;
+}
@@ -104,6 +104,8 @@ static double bessel(double x, double err=1.0e-21) {
 #define BITS_PER_SAMPLE 16
 /** The default stoppband attenuation */
 #define STOPBAND_ATTEN  80.0
+/** The maximum number of phases to precompute for a rational rate ratio */
+#define POLYPHASE_LIMIT 512
 
 /**
  * Creates a degenerate audio resampler.
@@ -123,6 +125,10 @@ _per_crossing(0),
 _filter_size(0),
 _filter_table(nullptr),
 _filter_diffs(nullptr),
+_kernel(nullptr),
+_polytable(nullptr),
+_polyphases(0),
+_polystep(0),
 _capacity(0),
 _cvtavail(0),
 _cvtoffset(0.0),
@@ -212,6 +218,16 @@ void AudioResampler::dispose() {
             free(_cvtbuffer);
             _cvtbuffer = nullptr;
         }
+        if (_kernel != nullptr) {
+            free(_kernel);
+            _kernel = nullptr;
+        }
+        if (_polytable != nullptr) {
+            free(_polytable);
+            _polytable = nullptr;
+        }
+        _polyphases = 0;
+        _polystep   = 0;
         _input = nullptr;
         _capacity  = 0;
         _pagesize  = 0;
@@ -349,6 +365,7 @@ void AudioResampler::setInputRate(Uint32 value) {
     _cvtbuffer = (float*)malloc(sizeof(float)*_capacity*_channels);
     std::memset(_cvtbuffer, 0, sizeof(float)*_capacity*_channels);
     _cvtoffset = _capacity;
+    setupPolyphase();
 }
 
 /**
@@ -459,6 +476,7 @@ bool AudioResampler::completed() {
  * @return the actual number of frames read
  */
 Uint32 AudioResampler::read(float* buffer, Uint32 frames) {
+    ReadTimer timer(this);
     std::shared_ptr<AudioNode> input = std::atomic_load_explicit(&_input,std::memory_order_seq_cst);
     Uint32 inrate = _inputrate.load(std::memory_order_seq_cst);
 
@@ -760,6 +778,10 @@ void AudioResampler::setup() {
         free(_filter_diffs);
         _filter_diffs = nullptr;
     }
+    if (_kernel != nullptr) {
+        free(_kernel);
+        _kernel = nullptr;
+    }
 
     // Initialize the new filter
     _per_crossing = (1 << ((_bit_precision / 2) + 1));
@@ -790,6 +812,91 @@ void AudioResampler::setup() {
     
     // Need to ensure large enough convolution window.
     _pagesize = nextPOT((Uint32)_filter_size);
+    _kernel = (float*)malloc(sizeof(float)*2*_zero_cross);
+    setupPolyphase();
+}
+
+/**
+ * Sets up the polyphase table for the current input rate.
+ *
+ * If the ratio of the input rate to the output rate reduces to a fraction
+ * with a small denominator (such as 147/160 for 44.1k to 48k), then the
+ * output frames cycle through a fixed set of filter phases. In that case,
+ * this method precomputes the filter kernel for each phase, so that
+ * filtering a frame is a single dot product per channel. Otherwise, there
+ * is no table, and the kernel is computed for each frame.
+ *
+ * This table must be recomputed any time the filter or the input rate
+ * changes.
+ */
+void AudioResampler::setupPolyphase() {
+    if (_polytable != nullptr) {
+        free(_polytable);
+        _polytable = nullptr;
+    }
+    _polyphases = 0;
+    _polystep = 0;
+    
+    Uint32 inrate = _inputrate.load(std::memory_order_relaxed);
+    if (inrate == 0 || inrate == _sampling || _filter_table == nullptr) {
+        return;
+    }
+    
+    Uint32 common = inrate;
+    Uint32 other  = _sampling;
+    while (other != 0) {
+        Uint32 temp = common % other;
+        common = other;
+        other  = temp;
+    }
+    
+    Uint32 phases = _sampling/common;
+    if (phases > POLYPHASE_LIMIT) {
+        return;
+    }
+    
+    Uint32 width = 2*_zero_cross;
+    _polytable = (float*)malloc(sizeof(float)*phases*width);
+    for(Uint32 ii = 0; ii < phases; ii++) {
+        fillKernel(_polytable+ii*width, ii/(double)phases);
+    }
+    _polyphases = phases;
+    _polystep = inrate/common;
+}
+
+/**
+ * Computes the filter kernel for the given interpolation phase.
+ *
+ * The kernel has two taps per zero crossing. Tap 0 is applied to the
+ * frame immediately after the current offset into the sampling buffer.
+ * Taps outside of the filter window are 0.
+ *
+ * @param kernel    The array to store the kernel
+ * @param interp0   The fractional part of the offset into the buffer
+ */
+void AudioResampler::fillKernel(float* kernel, double interp0) {
+    Uint32 zerocross = _zero_cross.load(std::memory_order_relaxed);
+    std::memset(kernel, 0, sizeof(float)*2*zerocross);
+
+    double interp1 = 1.0 - interp0;
+    Uint32 filterindex0 = (Uint32)(interp0 * _per_crossing);
+    Uint32 filterindex1 = (Uint32)(interp1 * _per_crossing);
+    
+    Uint32 leftbound = (Uint32)((_filter_size-filterindex0)/(double)_per_crossing);
+    Uint32 rghtbound = (Uint32)((_filter_size-filterindex1)/(double)_per_crossing);
+    
+    // The midpoint of the window is tap zerocross
+    Uint32 leftindex = filterindex0 + ((leftbound-1) * _per_crossing);
+    for(Uint32 tap = zerocross-leftbound; tap < zerocross; tap++) {
+        kernel[tap] = _filter_table[leftindex] + interp0 * _filter_diffs[leftindex];
+        leftindex -= _per_crossing;
+    }
+    
+    Uint32 rightindex = filterindex1;
+    for(Uint32 tap = zerocross; tap < zerocross+rghtbound; tap++) {
+        kernel[tap] = _filter_table[rightindex] + interp1 * _filter_diffs[rightindex];
+        rightindex += _per_crossing;
+    }
 }
 
 /**
@@ -799,6 +906,10 @@ void AudioResampler::setup() {
  * stores the results in buffer (in order by channel). The current audio frame
  * is determined by the _cvtoffset value.
  *
+ * The kernel is taken from the polyphase table when there is one for the
+ * input rate. Otherwise it is computed once for the frame, and shared by
+ * all of the channels.
+ *
  * The additional parameters passed to this method are to ensure thread safety.
  * For example, inrate is the input sampling rate at the time of the buffer
  * computation, and not necessarily the current input rate.
@@ -809,6 +920,31 @@ void AudioResampler::setup() {
  */
 void AudioResampler::filter(float* buffer, double inrate, Uint32 limit) {
     Uint32 index = (Uint32)_cvtoffset;
+    Uint32 width = 2*_zero_cross.load(std::memory_order_relaxed);
+
+    // Use a precomputed kernel if the table matches this input rate
+    if (_polyphases && (Uint64)_polystep*_sampling == (Uint64)inrate*_polyphases) {
+        Uint64 position = (Uint64)std::llround(_cvtoffset*_polyphases);
+        Uint32 start = (Uint32)(position/_polyphases)+1;
+        if (start+width <= limit) {
+            float* kernel = _polytable+(position % _polyphases)*width;
+            for(Uint32 chan = 0; chan < _channels; chan++) {
+                buffer[chan] = dsp::DSPMath::dot(_cvtbuffer+start*_channels+chan,_channels,kernel,width);
+            }
+            // Advance exactly to prevent drift
+            _cvtoffset = (double)(position+_polystep)/_polyphases;
+            return;
+        }
+    } else if (index+1+width <= limit) {
+        fillKernel(_kernel, _cvtoffset-index);
+        for(Uint32 chan = 0; chan < _channels; chan++) {
+            buffer[chan] = dsp::DSPMath::dot(_cvtbuffer+(index+1)*_channels+chan,_channels,_kernel,width);
+        }
+        _cvtoffset += inrate/_sampling;
+        return;
+    }
+    
+    // The window is clipped at the end of the buffer
     double currtime =  index / inrate;
     double nexttime = (index + 1) / inrate;
     index += _zero_cross;
@@ -603,6 +603,7 @@ void AudioScheduler::setReadSize(Uint32 size) {
  * @return the actual number of frames read
  */
 Uint32 AudioScheduler::read(float* buffer, Uint32 frames) {
+    ReadTimer timer(this);
     if (_paused.load(std::memory_order_relaxed)) {
         std::memset(buffer,0,frames*sizeof(float)*_channels);
         return frames;
@@ -624,7 +625,7 @@ Uint32 AudioScheduler::read(float* buffer, Uint32 frames) {
             float* output = buffer+amt*_channels;
             float* input  = _buffer;
             
-            Sint64 remain = previous->getRemaining()*_sampling;
+            Sint64 remain = (Sint64)std::llround(previous->getRemaining()*_sampling);
             Uint32 goal = std::min((Uint32)std::max(remain,(Sint64)0),need);
             Uint32 real = current->read(output,goal);
             goal = previous->read(input,real);
@@ -663,15 +664,22 @@ Uint32 AudioScheduler::read(float* buffer, Uint32 frames) {
             }
         } else if (overlap > 0 && loop == 0 && _qsize.load(std::memory_order_acquire)) {
             // Check whether we need to overlap
-            Sint64 remain = current->getRemaining()*_sampling;
+            Sint64 remain = (Sint64)std::llround(current->getRemaining()*_sampling);
             if (remain >= 0 && remain-overlap <= need) {
                 if (remain > overlap) {
                     amt += current->read(&(buffer[amt*_channels]),(Uint32)(remain-overlap));
                 }
                 _previous = current;
                 previous = _previous;
+                
+                // Pop without notifying, as the previous node is still playing
                 _queue.pop(_current,loop);
+                _qsize.store(_qsize.load(std::memory_order_acquire)-1,std::memory_order_release);
+                _loops.store(loop,std::memory_order_relaxed);
                 current = _current;
+                if (current->getReadSize() != _readsize) {
+                    current->setReadSize(_readsize);
+                }
             } else {
                 amt += current->read(&(buffer[amt*_channels]),need);
                 if (amt < frames || current->completed()) {
@@ -33,9 +33,13 @@
 #include <cugl/base/CUApplication.h>
 #include <cugl/base/CUDisplay.h>
 #include <cugl/render/CUTexture.h>
+#include <cugl/render/CURenderState.h>
 #include <cugl/input/CUInput.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUProfiler.h>
+#include <cugl/util/CULogger.h>
 #include <algorithm>
+#include <cstring>
 #include <vector>
 
 /** The default screen width */
@@ -44,6 +48,12 @@
 #define DEFAULT_HEIGHT  576
 /** The default smoothing window for fps calculation */
 #define FPS_WINDOW      10
+/** The initial capacity of the queue for callbacks with no delay */
+#define IMMEDIATE_QUEUE 256
+/** The mask for a single slot in the timer wheel */
+#define TIMER_MASK      ((1 << CU_TIMER_BITS)-1)
+/** The default time budget (in microseconds) for deferred jobs each frame */
+#define DEFAULT_BUDGET  2000
 
 using namespace cugl;
 
@@ -70,11 +80,19 @@ _highdpi(true),
 _fps(0),
 _vsync(true),
 _funcid(0),
+_immediate(IMMEDIATE_QUEUE,OverflowPolicy::GROW),
+_wheelsize(0),
+_clock(0),
+_jobsDirty(false),
+_jobcursor(0),
+_budget(DEFAULT_BUDGET),
+_arenaIndex(0),
 _updateCounter(0),
 _leftover(0),
 _clearColor(Color4f::CORNFLOWER) // Ah, XNA
 {
     _display.size.set(DEFAULT_WIDTH,DEFAULT_HEIGHT);
+    std::memset(_wheel, 0, sizeof(_wheel));
 #if (CU_PLATFORM == CU_PLATFORM_IPHONE || CU_PLATFORM == CU_PLATFORM_ANDROID)
     _fullscreen = true;
 #endif
@@ -84,6 +102,10 @@ _clearColor(Color4f::CORNFLOWER) // Ah, XNA
 #else
 	_multisamp = false;
 #endif
+    _headless = false;
+    _unthrottled = false;
+    _startupReport = false;
+    _asyncLog = false;
 }
 
 /**
@@ -98,6 +120,10 @@ void Application::dispose() {
     _display.set(0,0,DEFAULT_WIDTH,DEFAULT_HEIGHT);
     _fullscreen = false;
     _highdpi = true;
+    _headless = false;
+    _unthrottled = false;
+    _startupReport = false;
+    _asyncLog = false;
     _fpswindow.clear();
     _clearColor = Color4f::CORNFLOWER;
     setFPS(60.0f);
@@ -108,7 +134,8 @@ void Application::dispose() {
  *
  * The initialization will use the current value of all of the attributes,
  * like application name, orientation, and size.  These values should be
- * set before calling init().
+ * set before calling init(). A headless application (see {@link #setHeadless})
+ * creates neither a window nor an OpenGL context.
  *
  * You should not override this method to initialize user-defined attributes.
  * Use the method onStartup() instead.
@@ -117,39 +144,60 @@ void Application::dispose() {
  */
 bool Application::init() {
     _state = State::STARTUP;
-
-
-    // Initializate the video
-    Uint32 flags = Display::INIT_CENTERED;
-    if (_fullscreen) {
-        flags |= Display::INIT_FULLSCREEN;
-    }
-    if (_highdpi) {
-        flags |= Display::INIT_HIGH_DPI;
+    Profiler::setThreadName("Main");
+    if (_asyncLog) {
+        Logger::start();
     }
-    if (_multisamp) {
-        flags |= Display::INIT_MULTISAMPLED;
+    if (_startupReport) {
+        Profiler::start();
     }
-    if (!Display::start(_name,_display, flags)) {
-        return false;
-    }
-    if (_fullscreen) {
-        _display = Display::get()->getBounds();
-        _safearea = Display::get()->getSafeBounds();
-    } else {
+    CU_PROFILE_SCOPE("Application::init");
+
+    if (_headless) {
+        // No window, OpenGL, or audio; only timers and events
+        if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS) < 0) {
+            CULogError("Could not initialize SDL: %s",SDL_GetError());
+            return false;
+        }
         _safearea = _display;
-    }
-    
-    SDL_DisplayMode mode;
-    SDL_GetDisplayMode(0, 0, &mode);
-    if (_fps == 0) {
-        setFPS(mode.refresh_rate > 0 ? mode.refresh_rate : 60.0f);
+        if (_fps == 0) {
+            setFPS(1.0f/(FIXED_TIMESTEP_S));
+        }
+    } else {
+        // Initializate the video
+        Uint32 flags = Display::INIT_CENTERED;
+        if (_fullscreen) {
+            flags |= Display::INIT_FULLSCREEN;
+        }
+        if (_highdpi) {
+            flags |= Display::INIT_HIGH_DPI;
+        }
+        if (_multisamp) {
+            flags |= Display::INIT_MULTISAMPLED;
+        }
+        if (!Display::start(_name,_display, flags)) {
+            return false;
+        }
+        if (_fullscreen) {
+            _display = Display::get()->getBounds();
+            _safearea = Display::get()->getSafeBounds();
+        } else {
+            _safearea = _display;
+        }
+
+        SDL_DisplayMode mode;
+        SDL_GetDisplayMode(0, 0, &mode);
+        if (_fps == 0) {
+            setFPS(mode.refresh_rate > 0 ? mode.refresh_rate : 60.0f);
+        }
+        SDL_GL_SetSwapInterval(_vsync ? 1 : 0);
     }
     
     _fpswindow.resize(FPS_WINDOW,1.0f/_fps);
-    SDL_GL_SetSwapInterval(_vsync ? 1 : 0);
     Input::start();
-    Texture::getBlank(); // Prevent this from happening in loading threads
+    if (!_headless) {
+        Texture::getBlank(); // Prevent this from happening in loading threads
+    }
     Application::_theapp = this;
     _boot.mark();
     _state = State::STARTUP;
@@ -172,10 +220,28 @@ bool Application::init() {
  * When overriding this method, you should call the parent method as the
  * very last line.  This ensures that the state will transition to FOREGROUND,
  * causing the application to run.
+ *
+ * If the startup report is enabled (see {@link #setStartupReport}), the
+ * parent method ends the startup capture and logs its report.
  */
 void Application::onStartup() {
     // Switch states and show to user
-    Display::get()->show();
+    if (!_headless) {
+        Display::get()->show();
+    }
+    if (_startupReport && Profiler::isActive()) {
+        Profiler::record("Application::startup",0,Profiler::now());
+        Profiler::stop();
+        // Log line by line, as SDL truncates long messages
+        std::string report = Profiler::getReport();
+        size_t pos = 0;
+        while (pos < report.size()) {
+            size_t next = report.find('\n',pos);
+            next = (next == std::string::npos ? report.size() : next);
+            CULog("%s",report.substr(pos,next-pos).c_str());
+            pos = next+1;
+        }
+    }
     _state = State::FOREGROUND;
     _start.mark();
 }
@@ -194,6 +260,10 @@ void Application::onStartup() {
 void Application::onShutdown() {
     // Switch states
     Input::stop();
+    Logger::stop();
+    if (_headless) {
+        SDL_Quit();
+    }
     _state = State::NONE;
 }
 
@@ -254,6 +324,8 @@ bool Application::getInput() {
         }
     }
     
+    // Dispatch any coalesced input
+    Input::get()->flush();
     return true;
 }
 
@@ -263,10 +335,21 @@ bool Application::getInput() {
  *
  * This method processes the input, calls the update method, and then
  * draws it.  It also updates any running statics, like the average FPS.
+ * Any deferred jobs (see {@link #defer}) are run between the update and
+ * the draw. The frame arenas are swapped at the start of the frame (see
+ * {@link #getFrameArena}).
+ *
+ * A headless application (see {@link #setHeadless}) skips the draw. An
+ * unthrottled application (see {@link #setUnthrottled}) advances exactly
+ * one fixed time step and does not sleep.
  *
  * @return false if the application should quit next frame
  */
 bool Application::step() {
+    // Transient data from two frames ago is no longer needed
+    _arenaIndex = 1-_arenaIndex;
+    _arenas[_arenaIndex].reset();
+    
     // Get input before doing the next time
     bool running = getInput();
 
@@ -275,15 +358,20 @@ bool Application::step() {
     Uint32 micros = (Uint32)poststep.ellapsedMicros(_start);
     _start.mark();
     if (running &&  _state == State::FOREGROUND) {
-        processCallbacks((micros)/1000);
-
         _fpswindow.pop_front();
-        _fpswindow.push_back(1000000.0f/micros);
+        _fpswindow.push_back(1000000.0f/std::max(micros,(Uint32)1));
+
+        // Simulate exactly one time step, no matter the wall clock
+        if (_unthrottled) {
+            micros = (Uint32)(FIXED_TIMESTEP);
+        }
+        processCallbacks((micros)/1000);
 
         Uint32 updateMicros = micros + _leftover;
 
         #if USING_PHYSICS
-
+        {
+            CU_PROFILE_SCOPE("Application::update");
             preUpdate(micros / 1000000.0f);
 
             for (; updateMicros >= FIXED_TIMESTEP; updateMicros -= FIXED_TIMESTEP) {
@@ -291,18 +379,27 @@ bool Application::step() {
                 _updateCounter++;
             }
             _leftover = updateMicros;
+            _lastUpdateTime = _start;
 
             postUpdate(micros / 1000000.0f);
+        }
         #else
-			update(micros / 1000000.0f);
+        {
+            CU_PROFILE_SCOPE("Application::update");
+            update(micros / 1000000.0f);
+        }
         #endif
+        processJobs();
 
-        glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
-        glStencilMask(0xffffffff);
-        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        if (!_headless) {
+            CU_PROFILE_SCOPE("Application::draw");
+            glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, _clearColor.a);
+            renderstate::stencilMask(0xffffffff);
+            glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-        draw();
-        Display::get()->refresh();
+            draw();
+            Display::get()->refresh();
+        }
         Timestamp lastSwap;
     } else {
         running = _state == State::BACKGROUND;
@@ -311,7 +408,7 @@ bool Application::step() {
 	// Sleep the remainder
     poststep.mark();
     Uint32 millis = (Uint32)poststep.ellapsedMillis(_finish)+1;
-    if (millis < _delay) {
+    if (!_unthrottled && millis < _delay) {
 		SDL_Delay(_delay - millis);
 	}
     
@@ -319,6 +416,35 @@ bool Application::step() {
     return running;
 }
 
+/**
+ * Returns the (fractional) update count at the given time.
+ *
+ * Input events are timestamped when SDL receives them, which is usually
+ * in the middle of a fixed time step. This method maps such a timestamp
+ * onto the clock of {@link #getUpdateCount}, so that the integer part is
+ * the fixed update the event happened in and the fractional part is how
+ * far into that step it happened. Events received since the last frame
+ * map past the current update count.
+ *
+ * The mapping is only meaningful for a throttled application, as an
+ * unthrottled one (see {@link #setUnthrottled}) does not follow the wall
+ * clock.
+ *
+ * @param stamp The time to convert
+ *
+ * @return the (fractional) update count at the given time.
+ */
+double Application::getUpdateCountAt(const Timestamp& stamp) const {
+    // The leftover is the time simulated past the last fixed update
+    double micros = (double)_leftover;
+    if (_lastUpdateTime < stamp) {
+        micros += (double)stamp.ellapsedMicros(_lastUpdateTime);
+    } else {
+        micros -= (double)_lastUpdateTime.ellapsedMicros(stamp);
+    }
+    return (double)_updateCounter+micros/(double)(FIXED_TIMESTEP);
+}
+
 /**
  * Cleanly shuts down the application.
  *
@@ -364,15 +490,7 @@ void Application::quit() {
  * @return a unique identifier to unschedule the callback
  */
 Uint32 Application::schedule(std::function<bool()> callback, Uint32 time) {
-    scheduable item;
-    item.callback = callback;
-    item.period = time;
-    item.timer  = time;
-	{
-		std::unique_lock<std::mutex> lk(_queueMutex);
-		_callbacks.emplace(_funcid++, item);
-	}
-    return _funcid-1;
+    return schedule(callback, time, time);
 }
 
 /**
@@ -403,15 +521,30 @@ Uint32 Application::schedule(std::function<bool()> callback, Uint32 time) {
  * @return a unique identifier to unschedule the callback
  */
 Uint32 Application::schedule(std::function<bool()> callback, Uint32 time, Uint32 period) {
-    scheduable item;
-    item.callback = callback;
-    item.period = period;
-    item.timer  = time;
-	{
-		std::unique_lock<std::mutex> lk(_queueMutex);
-		_callbacks.emplace(_funcid++, item);
-	}
-    return _funcid-1;
+    std::unique_ptr<Timer> timer = std::make_unique<Timer>();
+    timer->id = _funcid.fetch_add(1);
+    timer->callback = std::move(callback);
+    timer->period = period;
+    timer->expire = 0;
+    timer->wheeled = false;
+    timer->repeat  = false;
+    timer->cancelled = false;
+    timer->slot = nullptr;
+    timer->prev = nullptr;
+    timer->next = nullptr;
+    
+    Uint32 id = timer->id;
+    if (time == 0) {
+        // Run next frame without contending with the main thread
+        _immediate.push(std::move(timer));
+        return id;
+    }
+    
+    std::unique_lock<std::mutex> lk(_queueMutex);
+    timer->expire = _clock+time+1;
+    insertTimer(timer.get());
+    _callbacks.emplace(id, std::move(timer));
+    return id;
 }
 
 /**
@@ -428,8 +561,19 @@ Uint32 Application::schedule(std::function<bool()> callback, Uint32 time, Uint32
 void Application::unschedule(Uint32 id) {
 	std::unique_lock<std::mutex> lk(_queueMutex);
     auto it = _callbacks.find(id);
-    if (it != _callbacks.end()) {
+    if (it == _callbacks.end()) {
+        // It may still be in the immediate queue
+        _cancelled.push_back(id);
+        return;
+    }
+    
+    Timer* timer = it->second.get();
+    if (timer->wheeled) {
+        removeTimer(timer);
         _callbacks.erase(it);
+    } else {
+        // Running or every frame; main thread will clean it up
+        timer->cancelled = true;
     }
 }
 
@@ -440,42 +584,298 @@ void Application::unschedule(Uint32 id) {
  * If they are a one time callback, or if they return false, they are deleted.  
  * If they are a reoccuring callback and return true, the timer is reset.
  *
+ * The cost of this method only depends on the callbacks that are due,
+ * and not on the total number of callbacks.
+ *
  * @param millis    The number of milliseconds since last called
  */
 void Application::processCallbacks(Uint32 millis) {
-	std::vector<Uint32> indeces;
-	std::vector<scheduable> actives;
 	{
 		std::unique_lock<std::mutex> lk(_queueMutex);
-		for (auto it = _callbacks.begin(); it != _callbacks.end(); ++it) {
-			if (it->second.timer < millis) {
-				indeces.push_back(it->first);
-				actives.push_back(it->second);
-				it->second.timer -= std::min(it->second.timer, millis);
-				it->second.timer += it->second.period;
-			} else {
-				it->second.timer -= millis;
-			}
-		}
+        std::unique_ptr<Timer> timer;
+        while (_immediate.pop(timer)) {
+            _active.push_back(timer.get());
+            _callbacks.emplace(timer->id, std::move(timer));
+        }
+        
+        // Resolve any identifiers unscheduled while in the queue
+        for(auto it = _cancelled.begin(); it != _cancelled.end(); ) {
+            auto jt = _callbacks.find(*it);
+            if (jt != _callbacks.end()) {
+                jt->second->cancelled = true;
+                it = _cancelled.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (_immediate.empty()) {
+            _cancelled.clear();
+        }
+        
+        _active.insert(_active.end(), _everyframe.begin(), _everyframe.end());
+        _everyframe.clear();
+        advanceTimers(millis);
 	}
 
 	// These can take a while, so do them outside lock
-	for (int ii = 0; ii < actives.size(); ii++) {
-		if (actives[ii].callback()) {
-			indeces[ii] = (Uint32)-1;
-		}
+	for (auto it = _active.begin(); it != _active.end(); ++it) {
+        Timer* timer = *it;
+        timer->repeat = !timer->cancelled && timer->callback();
 	}
 
 	{
 		std::unique_lock<std::mutex> lk(_queueMutex);
-		for (auto it = indeces.begin(); it != indeces.end(); ++it) {
-			if (*it != (Uint32)-1) {
-				_callbacks.erase(*it);
-			}
+		for (auto it = _active.begin(); it != _active.end(); ++it) {
+            Timer* timer = *it;
+            if (!timer->repeat || timer->cancelled) {
+                _callbacks.erase(timer->id);
+            } else if (timer->period == 0) {
+                _everyframe.push_back(timer);
+            } else {
+                timer->expire = _clock+timer->period+1;
+                insertTimer(timer);
+            }
 		}
+        _active.clear();
 	}
 }
 
+/**
+ * Adds a timer to the timer wheel.
+ *
+ * The slot is chosen from the time remaining until the timer expires.
+ * The queue mutex must be held.
+ *
+ * @param timer     The timer to add
+ */
+void Application::insertTimer(Timer* timer) {
+    Uint64 delta = timer->expire > _clock ? timer->expire-_clock : 0;
+    int level = 0;
+    while (level < CU_TIMER_LEVELS-1 && delta >= ((Uint64)1 << ((level+1)*CU_TIMER_BITS))) {
+        level++;
+    }
+    
+    Uint64 expire = std::max(timer->expire,_clock);
+    Timer** slot = &_wheel[level][(expire >> (level*CU_TIMER_BITS)) & TIMER_MASK];
+    timer->slot = slot;
+    timer->prev = nullptr;
+    timer->next = *slot;
+    if (*slot != nullptr) {
+        (*slot)->prev = timer;
+    }
+    *slot = timer;
+    timer->wheeled = true;
+    _wheelsize++;
+}
+
+/**
+ * Removes a timer from the timer wheel.
+ *
+ * The queue mutex must be held.
+ *
+ * @param timer     The timer to remove
+ */
+void Application::removeTimer(Timer* timer) {
+    if (timer->prev != nullptr) {
+        timer->prev->next = timer->next;
+    } else {
+        *(timer->slot) = timer->next;
+    }
+    if (timer->next != nullptr) {
+        timer->next->prev = timer->prev;
+    }
+    timer->slot = nullptr;
+    timer->prev = nullptr;
+    timer->next = nullptr;
+    timer->wheeled = false;
+    _wheelsize--;
+}
+
+/**
+ * Advances the timer wheel by the given number of milliseconds.
+ *
+ * Any timers that expire are removed from the wheel and added to the
+ * active callbacks. The queue mutex must be held.
+ *
+ * @param millis    The number of milliseconds to advance
+ */
+void Application::advanceTimers(Uint32 millis) {
+    for(Uint32 ii = 0; ii < millis; ii++) {
+        if (_wheelsize == 0) {
+            _clock += millis-ii;
+            return;
+        }
+        
+        Uint64 now = ++_clock;
+        // Move timers down a level whenever the level below wraps around
+        for(int level = 1; level < CU_TIMER_LEVELS; level++) {
+            if (now & (((Uint64)1 << (level*CU_TIMER_BITS))-1)) {
+                break;
+            }
+            Timer** slot = &_wheel[level][(now >> (level*CU_TIMER_BITS)) & TIMER_MASK];
+            Timer* timer = *slot;
+            *slot = nullptr;
+            while (timer != nullptr) {
+                Timer* next = timer->next;
+                timer->wheeled = false;
+                _wheelsize--;
+                insertTimer(timer);
+                timer = next;
+            }
+        }
+        
+        Timer** slot = &_wheel[0][now & TIMER_MASK];
+        while (*slot != nullptr) {
+            Timer* timer = *slot;
+            removeTimer(timer);
+            _active.push_back(timer);
+        }
+    }
+}
+
+
+#pragma mark -
+#pragma mark Deferred Work
+/**
+ * Adds a job to be time-sliced across animation frames.
+ *
+ * A deferred job is for incremental work that should never use more
+ * than a small part of an animation frame, like building large assets.
+ * Each animation frame, after {@link update} but before {@link draw},
+ * the application calls its jobs round-robin until the frame budget is
+ * exhausted (see {@link #setFrameBudget}). The budget is also limited by
+ * the time remaining in the frame at the target FPS. However, at least
+ * one job is called every frame, so that the jobs make progress even
+ * when the application is behind.
+ *
+ * The job is called with the number of microseconds left in its budget
+ * (which may be 0). It should do a small amount of work each call, and
+ * return false once it is finished. Otherwise it will be called again,
+ * either later this frame or in a future frame.
+ *
+ * This method may be called from any thread, but the job is always
+ * executed in the main thread.
+ *
+ * @param job   The job function
+ *
+ * @return a unique identifier to cancel the job
+ */
+Uint32 Application::defer(std::function<bool(Uint64 micros)> job) {
+    Job item;
+    item.id = _funcid.fetch_add(1);
+    item.work = std::move(job);
+    Uint32 id = item.id;
+    {
+        std::unique_lock<std::mutex> lk(_jobMutex);
+        _newjobs.push_back(std::move(item));
+        _jobsDirty = true;
+    }
+    return id;
+}
+
+/**
+ * Stops a deferred job from being executed.
+ *
+ * The job is identified by the unique identifier returned by
+ * {@link #defer}. A job that has already finished is ignored.
+ *
+ * @param id    The job identifier
+ */
+void Application::cancelDeferred(Uint32 id) {
+    std::unique_lock<std::mutex> lk(_jobMutex);
+    _canceljobs.push_back(id);
+    _jobsDirty = true;
+}
+
+/**
+ * Returns the time remaining in the current animation frame.
+ *
+ * This value is measured in microseconds from the start of the frame,
+ * using the target FPS (see {@link #setFPS}). It is 0 if the frame has
+ * already taken longer than the target.
+ *
+ * @return the time remaining in the current animation frame.
+ */
+Uint64 Application::getFrameRemaining() const {
+    Uint64 target = _fps > 0 ? (Uint64)(1000000.0f/_fps) : 0;
+    Timestamp now;
+    Uint64 elapsed = now.ellapsedMicros(_start);
+    return elapsed < target ? target-elapsed : 0;
+}
+
+/**
+ * Adds any new jobs, and removes any cancelled ones.
+ *
+ * This method may only be called by the main thread.
+ */
+void Application::updateJobs() {
+    std::unique_lock<std::mutex> lk(_jobMutex);
+    for(auto it = _newjobs.begin(); it != _newjobs.end(); ++it) {
+        _jobs.push_back(std::move(*it));
+    }
+    _newjobs.clear();
+    
+    for(auto it = _canceljobs.begin(); it != _canceljobs.end(); ++it) {
+        Uint32 id = *it;
+        auto jt = std::find_if(_jobs.begin(), _jobs.end(),
+                               [id](const Job& job) { return job.id == id; });
+        if (jt != _jobs.end()) {
+            size_t pos = jt-_jobs.begin();
+            _jobs.erase(jt);
+            if (pos < _jobcursor) {
+                _jobcursor--;
+            }
+        }
+    }
+    _canceljobs.clear();
+    _jobsDirty = false;
+}
+
+/**
+ * Runs the deferred jobs for the current animation frame.
+ *
+ * The jobs are run round-robin until the frame budget (or the
+ * remaining frame time) is exhausted. At least one job is run each
+ * frame, so that the jobs always make progress.
+ */
+void Application::processJobs() {
+    CU_PROFILE_SCOPE("Application::processJobs");
+    if (_jobsDirty) {
+        updateJobs();
+    }
+    if (_jobs.empty()) {
+        return;
+    }
+    
+    Timestamp start;
+    Uint64 limit = std::min((Uint64)_budget, getFrameRemaining());
+    bool first = true;
+    while (!_jobs.empty()) {
+        Uint64 used = Timestamp().ellapsedMicros(start);
+        if (!first && used >= limit) {
+            break;
+        }
+        first = false;
+        
+        if (_jobcursor >= _jobs.size()) {
+            _jobcursor = 0;
+        }
+        // Copy the identifier, as the job may cancel itself
+        Uint32 id = _jobs[_jobcursor].id;
+        bool more = _jobs[_jobcursor].work(used < limit ? limit-used : 0);
+        if (_jobsDirty) {
+            updateJobs();
+        }
+        if (_jobcursor < _jobs.size() && _jobs[_jobcursor].id == id) {
+            if (more) {
+                _jobcursor++;
+            } else {
+                _jobs.erase(_jobs.begin()+_jobcursor);
+            }
+        }
+    }
+}
+
 
 #pragma mark -
 #pragma mark Initialization Attributes
@@ -561,6 +961,31 @@ void Application::setMultiSampled(bool flag) {
 	_multisamp = flag;
 }
 
+/**
+ * Sets whether this application runs headless.
+ *
+ * A headless application has no window, OpenGL context, or fonts. Only
+ * the SDL timer and event subsystems are initialized. The animation loop
+ * still gathers input, processes callbacks and deferred jobs, and calls
+ * the update methods, but it never clears the screen or calls draw().
+ * This is useful for dedicated servers (which can still use the network
+ * layer) and for benchmarks on machines without a GPU.
+ *
+ * Unless the FPS is set explicitly, a headless application runs at the
+ * rate of the fixed time step, so every frame is one fixedUpdate(). See
+ * {@link #setUnthrottled} to run the simulation as fast as possible.
+ *
+ * This method may only be safely called before the application is
+ * initialized.  Once the application is initialized; this value may not
+ * be changed.
+ *
+ * @param value Whether this application runs headless
+ */
+void Application::setHeadless(bool value) {
+    CUAssertLog(_state == State::NONE, "Cannot reset application display after initialization");
+    _headless = value;
+}
+
 
 #pragma mark -
 #pragma mark Runtime Attributes
@@ -657,7 +1082,7 @@ void Application::setOrganization(const std::string name) {
  */
 void Application::setVSync(bool vsync) {
     _vsync = vsync;
-    if (_state != State::NONE) {
+    if (_state != State::NONE && !_headless) {
         SDL_GL_SetSwapInterval(_vsync ? 1 : 0);
     }
 }
@@ -707,9 +1132,15 @@ float Application::getAverageFPS() const {
 /**
  * Returns the OpenGL description for this application
  *
+ * A headless application has no OpenGL context, so this method returns
+ * the empty string in that case.
+ *
  * @return the OpenGL description for this application
  */
 const std::string Application::getOpenGLDescription() const {
+    if (_headless) {
+        return "";
+    }
     const char* glinfo = (const char*)glGetString(GL_VERSION);
     return std::string(glinfo);
 }
@@ -36,6 +36,7 @@
 //  Version: 12/12/18
 #include <cugl/base/CUBase.h>
 #include <cugl/render/CURenderBase.h>
+#include <cugl/render/CURenderState.h>
 #include <cugl/base/CUDisplay.h>
 #include <cugl/util/CUDebug.h>
 #include <SDL_ttf.h>
@@ -206,7 +207,7 @@ bool Display::init(std::string title, Rect bounds, Uint32 flags) {
 
 // The mobile devices have viewport problems
 #if CU_PLATFORM == CU_PLATFORM_ANDROID || CU_PLATFORM == CU_PLATFORM_IPHONE
-    glViewport(0, 0, (int)_bounds.size.width, (int)_bounds.size.height);
+    renderstate::viewport(0, 0, (int)_bounds.size.width, (int)_bounds.size.height);
 #endif
 
     _initialOrientation = translateOrientation(SDL_GetDisplayOrientation(_display));
@@ -388,8 +389,8 @@ bool Display::removeOrientationListener() {
  * on iOS).
  */
 void Display::restoreRenderTarget() {
-    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
-    glBindRenderbuffer(GL_RENDERBUFFER, _rendbuffer);
+    renderstate::bindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    renderstate::bindRenderbuffer(_rendbuffer);
 }
 
 /**
@@ -487,6 +488,8 @@ bool Display::initOpenGL(bool multisample) {
     }
 #endif
 
+    // The state cache knows nothing about a new context
+    renderstate::invalidate();
     queryRenderTarget();
     return true;
 }
@@ -183,6 +183,21 @@ bool Input::update(SDL_Event event) {
     return result;
 }
 
+/**
+ * Finishes the input phase of the current animation frame
+ *
+ * All {@link InputDevice} objects have a method {@link InputDevice#flushState()}
+ * that dispatches any events deferred during the input phase. This method
+ * (which should only be called by the {@link Application} class) invokes
+ * this method for all active devices, after all events have been
+ * processed by {@link update}.
+ */
+void Input::flush() {
+    for(auto it = _devices.begin(); it != _devices.end(); ++it) {
+        it->second->flushState();
+    }
+}
+
 #pragma mark -
 #pragma mark Internal Helpers
 /**
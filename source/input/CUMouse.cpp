@@ -44,6 +44,52 @@ void Mouse::dispose() {
     _dragListeners.clear();
     _moveListeners.clear();
     _wheelListeners.clear();
+    _history.clear();
+    _pending = false;
+    _coalesce = false;
+    _recordHistory = false;
+}
+
+#pragma mark -
+#pragma mark Coalescing
+/**
+ * Sets whether this device coalesces motion events
+ *
+ * SDL can report many motion events in a single animation frame, which
+ * is particularly common with high polling rate mice. When coalescing is
+ * on, this device dispatches at most one drag or motion event per frame.
+ * The event has the last position of the frame, and its previous position
+ * is the position before the first motion event of the frame. Motion is
+ * always dispatched before any button or wheel event that follows it, so
+ * listeners still see events in order.
+ *
+ * Coalescing is off by default. Use {@link #setMotionHistory} if you turn
+ * it on, but still need every motion sample (e.g. for drawing strokes).
+ *
+ * @param value Whether this device coalesces motion events
+ */
+void Mouse::setCoalescing(bool value) {
+    if (!value) {
+        flushMotion();
+    }
+    _coalesce = value;
+}
+
+/**
+ * Sets whether this device records the raw motion history
+ *
+ * When this value is true, every motion event of the current animation
+ * frame is available from {@link #getMotionHistory}, whether or not the
+ * events are coalesced. Only events allowed by the pointer awareness
+ * are recorded.
+ *
+ * @param value Whether this device records the raw motion history
+ */
+void Mouse::setMotionHistory(bool value) {
+    if (!value) {
+        _history.clear();
+    }
+    _recordHistory = value;
 }
 
 
@@ -78,11 +124,11 @@ bool Mouse::requestFocus(Uint32 key) {
  * @return true if key represents a listener object
  */
 bool Mouse::isListener(Uint32 key) const {
-    bool result = _pressListeners.find(key) != _pressListeners.end();
-    result = result || _releaseListeners.find(key) != _releaseListeners.end();
-    result = result || _dragListeners.find(key) != _dragListeners.end();
-    result = result || _moveListeners.find(key) != _moveListeners.end();
-    result = result || _wheelListeners.find(key) != _wheelListeners.end();
+    bool result = _pressListeners.contains(key);
+    result = result || _releaseListeners.contains(key);
+    result = result || _dragListeners.contains(key);
+    result = result || _moveListeners.contains(key);
+    result = result || _wheelListeners.contains(key);
     return result;
 }
 
@@ -98,10 +144,7 @@ bool Mouse::isListener(Uint32 key) const {
  * @return the mouse press listener for the given object key
  */
 const Mouse::ButtonListener Mouse::getPressListener(Uint32 key) const {
-    if (_pressListeners.find(key) != _pressListeners.end()) {
-        return (_pressListeners.at(key));
-    }
-    return nullptr;
+    return _pressListeners.get(key);
 }
 
 /**
@@ -116,10 +159,7 @@ const Mouse::ButtonListener Mouse::getPressListener(Uint32 key) const {
  * @return the mouse release listener for the given object key
  */
 const Mouse::ButtonListener Mouse::getReleaseListener(Uint32 key) const {
-    if (_releaseListeners.find(key) != _releaseListeners.end()) {
-        return (_releaseListeners.at(key));
-    }
-    return nullptr;
+    return _releaseListeners.get(key);
 }
 
 /**
@@ -137,10 +177,7 @@ const Mouse::ButtonListener Mouse::getReleaseListener(Uint32 key) const {
  * @return the mouse drag listener for the given object key
  */
 const Mouse::MotionListener Mouse::getDragListener(Uint32 key) const {
-    if (_dragListeners.find(key) != _dragListeners.end()) {
-        return (_dragListeners.at(key));
-    }
-    return nullptr;
+    return _dragListeners.get(key);
 }
 
 /**
@@ -158,10 +195,7 @@ const Mouse::MotionListener Mouse::getDragListener(Uint32 key) const {
  * @return the mouse motion listener for the given object key
  */
 const Mouse::MotionListener Mouse::getMotionListener(Uint32 key) const {
-    if (_moveListeners.find(key) != _moveListeners.end()) {
-        return (_moveListeners.at(key));
-    }
-    return nullptr;
+    return _moveListeners.get(key);
 }
 
 /**
@@ -174,10 +208,7 @@ const Mouse::MotionListener Mouse::getMotionListener(Uint32 key) const {
  * @return the mouse wheel listener for the given object key
  */
 const Mouse::WheelListener Mouse::getWheelListener(Uint32 key) const {
-    if (_wheelListeners.find(key) != _wheelListeners.end()) {
-        return (_wheelListeners.at(key));
-    }
-    return nullptr;
+    return _wheelListeners.get(key);
 }
 
 /**
@@ -195,11 +226,7 @@ const Mouse::WheelListener Mouse::getWheelListener(Uint32 key) const {
  * @return true if the listener was succesfully added
  */
 bool Mouse::addPressListener(Uint32 key, Mouse::ButtonListener listener) {
-    if (_pressListeners.find(key) == _pressListeners.end()) {
-        _pressListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _pressListeners.add(key,listener);
 }
 
 /**
@@ -217,11 +244,7 @@ bool Mouse::addPressListener(Uint32 key, Mouse::ButtonListener listener) {
  * @return true if the listener was succesfully added
  */
 bool Mouse::addReleaseListener(Uint32 key, Mouse::ButtonListener listener) {
-    if (_releaseListeners.find(key) == _releaseListeners.end()) {
-        _releaseListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _releaseListeners.add(key,listener);
 }
 
 /**
@@ -241,11 +264,7 @@ bool Mouse::addReleaseListener(Uint32 key, Mouse::ButtonListener listener) {
  * @return true if the listener was succesfully added
  */
 bool Mouse::addDragListener(Uint32 key, Mouse::MotionListener listener) {
-    if (_awareness != PointerAwareness::BUTTON && _dragListeners.find(key) == _dragListeners.end()) {
-        _dragListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _awareness != PointerAwareness::BUTTON && _dragListeners.add(key,listener);
 }
 
 /**
@@ -265,11 +284,7 @@ bool Mouse::addDragListener(Uint32 key, Mouse::MotionListener listener) {
  * @return true if the listener was succesfully added
  */
 bool Mouse::addMotionListener(Uint32 key, Mouse::MotionListener listener) {
-    if (_awareness == PointerAwareness::ALWAYS && _moveListeners.find(key) == _moveListeners.end()) {
-        _moveListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _awareness == PointerAwareness::ALWAYS && _moveListeners.add(key,listener);
 }
 
 /**
@@ -287,11 +302,7 @@ bool Mouse::addMotionListener(Uint32 key, Mouse::MotionListener listener) {
  * @return true if the listener was succesfully added
  */
 bool Mouse::addWheelListener(Uint32 key, Mouse::WheelListener listener) {
-    if (_wheelListeners.find(key) == _wheelListeners.end()) {
-        _wheelListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _wheelListeners.add(key,listener);
 }
 
 /**
@@ -307,11 +318,7 @@ bool Mouse::addWheelListener(Uint32 key, Mouse::WheelListener listener) {
  * @return true if the listener was succesfully removed
  */
 bool Mouse::removePressListener(Uint32 key) {
-    if (_pressListeners.find(key) != _pressListeners.end()) {
-        _pressListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _pressListeners.remove(key);
 }
 
 /**
@@ -327,11 +334,7 @@ bool Mouse::removePressListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool Mouse::removeReleaseListener(Uint32 key) {
-    if (_releaseListeners.find(key) != _releaseListeners.end()) {
-        _releaseListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _releaseListeners.remove(key);
 }
 
 /**
@@ -349,11 +352,7 @@ bool Mouse::removeReleaseListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool Mouse::removeDragListener(Uint32 key) {
-    if (_dragListeners.find(key) != _dragListeners.end()) {
-        _dragListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _dragListeners.remove(key);
 }
 
 /**
@@ -371,11 +370,7 @@ bool Mouse::removeDragListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool Mouse::removeMotionListener(Uint32 key) {
-    if (_moveListeners.find(key) != _moveListeners.end()) {
-        _moveListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _moveListeners.remove(key);
 }
 
 /**
@@ -391,11 +386,7 @@ bool Mouse::removeMotionListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool Mouse::removeWheelListener(Uint32 key) {
-    if (_wheelListeners.find(key) != _wheelListeners.end()) {
-        _wheelListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _wheelListeners.remove(key);
 }
 
 #pragma mark -
@@ -408,6 +399,9 @@ bool Mouse::removeWheelListener(Uint32 key) {
  * necessary to advance the frame.
  */
 void Mouse::clearState() {
+    // Only pending if the last frame was never flushed
+    flushMotion();
+    _history.clear();
     _lastState = _currState;
     _lastPoint = _currPoint;
     _wheelOffset.setZero();
@@ -428,54 +422,57 @@ bool Mouse::updateState(const SDL_Event& event, const Timestamp& stamp) {
     switch (event.type) {
         case SDL_MOUSEBUTTONUP:
             if (event.button.which != SDL_TOUCH_MOUSEID) {
+                flushMotion();
 				MouseEvent mevent(SDL_BUTTON(event.button.button), Vec2((float)event.button.x, (float)event.button.y), stamp);
                 _currPoint  = mevent.position;
                 _currState -= mevent.buttons;
-                for(auto it = _releaseListeners.begin(); it != _releaseListeners.end(); ++it) {
-                    it->second(mevent,event.button.clicks,it->first == _focus);
-                }
+                _releaseListeners.dispatch(_focus,mevent,event.button.clicks);
             }
             break;
         case SDL_MOUSEBUTTONDOWN:
             if (event.button.which != SDL_TOUCH_MOUSEID) {
+                flushMotion();
                 
                 MouseEvent mevent(SDL_BUTTON(event.button.button),Vec2((float)event.button.x, (float)event.button.y),stamp);
                 _currPoint  = mevent.position;
                 _currState |= mevent.buttons;
-                for(auto it = _pressListeners.begin(); it != _pressListeners.end(); ++it) {
-                    it->second(mevent,event.button.clicks,it->first == _focus);
-                }
+                _pressListeners.dispatch(_focus,mevent,event.button.clicks);
             }
             break;
         case SDL_MOUSEMOTION:
             if (event.motion.which != SDL_TOUCH_MOUSEID) {
-                if (_awareness == PointerAwareness::DRAG && event.motion.state > 0) {
-                    MouseEvent mevent(SDL_BUTTON(event.button.button),Vec2((float)event.button.x, (float)event.button.y),stamp);
-                    Vec2 previous((float)(event.motion.x-event.motion.xrel),(float)(event.motion.y-event.motion.yrel));
-                    _currPoint = mevent.position;
-                    for(auto it = _dragListeners.begin(); it != _dragListeners.end(); ++it) {
-                        it->second(mevent,previous,it->first == _focus);
-                    }
-                } else if (_awareness == PointerAwareness::ALWAYS) {
+                bool move = _awareness == PointerAwareness::ALWAYS;
+                bool drag = move || (_awareness == PointerAwareness::DRAG && event.motion.state > 0);
+                if (drag) {
                     MouseEvent mevent(SDL_BUTTON(event.button.button),Vec2((float)event.button.x, (float)event.button.y),stamp);
                     Vec2 previous((float)(event.motion.x-event.motion.xrel),(float)(event.motion.y-event.motion.yrel));
                     _currPoint = mevent.position;
-                    for(auto it = _dragListeners.begin(); it != _dragListeners.end(); ++it) {
-                        it->second(mevent,previous,it->first == _focus);
+                    if (_recordHistory) {
+                        _history.push_back(mevent);
                     }
-                    for(auto it = _moveListeners.begin(); it != _moveListeners.end(); ++it) {
-                        it->second(mevent,previous,it->first == _focus);
+                    if (_coalesce) {
+                        if (!_pending) {
+                            _pending = true;
+                            _pendingMove = false;
+                            _pendingPrevious = previous;
+                        }
+                        _pendingEvent = mevent;
+                        _pendingMove = _pendingMove || move;
+                    } else {
+                        _dragListeners.dispatch(_focus,mevent,previous);
+                        if (move) {
+                            _moveListeners.dispatch(_focus,mevent,previous);
+                        }
                     }
                 }
             }
             break;
         case SDL_MOUSEWHEEL:
             if (event.wheel.which != SDL_TOUCH_MOUSEID) {
+                flushMotion();
                 MouseWheelEvent mevent(Vec2((float)event.wheel.x, (float)event.wheel.y),stamp,event.wheel.direction == SDL_MOUSEWHEEL_FLIPPED);
                 _wheelOffset += (mevent.flipped ? mevent.direction : -mevent.direction);
-                for(auto it = _wheelListeners.begin(); it != _wheelListeners.end(); ++it) {
-                    it->second(mevent, it->first == _focus);
-                }
+                _wheelListeners.dispatch(_focus,mevent);
             }
             break;
         default:
@@ -486,6 +483,30 @@ bool Mouse::updateState(const SDL_Event& event, const Timestamp& stamp) {
 
 }
 
+/**
+ * Finishes the input of this device for the current frame.
+ *
+ * This method dispatches the coalesced motion event (if any) of this
+ * animation frame.
+ */
+void Mouse::flushState() {
+    flushMotion();
+}
+
+/**
+ * Dispatches the pending coalesced motion event, if there is one
+ */
+void Mouse::flushMotion() {
+    if (!_pending) {
+        return;
+    }
+    _pending = false;
+    _dragListeners.dispatch(_focus,_pendingEvent,_pendingPrevious);
+    if (_pendingMove) {
+        _moveListeners.dispatch(_focus,_pendingEvent,_pendingPrevious);
+    }
+}
+
 /**
  * Determine the SDL events of relevance and store there types in eventset.
  *
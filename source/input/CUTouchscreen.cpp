@@ -45,6 +45,50 @@ void Touchscreen::dispose() {
     _beginListeners.clear();
     _finishListeners.clear();
     _moveListeners.clear();
+    _pending.clear();
+    _history.clear();
+    _coalesce = false;
+    _recordHistory = false;
+}
+
+#pragma mark -
+#pragma mark Coalescing
+/**
+ * Sets whether this device coalesces motion events
+ *
+ * SDL can report many motion events for a touch in a single animation
+ * frame. When coalescing is on, this device dispatches at most one motion
+ * event per touch per frame. The event has the last position of the frame,
+ * and its previous position is the position before the first motion event
+ * of the frame. Motion is always dispatched before any touch begins or
+ * ends, so listeners still see events in order.
+ *
+ * Coalescing is off by default. Use {@link #setMotionHistory} if you turn
+ * it on, but still need every motion sample (e.g. for drawing strokes).
+ *
+ * @param value Whether this device coalesces motion events
+ */
+void Touchscreen::setCoalescing(bool value) {
+    if (!value) {
+        flushMotion();
+    }
+    _coalesce = value;
+}
+
+/**
+ * Sets whether this device records the raw motion history
+ *
+ * When this value is true, every motion event of the current animation
+ * frame is available from {@link #getMotionHistory}, whether or not the
+ * events are coalesced.
+ *
+ * @param value Whether this device records the raw motion history
+ */
+void Touchscreen::setMotionHistory(bool value) {
+    if (!value) {
+        _history.clear();
+    }
+    _recordHistory = value;
 }
 
 #pragma mark -
@@ -131,9 +175,9 @@ bool Touchscreen::requestFocus(Uint32 key) {
  * @return true if key represents a listener object
  */
 bool Touchscreen::isListener(Uint32 key) const {
-    bool result = _beginListeners.find(key) != _beginListeners.end();
-    result = result || _finishListeners.find(key) != _finishListeners.end();
-    result = result || _moveListeners.find(key) != _moveListeners.end();
+    bool result = _beginListeners.contains(key);
+    result = result || _finishListeners.contains(key);
+    result = result || _moveListeners.contains(key);
     return result;
 }
 
@@ -149,10 +193,7 @@ bool Touchscreen::isListener(Uint32 key) const {
  * @return the touch begin listener for the given object key
  */
 const Touchscreen::ContactListener Touchscreen::getBeginListener(Uint32 key) const {
-    if (_beginListeners.find(key) != _beginListeners.end()) {
-        return (_beginListeners.at(key));
-    }
-    return nullptr;
+    return _beginListeners.get(key);
 }
 
 /**
@@ -167,10 +208,7 @@ const Touchscreen::ContactListener Touchscreen::getBeginListener(Uint32 key) con
  * @return the touch end listener for the given object key
  */
 const Touchscreen::ContactListener Touchscreen::getEndListener(Uint32 key) const {
-    if (_finishListeners.find(key) != _finishListeners.end()) {
-        return (_finishListeners.at(key));
-    }
-    return nullptr;
+    return _finishListeners.get(key);
 }
 
 /**
@@ -183,10 +221,7 @@ const Touchscreen::ContactListener Touchscreen::getEndListener(Uint32 key) const
  * @return the touch motion listener for the given object key
  */
 const Touchscreen::MotionListener Touchscreen::getMotionListener(Uint32 key) const {
-    if (_moveListeners.find(key) != _moveListeners.end()) {
-        return (_moveListeners.at(key));
-    }
-    return nullptr;
+    return _moveListeners.get(key);
 }
 
 /**
@@ -204,11 +239,7 @@ const Touchscreen::MotionListener Touchscreen::getMotionListener(Uint32 key) con
  * @return true if the listener was succesfully added
  */
 bool Touchscreen::addBeginListener(Uint32 key, Touchscreen::ContactListener listener) {
-    if (_beginListeners.find(key) == _beginListeners.end()) {
-        _beginListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _beginListeners.add(key,listener);
 }
 
 /**
@@ -226,11 +257,7 @@ bool Touchscreen::addBeginListener(Uint32 key, Touchscreen::ContactListener list
  * @return true if the listener was succesfully added
  */
 bool Touchscreen::addEndListener(Uint32 key, Touchscreen::ContactListener listener) {
-    if (_finishListeners.find(key) == _finishListeners.end()) {
-        _finishListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _finishListeners.add(key,listener);
 }
 
 /**
@@ -248,11 +275,7 @@ bool Touchscreen::addEndListener(Uint32 key, Touchscreen::ContactListener listen
  * @return true if the listener was succesfully added
  */
 bool Touchscreen::addMotionListener(Uint32 key, Touchscreen::MotionListener listener) {
-    if (_moveListeners.find(key) == _moveListeners.end()) {
-        _moveListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _moveListeners.add(key,listener);
 }
 
 /**
@@ -268,11 +291,7 @@ bool Touchscreen::addMotionListener(Uint32 key, Touchscreen::MotionListener list
  * @return true if the listener was succesfully removed
  */
 bool Touchscreen::removeBeginListener(Uint32 key) {
-    if (_beginListeners.find(key) != _beginListeners.end()) {
-        _beginListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _beginListeners.remove(key);
 }
 
 /**
@@ -288,11 +307,7 @@ bool Touchscreen::removeBeginListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool Touchscreen::removeEndListener(Uint32 key) {
-    if (_finishListeners.find(key) != _finishListeners.end()) {
-        _finishListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _finishListeners.remove(key);
 }
 
 /**
@@ -308,11 +323,7 @@ bool Touchscreen::removeEndListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool Touchscreen::removeMotionListener(Uint32 key) {
-    if (_moveListeners.find(key) != _moveListeners.end()) {
-        _moveListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _moveListeners.remove(key);
 }
 
 #pragma mark -
@@ -324,6 +335,9 @@ bool Touchscreen::removeMotionListener(Uint32 key) {
  * necessary to advance the frame.
  */
 void Touchscreen::clearState() {
+    // Only pending if the last frame was never flushed
+    flushMotion();
+    _history.clear();
     _previous.clear();
     _previous.insert(_current.begin(),_current.end());
 }
@@ -343,28 +357,26 @@ bool Touchscreen::updateState(const SDL_Event& event, const Timestamp& stamp) {
     switch (event.type) {
         case SDL_FINGERDOWN:
         {
+            flushMotion();
             TouchEvent tevent(event.tfinger.fingerId,Vec2(event.tfinger.x,event.tfinger.y),
                               event.tfinger.pressure, stamp);
             
             tevent.position *= Application::get()->getDisplayBounds().size;
             tevent.position += Application::get()->getDisplayBounds().origin;
             _current[tevent.touch] = tevent.position;
-            for(auto it = _beginListeners.begin(); it != _beginListeners.end(); ++it) {
-                it->second(tevent,it->first == _focus);
-            }
+            _beginListeners.dispatch(_focus,tevent);
         }
             break;
         case SDL_FINGERUP:
         {
+            flushMotion();
             TouchEvent tevent(event.tfinger.fingerId,Vec2(event.tfinger.x,event.tfinger.y),
                               event.tfinger.pressure, stamp);
 
             tevent.position *= Application::get()->getDisplayBounds().size;
             tevent.position += Application::get()->getDisplayBounds().origin;
             _current.erase(tevent.touch);
-            for(auto it = _finishListeners.begin(); it != _finishListeners.end(); ++it) {
-                it->second(tevent,it->first == _focus);
-            }
+            _finishListeners.dispatch(_focus,tevent);
         }
             break;
         case SDL_FINGERMOTION:
@@ -381,8 +393,21 @@ bool Touchscreen::updateState(const SDL_Event& event, const Timestamp& stamp) {
             previous += origin;
 
             _current[tevent.touch] = tevent.position;
-            for(auto it = _moveListeners.begin(); it != _moveListeners.end(); ++it) {
-                it->second(tevent,previous,it->first == _focus);
+            if (_recordHistory) {
+                _history.push_back(tevent);
+            }
+            if (_coalesce) {
+                auto it = _pending.begin();
+                while (it != _pending.end() && it->event.touch != tevent.touch) {
+                    ++it;
+                }
+                if (it == _pending.end()) {
+                    _pending.push_back({tevent,previous});
+                } else {
+                    it->event = tevent;
+                }
+            } else {
+                _moveListeners.dispatch(_focus,tevent,previous);
             }
         }
             break;
@@ -394,6 +419,36 @@ bool Touchscreen::updateState(const SDL_Event& event, const Timestamp& stamp) {
     
 }
 
+/**
+ * Finishes the input of this device for the current frame.
+ *
+ * This method dispatches the coalesced motion events (if any) of this
+ * animation frame.
+ */
+void Touchscreen::flushState() {
+    flushMotion();
+}
+
+/**
+ * Dispatches the pending coalesced motion events, in the order received
+ */
+void Touchscreen::flushMotion() {
+    if (_pending.empty()) {
+        return;
+    }
+    // Swap out in case a listener changes the coalescing
+    std::vector<PendingMotion> pending;
+    pending.swap(_pending);
+    for(auto it = pending.begin(); it != pending.end(); ++it) {
+        _moveListeners.dispatch(_focus,it->event,it->previous);
+    }
+    // Keep the capacity for the next frame
+    pending.clear();
+    if (_pending.empty()) {
+        _pending.swap(pending);
+    }
+}
+
 /**
  * Determine the SDL events of relevance and store there types in eventset.
  *
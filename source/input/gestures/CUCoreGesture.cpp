@@ -251,9 +251,9 @@ bool CoreGesture::requestFocus(Uint32 key) {
  * @return true if key represents a listener object
  */
 bool CoreGesture::isListener(Uint32 key) const {
-    bool result = _startListeners.find(key) != _startListeners.end();
-    result = result | _endListeners.find(key) != _endListeners.end();
-    result = result | _deltaListeners.find(key) != _deltaListeners.end();
+    bool result = _startListeners.contains(key);
+    result = result | _endListeners.contains(key);
+    result = result | _deltaListeners.contains(key);
     return result;
 }
 
@@ -272,10 +272,7 @@ bool CoreGesture::isListener(Uint32 key) const {
  * @return the gesture begin listener for the given object key
  */
 const CoreGesture::Listener CoreGesture::getBeginListener(Uint32 key) const {
-    if (_startListeners.find(key) != _startListeners.end()) {
-        return (_startListeners.at(key));
-    }
-    return nullptr;
+    return _startListeners.get(key);
 }
 
 /**
@@ -292,10 +289,7 @@ const CoreGesture::Listener CoreGesture::getBeginListener(Uint32 key) const {
  * @return the gesture begin listener for the given object key
  */
 const CoreGesture::Listener CoreGesture::getEndListener(Uint32 key) const {
-    if (_endListeners.find(key) != _endListeners.end()) {
-        return (_endListeners.at(key));
-    }
-    return nullptr;
+    return _endListeners.get(key);
 }
 
 /**
@@ -313,10 +307,7 @@ const CoreGesture::Listener CoreGesture::getEndListener(Uint32 key) const {
  * @return the gesture begin listener for the given object key
  */
 const CoreGesture::Listener CoreGesture::getChangeListener(Uint32 key) const {
-    if (_deltaListeners.find(key) != _deltaListeners.end()) {
-        return (_deltaListeners.at(key));
-    }
-    return nullptr;
+    return _deltaListeners.get(key);
 }
 
 /**
@@ -337,11 +328,7 @@ const CoreGesture::Listener CoreGesture::getChangeListener(Uint32 key) const {
  * @return true if the listener was succesfully added
  */
 bool CoreGesture::addBeginListener(Uint32 key, Listener listener) {
-    if (_startListeners.find(key) == _startListeners.end()) {
-        _startListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _startListeners.add(key,listener);
 }
 
 /**
@@ -361,11 +348,7 @@ bool CoreGesture::addBeginListener(Uint32 key, Listener listener) {
  * @return true if the listener was succesfully added
  */
 bool CoreGesture::addEndListener(Uint32 key, Listener listener) {
-    if (_endListeners.find(key) == _endListeners.end()) {
-        _endListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _endListeners.add(key,listener);
 }
 
 /**
@@ -386,11 +369,7 @@ bool CoreGesture::addEndListener(Uint32 key, Listener listener) {
  * @return true if the listener was succesfully added
  */
 bool CoreGesture::addChangeListener(Uint32 key, Listener listener) {
-    if (_deltaListeners.find(key) == _deltaListeners.end()) {
-        _deltaListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _deltaListeners.add(key,listener);
 }
 
 /**
@@ -409,11 +388,7 @@ bool CoreGesture::addChangeListener(Uint32 key, Listener listener) {
  * @return true if the listener was succesfully removed
  */
 bool CoreGesture::removeBeginListener(Uint32 key) {
-    if (_startListeners.find(key) == _startListeners.end()) {
-        _startListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _startListeners.remove(key);
 }
 
 /**
@@ -432,11 +407,7 @@ bool CoreGesture::removeBeginListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool CoreGesture::removeEndListener(Uint32 key) {
-    if (_endListeners.find(key) == _endListeners.end()) {
-        _endListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _endListeners.remove(key);
 }
 
 /**
@@ -455,11 +426,7 @@ bool CoreGesture::removeEndListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool CoreGesture::removeChangeListener(Uint32 key) {
-    if (_deltaListeners.find(key) == _deltaListeners.end()) {
-        _deltaListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _deltaListeners.remove(key);
 }
 
 #pragma mark -
@@ -509,9 +476,7 @@ bool CoreGesture::updateState(const SDL_Event& event, const Timestamp& stamp) {
 					processPinch();
 					processSpin();
 					_data.now = stamp;
-					for(auto it = _deltaListeners.begin(); it != _deltaListeners.end(); ++it) {
-						it->second(_data,_focus);
-					}
+					_deltaListeners.dispatch(_focus,_data);
 				}
             }
         }
@@ -635,9 +600,7 @@ void CoreGesture::startGesture(const Timestamp& stamp) {
     _data.origSpread = axis.length();
     _data.currSpread = _data.origSpread;
 
-    for(auto it = _startListeners.begin(); it != _startListeners.end(); ++it) {
-        it->second(_data,_focus);
-    }
+    _startListeners.dispatch(_focus,_data);
 }
 
 /**
@@ -650,9 +613,7 @@ void CoreGesture::startGesture(const Timestamp& stamp) {
  */
 void CoreGesture::cancelGesture(const Timestamp& stamp) {
     _data.now = stamp;
-    for(auto it = _endListeners.begin(); it != _endListeners.end(); ++it) {
-        it->second(_data,_focus);
-    }
+    _endListeners.dispatch(_focus,_data);
     _data.clear();
     _data.start = stamp;
     _active = false;
@@ -127,9 +127,9 @@ bool PanGesture::requestFocus(Uint32 key) {
  * @return true if key represents a listener object
  */
 bool PanGesture::isListener(Uint32 key) const {
-    bool result = _beginListeners.find(key) != _beginListeners.end();
-    result = result || _finishListeners.find(key) != _finishListeners.end();
-    result = result || _motionListeners.find(key) != _motionListeners.end();
+    bool result = _beginListeners.contains(key);
+    result = result || _finishListeners.contains(key);
+    result = result || _motionListeners.contains(key);
     return result;
 }
 
@@ -145,10 +145,7 @@ bool PanGesture::isListener(Uint32 key) const {
  * @return the pan begin listener for the given object key
  */
 const PanGesture::Listener PanGesture::getBeginListener(Uint32 key) const {
-    if (_beginListeners.find(key) != _beginListeners.end()) {
-        return (_beginListeners.at(key));
-    }
-    return nullptr;
+    return _beginListeners.get(key);
 }
 
 /**
@@ -164,10 +161,7 @@ const PanGesture::Listener PanGesture::getBeginListener(Uint32 key) const {
  * @return the pan end listener for the given object key
  */
 const PanGesture::Listener PanGesture::getEndListener(Uint32 key) const {
-    if (_finishListeners.find(key) != _finishListeners.end()) {
-        return (_finishListeners.at(key));
-    }
-    return nullptr;
+    return _finishListeners.get(key);
 }
 
 /**
@@ -180,10 +174,7 @@ const PanGesture::Listener PanGesture::getEndListener(Uint32 key) const {
  * @return the pan change listener for the given object key
  */
 const PanGesture::Listener PanGesture::getChangeListener(Uint32 key) const {
-    if (_motionListeners.find(key) != _motionListeners.end()) {
-        return (_motionListeners.at(key));
-    }
-    return nullptr;
+    return _motionListeners.get(key);
 }
 
 /**
@@ -201,11 +192,7 @@ const PanGesture::Listener PanGesture::getChangeListener(Uint32 key) const {
  * @return true if the listener was succesfully added
  */
 bool PanGesture::addBeginListener(Uint32 key, PanGesture::Listener listener) {
-    if (_beginListeners.find(key) == _beginListeners.end()) {
-        _beginListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _beginListeners.add(key,listener);
 }
 
 /**
@@ -224,11 +211,7 @@ bool PanGesture::addBeginListener(Uint32 key, PanGesture::Listener listener) {
  * @return true if the listener was succesfully added
  */
 bool PanGesture::addEndListener(Uint32 key, PanGesture::Listener listener) {
-    if (_finishListeners.find(key) == _finishListeners.end()) {
-        _finishListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _finishListeners.add(key,listener);
 }
 
 /**
@@ -246,11 +229,7 @@ bool PanGesture::addEndListener(Uint32 key, PanGesture::Listener listener) {
  * @return true if the listener was succesfully added
  */
 bool PanGesture::addChangeListener(Uint32 key, PanGesture::Listener listener) {
-    if (_motionListeners.find(key) == _motionListeners.end()) {
-        _motionListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _motionListeners.add(key,listener);
 }
 
 /**
@@ -266,11 +245,7 @@ bool PanGesture::addChangeListener(Uint32 key, PanGesture::Listener listener) {
  * @return true if the listener was succesfully removed
  */
 bool PanGesture::removeBeginListener(Uint32 key) {
-    if (_beginListeners.find(key) != _beginListeners.end()) {
-        _beginListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _beginListeners.remove(key);
 }
 
 /**
@@ -287,11 +262,7 @@ bool PanGesture::removeBeginListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool PanGesture::removeEndListener(Uint32 key) {
-    if (_finishListeners.find(key) != _finishListeners.end()) {
-        _finishListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _finishListeners.remove(key);
 }
 
 /**
@@ -307,11 +278,7 @@ bool PanGesture::removeEndListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool PanGesture::removeChangeListener(Uint32 key) {
-    if (_motionListeners.find(key) != _motionListeners.end()) {
-        _motionListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _motionListeners.remove(key);
 }
 
 
@@ -348,14 +315,10 @@ bool PanGesture::updateState(const SDL_Event& event, const Timestamp& stamp) {
                     _event.now = stamp;
                     if (_fingery) {
                         // Reboot events when we add fingers
-                        for(auto it = _finishListeners.begin(); it != _finishListeners.end(); ++it) {
-                            it->second(_event,it->first == _focus);
-                        }
+                        _finishListeners.dispatch(_focus,_event);
                         _event.fingers++;
                         _event.currPosition = computeCentroid();
-                        for(auto it = _beginListeners.begin(); it != _beginListeners.end(); ++it) {
-                            it->second(_event,it->first == _focus);
-                        }
+                        _beginListeners.dispatch(_focus,_event);
                     } else {
                         _event.fingers++;
                     }
@@ -375,14 +338,10 @@ bool PanGesture::updateState(const SDL_Event& event, const Timestamp& stamp) {
                     } else if (_fingery) {
                         _event.now = stamp;
                         // Reboot events when we remove fingers
-                        for(auto it = _finishListeners.begin(); it != _finishListeners.end(); ++it) {
-                            it->second(_event,it->first == _focus);
-                        }
+                        _finishListeners.dispatch(_focus,_event);
                         _event.fingers--;
                         _event.currPosition = computeCentroid();
-                        for(auto it = _beginListeners.begin(); it != _beginListeners.end(); ++it) {
-                            it->second(_event,it->first == _focus);
-                        }
+                        _beginListeners.dispatch(_focus,_event);
                     }
                 }
             }
@@ -400,9 +359,7 @@ bool PanGesture::updateState(const SDL_Event& event, const Timestamp& stamp) {
                     _event.currPosition = position;
                     _event.now = stamp;
                     
-                    for(auto it = _motionListeners.begin(); it != _motionListeners.end(); ++it) {
-                        it->second(_event,_focus);
-                    }
+                    _motionListeners.dispatch(_focus,_event);
                 }
             }
         }
@@ -488,9 +445,7 @@ void PanGesture::startGesture(const Timestamp& stamp) {
     _event.delta.setZero();
     _event.fingers = (Uint32)_fingers.size();
 
-    for(auto it = _beginListeners.begin(); it != _beginListeners.end(); ++it) {
-        it->second(_event,_focus);
-    }
+    _beginListeners.dispatch(_focus,_event);
 }
 
 /**
@@ -503,9 +458,7 @@ void PanGesture::startGesture(const Timestamp& stamp) {
  */
 void PanGesture::cancelGesture(const Timestamp& stamp) {
     _event.now = stamp;
-    for(auto it = _finishListeners.begin(); it != _finishListeners.end(); ++it) {
-        it->second(_event,_focus);
-    }
+    _finishListeners.dispatch(_focus,_event);
     _event.clear();
     _event.start = stamp;
     _active = false;
@@ -172,9 +172,9 @@ bool PinchGesture::requestFocus(Uint32 key) {
  * @return true if key represents a listener object
  */
 bool PinchGesture::isListener(Uint32 key) const {
-    bool result = _beginListeners.find(key) != _beginListeners.end();
-    result = result || _finishListeners.find(key) != _finishListeners.end();
-    result = result || _changeListeners.find(key) != _changeListeners.end();
+    bool result = _beginListeners.contains(key);
+    result = result || _finishListeners.contains(key);
+    result = result || _changeListeners.contains(key);
     return result;
 }
 
@@ -190,10 +190,7 @@ bool PinchGesture::isListener(Uint32 key) const {
  * @return the pinch begin listener for the given object key
  */
 const PinchGesture::Listener PinchGesture::getBeginListener(Uint32 key) const {
-    if (_beginListeners.find(key) != _beginListeners.end()) {
-        return (_beginListeners.at(key));
-    }
-    return nullptr;
+    return _beginListeners.get(key);
 }
 
 /**
@@ -209,10 +206,7 @@ const PinchGesture::Listener PinchGesture::getBeginListener(Uint32 key) const {
  * @return the pinch end listener for the given object key
  */
 const PinchGesture::Listener PinchGesture::getEndListener(Uint32 key) const {
-    if (_finishListeners.find(key) != _finishListeners.end()) {
-        return (_finishListeners.at(key));
-    }
-    return nullptr;
+    return _finishListeners.get(key);
 }
 
 /**
@@ -225,10 +219,7 @@ const PinchGesture::Listener PinchGesture::getEndListener(Uint32 key) const {
  * @return the pinch change listener for the given object key
  */
 const PinchGesture::Listener PinchGesture::getChangeListener(Uint32 key) const {
-    if (_changeListeners.find(key) != _changeListeners.end()) {
-        return (_changeListeners.at(key));
-    }
-    return nullptr;
+    return _changeListeners.get(key);
 }
 
 /**
@@ -246,11 +237,7 @@ const PinchGesture::Listener PinchGesture::getChangeListener(Uint32 key) const {
  * @return true if the listener was succesfully added
  */
 bool PinchGesture::addBeginListener(Uint32 key, PinchGesture::Listener listener) {
-    if (_beginListeners.find(key) == _beginListeners.end()) {
-        _beginListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _beginListeners.add(key,listener);
 }
 
 /**
@@ -269,11 +256,7 @@ bool PinchGesture::addBeginListener(Uint32 key, PinchGesture::Listener listener)
  * @return true if the listener was succesfully added
  */
 bool PinchGesture::addEndListener(Uint32 key, PinchGesture::Listener listener) {
-    if (_finishListeners.find(key) == _finishListeners.end()) {
-        _finishListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _finishListeners.add(key,listener);
 }
 
 /**
@@ -291,11 +274,7 @@ bool PinchGesture::addEndListener(Uint32 key, PinchGesture::Listener listener) {
  * @return true if the listener was succesfully added
  */
 bool PinchGesture::addChangeListener(Uint32 key, PinchGesture::Listener listener) {
-    if (_changeListeners.find(key) == _changeListeners.end()) {
-        _changeListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _changeListeners.add(key,listener);
 }
 
 /**
@@ -311,11 +290,7 @@ bool PinchGesture::addChangeListener(Uint32 key, PinchGesture::Listener listener
  * @return true if the listener was succesfully removed
  */
 bool PinchGesture::removeBeginListener(Uint32 key) {
-    if (_beginListeners.find(key) != _beginListeners.end()) {
-        _beginListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _beginListeners.remove(key);
 }
 
 /**
@@ -332,11 +307,7 @@ bool PinchGesture::removeBeginListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool PinchGesture::removeEndListener(Uint32 key) {
-    if (_finishListeners.find(key) != _finishListeners.end()) {
-        _finishListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _finishListeners.remove(key);
 }
 
 /**
@@ -352,11 +323,7 @@ bool PinchGesture::removeEndListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool PinchGesture::removeChangeListener(Uint32 key) {
-    if (_changeListeners.find(key) != _changeListeners.end()) {
-        _changeListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _changeListeners.remove(key);
 }
 
 
@@ -424,9 +391,7 @@ bool PinchGesture::updateState(const SDL_Event& event, const Timestamp& stamp) {
                         _event.delta = spread-_event.currSpread;
                         _event.currSpread = spread;
                         _event.now = stamp;
-                        for(auto it = _changeListeners.begin(); it != _changeListeners.end(); ++it) {
-                            it->second(_event,_focus);
-                        }
+                        _changeListeners.dispatch(_focus,_event);
                     }
                 }
             }
@@ -547,9 +512,7 @@ void PinchGesture::startGesture(const Timestamp& stamp) {
     _event.currSpread = _event.origSpread;
     _event.delta = 0;
 
-    for(auto it = _beginListeners.begin(); it != _beginListeners.end(); ++it) {
-        it->second(_event,_focus);
-    }
+    _beginListeners.dispatch(_focus,_event);
 }
 
 /**
@@ -562,9 +525,7 @@ void PinchGesture::startGesture(const Timestamp& stamp) {
  */
 void PinchGesture::cancelGesture(const Timestamp& stamp) {
     _event.now = stamp;
-    for(auto it = _finishListeners.begin(); it != _finishListeners.end(); ++it) {
-        it->second(_event,_focus);
-    }
+    _finishListeners.dispatch(_focus,_event);
     _event.clear();
     _event.start = stamp;
     _active = false;
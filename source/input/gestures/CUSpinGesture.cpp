@@ -193,9 +193,9 @@ bool SpinGesture::requestFocus(Uint32 key) {
  * @return true if key represents a listener object
  */
 bool SpinGesture::isListener(Uint32 key) const {
-    bool result = _beginListeners.find(key) != _beginListeners.end();
-    result = result || _finishListeners.find(key) != _finishListeners.end();
-    result = result || _changeListeners.find(key) != _changeListeners.end();
+    bool result = _beginListeners.contains(key);
+    result = result || _finishListeners.contains(key);
+    result = result || _changeListeners.contains(key);
     return result;
 }
 
@@ -211,10 +211,7 @@ bool SpinGesture::isListener(Uint32 key) const {
  * @return the rotational begin listener for the given object key
  */
 const SpinGesture::Listener SpinGesture::getBeginListener(Uint32 key) const {
-    if (_beginListeners.find(key) != _beginListeners.end()) {
-        return (_beginListeners.at(key));
-    }
-    return nullptr;
+    return _beginListeners.get(key);
 }
 
 /**
@@ -230,10 +227,7 @@ const SpinGesture::Listener SpinGesture::getBeginListener(Uint32 key) const {
  * @return the rotational end listener for the given object key
  */
 const SpinGesture::Listener SpinGesture::getEndListener(Uint32 key) const {
-    if (_finishListeners.find(key) != _finishListeners.end()) {
-        return (_finishListeners.at(key));
-    }
-    return nullptr;
+    return _finishListeners.get(key);
 }
 
 /**
@@ -246,10 +240,7 @@ const SpinGesture::Listener SpinGesture::getEndListener(Uint32 key) const {
  * @return the rotational change listener for the given object key
  */
 const SpinGesture::Listener SpinGesture::getChangeListener(Uint32 key) const {
-    if (_changeListeners.find(key) != _changeListeners.end()) {
-        return (_changeListeners.at(key));
-    }
-    return nullptr;
+    return _changeListeners.get(key);
 }
 
 /**
@@ -267,11 +258,7 @@ const SpinGesture::Listener SpinGesture::getChangeListener(Uint32 key) const {
  * @return true if the listener was succesfully added
  */
 bool SpinGesture::addBeginListener(Uint32 key, SpinGesture::Listener listener) {
-    if (_beginListeners.find(key) == _beginListeners.end()) {
-        _beginListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _beginListeners.add(key,listener);
 }
 
 /**
@@ -290,11 +277,7 @@ bool SpinGesture::addBeginListener(Uint32 key, SpinGesture::Listener listener) {
  * @return true if the listener was succesfully added
  */
 bool SpinGesture::addEndListener(Uint32 key, SpinGesture::Listener listener) {
-    if (_finishListeners.find(key) == _finishListeners.end()) {
-        _finishListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _finishListeners.add(key,listener);
 }
 
 /**
@@ -312,11 +295,7 @@ bool SpinGesture::addEndListener(Uint32 key, SpinGesture::Listener listener) {
  * @return true if the listener was succesfully added
  */
 bool SpinGesture::addChangeListener(Uint32 key, SpinGesture::Listener listener) {
-    if (_changeListeners.find(key) == _changeListeners.end()) {
-        _changeListeners[key] = listener;
-        return true;
-    }
-    return false;
+    return _changeListeners.add(key,listener);
 }
 
 /**
@@ -332,11 +311,7 @@ bool SpinGesture::addChangeListener(Uint32 key, SpinGesture::Listener listener)
  * @return true if the listener was succesfully removed
  */
 bool SpinGesture::removeBeginListener(Uint32 key) {
-    if (_beginListeners.find(key) != _beginListeners.end()) {
-        _beginListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _beginListeners.remove(key);
 }
 
 /**
@@ -353,11 +328,7 @@ bool SpinGesture::removeBeginListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool SpinGesture::removeEndListener(Uint32 key) {
-    if (_finishListeners.find(key) != _finishListeners.end()) {
-        _finishListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _finishListeners.remove(key);
 }
 
 /**
@@ -373,11 +344,7 @@ bool SpinGesture::removeEndListener(Uint32 key) {
  * @return true if the listener was succesfully removed
  */
 bool SpinGesture::removeChangeListener(Uint32 key) {
-    if (_changeListeners.find(key) != _changeListeners.end()) {
-        _changeListeners.erase(key);
-        return true;
-    }
-    return false;
+    return _changeListeners.remove(key);
 }
 
 
@@ -448,9 +415,7 @@ bool SpinGesture::updateState(const SDL_Event& event, const Timestamp& stamp) {
                         _event.delta = angle-_event.currAngle;
                         _event.currAngle = angle;
                         _event.now = stamp;
-                        for(auto it = _changeListeners.begin(); it != _changeListeners.end(); ++it) {
-                            it->second(_event,_focus);
-                        }
+                        _changeListeners.dispatch(_focus,_event);
                     }
                 } else if (_fingers.size() == 2 && _updated == 2) {
                     Vec2 axis = computeAxis();
@@ -576,9 +541,7 @@ void SpinGesture::startGesture(const Timestamp& stamp) {
     _event.currAngle = _event.origAngle;
     _event.delta = 0;
     
-    for(auto it = _beginListeners.begin(); it != _beginListeners.end(); ++it) {
-        it->second(_event,_focus);
-    }
+    _beginListeners.dispatch(_focus,_event);
 }
 
 /**
@@ -591,9 +554,7 @@ void SpinGesture::startGesture(const Timestamp& stamp) {
  */
 void SpinGesture::cancelGesture(const Timestamp& stamp) {
     _event.now = stamp;
-    for(auto it = _finishListeners.begin(); it != _finishListeners.end(); ++it) {
-        it->second(_event,_focus);
-    }
+    _finishListeners.dispatch(_focus,_event);
     _event.clear();
     _event.start = stamp;
     _active = false;
@@ -0,0 +1,608 @@
+//
+//  CUAssetBundle.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides support for asset bundles. A bundle is a single
+//  archive file holding many assets, together with a central index. Opening
+//  a file on some platforms (particularly the APK asset manager on Android)
+//  has a significant fixed cost, and a bundle pays it only once.
+//
+//  Bundles are built offline with the script scripts/bundle.py. Each entry
+//  is aligned so that it may be used directly from a memory mapping, and may
+//  optionally be compressed (with the LZ4 block format).
+//
+//  Once a bundle is mounted, every reader in the io package, as well as the
+//  asset loaders, will read asset files from the bundle instead of the file
+//  system. Files that are not in any mounted bundle are read as normal.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/io/CUAssetBundle.h>
+#include <cugl/io/CUBinaryReader.h>
+#include <cugl/util/CUDebug.h>
+#include <cugl/util/CUFiletools.h>
+#include <cugl/base/CUApplication.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+using namespace cugl;
+
+/** The magic number at the start of every bundle */
+#define BUNDLE_MAGIC    "CUGB"
+/** The current version of the bundle format */
+#define BUNDLE_VERSION  1
+/** The size of the bundle header in bytes */
+#define BUNDLE_HEADER   32
+/** The size of a single index entry in bytes */
+#define BUNDLE_ENTRY    32
+/** The index flag for an LZ4 compressed entry */
+#define BUNDLE_LZ4      1
+
+/** The mounted bundles, in order of mounting */
+static std::vector<std::shared_ptr<AssetBundle>> _mounted;
+/** The lock protecting the mounted bundles */
+static std::mutex _mountex;
+
+#pragma mark -
+#pragma mark Helpers
+/**
+ * Returns the little-endian 16 bit value at the given position
+ *
+ * @param data  The position to read
+ *
+ * @return the little-endian 16 bit value at the given position
+ */
+static Uint16 read_uint16(const Uint8* data) {
+    return (Uint16)(data[0] | (data[1] << 8));
+}
+
+/**
+ * Returns the little-endian 32 bit value at the given position
+ *
+ * @param data  The position to read
+ *
+ * @return the little-endian 32 bit value at the given position
+ */
+static Uint32 read_uint32(const Uint8* data) {
+    return ((Uint32)data[0]) | ((Uint32)data[1] << 8) |
+           ((Uint32)data[2] << 16) | ((Uint32)data[3] << 24);
+}
+
+/**
+ * Returns the little-endian 64 bit value at the given position
+ *
+ * @param data  The position to read
+ *
+ * @return the little-endian 64 bit value at the given position
+ */
+static Uint64 read_uint64(const Uint8* data) {
+    return ((Uint64)read_uint32(data+4) << 32) | read_uint32(data);
+}
+
+/**
+ * Decompresses an LZ4 block into the given buffer
+ *
+ * The block must decompress to exactly the size of the buffer. This function
+ * checks every length and offset against the bounds of both buffers, so it
+ * is safe to use on corrupt data.
+ *
+ * @param src       The compressed block
+ * @param srclen    The size of the compressed block
+ * @param dst       The buffer to store the result
+ * @param dstlen    The size of the decompressed data
+ *
+ * @return true if the block was decompressed successfully
+ */
+static bool lz4_decode(const Uint8* src, size_t srclen, Uint8* dst, size_t dstlen) {
+    const Uint8* send = src+srclen;
+    Uint8* dpos = dst;
+    Uint8* dend = dst+dstlen;
+
+    while (src < send) {
+        Uint8 token = *src++;
+
+        // Copy the literals
+        size_t length = token >> 4;
+        if (length == 15) {
+            Uint8 more;
+            do {
+                if (src >= send) {
+                    return false;
+                }
+                more = *src++;
+                length += more;
+            } while (more == 255);
+        }
+        if (length > (size_t)(send-src) || length > (size_t)(dend-dpos)) {
+            return false;
+        }
+        std::memcpy(dpos, src, length);
+        src  += length;
+        dpos += length;
+
+        // The last sequence has no match
+        if (src == send) {
+            break;
+        }
+
+        if (send-src < 2) {
+            return false;
+        }
+        size_t offset = read_uint16(src);
+        src += 2;
+        if (offset == 0 || offset > (size_t)(dpos-dst)) {
+            return false;
+        }
+
+        length = (token & 0x0f);
+        if (length == 15) {
+            Uint8 more;
+            do {
+                if (src >= send) {
+                    return false;
+                }
+                more = *src++;
+                length += more;
+            } while (more == 255);
+        }
+        length += 4;
+        if (length > (size_t)(dend-dpos)) {
+            return false;
+        }
+
+        // Matches may overlap the output, so copy bytewise
+        const Uint8* match = dpos-offset;
+        for(size_t ii = 0; ii < length; ii++) {
+            dpos[ii] = match[ii];
+        }
+        dpos += length;
+    }
+    return dpos == dend;
+}
+
+/**
+ * Closes a stream that owns its (decompressed) memory
+ *
+ * @param context   The stream to close
+ *
+ * @return 0 on success
+ */
+static int owned_close(SDL_RWops* context) {
+    if (context) {
+        free((void*)context->hidden.mem.base);
+        SDL_FreeRW(context);
+    }
+    return 0;
+}
+
+/**
+ * Returns the path of the given file relative to the asset directory
+ *
+ * The result uses forward slashes as separators. This function returns the
+ * empty string if the file is not in the asset directory.
+ *
+ * @param path  The (normalized) path to the file
+ *
+ * @return the path of the given file relative to the asset directory
+ */
+static std::string asset_path(const std::string& path) {
+    Application* app = Application::get();
+    if (app == nullptr) {
+        return std::string();
+    }
+
+    std::string root = app->getAssetDirectory();
+    size_t pos = 0;
+    if (!root.empty()) {
+        root = filetool::normalize_path(root);
+        while (!root.empty() && (root.back() == '/' || root.back() == '\\')) {
+            root.pop_back();
+        }
+        if (path.size() <= root.size() || path.compare(0, root.size(), root) != 0 ||
+            (path[root.size()] != '/' && path[root.size()] != '\\')) {
+            return std::string();
+        }
+        pos = root.size();
+    }
+    while (pos < path.size() && (path[pos] == '/' || path[pos] == '\\')) {
+        pos++;
+    }
+
+    std::string result = path.substr(pos);
+    std::replace(result.begin(), result.end(), '\\', '/');
+    return result;
+}
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Disposes all of the resources used by this bundle.
+ *
+ * Any stream opened from this bundle is invalid after this call.
+ */
+void AssetBundle::dispose() {
+    if (_reader) {
+        _reader->close();
+        _reader = nullptr;
+    }
+    _storage.clear();
+    _storage.shrink_to_fit();
+    _index.clear();
+    _data = nullptr;
+    _size = 0;
+    _name.clear();
+}
+
+/**
+ * Initializes an asset bundle from the given file.
+ *
+ * If the file is a relative path, this bundle will look for the file in
+ * the application save directory {@see Application#getSaveDirectory()}.
+ * If you wish to read a file in any other directory, you must provide
+ * an absolute path.
+ *
+ * @param file  the path (absolute or relative) to the bundle
+ *
+ * @return true if the bundle is initialized properly, false otherwise.
+ */
+bool AssetBundle::init(const std::string file) {
+    if (_data != nullptr) {
+        CUAssertLog(false, "Bundle %s is already initialized", _name.c_str());
+        return false;
+    }
+
+    _name = filetool::normalize_path(file);
+    _reader = BinaryReader::allocMapped(_name);
+    if (_reader == nullptr) {
+        CULogError("Could not open bundle %s", _name.c_str());
+        return false;
+    }
+
+    // A mapped reader hands out the entire bundle with no copy
+    _size = _reader->getSize();
+    if (_reader->isMapped()) {
+        _data = _reader->readBytes(_size);
+    } else {
+        _storage.resize(_size);
+        size_t amt = _size ? _reader->read(_storage.data(), _size) : 0;
+        _reader->close();
+        _reader = nullptr;
+        _storage.resize(amt);
+        _data = _storage.data();
+        _size = amt;
+    }
+
+    if (!parse()) {
+        CULogError("Bundle %s is corrupt", _name.c_str());
+        dispose();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Initializes an asset bundle from the given file.
+ *
+ * This initializer assumes that the file name is a relative path. It will
+ * search the application assert directory {@see Application#getAssetDirectory()}
+ * for the file and return false if it cannot find it there.
+ *
+ * @param file  the relative path to the bundle
+ *
+ * @return true if the bundle is initialized properly, false otherwise.
+ */
+bool AssetBundle::initWithAsset(const std::string file) {
+    bool absolute = filetool::is_absolute(file);
+    CUAssertLog(!absolute, "This initializer does not accept absolute paths");
+
+    std::string path = Application::get()->getAssetDirectory();
+    path.append(file);
+    return init(path);
+}
+
+/**
+ * Parses the header and index of the bundle contents
+ *
+ * @return true if the bundle is well-formed
+ */
+bool AssetBundle::parse() {
+    if (_data == nullptr || _size < BUNDLE_HEADER || std::memcmp(_data, BUNDLE_MAGIC, 4)) {
+        return false;
+    }
+    if (read_uint32(_data+4) != BUNDLE_VERSION) {
+        CULogError("Bundle %s has unsupported version %u", _name.c_str(), read_uint32(_data+4));
+        return false;
+    }
+
+    Uint64 count = read_uint32(_data+8);
+    Uint64 names = read_uint32(_data+12);
+    Uint64 table = BUNDLE_HEADER+count*BUNDLE_ENTRY;
+    if (table+names > _size) {
+        return false;
+    }
+
+    _index.reserve((size_t)count);
+    for(Uint64 ii = 0; ii < count; ii++) {
+        const Uint8* pos = _data+BUNDLE_HEADER+ii*BUNDLE_ENTRY;
+        Entry entry;
+        entry.offset = read_uint64(pos);
+        entry.stored = read_uint64(pos+8);
+        entry.length = read_uint64(pos+16);
+        Uint32 name  = read_uint32(pos+24);
+        Uint16 size  = read_uint16(pos+28);
+        Uint16 flags = read_uint16(pos+30);
+        entry.compressed = (flags & BUNDLE_LZ4) != 0;
+
+        if ((Uint64)name+size > names || entry.offset > _size || entry.stored > _size-entry.offset) {
+            return false;
+        }
+        if (!entry.compressed && entry.stored != entry.length) {
+            return false;
+        }
+        std::string key((const char*)_data+table+name, size);
+        _index[key] = entry;
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Attributes
+/**
+ * Returns the paths of all files in this bundle
+ *
+ * The paths are in no particular order.
+ *
+ * @return the paths of all files in this bundle
+ */
+std::vector<std::string> AssetBundle::getFiles() const {
+    std::vector<std::string> result;
+    result.reserve(_index.size());
+    for(auto it = _index.begin(); it != _index.end(); ++it) {
+        result.push_back(it->first);
+    }
+    return result;
+}
+
+#pragma mark -
+#pragma mark File Access
+/**
+ * Returns the index entry for the given file, or nullptr if it is missing
+ *
+ * @param file  The path of the file in the bundle
+ *
+ * @return the index entry for the given file, or nullptr if it is missing
+ */
+const AssetBundle::Entry* AssetBundle::find(const std::string& file) const {
+    auto it = _index.find(file);
+    return it == _index.end() ? nullptr : &(it->second);
+}
+
+/**
+ * Returns true if the given file is compressed in this bundle
+ *
+ * @param file  The path of the file in the bundle
+ *
+ * @return true if the given file is compressed in this bundle
+ */
+bool AssetBundle::isCompressed(const std::string& file) const {
+    const Entry* entry = find(file);
+    return entry != nullptr && entry->compressed;
+}
+
+/**
+ * Returns the (uncompressed) size of the given file in bytes
+ *
+ * This method returns 0 if the file is not in this bundle.
+ *
+ * @param file  The path of the file in the bundle
+ *
+ * @return the (uncompressed) size of the given file in bytes
+ */
+size_t AssetBundle::getSize(const std::string& file) const {
+    const Entry* entry = find(file);
+    return entry == nullptr ? 0 : (size_t)entry->length;
+}
+
+/**
+ * Returns a pointer to the contents of the given file
+ *
+ * The pointer is into the bundle itself, and is valid until the bundle
+ * is disposed. This method returns nullptr if the file is missing or is
+ * compressed. Use {@link read} for compressed files.
+ *
+ * @param file  The path of the file in the bundle
+ *
+ * @return a pointer to the contents of the given file
+ */
+const Uint8* AssetBundle::getData(const std::string& file) const {
+    const Entry* entry = find(file);
+    if (entry == nullptr || entry->compressed) {
+        return nullptr;
+    }
+    return _data+entry->offset;
+}
+
+/**
+ * Reads the (uncompressed) contents of the given file into a buffer
+ *
+ * The buffer is resized to fit the file. This method returns false if
+ * the file is missing or cannot be decompressed.
+ *
+ * @param file  The path of the file in the bundle
+ * @param data  The buffer to store the result
+ *
+ * @return true if the file was read successfully
+ */
+bool AssetBundle::read(const std::string& file, std::vector<Uint8>& data) const {
+    const Entry* entry = find(file);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    data.resize((size_t)entry->length);
+    if (!entry->compressed) {
+        if (!data.empty()) {
+            std::memcpy(data.data(), _data+entry->offset, data.size());
+        }
+        return true;
+    }
+    if (!lz4_decode(_data+entry->offset, (size_t)entry->stored, data.data(), data.size())) {
+        CULogError("Could not decompress %s in bundle %s", file.c_str(), _name.c_str());
+        data.clear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Returns a read-only stream for the given file
+ *
+ * For uncompressed files, the stream reads directly from the bundle. A
+ * compressed file is decompressed into memory owned by the stream, and
+ * freed when the stream is closed. In both cases, the stream is a memory
+ * stream, and so {@link BinaryReader#allocMapped} will use it with no
+ * copy.
+ *
+ * This method returns nullptr if the file is missing or cannot be
+ * decompressed.
+ *
+ * @param file  The path of the file in the bundle
+ *
+ * @return a read-only stream for the given file
+ */
+SDL_RWops* AssetBundle::open(const std::string& file) const {
+    const Entry* entry = find(file);
+    if (entry == nullptr || entry->length > SDL_MAX_SINT32) {
+        return nullptr;
+    }
+
+    if (!entry->compressed) {
+        return SDL_RWFromConstMem(_data+entry->offset, (int)entry->length);
+    }
+
+    // The stream takes ownership of the decompressed data
+    size_t length = (size_t)entry->length;
+    Uint8* buffer = (Uint8*)malloc(length ? length : 1);
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+    if (!lz4_decode(_data+entry->offset, (size_t)entry->stored, buffer, length)) {
+        CULogError("Could not decompress %s in bundle %s", file.c_str(), _name.c_str());
+        free(buffer);
+        return nullptr;
+    }
+    SDL_RWops* stream = SDL_RWFromConstMem(buffer, (int)length);
+    if (stream == nullptr) {
+        free(buffer);
+        return nullptr;
+    }
+    stream->close = owned_close;
+    return stream;
+}
+
+#pragma mark -
+#pragma mark Mounting
+/**
+ * Mounts the given bundle, making it visible to {@link openStream}
+ *
+ * The bundle is assumed to hold files from the asset directory. Bundles
+ * mounted later take precedence over those mounted earlier. Mounting a
+ * bundle twice has no effect.
+ *
+ * @param bundle    The bundle to mount
+ */
+void AssetBundle::mount(const std::shared_ptr<AssetBundle>& bundle) {
+    if (bundle == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mountex);
+    if (std::find(_mounted.begin(), _mounted.end(), bundle) == _mounted.end()) {
+        _mounted.push_back(bundle);
+    }
+}
+
+/**
+ * Unmounts the given bundle
+ *
+ * Streams already opened from the bundle remain valid for as long as the
+ * caller keeps a reference to the bundle.
+ *
+ * @param bundle    The bundle to unmount
+ */
+void AssetBundle::unmount(const std::shared_ptr<AssetBundle>& bundle) {
+    std::lock_guard<std::mutex> lock(_mountex);
+    _mounted.erase(std::remove(_mounted.begin(), _mounted.end(), bundle), _mounted.end());
+}
+
+/**
+ * Unmounts all bundles
+ */
+void AssetBundle::unmountAll() {
+    std::lock_guard<std::mutex> lock(_mountex);
+    _mounted.clear();
+}
+
+/**
+ * Returns a read-only stream for the file at the given path
+ *
+ * If the path is in the asset directory, and the file is in a mounted
+ * bundle, this is the stream from the bundle. Otherwise, this is the
+ * same as calling SDL_RWFromFile with mode "rb". This method returns
+ * nullptr if the file cannot be opened.
+ *
+ * @param path  The (normalized) path to the file
+ *
+ * @return a read-only stream for the file at the given path
+ */
+SDL_RWops* AssetBundle::openStream(const std::string& path) {
+    bool search;
+    {
+        std::lock_guard<std::mutex> lock(_mountex);
+        search = !_mounted.empty();
+    }
+
+    if (search) {
+        std::string file = asset_path(path);
+        if (!file.empty()) {
+            std::lock_guard<std::mutex> lock(_mountex);
+            for(auto it = _mounted.rbegin(); it != _mounted.rend(); ++it) {
+                if ((*it)->contains(file)) {
+                    return (*it)->open(file);
+                }
+            }
+        }
+    }
+    return SDL_RWFromFile(path.c_str(), "rb");
+}
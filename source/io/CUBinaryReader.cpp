@@ -10,6 +10,10 @@
 //  long, etc.  Those types are NOT cross-platform.  For example, a long is
 //  8 bytes on Unix/OS X, but 4 bytes on Win32 platforms.
 //
+//  A reader may also be memory-mapped, in which case there is no transfer
+//  buffer and bulk reads can return pointers directly into the file. If the
+//  file is in the byte order of the host, values are never byte swapped.
+//
 //  By default, this module (and every module in the io package) accesses the
 //  application save directory.  If you want to access another directory, you
 //  will need to specify an absolute path for the file name.  Keep in mind that
@@ -51,15 +55,79 @@
 //  Version: 11/28/16
 //
 #include <cugl/io/CUBinaryReader.h>
+#include <cugl/io/CUAssetBundle.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/base/CUApplication.h>
 #include <cugl/base/CUEndian.h>
 #include <cugl/util/CUFiletools.h>
+#include <algorithm>
+#include <cstring>
+
+#if defined (__ANDROID__)
+    #include <android/asset_manager.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#elif defined (__WINDOWS__)
+    #include <windows.h>
+    #include <locale>
+    #include <codecvt>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
 
 using namespace cugl;
 
 #define BUFFSIZE 1024
 
+/**
+ * Returns the given value with its bytes reversed
+ *
+ * @param value The value to swap
+ *
+ * @return the given value with its bytes reversed
+ */
+template <typename T>
+static T swap_bytes(T value) {
+    Uint8 bytes[sizeof(T)];
+    std::memcpy(bytes,&value,sizeof(T));
+    std::reverse(bytes,bytes+sizeof(T));
+    std::memcpy(&value,bytes,sizeof(T));
+    return value;
+}
+
+/**
+ * Returns the value stored at the given (possibly unaligned) address
+ *
+ * @param data  The address of the value
+ * @param swap  Whether to byte swap the value
+ *
+ * @return the value stored at the given address
+ */
+template <typename T>
+static T load_value(const char* data, bool swap) {
+    T value;
+    std::memcpy(&value,data,sizeof(T));
+    return swap ? swap_bytes(value) : value;
+}
+
+/**
+ * Byte swaps the given array in place
+ *
+ * @param data  The array to swap
+ * @param size  The number of elements in the array
+ */
+template <typename T>
+static void swap_array(T* data, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        data[ii] = swap_bytes(data[ii]);
+    }
+}
+
 #pragma mark -
 #pragma mark Constructors
 
@@ -98,7 +166,7 @@ bool BinaryReader::init(const std::string file) {
 bool BinaryReader::init(const std::string file, unsigned int capacity) {
     CUAssertLog(capacity, "The buffer capacity must be positive");
     _name = filetool::normalize_path(file);
-    _stream = SDL_RWFromFile(_name.c_str(), "rb");
+    _stream = AssetBundle::openStream(_name);
     if (!_stream) {
         return false;
     }
@@ -152,7 +220,7 @@ bool BinaryReader::initWithAsset(const std::string file, unsigned int capacity)
     _name.append(file);
     _name = filetool::normalize_path(_name);
     
-    _stream = SDL_RWFromFile(_name.c_str(), "rb");
+    _stream = AssetBundle::openStream(_name);
     if (!_stream) {
         return false;
     }
@@ -167,6 +235,66 @@ bool BinaryReader::initWithAsset(const std::string file, unsigned int capacity)
     return _ssize >= 0;
 }
 
+/**
+ * Initializes a memory-mapped reader for the given file.
+ *
+ * A memory-mapped reader has no transfer buffer. Instead, all reads come
+ * directly from a mapping of the file, and {@link readSpan} can return
+ * pointers into the file with no copy at all. If the file cannot be
+ * mapped, this reader falls back to buffered reads.
+ *
+ * If the file is a relative path, this reader will look for the file in
+ * the application save directory {@see Application#getSaveDirectory()}.
+ * If you wish to read a file in any other directory, you must provide
+ * an absolute path.
+ *
+ * @param file  the path (absolute or relative) to the file
+ *
+ * @return true if the reader is initialized properly, false otherwise.
+ */
+bool BinaryReader::initMapped(const std::string file) {
+    _name = filetool::normalize_path(file);
+    _stream = AssetBundle::openStream(_name);
+    if (!_stream) {
+        return false;
+    }
+
+    _ssize = SDL_RWsize(_stream);
+    _scursor = 0;
+    if (!map()) {
+        _capacity = BUFFSIZE;
+        _buffer = new char[_capacity];
+        _bufsize = 0;
+        fill();
+    }
+    return _ssize >= 0;
+}
+
+/**
+ * Initializes a memory-mapped reader for the given file.
+ *
+ * A memory-mapped reader has no transfer buffer. Instead, all reads come
+ * directly from a mapping of the file, and {@link readSpan} can return
+ * pointers into the file with no copy at all. If the file cannot be
+ * mapped, this reader falls back to buffered reads.
+ *
+ * This initializer assumes that the file name is a relative path. It will
+ * search the application assert directory {@see Application#getAssetDirectory()}
+ * for the file and return false if it cannot find it there.
+ *
+ * @param file  the relative path to the file
+ *
+ * @return true if the reader is initialized properly, false otherwise.
+ */
+bool BinaryReader::initMappedWithAsset(const std::string file) {
+    bool absolute = filetool::is_absolute(file);
+    CUAssertLog(!absolute, "This initializer does not accept absolute paths");
+
+    std::string path = Application::get()->getAssetDirectory();
+    path.append(file);
+    return initMapped(path);
+}
+
 
 #pragma mark -
 #pragma mark Stream Management
@@ -177,15 +305,27 @@ bool BinaryReader::initWithAsset(const std::string file, unsigned int capacity)
  * if the stream has been closed.
  */
 void BinaryReader::reset() {
+    if (_mapped && _stream) {
+        _bufoff = 0;
+        return;
+    }
     if (_stream) {
         close();
     }
-    _stream = SDL_RWFromFile(_name.c_str(), "rb");
+    _stream = AssetBundle::openStream(_name);
     _ssize  = SDL_RWsize(_stream);
+    _scursor = 0;
+    if (_mapped && map()) {
+        return;
+    }
+    if (_mapped || !_capacity) {
+        _capacity = BUFFSIZE;
+        _mapped = false;
+    }
     _buffer = new char[_capacity];
     _bufsize = 0;
-    _bufoff  = 0;
-    _scursor = 0;
+    _bufoff  = -1;
+    fill();
 }
 
 /**
@@ -195,6 +335,9 @@ void BinaryReader::reset() {
  * on a previously closed stream has no effect.
  */
 void BinaryReader::close() {
+    if (_mapped) {
+        unmap();
+    }
     if (_stream) {
         SDL_RWclose(_stream);
         _stream  = nullptr;
@@ -254,6 +397,103 @@ void BinaryReader::fill(unsigned int bytes) {
     _scursor += amt;
 }
 
+/**
+ * Attempts to memory map the open file
+ *
+ * On success, the buffer is the mapping of the entire file. Files from an
+ * asset bundle are already in memory, and are used as is. On Android,
+ * assets are mapped through the asset manager. Otherwise this uses the
+ * native mapping of the platform. If mapping fails, the reader should
+ * fall back to buffered reads.
+ *
+ * @return true if the file was mapped
+ */
+bool BinaryReader::map() {
+    if (!_stream || _ssize <= 0 || _ssize > SDL_MAX_UINT32) {
+        return false;
+    }
+
+    // Streams from an asset bundle are already in memory
+    const char* data = nullptr;
+    if (_stream->type == SDL_RWOPS_MEMORY_RO || _stream->type == SDL_RWOPS_MEMORY) {
+        data = (const char*)_stream->hidden.mem.base;
+    }
+#if defined (__ANDROID__)
+    // Assets live in the APK, so only the asset manager can map them
+    if (data == nullptr && _stream->type == SDL_RWOPS_JNIFILE) {
+        AAsset* asset = (AAsset*)_stream->hidden.androidio.asset;
+        data = (const char*)AAsset_getBuffer(asset);
+    }
+#endif
+#if defined (__WINDOWS__)
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    std::wstring wname = converter.from_bytes(_name);
+    HANDLE file = INVALID_HANDLE_VALUE;
+    if (data == nullptr) {
+        file = CreateFileW(wname.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+        HANDLE handle = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(file);
+        if (handle != NULL) {
+            _mapping = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+            if (_mapping) {
+                _maphandle = handle;
+                data = (const char*)_mapping;
+            } else {
+                CloseHandle(handle);
+            }
+        }
+    }
+#else
+    if (data == nullptr) {
+        int fd = open(_name.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            void* addr = mmap(nullptr, (size_t)_ssize, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (addr != MAP_FAILED) {
+                _mapping = addr;
+                data = (const char*)addr;
+            }
+        }
+    }
+#endif
+
+    if (data == nullptr) {
+        return false;
+    }
+
+    // The mapping is a buffer holding the entire file
+    _mapped   = true;
+    _buffer   = (char*)data;
+    _capacity = (Uint32)_ssize;
+    _bufsize  = (Uint32)_ssize;
+    _bufoff   = 0;
+    _scursor  = _ssize;
+    return true;
+}
+
+/**
+ * Releases the memory mapping (if any)
+ */
+void BinaryReader::unmap() {
+    if (_mapping) {
+#if defined (__WINDOWS__)
+        UnmapViewOfFile(_mapping);
+        CloseHandle((HANDLE)_maphandle);
+        _maphandle = nullptr;
+#else
+        munmap(_mapping, (size_t)_bufsize);
+#endif
+        _mapping = nullptr;
+    }
+    // The buffer belongs to the mapping, so it must not be deleted
+    _buffer  = nullptr;
+    _bufsize = 0;
+    _bufoff  = 0;
+}
+
 #pragma mark -
 #pragma mark Single Element Reads
 /**
@@ -296,9 +536,9 @@ Sint16 BinaryReader::readSint16() {
         fill(2);
     }
     CUAssertLog(_bufsize - _bufoff >= 2, "Too few elements remaining in stream");
-    Sint16* ref = (Sint16*)(&_buffer[_bufoff]);
+    Sint16 value = load_value<Sint16>(&_buffer[_bufoff],_swap);
     _bufoff += 2;
-    return marshall(*ref);
+    return value;
 }
 
 /**
@@ -315,9 +555,9 @@ Uint16 BinaryReader::readUint16() {
         fill(2);
     }
     CUAssertLog(_bufsize - _bufoff >= 2, "Too few elements remaining in stream");
-    Uint16* ref = (Uint16*)(&_buffer[_bufoff]);
+    Uint16 value = load_value<Uint16>(&_buffer[_bufoff],_swap);
     _bufoff += 2;
-    return marshall(*ref);
+    return value;
 }
 
 /**
@@ -334,9 +574,9 @@ Sint32 BinaryReader::readSint32() {
         fill(4);
     }
     CUAssertLog(_bufsize - _bufoff >= 4, "Too few elements remaining in stream");
-    Sint32* ref = (Sint32*)(&_buffer[_bufoff]);
+    Sint32 value = load_value<Sint32>(&_buffer[_bufoff],_swap);
     _bufoff += 4;
-    return marshall(*ref);
+    return value;
 }
 
 
@@ -354,9 +594,9 @@ Uint32 BinaryReader::readUint32() {
         fill(4);
     }
     CUAssertLog(_bufsize - _bufoff >= 4, "Too few elements remaining in stream");
-    Uint32* ref = (Uint32*)(&_buffer[_bufoff]);
+    Uint32 value = load_value<Uint32>(&_buffer[_bufoff],_swap);
     _bufoff += 4;
-    return marshall(*ref);
+    return value;
 }
 
 
@@ -374,9 +614,9 @@ Sint64 BinaryReader::readSint64() {
         fill(8);
     }
     CUAssertLog(_bufsize - _bufoff >= 8, "Too few elements remaining in stream");
-    Sint64* ref = (Sint64*)(&_buffer[_bufoff]);
+    Sint64 value = load_value<Sint64>(&_buffer[_bufoff],_swap);
     _bufoff += 8;
-    return marshall(*ref);
+    return value;
 }
 
 /**
@@ -393,9 +633,9 @@ Uint64 BinaryReader::readUint64() {
         fill(8);
     }
     CUAssertLog(_bufsize - _bufoff >= 8, "Too few elements remaining in stream");
-    Uint64* ref = (Uint64*)(&_buffer[_bufoff]);
+    Uint64 value = load_value<Uint64>(&_buffer[_bufoff],_swap);
     _bufoff += 8;
-    return marshall(*ref);
+    return value;
 }
 
 
@@ -413,9 +653,9 @@ float BinaryReader::readFloat() {
         fill(4);
     }
     CUAssertLog(_bufsize - _bufoff >= 4, "Too few elements remaining in stream");
-    float* ref = (float*)(&_buffer[_bufoff]);
+    float value = load_value<float>(&_buffer[_bufoff],_swap);
     _bufoff += 4;
-    return marshall(*ref);
+    return value;
 }
 
 
@@ -433,9 +673,9 @@ double BinaryReader::readDouble()  {
         fill(8);
     }
     CUAssertLog(_bufsize - _bufoff >= 8, "Too few elements remaining in stream");
-    double* ref = (double*)(&_buffer[_bufoff]);
+    double value = load_value<double>(&_buffer[_bufoff],_swap);
     _bufoff += 8;
-    return marshall(*ref);
+    return value;
 }
 
 
@@ -457,6 +697,9 @@ size_t BinaryReader::read(char* buffer, size_t maximum, size_t offset) {
     CUAssertLog(ready(), "Attempt to read a finished stream");
     unsigned int pos = (unsigned int)offset;
     while (ready(1) && pos-offset < maximum) {
+        if (_bufoff >= _bufsize) {
+            fill();
+        }
         size_t available = _bufsize-_bufoff;
         size_t wanted = maximum-(pos-offset);
         wanted = wanted < available ? wanted : available;
@@ -483,6 +726,9 @@ size_t BinaryReader::read(Uint8* buffer, size_t maximum, size_t offset)  {
     CUAssertLog(ready(), "Attempt to read a finished stream");
     unsigned int pos = (unsigned int)offset;
     while (ready(1) && pos-offset < maximum) {
+        if (_bufoff >= _bufsize) {
+            fill();
+        }
         size_t available = _bufsize-_bufoff;
         size_t wanted = maximum-(pos-offset);
         wanted = wanted < available ? wanted : available;
@@ -513,6 +759,9 @@ size_t BinaryReader::read(Sint16* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 2;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufoff+bytes > _bufsize) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -520,8 +769,8 @@ size_t BinaryReader::read(Sint16* buffer, size_t maximum, size_t offset) {
         _bufoff += (Sint32)wanted;
         pos += (unsigned int)(wanted/bytes);
     }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
+    if (_swap) {
+        swap_array(buffer+offset,pos-offset);
     }
     
     return pos-offset;
@@ -547,6 +796,9 @@ size_t BinaryReader::read(Uint16* buffer, size_t maximum, size_t offset)  {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 2;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufoff+bytes > _bufsize) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -554,8 +806,8 @@ size_t BinaryReader::read(Uint16* buffer, size_t maximum, size_t offset)  {
         _bufoff += (Sint32)wanted;
         pos += (unsigned int)(wanted/bytes);
     }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
+    if (_swap) {
+        swap_array(buffer+offset,pos-offset);
     }
     
     return pos-offset;
@@ -582,6 +834,9 @@ size_t BinaryReader::read(Sint32* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 4;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufoff+bytes > _bufsize) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -589,8 +844,8 @@ size_t BinaryReader::read(Sint32* buffer, size_t maximum, size_t offset) {
         _bufoff += (Sint32)wanted;
         pos += (unsigned int)(wanted/bytes);
     }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
+    if (_swap) {
+        swap_array(buffer+offset,pos-offset);
     }
     
     return pos-offset;
@@ -616,6 +871,9 @@ size_t BinaryReader::read(Uint32* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 4;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufoff+bytes > _bufsize) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -623,8 +881,8 @@ size_t BinaryReader::read(Uint32* buffer, size_t maximum, size_t offset) {
         _bufoff += (Sint32)wanted;
         pos += (unsigned int)(wanted/bytes);
     }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
+    if (_swap) {
+        swap_array(buffer+offset,pos-offset);
     }
     
     return pos-offset;
@@ -650,6 +908,9 @@ size_t BinaryReader::read(Sint64* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 8;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufoff+bytes > _bufsize) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -657,8 +918,8 @@ size_t BinaryReader::read(Sint64* buffer, size_t maximum, size_t offset) {
         _bufoff += (Sint32)wanted;
         pos += (unsigned int)(wanted/bytes);
     }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
+    if (_swap) {
+        swap_array(buffer+offset,pos-offset);
     }
     
     return pos-offset;
@@ -684,6 +945,9 @@ size_t BinaryReader::read(Uint64* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 8;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufoff+bytes > _bufsize) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -691,8 +955,8 @@ size_t BinaryReader::read(Uint64* buffer, size_t maximum, size_t offset) {
         _bufoff += (Sint32)wanted;
         pos += (unsigned int)(wanted/bytes);
     }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
+    if (_swap) {
+        swap_array(buffer+offset,pos-offset);
     }
     
     return pos-offset;
@@ -718,6 +982,9 @@ size_t BinaryReader::read(float* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 4;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufoff+bytes > _bufsize) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -725,8 +992,8 @@ size_t BinaryReader::read(float* buffer, size_t maximum, size_t offset) {
         _bufoff += (Sint32)wanted;
         pos += (unsigned int)(wanted/bytes);
     }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
+    if (_swap) {
+        swap_array(buffer+offset,pos-offset);
     }
     
     return pos-offset;
@@ -752,6 +1019,9 @@ size_t BinaryReader::read(double* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 8;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufoff+bytes > _bufsize) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -759,10 +1029,42 @@ size_t BinaryReader::read(double* buffer, size_t maximum, size_t offset) {
         _bufoff += (Sint32)wanted;
         pos += (unsigned int)(wanted/bytes);
     }
-    for(int ii = (int)offset; ii < pos; ii++) {
-        buffer[ii] = marshall(buffer[ii]);
+    if (_swap) {
+        swap_array(buffer+offset,pos-offset);
     }
     
     return pos-offset;
 }
 
+#pragma mark -
+#pragma mark Zero-Copy Reads
+/**
+ * Returns a pointer to the next bytes of the stream, advancing past them.
+ *
+ * For a memory-mapped reader, this is a pointer into the mapping, and is
+ * valid until the reader is closed. Otherwise, it is a pointer into the
+ * transfer buffer, and is only valid until the next read. In that case,
+ * the request cannot be larger than the buffer capacity.
+ *
+ * This method returns nullptr (and does not advance) if there are too few
+ * bytes remaining.
+ *
+ * @param bytes The number of bytes to read
+ *
+ * @return a pointer to the next bytes of the stream
+ */
+const Uint8* BinaryReader::readBytes(size_t bytes) {
+    if (!ready((unsigned int)bytes)) {
+        return nullptr;
+    }
+    if (!_mapped && _bufoff+bytes > _bufsize) {
+        CUAssertLog(bytes <= _capacity, "Span of %zu bytes exceeds the buffer capacity", bytes);
+        fill((unsigned int)bytes);
+        if (_bufoff+bytes > _bufsize) {
+            return nullptr;
+        }
+    }
+    const Uint8* result = (const Uint8*)(_buffer+_bufoff);
+    _bufoff += (Sint32)bytes;
+    return result;
+}
@@ -55,6 +55,7 @@
 #include <cugl/base/CUEndian.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUFiletools.h>
+#include <cugl/util/CUThreadPool.h>
 #include <cstring>
 
 using namespace cugl;
@@ -110,6 +111,9 @@ bool BinaryWriter::init(const std::string file, unsigned int capacity) {
     _capacity = capacity;
     _cbuffer = new char[_capacity];
     _bufoff = 0;
+    if (_async) {
+        startWorker();
+    }
     
     return (bool)_cbuffer;
 }
@@ -124,9 +128,39 @@ bool BinaryWriter::init(const std::string file, unsigned int capacity) {
  * when the buffer fills, or just before the file is closed.
  */
 void BinaryWriter::flush() {
-    size_t amt = SDL_RWwrite(_stream, _cbuffer, 1, _bufoff);
-    CUAssertLog(amt == _bufoff, "Unable to fully flush the writer");
+    _expired = false;
+    if (_worker == nullptr) {
+        size_t amt = SDL_RWwrite(_stream, _cbuffer, 1, _bufoff);
+        CUAssertLog(amt == _bufoff, "Unable to fully flush the writer");
+        _bufoff = 0;
+        return;
+    } else if (_bufoff == 0) {
+        return;
+    }
+
+    // Wait for the back buffer, then swap
+    std::unique_lock<std::mutex> lock(_mutex);
+    _ready.wait(lock, [this] { return _backsize == 0; });
+    std::swap(_cbuffer, _backbuffer);
+    _backsize = _bufoff;
     _bufoff = 0;
+    _ready.notify_all();
+}
+
+/**
+ * Flushes the contents of the write buffer, waiting until it is written
+ *
+ * For a synchronous writer, this is the same as {@link flush}. For an
+ * asynchronous writer, this blocks until the background thread has
+ * written every buffered byte to the file.
+ */
+void BinaryWriter::sync() {
+    CUAssertLog(_stream, "Attempt to sync a closed stream");
+    flush();
+    if (_worker != nullptr) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _ready.wait(lock, [this] { return _backsize == 0; });
+    }
 }
 
 /**
@@ -135,10 +169,14 @@ void BinaryWriter::flush() {
  * The contents of the buffer are flushed before the file is closed.  Any
  * attempts to write to a closed stream will fail.  Calling this method
  * on a previously closed stream has no effect.
+ *
+ * If the writer is asynchronous, this method waits for the background
+ * thread to write all pending data.
  */
 void BinaryWriter::close() {
     if (_stream) {
         flush();
+        stopWorker();
         SDL_RWclose(_stream);
         _stream  = nullptr;
     }
@@ -146,6 +184,119 @@ void BinaryWriter::close() {
         delete[] _cbuffer;
         _cbuffer = nullptr;
     }
+    if (_backbuffer) {
+        delete[] _backbuffer;
+        _backbuffer = nullptr;
+    }
+}
+
+/**
+ * Sets whether this writer flushes on a background thread
+ *
+ * An asynchronous writer is double buffered. A full buffer is handed to
+ * a background thread, and writing continues into the other buffer. The
+ * writer only blocks if it fills its buffer before the background thread
+ * is done with the previous one. By default, a writer is synchronous.
+ *
+ * Making an asynchronous writer synchronous waits for all pending data
+ * to be written.
+ *
+ * @param value Whether this writer flushes on a background thread
+ */
+void BinaryWriter::setAsync(bool value) {
+    if (_async == value) {
+        return;
+    }
+    _async = value;
+    if (!_stream) {
+        return;
+    } else if (value) {
+        startWorker();
+    } else {
+        flush();
+        stopWorker();
+    }
+}
+
+/**
+ * Sets the time between automatic flushes, in milliseconds
+ *
+ * This value only applies to asynchronous writers. If it is positive,
+ * any data written is flushed once the interval passes, even if the
+ * buffer is not full. The flush happens on the next write after the
+ * interval passes. If it is 0 (the default), data is only written when
+ * the buffer is full, on an explicit flush, or when the file is closed.
+ *
+ * @param millis    The time between automatic flushes, in milliseconds
+ */
+void BinaryWriter::setFlushInterval(Uint32 millis) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _interval = millis;
+    _ready.notify_all();
+}
+
+#pragma mark -
+#pragma mark Background Flushing
+/**
+ * Writes the back buffer to the file until the writer halts
+ *
+ * This is the loop of the background flush thread.
+ */
+void BinaryWriter::backflush() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        if (_backsize > 0) {
+            Uint32 size = _backsize;
+            lock.unlock();
+            size_t amt = SDL_RWwrite(_stream, _backbuffer, 1, size);
+            CUAssertLog(amt == size, "Unable to fully flush the writer");
+            lock.lock();
+            _backsize = 0;
+            _ready.notify_all();
+        } else if (_halt) {
+            break;
+        } else if (_interval > 0) {
+            auto wait = std::chrono::milliseconds(_interval);
+            if (_ready.wait_for(lock, wait) == std::cv_status::timeout) {
+                _expired = true;
+            }
+        } else {
+            _ready.wait(lock);
+        }
+    }
+}
+
+/**
+ * Starts the background flush thread
+ */
+void BinaryWriter::startWorker() {
+    if (_worker != nullptr) {
+        return;
+    }
+    if (_backbuffer == nullptr) {
+        _backbuffer = new char[_capacity];
+    }
+    _halt = false;
+    _backsize = 0;
+    _worker = ThreadPool::alloc(1);
+    _worker->addTask([this] { this->backflush(); });
+}
+
+/**
+ * Stops the background flush thread, writing any pending data
+ */
+void BinaryWriter::stopWorker() {
+    if (_worker == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _halt = true;
+        _ready.notify_all();
+    }
+    // Releasing the pool joins the thread
+    _worker = nullptr;
+    _expired = false;
 }
 
 
@@ -162,7 +313,7 @@ void BinaryWriter::close() {
  */
 void BinaryWriter::write(char c) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
-    if (_bufoff >= _capacity) {
+    if (_bufoff >= _capacity || _expired) {
         flush();
     }
     _cbuffer[_bufoff++] = c;
@@ -179,7 +330,7 @@ void BinaryWriter::write(char c) {
  */
 void BinaryWriter::writeUint8(Uint8 c) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
-    if (_bufoff >= _capacity) {
+    if (_bufoff >= _capacity || _expired) {
         flush();
     }
     _cbuffer[_bufoff++] = c;
@@ -199,7 +350,7 @@ void BinaryWriter::writeUint8(Uint8 c) {
  */
 void BinaryWriter::writeSint16(Sint16 n) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
-    if (_bufoff+2 > _capacity) {
+    if (_bufoff+2 > _capacity || _expired) {
         flush();
     }
     
@@ -222,7 +373,7 @@ void BinaryWriter::writeSint16(Sint16 n) {
  */
 void BinaryWriter::writeUint16(Uint16 n) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
-    if (_bufoff+2 > _capacity) {
+    if (_bufoff+2 > _capacity || _expired) {
         flush();
     }
     
@@ -245,7 +396,7 @@ void BinaryWriter::writeUint16(Uint16 n) {
  */
 void BinaryWriter::writeSint32(Sint32 n) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
-    if (_bufoff+4 > _capacity) {
+    if (_bufoff+4 > _capacity || _expired) {
         flush();
     }
     
@@ -268,7 +419,7 @@ void BinaryWriter::writeSint32(Sint32 n) {
  */
 void BinaryWriter::writeUint32(Uint32 n) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
-    if (_bufoff+4 > _capacity) {
+    if (_bufoff+4 > _capacity || _expired) {
         flush();
     }
     
@@ -291,7 +442,7 @@ void BinaryWriter::writeUint32(Uint32 n) {
  */
 void BinaryWriter::writeSint64(Sint64 n) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
-    if (_bufoff+8 > _capacity) {
+    if (_bufoff+8 > _capacity || _expired) {
         flush();
     }
     
@@ -314,7 +465,7 @@ void BinaryWriter::writeSint64(Sint64 n) {
  */
 void BinaryWriter::writeUint64(Uint64 n) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
-    if (_bufoff+8 > _capacity) {
+    if (_bufoff+8 > _capacity || _expired) {
         flush();
     }
     
@@ -338,7 +489,7 @@ void BinaryWriter::writeUint64(Uint64 n) {
  */
 void BinaryWriter::writeFloat(float n) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
-    if (_bufoff+4 > _capacity) {
+    if (_bufoff+4 > _capacity || _expired) {
         flush();
     }
     
@@ -362,7 +513,7 @@ void BinaryWriter::writeFloat(float n) {
  */
 void BinaryWriter::writeDouble(double n) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
-    if (_bufoff+8 > _capacity) {
+    if (_bufoff+8 > _capacity || _expired) {
         flush();
     }
     
@@ -390,9 +541,15 @@ void BinaryWriter::write(const char* array, size_t length, size_t offset) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
     size_t pos = 0;
     
-    if (_bufoff+length > _capacity) {
+    if (_bufoff+length > _capacity || _expired) {
         flush();
     }
+    if (length >= _capacity && _worker == nullptr) {
+        // Skip the buffer entirely
+        size_t amt = SDL_RWwrite(_stream, &(array[offset]), 1, length);
+        CUAssertLog(amt == length, "Unable to fully write the array");
+        return;
+    }
     while (length-pos > _capacity-_bufoff) {
         memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]),_capacity-_bufoff);
         pos += _capacity-_bufoff;
@@ -418,10 +575,16 @@ void BinaryWriter::write(const char* array, size_t length, size_t offset) {
 void BinaryWriter::write(const Uint8* array, size_t length, size_t offset) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
     size_t pos = 0;
-        
-    if (_bufoff+length > _capacity) {
+    
+    if (_bufoff+length > _capacity || _expired) {
         flush();
     }
+    if (length >= _capacity && _worker == nullptr) {
+        // Skip the buffer entirely
+        size_t amt = SDL_RWwrite(_stream, &(array[offset]), 1, length);
+        CUAssertLog(amt == length, "Unable to fully write the array");
+        return;
+    }
     while (length-pos > _capacity-_bufoff) {
         memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]),_capacity-_bufoff);
         pos += _capacity-_bufoff;
@@ -452,12 +615,12 @@ void BinaryWriter::write(const Sint16* array, size_t length, size_t offset) {
     size_t pos = 0;
     
     unsigned int bytes = 2;
-    if (_bufoff+length*bytes > _capacity) {
+    if (_bufoff+length*bytes > _capacity || _expired) {
         flush();
     }
     while ((length-pos)*bytes > _capacity-_bufoff) {
         unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
+        memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]),skip);
         
         for(int ii = 0; ii < skip; ii += bytes) {
             Sint16* ref = (Sint16*)(&_cbuffer[_bufoff+ii]);
@@ -498,12 +661,12 @@ void BinaryWriter::write(const Uint16* array, size_t length, size_t offset) {
     size_t pos = 0;
     
     unsigned int bytes = 2;
-    if (_bufoff+length*bytes > _capacity) {
+    if (_bufoff+length*bytes > _capacity || _expired) {
         flush();
     }
     while ((length-pos)*bytes > _capacity-_bufoff) {
         unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
+        memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]),skip);
         
         for(int ii = 0; ii < skip; ii += bytes) {
             Uint16* ref = (Uint16*)(&_cbuffer[_bufoff+ii]);
@@ -544,12 +707,12 @@ void BinaryWriter::write(const Sint32* array, size_t length, size_t offset) {
     size_t pos = 0;
     
     unsigned int bytes = 4;
-    if (_bufoff+length*bytes > _capacity) {
+    if (_bufoff+length*bytes > _capacity || _expired) {
         flush();
     }
     while ((length-pos)*bytes > _capacity-_bufoff) {
         unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
+        memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]),skip);
         
         for(int ii = 0; ii < skip; ii += bytes) {
             Sint32* ref = (Sint32*)(&_cbuffer[_bufoff+ii]);
@@ -591,12 +754,12 @@ void BinaryWriter::write(const Uint32* array, size_t length, size_t offset) {
     size_t pos = 0;
     
     unsigned int bytes = 4;
-    if (_bufoff+length*bytes > _capacity) {
+    if (_bufoff+length*bytes > _capacity || _expired) {
         flush();
     }
     while ((length-pos)*bytes > _capacity-_bufoff) {
         unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
+        memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]),skip);
         
         for(int ii = 0; ii < skip; ii += bytes) {
             Uint32* ref = (Uint32*)(&_cbuffer[_bufoff+ii]);
@@ -638,12 +801,12 @@ void BinaryWriter::write(const Sint64* array, size_t length, size_t offset) {
     size_t pos = 0;
     
     unsigned int bytes = 8;
-    if (_bufoff+length*bytes > _capacity) {
+    if (_bufoff+length*bytes > _capacity || _expired) {
         flush();
     }
     while ((length-pos)*bytes > _capacity-_bufoff) {
         unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
+        memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]),skip);
         
         for(int ii = 0; ii < skip; ii += bytes) {
             Sint64* ref = (Sint64*)(&_cbuffer[_bufoff+ii]);
@@ -685,12 +848,12 @@ void BinaryWriter::write(const Uint64* array, size_t length, size_t offset) {
     size_t pos = 0;
     
     unsigned int bytes = 8;
-    if (_bufoff+length*bytes > _capacity) {
+    if (_bufoff+length*bytes > _capacity || _expired) {
         flush();
     }
     while ((length-pos)*bytes > _capacity-_bufoff) {
         unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
+        memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]),skip);
         
         for(int ii = 0; ii < skip; ii += bytes) {
             Uint64* ref = (Uint64*)(&_cbuffer[_bufoff+ii]);
@@ -732,12 +895,12 @@ void BinaryWriter::write(const float* array, size_t length, size_t offset) {
     size_t pos = 0;
     
     unsigned int bytes = 4;
-    if (_bufoff+length*bytes > _capacity) {
+    if (_bufoff+length*bytes > _capacity || _expired) {
         flush();
     }
     while ((length-pos)*bytes > _capacity-_bufoff) {
         unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
+        memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]),skip);
         
         for(int ii = 0; ii < skip; ii += bytes) {
             float* ref = (float*)(&_cbuffer[_bufoff+ii]);
@@ -778,12 +941,12 @@ void BinaryWriter::write(const double* array, size_t length, size_t offset) {
     size_t pos = 0;
     
     unsigned int bytes = 8;
-    if (_bufoff+length*bytes > _capacity) {
+    if (_bufoff+length*bytes > _capacity || _expired) {
         flush();
     }
     while ((length-pos)*bytes > _capacity-_bufoff) {
         unsigned int skip = bytes*((_capacity-_bufoff)/bytes);
-        memcpy(&(_cbuffer[_bufoff]), &(array[pos]),skip);
+        memcpy(&(_cbuffer[_bufoff]), &(array[pos+offset]),skip);
         
         for(int ii = 0; ii < skip; ii += bytes) {
             double* ref = (double*)(&_cbuffer[_bufoff+ii]);
@@ -804,3 +967,33 @@ void BinaryWriter::write(const double* array, size_t length, size_t offset) {
     
     _bufoff += skip;
 }
+
+/**
+ * Writes a sequence of byte chunks to the binary file.
+ *
+ * This is the analogue of writev. Each chunk is a pointer and a length
+ * (in bytes). The chunks are written in order, and the buffer is flushed
+ * at most once before writing, instead of once per chunk. No marshalling
+ * is performed.
+ *
+ * The chunks are written to the internal buffer, but are not necessarily
+ * flushed automatically.  They will be written when the buffer reaches
+ * capacity or the file is closed.
+ *
+ * @param chunks    the chunks to write
+ */
+void BinaryWriter::writeChunks(std::initializer_list<std::pair<const void*,size_t>> chunks) {
+    CUAssertLog(_stream, "Attempt to write to a closed stream");
+    size_t total = 0;
+    for(auto it = chunks.begin(); it != chunks.end(); ++it) {
+        total += it->second;
+    }
+    if (_bufoff+total > _capacity || _expired) {
+        flush();
+    }
+    for(auto it = chunks.begin(); it != chunks.end(); ++it) {
+        if (it->second > 0) {
+            write((const Uint8*)it->first, it->second);
+        }
+    }
+}
@@ -6,6 +6,11 @@
 //  It does not require that the entire file conform to JSON standards; it can
 //  read a JSON string embedded in a larger text file.
 //
+//  In addition to building a JsonValue (or JsonDocument), this reader has an
+//  event-driven interface for very large files. This interface reports each
+//  node to a JsonHandler as it is read, directly from the stream buffer, so
+//  the memory used is bounded by the nesting depth and the longest string.
+//
 //  By default, this module (and every module in the io package) accesses the
 //  application save directory.  If you want to access another directory, you
 //  will need to specify an absolute path for the file name.  Keep in mind that
@@ -48,9 +53,74 @@
 //
 #include <cugl/io/CUJsonReader.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUStrings.h>
+#include <cstdlib>
+#include <cctype>
+#include <vector>
 
 using namespace cugl;
 
+/** The maximum number of array values reported in a single batch */
+#define NUMBER_BATCH    1024
+/** The maximum nesting depth of a JSON value */
+#define MAX_DEPTH       1000
+
+/**
+ * Returns the value of the given hexadecimal digit, or -1 if invalid
+ *
+ * @param c     The hexadecimal digit
+ *
+ * @return the value of the given hexadecimal digit, or -1 if invalid
+ */
+static int hex_value(int c) {
+    if (c >= '0' && c <= '9') {
+        return c-'0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c-'a'+10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c-'A'+10;
+    }
+    return -1;
+}
+
+/**
+ * Appends the UTF-8 encoding of the given code point to the string
+ *
+ * @param data  The string to append to
+ * @param code  The unicode code point
+ */
+static void utf8_append(std::string& data, Uint32 code) {
+    if (code < 0x80) {
+        data.push_back((char)code);
+    } else if (code < 0x800) {
+        data.push_back((char)(0xC0 | (code >> 6)));
+        data.push_back((char)(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        data.push_back((char)(0xE0 | (code >> 12)));
+        data.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+        data.push_back((char)(0x80 | (code & 0x3F)));
+    } else {
+        data.push_back((char)(0xF0 | (code >> 18)));
+        data.push_back((char)(0x80 | ((code >> 12) & 0x3F)));
+        data.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+        data.push_back((char)(0x80 | (code & 0x3F)));
+    }
+}
+
+/**
+ * Returns true if the character may appear in a JSON number
+ *
+ * @param c     The character to test
+ *
+ * @return true if the character may appear in a JSON number
+ */
+static bool is_numeric(int c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+#pragma mark -
+#pragma mark Read Methods
+
 /**
  * Returns the next available JSON string
  *
@@ -116,3 +186,348 @@ std::shared_ptr<JsonValue> JsonReader::readJson() {
     }
     return nullptr;
 }
+
+/**
+ * Returns a newly allocated JsonDocument for the next available JSON string.
+ *
+ * This method uses {@link readJsonString()} to extract the next available
+ * JSON string and constructs a JsonDocument from that. The document takes
+ * ownership of the string, so it is not copied. This is the preferred way
+ * to read large, read-only files such as levels.
+ *
+ * If there is a parsing error, this  method will return nullptr.  Detailed
+ * information about the parsing error will be passed to an assert.  Hence
+ * error messages are suppressed if asserts are turned off.
+ *
+ * @return a newly allocated JsonDocument for the next available JSON string.
+ */
+std::shared_ptr<JsonDocument> JsonReader::readDocument() {
+    std::string data = readJsonString();
+    if (!data.empty()) {
+        return JsonDocument::allocWithJson(std::move(data));
+    }
+    return nullptr;
+}
+
+/**
+ * Reads the next available JSON value, reporting it to the given handler.
+ *
+ * Unlike {@link readJson}, this method does not build a tree. Each node
+ * is reported to the handler as it is read, straight from the stream
+ * buffer. The memory used is bounded by the nesting depth, the longest
+ * string, and the batch size for numeric arrays. This is the preferred
+ * way to visit a very large file (such as a tile map or replay) once.
+ *
+ * The value must be an object or an array. This method will skip over
+ * any whitespace to find it. It stops after the closing brace or bracket,
+ * so a stream may contain several values in sequence.
+ *
+ * If there is a parsing error, this method will return false.  Detailed
+ * information about the parsing error will be passed to an assert.  Hence
+ * error messages are suppressed if asserts are turned off. This method
+ * also returns false if the handler stops the reader early.
+ *
+ * @param handler   The receiver for the parsing events
+ *
+ * @return true if the value was read completely
+ */
+bool JsonReader::readEvents(JsonHandler& handler) {
+    CUAssertLog(ready(), "Attempt to read a finished stream");
+    int c = skipSpace();
+    if (c != '{' && c != '[') {
+        CUAssertLog(false, "JSON is missing initial { or [");
+        return false;
+    }
+
+    std::vector<char> stack;    // The open containers
+    std::vector<double> batch;  // Pending numbers in the current array
+    std::string token;
+    batch.reserve(NUMBER_BATCH);
+
+    // Reports the pending numbers (if any) to the handler
+    auto flush = [&]() {
+        bool result = batch.empty() || handler.numbers(batch.data(),batch.size());
+        batch.clear();
+        return result;
+    };
+
+    bool member = false;    // Whether we expect an object key
+    while (true) {
+        c = skipSpace();
+        if (member) {
+            if (c != '"' || !readQuoted(token)) {
+                CUAssertLog(false, "JSON object has an invalid key");
+                return false;
+            } else if (!handler.key(token)) {
+                return false;
+            } else if (skipSpace() != ':') {
+                CUAssertLog(false, "JSON object key '%s' is missing :",token.c_str());
+                return false;
+            }
+            _bufoff++;
+            c = skipSpace();
+            member = false;
+        }
+
+        // Read a value
+        bool open = false;
+        switch (c) {
+            case '{':
+            case '[':
+                if (stack.size() >= MAX_DEPTH) {
+                    CUAssertLog(false, "JSON exceeds the maximum depth %d",MAX_DEPTH);
+                    return false;
+                } else if (!flush()) {
+                    return false;
+                }
+                _bufoff++;
+                stack.push_back((char)c);
+                if (!(c == '{' ? handler.startObject() : handler.startArray())) {
+                    return false;
+                }
+                // Check for an empty container
+                c = skipSpace();
+                if (c == (stack.back() == '{' ? '}' : ']')) {
+                    break;
+                }
+                member = (stack.back() == '{');
+                open = true;
+                break;
+            case '"':
+                if (!flush() || !readQuoted(token) || !handler.string(token)) {
+                    return false;
+                }
+                break;
+            case 't':
+                if (!flush() || !readLiteral("true") || !handler.boolean(true)) {
+                    return false;
+                }
+                break;
+            case 'f':
+                if (!flush() || !readLiteral("false") || !handler.boolean(false)) {
+                    return false;
+                }
+                break;
+            case 'n':
+                if (!flush() || !readLiteral("null") || !handler.null()) {
+                    return false;
+                }
+                break;
+            default:
+            {
+                double value;
+                if (!readNumber(token,value)) {
+                    return false;
+                } else if (stack.back() == '[') {
+                    batch.push_back(value);
+                    if (batch.size() == NUMBER_BATCH && !flush()) {
+                        return false;
+                    }
+                } else if (!handler.number(value)) {
+                    return false;
+                }
+            }
+                break;
+        }
+        if (open) {
+            continue;
+        }
+
+        // Close any finished containers
+        c = skipSpace();
+        while (c == '}' || c == ']') {
+            if (c != (stack.back() == '{' ? '}' : ']')) {
+                CUAssertLog(false, "JSON has a mismatched %c",(char)c);
+                return false;
+            }
+            _bufoff++;
+            if (!flush() || !(c == '}' ? handler.endObject() : handler.endArray())) {
+                return false;
+            }
+            stack.pop_back();
+            if (stack.empty()) {
+                return true;
+            }
+            c = skipSpace();
+        }
+
+        if (c != ',') {
+            CUAssertLog(false, c < 0 ? "JSON is missing closing } or ]" : "JSON is missing ,");
+            return false;
+        }
+        _bufoff++;
+        member = (stack.back() == '{');
+    }
+    return false;
+}
+
+#pragma mark -
+#pragma mark Event Parsing
+/**
+ * Returns the next character in the stream without consuming it
+ *
+ * This method refills the buffer as necessary.
+ *
+ * @return the next character in the stream, or -1 at the end
+ */
+int JsonReader::peekChar() {
+    if (_bufoff < 0 || _bufoff >= (Sint32)_sbuffer.size()) {
+        if (!ready()) {
+            return -1;
+        }
+        fill();
+        if (_bufoff < 0 || _bufoff >= (Sint32)_sbuffer.size()) {
+            return -1;
+        }
+    }
+    return (unsigned char)_sbuffer[_bufoff];
+}
+
+/**
+ * Skips over any whitespace in the stream
+ *
+ * Unlike {@link TextReader#skip}, this method is safe at the end of the
+ * stream.
+ *
+ * @return the next non-whitespace character, or -1 at the end
+ */
+int JsonReader::skipSpace() {
+    int c = peekChar();
+    while (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+        _bufoff++;
+        c = peekChar();
+    }
+    return c;
+}
+
+/**
+ * Reads a string (including the quotes) into the given buffer
+ *
+ * Escape sequences are decoded as they are read.
+ *
+ * @param data  The buffer to store the string
+ *
+ * @return true if the string was read successfully
+ */
+bool JsonReader::readQuoted(std::string& data) {
+    data.clear();
+    _bufoff++; // Opening quote
+    while (true) {
+        if (peekChar() < 0) {
+            CUAssertLog(false, "JSON string is missing closing \"");
+            return false;
+        }
+
+        // Copy the unescaped run in one step
+        size_t start = _bufoff;
+        size_t pos = _sbuffer.find_first_of("\"\\",start);
+        if (pos == std::string::npos) {
+            data.append(_sbuffer,start,std::string::npos);
+            _bufoff = (Sint32)_sbuffer.size();
+            continue;
+        }
+        data.append(_sbuffer,start,pos-start);
+        _bufoff = (Sint32)pos+1;
+        if (_sbuffer[pos] == '"') {
+            return true;
+        }
+
+        // Escape sequence
+        int c = peekChar();
+        _bufoff++;
+        switch (c) {
+            case '"':  data.push_back('"');  break;
+            case '\\': data.push_back('\\'); break;
+            case '/':  data.push_back('/');  break;
+            case 'b':  data.push_back('\b'); break;
+            case 'f':  data.push_back('\f'); break;
+            case 'n':  data.push_back('\n'); break;
+            case 'r':  data.push_back('\r'); break;
+            case 't':  data.push_back('\t'); break;
+            case 'u':
+            {
+                Uint32 code = 0;
+                for(int ii = 0; ii < 4; ii++) {
+                    int digit = hex_value(peekChar());
+                    if (digit < 0) {
+                        CUAssertLog(false, "JSON string has an invalid \\u escape");
+                        return false;
+                    }
+                    code = (code << 4) | digit;
+                    _bufoff++;
+                }
+                // Combine surrogate pairs
+                if (code >= 0xD800 && code < 0xDC00 && peekChar() == '\\') {
+                    _bufoff++;
+                    Uint32 low = 0;
+                    if (peekChar() == 'u') {
+                        _bufoff++;
+                        for(int ii = 0; ii < 4; ii++) {
+                            int digit = hex_value(peekChar());
+                            if (digit < 0) {
+                                CUAssertLog(false, "JSON string has an invalid \\u escape");
+                                return false;
+                            }
+                            low = (low << 4) | digit;
+                            _bufoff++;
+                        }
+                    }
+                    if (low < 0xDC00 || low >= 0xE000) {
+                        CUAssertLog(false, "JSON string has an invalid surrogate pair");
+                        return false;
+                    }
+                    code = 0x10000+((code-0xD800) << 10)+(low-0xDC00);
+                }
+                utf8_append(data,code);
+            }
+                break;
+            default:
+                CUAssertLog(false, "JSON string has an invalid escape");
+                return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * Reads a number into the given value
+ *
+ * @param token The scratch buffer for the number text
+ * @param value The value to store the number
+ *
+ * @return true if the number was read successfully
+ */
+bool JsonReader::readNumber(std::string& token, double& value) {
+    token.clear();
+    int c = peekChar();
+    while (is_numeric(c)) {
+        token.push_back((char)c);
+        _bufoff++;
+        c = peekChar();
+    }
+
+    value = 0;
+    if (token.empty() || strtool::from_chars(token.data(),token.size(),value) != token.size()) {
+        CUAssertLog(false, "JSON has an invalid value '%s'",token.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Reads the given literal (e.g. "true") from the stream
+ *
+ * @param word  The literal to read
+ *
+ * @return true if the literal was read successfully
+ */
+bool JsonReader::readLiteral(const char* word) {
+    for(const char* ch = word; *ch; ch++) {
+        if (peekChar() != *ch) {
+            CUAssertLog(false, "JSON has an invalid value (expected '%s')",word);
+            return false;
+        }
+        _bufoff++;
+    }
+    return true;
+}
@@ -64,6 +64,7 @@ using namespace cugl;
  */
 void JsonWriter::writeJson(const JsonValue* json, bool format) {
     CUAssertLog(json, "Attempt to write a nullptr JSON");
-    std::string data = json->toString(format);
-    writeLine(data);
+    _encoding.clear();
+    json->toString(_encoding,format);
+    writeLine(_encoding);
 }
@@ -47,6 +47,7 @@
 //  Version: 11/22/16
 //
 #include <cugl/io/CUTextReader.h>
+#include <cugl/io/CUAssetBundle.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUFiletools.h>
 #include <cugl/base/CUApplication.h>
@@ -95,7 +96,7 @@ bool TextReader::init(const std::string file) {
 bool TextReader::init(const std::string file, unsigned int capacity) {
     CUAssertLog(capacity, "The buffer capacity must be positive");
     _name = filetool::normalize_path(file);
-    _stream = SDL_RWFromFile(_name.c_str(), "r");
+    _stream = AssetBundle::openStream(_name);
     if (!_stream) {
         return false;
     }
@@ -149,7 +150,7 @@ bool TextReader::initWithAsset(const std::string file, unsigned int capacity) {
     _name.append(file);
     _name = filetool::normalize_path(_name);
 
-    _stream = SDL_RWFromFile(_name.c_str(), "r");
+    _stream = AssetBundle::openStream(_name);
     if (!_stream) {
         return false;
     }
@@ -177,7 +178,7 @@ void TextReader::reset() {
     if (_stream) {
         close();
     }
-    _stream = SDL_RWFromFile(_name.c_str(), "r");
+    _stream = AssetBundle::openStream(_name);
     _ssize  = SDL_RWsize(_stream);
     _cbuffer = new char[_capacity];
     _sbuffer.clear();
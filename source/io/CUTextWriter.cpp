@@ -50,6 +50,7 @@
 #include <cugl/base/CUApplication.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUFiletools.h>
+#include <cugl/util/CUThreadPool.h>
 #include <cstring>
 
 using namespace cugl;
@@ -105,6 +106,9 @@ bool TextWriter::init(const std::string file, unsigned int capacity) {
     _capacity = capacity;
     _cbuffer = new char[_capacity];
     _bufoff = 0;
+    if (_async) {
+        startWorker();
+    }
     
     return (bool)_cbuffer;
 }
@@ -119,9 +123,39 @@ bool TextWriter::init(const std::string file, unsigned int capacity) {
  * when the buffer fills, or just before the file is closed.
  */
 void TextWriter::flush() {
-    size_t amt = SDL_RWwrite(_stream, _cbuffer, 1, _bufoff);
-    CUAssertLog(amt == _bufoff, "Unable to fully flush the writer");
+    _expired = false;
+    if (_worker == nullptr) {
+        size_t amt = SDL_RWwrite(_stream, _cbuffer, 1, _bufoff);
+        CUAssertLog(amt == _bufoff, "Unable to fully flush the writer");
+        _bufoff = 0;
+        return;
+    } else if (_bufoff == 0) {
+        return;
+    }
+
+    // Wait for the back buffer, then swap
+    std::unique_lock<std::mutex> lock(_mutex);
+    _ready.wait(lock, [this] { return _backsize == 0; });
+    std::swap(_cbuffer, _backbuffer);
+    _backsize = _bufoff;
     _bufoff = 0;
+    _ready.notify_all();
+}
+
+/**
+ * Flushes the contents of the write buffer, waiting until it is written
+ *
+ * For a synchronous writer, this is the same as {@link flush}. For an
+ * asynchronous writer, this blocks until the background thread has
+ * written every buffered byte to the file.
+ */
+void TextWriter::sync() {
+    CUAssertLog(_stream, "Attempt to sync a closed stream");
+    flush();
+    if (_worker != nullptr) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _ready.wait(lock, [this] { return _backsize == 0; });
+    }
 }
 
 /**
@@ -130,10 +164,14 @@ void TextWriter::flush() {
  * The contents of the buffer are flushed before the file is closed.  Any
  * attempts to write to a closed stream will fail.  Calling this method
  * on a previously closed stream has no effect.
+ *
+ * If the writer is asynchronous, this method waits for the background
+ * thread to write all pending data.
  */
 void TextWriter::close() {
     if (_stream) {
         flush();
+        stopWorker();
         SDL_RWclose(_stream);
         _stream  = nullptr;
     }
@@ -141,6 +179,119 @@ void TextWriter::close() {
         delete[] _cbuffer;
         _cbuffer = nullptr;
     }
+    if (_backbuffer) {
+        delete[] _backbuffer;
+        _backbuffer = nullptr;
+    }
+}
+
+/**
+ * Sets whether this writer flushes on a background thread
+ *
+ * An asynchronous writer is double buffered. A full buffer is handed to
+ * a background thread, and writing continues into the other buffer. The
+ * writer only blocks if it fills its buffer before the background thread
+ * is done with the previous one. By default, a writer is synchronous.
+ *
+ * Making an asynchronous writer synchronous waits for all pending data
+ * to be written.
+ *
+ * @param value Whether this writer flushes on a background thread
+ */
+void TextWriter::setAsync(bool value) {
+    if (_async == value) {
+        return;
+    }
+    _async = value;
+    if (!_stream) {
+        return;
+    } else if (value) {
+        startWorker();
+    } else {
+        flush();
+        stopWorker();
+    }
+}
+
+/**
+ * Sets the time between automatic flushes, in milliseconds
+ *
+ * This value only applies to asynchronous writers. If it is positive,
+ * any data written is flushed once the interval passes, even if the
+ * buffer is not full. The flush happens on the next write after the
+ * interval passes. If it is 0 (the default), data is only written when
+ * the buffer is full, on an explicit flush, or when the file is closed.
+ *
+ * @param millis    The time between automatic flushes, in milliseconds
+ */
+void TextWriter::setFlushInterval(Uint32 millis) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _interval = millis;
+    _ready.notify_all();
+}
+
+#pragma mark -
+#pragma mark Background Flushing
+/**
+ * Writes the back buffer to the file until the writer halts
+ *
+ * This is the loop of the background flush thread.
+ */
+void TextWriter::backflush() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        if (_backsize > 0) {
+            Uint32 size = _backsize;
+            lock.unlock();
+            size_t amt = SDL_RWwrite(_stream, _backbuffer, 1, size);
+            CUAssertLog(amt == size, "Unable to fully flush the writer");
+            lock.lock();
+            _backsize = 0;
+            _ready.notify_all();
+        } else if (_halt) {
+            break;
+        } else if (_interval > 0) {
+            auto wait = std::chrono::milliseconds(_interval);
+            if (_ready.wait_for(lock, wait) == std::cv_status::timeout) {
+                _expired = true;
+            }
+        } else {
+            _ready.wait(lock);
+        }
+    }
+}
+
+/**
+ * Starts the background flush thread
+ */
+void TextWriter::startWorker() {
+    if (_worker != nullptr) {
+        return;
+    }
+    if (_backbuffer == nullptr) {
+        _backbuffer = new char[_capacity];
+    }
+    _halt = false;
+    _backsize = 0;
+    _worker = ThreadPool::alloc(1);
+    _worker->addTask([this] { this->backflush(); });
+}
+
+/**
+ * Stops the background flush thread, writing any pending data
+ */
+void TextWriter::stopWorker() {
+    if (_worker == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _halt = true;
+        _ready.notify_all();
+    }
+    // Releasing the pool joins the thread
+    _worker = nullptr;
+    _expired = false;
 }
 
 
@@ -157,7 +308,7 @@ void TextWriter::close() {
  */
 void TextWriter::write(char c) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
-    if (_bufoff >= _capacity) {
+    if (_bufoff >= _capacity || _expired) {
         flush();
     }
     _cbuffer[_bufoff++] = c;
@@ -177,7 +328,7 @@ void TextWriter::write(const char* s) {
     size_t pos = 0;
     size_t len = strlen(s);
 
-    if (_bufoff+len >  _capacity) {
+    if (_bufoff+len >  _capacity || _expired) {
         flush();
     }
     while (len-pos > _capacity-_bufoff) {
@@ -200,10 +351,10 @@ void TextWriter::write(const char* s) {
  *
  * @param s  the string to write
  */
-void TextWriter::write(const std::string s) {
+void TextWriter::write(const std::string& s) {
     CUAssertLog(_stream, "Attempt to write to a closed stream");
     size_t pos = 0;
-    if (_bufoff+s.size() > _capacity) {
+    if (_bufoff+s.size() > _capacity || _expired) {
         flush();
     }
     while (s.size()-pos > _capacity-_bufoff) {
@@ -222,13 +373,36 @@ void TextWriter::write(const std::string s) {
  *
  * The newline used is a standard Unix newline '\n'. You should not expect
  * Windows-style carriage returns (e.g. '\r'). This method automatically
- * flushes the buffer when done.
+ * flushes the buffer when done, unless the writer is asynchronous. An
+ * asynchronous writer relies on the flush interval instead, so that each
+ * line does not wait on the background thread.
  *
  * @param s  the string to write
  */
-void TextWriter::writeLine(const std::string s) {
+void TextWriter::writeLine(const std::string& s) {
     write(s);
     write('\n');
-    flush();
+    if (_worker == nullptr) {
+        flush();
+    }
+}
+
+/**
+ * Writes a sequence of strings (ASCII or UTF8) to the file, each followed by a newline
+ *
+ * The newline used is a standard Unix newline '\n'. The buffer is flushed
+ * at most once for the entire batch (as with {@link writeLine}), instead
+ * of once per line.
+ *
+ * @param lines  the strings to write
+ */
+void TextWriter::writeLines(const std::vector<std::string>& lines) {
+    for(auto it = lines.begin(); it != lines.end(); ++it) {
+        write(*it);
+        write('\n');
+    }
+    if (_worker == nullptr) {
+        flush();
+    }
 }
 
@@ -954,12 +954,92 @@ Vec2* Affine2::transform(const Affine2& aff, const Vec2 point, Vec2* dst) {
  * @return A reference to dst for chaining
  */
 float* Affine2::transform(const Affine2& aff, float const* input, float* output, size_t size) {
-    for(size_t ii = 0; ii < size; ii++) {
-        float x = aff.m[0]*input[2*ii]+aff.m[2]*input[2*ii+1]+aff.m[4];
-        float y = aff.m[1]*input[2*ii]+aff.m[3]*input[2*ii+1]+aff.m[5];
-        output[2*ii  ] = x;
-        output[2*ii+1] = y;
+    return transform(aff,input,output,size,2);
+}
+
+/**
+ * Transforms the strided vector array, and stores the result in dst.
+ *
+ * The vector is array is treated as a list of 2 element vectors (@see Vec2),
+ * where consecutive vectors are stride floats apart. This allows the method
+ * to transform the positions of interleaved vertex data in place, such as
+ * an array of {@link SpriteVertex2}. Floats between the vectors are left
+ * untouched. The input and output may be the same array.
+ *
+ * This method uses the vectorized algorithm, if available.
+ *
+ * @param aff       The transform matrix.
+ * @param input     The array of vectors to transform.
+ * @param output    The array to store the transformed vectors.
+ * @param size      The number of vectors in the two arrays.
+ * @param stride    The number of floats from one vector to the next
+ *
+ * @return A reference to dst for chaining
+ */
+float* Affine2::transform(const Affine2& aff, float const* input, float* output,
+                          size_t size, size_t stride) {
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    // Two vectors per register as (x0,y0,x1,y1)
+    __m128 col0 = _mm_set_ps(aff.m[1],aff.m[0],aff.m[1],aff.m[0]);
+    __m128 col1 = _mm_set_ps(aff.m[3],aff.m[2],aff.m[3],aff.m[2]);
+    __m128 offs = _mm_set_ps(aff.m[5],aff.m[4],aff.m[5],aff.m[4]);
+    for(; ii+1 < size; ii += 2) {
+        const float* src = input+ii*stride;
+        float* dst = output+ii*stride;
+        __m128 data = _mm_loadl_pi(_mm_setzero_ps(),(const __m64*)src);
+        data = _mm_loadh_pi(data,(const __m64*)(src+stride));
+        __m128 xs = _mm_shuffle_ps(data,data,_MM_SHUFFLE(2,2,0,0));
+        __m128 ys = _mm_shuffle_ps(data,data,_MM_SHUFFLE(3,3,1,1));
+        data = _mm_add_ps(_mm_add_ps(_mm_mul_ps(col0,xs),_mm_mul_ps(col1,ys)),offs);
+        _mm_storel_pi((__m64*)dst,data);
+        _mm_storeh_pi((__m64*)(dst+stride),data);
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+    // Two vectors per register as (x0,y0,x1,y1)
+    float32x4_t col0 = { aff.m[0], aff.m[1], aff.m[0], aff.m[1] };
+    float32x4_t col1 = { aff.m[2], aff.m[3], aff.m[2], aff.m[3] };
+    float32x4_t offs = { aff.m[4], aff.m[5], aff.m[4], aff.m[5] };
+    for(; ii+1 < size; ii += 2) {
+        const float* src = input+ii*stride;
+        float* dst = output+ii*stride;
+        float32x4_t data = vcombine_f32(vld1_f32(src),vld1_f32(src+stride));
+        float32x4_t xs = vtrn1q_f32(data,data);
+        float32x4_t ys = vtrn2q_f32(data,data);
+        data = vmlaq_f32(vmlaq_f32(offs,col0,xs),col1,ys);
+        vst1_f32(dst,vget_low_f32(data));
+        vst1_f32(dst+stride,vget_high_f32(data));
     }
+#endif
+    for(; ii < size; ii++) {
+        const float* src = input+ii*stride;
+        float* dst = output+ii*stride;
+        float x = aff.m[0]*src[0]+aff.m[2]*src[1]+aff.m[4];
+        float y = aff.m[1]*src[0]+aff.m[3]*src[1]+aff.m[5];
+        dst[0] = x;
+        dst[1] = y;
+    }
+    return output;
+}
+
+/**
+ * Transforms the point array, and stores the result in output.
+ *
+ * The transform is applied in order and written to the output array. The
+ * input and output may be the same array.
+ *
+ * This method uses the vectorized algorithm, if available.
+ *
+ * @param aff       The transform matrix.
+ * @param input     The array of points to transform.
+ * @param output    The array to store the transformed points.
+ * @param size      The size of the two arrays.
+ *
+ * @return A reference to output for chaining
+ */
+Vec2* Affine2::transform(const Affine2& aff, const Vec2* input, Vec2* output, size_t size) {
+    static_assert(sizeof(Vec2) == 2*sizeof(float), "Vec2 must be tightly packed");
+    transform(aff,reinterpret_cast<const float*>(input),reinterpret_cast<float*>(output),size,2);
     return output;
 }
 
@@ -1183,6 +1183,53 @@ Color4f* Color4f::blendPre(const Color4f c1, const Color4f c2, Color4f* dst) {
     return dst;
 }
 
+/**
+ * Premultiplies the color array, and stores the result in output.
+ *
+ * Each color is premultiplied with its own alpha, which is unchanged.
+ * This class does not store whether a color is already premultiplied.
+ * Hence premultiplying an already premultiplied color will have a
+ * compounding effect. The input and output may be the same array.
+ *
+ * This method uses the vectorized algorithm, if available.
+ *
+ * @param input     The array of colors to premultiply.
+ * @param output    The array to store the premultiplied colors.
+ * @param size      The size of the two arrays.
+ *
+ * @return A reference to output for chaining
+ */
+Color4f* Color4f::premultiply(const Color4f* input, Color4f* output, size_t size) {
+    static_assert(sizeof(Color4f) == 4*sizeof(float), "Color4f must be tightly packed");
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    // Multiply the alpha by 1 so that it is preserved
+    const __m128 ones = _mm_set_ps(1.0f,0.0f,0.0f,0.0f);
+    const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0,-1,-1,-1));
+    for(; ii < size; ii++) {
+        __m128 data  = _mm_loadu_ps(&(input[ii].r));
+        __m128 alpha = _mm_shuffle_ps(data,data,_MM_SHUFFLE(3,3,3,3));
+        alpha = _mm_or_ps(_mm_and_ps(alpha,mask),ones);
+        _mm_storeu_ps(&(output[ii].r),_mm_mul_ps(data,alpha));
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+    for(; ii < size; ii++) {
+        float32x4_t data = vld1q_f32(&(input[ii].r));
+        float alpha = vgetq_lane_f32(data,3);
+        data = vsetq_lane_f32(alpha,vmulq_n_f32(data,alpha),3);
+        vst1q_f32(&(output[ii].r),data);
+    }
+#endif
+    for(; ii < size; ii++) {
+        float alpha = input[ii].a;
+        output[ii].r = input[ii].r*alpha;
+        output[ii].g = input[ii].g*alpha;
+        output[ii].b = input[ii].b*alpha;
+        output[ii].a = alpha;
+    }
+    return output;
+}
+
 #pragma mark Conversions
 
 /**
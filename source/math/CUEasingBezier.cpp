@@ -42,6 +42,7 @@
 //
 #include <cugl/cugl.h>
 #include <cugl/math/CUEasingBezier.h>
+#include "cuEasingTable.inl"
 
 using namespace cugl;
 
@@ -144,6 +145,13 @@ bool EasingBezier::init(float x1, float y1, float x2, float y2) {
     _c1.set(3*x1,3*y1);
     _c2.set(3*x2-6*x1,3*y2-6*y1);
     _c3.set(1-3*x2+3*x1,1-3*y2+3*y1);
+    
+    float samples[EASING_TABLE_SIZE+1];
+    for(int ii = 0; ii <= EASING_TABLE_SIZE; ii++) {
+        samples[ii] = evaluate(ii/(float)EASING_TABLE_SIZE);
+    }
+    _table.resize(4*EASING_TABLE_SIZE);
+    easing_table_build(samples,_table.data());
     return true;
 }
 
@@ -157,6 +165,7 @@ void EasingBezier::dispose() {
     _c2 = Vec2::ZERO;
     _c3 = Vec2::ZERO;
     _rootset.clear();
+    _table.clear();
 }
 
 #pragma mark -
@@ -170,13 +179,7 @@ void EasingBezier::dispose() {
  * @return the value of the easing function at t.
  */
 float EasingBezier::evaluate(float t) {
-    _rootset.clear();
-    solveCubicEquation(_c3.x, _c2.x, _c1.x, -t);
-    float choice = 0;
-    if (!_rootset.empty()) {
-        choice = _rootset[0];
-    }
-    
+    float choice = solveParameter(t);
     return choice*choice*choice*_c3.y+choice*choice*_c2.y+choice*_c1.y;
 }
 
@@ -193,6 +196,62 @@ std::function<float(float)> EasingBezier::getEvaluator() {
     return [=] (float t){ return context->evaluate(t); };
 }
 
+/**
+ * Returns the lookup table approximation of the easing function at t.
+ *
+ * The lookup table has {@link EASING_TABLE_SIZE} intervals and is built
+ * when this function is initialized. It uses monotone cubic interpolation,
+ * so it does not overshoot between samples. If cubic is false, it uses
+ * linear interpolation instead. Unlike {@link evaluate}, this method does
+ * not solve the cubic polynomial, and so it is safe to call from multiple
+ * threads.
+ *
+ * The value t is clamped to [0,1].
+ *
+ * @param t     The time to evaluate
+ * @param cubic Whether to use cubic (as opposed to linear) interpolation
+ *
+ * @return the lookup table approximation of the easing function at t.
+ */
+float EasingBezier::lookup(float t, bool cubic) const {
+    CUAssertLog(!_table.empty(), "The easing function is not initialized");
+    return easing_table_lookup(_table.data(),t,cubic);
+}
+
+/**
+ * Evaluates the lookup table approximation of this function on an array.
+ *
+ * This is the batched alternative to {@link lookup}. It evaluates four times
+ * at once when vectorization is enabled. The input and output arrays
+ * may be the same.
+ *
+ * The times are clamped to [0,1].
+ *
+ * @param input     The times to adjust
+ * @param output    The array to store the adjusted times
+ * @param count     The number of times to adjust
+ * @param cubic     Whether to use cubic (as opposed to linear) interpolation
+ */
+void EasingBezier::evaluateLookup(const float* input, float* output, size_t count, bool cubic) const {
+    CUAssertLog(!_table.empty(), "The easing function is not initialized");
+    easing_table_evaluate(_table.data(),input,output,count,cubic);
+}
+
+/**
+ * Returns a pointer to the lookup table approximation of this function.
+ *
+ * The function retains a shared pointer to the object, so the object
+ * reference can be safely discarded after getting the function pointer.
+ *
+ * @param cubic Whether to use cubic (as opposed to linear) interpolation
+ *
+ * @return a pointer to the lookup table approximation of this function.
+ */
+std::function<float(float)> EasingBezier::getLookup(bool cubic) {
+    std::shared_ptr<EasingBezier> context = shared_from_this();
+    return [=] (float t){ return context->lookup(t,cubic); };
+}
+
 
 #pragma mark -
 #pragma mark Internal Helpers
@@ -207,6 +266,13 @@ std::function<float(float)> EasingBezier::getEvaluator() {
  * @param c The constant factor
  */
 void EasingBezier::solveQuadraticEquation(float a, float b, float c) {
+    if (a == 0) {
+        if (b != 0) {
+            _rootset.push_back(-c/b);
+        }
+        return;
+    }
+    
     float  discriminant = b * b - 4 * a * c;
     if (discriminant >= 0) {
         _rootset.push_back((-b + sqrtf(discriminant)) / (2.0f * a));
@@ -239,22 +305,29 @@ void EasingBezier::solveCubicEquation(float a, float b, float c, float d) {
     float p = (3 * c - b * b)/3.0f;
     float q = (2 * b * b * b - 9 * b * c + 27 * d)/27.0f;
     
+    // Roots of the depressed cubic are shifted back by b/3
     if (p == 0) {
-        _rootset.push_back(powf(-q, 1.0f/3.0f));
+        _rootset.push_back(cbrtf(-q) - b/3.0f);
     } else if (q == 0) {
-        _rootset.push_back(sqrtf(-p));
-        _rootset.push_back(-sqrtf(-p));
+        _rootset.push_back(-b/3.0f);
+        if (p < 0) {
+            _rootset.push_back(sqrtf(-p) - b/3.0f);
+            _rootset.push_back(-sqrtf(-p) - b/3.0f);
+        }
     } else {
         float discriminant = q*q/4.0f + p*p*p/27.0f;
         if (discriminant == 0) {
-            _rootset.push_back(powf(q/2.0f, 1.0f/3.0f) - b/3.0f);
+            float u = cbrtf(-q/2.0f);
+            _rootset.push_back(2*u - b/3.0f);
+            _rootset.push_back(-u - b/3.0f);
         } else if (discriminant > 0) {
-            _rootset.push_back(powf(-(q/2.0f) + sqrtf(discriminant), 1.0f/3.0f) -
-                               powf((q/2.0f)  + sqrtf(discriminant), 1.0f/3.0f) - b/3.0f);
+            _rootset.push_back(cbrtf(-(q/2.0f) + sqrtf(discriminant)) +
+                               cbrtf(-(q/2.0f) - sqrtf(discriminant)) - b/3.0f);
         } else {
             float r = sqrtf( powf(-(p/3.0f), 3.0f) );
-            float phi = acosf(-(q / (2 * sqrtf(-p*p*p/27.0f))));
-            float s = 2 * powf(r, 1.0f/3.0f);
+            float cosphi = -(q / (2 * sqrtf(-p*p*p/27.0f)));
+            float phi = acosf(std::max(-1.0f,std::min(1.0f,cosphi)));
+            float s = 2 * cbrtf(r);
             _rootset.push_back(s * cosf(phi / 3.0f) - b / 3.0f);
             _rootset.push_back(s * cosf((phi + 2 * (float)M_PI) / 3.0f) - b / 3.0f);
             _rootset.push_back(s * cosf((phi + 4 * (float)M_PI) / 3.0f) - b / 3.0f);
@@ -262,4 +335,26 @@ void EasingBezier::solveCubicEquation(float a, float b, float c, float d) {
     }
 }
 
-
+/**
+ * Returns the bezier parameter for the given x-coordinate.
+ *
+ * The parameter is chosen from the roots of the x-component polynomial,
+ * preferring the first root in [0,1].
+ *
+ * @param x The x-coordinate (e.g. the time)
+ *
+ * @return the bezier parameter for the given x-coordinate.
+ */
+float EasingBezier::solveParameter(float x) {
+    _rootset.clear();
+    solveCubicEquation(_c3.x, _c2.x, _c1.x, -x);
+    if (_rootset.empty()) {
+        return 0;
+    }
+    for(auto it = _rootset.begin(); it != _rootset.end(); ++it) {
+        if (*it >= -CU_MATH_EPSILON && *it <= 1+CU_MATH_EPSILON) {
+            return *it;
+        }
+    }
+    return _rootset[0];
+}
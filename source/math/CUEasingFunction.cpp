@@ -32,9 +32,14 @@
 //  Version: 3/12/17
 //
 #include <cugl/math/CUEasingFunction.h>
+#include <mutex>
+#include "cuEasingTable.inl"
 
 using namespace cugl;
 
+/** The number of easing function types */
+#define EASING_TYPES ((int)EasingFunction::Type::ELASTIC_IN_OUT+1)
+
 /**
  * Returns an easing function of the given type.
  *
@@ -115,6 +120,276 @@ std::function<float(float)> EasingFunction::alloc(Type type, float period) {
     return nullptr;
 }
 
+/**
+ * Evaluates an easing function of the given type on an array of times.
+ *
+ * This is the batched alternative to {@link alloc}. The type is resolved
+ * once for the whole array, and the easing function is applied in a tight
+ * loop that the compiler is free to vectorize. It is much faster than
+ * calling a function value once per tween. The input and output arrays
+ * may be the same.
+ *
+ * The optional value period only applies to elastic easing functions, as
+ * their bounce factor is adjustable.
+ *
+ * @param type      The easing function type
+ * @param input     The times to adjust
+ * @param output    The array to store the adjusted times
+ * @param count     The number of times to adjust
+ * @param period    The period of an elastic easing function
+ */
+void EasingFunction::evaluate(Type type, const float* input, float* output, size_t count, float period) {
+    switch(type) {
+    case Type::LINEAR:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::linear(input[ii]);
+        }
+        break;
+    case Type::SINE_IN:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::sineIn(input[ii]);
+        }
+        break;
+    case Type::SINE_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::sineOut(input[ii]);
+        }
+        break;
+    case Type::SINE_IN_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::sineInOut(input[ii]);
+        }
+        break;
+    case Type::QUAD_IN:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::quadIn(input[ii]);
+        }
+        break;
+    case Type::QUAD_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::quadOut(input[ii]);
+        }
+        break;
+    case Type::QUAD_IN_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::quadInOut(input[ii]);
+        }
+        break;
+    case Type::CUBIC_IN:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::cubicIn(input[ii]);
+        }
+        break;
+    case Type::CUBIC_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::cubicOut(input[ii]);
+        }
+        break;
+    case Type::CUBIC_IN_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::cubicInOut(input[ii]);
+        }
+        break;
+    case Type::QUART_IN:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::quartIn(input[ii]);
+        }
+        break;
+    case Type::QUART_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::quartOut(input[ii]);
+        }
+        break;
+    case Type::QUART_IN_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::quartInOut(input[ii]);
+        }
+        break;
+    case Type::QUINT_IN:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::quintIn(input[ii]);
+        }
+        break;
+    case Type::QUINT_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::quintOut(input[ii]);
+        }
+        break;
+    case Type::QUINT_IN_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::quintInOut(input[ii]);
+        }
+        break;
+    case Type::EXPO_IN:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::expoIn(input[ii]);
+        }
+        break;
+    case Type::EXPO_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::expoOut(input[ii]);
+        }
+        break;
+    case Type::EXPO_IN_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::expoInOut(input[ii]);
+        }
+        break;
+    case Type::CIRC_IN:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::circIn(input[ii]);
+        }
+        break;
+    case Type::CIRC_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::circOut(input[ii]);
+        }
+        break;
+    case Type::CIRC_IN_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::circInOut(input[ii]);
+        }
+        break;
+    case Type::BACK_IN:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::backIn(input[ii]);
+        }
+        break;
+    case Type::BACK_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::backOut(input[ii]);
+        }
+        break;
+    case Type::BACK_IN_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::backInOut(input[ii]);
+        }
+        break;
+    case Type::BOUNCE_IN:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::bounceIn(input[ii]);
+        }
+        break;
+    case Type::BOUNCE_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::bounceOut(input[ii]);
+        }
+        break;
+    case Type::BOUNCE_IN_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::bounceInOut(input[ii]);
+        }
+        break;
+    case Type::ELASTIC_IN:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::elasticIn(input[ii],period);
+        }
+        break;
+    case Type::ELASTIC_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::elasticOut(input[ii],period);
+        }
+        break;
+    case Type::ELASTIC_IN_OUT:
+        for(size_t ii = 0; ii < count; ii++) {
+            output[ii] = EasingFunction::elasticInOut(input[ii],period);
+        }
+        break;
+    }
+}
+
+/**
+ * Returns the lookup table approximation of an easing function at time.
+ *
+ * Each easing type has a lookup table of {@link EASING_TABLE_SIZE} intervals,
+ * built on first use. The table uses monotone cubic interpolation, so it does
+ * not overshoot between samples. If cubic is false, it uses linear
+ * interpolation instead, which is faster but less smooth. Either way, this
+ * avoids the transcendental functions in types like elastic, expo or sine.
+ *
+ * The time is clamped to [0,1]. Elastic tables use the default period
+ * {@link ELASTIC_PERIOD}.
+ *
+ * @param type      The easing function type
+ * @param time      The time to adjust
+ * @param cubic     Whether to use cubic (as opposed to linear) interpolation
+ *
+ * @return the lookup table approximation of an easing function at time.
+ */
+float EasingFunction::lookup(Type type, float time, bool cubic) {
+    return easing_table_lookup(getTable(type),time,cubic);
+}
+
+/**
+ * Returns the lookup table approximation of an easing function.
+ *
+ * Each easing type has a lookup table of {@link EASING_TABLE_SIZE} intervals,
+ * built on first use. The table uses monotone cubic interpolation, so it does
+ * not overshoot between samples. If cubic is false, it uses linear
+ * interpolation instead, which is faster but less smooth. Either way, this
+ * avoids the transcendental functions in types like elastic, expo or sine.
+ *
+ * The returned function clamps its time to [0,1]. Elastic tables use the
+ * default period {@link ELASTIC_PERIOD}.
+ *
+ * @param type      The easing function type
+ * @param cubic     Whether to use cubic (as opposed to linear) interpolation
+ *
+ * @return the lookup table approximation of an easing function.
+ */
+std::function<float(float)> EasingFunction::allocLookup(Type type, bool cubic) {
+    const float* table = getTable(type);
+    return [=] (float time) { return easing_table_lookup(table,time,cubic); };
+}
+
+/**
+ * Evaluates the lookup table approximation of an easing function on an array.
+ *
+ * This is the batched alternative to {@link lookup}. It evaluates four times
+ * at once when vectorization is enabled. The input and output arrays
+ * may be the same.
+ *
+ * The times are clamped to [0,1]. Elastic tables use the default period
+ * {@link ELASTIC_PERIOD}.
+ *
+ * @param type      The easing function type
+ * @param input     The times to adjust
+ * @param output    The array to store the adjusted times
+ * @param count     The number of times to adjust
+ * @param cubic     Whether to use cubic (as opposed to linear) interpolation
+ */
+void EasingFunction::evaluateLookup(Type type, const float* input, float* output, size_t count,
+                                    bool cubic) {
+    easing_table_evaluate(getTable(type),input,output,count,cubic);
+}
+
+/**
+ * Returns the lookup table for the given easing type.
+ *
+ * The table is built (in a thread-safe way) the first time it is requested.
+ * It is {@link EASING_TABLE_SIZE} rows of four cubic coefficients.
+ *
+ * @param type      The easing function type
+ *
+ * @return the lookup table for the given easing type.
+ */
+const float* EasingFunction::getTable(Type type) {
+    static std::once_flag flags[EASING_TYPES];
+    static std::unique_ptr<float[]> tables[EASING_TYPES];
+    
+    int pos = (int)type;
+    std::call_once(flags[pos], [=] {
+        std::function<float(float)> func = alloc(type);
+        float samples[EASING_TABLE_SIZE+1];
+        for(int ii = 0; ii <= EASING_TABLE_SIZE; ii++) {
+            samples[ii] = func(ii/(float)EASING_TABLE_SIZE);
+        }
+        tables[pos] = std::unique_ptr<float[]>(new float[4*EASING_TABLE_SIZE]);
+        easing_table_build(samples,tables[pos].get());
+    });
+    return tables[pos].get();
+}
+
 /**
  * Returns an adjustment of the tweening time
  *
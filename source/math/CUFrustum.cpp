@@ -205,3 +205,222 @@ Frustum::Region Frustum::findBox(float x, float y, float z,
         
     return Region::INTERSECT;
 }
+
+#pragma mark -
+#pragma mark Batch Culling
+/**
+ * Stores the planes of the frustum, oriented inward, in the given array
+ *
+ * The winding of the frustum planes depends on the handedness of the
+ * source matrix. To be robust, each plane is flipped (if necessary) so
+ * that the center of the frustum is on its positive side.
+ *
+ * @param planes    The frustum planes
+ * @param points    The frustum corners
+ * @param dst       The array to store the oriented planes
+ */
+static void orient_planes(const Plane* planes, const Vec3* points, Plane* dst) {
+    Vec3 center;
+    for(int ii = 0; ii < 8; ii++) {
+        center += points[ii];
+    }
+    center /= 8;
+    for(int ii = 0; ii < 6; ii++) {
+        dst[ii] = planes[ii];
+        if (dst[ii].distance(center) < 0) {
+            dst[ii].normal = -dst[ii].normal;
+            dst[ii].offset = -dst[ii].offset;
+        }
+    }
+}
+
+/**
+ * Stores the visibility of an array of bounding boxes in the given mask.
+ *
+ * The boxes are given in structure-of-arrays form: each box ii is centered
+ * at (x[ii],y[ii],z[ii]) with half extents (hx[ii],hy[ii],hz[ii]). Bit
+ * ii%32 of mask[ii/32] is set if box ii is not entirely outside of this
+ * frustum. So the mask must have room for (count+31)/32 values. Boxes are
+ * tested four at a time when vectorization is enabled.
+ *
+ * Like {@link findBox}, this test is conservative. A box that straddles
+ * two planes near a corner may be reported as visible even though it is
+ * outside.
+ *
+ * If nearfar is false, the boxes are not tested against the near and far
+ * clipping planes. This is useful for 2d scenes, where the depth of
+ * the content is not meaningful.
+ *
+ * @param x         The x-coordinates of the box centers
+ * @param y         The y-coordinates of the box centers
+ * @param z         The z-coordinates of the box centers
+ * @param hx        The half widths (x-axis) of the boxes
+ * @param hy        The half heights (y-axis) of the boxes
+ * @param hz        The half depths (z-axis) of the boxes
+ * @param count     The number of boxes
+ * @param mask      The bitmask to store the visibility
+ * @param nearfar   Whether to test the near and far clipping planes
+ *
+ * @return the number of visible boxes
+ */
+size_t Frustum::cullBoxes(const float* x, const float* y, const float* z,
+                          const float* hx, const float* hy, const float* hz,
+                          size_t count, Uint32* mask, bool nearfar) const {
+    std::memset(mask, 0, ((count+31)/32)*sizeof(Uint32));
+    Plane planes[PLANE_COUNT];
+    orient_planes(_planes, _points, planes);
+    const int first = nearfar ? 0 : 2;
+    size_t visible = 0;
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    for(; ii+4 <= count; ii += 4) {
+        __m128 cx = _mm_loadu_ps(x+ii);
+        __m128 cy = _mm_loadu_ps(y+ii);
+        __m128 cz = _mm_loadu_ps(z+ii);
+        __m128 ex = _mm_loadu_ps(hx+ii);
+        __m128 ey = _mm_loadu_ps(hy+ii);
+        __m128 ez = _mm_loadu_ps(hz+ii);
+        __m128 out = _mm_setzero_ps();
+        for(int jj = first; jj < PLANE_COUNT; jj++) {
+            const Plane& plane = planes[jj];
+            __m128 nx = _mm_set1_ps(plane.normal.x);
+            __m128 ny = _mm_set1_ps(plane.normal.y);
+            __m128 nz = _mm_set1_ps(plane.normal.z);
+            // Distance of the corner farthest along the normal
+            __m128 d = _mm_add_ps(_mm_mul_ps(nx,cx),_mm_set1_ps(plane.offset));
+            d = _mm_add_ps(d,_mm_mul_ps(ny,cy));
+            d = _mm_add_ps(d,_mm_mul_ps(nz,cz));
+            d = _mm_add_ps(d,_mm_mul_ps(_mm_andnot_ps(sign,nx),ex));
+            d = _mm_add_ps(d,_mm_mul_ps(_mm_andnot_ps(sign,ny),ey));
+            d = _mm_add_ps(d,_mm_mul_ps(_mm_andnot_ps(sign,nz),ez));
+            out = _mm_or_ps(out,_mm_cmplt_ps(d,_mm_setzero_ps()));
+        }
+        Uint32 bits = (~_mm_movemask_ps(out)) & 0xf;
+        mask[ii/32] |= bits << (ii%32);
+        visible += (bits & 1)+((bits >> 1) & 1)+((bits >> 2) & 1)+(bits >> 3);
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+    const uint32x4_t lanes = { 1, 2, 4, 8 };
+    for(; ii+4 <= count; ii += 4) {
+        float32x4_t cx = vld1q_f32(x+ii);
+        float32x4_t cy = vld1q_f32(y+ii);
+        float32x4_t cz = vld1q_f32(z+ii);
+        float32x4_t ex = vld1q_f32(hx+ii);
+        float32x4_t ey = vld1q_f32(hy+ii);
+        float32x4_t ez = vld1q_f32(hz+ii);
+        uint32x4_t out = vdupq_n_u32(0);
+        for(int jj = first; jj < PLANE_COUNT; jj++) {
+            const Plane& plane = planes[jj];
+            // Distance of the corner farthest along the normal
+            float32x4_t d = vmlaq_n_f32(vdupq_n_f32(plane.offset),cx,plane.normal.x);
+            d = vmlaq_n_f32(d,cy,plane.normal.y);
+            d = vmlaq_n_f32(d,cz,plane.normal.z);
+            d = vmlaq_n_f32(d,ex,fabsf(plane.normal.x));
+            d = vmlaq_n_f32(d,ey,fabsf(plane.normal.y));
+            d = vmlaq_n_f32(d,ez,fabsf(plane.normal.z));
+            out = vorrq_u32(out,vcltq_f32(d,vdupq_n_f32(0.0f)));
+        }
+        Uint32 bits = vaddvq_u32(vandq_u32(vmvnq_u32(out),lanes));
+        mask[ii/32] |= bits << (ii%32);
+        visible += (bits & 1)+((bits >> 1) & 1)+((bits >> 2) & 1)+(bits >> 3);
+    }
+#endif
+    for(; ii < count; ii++) {
+        bool inside = true;
+        for(int jj = first; inside && jj < PLANE_COUNT; jj++) {
+            const Plane& plane = planes[jj];
+            float d = plane.normal.x*x[ii]+plane.normal.y*y[ii]+plane.normal.z*z[ii]+plane.offset;
+            d += fabsf(plane.normal.x)*hx[ii]+fabsf(plane.normal.y)*hy[ii]+fabsf(plane.normal.z)*hz[ii];
+            inside = d >= 0;
+        }
+        if (inside) {
+            mask[ii/32] |= 1u << (ii%32);
+            visible++;
+        }
+    }
+    return visible;
+}
+
+/**
+ * Stores the visibility of an array of spheres in the given mask.
+ *
+ * The spheres are given in structure-of-arrays form: each sphere ii is
+ * centered at (x[ii],y[ii],z[ii]) with the given radius[ii]. Bit ii%32
+ * of mask[ii/32] is set if sphere ii is not entirely outside of this
+ * frustum. So the mask must have room for (count+31)/32 values. Spheres
+ * are tested four at a time when vectorization is enabled.
+ *
+ * If nearfar is false, the spheres are not tested against the near and
+ * far clipping planes, as in {@link findSphereWithoutNearFar}.
+ *
+ * @param x         The x-coordinates of the sphere centers
+ * @param y         The y-coordinates of the sphere centers
+ * @param z         The z-coordinates of the sphere centers
+ * @param radius    The sphere radii
+ * @param count     The number of spheres
+ * @param mask      The bitmask to store the visibility
+ * @param nearfar   Whether to test the near and far clipping planes
+ *
+ * @return the number of visible spheres
+ */
+size_t Frustum::cullSpheres(const float* x, const float* y, const float* z, const float* radius,
+                            size_t count, Uint32* mask, bool nearfar) const {
+    std::memset(mask, 0, ((count+31)/32)*sizeof(Uint32));
+    Plane planes[PLANE_COUNT];
+    orient_planes(_planes, _points, planes);
+    const int first = nearfar ? 0 : 2;
+    size_t visible = 0;
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    for(; ii+4 <= count; ii += 4) {
+        __m128 cx = _mm_loadu_ps(x+ii);
+        __m128 cy = _mm_loadu_ps(y+ii);
+        __m128 cz = _mm_loadu_ps(z+ii);
+        __m128 nr = _mm_sub_ps(_mm_setzero_ps(),_mm_loadu_ps(radius+ii));
+        __m128 out = _mm_setzero_ps();
+        for(int jj = first; jj < PLANE_COUNT; jj++) {
+            const Plane& plane = planes[jj];
+            __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normal.x),cx),_mm_set1_ps(plane.offset));
+            d = _mm_add_ps(d,_mm_mul_ps(_mm_set1_ps(plane.normal.y),cy));
+            d = _mm_add_ps(d,_mm_mul_ps(_mm_set1_ps(plane.normal.z),cz));
+            out = _mm_or_ps(out,_mm_cmplt_ps(d,nr));
+        }
+        Uint32 bits = (~_mm_movemask_ps(out)) & 0xf;
+        mask[ii/32] |= bits << (ii%32);
+        visible += (bits & 1)+((bits >> 1) & 1)+((bits >> 2) & 1)+(bits >> 3);
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+    const uint32x4_t lanes = { 1, 2, 4, 8 };
+    for(; ii+4 <= count; ii += 4) {
+        float32x4_t cx = vld1q_f32(x+ii);
+        float32x4_t cy = vld1q_f32(y+ii);
+        float32x4_t cz = vld1q_f32(z+ii);
+        float32x4_t nr = vnegq_f32(vld1q_f32(radius+ii));
+        uint32x4_t out = vdupq_n_u32(0);
+        for(int jj = first; jj < PLANE_COUNT; jj++) {
+            const Plane& plane = planes[jj];
+            float32x4_t d = vmlaq_n_f32(vdupq_n_f32(plane.offset),cx,plane.normal.x);
+            d = vmlaq_n_f32(d,cy,plane.normal.y);
+            d = vmlaq_n_f32(d,cz,plane.normal.z);
+            out = vorrq_u32(out,vcltq_f32(d,nr));
+        }
+        Uint32 bits = vaddvq_u32(vandq_u32(vmvnq_u32(out),lanes));
+        mask[ii/32] |= bits << (ii%32);
+        visible += (bits & 1)+((bits >> 1) & 1)+((bits >> 2) & 1)+(bits >> 3);
+    }
+#endif
+    for(; ii < count; ii++) {
+        bool inside = true;
+        for(int jj = first; inside && jj < PLANE_COUNT; jj++) {
+            const Plane& plane = planes[jj];
+            float d = plane.normal.x*x[ii]+plane.normal.y*y[ii]+plane.normal.z*z[ii]+plane.offset;
+            inside = d >= -radius[ii];
+        }
+        if (inside) {
+            mask[ii/32] |= 1u << (ii%32);
+            visible++;
+        }
+    }
+    return visible;
+}
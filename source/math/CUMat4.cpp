@@ -1269,6 +1269,32 @@ float* Mat4::multiply(const float* m1, const float* m2, float* dst) {
     return dst;
 }
 
+/**
+ * Multiplies each matrix in the input array by mat and stores the results.
+ *
+ * The matrix mat is on the right of each product. This means that it is
+ * applied as a subsequent transform to every matrix in the array, such
+ * as when a single parent transform is combined with many children. The
+ * input and output may be the same array.
+ *
+ * This method uses the vectorized algorithm, if available.
+ *
+ * @param input     The array of matrices to multiply.
+ * @param mat       The matrix to multiply on the right.
+ * @param output    The array to store the products.
+ * @param size      The size of the two arrays.
+ *
+ * @return A reference to output for chaining
+ */
+Mat4* Mat4::multiply(const Mat4* input, const Mat4& mat, Mat4* output, size_t size) {
+    CUAssertLog(output, "Destination matrix is null");
+    // Each column of a product is a column of the input transformed by mat
+    for(size_t ii = 0; ii < size; ii++) {
+        transform(mat.m,input[ii].m,output[ii].m,4,4);
+    }
+    return output;
+}
+
 /**
  * Negates m1 and stores the result in dst.
  *
@@ -1771,27 +1797,15 @@ Vec4* Mat4::transform(const Mat4& mat, const Vec4 vec, Vec4* dst) {
  */
 float* Mat4::transform(const Mat4& mat, float const* input, float* output, size_t size) {
     CUAssertLog(output, "Destination vector is null");
-    for(size_t ii = 0; ii < size; ii++) {
-        // Handle case where v == dst.
-        float x = input[ii*4] * mat.m[0] + input[ii*4+1] * mat.m[4] + input[ii*4+2] * mat.m[8]  + input[ii*4+3] * mat.m[12];
-        float y = input[ii*4] * mat.m[1] + input[ii*4+1] * mat.m[5] + input[ii*4+2] * mat.m[9]  + input[ii*4+3] * mat.m[13];
-        float z = input[ii*4] * mat.m[2] + input[ii*4+1] * mat.m[6] + input[ii*4+2] * mat.m[10] + input[ii*4+3] * mat.m[14];
-        float w = input[ii*4] * mat.m[3] + input[ii*4+1] * mat.m[7] + input[ii*4+2] * mat.m[11] + input[ii*4+3] * mat.m[15];
-        
-        output[ii*4  ] = x;
-        output[ii*4+1] = y;
-        output[ii*4+2] = z;
-        output[ii*4+3] = w;
-    }
-
-    return output;
+    return transform(mat.m,input,output,size,4);
 }
 
 /**
  * Transforms the vector array by the given matrix, and stores the result in dst.
  *
  * The vector is array is treated as a list of 4 element vectors (@see Vec4).
- * The transform is applied in order and written to the output array.
+ * The transform is applied in order and written to the output array. The
+ * float array for the matrix should be in column major order
  *
  * @param mat       The transform matrix in column major order
  * @param input     The array of vectors to transform.
@@ -1802,17 +1816,201 @@ float* Mat4::transform(const Mat4& mat, float const* input, float* output, size_
  */
 float* Mat4::transform(const float* mat, float const* input, float* output, size_t size) {
     CUAssertLog(output, "Destination vector is null");
-    for(size_t ii = 0; ii < size; ii++) {
+    return transform(mat,input,output,size,4);
+}
+
+/**
+ * Transforms the strided vector array by the given matrix, and stores the result in dst.
+ *
+ * The vector is array is treated as a list of 4 element vectors (@see Vec4),
+ * where consecutive vectors are stride floats apart. Floats between the
+ * vectors are left untouched. The float array for the matrix should be in
+ * column major order. The input and output may be the same array.
+ *
+ * This method uses the vectorized algorithm, if available.
+ *
+ * @param mat       The transform matrix in column major order
+ * @param input     The array of vectors to transform.
+ * @param output    The array to store the transformed vectors.
+ * @param size      The number of vectors in the two arrays.
+ * @param stride    The number of floats from one vector to the next
+ *
+ * @return A reference to dst for chaining
+ */
+float* Mat4::transform(const float* mat, float const* input, float* output,
+                       size_t size, size_t stride) {
+    CUAssertLog(output, "Destination vector is null");
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    __m128 col0 = _mm_loadu_ps(mat);
+    __m128 col1 = _mm_loadu_ps(mat+4);
+    __m128 col2 = _mm_loadu_ps(mat+8);
+    __m128 col3 = _mm_loadu_ps(mat+12);
+    for(; ii < size; ii++) {
+        const float* src = input+ii*stride;
+        __m128 temp = _mm_mul_ps(col0,_mm_set1_ps(src[0]));
+        temp = _mm_add_ps(temp,_mm_mul_ps(col1,_mm_set1_ps(src[1])));
+        temp = _mm_add_ps(temp,_mm_mul_ps(col2,_mm_set1_ps(src[2])));
+        temp = _mm_add_ps(temp,_mm_mul_ps(col3,_mm_set1_ps(src[3])));
+        _mm_storeu_ps(output+ii*stride,temp);
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+    float32x4_t col0 = vld1q_f32(mat);
+    float32x4_t col1 = vld1q_f32(mat+4);
+    float32x4_t col2 = vld1q_f32(mat+8);
+    float32x4_t col3 = vld1q_f32(mat+12);
+    for(; ii < size; ii++) {
+        float32x4_t data = vld1q_f32(input+ii*stride);
+        float32x4_t temp = vmulq_laneq_f32(col0,data,0);
+        temp = vfmaq_laneq_f32(temp,col1,data,1);
+        temp = vfmaq_laneq_f32(temp,col2,data,2);
+        temp = vfmaq_laneq_f32(temp,col3,data,3);
+        vst1q_f32(output+ii*stride,temp);
+    }
+#endif
+    for(; ii < size; ii++) {
+        const float* src = input+ii*stride;
+        float* dst = output+ii*stride;
         // Handle case where v == dst.
-        float x = input[ii*4] * mat[0] + input[ii*4+1] * mat[4] + input[ii*4+2] * mat[8]  + input[ii*4+3] * mat[12];
-        float y = input[ii*4] * mat[1] + input[ii*4+1] * mat[5] + input[ii*4+2] * mat[9]  + input[ii*4+3] * mat[13];
-        float z = input[ii*4] * mat[2] + input[ii*4+1] * mat[6] + input[ii*4+2] * mat[10] + input[ii*4+3] * mat[14];
-        float w = input[ii*4] * mat[3] + input[ii*4+1] * mat[7] + input[ii*4+2] * mat[11] + input[ii*4+3] * mat[15];
-        
-        output[ii*4  ] = x;
-        output[ii*4+1] = y;
-        output[ii*4+2] = z;
-        output[ii*4+3] = w;
+        float x = src[0] * mat[0] + src[1] * mat[4] + src[2] * mat[8]  + src[3] * mat[12];
+        float y = src[0] * mat[1] + src[1] * mat[5] + src[2] * mat[9]  + src[3] * mat[13];
+        float z = src[0] * mat[2] + src[1] * mat[6] + src[2] * mat[10] + src[3] * mat[14];
+        float w = src[0] * mat[3] + src[1] * mat[7] + src[2] * mat[11] + src[3] * mat[15];
+        dst[0] = x;
+        dst[1] = y;
+        dst[2] = z;
+        dst[3] = w;
+    }
+    return output;
+}
+
+/**
+ * Transforms the vector array by the given matrix, and stores the result in dst.
+ *
+ * The vectors are treated as is.  Hence whether or not translation is
+ * applied depends on the value of w. The input and output may be the
+ * same array.
+ *
+ * This method uses the vectorized algorithm, if available.
+ *
+ * @param mat       The transform matrix.
+ * @param input     The array of vectors to transform.
+ * @param output    The array to store the transformed vectors.
+ * @param size      The size of the two arrays.
+ *
+ * @return A reference to dst for chaining
+ */
+Vec4* Mat4::transform(const Mat4& mat, const Vec4* input, Vec4* output, size_t size) {
+    CUAssertLog(output, "Destination vector is null");
+    transform(mat.m,reinterpret_cast<const float*>(input),reinterpret_cast<float*>(output),
+              size,sizeof(Vec4)/sizeof(float));
+    return output;
+}
+
+/**
+ * Transforms the point array by the given matrix, and stores the result in dst.
+ *
+ * The vectors are treated as points, which means that translation is
+ * applied to the result. The input and output may be the same array.
+ *
+ * This method uses the vectorized algorithm, if available.
+ *
+ * @param mat       The transform matrix.
+ * @param input     The array of points to transform.
+ * @param output    The array to store the transformed points.
+ * @param size      The size of the two arrays.
+ *
+ * @return A reference to dst for chaining
+ */
+Vec3* Mat4::transform(const Mat4& mat, const Vec3* input, Vec3* output, size_t size) {
+    CUAssertLog(output, "Destination vector is null");
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    __m128 col0 = _mm_loadu_ps(mat.m);
+    __m128 col1 = _mm_loadu_ps(mat.m+4);
+    __m128 col2 = _mm_loadu_ps(mat.m+8);
+    __m128 col3 = _mm_loadu_ps(mat.m+12);
+    for(; ii < size; ii++) {
+        const Vec3& src = input[ii];
+        __m128 temp = _mm_add_ps(col3,_mm_mul_ps(col0,_mm_set1_ps(src.x)));
+        temp = _mm_add_ps(temp,_mm_mul_ps(col1,_mm_set1_ps(src.y)));
+        temp = _mm_add_ps(temp,_mm_mul_ps(col2,_mm_set1_ps(src.z)));
+        // Only three floats may be written
+        _mm_storel_pi((__m64*)&(output[ii].x),temp);
+        _mm_store_ss(&(output[ii].z),_mm_movehl_ps(temp,temp));
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+    float32x4_t col0 = vld1q_f32(mat.m);
+    float32x4_t col1 = vld1q_f32(mat.m+4);
+    float32x4_t col2 = vld1q_f32(mat.m+8);
+    float32x4_t col3 = vld1q_f32(mat.m+12);
+    for(; ii < size; ii++) {
+        const Vec3& src = input[ii];
+        float32x4_t temp = vfmaq_n_f32(col3,col0,src.x);
+        temp = vfmaq_n_f32(temp,col1,src.y);
+        temp = vfmaq_n_f32(temp,col2,src.z);
+        // Only three floats may be written
+        vst1_f32(&(output[ii].x),vget_low_f32(temp));
+        output[ii].z = vgetq_lane_f32(temp,2);
+    }
+#endif
+    for(; ii < size; ii++) {
+        Vec3 src = input[ii];
+        output[ii].x = src.x * mat.m[0] + src.y * mat.m[4] + src.z * mat.m[8]  + mat.m[12];
+        output[ii].y = src.x * mat.m[1] + src.y * mat.m[5] + src.z * mat.m[9]  + mat.m[13];
+        output[ii].z = src.x * mat.m[2] + src.y * mat.m[6] + src.z * mat.m[10] + mat.m[14];
+    }
+    return output;
+}
+
+/**
+ * Transforms the point array by the given matrix, and stores the result in dst.
+ *
+ * The vectors are treated as points in the plane z = 0, which means that
+ * translation is applied to the result. The input and output may be the
+ * same array.
+ *
+ * This method uses the vectorized algorithm, if available.
+ *
+ * @param mat       The transform matrix.
+ * @param input     The array of points to transform.
+ * @param output    The array to store the transformed points.
+ * @param size      The size of the two arrays.
+ *
+ * @return A reference to dst for chaining
+ */
+Vec2* Mat4::transform(const Mat4& mat, const Vec2* input, Vec2* output, size_t size) {
+    CUAssertLog(output, "Destination vector is null");
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    // Two points per register as (x0,y0,x1,y1)
+    __m128 col0 = _mm_set_ps(mat.m[1],mat.m[0],mat.m[1],mat.m[0]);
+    __m128 col1 = _mm_set_ps(mat.m[5],mat.m[4],mat.m[5],mat.m[4]);
+    __m128 offs = _mm_set_ps(mat.m[13],mat.m[12],mat.m[13],mat.m[12]);
+    for(; ii+1 < size; ii += 2) {
+        __m128 data = _mm_loadu_ps(&(input[ii].x));
+        __m128 xs = _mm_shuffle_ps(data,data,_MM_SHUFFLE(2,2,0,0));
+        __m128 ys = _mm_shuffle_ps(data,data,_MM_SHUFFLE(3,3,1,1));
+        data = _mm_add_ps(_mm_add_ps(_mm_mul_ps(col0,xs),_mm_mul_ps(col1,ys)),offs);
+        _mm_storeu_ps(&(output[ii].x),data);
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+    // Two points per register as (x0,y0,x1,y1)
+    float32x4_t col0 = { mat.m[0],  mat.m[1],  mat.m[0],  mat.m[1]  };
+    float32x4_t col1 = { mat.m[4],  mat.m[5],  mat.m[4],  mat.m[5]  };
+    float32x4_t offs = { mat.m[12], mat.m[13], mat.m[12], mat.m[13] };
+    for(; ii+1 < size; ii += 2) {
+        float32x4_t data = vld1q_f32(&(input[ii].x));
+        float32x4_t xs = vtrn1q_f32(data,data);
+        float32x4_t ys = vtrn2q_f32(data,data);
+        data = vfmaq_f32(vfmaq_f32(offs,col0,xs),col1,ys);
+        vst1q_f32(&(output[ii].x),data);
+    }
+#endif
+    for(; ii < size; ii++) {
+        Vec2 src = input[ii];
+        output[ii].x = src.x * mat.m[0] + src.y * mat.m[4] + mat.m[12];
+        output[ii].y = src.x * mat.m[1] + src.y * mat.m[5] + mat.m[13];
     }
     return output;
 }
@@ -1023,11 +1023,7 @@ Path2& Path2::operator*=(const Vec2 scale) {
  * @return This path with the vertices transformed
  */
 Path2& Path2::operator*=(const Affine2& transform) {
-    Vec2 tmp;
-    for(auto it = vertices.begin(); it != vertices.end(); ++it) {
-        Affine2::transform(transform,*it,&tmp);
-        *it = tmp;
-    }
+    Affine2::transform(transform,vertices.data(),vertices.data(),vertices.size());
     return *this;
 }
 
@@ -1041,11 +1037,7 @@ Path2& Path2::operator*=(const Affine2& transform) {
  * @return This path with the vertices transformed
  */
 Path2& Path2::operator*=(const Mat4& transform) {
-    Vec2 tmp;
-    for(auto it = vertices.begin(); it != vertices.end(); ++it) {
-        Mat4::transform(transform,*it,&tmp);
-        *it = tmp;
-    }
+    Mat4::transform(transform,vertices.data(),vertices.data(),vertices.size());
     return *this;
 }
 
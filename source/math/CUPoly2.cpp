@@ -48,6 +48,7 @@
 #include <iterator>
 #include <unordered_set>
 #include <unordered_map>
+#include <limits>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUStrings.h>
 #include <cugl/math/CUPoly2.h>
@@ -57,6 +58,7 @@
 #include <cugl/math/CUAffine2.h>
 #include <cugl/assets/CUJsonValue.h>
 #include <cugl/math/polygon/CUEarclipTriangulator.h>
+#include <cugl/math/polygon/CUMonotoneTriangulator.h>
 #include <cugl/math/polygon/CUDelaunayTriangulator.h>
 
 using namespace std;
@@ -487,6 +489,484 @@ static bool colinear(const Vec2& v, const Vec2& w, const Vec2& p, float err) {
     return (distance <= err);
 }
 
+#pragma mark -
+#pragma mark Acceleration Support
+/** The maximum number of elements in a leaf of the acceleration hierarchy */
+#define HIERARCHY_LEAF  4
+
+/**
+ * Stores the boundary edges of the given triangle mesh in the buffer
+ *
+ * An edge is on the boundary if it belongs to exactly one triangle. The edges
+ * are stored as pairs of vertex indices, in the orientation of the triangle
+ * that owns them.
+ *
+ * @param indices   The triangle mesh indices
+ * @param buffer    The buffer to store the edges
+ */
+static void boundary_edges(const std::vector<Uint32>& indices, std::vector<Uint32>& buffer) {
+    std::unordered_map<Uint64,size_t> seen;
+    std::vector<Uint32> edges;
+    std::vector<bool> alive;
+    seen.reserve(indices.size());
+    edges.reserve(indices.size()*2);
+    alive.reserve(indices.size());
+    for(size_t ii = 0; ii+2 < indices.size(); ii += 3) {
+        for(int jj = 0; jj < 3; jj++) {
+            Uint32 a = indices[ii+jj];
+            Uint32 b = indices[ii+(jj+1)%3];
+            Uint64 key = a < b ? ((Uint64)a << 32) | b : ((Uint64)b << 32) | a;
+            auto it = seen.find(key);
+            if (it == seen.end()) {
+                seen.emplace(key,alive.size());
+                alive.push_back(true);
+                edges.push_back(a);
+                edges.push_back(b);
+            } else {
+                alive[it->second] = false;
+            }
+        }
+    }
+    
+    buffer.reserve(buffer.size()+edges.size());
+    for(size_t ii = 0; ii < alive.size(); ii++) {
+        if (alive[ii]) {
+            buffer.push_back(edges[2*ii  ]);
+            buffer.push_back(edges[2*ii+1]);
+        }
+    }
+}
+
+/**
+ * Returns the point on the segment vw nearest to p
+ *
+ * @param v     The start of the segment
+ * @param w     The end of the segment
+ * @param p     The point to project
+ *
+ * @return the point on the segment vw nearest to p
+ */
+static Vec2 project_segment(const Vec2& v, const Vec2& w, const Vec2& p) {
+    const float l2 = (w-v).lengthSquared();
+    if (l2 == 0.0f) {
+        return v;
+    }
+    const float t = std::max(0.0f, std::min(1.0f, (p - v).dot(w - v) / l2));
+    return v + t * (w - v);
+}
+
+/**
+ * Returns true if segment p0p1 crosses segment q0q1
+ *
+ * If the segments cross, the parameter t stores the position of the (first)
+ * crossing along p0p1. Colinear segments cross if they overlap.
+ *
+ * @param p0    The start of the first segment
+ * @param p1    The end of the first segment
+ * @param q0    The start of the second segment
+ * @param q1    The end of the second segment
+ * @param t     The parameter to store the crossing
+ *
+ * @return true if segment p0p1 crosses segment q0q1
+ */
+static bool segment_cross(const Vec2& p0, const Vec2& p1, const Vec2& q0, const Vec2& q1, float& t) {
+    Vec2 r = p1-p0;
+    Vec2 s = q1-q0;
+    Vec2 d = q0-p0;
+    float denom = r.cross(s);
+    float numer = d.cross(r);
+    if (denom == 0.0f) {
+        float l2 = r.lengthSquared();
+        if (numer != 0.0f || l2 == 0.0f) {
+            return false;
+        }
+        float t0 = d.dot(r)/l2;
+        float t1 = (q1-p0).dot(r)/l2;
+        float lo = std::max(0.0f,std::min(t0,t1));
+        float hi = std::min(1.0f,std::max(t0,t1));
+        if (lo > hi) {
+            return false;
+        }
+        t = lo;
+        return true;
+    }
+    
+    float u = numer/denom;
+    t = d.cross(s)/denom;
+    return (0 <= t && t <= 1 && 0 <= u && u <= 1);
+}
+
+/**
+ * This class is a bounding volume hierarchy for a polygon.
+ *
+ * The hierarchy is actually two hierarchies: one over the triangles (for
+ * containment) and one over the boundary edges (for incidence, nearest point
+ * and intersection queries). Each is a binary tree of axis-aligned boxes,
+ * split at the median of the longest axis. The nodes are stored in depth-first
+ * order, so the left child of a node immediately follows it.
+ *
+ * The hierarchy is immutable once built, and so it may be shared by copies
+ * of the same polygon.
+ */
+class Poly2::Hierarchy {
+public:
+    /** A node in a bounding volume hierarchy */
+    struct Node {
+        /** The bottom left corner of the bounding box */
+        Vec2 min;
+        /** The top right corner of the bounding box */
+        Vec2 max;
+        /** The first element (leaf) or the right child (internal node) */
+        Uint32 start;
+        /** The number of elements (0 for an internal node) */
+        Uint32 count;
+    };
+    
+    /** The number of vertices when this hierarchy was built */
+    size_t vertsize;
+    /** The number of indices when this hierarchy was built */
+    size_t indxsize;
+    /** The hierarchy of triangles */
+    std::vector<Node> trinodes;
+    /** The triangle indices, ordered by leaf */
+    std::vector<Uint32> triangles;
+    /** The hierarchy of boundary edges */
+    std::vector<Node> edgenodes;
+    /** The boundary edge indices, ordered by leaf */
+    std::vector<Uint32> edgeorder;
+    /** The boundary edges (as pairs of vertex indices) */
+    std::vector<Uint32> edges;
+    
+    /**
+     * Creates a hierarchy for the given polygon
+     *
+     * @param poly  The polygon to accelerate
+     */
+    Hierarchy(const Poly2& poly) {
+        vertsize = poly.vertices.size();
+        indxsize = poly.indices.size();
+        const Vec2* verts = poly.vertices.data();
+        
+        std::vector<Vec2> mins, maxs;
+        size_t tris = indxsize/3;
+        mins.reserve(tris);
+        maxs.reserve(tris);
+        triangles.reserve(tris);
+        for(Uint32 ii = 0; ii < tris; ii++) {
+            const Vec2& a = verts[poly.indices[3*ii  ]];
+            const Vec2& b = verts[poly.indices[3*ii+1]];
+            const Vec2& c = verts[poly.indices[3*ii+2]];
+            mins.emplace_back(std::min(a.x,std::min(b.x,c.x)),std::min(a.y,std::min(b.y,c.y)));
+            maxs.emplace_back(std::max(a.x,std::max(b.x,c.x)),std::max(a.y,std::max(b.y,c.y)));
+            triangles.push_back(ii);
+        }
+        trinodes.reserve(2*tris/HIERARCHY_LEAF+1);
+        build(trinodes,triangles,mins,maxs,0,(Uint32)tris);
+        
+        boundary_edges(poly.indices,edges);
+        size_t size = edges.size()/2;
+        mins.clear();
+        maxs.clear();
+        edgeorder.reserve(size);
+        for(Uint32 ii = 0; ii < size; ii++) {
+            const Vec2& a = verts[edges[2*ii  ]];
+            const Vec2& b = verts[edges[2*ii+1]];
+            mins.emplace_back(std::min(a.x,b.x),std::min(a.y,b.y));
+            maxs.emplace_back(std::max(a.x,b.x),std::max(a.y,b.y));
+            edgeorder.push_back(ii);
+        }
+        edgenodes.reserve(2*size/HIERARCHY_LEAF+1);
+        build(edgenodes,edgeorder,mins,maxs,0,(Uint32)size);
+    }
+    
+    /**
+     * Returns true if this hierarchy is consistent with the given polygon
+     *
+     * This is only a size check. It cannot detect in place changes.
+     *
+     * @param poly  The polygon to check
+     *
+     * @return true if this hierarchy is consistent with the given polygon
+     */
+    bool matches(const Poly2& poly) const {
+        return vertsize == poly.vertices.size() && indxsize == poly.indices.size();
+    }
+    
+    /**
+     * Builds the subtree for the given range of elements
+     *
+     * @param nodes The nodes of the hierarchy
+     * @param items The elements of the hierarchy
+     * @param mins  The bottom left corner of each element
+     * @param maxs  The top right corner of each element
+     * @param start The first element in the range
+     * @param count The number of elements in the range
+     */
+    static void build(std::vector<Node>& nodes, std::vector<Uint32>& items,
+                      const std::vector<Vec2>& mins, const std::vector<Vec2>& maxs,
+                      Uint32 start, Uint32 count) {
+        if (count == 0) {
+            return;
+        }
+        
+        Node node;
+        node.min = mins[items[start]];
+        node.max = maxs[items[start]];
+        Vec2 lo = (mins[items[start]]+maxs[items[start]]);
+        Vec2 hi = lo;
+        for(Uint32 ii = start+1; ii < start+count; ii++) {
+            Uint32 item = items[ii];
+            node.min.x = std::min(node.min.x,mins[item].x);
+            node.min.y = std::min(node.min.y,mins[item].y);
+            node.max.x = std::max(node.max.x,maxs[item].x);
+            node.max.y = std::max(node.max.y,maxs[item].y);
+            Vec2 center = mins[item]+maxs[item];
+            lo.x = std::min(lo.x,center.x);
+            lo.y = std::min(lo.y,center.y);
+            hi.x = std::max(hi.x,center.x);
+            hi.y = std::max(hi.y,center.y);
+        }
+        
+        size_t pos = nodes.size();
+        if (count <= HIERARCHY_LEAF) {
+            node.start = start;
+            node.count = count;
+            nodes.push_back(node);
+            return;
+        }
+        
+        node.count = 0;
+        nodes.push_back(node);
+        
+        // Split at the median of the longest axis (centers are doubled)
+        bool xaxis = (hi.x-lo.x) >= (hi.y-lo.y);
+        Uint32 half = count/2;
+        std::nth_element(items.begin()+start, items.begin()+start+half, items.begin()+start+count,
+                         [&](Uint32 a, Uint32 b) {
+            return (xaxis ? mins[a].x+maxs[a].x < mins[b].x+maxs[b].x
+                          : mins[a].y+maxs[a].y < mins[b].y+maxs[b].y);
+        });
+        build(nodes,items,mins,maxs,start,half);
+        nodes[pos].start = (Uint32)nodes.size();
+        build(nodes,items,mins,maxs,start+half,count-half);
+    }
+    
+    /**
+     * Returns true if the given polygon contains the point
+     *
+     * @param poly  The polygon for this hierarchy
+     * @param p     The point to test
+     *
+     * @return true if the given polygon contains the point
+     */
+    bool contains(const Poly2& poly, const Vec2& p) const {
+        if (trinodes.empty()) {
+            return false;
+        }
+        
+        Uint32 stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = trinodes[stack[--top]];
+            if (p.x < node.min.x || p.x > node.max.x || p.y < node.min.y || p.y > node.max.y) {
+                continue;
+            }
+            if (node.count) {
+                for(Uint32 ii = node.start; ii < node.start+node.count; ii++) {
+                    Vec3 temp3 = poly.getBarycentric(p, triangles[ii]);
+                    if (0 <= temp3.x && temp3.x <= 1 &&
+                        0 <= temp3.y && temp3.y <= 1 &&
+                        0 <= temp3.z && temp3.z <= 1) {
+                        return true;
+                    }
+                }
+            } else {
+                Uint32 curr = (Uint32)(&node-trinodes.data());
+                stack[top++] = node.start;
+                stack[top++] = curr+1;
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * Returns true if the point is within err of a boundary edge
+     *
+     * @param poly  The polygon for this hierarchy
+     * @param p     The point to test
+     * @param err   The distance tolerance
+     *
+     * @return true if the point is within err of a boundary edge
+     */
+    bool incident(const Poly2& poly, const Vec2& p, float err) const {
+        if (edgenodes.empty()) {
+            return false;
+        }
+        
+        Uint32 stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = edgenodes[stack[--top]];
+            if (p.x < node.min.x-err || p.x > node.max.x+err ||
+                p.y < node.min.y-err || p.y > node.max.y+err) {
+                continue;
+            }
+            if (node.count) {
+                for(Uint32 ii = node.start; ii < node.start+node.count; ii++) {
+                    Uint32 edge = edgeorder[ii];
+                    const Vec2& v = poly.vertices[edges[2*edge  ]];
+                    const Vec2& w = poly.vertices[edges[2*edge+1]];
+                    if (colinear(v,w,p,err)) {
+                        return true;
+                    }
+                }
+            } else {
+                Uint32 curr = (Uint32)(&node-edgenodes.data());
+                stack[top++] = node.start;
+                stack[top++] = curr+1;
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * Returns the boundary point nearest to p
+     *
+     * If there is no boundary, this method returns p.
+     *
+     * @param poly  The polygon for this hierarchy
+     * @param p     The point to test
+     *
+     * @return the boundary point nearest to p
+     */
+    Vec2 nearest(const Poly2& poly, const Vec2& p) const {
+        Vec2 result = p;
+        if (edgenodes.empty()) {
+            return result;
+        }
+        
+        float best = std::numeric_limits<float>::infinity();
+        Uint32 stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = edgenodes[stack[--top]];
+            float dx = std::max(0.0f,std::max(node.min.x-p.x,p.x-node.max.x));
+            float dy = std::max(0.0f,std::max(node.min.y-p.y,p.y-node.max.y));
+            if (dx*dx+dy*dy >= best) {
+                continue;
+            }
+            if (node.count) {
+                for(Uint32 ii = node.start; ii < node.start+node.count; ii++) {
+                    Uint32 edge = edgeorder[ii];
+                    Vec2 q = project_segment(poly.vertices[edges[2*edge  ]],
+                                             poly.vertices[edges[2*edge+1]], p);
+                    float d2 = q.distanceSquared(p);
+                    if (d2 < best) {
+                        best = d2;
+                        result = q;
+                    }
+                }
+            } else {
+                // Visit the closer child first for better pruning
+                Uint32 curr  = (Uint32)(&node-edgenodes.data());
+                Uint32 left  = curr+1;
+                Uint32 right = node.start;
+                const Node& ln = edgenodes[left];
+                Vec2 lc = (ln.min+ln.max)*0.5f;
+                const Node& rn = edgenodes[right];
+                Vec2 rc = (rn.min+rn.max)*0.5f;
+                if (lc.distanceSquared(p) < rc.distanceSquared(p)) {
+                    std::swap(left,right);
+                }
+                stack[top++] = left;
+                stack[top++] = right;
+            }
+        }
+        return result;
+    }
+    
+    /**
+     * Returns true if the segment crosses a boundary edge
+     *
+     * If hit is not null, it stores the crossing closest to start.
+     *
+     * @param poly  The polygon for this hierarchy
+     * @param start The start of the line segment
+     * @param end   The end of the line segment
+     * @param hit   Optional pointer to store the first crossing
+     *
+     * @return true if the segment crosses a boundary edge
+     */
+    bool intersects(const Poly2& poly, const Vec2& start, const Vec2& end, Vec2* hit) const {
+        if (edgenodes.empty()) {
+            return false;
+        }
+        
+        Vec2 dir = end-start;
+        float best = 2.0f;
+        Uint32 stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = edgenodes[stack[--top]];
+            
+            // Slab test, clipped to the best crossing so far
+            float tmin = 0.0f;
+            float tmax = std::min(1.0f,best);
+            bool miss = false;
+            for(int axis = 0; !miss && axis < 2; axis++) {
+                float o  = axis ? start.y : start.x;
+                float d  = axis ? dir.y : dir.x;
+                float lo = axis ? node.min.y : node.min.x;
+                float hi = axis ? node.max.y : node.max.x;
+                if (d == 0.0f) {
+                    miss = (o < lo || o > hi);
+                } else {
+                    float t0 = (lo-o)/d;
+                    float t1 = (hi-o)/d;
+                    if (t0 > t1) {
+                        std::swap(t0,t1);
+                    }
+                    tmin = std::max(tmin,t0);
+                    tmax = std::min(tmax,t1);
+                    miss = tmin > tmax;
+                }
+            }
+            if (miss) {
+                continue;
+            }
+            
+            if (node.count) {
+                for(Uint32 ii = node.start; ii < node.start+node.count; ii++) {
+                    Uint32 edge = edgeorder[ii];
+                    float t;
+                    if (segment_cross(start, end, poly.vertices[edges[2*edge  ]],
+                                      poly.vertices[edges[2*edge+1]], t) && t < best) {
+                        best = t;
+                        if (hit == nullptr) {
+                            return true;
+                        }
+                    }
+                }
+            } else {
+                Uint32 curr = (Uint32)(&node-edgenodes.data());
+                stack[top++] = node.start;
+                stack[top++] = curr+1;
+            }
+        }
+        
+        if (best > 1.0f) {
+            return false;
+        } else if (hit != nullptr) {
+            *hit = start+dir*best;
+        }
+        return true;
+    }
+};
+
 #pragma mark -
 #pragma mark Setters
 /**
@@ -501,6 +981,7 @@ static bool colinear(const Vec2& v, const Vec2& w, const Vec2& p, float err) {
  * @return This polygon, returned for chaining
  */
 Poly2& Poly2::set(const vector<Vec2>& vertices) {
+    invalidate();
     this->vertices = vertices;
     indices.clear();
     return *this;
@@ -519,6 +1000,7 @@ Poly2& Poly2::set(const vector<Vec2>& vertices) {
  * @return This polygon, returned for chaining
  */
 Poly2& Poly2::set(const Vec2* vertices, size_t vertsize) {
+    invalidate();
     this->vertices.assign(vertices,vertices+vertsize);
     indices.clear();
     return *this;
@@ -539,6 +1021,8 @@ Poly2& Poly2::set(const Vec2* vertices, size_t vertsize) {
 Poly2& Poly2::set(const Poly2& poly) {
     vertices = poly.vertices;
     indices  = poly.indices;
+    _accelerate = poly._accelerate;
+    _tree = poly._tree;
     return *this;
 }
 
@@ -554,6 +1038,7 @@ Poly2& Poly2::set(const Poly2& poly) {
  * @return This polygon, returned for chaining
  */
 Poly2& Poly2::set(const Rect rect) {
+    invalidate();
     vertices.clear();
     indices.clear();
     vertices.reserve(4);
@@ -578,7 +1063,8 @@ Poly2& Poly2::set(const Rect rect) {
  * The JsonValue should either be an array of floats or an JSON object.
  * If it is an array of floats, then it interprets those floats as the
  * vertices. The polygon indices will be generated using an
- * {@link EarclipTriangulator}.
+ * {@link EarclipTriangulator}, or a {@link MonotoneTriangulator} if there
+ * are at least {@link CU_MONOTONE_THRESHOLD} vertices.
  *
  * On the other hand, if it is a JSON object, it supports the following
  * attributes:
@@ -590,13 +1076,15 @@ Poly2& Poly2::set(const Rect rect) {
  * All attributes are optional. If "vertices" are missing, the polygon will
  * be empty.  If both "indices" and "triangulator" are missing, the polygon
  * will have no indices. The "triangulator" choice will only be applied if
- * the "indices" are missing.
+ * the "indices" are missing. If "triangulator" is missing, the choice is
+ * made by the size of the polygon, as with an array of floats.
  *
  * @param data      The JSON object specifying the polygon
  *
  * @return This polygon, returned for chaining
  */
 Poly2& Poly2::set(const std::shared_ptr<JsonValue>& data) {
+    invalidate();
     vertices.clear();
     indices.clear();
     if (data->isArray()) {
@@ -609,7 +1097,11 @@ Poly2& Poly2::set(const std::shared_ptr<JsonValue>& data) {
             vert.y = poly->get(ii+1)->asFloat(0.0f);
             vertices.push_back(vert);
         }
-        triangulate<EarclipTriangulator>(vertices, indices);
+        if (vertices.size() >= CU_MONOTONE_THRESHOLD) {
+            triangulate<MonotoneTriangulator>(vertices, indices);
+        } else {
+            triangulate<EarclipTriangulator>(vertices, indices);
+        }
     } else if (data->has("vertices")) {
         std::vector<Uint32> holes;
         JsonValue* poly = data->get("vertices").get();
@@ -644,9 +1136,10 @@ Poly2& Poly2::set(const std::shared_ptr<JsonValue>& data) {
                 indices.push_back(tris->get(ii  )->asInt(0));
             }
         } else {
-            std::string choice = data->getString("triangulator","earclip");
+            std::string fallback = vertices.size() >= CU_MONOTONE_THRESHOLD ? "monotone" : "earclip";
+            std::string choice = data->getString("triangulator",fallback);
             if (choice == "monotone") {
-                triangulate<EarclipTriangulator>(vertices, holes, indices);
+                triangulate<MonotoneTriangulator>(vertices, holes, indices);
             } else if (choice == "delaunay") {
                 triangulate<DelaunayTriangulator>(vertices, holes, indices);
             } else {
@@ -674,6 +1167,7 @@ Poly2& Poly2::set(const std::shared_ptr<JsonValue>& data) {
   * @return This polygon, returned for chaining
   */
 Poly2& Poly2::setIndices(const vector<Uint32>& indices) {
+    invalidate();
     this->indices = indices;
     return *this;
 }
@@ -695,6 +1189,7 @@ Poly2& Poly2::setIndices(const vector<Uint32>& indices) {
  * @return This polygon, returned for chaining
  */
 Poly2& Poly2::setIndices(const Uint32* indices, size_t indxsize) {
+    invalidate();
     this->indices.assign(indices, indices+indxsize);
     return *this;
 }
@@ -705,6 +1200,7 @@ Poly2& Poly2::setIndices(const Uint32* indices, size_t indxsize) {
  * @return This polygon, returned for chaining
  */
 Poly2& Poly2::clear() {
+    invalidate();
     vertices.clear();
     indices.clear();
     return *this;
@@ -724,6 +1220,7 @@ Poly2& Poly2::clear() {
  * @return This polygon, scaled uniformly.
  */
 Poly2& Poly2::operator*=(float scale) {
+    invalidate();
     for(auto it = vertices.begin(); it != vertices.end(); ++it) {
         *it *= scale;
     }
@@ -742,6 +1239,7 @@ Poly2& Poly2::operator*=(float scale) {
  * @return This polygon, scaled non-uniformly.
  */
 Poly2& Poly2::operator*=(const Vec2 scale) {
+    invalidate();
     for(auto it = vertices.begin(); it != vertices.end(); ++it) {
         it->x *= scale.x;
         it->y *= scale.y;
@@ -757,11 +1255,8 @@ Poly2& Poly2::operator*=(const Vec2 scale) {
  * @return This polygon with the vertices transformed
  */
 Poly2& Poly2::operator*=(const Affine2& transform) {
-    Vec2 tmp;
-    for(auto it = vertices.begin(); it != vertices.end(); ++it) {
-        Affine2::transform(transform, *it, &tmp);
-        *it = tmp;
-    }
+    invalidate();
+    Affine2::transform(transform,vertices.data(),vertices.data(),vertices.size());
     return *this;
 }
 
@@ -775,11 +1270,8 @@ Poly2& Poly2::operator*=(const Affine2& transform) {
  * @return This polygon with the vertices transformed
  */
 Poly2& Poly2::operator*=(const Mat4& transform) {
-    Vec2 tmp;
-    for(auto it = vertices.begin(); it != vertices.end(); ++it) {
-        Mat4::transform(transform, *it, &tmp);
-        *it = tmp;
-    }
+    invalidate();
+    Mat4::transform(transform,vertices.data(),vertices.data(),vertices.size());
     return *this;
 }
 
@@ -795,6 +1287,7 @@ Poly2& Poly2::operator*=(const Mat4& transform) {
  * @return This polygon, scaled uniformly.
  */
 Poly2& Poly2::operator/=(float scale) {
+    invalidate();
     CUAssertLog(scale != 0, "Division by 0");
     for(auto it = vertices.begin(); it != vertices.end(); ++it) {
         it->x /= scale;
@@ -815,6 +1308,7 @@ Poly2& Poly2::operator/=(float scale) {
  * @return This polygon, scaled non-uniformly.
  */
 Poly2& Poly2::operator/=(const Vec2 scale) {
+    invalidate();
     for(auto it = vertices.begin(); it != vertices.end(); ++it) {
         it->x /= scale.x;
         it->y /= scale.y;
@@ -830,6 +1324,7 @@ Poly2& Poly2::operator/=(const Vec2 scale) {
  * @return This polygon, translated uniformly.
  */
 Poly2& Poly2::operator+=(float offset) {
+    invalidate();
     for(auto it = vertices.begin(); it != vertices.end(); ++it) {
         it->x += offset;
         it->y += offset;
@@ -845,6 +1340,7 @@ Poly2& Poly2::operator+=(float offset) {
  * @return This polygon, translated non-uniformly.
  */
 Poly2& Poly2::operator+=(const Vec2 offset) {
+    invalidate();
     for(auto it = vertices.begin(); it != vertices.end(); ++it) {
         *it += offset;
     }
@@ -859,6 +1355,7 @@ Poly2& Poly2::operator+=(const Vec2 offset) {
  * @return This polygon, translated uniformly.
  */
 Poly2& Poly2::operator-=(float offset) {
+    invalidate();
     for(auto it = vertices.begin(); it != vertices.end(); ++it) {
         it->x -= offset;
         it->y -= offset;
@@ -874,6 +1371,7 @@ Poly2& Poly2::operator-=(float offset) {
  * @return This polygon, translated non-uniformly.
  */
 Poly2& Poly2::operator-=(const Vec2 offset) {
+    invalidate();
     for(auto it = vertices.begin(); it != vertices.end(); ++it) {
         *it -= offset;
     }
@@ -882,6 +1380,30 @@ Poly2& Poly2::operator-=(const Vec2 offset) {
 
 #pragma mark -
 #pragma mark Geometry Methods
+/**
+ * Sets whether geometry queries on this polygon are accelerated.
+ *
+ * An accelerated polygon answers {@link #contains}, {@link #incident},
+ * {@link #getNearest} and {@link #intersects} with a bounding volume
+ * hierarchy over its triangles and boundary edges. This hierarchy is built
+ * on the first query, and is reused until this polygon changes, so these
+ * queries are O(log n) instead of O(n). It is off by default, as it is
+ * only worth the memory for large polygons that are queried repeatedly.
+ *
+ * The hierarchy is rebuilt automatically whenever this polygon is changed
+ * by one of its methods. However, because {@link #vertices} and
+ * {@link #indices} are public, it cannot detect when those values are
+ * modified in place. Call {@link #invalidate} after any such change.
+ *
+ * @param value Whether to accelerate geometry queries
+ */
+void Poly2::setAccelerated(bool value) {
+    _accelerate = value;
+    if (!value) {
+        _tree = nullptr;
+    }
+}
+
 /**
  * Returns the bounding box for the polygon
  *
@@ -952,6 +1474,11 @@ std::vector<Uint32> Poly2::convexHull() const {
  * @return true if this polygon contains the given point.
  */
 bool Poly2::contains(float x, float y) const {
+    Hierarchy* tree = getHierarchy();
+    if (tree != nullptr) {
+        return tree->contains(*this,Vec2(x,y));
+    }
+    
     bool inside = false;
     for (int ii = 0; !inside && 3 * ii < indices.size(); ii++) {
         Vec2 temp2(x,y);
@@ -979,6 +1506,11 @@ bool Poly2::contains(float x, float y) const {
  */
 bool Poly2::incident(float x, float y, float err) const {
     Vec2 p(x,y);
+    Hierarchy* tree = getHierarchy();
+    if (tree != nullptr) {
+        return tree->incident(*this,p,err);
+    }
+    
     std::vector<std::vector<Uint32>> bounds = boundaries();
     for(auto it = bounds.begin(); it != bounds.end(); ++it) {
         for (size_t ii = 0; ii < it->size(); ii += 2) {
@@ -992,6 +1524,78 @@ bool Poly2::incident(float x, float y, float err) const {
     return false;
 }
 
+/**
+ * Returns the point on the boundary of this polygon nearest the given one.
+ *
+ * The boundary consists of the triangle edges that are not shared by
+ * two triangles. If this polygon has no boundary (e.g. it has no indices),
+ * this method returns the point itself.
+ *
+ * @param point The point to check
+ *
+ * @return the point on the boundary of this polygon nearest the given one.
+ */
+Vec2 Poly2::getNearest(Vec2 point) const {
+    Hierarchy* tree = getHierarchy();
+    if (tree != nullptr) {
+        return tree->nearest(*this,point);
+    }
+    
+    std::vector<Uint32> edges;
+    boundary_edges(indices,edges);
+    Vec2 result = point;
+    float best = std::numeric_limits<float>::infinity();
+    for(size_t ii = 0; ii < edges.size(); ii += 2) {
+        Vec2 q = project_segment(vertices[edges[ii]],vertices[edges[ii+1]],point);
+        float d2 = q.distanceSquared(point);
+        if (d2 < best) {
+            best = d2;
+            result = q;
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns true if the given line segment crosses the boundary of this polygon.
+ *
+ * The boundary consists of the triangle edges that are not shared by
+ * two triangles. If hit is not null, it will store the boundary crossing
+ * that is closest to start.
+ *
+ * @param start The start of the line segment
+ * @param end   The end of the line segment
+ * @param hit   Optional pointer to store the first crossing
+ *
+ * @return true if the given line segment crosses the boundary of this polygon.
+ */
+bool Poly2::intersects(const Vec2& start, const Vec2& end, Vec2* hit) const {
+    Hierarchy* tree = getHierarchy();
+    if (tree != nullptr) {
+        return tree->intersects(*this,start,end,hit);
+    }
+    
+    std::vector<Uint32> edges;
+    boundary_edges(indices,edges);
+    float best = 2.0f;
+    for(size_t ii = 0; ii < edges.size(); ii += 2) {
+        float t;
+        if (segment_cross(start,end,vertices[edges[ii]],vertices[edges[ii+1]],t) && t < best) {
+            best = t;
+            if (hit == nullptr) {
+                return true;
+            }
+        }
+    }
+    
+    if (best > 1.0f) {
+        return false;
+    } else if (hit != nullptr) {
+        *hit = start+(end-start)*best;
+    }
+    return true;
+}
+
 /**
  * Returns the set of indices that are on a boundary of this polygon
  *
@@ -1263,3 +1867,21 @@ Vec3 Poly2::getBarycentric(Vec2 point, Uint32 index) const {
     result.z = 1 - result.x - result.y;
     return result;
 }
+
+/**
+ * Returns the acceleration hierarchy for this polygon.
+ *
+ * The hierarchy is built on demand. It is rebuilt if the size of the
+ * vertices or indices has changed since it was last built. This method
+ * returns nullptr if the polygon is not accelerated.
+ *
+ * @return the acceleration hierarchy for this polygon.
+ */
+Poly2::Hierarchy* Poly2::getHierarchy() const {
+    if (!_accelerate) {
+        return nullptr;
+    } else if (_tree == nullptr || !_tree->matches(*this)) {
+        _tree = std::make_shared<Hierarchy>(*this);
+    }
+    return _tree.get();
+}
@@ -0,0 +1,178 @@
+//
+//  cuEasingTable.inl
+//  Cornell University Game Library (CUGL)
+//
+//  This include file provides several static inline functions for evaluating
+//  easing functions with lookup tables. They are shared by EasingFunction and
+//  EasingBezier. A table approximates a curve on [0,1] by a piecewise cubic
+//  with monotone (Fritsch-Carlson) tangents, so that the table never overshoots
+//  between samples. Each interval is stored as a row of four coefficients, so
+//  that a lookup is a single row load for both linear and cubic interpolation.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/math/CUMathBase.h>
+#include <cugl/math/CUEasingFunction.h>
+#include "dsp/cuDSP128.inl"
+
+/**
+ * Builds the lookup table for the given samples
+ *
+ * The samples are EASING_TABLE_SIZE+1 evenly spaced values of the curve on
+ * [0,1]. The table is EASING_TABLE_SIZE rows of the four coefficients
+ * (c0,c1,c2,c3) of the cubic c0+c1*u+c2*u^2+c3*u^3 on each interval, where u
+ * is the position within the interval. As c1+c2+c3 is the difference between
+ * samples, the same row also supports linear interpolation.
+ *
+ * @param samples   The curve samples
+ * @param table     The table to store the coefficients
+ */
+static inline void easing_table_build(const float* samples, float* table) {
+    const int size = EASING_TABLE_SIZE;
+    float tangents[EASING_TABLE_SIZE+1];
+    float secants[EASING_TABLE_SIZE];
+    for(int ii = 0; ii < size; ii++) {
+        secants[ii] = samples[ii+1]-samples[ii];
+    }
+
+    tangents[0] = secants[0];
+    tangents[size] = secants[size-1];
+    for(int ii = 1; ii < size; ii++) {
+        if (secants[ii-1]*secants[ii] <= 0) {
+            tangents[ii] = 0;
+        } else {
+            tangents[ii] = (secants[ii-1]+secants[ii])*0.5f;
+        }
+    }
+
+    // Fritsch-Carlson limiter to preserve monotonicity
+    for(int ii = 0; ii < size; ii++) {
+        if (secants[ii] == 0) {
+            tangents[ii] = 0;
+            tangents[ii+1] = 0;
+        } else {
+            float alpha = tangents[ii]/secants[ii];
+            float beta  = tangents[ii+1]/secants[ii];
+            float norm  = alpha*alpha+beta*beta;
+            if (norm > 9) {
+                float tau = 3.0f/sqrtf(norm);
+                tangents[ii]   = tau*alpha*secants[ii];
+                tangents[ii+1] = tau*beta*secants[ii];
+            }
+        }
+    }
+
+    for(int ii = 0; ii < size; ii++) {
+        float* row = table+4*ii;
+        row[0] = samples[ii];
+        row[1] = tangents[ii];
+        row[2] = 3*secants[ii]-2*tangents[ii]-tangents[ii+1];
+        row[3] = tangents[ii]+tangents[ii+1]-2*secants[ii];
+    }
+}
+
+/**
+ * Returns the table approximation of the curve at t
+ *
+ * The value t is clamped to [0,1].
+ *
+ * @param table     The lookup table
+ * @param t         The time to evaluate
+ * @param cubic     Whether to use cubic (as opposed to linear) interpolation
+ *
+ * @return the table approximation of the curve at t
+ */
+static inline float easing_table_lookup(const float* table, float t, bool cubic) {
+    float x = std::max(0.0f,std::min(1.0f,t))*EASING_TABLE_SIZE;
+    int pos = std::min((int)x,EASING_TABLE_SIZE-1);
+    float u = x-pos;
+    const float* row = table+4*pos;
+    if (cubic) {
+        return ((row[3]*u+row[2])*u+row[1])*u+row[0];
+    }
+    return row[0]+(row[1]+row[2]+row[3])*u;
+}
+
+/**
+ * Evaluates the table approximation of the curve on an array of times
+ *
+ * The times are clamped to [0,1]. The input and output may be the same.
+ *
+ * @param table     The lookup table
+ * @param input     The times to evaluate
+ * @param output    The array to store the results
+ * @param count     The number of times to evaluate
+ * @param cubic     Whether to use cubic (as opposed to linear) interpolation
+ */
+static inline void easing_table_evaluate(const float* table, const float* input, float* output,
+                                         size_t count, bool cubic) {
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    const __m128 zero  = _mm_setzero_ps();
+    const __m128 one   = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps((float)EASING_TABLE_SIZE);
+    const __m128 last  = _mm_set1_ps((float)(EASING_TABLE_SIZE-1));
+    __m128 rows[4];
+    for(; ii+4 <= count; ii += 4) {
+        __m128 x = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(input+ii),zero),one),scale);
+        __m128i pos = _mm_cvttps_epi32(_mm_min_ps(x,last));
+        __m128 u = _mm_sub_ps(x,_mm_cvtepi32_ps(pos));
+        _mm_gather4_ps(table,pos,rows);
+        __m128 y;
+        if (cubic) {
+            y = _mm_add_ps(_mm_mul_ps(rows[3],u),rows[2]);
+            y = _mm_add_ps(_mm_mul_ps(y,u),rows[1]);
+            y = _mm_add_ps(_mm_mul_ps(y,u),rows[0]);
+        } else {
+            y = _mm_add_ps(_mm_add_ps(rows[1],rows[2]),rows[3]);
+            y = _mm_add_ps(_mm_mul_ps(y,u),rows[0]);
+        }
+        _mm_storeu_ps(output+ii,y);
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+    const float32x4_t zero  = vdupq_n_f32(0.0f);
+    const float32x4_t one   = vdupq_n_f32(1.0f);
+    const float32x4_t last  = vdupq_n_f32((float)(EASING_TABLE_SIZE-1));
+    float32x4_t rows[4];
+    for(; ii+4 <= count; ii += 4) {
+        float32x4_t x = vminq_f32(vmaxq_f32(vld1q_f32(input+ii),zero),one);
+        x = vmulq_n_f32(x,(float)EASING_TABLE_SIZE);
+        int32x4_t pos = vcvtq_s32_f32(vminq_f32(x,last));
+        float32x4_t u = vsubq_f32(x,vcvtq_f32_s32(pos));
+        vld1q_gather4_f32(table,pos,rows);
+        float32x4_t y;
+        if (cubic) {
+            y = vmlaq_f32(rows[2],rows[3],u);
+            y = vmlaq_f32(rows[1],y,u);
+            y = vmlaq_f32(rows[0],y,u);
+        } else {
+            y = vaddq_f32(vaddq_f32(rows[1],rows[2]),rows[3]);
+            y = vmlaq_f32(rows[0],y,u);
+        }
+        vst1q_f32(output+ii,y);
+    }
+#endif
+    for(; ii < count; ii++) {
+        output[ii] = easing_table_lookup(table,input[ii],cubic);
+    }
+}
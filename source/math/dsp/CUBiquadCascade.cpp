@@ -0,0 +1,438 @@
+//
+//  CUBiquadCascade.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This class represents a chain of biquad filters applied to the same
+//  multichannel signal, such as the bands of a parametric equalizer. Running
+//  a separate BiquadIIR for each band makes a pass over the whole buffer for
+//  each one. This class instead processes the channels side by side in the
+//  lanes of a vector register, and runs each section over the block while its
+//  state stays in registers. Hence an 8 channel bus is two vectors per frame,
+//  and the whole cascade is a single kernel.
+//
+//  The sections use the transposed direct form II, which is numerically
+//  robust for floats and has no latency. This differs from BiquadIIR, which
+//  delays its output by two frames.
+//
+//  This class supports vector optimizations for SSE and Neon 64. Like the
+//  other DSP classes, our implementation is limited to 128-bit words. Instead
+//  of 256-bit words, the kernel runs two channel groups at once, as the
+//  independent recurrences hide the latency of each multiply-add.
+//
+//  This class is NOT THREAD SAFE.  This is by design, for performance reasons.
+//  External locking may be required when the filter is shared between multiple
+//  threads (such as between an audio thread and the main thread).
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/math/dsp/CUBiquadCascade.h>
+#include <cugl/util/CUDebug.h>
+#include "cuDSP128.inl"
+
+using namespace cugl;
+using namespace cugl::dsp;
+
+/** The number of coefficients per section */
+#define SECTION_COEFFS  5
+
+/** Whether to use a vectorization algorithm */
+bool BiquadCascade::VECTORIZE = true;
+
+/**
+ * Writes the coefficients of a pass-through section to the given array
+ *
+ * @param coeffs    The array of SECTION_COEFFS coefficients
+ */
+static void pass_through(float* coeffs) {
+    coeffs[0] = 1.0f;
+    for(size_t ii = 1; ii < SECTION_COEFFS; ii++) {
+        coeffs[ii] = 0.0f;
+    }
+}
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates an empty cascade for a single channel.
+ *
+ * An empty cascade is a pass-through filter.
+ */
+BiquadCascade::BiquadCascade() :
+_channels(1),
+_sections(0) {
+    reset();
+}
+
+/**
+ * Creates a cascade of pass-through sections for the given channels.
+ *
+ * @param channels  The number of channels
+ * @param sections  The number of sections
+ */
+BiquadCascade::BiquadCascade(unsigned channels, size_t sections) :
+_channels(channels),
+_sections(sections) {
+    CUAssertLog(channels > 0, "Channels %d must be non-zero.",channels);
+    _coeffs.resize(SECTION_COEFFS*sections);
+    for(size_t ii = 0; ii < sections; ii++) {
+        pass_through(_coeffs.data()+SECTION_COEFFS*ii);
+    }
+    reset();
+}
+
+/**
+ * Creates a copy of the biquad cascade.
+ *
+ * @param copy  The filter to copy
+ */
+BiquadCascade::BiquadCascade(const BiquadCascade& copy) {
+    _channels = copy._channels;
+    _sections = copy._sections;
+    _coeffs = copy._coeffs;
+    _state1 = copy._state1;
+    _state2 = copy._state2;
+}
+
+/**
+ * Creates a biquad cascade with the resources of the original.
+ *
+ * @param filter    The filter to acquire
+ */
+BiquadCascade::BiquadCascade(BiquadCascade&& filter) {
+    _channels = filter._channels;
+    _sections = filter._sections;
+    _coeffs = std::move(filter._coeffs);
+    _state1 = std::move(filter._state1);
+    _state2 = std::move(filter._state2);
+}
+
+/**
+ * Resets the state buffers for the current channels and sections.
+ *
+ * This must be called if the number of channels or sections change.
+ */
+void BiquadCascade::reset() {
+    _state1.reset(_channels*_sections,16);
+    _state2.reset(_channels*_sections,16);
+    clear();
+}
+
+#pragma mark -
+#pragma mark Attributes
+/**
+ * Sets the number of channels for this filter
+ *
+ * The data buffers depend on the number of channels.  Changing this value
+ * will reset the data buffers to 0.
+ *
+ * @param channels  The number of channels for this filter
+ */
+void BiquadCascade::setChannels(unsigned channels) {
+    CUAssertLog(channels > 0, "Channels %d must be non-zero.",channels);
+    _channels = channels;
+    reset();
+}
+
+/**
+ * Sets the number of sections in this cascade.
+ *
+ * Existing sections keep their coefficients, and new sections are
+ * pass-through filters. Changing this value will reset the data buffers
+ * to 0.
+ *
+ * @param sections  The number of sections in this cascade.
+ */
+void BiquadCascade::setSections(size_t sections) {
+    _coeffs.resize(SECTION_COEFFS*sections);
+    for(size_t ii = _sections; ii < sections; ii++) {
+        pass_through(_coeffs.data()+SECTION_COEFFS*ii);
+    }
+    _sections = sections;
+    reset();
+}
+
+/**
+ * Sets the coefficients of the given section.
+ *
+ * The section implements the difference equation
+ *
+ *   y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]
+ *
+ * This does not reset the data buffers, so the coefficients may be
+ * changed while the filter is running.
+ *
+ * @param index The section index
+ * @param b0    The upper zero-order coefficient
+ * @param b1    The upper first-order coefficient
+ * @param b2    The upper second-order coefficient
+ * @param a1    The lower first-order coefficient
+ * @param a2    The lower second-order coefficient
+ */
+void BiquadCascade::setSection(size_t index, float b0, float b1, float b2, float a1, float a2) {
+    CUAssertLog(index < _sections, "Section %zu is out of range.",index);
+    float* coeffs = _coeffs.data()+SECTION_COEFFS*index;
+    coeffs[0] = b0;
+    coeffs[1] = b1;
+    coeffs[2] = b2;
+    coeffs[3] = a1;
+    coeffs[4] = a2;
+}
+
+/**
+ * Sets the coefficients of the given section to those of a biquad filter.
+ *
+ * This does not reset the data buffers, so the coefficients may be
+ * changed while the filter is running.
+ *
+ * @param index     The section index
+ * @param filter    The filter to copy the coefficients from
+ */
+void BiquadCascade::setSection(size_t index, const BiquadIIR& filter) {
+    std::vector<float> bvals = filter.getBCoeff();
+    std::vector<float> avals = filter.getACoeff();
+    setSection(index,bvals[0],bvals[1],bvals[2],avals[1],avals[2]);
+}
+
+/**
+ * Sets the given section to the special purpose filter of the given type
+ *
+ * This method is equivalent to {@link BiquadIIR#setType}. See that method
+ * for the meaning of the parameters. This does not reset the data
+ * buffers, so the bands of an equalizer may be adjusted while the
+ * filter is running.
+ *
+ * @param index     The section index
+ * @param type      The filter type
+ * @param frequency The (normalized) target frequency
+ * @param gainDB    The gain at the target frequency in decibels
+ * @param qVal      The special Q factor
+ */
+void BiquadCascade::setSection(size_t index, BiquadIIR::Type type, float frequency,
+                               float gainDB, float qVal) {
+    BiquadIIR filter(1,type,frequency,gainDB,qVal);
+    setSection(index,filter);
+}
+
+#pragma mark -
+#pragma mark Filter Methods
+/**
+ * Applies a single section to interleaved data.
+ *
+ * The input and output may be the same array. The gain is applied to
+ * the input of the section.
+ *
+ * @param section   The section index
+ * @param gain      The input gain factor
+ * @param input     The array of input samples
+ * @param output    The array to write the sample output
+ * @param size      The input size in frames
+ */
+void BiquadCascade::section(size_t section, float gain, const float* input, float* output, size_t size) {
+    const float* coeffs = _coeffs.data()+SECTION_COEFFS*section;
+    // Scaling the b-coefficients applies the gain to the input
+    float b0 = gain*coeffs[0];
+    float b1 = gain*coeffs[1];
+    float b2 = gain*coeffs[2];
+    float a1 = -coeffs[3];
+    float a2 = -coeffs[4];
+
+    float* state1 = _state1+section*_channels;
+    float* state2 = _state2+section*_channels;
+    size_t stride = _channels;
+    unsigned ckk = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    if (VECTORIZE) {
+        __m128 factor0 = _mm_set1_ps(b0);
+        __m128 factor1 = _mm_set1_ps(b1);
+        __m128 factor2 = _mm_set1_ps(b2);
+        __m128 factor3 = _mm_set1_ps(a1);
+        __m128 factor4 = _mm_set1_ps(a2);
+
+        // Two independent groups hide the latency of the recurrence
+        for(; ckk+8 <= _channels; ckk += 8) {
+            __m128 s1a = _mm_loadu_ps(state1+ckk);
+            __m128 s1b = _mm_loadu_ps(state1+ckk+4);
+            __m128 s2a = _mm_loadu_ps(state2+ckk);
+            __m128 s2b = _mm_loadu_ps(state2+ckk+4);
+            for(size_t ii = 0; ii < size; ii++) {
+                size_t pos = ii*stride+ckk;
+                __m128 xa = _mm_loadu_ps(input+pos);
+                __m128 xb = _mm_loadu_ps(input+pos+4);
+                __m128 ya = _mm_add_ps(_mm_mul_ps(factor0,xa),s1a);
+                __m128 yb = _mm_add_ps(_mm_mul_ps(factor0,xb),s1b);
+                s1a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(factor1,xa),_mm_mul_ps(factor3,ya)),s2a);
+                s1b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(factor1,xb),_mm_mul_ps(factor3,yb)),s2b);
+                s2a = _mm_add_ps(_mm_mul_ps(factor2,xa),_mm_mul_ps(factor4,ya));
+                s2b = _mm_add_ps(_mm_mul_ps(factor2,xb),_mm_mul_ps(factor4,yb));
+                _mm_storeu_ps(output+pos,ya);
+                _mm_storeu_ps(output+pos+4,yb);
+            }
+            _mm_storeu_ps(state1+ckk,s1a);
+            _mm_storeu_ps(state1+ckk+4,s1b);
+            _mm_storeu_ps(state2+ckk,s2a);
+            _mm_storeu_ps(state2+ckk+4,s2b);
+        }
+        for(; ckk+4 <= _channels; ckk += 4) {
+            __m128 s1 = _mm_loadu_ps(state1+ckk);
+            __m128 s2 = _mm_loadu_ps(state2+ckk);
+            for(size_t ii = 0; ii < size; ii++) {
+                size_t pos = ii*stride+ckk;
+                __m128 x = _mm_loadu_ps(input+pos);
+                __m128 y = _mm_add_ps(_mm_mul_ps(factor0,x),s1);
+                s1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(factor1,x),_mm_mul_ps(factor3,y)),s2);
+                s2 = _mm_add_ps(_mm_mul_ps(factor2,x),_mm_mul_ps(factor4,y));
+                _mm_storeu_ps(output+pos,y);
+            }
+            _mm_storeu_ps(state1+ckk,s1);
+            _mm_storeu_ps(state2+ckk,s2);
+        }
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+#if defined (__ANDROID__)
+    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
+        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
+#else
+    if (VECTORIZE) {
+#endif
+        float32x4_t factor0 = vdupq_n_f32(b0);
+        float32x4_t factor1 = vdupq_n_f32(b1);
+        float32x4_t factor2 = vdupq_n_f32(b2);
+        float32x4_t factor3 = vdupq_n_f32(a1);
+        float32x4_t factor4 = vdupq_n_f32(a2);
+
+        // Two independent groups hide the latency of the recurrence
+        for(; ckk+8 <= _channels; ckk += 8) {
+            float32x4_t s1a = vld1q_f32(state1+ckk);
+            float32x4_t s1b = vld1q_f32(state1+ckk+4);
+            float32x4_t s2a = vld1q_f32(state2+ckk);
+            float32x4_t s2b = vld1q_f32(state2+ckk+4);
+            for(size_t ii = 0; ii < size; ii++) {
+                size_t pos = ii*stride+ckk;
+                float32x4_t xa = vld1q_f32(input+pos);
+                float32x4_t xb = vld1q_f32(input+pos+4);
+                float32x4_t ya = vmlaq_f32(s1a,factor0,xa);
+                float32x4_t yb = vmlaq_f32(s1b,factor0,xb);
+                s1a = vmlaq_f32(vmlaq_f32(s2a,factor1,xa),factor3,ya);
+                s1b = vmlaq_f32(vmlaq_f32(s2b,factor1,xb),factor3,yb);
+                s2a = vmlaq_f32(vmulq_f32(factor2,xa),factor4,ya);
+                s2b = vmlaq_f32(vmulq_f32(factor2,xb),factor4,yb);
+                vst1q_f32(output+pos,ya);
+                vst1q_f32(output+pos+4,yb);
+            }
+            vst1q_f32(state1+ckk,s1a);
+            vst1q_f32(state1+ckk+4,s1b);
+            vst1q_f32(state2+ckk,s2a);
+            vst1q_f32(state2+ckk+4,s2b);
+        }
+        for(; ckk+4 <= _channels; ckk += 4) {
+            float32x4_t s1 = vld1q_f32(state1+ckk);
+            float32x4_t s2 = vld1q_f32(state2+ckk);
+            for(size_t ii = 0; ii < size; ii++) {
+                size_t pos = ii*stride+ckk;
+                float32x4_t x = vld1q_f32(input+pos);
+                float32x4_t y = vmlaq_f32(s1,factor0,x);
+                s1 = vmlaq_f32(vmlaq_f32(s2,factor1,x),factor3,y);
+                s2 = vmlaq_f32(vmulq_f32(factor2,x),factor4,y);
+                vst1q_f32(output+pos,y);
+            }
+            vst1q_f32(state1+ckk,s1);
+            vst1q_f32(state2+ckk,s2);
+        }
+    }
+#endif
+    // Channels that do not fill a vector
+    for(; ckk < _channels; ckk++) {
+        float s1 = state1[ckk];
+        float s2 = state2[ckk];
+        for(size_t ii = 0; ii < size; ii++) {
+            size_t pos = ii*stride+ckk;
+            float x = input[pos];
+            float y = b0*x+s1;
+            s1 = b1*x+a1*y+s2;
+            s2 = b2*x+a2*y;
+            output[pos] = y;
+        }
+        state1[ckk] = s1;
+        state2[ckk] = s2;
+    }
+}
+
+/**
+ * Performs a filter of single frame of data.
+ *
+ * The output is written to the given output array, which should be the
+ * same size as the input array. The size should be the number of channels.
+ * The gain parameter is applied at the filter input, but does not affect
+ * the filter coefficients.
+ *
+ * @param gain      The input gain factor
+ * @param input     The input frame
+ * @param output    The frame to receive the output
+ */
+void BiquadCascade::step(float gain, const float* input, float* output) {
+    calculate(gain,input,output,1);
+}
+
+/**
+ * Performs a filter of interleaved input data.
+ *
+ * The output is written to the given output array, which should be the
+ * same size as the input array. The two arrays may be the same. The size
+ * is the number of frames, not samples.  Hence the arrays must be size
+ * times the number of channels in size. The gain parameter is applied at
+ * the filter input, but does not affect the filter coefficients.
+ *
+ * Each section is applied to the whole array before the next one, so the
+ * array should be a typical audio block (so that it stays in the cache).
+ *
+ * @param gain      The input gain factor
+ * @param input     The array of input samples
+ * @param output    The array to write the sample output
+ * @param size      The input size in frames
+ */
+void BiquadCascade::calculate(float gain, const float* input, float* output, size_t size) {
+    if (_sections == 0) {
+        size_t total = size*_channels;
+        for(size_t ii = 0; ii < total; ii++) {
+            output[ii] = gain*input[ii];
+        }
+        return;
+    }
+
+    section(0,gain,input,output,size);
+    for(size_t ii = 1; ii < _sections; ii++) {
+        section(ii,1.0f,output,output,size);
+    }
+}
+
+/**
+ * Clears the filter buffers of any cached inputs or outputs
+ */
+void BiquadCascade::clear() {
+    for(size_t ii = 0; ii < _state1.size(); ii++) {
+        _state1[ii] = 0.0f;
+    }
+    for(size_t ii = 0; ii < _state2.size(); ii++) {
+        _state2[ii] = 0.0f;
+    }
+}
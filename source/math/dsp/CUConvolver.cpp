@@ -0,0 +1,362 @@
+//
+//  CUConvolver.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This class is represents a convolution engine for long kernels, such as
+//  the impulse response of a reverb. It uses a uniformly partitioned FFT
+//  convolution, so the cost per frame grows with the logarithm of the kernel
+//  length instead of the kernel length. The first partition of the kernel is
+//  applied directly, so there is no added latency.
+//
+//  This class uses the FFT in DSPMath, which supports vector optimizations for
+//  SSE and Neon 64. For short kernels (less than a few hundred taps) you
+//  should use FIRFilter instead, which will use this class automatically when
+//  the kernel is long enough.
+//
+//  This class is NOT THREAD SAFE.  This is by design, for performance reasons.
+//  External locking may be required when the filter is shared between multiple
+//  threads (such as between an audio thread and the main thread).
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/math/dsp/CUConvolver.h>
+#include <cugl/math/dsp/CUDSPMath.h>
+#include <cugl/util/CUDebug.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace cugl;
+using namespace cugl::dsp;
+
+/** The smallest supported partition size */
+#define MIN_BLOCK   4
+
+/** The default partition size in frames */
+const size_t Convolver::DEFAULT_BLOCK = 256;
+
+#pragma mark Constructors
+/**
+ * Creates a pass-through convolution for a single channel.
+ */
+Convolver::Convolver() :
+_channels(1),
+_block(DEFAULT_BLOCK),
+_parts(0),
+_offset(0),
+_newest(0) {
+    _kernel.push_back(1.0f);
+    reset();
+}
+
+/**
+ * Creates a pass-through convolution for the given number of channels.
+ *
+ * @param channels  The number of channels
+ */
+Convolver::Convolver(unsigned channels) :
+_block(DEFAULT_BLOCK),
+_parts(0),
+_offset(0),
+_newest(0) {
+    _channels = channels;
+    _kernel.push_back(1.0f);
+    reset();
+}
+
+/**
+ * Creates a convolution with the given kernel and number of channels.
+ *
+ * The block size must be a power of two. If it is not, it will be rounded
+ * up to the next power of two.
+ *
+ * @param channels  The number of channels
+ * @param kernel    The convolution kernel
+ * @param block     The partition size in frames
+ */
+Convolver::Convolver(unsigned channels, const std::vector<float> &kernel, size_t block) :
+_parts(0),
+_offset(0),
+_newest(0) {
+    _channels = channels;
+    _block = std::max((size_t)MIN_BLOCK,(size_t)nextPOT((Uint32)block));
+    _kernel = kernel;
+    reset();
+}
+
+/**
+ * Creates a copy of the convolution.
+ *
+ * @param copy    The convolution to copy
+ */
+Convolver::Convolver(const Convolver& copy) {
+    _channels = copy._channels;
+    _block  = copy._block;
+    _parts  = copy._parts;
+    _offset = copy._offset;
+    _newest = copy._newest;
+    _kernel = copy._kernel;
+    _head = copy._head;
+    _spectra = copy._spectra;
+    _table = copy._table;
+    _inns  = copy._inns;
+    _delay = copy._delay;
+    _tail  = copy._tail;
+    _work  = copy._work;
+}
+
+/**
+ * Creates a convolution with the resources of the original.
+ *
+ * @param filter    The convolution to acquire
+ */
+Convolver::Convolver(Convolver&& filter) {
+    _channels = filter._channels;
+    _block  = filter._block;
+    _parts  = filter._parts;
+    _offset = filter._offset;
+    _newest = filter._newest;
+    _kernel = std::move(filter._kernel);
+    _head = std::move(filter._head);
+    _spectra = std::move(filter._spectra);
+    _table = std::move(filter._table);
+    _inns  = std::move(filter._inns);
+    _delay = std::move(filter._delay);
+    _tail  = std::move(filter._tail);
+    _work  = std::move(filter._work);
+}
+
+/**
+ * Destroys the convolution, releasing all resources.
+ */
+Convolver::~Convolver() {}
+
+/**
+ * Resets the caching data structures for this filter
+ *
+ * This must be called if the number of channels, the block size, or the
+ * kernel change.
+ */
+void Convolver::reset() {
+    size_t fftsize = 2*_block;
+    _parts = _kernel.size() > _block ? (_kernel.size()-1)/_block : 0;
+
+    // The direct partition is in reverse order for the dot product
+    _head.reset(_block,16);
+    _head.clear();
+    size_t amt = std::min(_block,_kernel.size());
+    for(size_t ii = 0; ii < amt; ii++) {
+        _head[_block-ii-1] = _kernel[ii];
+    }
+
+    _table.reset(2*fftsize,16);
+    DSPMath::fft_table(_table,fftsize);
+
+    // Each spectral partition is zero-padded to two blocks
+    _spectra.reset(_parts*2*fftsize,16);
+    _spectra.clear();
+    float norm = 1.0f/fftsize;
+    for(size_t pp = 0; pp < _parts; pp++) {
+        float* spectrum = _spectra+pp*2*fftsize;
+        size_t start = (pp+1)*_block;
+        size_t stop  = std::min(start+_block,_kernel.size());
+        for(size_t ii = start; ii < stop; ii++) {
+            spectrum[2*(ii-start)] = _kernel[ii]*norm;
+        }
+        DSPMath::fft(spectrum,_table,fftsize);
+    }
+
+    _inns.reset(_channels*fftsize,16);
+    _delay.reset(_channels*_parts*2*fftsize,16);
+    _tail.reset(_channels*_block,16);
+    _work.reset(2*fftsize,16);
+    clear();
+}
+
+/**
+ * Completes the current input block
+ *
+ * This method adds the input block to the spectral delay line, and then
+ * computes the spectral contribution to the next output block.
+ */
+void Convolver::advance() {
+    size_t fftsize = 2*_block;
+    for(size_t ckk = 0; ckk < _channels; ckk++) {
+        float* inns = _inns+ckk*fftsize;
+        if (_parts > 0) {
+            // The spectrum of the last two blocks of input
+            float* delay = _delay+ckk*_parts*2*fftsize;
+            float* spectrum = delay+_newest*2*fftsize;
+            for(size_t ii = 0; ii < fftsize; ii++) {
+                spectrum[2*ii  ] = inns[ii];
+                spectrum[2*ii+1] = 0.0f;
+            }
+            DSPMath::fft(spectrum,_table,fftsize);
+
+            // Partition p+1 applies to the input p blocks ago
+            _work.clear();
+            for(size_t pp = 0; pp < _parts; pp++) {
+                size_t pos = (_newest+_parts-pp) % _parts;
+                DSPMath::complex_mult_add(_spectra+pp*2*fftsize, delay+pos*2*fftsize, _work, fftsize);
+            }
+            DSPMath::ifft(_work,_table,fftsize);
+
+            // Overlap-save keeps the second half
+            float* tail = _tail+ckk*_block;
+            for(size_t ii = 0; ii < _block; ii++) {
+                tail[ii] = _work[2*(_block+ii)];
+            }
+        }
+        std::memcpy(inns,inns+_block,_block*sizeof(float));
+    }
+    if (_parts > 0) {
+        _newest = (_newest+1) % _parts;
+    }
+    _offset = 0;
+}
+
+#pragma mark -
+#pragma mark Attributes
+/**
+ * Sets the number of channels for this convolution
+ *
+ * The data buffers depend on the number of channels.  Changing this value
+ * will reset the data buffers to 0.
+ *
+ * @param channels  The number of channels for this convolution
+ */
+void Convolver::setChannels(unsigned channels) {
+    CUAssertLog(channels > 0, "Channels %d must be non-zero.",channels);
+    _channels = channels;
+    reset();
+}
+
+/**
+ * Sets the partition size in frames
+ *
+ * The block size must be a power of two. If it is not, it will be rounded
+ * up to the next power of two. Changing this value will reset the data
+ * buffers to 0.
+ *
+ * @param block The partition size in frames
+ */
+void Convolver::setBlockSize(size_t block) {
+    _block = std::max((size_t)MIN_BLOCK,(size_t)nextPOT((Uint32)block));
+    reset();
+}
+
+/**
+ * Sets the convolution kernel
+ *
+ * This method transforms every partition of the kernel, and allocates the
+ * spectral delay line. Hence it should not be called in the audio thread.
+ * Changing this value will reset the data buffers to 0.
+ *
+ * @param kernel    The convolution kernel
+ */
+void Convolver::setKernel(const std::vector<float> &kernel) {
+    _kernel = kernel;
+    reset();
+}
+
+#pragma mark -
+#pragma mark Filter Methods
+/**
+ * Performs a convolution of single frame of data.
+ *
+ * The output is written to the given output array, which should be the
+ * same size as the input array. The size should be the number of channels.
+ * The gain parameter is applied at the filter input, but does not affect
+ * the kernel.
+ *
+ * @param gain      The input gain factor
+ * @param input     The input frame
+ * @param output    The frame to receive the output
+ */
+void Convolver::step(float gain, float* input, float* output) {
+    calculate(gain,input,output,1);
+}
+
+/**
+ * Performs a convolution of interleaved input data.
+ *
+ * The output is written to the given output array, which should be the
+ * same size as the input array. The size is the number of frames, not
+ * samples.  Hence the arrays must be size times the number of channels
+ * in size. It is safe for the output to be the same as the input.
+ *
+ * The gain parameter is applied at the filter input, but does not affect
+ * the kernel.
+ *
+ * @param gain      The input gain factor
+ * @param input     The array of input samples
+ * @param output    The array to write the sample output
+ * @param size      The input size in frames
+ */
+void Convolver::calculate(float gain, float* input, float* output, size_t size) {
+    size_t fftsize = 2*_block;
+    size_t done = 0;
+    while (done < size) {
+        size_t amt = std::min(size-done,_block-_offset);
+        for(size_t ckk = 0; ckk < _channels; ckk++) {
+            float* inns = _inns+ckk*fftsize;
+            float* tail = _tail+ckk*_block;
+            for(size_t ii = 0; ii < amt; ii++) {
+                size_t pos = _offset+ii;
+                size_t idx = (done+ii)*_channels+ckk;
+                inns[_block+pos] = gain*input[idx];
+                output[idx] = DSPMath::dot(inns+pos+1,1,_head,_block)+tail[pos];
+            }
+        }
+        _offset += amt;
+        done += amt;
+        if (_offset == _block) {
+            advance();
+        }
+    }
+}
+
+/**
+ * Clears the filter buffer of any delayed outputs or cached inputs
+ */
+void Convolver::clear() {
+    _inns.clear();
+    _delay.clear();
+    _tail.clear();
+    _offset = 0;
+    _newest = 0;
+}
+
+/**
+ * Flushes any delayed outputs to the provided array.
+ *
+ * As this filter has no delayed terms, this method will write nothing. It
+ * is only here to standardize the filter signature.
+ *
+ * This method will also clear the buffer.
+ *
+ * @return The number of frames (not samples) written
+ */
+size_t Convolver::flush(float* output) {
+    clear();
+    return 0;
+}
@@ -33,6 +33,9 @@
 //
 #include <cugl/math/dsp/CUDSPMath.h>
 #include <cugl/util/CUDebug.h>
+#include <cstring>
+#include <cmath>
+#include <utility>
 #include "cuDSP128.inl"
 
 using namespace cugl;
@@ -41,6 +44,45 @@ using namespace cugl::dsp;
 /** Whether to use a vectorization algorithm */
 bool DSPMath::VECTORIZE = true;
 
+/** The maximum number of channels supported by remix */
+#define REMIX_CHANNELS  8
+
+/**
+ * Reorders complex data into bit-reversed order
+ *
+ * This is the first step of an in-place radix-2 FFT.
+ *
+ * @param data  The interleaved complex data
+ * @param size  The number of complex elements (a power of two)
+ */
+static void bit_reverse(float* data, size_t size) {
+    size_t jj = 0;
+    for(size_t ii = 0; ii < size-1; ii++) {
+        if (ii < jj) {
+            std::swap(data[2*ii  ],data[2*jj  ]);
+            std::swap(data[2*ii+1],data[2*jj+1]);
+        }
+        size_t mask = size >> 1;
+        while (jj & mask) {
+            jj &= ~mask;
+            mask >>= 1;
+        }
+        jj |= mask;
+    }
+}
+
+/**
+ * Conjugates complex data in place
+ *
+ * @param data  The interleaved complex data
+ * @param size  The number of complex elements
+ */
+static void conjugate(float* data, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        data[2*ii+1] = -data[2*ii+1];
+    }
+}
+
 #pragma mark -
 #pragma mark Arithmetic Methods
 /**
@@ -572,3 +614,361 @@ size_t DSPMath::ease(float* data, float bound, float knee, size_t size) {
     }
     return size;
 }
+
+#pragma mark -
+#pragma mark Convolution Methods
+/**
+ * Returns the dot product of a strided input signal and a kernel
+ *
+ * The input signal is read every stride elements, so that this method
+ * can be applied to a single channel of an interleaved buffer. Hence the
+ * value returned is the sum of input[ii*stride]*kernel[ii] for all ii
+ * less than size.
+ *
+ * @param input     The input buffer
+ * @param stride    The stride of the input buffer
+ * @param kernel    The convolution kernel
+ * @param size      The number of elements in the kernel
+ *
+ * @return the dot product of a strided input signal and a kernel
+ */
+float DSPMath::dot(float* input, size_t stride, float* kernel, size_t size) {
+    float result = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    if (VECTORIZE) {
+        __m128 total = _mm_setzero_ps();
+        for(int ii = 0; ii < (int)size-3; ii += 4) {
+            __m128 value = stride == 1 ? _mm_loadu_ps(input+ii) : _mm_skipload_ps(input+ii*stride,stride);
+            total = _mm_add_ps(total,_mm_mul_ps(value,_mm_loadu_ps(kernel+ii)));
+        }
+        result = total[0]+total[1]+total[2]+total[3];
+        if (size % 4 != 0) {
+            Uint32 rem = size % 4;
+            for(int ii = (Uint32)(size-rem); ii < size; ii++) {
+                result += input[ii*stride]*kernel[ii];
+            }
+        }
+    } else {
+#elif defined (CU_MATH_VECTOR_NEON64)
+#if defined (__ANDROID__)
+    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
+        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
+#else
+    if (VECTORIZE) {
+#endif
+        float32x4_t total = vdupq_n_f32(0);
+        for(int ii = 0; ii < (int)size-3; ii += 4) {
+            float32x4_t value = stride == 1 ? vld1q_f32(input+ii) : vld1q_skip_f32(input+ii*stride,stride);
+            total = vmlaq_f32(total,value,vld1q_f32(kernel+ii));
+        }
+        result = vaddvq_f32(total);
+        if (size % 4 != 0) {
+            Uint32 rem = size % 4;
+            for(int ii = (Uint32)(size-rem); ii < size; ii++) {
+                result += input[ii*stride]*kernel[ii];
+            }
+        }
+    } else {
+#else
+    {
+#endif
+        for(int ii = 0; ii < size; ii++) {
+            result += input[ii*stride]*kernel[ii];
+        }
+    }
+    return result;
+}
+
+/**
+ * Redistributes an interleaved input signal with a channel matrix
+ *
+ * The matrix is an MxN matrix in row major order, where N is the number
+ * of input channels and M is the number of output channels. Each output
+ * frame is the product of this matrix and the input frame. The value size
+ * is specified in terms of frames, not samples.
+ *
+ * It is safe for output to be the same as the input buffer, provided that
+ * the buffer is large enough to hold the output data. This method only
+ * supports up to 8 input and output channels (7.1 surround). It does
+ * nothing and returns 0 if there are more channels than this.
+ *
+ * @param input     The input buffer
+ * @param inchans   The number of input channels
+ * @param matrix    The redistribution matrix
+ * @param output    The output buffer
+ * @param outchans  The number of output channels
+ * @param size      The number of frames to process
+ *
+ * @return the number of frames successfully processed
+ */
+size_t DSPMath::remix(const float* input, size_t inchans, const float* matrix,
+                      float* output, size_t outchans, size_t size) {
+    if (inchans > REMIX_CHANNELS || outchans > REMIX_CHANNELS) {
+        return 0;
+    }
+    
+    // Transpose the matrix so each input channel is a padded column
+    float columns[REMIX_CHANNELS*REMIX_CHANNELS];
+    std::memset(columns,0,sizeof(columns));
+    for(size_t ii = 0; ii < inchans; ii++) {
+        for(size_t jj = 0; jj < outchans; jj++) {
+            columns[ii*REMIX_CHANNELS+jj] = matrix[jj*inchans+ii];
+        }
+    }
+
+    // Upmixing in place must go backwards
+    bool reverse = outchans > inchans;
+    float frame[REMIX_CHANNELS];
+#if defined (CU_MATH_VECTOR_SSE)
+    if (VECTORIZE) {
+        for(size_t kk = 0; kk < size; kk++) {
+            size_t pos = reverse ? size-kk-1 : kk;
+            const float* src = input+pos*inchans;
+            __m128 lower = _mm_setzero_ps();
+            __m128 upper = _mm_setzero_ps();
+            for(size_t ii = 0; ii < inchans; ii++) {
+                __m128 value = _mm_set1_ps(src[ii]);
+                lower = _mm_add_ps(lower,_mm_mul_ps(value,_mm_loadu_ps(columns+ii*REMIX_CHANNELS)));
+                if (outchans > 4) {
+                    upper = _mm_add_ps(upper,_mm_mul_ps(value,_mm_loadu_ps(columns+ii*REMIX_CHANNELS+4)));
+                }
+            }
+            _mm_storeu_ps(frame,lower);
+            _mm_storeu_ps(frame+4,upper);
+            std::memcpy(output+pos*outchans,frame,outchans*sizeof(float));
+        }
+    } else {
+#elif defined (CU_MATH_VECTOR_NEON64)
+#if defined (__ANDROID__)
+    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
+        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
+#else
+    if (VECTORIZE) {
+#endif
+        for(size_t kk = 0; kk < size; kk++) {
+            size_t pos = reverse ? size-kk-1 : kk;
+            const float* src = input+pos*inchans;
+            float32x4_t lower = vdupq_n_f32(0);
+            float32x4_t upper = vdupq_n_f32(0);
+            for(size_t ii = 0; ii < inchans; ii++) {
+                lower = vmlaq_n_f32(lower,vld1q_f32(columns+ii*REMIX_CHANNELS),src[ii]);
+                if (outchans > 4) {
+                    upper = vmlaq_n_f32(upper,vld1q_f32(columns+ii*REMIX_CHANNELS+4),src[ii]);
+                }
+            }
+            vst1q_f32(frame,lower);
+            vst1q_f32(frame+4,upper);
+            std::memcpy(output+pos*outchans,frame,outchans*sizeof(float));
+        }
+    } else {
+#else
+    {
+#endif
+        for(size_t kk = 0; kk < size; kk++) {
+            size_t pos = reverse ? size-kk-1 : kk;
+            const float* src = input+pos*inchans;
+            for(size_t jj = 0; jj < outchans; jj++) {
+                float total = 0;
+                for(size_t ii = 0; ii < inchans; ii++) {
+                    total += columns[ii*REMIX_CHANNELS+jj]*src[ii];
+                }
+                frame[jj] = total;
+            }
+            std::memcpy(output+pos*outchans,frame,outchans*sizeof(float));
+        }
+    }
+    return size;
+}
+
+#pragma mark -
+#pragma mark Spectral Methods
+/**
+ * Computes the twiddle factors for an FFT of the given size
+ *
+ * The table is used by {@link #fft} and {@link #ifft}, and is laid out so
+ * that the factors of each butterfly stage are contiguous. The table
+ * should have room for 2*size elements. The value size is the number of
+ * complex elements in the transform, and must be a power of two.
+ *
+ * @param table     The buffer to store the twiddle factors
+ * @param size      The number of complex elements in the transform
+ *
+ * @return the number of complex elements supported by the table
+ */
+size_t DSPMath::fft_table(float* table, size_t size) {
+    if (size < 2 || (size & (size-1)) != 0) {
+        CUAssertLog(false, "FFT size %zu is not a power of two.", size);
+        return 0;
+    }
+    
+    // The stage with half-width h starts at complex position h-1
+    for(size_t half = 1; half < size; half <<= 1) {
+        float* stage = table+2*(half-1);
+        for(size_t jj = 0; jj < half; jj++) {
+            double angle = -M_PI*(double)jj/(double)half;
+            stage[2*jj  ] = (float)std::cos(angle);
+            stage[2*jj+1] = (float)std::sin(angle);
+        }
+    }
+    return size;
+}
+
+/**
+ * Performs an in-place forward FFT of complex data
+ *
+ * The data is interleaved as (real, imaginary) pairs, so the buffer must
+ * have 2*size elements. The value size is the number of complex elements,
+ * and must be a power of two. The table should be computed with
+ * {@link #fft_table} for this size. This method does nothing and returns
+ * 0 if size is not a power of two.
+ *
+ * @param data      The complex data to transform
+ * @param table     The twiddle factors for this size
+ * @param size      The number of complex elements
+ *
+ * @return the number of complex elements transformed
+ */
+size_t DSPMath::fft(float* data, const float* table, size_t size) {
+    if (size < 2 || (size & (size-1)) != 0) {
+        return 0;
+    }
+    bit_reverse(data,size);
+    
+    // The first stage has trivial twiddle factors
+    for(size_t ii = 0; ii < 2*size; ii += 4) {
+        float real = data[ii+2];
+        float imag = data[ii+3];
+        data[ii+2] = data[ii  ]-real;
+        data[ii+3] = data[ii+1]-imag;
+        data[ii  ] += real;
+        data[ii+1] += imag;
+    }
+    
+    const float* stage = table+2;
+    for(size_t half = 2; half < size; half <<= 1) {
+#if defined (CU_MATH_VECTOR_SSE)
+        if (VECTORIZE) {
+            for(size_t base = 0; base < size; base += 2*half) {
+                float* lower = data+2*base;
+                float* upper = lower+2*half;
+                for(size_t jj = 0; jj < 2*half; jj += 4) {
+                    __m128 value = _mm_loadu_ps(lower+jj);
+                    __m128 twist = _mm_cmul_ps(_mm_loadu_ps(upper+jj),_mm_loadu_ps(stage+jj));
+                    _mm_storeu_ps(lower+jj,_mm_add_ps(value,twist));
+                    _mm_storeu_ps(upper+jj,_mm_sub_ps(value,twist));
+                }
+            }
+        } else {
+#elif defined (CU_MATH_VECTOR_NEON64)
+#if defined (__ANDROID__)
+        if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
+            (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
+#else
+        if (VECTORIZE) {
+#endif
+            for(size_t base = 0; base < size; base += 2*half) {
+                float* lower = data+2*base;
+                float* upper = lower+2*half;
+                for(size_t jj = 0; jj < 2*half; jj += 4) {
+                    float32x4_t value = vld1q_f32(lower+jj);
+                    float32x4_t twist = vmulq_cplx_f32(vld1q_f32(upper+jj),vld1q_f32(stage+jj));
+                    vst1q_f32(lower+jj,vaddq_f32(value,twist));
+                    vst1q_f32(upper+jj,vsubq_f32(value,twist));
+                }
+            }
+        } else {
+#else
+        {
+#endif
+            for(size_t base = 0; base < size; base += 2*half) {
+                float* lower = data+2*base;
+                float* upper = lower+2*half;
+                for(size_t jj = 0; jj < 2*half; jj += 2) {
+                    float real = upper[jj]*stage[jj]-upper[jj+1]*stage[jj+1];
+                    float imag = upper[jj]*stage[jj+1]+upper[jj+1]*stage[jj];
+                    upper[jj  ] = lower[jj  ]-real;
+                    upper[jj+1] = lower[jj+1]-imag;
+                    lower[jj  ] += real;
+                    lower[jj+1] += imag;
+                }
+            }
+        }
+        stage += 2*half;
+    }
+    return size;
+}
+
+/**
+ * Performs an in-place inverse FFT of complex data
+ *
+ * The data is interleaved as (real, imaginary) pairs, so the buffer must
+ * have 2*size elements. The value size is the number of complex elements,
+ * and must be a power of two. The table should be computed with
+ * {@link #fft_table} for this size. This method does nothing and returns
+ * 0 if size is not a power of two.
+ *
+ * The result is not normalized. Following a forward transform with an
+ * inverse transform scales the original data by size.
+ *
+ * @param data      The complex data to transform
+ * @param table     The twiddle factors for this size
+ * @param size      The number of complex elements
+ *
+ * @return the number of complex elements transformed
+ */
+size_t DSPMath::ifft(float* data, const float* table, size_t size) {
+    if (size < 2 || (size & (size-1)) != 0) {
+        return 0;
+    }
+    
+    // The inverse is the conjugate of the forward transform of the conjugate
+    conjugate(data,size);
+    fft(data,table,size);
+    conjugate(data,size);
+    return size;
+}
+
+/**
+ * Multiplies two complex signals, adding the result to output
+ *
+ * The signals are interleaved as (real, imaginary) pairs, so each buffer
+ * must have 2*size elements. This is the inner loop of a frequency domain
+ * convolution.
+ *
+ * @param input1    The first input buffer
+ * @param input2    The second input buffer
+ * @param output    The output buffer
+ * @param size      The number of complex elements to multiply
+ *
+ * @return the number of complex elements successfully multiplied
+ */
+size_t DSPMath::complex_mult_add(const float* input1, const float* input2, float* output, size_t size) {
+    size_t start = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    if (VECTORIZE) {
+        for(; start+1 < size; start += 2) {
+            __m128 value = _mm_cmul_ps(_mm_loadu_ps(input1+2*start),_mm_loadu_ps(input2+2*start));
+            _mm_storeu_ps(output+2*start, _mm_add_ps(_mm_loadu_ps(output+2*start),value));
+        }
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+#if defined (__ANDROID__)
+    if (VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
+        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
+#else
+    if (VECTORIZE) {
+#endif
+        for(; start+1 < size; start += 2) {
+            float32x4_t value = vmulq_cplx_f32(vld1q_f32(input1+2*start),vld1q_f32(input2+2*start));
+            vst1q_f32(output+2*start, vaddq_f32(vld1q_f32(output+2*start),value));
+        }
+    }
+#endif
+    for(size_t ii = start; ii < size; ii++) {
+        const float* a = input1+2*ii;
+        const float* b = input2+2*ii;
+        output[2*ii  ] += a[0]*b[0]-a[1]*b[1];
+        output[2*ii+1] += a[0]*b[1]+a[1]*b[0];
+    }
+    return size;
+}
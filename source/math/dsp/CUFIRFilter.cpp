@@ -56,6 +56,9 @@ using namespace cugl::dsp;
 /** Whether to use a vectorization algorithm */
 bool FIRFilter::VECTORIZE = true;
 
+/** The number of coefficients at which to use a partitioned convolution */
+const size_t FIRFilter::CONVOLVE_TAPS = 256;
+
 #pragma mark Constructors
 
 /**
@@ -110,6 +113,9 @@ FIRFilter::FIRFilter(const FIRFilter& copy) {
     _channels = copy._channels;
     _bval = copy._bval;
     _inns = copy._inns;
+    if (copy._convolver) {
+        _convolver = std::unique_ptr<Convolver>(new Convolver(*copy._convolver));
+    }
 }
 
 /**
@@ -122,6 +128,7 @@ FIRFilter::FIRFilter(FIRFilter&& filter) {
     _channels = filter._channels;
     _bval = std::move(filter._bval);
     _inns = std::move(filter._inns);
+    _convolver = std::move(filter._convolver);
 }
 
 /**
@@ -136,9 +143,36 @@ FIRFilter::~FIRFilter() {}
  */
 void FIRFilter::reset() {
     _inns.reset(_bval.size()*_channels,16);
+    if (_convolver) {
+        _convolver->setChannels(_channels);
+    }
     clear();
 }
 
+/**
+ * Sets the partitioned convolution for the given coefficients
+ *
+ * The convolution is only used if there are at least {@link #CONVOLVE_TAPS}
+ * coefficients. Otherwise, it is set to nullptr.
+ *
+ * @param bvals The upper coefficients
+ * @param a0    The normalization factor
+ */
+void FIRFilter::setConvolver(const std::vector<float> &bvals, float a0) {
+    if (bvals.size() < CONVOLVE_TAPS) {
+        _convolver = nullptr;
+        return;
+    }
+    
+    std::vector<float> kernel(bvals);
+    if (a0 != 1.0f) {
+        for(auto it = kernel.begin(); it != kernel.end(); ++it) {
+            *it /= a0;
+        }
+    }
+    _convolver = std::unique_ptr<Convolver>(new Convolver(_channels,kernel));
+}
+
 #pragma mark -
 #pragma mark IIR Signature
 /**
@@ -180,6 +214,7 @@ void FIRFilter::setCoeff(const std::vector<float> &bvals, const std::vector<floa
     for(int ii = 0; ii < bsize; ii++) {
         _bval[bsize-ii-1] = bvals[ii+1]/a0;
     }
+    setConvolver(bvals,a0);
     reset();
 }
 
@@ -245,6 +280,7 @@ void FIRFilter::setBCoeff(const std::vector<float> &bvals) {
     for(size_t ii = 0; ii < bsize; ii++) {
         _bval[ii] = bvals[ii+1];
     }
+    setConvolver(bvals,1.0f);
     reset();
 }
 
@@ -272,6 +308,11 @@ void FIRFilter::setBCoeff(const std::vector<float> &bvals) {
  * @param size      The input size in frames
  */
 void FIRFilter::step(float gain, float* input, float* output) {
+    if (_convolver) {
+        _convolver->step(gain,input,output);
+        return;
+    }
+    
     size_t bsize = _bval.size();
 
     for(size_t ckk = 0; ckk < _channels; ckk++) {
@@ -314,6 +355,11 @@ void FIRFilter::step(float gain, float* input, float* output) {
  * @param size      The input size in frames
  */
 void FIRFilter::calculate(float gain,float* input, float* output, size_t size) {
+    if (_convolver) {
+        _convolver->calculate(gain,input,output,size);
+        return;
+    }
+    
     size_t valid = VECTORIZE ? size-(size % 4) : size;
     switch (_channels) {
         case 1:
@@ -351,6 +397,9 @@ void FIRFilter::clear() {
     for(size_t ii = 0; ii < _inns.size(); ii++) {
         _inns[ii] = 0.0f;
     }
+    if (_convolver) {
+        _convolver->clear();
+    }
 }
 
 /**
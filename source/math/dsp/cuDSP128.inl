@@ -61,6 +61,45 @@ static inline __m128 _mm_skipload_ps(float* src, size_t stride) {
     return result;
 }
 
+/**
+ * Returns the product of two pairs of interleaved complex numbers
+ *
+ * Each vector is two complex numbers, stored as (real, imag, real, imag).
+ *
+ * @param a         The first complex pair
+ * @param b         The second complex pair
+ *
+ * @return the product of two pairs of interleaved complex numbers
+ */
+static inline __m128 _mm_cmul_ps(__m128 a, __m128 b) {
+    const __m128 sign = _mm_set_ps(1.0f,-1.0f,1.0f,-1.0f);
+    __m128 real = _mm_shuffle_ps(b,b,_MM_SHUFFLE(2,2,0,0));
+    __m128 imag = _mm_shuffle_ps(b,b,_MM_SHUFFLE(3,3,1,1));
+    __m128 swap = _mm_shuffle_ps(a,a,_MM_SHUFFLE(2,3,0,1));
+    return _mm_add_ps(_mm_mul_ps(a,real),_mm_mul_ps(_mm_mul_ps(swap,imag),sign));
+}
+
+/**
+ * Stores four table rows as four column vectors
+ *
+ * The table is a packed array of rows of four floats. The lanes of index
+ * select the rows to load. Afterwards, result[k] holds column k of the four
+ * selected rows. This is useful for vectorized table lookups.
+ *
+ * @param table     The table of rows
+ * @param index     The rows to load
+ * @param result    The array to store the four columns
+ */
+static inline void _mm_gather4_ps(const float* table, __m128i index, __m128* result) {
+    alignas(16) int rows[4];
+    _mm_store_si128((__m128i*)rows,index);
+    result[0] = _mm_loadu_ps(table+4*rows[0]);
+    result[1] = _mm_loadu_ps(table+4*rows[1]);
+    result[2] = _mm_loadu_ps(table+4*rows[2]);
+    result[3] = _mm_loadu_ps(table+4*rows[3]);
+    _MM_TRANSPOSE4_PS(result[0],result[1],result[2],result[3]);
+}
+
 #elif defined (CU_MATH_VECTOR_NEON64)
 /**
  * Stores a float32x4_t vector into a strided array
@@ -114,4 +153,46 @@ static inline float32x2_t vld1_skip_f32(float* src, size_t stride) {
     return result;
 }
 
+/**
+ * Returns the product of two pairs of interleaved complex numbers
+ *
+ * Each vector is two complex numbers, stored as (real, imag, real, imag).
+ *
+ * @param a     The first complex pair
+ * @param b     The second complex pair
+ *
+ * @return the product of two pairs of interleaved complex numbers
+ */
+static inline float32x4_t vmulq_cplx_f32(float32x4_t a, float32x4_t b) {
+    const float32x4_t sign = { -1.0f, 1.0f, -1.0f, 1.0f };
+    float32x4_t real = vtrn1q_f32(b,b);
+    float32x4_t imag = vtrn2q_f32(b,b);
+    float32x4_t swap = vrev64q_f32(a);
+    return vmlaq_f32(vmulq_f32(a,real),vmulq_f32(swap,imag),sign);
+}
+
+/**
+ * Stores four table rows as four column vectors
+ *
+ * The table is a packed array of rows of four floats. The lanes of index
+ * select the rows to load. Afterwards, result[k] holds column k of the four
+ * selected rows. This is useful for vectorized table lookups.
+ *
+ * @param table     The table of rows
+ * @param index     The rows to load
+ * @param result    The array to store the four columns
+ */
+static inline void vld1q_gather4_f32(const float* table, int32x4_t index, float32x4_t* result) {
+    float32x4_t r0 = vld1q_f32(table+4*vgetq_lane_s32(index,0));
+    float32x4_t r1 = vld1q_f32(table+4*vgetq_lane_s32(index,1));
+    float32x4_t r2 = vld1q_f32(table+4*vgetq_lane_s32(index,2));
+    float32x4_t r3 = vld1q_f32(table+4*vgetq_lane_s32(index,3));
+    float32x4x2_t t01 = vtrnq_f32(r0,r1);
+    float32x4x2_t t23 = vtrnq_f32(r2,r3);
+    result[0] = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    result[1] = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    result[2] = vcombine_f32(vget_high_f32(t01.val[0]),vget_high_f32(t23.val[0]));
+    result[3] = vcombine_f32(vget_high_f32(t01.val[1]),vget_high_f32(t23.val[1]));
+}
+
 #endif
@@ -35,7 +35,6 @@
 //  Version: 1/22/21
 //
 #include <cugl/math/polygon/CUComplexExtruder.h>
-#include <cugl/math/polygon/CUDelaunayTriangulator.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/math/CUPoly2.h>
 #include <cugl/math/CUPath2.h>
@@ -56,6 +55,7 @@ using namespace cugl;
 ComplexExtruder::ComplexExtruder() :
 _calculated(false),
 _resolution(RESOLUTION),
+_scaled(false),
 _mitrelimit(MITRELIMIT) {
 }
 
@@ -71,6 +71,7 @@ _mitrelimit(MITRELIMIT) {
 ComplexExtruder::ComplexExtruder(const std::vector<Vec2>& points, bool closed) :
 _calculated(false),
 _resolution(RESOLUTION),
+_scaled(false),
 _mitrelimit(MITRELIMIT) {
     set(points,closed);
 }
@@ -86,6 +87,7 @@ _mitrelimit(MITRELIMIT) {
 ComplexExtruder::ComplexExtruder(const Path2& path) :
 _calculated(false),
 _resolution(RESOLUTION),
+_scaled(false),
 _mitrelimit(MITRELIMIT) {
     set(path);
 }
@@ -106,6 +108,7 @@ _mitrelimit(MITRELIMIT) {
  */
 void ComplexExtruder::set(const std::vector<Vec2>& points, bool closed) {
     reset();
+    _scaled = false;
     _input.vertices = points;
     _input.closed = closed;
 }
@@ -126,6 +129,8 @@ void ComplexExtruder::set(const std::vector<Vec2>& points, bool closed) {
  */
 void ComplexExtruder::set(const Vec2* points, size_t size, bool closed) {
     reset();
+    _scaled = false;
+    _input.vertices.clear();
     _input.vertices.insert(_input.vertices.begin(), points, points+size);
     _input.closed = closed;
 }
@@ -143,6 +148,7 @@ void ComplexExtruder::set(const Vec2* points, size_t size, bool closed) {
  */
 void ComplexExtruder::set(const Path2& path) {
     reset();
+    _scaled = false;
     _input = path;
 }
 
@@ -258,6 +264,7 @@ void ComplexExtruder::reset() {
 void ComplexExtruder::clear() {
     reset();
     _input.clear();
+    _scaled = false;
 }
 
 /**
@@ -283,20 +290,25 @@ void ComplexExtruder::calculate(float stroke) {
         return;
     }
     
-    ClipperLib::Path inverts;
-    ClipperLib::PolyTree solution;
-    for(auto it = _input.vertices.begin(); it != _input.vertices.end(); ++it) {
-        inverts << ClipperLib::IntPoint((ClipperLib::cInt)(it->x*_resolution),
-                                        (ClipperLib::cInt)(it->y*_resolution));
+    // The scaled input is only recomputed if the path or resolution changes
+    if (!_scaled) {
+        _inverts.clear();
+        _inverts.reserve(_input.vertices.size());
+        for(auto it = _input.vertices.begin(); it != _input.vertices.end(); ++it) {
+            _inverts.push_back(ClipperLib::IntPoint((ClipperLib::cInt)(it->x*_resolution),
+                                                    (ClipperLib::cInt)(it->y*_resolution)));
+        }
+        _scaled = true;
     }
     
-    ClipperLib::ClipperOffset worker;
-    worker.MiterLimit = _mitrelimit;
-    worker.AddPath( inverts, _joint, _input.closed ?  ClipperLib::etClosedLine : _endcap );
-    worker.Execute(solution, stroke*_resolution);
-    for(auto it = solution.Childs.begin(); it != solution.Childs.end(); it++) {
+    _worker.Clear();
+    _worker.MiterLimit = _mitrelimit;
+    _worker.AddPath( _inverts, _joint, _input.closed ?  ClipperLib::etClosedLine : _endcap );
+    _worker.Execute(_solution, stroke*_resolution);
+    for(auto it = _solution.Childs.begin(); it != _solution.Childs.end(); it++) {
         processNode(*it);
     }
+    _solution.Clear();
 
     _calculated = true;
 }
@@ -311,26 +323,32 @@ void ComplexExtruder::calculate(float stroke) {
  * @param node  The PolyNode to accumulate
  */
 void ComplexExtruder::processNode(const ClipperLib::PolyNode* node) {
-    Path2 path;
+    _bounds.emplace_back();
+    Path2& path = _bounds.back();
+    double scale = 1.0/_resolution;
+    path.vertices.reserve(node->Contour.size());
     for(auto it = node->Contour.begin(); it != node->Contour.end(); ++it) {
-        path.vertices.push_back(Vec2((float)(it->X/(double)_resolution),(float)(it->Y/(double)_resolution)));
+        path.vertices.push_back(Vec2((float)(it->X*scale),(float)(it->Y*scale)));
     }
     path.closed = true;
-    _bounds.push_back(path);
 
-    DelaunayTriangulator triang(path);
+    _triangulator.clear();
+    _triangulator.set(path);
     for(auto it = node->Childs.begin(); it != node->Childs.end(); ++it) {
-        Path2 hole;
+        _bounds.emplace_back();
+        Path2& hole = _bounds.back();
+        hole.vertices.reserve((*it)->Contour.size());
         for(auto jt = (*it)->Contour.begin(); jt != (*it)->Contour.end(); ++jt) {
-            hole.vertices.push_back(Vec2((float)(jt->X/(double)_resolution),(float)(jt->Y/(double)_resolution)));
+            hole.vertices.push_back(Vec2((float)(jt->X*scale),(float)(jt->Y*scale)));
         }
         hole.closed = true;
-        _bounds.push_back(hole);
-        triang.addHole(hole);
+        _triangulator.addHole(hole);
     }
 
-    triang.calculate();
-    triang.getPolygon(&_output);
+    _triangulator.calculate();
+    _triangulator.getPolygon(&_output);
+    // Release the poly2tri state, but keep the buffers
+    _triangulator.clear();
 
     // Just in case.  But should never be called.
     for(auto it = node->Childs.begin(); it != node->Childs.end(); ++it) {
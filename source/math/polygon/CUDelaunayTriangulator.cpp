@@ -39,10 +39,18 @@
 #include <cugl/math/CUPoly2.h>
 #include <cugl/math/CUPath2.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/base/CUApplication.h>
+#include <condition_variable>
+#include <mutex>
 #include <deque>
 
 using namespace cugl;
 
+/** The number of Voronoi cells computed by a single parallel task */
+#define DUAL_CHUNK      64
+/** The maximum number of parallel tasks for a Voronoi diagram */
+#define DUAL_TASKS      8
+
 /**
  * Returns the point of intersection of a ray with the bounding box.
  *
@@ -117,7 +125,9 @@ static Vec2 get_interior(const Vec2& start, const Vec2& end, const Rect& box) {
  */
 DelaunayTriangulator::DelaunayTriangulator() :
 _triangulator(nullptr),
-_calculated(false) {
+_calculated(false),
+_dualated(false),
+_pending(false) {
 }
 
 /**
@@ -132,7 +142,9 @@ _calculated(false) {
  */
 DelaunayTriangulator::DelaunayTriangulator(const std::vector<Vec2>& points) :
 _triangulator(nullptr),
-_calculated(false) {
+_calculated(false),
+_dualated(false),
+_pending(false) {
     set(points);
 }
 
@@ -149,7 +161,9 @@ _calculated(false) {
  */
 DelaunayTriangulator::DelaunayTriangulator(const Path2& path) :
 _triangulator(nullptr),
-_calculated(false) {
+_calculated(false),
+_dualated(false),
+_pending(false) {
     set(path);
 }
 
@@ -271,12 +285,13 @@ void DelaunayTriangulator::set(const Path2& path) {
  */
 void DelaunayTriangulator::addHole(const std::vector<Vec2>& points) {
     CUAssertLog(Path2::orientation(points) == 1, "Hole orientiation is not CW");
-    std::vector<p2t::Point> hole;
+    _holes.emplace_back();
+    std::vector<p2t::Point>& hole = _holes.back();
     hole.reserve(points.size());
     for(auto it = points.begin(); it != points.end(); ++it) {
         hole.push_back(p2t::Point(it->x, it->y));
-    }
-    _holes.push_back(hole);
+    }    _calculated = false;
+    _dualated = false;
 }
 
 /**
@@ -301,12 +316,13 @@ void DelaunayTriangulator::addHole(const std::vector<Vec2>& points) {
  */
 void DelaunayTriangulator::addHole(const Vec2* points, size_t size) {
     CUAssertLog(Path2::orientation(points, size) == 1, "Hole orientiation is not CW");
-    std::vector<p2t::Point> hole;
+    _holes.emplace_back();
+    std::vector<p2t::Point>& hole = _holes.back();
     hole.reserve(size);
     for(size_t ii = 0; ii < size; ii++) {
         hole.push_back(p2t::Point(points[ii].x, points[ii].y));
-    }
-    _holes.push_back(hole);
+    }    _calculated = false;
+    _dualated = false;
 }
 
 /**
@@ -330,12 +346,13 @@ void DelaunayTriangulator::addHole(const Vec2* points, size_t size) {
  */
 void DelaunayTriangulator::addHole(const Path2& path) {
     CUAssertLog(path.orientation() == 1, "Hole orientiation is not CW");
-    std::vector<p2t::Point> hole;
+    _holes.emplace_back();
+    std::vector<p2t::Point>& hole = _holes.back();
     hole.reserve(path.size());
     for(auto it = path.vertices.begin(); it != path.vertices.end(); ++it) {
         hole.push_back(p2t::Point(it->x, it->y));
-    }
-    _holes.push_back(hole);
+    }    _calculated = false;
+    _dualated = false;
 }
 
 /**
@@ -355,6 +372,8 @@ void DelaunayTriangulator::addHole(const Path2& path) {
  */
 void DelaunayTriangulator::addSteiner(Vec2 point) {
     _stein.push_back(p2t::Point(point.x, point.y));
+    _calculated = false;
+    _dualated = false;
 }
 
 #pragma mark -
@@ -400,10 +419,18 @@ void DelaunayTriangulator::clear() {
  * Voronoi dual.
  */
 void DelaunayTriangulator::calculate() {
+    if (_calculated) {
+        return;
+    }
     reset();
 
     // Set up the triangulator
-    _vertices.reserve(_hull.size());
+    size_t total = _hull.size()+_stein.size();
+    for(auto it = _holes.begin(); it != _holes.end(); ++it) {
+        total += it->size();
+    }
+    _vertices.reserve(total);
+    _idxmap.reserve(total);
     for(size_t ii = 0; ii < _hull.size(); ii++) {
         p2t::Point* p = &(_hull[ii]);
         _idxmap.emplace(p,_vertices.size());
@@ -411,23 +438,17 @@ void DelaunayTriangulator::calculate() {
     }
     _triangulator = new p2t::CDT(_vertices);
     
-    std::vector<p2t::Point*> hole;
     for(auto it = _holes.begin(); it != _holes.end(); ++it) {
-        hole.clear();
-        size_t next = _vertices.size()+it->size();
-        hole.reserve(it->size());
-        _vertices.reserve(next);
+        _scratch.clear();
         for(size_t ii = 0; ii < it->size(); ii++) {
             p2t::Point* p = &(it->at(ii));
-            hole.push_back(p);
+            _scratch.push_back(p);
             _idxmap.emplace(p,_vertices.size());
             _vertices.push_back(p);
         }
-        _triangulator->AddHole(hole);
+        _triangulator->AddHole(_scratch);
     }
     
-    size_t next = _vertices.size()+_stein.size();
-    _vertices.reserve(next);
     for(size_t ii = 0; ii < _stein.size(); ii++) {
         p2t::Point* p = &(_stein[ii]);
         _idxmap.emplace(p,_vertices.size());
@@ -477,6 +498,9 @@ void DelaunayTriangulator::calculateDual() {
     if (!_calculated) {
         calculate();
     }
+    if (_dualated) {
+        return;
+    }
     _voronoi.clear();
     
     std::list<p2t::Triangle*> map = _triangulator->GetMap();
@@ -487,29 +511,8 @@ void DelaunayTriangulator::calculateDual() {
             if (index != _idxmap.end()) {
                 auto search = _voronoi.find(index->second);
                 if (search == _voronoi.end()) {
-                    std::deque<Vec2> deque = calculateCell(p, *it);
                     _voronoi.emplace(index->second,Poly2());
-                    Poly2* poly = &_voronoi[index->second];
-                    
-                    // Add vertices
-                    for(auto it = deque.begin(); it != deque.end(); ++it) {
-                        poly->vertices.push_back(*it);
-                    }
-                    size_t size = poly->vertices.size();
-                    poly->vertices.push_back(Vec2(p->x,p->y));
-                    
-                    // Add indices
-                    if (size > 2) {
-                        for(int ii = 0; ii < size-1; ii++) {
-                            // This is CCW
-                            poly->indices.push_back(ii);
-                            poly->indices.push_back(ii+1);
-                            poly->indices.push_back((Uint32)size);
-                        }
-                    }
-                    poly->indices.push_back((Uint32)size-1);
-                    poly->indices.push_back(0);
-                    poly->indices.push_back((Uint32)size);
+                    buildCell(p, *it, &_voronoi[index->second]);
                 }
             }
         }
@@ -517,6 +520,136 @@ void DelaunayTriangulator::calculateDual() {
     _dualated = true;
 }
 
+/**
+ * Calculates the Voronoi diagram, using the given thread pool.
+ *
+ * This method is the same as {@link #calculateDual()}, except that the
+ * Voronoi cells are computed in parallel. The triangulation itself is
+ * still computed on the calling thread, as the poly2tri sweep cannot be
+ * divided. This method blocks until all of the cells are computed, and
+ * the calling thread shares in the work. Hence it is safe to use a pool
+ * that is busy (or even stopped), though it will not be any faster.
+ *
+ * This method should not be called from a task of the given pool.
+ *
+ * @param pool  The thread pool to compute the cells
+ */
+void DelaunayTriangulator::calculateDual(const std::shared_ptr<ThreadPool>& pool) {
+    if (pool == nullptr) {
+        calculateDual();
+        return;
+    }
+    if (!_calculated) {
+        calculate();
+    }
+    if (_dualated) {
+        return;
+    }
+    _voronoi.clear();
+
+    // The work shared between the tasks. Tasks that start late (after the
+    // cells are done) only touch this state, so it must outlive this call.
+    struct Work {
+        std::vector<std::pair<p2t::Point*,p2t::Triangle*>> seeds;
+        std::vector<Uint32> keys;
+        std::vector<Poly2>  cells;
+        std::atomic<size_t> next;
+        size_t done;
+        size_t chunks;
+        std::mutex mutex;
+        std::condition_variable cond;
+    };
+    auto work = std::make_shared<Work>();
+    work->next = 0;
+    work->done = 0;
+
+    // Pick a seed triangle for each point (serially)
+    std::list<p2t::Triangle*> map = _triangulator->GetMap();
+    std::vector<bool> seen(_vertices.size(),false);
+    for(auto it = map.begin(); it != map.end(); ++it) {
+        for(int ii = 0; ii < 3; ii++) {
+            p2t::Point* p = (*it)->GetPoint(ii);
+            auto index  = _idxmap.find(p);
+            if (index != _idxmap.end() && !seen[index->second]) {
+                seen[index->second] = true;
+                work->seeds.push_back(std::make_pair(p,*it));
+                work->keys.push_back(index->second);
+            }
+        }
+    }
+    work->cells.resize(work->seeds.size());
+    work->chunks = (work->seeds.size()+DUAL_CHUNK-1)/DUAL_CHUNK;
+
+    // Each participant claims chunks until there are none left
+    DelaunayTriangulator* self = this;
+    auto task = [self,work]() {
+        size_t chunk;
+        while ((chunk = work->next++) < work->chunks) {
+            size_t end = std::min((chunk+1)*DUAL_CHUNK,work->seeds.size());
+            for(size_t ii = chunk*DUAL_CHUNK; ii < end; ii++) {
+                self->buildCell(work->seeds[ii].first, work->seeds[ii].second, &(work->cells[ii]));
+            }
+            std::unique_lock<std::mutex> lock(work->mutex);
+            if (++work->done == work->chunks) {
+                work->cond.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(work->chunks > 0 ? work->chunks-1 : 0, (size_t)DUAL_TASKS);
+    for(size_t ii = 0; ii < helpers; ii++) {
+        pool->addTask(task);
+    }
+    task();
+    {
+        std::unique_lock<std::mutex> lock(work->mutex);
+        work->cond.wait(lock, [&]() { return work->done == work->chunks; });
+    }
+
+    _voronoi.reserve(work->cells.size());
+    for(size_t ii = 0; ii < work->cells.size(); ii++) {
+        _voronoi.emplace(work->keys[ii],std::move(work->cells[ii]));
+    }
+    _dualated = true;
+}
+
+/**
+ * Performs the calculation in the background, using the given thread pool.
+ *
+ * This method returns immediately. The triangulation (and the Voronoi
+ * diagram, if dual is true) is computed on a thread of the pool. When
+ * it is done, the callback is executed on the main thread at the start
+ * of the next animation frame, using {@link Application#schedule}.
+ *
+ * The triangulator must not be modified, read, or deleted until the
+ * callback is executed. Use {@link #isPending} to check whether a
+ * background calculation is still in progress.
+ *
+ * @param pool      The thread pool to perform the calculation
+ * @param dual      Whether to calculate the Voronoi diagram as well
+ * @param callback  The callback to execute when the calculation is done
+ */
+void DelaunayTriangulator::calculateAsync(const std::shared_ptr<ThreadPool>& pool, bool dual,
+                                          const std::function<void()>& callback) {
+    CUAssertLog(pool, "The thread pool is null");
+    CUAssertLog(!_pending, "A background calculation is already in progress");
+    _pending = true;
+    pool->addTask([=](void) {
+        if (dual) {
+            this->calculateDual();
+        } else {
+            this->calculate();
+        }
+        Application::get()->schedule([=](void) {
+            this->_pending = false;
+            if (callback) {
+                callback();
+            }
+            return false;
+        });
+    });
+}
+
 #pragma mark -
 #pragma mark Materialization
 /**
@@ -887,6 +1020,42 @@ const std::deque<Vec2> DelaunayTriangulator::calculateCell(p2t::Point* p, p2t::T
     return result;
 }
 
+/**
+ * Stores the Voronoi region for the given point in the given buffer.
+ *
+ * The region is a triangle fan about the point p, with the boundary
+ * computed by {@link #calculateCell}. This method only reads the
+ * triangulation, and so it is safe to call it from multiple threads
+ * at once (with different buffers).
+ *
+ * @param p         The point defining the Voronoi region
+ * @param tri       A poly2tri triangle containing p as a vertex.
+ * @param buffer    The buffer to store the region
+ */
+void DelaunayTriangulator::buildCell(p2t::Point* p, p2t::Triangle* tri, Poly2* buffer) {
+    std::deque<Vec2> deque = calculateCell(p, tri);
+    
+    // Add vertices
+    for(auto it = deque.begin(); it != deque.end(); ++it) {
+        buffer->vertices.push_back(*it);
+    }
+    size_t size = buffer->vertices.size();
+    buffer->vertices.push_back(Vec2(p->x,p->y));
+    
+    // Add indices
+    if (size > 2) {
+        for(int ii = 0; ii < size-1; ii++) {
+            // This is CCW
+            buffer->indices.push_back(ii);
+            buffer->indices.push_back(ii+1);
+            buffer->indices.push_back((Uint32)size);
+        }
+    }
+    buffer->indices.push_back((Uint32)size-1);
+    buffer->indices.push_back(0);
+    buffer->indices.push_back((Uint32)size);
+}
+
 /**
  * Returns the circumcenter for the given triangle tri
  *
@@ -656,10 +656,9 @@ void EarclipTriangulator::removeHoles() {
         return;
     }
     
-    size_t* holesleft;
     size_t  holessize = _holes.size()/2;
-    holesleft = (size_t*)malloc(2*holessize*sizeof(size_t));
-    std::memcpy(holesleft, _holes.data(), 2*holessize*sizeof(size_t));
+    _holesleft.assign(_holes.begin(),_holes.end());
+    size_t* holesleft = _holesleft.data();
     
     while (holessize > 0) {
         // Find the hole point with the largest x.
@@ -721,7 +720,6 @@ void EarclipTriangulator::removeHoles() {
         }
         
         if (bestpoint == nullptr) {
-            free(holesleft);
             return;
         }
         
@@ -747,7 +745,6 @@ void EarclipTriangulator::removeHoles() {
         holesleft[2*holepart+1] = holesleft[2*holessize-1];
         holessize--;
     }
-    free(holesleft);
 }
 
 /**
@@ -0,0 +1,886 @@
+//
+//  CUMonotoneTriangulator.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module is a factory for a monotone triangulator. This triangulator
+//  first partitions the polygon into y-monotone pieces with a sweep line, and
+//  then triangulates each piece in linear time. This makes it O(n log n),
+//  which is much faster than earclipping on large polygons, like the outlines
+//  of level geometry. However, it produces thinner triangles, so the
+//  earclipping triangulator is still preferable for small polygons.
+//
+//  Because math objects are intended to be on the stack, we do not provide
+//  any shared pointer support in this class.
+//
+//  This implementation is largely inspired by the polypartition library
+//  from Ivan Fratric, which is in turn based on the presentation in
+//  "Computational Geometry: Algorithms and Applications" by de Berg et al.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/math/polygon/CUMonotoneTriangulator.h>
+#include <cugl/math/polygon/CUEarclipTriangulator.h>
+#include <cugl/math/CUPoly2.h>
+#include <cugl/math/CUPath2.h>
+#include <cugl/util/CUDebug.h>
+#include <algorithm>
+#include <set>
+
+using namespace cugl;
+
+/** The vertex types of the monotone partition sweep */
+#define TYPE_REGULAR    0
+#define TYPE_START      1
+#define TYPE_END        2
+#define TYPE_SPLIT      3
+#define TYPE_MERGE      4
+
+#pragma mark Support Classes
+/**
+ * An internal class that manages vertex data
+ *
+ * The primary reason for this class is to implement a doubly linked list that
+ * we split with diagonals. When a diagonal is added, both of its endpoints are
+ * duplicated, so that each side of the diagonal is a separate list.
+ */
+class MonotoneTriangulator::Vertex {
+public:
+    /** The index position of this vertex in the input set */
+    Uint32 index;
+    /** The vertex coordinate */
+    Vec2 coord;
+    /** The next vertex along this path */
+    Uint32 next;
+    /** The previous vertex along this path */
+    Uint32 prev;
+    /** The vertex type in the sweep */
+    Uint32 type;
+    /** The helper of the edge starting at this vertex */
+    Uint32 helper;
+    /** Whether this vertex belongs to an extracted monotone piece */
+    bool used;
+
+    /**
+     * Initializes a default vertex
+     */
+    Vertex() : index(0), next(0), prev(0), type(TYPE_REGULAR), helper(0), used(false) {}
+
+    /**
+     * Returns true if the angle defined by the three points is convex.
+     *
+     * The defined angle is centered at p2, with p1 going into p2 and p2
+     * going out to p3.
+     *
+     * @param p1    The start of the angle
+     * @param p2    The center of the angle
+     * @param p3    The end of the angle
+     *
+     * @return true if the angle defined by the three points is convex.
+     */
+    static bool convex(const Vec2& p1, const Vec2& p2, const Vec2& p3) {
+        float tmp = (p3.y - p1.y) * (p2.x - p1.x) - (p3.x - p1.x) * (p2.y - p1.y);
+        return tmp > 0;
+    }
+
+    /**
+     * Returns true if p1 is below p2 in the sweep order
+     *
+     * The sweep line moves from the top (maximum y) down. Points with the
+     * same y-coordinate are ordered by x-coordinate.
+     *
+     * @param p1    The first point
+     * @param p2    The second point
+     *
+     * @return true if p1 is below p2 in the sweep order
+     */
+    static bool below(const Vec2& p1, const Vec2& p2) {
+        return p1.y < p2.y || (p1.y == p2.y && p1.x < p2.x);
+    }
+};
+
+/**
+ * An edge in the sweep line status
+ *
+ * The status only holds edges with the polygon interior to their right.
+ * They are ordered from left to right along the sweep line. Edges in the
+ * status never cross, so this order does not change as the line moves.
+ */
+class MonotoneTriangulator::Edge {
+public:
+    /** The start of the edge */
+    Vec2 p1;
+    /** The end of the edge */
+    Vec2 p2;
+    /** The vertex that starts this edge (updated when it is duplicated) */
+    mutable Uint32 index;
+
+    /**
+     * Returns true if this edge is to the left of the other one
+     *
+     * @param other The edge to compare
+     *
+     * @return true if this edge is to the left of the other one
+     */
+    bool operator<(const Edge& other) const {
+        if (other.p1.y == other.p2.y) {
+            if (p1.y == p2.y) {
+                return p1.y < other.p1.y;
+            }
+            return Vertex::convex(p1,p2,other.p1);
+        } else if (p1.y == p2.y) {
+            return !Vertex::convex(other.p1,other.p2,p1);
+        } else if (p1.y < other.p1.y) {
+            return !Vertex::convex(other.p1,other.p2,p1);
+        }
+        return Vertex::convex(p1,p2,other.p1);
+    }
+};
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates a triangulator with no vertex data.
+ */
+MonotoneTriangulator::MonotoneTriangulator() :
+_exterior(0),
+_calculated(false) {
+}
+
+/**
+ * Creates a triangulator with the given vertex data.
+ *
+ * The vertices are assumed to be the outer hull, and do not
+ * include any holes (which may be specified later). The vertex
+ * data is copied. The triangulator does not retain any references
+ * to the original data.
+ *
+ * @param points    The vertices to triangulate
+ */
+MonotoneTriangulator::MonotoneTriangulator(const std::vector<Vec2>& points) :
+_exterior(0),
+_calculated(false) {
+    set(points);
+}
+
+/**
+ * Creates a triangulator with the given vertex data.
+ *
+ * The path is assumed to be the outer hull, and does not include any
+ * holes (which may be specified later). The vertex data is copied.
+ * The triangulator does not retain any references to the original
+ * data.
+ *
+ * @param path      The vertices to triangulate
+ */
+MonotoneTriangulator::MonotoneTriangulator(const Path2& path) :
+_exterior(0),
+_calculated(false) {
+    set(path);
+}
+
+/**
+ * Deletes this triangulator, releasing all resources.
+ */
+MonotoneTriangulator::~MonotoneTriangulator() {
+    clear();
+}
+
+#pragma mark -
+#pragma mark Initialization
+/**
+ * Sets the exterior vertex data for this triangulator.
+ *
+ * The vertices are assumed to be the outer hull, and do not
+ * include any holes (which may be specified later). The vertices
+ * should define the hull in a counter-clockwise traversal.
+ *
+ * The vertex data is copied. The triangulator does not retain any
+ * references to the original data. Hull points are added first.
+ * That is, when the triangulation is computed, the lowest indices
+ * all refer to these points, in the order that they were provided.
+ *
+ * This method resets all interal data. The triangulation is lost,
+ * as well as any previously added holes. You will need to re-add
+ * any lost data and reperform the calculation.
+ *
+ * @param points    The vertices to triangulate
+ */
+void MonotoneTriangulator::set(const std::vector<Vec2>& points) {
+    CUAssertLog(Path2::orientation(points) == -1, "Path orientiation is not CCW");
+    clear();
+    _exterior = points.size();
+    _input.reserve(_exterior);
+    _input.insert(_input.end(), points.begin(), points.end());
+}
+
+/**
+ * Sets the exterior vertex data for this triangulator.
+ *
+ * The vertices are assumed to be the outer hull, and do not
+ * include any holes (which may be specified later). The vertices
+ * should define the hull in a counter-clockwise traversal.
+ *
+ * The vertex data is copied. The triangulator does not retain any
+ * references to the original data. Hull points are added first.
+ * That is, when the triangulation is computed, the lowest indices
+ * all refer to these points, in the order that they were provided.
+ *
+ * This method resets all interal data. The triangulation is lost,
+ * as well as any previously added holes. You will need to re-add
+ * any lost data and reperform the calculation.
+ *
+ * @param points    The vertices to triangulate
+ * @param size      The number of vertices
+ */
+void MonotoneTriangulator::set(const Vec2* points, size_t size) {
+    CUAssertLog(Path2::orientation(points,size) == -1, "Path orientiation is not CCW");
+    clear();
+    _exterior = size;
+    _input.reserve(_exterior);
+    _input.insert(_input.end(), points, points+size);
+}
+
+/**
+ * Sets the exterior vertex data for this triangulator.
+ *
+ * The path is assumed to be the outer hull, and does not include
+ * any holes (which may be specified later). The path should define
+ * the hull in a counter-clockwise traversal.
+ *
+ * The vertex data is copied. The triangulator does not retain any
+ * references to the original data. Hull points are added first.
+ * That is, when the triangulation is computed, the lowest indices
+ * all refer to these points, in the order that they were provided.
+ *
+ * This method resets all interal data. The triangulation is lost,
+ * as well as any previously added holes. You will need to re-add
+ * any lost data and reperform the calculation.
+ *
+ * @param path    The vertices to triangulate
+ */
+void MonotoneTriangulator::set(const Path2& path) {
+    CUAssertLog(path.orientation() == -1, "Path orientiation is not CCW");
+    clear();
+    _exterior = path.size();
+    _input.reserve(_exterior);
+    _input.insert(_input.end(), path.vertices.begin(), path.vertices.end());
+}
+
+/**
+ * Adds the given hole to the triangulation.
+ *
+ * The hole is assumed to be a closed path with no self-crossings.
+ * In addition, it is assumed to be inside the polygon outer hull, with
+ * vertices ordered in clockwise traversal. If any of these is not true,
+ * the results are undefined.
+ *
+ * The vertex data is copied. The triangulator does not retain any
+ * references to the original data. Hole points are added after
+ * the hull points, in order. That is, when the triangulation is
+ * computed, if the hull is size n, then the hull points are
+ * indices 0..n-1, while n is the index of a hole point.
+ *
+ * Any holes added to the triangulator will be lost if the exterior
+ * polygon is changed via the {@link #set} method.
+ *
+ * @param points    The hole vertices
+ */
+void MonotoneTriangulator::addHole(const std::vector<Vec2>& points) {
+    CUAssertLog(Path2::orientation(points) == 1, "Hole orientiation is not CW");
+    size_t size = _input.size();
+    _holes.push_back(size);
+    _holes.push_back(points.size());
+    _input.reserve(size+points.size());
+    _input.insert(_input.end(), points.begin(), points.end());
+}
+
+/**
+ * Adds the given hole to the triangulation.
+ *
+ * The hole is assumed to be a closed path with no self-crossings.
+ * In addition, it is assumed to be inside the polygon outer hull, with
+ * vertices ordered in clockwise traversal. If any of these is not true,
+ * the results are undefined.
+ *
+ * The vertex data is copied. The triangulator does not retain any
+ * references to the original data. Hole points are added after
+ * the hull points, in order. That is, when the triangulation is
+ * computed, if the hull is size n, then the hull points are
+ * indices 0..n-1, while n is the index of a hole point.
+ *
+ * Any holes added to the triangulator will be lost if the exterior
+ * polygon is changed via the {@link #set} method.
+ *
+ * @param points    The hole vertices
+ * @param size      The number of vertices
+ */
+void MonotoneTriangulator::addHole(const Vec2* points, size_t size) {
+    CUAssertLog(Path2::orientation(points,size) == 1, "Hole orientiation is not CW");
+    size_t isize = _input.size();
+    _holes.push_back(isize);
+    _holes.push_back(size);
+    _input.reserve(isize+size);
+    _input.insert(_input.end(), points, points+size);
+}
+
+/**
+ * Adds the given hole to the triangulation.
+ *
+ * The hole path should be a closed path with no self-crossings.
+ * In addition, it is assumed to be inside the polygon outer hull,
+ * with vertices ordered in clockwise traversal. If any of these is
+ * not true, the results are undefined.
+ *
+ * The vertex data is copied. The triangulator does not retain any
+ * references to the original data. Hole points are added after
+ * the hull points, in order. That is, when the triangulation is
+ * computed, if the hull is size n, then the hull points are
+ * indices 0..n-1, while n is the index of a hole point.
+ *
+ * Any holes added to the triangulator will be lost if the exterior
+ * polygon is changed via the {@link #set} method.
+ *
+ * @param path      The hole path
+ */
+void MonotoneTriangulator::addHole(const Path2& path) {
+    CUAssertLog(path.orientation() == 1, "Hole orientiation is not CW");
+    size_t size = _input.size();
+    _holes.push_back(size);
+    _holes.push_back(path.size());
+    _input.reserve(size+path.size());
+    _input.insert(_input.end(), path.vertices.begin(), path.vertices.end());
+}
+
+#pragma mark -
+#pragma mark Calculation
+/**
+ * Clears all internal data, but still maintains the initial vertex data.
+ *
+ * This method also retains any holes. It only clears the triangulation results.
+ */
+void MonotoneTriangulator::reset() {
+    _vertices.clear();
+    _output.clear();
+    _calculated = false;
+}
+
+/**
+ * Clears all internal data, including the initial vertex data.
+ *
+ * When this method is called, you will need to set a new vertices before
+ * calling calculate. In addition, any holes will be lost as well.
+ */
+void MonotoneTriangulator::clear() {
+    reset();
+    _input.clear();
+    _holes.clear();
+}
+
+/**
+ * Performs a triangulation of the current vertex data.
+ *
+ * If the vertex data is degenerate (e.g. it has repeated points), so
+ * that a monotone partition is impossible, this method falls back to
+ * {@link EarclipTriangulator}.
+ */
+void MonotoneTriangulator::calculate() {
+    reset();
+    if (_exterior > 0) {
+        allocateVertices();
+        if (!partition() || !computeTriangles()) {
+            CUWarn("Monotone partition failed; falling back to earclipping");
+            _output.clear();
+            EarclipTriangulator fallback;
+            fallback.set(_input.data(),_exterior);
+            for(size_t ii = 0; ii < _holes.size(); ii += 2) {
+                fallback.addHole(_input.data()+_holes[ii],_holes[ii+1]);
+            }
+            fallback.calculate();
+            fallback.getTriangulation(_output);
+        }
+        _vertices.clear();
+    }
+    _calculated = true;
+}
+
+
+#pragma mark -
+#pragma mark Materialization
+/**
+ * Returns a list of indices representing the triangulation.
+ *
+ * The indices represent positions in the original vertex list, which
+ * included holes as well. Positions are ordered as follows: first the
+ * exterior hull, and then all holes in order.
+ *
+ * The triangulator does not retain a reference to the returned list;
+ * it is safe to modify it. If the calculation is not yet performed,
+ * this method will return the empty list.
+ *
+ * @return a list of indices representing the triangulation.
+ */
+std::vector<Uint32> MonotoneTriangulator::getTriangulation() const {
+    return _output;
+}
+
+/**
+ * Stores the triangulation indices in the given buffer.
+ *
+ * The indices represent positions in the original vertex list, which
+ * included both holes and Steiner points. Positions are ordered as
+ * follows: first the exterior hull, then all holes in order, and
+ * finally the Steiner points.
+ *
+ * The indices will be appended to the provided vector. You should clear
+ * the vector first if you do not want to preserve the original data.
+ * If the calculation is not yet performed, this method will do nothing.
+ *
+ * @param buffer    The buffer to store the triangulation indices
+ *
+ * @return the number of elements added to the buffer
+ */
+size_t MonotoneTriangulator::getTriangulation(std::vector<Uint32>& buffer) const {
+    if (_calculated) {
+        buffer.insert(buffer.end(), _output.begin(), _output.end());
+        return _output.size();
+    }
+    return 0;
+}
+
+/**
+ * Returns a polygon representing the triangulation.
+ *
+ * This polygon is the proper triangulation, constrained to the interior
+ * of the polygon hull. It contains the vertices of the exterior polygon,
+ * as well as any holes.
+ *
+ * The triangulator does not maintain references to this polygon and it
+ * is safe to modify it. If the calculation is not yet performed, this
+ * method will return the empty polygon.
+ *
+ * @return a polygon representing the triangulation.
+ */
+Poly2 MonotoneTriangulator::getPolygon() const {
+    Poly2 poly;
+    if (_calculated) {
+        poly.vertices = _input;
+        poly.indices  = _output;
+    }
+    return poly;
+}
+
+/**
+ * Stores the triangulation in the given buffer.
+ *
+ * The polygon produced is the proper triangulation, constrained to the
+ * interior of the polygon hull. It contains the vertices of the exterior
+ * polygon, as well as any holes.
+ *
+ * This method will append the vertices to the given polygon. If the buffer
+ * is not empty, the indices will be adjusted accordingly. You should clear
+ * the buffer first if you do not want to preserve the original data.
+ *
+ * If the calculation is not yet performed, this method will do nothing.
+ *
+ * @param buffer    The buffer to store the triangulated polygon
+ *
+ * @return a reference to the buffer for chaining.
+ */
+Poly2* MonotoneTriangulator::getPolygon(Poly2* buffer) const {
+    CUAssertLog(buffer, "Destination buffer is null");
+    if (_calculated) {
+        Uint32 offset = (int)buffer->vertices.size();
+        if (offset > 0) {
+            buffer->vertices.insert(buffer->vertices.end(), _input.begin(), _input.end());
+            buffer->indices.reserve(buffer->indices.size()+_output.size());
+            for(auto it = _output.begin(); it != _output.end(); ++it) {
+                buffer->indices.push_back(offset+*it);
+            }
+        } else {
+            buffer->vertices = _input;
+            buffer->indices  = _output;
+        }
+    }
+    return buffer;
+}
+
+
+#pragma mark -
+#pragma mark Internal Computation
+/**
+ * Allocates the doubly-linked list(s) to manage the vertices
+ */
+void MonotoneTriangulator::allocateVertices() {
+    // Every diagonal duplicates two vertices, and there are fewer than n
+    size_t size = _input.size();
+    _vertices.reserve(3*size);
+    _vertices.resize(size);
+    for(size_t ii = 0; ii < size; ii++) {
+        _vertices[ii].index = (Uint32)ii;
+        _vertices[ii].coord = _input[ii];
+    }
+
+    // Link the hull and each hole as separate cycles
+    size_t pos = 0;
+    size_t hole = 0;
+    while (pos < size) {
+        size_t len = pos == 0 ? _exterior : _holes[hole+1];
+        if (pos > 0) {
+            hole += 2;
+        }
+        for(size_t ii = 0; ii < len; ii++) {
+            _vertices[pos+ii].next = (Uint32)(pos+(ii+1) % len);
+            _vertices[pos+ii].prev = (Uint32)(pos+(ii+len-1) % len);
+        }
+        pos += len;
+    }
+}
+
+/**
+ * Partitions the vertices into y-monotone pieces
+ *
+ * The pieces are separated by adding diagonals to the doubly-linked
+ * lists. Afterwards, each piece is a single (closed) list.
+ *
+ * @return true if the partition was successful
+ */
+bool MonotoneTriangulator::partition() {
+    size_t size = _vertices.size();
+    if (size < 3) {
+        return false;
+    }
+
+    // Classify the vertices
+    for(size_t ii = 0; ii < size; ii++) {
+        Vertex* v = &_vertices[ii];
+        const Vec2& prev = _vertices[v->prev].coord;
+        const Vec2& next = _vertices[v->next].coord;
+        if (Vertex::below(prev,v->coord) && Vertex::below(next,v->coord)) {
+            v->type = Vertex::convex(next,prev,v->coord) ? TYPE_START : TYPE_SPLIT;
+        } else if (Vertex::below(v->coord,prev) && Vertex::below(v->coord,next)) {
+            v->type = Vertex::convex(next,prev,v->coord) ? TYPE_END : TYPE_MERGE;
+        } else {
+            v->type = TYPE_REGULAR;
+        }
+    }
+
+    // The sweep order (from the top down)
+    std::vector<Uint32> order(size);
+    for(size_t ii = 0; ii < size; ii++) {
+        order[ii] = (Uint32)ii;
+    }
+    std::sort(order.begin(), order.end(), [this](Uint32 a, Uint32 b) {
+        return Vertex::below(_vertices[b].coord,_vertices[a].coord);
+    });
+
+    std::set<Edge> status;
+    std::vector<std::set<Edge>::iterator> edges(3*size,status.end());
+
+    // Adds a diagonal, returning the copy of a that continues its old path
+    auto diagonal = [&](Uint32 a, Uint32 b) {
+        Uint32 acopy = (Uint32)_vertices.size();
+        Uint32 bcopy = acopy+1;
+        _vertices.push_back(_vertices[a]);
+        _vertices.push_back(_vertices[b]);
+        if (edges.size() < _vertices.size()) {
+            edges.resize(_vertices.size(),status.end());
+        }
+        _vertices[_vertices[a].next].prev = acopy;
+        _vertices[_vertices[b].next].prev = bcopy;
+        _vertices[a].next = bcopy;
+        _vertices[bcopy].prev = a;
+        _vertices[b].next = acopy;
+        _vertices[acopy].prev = b;
+
+        edges[acopy] = edges[a];
+        edges[bcopy] = edges[b];
+        if (edges[acopy] != status.end()) {
+            edges[acopy]->index = acopy;
+        }
+        if (edges[bcopy] != status.end()) {
+            edges[bcopy]->index = bcopy;
+        }
+        return acopy;
+    };
+
+    // Inserts the edge starting at the given vertex
+    auto insert = [&](Uint32 pos, Uint32 helper) {
+        Edge edge;
+        edge.p1 = _vertices[pos].coord;
+        edge.p2 = _vertices[_vertices[pos].next].coord;
+        edge.index = pos;
+        edges[pos] = status.insert(edge).first;
+        _vertices[pos].helper = helper;
+    };
+
+    // Returns the edge immediately to the left of the given vertex
+    auto search = [&](Uint32 pos) {
+        Edge edge;
+        edge.p1 = _vertices[pos].coord;
+        edge.p2 = edge.p1;
+        auto it = status.lower_bound(edge);
+        if (it == status.begin()) {
+            return status.end();
+        }
+        return --it;
+    };
+
+    for(auto it = order.begin(); it != order.end(); ++it) {
+        Uint32 pos  = *it;
+        Uint32 prev = _vertices[pos].prev;
+        Uint32 curr = pos;
+        switch (_vertices[pos].type) {
+            case TYPE_START:
+                insert(pos,pos);
+                break;
+            case TYPE_END:
+                if (edges[prev] == status.end()) {
+                    return false;
+                }
+                if (_vertices[_vertices[prev].helper].type == TYPE_MERGE) {
+                    diagonal(pos,_vertices[prev].helper);
+                }
+                status.erase(edges[prev]);
+                break;
+            case TYPE_SPLIT:
+            {
+                auto left = search(pos);
+                if (left == status.end()) {
+                    return false;
+                }
+                curr = diagonal(pos,_vertices[left->index].helper);
+                _vertices[left->index].helper = pos;
+                insert(curr,curr);
+            }
+                break;
+            case TYPE_MERGE:
+            {
+                if (edges[prev] == status.end()) {
+                    return false;
+                }
+                if (_vertices[_vertices[prev].helper].type == TYPE_MERGE) {
+                    curr = diagonal(pos,_vertices[prev].helper);
+                }
+                status.erase(edges[prev]);
+                auto left = search(pos);
+                if (left == status.end()) {
+                    return false;
+                }
+                if (_vertices[_vertices[left->index].helper].type == TYPE_MERGE) {
+                    diagonal(curr,_vertices[left->index].helper);
+                }
+                _vertices[left->index].helper = curr;
+            }
+                break;
+            case TYPE_REGULAR:
+                if (Vertex::below(_vertices[pos].coord,_vertices[prev].coord)) {
+                    // The interior is to the right
+                    if (edges[prev] == status.end()) {
+                        return false;
+                    }
+                    if (_vertices[_vertices[prev].helper].type == TYPE_MERGE) {
+                        curr = diagonal(pos,_vertices[prev].helper);
+                    }
+                    status.erase(edges[prev]);
+                    insert(curr,curr);
+                } else {
+                    auto left = search(pos);
+                    if (left == status.end()) {
+                        return false;
+                    }
+                    if (_vertices[_vertices[left->index].helper].type == TYPE_MERGE) {
+                        diagonal(pos,_vertices[left->index].helper);
+                    }
+                    _vertices[left->index].helper = pos;
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+/**
+ * Computes the triangle indices for all of the monotone pieces.
+ *
+ * @return true if the triangulation was successful
+ */
+bool MonotoneTriangulator::computeTriangles() {
+    _output.reserve(3*(_input.size()+_holes.size()));
+    std::vector<Uint32> piece;
+    for(size_t ii = 0; ii < _vertices.size(); ii++) {
+        if (_vertices[ii].used) {
+            continue;
+        }
+        piece.clear();
+        Uint32 pos = (Uint32)ii;
+        do {
+            if (_vertices[pos].used) {
+                return false;
+            }
+            _vertices[pos].used = true;
+            piece.push_back(pos);
+            pos = _vertices[pos].next;
+        } while (pos != ii);
+        if (!triangulate(piece)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Computes the triangle indices for a single monotone piece.
+ *
+ * The piece is a list of vertex positions (into the vertex list) in
+ * counter-clockwise order.
+ *
+ * @param piece The monotone piece to triangulate
+ *
+ * @return true if the triangulation was successful
+ */
+bool MonotoneTriangulator::triangulate(const std::vector<Uint32>& piece) {
+    size_t size = piece.size();
+    if (size < 3) {
+        return false;
+    } else if (size == 3) {
+        for(size_t ii = 0; ii < 3; ii++) {
+            _output.push_back(_vertices[piece[ii]].index);
+        }
+        return true;
+    }
+
+    // Returns the coordinate at the given piece position
+    auto coord = [&](size_t a) -> const Vec2& {
+        return _vertices[piece[a]].coord;
+    };
+
+    // Find the top and bottom of the piece
+    size_t top = 0;
+    size_t bot = 0;
+    for(size_t ii = 1; ii < size; ii++) {
+        if (Vertex::below(coord(ii),coord(bot))) {
+            bot = ii;
+        }
+        if (Vertex::below(coord(top),coord(ii))) {
+            top = ii;
+        }
+    }
+
+    // Verify that the piece is monotone, in case of degeneracies
+    for(size_t ii = top; ii != bot; ii = (ii+1) % size) {
+        if (!Vertex::below(coord((ii+1) % size),coord(ii))) {
+            return false;
+        }
+    }
+    for(size_t ii = bot; ii != top; ii = (ii+1) % size) {
+        if (!Vertex::below(coord(ii),coord((ii+1) % size))) {
+            return false;
+        }
+    }
+
+    // Merge the two chains. The left chain runs top to bottom in piece order.
+    std::vector<size_t> order(size);
+    std::vector<int> chain(size,0);
+    size_t left  = (top+1) % size;
+    size_t right = (top+size-1) % size;
+    order[0] = top;
+    for(size_t ii = 1; ii < size-1; ii++) {
+        bool useleft;
+        if (left == bot) {
+            useleft = false;
+        } else if (right == bot) {
+            useleft = true;
+        } else {
+            useleft = !Vertex::below(coord(left),coord(right));
+        }
+        if (useleft) {
+            order[ii] = left;
+            chain[left] = 1;
+            left = (left+1) % size;
+        } else {
+            order[ii] = right;
+            chain[right] = -1;
+            right = (right+size-1) % size;
+        }
+    }
+    order[size-1] = bot;
+
+    // Adds the triangle (a,b,c) of piece positions
+    auto emit = [&](size_t a, size_t b, size_t c) {
+        _output.push_back(_vertices[piece[a]].index);
+        _output.push_back(_vertices[piece[b]].index);
+        _output.push_back(_vertices[piece[c]].index);
+    };
+
+    std::vector<size_t> stack;
+    stack.reserve(size);
+    stack.push_back(order[0]);
+    stack.push_back(order[1]);
+    for(size_t ii = 2; ii < size-1; ii++) {
+        size_t curr = order[ii];
+        if (chain[curr] != chain[stack.back()]) {
+            // Connect to every vertex on the other chain
+            for(size_t jj = 0; jj+1 < stack.size(); jj++) {
+                if (chain[curr] == 1) {
+                    emit(stack[jj+1],stack[jj],curr);
+                } else {
+                    emit(stack[jj],stack[jj+1],curr);
+                }
+            }
+            stack.clear();
+            stack.push_back(order[ii-1]);
+            stack.push_back(curr);
+        } else {
+            size_t last = stack.back();
+            stack.pop_back();
+            while (!stack.empty()) {
+                size_t prev = stack.back();
+                if (chain[curr] == 1) {
+                    if (!Vertex::convex(coord(curr),coord(prev),coord(last))) {
+                        break;
+                    }
+                    emit(curr,prev,last);
+                } else {
+                    if (!Vertex::convex(coord(curr),coord(last),coord(prev))) {
+                        break;
+                    }
+                    emit(curr,last,prev);
+                }
+                last = prev;
+                stack.pop_back();
+            }
+            stack.push_back(last);
+            stack.push_back(curr);
+        }
+    }
+
+    size_t curr = order[size-1];
+    for(size_t jj = 0; jj+1 < stack.size(); jj++) {
+        if (chain[stack[jj+1]] == 1) {
+            emit(stack[jj],stack[jj+1],curr);
+        } else {
+            emit(stack[jj+1],stack[jj],curr);
+        }
+    }
+    return true;
+}
@@ -42,6 +42,9 @@
 //
 #include <cugl/math/polygon/CUPathSmoother.h>
 #include <cugl/util/CUDebug.h>
+#include <algorithm>
+#include <queue>
+#include <limits>
 
 using namespace cugl;
 
@@ -54,6 +57,7 @@ using namespace cugl;
  */
 PathSmoother::PathSmoother() :
 _calculated(false),
+_closed(false),
 _epsilon(DEFAULT_EPSILON) {
 }
 
@@ -67,6 +71,7 @@ _epsilon(DEFAULT_EPSILON) {
  */
 PathSmoother::PathSmoother(const std::vector<Vec2>& points) :
 _calculated(false),
+_closed(false),
 _epsilon(DEFAULT_EPSILON) {
     set(points);
 }
@@ -78,6 +83,9 @@ _epsilon(DEFAULT_EPSILON) {
  */
 void PathSmoother::reset() {
     _output.clear();
+    _importance.clear();
+    _order.clear();
+    _tolerance.clear();
     _calculated = false;
 }
 
@@ -163,6 +171,123 @@ size_t PathSmoother::douglasPeucker(size_t start, size_t end) {
 }
 
 
+/**
+ * Returns the distance from p to the segment ab
+ *
+ * @param a     The start of the segment
+ * @param b     The end of the segment
+ * @param p     The point to measure
+ *
+ * @return the distance from p to the segment ab
+ */
+static float segment_distance(const Vec2& a, const Vec2& b, const Vec2& p) {
+    Vec2 u = b-a;
+    float l2 = u.lengthSquared();
+    if (l2 == 0) {
+        return p.distance(a);
+    }
+    float t = std::max(0.0f, std::min(1.0f, (p-a).dot(u)/l2));
+    return p.distance(a+u*t);
+}
+
+/**
+ * Computes a multi-resolution representation of the current vertex data.
+ *
+ * This is a single Douglas-Peucker pass that, instead of stopping at the
+ * epsilon value, always refines the span with the largest deviation until
+ * every vertex is used. The order in which vertices are added describes
+ * every level of detail at once. Any level of detail is then a prefix of
+ * this order, and can be read with methods like {@link #getDetailPoints}
+ * without recomputing anything. The error of each prefix is recorded as
+ * well, so that {@link #getDetailCount} can map a tolerance to a prefix.
+ *
+ * The end points of an open path always have infinite importance. If the
+ * path is closed, the first vertex and the vertex farthest from it are the
+ * two most important vertices.
+ *
+ * This calculation is independent of {@link #calculate}, and does not
+ * use the epsilon value.
+ */
+void PathSmoother::calculateDetail() {
+    const float INF = std::numeric_limits<float>::infinity();
+    size_t size = _input.size();
+    _importance.assign(size,0.0f);
+    _order.clear();
+    _tolerance.clear();
+    if (size == 0) {
+        return;
+    }
+    
+    // A span of the path (end may wrap past size) and its farthest vertex
+    struct Span {
+        float  dist;
+        size_t start;
+        size_t end;
+        size_t index;
+        bool operator<(const Span& other) const { return dist < other.dist; }
+    };
+    std::priority_queue<Span> queue;
+    auto refine = [&](size_t start, size_t end) {
+        if (end-start <= 1) {
+            return;
+        }
+        const Vec2& a = _input[start % size];
+        const Vec2& b = _input[end % size];
+        Span span;
+        span.dist  = -1;
+        span.start = start;
+        span.end   = end;
+        span.index = start+1;
+        for(size_t ii = start+1; ii < end; ii++) {
+            float dist = segment_distance(a,b,_input[ii % size]);
+            if (dist > span.dist) {
+                span.dist  = dist;
+                span.index = ii;
+            }
+        }
+        queue.push(span);
+    };
+    
+    _order.reserve(size);
+    _tolerance.reserve(size);
+    _importance[0] = INF;
+    _order.push_back(0);
+    _tolerance.push_back(size > 1 ? INF : 0);
+    if (size > 1) {
+        size_t last = size-1;
+        if (_closed) {
+            float best = -1;
+            for(size_t ii = 1; ii < size; ii++) {
+                float dist = _input[ii].distanceSquared(_input[0]);
+                if (dist > best) {
+                    best = dist;
+                    last = ii;
+                }
+            }
+        }
+        _importance[last] = INF;
+        _order.push_back((Uint32)last);
+        refine(0,last);
+        if (_closed) {
+            refine(last,size);
+        }
+        _tolerance.push_back(queue.empty() ? 0 : queue.top().dist);
+    }
+    
+    while (!queue.empty()) {
+        Span span = queue.top();
+        queue.pop();
+        _importance[span.index % size] = span.dist;
+        _order.push_back((Uint32)(span.index % size));
+        refine(span.start,span.index);
+        refine(span.index,span.end);
+        
+        // Deviation is not monotone in Douglas-Peucker, so keep a running min
+        float error = queue.empty() ? 0 : queue.top().dist;
+        _tolerance.push_back(std::min(error,_tolerance.back()));
+    }
+}
+
 #pragma mark -
 #pragma mark Materialization
 /**
@@ -237,3 +362,103 @@ Path2* PathSmoother::getPath(Path2* buffer) const {
     return buffer;
 
 }
+
+#pragma mark -
+#pragma mark Level of Detail
+/**
+ * Returns the number of vertices needed to match the given tolerance.
+ *
+ * This is the length of the shortest prefix of the detail order whose path
+ * is within epsilon of every input vertex. The result is at least 2 (or the
+ * number of input vertices, if that is smaller) so that the path is never
+ * lost. The value is found with a binary search.
+ *
+ * If {@link #calculateDetail} has not been called, this method returns 0.
+ *
+ * @param epsilon   The tolerance
+ *
+ * @return the number of vertices needed to match the given tolerance.
+ */
+size_t PathSmoother::getDetailCount(float epsilon) const {
+    if (_tolerance.empty()) {
+        return 0;
+    }
+    auto it = std::partition_point(_tolerance.begin(), _tolerance.end(), [=](float error) {
+        return error > epsilon;
+    });
+    size_t count = std::min((size_t)(it-_tolerance.begin())+1,_tolerance.size());
+    return std::max(count,std::min((size_t)2,_order.size()));
+}
+
+/**
+ * Stores the given number of detail vertices in the buffer.
+ *
+ * The vertices are stored in their original path order, and are appended
+ * to the buffer. The count is a level of detail, and may be any value up
+ * to the number of input vertices. Use {@link #getDetailCount} to choose
+ * a count from a tolerance (such as one pixel at the current zoom).
+ *
+ * If {@link #calculateDetail} has not been called, this method does nothing.
+ *
+ * @param count     The number of vertices to use
+ * @param buffer    The buffer to store the vertices
+ *
+ * @return the number of elements added to the buffer
+ */
+size_t PathSmoother::getDetailPoints(size_t count, std::vector<Vec2>& buffer) const {
+    count = std::min(count,_order.size());
+    std::vector<Uint32> indices(_order.begin(),_order.begin()+count);
+    std::sort(indices.begin(),indices.end());
+    buffer.reserve(buffer.size()+count);
+    for(auto it = indices.begin(); it != indices.end(); ++it) {
+        buffer.push_back(_input[*it]);
+    }
+    return count;
+}
+
+/**
+ * Returns a path with the given number of detail vertices.
+ *
+ * The vertices are in their original path order. The count is a level of
+ * detail, and may be any value up to the number of input vertices. Use
+ * {@link #getDetailCount} to choose a count from a tolerance (such as one
+ * pixel at the current zoom). The path is closed if the input was.
+ *
+ * If {@link #calculateDetail} has not been called, this method will return
+ * the empty path.
+ *
+ * @param count     The number of vertices to use
+ *
+ * @return a path with the given number of detail vertices.
+ */
+Path2 PathSmoother::getDetailPath(size_t count) const {
+    Path2 path;
+    getDetailPath(count,&path);
+    return path;
+}
+
+/**
+ * Stores a path with the given number of detail vertices.
+ *
+ * The vertices are in their original path order. They are appended to
+ * the end of the buffer. The count is a level of detail, and may be any
+ * value up to the number of input vertices. Use {@link #getDetailCount}
+ * to choose a count from a tolerance (such as one pixel at the current
+ * zoom). The path is closed if the input was.
+ *
+ * If {@link #calculateDetail} has not been called, this method will do
+ * nothing.
+ *
+ * @param count     The number of vertices to use
+ * @param buffer    The buffer to store the path
+ *
+ * @return a reference to the buffer for chaining.
+ */
+Path2* PathSmoother::getDetailPath(size_t count, Path2* buffer) const {
+    CUAssertLog(buffer, "Destination buffer is null");
+    if (!_order.empty()) {
+        getDetailPoints(count,buffer->vertices);
+        buffer->closed = _closed;
+    }
+    return buffer;
+}
@@ -37,7 +37,9 @@
 #include <cugl/math/CUPath2.h>
 #include <cugl/math/CUPoly2.h>
 #include <cugl/util/CUDebug.h>
+#include <algorithm>
 #include <iterator>
+#include <cmath>
 
 /** Tolerance to identify a point as "smooth" */
 #define SMOOTH_TOLERANCE    0.0001f
@@ -76,20 +78,15 @@ void SplinePather::clear() {
 /**
  * Performs an approximation of the current spline
  *
- * A polygon approximation is creating by recursively calling de Castlejau's
- * until we reach a stopping condition. The stopping condition is determined
- * by the {@link Criterion}.  See that enum for a description of how the
- * various stopping conditions work.  The tolerance is the value associated
- * with the condition.  For example, for condition DISTANCE, tolerance is how
- * far the point can be away from the true curve.
+ * Each bezier segment is divided into the minimum number of uniform
+ * pieces for which the path is guaranteed to be within the flatness
+ * tolerance of the curve (at the current scale). The pieces are then
+ * evaluated with forward differencing.
  *
  * The calculation uses a reference to the spline; it does not copy it.
  * Hence this method is not thread-safe.  If you are using this method in
  * a task thread, you should copy the spline first before starting the
  * calculation.
- *
- * @param  criterion    the stopping condition criterion
- * @param  tolerance    the error tolerance of the stopping condition
  */
 void SplinePather::calculate() {
     reset();
@@ -103,7 +100,7 @@ void SplinePather::calculate() {
     
     for (size_t ii = 0; ii < _spline->_size; ii++) {
         _anchorpts[_pointbuff.size()] = ii;
-        generate((float)ii, points+(3*ii), points+(3*ii+1), points+(3*ii+2), points+(3*ii+3), 0);
+        generate((float)ii, points+(3*ii), points+(3*ii+1), points+(3*ii+2), points+(3*ii+3));
     }
     
     // Push back last point and parameter
@@ -115,67 +112,131 @@ void SplinePather::calculate() {
 }
 
 /**
- * Generates data via recursive use of de Castlejau's
+ * Generates data via forward differencing of the given segment
  *
- * This method subdivides the spline at the given segment. The results
- * are put in the output buffers.
+ * This method subdivides the segment into the minimum number of uniform
+ * pieces within the flatness tolerance. The control points of each
+ * piece are put in the output buffers.
  *
  * @param  t        the parameter for the (start of) this segment
  * @param  p0       the left anchor of this segment
  * @param  p1       the left tangent of this segment
  * @param  p2       the right tangent of this segment
  * @param  p3       the right anchor of this segment
- * @param  depth    the current depth of the recursive call
  *
- * @return The number of (anchor) points generated by this recursive call.
+ * @return The number of (anchor) points generated for this segment.
  */
 int SplinePather::generate(float t, const Vec2* p0, const Vec2* p1,
-                           const Vec2* p2, const Vec2* p3, int depth) {
-    // Do not go to far
-    bool terminate = false;
-    if (depth >= 8) {
-        terminate = true;
-    } else if ((*p0 == *p1) && (*p2 == *p3)) {
-        terminate = true;
-    } else {
-        float dx = p3->x - p0->x;
-        float dy = p3->y - p0->y;
-        float d2 = (((p1->x - p3->x) * dy - (p1->y - p3->y) * dx));
-        float d3 = (((p2->x - p3->x) * dy - (p2->y - p3->y) * dx));
-        d2 = d2 > 0 ? d2 : -d2;
-        d3 = d3 > 0 ? d3 : -d3;
-    
-        if ((d2 + d3)*(d2 + d3) < _tolerance * (dx*dx + dy*dy)) {
-            terminate = true;
-        }
+                           const Vec2* p2, const Vec2* p3) {
+    float tolerance = _tolerance/_scale;
+
+    // Flat segments (including lines) need no subdivision
+    int pieces = 1;
+    float dx = p3->x - p0->x;
+    float dy = p3->y - p0->y;
+    float d2 = (((p1->x - p3->x) * dy - (p1->y - p3->y) * dx));
+    float d3 = (((p2->x - p3->x) * dy - (p2->y - p3->y) * dx));
+    d2 = d2 > 0 ? d2 : -d2;
+    d3 = d3 > 0 ? d3 : -d3;
+    if (!((*p0 == *p1) && (*p2 == *p3)) &&
+        (d2 + d3)*(d2 + d3) >= tolerance * tolerance * (dx*dx + dy*dy)) {
+        // Wang's formula bounds the error of a uniform subdivision
+        Vec2 dd1 = *p0 - *p1*2 + *p2;
+        Vec2 dd2 = *p1 - *p2*2 + *p3;
+        float bound = std::max(dd1.lengthSquared(),dd2.lengthSquared());
+        float count = std::ceil(std::sqrt(0.75f*std::sqrt(bound)/tolerance));
+        pieces = (int)std::min(std::max(count,1.0f),(float)MAX_FLATNESS_SEGMENTS);
     }
-    
-    // Add the first point if terminating.
-    int result = 0;
-    if (terminate) {
-        //CULog("Terminate at %.3f [%d]\n",param,depth);
+
+    float h = 1.0f/pieces;
+    if (pieces == 1) {
         _parambuff.push_back(t);
         _pointbuff.push_back(*p0);
         _pointbuff.push_back(*p1);
         _pointbuff.push_back(*p2);
         return 1;
     }
-    
-    // Cross bar
-    Vec2 h  = (*p1 + *p2)*0.5f;
-
-    // Subdivisions
-    Vec2 l1 = (*p0 + *p1)*0.5f;
-    Vec2 l2 = ( l1 +   h)*0.5f;
-    Vec2 r2 = (*p2 + *p3)*0.5f;
-    Vec2 r1 = (  h +  r2)*0.5f;
-    Vec2 c =  ( l2 +  r1)*0.5f;
-    
-    // Recursive calls
-    float s = t + 1.0f / (1 << (depth + 1));
-    result =  generate(t, p0, &l1, &l2, &c, depth + 1);
-    result += generate(s, &c, &r1, &r2, p3, depth + 1);
-    return result;
+
+    // Polynomial coefficients: B(u) = a u^3 + b u^2 + c u + p0
+    Vec2 a = (*p1-*p2)*3 + *p3 - *p0;
+    Vec2 b = (*p0 - *p1*2 + *p2)*3;
+    Vec2 c = (*p1 - *p0)*3;
+
+    // Forward differences of B (xy) and of its derivative B' (zw)
+    float h2 = h*h;
+    float h3 = h2*h;
+    float third = h/3.0f;
+    float state[4] = { p0->x, p0->y, c.x, c.y };
+    float diff1[4] = { a.x*h3+b.x*h2+c.x*h, a.y*h3+b.y*h2+c.y*h,
+                       3*a.x*h2+2*b.x*h, 3*a.y*h2+2*b.y*h };
+    float diff2[4] = { 6*a.x*h3+2*b.x*h2, 6*a.y*h3+2*b.y*h2, 6*a.x*h2, 6*a.y*h2 };
+    float diff3[4] = { 6*a.x*h3, 6*a.y*h3, 0, 0 };
+
+    size_t offset = _pointbuff.size();
+    _pointbuff.resize(offset+3*pieces);
+    _parambuff.reserve(_parambuff.size()+pieces);
+    Vec2* out = _pointbuff.data()+offset;
+
+    // The first anchor and tangent are exact
+    out[0] = *p0;
+    out[1] = *p0+c*third;
+#if defined (CU_MATH_VECTOR_SSE)
+    __m128 vstate = _mm_loadu_ps(state);
+    __m128 vdiff1 = _mm_loadu_ps(diff1);
+    __m128 vdiff2 = _mm_loadu_ps(diff2);
+    __m128 vdiff3 = _mm_loadu_ps(diff3);
+    __m128 vthird = _mm_set1_ps(third);
+    for(int ii = 1; ii < pieces; ii++) {
+        vstate = _mm_add_ps(vstate,vdiff1);
+        vdiff1 = _mm_add_ps(vdiff1,vdiff2);
+        vdiff2 = _mm_add_ps(vdiff2,vdiff3);
+
+        // (x,y,x,y) +/- (dx,dy,dx,dy)*h/3
+        __m128 pos = _mm_movelh_ps(vstate,vstate);
+        __m128 tan = _mm_mul_ps(_mm_movehl_ps(vstate,vstate),vthird);
+        __m128 rgt = _mm_sub_ps(pos,tan);
+        __m128 lft = _mm_add_ps(pos,tan);
+        _mm_storel_pi((__m64*)(out+3*ii-1),rgt);
+        _mm_storel_pi((__m64*)(out+3*ii),pos);
+        _mm_storel_pi((__m64*)(out+3*ii+1),lft);
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+    float32x4_t vstate = vld1q_f32(state);
+    float32x4_t vdiff1 = vld1q_f32(diff1);
+    float32x4_t vdiff2 = vld1q_f32(diff2);
+    float32x4_t vdiff3 = vld1q_f32(diff3);
+    for(int ii = 1; ii < pieces; ii++) {
+        vstate = vaddq_f32(vstate,vdiff1);
+        vdiff1 = vaddq_f32(vdiff1,vdiff2);
+        vdiff2 = vaddq_f32(vdiff2,vdiff3);
+
+        float32x2_t pos = vget_low_f32(vstate);
+        float32x2_t tan = vmul_n_f32(vget_high_f32(vstate),third);
+        vst1_f32((float*)(out+3*ii-1),vsub_f32(pos,tan));
+        vst1_f32((float*)(out+3*ii),pos);
+        vst1_f32((float*)(out+3*ii+1),vadd_f32(pos,tan));
+    }
+#else
+    for(int ii = 1; ii < pieces; ii++) {
+        for(int jj = 0; jj < 4; jj++) {
+            state[jj] += diff1[jj];
+            diff1[jj] += diff2[jj];
+            diff2[jj] += diff3[jj];
+        }
+        Vec2 pos(state[0],state[1]);
+        Vec2 tan(state[2]*third,state[3]*third);
+        out[3*ii-1] = pos-tan;
+        out[3*ii  ] = pos;
+        out[3*ii+1] = pos+tan;
+    }
+#endif
+    // The last tangent is exact
+    out[3*pieces-1] = *p3+(*p2-*p3)*h;
+
+    for(int ii = 0; ii < pieces; ii++) {
+        _parambuff.push_back(t+ii*h);
+    }
+    return pieces;
 }
 
 #pragma mark -
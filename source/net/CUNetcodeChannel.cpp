@@ -49,7 +49,9 @@
 #include <cugl/net/CUNetcodeConnection.h>
 #include <cugl/net/CUNetcodePeer.h>
 #include <cugl/assets/CUJsonValue.h>
+#include <cugl/base/CUEndian.h>
 #include <cugl/util/CUDebug.h>
+#include <algorithm>
 #include <cstring>
 #include <vector>
 
@@ -57,6 +59,50 @@ using namespace cugl::net;
 using namespace std;
 using namespace rtc;
 
+/** How often (in packets received) to sample the round trip time */
+#define RTT_SAMPLE_RATE 32
+/** The first byte of a fragment */
+#define FRAGMENT_MARKER  std::byte{0xFD}
+/** The size of a fragment header (marker, id, index, count, and message size) */
+#define FRAGMENT_HEADER  (1+2*sizeof(Uint32)+2*sizeof(Uint16))
+/** The largest fragment to send, so that other messages can interleave */
+#define FRAGMENT_SIZE    16384
+/** The buffered amount below which queued fragments are always sent */
+#define FRAGMENT_WINDOW  65536
+/** The maximum number of messages to reassemble at once */
+#define FRAGMENT_BUFFERS 8
+/** The largest message that can be fragmented */
+#define FRAGMENT_LIMIT   (1 << 24)
+
+/**
+ * Appends the given value to a fragment in network order
+ *
+ * @param fragment  The fragment to append to
+ * @param value     The value to append
+ */
+template <typename T>
+static void fragment_append(std::vector<std::byte>& fragment, T value) {
+    value = cugl::marshall(value);
+    const std::byte* bytes = reinterpret_cast<const std::byte*>(&value);
+    fragment.insert(fragment.end(), bytes, bytes+sizeof(T));
+}
+
+/**
+ * Returns the value at the given position of a fragment
+ *
+ * @param fragment  The fragment to read
+ * @param pos       The position to read
+ *
+ * @return the value at the given position of a fragment
+ */
+template <typename T>
+static T fragment_read(const std::vector<std::byte>& fragment, size_t pos) {
+    T value;
+    std::memcpy(&value,fragment.data()+pos,sizeof(T));
+    return cugl::marshall(value);
+}
+
+
 #pragma mark Constructors
 /**
  * Creates a degenerate RTC data channel.
@@ -68,7 +114,16 @@ using namespace rtc;
  */
 NetcodeChannel::NetcodeChannel() : 
 	_label(""), 
+	_handle(NETCODE_NO_HANDLE),
 	_channel(nullptr), 
+	_reliable(true),
+	_buffered(0),
+	_samples(0),
+	_highWater(0),
+	_lowWater(0),
+	_policy(Backpressure::QUEUE),
+	_congested(false),
+	_fragmentId(0),
 	_debug(false),
 	_active(false),
 	_open(false) {
@@ -98,6 +153,17 @@ void NetcodeChannel::dispose() {
 			_active = false;	// Prevents cycles
 			_channel->close();
 			_channel = nullptr;
+			if (_stats != nullptr) {
+				_stats->recordBuffered(0-_buffered);
+				_buffered = 0;
+			}
+			for(auto it = _incoming.begin(); it != _incoming.end(); ++it) {
+				_reassembly->free(it->second);
+			}
+			_incoming.clear();
+			_outgoing.clear();
+			_pending = nullptr;
+			_simulator = nullptr;
 
 			peer  = _parent.lock();
 			label = _label;
@@ -114,12 +180,16 @@ void NetcodeChannel::dispose() {
  *
  * This initializer assumes the peer is the offerer of the data channel.
  *
+ * If the channel is not reliable, it will be unordered and will never
+ * retransmit a lost message (e.g. maxRetransmits is 0).
+ *
  * @param parent    The parent RTC peer connection
  * @param label     The unique label for this data channel
+ * @param reliable  Whether the data channel is reliable and ordered
  *
  * @return true if initialization was successful
  */
-bool NetcodeChannel::init(const std::weak_ptr<NetcodePeer>& parent, std::string label) {
+bool NetcodeChannel::init(const std::weak_ptr<NetcodePeer>& parent, std::string label, bool reliable) {
 	auto p = parent.lock();
 	if (p == nullptr) {
 		return false;
@@ -136,24 +206,41 @@ bool NetcodeChannel::init(const std::weak_ptr<NetcodePeer>& parent, std::string
 			bool debug = p->_debug;
 			_debug = debug;
 			connection = p->_connection;
+			_stats = std::make_shared<NetcodeCounters>(p->_stats);
 		}
 	}
 
 	if (connection == nullptr) {
 		return false;
 	}
+	_reassembly = FreeList<Reassembly>::alloc(FRAGMENT_BUFFERS,true);
+	if (_reassembly == nullptr) {
+		return false;
+	}
 	
 	_label = label;
+	_reliable = reliable;
+	_connection = connection;
 	_active = true;
 
     if (_debug) {
-        CULog("NETCODE: Offered data channel '%s' from %s",_label.c_str(),_uuid.c_str());
+        CULog("NETCODE: Offered %s data channel '%s' from %s",
+              (_reliable ? "reliable" : "unreliable"),_label.c_str(),_uuid.c_str());
     }
 	try {
-		_channel = connection->createDataChannel(label);
+		rtc::DataChannelInit init;
+		if (!_reliable) {
+			init.reliability.type = rtc::Reliability::Type::Rexmit;
+			init.reliability.unordered = true;
+			init.reliability.rexmit = 0;
+		}
+		_channel = connection->createDataChannel(label,init);
 		_channel->onOpen([this]() { onOpen(); });
 		_channel->onClosed([this]() { onClosed(); });
 		_channel->onMessage([this](auto data) { onMessage(data); });
+		_channel->onBufferedAmountLow([this]() { onBufferedAmountLow(); });
+		applyBackpressure();
+		applySimulator();
 		return true;
 	} catch (const std::exception &e) {
 		CULogError("NETCODE ERROR: %s",e.what());
@@ -189,11 +276,19 @@ bool NetcodeChannel::init(const std::weak_ptr<NetcodePeer>& parent, const std::s
 			_debug = debug;
 			_uuid  = p->_uuid;
 			_grandparent = p->_parent;
+			_connection  = p->_connection;
+			_stats = std::make_shared<NetcodeCounters>(p->_stats);
 		} else {
 			return false;
 		}
 	}
+	_reassembly = FreeList<Reassembly>::alloc(FRAGMENT_BUFFERS,true);
+	if (_reassembly == nullptr) {
+		return false;
+	}
 	_label = dc->label();
+	rtc::Reliability reliability = dc->reliability();
+	_reliable = (reliability.type == rtc::Reliability::Type::Reliable && !reliability.unordered);
     _active = true;
 	if (_debug) {
 		CULog("NETCODE: Received data channel '%s' from %s",_label.c_str(),_uuid.c_str());
@@ -203,6 +298,9 @@ bool NetcodeChannel::init(const std::weak_ptr<NetcodePeer>& parent, const std::s
 	_channel->onOpen([this]() { onOpen(); });
 	_channel->onClosed([this]() { onClosed(); });
 	_channel->onMessage([this](auto data) { onMessage(data); });
+	_channel->onBufferedAmountLow([this]() { onBufferedAmountLow(); });
+	applyBackpressure();
+	applySimulator();
 	return true;
 }
 
@@ -221,6 +319,7 @@ void NetcodeChannel::onOpen() {
 		}
 		parent = _parent.lock();
 		label  = _label;
+		_open  = true;
 	}
     // Announce a successful connection
 	if (parent != nullptr) {
@@ -244,18 +343,128 @@ void NetcodeChannel::onClosed() {
  * Responds to a data channel message
  *
  * This information will be forwarded to the {@link NetcodeConnection} associated
- * with this data channel.
+ * with this data channel, which unpacks it if it is a batched datagram. Fragments
+ * are only forwarded once the message is complete.
+ *
+ * If this channel has a {@link NetcodeSimulator}, the message is processed once
+ * the simulator delivers it.
  *
  * @param data  The message data (a string or byte vector) 
  */
 void NetcodeChannel::onMessage(rtc::message_variant data) {
+	std::shared_ptr<NetcodeSimulator> simulator = nullptr;
+	std::weak_ptr<NetcodeChannel> wp;
+	{
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		if (_active && _simulator != nullptr) {
+			simulator = _simulator;
+			wp = weak_from_this();
+		}
+	}
+	
+	if (simulator != nullptr && std::holds_alternative<rtc::binary>(data)) {
+		// The simulator may deliver the datagram twice
+		auto datagram = std::make_shared<const rtc::binary>(std::get<rtc::binary>(std::move(data)));
+		bool posted = simulator->post(_uuid,_label+"<",_reliable,datagram->size(),[wp,datagram]() {
+			auto channel = wp.lock();
+			if (channel != nullptr) {
+				channel->receive(rtc::binary(*datagram));
+			}
+		});
+		if (!posted) {
+			receive(rtc::binary(*datagram));
+		}
+		return;
+	}
+	receive(std::move(data));
+}
+
+/**
+ * Processes a data channel message once it has arrived
+ *
+ * This is the body of {@link #onMessage}. It is split off so that a
+ * {@link NetcodeSimulator} can delay the message before it is processed.
+ *
+ * @param data  The message data (a string or byte vector)
+ */
+void NetcodeChannel::receive(rtc::message_variant data) {
 	std::shared_ptr<NetcodeConnection> grand = nullptr;
+	std::shared_ptr<rtc::PeerConnection> connection = nullptr;
 	std::string source = _uuid;
+	NetcodeConnection::PeerHandle handle = NETCODE_NO_HANDLE;
+	NetcodeConnection::Lane lane = NetcodeConnection::Lane::RELIABLE;
 	
 	// Critical section	
 	{
 		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		if (_label == NETCODE_UNRELIABLE_CHANNEL) {
+			lane = NetcodeConnection::Lane::UNRELIABLE;
+		}
 		if (_active && std::holds_alternative<rtc::binary>(data)) {
+			rtc::binary& bytes = std::get<rtc::binary>(data);
+			_stats->recordReceived(bytes.size());
+			if (_samples++ % RTT_SAMPLE_RATE == 0) {
+				connection = _connection.lock();
+			}
+			if (bytes.empty() || bytes[0] != FRAGMENT_MARKER || reassemble(bytes)) {
+				grand  = _grandparent.lock();
+				source = _uuid;
+				handle = _handle;
+			}
+		}
+	}
+	
+	// Sample the round trip time
+	if (connection != nullptr) {
+		auto rtt = connection->rtt();
+		if (rtt.has_value()) {
+			_stats->rtt = rtt->count();
+			if (_stats->parent) {
+				_stats->parent->rtt = rtt->count();
+			}
+		}
+	}
+	
+	// NEVER lock upwards
+	if (grand != nullptr) {
+		if (handle == NETCODE_NO_HANDLE) {
+			handle = grand->intern(source);
+			std::lock_guard<std::recursive_mutex> lock(_mutex);
+			if (_uuid == source) {
+				_handle = handle;
+			}
+		}
+		grand->unbatch(handle,std::get<rtc::binary>(std::move(data)),lane);
+	}
+}
+
+/**
+ * Called when the buffered amount drops to the low watermark
+ *
+ * This resumes any queued fragments, sends any coalesced message, and notifies
+ * the {@link NetcodeConnection} if the channel was previously congested.
+ */
+void NetcodeChannel::onBufferedAmountLow() {
+	std::shared_ptr<NetcodeConnection> grand = nullptr;
+	std::string source;
+	
+	// Critical section
+	{
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		if (!_active) {
+			return;
+		}
+		pump();
+		if (_pending != nullptr) {
+			NetcodeMessage pending = _pending;
+			_pending = nullptr;
+			transmit(*pending,pending);
+		}
+		if (_congested) {
+			if (_debug) {
+				CULog("NETCODE: Data channel '%s' to %s is writable.",_label.c_str(),_uuid.c_str());
+			}
+			_congested = false;
 			grand  = _grandparent.lock();
 			source = _uuid;
 		}
@@ -263,10 +472,256 @@ void NetcodeChannel::onMessage(rtc::message_variant data) {
 	
 	// NEVER lock upwards
 	if (grand != nullptr) {
-		grand->append(source,std::get<rtc::binary>(data));	
+		grand->onChannelWritable(source);
+	}
+}
+
+/**
+ * Applies the backpressure settings of the {@link NetcodeConnection}
+ *
+ * The settings are chosen according to the lane of this channel. They are
+ * atomic, so this does not require a lock on the connection.
+ */
+void NetcodeChannel::applyBackpressure() {
+	auto grand = _grandparent.lock();
+	if (grand != nullptr) {
+		int lane = (_label == NETCODE_UNRELIABLE_CHANNEL ? 1 : 0);
+		setBackpressure(grand->_highWater[lane],grand->_lowWater[lane],grand->_backpressure[lane]);
+	}
+}
+
+/**
+ * Sets the backpressure settings for this channel
+ *
+ * The channel becomes congested when the buffered amount reaches the high
+ * watermark, and remains so until it drops to the low watermark. A high
+ * watermark of 0 disables backpressure.
+ *
+ * @param high      The high watermark in bytes
+ * @param low       The low watermark in bytes
+ * @param policy    How to handle messages when congested
+ */
+void NetcodeChannel::setBackpressure(size_t high, size_t low, Backpressure policy) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	_highWater = high;
+	_lowWater  = (low < high || high == 0 ? low : high);
+	_policy = policy;
+	if (_active && _channel != nullptr) {
+		_channel->setBufferedAmountLowThreshold(_lowWater);
 	}
 }
 
+/**
+ * Applies the network simulator of the {@link NetcodeConnection}
+ *
+ * The simulator is accessed atomically, so this does not require a lock
+ * on the connection.
+ */
+void NetcodeChannel::applySimulator() {
+	auto grand = _grandparent.lock();
+	if (grand != nullptr) {
+		setSimulator(grand->getSimulator());
+	}
+}
+
+/**
+ * Sets the network simulator for this channel.
+ *
+ * Any datagrams already held by the previous simulator are still
+ * delivered. A nullptr value disables simulation.
+ *
+ * @param simulator The network simulator
+ */
+void NetcodeChannel::setSimulator(const std::shared_ptr<NetcodeSimulator>& simulator) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	if (_active) {
+		_simulator = simulator;
+	}
+}
+
+/**
+ * Passes a single datagram to the RTC data channel.
+ *
+ * If this channel has a {@link NetcodeSimulator}, the datagram is posted
+ * to the simulator, which calls {@link #release} once it is due. This
+ * method must be called while holding the lock for this channel.
+ *
+ * The datagram is only copied if it is simulated and message is nullptr.
+ *
+ * @param data      The datagram to send
+ * @param message   The shared buffer for the datagram (nullptr for none)
+ */
+void NetcodeChannel::emit(const std::vector<std::byte>& data, const NetcodeMessage& message) {
+	_stats->recordSent(data.size());
+	if (_simulator != nullptr) {
+		NetcodeMessage datagram = message != nullptr ? message : std::make_shared<const std::vector<std::byte>>(data);
+		std::weak_ptr<NetcodeChannel> wp = weak_from_this();
+		if (_simulator->post(_uuid,_label+">",_reliable,data.size(),[wp,datagram]() {
+			auto channel = wp.lock();
+			if (channel != nullptr) {
+				channel->release(datagram);
+			}
+		})) {
+			return;
+		}
+	}
+	_channel->send(data.data(),data.size());
+}
+
+/**
+ * Passes a datagram delayed by the network simulator to the RTC data channel.
+ *
+ * The datagram is discarded if this channel closed in the meantime.
+ *
+ * @param datagram  The datagram to send
+ */
+void NetcodeChannel::release(const NetcodeMessage& datagram) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	if (_active && _open) {
+		try {
+			_channel->send(datagram->data(),datagram->size());
+		} catch (const std::exception &e) {
+			CULogError("NETCODE ERROR: %s",e.what());
+		}
+	}
+}
+
+/**
+ * Sends a datagram along the RTC data channel, ignoring backpressure.
+ *
+ * If the datagram is larger than a single fragment, or begins with the
+ * fragment marker, it is split into fragments which are queued for
+ * {@link #pump}. On a reliable channel, any datagram sent while fragments
+ * are queued is queued behind them, so that order is preserved. This
+ * method must be called while holding the lock for this channel.
+ *
+ * The datagram is only copied if it must be queued and message is nullptr.
+ * Otherwise the queue shares message, which must hold the same bytes as
+ * data.
+ *
+ * @param data      The datagram to send
+ * @param message   The shared buffer for the datagram (nullptr for none)
+ */
+void NetcodeChannel::transmit(const std::vector<std::byte>& data, const NetcodeMessage& message) {
+	size_t limit = std::min(_channel->maxMessageSize(),(size_t)FRAGMENT_SIZE)-FRAGMENT_HEADER;
+	if (data.size() <= limit && (data.empty() || data[0] != FRAGMENT_MARKER)) {
+		if (_reliable && !_outgoing.empty()) {
+			_outgoing.push_back(message != nullptr ? message : std::make_shared<const std::vector<std::byte>>(data));
+		} else {
+			emit(data,message);
+		}
+		return;
+	}
+	
+	// Every fragment but the last has the same size
+	Uint16 count = (Uint16)((data.size()+limit-1)/limit);
+	size_t chunk = (data.size()+count-1)/count;
+	Uint32 id = _fragmentId++;
+	for(Uint16 ii = 0; ii < count; ii++) {
+		size_t start = ii*chunk;
+		size_t end = std::min(start+chunk,data.size());
+		std::vector<std::byte> fragment;
+		fragment.reserve(FRAGMENT_HEADER+end-start);
+		fragment.push_back(FRAGMENT_MARKER);
+		fragment_append(fragment,id);
+		fragment_append(fragment,ii);
+		fragment_append(fragment,count);
+		fragment_append(fragment,(Uint32)data.size());
+		fragment.insert(fragment.end(),data.begin()+start,data.begin()+end);
+		_outgoing.push_back(std::make_shared<const std::vector<std::byte>>(std::move(fragment)));
+	}
+	pump();
+}
+
+/**
+ * Sends queued fragments until the channel has enough buffered.
+ *
+ * The channel stops when its buffered amount is above the low watermark,
+ * so that {@link #onBufferedAmountLow} resumes it. This method must be
+ * called while holding the lock for this channel.
+ */
+void NetcodeChannel::pump() {
+	size_t window = std::max(_lowWater,(size_t)FRAGMENT_WINDOW);
+	while (!_outgoing.empty() && _channel->bufferedAmount() <= window) {
+		emit(*_outgoing.front(),_outgoing.front());
+		_outgoing.pop_front();
+	}
+}
+
+/**
+ * Adds a received fragment to its reassembly buffer.
+ *
+ * If this fragment completes a message, data is replaced by the message and
+ * this method returns true. Otherwise it returns false. This method must be
+ * called while holding the lock for this channel.
+ *
+ * @param data  The received fragment
+ *
+ * @return true if data now holds a complete message
+ */
+bool NetcodeChannel::reassemble(std::vector<std::byte>& data) {
+	if (data.size() < FRAGMENT_HEADER) {
+		CULogError("NETCODE: Truncated fragment from %s",_uuid.c_str());
+		return false;
+	}
+	Uint32 id    = fragment_read<Uint32>(data,1);
+	Uint16 index = fragment_read<Uint16>(data,1+sizeof(Uint32));
+	Uint16 count = fragment_read<Uint16>(data,1+sizeof(Uint32)+sizeof(Uint16));
+	Uint32 size  = fragment_read<Uint32>(data,1+sizeof(Uint32)+2*sizeof(Uint16));
+	if (index >= count || size > FRAGMENT_LIMIT) {
+		CULogError("NETCODE: Invalid fragment from %s",_uuid.c_str());
+		return false;
+	}
+	
+	Reassembly* buffer = nullptr;
+	auto find = _incoming.find(id);
+	if (find == _incoming.end()) {
+		// Fragments lost on an unreliable channel leave stale messages behind
+		if (_incoming.size() >= FRAGMENT_BUFFERS) {
+			auto oldest = _incoming.begin();
+			for(auto it = _incoming.begin(); it != _incoming.end(); ++it) {
+				if ((Sint32)(it->first-oldest->first) < 0) {
+					oldest = it;
+				}
+			}
+			_reassembly->free(oldest->second);
+			_incoming.erase(oldest);
+		}
+		buffer = _reassembly->malloc();
+		buffer->size  = size;
+		buffer->chunk = (size+count-1)/count;
+		buffer->arrived.assign(count,false);
+		buffer->data.resize(size);
+		find = _incoming.emplace(id,buffer).first;
+	} else {
+		buffer = find->second;
+	}
+	
+	size_t start  = index*buffer->chunk;
+	size_t length = data.size()-FRAGMENT_HEADER;
+	size_t expected = start < buffer->size ? std::min(buffer->chunk,buffer->size-start) : 0;
+	if (buffer->size != size || buffer->arrived.size() != count || length != expected) {
+		CULogError("NETCODE: Mismatched fragment from %s",_uuid.c_str());
+		_reassembly->free(buffer);
+		_incoming.erase(find);
+		return false;
+	} else if (buffer->arrived[index]) {
+		return false;
+	}
+	
+	std::memcpy(buffer->data.data()+start,data.data()+FRAGMENT_HEADER,length);
+	buffer->arrived[index] = true;
+	if (++buffer->received < count) {
+		return false;
+	}
+	
+	// Keep the fragment storage in the free list for the next message
+	data.swap(buffer->data);
+	_reassembly->free(buffer);
+	_incoming.erase(find);
+	return true;
+}
+
 #pragma mark -
 #pragma mark Communication
 /**
@@ -322,25 +777,103 @@ bool NetcodeChannel::close()  {
 }
 
 /**
- * Sends data along this data channel to its recipient 
- * 
- * Most users should never need  to access this method. All communication should take 
- * place using the associated {@link NetcodeConnection}. It is provided for debugging
- *  purposes only. 
- *     *
- * @param data  The data to send
+ * Sends data along this data channel, subject to backpressure.
+ *
+ * This is the implementation of both versions of {@link #send}. The data
+ * is only copied if it must be stored (queued or coalesced) and message is
+ * nullptr. Otherwise the channel shares message, which must hold the same
+ * bytes as data.
+ *
+ * @param data      The data to send
+ * @param message   The shared buffer for the data (nullptr for none)
  *
  * @return true if transmission was (apparently) successful
  */
-bool NetcodeChannel::send(const std::vector<std::byte>& data) {
+bool NetcodeChannel::enqueue(const std::vector<std::byte>& data, const NetcodeMessage& message) {
+	if (data.size() > FRAGMENT_LIMIT) {
+		CULogError("NETCODE: Message of %zu bytes is too large to send",data.size());
+		return false;
+	}
+	
 	// Critical section	
 	{
 		std::lock_guard<std::recursive_mutex> lock(_mutex);
 		if (_active) {
-			_channel->send(data);
+			if (_highWater > 0 && (_congested || _channel->bufferedAmount() >= _highWater)) {
+				_congested = true;
+				switch (_policy) {
+					case Backpressure::DROP:
+						return false;
+					case Backpressure::COALESCE:
+						_pending = message != nullptr ? message : std::make_shared<const std::vector<std::byte>>(data);
+						return true;
+					case Backpressure::QUEUE:
+						break;
+				}
+			}
+			transmit(data,message);
+			size_t buffered = _channel->bufferedAmount();
+			_stats->recordBuffered(buffered-_buffered);
+			_buffered = buffered;
 			return true;
 		}
 	}
 	
 	return false;		
 }
+
+/**
+ * Sends data along this data channel to its recipient 
+ * 
+ * Most users should never need  to access this method. All communication should take 
+ * place using the associated {@link NetcodeConnection}. It is provided for debugging
+ *  purposes only. 
+ *
+ * If the channel is congested (see {@link Backpressure}), the message may be
+ * discarded or coalesced according to the channel policy. This method returns
+ * false if the message was discarded.
+ *
+ * Messages larger than the maximum message size of the channel are split into
+ * fragments and reassembled by the recipient.
+ *
+ * @param data  The data to send
+ *
+ * @return true if transmission was (apparently) successful
+ */
+bool NetcodeChannel::send(const std::vector<std::byte>& data) {
+	return enqueue(data,nullptr);
+}
+
+/**
+ * Sends a shared message buffer along this data channel to its recipient
+ *
+ * This method is identical to {@link #send}, except that the message is
+ * never copied by this channel. If the message has to wait (because it
+ * is queued or coalesced), the channel holds a reference to it instead.
+ *
+ * @param message   The message to send
+ *
+ * @return true if transmission was (apparently) successful
+ */
+bool NetcodeChannel::send(const NetcodeMessage& message) {
+	if (message == nullptr) {
+		return false;
+	}
+	return enqueue(*message,message);
+}
+
+/**
+ * Returns the network statistics for this data channel.
+ *
+ * Only the byte, packet, and buffered amounts are meaningful for a data
+ * channel. This method never takes a lock.
+ *
+ * @return the network statistics for this data channel.
+ */
+NetcodeStats NetcodeChannel::getStats() const {
+	NetcodeStats result;
+	if (_stats != nullptr) {
+		_stats->snapshot(result);
+	}
+	return result;
+}
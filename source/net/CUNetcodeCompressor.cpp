@@ -0,0 +1,439 @@
+//
+//  CUNetcodeCompressor.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module is part of a Web RTC implementation of the classic CUGL networking
+//  library. It provides the compression codec used by NetcodeConnection for large
+//  messages, such as state checkpoints and full physics synchronizations.
+//
+//  The codec is a fast LZ77 block compressor in the style of LZ4. It can be
+//  primed with a preset dictionary, so that even mid-size messages compress
+//  well when they share structure with the dictionary. A dictionary is best
+//  trained over samples of typical NetcodeSerializer output.
+//
+//  This class does not QUITE use our standard shared-pointer architecture. A
+//  compressor is immutable once constructed (so it is safe to share across
+//  threads), and so an init method is not necessary. However, we do still
+//  include an alloc method for creating shared pointers.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/net/CUNetcodeCompressor.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace cugl::net;
+
+/** The number of bits in a match table index */
+#define HASH_LOG        12
+/** The number of entries in the match table */
+#define HASH_SIZE       (1 << HASH_LOG)
+/** The minimum length of a match */
+#define MIN_MATCH       4
+/** The number of bytes at the end of a message that are always literals */
+#define LAST_LITERALS   5
+/** The minimum distance from the end of a message to the start of a match */
+#define MATCH_LIMIT     12
+/** The maximum distance of a match (and the maximum useful dictionary size) */
+#define MAX_OFFSET      65535
+/** The number of failed probes before the compressor starts skipping ahead */
+#define SKIP_TRIGGER    6
+/** The size of the byte grams counted when training a dictionary */
+#define TRAIN_GRAM      8
+/** The number of bits in a gram table index */
+#define TRAIN_LOG       16
+/** The size of each segment in a trained dictionary */
+#define TRAIN_SEGMENT   32
+/** The distance between candidate segments in a sample */
+#define TRAIN_STEP      8
+
+#pragma mark -
+#pragma mark Codec Helpers
+/**
+ * Returns the four bytes at the given position as an integer.
+ *
+ * @param src   The position to read
+ *
+ * @return the four bytes at the given position as an integer.
+ */
+static inline Uint32 read32(const std::byte* src) {
+    Uint32 value;
+    std::memcpy(&value,src,sizeof(Uint32));
+    return value;
+}
+
+/**
+ * Returns the match table index for the given four bytes.
+ *
+ * @param value The four bytes to hash
+ *
+ * @return the match table index for the given four bytes.
+ */
+static inline Uint32 hash32(Uint32 value) {
+    return (value*2654435761U) >> (32-HASH_LOG);
+}
+
+/**
+ * Returns the gram table index for the gram at the given position.
+ *
+ * @param src   The position of the gram
+ *
+ * @return the gram table index for the gram at the given position.
+ */
+static inline Uint32 gram_hash(const std::byte* src) {
+    Uint64 value;
+    std::memcpy(&value,src,sizeof(Uint64));
+    return (Uint32)((value*0x9E3779B97F4A7C15ULL) >> (64-TRAIN_LOG));
+}
+
+/**
+ * Appends the extension bytes of a long length.
+ *
+ * @param dst   The buffer to append to
+ * @param value The length beyond the 15 stored in the token
+ */
+static void write_length(std::vector<std::byte>& dst, size_t value) {
+    while (value >= 255) {
+        dst.push_back(std::byte{255});
+        value -= 255;
+    }
+    dst.push_back((std::byte)value);
+}
+
+/**
+ * Reads the extension bytes of a long length.
+ *
+ * @param data  The compressed data
+ * @param size  The size of the compressed data
+ * @param pos   The read position (updated by this function)
+ * @param value The length to add to
+ *
+ * @return false if the data ended in the middle of the length
+ */
+static bool read_length(const std::byte* data, size_t size, size_t& pos, size_t& value) {
+    Uint8 next;
+    do {
+        if (pos >= size) {
+            return false;
+        }
+        next = (Uint8)data[pos++];
+        value += next;
+    } while (next == 255);
+    return true;
+}
+
+/**
+ * Appends a single sequence to the compressed data.
+ *
+ * A sequence is a run of literals followed by a match. The final sequence of
+ * a message has no match, which is indicated by a length of 0.
+ *
+ * @param dst       The buffer to append to
+ * @param literals  The literal bytes
+ * @param count     The number of literal bytes
+ * @param offset    The distance of the match
+ * @param length    The length of the match (0 for none)
+ */
+static void write_sequence(std::vector<std::byte>& dst, const std::byte* literals, size_t count,
+                           size_t offset, size_t length) {
+    size_t match = length ? length-MIN_MATCH : 0;
+    Uint8 token = (Uint8)((std::min(count,(size_t)15) << 4) | std::min(match,(size_t)15));
+    dst.push_back((std::byte)token);
+    if (count >= 15) {
+        write_length(dst,count-15);
+    }
+    dst.insert(dst.end(),literals,literals+count);
+    if (length) {
+        dst.push_back((std::byte)(offset & 0xFF));
+        dst.push_back((std::byte)(offset >> 8));
+        if (match >= 15) {
+            write_length(dst,match-15);
+        }
+    }
+}
+
+/** A candidate segment when training a dictionary */
+typedef struct {
+    /** The number of samples sharing the grams of this segment */
+    Uint64 score;
+    /** The sample containing this segment */
+    size_t sample;
+    /** The position of this segment in the sample */
+    size_t offset;
+} TrainSegment;
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates a new compressor with the given preset dictionary.
+ *
+ * Only the last 64 KB of the dictionary can be reached by a match, so any
+ * bytes before that are ignored. An empty dictionary means no dictionary.
+ *
+ * @param dictionary    The preset dictionary
+ */
+NetcodeCompressor::NetcodeCompressor(const std::vector<std::byte>& dictionary) :
+    _hash(0) {
+    size_t start = dictionary.size() > MAX_OFFSET ? dictionary.size()-MAX_OFFSET : 0;
+    _dictionary.assign(dictionary.begin()+start,dictionary.end());
+    _table.assign(HASH_SIZE,0);
+    if (_dictionary.empty()) {
+        return;
+    }
+
+    // FNV-1a, reserving 0 for no dictionary
+    _hash = 2166136261U;
+    for(auto it = _dictionary.begin(); it != _dictionary.end(); ++it) {
+        _hash = (_hash ^ (Uint8)(*it))*16777619U;
+    }
+    _hash = _hash == 0 ? 1 : _hash;
+
+    // Prime the match table
+    for(size_t ii = 0; ii+MIN_MATCH <= _dictionary.size(); ii++) {
+        _table[hash32(read32(_dictionary.data()+ii))] = (Uint32)(ii+1);
+    }
+}
+
+#pragma mark -
+#pragma mark Compression
+/**
+ * Compresses the given data, appending it to the end of dst.
+ *
+ * If the data would not get strictly smaller, this method returns false and
+ * dst may be left with partial output. The caller should then truncate dst
+ * and send the data as is. The original size is not part of the output, and
+ * must be stored separately for {@link #decompress}.
+ *
+ * @param data          The data to compress
+ * @param size          The number of bytes to compress
+ * @param dst           The buffer to append to
+ * @param dictionary    Whether to use the preset dictionary
+ *
+ * @return true if the data was compressed
+ */
+bool NetcodeCompressor::compress(const std::byte* data, size_t size, std::vector<std::byte>& dst,
+                                 bool dictionary) const {
+    dictionary = dictionary && !_dictionary.empty();
+    size_t base = dictionary ? _dictionary.size() : 0;
+
+    // Match the message as if it followed the dictionary
+    std::vector<std::byte> window;
+    std::vector<Uint32> table;
+    const std::byte* src = data;
+    if (dictionary) {
+        window.reserve(base+size);
+        window.insert(window.end(),_dictionary.begin(),_dictionary.end());
+        window.insert(window.end(),data,data+size);
+        src = window.data();
+        table = _table;
+    } else {
+        table.assign(HASH_SIZE,0);
+    }
+
+    size_t start  = dst.size();
+    size_t end    = base+size;
+    size_t anchor = base;
+    size_t ip = base;
+    dst.reserve(start+size);
+    if (size > MATCH_LIMIT) {
+        size_t limit  = end-MATCH_LIMIT;
+        size_t misses = 0;
+        while (ip < limit) {
+            Uint32 value = read32(src+ip);
+            Uint32 hash  = hash32(value);
+            size_t ref = table[hash];
+            table[hash] = (Uint32)(ip+1);
+            if (ref == 0 || ip-(ref-1) > MAX_OFFSET || read32(src+ref-1) != value) {
+                // Incompressible data is skipped over faster and faster
+                ip += 1+(misses++ >> SKIP_TRIGGER);
+                continue;
+            }
+            ref--;
+            misses = 0;
+
+            // Extend the match in both directions
+            while (ip > anchor && ref > 0 && src[ip-1] == src[ref-1]) {
+                ip--;
+                ref--;
+            }
+            size_t length = MIN_MATCH;
+            while (ip+length < end-LAST_LITERALS && src[ref+length] == src[ip+length]) {
+                length++;
+            }
+
+            write_sequence(dst,src+anchor,ip-anchor,ip-ref,length);
+            ip += length;
+            anchor = ip;
+            if (dst.size()-start >= size) {
+                return false;
+            }
+        }
+    }
+
+    write_sequence(dst,src+anchor,end-anchor,0,0);
+    return dst.size()-start < size;
+}
+
+/**
+ * Decompresses the given data, appending it to the end of dst.
+ *
+ * The original size must be the size of the data before compression. This
+ * method returns false if the data is malformed or does not decompress to
+ * exactly that size. In that case dst may be left with partial output.
+ *
+ * @param data          The data to decompress
+ * @param size          The number of bytes to decompress
+ * @param original      The size of the data before compression
+ * @param dst           The buffer to append to
+ * @param dictionary    Whether the data was compressed with the preset dictionary
+ *
+ * @return true if the data was decompressed
+ */
+bool NetcodeCompressor::decompress(const std::byte* data, size_t size, size_t original,
+                                   std::vector<std::byte>& dst, bool dictionary) const {
+    if (dictionary && _dictionary.empty()) {
+        return false;
+    }
+
+    size_t base  = dictionary ? _dictionary.size() : 0;
+    size_t start = dst.size();
+    size_t pos = 0;
+    dst.reserve(start+original);
+    while (pos < size) {
+        Uint8 token  = (Uint8)data[pos++];
+        size_t count = token >> 4;
+        if (count == 15 && !read_length(data,size,pos,count)) {
+            return false;
+        } else if (count > size-pos || count > original-(dst.size()-start)) {
+            return false;
+        }
+        dst.insert(dst.end(),data+pos,data+pos+count);
+        pos += count;
+
+        // The final sequence has no match
+        if (pos == size) {
+            break;
+        } else if (size-pos < 2) {
+            return false;
+        }
+        size_t offset = (size_t)data[pos] | ((size_t)data[pos+1] << 8);
+        pos += 2;
+        size_t length = token & 0x0F;
+        if (length == 15 && !read_length(data,size,pos,length)) {
+            return false;
+        }
+        length += MIN_MATCH;
+
+        size_t produced = dst.size()-start;
+        if (offset == 0 || offset > produced+base || length > original-produced) {
+            return false;
+        }
+        for(size_t ii = 0; ii < length; ii++, produced++) {
+            std::byte next = offset > produced ? _dictionary[base-(offset-produced)]
+                                               : dst[start+produced-offset];
+            dst.push_back(next);
+        }
+    }
+    return dst.size()-start == original;
+}
+
+/**
+ * Returns a preset dictionary trained on the given samples.
+ *
+ * The samples should be typical messages, such as the output of a
+ * {@link NetcodeSerializer} for a handful of game states. The dictionary
+ * is assembled from the byte segments that occur in the most samples, with
+ * the most common ones last (closest to the message). It is at most the
+ * given capacity, which cannot exceed 64 KB.
+ *
+ * @param samples   The sample messages
+ * @param capacity  The maximum size of the dictionary
+ *
+ * @return a preset dictionary trained on the given samples.
+ */
+std::vector<std::byte> NetcodeCompressor::train(const std::vector<std::vector<std::byte>>& samples,
+                                                size_t capacity) {
+    capacity = std::min(capacity,(size_t)MAX_OFFSET);
+
+    // Count the number of samples containing each gram
+    std::vector<Uint32> counts(1 << TRAIN_LOG,0);
+    std::vector<Uint32> seen(1 << TRAIN_LOG,0);
+    for(size_t ii = 0; ii < samples.size(); ii++) {
+        const std::vector<std::byte>& sample = samples[ii];
+        for(size_t jj = 0; jj+TRAIN_GRAM <= sample.size(); jj++) {
+            Uint32 hash = gram_hash(sample.data()+jj);
+            if (seen[hash] != ii+1) {
+                seen[hash] = (Uint32)(ii+1);
+                counts[hash]++;
+            }
+        }
+    }
+
+    // Score the segments by the grams shared with other samples
+    std::vector<TrainSegment> segments;
+    for(size_t ii = 0; ii < samples.size(); ii++) {
+        const std::vector<std::byte>& sample = samples[ii];
+        for(size_t jj = 0; jj+TRAIN_SEGMENT <= sample.size(); jj += TRAIN_STEP) {
+            Uint64 score = 0;
+            for(size_t kk = 0; kk+TRAIN_GRAM <= TRAIN_SEGMENT; kk++) {
+                Uint32 count = counts[gram_hash(sample.data()+jj+kk)];
+                score += count > 1 ? count : 0;
+            }
+            if (score > 0) {
+                segments.push_back({score,ii,jj});
+            }
+        }
+    }
+    std::stable_sort(segments.begin(),segments.end(),[](const TrainSegment& a, const TrainSegment& b) {
+        return a.score > b.score;
+    });
+
+    // Pick the best segments, skipping those already covered
+    std::vector<const TrainSegment*> chosen;
+    size_t total = 0;
+    for(auto it = segments.begin(); it != segments.end() && total+TRAIN_SEGMENT <= capacity; ++it) {
+        const std::byte* bytes = samples[it->sample].data()+it->offset;
+        Uint64 score = 0;
+        for(size_t kk = 0; kk+TRAIN_GRAM <= TRAIN_SEGMENT; kk++) {
+            Uint32 count = counts[gram_hash(bytes+kk)];
+            score += count > 1 ? count : 0;
+        }
+        if (2*score < it->score) {
+            continue;
+        }
+        for(size_t kk = 0; kk+TRAIN_GRAM <= TRAIN_SEGMENT; kk++) {
+            counts[gram_hash(bytes+kk)] = 0;
+        }
+        chosen.push_back(&(*it));
+        total += TRAIN_SEGMENT;
+    }
+
+    // The most common segments go last, where matches are closest
+    std::vector<std::byte> result;
+    result.reserve(total);
+    for(auto it = chosen.rbegin(); it != chosen.rend(); ++it) {
+        const std::byte* bytes = samples[(*it)->sample].data()+(*it)->offset;
+        result.insert(result.end(),bytes,bytes+TRAIN_SEGMENT);
+    }
+    return result;
+}
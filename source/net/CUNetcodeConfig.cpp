@@ -54,7 +54,10 @@ NetcodeConfig::NetcodeConfig() {
     portRangeEnd = 65535;
     mtu = 0;
 	maxMessage = 0;
+	maxRelays = 0;
 	maxPlayers = 2;
+	topology = Topology::MESH;
+	spectator = false;
 	apiVersion = 0;
 }
 
@@ -71,7 +74,10 @@ NetcodeConfig::NetcodeConfig(const InetAddress& lobby) {
     portRangeEnd = 65535;
     mtu = 0;
 	maxMessage = 0;
+	maxRelays = 0;
 	maxPlayers = 2;
+	topology = Topology::MESH;
+	spectator = false;
 	apiVersion = 0;
 }
 
@@ -89,7 +95,10 @@ NetcodeConfig::NetcodeConfig(const InetAddress& lobby, const ICEAddress& iceServ
     portRangeEnd = 65535;
     mtu = 0;
 	maxMessage = 0;
+	maxRelays = 0;
 	maxPlayers = 2;
+	topology = Topology::MESH;
+	spectator = false;
 	apiVersion = 0;
 }
 
@@ -102,11 +111,14 @@ NetcodeConfig::NetcodeConfig(const InetAddress& lobby, const ICEAddress& iceServ
  *
  *      "secure":       A boolean indicating if the lobby uses SSL
  *      "ICE servers":  A list of {@link ICEAddress} JSONs
+ *      "max relays":   An int representing the maximum number of TURN servers
  *      "multiplex":    A boolean specifying whether to use UDP multiplexing
  *      "port range":   A list pair of the ports to scan
  *      "MTU":          An int representing the maximum transmission unit
  *      "max message":  An int respresenting the maximum transmission size
  *      "max players":  An int respresenting the maximum number of players
+ *      "topology":     Either "mesh" or "star"
+ *      "spectator":    A boolean indicating if this connection only watches
  *      "API version":  An int respresenting the API version
  *
  * @param pref      The configuration settings
@@ -133,7 +145,10 @@ NetcodeConfig::NetcodeConfig(const std::shared_ptr<JsonValue>& prefs) {
 	}
     mtu = prefs->getInt("MTU",0);
 	maxMessage = prefs->getInt("max message",0);
+	maxRelays = prefs->getInt("max relays",0);
 	maxPlayers = prefs->getInt("max players",2);
+	topology = (prefs->getString("topology","mesh") == "star" ? Topology::STAR : Topology::MESH);
+	spectator = prefs->getBool("spectator",false);
 	apiVersion = prefs->getInt("API version",0);
 }
 
@@ -160,7 +175,10 @@ NetcodeConfig& NetcodeConfig::set(const NetcodeConfig& src) {
     portRangeEnd = src.portRangeEnd;
     mtu = src.mtu;
 	maxMessage = src.maxMessage;
+	maxRelays = src.maxRelays;
 	maxPlayers = src.maxPlayers;
+	topology = src.topology;
+	spectator = src.spectator;
 	apiVersion = src.apiVersion;
 	return *this;
 }
@@ -180,7 +198,10 @@ NetcodeConfig& NetcodeConfig::set(const std::shared_ptr<NetcodeConfig>& src) {
     portRangeEnd = src->portRangeEnd;
     mtu = src->mtu;
 	maxMessage = src->maxMessage;
+	maxRelays = src->maxRelays;
 	maxPlayers = src->maxPlayers;
+	topology = src->topology;
+	spectator = src->spectator;
 	apiVersion = src->apiVersion;
 	return *this;
 }
@@ -193,11 +214,14 @@ NetcodeConfig& NetcodeConfig::set(const std::shared_ptr<NetcodeConfig>& src) {
  *
  *      "secure":       A boolean indicating if the lobby uses SSL
  *      "ICE servers":  A list of {@link ICEAddress} JSONs
+ *      "max relays":   An int representing the maximum number of TURN servers
  *      "multiplex":    A boolean specifying whether to use UDP multiplexing
  *      "port range":   A list pair of the ports to scan
  *      "MTU":          An int representing the maximum transmission unit
  *      "max message":  An int respresenting the maximum transmission size
  *      "max players":  An int respresenting the maximum number of players
+ *      "topology":     Either "mesh" or "star"
+ *      "spectator":    A boolean indicating if this connection only watches
  *      "API version":  An int respresenting the API version
  *
  * @param pref      The address settings
@@ -227,7 +251,10 @@ NetcodeConfig& NetcodeConfig::set(const std::shared_ptr<JsonValue>& prefs) {
 	}
     mtu = prefs->getInt("MTU",0);
 	maxMessage = prefs->getInt("max message",0);
+	maxRelays = prefs->getInt("max relays",0);
 	maxPlayers = prefs->getInt("max players",2);
+	topology = (prefs->getString("topology","mesh") == "star" ? Topology::STAR : Topology::MESH);
+	spectator = prefs->getBool("spectator",false);
 	apiVersion = prefs->getInt("API version",0);
 	return *this;
 }
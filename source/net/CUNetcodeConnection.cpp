@@ -60,13 +60,16 @@
 #include <cugl/net/CUNetcodeChannel.h>
 #include <cugl/net/CUNetcodeConnection.h>
 #include <cugl/net/CUNetcodePeer.h>
+#include <cugl/net/CUNetcodeVoice.h>
 #include <cugl/net/CUNetworkLayer.h>
 #include <cugl/assets/CUJsonValue.h>
 #include <cugl/base/CUApplication.h>
+#include <cugl/base/CUEndian.h>
 #include <cugl/util/CUDebug.h>
 #include <stduuid/uuid.h>
 #include <stdexcept>
 #include <algorithm>
+#include <iterator>
 #include <random>
 #include <cstring>
 
@@ -76,6 +79,175 @@ using namespace rtc;
 
 /** The buffer size for message envelopes */
 #define DEFAULT_BUFFER 32
+/** The MTU to assume for batching if the configuration does not specify one */
+#define DEFAULT_MTU    1200
+/** The space reserved in each batched datagram for DTLS/SCTP/UDP headers */
+#define BATCH_HEADROOM 64
+/** The default buffered amount at which a data channel is congested */
+#define DEFAULT_HIGH_WATER  262144
+/** The default buffered amount at which a data channel is no longer congested */
+#define DEFAULT_LOW_WATER   65536
+/** The first byte of a batched datagram */
+#define BATCH_MARKER   std::byte{0xFF}
+/** The size of the length prefix for each message in a batched datagram */
+#define BATCH_PREFIX   sizeof(Uint32)
+/** The first byte of a compression frame */
+#define COMPRESS_MARKER std::byte{0xFE}
+/** A compression frame holding an (escaped) uncompressed message */
+#define COMPRESS_RAW    0
+/** A compression frame holding a message compressed without a dictionary */
+#define COMPRESS_PLAIN  1
+/** A compression frame holding a message compressed with the dictionary */
+#define COMPRESS_DICT   2
+/** A compression frame announcing the dictionary of the sender */
+#define COMPRESS_HELLO  3
+/** A compression frame announcing that the sender is a spectator (sent to the host) */
+#define COMPRESS_SPECTATOR 4
+/** The size of a compressed frame header (marker, type, size, and dictionary hash) */
+#define COMPRESS_HEADER (2+2*sizeof(Uint32))
+/** The largest decompressed message (the same as the largest fragmented message) */
+#define COMPRESS_LIMIT  (1 << 24)
+/** The first byte of a relay frame (star topology only) */
+#define RELAY_MARKER    std::byte{0xFD}
+/** A relay frame holding an (escaped) message from the sender itself */
+#define RELAY_DIRECT    0
+/** A relay frame asking the host to forward a message to the given player */
+#define RELAY_UNICAST   1
+/** A relay frame asking the host to forward a message to every other player */
+#define RELAY_BROADCAST 2
+/** A relay frame holding a message forwarded by the host from the given player */
+#define RELAY_FORWARD   3
+/** A relay frame announcing that the given player is a spectator (host only) */
+#define RELAY_SPECTATOR 4
+/** The size of a relay frame header (marker, type, and UUID length) */
+#define RELAY_HEADER    3
+
+/**
+ * Appends a message to a batched datagram
+ *
+ * If the datagram is empty, this function will add the batch marker first.
+ *
+ * @param batch The batched datagram
+ * @param data  The message to append
+ */
+static void batch_append(std::vector<std::byte>& batch, const std::vector<std::byte>& data) {
+    if (batch.empty()) {
+        batch.push_back(BATCH_MARKER);
+    }
+    Uint32 length = cugl::marshall((Uint32)data.size());
+    const std::byte* bytes = reinterpret_cast<const std::byte*>(&length);
+    batch.insert(batch.end(), bytes, bytes+BATCH_PREFIX);
+    batch.insert(batch.end(), data.begin(), data.end());
+}
+
+/**
+ * Sends a single (unbatched) message along the given channel.
+ *
+ * If the message begins with the batch marker, it is sent as a batch of one
+ * message. That way the receiver never confuses it with a batched datagram.
+ *
+ * If message is not nullptr, it must hold the same bytes as data. It is then
+ * shared with the channel, so that data is never copied.
+ *
+ * @param channel   The data channel
+ * @param data      The message to send
+ * @param message   The shared buffer for the message (nullptr for none)
+ *
+ * @return true if transmission was (apparently) successful
+ */
+static bool send_single(const std::shared_ptr<NetcodeChannel>& channel, const std::vector<std::byte>& data,
+                        const NetcodeMessage& message) {
+    if (!data.empty() && data[0] == BATCH_MARKER) {
+        std::vector<std::byte> batch;
+        batch.reserve(data.size()+BATCH_PREFIX+1);
+        batch_append(batch,data);
+        return channel->send(batch);
+    }
+    return message != nullptr ? channel->send(message) : channel->send(data);
+}
+
+/**
+ * Returns a compression frame announcing the given dictionary.
+ *
+ * @param hash  The hash of the dictionary (0 for none)
+ *
+ * @return a compression frame announcing the given dictionary.
+ */
+static std::vector<std::byte> compress_hello(Uint32 hash) {
+    std::vector<std::byte> frame;
+    frame.reserve(2+sizeof(Uint32));
+    frame.push_back(COMPRESS_MARKER);
+    frame.push_back((std::byte)COMPRESS_HELLO);
+    hash = cugl::marshall(hash);
+    const std::byte* bytes = reinterpret_cast<const std::byte*>(&hash);
+    frame.insert(frame.end(), bytes, bytes+sizeof(Uint32));
+    return frame;
+}
+
+/**
+ * Returns a relay frame wrapping the given message.
+ *
+ * A relay frame is the relay marker, the frame type, and the length of the
+ * UUID, followed by the UUID and the message. For a broadcast, the UUID is
+ * that of the sender. It is a placeholder, so that the host can replace it
+ * with the verified source without moving the message.
+ *
+ * @param type  The relay frame type
+ * @param uuid  The UUID of the destination or source
+ * @param data  The message to wrap
+ *
+ * @return a relay frame wrapping the given message.
+ */
+static NetcodeMessage relay_frame(Uint8 type, const std::string& uuid, const std::vector<std::byte>& data) {
+    std::vector<std::byte> frame;
+    frame.reserve(RELAY_HEADER+uuid.size()+data.size());
+    frame.push_back(RELAY_MARKER);
+    frame.push_back((std::byte)type);
+    frame.push_back((std::byte)uuid.size());
+    const std::byte* bytes = reinterpret_cast<const std::byte*>(uuid.data());
+    frame.insert(frame.end(), bytes, bytes+uuid.size());
+    frame.insert(frame.end(), data.begin(), data.end());
+    return std::make_shared<const std::vector<std::byte>>(std::move(frame));
+}
+
+/**
+ * Rewrites the header of a relay frame in place.
+ *
+ * The message is only moved if the new UUID has a different length. As all
+ * UUIDs generated by {@link NetcodeConnection} have the same length, a host
+ * can forward a frame without copying it.
+ *
+ * @param frame The relay frame
+ * @param type  The new relay frame type
+ * @param uuid  The new UUID of the destination or source
+ */
+static void relay_rewrite(std::vector<std::byte>& frame, Uint8 type, const std::string& uuid) {
+    size_t length = (size_t)frame[2];
+    if (length != uuid.size()) {
+        frame.erase(frame.begin()+RELAY_HEADER, frame.begin()+RELAY_HEADER+length);
+        frame.insert(frame.begin()+RELAY_HEADER, uuid.size(), std::byte{0});
+        frame[2] = (std::byte)uuid.size();
+    }
+    frame[1] = (std::byte)type;
+    std::memcpy(frame.data()+RELAY_HEADER, uuid.data(), uuid.size());
+}
+
+/**
+ * Removes every spectator that is no longer a player.
+ *
+ * @param spectators    The spectators to prune
+ * @param players       The active players
+ */
+static void prune_spectators(std::unordered_set<std::string>& spectators,
+                             const std::unordered_set<std::string>& players) {
+    for(auto it = spectators.begin(); it != spectators.end(); ) {
+        if (players.find(*it) == players.end()) {
+            it = spectators.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
 
 /**
  * Copies information from a CUGL configuration to an RTC configuration
@@ -133,14 +305,34 @@ NetcodeConnection::NetcodeConnection() :
 	_ishost(false), 
 	_initialPlayers(0),
 	_migration(0),
-	_buffsize(0),
-	_buffhead(0),
-	_bufftail(0),
+	_hasReceipt(false),
+	_stats(std::make_shared<NetcodeCounters>()),
+	_messagesSent(0),
+	_messagesReceived(0),
+	_batching(false),
+	_bandwidth(0),
+	_deficit(0),
+	_compression(0),
+	_compressor(NetcodeCompressor::alloc()),
 	_debug(false),
 	_open(false),
 	_active(false),
 	_state(State::INACTIVE),
-	_previous(State::INACTIVE) {}
+	_previous(State::INACTIVE),
+	_selfHandle(NETCODE_NO_HANDLE) {
+	_names.push_back(std::make_shared<const std::string>());
+	publish();
+	for(int lane = 0; lane < 2; lane++) {
+		_highWater[lane] = DEFAULT_HIGH_WATER;
+		_lowWater[lane]  = DEFAULT_LOW_WATER;
+	}
+	for(int lane = 0; lane < 3; lane++) {
+		_laneBudget[lane] = 0;
+		_laneDepth[lane]  = 0;
+	}
+	_backpressure[(int)Lane::RELIABLE]   = NetcodeChannel::Backpressure::QUEUE;
+	_backpressure[(int)Lane::UNRELIABLE] = NetcodeChannel::Backpressure::COALESCE;
+}
 
 /**
  * Deletes this websocket connection, disposing all resources
@@ -165,6 +357,8 @@ void NetcodeConnection::dispose() {
 
 	// Critical section (clear peers first)
 	std::unordered_map<std::string, std::shared_ptr<NetcodePeer>> peers;
+	std::shared_ptr<const Roster> roster;
+	std::shared_ptr<NetcodePeer> spare;
 	{
 		std::lock_guard<std::recursive_mutex> lock(_mutex);
 		if (_active && !_peers.empty()) {
@@ -172,9 +366,18 @@ void NetcodeConnection::dispose() {
 			// Copy it to invoke GC outside of lock
 			peers = _peers;
 			_peers.clear();
+			roster = publish();
 		}
+		spare = _spare;
+		_spare = nullptr;
+		_codecs.clear();
 	}
+	std::atomic_store(&_recorder,std::shared_ptr<NetcodeRecorder>());
+	std::atomic_store(&_simulator,std::shared_ptr<NetcodeSimulator>());
+	std::atomic_store(&_voice,std::shared_ptr<NetcodeVoice>());
 	peers.clear();
+	roster = nullptr;
+	spare = nullptr;
 
 	// Critical section (shutdown socket)
 	{
@@ -190,8 +393,16 @@ void NetcodeConnection::dispose() {
 			_room = "";
 			_ishost = false;
 			
-			_buffer.clear();
+			_inbound.clear();
+			_batches[0].clear();
+			_batches[1].clear();
+			for(int lane = 0; lane < 3; lane++) {
+				_queues[lane].clear();
+			}
+			_deficit = 0;
 			_players.clear();
+			_spectators.clear();
+			publish();
 			_rtcconfig.iceServers.clear();
 			
 			// Leave other settings for debugging
@@ -225,11 +436,14 @@ bool NetcodeConnection::init(const NetcodeConfig& config) {
 		
 		_config = config;
 		config2rtc(_config,_rtcconfig);
+		NetworkLayer::get()->prewarm(_config.iceServers);
 	
 		// Get the UUID 
         _uuid = genuuid();
 		_ishost = true;
 		_host = _uuid;
+		publish();
+		_selfHandle = intern(_uuid);
 		
 		return true;
 	} catch (const std::exception &e) {
@@ -270,11 +484,13 @@ bool NetcodeConnection::init(const NetcodeConfig& config, const std::string room
 		
 		_config = config;
 		config2rtc(_config,_rtcconfig);
+		NetworkLayer::get()->prewarm(_config.iceServers);
 	
 		// Get the UUID 
         _uuid = genuuid();
 		_ishost = false;
 		_room = room;
+		_selfHandle = intern(_uuid);
 		
 		return true;
 	} catch (const std::exception &e) {
@@ -347,7 +563,7 @@ void NetcodeConnection::onMessage(message_variant data) {
 	std:string value = std::get<std::string>(data);
 	auto json = cugl::JsonValue::allocWithJson(value);
 	if (_debug) {
-		CULog("NETCODE: Received '%s'",value.c_str());
+		CULogCategory(CU_LOG_CATEGORY_NETCODE,"NETCODE: Received '%s'",value.c_str());
 	}
 
 	if (json != NULL) {
@@ -378,13 +594,13 @@ void NetcodeConnection::onMessage(message_variant data) {
 			}
 			
 			if (callback) {
-                Application::get()->schedule(callback);
+                deliver(callback);
 			}
 		} else {
 			handleSignal(json);
 		}
 	} else if (_debug) {
-		CULog("NETCODE: Invalid message '%s'",value.c_str());
+		CULogCategory(CU_LOG_CATEGORY_NETCODE,"NETCODE: Invalid message '%s'",value.c_str());
 	}
 }
 
@@ -395,9 +611,24 @@ void NetcodeConnection::onMessage(message_variant data) {
  */
 void NetcodeConnection::onPeerEstablished(const std::string uuid) {
  	std::function<bool()> callback;
+    std::shared_ptr<NetcodeChannel> channel;
+    Uint32 dictionary = 0;
+    bool spectate = false;
+    std::vector<std::string> spectators;
     // Critical section
     {
 		std::lock_guard<std::recursive_mutex> lock(_mutex);
+        auto find = _peers.find(uuid);
+        if (find != _peers.end()) {
+            // Locking downwards is allowed
+            channel = getLaneChannel(find->second,Lane::RELIABLE);
+            dictionary = _compressor->getDictionaryHash();
+        }
+        // A spectator tells each new host, and a star host tells each new client
+        spectate = _config.spectator && uuid == _host;
+        if (_ishost && isStar()) {
+            spectators.assign(_spectators.begin(),_spectators.end());
+        }
     	if (_state != State::MIGRATING) {
 			if (uuid == _host)	{
 				_previous = _state;
@@ -411,6 +642,7 @@ void NetcodeConnection::onPeerEstablished(const std::string uuid) {
 			} else {
                 // Incoming sibling player
                 _players.emplace(uuid);
+                publish();
                 if (_onConnect) {
                     callback = [=]() {
                         _onConnect(uuid);
@@ -425,15 +657,26 @@ void NetcodeConnection::onPeerEstablished(const std::string uuid) {
 			response->appendValue("type",std::string("lobby"));
 			response->appendValue("category",std::string("promotion"));
 			response->appendValue("status",std::string("complete"));
-			_socket->send(response->toString());
+			_socket->send(response->toString(false));
 			_migration = 0;
 		} else if (_migration > 1) {
 			_migration--;
 		}
 	}
 
+    // Announce that we accept compressed messages
+    if (channel != nullptr) {
+        channel->send(compress_hello(dictionary));
+        if (spectate) {
+            std::vector<std::byte> frame = { COMPRESS_MARKER, (std::byte)COMPRESS_SPECTATOR };
+            channel->send(frame);
+        }
+        for(auto it = spectators.begin(); it != spectators.end(); ++it) {
+            channel->send(*relay_frame(RELAY_SPECTATOR,*it,std::vector<std::byte>()));
+        }
+    }
 	if (callback) {
-        Application::get()->schedule(callback);
+        deliver(callback);
 	}
 }
 
@@ -451,12 +694,144 @@ void NetcodeConnection::onPeerClosed(std::string id) {
                 CULog("NETCODE: WebSocket %s cleaned-up peer connection %s",_uuid.c_str(),id.c_str());
             }
             _peers.erase(id);
+            _codecs.erase(id);
+            publish();
+        }
+    }
+}
+
+/**
+ * Delivers the given user callback to the thread owning this connection.
+ *
+ * If there is no scheduler, the callback is scheduled with the running
+ * {@link Application}.
+ *
+ * @param callback  The callback to deliver
+ */
+void NetcodeConnection::deliver(std::function<bool()> callback) {
+    if (_scheduler) {
+        _scheduler(std::move(callback));
+    } else {
+        Application::get()->schedule(std::move(callback));
+    }
+}
+
+/**
+ * Publishes a new snapshot of the peers, players and host.
+ *
+ * This method must be called (while holding the lock for this connection)
+ * after any change to these values. It returns the previous snapshot, so
+ * that the caller may release it outside of the lock.
+ *
+ * @return the previous snapshot
+ */
+std::shared_ptr<const NetcodeConnection::Roster> NetcodeConnection::publish() {
+    auto roster = std::make_shared<Roster>();
+    roster->peers = _peers;
+    roster->players = _players;
+    roster->spectators = _spectators;
+    roster->host = _host;
+    roster->names = _names;
+    roster->handles = _handles;
+    return std::atomic_exchange(&_roster,std::shared_ptr<const Roster>(roster));
+}
+
+/**
+ * Returns the peer handle for the given UUID, assigning one if necessary.
+ *
+ * If the UUID already has a handle, this method does not lock. Otherwise,
+ * it locks this connection to assign the next handle, and publishes a new
+ * snapshot. So this method must never be called while holding the lock of
+ * a peer or a channel (locking downwards).
+ *
+ * @param uuid  The peer UUID
+ *
+ * @return the peer handle for the given UUID
+ */
+NetcodeConnection::PeerHandle NetcodeConnection::intern(const std::string& uuid) {
+    {
+        auto roster = getRoster();
+        auto it = roster->handles.find(uuid);
+        if (it != roster->handles.end()) {
+            return it->second;
         }
     }
+    
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    auto it = _handles.find(uuid);
+    if (it != _handles.end()) {
+        // Another thread got here first
+        return it->second;
+    }
+    PeerHandle handle = (PeerHandle)_names.size();
+    _names.push_back(std::make_shared<const std::string>(uuid));
+    _handles.emplace(uuid,handle);
+    publish();
+    return handle;
 }
 
 #pragma mark -
 #pragma mark Internal Communication
+/**
+ * Creates a spare peer connection for the next peer.
+ *
+ * Creating a peer connection is expensive (it generates a certificate),
+ * and ICE gathering takes a while on a mobile network. A spare connection
+ * gets this out of the way while the lobby is still negotiating. On a
+ * client, the spare is offered, so that ICE gathering starts right away.
+ * On the host, the spare is used to answer the next incoming offer.
+ */
+void NetcodeConnection::prewarm() {
+	bool offered = !_ishost;
+	try {
+		// DO NOT HOLD LOCK HERE
+		std::shared_ptr<NetcodePeer> peer = NetcodePeer::alloc(shared_from_this(),"",offered);
+		if (peer == nullptr) {
+			return;
+		} else if (offered) {
+			// Creating the channel starts the offer (and ICE gathering)
+			peer->createChannel(NETCODE_RELIABLE_CHANNEL);
+		}
+		
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		if (_active && _spare == nullptr) {
+			_spare = peer;
+		}
+	} catch (const std::exception &e) {
+		CULogError("NETCODE ERROR: %s", e.what());
+	}
+}
+
+/**
+ * Returns the spare peer connection, assigned to the given UUID.
+ *
+ * This method returns nullptr if there is no spare connection, or if it
+ * was prepared for the other role (offered versus received).
+ *
+ * @param uuid      The UUID of the peer
+ * @param offered   Whether the connection is offered (not received)
+ *
+ * @return the spare peer connection, assigned to the given UUID.
+ */
+std::shared_ptr<NetcodePeer> NetcodeConnection::claimSpare(const std::string uuid, bool offered) {
+	std::shared_ptr<NetcodePeer> peer;
+	{
+		// Critical section
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		if (!_active || _spare == nullptr || _spare->_offered != offered || !_spare->_active) {
+			return nullptr;
+		}
+		peer = _spare;
+		_spare = nullptr;
+		_peers.emplace(uuid,peer);
+		publish();
+	}
+	
+	// NEVER hold the lock when assigning (it sends signals)
+	peer->assign(uuid);
+	return peer;
+}
+
 /**
  * Offers a peer connection to the host with the given UUID
  *
@@ -468,6 +843,11 @@ void NetcodeConnection::onPeerClosed(std::string id) {
  */
 bool NetcodeConnection::offerPeer(const std::string uuid) {
 	try {
+		// The spare already started its offer
+		if (claimSpare(uuid,true) != nullptr) {
+			return true;
+		}
+		
 		std::shared_ptr<NetcodePeer> peer = NetcodePeer::alloc(shared_from_this(),uuid,true);
 
 		// Critical section
@@ -475,13 +855,14 @@ bool NetcodeConnection::offerPeer(const std::string uuid) {
 			std::lock_guard<std::recursive_mutex> lock(_mutex);
 			if (_active) {
 				_peers.emplace(uuid,peer);
+				publish();
 			} else {
 				return false;
 			}
 		}
 
         // We are the offerer, so create a data channel to initiate the process
-        peer->createChannel("public");
+        peer->createChannel(NETCODE_RELIABLE_CHANNEL);
         return true;
 	} catch (const std::exception &e) {
 		CULogError("NETCODE ERROR: %s", e.what());
@@ -545,11 +926,13 @@ void NetcodeConnection::handleNegotiation(const std::shared_ptr<JsonValue>&  jso
 			for(int ii = 0; ii < child->size(); ii++) {
                 std::string value = child->get(ii)->asString();
 				_players.emplace(value);
-                if (value != _uuid) {
+                // In a star (or as a spectator), clients only connect to the host
+                if (value != _uuid && ((!isStar() && !_config.spectator) || value == _host)) {
                     outgoing.push_back(value);
                 }
 			}
 			
+			publish();
 			connect = !_ishost;
 			host = _host;
 			if (_ishost) {
@@ -583,7 +966,7 @@ void NetcodeConnection::handleNegotiation(const std::shared_ptr<JsonValue>&  jso
 		
 		// Finish up
 		if (response != nullptr) {
-			_socket->send(response->toString());		
+			_socket->send(response->toString(false));		
 		}
 		if (statech && _onStateChange) {
 			callback = [=]() {
@@ -600,7 +983,7 @@ void NetcodeConnection::handleNegotiation(const std::shared_ptr<JsonValue>&  jso
     }
 
 	if (callback) {
-        Application::get()->schedule(callback);
+        deliver(callback);
 	}
 }
 
@@ -634,11 +1017,24 @@ void NetcodeConnection::handleSession(const std::shared_ptr<JsonValue>&  json) {
 			if (status == "connect") {
 				// A player was added to our room
 				std::string player = json->getString("player");
+				if (isStar() && !_ishost && player != _uuid && player != _host) {
+					// Relayed players never establish a peer connection
+					_players.emplace(player);
+					publish();
+					if (_onConnect) {
+						callback = [=]() {
+							_onConnect(player);
+							return false;
+						};
+					}
+				}
 			} else if (status == "disconnect") {
 				// A (non-host) player was removed from our room
 				std::string player = json->getString("player");
 				_players.erase(player);
+				_spectators.erase(player);
                 _peers.erase(player);
+                publish();
 				if (_onDisconnect) {
 					callback = [=]() {
 						_onDisconnect(player);				
@@ -654,11 +1050,12 @@ void NetcodeConnection::handleSession(const std::shared_ptr<JsonValue>&  json) {
 				for(int ii = 0; ii < child->size(); ii++) {
                     std::string value = child->get(ii)->asString();
                     auto find = _peers.find(value);
-                    if (value == _uuid || find != _peers.end()) {
+                    if (value == _uuid || find != _peers.end() || isStar()) {
                         _players.emplace(value);
                     }
 				}
 				_initialPlayers = _players.size();
+				publish();
 				statech = true;
 				_previous = _state;
 				_state = State::INSESSION;
@@ -681,7 +1078,7 @@ void NetcodeConnection::handleSession(const std::shared_ptr<JsonValue>&  json) {
 	}
 
 	if (callback) {
-        Application::get()->schedule(callback);
+        deliver(callback);
 	}
 }
 
@@ -733,13 +1130,15 @@ void NetcodeConnection::handleMigration(const std::shared_ptr<JsonValue>&  json)
                 for(int ii = 0; ii < child->size(); ii++) {
                     _players.emplace(child->get(ii)->asString());
                 }
+                prune_spectators(_spectators,_players);
+                publish();
                 migrate = true;
                 host = _host;
                 
                 // Determine if any reconfiguration is necessary
                 for(auto it = _players.begin(); it != _players.end(); ++it) {
                     std::string uuid = *it;
-                    if (uuid != _uuid) {
+                    if (uuid != _uuid && ((!isStar() && !_config.spectator) || uuid == _host)) {
                         auto jt = _peers.find(uuid);
                         if (jt == _peers.end()) {
                             to_open.push_back(uuid);
@@ -762,8 +1161,8 @@ void NetcodeConnection::handleMigration(const std::shared_ptr<JsonValue>&  json)
             }
         } else if (category == "promotion") {
             if (status == "query") {
-                // We are being asked to promote to the host
-                if (_onPromotion) {
+                // We are being asked to promote to the host (spectators never are)
+                if (_onPromotion && !_config.spectator) {
                     std::weak_ptr<NetcodeConnection> wp = shared_from_this();
                     callback = [=]() {
                         bool result = _onPromotion(false);
@@ -776,7 +1175,7 @@ void NetcodeConnection::handleMigration(const std::shared_ptr<JsonValue>&  json)
                             response->appendValue("category",std::string("promotion"));
                             response->appendValue("status",std::string("response"));
                             response->appendValue("response",result);
-                            wwp->_socket->send(response->toString());
+                            wwp->_socket->send(response->toString(false));
                         }
                         return false;
                     };
@@ -797,6 +1196,8 @@ void NetcodeConnection::handleMigration(const std::shared_ptr<JsonValue>&  json)
                 for(int ii = 0; ii < child->size(); ii++) {
                     _players.emplace(child->get(ii)->asString());
                 }
+                prune_spectators(_spectators,_players);
+                publish();
                 
                 // Determine if any reconfiguration is necessary
                 _migration = 0;
@@ -831,7 +1232,7 @@ void NetcodeConnection::handleMigration(const std::shared_ptr<JsonValue>&  json)
                                 response->appendValue("type",std::string("lobby"));
                                 response->appendValue("category",std::string("session"));
                                 response->appendValue("status",std::string("shutdown"));
-                                wwp->_socket->send(response->toString());
+                                wwp->_socket->send(response->toString(false));
                             }
                         }
                         return false;
@@ -849,7 +1250,7 @@ void NetcodeConnection::handleMigration(const std::shared_ptr<JsonValue>&  json)
         
         // Finish up
         if (response != nullptr) {
-            _socket->send(response->toString());
+            _socket->send(response->toString(false));
         }
         if (statech && _onStateChange) {
             callback = [=]() {
@@ -870,7 +1271,7 @@ void NetcodeConnection::handleMigration(const std::shared_ptr<JsonValue>&  json)
     }
     
     if (callback) {
-        Application::get()->schedule(callback);
+        deliver(callback);
     }
 }
 
@@ -896,15 +1297,26 @@ void NetcodeConnection::handleSignal(const std::shared_ptr<JsonValue>&  json) {
 		}
 	}
 	
-	if (peer == nullptr && type == "offer") {
+	bool claimed = false;
+	if (peer == nullptr && type == "offer" && _config.spectator && id != getRoster()->host) {
+		if (_debug) {
+			CULog("NETCODE: Spectator ignored offer from %s",id.c_str());
+		}
+		return;
+	} else if (peer == nullptr && type == "offer") {
 		// DO NOT HOLD LOCK HERE
-		peer = NetcodePeer::alloc(shared_from_this(),id);
+		peer = claimSpare(id,false);
+		claimed = peer != nullptr;
+		if (peer == nullptr) {
+			peer = NetcodePeer::alloc(shared_from_this(),id);
+		}
 		{
 			std::lock_guard<std::recursive_mutex> lock(_mutex);
 			if (_debug) {
 				CULog("NETCODE: Answering offer from %s",id.c_str());
 			}
-			_peers.emplace(id,peer);		
+			_peers.emplace(id,peer);
+			publish();
 		}
 	}
 	
@@ -919,7 +1331,12 @@ void NetcodeConnection::handleSignal(const std::shared_ptr<JsonValue>&  json) {
 		std::string sdp = json->getString("candidate");
 		std::string mid = json->getString("mid");
 		peer->_connection->addRemoteCandidate(rtc::Candidate(sdp, mid));
-	} 
+	}
+	
+	// Replace the spare for the next player to join
+	if (claimed) {
+		prewarm();
+	}
 }
 
 /** 
@@ -927,147 +1344,564 @@ void NetcodeConnection::handleSignal(const std::shared_ptr<JsonValue>&  json) {
  *
  * This method is used to store an incoming message for later consumption.
  *
- * @param source    The message source
+ * @param source    The message source handle
  * @param data      The message data
  *
  * @return if the message was successfully added to the buffer.
  */
-bool NetcodeConnection::append(const std::string source, const std::vector<std::byte>& data) {
- 	std::function<bool()> callback;
-	bool success = false;
+bool NetcodeConnection::append(PeerHandle source, const std::vector<std::byte>& data) {
+	std::vector<std::byte> copy(data);
+	return append(source,std::move(copy));
+}
+
+/**
+ * Appends the given data to the ring buffer.
+ *
+ * This method is used to store an incoming message for later consumption.
+ * This version acquires the message data, and does not copy it. It is the
+ * version used for all messages arriving on a data channel.
+ *
+ * @param source    The message source handle
+ * @param data      The message data
+ *
+ * @return if the message was successfully added to the buffer.
+ */
+bool NetcodeConnection::append(PeerHandle source, std::vector<std::byte>&& data) {
+	if (!_active) {
+		return false;
+	}
 	
-	{
-		std::lock_guard<std::recursive_mutex> lock(_mutex);
-		if (_active) {
+	// Voice goes straight to the audio thread
+	if (!data.empty() && data[0] == NETCODE_VOICE_MARKER) {
+		auto voice = std::atomic_load(&_voice);
+		if (voice != nullptr) {
+			voice->receive(source,data);
+			return true;
+		}
+	}
+	
+	auto recorder = std::atomic_load(&_recorder);
+	if (recorder != nullptr) {
+		recorder->record(NetcodeRecorder::Direction::INBOUND,*getPeerName(source),data);
+	}
+	
+	// Only the callback requires a lock
+	if (_hasReceipt) {
+	 	std::function<bool()> callback;
+		{
+			std::lock_guard<std::recursive_mutex> lock(_mutex);
 			if (_onReceipt) {
-				callback = [=]() {
-					_onReceipt(source,data);
+				callback = [this,name = getPeerName(source),message = std::move(data)]() {
+					_onReceipt(*name,message);
 					return false;
 				};
-			} else {
-				// Buffer it
-				if (_buffsize == _buffer.size()) {
-					// Drops the oldest message
-					_buffhead = ((_buffhead + 1) % _buffer.size());
-					_buffsize--;
-				}
-		
-				Envelope* env = &(_buffer[_bufftail]);
-				env->source  = source;
-				env->message = data;
-
-				_bufftail = ((_bufftail + 1) % _buffer.size());
-				_buffsize++;
-			}		
-			success = true;
+			}
+		}
+		if (callback) {
+			deliver(std::move(callback));
+			return true;
 		}
 	}
 	
-	if (callback) {
-        Application::get()->schedule(callback);
-	}
-	
-	return success;
+	_inbound.push(Envelope(source,std::move(data)));
+	return true;
 }
 
-#pragma mark -
-#pragma mark Accessors
 /**
- * Returns a globally unique UUID representing this connection.
+ * Returns the data channel of the given peer for the specified lane.
  *
- * While room IDs are assigned by the lobby server, connections must assign their
- * own IDs. The only way to guarantee that this IDs are unique is to use Universally
- * Unique Identifiers (UUID) as defined here:
+ * If the unreliable lane is requested but is not yet open, this method
+ * returns the reliable channel instead. It returns nullptr if the peer has
+ * no open channel at all. This method locks the peer, and so must never be
+ * called while holding the lock of another peer (locking downwards).
  *
- *     https://en.wikipedia.org/wiki/Universally_unique_identifier
+ * @param peer  The peer connection
+ * @param lane  The delivery lane
  *
- * This number is assigned open allocation of this connection. Different connections,
- * even on the same device, have different UUIDs.
+ * @return the data channel of the given peer for the specified lane.
+ */
+std::shared_ptr<NetcodeChannel> NetcodeConnection::getLaneChannel(const std::shared_ptr<NetcodePeer>& peer,
+                                                                  Lane lane) {
+    std::lock_guard<std::recursive_mutex> sublock(peer->_mutex);
+    if (lane == Lane::UNRELIABLE) {
+        auto jt = peer->_channels.find(NETCODE_UNRELIABLE_CHANNEL);
+        if (jt != peer->_channels.end() && jt->second->isOpen()) {
+            return jt->second;
+        }
+    }
+    auto jt = peer->_channels.find(NETCODE_RELIABLE_CHANNEL);
+    return (jt == peer->_channels.end() ? nullptr : jt->second);
+}
+
+/**
+ * Adds the message to the outgoing batch for the given peer and lane.
  *
- * This method is not const because it requires a lock.
+ * If the message does not fit in the current batch, the batch is moved to
+ * ready and a new batch is started. If the message is too large to batch
+ * at all, it is moved to ready (after the current batch) as is. The datagrams
+ * in ready must be sent immediately, in order.
  *
- * @return a globally unique UUID representing this connection.
+ * This method must be called while holding the lock for this connection.
+ *
+ * @param dst   The UUID of the peer to receive the message
+ * @param lane  The delivery lane
+ * @param data  The message to batch
+ * @param ready The datagrams that must be sent now
  */
-std::string NetcodeConnection::getUUID() { 
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	return _uuid; 
+void NetcodeConnection::batch(const std::string& dst, Lane lane, const std::vector<std::byte>& data,
+                              std::vector<std::vector<std::byte>>& ready) {
+    size_t limit = (_config.mtu != 0 ? _config.mtu : DEFAULT_MTU)-BATCH_HEADROOM;
+    // The bulk lane shares the reliable channel
+    std::vector<std::byte>& batch = _batches[lane == Lane::UNRELIABLE ? 1 : 0][dst];
+    size_t needed = data.size()+BATCH_PREFIX;
+    if (!batch.empty() && batch.size()+needed > limit) {
+        ready.push_back(std::move(batch));
+        batch.clear();
+    }
+    if (needed+1 > limit) {
+        // Too large to batch
+        if (!data.empty() && data[0] == BATCH_MARKER) {
+            ready.emplace_back();
+            batch_append(ready.back(),data);
+        } else {
+            ready.push_back(data);
+        }
+    } else {
+        if (batch.empty()) {
+            batch.reserve(limit);
+        }
+        batch_append(batch,data);
+    }
 }
 
 /**
- * Returns the UUID for the (current) game host
+ * Processes a datagram received from a data channel.
  *
- * This method is not const because it requires a lock.
+ * If the datagram is a batch, it is unpacked into its individual messages,
+ * which are appended to the ring buffer in order. Otherwise the datagram is
+ * appended as is.
  *
- * @return the UUID for the (current) game host
+ * @param source    The message source handle
+ * @param data      The datagram
+ * @param lane      The lane the datagram arrived on
  */
-const std::string NetcodeConnection::getHost() {
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	return _host; 
+void NetcodeConnection::unbatch(PeerHandle source, std::vector<std::byte>&& data, Lane lane) {
+    if (data.empty() || data[0] != BATCH_MARKER) {
+        if (decode(source,std::move(data),lane)) {
+            _messagesReceived++;
+        }
+        return;
+    }
+    
+    size_t pos = 1;
+    while (pos+BATCH_PREFIX <= data.size()) {
+        Uint32 length;
+        std::memcpy(&length,data.data()+pos,BATCH_PREFIX);
+        length = cugl::marshall(length);
+        pos += BATCH_PREFIX;
+        if (pos+length > data.size()) {
+            CULogError("NETCODE: Truncated batch from %s",getPeerName(source)->c_str());
+            return;
+        }
+        if (decode(source,std::vector<std::byte>(data.begin()+pos,data.begin()+pos+length),lane)) {
+            _messagesReceived++;
+        }
+        pos += length;
+    }
 }
+
+/**
+ * Returns the message to send to the given peer in place of data.
+ *
+ * If the threshold is not 0, the peer accepts compressed messages, and the
+ * data is large enough, this method returns a compressed frame (using the
+ * dictionary if the peer has the same one). A message that begins with the
+ * compression marker is escaped. Otherwise, this method returns message,
+ * the shared buffer for data. A result of nullptr means data is sent as is.
+ *
+ * Frames are cached in frames (indexed by codec), so that a broadcast only
+ * compresses a message once per codec. The bitmask tried records which
+ * codecs have been attempted. This method must be called while holding the
+ * lock for this connection, unless the threshold is 0.
+ *
+ * @param dst       The UUID of the peer to receive the message
+ * @param data      The message to send
+ * @param message   The shared buffer for data (nullptr for none)
+ * @param threshold The compression threshold (0 for no compression)
+ * @param frames    The frames encoded so far for this message
+ * @param tried     The codecs attempted so far for this message
+ *
+ * @return the message to send to the given peer in place of data.
+ */
+NetcodeMessage NetcodeConnection::encode(const std::string& dst, const std::vector<std::byte>& data,
+                                         const NetcodeMessage& message, size_t threshold,
+                                         NetcodeMessage* frames, Uint8& tried) {
+    if (data.empty()) {
+        return message;
+    }
+    
+    // Only touch the codecs when compressing (the lock is not held otherwise)
+    auto find = threshold != 0 ? _codecs.find(dst) : _codecs.end();
+    if (threshold != 0 && data.size() >= threshold && find != _codecs.end()) {
+        Uint32 hash = _compressor->getDictionaryHash();
+        int codec = (hash != 0 && find->second == hash) ? COMPRESS_DICT : COMPRESS_PLAIN;
+        if (!(tried & (1 << codec))) {
+            tried |= (1 << codec);
+            std::vector<std::byte> frame;
+            Uint32 header[2];
+            header[0] = cugl::marshall((Uint32)data.size());
+            header[1] = cugl::marshall(codec == COMPRESS_DICT ? hash : 0);
+            const std::byte* bytes = reinterpret_cast<const std::byte*>(header);
+            frame.push_back(COMPRESS_MARKER);
+            frame.push_back((std::byte)codec);
+            frame.insert(frame.end(), bytes, bytes+2*sizeof(Uint32));
+            if (_compressor->compress(data.data(),data.size(),frame,codec == COMPRESS_DICT) &&
+                frame.size() < data.size()) {
+                frames[codec] = std::make_shared<const std::vector<std::byte>>(std::move(frame));
+            }
+        }
+        if (frames[codec] != nullptr) {
+            return frames[codec];
+        }
+    }
     
+    if (data[0] == COMPRESS_MARKER) {
+        if (frames[COMPRESS_RAW] == nullptr) {
+            std::vector<std::byte> frame;
+            frame.reserve(data.size()+2);
+            frame.push_back(COMPRESS_MARKER);
+            frame.push_back((std::byte)COMPRESS_RAW);
+            frame.insert(frame.end(), data.begin(), data.end());
+            frames[COMPRESS_RAW] = std::make_shared<const std::vector<std::byte>>(std::move(frame));
+        }
+        return frames[COMPRESS_RAW];
+    }
+    return message;
+}
+
 /**
- * Returns the message buffer capacity.
- *
- * It is possible for this connection to receive several messages over the network
- * before it has a chance to all {@link #receive}. This buffer stores those messages
- * to be read later. The capacity indicates the number of messages that can be
- * stored.
+ * Processes a single message received from a data channel.
  *
- * Note that this is NOT the same as the capacity of a single message. That value
- * was set as part of the initial {@link NetcodeConfig}.
+ * If the message is a compression frame, it is decompressed (or unescaped)
+ * before it is appended to the ring buffer. Compression handshakes from the
+ * peer are consumed, and never appended.
  *
- * This method is not const because it requires a lock.
+ * @param source    The message source handle
+ * @param data      The message
+ * @param lane      The lane the message arrived on
  *
- * @return the message buffer capacity.
+ * @return true if a message was appended to the ring buffer
  */
-size_t NetcodeConnection::getCapacity() {
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	return _buffer.size();
+bool NetcodeConnection::decode(PeerHandle source, std::vector<std::byte>&& data, Lane lane) {
+    if (data.empty() || data[0] != COMPRESS_MARKER) {
+        return deliver(source,std::move(data),lane);
+    } else if (data.size() < 2) {
+        CULogError("NETCODE: Truncated compression frame from %s",getPeerName(source)->c_str());
+        return false;
+    }
+    
+    Uint8 type = (Uint8)data[1];
+    Uint32 header[2];
+    switch (type) {
+        case COMPRESS_RAW:
+            return deliver(source,std::vector<std::byte>(data.begin()+2,data.end()),lane);
+        case COMPRESS_HELLO:
+            if (data.size() < 2+sizeof(Uint32)) {
+                break;
+            }
+            std::memcpy(header,data.data()+2,sizeof(Uint32));
+            {
+                std::lock_guard<std::recursive_mutex> lock(_mutex);
+                _codecs[*getPeerName(source)] = cugl::marshall(header[0]);
+            }
+            if (_debug) {
+                CULog("NETCODE: Peer %s accepts compression",getPeerName(source)->c_str());
+            }
+            return false;
+        case COMPRESS_SPECTATOR:
+            if (_ishost) {
+                addSpectator(*getPeerName(source));
+            }
+            return false;
+        case COMPRESS_PLAIN:
+        case COMPRESS_DICT:
+        {
+            if (data.size() < COMPRESS_HEADER) {
+                break;
+            }
+            std::memcpy(header,data.data()+2,2*sizeof(Uint32));
+            size_t original = cugl::marshall(header[0]);
+            if (original > COMPRESS_LIMIT) {
+                CULogError("NETCODE: Compressed message from %s is too large",getPeerName(source)->c_str());
+                return false;
+            }
+            
+            std::shared_ptr<NetcodeCompressor> compressor;
+            {
+                std::lock_guard<std::recursive_mutex> lock(_mutex);
+                compressor = _compressor;
+            }
+            if (type == COMPRESS_DICT && compressor->getDictionaryHash() != cugl::marshall(header[1])) {
+                CULogError("NETCODE: Unknown compression dictionary from %s",getPeerName(source)->c_str());
+                return false;
+            }
+
+            std::vector<std::byte> message;
+            if (!compressor->decompress(data.data()+COMPRESS_HEADER,data.size()-COMPRESS_HEADER,
+                                        original,message,type == COMPRESS_DICT)) {
+                CULogError("NETCODE: Corrupt compressed message from %s",getPeerName(source)->c_str());
+                return false;
+            }
+            return deliver(source,std::move(message),lane);
+        }
+        default:
+            break;
+    }
+    CULogError("NETCODE: Invalid compression frame from %s",getPeerName(source)->c_str());
+    return false;
 }
 
 /**
- * Sets the message buffer capacity.
+ * Processes a single decoded message received from a data channel.
  *
- * It is possible for this connection to recieve several messages over the network
- * before it has a chance to all {@link #receive}. This buffer stores those messages
- * to be read later. The capacity indicates the number of messages that can be
- * stored.
+ * In the star topology, this unwraps any relay frame. If this connection
+ * is the host, and the message is addressed to other players, it is
+ * forwarded along the same lane. Otherwise the message is appended to the
+ * ring buffer with its original source.
  *
- * Note that this is NOT the same as the capacity of a single message. That value
- * was set as part of the initial {@link NetcodeConfig}.
+ * @param source    The message source handle
+ * @param data      The message
+ * @param lane      The lane the message arrived on
  *
- * @paran capacity  The new message buffer capacity.
+ * @return true if a message was appended to the ring buffer
  */
-void NetcodeConnection::setCapacity(size_t capacity) {
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	
-	// Rotate to correct position
-	size_t pos = _buffhead;
-	if (capacity < _buffsize) {
-		pos = ((_buffhead + (_buffsize-capacity)) % _buffer.size());
-		_buffsize = capacity;
-	}
-	if (pos != 0) {
-		std::rotate(_buffer.begin(), _buffer.begin() + pos, _buffer.end());
-	}
-	_buffhead = 0;
-	_bufftail = ((_bufftail + (_buffer.size()-pos)) % _buffer.size());
-	_buffer.resize(capacity);
-}
+bool NetcodeConnection::deliver(PeerHandle source, std::vector<std::byte>&& data, Lane lane) {
+    if (!isStar() || data.empty() || data[0] != RELAY_MARKER) {
+        return append(source,std::move(data));
+    }
     
-/**
- * Returns the list of active players
+    // Relay frames need the UUID (the snapshot keeps it alive)
+    auto roster = getRoster();
+    const std::string& name = roster->getName(source);
+    size_t length = (data.size() >= RELAY_HEADER ? (size_t)data[2] : 0);
+    if (data.size() < RELAY_HEADER+length) {
+        CULogError("NETCODE: Truncated relay frame from %s",name.c_str());
+        return false;
+    }
+    
+    Uint8 type = (Uint8)data[1];
+    std::string uuid(reinterpret_cast<const char*>(data.data())+RELAY_HEADER,length);
+    auto payload = data.begin()+RELAY_HEADER+length;
+    bool ishost  = _ishost;
+    bool forward = !ishost && name == roster->host;
+    bool muted   = ishost && roster->spectators.count(name) > 0;
+    
+    switch (type) {
+        case RELAY_DIRECT:
+            return append(source,std::vector<std::byte>(payload,data.end()));
+        case RELAY_FORWARD:
+            if (forward) {
+                return append(intern(uuid),std::vector<std::byte>(payload,data.end()));
+            }
+            break;
+        case RELAY_UNICAST:
+            if (!ishost) {
+                break;
+            } else if (uuid == _uuid) {
+                return append(source,std::vector<std::byte>(payload,data.end()));
+            } else if (muted) {
+                if (_debug) {
+                    CULogCategory(CU_LOG_CATEGORY_NETCODE,"NETCODE: Dropped relay from spectator %s",name.c_str());
+                }
+                return false;
+            } else {
+                relay_rewrite(data,RELAY_FORWARD,name);
+                NetcodeMessage frame = std::make_shared<const std::vector<std::byte>>(std::move(data));
+                if (!transmit(uuid,*frame,frame,lane) && _debug) {
+                    CULogCategory(CU_LOG_CATEGORY_NETCODE,"NETCODE: Dropped relay from %s to %s",name.c_str(),uuid.c_str());
+                }
+                return false;
+            }
+        case RELAY_BROADCAST:
+            if (ishost && muted) {
+                // Spectators may talk to the host, but not the other players
+                return append(source,std::vector<std::byte>(payload,data.end()));
+            } else if (ishost) {
+                bool result = append(source,std::vector<std::byte>(payload,data.end()));
+                relay_rewrite(data,RELAY_FORWARD,name);
+                NetcodeMessage frame = std::make_shared<const std::vector<std::byte>>(std::move(data));
+                fanout(*frame,frame,lane,name);
+                return result;
+            }
+            break;
+        case RELAY_SPECTATOR:
+            if (forward) {
+                addSpectator(uuid);
+                return false;
+            }
+            break;
+        default:
+            break;
+    }
+    CULogError("NETCODE: Invalid relay frame from %s",name.c_str());
+    return false;
+}
+
+/**
+ * Records that the given player is a spectator.
+ *
+ * The host learns of a spectator from the control frame that it sends
+ * once their peer connection is established. In the star topology, the
+ * host then announces the spectator to every other client. This method
+ * must NOT be called while holding the lock for this connection.
+ *
+ * @param uuid  The UUID of the spectator
+ */
+void NetcodeConnection::addSpectator(const std::string& uuid) {
+    bool announce = false;
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        if (!_active || uuid == _uuid || !_spectators.emplace(uuid).second) {
+            return;
+        }
+        publish();
+        announce = _ishost && isStar();
+        if (_debug) {
+            CULog("NETCODE: Player %s is a spectator",uuid.c_str());
+        }
+    }
+    
+    // The spectator is already skipped by the fanout
+    if (announce) {
+        NetcodeMessage frame = relay_frame(RELAY_SPECTATOR,uuid,std::vector<std::byte>());
+        fanout(*frame,frame,Lane::RELIABLE,uuid,true);
+    }
+}
+
+#pragma mark -
+#pragma mark Accessors
+/**
+ * Returns the network statistics for this connection.
+ *
+ * The statistics include the bytes and packets sent and received across all
+ * peers, the number of messages sent and received, the number of incoming
+ * messages dropped because the message buffer was full, and the number of
+ * messages waiting in that buffer. Use {@link NetcodePeer#getStats} for the
+ * round trip time of an individual peer.
+ *
+ * All of these values are atomic, so this method never takes a lock. However,
+ * the queue depth is only accurate when called on the same thread as
+ * {@link #receive}.
+ *
+ * @return the network statistics for this connection.
+ */
+NetcodeStats NetcodeConnection::getStats() const {
+	NetcodeStats result;
+	_stats->snapshot(result);
+	result.messagesSent = _messagesSent.load();
+	result.messagesReceived = _messagesReceived.load();
+	result.messagesDropped = _inbound.getDropped();
+	result.queueDepth = _inbound.size();
+	result.rtt = -1;
+	return result;
+}
+
+/**
+ * Returns a globally unique UUID representing this connection.
+ *
+ * While room IDs are assigned by the lobby server, connections must assign their
+ * own IDs. The only way to guarantee that this IDs are unique is to use Universally
+ * Unique Identifiers (UUID) as defined here:
+ *
+ *     https://en.wikipedia.org/wiki/Universally_unique_identifier
+ *
+ * This number is assigned open allocation of this connection. Different connections,
+ * even on the same device, have different UUIDs.
+ *
+ * This method is not const because it requires a lock.
+ *
+ * @return a globally unique UUID representing this connection.
+ */
+std::string NetcodeConnection::getUUID() { 
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	return _uuid; 
+}
+
+/**
+ * Returns the UUID for the (current) game host
+ *
+ * @return the UUID for the (current) game host
+ */
+const std::string NetcodeConnection::getHost() const {
+	return getRoster()->host;
+}
+    
+/**
+ * Returns the message buffer capacity.
+ *
+ * It is possible for this connection to receive several messages over the network
+ * before it has a chance to all {@link #receive}. This buffer stores those messages
+ * to be read later. The capacity indicates the number of messages that can be
+ * stored.
+ *
+ * Note that this is NOT the same as the capacity of a single message. That value
+ * was set as part of the initial {@link NetcodeConfig}.
+ *
+ * This method is not const because it requires a lock.
+ *
+ * @return the message buffer capacity.
+ */
+size_t NetcodeConnection::getCapacity() {
+	return _inbound.capacity();
+}
+
+/**
+ * Sets the message buffer capacity.
+ *
+ * It is possible for this connection to recieve several messages over the network
+ * before it has a chance to all {@link #receive}. This buffer stores those messages
+ * to be read later. The capacity indicates the number of messages that can be
+ * stored.
+ *
+ * Note that this is NOT the same as the capacity of a single message. That value
+ * was set as part of the initial {@link NetcodeConfig}.
+ *
+ * This method should only be called on the same thread as {@link #receive}.
+ *
+ * @paran capacity  The new message buffer capacity.
+ */
+void NetcodeConnection::setCapacity(size_t capacity) {
+	_inbound.resize(capacity);
+}
+    
+/**
+ * Returns the list of active players
  *
  * This vector stores the UUIDs of all the players who are currently playing the
  * game. This list will continually update as players join and leave the game.
  *
- * This method is not const because it requires a lock.
+ * This method copies the latest snapshot of the players, but does not lock.
+ * Use {@link #getPlayerView} to avoid the copy.
  *
  * @return the list of active players
  */
-const std::unordered_set<std::string> NetcodeConnection::getPlayers() {
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	return _players;
+const std::unordered_set<std::string> NetcodeConnection::getPlayers() const {
+	return getRoster()->players;
+}
+
+/**
+ * Returns a read-only snapshot of the active players
+ *
+ * This is the same set as {@link #getPlayers}, but it is neither copied nor
+ * locked. The snapshot never changes. Instead, the connection publishes a
+ * new one whenever the players change, so this method should be called
+ * again to see the latest players.
+ *
+ * @return a read-only snapshot of the active players
+ */
+std::shared_ptr<const std::unordered_set<std::string>> NetcodeConnection::getPlayerView() const {
+	auto roster = getRoster();
+	return std::shared_ptr<const std::unordered_set<std::string>>(roster,&roster->players);
 }
     
 /**
@@ -1079,28 +1913,74 @@ const std::unordered_set<std::string> NetcodeConnection::getPlayers() {
  * be initiated through the websocket. It is provided for debugging purposes
  * only.
  *
- * This method is not const because it requires a lock.
+ * This method copies the latest snapshot of the peers, but does not lock.
+ * Use {@link #getPeerView} to avoid the copy.
  *
  * @return the list of peer connections for this websocket connection
  */
-const std::unordered_map<std::string, std::shared_ptr<NetcodePeer>> NetcodeConnection::getPeers() {
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	return _peers;
+const std::unordered_map<std::string, std::shared_ptr<NetcodePeer>> NetcodeConnection::getPeers() const {
+	return getRoster()->peers;
 }
 
 /**
- * Returns true if the given player UUID is currently connected to the game.
+ * Returns a read-only snapshot of the peer connections
  *
- * This method is not const because it requires a lock.
+ * This is the same map as {@link #getPeers}, but it is neither copied nor
+ * locked. The snapshot never changes. Instead, the connection publishes a
+ * new one whenever the peers change, so this method should be called
+ * again to see the latest peers.
+ *
+ * @return a read-only snapshot of the peer connections
+ */
+std::shared_ptr<const std::unordered_map<std::string, std::shared_ptr<NetcodePeer>>> NetcodeConnection::getPeerView() const {
+	auto roster = getRoster();
+	return std::shared_ptr<const std::unordered_map<std::string, std::shared_ptr<NetcodePeer>>>(roster,&roster->peers);
+}
+
+/**
+ * Returns true if the given player UUID is currently connected to the game.
  *
  * @param player    The player to test for connection
  *
  * @return true if the given player UUID is currently connected to the game.
  */
-bool NetcodeConnection::isPlayerActive(const std::string player) {
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	auto it = _players.find(player);
-	return it != _players.end();
+bool NetcodeConnection::isPlayerActive(const std::string player) const {
+	auto roster = getRoster();
+	return roster->players.find(player) != roster->players.end();
+}
+
+/**
+ * Returns the peer handle for the given UUID.
+ *
+ * Handles are assigned to peers the first time this connection receives a
+ * message from them (this connection always has a handle). This method
+ * returns {@link NETCODE_NO_HANDLE} if the UUID does not have a handle yet.
+ * It does not lock.
+ *
+ * @param uuid  The peer UUID
+ *
+ * @return the peer handle for the given UUID.
+ */
+NetcodeConnection::PeerHandle NetcodeConnection::getPeerHandle(const std::string& uuid) const {
+	auto roster = getRoster();
+	auto it = roster->handles.find(uuid);
+	return (it == roster->handles.end() ? NETCODE_NO_HANDLE : it->second);
+}
+
+/**
+ * Returns the UUID for the given peer handle.
+ *
+ * The UUID is shared, so that it may be attached to every message from a
+ * peer without copying it. This method returns an empty string (never
+ * nullptr) if the handle is not valid. It does not lock.
+ *
+ * @param handle    The peer handle
+ *
+ * @return the UUID for the given peer handle.
+ */
+std::shared_ptr<const std::string> NetcodeConnection::getPeerName(PeerHandle handle) const {
+	auto roster = getRoster();
+	return roster->names[handle < roster->names.size() ? handle : NETCODE_NO_HANDLE];
 }
 
 /**
@@ -1108,13 +1988,10 @@ bool NetcodeConnection::isPlayerActive(const std::string player) {
  *
  * This does not include any players that have been disconnected.
  *
- * This method is not const because it requires a lock.
- *
  * @return the number of players currently connected to this game 
  */
-size_t NetcodeConnection::getNumPlayers() {
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	return _players.size();
+size_t NetcodeConnection::getNumPlayers() const {
+	return getRoster()->players.size();
 }
 
 /**
@@ -1132,6 +2009,50 @@ size_t NetcodeConnection::getTotalPlayers() {
 	return _initialPlayers;
 }
 
+/**
+ * Returns true if the given player only watches the game.
+ *
+ * Spectators are still players (see {@link #getPlayers}), but broadcasts
+ * never reach them. Only the host is guaranteed to know every spectator.
+ * In the star topology, the host announces them to the other clients. In
+ * the mesh topology, the other clients never connect to them at all.
+ *
+ * This method does not lock.
+ *
+ * @param uuid  The UUID of the player
+ *
+ * @return true if the given player only watches the game.
+ */
+bool NetcodeConnection::isSpectator(const std::string& uuid) const {
+	auto roster = getRoster();
+	return roster->spectators.find(uuid) != roster->spectators.end();
+}
+
+/**
+ * Returns a read-only snapshot of the spectators
+ *
+ * This is the subset of {@link #getPlayers} that only watch the game. Like
+ * {@link #getPlayerView}, it is neither copied nor locked, and a new
+ * snapshot is published whenever the spectators change.
+ *
+ * @return a read-only snapshot of the spectators
+ */
+std::shared_ptr<const std::unordered_set<std::string>> NetcodeConnection::getSpectatorView() const {
+	auto roster = getRoster();
+	return std::shared_ptr<const std::unordered_set<std::string>>(roster,&roster->spectators);
+}
+
+/**
+ * Returns the number of spectators currently connected to this game
+ *
+ * These are included in {@link #getNumPlayers}.
+ *
+ * @return the number of spectators currently connected to this game
+ */
+size_t NetcodeConnection::getNumSpectators() const {
+	return getRoster()->spectators.size();
+}
+
 /**
  * Toggles the debugging status of this connection.
  *
@@ -1174,7 +2095,7 @@ void NetcodeConnection::open() {
 	_socket->onClosed([this]() { onClosed(); });
 	_socket->onMessage([this](auto data) { onMessage(data); });
 	
-	_buffer.resize(DEFAULT_BUFFER);
+	_inbound.resize(DEFAULT_BUFFER);
 	
 	// Start the connection
 	_active = true;
@@ -1186,11 +2107,18 @@ void NetcodeConnection::open() {
 		CULog("NETCODE: Connecting to websocket %s",url.c_str());
 	}
 	
-	_players.emplace(_uuid);
+	{
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		_players.emplace(_uuid);
+		publish();
+	}
 	_socket->open(url);
 	if (_debug) {
 		CULog("NETCODE: Waiting for lobby '%s' to connect",url.c_str());
 	}
+	
+	// Overlap peer setup with the lobby negotiation
+	prewarm();
 }
 
 /**
@@ -1234,50 +2162,173 @@ void NetcodeConnection::close() {
  * This requires a connection be established. Otherwise it will return false. It
  * will also return false if the host is currently migrating.
  *
- * @param dst The UUID of the peer to receive the message
- * @param msg The byte array to send.
+ * If the lane is {@link Lane#UNRELIABLE}, the message is not guaranteed to be
+ * ordered, or even to arrive at all.
+ *
+ * @param dst   The UUID of the peer to receive the message
+ * @param data  The byte array to send.
+ * @param lane  The delivery lane
  *
  * @return true if the message was (apparently) sent
  */
-bool NetcodeConnection::sendTo(const std::string dst, const std::vector<std::byte>& data) {
-	std::shared_ptr<NetcodeChannel> channel;
+bool NetcodeConnection::sendTo(const std::string dst, const std::vector<std::byte>& data, Lane lane) {
+    return sendTo(dst,data,nullptr,lane);
+}
+
+/**
+ * Sends a shared message buffer to the specified connection.
+ *
+ * This method is identical to {@link #sendTo}, except that the message is
+ * never copied on its way to the data channel. If this connection is the
+ * recipient, the message is still copied into the receipt buffer.
+ *
+ * @param dst       The UUID of the peer to receive the message
+ * @param message   The message to send.
+ * @param lane      The delivery lane
+ *
+ * @return true if the message was (apparently) sent
+ */
+bool NetcodeConnection::sendTo(const std::string dst, const NetcodeMessage& message, Lane lane) {
+    if (message == nullptr) {
+        return false;
+    }
+    return sendTo(dst,*message,message,lane);
+}
+
+/**
+ * Sends a byte array to the specified connection.
+ *
+ * This is the implementation of both versions of {@link #sendTo}. If message
+ * is not nullptr, it must hold the same bytes as data, and it is shared by the
+ * send stack instead of data being copied.
+ *
+ * @param dst       The UUID of the peer to receive the message
+ * @param data      The byte array to send.
+ * @param message   The shared buffer for data (nullptr for none)
+ * @param lane      The delivery lane
+ *
+ * @return true if the message was (apparently) sent
+ */
+bool NetcodeConnection::sendTo(const std::string dst, const std::vector<std::byte>& data,
+                               const NetcodeMessage& message, Lane lane) {
+    std::string route = dst;
+    bool relayed = false;
     bool self = false;
 	
-	// Critical section
+	// Read the snapshot (no lock needed)
 	{
-		std::lock_guard<std::recursive_mutex> lock(_mutex);
-        if (_active && _state != State::MIGRATING) {
-            self = dst == _uuid;
-            if (!self) {
-                auto find = _peers.find(dst);
-                if (!_active || find == _peers.end()) {
-                    CUAssertLog(false,"No direct route to '%s'",dst.c_str());
-                    return false;
-                } else if (_state == State::MIGRATING) {
-                    return false;
-                }
-                
-                // Locking downwards is allowed
-                auto peer = find->second;
-                std::lock_guard<std::recursive_mutex> sublock(peer->_mutex);
-                for(auto jt = peer->_channels.begin();
-                    channel == nullptr && jt != peer->_channels.end(); ++jt) {
-                    if (jt->first == "public") {
-                        channel = jt->second;
-                    }
-                }
-            }
+        if (!_active || _state == State::MIGRATING) {
+            return false;
+        }
+        
+        auto roster = getRoster();
+        self = dst == _uuid;
+        if (!self && isStar() && !_ishost && dst != roster->host) {
+            // Clients in a star only have a route to the host
+            route = roster->host;
+            relayed = true;
+        }
+        if (!self && roster->peers.find(route) == roster->peers.end()) {
+            CUAssertLog(false,"No direct route to '%s'",route.c_str());
+            return false;
         }
 	}
 	
     // Do not hold locks on send
     if (self) {
-        append(dst,data);
-    } else if (channel != nullptr) {
-        channel->send(data);
+        append(_selfHandle,data);
+        return true;
+    }
+    
+    bool result = false;
+    if (relayed) {
+        NetcodeMessage frame = relay_frame(RELAY_UNICAST,dst,data);
+        result = transmit(route,*frame,frame,lane);
+    } else if (isStar() && !data.empty() && data[0] == RELAY_MARKER) {
+        NetcodeMessage frame = relay_frame(RELAY_DIRECT,"",data);
+        result = transmit(route,*frame,frame,lane);
     } else {
+        result = transmit(route,data,message,lane);
+    }
+    
+    auto recorder = std::atomic_load(&_recorder);
+    if (result && recorder != nullptr) {
+        recorder->record(NetcodeRecorder::Direction::OUTBOUND,dst,data);
+    }
+    return result;
+}
+
+/**
+ * Sends a byte array along the peer connection with the given UUID.
+ *
+ * This is the shared back end of all of the send methods. It does not
+ * relay, and it does not record the message. If message is not nullptr,
+ * it must hold the same bytes as data, and it is shared by the send stack
+ * instead of data being copied. This method must NOT be called while
+ * holding the lock for this connection.
+ *
+ * If scheduling is enabled, the message is queued for {@link #flush}
+ * instead, unless direct is true.
+ *
+ * @param dst       The UUID of the peer connection
+ * @param data      The byte array to send.
+ * @param message   The shared buffer for data (nullptr for none)
+ * @param lane      The delivery lane
+ * @param direct    Whether to bypass the scheduler
+ *
+ * @return true if the message was (apparently) sent
+ */
+bool NetcodeConnection::transmit(const std::string& dst, const std::vector<std::byte>& data,
+                                 const NetcodeMessage& message, Lane lane, bool direct) {
+    if (!direct && _bandwidth != 0) {
+        return enqueue(dst,false,data,message,lane);
+    }
+    
+	std::shared_ptr<NetcodeChannel> channel;
+    std::vector<std::vector<std::byte>> ready;
+    NetcodeMessage frames[3];
+    NetcodeMessage encoded;
+    Uint8 tried = 0;
+    bool batched = false;
+	
+	// Critical section (only needed to batch or compress)
+	{
+        auto roster = getRoster();
+        auto find = roster->peers.find(dst);
+        if (!_active || find == roster->peers.end()) {
+            return false;
+        }
+        
+        size_t threshold = _compression;
+        std::unique_lock<std::recursive_mutex> lock(_mutex,std::defer_lock);
+        if (_batching || threshold != 0) {
+            lock.lock();
+        }
+        
+        // Locking downwards is allowed
+        channel = getLaneChannel(find->second,lane);
+        if (channel != nullptr) {
+            encoded = encode(dst,data,message,threshold,frames,tried);
+            if (lock.owns_lock() && _batching) {
+                batch(dst,lane,encoded != nullptr ? *encoded : data,ready);
+                batched = true;
+            }
+        }
+	}
+	
+    // Do not hold locks on send
+    if (channel == nullptr) {
         return false;
     }
+    
+    _messagesSent++;
+    if (batched) {
+        for(auto it = ready.begin(); it != ready.end(); ++it) {
+            channel->send(*it);
+        }
+    } else {
+        send_single(channel,encoded != nullptr ? *encoded : data,encoded);
+    }
     return true;
 }
 
@@ -1300,61 +2351,67 @@ bool NetcodeConnection::sendTo(const std::string dst, const std::vector<std::byt
  * This requires a connection be established. Otherwise it will return false. It
  * will also return false if the host is currently migrating.
  *
- * @param dst The UUID of the peer to receive the message
- * @param msg The byte array to send.
+ * If the lane is {@link Lane#UNRELIABLE}, the message is not guaranteed to be
+ * ordered, or even to arrive at all.
+ *
+ * @param data  The byte array to send.
+ * @param lane  The delivery lane
  *
  * @return true if the message was (apparently) sent
  */
-bool NetcodeConnection::sendToHost(const std::vector<std::byte>& data) {
-    std::shared_ptr<NetcodeChannel> channel;
-    bool self = false;
-    std::string uuid;
-    
-    // Critical section
-    {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-        if (_active && _state != State::MIGRATING) {
-            self = _host == _uuid;
-            uuid = _host;
-            if (!self) {
-                auto find = _peers.find(_host);
-                if (!_active || find == _peers.end()) {
-                    CUAssertLog(false,"No direct route to '%s'",_host.c_str());
-                    return false;
-                } else if (_state == State::MIGRATING) {
-                    return false;
-                }
-                
-                // Locking downwards is allowed
-                auto peer = find->second;
-                std::lock_guard<std::recursive_mutex> sublock(peer->_mutex);
-                for(auto jt = peer->_channels.begin();
-                    channel == nullptr && jt != peer->_channels.end(); ++jt) {
-                    if (jt->first == "public") {
-                        channel = jt->second;
-                    }
-                }
-            }
-        }
-    }
-    
-    // Do not hold locks on send
-    if (self) {
-        append(uuid,data);
-    } else if (channel != nullptr) {
-        channel->send(data);
-    } else {
-        return false;
-    }
-    return true;
+bool NetcodeConnection::sendToHost(const std::vector<std::byte>& data, Lane lane) {
+    return sendToHost(data,nullptr,lane);
 }
 
 /**
- * Sends a byte array to all other players.
+ * Sends a shared message buffer to the host player.
  *
- * Within a few frames, other players should receive this via a call to
- * {@link #receive} or the callback function {@link #onReceipt}. As this is
- * a broadcast message, this player will receive it as well (with the indication
+ * This method is identical to {@link #sendToHost}, except that the message is
+ * never copied on its way to the data channel. If this connection is the host,
+ * the message is still copied into the receipt buffer.
+ *
+ * @param message   The message to send.
+ * @param lane      The delivery lane
+ *
+ * @return true if the message was (apparently) sent
+ */
+bool NetcodeConnection::sendToHost(const NetcodeMessage& message, Lane lane) {
+    if (message == nullptr) {
+        return false;
+    }
+    return sendToHost(*message,message,lane);
+}
+
+/**
+ * Sends a byte array to the host player.
+ *
+ * This is the implementation of both versions of {@link #sendToHost}. If
+ * message is not nullptr, it must hold the same bytes as data, and it is
+ * shared by the send stack instead of data being copied.
+ *
+ * @param data      The byte array to send.
+ * @param message   The shared buffer for data (nullptr for none)
+ * @param lane      The delivery lane
+ *
+ * @return true if the message was (apparently) sent
+ */
+bool NetcodeConnection::sendToHost(const std::vector<std::byte>& data, const NetcodeMessage& message, Lane lane) {
+    std::string host;
+    
+    // Critical section
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        host = _host;
+    }
+    return sendTo(host,data,message,lane);
+}
+
+/**
+ * Sends a byte array to all other players.
+ *
+ * Within a few frames, other players should receive this via a call to
+ * {@link #receive} or the callback function {@link #onReceipt}. As this is
+ * a broadcast message, this player will receive it as well (with the indication
  * of this connection as the sender).
  *
  * As with {@link #sendTo}, communication from a particular source is guaranteed
@@ -1362,6 +2419,9 @@ bool NetcodeConnection::sendToHost(const std::vector<std::byte>& data) {
  * will receive those messages in the same order. However, there is no relationship
  * between the messages coming from different sources.
  *
+ * Spectators (see {@link #isSpectator}) never receive a broadcast. Messages for
+ * a spectator must be sent to it with {@link #sendTo}.
+ *
  * You may choose to either send a byte array directly, or you can use the
  * {@link NetworkSerializer} and {@link NetworkDeserializer} classes to encode
  * more complex data.
@@ -1369,27 +2429,62 @@ bool NetcodeConnection::sendToHost(const std::vector<std::byte>& data) {
  * This requires a connection be established. Otherwise it will return false. It
  * will also return false if the host is currently migrating.
  *
- * @param msg The byte array to send.
+ * If the lane is {@link Lane#UNRELIABLE}, the message is not guaranteed to be
+ * ordered, or even to arrive at all.
+ *
+ * @param data The byte array to send.
+ * @param lane The delivery lane
  *
  * @return true if the message was (apparently) sent
  */
-bool NetcodeConnection::broadcast(const std::vector<std::byte>& data) {
-    std::vector<std::shared_ptr<NetcodeChannel>> channels;
+bool NetcodeConnection::broadcast(const std::vector<std::byte>& data, Lane lane) {
+    return broadcast(data,nullptr,lane);
+}
+
+/**
+ * Sends a shared message buffer to all other players.
+ *
+ * This method is identical to {@link #broadcast}, except that the message is
+ * never copied on its way to the data channels. So a message sent to several
+ * peers is only stored once, even if some channels must queue it. The message
+ * is still copied into the receipt buffer of this connection.
+ *
+ * @param message   The message to send.
+ * @param lane      The delivery lane
+ *
+ * @return true if the message was (apparently) sent
+ */
+bool NetcodeConnection::broadcast(const NetcodeMessage& message, Lane lane) {
+    if (message == nullptr) {
+        return false;
+    }
+    return broadcast(*message,message,lane);
+}
+
+/**
+ * Sends a byte array to all other players.
+ *
+ * This is the implementation of both versions of {@link #broadcast}. If
+ * message is not nullptr, it must hold the same bytes as data, and it is
+ * shared by every channel instead of data being copied for each peer.
+ *
+ * @param data      The byte array to send.
+ * @param message   The shared buffer for data (nullptr for none)
+ * @param lane      The delivery lane
+ *
+ * @return true if the message was (apparently) sent
+ */
+bool NetcodeConnection::broadcast(const std::vector<std::byte>& data, const NetcodeMessage& message, Lane lane) {
+    bool relayed = false;
     bool success = true;
-    std::string uuid;
+    std::string uuid = _uuid;
+    std::string host;
     {
-        // Critical section
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        // Read the snapshot (no lock needed)
         if (_active && _state != State::MIGRATING) {
-            for(auto it = _peers.begin(); it != _peers.end(); ++it) {
-                // Locking downwards is allowed
-                auto peer = it->second;
-                std::lock_guard<std::recursive_mutex> sublock(peer->_mutex);
-                for(auto jt = peer->_channels.begin(); jt != peer->_channels.end(); ++jt) {
-                    if (jt->first == "public") {
-                        channels.push_back(jt->second);
-                    }
-                }
+            relayed = isStar() && !_ishost;
+            if (relayed) {
+                host = getRoster()->host;
             }
         } else {
             success = false;
@@ -1397,14 +2492,529 @@ bool NetcodeConnection::broadcast(const std::vector<std::byte>& data) {
     }
         
     // Do not hold locks on send
-    for(auto it = channels.begin(); it != channels.end(); ++it) {
-        success = (*it)->send(data) && success;
+    auto recorder = std::atomic_load(&_recorder);
+    if (success && recorder != nullptr) {
+        recorder->record(NetcodeRecorder::Direction::OUTBOUND,"",data);
+    }
+    if (!success) {
+        // Nothing to send
+    } else if (relayed) {
+        // The host sends it on to everyone else
+        NetcodeMessage frame = relay_frame(RELAY_BROADCAST,uuid,data);
+        success = transmit(host,*frame,frame,lane);
+    } else if (isStar() && !data.empty() && data[0] == RELAY_MARKER) {
+        NetcodeMessage frame = relay_frame(RELAY_DIRECT,"",data);
+        success = fanout(*frame,frame,lane,"");
+    } else {
+        success = fanout(data,message,lane,"");
     }
         
-    append(uuid,data);
+    append(_selfHandle,data);
+    return success;
+}
+
+/**
+ * Sends a voice frame to all other players.
+ *
+ * This method is like {@link #broadcast} on the unreliable lane, except
+ * that the frame is neither recorded nor delivered to this connection.
+ * Like any other message, a voice frame is batched and scheduled if those
+ * features are enabled, and so leaves on the next {@link #flush}.
+ *
+ * @param message   The voice frame to send.
+ *
+ * @return true if the frame was (apparently) sent
+ */
+bool NetcodeConnection::sendVoice(const NetcodeMessage& message) {
+    if (message == nullptr || !_active || _state == State::MIGRATING) {
+        return false;
+    }
+    
+    if (isStar() && !_ishost) {
+        // The host sends it on to everyone else
+        std::string host = getRoster()->host;
+        NetcodeMessage frame = relay_frame(RELAY_BROADCAST,_uuid,*message);
+        return transmit(host,*frame,frame,Lane::UNRELIABLE);
+    }
+    return fanout(*message,message,Lane::UNRELIABLE,"");
+}
+
+/**
+ * Sends a byte array along every peer connection but the given one.
+ *
+ * Like {@link #transmit}, this method does not relay, and it does not
+ * record the message. If message is not nullptr, it must hold the same
+ * bytes as data, and it is shared by every channel instead of data being
+ * copied for each peer. Spectators are always skipped. This method must
+ * NOT be called while holding the lock for this connection.
+ *
+ * If scheduling is enabled, the message is queued for {@link #flush}
+ * instead, unless direct is true.
+ *
+ * @param data      The byte array to send.
+ * @param message   The shared buffer for data (nullptr for none)
+ * @param lane      The delivery lane
+ * @param except    The UUID of the peer to skip (empty for none)
+ * @param direct    Whether to bypass the scheduler
+ *
+ * @return true if the message was (apparently) sent
+ */
+bool NetcodeConnection::fanout(const std::vector<std::byte>& data, const NetcodeMessage& message,
+                               Lane lane, const std::string& except, bool direct) {
+    if (!direct && _bandwidth != 0) {
+        return enqueue(except,true,data,message,lane);
+    }
+    
+    std::vector<std::shared_ptr<NetcodeChannel>> channels;
+    std::vector<std::vector<std::vector<std::byte>>> ready;
+    std::vector<NetcodeMessage> messages;
+    NetcodeMessage frames[3];
+    Uint8 tried = 0;
+    bool batched = false;
+    bool success = true;
+    {
+        // Critical section (only needed to batch or compress)
+        auto roster = getRoster();
+        if (!_active) {
+            return false;
+        }
+        
+        size_t threshold = _compression;
+        std::unique_lock<std::recursive_mutex> lock(_mutex,std::defer_lock);
+        if (_batching || threshold != 0) {
+            lock.lock();
+        }
+        batched = lock.owns_lock() && _batching;
+        for(auto it = roster->peers.begin(); it != roster->peers.end(); ++it) {
+            if (it->first == except || roster->spectators.count(it->first)) {
+                continue;
+            }
+            // Locking downwards is allowed
+            auto channel = getLaneChannel(it->second,lane);
+            if (channel != nullptr) {
+                channels.push_back(channel);
+                messages.push_back(encode(it->first,data,message,threshold,frames,tried));
+                if (batched) {
+                    ready.emplace_back();
+                    batch(it->first,lane,messages.back() != nullptr ? *messages.back() : data,ready.back());
+                }
+            }
+        }
+    }
+    
+    // Do not hold locks on send
+    _messagesSent += channels.size();
+    for(size_t ii = 0; ii < channels.size(); ii++) {
+        if (batched) {
+            for(auto it = ready[ii].begin(); it != ready[ii].end(); ++it) {
+                success = channels[ii]->send(*it) && success;
+            }
+        } else {
+            const NetcodeMessage& encoded = messages[ii];
+            success = send_single(channels[ii],encoded != nullptr ? *encoded : data,encoded) && success;
+        }
+    }
+    return success;
+}
+
+/**
+ * Queues a message for the scheduler.
+ *
+ * If the queue for the lane is at its depth limit, the oldest message is
+ * dropped for the unreliable lane (it is a stale snapshot). For the other
+ * lanes, the new message is rejected and this method returns false. This
+ * method must NOT be called while holding the lock for this connection.
+ *
+ * @param dst       The UUID of the peer to receive the message (or skip)
+ * @param fanout    Whether the message goes to every peer but dst
+ * @param data      The byte array to send.
+ * @param message   The shared buffer for data (nullptr for none)
+ * @param lane      The delivery lane
+ *
+ * @return true if the message was queued
+ */
+bool NetcodeConnection::enqueue(const std::string& dst, bool fanout, const std::vector<std::byte>& data,
+                                const NetcodeMessage& message, Lane lane) {
+    // Copy outside of the lock
+    NetcodeMessage shared = message;
+    if (shared == nullptr) {
+        shared = std::make_shared<const std::vector<std::byte>>(data);
+    }
+    
+    size_t count = 1;
+    if (fanout) {
+        auto roster = getRoster();
+        count = roster->peers.size();
+        if (!dst.empty() && roster->peers.find(dst) != roster->peers.end()) {
+            count--;
+        }
+    }
+    
+    // Critical section
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    if (!_active) {
+        return false;
+    }
+    
+    std::deque<Scheduled>& queue = _queues[(int)lane];
+    size_t depth = _laneDepth[(int)lane];
+    if (depth != 0 && queue.size() >= depth) {
+        if (lane != Lane::UNRELIABLE) {
+            if (_debug) {
+                CULogCategory(CU_LOG_CATEGORY_NETCODE,"NETCODE: Scheduler queue for lane %d is full",(int)lane);
+            }
+            return false;
+        }
+        queue.pop_front();
+    }
+    queue.push_back({dst,fanout,lane,shared,shared->size()*count});
+    return true;
+}
+
+/**
+ * Removes the messages to send this flush from the scheduler queues.
+ *
+ * The reliable lane is never held back. The unreliable lane is sent up to
+ * its budget, and the bulk lane only uses what is left of the bandwidth. A
+ * lane always sends its next message if there is any bandwidth left, so a
+ * flush may go over the bandwidth. The excess is taken from the next flush.
+ * If scheduling is disabled, every queued message is removed.
+ *
+ * This method must be called while holding the lock for this connection.
+ *
+ * @param sends The messages to send, in order
+ */
+void NetcodeConnection::schedule(std::vector<Scheduled>& sends) {
+    size_t bandwidth = _bandwidth;
+    if (bandwidth == 0) {
+        for(int lane = 0; lane < 3; lane++) {
+            std::move(_queues[lane].begin(),_queues[lane].end(),std::back_inserter(sends));
+            _queues[lane].clear();
+        }
+        _deficit = 0;
+        return;
+    }
+    
+    // Control is never held back
+    Sint64 budget = (Sint64)bandwidth-(Sint64)_deficit;
+    std::deque<Scheduled>& control = _queues[(int)Lane::RELIABLE];
+    for(auto it = control.begin(); it != control.end(); ++it) {
+        budget -= (Sint64)it->cost;
+        sends.push_back(std::move(*it));
+    }
+    control.clear();
+    
+    // The other lanes take what is left, in order of priority
+    for(int lane = (int)Lane::UNRELIABLE; lane <= (int)Lane::BULK; lane++) {
+        std::deque<Scheduled>& queue = _queues[lane];
+        size_t limit = _laneBudget[lane];
+        size_t spent = 0;
+        while (!queue.empty() && budget > 0 && (limit == 0 || spent < limit)) {
+            size_t cost = queue.front().cost;
+            if (spent != 0 && limit != 0 && spent+cost > limit) {
+                break;
+            }
+            spent  += cost;
+            budget -= (Sint64)cost;
+            sends.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+    }
+    
+    // Carry over the excess (but never more than a full flush)
+    _deficit = budget < 0 ? std::min((size_t)(-budget),bandwidth) : 0;
+}
+
+/**
+ * Sets the number of bytes to send each flush.
+ *
+ * When scheduling is enabled, messages to other peers are queued by lane,
+ * and are only sent when {@link #flush} is called. Each flush divides the
+ * bandwidth by priority. Messages on the reliable lane are always sent first,
+ * and are never held back. The unreliable lane comes next, up to its budget.
+ * The bulk lane only gets the bandwidth that is left over. So a large
+ * transfer on the bulk lane can never starve the state snapshots. Messages
+ * that do not fit stay queued for the next flush. The cost of a broadcast is
+ * its size times the number of peers.
+ *
+ * The bandwidth is a budget per flush, so it should be the uplink rate
+ * divided by the network frame rate. A value of 0 disables scheduling, and
+ * sends every queued message on the next flush.
+ *
+ * @param bytes The number of bytes to send each flush
+ */
+void NetcodeConnection::setBandwidth(size_t bytes) {
+    _bandwidth = bytes;
+}
+
+/**
+ * Sets the scheduling limits for the given lane.
+ *
+ * The budget is the maximum number of bytes the lane may send each flush,
+ * within the overall bandwidth. The depth is the maximum number of messages
+ * queued for the lane. When the unreliable lane is at its depth, it drops
+ * its oldest message. The other lanes refuse new messages, so that their
+ * senders know the message was not sent. A value of 0 means no limit. The
+ * budget has no effect on the reliable lane, which is never held back.
+ *
+ * These limits only matter if scheduling is enabled. By default, no lane
+ * has any limits.
+ *
+ * @param lane      The delivery lane
+ * @param budget    The maximum bytes to send each flush
+ * @param depth     The maximum number of queued messages
+ */
+void NetcodeConnection::setLaneSchedule(Lane lane, size_t budget, size_t depth) {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _laneBudget[(int)lane] = budget;
+    _laneDepth[(int)lane]  = depth;
+}
+
+/**
+ * Sets whether outgoing messages are batched.
+ *
+ * When batching is enabled, messages to the same peer along the same lane are
+ * packed together into a single datagram no larger than the MTU (as specified
+ * by {@link NetcodeConfig#mtu}). A datagram is sent once it is full, or when
+ * {@link #flush} is called. The receiving side unpacks these datagrams
+ * transparently, so this setting does not need to agree across connections.
+ *
+ * Disabling batching will flush any pending messages.
+ *
+ * @param value Whether outgoing messages are batched.
+ */
+void NetcodeConnection::setBatching(bool value) {
+    _batching = value;
+    if (!value) {
+        flush();
+    }
+}
+
+/**
+ * Sets the backpressure settings for the given lane.
+ *
+ * A data channel is congested when the number of bytes buffered (but not
+ * yet sent) reaches the high watermark, and stays congested until the buffered
+ * amount drops to the low watermark. While congested, messages are handled
+ * according to the policy. For example, stale state snapshots on the
+ * unreliable lane can be coalesced so that only the latest is sent.
+ *
+ * A high watermark of 0 disables backpressure. These settings apply to all
+ * existing and future data channels for that lane.
+ *
+ * By default, both lanes have a high watermark of 256 KB and a low watermark
+ * of 64 KB. The reliable lane queues messages, while the unreliable lane
+ * coalesces them. The bulk lane shares the settings of the reliable lane, as
+ * it uses the same data channel.
+ *
+ * @param lane      The delivery lane
+ * @param high      The high watermark in bytes
+ * @param low       The low watermark in bytes
+ * @param policy    How to handle messages when congested
+ */
+void NetcodeConnection::setBackpressure(Lane lane, size_t high, size_t low,
+                                        NetcodeChannel::Backpressure policy) {
+    if (lane == Lane::BULK) {
+        lane = Lane::RELIABLE;
+    }
+    _highWater[(int)lane] = high;
+    _lowWater[(int)lane]  = low;
+    _backpressure[(int)lane] = policy;
+    
+    std::vector<std::shared_ptr<NetcodeChannel>> channels;
+    {
+        // Critical section
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        for(auto it = _peers.begin(); it != _peers.end(); ++it) {
+            // Locking downwards is allowed
+            auto peer = it->second;
+            std::lock_guard<std::recursive_mutex> sublock(peer->_mutex);
+            auto jt = peer->_channels.find(lane == Lane::RELIABLE ? NETCODE_RELIABLE_CHANNEL
+                                                                  : NETCODE_UNRELIABLE_CHANNEL);
+            if (jt != peer->_channels.end()) {
+                channels.push_back(jt->second);
+            }
+        }
+    }
+    
+    for(auto it = channels.begin(); it != channels.end(); ++it) {
+        (*it)->setBackpressure(high,low,policy);
+    }
+}
+
+/**
+ * Sets the network simulator of this connection.
+ *
+ * Once set, every datagram sent or received on a data channel of this
+ * connection passes through the simulator, which can delay, drop, or
+ * duplicate it according to the conditions for that peer. The conditions
+ * apply to each direction, so a simulated latency is added twice to the
+ * round trip time. This setting applies to all existing and future data
+ * channels of this connection.
+ *
+ * This is a debugging tool, and is off by default. Setting it to nullptr
+ * stops the simulation, though datagrams already held by the simulator
+ * are still delivered.
+ *
+ * @param simulator The network simulator of this connection
+ */
+void NetcodeConnection::setSimulator(const std::shared_ptr<NetcodeSimulator>& simulator) {
+    std::atomic_store(&_simulator,simulator);
+    
+    std::vector<std::shared_ptr<NetcodeChannel>> channels;
+    {
+        // Critical section
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        for(auto it = _peers.begin(); it != _peers.end(); ++it) {
+            // Locking downwards is allowed
+            auto peer = it->second;
+            std::lock_guard<std::recursive_mutex> sublock(peer->_mutex);
+            for(auto jt = peer->_channels.begin(); jt != peer->_channels.end(); ++jt) {
+                channels.push_back(jt->second);
+            }
+        }
+    }
+    
+    for(auto it = channels.begin(); it != channels.end(); ++it) {
+        (*it)->setSimulator(simulator);
+    }
+}
+
+/**
+ * Called when a congested data channel drains to its low watermark
+ *
+ * This method schedules the {@link #onWritable} callback (if any).
+ *
+ * @param uuid  The UUID of the peer for the data channel
+ */
+void NetcodeConnection::onChannelWritable(const std::string uuid) {
+    std::function<bool()> callback;
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        if (_active && _onWritable) {
+            callback = [=]() {
+                _onWritable(uuid);
+                return false;
+            };
+        }
+    }
+    if (callback) {
+        deliver(callback);
+    }
+}
+
+/**
+ * Sends all pending batched messages.
+ *
+ * If batching is enabled, this method should be called at the end of every
+ * network frame. Otherwise messages may never be sent. If scheduling is
+ * enabled, this method first sends the queued messages allowed by the
+ * bandwidth (see {@link #setBandwidth}). If neither is enabled, this method
+ * does nothing.
+ *
+ * @return true if the messages were (apparently) sent
+ */
+bool NetcodeConnection::flush() {
+    bool success = true;
+    std::vector<Scheduled> sends;
+    {
+        // Critical section
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        schedule(sends);
+    }
+    
+    // Do not hold locks on send (sends may add to the batches)
+    for(auto it = sends.begin(); it != sends.end(); ++it) {
+        const std::vector<std::byte>& data = *(it->message);
+        if (it->fanout) {
+            success = fanout(data,it->message,it->lane,it->dst,true) && success;
+        } else {
+            success = transmit(it->dst,data,it->message,it->lane,true) && success;
+        }
+    }
+    sends.clear();
+    
+    std::vector<std::shared_ptr<NetcodeChannel>> channels;
+    std::vector<std::vector<std::byte>> datagrams;
+    {
+        // Critical section
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        for(int lane = 0; lane < 2; lane++) {
+            for(auto it = _batches[lane].begin(); it != _batches[lane].end(); ++it) {
+                if (it->second.empty()) {
+                    continue;
+                }
+                auto find = _peers.find(it->first);
+                if (find != _peers.end()) {
+                    // Locking downwards is allowed
+                    auto channel = getLaneChannel(find->second,(Lane)lane);
+                    if (channel != nullptr) {
+                        channels.push_back(channel);
+                        datagrams.push_back(std::move(it->second));
+                    }
+                }
+                it->second.clear();
+            }
+        }
+    }
+    
+    // Do not hold locks on send
+    for(size_t ii = 0; ii < channels.size(); ii++) {
+        success = channels[ii]->send(datagrams[ii]) && success;
+    }
     return success;
 }
 
+/**
+ * Returns the compression dictionary of this connection.
+ *
+ * If no dictionary has been set, this method returns an empty vector.
+ *
+ * @return the compression dictionary of this connection.
+ */
+std::vector<std::byte> NetcodeConnection::getDictionary() {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    return _compressor->getDictionary();
+}
+
+/**
+ * Sets the compression dictionary of this connection.
+ *
+ * A dictionary makes mid-size messages compress much better, particularly
+ * if it is trained on typical messages with {@link NetcodeCompressor#train}.
+ * The dictionary is only used for a peer that has the same dictionary, as
+ * announced during compression negotiation. Changing the dictionary will
+ * announce the new dictionary to all peers.
+ *
+ * The dictionary should be set before the connection is opened, and be the
+ * same on every connection. Otherwise messages compressed with the previous
+ * dictionary may be dropped while the announcement is in flight.
+ *
+ * @param dictionary    The compression dictionary
+ */
+void NetcodeConnection::setDictionary(const std::vector<std::byte>& dictionary) {
+    auto compressor = NetcodeCompressor::alloc(dictionary);
+    std::vector<std::shared_ptr<NetcodeChannel>> channels;
+    {
+        // Critical section
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _compressor = compressor;
+        for(auto it = _peers.begin(); it != _peers.end(); ++it) {
+            // Locking downwards is allowed
+            auto channel = getLaneChannel(it->second,Lane::RELIABLE);
+            if (channel != nullptr) {
+                channels.push_back(channel);
+            }
+        }
+    }
+    
+    // Do not hold locks on send
+    std::vector<std::byte> hello = compress_hello(compressor->getDictionaryHash());
+    for(auto it = channels.begin(); it != channels.end(); ++it) {
+        (*it)->send(hello);
+    }
+}
+
 /**
  * Receives incoming network messages.
  *
@@ -1416,6 +3026,10 @@ bool NetcodeConnection::broadcast(const std::vector<std::byte>& data) {
  * function should be prepared to be called multiple times a render frame, or even
  * not at all.
  *
+ * No locks are held while the dispatcher runs, so a slow dispatcher never stalls
+ * the threads delivering network messages. Messages that arrive during the call
+ * may be dispatched as part of this call.
+ *
  * If a dispatcher callback has been registered with {@link #onReceipt}, this
  * method will never do anything. In that case, messages are not buffered and are
  * processed as soon as they are received.
@@ -1427,22 +3041,71 @@ void NetcodeConnection::receive(const Dispatcher& dispatcher) {
 		return;
 	}
 	
-	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	size_t off = 0;
-	for (auto it = _buffer.begin()+_buffhead; it != _buffer.end() && off < _buffsize; off++, ++it) {
-		dispatcher(it->source,it->message);
-		it->source.clear();
-		it->message.clear();
+	// No lock is held while dispatching
+	auto roster = getRoster();
+	Envelope env;
+	while (_inbound.pop(env)) {
+		if (env.source >= roster->names.size()) {
+			roster = getRoster();
+		}
+		dispatcher(roster->getName(env.source),env.message);
 	}
-	// Wrap around ring buffer
-	for (auto it = _buffer.begin(); it != _buffer.end() && off < _buffsize; off++, ++it) {
-		dispatcher(it->source,it->message);
-		it->source.clear();
-		it->message.clear();
+}
+
+/**
+ * Consumes incoming network messages.
+ *
+ * This method is identical to {@link #receive}, except that the message data
+ * is moved to the consumer instead of passed by reference. Use this method
+ * when the messages need to outlive the call (e.g. they are queued for later
+ * processing), as it avoids copying each message.
+ *
+ * If a dispatcher callback has been registered with {@link #onReceipt}, this
+ * method will never do anything. In that case, messages are not buffered and are
+ * processed as soon as they are received.
+ *
+ * @param consumer  The function to take the received data
+ */
+void NetcodeConnection::consume(const Consumer& consumer) {
+	if (consumer == nullptr || _socket == nullptr) {
+		return;
 	}
 	
-	_buffhead = ((_buffhead + off) % _buffer.size());
-	_buffsize -= off;
+	// No lock is held while dispatching
+	auto roster = getRoster();
+	Envelope env;
+	while (_inbound.pop(env)) {
+		if (env.source >= roster->names.size()) {
+			roster = getRoster();
+		}
+		consumer(roster->getName(env.source),std::move(env.message));
+	}
+}
+
+/**
+ * Consumes incoming network messages, identifying sources by handle.
+ *
+ * This method is identical to {@link #consume}, except that the source of
+ * each message is a {@link PeerHandle} instead of a UUID. No strings are
+ * copied on this path. Use {@link #getPeerName} to recover the UUID of a
+ * handle when it is needed.
+ *
+ * If a dispatcher callback has been registered with {@link #onReceipt}, this
+ * method will never do anything. In that case, messages are not buffered and are
+ * processed as soon as they are received.
+ *
+ * @param consumer  The function to take the received data
+ */
+void NetcodeConnection::consumeByHandle(const HandleConsumer& consumer) {
+	if (consumer == nullptr || _socket == nullptr) {
+		return;
+	}
+	
+	// No lock is held while dispatching
+	Envelope env;
+	while (_inbound.pop(env)) {
+		consumer(env.source,std::move(env.message));
+	}
 }
 
 /**
@@ -1460,7 +3123,7 @@ void NetcodeConnection::startSession() {
 			response->appendValue("type",std::string("lobby"));
 			response->appendValue("category",std::string("session"));
 			response->appendValue("status",std::string("request"));
-			_socket->send(response->toString());
+			_socket->send(response->toString(false));
 		}
 	}
 }
@@ -1483,13 +3146,33 @@ void NetcodeConnection::endSession() {
             response->appendValue("type",std::string("lobby"));
             response->appendValue("category",std::string("session"));
             response->appendValue("status",std::string("shutdown"));
-            _socket->send(response->toString());
+            _socket->send(response->toString(false));
         }
     }
 }
     
 #pragma mark -
 #pragma mark Callbacks
+/**
+ * Sets the scheduler for the user callbacks of this connection.
+ *
+ * By default, all callback functions are scheduled with {@link Application},
+ * so that they are called on the main thread at the start of an animation
+ * frame. A connection that is not owned by the main thread (such as one of
+ * many sessions on a dedicated server) should provide a scheduler that runs
+ * the callbacks on its own thread. See {@link Scheduler}.
+ *
+ * This method must be called before {@link #open}. Setting the scheduler to
+ * nullptr restores the default.
+ *
+ * @param scheduler The scheduler for user callbacks
+ */
+void NetcodeConnection::setScheduler(Scheduler scheduler) {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    CUAssertLog(!_active, "The scheduler must be set before the connection is opened");
+    _scheduler = scheduler;
+}
+
 /**
  * Sets a callback function to invoke on message receipt
  *
@@ -1506,6 +3189,26 @@ void NetcodeConnection::endSession() {
 void NetcodeConnection::onReceipt(Dispatcher callback) {
     std::lock_guard<std::recursive_mutex> lock(_mutex);
     _onReceipt = callback;
+    _hasReceipt = (callback != nullptr);
+}
+
+/**
+ * Sets a callback function to invoke when a congested peer becomes writable
+ *
+ * A peer is congested when one of its data channels buffers more bytes than
+ * the high watermark set by {@link #setBackpressure}. This callback is invoked
+ * once that data channel drains to its low watermark. The uuid sent to the
+ * callback identifies the peer.
+ *
+ * All callback functions are guaranteed to be called on the main thread. They
+ * are called at the start of an animation frame, before the method
+ * {@link Application#update(float) }.
+ *
+ * @param callback  The writable callback
+ */
+void NetcodeConnection::onWritable(ConnectionCallback callback) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	_onWritable = callback;
 }
 
 /**
@@ -49,6 +49,7 @@
 #include <cugl/net/CUNetcodeChannel.h>
 #include <cugl/net/CUNetcodeConnection.h>
 #include <cugl/net/CUNetcodePeer.h>
+#include <cugl/net/CUNetworkLayer.h>
 #include <cugl/assets/CUJsonValue.h>
 #include <cugl/util/CUDebug.h>
 #include <cstring>
@@ -57,6 +58,41 @@ using namespace cugl::net;
 using namespace std;
 using namespace rtc;
 
+/**
+ * Returns the abbreviated ICE type of the given candidate
+ *
+ * @param candidate	The ICE candidate
+ *
+ * @return the abbreviated ICE type of the given candidate
+ */
+static std::string candidate_type(const rtc::Candidate& candidate) {
+	switch (candidate.type()) {
+	case rtc::Candidate::Type::Host:
+		return "host";
+	case rtc::Candidate::Type::ServerReflexive:
+		return "srflx";
+	case rtc::Candidate::Type::PeerReflexive:
+		return "prflx";
+	case rtc::Candidate::Type::Relayed:
+		return "relay";
+	default:
+		break;
+	}
+	return "unknown";
+}
+
+/**
+ * Returns a description of the type and address of the given candidate
+ *
+ * @param candidate	The ICE candidate
+ *
+ * @return a description of the type and address of the given candidate
+ */
+static std::string candidate_string(const rtc::Candidate& candidate) {
+	std::string result = candidate_type(candidate)+" "+candidate.address().value_or("?");
+	return result+":"+std::to_string(candidate.port().value_or(0));
+}
+
 #pragma mark Constructors
 /**
  * Creates a degenerate RTC peer connection.
@@ -71,6 +107,7 @@ NetcodePeer::NetcodePeer() :
 	_uuid(""), 
 	_connection(nullptr), 
 	_offered(false),
+	_holding(false),
 	_debug(false),
 	_open(false),
 	_active(false) {}
@@ -157,10 +194,29 @@ bool NetcodePeer::init(const std::weak_ptr<NetcodeConnection>& parent,
 	_parent = parent;
 	_active = true;
 	_offered = offered;
+	_holding = id.empty();
+	_stats = std::make_shared<NetcodeCounters>(p->_stats);
 	
 	// Atomics.  Safe to get without locks
 	rtc::Configuration config = p->_rtcconfig;
 	bool debug = p->_debug;
+	
+	// Use any ICE servers resolved since the connection was configured, nearest first
+	if (NetworkLayer::get() != nullptr) {
+		config.iceServers.clear();
+		size_t relays = 0;
+		auto servers = NetworkLayer::get()->rank(p->_config.iceServers);
+		for(auto it = servers.begin(); it != servers.end(); ++it) {
+			if (it->turn && p->_config.maxRelays > 0 && relays++ >= p->_config.maxRelays) {
+				continue;
+			}
+			config.iceServers.emplace_back(it->toString());
+			if (debug) {
+				CULog("NETCODE: ICE server %s:%d has round trip %lld ms",it->address.c_str(),
+				      (int)it->port,(long long)NetworkLayer::get()->getRTT(*it));
+			}
+		}
+	}
 	_debug = debug;
 	if (!p->_active) {
 		return false;
@@ -216,6 +272,9 @@ void NetcodePeer::onStateChange(rtc::PeerConnection::State state) {
 			case rtc::PeerConnection::State::Closed:
 				CULog("NETCODE: Peer %s closed",_uuid.c_str());
 				break;
+			case rtc::PeerConnection::State::Connected:
+				CULog("NETCODE: Peer %s connected via %s",_uuid.c_str(),getPathDescription().c_str());
+				break;
 			default:
 				break;
 			}
@@ -264,7 +323,12 @@ void NetcodePeer::onLocalDescription(rtc::Description description) {
 	// Critical section
 	{
 		std::lock_guard<std::recursive_mutex> lock(_mutex);
-		if (_active) {
+		if (_active && _holding) {
+			// The id is added once we know who this is for
+			json->appendValue("type",description.typeString());
+			json->appendValue("description",std::string(description));
+			_signals.push_back(json);
+		} else if (_active) {
 			json->appendValue("id",_uuid);
 			json->appendValue("type",description.typeString());
 			json->appendValue("description",std::string(description));
@@ -275,7 +339,7 @@ void NetcodePeer::onLocalDescription(rtc::Description description) {
 	// NEVER lock upwards
 	if (parent != nullptr) {
 		std::lock_guard<std::recursive_mutex> lock(parent->_mutex);
-		parent->_socket->send(json->toString());
+		parent->_socket->send(json->toString(false));
 	}	
 }
 
@@ -297,7 +361,13 @@ void NetcodePeer::onLocalCandidate(rtc::Candidate candidate) {
 	// Critical section
 	{
 		std::lock_guard<std::recursive_mutex> lock(_mutex);
-		if (_active) {
+		if (_active && _holding) {
+			// The id is added once we know who this is for
+			json->appendValue("type",std::string("candidate"));
+			json->appendValue("candidate",std::string(candidate));
+			json->appendValue("mid",candidate.mid());
+			_signals.push_back(json);
+		} else if (_active) {
 			json->appendValue("id",_uuid);
 			json->appendValue("type",std::string("candidate"));
 			json->appendValue("candidate",std::string(candidate));
@@ -309,7 +379,7 @@ void NetcodePeer::onLocalCandidate(rtc::Candidate candidate) {
     // NEVER lock upwards
 	if (parent != nullptr) {
 		std::lock_guard<std::recursive_mutex> lock(parent->_mutex);
-		parent->_socket->send(json->toString());
+		parent->_socket->send(json->toString(false));
 	}	
 }
 
@@ -367,6 +437,8 @@ void NetcodePeer::onChannelClosed(const std::string label) {
  *
  * In our experiments, it is only safe to open one data channel at a time.
  * This callback informs this peer when it is safe to make a new channel.
+ * Hence the offering peer creates the unreliable channel only once the
+ * reliable channel has opened.
  *
  * @param label The data channel label
  */
@@ -386,8 +458,13 @@ void NetcodePeer::onChannelOpened(const std::string label) {
 			uuid = _uuid;
 		}
 	}
-	if (label == "public") {
-		parent->onPeerEstablished(uuid);
+	if (label == NETCODE_RELIABLE_CHANNEL) {
+		if (offered) {
+			createChannel(NETCODE_UNRELIABLE_CHANNEL,false);
+		}
+		if (parent != nullptr) {
+			parent->onPeerEstablished(uuid);
+		}
 	}
 }
 
@@ -396,13 +473,16 @@ void NetcodePeer::onChannelOpened(const std::string label) {
  *
  * There can only be one data channel of any label.
  *
+ * @param label     The data channel label
+ * @param reliable  Whether the data channel is reliable and ordered
+ *
  * @return true if creation was successful.
  */
-bool NetcodePeer::createChannel(const std::string label) {
+bool NetcodePeer::createChannel(const std::string label, bool reliable) {
 	std::weak_ptr<NetcodePeer> wp = shared_from_this();
     
     // DO NOT HOLD LOCK HERE
-    std::shared_ptr<NetcodeChannel> channel = NetcodeChannel::alloc(wp,label);
+    std::shared_ptr<NetcodeChannel> channel = NetcodeChannel::alloc(wp,label,reliable);
 	
 	// Critical section
 	{
@@ -418,7 +498,83 @@ bool NetcodePeer::createChannel(const std::string label) {
 	return false;
 }
 
+/**
+ * Assigns this peer connection to the device with the given id.
+ *
+ * A {@link NetcodeConnection} creates a spare peer connection with an empty
+ * id before it knows who it will connect to. That way, the expensive setup
+ * (and for an offered connection, ICE gathering) overlaps with the lobby
+ * negotiation. The local description and candidates gathered so far are
+ * held back until this method is called, at which point they are sent in
+ * order.
+ *
+ * @param id        The unique id for this peer
+ */
+void NetcodePeer::assign(const std::string id) {
+	std::shared_ptr<NetcodeConnection> parent = nullptr;
+	
+	// Critical section
+	{
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		if (!_active) {
+			return;
+		}
+		_uuid = id;
+		for(auto it = _channels.begin(); it != _channels.end(); ++it) {
+			// Locking downwards is allowed
+			std::lock_guard<std::recursive_mutex> sublock(it->second->_mutex);
+			it->second->_uuid = id;
+			it->second->_handle = NETCODE_NO_HANDLE;
+		}
+		parent = _parent.lock();
+		if (_debug) {
+			CULog("NETCODE: Assigned spare peer connection to %s",_uuid.c_str());
+		}
+	}
+	
+	// Keep holding until everything gathered so far has been sent
+	while (true) {
+		std::vector<std::shared_ptr<JsonValue>> signals;
+		{
+			std::lock_guard<std::recursive_mutex> lock(_mutex);
+			if (_signals.empty() || parent == nullptr) {
+				_signals.clear();
+				_holding = false;
+				return;
+			}
+			signals.swap(_signals);
+		}
+		
+		// NEVER lock upwards
+		std::lock_guard<std::recursive_mutex> lock(parent->_mutex);
+		for(auto it = signals.begin(); it != signals.end(); ++it) {
+			(*it)->appendValue("id",id);
+			parent->_socket->send((*it)->toString(false));
+		}
+	}
+}
+
 #pragma mark Communication
+/**
+ * Returns the network statistics for this peer.
+ *
+ * The statistics include the bytes and packets sent and received along all
+ * data channels, the number of bytes buffered in the data channels, and
+ * the most recent round trip time. The message counts, drops, and queue
+ * depth are only tracked by {@link NetcodeConnection#getStats}.
+ *
+ * All of these values are atomic, so this method never takes a lock.
+ *
+ * @return the network statistics for this peer.
+ */
+NetcodeStats NetcodePeer::getStats() const {
+	NetcodeStats result;
+	if (_stats != nullptr) {
+		_stats->snapshot(result);
+	}
+	return result;
+}
+
 /**
  * Returns the data channel with the associated label.
  *
@@ -460,6 +616,54 @@ const std::shared_ptr<NetcodeConnection> NetcodePeer::getConnection() {
     return _parent.lock();
 }
 
+/**
+ * Returns the network path of this peer connection.
+ *
+ * The path is given by the ICE candidate pair selected by the connection.
+ * Use this method to spot relayed sessions. The round trip time of the
+ * path is the rtt of {@link #getStats}.
+ *
+ * This method is not const because it requires a lock.
+ *
+ * @return the network path of this peer connection.
+ */
+NetcodePeer::Path NetcodePeer::getPath() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	rtc::Candidate local, remote;
+	if (_connection == nullptr || !_connection->getSelectedCandidatePair(&local,&remote)) {
+		return Path::UNKNOWN;
+	}
+	
+	rtc::Candidate::Type ltype = local.type();
+	rtc::Candidate::Type rtype = remote.type();
+	if (ltype == rtc::Candidate::Type::Relayed || rtype == rtc::Candidate::Type::Relayed) {
+		return Path::RELAYED;
+	} else if (ltype == rtc::Candidate::Type::Host && rtype == rtc::Candidate::Type::Host) {
+		return Path::DIRECT;
+	}
+	return Path::REFLEXIVE;
+}
+
+/**
+ * Returns a description of the selected candidate pair.
+ *
+ * The description has the type and address of the local and the remote
+ * candidate, such as "srflx 1.2.3.4:5000 <-> relay 5.6.7.8:3478". It is
+ * the empty string if no pair is selected yet.
+ *
+ * This method is not const because it requires a lock.
+ *
+ * @return a description of the selected candidate pair.
+ */
+std::string NetcodePeer::getPathDescription() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	rtc::Candidate local, remote;
+	if (_connection == nullptr || !_connection->getSelectedCandidatePair(&local,&remote)) {
+		return "";
+	}
+	return candidate_string(local)+" <-> "+candidate_string(remote);
+}
+
 /**
  * Closes this peer connection.
  *
@@ -521,6 +725,49 @@ bool NetcodePeer::send(const std::string channel, const std::vector<std::byte>&
 	return false;
 }
 
+/**
+ * Sends a shared message buffer along the data channel of the given name
+ *
+ * This method is identical to {@link #send}, except that the message is
+ * never copied on its way to the data channel. So the same message can be
+ * sent to several peers while only being stored once.
+ *
+ * @param channel   The data channel label
+ * @param message   The message to send
+ *
+ * @return true if transmission was (apparently) successful
+ */
+bool NetcodePeer::send(const std::string channel, const NetcodeMessage& message) {
+	std::shared_ptr<NetcodeChannel> stream = nullptr;
+	std::string uuid  = "";
+	if (message == nullptr) {
+		return false;
+	}
+	
+	// Critical section
+	{
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+		if (_active) {
+			auto it = _channels.find(channel);
+			if (it == _channels.end()) {
+				return false;
+			}
+			uuid = _uuid;
+			stream = it->second;	
+		}
+	}
+	
+	// Hold no more than one lock at a time
+	if (stream != nullptr) {
+		if (_debug) {
+			CULog("NETCODE: Peer connection %s sending %zu bytes data channel '%s'",uuid.c_str(),message->size(),channel.c_str());
+		}
+		stream->send(message);
+		return true;	
+	}
+	return false;
+}
+
 /**
  * Toggles the debugging status of this peer.
  *
@@ -0,0 +1,369 @@
+//
+//  CUNetcodeRecorder.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module is part of a Web RTC implementation of the classic CUGL networking
+//  library. It provides a tap for NetcodeConnection that records every message
+//  sent or received to a trace file. The trace can be read back with the class
+//  NetcodeReplay, which is how a desynchronized match is debugged offline.
+//
+//  The trace is written on a background thread, so that recording never delays
+//  the threads delivering network messages. The format is a compact binary
+//  format written with BinaryWriter.
+//
+//  These classes uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/net/CUNetcodeRecorder.h>
+#include <cugl/io/CUBinaryWriter.h>
+#include <cugl/io/CUBinaryReader.h>
+#include <cugl/util/CUDebug.h>
+#include <chrono>
+
+using namespace cugl;
+using namespace cugl::net;
+
+/** The magic number at the start of every trace ("CUNT") */
+#define TRACE_MAGIC     0x43554E54
+/** The version of the trace format */
+#define TRACE_VERSION   1
+/** A record introducing a peer UUID */
+#define TRACE_PEER      0
+/** A record of an inbound message */
+#define TRACE_INBOUND   1
+/** A record of an outbound message */
+#define TRACE_OUTBOUND  2
+/** The size of a message record header (kind, time, peer, and size) */
+#define TRACE_HEADER    (1+sizeof(Uint64)+sizeof(Uint16)+sizeof(Uint32))
+/** The initial capacity of the record queue */
+#define TRACE_QUEUE     256
+/** The buffer capacity of the trace writer */
+#define TRACE_BUFFER    65536
+/** How long the writing thread sleeps when there are no records (in ms) */
+#define TRACE_SLEEP     10
+
+#pragma mark -
+#pragma mark NetcodeRecorder
+/**
+ * Creates a degenerate recorder.
+ *
+ * This object has not been initialized with a file and cannot be used.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+NetcodeRecorder::NetcodeRecorder() :
+    _queue(TRACE_QUEUE,OverflowPolicy::GROW),
+    _active(false),
+    _count(0) {
+}
+
+/**
+ * Disposes all of the resources used by this recorder.
+ *
+ * This method blocks until every record accepted so far is written to the
+ * file, and then closes the file. A disposed recorder can be safely
+ * reinitialized.
+ */
+void NetcodeRecorder::dispose() {
+    _active.store(false);
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    _writer = nullptr;
+    _peers.clear();
+    _count.store(0);
+}
+
+/**
+ * Initializes a recorder for the given file.
+ *
+ * If the file is a relative path, it is placed in the application save
+ * directory (see {@link BinaryWriter}). Any existing file is replaced.
+ * The trace starts at the time of this call.
+ *
+ * @param file  The path to the trace file
+ *
+ * @return true if the recorder is initialized properly, false otherwise.
+ */
+bool NetcodeRecorder::init(const std::string file) {
+    if (_writer != nullptr) {
+        CUAssertLog(false, "Recorder is already initialized");
+        return false;
+    }
+
+    _writer = BinaryWriter::alloc(file,TRACE_BUFFER);
+    if (_writer == nullptr) {
+        return false;
+    }
+    _writer->writeUint32(TRACE_MAGIC);
+    _writer->writeUint16(TRACE_VERSION);
+    _writer->flush();
+
+    _start.mark();
+    _active.store(true);
+    _thread = std::thread([this]() { run(); });
+    return true;
+}
+
+/**
+ * Writes records to the file until this recorder is disposed.
+ *
+ * This is the body of the writing thread. It drains the queue of records,
+ * flushing the file after each batch, and sleeps when there are none.
+ */
+void NetcodeRecorder::run() {
+    Record record;
+    while (true) {
+        // Check before draining, so that no accepted record is lost
+        bool active = _active.load();
+        bool wrote = false;
+        while (_queue.pop(record)) {
+            write(record);
+            wrote = true;
+        }
+        if (wrote) {
+            _writer->flush();
+        }
+        if (!active) {
+            break;
+        } else if (!wrote) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(TRACE_SLEEP));
+        }
+    }
+    _writer->close();
+}
+
+/**
+ * Writes a single record to the file.
+ *
+ * If the peer of this record has not been seen before, this method writes
+ * the peer UUID first. This method must only be called by the writing
+ * thread.
+ *
+ * @param record    The record to write
+ */
+void NetcodeRecorder::write(const Record& record) {
+    Uint16 index;
+    auto it = _peers.find(record.peer);
+    if (it == _peers.end()) {
+        index = (Uint16)_peers.size();
+        _peers.emplace(record.peer,index);
+        _writer->writeUint8(TRACE_PEER);
+        _writer->writeUint16(index);
+        _writer->writeUint16((Uint16)record.peer.size());
+        _writer->write(record.peer.c_str(),record.peer.size());
+    } else {
+        index = it->second;
+    }
+
+    _writer->writeUint8(record.direction == Direction::INBOUND ? TRACE_INBOUND : TRACE_OUTBOUND);
+    _writer->writeUint64(record.time);
+    _writer->writeUint16(index);
+    _writer->writeUint32((Uint32)record.message.size());
+    _writer->write(reinterpret_cast<const Uint8*>(record.message.data()),record.message.size());
+}
+
+/**
+ * Records a single message.
+ *
+ * This method may be called from any thread. It copies the message and
+ * returns immediately, as the record is written by the background thread.
+ * It returns false if this recorder is not active.
+ *
+ * @param direction The message direction
+ * @param peer      The UUID of the peer on the other end
+ * @param data      The message data
+ *
+ * @return true if the message was recorded
+ */
+bool NetcodeRecorder::record(Direction direction, const std::string& peer, const std::vector<std::byte>& data) {
+    if (!_active.load()) {
+        return false;
+    }
+
+    Timestamp now;
+    Record record;
+    record.time = now.ellapsedMicros(_start);
+    record.direction = direction;
+    record.peer = peer;
+    record.message = data;
+    _queue.push(std::move(record));
+    _count++;
+    return true;
+}
+
+#pragma mark -
+#pragma mark NetcodeReplay
+/**
+ * Disposes all of the resources used by this replay.
+ *
+ * A disposed replay can be safely reinitialized.
+ */
+void NetcodeReplay::dispose() {
+    _reader = nullptr;
+    _peers.clear();
+    _next = NetcodeRecorder::Record();
+    _ready = false;
+    _file.clear();
+}
+
+/**
+ * Initializes a replay of the given trace file.
+ *
+ * If the file is a relative path, it is read from the application save
+ * directory (see {@link BinaryReader}). This method returns false if the
+ * file does not exist or is not a trace.
+ *
+ * @param file  The path to the trace file
+ *
+ * @return true if the replay is initialized properly, false otherwise.
+ */
+bool NetcodeReplay::init(const std::string file) {
+    if (_reader != nullptr) {
+        CUAssertLog(false, "Replay is already initialized");
+        return false;
+    }
+    _file = file;
+    if (!start()) {
+        dispose();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Opens the trace file and reads its header, returning true if it is valid.
+ *
+ * If the header is valid, this method also reads the first record.
+ *
+ * @return true if the file header is valid
+ */
+bool NetcodeReplay::start() {
+    _peers.clear();
+    _ready = false;
+    _reader = BinaryReader::alloc(_file);
+    if (_reader == nullptr) {
+        return false;
+    }
+    if (!_reader->ready(sizeof(Uint32)+sizeof(Uint16)) || _reader->readUint32() != TRACE_MAGIC) {
+        CULogError("NETCODE: '%s' is not a network trace",_file.c_str());
+        return false;
+    }
+    Uint16 version = _reader->readUint16();
+    if (version != TRACE_VERSION) {
+        CULogError("NETCODE: Network trace '%s' has unsupported version %d",_file.c_str(),version);
+        return false;
+    }
+    advance();
+    return true;
+}
+
+/**
+ * Reads the next message record into _next
+ *
+ * Any peer records along the way are added to the peer table. This
+ * method sets _ready to false if there are no more complete records.
+ */
+void NetcodeReplay::advance() {
+    _ready = false;
+    while (_reader->ready(1)) {
+        Uint8 kind = _reader->readByte();
+        if (kind == TRACE_PEER) {
+            if (!_reader->ready(2*sizeof(Uint16))) {
+                return;
+            }
+            Uint16 index  = _reader->readUint16();
+            Uint16 length = _reader->readUint16();
+            if (index != _peers.size() || !_reader->ready(length)) {
+                return;
+            }
+            std::string peer(length,'\0');
+            if (length > 0) {
+                _reader->read(&peer[0],length);
+            }
+            _peers.push_back(std::move(peer));
+        } else if (kind == TRACE_INBOUND || kind == TRACE_OUTBOUND) {
+            if (!_reader->ready(TRACE_HEADER-1)) {
+                return;
+            }
+            _next.time  = _reader->readUint64();
+            Uint16 index = _reader->readUint16();
+            Uint32 size  = _reader->readUint32();
+            if (index >= _peers.size() || (size > 0 && !_reader->ready(size))) {
+                return;
+            }
+            _next.direction = (kind == TRACE_INBOUND ? NetcodeRecorder::Direction::INBOUND :
+                                                       NetcodeRecorder::Direction::OUTBOUND);
+            _next.peer = _peers[index];
+            _next.message.resize(size);
+            if (size > 0) {
+                _reader->read(reinterpret_cast<Uint8*>(_next.message.data()),size);
+            }
+            _ready = true;
+            return;
+        } else {
+            CULogError("NETCODE: Corrupt record in network trace '%s'",_file.c_str());
+            return;
+        }
+    }
+}
+
+/**
+ * Reads the next record of the trace.
+ *
+ * This method returns false if there are no more records, in which case
+ * record is unchanged.
+ *
+ * @param record    The record to store the result
+ *
+ * @return true if a record was read
+ */
+bool NetcodeReplay::next(NetcodeRecorder::Record& record) {
+    if (!_ready) {
+        return false;
+    }
+    record = std::move(_next);
+    _next = NetcodeRecorder::Record();
+    advance();
+    return true;
+}
+
+/**
+ * Rewinds this replay to the start of the trace.
+ */
+void NetcodeReplay::reset() {
+    if (_reader != nullptr) {
+        start();
+    }
+}
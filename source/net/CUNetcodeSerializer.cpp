@@ -48,15 +48,45 @@
 // With thanks to the students of CS 4152 Spring 2021 for beta testing this class.
 //
 #include <cugl/net/CUNetcodeSerializer.h>
+#include <cugl/net/CUNetcodeWriter.h>
 #include <cugl/assets/CUJsonValue.h>
 #include <cugl/base/CUEndian.h>
+#include <cugl/util/CUDebug.h>
 
 #include <stdexcept>
-#include <sstream>
+#include <algorithm>
+#include <cstring>
 
 using namespace cugl;
 using namespace cugl::net;
 
+#pragma mark -
+#pragma mark Encoding Helpers
+/**
+ * Returns the zigzag encoding of a signed integer.
+ *
+ * This maps small negative numbers to small positive numbers, so that they have
+ * short variable length encodings.
+ *
+ * @param value The signed integer
+ *
+ * @return the zigzag encoding of a signed integer.
+ */
+static inline Uint64 zigzag(Sint64 value) {
+    return (static_cast<Uint64>(value) << 1) ^ static_cast<Uint64>(value >> 63);
+}
+
+/**
+ * Returns the signed integer for the given zigzag encoding.
+ *
+ * @param value The zigzag encoded integer
+ *
+ * @return the signed integer for the given zigzag encoding.
+ */
+static inline Sint64 unzigzag(Uint64 value) {
+    return static_cast<Sint64>(value >> 1) ^ -static_cast<Sint64>(value & 1);
+}
+
 #pragma mark -
 #pragma mark NetcodeSerializer
 /**
@@ -69,7 +99,11 @@ using namespace cugl::net;
  * @param b The value to write
  */
 void NetcodeSerializer::writeBool(bool b) {
-    _data.push_back(static_cast<std::byte>(b ? BooleanTrue : BooleanFalse));
+    if (_compact) {
+        _data.push_back(static_cast<std::byte>(b ? 1 : 0));
+    } else {
+        _data.push_back(static_cast<std::byte>(b ? BooleanTrue : BooleanFalse));
+    }
 }
 
 /**
@@ -82,12 +116,10 @@ void NetcodeSerializer::writeBool(bool b) {
  * @param f The value to write
  */
 void NetcodeSerializer::writeFloat(float f) {
-    float ii = marshall(f);
-    const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-    _data.push_back(static_cast<std::byte>(FloatType));
-    for (size_t j = 0; j < sizeof(float); j++) {
-        _data.push_back(bytes[j]);
+    if (!_compact) {
+        _data.push_back(static_cast<std::byte>(FloatType));
     }
+    NetcodeWriter(_data).write(f);
 }
 
 /**
@@ -100,12 +132,10 @@ void NetcodeSerializer::writeFloat(float f) {
  * @param d The value to write
  */
 void NetcodeSerializer::writeDouble(double d) {
-    double ii = marshall(d);
-    const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-    _data.push_back(static_cast<std::byte>(DoubleType));
-    for (size_t j = 0; j < sizeof(double); j++) {
-        _data.push_back(bytes[j]);
+    if (!_compact) {
+        _data.push_back(static_cast<std::byte>(DoubleType));
     }
+    NetcodeWriter(_data).write(d);
 }
 
 /**
@@ -118,11 +148,11 @@ void NetcodeSerializer::writeDouble(double d) {
  * @param i The value to write
  */
 void NetcodeSerializer::writeUint32(Uint32 i) {
-    Uint32 ii = marshall(i);
-    const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-    _data.push_back(static_cast<std::byte>(UInt32Type));
-    for (size_t j = 0; j < sizeof(Uint32); j++) {
-        _data.push_back(bytes[j]);
+    if (_compact) {
+        NetcodeWriter(_data).writeVarint(i);
+    } else {
+        _data.push_back(static_cast<std::byte>(UInt32Type));
+        NetcodeWriter(_data).write(i);
     }
 }
 
@@ -136,11 +166,11 @@ void NetcodeSerializer::writeUint32(Uint32 i) {
  * @param i The value to write
  */
 void NetcodeSerializer::writeUint64(Uint64 i) {
-    Uint64 ii = marshall(i);
-    const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-    _data.push_back(static_cast<std::byte>(UInt64Type));
-    for (size_t j = 0; j < sizeof(Uint64); j++) {
-        _data.push_back(bytes[j]);
+    if (_compact) {
+        NetcodeWriter(_data).writeVarint(i);
+    } else {
+        _data.push_back(static_cast<std::byte>(UInt64Type));
+        NetcodeWriter(_data).write(i);
     }
 }
 
@@ -154,11 +184,11 @@ void NetcodeSerializer::writeUint64(Uint64 i) {
  * @param i The value to write
  */
 void NetcodeSerializer::writeSint32(Sint32 i) {
-    Sint32 ii = marshall(i);
-    const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-    _data.push_back(static_cast<std::byte>(SInt32Type));
-    for (size_t j = 0; j < sizeof(Sint32); j++) {
-        _data.push_back(bytes[j]);
+    if (_compact) {
+        NetcodeWriter(_data).writeVarint(zigzag(i));
+    } else {
+        _data.push_back(static_cast<std::byte>(SInt32Type));
+        NetcodeWriter(_data).write(i);
     }
 }
 
@@ -172,11 +202,11 @@ void NetcodeSerializer::writeSint32(Sint32 i) {
  * @param i The value to write
  */
 void NetcodeSerializer::writeSint64(Sint64 i) {
-    Sint64 ii = marshall(i);
-    const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-    _data.push_back(static_cast<std::byte>(SInt64Type));
-    for (size_t j = 0; j < sizeof(Sint64); j++) {
-        _data.push_back(bytes[j]);
+    if (_compact) {
+        NetcodeWriter(_data).writeVarint(zigzag(i));
+    } else {
+        _data.push_back(static_cast<std::byte>(SInt64Type));
+        NetcodeWriter(_data).write(i);
     }
 }
 
@@ -190,11 +220,11 @@ void NetcodeSerializer::writeSint64(Sint64 i) {
  * @param s The value to write
  */
 void NetcodeSerializer::writeString(std::string s) {
-    _data.push_back(static_cast<std::byte>(StringType));
-    writeUint64((Uint64)(s.size()));
-    for (char& c : s) {
-        _data.push_back(static_cast<std::byte>(c));
+    if (!_compact) {
+        _data.push_back(static_cast<std::byte>(StringType));
     }
+    writeUint64((Uint64)(s.size()));
+    NetcodeWriter(_data).writeBytes(s.data(), s.size());
 }
 
 /**
@@ -223,6 +253,11 @@ void NetcodeSerializer::writeChars(char* s) {
  * @param j The value to write
  */
 void NetcodeSerializer::writeJson(const std::shared_ptr<JsonValue>& j) {
+    if (_compact) {
+        // There are no tags to describe the structure, so send it as text
+        writeString(j->toString(false));
+        return;
+    }
     _data.push_back(static_cast<std::byte>(JsonType));
     switch (j->type()) {
     case JsonValue::Type::NullType:
@@ -266,7 +301,9 @@ void NetcodeSerializer::writeJson(const std::shared_ptr<JsonValue>& j) {
  * @param v The vector to write
  */
 void NetcodeSerializer::writeBoolVector(std::vector<bool> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + BooleanTrue));
+    if (!_compact) {
+        _data.push_back(static_cast<std::byte>(ArrayType + BooleanTrue));
+    }
     writeUint64((Uint64)(v.size()));
     for (size_t i = 0; i < v.size(); i++) {
         writeBool(v[i]);
@@ -283,7 +320,9 @@ void NetcodeSerializer::writeBoolVector(std::vector<bool> v) {
  * @param v The vector to write
  */
 void NetcodeSerializer::writeFloatVector(std::vector<float> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + FloatType));
+    if (!_compact) {
+        _data.push_back(static_cast<std::byte>(ArrayType + FloatType));
+    }
     writeUint64((Uint64)(v.size()));
     for (size_t i = 0; i < v.size(); i++) {
         writeFloat(v[i]);
@@ -300,7 +339,9 @@ void NetcodeSerializer::writeFloatVector(std::vector<float> v) {
  * @param v The vector to write
  */
 void NetcodeSerializer::writeDoubleVector(std::vector<double> v) {
-    _data.push_back((std::byte)(ArrayType + DoubleType));
+    if (!_compact) {
+        _data.push_back((std::byte)(ArrayType + DoubleType));
+    }
     writeUint64((Uint64)(v.size()));
     for (size_t i = 0; i < v.size(); i++) {
         writeDouble(v[i]);
@@ -317,7 +358,9 @@ void NetcodeSerializer::writeDoubleVector(std::vector<double> v) {
  * @param v The vector to write
  */
 void NetcodeSerializer::writeUint32Vector(std::vector<Uint32> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + UInt32Type));
+    if (!_compact) {
+        _data.push_back(static_cast<std::byte>(ArrayType + UInt32Type));
+    }
     writeUint64((Uint64)(v.size()));
     for (size_t i = 0; i < v.size(); i++) {
             writeUint32(v[i]);
@@ -334,7 +377,9 @@ void NetcodeSerializer::writeUint32Vector(std::vector<Uint32> v) {
  * @param v The vector to write
  */
 void NetcodeSerializer::writeUint64Vector(std::vector<Uint64> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + UInt64Type));
+    if (!_compact) {
+        _data.push_back(static_cast<std::byte>(ArrayType + UInt64Type));
+    }
     writeUint64((Uint64)(v.size()));
     for (size_t i = 0; i < v.size(); i++) {
             writeUint64(v[i]);
@@ -351,7 +396,9 @@ void NetcodeSerializer::writeUint64Vector(std::vector<Uint64> v) {
  * @param v The vector to write
  */
 void NetcodeSerializer::writeSint32Vector(std::vector<Sint32> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + SInt32Type));
+    if (!_compact) {
+        _data.push_back(static_cast<std::byte>(ArrayType + SInt32Type));
+    }
     writeUint64((Uint64)(v.size()));
     for (size_t i = 0; i < v.size(); i++) {
         writeSint32(v[i]);
@@ -368,7 +415,9 @@ void NetcodeSerializer::writeSint32Vector(std::vector<Sint32> v) {
  * @param v The vector to write
  */
 void NetcodeSerializer::writeSint64Vector(std::vector<Sint64> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + SInt64Type));
+    if (!_compact) {
+        _data.push_back(static_cast<std::byte>(ArrayType + SInt64Type));
+    }
     writeUint64((Uint64)(v.size()));
     for (size_t i = 0; i < v.size(); i++) {
         writeSint64(v[i]);
@@ -384,7 +433,9 @@ void NetcodeSerializer::writeSint64Vector(std::vector<Sint64> v) {
  * @param v The vector to write
  */
 void NetcodeSerializer::writeStringVector(std::vector<std::string> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + StringType));
+    if (!_compact) {
+        _data.push_back(static_cast<std::byte>(ArrayType + StringType));
+    }
     writeUint64((Uint64)(v.size()));
     for (size_t i = 0; i < v.size(); i++) {
         writeString(v[i]);
@@ -404,7 +455,9 @@ void NetcodeSerializer::writeStringVector(std::vector<std::string> v) {
  * @param v The vector to write
  */
 void NetcodeSerializer::writeCharsVector(std::vector<char*> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + StringType));
+    if (!_compact) {
+        _data.push_back(static_cast<std::byte>(ArrayType + StringType));
+    }
     writeUint64((Uint64)(v.size()));
     for (size_t i = 0; i < v.size(); i++) {
         writeChars(v[i]);
@@ -421,13 +474,32 @@ void NetcodeSerializer::writeCharsVector(std::vector<char*> v) {
  * @param v The vector to write
  */
 void NetcodeSerializer::writeJsonVector(std::vector<std::shared_ptr<JsonValue>> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + JsonType));
+    if (!_compact) {
+        _data.push_back(static_cast<std::byte>(ArrayType + JsonType));
+    }
     writeUint64((Uint64)(v.size()));
     for (size_t i = 0; i < v.size(); i++) {
         writeJson(v[i]);
     }
 }
 
+/**
+ * Writes a block of raw bytes.
+ *
+ * The bytes are prefixed by their length, and are read back (as a single
+ * vector) with {@link NetcodeDeserializer#readBytes}. This is useful for
+ * embedding data that was packed by some other serializer.
+ *
+ * This method is only supported in compact mode.
+ *
+ * @param v The bytes to write
+ */
+void NetcodeSerializer::writeBytes(const std::vector<std::byte>& v) {
+    CUAssertLog(_compact, "Raw bytes are only supported in compact mode");
+    writeUint64((Uint64)(v.size()));
+    NetcodeWriter(_data).writeBytes(v.data(), v.size());
+}
+
 /**
  * Returns a byte vector of all written values suitable for network transit.
  *
@@ -448,6 +520,25 @@ const std::vector<std::byte>& NetcodeSerializer::serialize() {
 	return _data;
 }
 
+/**
+ * Returns a shared message buffer of all written values.
+ *
+ * This method is the same as {@link #serialize}, except that the written
+ * values are moved into an immutable {@link NetcodeMessage} without being
+ * copied. This is the preferred way to create a message that will be
+ * broadcast to several peers.
+ *
+ * This method resets the serializer. Unlike {@link #reset}, the capacity
+ * of the buffer is NOT preserved, as the buffer belongs to the message.
+ *
+ * @returns a shared message buffer of all written values.
+ */
+NetcodeMessage NetcodeSerializer::share() {
+	auto result = std::make_shared<const std::vector<std::byte>>(std::move(_data));
+	_data.clear();
+	return result;
+}
+
 /**
  * Clears the input buffer.
  */
@@ -480,6 +571,57 @@ void NetcodeDeserializer::receive(const std::vector<std::byte>& msg) {
 	_pos = 0;
 }
 
+/**
+ * Loads a new message to be read.
+ *
+ * This version of the method takes ownership of the message, and so avoids
+ * copying it. Otherwise it is the same as {@link #receive}.
+ *
+ * @param msg The byte vector serialized by {@link NetcodeSerializer}
+ */
+void NetcodeDeserializer::receive(std::vector<std::byte>&& msg) {
+    _data = std::move(msg);
+    _pos = 0;
+}
+
+/**
+ * Copies the given number of bytes from the stream, advancing the read position.
+ *
+ * If there are not enough bytes left, nothing is copied, the stream is
+ * exhausted, and this method returns false.
+ *
+ * @param dst   The buffer to copy into
+ * @param len   The number of bytes to copy
+ *
+ * @return true if the bytes were copied
+ */
+bool NetcodeDeserializer::fetch(void* dst, size_t len) {
+    size_t start = std::min(_pos, _data.size());
+    NetcodeReader reader(_data.data()+start, _data.size()-start);
+    bool result = reader.readBytes(dst, len);
+    _pos = start+reader.position();
+    return result;
+}
+
+/**
+ * Returns the next variable length integer, advancing the read position.
+ *
+ * If the stream ends before the integer does, the stream is exhausted and
+ * this method returns 0.
+ *
+ * @return the next variable length integer
+ */
+Uint64 NetcodeDeserializer::fetchVarint() {
+    Uint64 result = 0;
+    size_t start = std::min(_pos, _data.size());
+    NetcodeReader reader(_data.data()+start, _data.size()-start);
+    if (!reader.readVarint(result)) {
+        result = 0;
+    }
+    _pos = start+reader.position();
+    return result;
+}
+
 /**
  * Reads the next unreturned value or vector from the currently loaded byte vector.
  *
@@ -493,11 +635,17 @@ void NetcodeDeserializer::receive(const std::vector<std::byte>& msg) {
  * value should be of a certain type T and to extract that value directly. This
  * avoids the overhead of a pattern match on every value. In addition, it is
  * guaranteed to never corrupt the stream (unlike the other read methods)
+ *
+ * This method is not supported in compact mode, and will always return the
+ * monostate.
  */
 NetcodeDeserializer::Message NetcodeDeserializer::read() {
 	if (_pos >= _data.size()) {
 		return {};
-	}
+	} else if (_compact) {
+        CUAssertLog(false, "Variant reads are not supported in compact mode");
+        return {};
+    }
 
     uint8_t value = static_cast<uint8_t>(_data[_pos]);
     switch (value) {
@@ -553,12 +701,13 @@ NetcodeDeserializer::Message NetcodeDeserializer::read() {
  * Returns the type of the next data value to be read.
  *
  * This method returns {@link NetcodeType#InvalidType} if the stream is exhausted
- * (nothing left to be read) or corrupted.
+ * (nothing left to be read) or corrupted. As compact messages have no type
+ * tags, it also returns InvalidType in compact mode.
  *
  * @return the type of the next data value to be read.
  */
 NetcodeType NetcodeDeserializer::nextType() const {
-    if (_pos >= _data.size()) {
+    if (_pos >= _data.size() || _compact) {
         return InvalidType;
     }
     
@@ -607,7 +756,7 @@ bool NetcodeDeserializer::readBool() {
         return false;
     }
     uint8_t value = static_cast<uint8_t>(_data[_pos++]);
-    return value == BooleanTrue;
+    return _compact ? value != 0 : value == BooleanTrue;
 }
 
 /**
@@ -624,11 +773,14 @@ bool NetcodeDeserializer::readBool() {
 float NetcodeDeserializer::readFloat() {
     if (_pos >= _data.size()) {
         return 0.0f;
+    } else if (!_compact) {
+        _pos++;
     }
-    _pos++;
-    const float* r = reinterpret_cast<const float*>(_data.data() + _pos);
-    _pos += sizeof(float);
-    return marshall(*r);
+    float r;
+    if (!fetch(&r, sizeof(float))) {
+        return 0.0f;
+    }
+    return marshall(r);
 }
 
 
@@ -646,11 +798,14 @@ float NetcodeDeserializer::readFloat() {
 double NetcodeDeserializer::readDouble() {
     if (_pos >= _data.size()) {
         return 0.0;
+    } else if (!_compact) {
+        _pos++;
     }
-    _pos++;
-    const double* r = reinterpret_cast<const double*>(_data.data() + _pos);
-    _pos += sizeof(double);
-    return marshall(*r);
+    double r;
+    if (!fetch(&r, sizeof(double))) {
+        return 0.0;
+    }
+    return marshall(r);
 }
 
 /**
@@ -667,11 +822,15 @@ double NetcodeDeserializer::readDouble() {
 Uint32 NetcodeDeserializer::readUint32() {
     if (_pos >= _data.size()) {
         return 0;
+    } else if (_compact) {
+        return (Uint32)fetchVarint();
     }
     _pos++;
-    const Uint32* r = reinterpret_cast<const Uint32*>(_data.data() + _pos);
-    _pos += sizeof(Uint32);
-    return marshall(*r);
+    Uint32 r;
+    if (!fetch(&r, sizeof(Uint32))) {
+        return 0;
+    }
+    return marshall(r);
 }
 
 /**
@@ -688,11 +847,15 @@ Uint32 NetcodeDeserializer::readUint32() {
 Sint32 NetcodeDeserializer::readSint32() {
     if (_pos >= _data.size()) {
         return 0;
+    } else if (_compact) {
+        return (Sint32)unzigzag(fetchVarint());
     }
     _pos++;
-    const Sint32* r = reinterpret_cast<const Sint32*>(_data.data() + _pos);
-    _pos += sizeof(Sint32);
-    return marshall(*r);
+    Sint32 r;
+    if (!fetch(&r, sizeof(Sint32))) {
+        return 0;
+    }
+    return marshall(r);
 }
 
 /**
@@ -709,11 +872,15 @@ Sint32 NetcodeDeserializer::readSint32() {
 Uint64 NetcodeDeserializer::readUint64() {
     if (_pos >= _data.size()) {
         return 0;
+    } else if (_compact) {
+        return fetchVarint();
     }
     _pos++;
-    const Uint64* r = reinterpret_cast<const Uint64*>(_data.data() + _pos);
-    _pos += sizeof(Uint64);
-    return marshall(*r);
+    Uint64 r;
+    if (!fetch(&r, sizeof(Uint64))) {
+        return 0;
+    }
+    return marshall(r);
 }
 
 /**
@@ -730,11 +897,15 @@ Uint64 NetcodeDeserializer::readUint64() {
 Sint64 NetcodeDeserializer::readSint64() {
     if (_pos >= _data.size()) {
         return 0;
+    } else if (_compact) {
+        return unzigzag(fetchVarint());
     }
     _pos++;
-    const Sint64* r = reinterpret_cast<const Sint64*>(_data.data() + _pos);
-    _pos += sizeof(Sint64);
-    return marshall(*r);
+    Sint64 r;
+    if (!fetch(&r, sizeof(Sint64))) {
+        return 0;
+    }
+    return marshall(r);
 }
 
 /**
@@ -751,14 +922,14 @@ Sint64 NetcodeDeserializer::readSint64() {
 std::string NetcodeDeserializer::readString() {
     if (_pos >= _data.size()) {
         return std::string();
+    } else if (!_compact) {
+        _pos++;
     }
-    _pos++;
-    Uint64 size = std::get<Uint64>(read());
-    std::ostringstream disp;
-    for (size_t i = 0; i < size; i++, _pos++) {
-        disp << static_cast<char>(_data[_pos]);
-    }
-    return disp.str();
+    Uint64 size = readUint64();
+    size_t len = (size_t)std::min<Uint64>(size, _data.size()-_pos);
+    std::string result(reinterpret_cast<const char*>(_data.data()+_pos), len);
+    _pos += len;
+    return result;
 }
 
 /**
@@ -775,6 +946,9 @@ std::string NetcodeDeserializer::readString() {
 std::shared_ptr<JsonValue> NetcodeDeserializer::readJson() {
     if (_pos >= _data.size()) {
         return nullptr;
+    } else if (_compact) {
+        std::string text = readString();
+        return text.empty() ? nullptr : JsonValue::allocWithJson(text);
     }
     _pos++;
     uint8_t value = static_cast<uint8_t>(_data[_pos]);
@@ -828,9 +1002,19 @@ std::shared_ptr<JsonValue> NetcodeDeserializer::readJson() {
  * @return a vector of boolean values.
  */
 std::vector<bool> NetcodeDeserializer::readBoolVector()  {
+    std::vector<bool> vv;
+    if (_pos >= _data.size()) {
+        return vv;
+    }
+    if (_compact) {
+        Uint64 size = readUint64();
+        for (size_t i = 0; i < size && available(); i++) {
+            vv.push_back(readBool());
+        }
+        return vv;
+    }
     _pos++;
     Uint64 size = std::get<Uint64>(read());
-    std::vector<bool> vv;
     for (size_t i = 0; i < size; i++) {
         vv.push_back(std::get<bool>(read()));
     }
@@ -853,6 +1037,13 @@ std::vector<float> NetcodeDeserializer::readFloatVector() {
     if (_pos >= _data.size()) {
         return vv;
     }
+    if (_compact) {
+        Uint64 size = readUint64();
+        for (size_t i = 0; i < size && available(); i++) {
+            vv.push_back(readFloat());
+        }
+        return vv;
+    }
     _pos++;
     Uint64 size = std::get<Uint64>(read());
     for (size_t i = 0; i < size; i++) {
@@ -877,6 +1068,13 @@ std::vector<double> NetcodeDeserializer::readDoubleVector()     {
     if (_pos >= _data.size()) {
         return vv;
     }
+    if (_compact) {
+        Uint64 size = readUint64();
+        for (size_t i = 0; i < size && available(); i++) {
+            vv.push_back(readDouble());
+        }
+        return vv;
+    }
     _pos++;
     Uint64 size = std::get<Uint64>(read());
     for (size_t i = 0; i < size; i++) {
@@ -901,6 +1099,13 @@ std::vector<Uint32> NetcodeDeserializer::readUint32Vector() {
     if (_pos >= _data.size()) {
         return vv;
     }
+    if (_compact) {
+        Uint64 size = readUint64();
+        for (size_t i = 0; i < size && available(); i++) {
+            vv.push_back(readUint32());
+        }
+        return vv;
+    }
     _pos++;
     Uint64 size = std::get<Uint64>(read());
     for (size_t i = 0; i < size; i++) {
@@ -925,6 +1130,13 @@ std::vector<Sint32> NetcodeDeserializer::readSint32Vector()  {
     if (_pos >= _data.size()) {
         return vv;
     }
+    if (_compact) {
+        Uint64 size = readUint64();
+        for (size_t i = 0; i < size && available(); i++) {
+            vv.push_back(readSint32());
+        }
+        return vv;
+    }
     _pos++;
     Uint64 size = std::get<Uint64>(read());
     for (size_t i = 0; i < size; i++) {
@@ -949,6 +1161,13 @@ std::vector<Uint64> NetcodeDeserializer::readUint64Vector() {
     if (_pos >= _data.size()) {
         return vv;
     }
+    if (_compact) {
+        Uint64 size = readUint64();
+        for (size_t i = 0; i < size && available(); i++) {
+            vv.push_back(readUint64());
+        }
+        return vv;
+    }
     _pos++;
     Uint64 size = std::get<Uint64>(read());
     for (size_t i = 0; i < size; i++) {
@@ -973,6 +1192,13 @@ std::vector<Sint64> NetcodeDeserializer::readSint64Vector() {
     if (_pos >= _data.size()) {
         return vv;
     }
+    if (_compact) {
+        Uint64 size = readUint64();
+        for (size_t i = 0; i < size && available(); i++) {
+            vv.push_back(readSint64());
+        }
+        return vv;
+    }
     _pos++;
     Uint64 size = std::get<Uint64>(read());
     for (size_t i = 0; i < size; i++) {
@@ -997,6 +1223,13 @@ std::vector<std::string> NetcodeDeserializer::readStringVector() {
     if (_pos >= _data.size()) {
         return vv;
     }
+    if (_compact) {
+        Uint64 size = readUint64();
+        for (size_t i = 0; i < size && available(); i++) {
+            vv.push_back(readString());
+        }
+        return vv;
+    }
     _pos++;
     Uint64 size = std::get<Uint64>(read());
     for (size_t i = 0; i < size; i++) {
@@ -1021,6 +1254,13 @@ std::vector<std::shared_ptr<JsonValue>> NetcodeDeserializer::readJsonVector() {
     if (_pos >= _data.size()) {
         return vv;
     }
+    if (_compact) {
+        Uint64 size = readUint64();
+        for (size_t i = 0; i < size && available(); i++) {
+            vv.push_back(readJson());
+        }
+        return vv;
+    }
     _pos++;
     Uint64 size = std::get<Uint64>(read());
     for (size_t i = 0; i < size; i++) {
@@ -1029,6 +1269,30 @@ std::vector<std::shared_ptr<JsonValue>> NetcodeDeserializer::readJsonVector() {
     return vv;
 }
 
+/**
+ * Returns a block of raw bytes.
+ *
+ * This method reads a block written by {@link NetcodeSerializer#writeBytes}.
+ * It is only supported in compact mode.
+ *
+ * The method advances the read position. If called when no more data is available,
+ * this method will return an empty vector.
+ *
+ * @return a block of raw bytes.
+ */
+std::vector<std::byte> NetcodeDeserializer::readBytes() {
+    std::vector<std::byte> vv;
+    if (_pos >= _data.size()) {
+        return vv;
+    }
+    CUAssertLog(_compact, "Raw bytes are only supported in compact mode");
+    Uint64 size = readUint64();
+    size_t len = (size_t)std::min<Uint64>(size, _data.size()-_pos);
+    vv.assign(_data.begin()+_pos, _data.begin()+_pos+len);
+    _pos += len;
+    return vv;
+}
+
 /**
  * Clears the buffer and ignore any remaining data in it.
  */
@@ -0,0 +1,368 @@
+//
+//  CUNetcodeSimulator.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module is part of a Web RTC implementation of the classic CUGL networking
+//  library. It provides a network condition simulator for debugging. When it is
+//  attached to a NetcodeConnection, every datagram between a data channel and its
+//  RTC data channel is delayed, dropped, or duplicated according to the simulated
+//  conditions of its peer. This makes it possible to tune interpolation and
+//  prediction settings without a bad network at hand.
+//
+//  All delayed datagrams are kept in a single timer wheel serviced by one thread.
+//  So the simulator never sleeps on a network thread, and never distorts the
+//  timing of anything else.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/net/CUNetcodeSimulator.h>
+#include <cugl/util/CUDebug.h>
+#include <algorithm>
+#include <chrono>
+
+using namespace cugl;
+using namespace cugl::net;
+
+/** The number of slots in the timer wheel (one per millisecond) */
+#define SIM_SLOTS       1024
+/** The delay (in ms) before a reliable channel retransmits a lost datagram */
+#define SIM_RETRANSMIT  200
+
+#pragma mark Constructors
+/**
+ * Creates a degenerate simulator.
+ *
+ * This object has not been initialized and cannot be used.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+NetcodeSimulator::NetcodeSimulator() :
+    _active(false),
+    _tick(0),
+    _pending(0),
+    _order(0) {
+}
+
+/**
+ * Disposes all of the resources used by this simulator.
+ *
+ * Any datagrams still held by the simulator are discarded. A disposed
+ * simulator can be safely reinitialized.
+ */
+void NetcodeSimulator::dispose() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _active = false;
+    }
+    _wakeup.notify_all();
+    if (_thread.joinable()) {
+        // A delivery may release the last reference to this simulator
+        if (_thread.get_id() == std::this_thread::get_id()) {
+            *_alive = false;
+            _thread.detach();
+        } else {
+            _thread.join();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _wheel.clear();
+    _links.clear();
+    _conditions.clear();
+    _default = NetcodeConditions();
+    _pending = 0;
+    _order = 0;
+    _tick  = 0;
+}
+
+/**
+ * Initializes a simulator with the given random seed.
+ *
+ * The simulator starts with perfect conditions for every peer.
+ *
+ * @param seed  The seed for the simulated random choices
+ *
+ * @return true if the simulator is initialized properly, false otherwise.
+ */
+bool NetcodeSimulator::init(Uint32 seed) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_active) {
+        CUAssertLog(false, "Simulator is already initialized");
+        return false;
+    }
+
+    _wheel.resize(SIM_SLOTS);
+    _random.seed(seed);
+    _start.mark();
+    _tick = 0;
+    _active = true;
+    _alive  = std::make_shared<bool>(true);
+    _thread = std::thread([this]() { run(); });
+    return true;
+}
+
+#pragma mark Timer Wheel
+/**
+ * Services the timer wheel until the simulator is disposed.
+ *
+ * This is the body of the timer thread.
+ */
+void NetcodeSimulator::run() {
+    std::shared_ptr<bool> alive = _alive;
+    std::vector<Event> ready;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_active) {
+        if (_pending == 0) {
+            _wakeup.wait(lock);
+            continue;
+        }
+
+        Timestamp now;
+        Uint64 tick = now.ellapsedMicros(_start)/1000;
+        if (tick >= _tick) {
+            // After a long stall, every slot is visited once
+            Uint64 first = (tick-_tick >= SIM_SLOTS ? tick-SIM_SLOTS+1 : _tick);
+            for(Uint64 tt = first; tt <= tick; tt++) {
+                std::vector<Event>& slot = _wheel[tt % SIM_SLOTS];
+                for(size_t ii = 0; ii < slot.size(); ) {
+                    if (slot[ii].deadline/1000 <= tick) {
+                        ready.push_back(std::move(slot[ii]));
+                        if (ii != slot.size()-1) {
+                            slot[ii] = std::move(slot.back());
+                        }
+                        slot.pop_back();
+                    } else {
+                        ii++;
+                    }
+                }
+            }
+            _tick = tick+1;
+            _pending -= ready.size();
+        }
+
+        if (!ready.empty()) {
+            std::sort(ready.begin(),ready.end(),[](const Event& a, const Event& b) {
+                return a.deadline < b.deadline || (a.deadline == b.deadline && a.order < b.order);
+            });
+
+            // Deliver without the lock, as deliveries may post new datagrams
+            lock.unlock();
+            for(auto it = ready.begin(); it != ready.end(); ++it) {
+                it->action();
+            }
+            ready.clear();
+            if (!*alive) {
+                return;
+            }
+            lock.lock();
+        } else {
+            _wakeup.wait_for(lock,std::chrono::milliseconds(1));
+        }
+    }
+}
+
+/**
+ * Adds an event to the timer wheel.
+ *
+ * This method must be called while holding the lock for this simulator.
+ *
+ * @param deadline  The time to run the event, in microseconds
+ * @param action    The function to run
+ */
+void NetcodeSimulator::schedule(Uint64 deadline, const std::function<void()>& action) {
+    // A slot already serviced would not be visited for a whole turn
+    Uint64 tick = std::max(deadline/1000,_tick);
+    Event event;
+    event.deadline = deadline;
+    event.order  = _order++;
+    event.action = action;
+    _wheel[tick % SIM_SLOTS].push_back(std::move(event));
+    if (_pending++ == 0) {
+        _wakeup.notify_one();
+    }
+}
+
+/**
+ * Returns a random delay for the given conditions, in microseconds
+ *
+ * This method must be called while holding the lock for this simulator.
+ *
+ * @param conditions    The link conditions
+ *
+ * @return a random delay for the given conditions, in microseconds
+ */
+Uint64 NetcodeSimulator::delay(const NetcodeConditions& conditions) {
+    Uint64 result = (Uint64)conditions.latency*1000;
+    if (conditions.jitter > 0) {
+        std::uniform_int_distribution<Uint64> jitter(0,(Uint64)conditions.jitter*1000);
+        result += jitter(_random);
+    }
+    return result;
+}
+
+#pragma mark Conditions
+/**
+ * Returns the conditions for peers without their own.
+ *
+ * @return the conditions for peers without their own.
+ */
+NetcodeConditions NetcodeSimulator::getConditions() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _default;
+}
+
+/**
+ * Sets the conditions for peers without their own.
+ *
+ * @param conditions    The link conditions
+ */
+void NetcodeSimulator::setConditions(const NetcodeConditions& conditions) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _default = conditions;
+}
+
+/**
+ * Returns the conditions for the given peer.
+ *
+ * @param uuid  The peer UUID
+ *
+ * @return the conditions for the given peer.
+ */
+NetcodeConditions NetcodeSimulator::getConditions(const std::string uuid) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _conditions.find(uuid);
+    return it == _conditions.end() ? _default : it->second;
+}
+
+/**
+ * Sets the conditions for the given peer.
+ *
+ * @param uuid          The peer UUID
+ * @param conditions    The link conditions
+ */
+void NetcodeSimulator::setConditions(const std::string uuid, const NetcodeConditions& conditions) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _conditions[uuid] = conditions;
+}
+
+/**
+ * Removes the conditions for the given peer.
+ *
+ * The peer will then have the conditions for peers without their own.
+ *
+ * @param uuid  The peer UUID
+ */
+void NetcodeSimulator::clearConditions(const std::string uuid) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _conditions.erase(uuid);
+}
+
+/**
+ * Returns the number of datagrams currently held by this simulator.
+ *
+ * @return the number of datagrams currently held by this simulator.
+ */
+size_t NetcodeSimulator::getPending() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pending;
+}
+
+#pragma mark Simulation
+/**
+ * Passes a datagram through the simulated link to the given peer.
+ *
+ * If the peer has perfect conditions, this method returns false, and the
+ * caller should deliver the datagram immediately. Otherwise, the simulator
+ * takes over the datagram and returns true. In that case, the action is run
+ * on the timer thread once the datagram is due, unless the datagram is lost.
+ * The action may be run twice if the datagram is duplicated.
+ *
+ * The link is the channel label and direction, so that every direction of
+ * every data channel to a peer has its own bandwidth and ordering.
+ *
+ * @param uuid      The peer UUID
+ * @param link      The data channel label and direction
+ * @param reliable  Whether the data channel is reliable and ordered
+ * @param size      The size of the datagram in bytes
+ * @param action    The function to deliver the datagram
+ *
+ * @return true if the simulator took over the datagram
+ */
+bool NetcodeSimulator::post(const std::string& uuid, const std::string& link, bool reliable,
+                            size_t size, const std::function<void()>& action) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_active) {
+        return false;
+    }
+
+    auto it = _conditions.find(uuid);
+    const NetcodeConditions& conditions = (it == _conditions.end() ? _default : it->second);
+    if (conditions.isPerfect()) {
+        return false;
+    }
+
+    Timestamp now;
+    Uint64 time = now.ellapsedMicros(_start);
+    Link& state = _links[uuid+"/"+link];
+
+    // The datagram must wait for the link to finish the ones before it
+    if (conditions.bandwidth > 0) {
+        time = std::max(time,state.free);
+        state.free = time+(Uint64)size*1000000/conditions.bandwidth;
+        time = state.free;
+    }
+
+    std::uniform_real_distribution<float> chance(0.0f,1.0f);
+    bool lost = conditions.loss > 0 && chance(_random) < conditions.loss;
+    if (lost && !reliable) {
+        return true;
+    }
+
+    Uint64 deadline = time+delay(conditions);
+    if (reliable) {
+        // A lost datagram is retransmitted, holding up the ones behind it
+        if (lost) {
+            deadline += (Uint64)(SIM_RETRANSMIT+conditions.latency)*1000;
+        }
+        deadline = std::max(deadline,state.last);
+        state.last = deadline;
+    }
+    schedule(deadline,action);
+
+    if (!reliable && conditions.duplicate > 0 && chance(_random) < conditions.duplicate) {
+        schedule(time+delay(conditions),action);
+    }
+    return true;
+}
@@ -0,0 +1,683 @@
+//
+//  CUNetcodeVoice.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module is part of a Web RTC implementation of the classic CUGL networking
+//  library. It provides voice chat over a NetcodeConnection. Audio is taken
+//  from an AudioInput capture stream, encoded on a background thread, and sent
+//  along the unreliable lane. On the receiving side, an audio node buffers the
+//  frames of each speaker in an adaptive jitter buffer, conceals lost frames,
+//  and mixes the speakers for an audio graph.
+//
+//  Voice is encoded as 16 kHz mono IMA ADPCM in 20 ms frames. Every frame
+//  carries its own codec state, so a lost frame never corrupts the next one.
+//
+//  These classes uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/net/CUNetcodeVoice.h>
+#include <cugl/net/CUNetcodeConnection.h>
+#include <cugl/audio/graph/CUAudioInput.h>
+#include <cugl/math/dsp/CUDSPMath.h>
+#include <cugl/util/CUDebug.h>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+
+using namespace cugl;
+using namespace cugl::audio;
+using namespace cugl::net;
+
+/** The number of voice frames that may wait for the audio thread */
+#define VOICE_QUEUE     64
+/** The initial (and minimum) jitter buffer depth in frames */
+#define VOICE_MIN_DELAY 2
+/** The maximum jitter buffer depth in frames (100 ms) */
+#define VOICE_MAX_DELAY 5
+/** The number of consecutive frames to conceal before going silent */
+#define VOICE_CONCEAL   3
+/** The gain applied to each concealed frame */
+#define VOICE_FADE      0.5f
+/** The number of frames above the target depth before skipping a frame */
+#define VOICE_EXCESS    25
+/** The number of frames without a late arrival before lowering the target depth */
+#define VOICE_STABLE    250
+/** The number of frames sent after the level drops below the gate */
+#define VOICE_HANGOVER  10
+/** The size of the input capture stream in milliseconds */
+#define VOICE_CAPTURE   200
+/** The time the encoding thread sleeps when there is no audio in milliseconds */
+#define VOICE_SLEEP     5
+/** The cutoff of the low-pass filter before downsampling in HZ */
+#define VOICE_CUTOFF    7200
+
+#pragma mark -
+#pragma mark IMA ADPCM
+/** The quantizer step sizes of IMA ADPCM */
+static const int IMA_STEPS[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+/** The step index adjustment for each IMA ADPCM code */
+static const int IMA_INDEX[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+/**
+ * Updates the codec state for the given code, returning the new sample.
+ *
+ * The encoder and decoder share this method, so that their states never
+ * diverge.
+ *
+ * @param code      The 4-bit code
+ * @param predictor The codec predictor
+ * @param index     The codec step index
+ *
+ * @return the decoded sample
+ */
+static int ima_update(Uint8 code, int& predictor, int& index) {
+    int step  = IMA_STEPS[index];
+    int delta = step >> 3;
+    if (code & 4) {
+        delta += step;
+    }
+    if (code & 2) {
+        delta += step >> 1;
+    }
+    if (code & 1) {
+        delta += step >> 2;
+    }
+    predictor += (code & 8) ? -delta : delta;
+    predictor = predictor < -32768 ? -32768 : (predictor > 32767 ? 32767 : predictor);
+    index += IMA_INDEX[code];
+    index = index < 0 ? 0 : (index > 88 ? 88 : index);
+    return predictor;
+}
+
+/**
+ * Returns the code for the given sample, updating the codec state.
+ *
+ * @param sample    The sample to encode
+ * @param predictor The codec predictor
+ * @param index     The codec step index
+ *
+ * @return the code for the given sample
+ */
+static Uint8 ima_encode(int sample, int& predictor, int& index) {
+    int step = IMA_STEPS[index];
+    int diff = sample - predictor;
+    Uint8 code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+    }
+    ima_update(code,predictor,index);
+    return code;
+}
+
+#pragma mark -
+#pragma mark NetcodeVoiceNode
+/**
+ * Creates a degenerate voice node.
+ *
+ * The node has not been initialized, so it is not active.  The node
+ * must be initialized to be used.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a node on
+ * the heap, use one of the static constructors instead.
+ */
+NetcodeVoiceNode::NetcodeVoiceNode() : AudioNode(),
+_queue(VOICE_QUEUE,OverflowPolicy::DROP_NEWEST),
+_speakers(nullptr),
+_concealed(0),
+_late(0) {
+    _classname = "NetcodeVoiceNode";
+}
+
+/**
+ * Initializes the node with default stereo settings
+ *
+ * The number of channels is two, for stereo output. The sample rate is
+ * the modern standard of 48000 HZ.
+ *
+ * @return true if initialization was successful
+ */
+bool NetcodeVoiceNode::init() {
+    return init(DEFAULT_CHANNELS,DEFAULT_SAMPLING);
+}
+
+/**
+ * Initializes the node with the given number of channels and sample rate
+ *
+ * @param channels  The number of audio channels
+ * @param rate      The sample rate (frequency) in HZ
+ *
+ * @return true if initialization was successful
+ */
+bool NetcodeVoiceNode::init(Uint8 channels, Uint32 rate) {
+    if (AudioNode::init(channels,rate)) {
+        _speakers = new Speaker[NETCODE_VOICE_SPEAKERS];
+        std::memset(_speakers,0,NETCODE_VOICE_SPEAKERS*sizeof(Speaker));
+        _concealed.store(0);
+        _late.store(0);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Disposes any resources allocated for this node
+ *
+ * The state of the node is reset to that of an uninitialized constructor.
+ * Unlike the destructor, this method allows the node to be reinitialized.
+ */
+void NetcodeVoiceNode::dispose() {
+    if (_booted) {
+        AudioNode::dispose();
+        _queue.clear();
+        if (_speakers) {
+            delete[] _speakers;
+            _speakers = nullptr;
+        }
+        _concealed.store(0);
+        _late.store(0);
+    }
+}
+
+#pragma mark Voice Frames
+/**
+ * Adds a voice frame to this node.
+ *
+ * This method may be called from any thread. It never blocks. If the audio
+ * thread has fallen behind, the frame is dropped.
+ *
+ * @param frame The voice frame
+ */
+void NetcodeVoiceNode::push(const Frame& frame) {
+    Frame copy = frame;
+    _queue.push(std::move(copy));
+}
+
+/**
+ * Stores a frame in the jitter buffer of its speaker
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ *
+ * @param frame The frame to store
+ */
+void NetcodeVoiceNode::store(const Frame& frame) {
+    Speaker* speaker = nullptr;
+    Speaker* vacant  = nullptr;
+    for(int ii = 0; speaker == nullptr && ii < NETCODE_VOICE_SPEAKERS; ii++) {
+        if (_speakers[ii].source == frame.source) {
+            speaker = _speakers+ii;
+        } else if (vacant == nullptr && _speakers[ii].source == 0) {
+            vacant = _speakers+ii;
+        }
+    }
+    if (speaker == nullptr) {
+        if (vacant == nullptr) {
+            // Too many people talking at once
+            return;
+        }
+        speaker = vacant;
+        std::memset(speaker,0,sizeof(Speaker));
+        speaker->source = frame.source;
+        speaker->target = VOICE_MIN_DELAY;
+        speaker->next = frame.sequence;
+    }
+    speaker->idle = 0;
+
+    Sint16 offset = (Sint16)(Uint16)(frame.sequence-speaker->next);
+    if (offset < 0) {
+        if (speaker->playing) {
+            // Arrived after it was played (or concealed)
+            _late.fetch_add(1,std::memory_order_relaxed);
+            if (speaker->target < VOICE_MAX_DELAY) {
+                speaker->target++;
+            }
+            speaker->stable = 0;
+            return;
+        } else if (speaker->depth+(Uint32)(-offset) >= NETCODE_VOICE_JITTER) {
+            return;
+        }
+        // Still buffering, so start earlier
+        speaker->next = frame.sequence;
+    } else if (offset >= NETCODE_VOICE_JITTER) {
+        // Too far ahead, so start over
+        std::memset(speaker->valid,0,sizeof(speaker->valid));
+        speaker->depth = 0;
+        speaker->playing = false;
+        speaker->next = frame.sequence;
+    }
+
+    Uint32 slot = frame.sequence % NETCODE_VOICE_JITTER;
+    if (!speaker->valid[slot]) {
+        speaker->valid[slot] = true;
+        speaker->depth++;
+    }
+    speaker->frames[slot] = frame;
+}
+
+/**
+ * Decodes the next frame of the given speaker
+ *
+ * If the frame is missing, it is concealed. This method returns false if
+ * the speaker has stopped playing.
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ *
+ * @param speaker   The speaker to advance
+ *
+ * @return true if the speaker is still playing
+ */
+bool NetcodeVoiceNode::advance(Speaker& speaker) {
+    // Skip a frame if the delay has been too high for too long
+    if (speaker.depth > speaker.target) {
+        if (++speaker.excess >= VOICE_EXCESS) {
+            Uint32 slot = speaker.next % NETCODE_VOICE_JITTER;
+            if (speaker.valid[slot]) {
+                speaker.valid[slot] = false;
+                speaker.depth--;
+            }
+            speaker.next++;
+            speaker.excess = 0;
+        }
+    } else {
+        speaker.excess = 0;
+    }
+
+    Uint32 slot = speaker.next % NETCODE_VOICE_JITTER;
+    if (speaker.valid[slot]) {
+        const Frame& frame = speaker.frames[slot];
+        int predictor = frame.predictor;
+        int index = frame.index;
+        for(int ii = 0; ii < NETCODE_VOICE_FRAME/2; ii++) {
+            Uint8 byte = frame.data[ii];
+            speaker.pcm[2*ii  ] = ima_update(byte & 0x0f,predictor,index)/32768.0f;
+            speaker.pcm[2*ii+1] = ima_update(byte >> 4,predictor,index)/32768.0f;
+        }
+        speaker.valid[slot] = false;
+        speaker.depth--;
+        speaker.losses = 0;
+        if (++speaker.stable >= VOICE_STABLE && speaker.target > VOICE_MIN_DELAY) {
+            speaker.target--;
+            speaker.stable = 0;
+        }
+    } else if (++speaker.losses > VOICE_CONCEAL) {
+        // They have stopped talking (or we lost them)
+        std::memset(speaker.valid,0,sizeof(speaker.valid));
+        speaker.depth = 0;
+        speaker.losses = 0;
+        speaker.playing = false;
+        return false;
+    } else {
+        // Repeat the last frame, fading it out
+        _concealed.fetch_add(1,std::memory_order_relaxed);
+        dsp::DSPMath::scale(speaker.pcm,VOICE_FADE,speaker.pcm,NETCODE_VOICE_FRAME);
+    }
+    speaker.next++;
+    speaker.position = 0;
+    return true;
+}
+
+#pragma mark Audio Graph
+/**
+ * Reads up to the specified number of frames into the given buffer
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ * The only exception is when the user needs to create a custom subclass
+ * of this AudioNode.
+ *
+ * The buffer should have enough room to store frames * channels elements.
+ * The channels are interleaved into the output buffer. This node always
+ * reads the requested number of frames, filling in silence when no one
+ * is talking.
+ *
+ * @param buffer    The read buffer to store the results
+ * @param frames    The maximum number of frames to read
+ *
+ * @return the actual number of frames read
+ */
+Uint32 NetcodeVoiceNode::read(float* buffer, Uint32 frames) {
+    ReadTimer timer(this);
+    std::memset(buffer,0,frames*_channels*sizeof(float));
+    if (_paused.load(std::memory_order_relaxed)) {
+        return frames;
+    }
+
+    _polling.store(true);
+    Frame frame;
+    while (_queue.pop(frame)) {
+        store(frame);
+    }
+
+    double step = (double)NETCODE_VOICE_RATE/_sampling;
+    for(int jj = 0; jj < NETCODE_VOICE_SPEAKERS; jj++) {
+        Speaker& speaker = _speakers[jj];
+        if (speaker.source == 0) {
+            continue;
+        }
+
+        speaker.idle += frames;
+        if (!speaker.playing) {
+            if (speaker.depth > 0 && speaker.depth >= speaker.target) {
+                speaker.playing  = true;
+                speaker.position = NETCODE_VOICE_FRAME;
+                speaker.previous = 0;
+                speaker.current  = 0;
+                speaker.phase    = 0;
+            } else {
+                // Release the slot after a second of silence
+                if (speaker.idle > _sampling) {
+                    speaker.source = 0;
+                }
+                continue;
+            }
+        }
+
+        bool playing = true;
+        for(Uint32 ii = 0; playing && ii < frames; ii++) {
+            speaker.phase += step;
+            while (playing && speaker.phase >= 1.0) {
+                speaker.phase -= 1.0;
+                if (speaker.position >= NETCODE_VOICE_FRAME) {
+                    playing = advance(speaker);
+                }
+                if (playing) {
+                    speaker.previous = speaker.current;
+                    speaker.current  = speaker.pcm[speaker.position++];
+                }
+            }
+            if (playing) {
+                float value = speaker.previous+(speaker.current-speaker.previous)*(float)speaker.phase;
+                float* output = buffer+ii*_channels;
+                for(Uint32 kk = 0; kk < _channels; kk++) {
+                    output[kk] += value;
+                }
+            }
+        }
+    }
+
+    dsp::DSPMath::scale(buffer,_ndgain.load(std::memory_order_relaxed),buffer,frames*_channels);
+    return frames;
+}
+
+#pragma mark -
+#pragma mark NetcodeVoice
+/**
+ * Creates a degenerate voice chat.
+ *
+ * This object has not been initialized, and cannot be used.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+NetcodeVoice::NetcodeVoice() :
+_output(nullptr),
+_input(nullptr),
+_running(false),
+_gate(0.0f),
+_sent(0) {
+}
+
+/**
+ * Disposes all of the resources used by this voice chat.
+ *
+ * This stops any transmission, and detaches this object from the connection.
+ * A disposed voice chat can be safely reinitialized.
+ */
+void NetcodeVoice::dispose() {
+    stop();
+    auto network = _network.lock();
+    if (network != nullptr && std::atomic_load(&network->_voice).get() == this) {
+        network->setVoice(nullptr);
+    }
+    _network.reset();
+    std::atomic_store(&_output,std::shared_ptr<NetcodeVoiceNode>());
+    _sent.store(0);
+}
+
+/**
+ * Initializes a voice chat for the given connection.
+ *
+ * The voice of the other players is played by an audio node with the given
+ * number of channels and sample rate. These should match the audio graph
+ * that the node is attached to. This object replaces any voice chat already
+ * attached to the connection.
+ *
+ * @param network   The network connection
+ * @param channels  The number of channels of the output node
+ * @param rate      The sample rate of the output node
+ *
+ * @return true if initialization was successful
+ */
+bool NetcodeVoice::init(const std::shared_ptr<NetcodeConnection>& network, Uint8 channels, Uint32 rate) {
+    if (_output != nullptr) {
+        CUAssertLog(false, "Voice chat is already initialized");
+        return false;
+    } else if (network == nullptr) {
+        return false;
+    }
+
+    _output = NetcodeVoiceNode::alloc(channels,rate);
+    if (_output == nullptr) {
+        return false;
+    }
+    _network = network;
+    network->setVoice(shared_from_this());
+    return true;
+}
+
+#pragma mark Transmission
+/**
+ * Starts transmitting the given input node.
+ *
+ * This enables the capture stream of the input node, and starts the
+ * encoding thread. If this object is already transmitting, it switches
+ * to the new input.
+ *
+ * @param input The input node to transmit
+ *
+ * @return true if transmission started
+ */
+bool NetcodeVoice::start(const std::shared_ptr<AudioInput>& input) {
+    if (input == nullptr || _output == nullptr) {
+        return false;
+    }
+    stop();
+
+    Uint32 capture = input->getRate()*VOICE_CAPTURE/1000;
+    if (input->getCaptureSize() < capture) {
+        input->setCaptureSize(capture);
+    }
+    _input = input;
+    _running.store(true);
+    _thread = std::thread([this]() { run(); });
+    return true;
+}
+
+/**
+ * Stops transmitting.
+ *
+ * This disables the capture stream of the input node. The voice of the
+ * other players is still played. If this object is not transmitting, this
+ * method does nothing.
+ */
+void NetcodeVoice::stop() {
+    _running.store(false);
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    if (_input != nullptr) {
+        _input->setCaptureSize(0);
+        _input = nullptr;
+    }
+}
+
+/**
+ * Runs the encoding thread until {@link #stop} is called.
+ */
+void NetcodeVoice::run() {
+    Uint32 channels = _input->getChannels();
+    Uint32 rate = _input->getRate();
+    Uint32 chunk = rate*VOICE_SLEEP/1000+1;
+    std::vector<float> captured(chunk*channels);
+
+    // The low-pass filter only matters if we are downsampling
+    float alpha = 1.0f;
+    if (rate > NETCODE_VOICE_RATE) {
+        alpha = 1.0f-std::exp(-2.0f*(float)M_PI*VOICE_CUTOFF/rate);
+    }
+    double step = (double)rate/NETCODE_VOICE_RATE;
+    double phase = 0;
+    float filtered = 0;
+    float previous = 0;
+
+    float pcm[NETCODE_VOICE_FRAME];
+    Uint32 filled = 0;
+    Uint16 sequence = 0;
+    Uint32 hangover = 0;
+    int predictor = 0;
+    int index = 0;
+
+    while (_running.load()) {
+        Uint32 amt = _input->capture(captured.data(),chunk);
+        if (amt == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(VOICE_SLEEP));
+            continue;
+        }
+
+        for(Uint32 ii = 0; ii < amt; ii++) {
+            float sample = 0;
+            for(Uint32 jj = 0; jj < channels; jj++) {
+                sample += captured[ii*channels+jj];
+            }
+            filtered += alpha*(sample/channels-filtered);
+
+            // Linear resampling to the voice rate
+            while (phase <= 1.0) {
+                pcm[filled++] = previous+(filtered-previous)*(float)phase;
+                phase += step;
+                if (filled < NETCODE_VOICE_FRAME) {
+                    continue;
+                }
+                filled = 0;
+
+                float energy = 0;
+                for(int kk = 0; kk < NETCODE_VOICE_FRAME; kk++) {
+                    energy += pcm[kk]*pcm[kk];
+                }
+                float level = std::sqrt(energy/NETCODE_VOICE_FRAME);
+                if (level >= _gate.load(std::memory_order_relaxed)) {
+                    hangover = VOICE_HANGOVER;
+                } else if (hangover > 0) {
+                    hangover--;
+                } else {
+                    continue;
+                }
+
+                std::vector<std::byte> packet(NETCODE_VOICE_HEADER+NETCODE_VOICE_FRAME/2);
+                packet[0] = NETCODE_VOICE_MARKER;
+                packet[1] = (std::byte)(sequence & 0xff);
+                packet[2] = (std::byte)(sequence >> 8);
+                packet[3] = (std::byte)(predictor & 0xff);
+                packet[4] = (std::byte)((predictor >> 8) & 0xff);
+                packet[5] = (std::byte)index;
+                for(int kk = 0; kk < NETCODE_VOICE_FRAME/2; kk++) {
+                    float lo = pcm[2*kk]*32767.0f;
+                    float hi = pcm[2*kk+1]*32767.0f;
+                    lo = lo < -32768.0f ? -32768.0f : (lo > 32767.0f ? 32767.0f : lo);
+                    hi = hi < -32768.0f ? -32768.0f : (hi > 32767.0f ? 32767.0f : hi);
+                    Uint8 code = ima_encode((int)lo,predictor,index);
+                    code |= ima_encode((int)hi,predictor,index) << 4;
+                    packet[NETCODE_VOICE_HEADER+kk] = (std::byte)code;
+                }
+                sequence++;
+
+                auto network = _network.lock();
+                if (network != nullptr) {
+                    NetcodeMessage message = std::make_shared<const std::vector<std::byte>>(std::move(packet));
+                    if (network->sendVoice(message)) {
+                        _sent.fetch_add(1);
+                    }
+                }
+            }
+            phase -= 1.0;
+            previous = filtered;
+        }
+    }
+}
+
+/**
+ * Delivers a voice frame received from a peer.
+ *
+ * This method is called by the connection on the network thread. Invalid
+ * frames are ignored.
+ *
+ * @param source    The peer handle of the speaker
+ * @param data      The voice frame
+ */
+void NetcodeVoice::receive(Uint32 source, const std::vector<std::byte>& data) {
+    auto output = std::atomic_load(&_output);
+    if (output == nullptr || source == NETCODE_NO_HANDLE ||
+        data.size() != NETCODE_VOICE_HEADER+NETCODE_VOICE_FRAME/2 || (Uint8)data[5] > 88) {
+        return;
+    }
+
+    NetcodeVoiceNode::Frame frame;
+    frame.source = source;
+    frame.sequence  = (Uint16)((Uint8)data[1] | ((Uint8)data[2] << 8));
+    frame.predictor = (Sint16)(Uint16)((Uint8)data[3] | ((Uint8)data[4] << 8));
+    frame.index = (Uint8)data[5];
+    std::memcpy(frame.data,data.data()+NETCODE_VOICE_HEADER,NETCODE_VOICE_FRAME/2);
+    output->push(frame);
+}
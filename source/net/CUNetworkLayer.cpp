@@ -40,14 +40,46 @@
 //  Version: 1/6/23
 //
 #include <cugl/net/CUNetworkLayer.h>
+#include <cugl/base/CUBase.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUProfiler.h>
+#include <cugl/util/CULogger.h>
 #include <rtc/rtc.hpp>
 #include <variant>
 #include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstring>
 #include <cstddef>
+#if defined (__WINDOWS__)
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+#else
+    #include <sys/types.h>
+    #include <sys/socket.h>
+    #include <sys/select.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <netdb.h>
+    #include <unistd.h>
+#endif
 
 using namespace cugl::net;
 
+/** The number of network debug messages logged each second */
+#define NETCODE_LOG_LIMIT   50
+/** The number of STUN binding requests sent to probe an ICE server */
+#define PROBE_ATTEMPTS      3
+/** The time to wait for each STUN binding response (in milliseconds) */
+#define PROBE_TIMEOUT       500
+/** The probe result when the probe has not finished */
+#define PROBE_PENDING       -1
+/** The probe result when the server did not answer */
+#define PROBE_FAILED        -2
+/** The size of a STUN message header */
+#define STUN_HEADER         20
+
 #pragma mark Layer Singleton
 /** The RTC network manager singleton */
 NetworkLayer* NetworkLayer::_singleton = nullptr;
@@ -80,6 +112,149 @@ static rtc::LogLevel level2rtc(NetworkLayer::Log level) {
 	return rtc::LogLevel::None;
 }
 
+/**
+ * Returns the numeric IPV4 address of the given hostname
+ *
+ * This function blocks until the lookup completes. It returns the empty
+ * string if the hostname could not be resolved.
+ *
+ * @param hostname	The hostname to resolve
+ *
+ * @return the numeric IPV4 address of the given hostname
+ */
+static std::string lookup_host(const std::string hostname) {
+	struct addrinfo hints;
+	std::memset(&hints,0,sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	
+	struct addrinfo* info = nullptr;
+	if (getaddrinfo(hostname.c_str(),nullptr,&hints,&info) != 0 || info == nullptr) {
+		return "";
+	}
+	
+	std::string result;
+	char buffer[INET_ADDRSTRLEN];
+	if (getnameinfo(info->ai_addr,(socklen_t)info->ai_addrlen,buffer,sizeof(buffer),
+	                nullptr,0,NI_NUMERICHOST) == 0) {
+		result = buffer;
+	}
+	freeaddrinfo(info);
+	return result;
+}
+
+/**
+ * Returns the round trip time to a STUN (or TURN) server in microseconds
+ *
+ * This function sends up to PROBE_ATTEMPTS STUN binding requests (RFC 5389)
+ * over UDP, and returns the fastest answer. Both success and error responses
+ * count, as either shows how far away the server is. This function blocks
+ * until the probe completes. It returns PROBE_FAILED if the server never
+ * answered.
+ *
+ * If the server has a hostname, the lookup is the result of {@link lookup_host}.
+ * Otherwise, it is invalid and the address is used as is.
+ *
+ * @param lookup	The hostname lookup (invalid for a numeric address)
+ * @param address	The server address
+ * @param port		The server port
+ *
+ * @return the round trip time to a STUN (or TURN) server in microseconds
+ */
+static int64_t probe_server(std::shared_future<std::string> lookup,
+                            const std::string address, uint16_t port) {
+	std::string host = lookup.valid() ? lookup.get() : address;
+	struct sockaddr_in target;
+	std::memset(&target,0,sizeof(target));
+	target.sin_family = AF_INET;
+	target.sin_port = htons(port);
+	if (host.empty() || inet_pton(AF_INET,host.c_str(),&target.sin_addr) != 1) {
+		return PROBE_FAILED;
+	}
+
+#if defined (__WINDOWS__)
+	WSADATA data;
+	if (WSAStartup(MAKEWORD(2,2),&data) != 0) {
+		return PROBE_FAILED;
+	}
+	SOCKET sock = socket(AF_INET,SOCK_DGRAM,IPPROTO_UDP);
+	bool valid = sock != INVALID_SOCKET;
+#else
+	int sock = socket(AF_INET,SOCK_DGRAM,IPPROTO_UDP);
+	bool valid = sock >= 0;
+#endif
+
+	typedef std::chrono::steady_clock clock;
+	std::mt19937 random(std::random_device{}());
+	int64_t best = PROBE_FAILED;
+	for(int ii = 0; valid && ii < PROBE_ATTEMPTS; ii++) {
+		// Binding request with no attributes and a random transaction id
+		Uint8 request[STUN_HEADER] = { 0x00, 0x01, 0x00, 0x00, 0x21, 0x12, 0xA4, 0x42 };
+		for(size_t jj = 8; jj < STUN_HEADER; jj++) {
+			request[jj] = (Uint8)(random() & 0xff);
+		}
+		
+		auto start = clock::now();
+		if (sendto(sock,(const char*)request,STUN_HEADER,0,
+		           (struct sockaddr*)&target,sizeof(target)) != STUN_HEADER) {
+			break;
+		}
+		
+		auto deadline = start+std::chrono::milliseconds(PROBE_TIMEOUT);
+		bool answered = false;
+		while (!answered) {
+			auto now = clock::now();
+			if (now >= deadline) {
+				break;
+			}
+			long wait = (long)std::chrono::duration_cast<std::chrono::microseconds>(deadline-now).count();
+			struct timeval timeout;
+			timeout.tv_sec  = wait/1000000;
+			timeout.tv_usec = wait%1000000;
+			fd_set reads;
+			FD_ZERO(&reads);
+			FD_SET(sock,&reads);
+			if (select((int)sock+1,&reads,nullptr,nullptr,&timeout) <= 0) {
+				break;
+			}
+			
+			Uint8 response[512];
+			int size = (int)recv(sock,(char*)response,sizeof(response),0);
+			answered = (size >= STUN_HEADER && response[0] == 0x01 &&
+			            (response[1] == 0x01 || response[1] == 0x11) &&
+			            std::memcmp(response+4,request+4,STUN_HEADER-4) == 0);
+		}
+		
+		if (answered) {
+			int64_t rtt = std::chrono::duration_cast<std::chrono::microseconds>(clock::now()-start).count();
+			best = (best < 0 ? rtt : std::min(best,rtt));
+		}
+	}
+
+#if defined (__WINDOWS__)
+	if (valid) {
+		closesocket(sock);
+	}
+	WSACleanup();
+#else
+	if (valid) {
+		close(sock);
+	}
+#endif
+	return best;
+}
+
+/**
+ * Returns the probe key for the given ICE server
+ *
+ * @param server	The ICE server
+ *
+ * @return the probe key for the given ICE server
+ */
+static std::string probe_key(const ICEAddress& server) {
+	return server.address+":"+std::to_string(server.port);
+}
+
 /**
  * Creates the RTC networking layer.
  *
@@ -91,6 +266,10 @@ NetworkLayer::NetworkLayer(Log level) {
 	InitLogger(level2rtc(level));
 	rtcPreload();
 	_debug = (int)level >= (int)Log::NETCODE;
+	if (_debug) {
+		SDL_LogSetPriority(CU_LOG_CATEGORY_NETCODE,SDL_LOG_PRIORITY_INFO);
+		Logger::setRateLimit(CU_LOG_CATEGORY_NETCODE,NETCODE_LOG_LIMIT);
+	}
 }
 
 /**
@@ -112,6 +291,7 @@ NetworkLayer::~NetworkLayer() {
  * @return true if the network sublayer was successfully initialized
  */
 bool NetworkLayer::start(Log level) {
+    CU_PROFILE_SCOPE("NetworkLayer::start");
 	if (_singleton == nullptr) {
 		_singleton = new NetworkLayer(level);
 	}
@@ -135,3 +315,159 @@ bool NetworkLayer::stop() {
 	}
 	return false;
 }
+
+#pragma mark -
+#pragma mark ICE Servers
+/**
+ * Starts resolving the hostnames of the given ICE servers.
+ *
+ * Every STUN/TURN server specified by hostname must be resolved before ICE
+ * gathering can contact it. On mobile networks this can add noticeably to
+ * the time it takes to join a game. This method resolves the hostnames in
+ * the background, and caches the results for {@link #resolve}. It never
+ * blocks, and each hostname is only resolved once.
+ *
+ * Once a server is resolved, it is also probed with STUN binding requests
+ * to measure its round trip time (see {@link #getRTT}). Both STUN and TURN
+ * servers answer these requests. The measurements are used by
+ * {@link #rank} to prefer nearby servers.
+ *
+ * This method is called by {@link NetcodeConnection} when it is initialized,
+ * well before it needs to create any peer connections.
+ *
+ * @param servers   The ICE servers to resolve
+ */
+void NetworkLayer::prewarm(const std::vector<ICEAddress>& servers) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	for(auto it = servers.begin(); it != servers.end(); ++it) {
+		std::shared_future<std::string> lookup;
+		if (it->getType() == InetAddress::Type::HOSTNAME) {
+			auto find = _lookups.find(it->address);
+			if (find == _lookups.end()) {
+				if (_debug) {
+					CULog("NETCODE: Resolving ICE server %s",it->address.c_str());
+				}
+				lookup = std::async(std::launch::async,lookup_host,it->address).share();
+				_lookups.emplace(it->address,lookup);
+			} else {
+				lookup = find->second;
+			}
+		}
+		
+		std::string key = probe_key(*it);
+		if (!_probes.count(key)) {
+			_probes.emplace(key,std::async(std::launch::async,probe_server,lookup,
+			                               it->address,it->port).share());
+		}
+	}
+}
+
+/**
+ * Returns the given ICE server with its hostname resolved.
+ *
+ * If the hostname of this server has been resolved by {@link #prewarm},
+ * the result has the numeric address instead. Otherwise, the server is
+ * returned as is (so that the RTC layer resolves it). This method never
+ * blocks on a lookup that has not finished.
+ *
+ * @param server    The ICE server to resolve
+ *
+ * @return the given ICE server with its hostname resolved.
+ */
+ICEAddress NetworkLayer::resolve(const ICEAddress& server) {
+	ICEAddress result(server);
+	if (server.getType() != InetAddress::Type::HOSTNAME) {
+		return result;
+	}
+	
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto find = _lookups.find(server.address);
+	if (find != _lookups.end() &&
+	    find->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		const std::string& address = find->second.get();
+		if (!address.empty()) {
+			result.address = address;
+		}
+	}
+	return result;
+}
+
+/**
+ * Returns the measured round trip time to the given ICE server.
+ *
+ * The value is in milliseconds. It is the best of several STUN binding
+ * requests sent after {@link #prewarm}. This method returns -1 if the
+ * server was never probed, if the probe has not finished, or if the
+ * server did not answer. It never blocks.
+ *
+ * @param server    The ICE server
+ *
+ * @return the measured round trip time to the given ICE server.
+ */
+int64_t NetworkLayer::getRTT(const ICEAddress& server) {
+	int64_t probe = getProbe(server);
+	return probe < 0 ? -1 : (probe+999)/1000;
+}
+
+/**
+ * Returns the given ICE servers resolved and ranked by round trip time.
+ *
+ * The servers that answered their probe come first, nearest first. They
+ * are followed by the servers whose probe has not finished, and then by
+ * the servers that did not answer. Servers in the same group keep their
+ * original order. Each server is resolved as with {@link #resolve}.
+ *
+ * The RTC layer only uses the first STUN server, and it prefers relays
+ * in the order they are given. Hence this ranking keeps peers from
+ * gathering through a distant server. This method never blocks.
+ *
+ * @param servers   The ICE servers to rank
+ *
+ * @return the given ICE servers resolved and ranked by round trip time.
+ */
+std::vector<ICEAddress> NetworkLayer::rank(const std::vector<ICEAddress>& servers) {
+	std::vector<std::pair<int64_t,ICEAddress>> ranked;
+	ranked.reserve(servers.size());
+	for(auto it = servers.begin(); it != servers.end(); ++it) {
+		int64_t probe = getProbe(*it);
+		if (probe == PROBE_PENDING) {
+			probe = INT64_MAX-1;
+		} else if (probe == PROBE_FAILED) {
+			probe = INT64_MAX;
+		}
+		ranked.emplace_back(probe,resolve(*it));
+	}
+	
+	std::stable_sort(ranked.begin(),ranked.end(),[](const std::pair<int64_t,ICEAddress>& a,
+	                                                const std::pair<int64_t,ICEAddress>& b) {
+		return a.first < b.first;
+	});
+	
+	std::vector<ICEAddress> result;
+	result.reserve(ranked.size());
+	for(auto it = ranked.begin(); it != ranked.end(); ++it) {
+		result.push_back(it->second);
+	}
+	return result;
+}
+
+/**
+ * Returns the probe result for the given ICE server.
+ *
+ * The result is the round trip time in microseconds. It is -1 if there
+ * is no probe result yet, and -2 if the server did not answer. This
+ * method never blocks.
+ *
+ * @param server    The ICE server
+ *
+ * @return the probe result for the given ICE server.
+ */
+int64_t NetworkLayer::getProbe(const ICEAddress& server) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto find = _probes.find(probe_key(server));
+	if (find == _probes.end() ||
+	    find->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+		return PROBE_PENDING;
+	}
+	return find->second.get();
+}
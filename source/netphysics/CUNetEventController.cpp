@@ -28,8 +28,58 @@
 
 #include <cugl/netphysics/CUNetEventController.h>
 #include <cugl/netphysics/CULWSerializer.h>
+#include <cugl/util/CUProfiler.h>
+#include <cstring>
 
 #define MIN_MSG_LENGTH sizeof(std::byte)+sizeof(Uint64)
+/** The number of ticks of input repeated in each input event */
+#define INPUT_REDUNDANCY 3
+/** The number of clock samples kept for the minimum round trip filter */
+#define CLOCK_SAMPLES 8
+/** The ticks between pings while the clock is first synchronized */
+#define CLOCK_BURST_INTERVAL 4
+/** The ticks between pings once the sample window is full */
+#define CLOCK_PING_INTERVAL 60
+/** The largest offset correction (in ticks) that is applied gradually */
+#define CLOCK_STEP_LIMIT 4.0
+/** The largest gradual offset correction (in ticks) per sample */
+#define CLOCK_SLEW 0.25
+/** The smoothing factor of the round trip time (as in TCP) */
+#define RTT_ALPHA 0.125
+/** The smoothing factor of the round trip deviation (as in TCP) */
+#define RTT_BETA 0.25
+/** The smoothing factor of the ping loss of a link */
+#define LOSS_ALPHA 0.25
+/** The initial send budget in bytes per tick */
+#define CONGESTION_INIT_BUDGET 2048.0
+/** The smallest send budget in bytes per tick */
+#define CONGESTION_MIN_BUDGET 256.0
+/** The largest send budget in bytes per tick */
+#define CONGESTION_MAX_BUDGET 16384.0
+/** The growth of the send budget per ping without congestion */
+#define CONGESTION_INCREASE 256.0
+/** The factor the send budget is cut by on congestion */
+#define CONGESTION_DECREASE 0.5
+/** The ping loss that counts as congestion */
+#define CONGESTION_LOSS 0.05
+/** The growth in round trip time (in ticks) that counts as congestion */
+#define CONGESTION_DELAY 4.0
+/** The number of ticks of budget that may be saved up for a burst */
+#define CONGESTION_BURST 4.0
+/** The most ticks between two physics snapshots, no matter the budget */
+#define CONGESTION_MAX_INTERVAL 30
+/** The fewest ticks before an unacknowledged sequenced event is resent */
+#define SEQUENCED_RESEND_MIN 4
+/** The resend interval of sequenced events in round trips */
+#define SEQUENCED_RESEND_SCALE 1.5
+/** The largest payload of a sequenced envelope (more events wait a tick) */
+#define SEQUENCED_MAX_BYTES 1024
+/** The initial capacity of the callback queue of a detached controller */
+#define DETACHED_QUEUE 64
+/** The default number of ticks between spectator snapshots */
+#define SPECTATOR_INTERVAL 6
+/** The default number of ticks that spectator snapshots lag behind */
+#define SPECTATOR_DELAY 60
 
 using namespace cugl::netphysics;
 
@@ -64,17 +114,53 @@ using namespace cugl::netphysics;
 bool NetEventController::init(const std::shared_ptr<cugl::AssetManager>& assets) {
     // Attach the primitive event types for deserialization
     attachEventType<GameStateEvent>();
+    attachEventType<ClockSyncEvent>(NetEventPool<ClockSyncEvent>::alloc());
+    _sequencedPool = NetEventPool<SequencedEvent>::alloc();
+    attachEventType<SequencedEvent>(NetEventPool<SequencedEvent>::alloc());
+    attachEventType<SubscriptionEvent>();
+    _coreTypes = _newEventVector.size();
+    setBuiltinHandler<GameStateEvent>(&NetEventController::processGameStateEvent);
+    setBuiltinHandler<ClockSyncEvent>(&NetEventController::processClockSyncEvent);
+    setBuiltinHandler<SequencedEvent>(&NetEventController::processSequencedEvent);
+    setBuiltinHandler<SubscriptionEvent>(&NetEventController::processSubscriptionEvent);
+    setEventLane<ClockSyncEvent>(net::NetcodeConnection::Lane::UNRELIABLE);
+    setEventLane<SequencedEvent>(net::NetcodeConnection::Lane::UNRELIABLE);
 
     // Configure the NetcodeConnection
     _assets = assets;
     auto json = _assets->get<JsonValue>("server");
     _config.set(json);
     _status = Status::IDLE;
+    _spectatorInterval = SPECTATOR_INTERVAL;
+    _spectatorDelay = SPECTATOR_DELAY;
     _appRef = Application::get();
     _physController = NetPhysicsController::alloc();
     return true;
 }
 
+/**
+ * Initializes a detached controller with the given asset manager.
+ *
+ * A detached controller does not use the {@link Application}. Its clock
+ * only advances with {@link advanceTick()}, and its network callbacks are
+ * run at the start of {@link updateNet()}, on whichever thread calls it.
+ * So many detached controllers can run in the same process, each on a
+ * thread of its own (or a task of a {@link ThreadPool}).
+ *
+ * The asset manager has the same requirements as {@link init}.
+ */
+bool NetEventController::initDetached(const std::shared_ptr<AssetManager>& assets) {
+    if (!init(assets)) {
+        return false;
+    }
+    _appRef = nullptr;
+    _detached = true;
+    _ticks = 0;
+    _tickTime.mark();
+    _callbacks = std::make_shared<MPSCQueue<std::function<bool()>>>(DETACHED_QUEUE,OverflowPolicy::GROW);
+    return true;
+}
+
 /**
  * Starts handshake process for starting game.
  
@@ -119,6 +205,8 @@ bool NetEventController::connectAsHost() {
         _physController = NetPhysicsController::alloc();
         _status = Status::CONNECTING;
         _network = net::NetcodeConnection::alloc(_config);
+        _network->setBatching(true);
+        attachScheduler();
         _network->open();
     }
     return checkConnection();
@@ -139,12 +227,80 @@ bool NetEventController::connectAsClient(std::string roomid) {
         _physController = NetPhysicsController::alloc();
         _status = Status::CONNECTING;
         _network = net::NetcodeConnection::alloc(_config, roomid);
+        _network->setBatching(true);
+        attachScheduler();
         _network->open();
     }
     _roomid = roomid;
     return checkConnection();
 }
 
+/**
+ * Connect to an existing lobby as a spectator.
+ *
+ * A spectator only connects to the host (or its relay), and cannot send
+ * gameplay events. It does not take part in the start handshake, and it
+ * is not assigned a UID. Once the game is in progress, the host starts it
+ * and sends it the world. From then on it receives a delayed physics
+ * snapshot every few ticks (see {@link setSpectatorInterval} and
+ * {@link setSpectatorDelay}), along with the events marked with
+ * {@link setSpectated}.
+ *
+ * If successful, the controller status changes to CONNECTED.
+ */
+bool NetEventController::connectAsSpectator(std::string roomid) {
+    if (_status == Status::NETERROR) {
+        disconnect();
+    }
+
+    _isHost = false;
+    if (_status == Status::IDLE) {
+        net::NetcodeConfig config = _config;
+        config.spectator = true;
+        _physController = NetPhysicsController::alloc();
+        _status = Status::CONNECTING;
+        _network = net::NetcodeConnection::alloc(config, roomid);
+        _network->setBatching(true);
+        attachScheduler();
+        _network->open();
+    }
+    _roomid = roomid;
+    return checkConnection();
+}
+
+/**
+ * Routes the callbacks of the network connection to this controller.
+ *
+ * A detached controller queues the callbacks, to be run in updateNet().
+ * Otherwise the connection schedules them with the application.
+ */
+void NetEventController::attachScheduler() {
+    if (!_detached) {
+        return;
+    }
+    // The queue (and not this controller) must outlive the connection
+    std::shared_ptr<MPSCQueue<std::function<bool()>>> queue = _callbacks;
+    _network->setScheduler([queue](std::function<bool()> callback) {
+        queue->push(std::move(callback));
+    });
+}
+
+/**
+ * Runs the network callbacks waiting for a detached controller.
+ */
+void NetEventController::processCallbacks() {
+    std::function<bool()> callback;
+    std::vector<std::function<bool()>> repeat;
+    while (_callbacks->pop(callback)) {
+        if (callback()) {
+            repeat.push_back(std::move(callback));
+        }
+    }
+    for(auto it = repeat.begin(); it != repeat.end(); ++it) {
+        _callbacks->push(std::move(*it));
+    }
+}
+
 /**
  * Disconnect from the current lobby.
  */
@@ -152,6 +308,8 @@ void NetEventController::disconnect() {
     if(_network)
         _network->close();
     _network = nullptr;
+    _peerNames.clear();
+    _replay = nullptr;
     _shortUID = 0;
     _status = Status::IDLE;
     _physEnabled = false;
@@ -159,6 +317,19 @@ void NetEventController::disconnect() {
     _startGameTimeStamp = 0;
     _numReady = 0;
     _outEventQueue.clear();
+    drainDecoder();
+    _decoded.clear();
+    _input.clear();
+    _inputHistory.clear();
+    _lastInputTick.clear();
+    resetClock();
+    resetCongestion();
+    _seqLinks.clear();
+    _peerSubscriptions.clear();
+    _announced.clear();
+    _admitted.clear();
+    _spectatorSync = nullptr;
+    _lastSpectatorTick = 0;
     while (!_inEventQueue.empty()) {
         _inEventQueue.pop();
     }
@@ -190,12 +361,14 @@ bool NetEventController::checkConnection() {
             CULog("NUM Players: %zu", players.size());
             for (auto it = players.begin(); it != players.end(); it++) {
                 CULog("Player Name: %s", (*it).c_str());
-                _network->sendTo((*it), wrap(GameStateEvent::allocUIDAssign(shortUID++)));
+                if (!_network->isSpectator(*it)) {
+                    _network->sendTo((*it), wrap(GameStateEvent::allocUIDAssign(shortUID++)));
+                }
             }
         }
 		return true;
 	}
-    else if (_status == READY && _numReady == _network->getNumPlayers() && _isHost) {
+    else if (_status == READY && _numReady == _network->getNumPlayers()-_network->getNumSpectators() && _isHost) {
         CULog("GAME START MESSAGE SENT");
         pushOutEvent(GameStateEvent::allocGameStart());
     }
@@ -213,28 +386,217 @@ bool NetEventController::checkConnection() {
 }
 
 /**
- * Processes all events received during the last update.
+ * Processes an event received during the last update.
  *
- * This method either processes events internally if it is a built-in event
- * and adds them to the inbound event queue otherwise.
+ * The event is passed to the handler for its type id, if there is one.
+ * This includes all of the built-in events. Otherwise, the event is added
+ * to the inbound event queue if the game is in progress.
+ *
+ * @param type  The type id of the event
+ * @param e     The received event
  */
-void NetEventController::processReceivedEvent(const std::shared_ptr<NetEvent>& e) {
-    if (auto game = std::dynamic_pointer_cast<GameStateEvent>(e)) {
-        processGameStateEvent(game);
-    } else if (_status == INGAME){
-        if (auto phys = std::dynamic_pointer_cast<PhysSyncEvent>(e)) {
-            if(_physEnabled)
-			    _physController->processPhysSyncEvent(phys);
-		}
-        else if (auto phys = std::dynamic_pointer_cast<PhysObjEvent>(e)) {
-            if (_physEnabled) {
-                _physController->processPhysObjEvent(phys);
-            }
+void NetEventController::processReceivedEvent(Uint8 type, const std::shared_ptr<NetEvent>& e) {
+    // Only the host hears from spectators, and they cannot change the game
+    if (_isHost && type >= _coreTypes && _network != nullptr && _network->isSpectator(e->getSourceId())) {
+        return;
+    }
+    auto& handler = _eventHandlers[type];
+    if (handler) {
+        handler(e);
+    } else if (_status == INGAME) {
+        _inEventQueue.push(e);
+    }
+}
+
+/**
+ * Processes a physics snapshot from a peer.
+ *
+ * Snapshots arrive unordered, so any snapshot older than the latest one
+ * from the same peer is dropped.
+ */
+void NetEventController::processPhysSyncEvent(const std::shared_ptr<PhysSyncEvent>& e) {
+    if (_status != INGAME || (_authoritative && _isHost)) {
+        return; // The host is the only authority
+    }
+    auto it = _lastSyncStamp.find(e->getSourceId());
+    if (it != _lastSyncStamp.end() && it->second > e->getEventTimeStamp()) {
+        return;
+    }
+    _lastSyncStamp[e->getSourceId()] = e->getEventTimeStamp();
+    if (_physEnabled) {
+        _physController->processPhysSyncEvent(e);
+    }
+}
+
+/**
+ * Processes an obstacle event from a peer.
+ */
+void NetEventController::processPhysObjEvent(const std::shared_ptr<PhysObjEvent>& e) {
+    if (_status != INGAME || (_authoritative && _isHost)) {
+        return; // The host is the only authority
+    }
+    if (_physEnabled) {
+        _physController->processPhysObjEvent(e);
+    }
+}
+
+/**
+ * Processes a batch of obstacle changes from a peer.
+ */
+void NetEventController::processPhysDeltaEvent(const std::shared_ptr<PhysDeltaEvent>& e) {
+    if (_status != INGAME || (_authoritative && _isHost)) {
+        return; // The host is the only authority
+    }
+    if (_physEnabled) {
+        _physController->processPhysDeltaEvent(e);
+    }
+}
+
+/**
+ * Processes a checksum event from a peer.
+ */
+void NetEventController::processPhysChecksumEvent(const std::shared_ptr<PhysChecksumEvent>& e) {
+    if (_status == INGAME && _physEnabled) {
+        _physController->processChecksumEvent(e);
+    }
+}
+
+/**
+ * Processes an ownership checkpoint from the host.
+ */
+void NetEventController::processPhysCheckpointEvent(const std::shared_ptr<PhysCheckpointEvent>& e) {
+    if (_status == INGAME && _physEnabled && !_isHost && _network != nullptr &&
+        e->getSourceId() == _network->getHost()) {
+        _physController->processCheckpointEvent(e);
+    }
+}
+
+/**
+ * Processes a chunk of a late-join world transfer from the host.
+ */
+void NetEventController::processPhysWorldEvent(const std::shared_ptr<PhysWorldEvent>& e) {
+    if (_status == INGAME && _physEnabled && !_isHost && _network != nullptr &&
+        e->getSourceId() == _network->getHost()) {
+        _physController->processWorldEvent(e);
+    }
+}
+
+/**
+ * Processes a change to a shared joint from a peer.
+ */
+void NetEventController::processPhysJointEvent(const std::shared_ptr<PhysJointEvent>& e) {
+    if (_status != INGAME || (_authoritative && _isHost)) {
+        return; // The host is the only authority
+    }
+    if (_physEnabled) {
+        _physController->processJointEvent(e);
+    }
+}
+
+/**
+ * Processes a snapshot of groups of jointed obstacles from a peer.
+ *
+ * Snapshots arrive unordered, so any snapshot older than the latest one
+ * from the same peer is dropped.
+ */
+void NetEventController::processPhysGroupEvent(const std::shared_ptr<PhysGroupEvent>& e) {
+    if (_status != INGAME || (_authoritative && _isHost)) {
+        return; // The host is the only authority
+    }
+    auto it = _lastGroupStamp.find(e->getSourceId());
+    if (it != _lastGroupStamp.end() && it->second > e->getEventTimeStamp()) {
+        return;
+    }
+    _lastGroupStamp[e->getSourceId()] = e->getEventTimeStamp();
+    if (_physEnabled) {
+        _physController->processGroupEvent(e);
+    }
+}
+
+/**
+ * Takes over as host after this client was promoted in a host migration.
+ *
+ * The clock offset is kept, so the server tick carries on from the old
+ * host. The physics controller takes over the obstacles of the old host
+ * from its last checkpoint (see {@link NetPhysicsController#promote}).
+ */
+void NetEventController::promoteToHost() {
+    CULog("PROMOTED TO HOST");
+    _isHost = true;
+    _clockSynced = true;
+    _lastSyncStamp.clear();
+    _lastGroupStamp.clear();
+    _inputHistory.clear();
+    _admitted.clear();
+    resetCongestion();
+    if (_physEnabled) {
+        _physController->promote(_network->getPlayers());
+    }
+}
+
+/**
+ * Processes an input event from a client.
+ *
+ * Input events repeat the inputs of the last few ticks. This method splits
+ * the event into one event for every tick not yet received, and adds them
+ * to the inbound event queue.
+ */
+void NetEventController::processPhysInputEvent(const std::shared_ptr<PhysInputEvent>& e) {
+    if (_status != INGAME || !_isHost) {
+        return;
+    }
+    if (_physEnabled) {
+        _physController->processPhysInputEvent(e);
+    }
+    
+    const std::vector<std::vector<std::byte>>& inputs = e->getInputs();
+    auto it = _lastInputTick.find(e->getSourceId());
+    Uint64 last = it == _lastInputTick.end() ? 0 : it->second;
+    if (e->getTick() <= last && it != _lastInputTick.end()) {
+        return;
+    }
+    
+    for (size_t ii = 0; ii < inputs.size(); ii++) {
+        Uint64 back = inputs.size()-1-ii;
+        if (e->getTick() < back) {
+            continue;
+        }
+        Uint64 tick = e->getTick()-back;
+        if (it != _lastInputTick.end() && tick <= last) {
+            continue;
         }
-        else {
-            _inEventQueue.push(e);
-        } 
+        auto single = _inputPool->get();
+        single->setTick(tick);
+        single->addInput(inputs[ii]);
+        single->setSourceUID(e->getSourceUID());
+        single->setMetaData(e->getEventTimeStamp(), e->getReceiveTimeStamp(), e->_sourceHandle, e->_sourceID);
+        _inEventQueue.push(single);
+    }
+    _lastInputTick[e->getSourceId()] = e->getTick();
+}
+
+/**
+ * Sends the input commands of this tick to the host.
+ *
+ * This method is only used by clients in host-authoritative mode. Inputs
+ * are sent every tick, even if they are empty, as they carry the
+ * acknowledgements for the host snapshots.
+ */
+void NetEventController::sendInput() {
+    Uint64 tick = getGameTick();
+    _physController->recordPrediction(tick, _input);
+    _inputHistory.push_back(std::move(_input));
+    _input.clear();
+    if (_inputHistory.size() > INPUT_REDUNDANCY) {
+        _inputHistory.pop_front();
+    }
+    
+    auto e = _physController->allocInputEvent(tick);
+    for (auto it = _inputHistory.begin(); it != _inputHistory.end(); ++it) {
+        e->addInput(*it);
     }
+    e->setDestinationId(_network->getHost());
+    pushOutEvent(e);
 }
 
 /**
@@ -243,14 +605,20 @@ void NetEventController::processReceivedEvent(const std::shared_ptr<NetEvent>& e
  * This method updates the controller status based on the event received.
  */
 void NetEventController::processGameStateEvent(const std::shared_ptr<GameStateEvent>& e) {
-    CULog("GAME STATE %d, CUR STATE %d", e->getType(), _status);
+    CULogCategory(CU_LOG_CATEGORY_NETCODE,"GAME STATE %d, CUR STATE %d", e->getType(), _status);
     if (_status == HANDSHAKE && e->getType() == GameStateEvent::UID_ASSIGN) {
         _shortUID = e->getShortUID();
         CULog("THE UID ASSIGNED IS %x", _shortUID);
     }
-    if (_status == READY && e->getType() == GameStateEvent::GAME_START) {
+    // Spectators skip the handshake, and are started by the host
+    bool watching = isSpectator() && (_status == CONNECTED || _status == HANDSHAKE);
+    if ((_status == READY || watching) && e->getType() == GameStateEvent::GAME_START) {
         _status = INGAME;
-        _startGameTimeStamp = _appRef->getUpdateCount();
+        _startGameTimeStamp = getUpdateCount();
+        resetClock();
+        resetCongestion();
+        _seqLinks.clear();
+        _clockSynced = _isHost;
     }
     if (_isHost) {
         if (e->getType() == GameStateEvent::CLIENT_RDY) {
@@ -258,7 +626,249 @@ void NetEventController::processGameStateEvent(const std::shared_ptr<GameStateEv
             CULog("RECEIVED RDY FROM %s", e->getSourceId().c_str());
         }
     }
-    CULog("FINISHED STATE %d", _status);
+    CULogCategory(CU_LOG_CATEGORY_NETCODE,"FINISHED STATE %d", _status);
+}
+
+/**
+ * Processes a clock synchronization event.
+ *
+ * Every peer answers pings with a pong, and records the round trip of
+ * every pong for its link statistics. Clients also turn a pong from the
+ * host into a clock sample, and update the clock offset and round trip
+ * estimates.
+ */
+void NetEventController::processClockSyncEvent(const std::shared_ptr<ClockSyncEvent>& e) {
+    if (_status != INGAME) {
+        return;
+    }
+    if (e->getType() == ClockSyncEvent::PING) {
+        // Everyone answers, so that every peer can measure its links
+        Uint64 now = getServerTick();
+        auto pong = ClockSyncEvent::allocPong(e->getOriginTick(), now, now);
+        pong->setDestinationId(e->getSourceId());
+        pushOutEvent(pong);
+        return;
+    }
+    
+    // The four NTP timestamps (t0 and t3 local, t1 and t2 on the peer)
+    double t0 = (double)e->getOriginTick();
+    double t1 = (double)e->getReceiveTick();
+    double t2 = (double)e->getTransmitTick();
+    double t3 = (double)getGameTick();
+    if (t3 < t0) {
+        return; // A ping from before the clock was reset
+    }
+    
+    ClockSample sample;
+    sample.rtt = (t3-t0)-(t2-t1);
+    sample.offset = ((t1-t0)+(t2-t3))/2;
+    if (sample.rtt < 0) {
+        sample.rtt = 0;
+    }
+    recordRoundTrip(e->getSourceId(), sample.rtt, e->getOriginTick());
+    if (_isHost) {
+        return; // The host clock is the reference
+    }
+    _clockSamples.push_back(sample);
+    if (_clockSamples.size() > CLOCK_SAMPLES) {
+        _clockSamples.pop_front();
+    }
+    
+    // Jitter only ever adds delay, so the fastest sample is the most accurate
+    const ClockSample* best = &_clockSamples.front();
+    for (auto it = _clockSamples.begin(); it != _clockSamples.end(); ++it) {
+        if (it->rtt < best->rtt) {
+            best = &(*it);
+        }
+    }
+    
+    if (!_clockSynced) {
+        _clockOffset = best->offset;
+        _roundTrip = sample.rtt;
+        _roundTripVar = sample.rtt/2;
+        _clockSynced = true;
+        return;
+    }
+    
+    double error = best->offset-_clockOffset;
+    if (std::abs(error) > CLOCK_STEP_LIMIT) {
+        _clockOffset = best->offset;
+    } else if (error > CLOCK_SLEW) {
+        _clockOffset += CLOCK_SLEW;
+    } else if (error < -CLOCK_SLEW) {
+        _clockOffset -= CLOCK_SLEW;
+    } else {
+        _clockOffset = best->offset;
+    }
+    
+    _roundTripVar += RTT_BETA*(std::abs(sample.rtt-_roundTrip)-_roundTripVar);
+    _roundTrip += RTT_ALPHA*(sample.rtt-_roundTrip);
+}
+
+/**
+ * Sends a clock synchronization ping if one is due.
+ *
+ * Clients ping the host, and the host pings every client. The first few
+ * pings are sent in quick succession so that the clock is synchronized soon
+ * after the game starts. After that, pings are only sent every so often to
+ * follow the clock drift and latency changes.
+ *
+ * The steady pings are also how the links are measured. A ping that has not
+ * been answered by the time the next one is due counts as lost, and the send
+ * budget is updated before every such ping.
+ */
+void NetEventController::sendClockPing() {
+    Uint64 now = getGameTick();
+    Uint64 interval = _pingCount < CLOCK_SAMPLES ? CLOCK_BURST_INTERVAL : CLOCK_PING_INTERVAL;
+    if (_pingCount > 0 && now < _lastPingTick+interval) {
+        return;
+    }
+    
+    // Burst pings are too close together to time out
+    if (_pingCount > CLOCK_SAMPLES) {
+        for (auto it = _links.begin(); it != _links.end(); ) {
+            if (!_network->isPlayerActive(it->first)) {
+                it = _links.erase(it);
+                continue;
+            }
+            it->second.loss += LOSS_ALPHA*((it->second.answered ? 0 : 1)-it->second.loss);
+            ++it;
+        }
+        updateCongestion();
+    }
+    for (auto it = _links.begin(); it != _links.end(); ++it) {
+        it->second.answered = false;
+    }
+    
+    auto ping = ClockSyncEvent::allocPing(now);
+    if (!_isHost) {
+        ping->setDestinationId(_network->getHost());
+    }
+    pushOutEvent(ping);
+    _lastPingTick = now;
+    _pingCount++;
+}
+
+/**
+ * Resets the clock synchronization estimates.
+ */
+void NetEventController::resetClock() {
+    _clockSamples.clear();
+    _clockOffset = 0;
+    _roundTrip = 0;
+    _roundTripVar = 0;
+    _clockSynced = false;
+    _lastPingTick = 0;
+    _pingCount = 0;
+}
+
+/**
+ * Records a round trip to the given peer.
+ *
+ * @param source    The UUID of the peer
+ * @param rtt       The round trip time in ticks
+ * @param origin    The local game tick of the answered ping
+ */
+void NetEventController::recordRoundTrip(const std::string& source, double rtt, Uint64 origin) {
+    auto it = _links.find(source);
+    if (it == _links.end()) {
+        LinkStats link;
+        link.rtt = rtt;
+        link.minRtt = rtt;
+        link.loss = 0;
+        link.answered = false;
+        it = _links.emplace(source,link).first;
+    }
+    LinkStats& link = it->second;
+    link.rtt += RTT_ALPHA*(rtt-link.rtt);
+    link.minRtt = SDL_min(link.minRtt,rtt);
+    if (origin == _lastPingTick) {
+        link.answered = true;
+    }
+}
+
+/**
+ * Adjusts the send budget to the measured quality of the links.
+ *
+ * The budget is adjusted AIMD style, as in TCP. If the worst link loses
+ * pings, or its round trip time has grown well beyond its minimum (so the
+ * packets are queueing up somewhere), the budget is halved. Otherwise, it
+ * grows by a fixed amount.
+ */
+void NetEventController::updateCongestion() {
+    bool congested = false;
+    for (auto it = _links.begin(); it != _links.end(); ++it) {
+        const LinkStats& link = it->second;
+        if (link.loss > CONGESTION_LOSS || link.rtt > link.minRtt+CONGESTION_DELAY) {
+            congested = true;
+        }
+    }
+    
+    if (congested) {
+        _sendBudget = SDL_max(_sendBudget*CONGESTION_DECREASE,CONGESTION_MIN_BUDGET);
+    } else {
+        _sendBudget = SDL_min(_sendBudget+CONGESTION_INCREASE,CONGESTION_MAX_BUDGET);
+    }
+    if (_congestionControl && _physController) {
+        _physController->setPrioritySyncBudget((size_t)_sendBudget);
+    }
+}
+
+/**
+ * Resets the send budget and the link measurements.
+ */
+void NetEventController::resetCongestion() {
+    _links.clear();
+    _sendBudget = CONGESTION_INIT_BUDGET;
+    _sendCredit = 0;
+    _lastSyncTick = 0;
+}
+
+/**
+ * Returns the smoothed ping loss of the worst link.
+ *
+ * @return the smoothed ping loss of the worst link.
+ */
+double NetEventController::getPacketLoss() const {
+    double result = 0;
+    for (auto it = _links.begin(); it != _links.end(); ++it) {
+        result = SDL_max(result,it->second.loss);
+    }
+    return result;
+}
+
+/**
+ * Returns the estimated (fractional) game tick of the host at the given time.
+ *
+ * This method maps a timestamp, such as that of a {@link KeyEvent},
+ * {@link MouseEvent} or {@link TouchEvent}, onto the same clock as
+ * {@link getServerTick()}. The fractional part is how far into the
+ * tick the event happened. Clients can use this to tag their input
+ * commands (see {@link setInput()}) with the exact moment of the input,
+ * so that the host can compensate for lag.
+ *
+ * A detached controller assumes that {@link advanceTick()} is called
+ * once every FIXED_TIMESTEP, starting at the time of the call.
+ *
+ * @param stamp The time to convert
+ *
+ * @return the estimated (fractional) game tick of the host at the given time.
+ */
+double NetEventController::getServerTickAt(const Timestamp& stamp) const {
+    double local;
+    if (_detached) {
+        double micros;
+        if (_tickTime < stamp) {
+            micros = (double)stamp.ellapsedMicros(_tickTime);
+        } else {
+            micros = -(double)_tickTime.ellapsedMicros(stamp);
+        }
+        local = (double)_ticks+micros/(double)(FIXED_TIMESTEP);
+    } else {
+        local = _appRef->getUpdateCountAt(stamp);
+    }
+    double tick = local-(double)_startGameTimeStamp+_clockOffset;
+    return tick < 0 ? 0 : tick;
 }
 
 /**
@@ -268,53 +878,641 @@ void NetEventController::processGameStateEvent(const std::shared_ptr<GameStateEv
  * {@link processReceivedEvent()}.
  */
 void NetEventController::processReceivedData(){
-    _network->receive([this](const std::string source,
-        const std::vector<std::byte>& data) {
-        //CULog("DATA %d, CUR STATE %d, SOURCE %s", data[0], _status, source.c_str());
-        processReceivedEvent(unwrap(data, source)); 
+    if (_decoder) {
+        processDecodedEvents();
+        
+        // Hand the raw messages to the worker, to be applied next update
+        struct Message {
+            Uint32 handle;
+            std::shared_ptr<const std::string> source;
+            std::vector<std::byte> data;
+        };
+        typedef std::vector<Message> Batch;
+        auto batch = std::make_shared<Batch>();
+        _network->consumeByHandle([&](Uint32 handle, std::vector<std::byte>&& data) {
+            if (!isDropped((Uint8)data[0])) {
+                batch->push_back({handle, getPeerName(handle), std::move(data)});
+            }
+        });
+        if (batch->empty()) {
+            return;
+        }
+        _decodePending++;
+        _decoder->addTask([this,batch]() {
+            for (auto it = batch->begin(); it != batch->end(); ++it) {
+                Uint8 type = (Uint8)it->data[0];
+                _decoded.push(std::make_pair(type, decode(it->data, it->handle, it->source, _decodeArena, false)));
+            }
+            _decodePending--;
+        });
+        return;
+    }
+    
+    _network->consumeByHandle([this](Uint32 handle, std::vector<std::byte>&& data) {
+        if (!isDropped((Uint8)data[0])) {
+            processReceivedEvent((Uint8)data[0], unwrap(data, handle, getPeerName(handle)));
+        }
     });
 }
 
+/**
+ * Processes all events decoded by the decoder thread so far.
+ *
+ * The events are stamped with the current server tick as they are
+ * processed, and then passed to {@link processReceivedEvent()} in the
+ * order they arrived.
+ */
+void NetEventController::processDecodedEvents() {
+    Uint64 now = getServerTick();
+    std::pair<Uint8,std::shared_ptr<NetEvent>> item;
+    while (_decoded.pop(item)) {
+        item.second->_receiveTimeStamp = now;
+        processReceivedEvent(item.first, item.second);
+    }
+}
+
+/**
+ * Blocks until the decoder thread has decoded every message given to it.
+ *
+ * This must be called before the event type tables are changed, as the
+ * decoder thread reads them.
+ */
+void NetEventController::drainDecoder() {
+    while (_decodePending.load() > 0) {
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * Sets whether inbound messages are decoded off the main thread.
+ *
+ * By default, every message is deserialized on the main thread in
+ * {@link updateNet()}. With asynchronous decoding, each update hands the
+ * raw messages to a worker thread, and only applies the events that the
+ * worker has finished decoding. Hence the main thread no longer pays for
+ * the deserialization, but received events are applied one update later.
+ *
+ * The decoded events are not pooled, as the event pools are not thread
+ * safe. This is off by default.
+ *
+ * @param value Whether inbound messages are decoded off the main thread
+ */
+void NetEventController::setAsyncDecoding(bool value) {
+    if (value == (_decoder != nullptr)) {
+        return;
+    } else if (value) {
+        _decoder = ThreadPool::alloc(1);
+        return;
+    }
+    
+    // Apply what the worker has left, so that no message is lost
+    drainDecoder();
+    processDecodedEvents();
+    _decoder = nullptr;
+}
+
 /**
  * Broadcasts all queued outbound events.
+ *
+ * Events with a destination are only sent to that client. Events are only
+ * sent to the peers that subscribe to their type, and an event that no peer
+ * wants is never serialized. Spectators are sent the broadcasts that they
+ * watch directly, sharing the buffer of the broadcast.
  */
 void NetEventController::sendQueuedOutData(){
-    int msgCount = 0;
-    int byteCount = 0;
+    _frameMsgCount = 0;
+    _frameByteCount = 0;
+    bool sequenced = _sequenced && _status == INGAME;
+    auto spectators = _network->getSpectatorView();
+    bool filtering = !_peerSubscriptions.empty() || !spectators->empty();
+    std::string self = filtering ? _network->getUUID() : "";
     for(auto it = _outEventQueue.begin(); it != _outEventQueue.end(); it++){
         auto e = *(it);
-        auto wrapped = wrap(e);
-        msgCount++;
-        byteCount += wrapped.size();
-        //CULog("flag: %x", (std::byte)getType(*e))
-        _network->broadcast(wrap(e));
+        Uint8 type = getType(*e);
+        const std::string& dest = e->getDestinationId();
+        
+        // Filter by subscription before serializing
+        bool filtered = false;
+        if (filtering && type >= _coreTypes) {
+            if (!dest.empty() && !isPeerSubscribed(dest,type)) {
+                continue;
+            } else if (dest.empty()) {
+                _recipients.clear();
+                auto players = _network->getPlayerView();
+                for (auto jt = players->begin(); jt != players->end(); ++jt) {
+                    // A broadcast never reaches a spectator
+                    if (*jt != self && !spectators->count(*jt)) {
+                        if (isPeerSubscribed(*jt,type)) {
+                            _recipients.push_back(*jt);
+                        } else {
+                            filtered = true;
+                        }
+                    }
+                }
+            }
+        }
+        
+        _audience.clear();
+        if (dest.empty()) {
+            for (auto jt = spectators->begin(); jt != spectators->end(); ++jt) {
+                if (isPeerSubscribed(*jt,type)) {
+                    _audience.push_back(*jt);
+                }
+            }
+        }
+        if (filtered && _recipients.empty() && _audience.empty()) {
+            continue;
+        }
+        
+        wrapInto(e,_outArena);
+        if (sequenced && getLane(e) == net::NetcodeConnection::Lane::RELIABLE) {
+            queueSequenced(dest,type,_outArena);
+            continue;
+        }
+        _frameMsgCount++;
+        _frameByteCount += _outArena.size();
+        if (dest.empty()) {
+            // Share one buffer across every peer (the arena reallocates)
+            auto message = std::make_shared<const std::vector<std::byte>>(std::move(_outArena));
+            _outArena.clear();
+            if (!filtered) {
+                _network->broadcast(message,getLane(e));
+            } else {
+                for (auto jt = _recipients.begin(); jt != _recipients.end(); ++jt) {
+                    _network->sendTo(*jt,message,getLane(e));
+                }
+            }
+            for (auto jt = _audience.begin(); jt != _audience.end(); ++jt) {
+                _network->sendTo(*jt,message,getLane(e));
+            }
+        } else {
+            _network->sendTo(e->getDestinationId(),_outArena,getLane(e));
+        }
     }
     _outEventQueue.clear();
+    if (sequenced) {
+        sendSequenced();
+    }
+    sendSpectatorSync();
+    _network->flush();
+    _sendCredit = SDL_max(_sendCredit-_frameByteCount,-_sendBudget*CONGESTION_BURST);
+}
+
+/**
+ * Queues a wrapped reliable event for sequenced delivery.
+ *
+ * If the event is for all peers, it is only queued for the peers that
+ * subscribe to its type.
+ *
+ * @param dest  The UUID of the recipient (empty for all peers)
+ * @param type  The type id of the event
+ * @param data  The wrapped event
+ */
+void NetEventController::queueSequenced(const std::string& dest, Uint8 type, const std::vector<std::byte>& data) {
+    SequencedEntry entry;
+    entry.due = 0;
+    entry.data = std::make_shared<std::vector<std::byte>>(data);
+    if (!dest.empty()) {
+        SequencedLink& link = _seqLinks[dest];
+        entry.sequence = ++link.lastSequence;
+        link.pending.push_back(entry);
+        return;
+    }
+    
+    std::string self = _network->getUUID();
+    auto players = _network->getPlayerView();
+    for (auto it = players->begin(); it != players->end(); ++it) {
+        if (*it != self && isPeerSubscribed(*it,type)) {
+            SequencedLink& link = _seqLinks[*it];
+            entry.sequence = ++link.lastSequence;
+            link.pending.push_back(entry);
+        }
+    }
+}
+
+/**
+ * Sends an envelope to every peer that is due one.
+ *
+ * An envelope holds the events never sent or not acknowledged within the
+ * resend interval (about one and a half round trips), up to a byte limit.
+ * A peer that sent us events gets an envelope even if there is nothing to
+ * send, so that it can stop resending.
+ */
+void NetEventController::sendSequenced() {
+    Uint64 now = getGameTick();
+    for (auto it = _seqLinks.begin(); it != _seqLinks.end(); ) {
+        if (!_network->isPlayerActive(it->first)) {
+            it = _seqLinks.erase(it);
+            continue;
+        }
+        
+        SequencedLink& link = it->second;
+        Uint64 resend = SEQUENCED_RESEND_MIN;
+        auto jt = _links.find(it->first);
+        if (jt != _links.end()) {
+            resend = SDL_max(resend,(Uint64)std::ceil(SEQUENCED_RESEND_SCALE*jt->second.rtt));
+        }
+        
+        std::shared_ptr<SequencedEvent> envelope = nullptr;
+        size_t bytes = 0;
+        for (auto kt = link.pending.begin(); kt != link.pending.end(); ++kt) {
+            if (kt->due > now) {
+                continue;
+            } else if (envelope && bytes+kt->data->size() > SEQUENCED_MAX_BYTES) {
+                break;
+            } else if (envelope == nullptr) {
+                envelope = _sequencedPool->get();
+            }
+            envelope->addEvent(kt->sequence,*(kt->data));
+            bytes += kt->data->size();
+            kt->due = now+resend;
+        }
+        
+        if (envelope == nullptr && link.ackOwed) {
+            envelope = _sequencedPool->get();
+        }
+        if (envelope) {
+            Uint32 bits = 0;
+            for (Uint32 ii = 0; ii < 32; ii++) {
+                if (link.early.count(link.received+2+ii)) {
+                    bits |= ((Uint32)1) << ii;
+                }
+            }
+            envelope->setAck(link.received,bits);
+            link.ackOwed = false;
+            wrapInto(envelope,_outArena);
+            _frameMsgCount++;
+            _frameByteCount += _outArena.size();
+            _network->sendTo(it->first,_outArena,getLane(envelope));
+        }
+        ++it;
+    }
+}
+
+/**
+ * Processes an envelope of sequenced events from a peer.
+ *
+ * The acknowledgements in the envelope stop the resending of our events.
+ * The events in the envelope are buffered, and delivered (unwrapped and
+ * processed) strictly in sequence order. Duplicates are ignored.
+ */
+void NetEventController::processSequencedEvent(const std::shared_ptr<SequencedEvent>& e) {
+    if (_status != INGAME) {
+        return; // The sender will resend until we are ready
+    }
+    
+    std::shared_ptr<const std::string> source = e->_sourceID;
+    SequencedLink& link = _seqLinks[e->getSourceId()];
+    Uint32 ack = e->getAck();
+    Uint32 bits = e->getAckBits();
+    for (auto it = link.pending.begin(); it != link.pending.end(); ) {
+        Uint32 seq = it->sequence;
+        if (seq <= ack || (seq >= ack+2 && seq-ack-2 < 32 && ((bits >> (seq-ack-2)) & 1))) {
+            it = link.pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    
+    const std::vector<Uint32>& sequences = e->getSequences();
+    const std::vector<std::vector<std::byte>>& events = e->getEvents();
+    for (size_t ii = 0; ii < sequences.size(); ii++) {
+        link.ackOwed = true;
+        if (sequences[ii] > link.received && !link.early.count(sequences[ii])) {
+            link.early.emplace(sequences[ii],events[ii]);
+        }
+    }
+    
+    // Deliver after the bookkeeping, as a handler may change the links
+    std::vector<std::vector<std::byte>> ready;
+    while (!link.early.empty() && link.early.begin()->first == link.received+1) {
+        ready.push_back(std::move(link.early.begin()->second));
+        link.early.erase(link.early.begin());
+        link.received++;
+    }
+    for (auto it = ready.begin(); it != ready.end(); ++it) {
+        if (it->size() >= MIN_MSG_LENGTH && (Uint8)(*it)[0] < _newEventVector.size() &&
+            !isDropped((Uint8)(*it)[0])) {
+            processReceivedEvent((Uint8)(*it)[0], unwrap(*it, e->_sourceHandle, source));
+        }
+    }
+}
+
+/**
+ * Processes the event subscriptions of a peer.
+ *
+ * From now on, events with a type the peer does not want are no longer
+ * sent to it.
+ */
+void NetEventController::processSubscriptionEvent(const std::shared_ptr<SubscriptionEvent>& e) {
+    _peerSubscriptions[e->getSourceId()] = e->getTypes();
+}
+
+/**
+ * Sends our event subscriptions to every peer that does not have them.
+ *
+ * Nothing is sent until the subscriptions have changed at least once,
+ * since peers assume that every type is wanted.
+ */
+void NetEventController::sendSubscriptions() {
+    if (!_resubscribe || _network == nullptr || _status == IDLE || _status == CONNECTING) {
+        return;
+    }
+    
+    std::string self = _network->getUUID();
+    auto players = _network->getPlayerView();
+    for (auto it = players->begin(); it != players->end(); ++it) {
+        if (*it != self && !_announced.count(*it)) {
+            auto e = SubscriptionEvent::alloc(_subscribed);
+            e->setDestinationId(*it);
+            pushOutEvent(e);
+            _announced.insert(*it);
+        }
+    }
+}
+
+/**
+ * Sets whether this controller wants the events with the given type id.
+ *
+ * The built-in event types are always wanted.
+ *
+ * @param type  The type id
+ * @param value Whether this controller wants the events with that type id
+ */
+void NetEventController::subscribe(Uint8 type, bool value) {
+    CUAssertLog(type >= _coreTypes, "Built-in events cannot be unsubscribed");
+    if (type < _coreTypes || type >= _subscribed.size() || _subscribed[type] == value) {
+        return;
+    }
+    _subscribed[type] = value;
+    _resubscribe = true;
+    _announced.clear();
+}
+
+/**
+ * Returns true if the given peer wants the events with the given type id.
+ *
+ * A peer wants every event type until it announces its subscriptions.
+ *
+ * @param peer  The UUID of the peer
+ * @param type  The type id
+ *
+ * @return true if the given peer wants the events with the given type id.
+ */
+bool NetEventController::isPeerSubscribed(const std::string& peer, Uint8 type) const {
+    if (type < _coreTypes) {
+        return true;
+    } else if (_network != nullptr && _network->isSpectator(peer)) {
+        if (type >= _spectated.size() || !_spectated[type]) {
+            return false;
+        }
+    }
+    auto it = _peerSubscriptions.find(peer);
+    if (it == _peerSubscriptions.end() || type >= it->second.size()) {
+        return true;
+    }
+    return it->second[type];
+}
+
+/**
+ * Returns the number of sequenced events not yet acknowledged.
+ *
+ * This is the total over all peers. A steadily growing backlog means a
+ * peer has stopped acknowledging.
+ *
+ * @return the number of sequenced events not yet acknowledged.
+ */
+size_t NetEventController::getSequencedBacklog() const {
+    size_t result = 0;
+    for (auto it = _seqLinks.begin(); it != _seqLinks.end(); ++it) {
+        result += it->second.pending.size();
+    }
+    return result;
+}
+
+#pragma mark -
+#pragma mark Spectators
+/**
+ * Starts the game for every spectator that has not seen it start.
+ *
+ * A spectator does not take part in the start handshake. Instead, the
+ * host sends it the game start once the game is in progress, followed by
+ * the world (if physics is enabled).
+ */
+void NetEventController::admitSpectators() {
+    auto spectators = _network->getSpectatorView();
+    for (auto it = _admitted.begin(); it != _admitted.end(); ) {
+        if (!spectators->count(*it)) {
+            it = _admitted.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    
+    for (auto it = spectators->begin(); it != spectators->end(); ++it) {
+        if (!_admitted.insert(*it).second) {
+            continue;
+        }
+        CULog("SPECTATOR %s ADMITTED", it->c_str());
+        auto start = GameStateEvent::allocGameStart();
+        start->setDestinationId(*it);
+        pushOutEvent(start);
+        if (_physEnabled) {
+            // The history must reach back to the delayed snapshots
+            Uint32 length = _spectatorDelay+_spectatorInterval+1;
+            if (_physController->getRewindLength() < length) {
+                _physController->setRewindLength(length);
+            }
+            // No region is urgent, as the spectator is behind anyway
+            Rect bounds = _physController->getWorlds().front()->getBounds();
+            _physController->sendWorld(*it,Rect(bounds.origin+bounds.size/2,Size::ZERO));
+            // The new spectator has none of the baselines
+            _physController->resetSpectatorSync();
+        }
+    }
+}
+
+/**
+ * Sends the spectator snapshot of this update to every spectator.
+ *
+ * The snapshot is serialized once, and the same message is shared by the
+ * connections to all of the spectators.
+ */
+void NetEventController::sendSpectatorSync() {
+    if (_spectatorSync == nullptr) {
+        return;
+    }
+    wrapInto(_spectatorSync,_outArena);
+    _spectatorSync = nullptr;
+    _frameMsgCount++;
+    _frameByteCount += _outArena.size();
+    
+    auto message = std::make_shared<const std::vector<std::byte>>(std::move(_outArena));
+    _outArena.clear();
+    for (auto it = _admitted.begin(); it != _admitted.end(); ++it) {
+        _network->sendTo(*it,message,net::NetcodeConnection::Lane::RELIABLE);
+    }
+}
+
+/**
+ * Returns the delivery lane for the given event.
+ *
+ * Physics snapshots ({@link PhysSyncEvent}) are superseded by the next
+ * snapshot, so they are sent on the unreliable lane. So are inputs, which
+ * are repeated, and checksums, which are only compared if they arrive.
+ * Clock pings are sent unreliably as well, since a retransmitted ping would
+ * only be a bad round trip sample. All other events change the game state,
+ * and are sent on the reliable lane. The lane is looked up by the type id of
+ * the event.
+ */
+cugl::net::NetcodeConnection::Lane NetEventController::getLane(const std::shared_ptr<NetEvent>& e) {
+    return _eventLanes[getType(*e)];
 }
 
 /**
  * Updates the network controller.
  */
 void NetEventController::updateNet() {
+    CU_PROFILE_SCOPE("NetEventController::updateNet");
+    if (_detached) {
+        processCallbacks();
+    }
     if(_network){
         checkConnection();
+        
+        if (_status == INGAME && !_isHost && _network->isHost()) {
+            promoteToHost();
+        }
+        if (_status == INGAME) {
+            sendClockPing();
+            // Save up the budget of this tick, but only for a short burst
+            _sendCredit = SDL_min(_sendCredit+_sendBudget,_sendBudget*CONGESTION_BURST);
+        }
 
-        if (_status == INGAME && _physEnabled) {
-            _physController->packPhysSync(NetPhysicsController::FULL_SYNC);
+        if (_status == INGAME && _physEnabled && isSpectator()) {
+            // Spectators only interpolate the delayed snapshots of the host
+            _physController->fixedUpdate();
+            _physController->getOutEvents().clear();
+        } else if (_status == INGAME && _physEnabled && _authoritative && !_isHost) {
+            // Clients only send input, and just interpolate the host snapshots
+            _physController->fixedUpdate();
+            _physController->packChecksum(getGameTick());
+            _physController->getOutEvents().clear();
+            sendInput();
+        } else if (_status == INGAME && _physEnabled) {
+            // Skip snapshots rather than queue them on a congested link
+            Uint64 now = getGameTick();
+            if (!_congestionControl || _sendCredit > 0 || now >= _lastSyncTick+CONGESTION_MAX_INTERVAL) {
+                _physController->packPhysSync(NetPhysicsController::FULL_SYNC);
+                _lastSyncTick = now;
+            }
             _physController->packPhysObj();
 			_physController->fixedUpdate();
+            if (_isHost) {
+                _physController->recordRewind(getGameTick());
+                if (!_admitted.empty() && now >= _spectatorDelay &&
+                    now >= _lastSpectatorTick+_spectatorInterval) {
+                    _spectatorSync = _physController->packSpectatorSync(now-_spectatorDelay);
+                    _lastSpectatorTick = now;
+                }
+            }
+            _physController->packChecksum(getGameTick());
+            _physController->packCheckpoint(getGameTick());
+            _physController->packWorldTransfer();
             for (auto it = _physController->getOutEvents().begin(); it != _physController->getOutEvents().end(); it++) {
                 pushOutEvent(*it);
 		    }
             _physController->getOutEvents().clear();
                 
 		}
+        if (_status == INGAME && _isHost) {
+            admitSpectators();
+        }
         
         processReceivedData();
+        sendSubscriptions();
         sendQueuedOutData();
     }
 }
 
+/**
+ * Starts an offline replay of the given network trace.
+ *
+ * A trace is recorded by attaching a {@link net::NetcodeRecorder} to the
+ * connection of a live session. This method puts the controller in the
+ * INGAME state, as the host or as a client, without any connection. The
+ * inbound messages of the trace are then applied by {@link replay}.
+ *
+ * The controller must not be connected. Any event types and physics
+ * settings must be the same as those of the recorded session.
+ *
+ * @param trace The network trace
+ * @param host  Whether the trace was recorded by the host
+ *
+ * @return true if the replay was started
+ */
+bool NetEventController::startReplay(const std::shared_ptr<net::NetcodeReplay>& trace, bool host) {
+    if (_network != nullptr) {
+        CUAssertLog(false, "Cannot replay a trace while connected");
+        return false;
+    } else if (trace == nullptr) {
+        return false;
+    }
+    
+    _replay = trace;
+    _isHost = host;
+    _status = INGAME;
+    _startGameTimeStamp = getUpdateCount();
+    resetClock();
+    resetCongestion();
+    _seqLinks.clear();
+    _lastSyncStamp.clear();
+    _lastGroupStamp.clear();
+    _lastInputTick.clear();
+    _clockSynced = true;
+    return true;
+}
+
+/**
+ * Applies the inbound messages of the replay trace up to the given time.
+ *
+ * Every inbound message recorded up to the given time (in microseconds
+ * since the trace started) is unwrapped and processed as if it had just
+ * been received. Outbound messages are skipped. Messages are always decoded
+ * on the calling thread, even with asynchronous decoding, so a replay is
+ * deterministic. Calling this method with the largest Uint64 applies the
+ * rest of the trace at once, which is useful for timing decode and apply.
+ *
+ * Nothing is sent during a replay, as there is no connection. Built-in
+ * events that need a connection (such as ownership checkpoints) are ignored.
+ *
+ * @param until The time to replay up to
+ *
+ * @return the number of messages applied
+ */
+size_t NetEventController::replay(Uint64 until) {
+    if (_replay == nullptr) {
+        return 0;
+    }
+    
+    size_t count = 0;
+    net::NetcodeRecorder::Record record;
+    while (!_replay->isDone() && _replay->getTime() <= until) {
+        _replay->next(record);
+        if (record.direction != net::NetcodeRecorder::Direction::INBOUND) {
+            continue;
+        } else if (record.message.size() < MIN_MSG_LENGTH || (Uint8)record.message[0] >= _newEventVector.size()) {
+            CULogError("NETCODE: Skipping invalid message from %s in trace",record.peer.c_str());
+            continue;
+        }
+        // Traces record the UUID, as handles are only valid for a connection
+        auto source = std::make_shared<const std::string>(record.peer);
+        processReceivedEvent((Uint8)record.message[0], unwrap(record.message, NETCODE_NO_HANDLE, source));
+        count++;
+    }
+    return count;
+}
+
 /**
  * Returns if there are remaining custom inbound events.
  *
@@ -326,7 +1524,7 @@ bool NetEventController::isInAvailable() {
     if ( _inEventQueue.empty() )
         return false;
     std::shared_ptr<NetEvent> top = _inEventQueue.front();
-    return top->_eventTimeStamp <= _appRef->getUpdateCount()-_startGameTimeStamp;
+    return top->_eventTimeStamp <= getServerTick();
 }
 
 /**
@@ -344,9 +1542,12 @@ std::shared_ptr<NetEvent> NetEventController::popInEvent() {
  * Queues an outbound event to be sent to peers.
  *
  * Queued events are sent when {@link updateNet()} is called. and cleared
- * after sending.
+ * after sending. A spectator can only send the built-in events.
  */
 void NetEventController::pushOutEvent(const std::shared_ptr<NetEvent>& e) {
+    if (isSpectator() && getType(*e) >= _coreTypes) {
+        return;
+    }
 	_outEventQueue.push_back(e);
 }
 
@@ -358,16 +1559,61 @@ void NetEventController::pushOutEvent(const std::shared_ptr<NetEvent>& e) {
  * {@link NetEvent#deserialize()} method. This method is only called on
  * outbound events.
  */
-std::shared_ptr<NetEvent> NetEventController::unwrap(const std::vector<std::byte>& data, std::string source) {
+std::shared_ptr<NetEvent> NetEventController::unwrap(const std::vector<std::byte>& data, Uint32 handle,
+                                                     const std::shared_ptr<const std::string>& source) {
+    std::shared_ptr<NetEvent> e = decode(data, handle, source, _inArena, true);
+    e->_receiveTimeStamp = getServerTick();
+    return e;
+}
+
+/**
+ * Returns the sender ID for the given peer handle.
+ *
+ * The IDs are cached, so that the connection is only consulted the first
+ * time a handle is seen. All events from the same sender share the ID.
+ *
+ * @param handle    The peer handle
+ *
+ * @return the sender ID for the given peer handle.
+ */
+const std::shared_ptr<const std::string>& NetEventController::getPeerName(Uint32 handle) {
+    if (handle >= _peerNames.size()) {
+        _peerNames.resize(handle+1);
+    }
+    if (_peerNames[handle] == nullptr) {
+        _peerNames[handle] = _network->getPeerName(handle);
+    }
+    return _peerNames[handle];
+}
+
+/**
+ * Decodes a byte vector into a NetEvent without a receive timestamp.
+ *
+ * This is the part of {@link unwrap()} that is safe to run on the decoder
+ * thread, provided that pooled is false. The event pools are not thread
+ * safe, so the decoder thread always allocates its events.
+ *
+ * @param data      The message data
+ * @param handle    The peer handle of the sender
+ * @param source    The UUID of the sender
+ * @param arena     The buffer to copy the payload into
+ * @param pooled    Whether to take the event from its pool (if it has one)
+ *
+ * @return the decoded event.
+ */
+std::shared_ptr<NetEvent> NetEventController::decode(const std::vector<std::byte>& data, Uint32 handle,
+                                                     const std::shared_ptr<const std::string>& source,
+                                                     std::vector<std::byte>& arena, bool pooled) {
     CUAssertLog(data.size() >= MIN_MSG_LENGTH && (Uint8)data[0] < _newEventVector.size(), "Unwrapping invalid event");
-    LWDeserializer deserializer;
-    deserializer.receive(data);
-    Uint8 eventType = (Uint8)deserializer.readByte();
-    std::shared_ptr<NetEvent> e = _newEventVector[eventType]->newEvent();
-    Uint64 eventTimeStamp = deserializer.readUint64();
-    Uint64 receiveTimeStamp =  _appRef->getUpdateCount()-_startGameTimeStamp;
-	e->setMetaData(eventTimeStamp, receiveTimeStamp, source);
-    e->deserialize(std::vector(data.begin()+MIN_MSG_LENGTH,data.end()));
+    // Read the header in place, rather than copying the message
+    Uint8 eventType = (Uint8)data[0];
+    std::shared_ptr<NetEvent> e = (pooled && _eventPools[eventType]) ? _eventPools[eventType]() : _newEventVector[eventType]->newEvent();
+    Uint64 eventTimeStamp;
+    std::memcpy(&eventTimeStamp, data.data()+sizeof(std::byte), sizeof(Uint64));
+    eventTimeStamp = marshall(eventTimeStamp);
+	e->setMetaData(eventTimeStamp, 0, handle, source);
+    arena.assign(data.begin()+MIN_MSG_LENGTH,data.end());
+    e->deserialize(arena);
     return e;
 }
 
@@ -379,10 +1625,25 @@ std::shared_ptr<NetEvent> NetEventController::unwrap(const std::vector<std::byte
  * events.
  */
 const std::vector<std::byte> NetEventController::wrap(const std::shared_ptr<NetEvent>& e) {
-    LWSerializer serializer;
-    serializer.writeByte((std::byte)getType(*e));
-    //CULog("flag: %x",(std::byte)getType(*e));
-    serializer.writeUint64(_appRef->getUpdateCount()-_startGameTimeStamp);
-    serializer.writeByteVector(e->serialize());
-	return serializer.serialize();
+    std::vector<std::byte> result;
+    wrapInto(e,result);
+    return result;
+}
+
+/**
+ * Wraps a NetEvent into the given byte vector.
+ *
+ * This is the same as {@link wrap()}, except that the bytes are written
+ * into the given buffer (which is cleared first). Reusing the buffer
+ * avoids an allocation for every event on the outbound path.
+ */
+void NetEventController::wrapInto(const std::shared_ptr<NetEvent>& e, std::vector<std::byte>& out) {
+    const std::vector<std::byte> payload = e->serialize();
+    Uint64 stamp = marshall(getServerTick());
+    const std::byte* bytes = reinterpret_cast<const std::byte*>(&stamp);
+    out.clear();
+    out.reserve(MIN_MSG_LENGTH+payload.size());
+    out.push_back((std::byte)getType(*e));
+    out.insert(out.end(),bytes,bytes+sizeof(Uint64));
+    out.insert(out.end(),payload.begin(),payload.end());
 }
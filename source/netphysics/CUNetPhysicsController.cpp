@@ -28,14 +28,87 @@
 
 #include <cugl/netphysics/CUNetPhysicsController.h>
 #include <cugl/netphysics/CULWSerializer.h>
+#include <cugl/physics2/CUComplexObstacle.h>
+#include <box2d/b2_contact.h>
+#include <cugl/base/CUApplication.h>
+#include <cmath>
+#include <algorithm>
 
 #define ITPR_STATS 0
 
-#define ITPR_METHOD 0
+/** The number of delta snapshots to keep as potential baselines */
+#define SYNC_HISTORY 32
+/** The priority an obstacle accrues per unit of speed each PRIO_SYNC */
+#define PRIO_SPEED_SCALE    1.0f
+/** The priority an obstacle accrues per touching contact each PRIO_SYNC */
+#define PRIO_CONTACT_BONUS  4.0f
+/** The priority an obstacle gains when its ownership changes */
+#define PRIO_OWNER_BONUS    16.0f
+/** The priority an obstacle gains when it falls asleep */
+#define PRIO_REST_BONUS     16.0f
+/** The estimated size of the snapshot header in bytes */
+#define PRIO_HEADER_BYTES   16
+/** The number of ticks of predicted state to keep */
+#define PREDICTION_HISTORY  64
+/** The maximum number of ticks to replay in a single rollback */
+#define PREDICTION_MAX_REPLAY 16
+/** The number of buckets in a checksum */
+#define CHECKSUM_BUCKETS    16
+/** The number of recent checksums to keep for comparison */
+#define CHECKSUM_HISTORY    8
+/** The number of consecutive mismatches before a divergence is reported */
+#define CHECKSUM_CONFIRM    2
+/** The number of bits for an angle in a checksum */
+#define CHECKSUM_ANGLE_BITS 8
+/** The FNV-1a offset basis for checksums */
+#define CHECKSUM_BASIS      2166136261u
+/** The FNV-1a prime for checksums */
+#define CHECKSUM_PRIME      16777619u
+/** The state fields of an interpolation, in block order */
+#define ITPR_X      0
+#define ITPR_Y      1
+#define ITPR_VX     2
+#define ITPR_VY     3
+#define ITPR_ANGLE  4
+#define ITPR_ANGV   5
+#define ITPR_FIELDS 6
+/** The initial capacity of the interpolation batch */
+#define ITPR_MIN_CAPACITY 16
+/** The maximum number of snapshots buffered per obstacle */
+#define BUFFER_MAX_SAMPLES  32
+/** The target size of a world transfer chunk in bytes */
+#define WORLD_CHUNK_BYTES   1024
+/** The size of a world transfer chunk header in bytes */
+#define WORLD_HEADER_BYTES  4
+/** The size of an obstacle in a world transfer chunk in bytes (without factory parameters) */
+#define WORLD_ENTRY_BYTES   30
 
 using namespace cugl;
 using namespace cugl::netphysics;
 
+/** Whether to use a vectorization algorithm */
+bool NetPhysicsController::VECTORIZE = true;
+
+/**
+ * Returns the priority the given obstacle accrues each PRIO_SYNC (before weight)
+ *
+ * Fast obstacles and obstacles in contact accrue priority faster.
+ *
+ * @param obj   The obstacle
+ *
+ * @return the priority the given obstacle accrues each PRIO_SYNC
+ */
+static float prio_amount(physics2::Obstacle* obj) {
+    float amount = 1+PRIO_SPEED_SCALE*obj->getLinearVelocity().length();
+    b2Body* body = obj->getBody();
+    for (b2ContactEdge* edge = body ? body->GetContactList() : nullptr; edge; edge = edge->next) {
+        if (edge->contact->IsTouching()) {
+            amount += PRIO_CONTACT_BONUS;
+        }
+    }
+    return amount;
+}
+
 /**
  * Processes a physics object synchronization event.
  *
@@ -47,28 +120,67 @@ void NetPhysicsController::processPhysObjEvent(const std::shared_ptr<PhysObjEven
 
     if (event->getType() == PhysObjEvent::Type::OBJ_CREATION) {
         CUAssertLog(event->getObstacleFactId() < _obstacleFacts.size(), "Unknown object Factory %u", event->getObstacleFactId());
+        if (findObstacle(event->getObjId()) != nullptr) {
+            return; // Already made by a world transfer
+        }
+        _factoryMade[event->getObjId()] = std::make_pair(event->getObstacleFactId(),event->getPackedParam());
         auto pair = _obstacleFacts[event->getObstacleFactId()]->createObstacle(*event->getPackedParam());
-        _world->addObstacle(pair.first, event->getObjId());
+        worldOf(event->getObjId())->addObstacle(pair.first, event->getObjId());
         if (_linkSceneToObsFunc) {
             _linkSceneToObsFunc(pair.first, pair.second);
             _sharedObsToNodeMap.insert(std::make_pair(pair.first, pair.second));
         }
         if(_isHost){
-            _world->getOwned().insert({pair.first,0});
+            pair.first->setOwned(0);
+        }
+        return;
+    }
+
+    if (event->getType() == PhysObjEvent::Type::OBJ_BATCH_CREATION) {
+        CUAssertLog(event->getObstacleFactId() < _obstacleFacts.size(), "Unknown object Factory %u", event->getObstacleFactId());
+        const std::vector<Uint64>& ids = event->getBatchIds();
+        const std::vector<Vec2>& positions = event->getBatchPositions();
+        const std::vector<float>& angles = event->getBatchAngles();
+        std::vector<std::pair<std::shared_ptr<physics2::Obstacle>,std::shared_ptr<scene2::SceneNode>>> pairs;
+        _obstacleFacts[event->getObstacleFactId()]->createObstacles(*event->getPackedParam(), ids.size(), pairs);
+        for (size_t ii = 0; ii < pairs.size() && ii < ids.size(); ii++) {
+            if (findObstacle(ids[ii]) != nullptr) {
+                continue; // Already made by a world transfer
+            }
+            auto& obj = pairs[ii].first;
+            obj->setPosition(positions[ii]);
+            obj->setAngle(angles[ii]);
+            worldOf(ids[ii])->addObstacle(obj, ids[ii]);
+            if (_linkSceneToObsFunc) {
+                _linkSceneToObsFunc(obj, pairs[ii].second);
+                _sharedObsToNodeMap.insert(std::make_pair(obj, pairs[ii].second));
+            }
+            if(_isHost){
+                obj->setOwned(0);
+            }
+            _factoryMade[ids[ii]] = std::make_pair(event->getObstacleFactId(),event->getPackedParam());
         }
         return;
     }
 
     // Ignore event if object is not found.
     // TODO: Send request to object owner to sync object.
-    if(!_world->getIdToObj().count(event->getObjId()))
+    std::shared_ptr<physics2::Obstacle> obj = findObstacle(event->getObjId());
+    if(obj == nullptr) {
+        // Do not let a world transfer bring it back
+        if (event->getType() == PhysObjEvent::Type::OBJ_DELETION &&
+            (_transferState == TRANSFER_LOADING || _transferState == TRANSFER_NEAR)) {
+            _transferRemoved.insert(event->getObjId());
+        }
 		return;
-
-    auto obj = _world->getIdToObj().at(event->getObjId());
+    }
 
     if (event->getType() == PhysObjEvent::Type::OBJ_DELETION) {
-        _cache.erase(obj);
-        _world->removeObstacle(obj.get());
+        _factoryMade.erase(obj->getGlobalId());
+        removeInterpolation(obj);
+        _entityBuffers.erase(obj->getGlobalId());
+        _owners.erase(obj->getGlobalId());
+        worldOf(obj->getGlobalId())->removeObstacle(obj.get());
         if (_sharedObsToNodeMap.count(obj)) {
             _sharedObsToNodeMap.at(obj)->removeFromParent();
             _sharedObsToNodeMap.erase(obj);
@@ -113,12 +225,17 @@ void NetPhysicsController::processPhysObjEvent(const std::shared_ptr<PhysObjEven
             if (event->_centroid != obj->getCentroid()) obj->setCentroid(event->_centroid);
             break;
         case PhysObjEvent::Type::OBJ_OWNER_ACQUIRE:
-            _world->getOwned().erase(obj);
+            obj->clearOwned();
+            _leaseExpiry.erase(event->getObjId());
+            obj->addSyncPriority(PRIO_OWNER_BONUS);
+            _owners[event->getObjId()] = event->getSourceId();
             //CULog("Erased ownership for %llu",event->getObjId());
             break;
         case PhysObjEvent::Type::OBJ_OWNER_RELEASE:
-            if(_isHost){
-                _world->getOwned().insert(std::make_pair(obj,0));
+            obj->addSyncPriority(PRIO_OWNER_BONUS);
+            _owners.erase(event->getObjId());
+            if(_isHost && !obj->isOwned()){
+                obj->setOwned(0);
                 //CULog("Regained ownership for %llu",event->getObjId());
             }
             
@@ -129,56 +246,198 @@ void NetPhysicsController::processPhysObjEvent(const std::shared_ptr<PhysObjEven
     obj->setShared(true);
 }
 
+/**
+ * Processes a batch of obstacle changes from a peer.
+ *
+ * Each record only updates the fields in its mask. Records for unknown
+ * obstacles are ignored.
+ */
+void NetPhysicsController::processPhysDeltaEvent(const std::shared_ptr<PhysDeltaEvent>& event) {
+    if (event->getSourceId() == "")
+        return; // Ignore physic syncs from self.
+
+    const std::vector<ObjDelta>& records = event->getRecords();
+    for (auto it = records.begin(); it != records.end(); ++it) {
+        std::shared_ptr<physics2::Obstacle> obj = findObstacle(it->objId);
+        if (obj == nullptr) {
+            continue;
+        }
+
+        obj->setShared(false);
+        // ===== BEGIN NON-SHARED BLOCK =====
+        if (it->fields & PhysDeltaEvent::DELTA_BODY_TYPE) {
+            obj->setBodyType(it->bodyType);
+        }
+        if (it->fields & PhysDeltaEvent::DELTA_POSITION) {
+            obj->setPosition(it->pos);
+        }
+        if (it->fields & PhysDeltaEvent::DELTA_VELOCITY) {
+            obj->setLinearVelocity(it->vel);
+        }
+        if (it->fields & PhysDeltaEvent::DELTA_ANGLE) {
+            obj->setAngle(it->angle);
+        }
+        if (it->fields & PhysDeltaEvent::DELTA_ANGULAR) {
+            obj->setAngularVelocity(it->angularVel);
+        }
+        if (it->fields & PhysDeltaEvent::DELTA_BOOL_CONSTS) {
+            bool isEnabled = it->flags & PhysDeltaEvent::FLAG_ENABLED;
+            bool isAwake = it->flags & PhysDeltaEvent::FLAG_AWAKE;
+            bool isSleepingAllowed = it->flags & PhysDeltaEvent::FLAG_SLEEPING_ALLOWED;
+            bool isFixedRotation = it->flags & PhysDeltaEvent::FLAG_FIXED_ROTATION;
+            bool isBullet = it->flags & PhysDeltaEvent::FLAG_BULLET;
+            bool isSensor = it->flags & PhysDeltaEvent::FLAG_SENSOR;
+            if (isEnabled != obj->isEnabled()) obj->setEnabled(isEnabled);
+            if (isAwake != obj->isAwake()) obj->setAwake(isAwake);
+            if (isSleepingAllowed != obj->isSleepingAllowed()) obj->setSleepingAllowed(isSleepingAllowed);
+            if (isFixedRotation != obj->isFixedRotation()) obj->setFixedRotation(isFixedRotation);
+            if (isBullet != obj->isBullet()) obj->setBullet(isBullet);
+            if (isSensor != obj->isSensor()) obj->setSensor(isSensor);
+        }
+        if (it->fields & PhysDeltaEvent::DELTA_FLOAT_CONSTS) {
+            if (it->density != obj->getDensity()) obj->setDensity(it->density);
+            if (it->friction != obj->getFriction()) obj->setFriction(it->friction);
+            if (it->restitution != obj->getRestitution()) obj->setRestitution(it->restitution);
+            if (it->linearDamping != obj->getLinearDamping()) obj->setLinearDamping(it->linearDamping);
+            if (it->angularDamping != obj->getAngularDamping()) obj->setAngularDamping(it->angularDamping);
+            if (it->gravityScale != obj->getGravityScale()) obj->setGravityScale(it->gravityScale);
+            if (it->mass != obj->getMass()) obj->setMass(it->mass);
+            if (it->inertia != obj->getInertia()) obj->setInertia(it->inertia);
+            if (it->centroid != obj->getCentroid()) obj->setCentroid(it->centroid);
+        }
+        // ====== END NON-SHARED BLOCK ======
+        obj->setShared(true);
+    }
+}
+
 /**
  * Adds a shared obstacle to the physics world.
  *
  * This method is used to add a shared obstacle across all clients.
  *
+ * The obstacle is added to the world with the given shard (see {@link #addWorld}).
+ * Its id is allocated by that world, so every client adds it to the world with
+ * the same shard.
+ *
  * @param factoryID The ID of the obstacle factory to use
  * @param bytes The serialized parameters taken by the obstacle factory
+ * @param shard The shard of the world to add the obstacle to
  *
  * @return A pair of the added obstacle and its corresponding scene node
  *
  * Users can uses the returned references to manually link the obstacle,
  * or for custom obstacle setups.
  */
-std::pair<std::shared_ptr<physics2::Obstacle>, std::shared_ptr<scene2::SceneNode>> NetPhysicsController::addSharedObstacle(Uint32 factoryID, std::shared_ptr<std::vector<std::byte>> bytes) {
+std::pair<std::shared_ptr<physics2::Obstacle>, std::shared_ptr<scene2::SceneNode>> NetPhysicsController::addSharedObstacle(Uint32 factoryID, std::shared_ptr<std::vector<std::byte>> bytes, Uint8 shard) {
     CUAssertLog(factoryID < _obstacleFacts.size(), "Unknown object Factory %u", factoryID);
+    CUAssertLog(shard < _worlds.size(), "Unknown world shard %u", (Uint32)shard);
     auto pair = _obstacleFacts[factoryID]->createObstacle(*bytes);
     pair.first->setShared(true);
-    Uint64 objId = _world->addObstacle(pair.first);
+    Uint64 objId = _worlds[shard]->addObstacle(pair.first);
     if(_isHost){
-        _world->getOwned().insert(std::make_pair(pair.first,0));
+        pair.first->setOwned(0);
     }
     if (_linkSceneToObsFunc)
 		_linkSceneToObsFunc(pair.first, pair.second);
-    _outEvents.push_back(PhysObjEvent::allocCreation(factoryID,objId,bytes));
+    _factoryMade[objId] = std::make_pair(factoryID,bytes);
+    auto event = _objEventPool->get();
+    event->initCreation(factoryID,objId,bytes);
+    _outEvents.push_back(event);
     return pair;
 }
 
+/**
+ * Adds several shared obstacles from the same factory parameters.
+ *
+ * This is the batch version of {@link #addSharedObstacle}, for spawning
+ * many similar obstacles at once. Every obstacle is made from the same
+ * parameters (with {@link ObstacleFactory#createObstacles}), and then moved
+ * to its own position and angle. All of the obstacles are sent in a single
+ * {@link PhysObjEvent}, which carries the parameters once, and only the id,
+ * position and angle of each obstacle.
+ *
+ * If angles is empty, each obstacle keeps the angle given to it by the
+ * factory. Otherwise, it must be parallel to positions.
+ *
+ * @param factoryID The ID of the obstacle factory to use
+ * @param bytes     The serialized parameters shared by the obstacles
+ * @param positions The position of each obstacle
+ * @param angles    The angle of each obstacle (may be empty)
+ * @param shard     The shard of the world to add the obstacles to
+ *
+ * @return the added obstacles and their corresponding scene nodes
+ */
+std::vector<std::pair<std::shared_ptr<physics2::Obstacle>,std::shared_ptr<scene2::SceneNode>>> NetPhysicsController::addSharedObstacles(Uint32 factoryID, std::shared_ptr<std::vector<std::byte>> bytes,
+                                                                                                                                      const std::vector<Vec2>& positions, const std::vector<float>& angles,
+                                                                                                                                      Uint8 shard) {
+    CUAssertLog(factoryID < _obstacleFacts.size(), "Unknown object Factory %u", factoryID);
+    CUAssertLog(shard < _worlds.size(), "Unknown world shard %u", (Uint32)shard);
+    CUAssertLog(angles.empty() || angles.size() == positions.size(), "Angles do not match positions");
+    std::vector<std::pair<std::shared_ptr<physics2::Obstacle>,std::shared_ptr<scene2::SceneNode>>> result;
+    if (positions.empty()) {
+        return result;
+    }
+    
+    _obstacleFacts[factoryID]->createObstacles(*bytes, positions.size(), result);
+    auto event = _objEventPool->get();
+    event->initBatchCreation(factoryID,bytes);
+    for (size_t ii = 0; ii < result.size() && ii < positions.size(); ii++) {
+        auto& obj = result[ii].first;
+        obj->setPosition(positions[ii]);
+        if (!angles.empty()) {
+            obj->setAngle(angles[ii]);
+        }
+        obj->setShared(true);
+        Uint64 objId = _worlds[shard]->addObstacle(obj);
+        if(_isHost){
+            obj->setOwned(0);
+        }
+        if (_linkSceneToObsFunc)
+            _linkSceneToObsFunc(obj, result[ii].second);
+        _factoryMade[objId] = std::make_pair(factoryID,bytes);
+        event->addBatchInstance(objId,positions[ii],obj->getAngle());
+    }
+    _outEvents.push_back(event);
+    return result;
+}
+
 void NetPhysicsController::acquireObs(std::shared_ptr<physics2::Obstacle> obs, Uint64 duration){
-    if(_isHost){
-        _world->getOwned().insert(std::make_pair(obs, 0));
+    Uint64 id = obs->getGlobalId();
+    if(!obs->isOwned()){
+        obs->setOwned(_isHost ? 0 : duration);
+        if (!_isHost && duration > 0) {
+            Uint64 expiry = _leaseTick+duration;
+            _leaseExpiry[id] = expiry;
+            _leases.push(std::make_pair(expiry,id));
+        }
     }
-    _world->getOwned().insert(std::make_pair(obs,duration));
-    Uint64 id = _world->getObjToId().at(obs);
-    auto event = PhysObjEvent::allocOwnerAcquire(id, duration);
+    obs->addSyncPriority(PRIO_OWNER_BONUS);
+    _owners.erase(id);
+    auto event = _objEventPool->get();
+    event->initOwnerAcquire(id, duration);
     _outEvents.push_back(event);
 }
 
 void NetPhysicsController::releaseObs(std::shared_ptr<physics2::Obstacle> obs){
     if(!_isHost){
-        _world->getOwned().erase(obs);
-        Uint64 id = _world->getObjToId().at(obs);
-        auto event = PhysObjEvent::allocOwnerRelease(id);
+        obs->clearOwned();
+        obs->addSyncPriority(PRIO_OWNER_BONUS);
+        Uint64 id = obs->getGlobalId();
+        _leaseExpiry.erase(id);
+        auto event = _objEventPool->get();
+        event->initOwnerRelease(id);
         _outEvents.push_back(event);
     }
     
 }
 
 void NetPhysicsController::ownAll(){
-    for(auto it = _world->getObstacles().begin(); it != _world->getObstacles().end(); ++it){
-        _world->getOwned().insert(std::make_pair((*it), 0));
+    for(auto wt = _worlds.begin(); wt != _worlds.end(); ++wt) {
+        for(auto it = (*wt)->getObstacles().begin(); it != (*wt)->getObstacles().end(); ++it){
+            if(!(*it)->isOwned()){
+                (*it)->setOwned(0);
+            }
+        }
     }
 }
 
@@ -188,11 +447,16 @@ void NetPhysicsController::ownAll(){
  * If linkSceneToObsFunc was provided, the scene node will also be removed.
  */
 void NetPhysicsController::removeSharedObstacle(std::shared_ptr<physics2::Obstacle> obj) {
-    auto map = _world->getObjToId();
-    if (map.count(obj)) {
-		Uint64 objId = map.at(obj);
-		_outEvents.push_back(PhysObjEvent::allocDeletion(objId));
-		_world->removeObstacle(obj.get());
+    if (obj->hasGlobalId()) {
+		Uint64 objId = obj->getGlobalId();
+		auto event = _objEventPool->get();
+		event->initDeletion(objId);
+		_outEvents.push_back(event);
+		worldOf(objId)->removeObstacle(obj.get());
+		_restingIds.erase(objId);
+		_owners.erase(objId);
+		_leaseExpiry.erase(objId);
+		_factoryMade.erase(objId);
 		if (_sharedObsToNodeMap.count(obj)) {
 			_sharedObsToNodeMap.at(obj)->removeFromParent();
 			_sharedObsToNodeMap.erase(obj);
@@ -201,43 +465,143 @@ void NetPhysicsController::removeSharedObstacle(std::shared_ptr<physics2::Obstac
 }
 
 /**
- * Resets the physics controller.
+ * Processes a physics synchronization event.
+ *
+ * Delta snapshots are reconstructed against their baseline. If the baseline
+ * has not been received, the snapshot is ignored and the sender will fall
+ * back to a key snapshot once it sees our acknowledgements.
  */
 void NetPhysicsController::processPhysSyncEvent(const std::shared_ptr<PhysSyncEvent>& event) {
     if (event->getSourceId() == "")
         return; // Ignore physic syncs from self.
-    const std::vector<ObjParam>& params = event->getSyncList();
+
+    Uint32 source = event->getSourceUID();
+    recordAcks(source, event->getSourceId(), event->getAcks());
+    
+    // The tick of our latest input that this snapshot reflects (if any)
+    bool hasInputTick = false;
+    Uint64 inputTick = 0;
+    for (auto it = event->getInputAcks().begin(); it != event->getInputAcks().end(); it++) {
+        if (it->first == _shortUID) {
+            hasInputTick = true;
+            inputTick = it->second;
+        }
+    }
+    std::vector<ObjParam> corrections;
+
+    std::vector<ObjParam> params;
+    if (event->getSequence() == 0) {
+        params = event->getSyncList();
+    } else {
+        SyncStream& stream = _syncStreams[source];
+        if (event->getSequence() <= stream.last) {
+            return;
+        }
+        
+        const SyncState* base = nullptr;
+        if (event->getBaseline()) {
+            for (auto it = stream.history.begin(); it != stream.history.end(); ++it) {
+                if (it->first == event->getBaseline()) {
+                    base = &(it->second);
+                }
+            }
+            if (base == nullptr) {
+                return; // Cannot decode until we get a key snapshot
+            }
+        }
+        
+        SyncState state = base ? *base : SyncState();
+        for (auto it = event->getRemoved().begin(); it != event->getRemoved().end(); ++it) {
+            state.erase(*it);
+        }
+        const std::vector<ObjParam>& deltas = event->getSyncList();
+        const std::vector<Uint8>& fields = event->getFieldList();
+        for (size_t ii = 0; ii < deltas.size(); ii++) {
+            if (fields[ii] == PhysSyncEvent::FIELD_ALL) {
+                state[deltas[ii].objId] = deltas[ii];
+            } else {
+                auto jt = state.find(deltas[ii].objId);
+                if (jt != state.end()) {
+                    PhysSyncEvent::merge(jt->second, deltas[ii], fields[ii]);
+                }
+            }
+        }
+        
+        // Only apply what changed since the last snapshot we applied
+        for (auto it = state.begin(); it != state.end(); ++it) {
+            auto jt = stream.current.find(it->first);
+            if (jt == stream.current.end() || PhysSyncEvent::diff(it->second, jt->second)) {
+                params.push_back(it->second);
+            }
+        }
+        
+        stream.last = event->getSequence();
+        stream.current = state;
+        stream.history.push_back(std::make_pair(stream.last, std::move(state)));
+        if (stream.history.size() > SYNC_HISTORY) {
+            stream.history.pop_front();
+        }
+    }
+    
     for (auto it = params.begin(); it != params.end(); it++) {
         ObjParam param = (*it);
-        if(!_world->getIdToObj().count(param.objId))
+        const std::shared_ptr<physics2::Obstacle>& obj = findObstacle(param.objId);
+        if(obj == nullptr)
             continue;
-        //CUAssertLog(_world->getIdToObj().count(param.objId), "Invalid PhysSyncEvent, obj %llu not found.",param.objId);
-            
-        auto obj = _world->getIdToObj().at(param.objId);
-        float x = param.x;            
-        float y = param.y;            
-        float angle = param.angle; 
-        float vAngular = param.vAngular;
-        float vx = param.vx;
-        float vy = param.vy;
-        float diff = (obj->getPosition() - Vec2(x, y)).length();
-        float angDiff = 10 * abs(obj->getAngle() - angle);
-            
-        int steps = SDL_max(1, SDL_min(30, SDL_max((int)(diff * 30), (int)angDiff)));
-
-        std::shared_ptr<targetParam> target = std::make_shared<targetParam>();
-        target->targetVel = Vec2(vx, vy);
-        target->targetAngle = angle;
-        target->targetAngV = vAngular;
-        target->curStep = 0;
-        target->numSteps = steps;
-        target->P0 = obj->getPosition();
-        target->P1 = obj->getPosition() + obj->getLinearVelocity() / 10.f;
-        target->P3 = Vec2(x, y);
-        target->P2 = target->P3 - target->targetVel / 10.f;
+        if (hasInputTick && !_predicted.empty() && isPredicted(obj)) {
+            corrections.push_back(param);
+            continue;
+        }
+        steerObstacle(obj, param, event->getEventTimeStamp());
+    }
+    
+    if (!corrections.empty()) {
+        reconcile(inputTick, corrections);
+    }
+}
 
-        addSyncObject(obj, target);
+/**
+ * Moves the given obstacle to a remote state.
+ *
+ * The obstacle is interpolated to the state with its interpolation method.
+ * Buffered obstacles add the state to their buffer instead.
+ *
+ * @param obj   The obstacle to move
+ * @param param The remote state
+ * @param stamp The time stamp of the remote state
+ */
+void NetPhysicsController::steerObstacle(const std::shared_ptr<physics2::Obstacle>& obj, const ObjParam& param, Uint64 stamp) {
+    if (getInterpolationMethod(obj.get()) == BUFFERED_INTERPOLATION) {
+        addEntitySample(obj, stamp, param);
+        return;
+    } else if (!_entityBuffers.empty()) {
+        _entityBuffers.erase(param.objId);
     }
+
+    float x = param.x;            
+    float y = param.y;            
+    // Snapshots only store a direction, so take the nearest equivalent angle
+    float angle = obj->getAngle()+std::remainder(param.angle-obj->getAngle(), 2*M_PI); 
+    float vAngular = param.vAngular;
+    float vx = param.vx;
+    float vy = param.vy;
+    float diff = (obj->getPosition() - Vec2(x, y)).length();
+    float angDiff = 10 * abs(obj->getAngle() - angle);
+        
+    int steps = SDL_max(1, SDL_min(30, SDL_max((int)(diff * 30), (int)angDiff)));
+
+    targetParam target = {};
+    target.targetVel = Vec2(vx, vy);
+    target.targetAngle = angle;
+    target.targetAngV = vAngular;
+    target.curStep = 0;
+    target.numSteps = steps;
+    target.P0 = obj->getPosition();
+    target.P1 = obj->getPosition() + obj->getLinearVelocity() / 10.f;
+    target.P3 = Vec2(x, y);
+    target.P2 = target.P3 - target.targetVel / 10.f;
+
+    addInterpolation(obj, target);
 }
 
 /**
@@ -247,31 +611,14 @@ void NetPhysicsController::processPhysSyncEvent(const std::shared_ptr<PhysSyncEv
  * @param param The target parameters for interpolation
  */
 void NetPhysicsController::addSyncObject(std::shared_ptr<physics2::Obstacle> obj, std::shared_ptr<targetParam> param){
-    if(_cache.count(obj)){
-        #if ITPR_METHOD == 1
-        return;
-        #endif
-        auto oldParam = _cache.at(obj);
-        obj->setShared(false);
-        // ===== BEGIN NON-SHARED BLOCK =====
-        obj->setLinearVelocity(oldParam->targetVel);
-        obj->setAngularVelocity(oldParam->targetAngV);
-        // ====== END NON-SHARED BLOCK ======
-        obj->setShared(true);
-        param->I = oldParam->I;
-        param->numI = oldParam->numI;
-    }
-    _cache.erase(obj);
-    _cache.insert(std::make_pair(obj,param));
-    _stepSum += param->numSteps;
-    _itprCount ++;
+    addInterpolation(obj, *param);
 }
 
 /**
  * Returns true if the given obstacle is being interpolated.
  */
 bool NetPhysicsController::isInSync(std::shared_ptr<physics2::Obstacle> obj){
-    return _cache.count(obj) > 0;
+    return _itprIndex.count(obj.get()) > 0;
 }
 
 /**
@@ -283,194 +630,2254 @@ bool NetPhysicsController::isInSync(std::shared_ptr<physics2::Obstacle> obj){
  * @param type  the type of synchronization
  */
 void NetPhysicsController::packPhysSync(SyncType type) {
-    auto event = PhysSyncEvent::alloc();
-    
+    if (_groupsDirty) {
+        rebuildGroups();
+    }
     switch (type) {
         case OVERRIDE_FULL_SYNC:
-            for (auto it = _world->getIdToObj().begin(); it != _world->getIdToObj().end(); it++) {
-                Uint64 id = (*it).first;
-                auto obj = (*it).second;
-                if(obj->isShared())
-                    event->addObj(obj, id);
+            // Each world has its own event, quantized to its own bounds
+            for (auto wt = _worlds.begin(); wt != _worlds.end(); ++wt) {
+                auto event = allocSyncEvent((*wt)->getBounds());
+                for (auto it = (*wt)->getObstacles().begin(); it != (*wt)->getObstacles().end(); it++) {
+                    auto& obj = (*it);
+                    if(obj->isShared() && obj->hasGlobalId())
+                        event->addObj(obj, obj->getGlobalId());
+                }
+                _outEvents.push_back(event);
             }
             break;
         case FULL_SYNC:
-            for (auto it = _world->getIdToObj().begin(); it != _world->getIdToObj().end(); it++) {
-                Uint64 id = (*it).first;
-                auto obj = (*it).second;
-                if(obj->isShared() && _world->getOwned().count(obj))
-                    event->addObj(obj, id);
+        {
+            // The delta stream (and its baselines) spans every world
+            Rect bounds = getSyncBounds();
+            auto event = allocSyncEvent(bounds);
+            
+            // Snapshot every object once, no matter how many snapshots we send
+            std::vector<ObjParam> params;
+            std::vector<bool> resting;
+            for (auto wt = _worlds.begin(); wt != _worlds.end(); ++wt) {
+                for (auto it = (*wt)->getObstacles().begin(); it != (*wt)->getObstacles().end(); it++) {
+                    auto& obj = (*it);
+                    if(obj->isShared() && obj->isOwned() && obj->hasGlobalId() && !_groupOf.count(obj->getGlobalId())) {
+                        ObjParam param = PhysSyncEvent::snapshot(obj, obj->getGlobalId());
+                        event->quantize(param);
+                        params.push_back(param);
+                        resting.push_back(obj->getBodyType() != b2_staticBody && !obj->isAwake());
+                    }
+                }
+            }
+            
+            // Jointed obstacles are synced by group instead
+            if (!_groups.empty()) {
+                auto group = _groupEventPool->get();
+                for (auto it = _groups.begin(); it != _groups.end(); ++it) {
+                    const std::shared_ptr<physics2::Obstacle>& root = findObstacle(it->first);
+                    if (root == nullptr || !root->isShared() || !root->isOwned()) {
+                        continue;
+                    }
+                    // Sleeping groups only need to send their rest state once
+                    bool awake = false;
+                    for (auto jt = it->second.begin(); jt != it->second.end() && !awake; ++jt) {
+                        const std::shared_ptr<physics2::Obstacle>& obj = findObstacle(*jt);
+                        awake = (obj != nullptr && obj->isAwake());
+                    }
+                    if (awake) {
+                        _restingIds.erase(it->first);
+                    } else if (!_restingIds.insert(it->first).second) {
+                        continue;
+                    }
+                    packGroup(group, it->first);
+                }
+                if (!group->isEmpty()) {
+                    _outEvents.push_back(group);
+                }
+            }
+            
+            _syncSeq++;
+            if (_peerViews.empty()) {
+                packDeltaSync(event, params, resting, _syncHistory, getSyncBaseline(), nullptr, _syncSeq);
+                _outEvents.push_back(event);
+                break;
+            }
+            
+            // With interest management, every client gets its own snapshot
+            for (auto it = _peerUUIDs.begin(); it != _peerUUIDs.end(); ++it) {
+                auto jt = _syncAcks.find(it->first);
+                if (jt == _syncAcks.end() || _syncSeq-jt->second.heard > SYNC_HISTORY) {
+                    continue;
+                }
+                
+                auto peerEvent = allocSyncEvent(bounds);
+                peerEvent->setDestinationId(it->second);
+                SyncHistory& history = _peerHistory[it->first];
+                auto kt = _peerViews.find(it->second);
+                if (kt == _peerViews.end()) {
+                    packDeltaSync(peerEvent, params, resting, history, jt->second.acked, nullptr, _syncSeq);
+                } else {
+                    std::unordered_set<Uint64> interest;
+                    queryInterest(kt->second, history.empty() ? nullptr : &(history.back().second), interest);
+                    packDeltaSync(peerEvent, params, resting, history, jt->second.acked, &interest, _syncSeq);
+                }
+                _outEvents.push_back(peerEvent);
             }
+        }
             break;
         case PRIO_SYNC:
-            std::vector<Uint64> velQueue;
-            for (auto it = _world->getIdToObj().begin(); it != _world->getIdToObj().end(); it++) {
-                Uint64 id = (*it).first;
-                auto obj = (*it).second;
-                if(obj->isShared())
-                    velQueue.push_back(id);
+        {
+            // Every object accrues priority until it is sent
+            std::vector<std::pair<float,physics2::Obstacle*>> queue;
+            for (auto wt = _worlds.begin(); wt != _worlds.end(); ++wt) {
+                const auto& objs = (*wt)->getObstacles();
+                for (size_t ii = 0; ii < objs.size(); ii++) {
+                    auto& obj = objs[ii];
+                    if(obj->isShared() && obj->hasGlobalId() && !_groupOf.count(obj->getGlobalId())) {
+                        // Sleeping obstacles only need to send their rest state once
+                        if (obj->getBodyType() != b2_staticBody && !obj->isAwake()) {
+                            if (_restingIds.insert(obj->getGlobalId()).second) {
+                                obj->addSyncPriority(obj->getSyncWeight()*PRIO_REST_BONUS);
+                            }
+                            if (obj->getSyncPriority() > 0) {
+                                queue.push_back(std::make_pair(obj->getSyncPriority(), obj.get()));
+                            }
+                            continue;
+                        }
+                        _restingIds.erase(obj->getGlobalId());
+                        obj->addSyncPriority(obj->getSyncWeight()*prio_amount(obj.get()));
+                        queue.push_back(std::make_pair(obj->getSyncPriority(), obj.get()));
+                    }
+                }
             }
-
-            std::sort(velQueue.begin(), velQueue.end(), [this](Uint64 const& l, Uint64 const& r) {
-                return _world->getIdToObj().at(l)->getLinearVelocity().length() > _world->getIdToObj().at(r)->getLinearVelocity().length();
-                ; });
-            
-            size_t numPrioObj = SDL_min(60,velQueue.size());
             
+            // A group accrues priority on its root, as fast as its fastest member
+            for (auto it = _groups.begin(); it != _groups.end(); ++it) {
+                const std::shared_ptr<physics2::Obstacle>& root = findObstacle(it->first);
+                if (root == nullptr || !root->isShared()) {
+                    continue;
+                }
+                bool awake = false;
+                float amount = 0;
+                for (auto jt = it->second.begin(); jt != it->second.end(); ++jt) {
+                    const std::shared_ptr<physics2::Obstacle>& obj = findObstacle(*jt);
+                    if (obj != nullptr && obj->isAwake()) {
+                        awake = true;
+                        amount = SDL_max(amount, prio_amount(obj.get()));
+                    }
+                }
+                if (!awake) {
+                    if (_restingIds.insert(it->first).second) {
+                        root->addSyncPriority(root->getSyncWeight()*PRIO_REST_BONUS);
+                    }
+                    if (root->getSyncPriority() > 0) {
+                        queue.push_back(std::make_pair(root->getSyncPriority(), root.get()));
+                    }
+                    continue;
+                }
+                _restingIds.erase(it->first);
+                root->addSyncPriority(root->getSyncWeight()*amount);
+                queue.push_back(std::make_pair(root->getSyncPriority(), root.get()));
+            }
             
-            for (size_t i = 0; i < numPrioObj; i++) {
-                auto obj = _world->getIdToObj().at(velQueue[i]);
-                if(obj->isShared())
-                    event->addObj(obj,velQueue[i]);
+            // Fill the byte budget with the objects of highest priority
+            size_t budget = _prioBudget-SDL_min(_prioBudget,PRIO_HEADER_BYTES);
+            size_t count = SDL_max(1,budget/getSyncObjectSize());
+            count = SDL_min(count,queue.size());
+            if (count < queue.size()) {
+                std::nth_element(queue.begin(), queue.begin()+count, queue.end(),
+                                 [](const std::pair<float,physics2::Obstacle*>& l,
+                                    const std::pair<float,physics2::Obstacle*>& r) {
+                    return l.first > r.first;
+                });
             }
             
-            for (size_t i = 0; i < SDL_min(20,velQueue.size()); i++) {
-                auto obj = _world->getObstacles()[_objRotation];
-                event->addObj(obj,_world->getObjToId().at(obj));
-                _objRotation = (_objRotation+1)%_world->getObstacles().size();
+            // The budget is shared, but each world sends its own event
+            std::vector<std::shared_ptr<PhysSyncEvent>> events(_worlds.size());
+            std::shared_ptr<PhysGroupEvent> group = nullptr;
+            size_t used = 0;
+            for (size_t ii = 0; ii < count; ii++) {
+                physics2::Obstacle* obj = queue[ii].second;
+                Uint64 id = obj->getGlobalId();
+                auto gt = _groups.find(id);
+                if (gt != _groups.end()) {
+                    // Groups are larger, so they may not fit in the budget
+                    size_t bytes = getSyncObjectSize()+(gt->second.size()-1)*GROUP_MEMBER_BYTES;
+                    if (used > 0 && used+bytes > budget) {
+                        continue;
+                    }
+                    used += bytes;
+                    if (group == nullptr) {
+                        group = _groupEventPool->get();
+                    }
+                    packGroup(group, id);
+                    obj->clearSyncPriority();
+                    continue;
+                }
+                used += getSyncObjectSize();
+                
+                Uint8 shard = physics2::ObstacleWorld::shardOf(id);
+                shard = (shard < _worlds.size() ? shard : 0);
+                if (events[shard] == nullptr) {
+                    events[shard] = allocSyncEvent(_worlds[shard]->getBounds());
+                }
+                events[shard]->addObj(findObstacle(id),id);
+                obj->clearSyncPriority();
+            }
+            for (auto it = events.begin(); it != events.end(); ++it) {
+                if (*it != nullptr) {
+                    _outEvents.push_back(*it);
+                }
             }
+            if (group != nullptr) {
+                _outEvents.push_back(group);
+            }
+        }
             break;
     }
-    
-    _outEvents.push_back(event);
 }
 
 /**
- * Packs any changed object information and add them to _outEvents.
+ * Records how much of our snapshot stream the given client has received.
  *
- * This method helps synchronize any method calls to the obstacles that set its properties.
- * This includes explicit setPosition(), setVelocity(), setBodyType(), etc.
+ * @param source    The short UID of the client
+ * @param uuid      The UUID of the client
+ * @param acks      The acknowledgements sent by the client
  */
-void NetPhysicsController::packPhysObj() {
-    auto objs = _world->getObstacles();
-    for (auto it = objs.begin(); it != objs.end(); it++) {
-        auto obj = (*it);
-        Uint64 id = _world->getObjToId().at(obj);
-        if (obj->isShared()) {
-            if (obj->isPosDirty()) {
-                _outEvents.push_back(PhysObjEvent::allocPos(id,obj->getPosition()));
-            }
-            if (obj->isAngleDirty()) {
-				_outEvents.push_back(PhysObjEvent::allocAngle(id,obj->getAngle()));
-			}
-            if (obj->isVelDirty()) {
-				_outEvents.push_back(PhysObjEvent::allocVel(id,obj->getLinearVelocity()));
-			}
-            if (obj->isAngVelDirty()) {
-				_outEvents.push_back(PhysObjEvent::allocAngularVel(id,obj->getAngularVelocity()));
-			}
-            if (obj->isTypeDirty()) {
-                _outEvents.push_back(PhysObjEvent::allocBodyType(id,obj->getBodyType()));
-            }
-            if (obj->isBoolConstDirty()) {
-				_outEvents.push_back(PhysObjEvent::allocBoolConsts(id,obj->isEnabled(),obj->isAwake(),obj->isSleepingAllowed(),obj->isFixedRotation(),obj->isBullet(),obj->isSensor()));
-			}
-            if (obj->isFloatConstDirty()) {
-                _outEvents.push_back(PhysObjEvent::allocFloatConsts(id,obj->getDensity(),obj->getFriction(),obj->getRestitution(),obj->getLinearDamping(),obj->getAngularDamping(), obj->getGravityScale(),obj->getMass(),obj->getInertia(),obj->getCentroid()));
-            }
-            obj->clearSharingDirtyBits();
+void NetPhysicsController::recordAcks(Uint32 source, const std::string& uuid,
+                                      const std::vector<std::pair<Uint32,Uint32>>& acks) {
+    _peerUUIDs[source] = uuid;
+    SyncAck& ack = _syncAcks[source];
+    ack.acked = 0;
+    ack.heard = _syncSeq;
+    for (auto it = acks.begin(); it != acks.end(); it++) {
+        if (it->first == _shortUID) {
+            ack.acked = it->second;
         }
-	}
+    }
 }
 
 /**
- * Updates the physics controller.
+ * Processes an input event from a client.
+ *
+ * The inputs are for the game to handle. This method only records the
+ * acknowledgements of the event, so that the snapshots sent to the client
+ * can be delta compressed.
  */
-void NetPhysicsController::fixedUpdate(){
-    packPhysObj();
-    
-    //Ownership transfer
-    std::vector<std::shared_ptr<cugl::physics2::Obstacle>> deleteCache;
-    for(auto it = _world->getObstacles().begin() ; it != _world->getObstacles().end(); ++it){
-        if(_world->getOwned().count(*it)){
-            Uint64 left = _world->getOwned().at(*it);
-            if(left==1){
-                releaseObs(*it);
-            }
-            else if(left>1){
-                _world->getOwned()[*it]=left-1;
-            }
-        }
+void NetPhysicsController::processPhysInputEvent(const std::shared_ptr<PhysInputEvent>& event) {
+    if (event->getSourceId() == "")
+        return; // Ignore inputs from self.
+    recordAcks(event->getSourceUID(), event->getSourceId(), event->getAcks());
+    Uint64& tick = _inputAcks[event->getSourceUID()];
+    tick = SDL_max(tick, event->getTick());
+}
+
+/**
+ * Returns a new input event for the given tick.
+ *
+ * The event includes the acknowledgements for the snapshots received from
+ * the other clients (typically the host), but no inputs.
+ *
+ * @param tick  The game tick of the input
+ *
+ * @return a new input event for the given tick.
+ */
+std::shared_ptr<PhysInputEvent> NetPhysicsController::allocInputEvent(Uint64 tick) const {
+    auto event = _inputEventPool->get();
+    event->setSourceUID(_shortUID);
+    event->setTick(tick);
+    for (auto it = _syncStreams.begin(); it != _syncStreams.end(); ++it) {
+        event->addAck(it->first, it->second.last);
+    }
+    return event;
+}
+
+/**
+ * Returns the estimated size in bytes of one object in a snapshot.
+ *
+ * This assumes that the object is a full (not delta) entry in the world
+ * bounds, and is used to convert the PRIO_SYNC budget into an object count.
+ *
+ * @return the estimated size in bytes of one object in a snapshot.
+ */
+size_t NetPhysicsController::getSyncObjectSize() const {
+    // Namespace flag, id (up to 2 varint groups), fields, and bounds flag
+    size_t bits = 1+16+4+1;
+    bits += 2*_precision.positionBits+2*_precision.velocityBits;
+    bits += _precision.angleBits+_precision.angularBits;
+    return (bits+7)/8;
+}
+
+/**
+ * Returns the bounds that contain every world of this controller.
+ *
+ * This is the quantization bounds of the snapshots that span all of the
+ * worlds (see {@link #addWorld}). With a single world, it is just the
+ * bounds of that world.
+ *
+ * @return the bounds that contain every world of this controller.
+ */
+Rect NetPhysicsController::getSyncBounds() const {
+    Rect result = _world->getBounds();
+    for (size_t ii = 1; ii < _worlds.size(); ii++) {
+        result.merge(_worlds[ii]->getBounds());
+    }
+    return result;
+}
+
+/**
+ * Returns a new physics snapshot with the header of this client.
+ *
+ * The header includes the quantization settings and the acknowledgements for
+ * the snapshots received from the other clients. The positions in the
+ * snapshot are quantized to the given bounds.
+ *
+ * @param bounds    The quantization bounds of the snapshot
+ *
+ * @return a new physics snapshot with the header of this client.
+ */
+std::shared_ptr<PhysSyncEvent> NetPhysicsController::allocSyncEvent(const Rect& bounds) const {
+    auto event = _syncEventPool->get();
+    event->setBounds(bounds);
+    event->setPrecision(_precision);
+    event->setSourceUID(_shortUID);
+    for (auto it = _syncStreams.begin(); it != _syncStreams.end(); ++it) {
+        event->addAck(it->first, it->second.last);
     }
-    for(auto it = deleteCache.begin(); it != deleteCache.end(); ++it){
-        _world->getOwned().erase((*it));
+    for (auto it = _inputAcks.begin(); it != _inputAcks.end(); ++it) {
+        event->addInputAck(it->first, it->second);
     }
+    return event;
+}
 
-    for(auto it = _cache.begin(); it != _cache.end(); it++){
-        auto obj = it->first;
-        if(!obj->isShared()){
-            _deleteCache.push_back(it->first);
+/**
+ * Packs a delta snapshot of the given objects into the event.
+ *
+ * The snapshot is delta compressed against the baseline, provided that it is
+ * still in the history. Otherwise it is a key snapshot. The new snapshot is
+ * appended to the history with the given sequence number.
+ *
+ * If interest is not nullptr, only the objects with ids in that set are sent.
+ * Any other objects are marked as removed, so the recipient stops syncing them.
+ *
+ * Any field of an awake object that changed less than the sync threshold
+ * keeps its baseline value, so it is not sent. Resting objects are compared
+ * exactly, so their final state is sent once and then never again.
+ *
+ * @param event     The event to store the snapshot
+ * @param params    The (quantized) state of every object to sync
+ * @param resting   Whether each object is asleep (parallel to params)
+ * @param history   The recent snapshots sent to the recipient(s)
+ * @param baseline  The sequence number of the requested baseline
+ * @param interest  The ids of the objects to send (nullptr for all)
+ * @param sequence  The sequence number of the new snapshot
+ */
+void NetPhysicsController::packDeltaSync(const std::shared_ptr<PhysSyncEvent>& event,
+                                         const std::vector<ObjParam>& params,
+                                         const std::vector<bool>& resting,
+                                         SyncHistory& history, Uint32 baseline,
+                                         const std::unordered_set<Uint64>* interest,
+                                         Uint32 sequence) {
+    const SyncState* base = nullptr;
+    for (auto it = history.begin(); baseline && it != history.end(); ++it) {
+        if (it->first == baseline) {
+            base = &(it->second);
+        }
+    }
+    if (base == nullptr) {
+        baseline = 0;
+    }
+    
+    SyncState state;
+    const SyncThreshold& limit = _syncThreshold;
+    for (size_t ii = 0; ii < params.size(); ii++) {
+        ObjParam param = params[ii];
+        if (interest && !interest->count(param.objId)) {
             continue;
         }
-        obj->setShared(false);
-        // ===== BEGIN NON-SHARED BLOCK =====
-        std::shared_ptr<targetParam> param = it->second;
-        int stepsLeft = param->numSteps-param->curStep;
         
-        if(stepsLeft <= 1){
-            obj->setPosition(param->P3);
-            obj->setLinearVelocity(param->targetVel);
-            obj->setAngle(param->targetAngle);
-            obj->setAngularVelocity(param->targetAngV);
-            _deleteCache.push_back(it->first);
-            _ovrdCount++;
+        Uint8 fields = PhysSyncEvent::FIELD_ALL;
+        if (base) {
+            auto jt = base->find(param.objId);
+            if (jt != base->end()) {
+                // Small changes keep the baseline, so the error never accumulates
+                const ObjParam& prev = jt->second;
+                if (!resting[ii]) {
+                    Uint8 small = 0;
+                    if (Vec2(param.x-prev.x,param.y-prev.y).length() <= limit.position) {
+                        small |= PhysSyncEvent::FIELD_POSITION;
+                    }
+                    if (Vec2(param.vx-prev.vx,param.vy-prev.vy).length() <= limit.velocity) {
+                        small |= PhysSyncEvent::FIELD_VELOCITY;
+                    }
+                    if (std::fabs(std::remainder(param.angle-prev.angle,2*M_PI)) <= limit.angle) {
+                        small |= PhysSyncEvent::FIELD_ANGLE;
+                    }
+                    if (std::fabs(param.vAngular-prev.vAngular) <= limit.angularVelocity) {
+                        small |= PhysSyncEvent::FIELD_ANGULAR;
+                    }
+                    PhysSyncEvent::merge(param, prev, small);
+                }
+                fields = PhysSyncEvent::diff(param, prev);
+            }
         }
-        else{
-            float t = ((float)param->curStep)/param->numSteps;
-            CUAssert(t<=1.f && t>=0.f);
-            
-            #if ITPR_METHOD == 1
-            Vec2 P1 = obj->getPosition()+obj->getLinearVelocity()/10.f;
-            Vec2 pos = (1-t)*(1-t)*(1-t)*obj->getPosition() + 3*(1-t)*(1-t)*t*P1 + 3*(1-t)*t*t*param->P2 + t*t*t*param->P3;
-            obj->setPosition(pos);
-            
-            #elif ITPR_METHOD == 2
-            Vec2 pos = (2*t*t*t-3*t*t+1)*obj->getPosition() + (t*t*t-2*t*t+t)*obj->getLinearVelocity() + (-2*t*t*t+3*t*t)*param->P3 + (t*t*t-t*t)*param->targetVel;
-            obj->setPosition(pos);
-            
-            #elif ITPR_METHOD == 3
-
-            Vec2 E = param->P3-obj->getPosition();
-            param->numI++;
-            param->I = param->I + E;
-            
-            Vec2 P = E*10.f; 
-            Vec2 I = param->I*0.01f;
-            Vec2 D = obj->getLinearVelocity()*0.5f;
-            obj->setLinearVelocity(obj->getLinearVelocity()+P-D+I);
-            
-            #else
-            obj->setX(interpolate(stepsLeft,param->P3.x,obj->getX()));
-            obj->setY(interpolate(stepsLeft,param->P3.y,obj->getY()));
-            obj->setVX(interpolate(stepsLeft, param->targetVel.x, obj->getVX()));
-            obj->setVY(interpolate(stepsLeft, param->targetVel.y, obj->getVY()));
+        state[param.objId] = param;
+        if (fields) {
+            event->addParam(param, fields);
+        }
+    }
+    
+    if (base) {
+        for (auto it = base->begin(); it != base->end(); ++it) {
+            if (!state.count(it->first)) {
+                event->addRemoved(it->first);
+            }
+        }
+    }
+    
+    event->setSequence(sequence, baseline);
+    history.push_back(std::make_pair(sequence, std::move(state)));
+    if (history.size() > SYNC_HISTORY) {
+        history.pop_front();
+    }
+}
 
-            #endif
-            
-            obj->setAngle(interpolate(stepsLeft, param->targetAngle, obj->getAngle()));
-            obj->setAngularVelocity(interpolate(stepsLeft, param->targetAngV, obj->getAngularVelocity()));
+/**
+ * Computes the ids of the objects of interest for the given view.
+ *
+ * An object enters the view when its bounding box overlaps the view. It only
+ * leaves once its bounding box no longer overlaps the view expanded by the
+ * view margin. This hysteresis keeps objects at the edge of a view from
+ * flickering in and out of the snapshots.
+ *
+ * @param view      The view rectangle of the recipient
+ * @param previous  The last snapshot sent to the recipient (may be nullptr)
+ * @param result    The set to store the object ids
+ */
+void NetPhysicsController::queryInterest(const Rect& view, const SyncState* previous,
+                                         std::unordered_set<Uint64>& result) const {
+    Rect outer(view.origin.x-_viewMargin, view.origin.y-_viewMargin,
+               view.size.width+2*_viewMargin, view.size.height+2*_viewMargin);
+    for (auto wt = _worlds.begin(); wt != _worlds.end(); ++wt) {
+        const physics2::ObstacleWorld* world = wt->get();
+        if (previous) {
+            world->queryAABB([&](b2Fixture* fixture) {
+                auto obj = reinterpret_cast<physics2::Obstacle*>(fixture->GetBody()->GetUserData().pointer);
+                if (obj && obj->hasGlobalId() && previous->count(obj->getGlobalId())) {
+                    result.insert(obj->getGlobalId());
+                }
+                return true;
+            }, outer);
         }
-        param->curStep++;
-        // ====== END NON-SHARED BLOCK ======
-        obj->setShared(true);
+        world->queryAABB([&](b2Fixture* fixture) {
+            auto obj = reinterpret_cast<physics2::Obstacle*>(fixture->GetBody()->GetUserData().pointer);
+            if (obj && obj->hasGlobalId()) {
+                result.insert(obj->getGlobalId());
+            }
+            return true;
+        }, view);
     }
+}
 
-    for(auto it = _deleteCache.begin(); it != _deleteCache.end(); it++){
-        _cache.erase(*it);
+/**
+ * Sets the view rectangle of the given client.
+ *
+ * Once any client has a view, physics snapshots are no longer broadcast.
+ * Instead, every client gets its own snapshot, which only includes the
+ * objects in its view (if it has one). This saves bandwidth on large
+ * maps, at the cost of serializing a snapshot for each client.
+ *
+ * @param uuid  The UUID of the client
+ * @param view  The view rectangle in physics coordinates
+ */
+void NetPhysicsController::setPeerView(const std::string& uuid, const Rect& view) {
+    if (_peerViews.empty()) {
+        // Snapshot sequences are shared, so baselines cannot cross modes
+        _syncHistory.clear();
+        _peerHistory.clear();
     }
-    _deleteCache.clear();
+    _peerViews[uuid] = view;
+}
 
-    if(ITPR_STATS){
-        CULog("%ld/%ld overriden", _itprCount-_ovrdCount,_itprCount);
-        CULog("Average step: %f", ((float)_stepSum)/_itprCount);
+/**
+ * Removes the view rectangle of the given client.
+ *
+ * That client will receive every object again. If no client has a view
+ * any more, physics snapshots are broadcast as before.
+ *
+ * @param uuid  The UUID of the client
+ */
+void NetPhysicsController::clearPeerView(const std::string& uuid) {
+    if (_peerViews.erase(uuid) && _peerViews.empty()) {
+        _syncHistory.clear();
+        _peerHistory.clear();
     }
 }
 
 /**
- * Helper function for linear object interpolation.
+ * Returns the sequence number of the baseline for the next delta snapshot.
  *
- * Formula: (target-source)/stepsLeft + source
+ * The baseline is the latest snapshot acknowledged by every client heard
+ * from recently. This method returns 0 if there is no such snapshot in the
+ * history, in which case the next snapshot is a key snapshot.
+ *
+ * @return the sequence number of the baseline for the next delta snapshot.
  */
-float NetPhysicsController::interpolate(int stepsLeft, float target, float source){
-    return (target-source)/stepsLeft+source;
+Uint32 NetPhysicsController::getSyncBaseline() const {
+    if (_syncAcks.empty() || _syncHistory.empty()) {
+        return 0;
+    }
+    
+    Uint32 baseline = 0;
+    bool first = true;
+    for (auto it = _syncAcks.begin(); it != _syncAcks.end(); ++it) {
+        // Ignore clients that have gone quiet (they may have left)
+        if (_syncSeq-it->second.heard > SYNC_HISTORY) {
+            continue;
+        }
+        if (first || it->second.acked < baseline) {
+            baseline = it->second.acked;
+            first = false;
+        }
+    }
+    
+    if (baseline < _syncHistory.front().first) {
+        return 0;
+    }
+    return baseline;
+}
+
+/**
+ * Packs any changed object information and add them to _outEvents.
+ *
+ * This method helps synchronize any method calls to the obstacles that set its properties.
+ * This includes explicit setPosition(), setVelocity(), setBodyType(), etc.
+ *
+ * Every obstacle with a dirty bit gets one record with the changed fields,
+ * and all of the records are sent in a single {@link PhysDeltaEvent}. No
+ * event is sent if nothing has changed. Only the obstacles in the dirty list
+ * of the world are visited, so the cost scales with the number of changed
+ * obstacles rather than the size of the world.
+ */
+void NetPhysicsController::packPhysObj() {
+    // Each world sends its own event, so a quiet world sends nothing
+    for (auto wt = _worlds.begin(); wt != _worlds.end(); ++wt) {
+        const auto& objs = (*wt)->getDirtyObstacles();
+        if (objs.empty()) {
+            continue;
+        }
+        
+        std::shared_ptr<PhysDeltaEvent> event = nullptr;
+        for (auto it = objs.begin(); it != objs.end(); it++) {
+            physics2::Obstacle* obj = *it;
+            if (!obj->isShared()) {
+                continue;
+            }
+            Uint8 fields = PhysDeltaEvent::getDirtyFields(*obj);
+            if (fields) {
+                if (event == nullptr) {
+                    event = _deltaEventPool->get();
+                }
+                event->addObj(*obj, obj->getGlobalId(), fields);
+                obj->clearSharingDirtyBits();
+            }
+        }
+        (*wt)->clearDirtyObstacles();
+        if (event != nullptr) {
+            _outEvents.push_back(event);
+        }
+    }
+}
+
+/**
+ * Updates the physics controller.
+ */
+void NetPhysicsController::fixedUpdate(){
+    packPhysObj();
+    packJoints();
+    
+    // Only visit the leases that expire this tick
+    _leaseTick++;
+    while (!_leases.empty() && _leases.top().first <= _leaseTick) {
+        OwnerLease lease = _leases.top();
+        _leases.pop();
+        
+        // A lease is stale if it was renewed or released since it was pushed
+        auto it = _leaseExpiry.find(lease.second);
+        if (it == _leaseExpiry.end() || it->second != lease.first) {
+            continue;
+        }
+        _leaseExpiry.erase(it);
+        const std::shared_ptr<physics2::Obstacle>& obj = findObstacle(lease.second);
+        if (obj != nullptr && obj->isOwned() && obj->getOwnedSteps() > 0) {
+            releaseObs(obj);
+        }
+    }
+
+    updateInterpolations();
+    updateEntityBuffers();
+
+    if(ITPR_STATS){
+        CULog("%ld/%ld overriden", _itprCount-_ovrdCount,_itprCount);
+        CULog("Average step: %f", ((float)_stepSum)/_itprCount);
+    }
+}
+
+/**
+ * Helper function for linear object interpolation.
+ *
+ * Formula: (target-source)/stepsLeft + source
+ */
+float NetPhysicsController::interpolate(int stepsLeft, float target, float source){
+    return (target-source)/stepsLeft+source;
+}
+
+#pragma mark -
+#pragma mark Interpolation Batch
+
+/**
+ * Moves the given state towards the target by the given weights.
+ *
+ * This computes state += (target-state)*weight for the first size elements.
+ * It uses the vectorized algorithm, if available.
+ *
+ * @param state     The state to update
+ * @param target    The target state
+ * @param weight    The weight of each element
+ * @param size      The number of elements
+ */
+static void lerp_kernel(float* state, const float* target, const float* weight, size_t size) {
+    size_t ii = 0;
+#if defined (CU_MATH_VECTOR_SSE)
+    if (NetPhysicsController::VECTORIZE) {
+        for(; ii+4 <= size; ii += 4) {
+            __m128 curr = _mm_loadu_ps(state+ii);
+            __m128 diff = _mm_sub_ps(_mm_loadu_ps(target+ii),curr);
+            _mm_storeu_ps(state+ii,_mm_add_ps(curr,_mm_mul_ps(diff,_mm_loadu_ps(weight+ii))));
+        }
+    }
+#elif defined (CU_MATH_VECTOR_NEON64)
+#if defined (__ANDROID__)
+    if (NetPhysicsController::VECTORIZE && android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
+        (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0) {
+#else
+    if (NetPhysicsController::VECTORIZE) {
+#endif
+        for(; ii+4 <= size; ii += 4) {
+            float32x4_t curr = vld1q_f32(state+ii);
+            float32x4_t diff = vsubq_f32(vld1q_f32(target+ii),curr);
+            vst1q_f32(state+ii,vmlaq_f32(curr,diff,vld1q_f32(weight+ii)));
+        }
+    }
+#endif
+    for(; ii < size; ii++) {
+        state[ii] += (target[ii]-state[ii])*weight[ii];
+    }
+}
+
+/**
+ * Starts interpolating the obstacle to the given target.
+ *
+ * If the obstacle is already interpolating, the new target replaces the
+ * old one.
+ *
+ * @param obj       The obstacle to interpolate
+ * @param param     The target parameters for interpolation
+ */
+void NetPhysicsController::addInterpolation(const std::shared_ptr<physics2::Obstacle>& obj, const targetParam& param) {
+    InterpolationBatch& batch = _itpr;
+    Uint8 method = getInterpolationMethod(obj.get());
+    size_t index;
+    auto it = _itprIndex.find(obj.get());
+    if (it != _itprIndex.end()) {
+        index = it->second;
+        if (method == BEZIER_INTERPOLATION && batch.method[index] == method) {
+            return; // Finish the current curve first
+        }
+        obj->setShared(false);
+        // ===== BEGIN NON-SHARED BLOCK =====
+        obj->setLinearVelocity(batch.target[ITPR_VX*batch.capacity+index],
+                               batch.target[ITPR_VY*batch.capacity+index]);
+        obj->setAngularVelocity(batch.target[ITPR_ANGV*batch.capacity+index]);
+        // ====== END NON-SHARED BLOCK ======
+        obj->setShared(true);
+    } else {
+        if (batch.size == batch.capacity) {
+            size_t capacity = SDL_max(ITPR_MIN_CAPACITY, 2*batch.capacity);
+            std::vector<float> state(ITPR_FIELDS*capacity);
+            std::vector<float> target(ITPR_FIELDS*capacity);
+            std::vector<float> weight(ITPR_FIELDS*capacity);
+            for(size_t ff = 0; ff < ITPR_FIELDS; ff++) {
+                std::copy(batch.state.begin()+ff*batch.capacity, batch.state.begin()+ff*batch.capacity+batch.size,
+                          state.begin()+ff*capacity);
+                std::copy(batch.target.begin()+ff*batch.capacity, batch.target.begin()+ff*batch.capacity+batch.size,
+                          target.begin()+ff*capacity);
+            }
+            batch.state.swap(state);
+            batch.target.swap(target);
+            batch.weight.swap(weight);
+            batch.objects.resize(capacity);
+            batch.method.resize(capacity);
+            batch.direct.resize(capacity);
+            batch.bodies.resize(capacity);
+            batch.curStep.resize(capacity);
+            batch.numSteps.resize(capacity);
+            batch.P2.resize(capacity);
+            batch.I.resize(capacity);
+            batch.numI.resize(capacity);
+            batch.capacity = capacity;
+        }
+        index = batch.size++;
+        batch.objects[index] = obj;
+        batch.direct[index] = dynamic_cast<physics2::ComplexObstacle*>(obj.get()) == nullptr;
+        batch.I[index] = param.I;
+        batch.numI[index] = param.numI;
+        _itprIndex[obj.get()] = index;
+    }
+    
+    size_t cap = batch.capacity;
+    batch.method[index] = method;
+    batch.curStep[index] = param.curStep;
+    batch.numSteps[index] = param.numSteps;
+    batch.P2[index] = param.P2;
+    batch.target[ITPR_X*cap+index] = param.P3.x;
+    batch.target[ITPR_Y*cap+index] = param.P3.y;
+    batch.target[ITPR_VX*cap+index] = param.targetVel.x;
+    batch.target[ITPR_VY*cap+index] = param.targetVel.y;
+    batch.target[ITPR_ANGLE*cap+index] = param.targetAngle;
+    batch.target[ITPR_ANGV*cap+index] = param.targetAngV;
+    _stepSum += param.numSteps;
+    _itprCount ++;
+}
+
+/**
+ * Stops interpolating the given obstacle.
+ *
+ * This does nothing if the obstacle is not interpolating.
+ *
+ * @param obj   The obstacle to stop interpolating
+ */
+void NetPhysicsController::removeInterpolation(const std::shared_ptr<physics2::Obstacle>& obj) {
+    auto it = _itprIndex.find(obj.get());
+    if (it == _itprIndex.end()) {
+        return;
+    }
+    
+    // Move the last entry into the hole
+    InterpolationBatch& batch = _itpr;
+    size_t index = it->second;
+    size_t last = batch.size-1;
+    _itprIndex.erase(it);
+    if (index != last) {
+        batch.objects[index] = batch.objects[last];
+        batch.direct[index] = batch.direct[last];
+        batch.method[index] = batch.method[last];
+        batch.curStep[index] = batch.curStep[last];
+        batch.numSteps[index] = batch.numSteps[last];
+        batch.P2[index] = batch.P2[last];
+        batch.I[index] = batch.I[last];
+        batch.numI[index] = batch.numI[last];
+        for(size_t ff = 0; ff < ITPR_FIELDS; ff++) {
+            batch.target[ff*batch.capacity+index] = batch.target[ff*batch.capacity+last];
+        }
+        _itprIndex[batch.objects[index].get()] = index;
+    }
+    batch.objects[last] = nullptr;
+    batch.size--;
+}
+
+/**
+ * Stops all interpolations.
+ */
+void NetPhysicsController::clearInterpolations() {
+    InterpolationBatch& batch = _itpr;
+    for(size_t ii = 0; ii < batch.size; ii++) {
+        batch.objects[ii] = nullptr;
+    }
+    batch.size = 0;
+    _itprIndex.clear();
+}
+
+/**
+ * Advances all interpolations by one step.
+ *
+ * The state of every interpolated obstacle is gathered into the batch,
+ * advanced in one vector pass per field, and written back. Obstacles with
+ * a single body are written to the body directly, with one transform
+ * update each. Finished interpolations are removed.
+ */
+void NetPhysicsController::updateInterpolations() {
+    InterpolationBatch& batch = _itpr;
+    size_t cap = batch.capacity;
+    
+    // Drop anything that stopped being shared or lost its body
+    for(size_t ii = batch.size; ii > 0; ii--) {
+        const std::shared_ptr<physics2::Obstacle>& obj = batch.objects[ii-1];
+        if (!obj->isShared() || obj->getBody() == nullptr) {
+            removeInterpolation(std::shared_ptr<physics2::Obstacle>(obj));
+        }
+    }
+    
+    // Gather
+    float* state = batch.state.data();
+    for(size_t ii = 0; ii < batch.size; ii++) {
+        physics2::Obstacle* obj = batch.objects[ii].get();
+        b2Body* body = obj->getBody();
+        batch.bodies[ii] = batch.direct[ii] ? body : nullptr;
+        
+        const b2Vec2& pos = body->GetPosition();
+        const b2Vec2& vel = body->GetLinearVelocity();
+        state[ITPR_X*cap+ii] = pos.x;
+        state[ITPR_Y*cap+ii] = pos.y;
+        state[ITPR_VX*cap+ii] = vel.x;
+        state[ITPR_VY*cap+ii] = vel.y;
+        state[ITPR_ANGLE*cap+ii] = body->GetAngle();
+        state[ITPR_ANGV*cap+ii] = body->GetAngularVelocity();
+        
+        int stepsLeft = batch.numSteps[ii]-batch.curStep[ii];
+        float weight = stepsLeft <= 1 ? 1.0f : 1.0f/stepsLeft;
+        for(size_t ff = ITPR_X; ff < ITPR_FIELDS; ff++) {
+            batch.weight[ff*cap+ii] = weight;
+        }
+    }
+    
+    // The curve methods set their fields here, and skip them in the lerp
+    const float* target = batch.target.data();
+    float* weight = batch.weight.data();
+    for(size_t ii = 0; ii < batch.size; ii++) {
+        Uint8 method = batch.method[ii];
+        if (method == LINEAR_INTERPOLATION || batch.numSteps[ii]-batch.curStep[ii] <= 1) {
+            continue;
+        }
+        float t = ((float)batch.curStep[ii])/batch.numSteps[ii];
+        CUAssert(t<=1.f && t>=0.f);
+        Vec2 P0(state[ITPR_X*cap+ii],state[ITPR_Y*cap+ii]);
+        Vec2 V0(state[ITPR_VX*cap+ii],state[ITPR_VY*cap+ii]);
+        Vec2 P3(target[ITPR_X*cap+ii],target[ITPR_Y*cap+ii]);
+        
+        if (method == PID_INTERPOLATION) {
+            Vec2 E = P3-P0;
+            batch.numI[ii]++;
+            batch.I[ii] = batch.I[ii] + E;
+            
+            Vec2 P = E*10.f;
+            Vec2 I = batch.I[ii]*0.01f;
+            Vec2 D = V0*0.5f;
+            state[ITPR_VX*cap+ii] = V0.x+P.x-D.x+I.x;
+            state[ITPR_VY*cap+ii] = V0.y+P.y-D.y+I.y;
+        } else {
+            Vec2 pos;
+            if (method == BEZIER_INTERPOLATION) {
+                Vec2 P1 = P0+V0/10.f;
+                pos = (1-t)*(1-t)*(1-t)*P0 + 3*(1-t)*(1-t)*t*P1 + 3*(1-t)*t*t*batch.P2[ii] + t*t*t*P3;
+            } else {
+                Vec2 V3(target[ITPR_VX*cap+ii],target[ITPR_VY*cap+ii]);
+                pos = (2*t*t*t-3*t*t+1)*P0 + (t*t*t-2*t*t+t)*V0 + (-2*t*t*t+3*t*t)*P3 + (t*t*t-t*t)*V3;
+            }
+            state[ITPR_X*cap+ii] = pos.x;
+            state[ITPR_Y*cap+ii] = pos.y;
+        }
+        weight[ITPR_X*cap+ii]  = 0;
+        weight[ITPR_Y*cap+ii]  = 0;
+        weight[ITPR_VX*cap+ii] = 0;
+        weight[ITPR_VY*cap+ii] = 0;
+    }
+    
+    // Advance
+    for(size_t ff = ITPR_X; ff < ITPR_FIELDS; ff++) {
+        lerp_kernel(state+ff*cap, target+ff*cap, weight+ff*cap, batch.size);
+    }
+    
+    // Write back, snapping finished interpolations to their target
+    for(size_t ii = 0; ii < batch.size; ii++) {
+        const float* src = batch.numSteps[ii]-batch.curStep[ii] <= 1 ? target : state;
+        float x  = src[ITPR_X*cap+ii];
+        float y  = src[ITPR_Y*cap+ii];
+        float vx = src[ITPR_VX*cap+ii];
+        float vy = src[ITPR_VY*cap+ii];
+        float angle = src[ITPR_ANGLE*cap+ii];
+        float angv  = src[ITPR_ANGV*cap+ii];
+        
+        b2Body* body = batch.bodies[ii];
+        if (body != nullptr) {
+            body->SetTransform(b2Vec2(x,y),angle);
+            body->SetLinearVelocity(b2Vec2(vx,vy));
+            body->SetAngularVelocity(angv);
+        } else {
+            physics2::Obstacle* obj = batch.objects[ii].get();
+            obj->setShared(false);
+            // ===== BEGIN NON-SHARED BLOCK =====
+            obj->setPosition(x,y);
+            obj->setAngle(angle);
+            obj->setLinearVelocity(vx,vy);
+            obj->setAngularVelocity(angv);
+            // ====== END NON-SHARED BLOCK ======
+            obj->setShared(true);
+        }
+        batch.curStep[ii]++;
+    }
+    
+    for(size_t ii = batch.size; ii > 0; ii--) {
+        if (batch.curStep[ii-1] >= batch.numSteps[ii-1]) {
+            _ovrdCount++;
+            removeInterpolation(std::shared_ptr<physics2::Obstacle>(batch.objects[ii-1]));
+        }
+    }
+}
+
+/**
+ * Returns the interpolation method to use for the given obstacle.
+ *
+ * This is the method of the obstacle, or the default method if the
+ * obstacle does not have one.
+ *
+ * @param obj   The obstacle to check
+ *
+ * @return the interpolation method to use for the given obstacle.
+ */
+Uint8 NetPhysicsController::getInterpolationMethod(const physics2::Obstacle* obj) const {
+    Uint8 method = obj->getInterpolation();
+    return method == DEFAULT_INTERPOLATION || method > BUFFERED_INTERPOLATION ? _itprMethod : method;
+}
+
+/**
+ * Adds a snapshot to the buffer of the given obstacle.
+ *
+ * Snapshots older than the newest one in the buffer are ignored.
+ *
+ * @param obj   The obstacle with buffered interpolation
+ * @param tick  The sender tick of the snapshot
+ * @param param The state of the obstacle in the snapshot
+ */
+void NetPhysicsController::addEntitySample(const std::shared_ptr<physics2::Obstacle>& obj, Uint64 tick, const ObjParam& param) {
+    removeInterpolation(obj);
+    
+    EntityBuffer& buffer = _entityBuffers[param.objId];
+    if (!buffer.samples.empty() && tick <= buffer.samples.back().first) {
+        return;
+    }
+    buffer.samples.push_back(std::make_pair(tick, param));
+    if (buffer.samples.size() > BUFFER_MAX_SAMPLES) {
+        buffer.samples.pop_front();
+    }
+    
+    // Resynchronize the render clock if it drifted too far from the delay
+    double newest = (double)tick;
+    double delay  = (double)_itprDelay;
+    if (buffer.samples.size() == 1 || buffer.renderTick > newest ||
+        buffer.renderTick < newest-2*delay) {
+        buffer.renderTick = newest-delay;
+    }
+}
+
+/**
+ * Advances all obstacles with buffered interpolation by one tick.
+ *
+ * Each obstacle is moved to the state between the two snapshots around
+ * its render tick. If the render tick is past the newest snapshot, the
+ * obstacle holds the newest state.
+ */
+void NetPhysicsController::updateEntityBuffers() {
+    for(auto it = _entityBuffers.begin(); it != _entityBuffers.end(); ) {
+        const std::shared_ptr<physics2::Obstacle>& obj = findObstacle(it->first);
+        EntityBuffer& buffer = it->second;
+        if (obj == nullptr || !obj->isShared() || buffer.samples.empty()) {
+            it = _entityBuffers.erase(it);
+            continue;
+        }
+        
+        // Drop the snapshots that are entirely in the past
+        buffer.renderTick += 1;
+        while (buffer.samples.size() > 1 && buffer.samples[1].first <= buffer.renderTick) {
+            buffer.samples.pop_front();
+        }
+        
+        const ObjParam& prev = buffer.samples.front().second;
+        ObjParam curr = prev;
+        if (buffer.samples.size() > 1 && buffer.renderTick > buffer.samples.front().first) {
+            const ObjParam& next = buffer.samples[1].second;
+            double span = (double)(buffer.samples[1].first-buffer.samples.front().first);
+            float t = (float)((buffer.renderTick-buffer.samples.front().first)/span);
+            curr.x  = prev.x+(next.x-prev.x)*t;
+            curr.y  = prev.y+(next.y-prev.y)*t;
+            curr.vx = prev.vx+(next.vx-prev.vx)*t;
+            curr.vy = prev.vy+(next.vy-prev.vy)*t;
+            curr.angle = prev.angle+(float)std::remainder(next.angle-prev.angle, 2*M_PI)*t;
+            curr.vAngular = prev.vAngular+(next.vAngular-prev.vAngular)*t;
+        }
+        
+        obj->setShared(false);
+        // ===== BEGIN NON-SHARED BLOCK =====
+        obj->setPosition(curr.x,curr.y);
+        obj->setAngle(obj->getAngle()+(float)std::remainder(curr.angle-obj->getAngle(), 2*M_PI));
+        obj->setLinearVelocity(curr.vx,curr.vy);
+        obj->setAngularVelocity(curr.vAngular);
+        // ====== END NON-SHARED BLOCK ======
+        obj->setShared(true);
+        ++it;
+    }
+}
+
+/**
+ * Adds an obstacle to predict locally.
+ *
+ * Prediction is for clients in host-authoritative mode. A predicted
+ * obstacle is simulated locally from the inputs of this client, instead of
+ * interpolated towards the host snapshots. When a host snapshot disagrees
+ * with the prediction for the same tick, the predicted obstacles are
+ * rewound to the host state, and the inputs since then are replayed (see
+ * {@link setInputFunc}).
+ *
+ * @param obj   The obstacle to predict
+ */
+void NetPhysicsController::addPredicted(const std::shared_ptr<physics2::Obstacle>& obj) {
+    if (!isPredicted(obj)) {
+        _predicted.push_back(obj);
+        removeInterpolation(obj);
+        _entityBuffers.erase(obj->getGlobalId());
+    }
+}
+
+/**
+ * Removes an obstacle from prediction.
+ *
+ * The obstacle will be interpolated towards the host snapshots again.
+ *
+ * @param obj   The obstacle to stop predicting
+ */
+void NetPhysicsController::removePredicted(const std::shared_ptr<physics2::Obstacle>& obj) {
+    auto it = std::find(_predicted.begin(), _predicted.end(), obj);
+    if (it != _predicted.end()) {
+        _predicted.erase(it);
+    }
+}
+
+/**
+ * Returns true if the given obstacle is predicted locally.
+ *
+ * @param obj   The obstacle to check
+ *
+ * @return true if the given obstacle is predicted locally.
+ */
+bool NetPhysicsController::isPredicted(const std::shared_ptr<physics2::Obstacle>& obj) const {
+    return std::find(_predicted.begin(), _predicted.end(), obj) != _predicted.end();
+}
+
+/**
+ * Records the input and predicted state of the given tick.
+ *
+ * This method is called automatically by the {@link NetEventController}
+ * in host-authoritative mode. It should be called after the world has been
+ * stepped for the tick.
+ *
+ * @param tick  The game tick
+ * @param input The input commands of the tick
+ */
+void NetPhysicsController::recordPrediction(Uint64 tick, const std::vector<std::byte>& input) {
+    if (_predictionFrames.empty()) {
+        _predictionFrames.resize(PREDICTION_HISTORY);
+    }
+    PredictionFrame& frame = _predictionFrames[tick % PREDICTION_HISTORY];
+    frame.tick = tick;
+    frame.valid = true;
+    frame.input = input;
+    frame.states.clear();
+    for (auto it = _predicted.begin(); it != _predicted.end(); ++it) {
+        if ((*it)->hasGlobalId()) {
+            frame.states.push_back(PhysSyncEvent::snapshot(*it, (*it)->getGlobalId()));
+        }
+    }
+    _predictionTick = tick;
+}
+
+/**
+ * Sets the state of an obstacle without marking it as changed.
+ *
+ * @param obj   The obstacle to modify
+ * @param param The state to apply
+ */
+void NetPhysicsController::applyState(const std::shared_ptr<physics2::Obstacle>& obj, const ObjParam& param) {
+    bool shared = obj->isShared();
+    obj->setShared(false);
+    // ===== BEGIN NON-SHARED BLOCK =====
+    obj->setPosition(Vec2(param.x,param.y));
+    obj->setAngle(param.angle);
+    obj->setLinearVelocity(Vec2(param.vx,param.vy));
+    obj->setAngularVelocity(param.vAngular);
+    // ====== END NON-SHARED BLOCK ======
+    obj->setShared(shared);
+}
+
+/**
+ * Reconciles the predicted obstacles with an authoritative state.
+ *
+ * If any prediction for the given tick is off by more than the tolerance,
+ * the predicted obstacles are rewound to the authoritative state and the
+ * recorded inputs since then are replayed. Otherwise, this method does
+ * nothing.
+ *
+ * Only the predicted obstacles are rewound. The world state is captured
+ * before the replay and restored afterwards (see
+ * {@link ObstacleWorld#captureState}), so the replay costs one world step
+ * per tick plus one state copy per predicted obstacle.
+ *
+ * @param tick          The tick of the authoritative state
+ * @param corrections   The authoritative state of the predicted obstacles
+ */
+void NetPhysicsController::reconcile(Uint64 tick, const std::vector<ObjParam>& corrections) {
+    PredictionFrame* frame = nullptr;
+    if (!_predictionFrames.empty()) {
+        frame = &(_predictionFrames[tick % PREDICTION_HISTORY]);
+        if (!frame->valid || frame->tick != tick || tick > _predictionTick) {
+            frame = nullptr;
+        }
+    }
+    
+    if (frame == nullptr || _predictionTick-tick > PREDICTION_MAX_REPLAY) {
+        // Too old to replay, so just take the host state
+        for (auto it = corrections.begin(); it != corrections.end(); ++it) {
+            const std::shared_ptr<physics2::Obstacle>& obj = findObstacle(it->objId);
+            if (obj != nullptr) {
+                applyState(obj, *it);
+            }
+        }
+        return;
+    }
+    
+    // Check the prediction for that tick
+    bool diverged = false;
+    for (auto it = corrections.begin(); !diverged && it != corrections.end(); ++it) {
+        const ObjParam* predicted = nullptr;
+        for (auto jt = frame->states.begin(); jt != frame->states.end(); ++jt) {
+            if (jt->objId == it->objId) {
+                predicted = &(*jt);
+            }
+        }
+        if (predicted == nullptr) {
+            diverged = true;
+        } else {
+            float error = Vec2(it->x-predicted->x, it->y-predicted->y).length();
+            float angError = std::abs(std::remainder(it->angle-predicted->angle, 2*M_PI));
+            diverged = error > _predictionTolerance || angError > _predictionTolerance;
+        }
+    }
+    if (!diverged) {
+        return;
+    }
+    _rollbackCount++;
+    
+    // Only the worlds with predicted obstacles are replayed
+    std::vector<bool> replay(_worlds.size(),false);
+    for (auto it = frame->states.begin(); it != frame->states.end(); ++it) {
+        replay[worldIndex(it->objId)] = true;
+    }
+    
+    // Every other obstacle is already at the current tick
+    _rollbackStates.resize(_worlds.size());
+    for (size_t ii = 0; ii < _worlds.size(); ii++) {
+        if (replay[ii]) {
+            _worlds[ii]->captureState(_rollbackStates[ii]);
+        }
+    }
+    
+    // Rewind the predicted obstacles to the authoritative state
+    for (auto it = corrections.begin(); it != corrections.end(); ++it) {
+        for (auto jt = frame->states.begin(); jt != frame->states.end(); ++jt) {
+            if (jt->objId == it->objId) {
+                *jt = *it;
+            }
+        }
+    }
+    for (auto it = frame->states.begin(); it != frame->states.end(); ++it) {
+        const std::shared_ptr<physics2::Obstacle>& obj = findObstacle(it->objId);
+        if (obj != nullptr) {
+            applyState(obj, *it);
+        }
+    }
+    
+    // Replay the inputs since then
+    for (Uint64 t = tick+1; t <= _predictionTick; t++) {
+        PredictionFrame& next = _predictionFrames[t % PREDICTION_HISTORY];
+        if (!next.valid || next.tick != t) {
+            break;
+        }
+        if (_inputFunc) {
+            _inputFunc(t, next.input);
+        }
+        for (size_t ii = 0; ii < _worlds.size(); ii++) {
+            if (replay[ii]) {
+                _worlds[ii]->step(FIXED_TIMESTEP_S);
+            }
+        }
+        next.states.clear();
+        for (auto it = _predicted.begin(); it != _predicted.end(); ++it) {
+            if ((*it)->hasGlobalId()) {
+                next.states.push_back(PhysSyncEvent::snapshot(*it, (*it)->getGlobalId()));
+            }
+        }
+    }
+    
+    // Restore everything else, and then put back the replayed obstacles
+    std::vector<ObjParam> replayed;
+    for (auto it = _predicted.begin(); it != _predicted.end(); ++it) {
+        if ((*it)->hasGlobalId()) {
+            replayed.push_back(PhysSyncEvent::snapshot(*it, (*it)->getGlobalId()));
+        }
+    }
+    for (size_t ii = 0; ii < _worlds.size(); ii++) {
+        if (replay[ii]) {
+            _worlds[ii]->restoreState(_rollbackStates[ii]);
+        }
+    }
+    for (auto it = replayed.begin(); it != replayed.end(); ++it) {
+        const std::shared_ptr<physics2::Obstacle>& obj = findObstacle(it->objId);
+        if (obj != nullptr) {
+            applyState(obj, *it);
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Desync Detection
+
+/**
+ * Mixes the bits of a value into an FNV-1a checksum
+ *
+ * @param hash  The running checksum
+ * @param value The value to mix in
+ *
+ * @return the updated checksum
+ */
+static Uint32 checksum_mix(Uint32 hash, Uint64 value) {
+    for (int ii = 0; ii < 8; ii++) {
+        hash ^= (Uint32)((value >> (8*ii)) & 0xFF);
+        hash *= CHECKSUM_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Returns the checksum bucket for the given obstacle id
+ *
+ * @param id    The global obstacle id
+ *
+ * @return the checksum bucket for the given obstacle id
+ */
+static size_t checksum_bucket(Uint64 id) {
+    return (size_t)(((id*0x9E3779B97F4A7C15ULL) >> 32) % CHECKSUM_BUCKETS);
+}
+
+/**
+ * Computes the checksum of the shared state into the given buckets.
+ *
+ * Each shared obstacle contributes a hash of its quantized position, angle
+ * and velocities to the bucket for its id. The contributions are summed,
+ * so the result does not depend on the order of the obstacles.
+ *
+ * Unless its world is deterministic, only obstacles at rest are included.
+ * Moving obstacles on a remote client lag behind by the latency, and so
+ * would never match.
+ *
+ * @param buckets   The vector to store the bucket hashes
+ */
+void NetPhysicsController::computeChecksum(std::vector<Uint32>& buckets) const {
+    buckets.assign(CHECKSUM_BUCKETS, 0);
+    double scale = _checksumQuantum > 0 ? 1.0/_checksumQuantum : 1.0;
+    
+    for (auto wt = _worlds.begin(); wt != _worlds.end(); ++wt) {
+        bool moving = (*wt)->isDeterministic();
+        const auto& objs = (*wt)->getObstacles();
+        for (auto it = objs.begin(); it != objs.end(); ++it) {
+            const physics2::Obstacle* obj = it->get();
+            if (!obj->isShared() || !obj->hasGlobalId()) {
+                continue;
+            }
+            Vec2 vel = obj->getLinearVelocity();
+            Sint64 vx = std::llround(vel.x*scale);
+            Sint64 vy = std::llround(vel.y*scale);
+            Sint64 va = std::llround(obj->getAngularVelocity()*scale);
+            if (!moving && (vx || vy || va)) {
+                continue;
+            }
+            
+            Vec2 pos = obj->getPosition();
+            Uint32 hash = CHECKSUM_BASIS;
+            hash = checksum_mix(hash, obj->getGlobalId());
+            hash = checksum_mix(hash, (Uint64)std::llround(pos.x*scale));
+            hash = checksum_mix(hash, (Uint64)std::llround(pos.y*scale));
+            hash = checksum_mix(hash, LWBitSerializer::quantizeAngle(obj->getAngle(), CHECKSUM_ANGLE_BITS));
+            hash = checksum_mix(hash, (Uint64)vx);
+            hash = checksum_mix(hash, (Uint64)vy);
+            hash = checksum_mix(hash, (Uint64)va);
+            buckets[checksum_bucket(obj->getGlobalId())] += hash;
+        }
+    }
+}
+
+/**
+ * Records a checksum of the shared state if one is due at this tick.
+ *
+ * If a checksum is due, it is added to the out events as a
+ * {@link PhysChecksumEvent}. This method is called automatically by the
+ * {@link NetEventController} each tick.
+ *
+ * @param tick  The game tick
+ */
+void NetPhysicsController::packChecksum(Uint64 tick) {
+    if (_checksumInterval == 0 || tick % _checksumInterval != 0) {
+        return;
+    }
+    if (_checksums.empty()) {
+        _checksums.resize(CHECKSUM_HISTORY);
+    }
+    
+    ChecksumRecord& record = _checksums[(tick/_checksumInterval) % CHECKSUM_HISTORY];
+    record.tick = tick;
+    record.valid = true;
+    computeChecksum(record.buckets);
+    auto event = _checksumEventPool->get();
+    event->init(_shortUID, tick, record.buckets);
+    _outEvents.push_back(event);
+}
+
+/**
+ * Processes a checksum event from another client.
+ *
+ * The checksum is compared to the one recorded for the same tick. If that
+ * tick is no longer (or not yet) recorded, the event is ignored.
+ */
+void NetPhysicsController::processChecksumEvent(const std::shared_ptr<PhysChecksumEvent>& event) {
+    Uint64 tick = event->getTick();
+    if (_checksumInterval == 0 || _checksums.empty() || tick % _checksumInterval != 0) {
+        return;
+    }
+    const ChecksumRecord& record = _checksums[(tick/_checksumInterval) % CHECKSUM_HISTORY];
+    const std::vector<Uint32>& theirs = event->getBuckets();
+    if (!record.valid || record.tick != tick || theirs.size() != record.buckets.size()) {
+        return;
+    }
+    
+    auto jt = _desyncs.find(event->getSourceUID());
+    if (jt == _desyncs.end()) {
+        jt = _desyncs.emplace(event->getSourceUID(), DesyncState{0,0,0,false}).first;
+    } else if (tick <= jt->second.lastTick) {
+        return; // Checksums arrive unordered
+    }
+    DesyncState& state = jt->second;
+    state.lastTick = tick;
+    
+    bool match = true;
+    for (size_t ii = 0; match && ii < theirs.size(); ii++) {
+        match = theirs[ii] == record.buckets[ii];
+    }
+    if (match) {
+        state.strikes = 0;
+        state.reported = false;
+        return;
+    }
+    
+    if (state.strikes == 0) {
+        state.firstTick = tick;
+    }
+    state.strikes++;
+    if (state.strikes < CHECKSUM_CONFIRM || state.reported) {
+        return;
+    }
+    
+    state.reported = true;
+    _desyncCount++;
+    if (_desyncFunc) {
+        std::vector<Uint64> suspects;
+        for (auto wt = _worlds.begin(); wt != _worlds.end(); ++wt) {
+            const auto& objs = (*wt)->getObstacles();
+            for (auto it = objs.begin(); it != objs.end(); ++it) {
+                if ((*it)->isShared() && (*it)->hasGlobalId()) {
+                    size_t bucket = checksum_bucket((*it)->getGlobalId());
+                    if (theirs[bucket] != record.buckets[bucket]) {
+                        suspects.push_back((*it)->getGlobalId());
+                    }
+                }
+            }
+        }
+        _desyncFunc(event->getSourceUID(), state.firstTick, suspects);
+    }
+}
+
+#pragma mark -
+#pragma mark Host Migration
+
+/**
+ * Records an ownership checkpoint if one is due at this tick.
+ *
+ * Only the host sends checkpoints. If one is due, it is added to the out
+ * events. This method is called automatically by the
+ * {@link NetEventController} each tick.
+ *
+ * @param tick  The game tick
+ */
+void NetPhysicsController::packCheckpoint(Uint64 tick) {
+    if (!_isHost || _checkpointInterval == 0 || tick % _checkpointInterval != 0) {
+        return;
+    }
+    auto event = _checkpointEventPool->get();
+    event->init(tick);
+    for (auto it = _owners.begin(); it != _owners.end(); ++it) {
+        event->addOwner(it->first, it->second);
+    }
+    _outEvents.push_back(event);
+}
+
+/**
+ * Processes an ownership checkpoint from the host.
+ *
+ * The checkpoint replaces the ownership table of this client.
+ */
+void NetPhysicsController::processCheckpointEvent(const std::shared_ptr<PhysCheckpointEvent>& event) {
+    if (_isHost) {
+        return;
+    }
+    _owners.clear();
+    const std::vector<std::string>& peers = event->getPeers();
+    const std::vector<std::pair<Uint64,Uint32>>& owners = event->getOwners();
+    for (auto it = owners.begin(); it != owners.end(); ++it) {
+        _owners[it->first] = peers[it->second];
+    }
+}
+
+/**
+ * Makes this client the host of the physics state.
+ *
+ * This is called by the {@link NetEventController} when this client is
+ * promoted during a host migration. The obstacles held by a client in the
+ * given set stay with that client. This client takes every other shared
+ * obstacle, starting from the latest state received for it. Any pending
+ * interpolation is skipped, so the new host simulates each obstacle from
+ * the tick it takes over, and there is no need to resynchronize.
+ *
+ * Snapshot baselines are reset, so the first snapshots of the new host
+ * are key snapshots.
+ *
+ * @param players   The UUIDs of the clients still in the game
+ */
+void NetPhysicsController::promote(const std::unordered_set<std::string>& players) {
+    _isHost = true;
+    // The host owns everything permanently
+    _leases = decltype(_leases)();
+    _leaseExpiry.clear();
+    InterpolationBatch& batch = _itpr;
+    for (auto wt = _worlds.begin(); wt != _worlds.end(); ++wt) {
+        for (auto it = (*wt)->getObstacles().begin(); it != (*wt)->getObstacles().end(); ++it) {
+            const std::shared_ptr<physics2::Obstacle>& obj = *it;
+            if (!obj->isShared() || !obj->hasGlobalId()) {
+                continue;
+            }
+            Uint64 id = obj->getGlobalId();
+            if (obj->isOwned()) {
+                obj->setOwned(0);
+                _owners.erase(id);
+                continue;
+            }
+            
+            auto jt = _owners.find(id);
+            if (jt != _owners.end()) {
+                if (players.count(jt->second)) {
+                    continue; // Still held by a client
+                }
+                _owners.erase(jt);
+            }
+            
+            // Jump to the latest state received, rather than finish the interpolation
+            auto kt = _itprIndex.find(obj.get());
+            if (kt != _itprIndex.end()) {
+                size_t index = kt->second;
+                size_t cap = batch.capacity;
+                ObjParam param;
+                param.objId = id;
+                param.x = batch.target[ITPR_X*cap+index];
+                param.y = batch.target[ITPR_Y*cap+index];
+                param.vx = batch.target[ITPR_VX*cap+index];
+                param.vy = batch.target[ITPR_VY*cap+index];
+                param.angle = batch.target[ITPR_ANGLE*cap+index];
+                param.vAngular = batch.target[ITPR_ANGV*cap+index];
+                applyState(obj, param);
+                removeInterpolation(obj);
+            }
+            auto lt = _entityBuffers.find(id);
+            if (lt != _entityBuffers.end()) {
+                if (!lt->second.samples.empty()) {
+                    applyState(obj, lt->second.samples.back().second);
+                }
+                _entityBuffers.erase(lt);
+            }
+            obj->setOwned(0);
+            obj->addSyncPriority(PRIO_OWNER_BONUS);
+        }
+    }
+    
+    // The baselines belong to the snapshot stream of the old host
+    _syncHistory.clear();
+    _peerHistory.clear();
+    _syncAcks.clear();
+    _spectatorHistory.clear();
+}
+
+#pragma mark -
+#pragma mark Lag Compensation
+/**
+ * Records the state of the moving shared obstacles at the given tick.
+ *
+ * This method is called automatically by the NetEventController on the
+ * host. It does nothing if the rewind history is disabled.
+ *
+ * @param tick  The current game tick
+ */
+void NetPhysicsController::recordRewind(Uint64 tick) {
+    if (_rewindLength == 0) {
+        return;
+    }
+    if (!_rewindHistory.empty() && _rewindHistory.back().first >= tick) {
+        _rewindHistory.back().second.clear(); // The same tick, recorded again
+    } else {
+        // Reuse the storage of the oldest tick
+        SyncState state;
+        if (_rewindHistory.size() >= _rewindLength) {
+            state = std::move(_rewindHistory.front().second);
+            state.clear();
+            _rewindHistory.pop_front();
+        }
+        _rewindHistory.push_back(std::make_pair(tick, std::move(state)));
+    }
+    
+    SyncState& state = _rewindHistory.back().second;
+    for (auto wt = _worlds.begin(); wt != _worlds.end(); ++wt) {
+        for (auto it = (*wt)->getObstacles().begin(); it != (*wt)->getObstacles().end(); ++it) {
+            const std::shared_ptr<physics2::Obstacle>& obj = *it;
+            if (obj->isShared() && obj->hasGlobalId() && obj->getBody() != nullptr &&
+                obj->getBodyType() != b2_staticBody) {
+                state.emplace(obj->getGlobalId(), PhysSyncEvent::snapshot(obj, obj->getGlobalId()));
+            }
+        }
+    }
+}
+
+/**
+ * Returns true if a ray hits an obstacle as it was at the given tick.
+ *
+ * This is for validating instant hits (such as hitscan weapons) on the
+ * host. A shot should be checked against where the targets were on the
+ * screen of the shooter, which is the tick that the shooter saw (its
+ * estimate of the host tick, minus its interpolation delay). The shooter
+ * should send this tick with the shot.
+ *
+ * The moving shared obstacles are tested at their recorded state at the
+ * given tick, without moving their bodies. Everything else (such as
+ * static walls) is tested where it is now with the live broadphase. A
+ * tick older than the history uses the oldest recorded tick, and a tick
+ * newer than the history uses the live world. Sensors are ignored.
+ *
+ * @param tick      The game tick to rewind to
+ * @param p1        The start of the ray (in physics coordinates)
+ * @param p2        The end of the ray (in physics coordinates)
+ * @param hit       The nearest hit, if any
+ * @param filter    Returns true for the obstacles that may be hit (optional)
+ * @param shard     The world to cast in
+ *
+ * @return true if a ray hits an obstacle as it was at the given tick.
+ */
+bool NetPhysicsController::rayCastAt(Uint64 tick, const Vec2& p1, const Vec2& p2, RewindHit& hit,
+                                     std::function<bool(const physics2::Obstacle*)> filter, Uint8 shard) const {
+    const std::shared_ptr<physics2::ObstacleWorld>& world = _worlds[shard < _worlds.size() ? shard : 0];
+    
+    // Find the latest recorded tick at or before the given one
+    const SyncState* past = nullptr;
+    if (!_rewindHistory.empty() && tick < _rewindHistory.back().first) {
+        past = &(_rewindHistory.front().second);
+        for (auto it = _rewindHistory.rbegin(); it != _rewindHistory.rend(); ++it) {
+            if (it->first <= tick) {
+                past = &(it->second);
+                break;
+            }
+        }
+    }
+    
+    b2RayCastInput input;
+    input.p1.Set(p1.x, p1.y);
+    input.p2.Set(p2.x, p2.y);
+    input.maxFraction = 1.0f;
+    b2AABB bounds;
+    bounds.lowerBound = b2Min(input.p1, input.p2);
+    bounds.upperBound = b2Max(input.p1, input.p2);
+    
+    float best = 1.0f;
+    bool found = false;
+    auto accept = [&](physics2::Obstacle* obj, const b2Vec2& point, const b2Vec2& normal, float fraction) {
+        if (fraction < best || !found) {
+            best = fraction;
+            found = true;
+            hit.obstacle = world->getObstacle(obj->getGlobalId());
+            hit.point = Vec2(point.x, point.y);
+            hit.normal = Vec2(normal.x, normal.y);
+            hit.fraction = fraction;
+        }
+    };
+    
+    // The moving obstacles at their recorded state
+    if (past != nullptr) {
+        for (auto it = past->begin(); it != past->end(); ++it) {
+            const std::shared_ptr<physics2::Obstacle>& obj = findObstacle(it->first);
+            if (obj == nullptr || world != worldOf(it->first) || obj->getBody() == nullptr ||
+                (filter && !filter(obj.get()))) {
+                continue;
+            }
+            b2Transform xf(b2Vec2(it->second.x, it->second.y), b2Rot(it->second.angle));
+            for (b2Fixture* f = obj->getBody()->GetFixtureList(); f; f = f->GetNext()) {
+                if (f->IsSensor()) {
+                    continue;
+                }
+                b2Shape* shape = f->GetShape();
+                for (int32 child = 0; child < shape->GetChildCount(); child++) {
+                    b2AABB aabb;
+                    shape->ComputeAABB(&aabb, xf, child);
+                    if (!b2TestOverlap(aabb, bounds)) {
+                        continue;
+                    }
+                    b2RayCastOutput output;
+                    input.maxFraction = best;
+                    if (shape->RayCast(&output, input, xf, child)) {
+                        accept(obj.get(), input.p1+output.fraction*(input.p2-input.p1), output.normal, output.fraction);
+                    }
+                }
+            }
+        }
+    }
+    
+    // Everything else where it is now
+    world->rayCast([&](b2Fixture* fixture, const Vec2 point, const Vec2 normal, float fraction) -> float {
+        physics2::Obstacle* obj = reinterpret_cast<physics2::Obstacle*>(fixture->GetBody()->GetUserData().pointer);
+        if (obj == nullptr || !obj->hasGlobalId() || fixture->IsSensor() || (filter && !filter(obj))) {
+            return -1;
+        } else if (past != nullptr && past->count(obj->getGlobalId())) {
+            return -1; // Tested at its past state
+        }
+        accept(obj, b2Vec2(point.x, point.y), b2Vec2(normal.x, normal.y), fraction);
+        return fraction;
+    }, p1, p2);
+    return found;
+}
+
+#pragma mark -
+#pragma mark Spectators
+/**
+ * Returns the delayed snapshot for the spectators, if one is due.
+ *
+ * The snapshot is the recorded state of the moving shared obstacles at
+ * the given tick (or the latest tick before it) in the rewind history.
+ * So the history must be at least as long as the spectator delay. It is
+ * delta compressed against the previous spectator snapshot, and so must
+ * be sent on an ordered lane to every spectator. There is one snapshot
+ * for all of the spectators, no matter how many there are.
+ *
+ * This method returns nullptr if the history has no state at or before
+ * the given tick, or if that state was already sent.
+ *
+ * @param tick  The (delayed) game tick to show the spectators
+ *
+ * @return the delayed snapshot for the spectators, if one is due.
+ */
+std::shared_ptr<PhysSyncEvent> NetPhysicsController::packSpectatorSync(Uint64 tick) {
+    if (!_isHost || _rewindHistory.empty() || _rewindHistory.front().first > tick) {
+        return nullptr;
+    }
+    
+    // The history is in tick order, so find the last state at or before the tick
+    auto it = std::upper_bound(_rewindHistory.begin(), _rewindHistory.end(), tick,
+                               [](Uint64 value, const std::pair<Uint64,SyncState>& entry) {
+        return value < entry.first;
+    });
+    --it;
+    if (!_spectatorHistory.empty() && it->first <= _spectatorTick) {
+        return nullptr;
+    }
+    
+    // Spectators never acknowledge, so the header has no acks
+    auto event = _syncEventPool->get();
+    event->setBounds(getSyncBounds());
+    event->setPrecision(_precision);
+    event->setSourceUID(_shortUID);
+    
+    std::vector<ObjParam> params;
+    params.reserve(it->second.size());
+    for (auto jt = it->second.begin(); jt != it->second.end(); ++jt) {
+        ObjParam param = jt->second;
+        event->quantize(param);
+        params.push_back(param);
+    }
+    std::vector<bool> resting(params.size(),false);
+    
+    // The lane is ordered, so the last snapshot is always the baseline
+    Uint32 baseline = _spectatorHistory.empty() ? 0 : _spectatorHistory.back().first;
+    packDeltaSync(event, params, resting, _spectatorHistory, baseline, nullptr, ++_spectatorSeq);
+    _spectatorTick = it->first;
+    return event;
+}
+
+#pragma mark -
+#pragma mark Joints
+/**
+ * Returns the root of the given id in a union-find forest
+ *
+ * This compresses the path to the root as it goes.
+ *
+ * @param parent    The parent of each id (missing for a root)
+ * @param id        The id to look up
+ *
+ * @return the root of the given id in a union-find forest
+ */
+static Uint64 find_root(std::unordered_map<Uint64,Uint64>& parent, Uint64 id) {
+    Uint64 root = id;
+    for (auto it = parent.find(root); it != parent.end() && it->second != root; it = parent.find(root)) {
+        root = it->second;
+    }
+    while (id != root) {
+        Uint64& next = parent[id];
+        id = next;
+        next = root;
+    }
+    return root;
+}
+
+/**
+ * Adds a joint between the given bodies to the world, returning the joint
+ *
+ * The joint is created with the fixed fields of the definition, and the
+ * tunable fields are then applied to it.
+ *
+ * @param world The physics world
+ * @param id    The joint id
+ * @param param The joint definition
+ * @param bodyA The first body
+ * @param bodyB The second body
+ *
+ * @return the new joint (or nullptr if the type is not supported)
+ */
+static b2Joint* add_joint(const std::shared_ptr<physics2::ObstacleWorld>& world, Uint64 id,
+                          const JointParam& param, b2Body* bodyA, b2Body* bodyB) {
+    switch (param.type) {
+        case e_revoluteJoint:
+        {
+            b2RevoluteJointDef def;
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = param.collide;
+            def.localAnchorA = param.anchorA;
+            def.localAnchorB = param.anchorB;
+            def.referenceAngle = param.reference;
+            world->addJoint(id, def);
+        }
+            break;
+        case e_prismaticJoint:
+        {
+            b2PrismaticJointDef def;
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = param.collide;
+            def.localAnchorA = param.anchorA;
+            def.localAnchorB = param.anchorB;
+            def.localAxisA = param.axis;
+            def.referenceAngle = param.reference;
+            world->addJoint(id, def);
+        }
+            break;
+        case e_distanceJoint:
+        {
+            b2DistanceJointDef def;
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = param.collide;
+            def.localAnchorA = param.anchorA;
+            def.localAnchorB = param.anchorB;
+            world->addJoint(id, def);
+        }
+            break;
+        case e_weldJoint:
+        {
+            b2WeldJointDef def;
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = param.collide;
+            def.localAnchorA = param.anchorA;
+            def.localAnchorB = param.anchorB;
+            def.referenceAngle = param.reference;
+            world->addJoint(id, def);
+        }
+            break;
+        case e_wheelJoint:
+        {
+            b2WheelJointDef def;
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = param.collide;
+            def.localAnchorA = param.anchorA;
+            def.localAnchorB = param.anchorB;
+            def.localAxisA = param.axis;
+            world->addJoint(id, def);
+        }
+            break;
+        default:
+            return nullptr;
+    }
+    
+    b2Joint* joint = world->getJoint(id).value_or(nullptr);
+    PhysJointEvent::apply(joint, param);
+    return joint;
+}
+
+/**
+ * Adds a shared joint to the physics world, returning its id.
+ *
+ * Both bodies of the joint must belong to shared obstacles with global
+ * ids in the same world. The joint is created on every client with a
+ * {@link PhysJointEvent}. Only revolute, prismatic, distance, weld and
+ * wheel joints can be shared (see {@link PhysJointEvent#isSupported}).
+ *
+ * The tunable parameters of a shared joint (limits, motors and springs)
+ * may be changed directly on the joint. The changes are sent on the next
+ * call to {@link #fixedUpdate}.
+ *
+ * Obstacles connected by shared joints form a group, which is synced as
+ * a single unit with a {@link PhysGroupEvent} instead of with the other
+ * obstacles in FULL_SYNC and PRIO_SYNC snapshots. The root of the group
+ * has its full state, and the other members are relative to the root.
+ * Groups are synced by the owner of the root, and ignore peer views.
+ *
+ * @param def   The joint definition
+ *
+ * @return the id of the joint (or 0 if it could not be shared)
+ */
+Uint64 NetPhysicsController::addSharedJoint(const b2JointDef& def) {
+    if (!PhysJointEvent::isSupported(def.type)) {
+        CULogError("Joints of type %d cannot be shared", (int)def.type);
+        return 0;
+    }
+    
+    physics2::Obstacle* objA = def.bodyA ? reinterpret_cast<physics2::Obstacle*>(def.bodyA->GetUserData().pointer) : nullptr;
+    physics2::Obstacle* objB = def.bodyB ? reinterpret_cast<physics2::Obstacle*>(def.bodyB->GetUserData().pointer) : nullptr;
+    if (objA == nullptr || objB == nullptr || !objA->isShared() || !objB->isShared() ||
+        !objA->hasGlobalId() || !objB->hasGlobalId()) {
+        CULogError("A shared joint must join two shared obstacles");
+        return 0;
+    }
+    const std::shared_ptr<physics2::ObstacleWorld>& world = worldOf(objA->getGlobalId());
+    if (world != worldOf(objB->getGlobalId())) {
+        CULogError("A shared joint must join two obstacles in the same world");
+        return 0;
+    }
+    
+    Uint64 id = world->addJoint(def);
+    JointParam param;
+    if (!PhysJointEvent::capture(world->getJoint(id).value_or(nullptr), param)) {
+        world->removeJoint(id);
+        return 0;
+    }
+    _joints[id] = param;
+    _groupsDirty = true;
+    
+    auto event = _jointEventPool->get();
+    event->initCreation(id, param);
+    _outEvents.push_back(event);
+    return id;
+}
+
+/**
+ * Removes a shared joint from the physics world.
+ *
+ * The joint is removed on every client. Removing a body of the joint
+ * also removes the joint, so there is no need to call this method first.
+ *
+ * @param id    The id of the joint
+ */
+void NetPhysicsController::removeSharedJoint(Uint64 id) {
+    if (_joints.erase(id)) {
+        auto event = _jointEventPool->get();
+        event->initDeletion(id);
+        _outEvents.push_back(event);
+        worldOf(id)->removeJoint(id);
+        _groupsDirty = true;
+    }
+}
+
+/**
+ * Processes a change to a shared joint from a peer.
+ *
+ * This method is called automatically by the NetEventController.
+ */
+void NetPhysicsController::processJointEvent(const std::shared_ptr<PhysJointEvent>& event) {
+    if (event->getSourceId() == "")
+        return; // Ignore joint changes from self.
+    
+    Uint64 id = event->getJointId();
+    const JointParam& param = event->getParam();
+    switch (event->getType()) {
+        case PhysJointEvent::JOINT_CREATION:
+        {
+            if (_joints.count(id)) {
+                return;
+            }
+            const std::shared_ptr<physics2::Obstacle>& objA = findObstacle(param.bodyA);
+            const std::shared_ptr<physics2::Obstacle>& objB = findObstacle(param.bodyB);
+            if (objA == nullptr || objB == nullptr || objA->getBody() == nullptr || objB->getBody() == nullptr ||
+                worldOf(param.bodyA) != worldOf(param.bodyB)) {
+                CULogError("Cannot create joint %llu, as its obstacles are missing", (unsigned long long)id);
+                return;
+            }
+            JointParam actual;
+            if (PhysJointEvent::capture(add_joint(worldOf(param.bodyA), id, param, objA->getBody(), objB->getBody()), actual)) {
+                _joints[id] = actual;
+                _groupsDirty = true;
+            }
+        }
+            break;
+        case PhysJointEvent::JOINT_DELETION:
+            if (_joints.erase(id)) {
+                worldOf(id)->removeJoint(id);
+                _groupsDirty = true;
+            }
+            break;
+        case PhysJointEvent::JOINT_PARAMS:
+        {
+            auto it = _joints.find(id);
+            b2Joint* joint = (it == _joints.end() ? nullptr : worldOf(id)->getJoint(id).value_or(nullptr));
+            if (joint != nullptr) {
+                PhysJointEvent::apply(joint, param);
+                // Record what we applied, so that we do not echo it back
+                PhysJointEvent::capture(joint, it->second);
+            }
+        }
+            break;
+    }
+}
+
+/**
+ * Packs the changes to the shared joints since the last tick.
+ *
+ * A shared joint whose tunable parameters changed sends a JOINT_PARAMS
+ * event. A shared joint that was destroyed with one of its bodies is
+ * forgotten without an event, as every client destroys it with the body.
+ */
+void NetPhysicsController::packJoints() {
+    for (auto it = _joints.begin(); it != _joints.end(); ) {
+        // Check the bodies first, as the joint may have been destroyed with them
+        b2Joint* joint = nullptr;
+        if (findObstacle(it->second.bodyA) != nullptr && findObstacle(it->second.bodyB) != nullptr) {
+            joint = worldOf(it->first)->getJoint(it->first).value_or(nullptr);
+        }
+        
+        JointParam param;
+        if (!PhysJointEvent::capture(joint, param)) {
+            it = _joints.erase(it);
+            _groupsDirty = true;
+            continue;
+        }
+        if (PhysJointEvent::changed(param, it->second)) {
+            auto event = _jointEventPool->get();
+            event->initParams(it->first, param);
+            _outEvents.push_back(event);
+            it->second = param;
+        }
+        ++it;
+    }
+}
+
+/**
+ * Rebuilds the groups of jointed obstacles from the shared joints.
+ *
+ * A group is the set of obstacles connected by shared joints. Joints to
+ * static obstacles do not join groups, as otherwise everything pinned to
+ * the ground would be a single group. The root of a group is the member
+ * with the smallest id, so every client agrees on it.
+ */
+void NetPhysicsController::rebuildGroups() {
+    _groupOf.clear();
+    _groups.clear();
+    _groupsDirty = false;
+    
+    std::unordered_map<Uint64,Uint64> parent;
+    for (auto it = _joints.begin(); it != _joints.end(); ++it) {
+        const std::shared_ptr<physics2::Obstacle>& objA = findObstacle(it->second.bodyA);
+        const std::shared_ptr<physics2::Obstacle>& objB = findObstacle(it->second.bodyB);
+        if (objA == nullptr || objB == nullptr ||
+            objA->getBodyType() == b2_staticBody || objB->getBodyType() == b2_staticBody) {
+            continue;
+        }
+        Uint64 rootA = find_root(parent, it->second.bodyA);
+        Uint64 rootB = find_root(parent, it->second.bodyB);
+        parent.emplace(rootA, rootA);
+        parent.emplace(rootB, rootB);
+        if (rootA < rootB) {
+            parent[rootB] = rootA;
+        } else if (rootB < rootA) {
+            parent[rootA] = rootB;
+        }
+    }
+    
+    for (auto it = parent.begin(); it != parent.end(); ++it) {
+        Uint64 root = find_root(parent, it->first);
+        _groupOf[it->first] = root;
+        _groups[root].push_back(it->first);
+    }
+    for (auto it = _groups.begin(); it != _groups.end(); ++it) {
+        std::sort(it->second.begin(), it->second.end());
+    }
+}
+
+/**
+ * Adds the given group to a group snapshot.
+ *
+ * @param event The group snapshot
+ * @param root  The global id of the root of the group
+ */
+void NetPhysicsController::packGroup(const std::shared_ptr<PhysGroupEvent>& event, Uint64 root) {
+    auto it = _groups.find(root);
+    const std::shared_ptr<physics2::Obstacle>& obj = findObstacle(root);
+    if (it == _groups.end() || obj == nullptr) {
+        return;
+    }
+    
+    std::vector<ObjParam> members;
+    members.reserve(it->second.size());
+    for (auto jt = it->second.begin(); jt != it->second.end(); ++jt) {
+        const std::shared_ptr<physics2::Obstacle>& member = findObstacle(*jt);
+        if (*jt != root && member != nullptr) {
+            members.push_back(PhysSyncEvent::snapshot(member, *jt));
+        }
+    }
+    event->addGroup(PhysSyncEvent::snapshot(obj, root), members);
+}
+
+/**
+ * Processes a snapshot of groups of jointed obstacles from a peer.
+ *
+ * This method is called automatically by the NetEventController.
+ */
+void NetPhysicsController::processGroupEvent(const std::shared_ptr<PhysGroupEvent>& event) {
+    if (event->getSourceId() == "")
+        return; // Ignore physic syncs from self.
+    
+    Uint64 stamp = event->getEventTimeStamp();
+    for (auto it = event->getGroups().begin(); it != event->getGroups().end(); ++it) {
+        const std::shared_ptr<physics2::Obstacle>& root = findObstacle(it->root.objId);
+        if (root != nullptr) {
+            steerObstacle(root, it->root, stamp);
+        }
+        for (auto jt = it->members.begin(); jt != it->members.end(); ++jt) {
+            const std::shared_ptr<physics2::Obstacle>& obj = findObstacle(jt->objId);
+            if (obj != nullptr) {
+                steerObstacle(obj, *jt, stamp);
+            }
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Late Join
+
+/**
+ * Starts sending the world to a client that joined a game in progress.
+ *
+ * This replaces an OVERRIDE_FULL_SYNC followed by a creation event for
+ * every obstacle made by a factory, which is one large burst for every
+ * client. Instead, the shared obstacles are streamed to the new client in
+ * {@link PhysWorldEvent} chunks on the bulk lane. Each chunk has the state
+ * of its obstacles, and the factory parameters of those made by a factory.
+ *
+ * The obstacles in the given view (typically the area around the spawn
+ * point of the new client) are sent first, nearest first, all in the next
+ * tick. The client can start to simulate once they arrive (see
+ * {@link #setWorldFunc}). The rest of the world follows, also nearest
+ * first, at the transfer rate (see {@link #setWorldTransferRate}).
+ *
+ * Only the host can send the world. Sending it again to the same client
+ * starts the transfer over.
+ *
+ * @param uuid  The UUID of the new client
+ * @param view  The region to send first, in physics coordinates
+ */
+void NetPhysicsController::sendWorld(const std::string& uuid, const Rect& view) {
+    if (!_isHost) {
+        return;
+    }
+    
+    std::unordered_set<Uint64> interest;
+    queryInterest(view, nullptr, interest);
+    
+    Vec2 center = view.origin+view.size/2;
+    std::vector<std::pair<float,Uint64>> nearby;
+    std::vector<std::pair<float,Uint64>> distant;
+    for (auto wt = _worlds.begin(); wt != _worlds.end(); ++wt) {
+        for (auto it = (*wt)->getObstacles().begin(); it != (*wt)->getObstacles().end(); ++it) {
+            auto& obj = (*it);
+            if (obj->isShared() && obj->hasGlobalId()) {
+                Uint64 id = obj->getGlobalId();
+                float dist = (obj->getPosition()-center).lengthSquared();
+                (interest.count(id) ? nearby : distant).push_back(std::make_pair(dist,id));
+            }
+        }
+    }
+    std::sort(nearby.begin(), nearby.end());
+    std::sort(distant.begin(), distant.end());
+    
+    WorldTransfer& transfer = _transfers[uuid];
+    transfer.pending.clear();
+    transfer.pending.reserve(nearby.size()+distant.size());
+    for (auto it = nearby.begin(); it != nearby.end(); ++it) {
+        transfer.pending.push_back(it->second);
+    }
+    for (auto it = distant.begin(); it != distant.end(); ++it) {
+        transfer.pending.push_back(it->second);
+    }
+    transfer.next = 0;
+    transfer.near = nearby.size();
+    transfer.chunk = 0;
+    transfer.sentNear = false;
+}
+
+/**
+ * Packs the world transfer chunks due this tick.
+ *
+ * Only the host sends chunks. They are added to the out events. This
+ * method is called automatically by the {@link NetEventController} each
+ * tick.
+ */
+void NetPhysicsController::packWorldTransfer() {
+    if (!_isHost) {
+        _transfers.clear();
+        return;
+    }
+    for (auto it = _transfers.begin(); it != _transfers.end(); ) {
+        if (packWorldChunks(it->first, it->second)) {
+            it = _transfers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * Packs the chunks of a world transfer due this tick.
+ *
+ * The whole near region is packed at once. After that, chunks are packed
+ * until they exceed the transfer rate. This method returns true once the
+ * last chunk has been packed.
+ *
+ * @param uuid      The UUID of the recipient
+ * @param transfer  The world transfer to the recipient
+ *
+ * @return true once the last chunk has been packed
+ */
+bool NetPhysicsController::packWorldChunks(const std::string& uuid, WorldTransfer& transfer) {
+    size_t spent = 0;
+    size_t total = transfer.pending.size();
+    while (transfer.chunk == 0 || transfer.next < total) {
+        bool near = transfer.next < transfer.near;
+        if (!near && _transferRate > 0 && spent >= _transferRate) {
+            break;
+        }
+        
+        auto event = _worldEventPool->get();
+        event->init(transfer.chunk++);
+        event->setDestinationId(uuid);
+        
+        // Chunks never mix the near region with the rest
+        size_t limit = near ? transfer.near : total;
+        size_t size  = WORLD_HEADER_BYTES;
+        while (transfer.next < limit && size < WORLD_CHUNK_BYTES) {
+            Uint64 id = transfer.pending[transfer.next++];
+            const std::shared_ptr<physics2::Obstacle>& obj = findObstacle(id);
+            if (obj == nullptr) {
+                continue; // Removed since the transfer started
+            }
+            
+            ObjParam state = PhysSyncEvent::snapshot(obj, id);
+            auto jt = _factoryMade.find(id);
+            if (jt == _factoryMade.end()) {
+                event->addEntry(state, WORLD_NO_FACTORY, nullptr);
+                size += WORLD_ENTRY_BYTES;
+            } else {
+                event->addEntry(state, jt->second.first, jt->second.second);
+                size += WORLD_ENTRY_BYTES+jt->second.second->size();
+            }
+        }
+        
+        if (!transfer.sentNear && transfer.next >= transfer.near) {
+            event->setNear(true);
+            transfer.sentNear = true;
+        }
+        event->setFinal(transfer.next >= total);
+        _outEvents.push_back(event);
+        spent += size;
+    }
+    return transfer.next >= total;
+}
+
+/**
+ * Processes a chunk of a world transfer from the host.
+ *
+ * Any obstacle this client does not have is made with its factory, and
+ * every obstacle is moved to its state in the chunk. Obstacles that are
+ * neither known nor made by a factory are ignored.
+ */
+void NetPhysicsController::processWorldEvent(const std::shared_ptr<PhysWorldEvent>& event) {
+    if (_isHost || event->getSourceId() == "") {
+        return;
+    }
+    if (event->getChunk() == 0) {
+        _transferState = TRANSFER_LOADING;
+        _transferRemoved.clear();
+    } else if (_transferState == TRANSFER_NONE || _transferState == TRANSFER_COMPLETE) {
+        return; // The start of this transfer was lost
+    }
+    
+    const std::vector<PhysWorldEvent::Entry>& entries = event->getEntries();
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        Uint64 id = it->state.objId;
+        if (_transferRemoved.count(id)) {
+            continue;
+        }
+        
+        std::shared_ptr<physics2::Obstacle> obj = findObstacle(id);
+        if (obj == nullptr) {
+            if (it->factory == WORLD_NO_FACTORY) {
+                continue;
+            } else if (it->factory >= _obstacleFacts.size()) {
+                CULogError("Unknown object Factory %u", it->factory);
+                continue;
+            }
+            auto pair = _obstacleFacts[it->factory]->createObstacle(*(it->params));
+            worldOf(id)->addObstacle(pair.first, id);
+            if (_linkSceneToObsFunc) {
+                _linkSceneToObsFunc(pair.first, pair.second);
+                _sharedObsToNodeMap.insert(std::make_pair(pair.first, pair.second));
+            }
+            obj = pair.first;
+        }
+        if (it->factory != WORLD_NO_FACTORY) {
+            _factoryMade[id] = std::make_pair(it->factory,it->params);
+        }
+        
+        // The state is authoritative, so skip any smoothing
+        removeInterpolation(obj);
+        _entityBuffers.erase(id);
+        applyState(obj, it->state);
+    }
+    
+    if (event->isNear() && _transferState == TRANSFER_LOADING) {
+        _transferState = TRANSFER_NEAR;
+        if (_worldFunc) {
+            _worldFunc(false);
+        }
+    }
+    if (event->isFinal()) {
+        _transferState = TRANSFER_COMPLETE;
+        _transferRemoved.clear();
+        if (_worldFunc) {
+            _worldFunc(true);
+        }
+    }
 }
@@ -256,7 +256,9 @@ void ComplexObstacle::update(float dt) {
         createFixtures();
     }
     
-    updateDebug();
+    if (checkTransformDirty()) {
+        updateDebug();
+    }
     // Update the children
     for(auto it = _bodies.begin(); it!= _bodies.end(); ++it) {
         (*it)->update(dt);
@@ -64,8 +64,27 @@ Obstacle::Obstacle() :
 _scene(nullptr),
 _debug(nullptr),
 _listener(nullptr),
-_body(nullptr) {
+_body(nullptr),
+_shared(false),
+_globalId(OBSTACLE_NO_ID),
+_owned(false),
+_ownedSteps(0),
+_syncPriority(0),
+_syncWeight(1),
+_interpolation(0),
+_prevAngle(0),
+_renderAlpha(1),
+_transformDirty(true),
+_wireFixture(nullptr),
+_dirtyList(nullptr),
+_inDirtyList(false),
+_worldIndex(0),
+_pool(OBSTACLE_NO_POOL),
+_parked(false),
+_parkedVelocity(0,0),
+_parkedSpin(0) {
     _posSnap = _angSnap = -1;
+    clearSharingDirtyBits();
 }
 
 /**
@@ -150,7 +169,7 @@ void Obstacle::setDensity(float value) {
             _body->ResetMassData();
         }
     }
-    if(_shared){ _isFloatConstDirty = true; };
+    if(_shared){ _isFloatConstDirty = true; markSharingDirty(); };
 }
 
 /**
@@ -171,7 +190,7 @@ void Obstacle::setFriction(float value) {
             f->SetFriction(value);
         }
     }
-    if(_shared){ _isFloatConstDirty = true; };
+    if(_shared){ _isFloatConstDirty = true; markSharingDirty(); };
 }
 
 /**
@@ -192,7 +211,7 @@ void Obstacle::setRestitution(float value) {
             f->SetRestitution(value);
         }
     }
-    if(_shared){ _isFloatConstDirty = true; };
+    if(_shared){ _isFloatConstDirty = true; markSharingDirty(); };
 }
 
 /**
@@ -211,7 +230,7 @@ void Obstacle::setSensor(bool value) {
             f->SetSensor(value);
         }
     }
-    if(_shared){ _isBoolConstDirty = true; };
+    if(_shared){ _isBoolConstDirty = true; markSharingDirty(); };
 }
 
 /**
@@ -257,7 +276,7 @@ void Obstacle::setCentroid(float x, float y) {
     if (_body != nullptr) {
         _body->SetMassData(&_massdata); // Protected accessor?
     }
-    if(_shared){ _isFloatConstDirty = true; };
+    if(_shared){ _isFloatConstDirty = true; markSharingDirty(); };
 }
 
 /**
@@ -278,7 +297,7 @@ void Obstacle::setInertia(float value) {
     if (_body != nullptr) {
         _body->SetMassData(&_massdata); // Protected accessor?
     }
-    if(_shared){ _isFloatConstDirty = true; };
+    if(_shared){ _isFloatConstDirty = true; markSharingDirty(); };
 }
 
 /**
@@ -342,8 +361,16 @@ void Obstacle::deactivatePhysics(b2World& world) {
         releaseFixtures(); // Have to remove these first.
         // Snapshot the values
         setBodyState(*_body);
+        if (_parked) {
+            // Do not lose the motion of a body put to sleep by the world
+            _bodyinfo.awake = true;
+            _bodyinfo.linearVelocity = _parkedVelocity;
+            _bodyinfo.angularVelocity = _parkedSpin;
+            _parked = false;
+        }
         world.DestroyBody(_body);
         _body = nullptr;
+        _wireMesh = nullptr;
         _bodyinfo.enabled = false;
     }
 }
@@ -403,8 +430,8 @@ void Obstacle::setDebugScene(const std::shared_ptr<scene2::SceneNode>& node) {
  */
 void Obstacle::updateDebug() {
     CUAssertLog(_scene, "Attempt to reposition a wireframe with no parent");
-    Vec2 pos = getPosition();
-    float angle = getAngle();
+    Vec2 pos = getRenderPosition();
+    float angle = getRenderAngle();
     
     // Positional snap
     if (_posSnap >= 0) {
@@ -0,0 +1,361 @@
+//
+//  CUObstacleWireBatch.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a batched alternative to the debug wireframes of the
+//  obstacles. The wireframe of each distinct shape is built once, as a line
+//  mesh in body coordinates, and shared by every obstacle with that shape.
+//  Each frame, the meshes are drawn to a SpriteBatch with the transform of
+//  their obstacle. So the debug view of a large level costs one batch of lines,
+//  instead of a scene graph node (and a draw call) per obstacle.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/physics2/CUObstacleWireBatch.h>
+#include <cugl/physics2/CUObstacle.h>
+#include <cugl/physics2/CUObstacleWorld.h>
+#include <cugl/render/CUSpriteBatch.h>
+#include <cugl/util/CUDebug.h>
+#include <box2d/b2_circle_shape.h>
+#include <box2d/b2_polygon_shape.h>
+#include <box2d/b2_edge_shape.h>
+#include <box2d/b2_chain_shape.h>
+
+using namespace cugl;
+using namespace cugl::physics2;
+
+/**
+ * Appends the bytes of the given value to the key
+ *
+ * @param key   The key to extend
+ * @param value The value to append
+ */
+template <typename T>
+static void append_key(std::string& key, const T& value) {
+    key.append(reinterpret_cast<const char*>(&value),sizeof(T));
+}
+
+/**
+ * Appends a line between the given points to the mesh
+ *
+ * @param mesh  The mesh to extend
+ * @param a     The start of the line
+ * @param b     The end of the line
+ * @param color The packed vertex color
+ */
+static void append_line(Mesh<SpriteVertex2>& mesh, const b2Vec2& a, const b2Vec2& b, GLuint color) {
+    GLuint start = (GLuint)mesh.vertices.size();
+    SpriteVertex2 vert;
+    vert.color = color;
+    vert.position = Vec2(a.x,a.y);
+    mesh.vertices.push_back(vert);
+    vert.position = Vec2(b.x,b.y);
+    mesh.vertices.push_back(vert);
+    mesh.indices.push_back(start);
+    mesh.indices.push_back(start+1);
+}
+
+/**
+ * Appends a closed loop through the given points to the mesh
+ *
+ * @param mesh      The mesh to extend
+ * @param points    The points of the loop
+ * @param count     The number of points
+ * @param color     The packed vertex color
+ */
+static void append_loop(Mesh<SpriteVertex2>& mesh, const b2Vec2* points, size_t count, GLuint color) {
+    GLuint start = (GLuint)mesh.vertices.size();
+    SpriteVertex2 vert;
+    vert.color = color;
+    for(size_t ii = 0; ii < count; ii++) {
+        vert.position = Vec2(points[ii].x,points[ii].y);
+        mesh.vertices.push_back(vert);
+        mesh.indices.push_back(start+(GLuint)ii);
+        mesh.indices.push_back(start+(GLuint)((ii+1) % count));
+    }
+}
+
+#pragma mark Constructors
+/**
+ * Disposes all of the resources used by this wire batch.
+ *
+ * Meshes still held by obstacles are not deleted until the obstacles let
+ * go of them. A disposed wire batch can be safely reinitialized.
+ */
+void ObstacleWireBatch::dispose() {
+    _cache.clear();
+    _segments = 0;
+    _builds = 0;
+}
+
+/**
+ * Initializes a wire batch with the given circle resolution.
+ *
+ * Circles (and the rounded ends of capsules) are outlined as regular
+ * polygons with the given number of segments.
+ *
+ * @param segments  The number of segments in the wireframe of a circle
+ *
+ * @return true if the wire batch is initialized properly, false otherwise.
+ */
+bool ObstacleWireBatch::init(Uint32 segments) {
+    if (_segments) {
+        CUAssertLog(false, "Wire batch is already initialized");
+        return false;
+    }
+    _segments = SDL_max(segments,3);
+    return true;
+}
+
+#pragma mark Meshes
+/**
+ * Returns the key of the fixture geometry of the given obstacle.
+ *
+ * Obstacles with the same key have identical fixtures, and so share the
+ * same wireframe.
+ *
+ * @param obj   The obstacle with the fixtures
+ *
+ * @return the key of the fixture geometry of the given obstacle.
+ */
+std::string ObstacleWireBatch::makeKey(const Obstacle* obj) {
+    std::string key;
+    for(const b2Fixture* fix = obj->_body->GetFixtureList(); fix; fix = fix->GetNext()) {
+        const b2Shape* shape = fix->GetShape();
+        append_key(key,(Uint8)shape->GetType());
+        append_key(key,shape->m_radius);
+        switch (shape->GetType()) {
+            case b2Shape::e_circle:
+                append_key(key,static_cast<const b2CircleShape*>(shape)->m_p);
+                break;
+            case b2Shape::e_polygon:
+            {
+                auto poly = static_cast<const b2PolygonShape*>(shape);
+                append_key(key,poly->m_count);
+                key.append(reinterpret_cast<const char*>(poly->m_vertices),poly->m_count*sizeof(b2Vec2));
+            }
+                break;
+            case b2Shape::e_edge:
+            {
+                auto edge = static_cast<const b2EdgeShape*>(shape);
+                append_key(key,edge->m_vertex1);
+                append_key(key,edge->m_vertex2);
+            }
+                break;
+            case b2Shape::e_chain:
+            {
+                auto chain = static_cast<const b2ChainShape*>(shape);
+                append_key(key,chain->m_count);
+                key.append(reinterpret_cast<const char*>(chain->m_vertices),chain->m_count*sizeof(b2Vec2));
+            }
+                break;
+            default:
+                break;
+        }
+    }
+    return key;
+}
+
+/**
+ * Stores the wireframe of the fixtures of the given obstacle in the mesh.
+ *
+ * The mesh is a set of lines in the coordinates of the body.
+ *
+ * @param obj   The obstacle with the fixtures
+ * @param mesh  The mesh to store the wireframe
+ */
+void ObstacleWireBatch::buildMesh(const Obstacle* obj, Mesh<SpriteVertex2>& mesh) const {
+    mesh.command = GL_LINES;
+    GLuint color = Color4::WHITE.getPacked();
+    std::vector<b2Vec2> points;
+    for(const b2Fixture* fix = obj->_body->GetFixtureList(); fix; fix = fix->GetNext()) {
+        const b2Shape* shape = fix->GetShape();
+        switch (shape->GetType()) {
+            case b2Shape::e_circle:
+            {
+                auto circle = static_cast<const b2CircleShape*>(shape);
+                points.resize(_segments);
+                for(Uint32 ii = 0; ii < _segments; ii++) {
+                    float angle = (float)(2*M_PI*ii/_segments);
+                    points[ii] = circle->m_p+circle->m_radius*b2Vec2(cosf(angle),sinf(angle));
+                }
+                append_loop(mesh,points.data(),points.size(),color);
+            }
+                break;
+            case b2Shape::e_polygon:
+            {
+                auto poly = static_cast<const b2PolygonShape*>(shape);
+                append_loop(mesh,poly->m_vertices,poly->m_count,color);
+            }
+                break;
+            case b2Shape::e_edge:
+            {
+                auto edge = static_cast<const b2EdgeShape*>(shape);
+                append_line(mesh,edge->m_vertex1,edge->m_vertex2,color);
+            }
+                break;
+            case b2Shape::e_chain:
+            {
+                // A loop repeats its first vertex at the end
+                auto chain = static_cast<const b2ChainShape*>(shape);
+                for(int ii = 1; ii < chain->m_count; ii++) {
+                    append_line(mesh,chain->m_vertices[ii-1],chain->m_vertices[ii],color);
+                }
+            }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * Returns the wireframe of the given obstacle.
+ *
+ * The wireframe is cached in the obstacle, and is only rebuilt when its
+ * shape changes. This method returns nullptr if the obstacle has no body.
+ *
+ * @param obj   The obstacle to outline
+ *
+ * @return the wireframe of the given obstacle.
+ */
+std::shared_ptr<const Mesh<SpriteVertex2>> ObstacleWireBatch::acquire(Obstacle* obj) {
+    if (obj->_body == nullptr) {
+        return nullptr;
+    }
+    b2Fixture* first = obj->_body->GetFixtureList();
+    if (obj->_wireMesh != nullptr && obj->_wireFixture == first) {
+        return obj->_wireMesh;
+    }
+
+    std::string key = makeKey(obj);
+    auto it = _cache.find(key);
+    std::shared_ptr<const Mesh<SpriteVertex2>> result;
+    if (it != _cache.end()) {
+        result = it->second.lock();
+    }
+    if (result == nullptr) {
+        auto mesh = std::make_shared<Mesh<SpriteVertex2>>();
+        buildMesh(obj,*mesh);
+        result = mesh;
+        _builds++;
+
+        // Building is rare, so this is a good time to drop unused shapes
+        for(auto jt = _cache.begin(); jt != _cache.end(); ) {
+            if (jt->second.expired()) {
+                jt = _cache.erase(jt);
+            } else {
+                ++jt;
+            }
+        }
+        _cache[key] = result;
+    }
+
+    // Fixtures waiting to be rebuilt are not cached in the obstacle
+    if (!obj->isDirty()) {
+        obj->_wireMesh = result;
+        obj->_wireFixture = first;
+    }
+    return result;
+}
+
+#pragma mark Drawing
+/**
+ * Draws the wireframe of the given obstacle to the sprite batch.
+ *
+ * The wireframe is drawn with the render transform of the obstacle, followed
+ * by the given transform (typically the drawing scale of the world). It is
+ * tinted by the debug color of the obstacle. The sprite batch must be active,
+ * and should have no texture.
+ *
+ * @param batch     The sprite batch to draw to
+ * @param obj       The obstacle to outline
+ * @param transform The transform from physics to screen coordinates
+ */
+void ObstacleWireBatch::draw(const std::shared_ptr<SpriteBatch>& batch, Obstacle* obj,
+                             const Affine2& transform) {
+    std::shared_ptr<const Mesh<SpriteVertex2>> mesh = acquire(obj);
+    if (mesh == nullptr || mesh->vertices.empty()) {
+        return;
+    }
+
+    Affine2 xform;
+    xform.rotate(obj->getRenderAngle());
+    xform.translate(obj->getRenderPosition());
+    xform *= transform;
+    batch->setColor(obj->getDebugColor());
+    batch->drawMesh(*mesh,xform);
+}
+
+/**
+ * Draws the wireframes of every obstacle in the world to the sprite batch.
+ *
+ * Each wireframe is drawn with the render transform of its obstacle,
+ * followed by the given transform (typically the drawing scale of the
+ * world). It is tinted by the debug color of the obstacle. The sprite batch
+ * must be active, and should have no texture. The color of the sprite batch
+ * is restored afterwards.
+ *
+ * @param batch     The sprite batch to draw to
+ * @param world     The world with the obstacles to outline
+ * @param transform The transform from physics to screen coordinates
+ */
+void ObstacleWireBatch::draw(const std::shared_ptr<SpriteBatch>& batch, const ObstacleWorld& world,
+                             const Affine2& transform) {
+    Color4 color = batch->getColor();
+    const auto& objs = world.getObstacles();
+    for(auto it = objs.begin(); it != objs.end(); ++it) {
+        draw(batch,it->get(),transform);
+    }
+    batch->setColor(color);
+}
+
+#pragma mark Statistics
+/**
+ * Returns the number of distinct wireframes still in use.
+ *
+ * This is the number of distinct fixture geometries among the obstacles
+ * drawn by this batch (that still exist).
+ *
+ * @return the number of distinct wireframes still in use.
+ */
+size_t ObstacleWireBatch::getCacheSize() const {
+    size_t result = 0;
+    for(auto it = _cache.begin(); it != _cache.end(); ++it) {
+        if (!it->second.expired()) {
+            result++;
+        }
+    }
+    return result;
+}
@@ -46,8 +46,17 @@
 #include <box2d/b2_world.h>
 #include <box2d/b2_contact.h>
 #include <box2d/b2_collision.h>
+#include <box2d/b2_fixture.h>
 #include <cugl/physics2/CUObstacleWorld.h>
 #include <cugl/physics2/CUObstacle.h>
+#include <cugl/util/CUThreadPool.h>
+#include <cugl/util/CUTimestamp.h>
+#include <cugl/util/CUProfiler.h>
+#include <condition_variable>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <mutex>
 
 using namespace cugl;
 using namespace cugl::physics2;
@@ -56,6 +65,39 @@ using namespace cugl::physics2;
 
 /** The default value of gravity (going down) */
 #define DEFAULT_GRAVITY -9.8f
+/** The FNV-1a offset basis for the world checksum */
+#define CHECKSUM_BASIS  0xcbf29ce484222325ULL
+/** The FNV-1a prime for the world checksum */
+#define CHECKSUM_PRIME  0x100000001b3ULL
+/** The default maximum number of fixed steps in a single update */
+#define DEFAULT_MAX_SUBSTEPS 5
+/** The default minimum number of obstacles in a single parallel task */
+#define DEFAULT_PARALLEL_GRAIN 256
+/** The minimum number of queries in a single parallel task */
+#define QUERY_PARALLEL_GRAIN   32
+/** The number of updates in the rolling averages of the profiler */
+#define PROFILE_WINDOW  60
+/** The default distance a body may leave every area of interest before it is parked */
+#define DEFAULT_LOD_MARGIN   2.0f
+/** The default number of updates between level of detail passes */
+#define DEFAULT_LOD_INTERVAL 10
+
+/**
+ * Adds the Box2D timings of a step to the given total
+ *
+ * @param total The timings to add to
+ * @param step  The timings of the step
+ */
+static void add_profile(b2Profile& total, const b2Profile& step) {
+    total.step  += step.step;
+    total.collide += step.collide;
+    total.solve += step.solve;
+    total.solveInit += step.solveInit;
+    total.solveVelocity += step.solveVelocity;
+    total.solvePosition += step.solvePosition;
+    total.broadphase += step.broadphase;
+    total.solveTOI += step.solveTOI;
+}
 
 #pragma mark -
 #pragma mark Proxy Classes
@@ -152,6 +194,104 @@ public:
     }
 };
 
+/**
+ * A lightweight b2RayCastCallback that records the closest hit.
+ *
+ * This class has no closure, so that batches of ray casts do not allocate.
+ */
+class ClosestRayProxy : public b2RayCastCallback {
+public:
+    /** The hit to record */
+    RayHit* hit;
+    
+    /**
+     * Creates a proxy recording to the given hit
+     *
+     * @param hit   The hit to record
+     */
+    ClosestRayProxy(RayHit* hit) : hit(hit) {}
+    
+    /**
+     * Records the hit and clips the ray to it.
+     *
+     * @param  fixture  the fixture hit by the ray
+     * @param  point    the point of initial intersection
+     * @param  normal   the normal vector at the point of intersection
+     * @param  fraction the fraction to return
+     *
+     * @return the fraction to clip the ray
+     */
+    float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override {
+        hit->fixture = fixture;
+        hit->point.set(point.x,point.y);
+        hit->normal.set(normal.x,normal.y);
+        hit->fraction = fraction;
+        return fraction;
+    }
+};
+
+/**
+ * A lightweight b2QueryCallback that collects fixtures into an array.
+ *
+ * This class has no closure, so that batches of queries do not allocate.
+ */
+class CollectProxy : public b2QueryCallback {
+public:
+    /** The array to store the fixtures */
+    b2Fixture** fixtures;
+    /** The capacity of the array */
+    size_t capacity;
+    /** The number of fixtures stored */
+    size_t size;
+    
+    /**
+     * Creates a proxy collecting into the given array
+     *
+     * @param fixtures  The array to store the fixtures
+     * @param capacity  The capacity of the array
+     */
+    CollectProxy(b2Fixture** fixtures, size_t capacity) :
+    fixtures(fixtures), capacity(capacity), size(0) {}
+    
+    /**
+     * Returns false to terminate the query once the array is full
+     *
+     * @param  fixture  the fixture selected
+     *
+     * @return false to terminate the query once the array is full
+     */
+    bool ReportFixture(b2Fixture* fixture) override {
+        if (size < capacity) {
+            fixtures[size++] = fixture;
+        }
+        return size < capacity;
+    }
+};
+
+/**
+ * Runs the given loop body over a range, in parallel if possible.
+ *
+ * The range is split into chunks of the given grain size, and the body is
+ * called with the start and end of each chunk. If there is no thread pool,
+ * or the range is no bigger than a chunk, the body is called once on the
+ * whole range. Otherwise the chunks are shared between the pool and the
+ * calling thread. Either way, this function does not return until the body
+ * has been called on the whole range.
+ *
+ * @param pool  The thread pool (may be nullptr)
+ * @param size  The size of the range
+ * @param grain The size of a chunk
+ * @param body  The loop body, called with the start and end of each chunk
+ */
+static void parallel_for(const std::shared_ptr<ThreadPool>& pool, size_t size, size_t grain,
+                         const std::function<void(size_t,size_t)>& body) {
+    if (pool == nullptr || pool->isStopped() || size <= grain) {
+        body(0,size);
+        return;
+    }
+    pool->parallelFor(size,grain,body);
+}
+
 
 #pragma mark -
 #pragma mark Constructors
@@ -171,10 +311,28 @@ _destroy(false)
     _stepssize  = DEFAULT_WORLD_STEP;
     _itvelocity = DEFAULT_WORLD_VELOC;
     _itposition = DEFAULT_WORLD_POSIT;
+    _deterministic = false;
+    _accumulating = false;
+    _accumulator = 0;
+    _maxSubsteps = DEFAULT_MAX_SUBSTEPS;
+    _substeps = 0;
+    _alpha = 1;
+    _workers = nullptr;
+    _grain = DEFAULT_PARALLEL_GRAIN;
+    _parallel = false;
+    _contactHead = 0;
+    _contactSize = 0;
+    _contactDropped = 0;
     _gravity = Vec2(0,DEFAULT_GRAVITY);
+    _shortUID = 0;
+    _shard = 0;
     _nextObj = 0;
     _nextInitObj = 0;
     _nextJoint = 0;
+    _lodMargin = DEFAULT_LOD_MARGIN;
+    _lodInterval = DEFAULT_LOD_INTERVAL;
+    _lodCounter = 0;
+    _lodParked = 0;
     
     onBeginContact = nullptr;
     onEndContact   = nullptr;
@@ -263,6 +421,34 @@ bool ObstacleWorld::init(const Rect bounds, const Vec2 gravity, std::string UUID
 
 #pragma mark -
 #pragma mark Object Management
+/**
+ * Returns true if the obstacle is ordered after the given id
+ *
+ * This is the order of the obstacles in deterministic mode.
+ *
+ * @param id    The global obstacle id
+ * @param obj   The obstacle to compare
+ *
+ * @return true if the obstacle is ordered after the given id
+ */
+static bool obstacle_after(Uint64 id, const std::shared_ptr<Obstacle>& obj) {
+    return id < obj->getGlobalId();
+}
+
+/**
+ * Returns true if the first obstacle is ordered before the second
+ *
+ * This is the order of the obstacles in deterministic mode.
+ *
+ * @param a The first obstacle
+ * @param b The second obstacle
+ *
+ * @return true if the first obstacle is ordered before the second
+ */
+static bool obstacle_before(const std::shared_ptr<Obstacle>& a, const std::shared_ptr<Obstacle>& b) {
+    return a->getGlobalId() < b->getGlobalId();
+}
+
 /**
  * Immediately adds the obstacle to the physics world
  *
@@ -277,29 +463,198 @@ bool ObstacleWorld::init(const Rect bounds, const Vec2 gravity, std::string UUID
  * param obj The obstacle to add
  */
 void ObstacleWorld::addObstacle(const std::shared_ptr<Obstacle>& obj, Uint64 id) {
+    CUAssertLog(!_parallel, "Cannot add an obstacle during a parallel update");
     CUAssertLog(inBounds(obj.get()), "Obstacle is not in bounds");
-    CUAssertLog(!_idToObj.count(id), "Duplicate Obstacle ids are not allowed");
-    _objects.push_back(obj);
+    CUAssertLog(!hasObstacle(id), "Duplicate Obstacle ids are not allowed");
+    if (_deterministic) {
+        auto pos = std::upper_bound(_objects.begin(), _objects.end(), id, obstacle_after);
+        reindex(_objects.insert(pos, obj)-_objects.begin());
+    } else {
+        obj->_worldIndex = _objects.size();
+        _objects.push_back(obj);
+    }
     obj->activatePhysics(*_world);
-    _idToObj.insert(std::make_pair(id, obj));
-    _objToId.insert(std::make_pair(obj, id));
+    obj->snapshot();
+    obj->_renderAlpha = _alpha;
+    obj->_dirtyList = &_dirtyObjects;
+    if (obj->isSharingDirty()) {
+        obj->markSharingDirty();
+    }
+    claimSlot(obj, id);
+}
+
+/**
+ * Assigns the id slot of the given obstacle.
+ *
+ * After this method, the obstacle may be looked up by the given id.
+ *
+ * @param obj   The obstacle to assign
+ * @param id    The global obstacle id
+ */
+void ObstacleWorld::claimSlot(const std::shared_ptr<Obstacle>& obj, Uint64 id) {
+    obj->setGlobalId(id);
+    Uint32 space = (Uint32)(id >> 32);
+    size_t index = (size_t)(id & 0xFFFFFFFF);
+    std::vector<std::shared_ptr<Obstacle>>* slots = nullptr;
+    for (auto it = _slots.begin(); slots == nullptr && it != _slots.end(); ++it) {
+        if (it->first == space) {
+            slots = &(it->second);
+        }
+    }
+    if (slots == nullptr) {
+        _slots.push_back(std::make_pair(space, std::vector<std::shared_ptr<Obstacle>>()));
+        slots = &(_slots.back().second);
+    }
+    if (slots->size() <= index) {
+        slots->resize(index+1);
+    }
+    (*slots)[index] = obj;
+}
+
+/**
+ * Returns the obstacle with the given global id.
+ *
+ * This method is constant time. If there is no obstacle with that id, this
+ * method returns nullptr. To get the id of an obstacle, use the method
+ * {@link Obstacle#getGlobalId}.
+ *
+ * @param id    The global obstacle id
+ *
+ * @return the obstacle with the given global id.
+ */
+const std::shared_ptr<Obstacle>& ObstacleWorld::getObstacle(Uint64 id) const {
+    static const std::shared_ptr<Obstacle> none;
+    Uint32 space = (Uint32)(id >> 32);
+    size_t index = (size_t)(id & 0xFFFFFFFF);
+    for (auto it = _slots.begin(); it != _slots.end(); ++it) {
+        if (it->first == space) {
+            return index < it->second.size() ? it->second[index] : none;
+        }
+    }
+    return none;
+}
+
+/**
+ * Releases the id slot of the given obstacle.
+ *
+ * After this method, the id of the obstacle may not be used to look it up.
+ *
+ * @param obj   The obstacle to release
+ */
+void ObstacleWorld::releaseSlot(Obstacle* obj) {
+    if (!obj->hasGlobalId()) {
+        return;
+    }
+    Uint64 id = obj->getGlobalId();
+    Uint32 space = (Uint32)(id >> 32);
+    size_t index = (size_t)(id & 0xFFFFFFFF);
+    for (auto it = _slots.begin(); it != _slots.end(); ++it) {
+        if (it->first == space && index < it->second.size() && it->second[index].get() == obj) {
+            it->second[index] = nullptr;
+        }
+    }
+    obj->setGlobalId(OBSTACLE_NO_ID);
+    obj->clearOwned();
+}
+
+/**
+ * Updates the stored position of every obstacle starting at the given one.
+ *
+ * This must be called whenever obstacles are inserted or erased in the
+ * middle of the obstacle list.
+ *
+ * @param first The position of the first obstacle to update
+ */
+void ObstacleWorld::reindex(size_t first) {
+    for(size_t ii = first; ii < _objects.size(); ii++) {
+        _objects[ii]->_worldIndex = ii;
+    }
+}
+
+/**
+ * Detaches the given obstacle from the dirty list of this world.
+ *
+ * This is called whenever an obstacle leaves the world, so that the
+ * dirty list never refers to an obstacle that may be deleted.
+ *
+ * @param obj   The obstacle to detach
+ */
+void ObstacleWorld::detachDirty(Obstacle* obj) {
+    if (obj->_inDirtyList) {
+        auto it = std::find(_dirtyObjects.begin(), _dirtyObjects.end(), obj);
+        if (it != _dirtyObjects.end()) {
+            _dirtyObjects.erase(it);
+        }
+    }
+    obj->_dirtyList = nullptr;
+    obj->_inDirtyList = false;
+}
+
+/**
+ * Empties the list of dirty obstacles.
+ *
+ * This does not clear the dirty bits of the obstacles themselves. An
+ * obstacle that is changed again is readded to the list.
+ */
+void ObstacleWorld::clearDirtyObstacles() {
+    for (auto it = _dirtyObjects.begin(); it != _dirtyObjects.end(); ++it) {
+        (*it)->_inDirtyList = false;
+    }
+    _dirtyObjects.clear();
+}
+
+/**
+ * Sets the shard of this world.
+ *
+ * A game may split disconnected play areas into several independent worlds
+ * (see {@link #updateAll}). The shard is stored in the namespace of every
+ * global id allocated by this world, so ids are unique across all of the
+ * worlds, and {@link #shardOf} recovers the world of any id. The shard must
+ * be set before any obstacles are added, and must be less than 255. The
+ * default is 0, which leaves the ids exactly as they were with one world.
+ *
+ * With a nonzero shard, the short UID must fit in 24 bits.
+ *
+ * @param shard The shard of this world
+ */
+void ObstacleWorld::setShard(Uint8 shard) {
+    CUAssertLog(shard != 0xFF, "Shard %d is reserved", (int)shard);
+    CUAssertLog(_objects.empty(), "The shard must be set before adding obstacles");
+    _shard = shard;
+}
+
+/**
+ * Returns a new global id for an obstacle created by this world.
+ *
+ * The namespace of the id is the short UID of this world, tagged with its
+ * shard (see {@link #setShard}).
+ *
+ * @return a new global id for an obstacle created by this world.
+ */
+Uint64 ObstacleWorld::nextGlobalId() {
+    CUAssertLog(_shard == 0 || _shortUID < (1 << 24), "Short UID %u does not fit with a shard", _shortUID);
+    Uint32 space = ((Uint32)_shard << 24) | _shortUID;
+    return (((Uint64)space) << 32) | _nextObj++;
 }
 
 Uint64 ObstacleWorld::addObstacle(const std::shared_ptr<Obstacle>& obj) {
-    Uint64 id = (((Uint64)_shortUID) << 32) | _nextObj++;
+    Uint64 id = nextGlobalId();
     addObstacle(obj, id);
     return id;
 }
 
 Uint64 ObstacleWorld::addInitObstacle(const std::shared_ptr<Obstacle>& obj) {
-    Uint64 id = (((Uint64)0xffffffff) << 32) | _nextInitObj++;
+    // The reserved namespace of the primary world has no shard tag
+    Uint32 space = (_shard == 0 ? 0xFFFFFFFF : ((Uint32)_shard << 24) | 0x00FFFFFF);
+    Uint64 id = (((Uint64)space) << 32) | _nextInitObj++;
     obj->setShared(true);
     addObstacle(obj, id);
     return id;
 }
 
 Uint64 ObstacleWorld::addJoint(const b2JointDef& jointDef) {
-    Uint64 id = (((Uint64)_shortUID) << 32) | _nextJoint++;
+    Uint32 space = ((Uint32)_shard << 24) | _shortUID;
+    Uint64 id = (((Uint64)space) << 32) | _nextJoint++;
     addJoint(id, jointDef);
     return id;
 }
@@ -361,22 +716,30 @@ bool ObstacleWorld::removeJointSet(std::shared_ptr<cugl::physics2::JointSet>& js
  * @release a reference to the obstacle
  */
 void ObstacleWorld::removeObstacle(Obstacle* obj) {
-    for(auto it = _objects.begin(); it != _objects.end(); ++it) {
-        if (it->get() == obj) {
-            obj->deactivatePhysics(*_world);
-            _objects.erase(it);
-            return;
-        }
+    CUAssertLog(!_parallel, "Cannot remove an obstacle during a parallel update");
+    size_t pos = obj->_worldIndex;
+    if (pos >= _objects.size() || _objects[pos].get() != obj) {
+        CUAssertLog(false, "Physics object not present in world");
+        return;
     }
     
-    CUAssertLog(false, "Physics object not present in world");
+    obj->deactivatePhysics(*_world);
+    detachDirty(obj);
+    releaseSlot(obj);
+    if (obj->isPooled()) {
+        _pools[obj->_pool].total--;
+        obj->_pool = OBSTACLE_NO_POOL;
+    }
+    _objects.erase(_objects.begin()+pos);
+    reindex(pos);
 }
 
 /**
  * Remove all objects marked for removal.
  *
  * The objects will be released immediately. If no more objects assert ownership,
- * then the objects will be garbage collected.
+ * then the objects will be garbage collected. Pooled obstacles are returned
+ * to their pool instead (see {@link #createPool}).
  *
  * This method is the efficient, preferred way to remove objects.
  */
@@ -384,16 +747,18 @@ void ObstacleWorld::garbageCollect() {
     size_t count = 0;
     size_t pos = 0;
     for(size_t ii = 0; ii < _objects.size(); ii++) {
-        if (_objects[ii]->isRemoved()) {
+        if (_objects[ii]->isPooled() && _objects[ii]->isRemoved()) {
+            retirePooled(_objects[ii]);
+            _objects[ii] = nullptr;
+        } else if (_objects[ii]->isRemoved()) {
             _objects[ii]->deactivatePhysics(*_world);
-            if (_objToId.count(_objects[ii])) {
-                _idToObj.erase(_objToId.at(_objects[ii]));
-            }
-            _objToId.erase(_objects[ii]);
+            detachDirty(_objects[ii].get());
+            releaseSlot(_objects[ii].get());
             _objects[ii] = nullptr;
         } else {
             if (pos != ii) {
                 _objects[pos] = _objects[ii];
+                _objects[pos]->_worldIndex = pos;
                 _objects[ii]  = nullptr;
             }
             pos++;
@@ -407,7 +772,7 @@ void ObstacleWorld::garbageCollect() {
  * Remove all objects, emptying this controller.
  *
  * This method is different from a constructor in that the controller can still
- * receive new objects.
+ * receive new objects. All obstacle pools are deleted.
  */
 void ObstacleWorld::clear() {
     for (auto it = _idToJoint.begin(); it != _idToJoint.end(); it++) {
@@ -415,19 +780,302 @@ void ObstacleWorld::clear() {
 	}
     _idToJoint.clear();
 
-    _idToObj.clear();
-    _objToId.clear();
-    _owned.clear();
+    _slots.clear();
 
     for(auto it = _objects.begin() ; it != _objects.end(); ++it) {
         Obstacle* obj = it->get();
         obj->deactivatePhysics(*_world);
+        obj->setGlobalId(OBSTACLE_NO_ID);
+        obj->clearOwned();
+        obj->_dirtyList = nullptr;
+        obj->_inDirtyList = false;
+        obj->_pool = OBSTACLE_NO_POOL;
     }
     _objects.clear();
+    _dirtyObjects.clear();
+    
+    for(auto it = _pools.begin(); it != _pools.end(); ++it) {
+        for(auto jt = it->idle.begin(); jt != it->idle.end(); ++jt) {
+            Obstacle* obj = jt->get();
+            obj->deactivatePhysics(*_world);
+            obj->setGlobalId(OBSTACLE_NO_ID);
+            obj->_pool = OBSTACLE_NO_POOL;
+        }
+    }
+    _pools.clear();
     
     update(0);
 }
 
+/**
+ * Removes all objects, keeping the Box2D world and the obstacle pools.
+ *
+ * This method is intended for restarting a round. Unlike {@link clear()}
+ * or {@link dispose()}, the Box2D world is not rebuilt. Its allocators
+ * keep the memory of the destroyed bodies, fixtures and joints, and so the
+ * next round reuses it instead of allocating. Spawned pool obstacles are
+ * returned to their pools rather than destroyed, so that the pools (see
+ * {@link #createPool}) are the cheapest way to build the next round.
+ *
+ * The obstacle ids start over, so that {@link #addInitObstacle} gives the
+ * same ids as in the first round. Hence, in a networked game, every client
+ * must reset its world at the same time. All other settings of this world
+ * (including the callbacks) are unchanged.
+ */
+void ObstacleWorld::reset() {
+    CUAssertLog(!_parallel, "Cannot reset the world during a parallel update");
+    for (auto it = _idToJoint.begin(); it != _idToJoint.end(); it++) {
+        _world->DestroyJoint(it->second);
+    }
+    _idToJoint.clear();
+    
+    for(auto it = _objects.begin() ; it != _objects.end(); ++it) {
+        Obstacle* obj = it->get();
+        obj->_dirtyList = nullptr;
+        obj->_inDirtyList = false;
+        obj->_parked = false;
+        if (obj->isPooled()) {
+            obj->setEnabled(false);
+            obj->markRemoved(false);
+            _pools[obj->_pool].idle.push_back(std::move(*it));
+        } else {
+            obj->deactivatePhysics(*_world);
+        }
+        obj->setGlobalId(OBSTACLE_NO_ID);
+        obj->clearOwned();
+    }
+    for(auto it = _pools.begin(); it != _pools.end(); ++it) {
+        for(auto jt = it->idle.begin(); jt != it->idle.end(); ++jt) {
+            (*jt)->setGlobalId(OBSTACLE_NO_ID);
+        }
+    }
+    
+    // Keep the capacity of each list for the next round
+    _objects.clear();
+    _dirtyObjects.clear();
+    for(auto it = _slots.begin(); it != _slots.end(); ++it) {
+        it->second.clear();
+    }
+    _nextObj = 0;
+    _nextInitObj = 0;
+    _nextJoint = 0;
+    
+    _accumulator = 0;
+    _substeps = 0;
+    _alpha = 1;
+    _lodCounter = 0;
+    _lodParked = 0;
+    clearContacts();
+}
+
+
+#pragma mark -
+#pragma mark Obstacle Pools
+/**
+ * Creates a pool of obstacles for the given template, returning its key.
+ *
+ * A pool is for obstacles that are spawned and despawned in bursts, like
+ * bullets or debris. The factory creates a new obstacle from the template,
+ * and this world creates count of them immediately. Each one has a body
+ * in the Box2D world, but the body is disabled, so it takes no part in the
+ * simulation. Spawning an obstacle only resets and enables its body, and
+ * despawning it only disables the body. Hence, as long as a pool has
+ * enough obstacles, neither allocates.
+ *
+ * Pooled obstacles keep their global ids between spawns, and are intended
+ * for obstacles local to this world. They should not be shared.
+ *
+ * @param factory   The function to create a new obstacle for the pool
+ * @param count     The number of obstacles to create now
+ *
+ * @return the key of the new pool
+ */
+Uint32 ObstacleWorld::createPool(const std::function<std::shared_ptr<Obstacle>()>& factory, size_t count) {
+    Uint32 key = (Uint32)_pools.size();
+    _pools.emplace_back();
+    _pools.back().factory = factory;
+    _pools.back().total = 0;
+    reservePool(key, count);
+    return key;
+}
+
+/**
+ * Ensures that the given pool has at least count obstacles ready to spawn.
+ *
+ * The obstacle list of this world is also reserved so that spawning all of
+ * them does not reallocate it.
+ *
+ * @param pool  The pool key
+ * @param count The number of obstacles to have ready
+ */
+void ObstacleWorld::reservePool(Uint32 pool, size_t count) {
+    CUAssertLog(pool < _pools.size(), "Pool %d does not exist", pool);
+    ObstaclePool& entry = _pools[pool];
+    if (entry.idle.size() >= count) {
+        return;
+    }
+    
+    size_t needed = count-entry.idle.size();
+    entry.idle.reserve(entry.total+needed);
+    _objects.reserve(_objects.size()+count);
+    for(size_t ii = 0; ii < needed; ii++) {
+        std::shared_ptr<Obstacle> obj = entry.factory();
+        CUAssertLog(obj != nullptr, "Pool %d failed to create an obstacle", pool);
+        obj->setEnabled(false);
+        obj->activatePhysics(*_world);
+        obj->_pool = pool;
+        entry.idle.push_back(obj);
+        entry.total++;
+    }
+}
+
+/**
+ * Spawns an obstacle from the given pool, returning it.
+ *
+ * The obstacle is placed at the given position, with the given angle and
+ * linear velocity, no angular velocity, and is awake. Any other state is
+ * what it was when it was despawned. If the pool is empty, it is grown
+ * with the factory, which allocates.
+ *
+ * @param pool      The pool key
+ * @param pos       The initial position
+ * @param angle     The initial angle
+ * @param velocity  The initial linear velocity
+ *
+ * @return the spawned obstacle
+ */
+const std::shared_ptr<Obstacle>& ObstacleWorld::spawn(Uint32 pool, const Vec2 pos, float angle,
+                                                      const Vec2 velocity) {
+    CUAssertLog(!_parallel, "Cannot spawn an obstacle during a parallel update");
+    CUAssertLog(pool < _pools.size(), "Pool %d does not exist", pool);
+    ObstaclePool& entry = _pools[pool];
+    if (entry.idle.empty()) {
+        // Grow geometrically so that bursts stop allocating quickly
+        reservePool(pool, std::max(entry.total, (size_t)1));
+    }
+    
+    std::shared_ptr<Obstacle> obj = std::move(entry.idle.back());
+    entry.idle.pop_back();
+    obj->setPosition(pos);
+    obj->setAngle(angle);
+    obj->setLinearVelocity(velocity);
+    obj->setAngularVelocity(0);
+    obj->markRemoved(false);
+    obj->setEnabled(true);
+    obj->setAwake(true);
+    activatePooled(obj);
+    return _objects[obj->_worldIndex];
+}
+
+/**
+ * Spawns several obstacles from the given pool.
+ *
+ * Obstacle ii is placed at positions[ii] with velocity velocities[ii] (or
+ * no velocity if velocities is nullptr) and no rotation. If results is not
+ * nullptr, the spawned obstacles are stored there. The pool is grown at
+ * most once, if it does not have enough obstacles.
+ *
+ * @param pool          The pool key
+ * @param positions     The initial positions
+ * @param velocities    The initial linear velocities (or nullptr)
+ * @param count         The number of obstacles to spawn
+ * @param results       The array to store the spawned obstacles (or nullptr)
+ */
+void ObstacleWorld::spawn(Uint32 pool, const Vec2* positions, const Vec2* velocities, size_t count,
+                          std::shared_ptr<Obstacle>* results) {
+    CUAssertLog(pool < _pools.size(), "Pool %d does not exist", pool);
+    reservePool(pool, count);
+    for(size_t ii = 0; ii < count; ii++) {
+        const std::shared_ptr<Obstacle>& obj = spawn(pool, positions[ii], 0,
+                                                     velocities == nullptr ? Vec2::ZERO : velocities[ii]);
+        if (results != nullptr) {
+            results[ii] = obj;
+        }
+    }
+}
+
+/**
+ * Returns a pooled obstacle to its pool immediately.
+ *
+ * Unlike {@link #removeObstacle}, this method is constant time. The last
+ * obstacle in the obstacle list takes the place of this one. The only
+ * exception is deterministic mode, where the order of the obstacles must
+ * be preserved, and so this method is linear time.
+ *
+ * Marking a pooled obstacle for removal and calling {@link #garbageCollect}
+ * also returns it to its pool. That is the better choice for despawning
+ * many obstacles at once in deterministic mode.
+ *
+ * @param obj   The pooled obstacle to despawn
+ */
+void ObstacleWorld::despawn(Obstacle* obj) {
+    CUAssertLog(!_parallel, "Cannot despawn an obstacle during a parallel update");
+    size_t pos = obj->_worldIndex;
+    if (!obj->isPooled() || pos >= _objects.size() || _objects[pos].get() != obj) {
+        CUAssertLog(false, "Obstacle is not a spawned pool obstacle");
+        return;
+    }
+    
+    std::shared_ptr<Obstacle> keep = std::move(_objects[pos]);
+    if (_deterministic) {
+        _objects.erase(_objects.begin()+pos);
+        reindex(pos);
+    } else {
+        if (pos != _objects.size()-1) {
+            _objects[pos] = std::move(_objects.back());
+            _objects[pos]->_worldIndex = pos;
+        }
+        _objects.pop_back();
+    }
+    retirePooled(keep);
+}
+
+/**
+ * Adds the given pooled obstacle back to the obstacle list.
+ *
+ * The obstacle keeps the global id that it had when it was last despawned,
+ * so that spawning does not allocate new id slots.
+ *
+ * @param obj   The obstacle to activate
+ */
+void ObstacleWorld::activatePooled(const std::shared_ptr<Obstacle>& obj) {
+    Uint64 id = obj->getGlobalId();
+    if (id == OBSTACLE_NO_ID) {
+        id = nextGlobalId();
+    }
+    if (_deterministic) {
+        auto pos = std::upper_bound(_objects.begin(), _objects.end(), id, obstacle_after);
+        reindex(_objects.insert(pos, obj)-_objects.begin());
+    } else {
+        obj->_worldIndex = _objects.size();
+        _objects.push_back(obj);
+    }
+    obj->snapshot();
+    obj->_renderAlpha = _alpha;
+    obj->_dirtyList = &_dirtyObjects;
+    if (obj->isSharingDirty()) {
+        obj->markSharingDirty();
+    }
+    claimSlot(obj, id);
+}
+
+/**
+ * Disables the given pooled obstacle and returns it to its pool.
+ *
+ * The obstacle must already have been removed from the obstacle list.
+ *
+ * @param obj   The obstacle to retire
+ */
+void ObstacleWorld::retirePooled(const std::shared_ptr<Obstacle>& obj) {
+    Uint64 id = obj->getGlobalId();
+    obj->setEnabled(false);
+    obj->markRemoved(false);
+    detachDirty(obj.get());
+    releaseSlot(obj.get());
+    obj->setGlobalId(id);
+    _pools[obj->_pool].idle.push_back(obj);
+}
+
 
 #pragma mark -
 #pragma mark Physics Handling
@@ -446,6 +1094,34 @@ void ObstacleWorld::setGravity(const Vec2 gravity) {
     }
 }
 
+/**
+ * Sets whether this world is in deterministic mode.
+ *
+ * In deterministic mode, every call to update steps the world by exactly
+ * {@link #getStepsize}, regardless of {@link #isLockStep}, and the obstacles
+ * are kept sorted by global id. Two worlds that receive the same obstacles
+ * and the same forces at the same steps will then produce the same state,
+ * as long as the Box2D library is built with B2_DETERMINISTIC (this is the
+ * default). Use {@link #computeChecksum} to detect when they do not.
+ *
+ * The order of the Box2D bodies is the order in which the obstacles were
+ * added. Hence obstacles must be added in the same order on every machine
+ * within a step. This is the case when they are created by the simulation
+ * itself, but not when they arrive over the network.
+ *
+ * The iteration counts are not changed, but they must match on every
+ * machine. Enabling this mode sorts the existing obstacles.
+ *
+ * @param flag  Whether this world is in deterministic mode
+ */
+void ObstacleWorld::setDeterministic(bool flag) {
+    if (flag && !_deterministic) {
+        std::stable_sort(_objects.begin(), _objects.end(), obstacle_before);
+        reindex(0);
+    }
+    _deterministic = flag;
+}
+
 /**
  * Executes a single step of the physics engine.
  *
@@ -458,16 +1134,277 @@ void ObstacleWorld::setGravity(const Vec2 gravity) {
  * physics.  The primary method is the step() method in world.  This implementation
  * works for all applications and should not need to be overwritten.
  *
+ * If the world is accumulating (see {@link #setAccumulating}), this may take
+ * several steps, or none at all. The obstacles are updated once either way.
+ *
+ * This method empties the contact buffer (see {@link #setContactBuffer})
+ * before the first step. It also parks or wakes obstacles for the level of
+ * detail (see {@link #setLODAreas}).
+ *
  * @param dt    Number of seconds since last animation frame
  */
 void ObstacleWorld::update(float dt) {
+    CU_PROFILE_SCOPE("ObstacleWorld::update");
+    clearContacts();
+    updateLOD();
+    if (!_accumulating || _stepssize <= 0) {
+        _substeps = 1;
+        _alpha = 1;
+        step(dt);
+        return;
+    }
+    
+    // Drop any time that we cannot catch up on
+    _accumulator = std::min(_accumulator+dt,_maxSubsteps*_stepssize);
+    _substeps = std::min((Uint32)(_accumulator/_stepssize),_maxSubsteps);
+    b2Profile total = b2Profile();
+    for(Uint32 ii = 0; ii < _substeps; ii++) {
+        // Only the last step is interpolated
+        if (ii == _substeps-1) {
+            for(auto it = _objects.begin() ; it != _objects.end(); ++it) {
+                (*it)->snapshot();
+            }
+        }
+        _world->Step(_stepssize,_itvelocity,_itposition);
+        add_profile(total,_world->GetProfile());
+    }
+    _accumulator = std::max(_accumulator-_substeps*_stepssize,0.0f);
+    _alpha = std::min(_accumulator/_stepssize,1.0f);
+    
+    // Post process all objects after physics (this updates graphics)
+    Timestamp start;
+    postStep(dt,_alpha);
+    Timestamp end;
+    recordProfile(total,Timestamp::ellapsedMicros(start,end)/1000.0f);
+}
+
+/**
+ * Executes exactly one step of the physics engine.
+ *
+ * This is the same as {@link #update} when the world is not accumulating.
+ * When it is, this method ignores the accumulator, and draws every obstacle
+ * at its current transform. It is intended for replaying steps (such as for
+ * rollback), which must not disturb the timing of the real frames.
+ *
+ * @param dt    Number of seconds since last animation frame
+ */
+void ObstacleWorld::step(float dt) {
     // Turn the physics engine crank.
-    _world->Step((_lockstep ? _stepssize : dt),_itvelocity,_itposition);
+    _world->Step((_lockstep || _deterministic ? _stepssize : dt),_itvelocity,_itposition);
     
     // Post process all objects after physics (this updates graphics)
+    Timestamp start;
+    postStep(dt,1);
+    Timestamp end;
+    recordProfile(_world->GetProfile(),Timestamp::ellapsedMicros(start,end)/1000.0f);
+}
+
+/**
+ * Adds the timings of an update to the rolling averages.
+ *
+ * @param total The Box2D timings summed over every step in the update
+ * @param post  The time spent updating the obstacles (in milliseconds)
+ */
+void ObstacleWorld::recordProfile(const b2Profile& total, float post) {
+    // Until the window is full, this is the true mean
+    if (_profile.samples < PROFILE_WINDOW) {
+        _profile.samples++;
+    }
+    float weight = 1.0f/_profile.samples;
+    _profile.step += (total.step-_profile.step)*weight;
+    _profile.collide += (total.collide-_profile.collide)*weight;
+    _profile.solve += (total.solve-_profile.solve)*weight;
+    _profile.broadphase += (total.broadphase-_profile.broadphase)*weight;
+    _profile.solveTOI += (total.solveTOI-_profile.solveTOI)*weight;
+    _profile.postStep += (post-_profile.postStep)*weight;
+}
+
+/**
+ * Returns a snapshot of the performance of this world.
+ *
+ * The timings are rolling averages of the recent calls to {@link #update}
+ * (and {@link #step}). The counts are the current size of the world. The
+ * profiler is always on, and only costs a few clock reads per update.
+ *
+ * @return a snapshot of the performance of this world.
+ */
+PhysicsProfile ObstacleWorld::getProfile() const {
+    PhysicsProfile result = _profile;
+    result.obstacles = _objects.size();
+    if (_world != nullptr) {
+        result.bodies = (size_t)_world->GetBodyCount();
+        result.contacts = (size_t)_world->GetContactCount();
+        result.joints = (size_t)_world->GetJointCount();
+        result.proxies = (size_t)_world->GetProxyCount();
+    }
+    return result;
+}
+
+/**
+ * Updates every obstacle after a physics step.
+ *
+ * This assigns the interpolation factor to each obstacle and then calls
+ * {@link Obstacle#update}. If this world has a thread pool, and there are
+ * more obstacles than the grain size, the obstacles are split into tasks of
+ * the grain size and updated in parallel. This method does not return until
+ * every obstacle is updated.
+ *
+ * @param dt    Number of seconds since last animation frame
+ * @param alpha The interpolation factor for each obstacle
+ */
+void ObstacleWorld::postStep(float dt, float alpha) {
+    if (_workers == nullptr || _workers->isStopped() || _objects.size() <= _grain) {
+        for(auto it = _objects.begin() ; it != _objects.end(); ++it) {
+            Obstacle* obj = it->get();
+            obj->_renderAlpha = alpha;
+            obj->update(dt);
+        }
+        return;
+    }
+    
+    // Fixtures belong to the Box2D world, so they must be rebuilt serially
     for(auto it = _objects.begin() ; it != _objects.end(); ++it) {
         Obstacle* obj = it->get();
-        obj->update(dt);
+        obj->_renderAlpha = alpha;
+        if (obj->isDirty()) {
+            obj->createFixtures();
+        }
+    }
+    
+#if SDL_ASSERT_LEVEL > 1
+    size_t objects = _objects.size();
+    size_t dirty  = _dirtyObjects.size();
+    int bodies = _world->GetBodyCount();
+    int joints = _world->GetJointCount();
+#endif
+    
+    _parallel = true;
+    const std::shared_ptr<Obstacle>* objs = _objects.data();
+    parallelFor(_objects.size(),_grain,[=](size_t first, size_t last) {
+        for(size_t ii = first; ii < last; ii++) {
+            objs[ii]->update(dt);
+        }
+    });
+    _parallel = false;
+    
+#if SDL_ASSERT_LEVEL > 1
+    CUAssertLog(objects == _objects.size() && bodies == _world->GetBodyCount() &&
+                joints == _world->GetJointCount(),
+                "An obstacle update modified the world during a parallel update");
+    CUAssertLog(dirty == _dirtyObjects.size(),
+                "An obstacle update changed shared state during a parallel update");
+#endif
+}
+
+/**
+ * Runs the given loop body over a range, in parallel if possible.
+ *
+ * The range is split into chunks of the given grain size, and the body is
+ * called with the start and end of each chunk. If this world has no thread
+ * pool, or the range is no bigger than a chunk, the body is called once on
+ * the whole range. Otherwise the chunks are shared between the pool and the
+ * calling thread. Either way, this method does not return until the body
+ * has been called on the whole range.
+ *
+ * @param size  The size of the range
+ * @param grain The size of a chunk
+ * @param body  The loop body, called with the start and end of each chunk
+ */
+void ObstacleWorld::parallelFor(size_t size, size_t grain,
+                                const std::function<void(size_t,size_t)>& body) const {
+    parallel_for(_workers,size,grain,body);
+}
+
+/**
+ * Executes a single update of each of the given worlds, in parallel.
+ *
+ * This is the same as calling {@link #update} on each world in turn, except
+ * that the worlds are updated at the same time on the given thread pool. The
+ * calling thread takes part, so this method only returns once every world is
+ * updated. Without a pool (or with only one world), the worlds are updated
+ * serially.
+ *
+ * This is only safe if the worlds never interact, as they are independent
+ * Box2D worlds. Every callback of a world (the contact callbacks, and every
+ * obstacle update and listener) may run on a pool thread, at the same time
+ * as the callbacks of the other worlds. So they may not touch any state that
+ * is shared between the worlds without their own synchronization. A world may
+ * still have its own thread pool (see {@link #setThreadPool}), and it may be
+ * the same pool.
+ *
+ * @param worlds    The worlds to update
+ * @param dt        Number of seconds since last animation frame
+ * @param pool      The thread pool for the updates (may be nullptr)
+ */
+void ObstacleWorld::updateAll(const std::vector<std::shared_ptr<ObstacleWorld>>& worlds, float dt,
+                              const std::shared_ptr<ThreadPool>& pool) {
+    // A world waiting on its own tasks runs them itself, so nesting is safe
+    const std::shared_ptr<ObstacleWorld>* items = worlds.data();
+    parallel_for(pool,worlds.size(),1,[=](size_t first, size_t last) {
+        for(size_t ii = first; ii < last; ii++) {
+            items[ii]->update(dt);
+        }
+    });
+}
+
+/**
+ * Copies the drawing transform of every obstacle into the given arrays.
+ *
+ * The transforms are stored as a structure of arrays, in the order of
+ * {@link #getObstacles}. Each array is resized to the number of obstacles.
+ * Each transform is the one returned by {@link Obstacle#getRenderPosition}
+ * and {@link Obstacle#getRenderAngle}, so it is interpolated if this world
+ * is accumulating. This allows a renderer to draw all of the obstacles in
+ * a single (vectorizable) loop, instead of with a listener per obstacle.
+ *
+ * The arrays are only reallocated if they grow, so they should be reused
+ * from frame to frame.
+ *
+ * @param xs        The array to store the x-coordinates
+ * @param ys        The array to store the y-coordinates
+ * @param angles    The array to store the angles
+ */
+void ObstacleWorld::exportTransforms(std::vector<float>& xs, std::vector<float>& ys,
+                                     std::vector<float>& angles) const {
+    size_t size = _objects.size();
+    xs.resize(size);
+    ys.resize(size);
+    angles.resize(size);
+    for(size_t ii = 0; ii < size; ii++) {
+        const Obstacle* obj = _objects[ii].get();
+        Vec2 pos = obj->getRenderPosition();
+        xs[ii] = pos.x;
+        ys[ii] = pos.y;
+        angles[ii] = obj->getRenderAngle();
+    }
+}
+
+/**
+ * Sets whether this world accumulates frame time into fixed steps.
+ *
+ * When accumulating, each call to update adds the frame time to an
+ * accumulator, and then takes as many steps of {@link #getStepsize} as fit
+ * (possibly none). So the simulation keeps up with real time, and is still
+ * reproducible. The time left over is exposed as {@link #getAlpha}, and
+ * each obstacle can be drawn between its last two steps with
+ * {@link Obstacle#getRenderPosition} and {@link Obstacle#getRenderAngle}.
+ *
+ * If the frame rate drops so far that more than {@link #getMaxSubsteps}
+ * steps are due, the extra time is dropped, and the simulation runs slower
+ * than real time. This prevents a slow frame from causing an even slower
+ * frame (the "spiral of death").
+ *
+ * Changing this value resets the accumulator.
+ *
+ * @param flag  Whether this world accumulates frame time into fixed steps
+ */
+void ObstacleWorld::setAccumulating(bool flag) {
+    _accumulating = flag;
+    _accumulator = 0;
+    _alpha = 1;
+    for(auto it = _objects.begin() ; it != _objects.end(); ++it) {
+        (*it)->snapshot();
+        (*it)->_renderAlpha = 1;
     }
 }
 
@@ -488,6 +1425,374 @@ bool ObstacleWorld::inBounds(Obstacle* obj) {
     return horiz && vert;
 }
 
+/**
+ * Returns true if the contact state is ordered before the given fixtures
+ *
+ * This is the order of the contacts in a {@link WorldState}.
+ *
+ * @param c         The contact state
+ * @param fixtureA  The first fixture of the other contact
+ * @param fixtureB  The second fixture of the other contact
+ * @param childA    The child index of the first fixture of the other contact
+ * @param childB    The child index of the second fixture of the other contact
+ *
+ * @return true if the contact state is ordered before the given fixtures
+ */
+static bool contact_before(const WorldState::Contact& c,
+                           const b2Fixture* fixtureA, const b2Fixture* fixtureB,
+                           int childA, int childB) {
+    if (c.fixtureA != fixtureA) {
+        return std::less<const b2Fixture*>()(c.fixtureA,fixtureA);
+    } else if (c.fixtureB != fixtureB) {
+        return std::less<const b2Fixture*>()(c.fixtureB,fixtureB);
+    } else if (c.childA != childA) {
+        return c.childA < childA;
+    }
+    return c.childB < childB;
+}
+
+/**
+ * Captures the dynamic state of this world into the given state.
+ *
+ * This saves the transform, velocity and sleep state of every body, and
+ * the warm starting impulses of every contact. It does not save fixtures,
+ * joints or obstacle properties, which are assumed to be unchanged on
+ * restore. This method does not allocate if the state already has enough
+ * room (see {@link WorldState#reserve}).
+ *
+ * This method may not be called during a physics step.
+ *
+ * @param state The state to store the result
+ */
+void ObstacleWorld::captureState(WorldState& state) const {
+    CUAssertLog(!_world->IsLocked(), "Cannot capture a world during a physics step");
+    state.reserve(_world->GetBodyCount(), _world->GetContactCount());
+    
+    size_t ii = 0;
+    for (const b2Body* body = _world->GetBodyList(); body; body = body->GetNext()) {
+        WorldState::Body& b = state.bodies[ii++];
+        const b2Vec2& pos = body->GetPosition();
+        const b2Vec2& vel = body->GetLinearVelocity();
+        b.body = body;
+        b.x = pos.x;
+        b.y = pos.y;
+        b.angle = body->GetAngle();
+        b.vx = vel.x;
+        b.vy = vel.y;
+        b.vangular = body->GetAngularVelocity();
+        b.flags  = body->IsAwake() ? WorldState::BODY_AWAKE : 0;
+        b.flags |= body->IsEnabled() ? WorldState::BODY_ENABLED : 0;
+    }
+    state.bodyCount = ii;
+    
+    ii = 0;
+    for (const b2Contact* contact = _world->GetContactList(); contact; contact = contact->GetNext()) {
+        WorldState::Contact& c = state.contacts[ii++];
+        const b2Manifold* manifold = contact->GetManifold();
+        c.fixtureA = contact->GetFixtureA();
+        c.fixtureB = contact->GetFixtureB();
+        c.childA = contact->GetChildIndexA();
+        c.childB = contact->GetChildIndexB();
+        c.flags  = contact->IsEnabled() ? WorldState::CONTACT_ENABLED : 0;
+        c.flags |= contact->IsTouching() ? WorldState::CONTACT_TOUCHING : 0;
+        c.pointCount = manifold->pointCount;
+        for (int jj = 0; jj < manifold->pointCount; jj++) {
+            c.ids[jj] = manifold->points[jj].id.key;
+            c.normalImpulse[jj]  = manifold->points[jj].normalImpulse;
+            c.tangentImpulse[jj] = manifold->points[jj].tangentImpulse;
+        }
+    }
+    state.contactCount = ii;
+    
+    std::sort(state.contacts.begin(), state.contacts.begin()+state.contactCount,
+              [](const WorldState::Contact& a, const WorldState::Contact& b) {
+        return contact_before(a, b.fixtureA, b.fixtureB, b.childA, b.childB);
+    });
+}
+
+/**
+ * Restores the dynamic state of this world from the given state.
+ *
+ * The state must have been captured from this world, and no bodies may
+ * have been added or removed since. Otherwise, this method returns false
+ * and does not change the world.
+ *
+ * Box2D does not expose the sleep timer, the order of its contacts, or the
+ * touching flag of contacts. Hence bodies whose velocity changed restart
+ * their sleep timer, and contacts recompute the touching flag on the next
+ * step. Freely moving bodies replay to within float rounding. Stacked bodies
+ * are sensitive to the contact order, and may drift slightly.
+ *
+ * This method may not be called during a physics step.
+ *
+ * @param state The state to restore
+ *
+ * @return true if the state was restored
+ */
+bool ObstacleWorld::restoreState(const WorldState& state) {
+    CUAssertLog(!_world->IsLocked(), "Cannot restore a world during a physics step");
+    if (state.bodyCount != (size_t)_world->GetBodyCount()) {
+        return false;
+    }
+    size_t ii = 0;
+    for (const b2Body* body = _world->GetBodyList(); body; body = body->GetNext()) {
+        if (state.bodies[ii++].body != body) {
+            return false;
+        }
+    }
+    
+    ii = 0;
+    for (b2Body* body = _world->GetBodyList(); body; body = body->GetNext()) {
+        const WorldState::Body& b = state.bodies[ii++];
+        bool enabled = (b.flags & WorldState::BODY_ENABLED) != 0;
+        if (body->IsEnabled() != enabled) {
+            body->SetEnabled(enabled);
+        }
+        // Moving a body resets its broadphase proxies, so only move if necessary
+        const b2Vec2& pos = body->GetPosition();
+        if (pos.x != b.x || pos.y != b.y || body->GetAngle() != b.angle) {
+            body->SetTransform(b2Vec2(b.x,b.y), b.angle);
+            Obstacle* obj = reinterpret_cast<Obstacle*>(body->GetUserData().pointer);
+            if (obj != nullptr) {
+                obj->markTransformDirty();
+            }
+        }
+        // Waking a body (or setting its velocity) restarts its sleep timer
+        if (b.flags & WorldState::BODY_AWAKE) {
+            if (!body->IsAwake()) {
+                body->SetAwake(true);
+            }
+            const b2Vec2& vel = body->GetLinearVelocity();
+            if (vel.x != b.vx || vel.y != b.vy) {
+                body->SetLinearVelocity(b2Vec2(b.vx,b.vy));
+            }
+            if (body->GetAngularVelocity() != b.vangular) {
+                body->SetAngularVelocity(b.vangular);
+            }
+        } else if (body->IsAwake()) {
+            // Sleeping bodies have no velocity
+            body->SetAwake(false);
+        }
+    }
+    
+    auto begin = state.contacts.begin();
+    auto end = state.contacts.begin()+state.contactCount;
+    for (b2Contact* contact = _world->GetContactList(); contact; contact = contact->GetNext()) {
+        const b2Fixture* fixtureA = contact->GetFixtureA();
+        const b2Fixture* fixtureB = contact->GetFixtureB();
+        int childA = contact->GetChildIndexA();
+        int childB = contact->GetChildIndexB();
+        auto it = std::lower_bound(begin, end, 0, [&](const WorldState::Contact& c, int) {
+            return contact_before(c, fixtureA, fixtureB, childA, childB);
+        });
+        
+        b2Manifold* manifold = contact->GetManifold();
+        bool found = (it != end && it->fixtureA == fixtureA && it->fixtureB == fixtureB &&
+                      it->childA == childA && it->childB == childB);
+        if (found) {
+            contact->SetEnabled((it->flags & WorldState::CONTACT_ENABLED) != 0);
+        }
+        for (int jj = 0; jj < manifold->pointCount; jj++) {
+            b2ManifoldPoint& point = manifold->points[jj];
+            point.normalImpulse  = 0;
+            point.tangentImpulse = 0;
+            for (int kk = 0; found && kk < it->pointCount; kk++) {
+                if (it->ids[kk] == point.id.key) {
+                    point.normalImpulse  = it->normalImpulse[kk];
+                    point.tangentImpulse = it->tangentImpulse[kk];
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Mixes the bits of a value into an FNV-1a checksum
+ *
+ * @param hash  The running checksum
+ * @param value The value to mix in
+ *
+ * @return the updated checksum
+ */
+static Uint64 checksum_mix(Uint64 hash, Uint64 value) {
+    for (int ii = 0; ii < 8; ii++) {
+        hash ^= (value >> (8*ii)) & 0xFF;
+        hash *= CHECKSUM_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Mixes the bits of a float into an FNV-1a checksum
+ *
+ * @param hash  The running checksum
+ * @param value The float to mix in
+ *
+ * @return the updated checksum
+ */
+static Uint64 checksum_mix(Uint64 hash, float value) {
+    Uint32 bits;
+    std::memcpy(&bits, &value, sizeof(Uint32));
+    return checksum_mix(hash, (Uint64)bits);
+}
+
+/**
+ * Returns a checksum of the dynamic state of this world.
+ *
+ * The checksum covers the global id, position, angle, velocities and
+ * sleep state of every non-static obstacle, in the order of the global ids.
+ * It hashes the exact bits of each value, so two worlds have the same checksum
+ * only if they are bit identical. This is intended for deterministic mode
+ * (see {@link #setDeterministic}), where peers can compare checksums each
+ * step instead of the state itself.
+ *
+ * This method does not allocate and is linear in the number of obstacles.
+ *
+ * @return a checksum of the dynamic state of this world.
+ */
+Uint64 ObstacleWorld::computeChecksum() const {
+    Uint64 hash = CHECKSUM_BASIS;
+    // Outside of deterministic mode, this is the order of insertion
+    for (auto it = _objects.begin(); it != _objects.end(); ++it) {
+        const Obstacle* obj = it->get();
+        if (obj->getBodyType() == b2_staticBody) {
+            continue;
+        }
+        Vec2 pos = obj->getPosition();
+        Vec2 vel = obj->getLinearVelocity();
+        hash = checksum_mix(hash, obj->getGlobalId());
+        hash = checksum_mix(hash, pos.x);
+        hash = checksum_mix(hash, pos.y);
+        hash = checksum_mix(hash, obj->getAngle());
+        hash = checksum_mix(hash, vel.x);
+        hash = checksum_mix(hash, vel.y);
+        hash = checksum_mix(hash, obj->getAngularVelocity());
+        hash = checksum_mix(hash, (Uint64)(obj->isAwake() ? 1 : 0));
+    }
+    return hash;
+}
+
+#pragma mark -
+#pragma mark Level of Detail
+/**
+ * Sets the areas of interest for the level of detail.
+ *
+ * Box2D spends nothing on a sleeping body. So on a large map, the bodies
+ * far from every player can be put to sleep (parked) without changing
+ * anything that a player could see. An obstacle is parked once it is more
+ * than {@link #getLODMargin} outside of every area, and it is woken as soon
+ * as it overlaps an area again. Its velocity is saved while it is parked,
+ * so it resumes its motion when woken. A parked body still wakes up as
+ * usual if an awake body collides with it.
+ *
+ * These areas should cover every player, such as the view of each player
+ * (see {@link netphysics::NetPhysicsController#setPeerView}). Static bodies
+ * and bodies with joints are never parked. Neither are shared obstacles
+ * that this client does not own, as their state comes from their owner.
+ * In deterministic mode (see {@link #setDeterministic}), every client
+ * must use the same areas.
+ *
+ * An empty list disables the level of detail, and wakes every parked
+ * obstacle at the next update.
+ *
+ * @param areas The areas of interest in physics coordinates
+ */
+void ObstacleWorld::setLODAreas(const std::vector<Rect>& areas) {
+    _lodAreas = areas;
+    _lodCounter = 0;
+}
+
+/**
+ * Returns true if the level of detail may park the given obstacle.
+ *
+ * @param obj   The obstacle to check
+ *
+ * @return true if the level of detail may park the given obstacle.
+ */
+static bool can_park(Obstacle* obj) {
+    const b2Body* body = obj->getBody();
+    if (body == nullptr || body->GetType() == b2_staticBody || !body->IsEnabled()) {
+        return false;
+    }
+    if (body->GetJointList() != nullptr) {
+        return false;
+    }
+    return !obj->isShared() || obj->isOwned();
+}
+
+/**
+ * Parks or wakes the obstacles according to the level of detail.
+ *
+ * An obstacle that is more than {@link #getLODMargin} outside of every
+ * area of interest is put to sleep, and its velocity is saved. A parked
+ * obstacle that overlaps an area again is woken with its saved velocity.
+ * If there are no areas, every parked obstacle is woken.
+ *
+ * This pass only runs every {@link #getLODInterval} updates.
+ */
+void ObstacleWorld::updateLOD() {
+    if (_lodAreas.empty() && _lodParked == 0) {
+        return;
+    } else if (_lodCounter > 0 && !_lodAreas.empty()) {
+        _lodCounter--;
+        return;
+    }
+    _lodCounter = _lodInterval-1;
+    
+    size_t parked = 0;
+    for(auto it = _objects.begin(); it != _objects.end(); ++it) {
+        Obstacle* obj = it->get();
+        b2Body* body = obj->_body;
+        if (obj->_parked && (body == nullptr || body->IsAwake())) {
+            // Something else woke it up (a collision or the user)
+            obj->_parked = false;
+        }
+        
+        bool allowed = !_lodAreas.empty() && can_park(obj);
+        if (!allowed && !obj->_parked) {
+            continue;
+        }
+        
+        // Only wake a parked body if it is inside an area, not just the margin
+        float margin = obj->_parked ? 0 : _lodMargin;
+        bool inside = false;
+        if (allowed) {
+            b2AABB bounds;
+            bounds.lowerBound = body->GetPosition();
+            bounds.upperBound = bounds.lowerBound;
+            for(b2Fixture* fix = body->GetFixtureList(); fix != nullptr; fix = fix->GetNext()) {
+                for(int ii = 0; ii < fix->GetShape()->GetChildCount(); ii++) {
+                    bounds.Combine(fix->GetAABB(ii));
+                }
+            }
+            for(auto jt = _lodAreas.begin(); !inside && jt != _lodAreas.end(); ++jt) {
+                inside = (bounds.upperBound.x >= jt->getMinX()-margin &&
+                          bounds.lowerBound.x <= jt->getMaxX()+margin &&
+                          bounds.upperBound.y >= jt->getMinY()-margin &&
+                          bounds.lowerBound.y <= jt->getMaxY()+margin);
+            }
+        }
+        
+        if (obj->_parked && (inside || !allowed)) {
+            // This does not go through the obstacle, so nothing is synced
+            body->SetAwake(true);
+            body->SetLinearVelocity(obj->_parkedVelocity);
+            body->SetAngularVelocity(obj->_parkedSpin);
+            obj->_parked = false;
+        } else if (!obj->_parked && !inside && body->IsAwake()) {
+            obj->_parkedVelocity = body->GetLinearVelocity();
+            obj->_parkedSpin = body->GetAngularVelocity();
+            body->SetAwake(false);
+            obj->_parked = true;
+        }
+        if (obj->_parked) {
+            parked++;
+        }
+    }
+    _lodParked = parked;
+}
+
 #pragma mark -
 #pragma mark Callback Activation
 
@@ -504,10 +1809,81 @@ void ObstacleWorld::activateCollisionCallbacks(bool flag) {
         return;
     }
     
-    _world->SetContactListener(flag ? this : nullptr);
+    _world->SetContactListener(flag || !_contacts.empty() ? this : nullptr);
     _collide = flag;
 }
 
+/**
+ * Sets the capacity of the contact buffer.
+ *
+ * A world with a contact buffer records a {@link ContactEvent} for every
+ * call to BeginContact, EndContact and PostSolve, in a ring buffer of the
+ * given capacity. The buffer is emptied at the start of each call to
+ * {@link #update}, so after an update it holds the events of every step in
+ * that update. Steps taken with {@link #step} (such as for rollback) add to
+ * the buffer without emptying it. If there are more events than the
+ * capacity, the oldest are dropped.
+ *
+ * This allows game logic to respond to contacts after the step, when it
+ * is safe to modify the world, and keeps the solver free of closures.
+ * Buffering is independent of {@link #activateCollisionCallbacks}. The
+ * {@link #beforeSolve} callback is never buffered, since it must be able
+ * to modify the contact.
+ *
+ * A capacity of 0 disables buffering, which is the default.
+ *
+ * @param capacity  The capacity of the contact buffer
+ */
+void ObstacleWorld::setContactBuffer(size_t capacity) {
+    _contacts.resize(capacity);
+    _contacts.shrink_to_fit();
+    clearContacts();
+    if (_world != nullptr) {
+        _world->SetContactListener(_collide || capacity > 0 ? this : nullptr);
+    }
+}
+
+/**
+ * Records a contact callback in the contact buffer.
+ *
+ * If the buffer is full, the oldest event is overwritten.
+ *
+ * @param type      The contact callback
+ * @param contact   The contact information
+ * @param impulse   The impulse produced by the solver (or nullptr)
+ */
+void ObstacleWorld::bufferContact(ContactEvent::Type type, b2Contact* contact, const b2ContactImpulse* impulse) {
+    size_t capacity = _contacts.size();
+    ContactEvent* event;
+    if (_contactSize < capacity) {
+        event = &_contacts[(_contactHead+_contactSize) % capacity];
+        _contactSize++;
+    } else {
+        event = &_contacts[_contactHead];
+        _contactHead = (_contactHead+1) % capacity;
+        _contactDropped++;
+    }
+    
+    event->type = type;
+    event->fixtureA = contact->GetFixtureA();
+    event->fixtureB = contact->GetFixtureB();
+    event->impulse = 0;
+    if (type == ContactEvent::Type::END || contact->GetManifold()->pointCount == 0) {
+        event->normal.setZero();
+        event->point.setZero();
+    } else {
+        b2WorldManifold manifold;
+        contact->GetWorldManifold(&manifold);
+        event->normal.set(manifold.normal.x,manifold.normal.y);
+        event->point.set(manifold.points[0].x,manifold.points[0].y);
+    }
+    if (impulse != nullptr) {
+        for(int ii = 0; ii < impulse->count; ii++) {
+            event->impulse += impulse->normalImpulses[ii];
+        }
+    }
+}
+
 /**
  * Activates the collision filter callbacks.
  *
@@ -579,3 +1955,90 @@ void ObstacleWorld::rayCast(std::function<float(b2Fixture* fixture, const Vec2 p
     proxy.onQuery = callback;
     _world->RayCast(&proxy, b2Vec2(point1.x,point1.y), b2Vec2(point2.x,point2.y));
 }
+
+/**
+ * Ray-casts the world for the closest fixture along each of the given rays.
+ *
+ * Ray ii goes from starts[ii] to ends[ii], and its closest hit is stored in
+ * hits[ii]. A ray that hits nothing has a hit with a nullptr fixture and a
+ * fraction of 1. Like {@link #rayCast}, each ray ignores the shapes that
+ * contain its starting point.
+ *
+ * Ray-casts only read the world, so a batch larger than a single task is
+ * split across the thread pool (see {@link #setThreadPool}). This method
+ * does not allocate unless it uses the pool, and may not be called during
+ * a physics step.
+ *
+ * @param starts    The ray starting points
+ * @param ends      The ray ending points
+ * @param hits      The array to store the closest hits
+ * @param count     The number of rays
+ *
+ * @return the number of rays that hit a fixture
+ */
+size_t ObstacleWorld::rayCastClosest(const Vec2* starts, const Vec2* ends,
+                                     RayHit* hits, size_t count) const {
+    CUAssertLog(!_world->IsLocked(), "Cannot query a world during a physics step");
+    std::atomic<size_t> total(0);
+    parallelFor(count,QUERY_PARALLEL_GRAIN,[&](size_t first, size_t last) {
+        size_t found = 0;
+        for(size_t ii = first; ii < last; ii++) {
+            RayHit* hit = hits+ii;
+            hit->fixture = nullptr;
+            hit->point = ends[ii];
+            hit->normal = Vec2::ZERO;
+            hit->fraction = 1;
+            if (starts[ii] != ends[ii]) {
+                ClosestRayProxy proxy(hit);
+                _world->RayCast(&proxy, b2Vec2(starts[ii].x,starts[ii].y), b2Vec2(ends[ii].x,ends[ii].y));
+            }
+            found += (hit->fixture != nullptr);
+        }
+        total += found;
+    });
+    return total;
+}
+
+/**
+ * Queries the world for the fixtures that potentially overlap each of the given AABBs.
+ *
+ * The fixtures for box ii are stored in fixtures[ii*limit], up to limit
+ * fixtures per box, and their number is stored in counts[ii]. Hence fixtures
+ * must have room for count*limit values. A box that overlaps more than limit
+ * fixtures has only the first limit that Box2D finds.
+ *
+ * Queries only read the world, so a batch larger than a single task is
+ * split across the thread pool (see {@link #setThreadPool}). This method
+ * does not allocate unless it uses the pool, and may not be called during
+ * a physics step.
+ *
+ * @param boxes     The axis-aligned bounding boxes
+ * @param count     The number of boxes
+ * @param fixtures  The array to store the fixtures
+ * @param limit     The maximum number of fixtures per box
+ * @param counts    The array to store the number of fixtures per box
+ *
+ * @return the total number of fixtures found
+ */
+size_t ObstacleWorld::queryAABB(const Rect* boxes, size_t count, b2Fixture** fixtures,
+                                size_t limit, size_t* counts) const {
+    CUAssertLog(!_world->IsLocked(), "Cannot query a world during a physics step");
+    std::atomic<size_t> total(0);
+    parallelFor(count,QUERY_PARALLEL_GRAIN,[&](size_t first, size_t last) {
+        size_t found = 0;
+        for(size_t ii = first; ii < last; ii++) {
+            const Rect& aabb = boxes[ii];
+            b2AABB b2box;
+            b2box.lowerBound.Set(aabb.origin.x, aabb.origin.y);
+            b2box.upperBound.Set(aabb.origin.x+aabb.size.width, aabb.origin.y+aabb.size.height);
+            CollectProxy proxy(fixtures+ii*limit,limit);
+            if (limit > 0) {
+                _world->QueryAABB(&proxy, b2box);
+            }
+            counts[ii] = proxy.size;
+            found += proxy.size;
+        }
+        total += found;
+    });
+    return total;
+}
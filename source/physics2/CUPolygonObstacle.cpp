@@ -45,11 +45,23 @@
 //
 #include <box2d/b2_polygon_shape.h>
 #include <cugl/physics2/CUPolygonObstacle.h>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <map>
 
+using namespace cugl;
 using namespace cugl::physics2;
 
 /** The epsilon necessary for box2d not to mark as degenerate */
 #define EPSILON 0.01
+/** The tolerance for a merged vertex to count as convex */
+#define CONVEX_EPSILON 1e-5f
+/** The offset basis for the geometry hash */
+#define HASH_BASIS  0xcbf29ce484222325ULL
+/** The prime for the geometry hash */
+#define HASH_PRIME  0x100000001b3ULL
 
 /**
  * Returns true if the given vertices are a non-degenerate triangle
@@ -92,6 +104,296 @@ static bool valid_shape(const b2Vec2* verts, int count) {
     return tempCount == 3;
 }
 
+#pragma mark -
+#pragma mark Convex Decomposition
+/**
+ * Returns the cross product of the two edges at b
+ *
+ * @param a The vertex before b
+ * @param b The vertex to check
+ * @param c The vertex after b
+ *
+ * @return the cross product of the two edges at b
+ */
+static float turn(const Vec2& a, const Vec2& b, const Vec2& c) {
+    return (b.x-a.x)*(c.y-b.y)-(b.y-a.y)*(c.x-b.x);
+}
+
+/**
+ * Returns true if the given polygon is convex (and counter-clockwise)
+ *
+ * @param verts The vertex positions
+ * @param poly  The vertex indices of the polygon
+ *
+ * @return true if the given polygon is convex
+ */
+static bool is_convex(const std::vector<Vec2>& verts, const std::vector<Uint32>& poly) {
+    size_t size = poly.size();
+    for(size_t ii = 0; ii < size; ii++) {
+        const Vec2& a = verts[poly[ii]];
+        const Vec2& b = verts[poly[(ii+1) % size]];
+        const Vec2& c = verts[poly[(ii+2) % size]];
+        if (turn(a,b,c) < -CONVEX_EPSILON) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Merges two polygons across a shared edge, returning true if it succeeded
+ *
+ * The edge is at position pi (from a to b) in the first polygon and at qi
+ * (from b to a) in the second. The merge fails if the result is not convex,
+ * or it has too many vertices for Box2D.
+ *
+ * @param verts     The vertex positions
+ * @param p         The first polygon
+ * @param pi        The position of the shared edge in the first polygon
+ * @param q         The second polygon
+ * @param qi        The position of the shared edge in the second polygon
+ * @param result    The vector to store the merged polygon
+ *
+ * @return true if the merge succeeded
+ */
+static bool merge_polygons(const std::vector<Vec2>& verts,
+                           const std::vector<Uint32>& p, size_t pi,
+                           const std::vector<Uint32>& q, size_t qi,
+                           std::vector<Uint32>& result) {
+    size_t total = p.size()+q.size()-2;
+    if (total > b2_maxPolygonVertices) {
+        return false;
+    }
+    result.clear();
+    for(size_t ii = 1; ii <= p.size(); ii++) {
+        result.push_back(p[(pi+ii) % p.size()]);
+    }
+    for(size_t ii = 2; ii < q.size(); ii++) {
+        result.push_back(q[(qi+ii) % q.size()]);
+    }
+    return is_convex(verts,result);
+}
+
+/**
+ * Decomposes a triangulated polygon into convex shapes.
+ *
+ * Degenerate triangles are skipped. The remaining triangles are merged
+ * greedily across shared edges (Hertel-Mehlhorn) as long as the result is
+ * convex and small enough for a b2PolygonShape.
+ *
+ * @param verts     The vertex positions
+ * @param indices   The triangulation
+ * @param shapes    The vector to store the shapes
+ */
+static void decompose(const std::vector<Vec2>& verts, const std::vector<Uint32>& indices,
+                      std::vector<b2PolygonShape>& shapes) {
+    // Weld vertices by position, in case the triangles do not share indices
+    std::map<std::pair<float,float>,Uint32> welds;
+    std::vector<Uint32> remap(verts.size());
+    for(size_t ii = 0; ii < verts.size(); ii++) {
+        auto key = std::make_pair(verts[ii].x,verts[ii].y);
+        remap[ii] = welds.emplace(key,(Uint32)ii).first->second;
+    }
+    
+    std::vector<std::vector<Uint32>> polys;
+    b2Vec2 triangle[3];
+    for(size_t ii = 0; ii+2 < indices.size(); ii += 3) {
+        std::vector<Uint32> poly(3);
+        for(int jj = 0; jj < 3; jj++) {
+            poly[jj] = remap[indices[ii+jj]];
+            triangle[jj].Set(verts[poly[jj]].x,verts[poly[jj]].y);
+        }
+        // Only add non-degenerate triangles
+        if (valid_shape(triangle, 3)) {
+            if (turn(verts[poly[0]],verts[poly[1]],verts[poly[2]]) < 0) {
+                std::swap(poly[1],poly[2]);
+            }
+            polys.push_back(std::move(poly));
+        }
+    }
+    
+    std::vector<bool> alive(polys.size(),true);
+    std::vector<Uint32> merged;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::map<std::pair<Uint32,Uint32>,size_t> edges;
+        for(size_t ii = 0; ii < polys.size(); ii++) {
+            if (!alive[ii]) {
+                continue;
+            }
+            const std::vector<Uint32>& poly = polys[ii];
+            for(size_t jj = 0; jj < poly.size(); jj++) {
+                edges[std::make_pair(poly[jj],poly[(jj+1) % poly.size()])] = ii;
+            }
+        }
+        
+        std::vector<bool> touched(polys.size(),false);
+        for(size_t ii = 0; ii < polys.size(); ii++) {
+            if (!alive[ii] || touched[ii]) {
+                continue;
+            }
+            const std::vector<Uint32>& poly = polys[ii];
+            for(size_t jj = 0; jj < poly.size(); jj++) {
+                Uint32 a = poly[jj];
+                Uint32 b = poly[(jj+1) % poly.size()];
+                auto it = edges.find(std::make_pair(b,a));
+                if (it == edges.end() || it->second == ii || !alive[it->second] || touched[it->second]) {
+                    continue;
+                }
+                const std::vector<Uint32>& other = polys[it->second];
+                size_t kk = 0;
+                while (kk < other.size() && !(other[kk] == b && other[(kk+1) % other.size()] == a)) {
+                    kk++;
+                }
+                if (kk < other.size() && merge_polygons(verts,poly,jj,other,kk,merged)) {
+                    alive[it->second] = false;
+                    touched[ii] = true;
+                    polys[ii] = merged;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    
+    b2Vec2 points[b2_maxPolygonVertices];
+    for(size_t ii = 0; ii < polys.size(); ii++) {
+        if (!alive[ii]) {
+            continue;
+        }
+        const std::vector<Uint32>& poly = polys[ii];
+        for(size_t jj = 0; jj < poly.size(); jj++) {
+            points[jj].Set(verts[poly[jj]].x,verts[poly[jj]].y);
+        }
+        shapes.emplace_back();
+        shapes.back().Set(points,(int32)poly.size());
+    }
+}
+
+#pragma mark -
+#pragma mark Polygon Shapes
+/**
+ * Returns the hash of the given geometry
+ *
+ * @param verts     The vertex positions
+ * @param indices   The triangulation
+ *
+ * @return the hash of the given geometry
+ */
+static Uint64 hash_geometry(const std::vector<Vec2>& verts, const std::vector<Uint32>& indices) {
+    Uint64 hash = HASH_BASIS;
+    for(auto it = verts.begin(); it != verts.end(); ++it) {
+        Uint32 bits[2];
+        std::memcpy(bits,&(it->x),sizeof(float));
+        std::memcpy(bits+1,&(it->y),sizeof(float));
+        hash = (hash ^ bits[0])*HASH_PRIME;
+        hash = (hash ^ bits[1])*HASH_PRIME;
+    }
+    for(auto it = indices.begin(); it != indices.end(); ++it) {
+        hash = (hash ^ *it)*HASH_PRIME;
+    }
+    return hash;
+}
+
+/** The shape cache, indexed by geometry hash */
+typedef std::unordered_map<Uint64, std::vector<std::weak_ptr<const PolygonShapes>>> ShapeCache;
+
+/**
+ * Returns the mutex for the shape cache
+ *
+ * @return the mutex for the shape cache
+ */
+static std::mutex& shape_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+/**
+ * Returns the shape cache
+ *
+ * This method must be called while holding the shape mutex.
+ *
+ * @return the shape cache
+ */
+static ShapeCache& shape_cache() {
+    static ShapeCache cache;
+    return cache;
+}
+
+/**
+ * Returns the shapes for the given polygon and origin.
+ *
+ * The shapes are relative to the origin, which is the position of the
+ * body. If these shapes are already in the cache, this method does not
+ * compute them again.
+ *
+ * @param poly      The polygon
+ * @param origin    The origin of the shapes
+ *
+ * @return the shapes for the given polygon and origin.
+ */
+std::shared_ptr<const PolygonShapes> PolygonShapes::get(const Poly2& poly, const Vec2 origin) {
+    std::shared_ptr<PolygonShapes> result = std::make_shared<PolygonShapes>();
+    result->_vertices.reserve(poly.vertices.size());
+    for(auto it = poly.vertices.begin(); it != poly.vertices.end(); ++it) {
+        result->_vertices.push_back(*it-origin);
+    }
+    result->_indices = poly.indices;
+    Uint64 hash = hash_geometry(result->_vertices,result->_indices);
+    
+    {
+        std::lock_guard<std::mutex> lock(shape_mutex());
+        std::vector<std::weak_ptr<const PolygonShapes>>& bucket = shape_cache()[hash];
+        for(auto it = bucket.begin(); it != bucket.end(); ++it) {
+            std::shared_ptr<const PolygonShapes> entry = it->lock();
+            if (entry != nullptr && entry->_vertices == result->_vertices &&
+                entry->_indices == result->_indices) {
+                return entry;
+            }
+        }
+    }
+    
+    // Decompose without the lock, as this is the expensive part
+    decompose(result->_vertices,result->_indices,result->_shapes);
+    
+    std::lock_guard<std::mutex> lock(shape_mutex());
+    std::vector<std::weak_ptr<const PolygonShapes>>& bucket = shape_cache()[hash];
+    for(auto it = bucket.begin(); it != bucket.end(); ) {
+        std::shared_ptr<const PolygonShapes> entry = it->lock();
+        if (entry == nullptr) {
+            it = bucket.erase(it);
+        } else if (entry->_vertices == result->_vertices && entry->_indices == result->_indices) {
+            // Another thread got here first
+            return entry;
+        } else {
+            ++it;
+        }
+    }
+    bucket.push_back(result);
+    return result;
+}
+
+/**
+ * Returns the number of shape sets currently in the cache.
+ *
+ * @return the number of shape sets currently in the cache.
+ */
+size_t PolygonShapes::getCacheSize() {
+    std::lock_guard<std::mutex> lock(shape_mutex());
+    ShapeCache& cache = shape_cache();
+    size_t result = 0;
+    for(auto it = cache.begin(); it != cache.end(); ) {
+        auto& bucket = it->second;
+        bucket.erase(std::remove_if(bucket.begin(), bucket.end(), [](const std::weak_ptr<const PolygonShapes>& entry) {
+            return entry.expired();
+        }), bucket.end());
+        result += bucket.size();
+        it = bucket.empty() ? cache.erase(it) : std::next(it);
+    }
+    return result;
+}
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -152,14 +454,7 @@ bool PolygonObstacle::initWithAnchor(const Poly2& poly, const Vec2 anchor) {
  */
 PolygonObstacle::~PolygonObstacle() {
     CUAssertLog(_body == nullptr, "You must deactive physics before deleting an object");
-    if (_shapes != nullptr) {
-        delete[] _shapes;
-        _shapes = nullptr;
-    }
-    if (_geoms != nullptr) {
-        delete[] _geoms;
-        _geoms = nullptr;
-    }
+    _shapes = nullptr;
 }
 
 
@@ -190,34 +485,8 @@ void PolygonObstacle::resize(const Size size) {
  * This must be called whenever the polygon is resized.
  */
 void PolygonObstacle::resetShapes() {
-    int ntris =  (int)_polygon.indices.size() / 3;
-    if (_shapes != nullptr) {
-        delete[] _shapes;
-    }
-    
-    Vec2 pos = getPosition();
-    _shapes = new b2PolygonShape[ntris];
-    b2Vec2 triangle[3];
-    int index = 0;
-    for(int ii = 0; ii < ntris; ii++) {
-        for(int jj = 0; jj < 3; jj++) {
-            Uint32 ind = _polygon.indices[3*ii+jj];
-            Vec2 temp = _polygon.vertices[ind]-pos;
-            triangle[jj].x = temp.x;
-            triangle[jj].y = temp.y;
-        }
-        // Only add non-degenerate triangles
-        if (valid_shape(triangle, 3)) {
-            _shapes[index++].Set(triangle,3);
-        }
-    }
-    ntris = index;
-    
-    if (_geoms == nullptr) {
-        _geoms = new b2Fixture*[ntris];
-        for(int ii = 0; ii < ntris; ii++) { _geoms[ii] = nullptr; }
-        _fixCount = ntris;
-    } else {
+    _shapes = PolygonShapes::get(_polygon,getPosition());
+    if (_body != nullptr) {
         markDirty(true);
     }
 }
@@ -300,14 +569,13 @@ void PolygonObstacle::createFixtures() {
         return;
     }
     
-    // Create the fixtures
+    // Create the fixtures (Box2D copies each shape)
     releaseFixtures();
-    if (_geoms == nullptr) {
-        _geoms = new b2Fixture*[_fixCount];
-    }
-    for(int ii = 0; ii < _fixCount; ii++) {
-        _fixture.shape = &(_shapes[ii]);
-        _geoms[ii] = _body->CreateFixture(&_fixture);
+    size_t count = (_shapes == nullptr ? 0 : _shapes->size());
+    _geoms.reserve(count);
+    for(size_t ii = 0; ii < count; ii++) {
+        _fixture.shape = _shapes->at(ii);
+        _geoms.push_back(_body->CreateFixture(&_fixture));
     }
     markDirty(false);
 }
@@ -318,14 +586,10 @@ void PolygonObstacle::createFixtures() {
  * This is the primary method to override for custom physics objects
  */
 void PolygonObstacle::releaseFixtures() {
-    if (_geoms != nullptr && _geoms[0] != nullptr) {
-        for(int ii = 0; ii < _fixCount; ii++) {
-            _body->DestroyFixture(_geoms[ii]);
-            _geoms[ii] = nullptr;
+    if (_body != nullptr) {
+        for(auto it = _geoms.begin(); it != _geoms.end(); ++it) {
+            _body->DestroyFixture(*it);
         }
     }
-    if (_geoms != nullptr) {
-        delete[] _geoms;
-        _geoms = nullptr;
-    }
+    _geoms.clear();
 }
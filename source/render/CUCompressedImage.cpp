@@ -0,0 +1,458 @@
+//
+//  CUCompressedImage.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides support for GPU-compressed images (ETC2, ASTC, and the
+//  BCn formats) stored in KTX or KTX2 containers. These images are uploaded to
+//  the graphics card as is, without any decoding. They use a fraction of the
+//  memory of an RGBA texture, and they load much faster.
+//
+//  Reading an image is separate from creating a texture. It does not use
+//  OpenGL, so it is safe to do outside of the main thread. See the class
+//  Texture for how to turn one of these images into a texture.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <SDL.h>
+#include <cstring>
+#include <algorithm>
+#include <cugl/render/CUCompressedImage.h>
+#include <cugl/util/CUDebug.h>
+#include <cugl/util/CUStrings.h>
+#include <cugl/io/CUAssetBundle.h>
+
+using namespace cugl;
+
+// Not every platform header defines the compressed formats
+#ifndef GL_COMPRESSED_RGB8_ETC2
+    #define GL_COMPRESSED_RGB8_ETC2                     0x9274
+    #define GL_COMPRESSED_SRGB8_ETC2                    0x9275
+    #define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9276
+    #define GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9277
+    #define GL_COMPRESSED_RGBA8_ETC2_EAC                0x9278
+    #define GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC         0x9279
+    #define GL_COMPRESSED_R11_EAC                       0x9270
+    #define GL_COMPRESSED_RG11_EAC                      0x9272
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+    #define GL_COMPRESSED_RGBA_ASTC_4x4_KHR             0x93B0
+    #define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR     0x93D0
+#endif
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    #define GL_COMPRESSED_RGB_S3TC_DXT1_EXT             0x83F0
+    #define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT            0x83F1
+    #define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT            0x83F2
+    #define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT            0x83F3
+#endif
+#ifndef GL_COMPRESSED_RED_RGTC1
+    #define GL_COMPRESSED_RED_RGTC1                     0x8DBB
+    #define GL_COMPRESSED_RG_RGTC2                      0x8DBD
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+    #define GL_COMPRESSED_RGBA_BPTC_UNORM               0x8E8C
+    #define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM         0x8E8D
+#endif
+
+/** The size of a KTX (version 1) header */
+#define KTX_HEADER_SIZE     64
+/** The size of a KTX2 header, including the index (but not the level index) */
+#define KTX2_HEADER_SIZE    80
+/** The KTX endianness tag in the native order of the file */
+#define KTX_ENDIAN_TAG      0x04030201
+
+/** The identifier at the start of a KTX (version 1) file */
+static const unsigned char KTX_IDENTIFIER[12] = {
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+/** The identifier at the start of a KTX2 file */
+static const unsigned char KTX2_IDENTIFIER[12] = {
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+/**
+ * Returns the 32 bit value at the given position.
+ *
+ * The value is little-endian unless swap is true.
+ *
+ * @param bytes The file contents
+ * @param pos   The position of the value
+ * @param swap  Whether to reverse the byte order
+ *
+ * @return the 32 bit value at the given position.
+ */
+static Uint32 read_uint32(const std::vector<char>& bytes, size_t pos, bool swap=false) {
+    Uint32 value;
+    std::memcpy(&value,bytes.data()+pos,sizeof(Uint32));
+    value = SDL_SwapLE32(value);
+    return swap ? SDL_Swap32(value) : value;
+}
+
+/**
+ * Returns the 64 bit little-endian value at the given position.
+ *
+ * @param bytes The file contents
+ * @param pos   The position of the value
+ *
+ * @return the 64 bit little-endian value at the given position.
+ */
+static Uint64 read_uint64(const std::vector<char>& bytes, size_t pos) {
+    Uint64 value;
+    std::memcpy(&value,bytes.data()+pos,sizeof(Uint64));
+    return SDL_SwapLE64(value);
+}
+
+/**
+ * Returns the OpenGL internal format for the given Vulkan format.
+ *
+ * KTX2 files identify their format with the Vulkan enumeration. This
+ * function returns 0 if the format is not a supported compressed format.
+ *
+ * @param vkformat  The Vulkan format
+ *
+ * @return the OpenGL internal format for the given Vulkan format.
+ */
+static GLenum vulkan_format(Uint32 vkformat) {
+    switch (vkformat) {
+        case 131: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case 133: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case 135: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+        case 137: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case 139: return GL_COMPRESSED_RED_RGTC1;
+        case 141: return GL_COMPRESSED_RG_RGTC2;
+        case 145: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case 146: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+        case 147: return GL_COMPRESSED_RGB8_ETC2;
+        case 148: return GL_COMPRESSED_SRGB8_ETC2;
+        case 149: return GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+        case 150: return GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+        case 151: return GL_COMPRESSED_RGBA8_ETC2_EAC;
+        case 152: return GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+        case 153: return GL_COMPRESSED_R11_EAC;
+        case 155: return GL_COMPRESSED_RG11_EAC;
+        default:
+            break;
+    }
+
+    // ASTC blocks come in unorm/srgb pairs, in the same order as OpenGL
+    if (vkformat >= 157 && vkformat <= 184) {
+        Uint32 block = (vkformat-157)/2;
+        if (vkformat % 2 == 1) {
+            return GL_COMPRESSED_RGBA_ASTC_4x4_KHR+block;
+        } else {
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR+block;
+        }
+    }
+    return 0;
+}
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Deletes the image data and resets all attributes.
+ *
+ * You must reinitialize the image to use it.
+ */
+void CompressedImage::dispose() {
+    _format = 0;
+    _width  = 0;
+    _height = 0;
+    _data.clear();
+    _offsets.clear();
+    _sizes.clear();
+}
+
+/**
+ * Initializes this image with the contents of the given file.
+ *
+ * The file must be a KTX or KTX2 container (detected from its contents,
+ * not its extension). The path is used as is, and is not resolved against
+ * the asset directory. This method does not use OpenGL, and so it is safe
+ * to call outside of the main thread.
+ *
+ * @param path  The path to the file
+ *
+ * @return true if initialization was successful.
+ */
+bool CompressedImage::init(const std::string& path) {
+    if (_format) {
+        CUAssertLog(false, "Image is already initialized");
+        return false;
+    }
+
+    SDL_RWops* file = AssetBundle::openStream(path);
+    if (file == nullptr) {
+        CULogError("Could not open file %s. %s", path.c_str(), SDL_GetError());
+        return false;
+    }
+    Sint64 length = SDL_RWsize(file);
+    std::vector<char> bytes(length > 0 ? (size_t)length : 0);
+    size_t amount = bytes.empty() ? 0 : SDL_RWread(file, bytes.data(), 1, bytes.size());
+    SDL_RWclose(file);
+    if (amount != bytes.size() || bytes.size() < 12) {
+        CULogError("Could not read file %s.", path.c_str());
+        return false;
+    }
+
+    bool success = false;
+    if (std::memcmp(bytes.data(), KTX_IDENTIFIER, 12) == 0) {
+        success = parseKTX(bytes);
+    } else if (std::memcmp(bytes.data(), KTX2_IDENTIFIER, 12) == 0) {
+        success = parseKTX2(bytes);
+    } else {
+        CULogError("File %s is not a KTX container.", path.c_str());
+        return false;
+    }
+
+    if (!success) {
+        CULogError("File %s is not a supported compressed image.", path.c_str());
+        dispose();
+        return false;
+    }
+    _data = std::move(bytes);
+    return true;
+}
+
+/**
+ * Returns true if the bytes are a valid KTX (version 1) image.
+ *
+ * If successful, this method initializes the format, size, and levels of
+ * this image. It does not copy the data.
+ *
+ * @param bytes The file contents
+ *
+ * @return true if the bytes are a valid KTX (version 1) image.
+ */
+bool CompressedImage::parseKTX(const std::vector<char>& bytes) {
+    if (bytes.size() < KTX_HEADER_SIZE) {
+        return false;
+    }
+    bool swap = read_uint32(bytes,12) != KTX_ENDIAN_TAG;
+    Uint32 gltype   = read_uint32(bytes,16,swap);
+    Uint32 internal = read_uint32(bytes,28,swap);
+    Uint32 width    = read_uint32(bytes,36,swap);
+    Uint32 height   = read_uint32(bytes,40,swap);
+    Uint32 depth    = read_uint32(bytes,44,swap);
+    Uint32 elements = read_uint32(bytes,48,swap);
+    Uint32 faces    = read_uint32(bytes,52,swap);
+    Uint32 levels   = read_uint32(bytes,56,swap);
+    Uint32 keyvalue = read_uint32(bytes,60,swap);
+
+    // Compressed 2d images only
+    if (gltype != 0 || getFamily(internal) == Family::NONE) {
+        return false;
+    } else if (depth > 1 || elements > 0 || faces != 1 || width == 0 || height == 0) {
+        return false;
+    }
+
+    _format = internal;
+    _width  = width;
+    _height = height;
+    size_t pos = (size_t)KTX_HEADER_SIZE+keyvalue;
+    levels = std::max(levels,(Uint32)1);
+    for(Uint32 ii = 0; ii < levels; ii++) {
+        if (pos+4 > bytes.size()) {
+            return false;
+        }
+        size_t size = read_uint32(bytes,pos,swap);
+        pos += 4;
+        if (pos+size > bytes.size()) {
+            return false;
+        }
+        _offsets.push_back(pos);
+        _sizes.push_back(size);
+        pos += (size+3) & ~(size_t)3;
+    }
+    return true;
+}
+
+/**
+ * Returns true if the bytes are a valid KTX2 image.
+ *
+ * If successful, this method initializes the format, size, and levels of
+ * this image. It does not copy the data.
+ *
+ * @param bytes The file contents
+ *
+ * @return true if the bytes are a valid KTX2 image.
+ */
+bool CompressedImage::parseKTX2(const std::vector<char>& bytes) {
+    if (bytes.size() < KTX2_HEADER_SIZE) {
+        return false;
+    }
+    GLenum format   = vulkan_format(read_uint32(bytes,12));
+    Uint32 width    = read_uint32(bytes,20);
+    Uint32 height   = read_uint32(bytes,24);
+    Uint32 depth    = read_uint32(bytes,28);
+    Uint32 layers   = read_uint32(bytes,32);
+    Uint32 faces    = read_uint32(bytes,36);
+    Uint32 levels   = read_uint32(bytes,40);
+    Uint32 scheme   = read_uint32(bytes,44);
+
+    // Compressed 2d images only, and no supercompression
+    if (format == 0 || scheme != 0) {
+        return false;
+    } else if (depth > 1 || layers > 1 || faces != 1 || width == 0 || height == 0) {
+        return false;
+    }
+
+    _format = format;
+    _width  = width;
+    _height = height;
+    levels  = std::max(levels,(Uint32)1);
+    if (KTX2_HEADER_SIZE+levels*24 > bytes.size()) {
+        return false;
+    }
+    for(Uint32 ii = 0; ii < levels; ii++) {
+        size_t entry  = KTX2_HEADER_SIZE+ii*24;
+        Uint64 offset = read_uint64(bytes,entry);
+        Uint64 size   = read_uint64(bytes,entry+8);
+        if (offset+size > bytes.size()) {
+            return false;
+        }
+        _offsets.push_back((size_t)offset);
+        _sizes.push_back((size_t)size);
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Platform Support
+/**
+ * Returns the compression family of the given format
+ *
+ * If the format is not a recognized compressed format, this method
+ * returns {@link Family#NONE}.
+ *
+ * @param format    The OpenGL internal format
+ *
+ * @return the compression family of the given format
+ */
+CompressedImage::Family CompressedImage::getFamily(GLenum format) {
+    if (format >= GL_COMPRESSED_R11_EAC && format <= GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC) {
+        return Family::ETC2;
+    } else if (format >= GL_COMPRESSED_RGBA_ASTC_4x4_KHR && format <= GL_COMPRESSED_RGBA_ASTC_4x4_KHR+13) {
+        return Family::ASTC;
+    } else if (format >= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR &&
+               format <= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR+13) {
+        return Family::ASTC;
+    }
+
+    switch (format) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_RG_RGTC2:
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+            return Family::BC;
+        default:
+            break;
+    }
+    return Family::NONE;
+}
+
+/**
+ * Returns true if this device can use the given compressed format.
+ *
+ * This method queries the formats supported by the OpenGL context, and so
+ * it must be called in the main thread. The query is only performed once.
+ *
+ * @param format    The OpenGL internal format
+ *
+ * @return true if this device can use the given compressed format.
+ */
+bool CompressedImage::isSupported(GLenum format) {
+    static std::vector<GLint> formats;
+    static bool queried = false;
+    if (!queried) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+        formats.resize(count);
+        if (count > 0) {
+            glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+        }
+        queried = true;
+    }
+
+#if CU_GL_PLATFORM == CU_GL_OPENGLES
+    // Required by the OpenGLES 3 specification, even if not listed
+    if (getFamily(format) == Family::ETC2) {
+        return true;
+    }
+#endif
+    return std::find(formats.begin(), formats.end(), (GLint)format) != formats.end();
+}
+
+/**
+ * Returns true if this device supports the given compression family.
+ *
+ * A family is supported if its most common format is supported. This
+ * method queries the formats supported by the OpenGL context, and so it
+ * must be called in the main thread.
+ *
+ * @param family    The compression family
+ *
+ * @return true if this device supports the given compression family.
+ */
+bool CompressedImage::isSupported(Family family) {
+    switch (family) {
+        case Family::ETC2:
+            return isSupported(GL_COMPRESSED_RGBA8_ETC2_EAC);
+        case Family::ASTC:
+            return isSupported(GL_COMPRESSED_RGBA_ASTC_4x4_KHR);
+        case Family::BC:
+            return isSupported(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ||
+                   isSupported(GL_COMPRESSED_RGBA_BPTC_UNORM);
+        default:
+            break;
+    }
+    return false;
+}
+
+/**
+ * Returns true if the given file name is a KTX or KTX2 container
+ *
+ * This method only checks the file extension.
+ *
+ * @param path  The file name
+ *
+ * @return true if the given file name is a KTX or KTX2 container
+ */
+bool CompressedImage::isContainer(const std::string& path) {
+    std::string lower = strtool::tolower(path);
+    return strtool::ends_with(lower, ".ktx") || strtool::ends_with(lower, ".ktx2");
+}
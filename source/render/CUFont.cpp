@@ -48,6 +48,8 @@
 #include <utf8/utf8.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUFiletools.h>
+#include <cugl/util/CUProfiler.h>
+#include <cugl/io/CUAssetBundle.h>
 #include <cugl/util/CUStrings.h>
 #include <cugl/render/CUTexture.h>
 #include <cugl/render/CUFont.h>
@@ -66,6 +68,10 @@ using namespace cugl;
 #define SPACE_CHAR      32
 /** The number of spaces to a tab character */
 #define TAB_SPACE       4
+/** The distance (in pixels, beyond the padding) encoded by a distance field */
+#define SDF_SPREAD      4
+/** The squared distance for pixels with no edge in range */
+#define SDF_INFINITY    1e20f
 
 /**
  * Returns true if thechar is a Unicode control character
@@ -94,6 +100,121 @@ static bool is_whitespace(Uint32 thechar) {
 }
 
 
+/**
+ * Computes the squared distance transform of a line of samples.
+ *
+ * This is the linear time algorithm of Felzenszwalb and Huttenlocher. Each
+ * sample is replaced by the minimum (squared) distance to a zero sample,
+ * plus that sample value. The scratch buffers must have size at least n
+ * (and n+1 for the boundaries).
+ *
+ * @param grid      The samples to transform
+ * @param n         The number of samples
+ * @param stride    The distance between samples in the grid
+ * @param f         Scratch space for the samples
+ * @param v         Scratch space for the parabola locations
+ * @param z         Scratch space for the parabola boundaries
+ */
+static void distance_line(float* grid, int n, int stride, float* f, int* v, float* z) {
+    for(int q = 0; q < n; q++) {
+        f[q] = grid[q*stride];
+    }
+    
+    int k = 0;
+    v[0] = 0;
+    z[0] = -SDF_INFINITY;
+    z[1] =  SDF_INFINITY;
+    for(int q = 1; q < n; q++) {
+        float s = ((f[q]+q*q)-(f[v[k]]+v[k]*v[k]))/(2*q-2*v[k]);
+        while (k > 0 && s <= z[k]) {
+            k--;
+            s = ((f[q]+q*q)-(f[v[k]]+v[k]*v[k]))/(2*q-2*v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k+1] = SDF_INFINITY;
+    }
+    
+    k = 0;
+    for(int q = 0; q < n; q++) {
+        while (z[k+1] < q) {
+            k++;
+        }
+        grid[q*stride] = (q-v[k])*(q-v[k])+f[v[k]];
+    }
+}
+
+/**
+ * Computes the squared distance transform of the given grid.
+ *
+ * Samples of value 0 are the sites. All other samples should have the
+ * value SDF_INFINITY on input, and are replaced by their squared distance
+ * to the nearest site.
+ *
+ * @param grid      The samples to transform
+ * @param width     The grid width
+ * @param height    The grid height
+ */
+static void distance_grid(std::vector<float>& grid, int width, int height) {
+    int size = std::max(width,height);
+    std::vector<float> f(size);
+    std::vector<int> v(size);
+    std::vector<float> z(size+1);
+    for(int x = 0; x < width; x++) {
+        distance_line(grid.data()+x, height, width, f.data(), v.data(), z.data());
+    }
+    for(int y = 0; y < height; y++) {
+        distance_line(grid.data()+y*width, width, 1, f.data(), v.data(), z.data());
+    }
+}
+
+/**
+ * Converts the alpha channel of the surface to a signed distance field.
+ *
+ * Afterwards, the alpha of each pixel is 0.5 on the edge of a glyph,
+ * increasing inside the glyph and decreasing outside, reaching 1 and 0 at
+ * the given spread. The color channels are set to white.
+ *
+ * @param surface   The atlas surface
+ * @param spread    The distance (in pixels) from the edge to each extreme
+ */
+static void make_distance_field(SDL_Surface* surface, Uint32 spread) {
+    int width  = surface->w;
+    int height = surface->h;
+    Uint32 amask  = surface->format->Amask;
+    Uint32 ashift = surface->format->Ashift;
+
+    SDL_LockSurface(surface);
+    Uint8* pixels = (Uint8*)surface->pixels;
+    std::vector<float> outer(width*height);
+    std::vector<float> inner(width*height);
+    for(int y = 0; y < height; y++) {
+        const Uint32* row = (const Uint32*)(pixels+y*surface->pitch);
+        for(int x = 0; x < width; x++) {
+            bool inside = ((row[x] & amask) >> ashift) >= 128;
+            outer[y*width+x] = inside ? 0 : SDF_INFINITY;
+            inner[y*width+x] = inside ? SDF_INFINITY : 0;
+        }
+    }
+    distance_grid(outer,width,height);
+    distance_grid(inner,width,height);
+
+    // Pixels on either side of the edge are half a pixel from it
+    float scale = 0.5f/spread;
+    for(int y = 0; y < height; y++) {
+        Uint32* row = (Uint32*)(pixels+y*surface->pitch);
+        for(int x = 0; x < width; x++) {
+            float inside  = std::sqrt(inner[y*width+x]);
+            float outside = std::sqrt(outer[y*width+x]);
+            float dist = inside > 0 ? inside-0.5f : 0.5f-outside;
+            float value = std::min(std::max(0.5f+dist*scale,0.0f),1.0f);
+            row[x] = (~amask) | (((Uint32)(value*255+0.5f)) << ashift);
+        }
+    }
+    SDL_UnlockSurface(surface);
+}
+
 #pragma mark -
 #pragma mark Atlas
 /**
@@ -123,6 +244,7 @@ void Font::Atlas::dispose() {
 	_size = Size::ZERO;
     texture = nullptr;
 	glyphmap.clear();
+    _cursor.clear();
 }
         
 /**
@@ -414,10 +536,12 @@ void Font::Atlas::getQuad(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex2>& mes
  * @return true if atlas creation was successful
  */
 bool Font::Atlas::build() {
+    CU_PROFILE_SCOPE("Font::Atlas::build");
     _surface = allocSurface(_size.width, _size.height);
     if (_surface == nullptr) {
         return false;
     }
+    CU_PROFILE_BYTES((Uint64)_surface->pitch*_surface->h);
     
     SDL_Rect srcrect, dstrect;
     SDL_Color color;
@@ -456,6 +580,9 @@ bool Font::Atlas::build() {
         SDL_FreeSurface(temp);
     }
     
+    if (_parent->_distanceField) {
+        make_distance_field(_surface, SDF_SPREAD+_parent->_atlasPadding);
+    }
     return true;
 }
 
@@ -479,6 +606,92 @@ bool Font::Atlas::materialize() {
     return texture != nullptr;
 }
 
+/**
+ * Adds the given glyphs to the free space of this materialized atlas.
+ *
+ * Each glyph is placed at the end of the first glyph row with enough
+ * room, and is rendered directly into that region of the texture. The
+ * texture is not resized and no other glyphs are touched. This method
+ * will consume glyphs from the provided glyphset as it places them.
+ * So if it successfully adds all glyphs, the value glyphset will be
+ * emptied. Any remaining glyphs must be processed by another atlas.
+ *
+ * This method must be called on the main thread. It is only safe to
+ * call this method after a succesful call to {@link #materialize()}.
+ *
+ * @param glyphset  The glyphs to add to this atlas
+ *
+ * @return true if any glyph was added to this atlas
+ */
+bool Font::Atlas::extend(std::deque<Uint32>& glyphset) {
+    if (texture == nullptr || _cursor.empty()) {
+        return false;
+    }
+    
+    float padding = _parent->_atlasPadding;
+    float h = _parent->_fontHeight+GLYPH_BORDER+2*padding;
+    
+    SDL_Rect srcrect, dstrect;
+    SDL_Color color;
+    color.r = color.g = color.b = color.a = 255;
+
+    bool added = false;
+    texture->bind();
+    for(auto it = glyphset.begin(); it != glyphset.end(); ) {
+        float w = _parent->getMetrics(*it).advance+GLYPH_BORDER+2*padding;
+        size_t line = 0;
+        while (line < _cursor.size() && w >= _size.width-_cursor[line]) {
+            line++;
+        }
+        if (line == _cursor.size()) {
+            ++it;
+            continue;
+        }
+        
+        SDL_Surface* temp = TTF_RenderGlyph32_Blended(_parent->_data, *it, color);
+        if (temp == nullptr) {
+            ++it;
+            continue;
+        }
+        
+        // Same boundary as build
+        Rect bounds(_cursor[line],line*h,w,h);
+        _cursor[line] += w;
+        bounds.origin.x += GLYPH_BORDER/2;
+        bounds.origin.y += GLYPH_BORDER/2;
+        bounds.size.width  -= GLYPH_BORDER;
+        bounds.size.height -= GLYPH_BORDER;
+        
+        SDL_Surface* cell = allocSurface((int)bounds.size.width, (int)bounds.size.height);
+        if (cell != nullptr) {
+            dstrect.x = dstrect.y = (int)padding;
+            srcrect.x = srcrect.y = 0;
+            dstrect.w = srcrect.w = (int)bounds.size.width-2*padding;
+            dstrect.h = srcrect.h = (int)bounds.size.height-2*padding;
+            SDL_SetSurfaceBlendMode(temp, SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(temp,&srcrect,cell,&dstrect);
+            if (_parent->_distanceField) {
+                make_distance_field(cell, SDF_SPREAD+_parent->_atlasPadding);
+            }
+            
+            texture->set(cell->pixels, (int)bounds.origin.x, (int)bounds.origin.y, cell->w, cell->h);
+            glyphmap.emplace(*it, bounds);
+            SDL_FreeSurface(cell);
+            added = true;
+            it = glyphset.erase(it);
+        } else {
+            ++it;
+        }
+        SDL_FreeSurface(temp);
+    }
+    
+    if (added && texture->hasMipMaps()) {
+        texture->buildMipMaps();
+    }
+    texture->unbind();
+    return added;
+}
+
 /**
  * Lays out the glyphs in reasonably efficient packing.
  *
@@ -562,6 +775,9 @@ void Font::Atlas::layout(std::deque<Uint32>& glyphset) {
             }
         }
     }
+    
+    // Remember the free space for extend
+    _cursor = used;
 }
 
 /**
@@ -616,9 +832,11 @@ _fontAscent(0),
 _fontDescent(0),
 _fontLineSkip(0),
 _atlasPadding(0),
+_distanceField(false),
 _shrinkLimit(0),
 _stretchLimit(0),
 _fallback(false),
+_paging(false),
 _fixedWidth(false),
 _useKerning(true),
 _style(Style::NORMAL),
@@ -643,6 +861,8 @@ void Font::dispose() {
     _fontDescent = 0;
     _fontLineSkip = 0;
     _atlasPadding = 0;
+    _distanceField = false;
+    _paging = false;
     _fixedWidth = false;
     _useKerning = true;
     _style  = Style::NORMAL;
@@ -671,7 +891,8 @@ bool Font::init(const std::string file, Uint32 size) {
         return false;
     }
     std::string fullpath = filetool::normalize_path(file);
-    _data = TTF_OpenFont(fullpath.c_str(), size);
+    SDL_RWops* stream = AssetBundle::openStream(fullpath);
+    _data = stream ? TTF_OpenFontRW(stream, 1, size) : nullptr;
     if (_data == nullptr) {
         CUAssertLog(false, "Font initialization error: %s", TTF_GetError());
         return false;
@@ -830,6 +1051,32 @@ void Font::setPadding(Uint32 padding) {
     }
 }
 
+/**
+ * Sets whether the atlases of this font are signed distance fields.
+ *
+ * A normal atlas stores the coverage of each glyph, rasterized at the size
+ * of this font. Scaling the text will blur or pixellate it. A distance
+ * field atlas instead stores the distance from each pixel to the edge of a
+ * glyph. When drawn by a {@link SpriteBatch} (which detects these atlases
+ * in its text methods), the edges are reconstructed in the shader and stay
+ * sharp at any scale. So one font (loaded at the largest size needed) can
+ * serve every UI scale, instead of loading the same file at several sizes.
+ *
+ * Distance field atlases are single color, and the glyph corners are
+ * slightly rounded at large scales. The padding (see {@link #setPadding})
+ * and fallback atlases (see {@link #setAtlasFallback}) work as before, but
+ * blur effects are softer. Reseting this value will clear any existing
+ * atlas collection.
+ *
+ * @param field    Whether the atlases of this font are signed distance fields
+ */
+void Font::setDistanceField(bool field) {
+    if (_distanceField != field) {
+        _distanceField = field;
+        clearAtlases();
+    }
+}
+
 #pragma mark -
 #pragma mark Measurements
 /**
@@ -1550,6 +1797,108 @@ bool Font::storeAtlases() {
     
     return success;
 }
+
+/**
+ * Adds any missing glyphs in the given text to the atlas collection.
+ *
+ * Glyphs that are already in an atlas, or that are not provided by this
+ * font, are ignored. The remaining glyphs are rendered into the free rows
+ * of the existing atlas textures. Only when these are full does this
+ * method create a new atlas. So adding a few glyphs at a time (such as
+ * the text of each new label) never rebuilds an existing texture.
+ *
+ * The text should be in UTF8 or ASCII format.
+ *
+ * WARNING: This method is not thread safe.  It generates OpenGL textures,
+ * which means that it may only be called in the main thread.
+ *
+ * @param text  The text with the glyphs to add (as UTF8 or ASCII)
+ *
+ * @return true if all provided glyphs in the text have atlas support.
+ */
+bool Font::addGlyphs(const std::string& text) {
+    std::vector<Uint32> charset;
+    const char* begin = text.c_str();
+    const char* end = begin+text.size();
+    while (begin != end) {
+        Uint32 thechar = utf8::next(begin,end);
+        if (_atlasmap.find(thechar) == _atlasmap.end()) {
+            charset.push_back(thechar);
+        }
+    }
+    if (charset.empty()) {
+        return true;
+    }
+    
+    // Layout assumes no duplicates
+    std::sort(charset.begin(),charset.end());
+    charset.erase(std::unique(charset.begin(),charset.end()),charset.end());
+    return addGlyphs(charset);
+}
+
+/**
+ * Adds any missing glyphs in the given character set to the atlas collection.
+ *
+ * Glyphs that are already in an atlas, or that are not provided by this
+ * font, are ignored. The remaining glyphs are rendered into the free rows
+ * of the existing atlas textures. Only when these are full does this
+ * method create a new atlas. So adding a few glyphs at a time (such as
+ * the text of each new label) never rebuilds an existing texture.
+ *
+ * The character set provided must be a collection of UNICODE encodings.
+ * The Unicode representation uses the endianness native to the platform.
+ * Therefore, this value should not be serialized. Use UTF8 to represent
+ * unicode in a platform-independent manner.
+ *
+ * WARNING: This method is not thread safe.  It generates OpenGL textures,
+ * which means that it may only be called in the main thread.
+ *
+ * @param charset   The characters to add (as UNICODE)
+ *
+ * @return true if all provided glyphs in the set have atlas support.
+ */
+bool Font::addGlyphs(const std::vector<Uint32>& charset) {
+    std::deque<Uint32> glyphs = gatherGlyphs(charset);
+    if (glyphs.empty()) {
+        return true;
+    }
+    gatherKerning(glyphs);
+    
+    // Fill the existing pages first
+    for(size_t pos = 0; !glyphs.empty() && pos < _atlases.size(); pos++) {
+        std::shared_ptr<Atlas> atlas = _atlases[pos];
+        std::deque<Uint32> pending = glyphs;
+        if (atlas->extend(glyphs)) {
+            for(auto it = pending.begin(); it != pending.end(); ++it) {
+                if (atlas->hasGlyph(*it)) {
+                    _atlasmap.emplace(*it,pos);
+                    if (*it == SPACE_CHAR) {
+                        _atlasmap.emplace(TAB_CHAR,pos);
+                    }
+                }
+            }
+        }
+    }
+    
+    // Only make new pages for the overflow
+    bool success = true;
+    while (success && glyphs.size() > 0) {
+        std::shared_ptr<Atlas> atlas = Atlas::alloc(this, glyphs);
+        success = atlas != nullptr && atlas->build() && atlas->materialize();
+        if (success) {
+            size_t pos = _atlases.size();
+            _atlases.push_back(atlas);
+            for(auto it = atlas->glyphmap.begin(); it != atlas->glyphmap.end(); ++it) {
+                _atlasmap.emplace(it->first,pos);
+                if (it->first == SPACE_CHAR) {
+                    _atlasmap.emplace(TAB_CHAR,pos);
+                }
+            }
+        }
+    }
+    
+    return success;
+}
 /**
  * Returns the OpenGL textures for the associated atlas collection.
  *
@@ -2097,40 +2446,31 @@ size_t Font::getGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& ru
             }
             prvchar = thechar;
 
-            std::shared_ptr<GlyphRun> grun;
-            std::shared_ptr<Atlas> atlas;
-
-            bool found = false;
-            if (_atlasmap.find(thechar) != _atlasmap.end()) {
-                size_t index = _atlasmap[thechar];
-                atlas = _atlases[index];
-                GLuint key = atlas->texture->getBuffer();
-                auto find = runs.find(key);
-                if (find == runs.end()) {
-                    grun = GlyphRun::alloc();
-                    grun->texture = atlas->texture;
-                    runs[key] = grun;
-                } else {
-                    grun = find->second;
-                }
-                found = true;
-            } else if (localmap.find(thechar) != localmap.end()) {
-                size_t index = localmap[thechar];
-                atlas = locals[index];
-                GLuint key = atlas->texture->getBuffer();
-                auto find = runs.find(key);
-                if (find == runs.end()) {
-                    grun = GlyphRun::alloc();
-                    grun->texture = atlas->texture;
-                    runs[key] = grun;
-                } else {
-                    grun = find->second;
+            // Raw pointers avoid reference counting on every glyph
+            GlyphRun* grun = nullptr;
+            const Atlas* atlas = nullptr;
+            
+            auto entry = _atlasmap.find(thechar);
+            if (entry != _atlasmap.end()) {
+                atlas = _atlases[entry->second].get();
+            } else {
+                auto local = localmap.find(thechar);
+                if (local != localmap.end()) {
+                    atlas = locals[local->second].get();
                 }
-                found = true;
             }
      
-            if (found && atlas->getQuad(thechar,offset,grun->mesh,bounds)) {
-                grun->contents.emplace(thechar);
+            if (atlas != nullptr) {
+                // Append to the existing run for this atlas (if any)
+                std::shared_ptr<GlyphRun>& slot = runs[atlas->texture->getBuffer()];
+                if (slot == nullptr) {
+                    slot = GlyphRun::alloc();
+                    slot->texture = atlas->texture;
+                }
+                grun = slot.get();
+            }
+            if (grun != nullptr && atlas->getQuad(thechar,offset,grun->mesh,bounds)) {
+                grun->contents.insert(thechar);
                 total++;
             }
         }
@@ -2148,27 +2488,26 @@ size_t Font::getGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& ru
             }
             prvchar = thechar;
             
-            std::shared_ptr<GlyphRun> grun;
-            std::shared_ptr<Atlas> atlas;
-
-            bool found = false;
-            if (_atlasmap.find(thechar) != _atlasmap.end()) {
-                size_t index = _atlasmap[thechar];
-                atlas = _atlases[index];
-                GLuint key = atlas->texture->getBuffer();
-                auto find = runs.find(key);
-                if (find == runs.end()) {
-                    grun = GlyphRun::alloc();
-                    grun->texture = atlas->texture;
-                    runs[key] = grun;
-                } else {
-                    grun = find->second;
-                }
-                found = true;
+            // Raw pointers avoid reference counting on every glyph
+            GlyphRun* grun = nullptr;
+            const Atlas* atlas = nullptr;
+            
+            auto entry = _atlasmap.find(thechar);
+            if (entry != _atlasmap.end()) {
+                atlas = _atlases[entry->second].get();
             }
      
-            if (found && atlas->getQuad(thechar,offset,grun->mesh,bounds)) {
-                grun->contents.emplace(thechar);
+            if (atlas != nullptr) {
+                // Append to the existing run for this atlas (if any)
+                std::shared_ptr<GlyphRun>& slot = runs[atlas->texture->getBuffer()];
+                if (slot == nullptr) {
+                    slot = GlyphRun::alloc();
+                    slot->texture = atlas->texture;
+                }
+                grun = slot.get();
+            }
+            if (grun != nullptr && atlas->getQuad(thechar,offset,grun->mesh,bounds)) {
+                grun->contents.insert(thechar);
                 total++;
             }
         }
@@ -2860,11 +3199,12 @@ std::deque<Uint32> Font::gatherGlyphs(const std::vector<Uint32>& charset) {
  */
 void Font::gatherKerning(const std::deque<Uint32>& glyphs) {
     for(auto it = _glyphsize.begin(); it != _glyphsize.end(); ++it) {
-        if (_kernmap.find(it->first) == _kernmap.end()) {
-            _kernmap.emplace(it->first, std::unordered_map<Uint32, Uint32>());
-        }
+        std::unordered_map<Uint32, Uint32>& kerning = _kernmap[it->first];
         for(auto jt = _glyphsize.begin(); jt != _glyphsize.end(); ++jt) {
-            _kernmap[it->first].emplace(jt->first, computeKerning(it->first, jt->first));
+            // Only query the font for new pairs
+            if (kerning.find(jt->first) == kerning.end()) {
+                kerning.emplace(jt->first, computeKerning(it->first, jt->first));
+            }
         }
     }
 }
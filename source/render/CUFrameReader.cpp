@@ -0,0 +1,444 @@
+//
+//  CUFrameReader.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides asynchronous readback of rendered frames, for tools
+//  such as screen capture, replays, and streaming. Reading the framebuffer
+//  directly with glReadPixels stalls the CPU until the GPU has finished every
+//  pending draw command. This class instead reads into pixel buffer objects,
+//  and waits on a fence for the transfer to complete. The pixels are handed
+//  to a callback a frame or two later, without ever blocking the render loop.
+//  Frames may be downscaled on the GPU first, which reduces the transfer.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/render/CUFrameReader.h>
+#include <cugl/render/CURenderState.h>
+#include <cugl/base/CUDisplay.h>
+#include <cugl/util/CUDebug.h>
+#include <cstring>
+
+using namespace cugl;
+
+/** The number of bytes in an RGBA pixel */
+#define PIXEL_BYTES     4
+/** The time (in nanoseconds) to wait on a transfer in each pass of a flush */
+#define FLUSH_TIMEOUT   1000000000
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates a degenerate frame reader.
+ *
+ * This object has not been initialized and cannot be used.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+FrameReader::FrameReader() :
+_head(0),
+_pending(0),
+_dropped(0),
+_scalebo(0),
+_scalerb(0),
+_scalew(0),
+_scaleh(0),
+_flipped(true) {
+}
+
+/**
+ * Disposes all of the resources used by this frame reader.
+ *
+ * Any reads in flight are abandoned, and their callbacks are never
+ * invoked. Use {@link #flush} first to deliver them. A disposed frame
+ * reader can be safely reinitialized.
+ */
+void FrameReader::dispose() {
+    for(auto it = _slots.begin(); it != _slots.end(); ++it) {
+        if (it->fence) {
+            glDeleteSync(it->fence);
+        }
+        if (it->buffer) {
+            renderstate::forgetBuffer(it->buffer);
+            glDeleteBuffers(1, &(it->buffer));
+        }
+    }
+    _slots.clear();
+    if (_scalebo) {
+        renderstate::forgetFramebuffer(_scalebo);
+        glDeleteFramebuffers(1, &_scalebo);
+        _scalebo = 0;
+    }
+    if (_scalerb) {
+        renderstate::forgetRenderbuffer(_scalerb);
+        glDeleteRenderbuffers(1, &_scalerb);
+        _scalerb = 0;
+    }
+    _scalew = 0;
+    _scaleh = 0;
+    _head = 0;
+    _pending = 0;
+    _dropped = 0;
+    _flipped = true;
+    _scratch.clear();
+    _scratch.shrink_to_fit();
+}
+
+/**
+ * Initializes a frame reader with the given number of pixel buffers.
+ *
+ * The number of buffers is the maximum number of reads in flight. Three
+ * buffers are enough to read every frame as long as the transfers finish
+ * within two frames.
+ *
+ * @param buffers   The number of pixel buffers
+ *
+ * @return true if initialization was successful.
+ */
+bool FrameReader::init(size_t buffers) {
+    if (!_slots.empty()) {
+        CUAssertLog(false, "Frame reader is already initialized");
+        return false;
+    } else if (buffers == 0) {
+        CUAssertLog(false, "Frame reader must have at least one buffer");
+        return false;
+    }
+
+    std::vector<GLuint> ids(buffers,0);
+    glGenBuffers((GLsizei)buffers, ids.data());
+    GLenum error = glGetError();
+    if (error) {
+        CULogError("Could not create pixel buffers. %s", gl_error_name(error).c_str());
+        return false;
+    }
+
+    _slots.resize(buffers);
+    for(size_t ii = 0; ii < buffers; ii++) {
+        Slot& slot = _slots[ii];
+        slot.buffer = ids[ii];
+        slot.capacity = 0;
+        slot.fence = 0;
+        slot.width = 0;
+        slot.height = 0;
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns true if the downscaling buffer has the given size.
+ *
+ * The buffer is (re)allocated if necessary.
+ *
+ * @param width     The buffer width
+ * @param height    The buffer height
+ *
+ * @return true if the downscaling buffer has the given size.
+ */
+bool FrameReader::prepareScale(int width, int height) {
+    if (_scalebo && _scalew == width && _scaleh == height) {
+        return true;
+    }
+
+    if (!_scalebo) {
+        glGenFramebuffers(1, &_scalebo);
+        glGenRenderbuffers(1, &_scalerb);
+    }
+    renderstate::bindRenderbuffer(_scalerb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    renderstate::bindFramebuffer(GL_DRAW_FRAMEBUFFER, _scalebo);
+    glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, _scalerb);
+
+    GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        CULogError("Could not create downscaling buffer. %s", gl_error_name(status).c_str());
+        _scalew = 0;
+        _scaleh = 0;
+        return false;
+    }
+    _scalew = width;
+    _scaleh = height;
+    return true;
+}
+
+/**
+ * Returns true if the read of the given framebuffer region started.
+ *
+ * This is the shared implementation of {@link #read} and {@link #readScreen}.
+ *
+ * @param framebo   The framebuffer to read
+ * @param attach    The color buffer to read
+ * @param bounds    The region to read, in pixels
+ * @param width     The output width
+ * @param height    The output height
+ * @param callback  The consumer of the pixels
+ *
+ * @return true if the read started.
+ */
+bool FrameReader::readFramebuffer(GLuint framebo, GLenum attach, const Rect bounds,
+                                  int width, int height, const Callback& callback) {
+    CUAssertLog(!_slots.empty(), "Frame reader is not initialized");
+    if (_pending == _slots.size()) {
+        _dropped++;
+        return false;
+    }
+
+    int srcx = (int)bounds.origin.x;
+    int srcy = (int)bounds.origin.y;
+    int srcw = (int)bounds.size.width;
+    int srch = (int)bounds.size.height;
+    width  = width  > 0 ? width  : srcw;
+    height = height > 0 ? height : srch;
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    Slot& slot = _slots[(_head+_pending) % _slots.size()];
+    size_t bytes = (size_t)width*height*PIXEL_BYTES;
+
+    renderstate::bindFramebuffer(GL_READ_FRAMEBUFFER, framebo);
+    glReadBuffer(attach);
+
+    // Downscale first so that the transfer is smaller
+    if (width != srcw || height != srch) {
+        if (!prepareScale(width, height)) {
+            Display::get()->restoreRenderTarget();
+            return false;
+        }
+        GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+        if (scissor) {
+            glDisable(GL_SCISSOR_TEST);
+        }
+        renderstate::bindFramebuffer(GL_DRAW_FRAMEBUFFER, _scalebo);
+        glBlitFramebuffer(srcx, srcy, srcx+srcw, srcy+srch, 0, 0, width, height,
+                          GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        if (scissor) {
+            glEnable(GL_SCISSOR_TEST);
+        }
+        renderstate::bindFramebuffer(GL_READ_FRAMEBUFFER, _scalebo);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        srcx = 0;
+        srcy = 0;
+    }
+
+    renderstate::bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (slot.capacity < bytes) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+        slot.capacity = bytes;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, PIXEL_BYTES);
+    glReadPixels(srcx, srcy, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    renderstate::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    Display::get()->restoreRenderTarget();
+
+    GLenum error = glGetError();
+    if (error || !slot.fence) {
+        CULogError("Could not read framebuffer. %s", gl_error_name(error).c_str());
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+            slot.fence = 0;
+        }
+        return false;
+    }
+
+    slot.width = width;
+    slot.height = height;
+    slot.callback = callback;
+    _pending++;
+    return true;
+}
+
+/**
+ * Delivers the pixels of the given slot and releases the slot.
+ *
+ * The fence of the slot must have signaled.
+ *
+ * @param slot  The slot to deliver
+ */
+void FrameReader::deliver(Slot& slot) {
+    glDeleteSync(slot.fence);
+    slot.fence = 0;
+
+    size_t stride = (size_t)slot.width*PIXEL_BYTES;
+    size_t bytes  = stride*slot.height;
+    renderstate::bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const Uint8* data = (const Uint8*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes,
+                                                       GL_MAP_READ_BIT);
+    if (data == nullptr) {
+        GLenum error = glGetError();
+        CULogError("Could not map pixel buffer. %s", gl_error_name(error).c_str());
+    } else if (slot.callback) {
+        if (_flipped) {
+            // OpenGL rows are bottom to top
+            _scratch.resize(bytes);
+            for(int row = 0; row < slot.height; row++) {
+                std::memcpy(_scratch.data()+row*stride,
+                            data+(slot.height-row-1)*stride, stride);
+            }
+            slot.callback(_scratch.data(), slot.width, slot.height);
+        } else {
+            slot.callback(data, slot.width, slot.height);
+        }
+    }
+    if (data != nullptr) {
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    renderstate::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.callback = nullptr;
+
+    _head = (_head+1) % _slots.size();
+    _pending--;
+}
+
+#pragma mark -
+#pragma mark Reading
+/**
+ * Returns true if a read of the given render target started.
+ *
+ * This reads the primary output texture of the render target. It should
+ * be called after {@link RenderTarget#end}. If width or height is 0, it
+ * is the size of the render target. Otherwise, the frame is downscaled
+ * to the given size on the GPU.
+ *
+ * This method fails if every pixel buffer is in use. The callback is
+ * invoked by a later call to {@link #update} or {@link #flush}.
+ *
+ * @param target    The render target to read
+ * @param callback  The consumer of the pixels
+ * @param width     The output width (0 for the target width)
+ * @param height    The output height (0 for the target height)
+ *
+ * @return true if a read of the given render target started.
+ */
+bool FrameReader::read(const std::shared_ptr<RenderTarget>& target, const Callback& callback,
+                       int width, int height) {
+    CUAssertLog(target != nullptr, "Cannot read a null render target");
+    Rect bounds(0, 0, (float)target->getWidth(), (float)target->getHeight());
+    return readFramebuffer(target->getFramebuffer(), GL_COLOR_ATTACHMENT0, bounds,
+                           width, height, callback);
+}
+
+/**
+ * Returns true if a read of the display started.
+ *
+ * The region is given in pixels, with the origin at the bottom left of
+ * the display. This should be called after drawing, but before the
+ * display is swapped. If width or height is 0, it is the size of the
+ * region. Otherwise, the frame is downscaled to the given size on the GPU.
+ *
+ * This method fails if every pixel buffer is in use. The callback is
+ * invoked by a later call to {@link #update} or {@link #flush}.
+ *
+ * @param bounds    The region to read, in pixels
+ * @param callback  The consumer of the pixels
+ * @param width     The output width (0 for the region width)
+ * @param height    The output height (0 for the region height)
+ *
+ * @return true if a read of the display started.
+ */
+bool FrameReader::readScreen(const Rect bounds, const Callback& callback, int width, int height) {
+    // The default framebuffer is not necessarily 0 (particularly on iOS)
+    Display::get()->restoreRenderTarget();
+    GLint framebo = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &framebo);
+    GLenum attach = framebo ? GL_COLOR_ATTACHMENT0 : GL_BACK;
+    return readFramebuffer((GLuint)framebo, attach, bounds, width, height, callback);
+}
+
+/**
+ * Delivers every completed read, returning the number delivered.
+ *
+ * This method never blocks. Reads are delivered in the order they were
+ * issued, so a completed read waits for any earlier read that is still
+ * in flight. This method should be called once a frame.
+ *
+ * @return the number of reads delivered.
+ */
+size_t FrameReader::update() {
+    size_t count = 0;
+    while (_pending > 0) {
+        Slot& slot = _slots[_head];
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            deliver(slot);
+            count++;
+        } else if (status == GL_WAIT_FAILED) {
+            GLenum error = glGetError();
+            CULogError("Could not query pixel transfer. %s", gl_error_name(error).c_str());
+            glDeleteSync(slot.fence);
+            slot.fence = 0;
+            slot.callback = nullptr;
+            _head = (_head+1) % _slots.size();
+            _pending--;
+        } else {
+            break;
+        }
+    }
+    return count;
+}
+
+/**
+ * Delivers every read in flight, returning the number delivered.
+ *
+ * Unlike {@link #update}, this method blocks until every transfer is
+ * complete. It is intended for the end of a capture, and should not be
+ * called every frame.
+ *
+ * @return the number of reads delivered.
+ */
+size_t FrameReader::flush() {
+    size_t count = 0;
+    while (_pending > 0) {
+        Slot& slot = _slots[_head];
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FLUSH_TIMEOUT);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            continue;
+        } else if (status == GL_WAIT_FAILED) {
+            GLenum error = glGetError();
+            CULogError("Could not query pixel transfer. %s", gl_error_name(error).c_str());
+            glDeleteSync(slot.fence);
+            slot.fence = 0;
+            slot.callback = nullptr;
+            _head = (_head+1) % _slots.size();
+            _pending--;
+        } else {
+            deliver(slot);
+            count++;
+        }
+    }
+    return count;
+}
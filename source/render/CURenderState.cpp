@@ -0,0 +1,902 @@
+//
+//  CURenderState.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module is a cache of the OpenGL state used by the render classes.
+//  Classes like SpriteBatch only track their state relative to their own
+//  previous draw call. They have no idea what a different sprite batch, a
+//  render target, or a texture bind did in the meantime. So they end up
+//  re-issuing state that the driver already has. All binds and all changes
+//  to the blend, depth, and stencil settings go through this module instead,
+//  which drops any call that would not change the state.
+//
+//  The cache only knows about changes made through this module. Code that
+//  calls OpenGL directly must call invalidate() before returning control.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/render/CURenderState.h>
+#include <cstring>
+
+using namespace cugl;
+
+/** The value of a cached object or enum that is not known */
+#define STATE_UNKNOWN   0xFFFFFFFF
+/** The value of a cached flag that is not known */
+#define FLAG_UNKNOWN    0xFF
+
+/** The index of GL_BLEND in the capability cache */
+#define CAP_BLEND       0
+/** The index of GL_CULL_FACE in the capability cache */
+#define CAP_CULL        1
+/** The index of GL_DEPTH_TEST in the capability cache */
+#define CAP_DEPTH       2
+/** The index of GL_SCISSOR_TEST in the capability cache */
+#define CAP_SCISSOR     3
+/** The index of GL_STENCIL_TEST in the capability cache */
+#define CAP_STENCIL     4
+/** The number of cached capabilities */
+#define CAP_COUNT       5
+
+/**
+ * The cached OpenGL state
+ *
+ * Every value is either STATE_UNKNOWN (FLAG_UNKNOWN for flags) or the value
+ * last sent to OpenGL.
+ */
+typedef struct {
+    /** The active shader program */
+    GLuint program;
+    /** The bound vertex array */
+    GLuint vertArray;
+    /** The buffer bound to GL_ARRAY_BUFFER */
+    GLuint arrayBuffer;
+    /** The buffer bound to GL_ELEMENT_ARRAY_BUFFER (part of the vertex array) */
+    GLuint indexBuffer;
+    /** The buffer bound to GL_UNIFORM_BUFFER */
+    GLuint uniformBuffer;
+    /** The buffers bound to each uniform bind point */
+    GLuint uniforms[RENDER_STATE_UNIFORMS];
+    /** Whether each uniform bind point has a whole buffer (and not a range) */
+    bool wholes[RENDER_STATE_UNIFORMS];
+    /** The active texture unit */
+    GLenum activeUnit;
+    /** The 2d texture bound to each texture unit */
+    GLuint textures[RENDER_STATE_TEXTURES];
+    /** The draw framebuffer */
+    GLuint drawFrame;
+    /** The read framebuffer */
+    GLuint readFrame;
+    /** The bound renderbuffer */
+    GLuint renderBuffer;
+    /** Whether the viewport is known */
+    bool hasViewport;
+    /** The viewport */
+    GLint viewport[4];
+    /** The enabled capabilities */
+    Uint8 caps[CAP_COUNT];
+    /** The blend equation */
+    GLenum blendEq;
+    /** The blend functions (srcRGB, dstRGB, srcAlpha, dstAlpha) */
+    GLenum blendFunc[4];
+    /** The depth write mask */
+    Uint8 depthMask;
+    /** The depth comparison function */
+    GLenum depthFunc;
+    /** The color write mask */
+    Uint8 colorMask[4];
+    /** The stencil write mask */
+    GLuint stencilMask;
+    /** Whether the stencil mask is known */
+    bool hasStencilMask;
+    /** The stencil test function */
+    GLenum stencilFunc;
+    /** The stencil reference value */
+    GLint stencilRef;
+    /** The stencil test mask */
+    GLuint stencilTest;
+    /** The stencil operations for the front face */
+    GLenum frontOp[3];
+    /** The stencil operations for the back face */
+    GLenum backOp[3];
+} RenderState;
+
+/** The state cache for the (single) OpenGL context */
+static RenderState _state;
+/** Whether the cache has been initialized */
+static bool _primed = false;
+/** The number of OpenGL calls made through the cache */
+static Uint64 _issued = 0;
+/** The number of redundant OpenGL calls dropped by the cache */
+static Uint64 _avoided = 0;
+
+/**
+ * Returns the cached OpenGL state, initializing it if necessary.
+ *
+ * @return the cached OpenGL state
+ */
+static RenderState& get_state() {
+    if (!_primed) {
+        renderstate::invalidate();
+    }
+    return _state;
+}
+
+/**
+ * Returns the index of the given capability in the cache (-1 if not cached)
+ *
+ * @param cap   The OpenGL capability
+ *
+ * @return the index of the given capability in the cache
+ */
+static int cap_index(GLenum cap) {
+    switch (cap) {
+        case GL_BLEND:
+            return CAP_BLEND;
+        case GL_CULL_FACE:
+            return CAP_CULL;
+        case GL_DEPTH_TEST:
+            return CAP_DEPTH;
+        case GL_SCISSOR_TEST:
+            return CAP_SCISSOR;
+        case GL_STENCIL_TEST:
+            return CAP_STENCIL;
+    }
+    return -1;
+}
+
+/**
+ * Records whether a call was issued or avoided, returning true if issued
+ *
+ * @param issue Whether the call changes the state
+ *
+ * @return the value of issue
+ */
+static bool count_call(bool issue) {
+    if (issue) {
+        _issued++;
+    } else {
+        _avoided++;
+    }
+    return issue;
+}
+
+#pragma mark -
+#pragma mark Cache Management
+/**
+ * Forgets all cached OpenGL state.
+ *
+ * The next call to each function in this namespace will reach OpenGL.
+ * This must be called whenever the OpenGL state is changed outside of
+ * this namespace.
+ */
+void cugl::renderstate::invalidate() {
+    _state.program = STATE_UNKNOWN;
+    _state.vertArray = STATE_UNKNOWN;
+    _state.arrayBuffer = STATE_UNKNOWN;
+    _state.indexBuffer = STATE_UNKNOWN;
+    _state.uniformBuffer = STATE_UNKNOWN;
+    for(int ii = 0; ii < RENDER_STATE_UNIFORMS; ii++) {
+        _state.uniforms[ii] = STATE_UNKNOWN;
+        _state.wholes[ii] = false;
+    }
+    _state.activeUnit = STATE_UNKNOWN;
+    for(int ii = 0; ii < RENDER_STATE_TEXTURES; ii++) {
+        _state.textures[ii] = STATE_UNKNOWN;
+    }
+    _state.drawFrame = STATE_UNKNOWN;
+    _state.readFrame = STATE_UNKNOWN;
+    _state.renderBuffer = STATE_UNKNOWN;
+    _state.hasViewport = false;
+    std::memset(_state.caps, FLAG_UNKNOWN, sizeof(_state.caps));
+    _state.blendEq = STATE_UNKNOWN;
+    for(int ii = 0; ii < 4; ii++) {
+        _state.blendFunc[ii] = STATE_UNKNOWN;
+        _state.colorMask[ii] = FLAG_UNKNOWN;
+    }
+    _state.depthMask = FLAG_UNKNOWN;
+    _state.depthFunc = STATE_UNKNOWN;
+    _state.hasStencilMask = false;
+    _state.stencilFunc = STATE_UNKNOWN;
+    for(int ii = 0; ii < 3; ii++) {
+        _state.frontOp[ii] = STATE_UNKNOWN;
+        _state.backOp[ii]  = STATE_UNKNOWN;
+    }
+    _primed = true;
+}
+
+/**
+ * Returns the number of OpenGL calls made through the cache.
+ *
+ * This only counts calls since the last call to {@link #resetCounters}.
+ *
+ * @return the number of OpenGL calls made through the cache.
+ */
+Uint64 cugl::renderstate::getIssuedCalls() {
+    return _issued;
+}
+
+/**
+ * Returns the number of redundant OpenGL calls dropped by the cache.
+ *
+ * This only counts calls since the last call to {@link #resetCounters}.
+ *
+ * @return the number of redundant OpenGL calls dropped by the cache.
+ */
+Uint64 cugl::renderstate::getAvoidedCalls() {
+    return _avoided;
+}
+
+/**
+ * Resets the call counters to 0.
+ */
+void cugl::renderstate::resetCounters() {
+    _issued  = 0;
+    _avoided = 0;
+}
+
+#pragma mark -
+#pragma mark Object Bindings
+/**
+ * Makes the given shader program active.
+ *
+ * @param program   The shader program
+ */
+void cugl::renderstate::useProgram(GLuint program) {
+    RenderState& state = get_state();
+    if (count_call(state.program != program)) {
+        glUseProgram(program);
+        state.program = program;
+    }
+}
+
+/**
+ * Returns the active shader program.
+ *
+ * @return the active shader program.
+ */
+GLuint cugl::renderstate::getProgram() {
+    RenderState& state = get_state();
+    if (state.program == STATE_UNKNOWN) {
+        GLint value;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+        state.program = (GLuint)value;
+    }
+    return state.program;
+}
+
+/**
+ * Binds the given vertex array object.
+ *
+ * As the element array buffer belongs to the vertex array, changing
+ * the vertex array forgets the cached element array buffer.
+ *
+ * @param array     The vertex array object
+ */
+void cugl::renderstate::bindVertexArray(GLuint array) {
+    RenderState& state = get_state();
+    if (count_call(state.vertArray != array)) {
+        glBindVertexArray(array);
+        state.vertArray = array;
+        state.indexBuffer = STATE_UNKNOWN;
+    }
+}
+
+/**
+ * Returns the bound vertex array object.
+ *
+ * @return the bound vertex array object.
+ */
+GLuint cugl::renderstate::getVertexArray() {
+    RenderState& state = get_state();
+    if (state.vertArray == STATE_UNKNOWN) {
+        GLint value;
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+        state.vertArray = (GLuint)value;
+    }
+    return state.vertArray;
+}
+
+/**
+ * Returns a pointer to the cache slot for the given buffer target
+ *
+ * @param state     The cached OpenGL state
+ * @param target    The buffer target
+ *
+ * @return a pointer to the cache slot (or nullptr if not cached)
+ */
+static GLuint* buffer_slot(RenderState& state, GLenum target) {
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            return &state.arrayBuffer;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return &state.indexBuffer;
+        case GL_UNIFORM_BUFFER:
+            return &state.uniformBuffer;
+    }
+    return nullptr;
+}
+
+/**
+ * Binds the given buffer to the given target.
+ *
+ * Only GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER and GL_UNIFORM_BUFFER
+ * are cached. All other targets are passed through to OpenGL.
+ *
+ * @param target    The buffer target
+ * @param buffer    The buffer object
+ */
+void cugl::renderstate::bindBuffer(GLenum target, GLuint buffer) {
+    GLuint* slot = buffer_slot(get_state(), target);
+    if (count_call(slot == nullptr || *slot != buffer)) {
+        glBindBuffer(target, buffer);
+        if (slot != nullptr) {
+            *slot = buffer;
+        }
+    }
+}
+
+/**
+ * Returns the buffer bound to the given target.
+ *
+ * @param target    The buffer target
+ *
+ * @return the buffer bound to the given target.
+ */
+GLuint cugl::renderstate::getBuffer(GLenum target) {
+    GLuint* slot = buffer_slot(get_state(), target);
+    if (slot != nullptr && *slot != STATE_UNKNOWN) {
+        return *slot;
+    }
+
+    GLenum query = GL_NONE;
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            query = GL_ARRAY_BUFFER_BINDING;
+            break;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            query = GL_ELEMENT_ARRAY_BUFFER_BINDING;
+            break;
+        case GL_UNIFORM_BUFFER:
+            query = GL_UNIFORM_BUFFER_BINDING;
+            break;
+        default:
+            return 0;
+    }
+    GLint value;
+    glGetIntegerv(query, &value);
+    *slot = (GLuint)value;
+    return *slot;
+}
+
+/**
+ * Binds the whole of the given buffer to an indexed bind point.
+ *
+ * Only GL_UNIFORM_BUFFER is cached. As in OpenGL, this also binds the
+ * buffer to the generic target.
+ *
+ * @param target    The buffer target
+ * @param index     The bind point
+ * @param buffer    The buffer object
+ */
+void cugl::renderstate::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    RenderState& state = get_state();
+    bool cached = target == GL_UNIFORM_BUFFER && index < RENDER_STATE_UNIFORMS;
+    if (count_call(!cached || state.uniforms[index] != buffer || !state.wholes[index])) {
+        glBindBufferBase(target, index, buffer);
+        if (cached) {
+            state.uniforms[index] = buffer;
+            state.wholes[index] = true;
+        }
+        GLuint* slot = buffer_slot(state, target);
+        if (slot != nullptr) {
+            *slot = buffer;
+        }
+    }
+}
+
+/**
+ * Binds a range of the given buffer to an indexed bind point.
+ *
+ * The range is not cached, so this call always reaches OpenGL. As in
+ * OpenGL, this also binds the buffer to the generic target.
+ *
+ * @param target    The buffer target
+ * @param index     The bind point
+ * @param buffer    The buffer object
+ * @param offset    The start of the range in bytes
+ * @param size      The size of the range in bytes
+ */
+void cugl::renderstate::bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                                        GLintptr offset, GLsizeiptr size) {
+    RenderState& state = get_state();
+    count_call(true);
+    glBindBufferRange(target, index, buffer, offset, size);
+    if (target == GL_UNIFORM_BUFFER && index < RENDER_STATE_UNIFORMS) {
+        // A range is not the whole buffer, so a later base bind must happen
+        state.uniforms[index] = buffer;
+        state.wholes[index] = false;
+    }
+    GLuint* slot = buffer_slot(state, target);
+    if (slot != nullptr) {
+        *slot = buffer;
+    }
+}
+
+/**
+ * Returns the buffer bound to the given indexed bind point.
+ *
+ * @param target    The buffer target
+ * @param index     The bind point
+ *
+ * @return the buffer bound to the given indexed bind point.
+ */
+GLuint cugl::renderstate::getBufferBase(GLenum target, GLuint index) {
+    RenderState& state = get_state();
+    if (target == GL_UNIFORM_BUFFER && index < RENDER_STATE_UNIFORMS &&
+        state.uniforms[index] != STATE_UNKNOWN) {
+        return state.uniforms[index];
+    }
+    GLint value = 0;
+    if (target == GL_UNIFORM_BUFFER) {
+        glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, index, &value);
+        if (index < RENDER_STATE_UNIFORMS) {
+            // We cannot tell a range from a whole buffer
+            state.uniforms[index] = (GLuint)value;
+            state.wholes[index] = false;
+        }
+    }
+    return (GLuint)value;
+}
+
+/**
+ * Sets the active texture unit.
+ *
+ * @param unit      The texture unit (GL_TEXTURE0 + n)
+ */
+void cugl::renderstate::activeTexture(GLenum unit) {
+    RenderState& state = get_state();
+    if (count_call(state.activeUnit != unit)) {
+        glActiveTexture(unit);
+        state.activeUnit = unit;
+    }
+}
+
+/**
+ * Returns the active texture unit.
+ *
+ * @return the active texture unit.
+ */
+GLenum cugl::renderstate::getActiveTexture() {
+    RenderState& state = get_state();
+    if (state.activeUnit == STATE_UNKNOWN) {
+        GLint value;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &value);
+        state.activeUnit = (GLenum)value;
+    }
+    return state.activeUnit;
+}
+
+/**
+ * Binds the given 2d texture to the active texture unit.
+ *
+ * @param texture   The texture object
+ */
+void cugl::renderstate::bindTexture(GLuint texture) {
+    bindTexture(getActiveTexture(), texture);
+}
+
+/**
+ * Binds the given 2d texture to the given texture unit.
+ *
+ * This makes the given unit the active texture unit, so that texture
+ * parameters may be set afterwards.
+ *
+ * @param unit      The texture unit (GL_TEXTURE0 + n)
+ * @param texture   The texture object
+ */
+void cugl::renderstate::bindTexture(GLenum unit, GLuint texture) {
+    RenderState& state = get_state();
+    GLuint index = unit-GL_TEXTURE0;
+    bool cached = index < RENDER_STATE_TEXTURES;
+    activeTexture(unit);
+    if (count_call(!cached || state.textures[index] != texture)) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        if (cached) {
+            state.textures[index] = texture;
+        }
+    }
+}
+
+/**
+ * Returns the 2d texture bound to the given texture unit.
+ *
+ * @param unit      The texture unit (GL_TEXTURE0 + n)
+ *
+ * @return the 2d texture bound to the given texture unit.
+ */
+GLuint cugl::renderstate::getTexture(GLenum unit) {
+    RenderState& state = get_state();
+    GLuint index = unit-GL_TEXTURE0;
+    if (index < RENDER_STATE_TEXTURES && state.textures[index] != STATE_UNKNOWN) {
+        return state.textures[index];
+    }
+    activeTexture(unit);
+    GLint value;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &value);
+    if (index < RENDER_STATE_TEXTURES) {
+        state.textures[index] = (GLuint)value;
+    }
+    return (GLuint)value;
+}
+
+/**
+ * Binds the given framebuffer to the given target.
+ *
+ * The target GL_FRAMEBUFFER sets both the read and draw framebuffers.
+ *
+ * @param target    The framebuffer target
+ * @param buffer    The framebuffer object
+ */
+void cugl::renderstate::bindFramebuffer(GLenum target, GLuint buffer) {
+    RenderState& state = get_state();
+    bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+    if (count_call((draw && state.drawFrame != buffer) || (read && state.readFrame != buffer))) {
+        glBindFramebuffer(target, buffer);
+        if (draw) {
+            state.drawFrame = buffer;
+        }
+        if (read) {
+            state.readFrame = buffer;
+        }
+    }
+}
+
+/**
+ * Binds the given renderbuffer.
+ *
+ * @param buffer    The renderbuffer object
+ */
+void cugl::renderstate::bindRenderbuffer(GLuint buffer) {
+    RenderState& state = get_state();
+    if (count_call(state.renderBuffer != buffer)) {
+        glBindRenderbuffer(GL_RENDERBUFFER, buffer);
+        state.renderBuffer = buffer;
+    }
+}
+
+/**
+ * Sets the viewport
+ *
+ * @param x         The left edge of the viewport
+ * @param y         The bottom edge of the viewport
+ * @param width     The width of the viewport
+ * @param height    The height of the viewport
+ */
+void cugl::renderstate::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    RenderState& state = get_state();
+    if (count_call(!state.hasViewport || state.viewport[0] != x || state.viewport[1] != y ||
+                   state.viewport[2] != width || state.viewport[3] != height)) {
+        glViewport(x, y, width, height);
+        state.viewport[0] = x;
+        state.viewport[1] = y;
+        state.viewport[2] = width;
+        state.viewport[3] = height;
+        state.hasViewport = true;
+    }
+}
+
+/**
+ * Stores the current viewport in the given array.
+ *
+ * The array must have four elements. This only queries OpenGL if the
+ * viewport is not cached.
+ *
+ * @param viewport  The array to store the viewport
+ */
+void cugl::renderstate::getViewport(GLint* viewport) {
+    RenderState& state = get_state();
+    if (!state.hasViewport) {
+        glGetIntegerv(GL_VIEWPORT, state.viewport);
+        state.hasViewport = true;
+    }
+    std::memcpy(viewport, state.viewport, 4*sizeof(GLint));
+}
+
+/**
+ * Notifies the cache that the given texture has been deleted.
+ *
+ * OpenGL unbinds a deleted texture from every texture unit.
+ *
+ * @param texture   The deleted texture object
+ */
+void cugl::renderstate::forgetTexture(GLuint texture) {
+    RenderState& state = get_state();
+    for(int ii = 0; ii < RENDER_STATE_TEXTURES; ii++) {
+        if (state.textures[ii] == texture) {
+            state.textures[ii] = 0;
+        }
+    }
+}
+
+/**
+ * Notifies the cache that the given buffer has been deleted.
+ *
+ * OpenGL unbinds a deleted buffer from every target.
+ *
+ * @param buffer    The deleted buffer object
+ */
+void cugl::renderstate::forgetBuffer(GLuint buffer) {
+    RenderState& state = get_state();
+    if (state.arrayBuffer == buffer) {
+        state.arrayBuffer = 0;
+    }
+    if (state.indexBuffer == buffer) {
+        state.indexBuffer = 0;
+    }
+    if (state.uniformBuffer == buffer) {
+        state.uniformBuffer = 0;
+    }
+    for(int ii = 0; ii < RENDER_STATE_UNIFORMS; ii++) {
+        if (state.uniforms[ii] == buffer) {
+            state.uniforms[ii] = 0;
+        }
+    }
+}
+
+/**
+ * Notifies the cache that the given vertex array has been deleted.
+ *
+ * @param array     The deleted vertex array object
+ */
+void cugl::renderstate::forgetVertexArray(GLuint array) {
+    RenderState& state = get_state();
+    if (state.vertArray == array) {
+        state.vertArray = 0;
+        state.indexBuffer = STATE_UNKNOWN;
+    }
+}
+
+/**
+ * Notifies the cache that the given shader program has been deleted.
+ *
+ * @param program   The deleted shader program
+ */
+void cugl::renderstate::forgetProgram(GLuint program) {
+    RenderState& state = get_state();
+    if (state.program == program) {
+        // A bound program is only flagged for deletion
+        state.program = STATE_UNKNOWN;
+    }
+}
+
+/**
+ * Notifies the cache that the given framebuffer has been deleted.
+ *
+ * @param buffer    The deleted framebuffer object
+ */
+void cugl::renderstate::forgetFramebuffer(GLuint buffer) {
+    RenderState& state = get_state();
+    if (state.drawFrame == buffer) {
+        state.drawFrame = 0;
+    }
+    if (state.readFrame == buffer) {
+        state.readFrame = 0;
+    }
+}
+
+/**
+ * Notifies the cache that the given renderbuffer has been deleted.
+ *
+ * @param buffer    The deleted renderbuffer object
+ */
+void cugl::renderstate::forgetRenderbuffer(GLuint buffer) {
+    RenderState& state = get_state();
+    if (state.renderBuffer == buffer) {
+        state.renderBuffer = 0;
+    }
+}
+
+#pragma mark -
+#pragma mark Pipeline Settings
+/**
+ * Enables or disables the given capability.
+ *
+ * Only GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST and
+ * GL_STENCIL_TEST are cached. All other capabilities are passed
+ * through to OpenGL.
+ *
+ * @param cap       The capability
+ * @param value     Whether to enable the capability
+ */
+void cugl::renderstate::setEnabled(GLenum cap, bool value) {
+    RenderState& state = get_state();
+    int index = cap_index(cap);
+    if (count_call(index < 0 || state.caps[index] != (Uint8)value)) {
+        if (value) {
+            glEnable(cap);
+        } else {
+            glDisable(cap);
+        }
+        if (index >= 0) {
+            state.caps[index] = (Uint8)value;
+        }
+    }
+}
+
+/**
+ * Sets the blend equation for both the RGB and alpha components.
+ *
+ * @param mode      The blend equation
+ */
+void cugl::renderstate::blendEquation(GLenum mode) {
+    RenderState& state = get_state();
+    if (count_call(state.blendEq != mode)) {
+        glBlendEquation(mode);
+        state.blendEq = mode;
+    }
+}
+
+/**
+ * Sets the blend functions for the RGB and alpha components.
+ *
+ * This uses glBlendFunc if the RGB and alpha functions agree, and
+ * glBlendFuncSeparate otherwise.
+ *
+ * @param srcRGB    The source function for the RGB components
+ * @param dstRGB    The destination function for the RGB components
+ * @param srcAlpha  The source function for the alpha component
+ * @param dstAlpha  The destination function for the alpha component
+ */
+void cugl::renderstate::blendFunc(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
+    RenderState& state = get_state();
+    if (count_call(state.blendFunc[0] != srcRGB || state.blendFunc[1] != dstRGB ||
+                   state.blendFunc[2] != srcAlpha || state.blendFunc[3] != dstAlpha)) {
+        if (srcRGB != srcAlpha || dstRGB != dstAlpha) {
+            glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+        } else {
+            glBlendFunc(srcRGB, dstRGB);
+        }
+        state.blendFunc[0] = srcRGB;
+        state.blendFunc[1] = dstRGB;
+        state.blendFunc[2] = srcAlpha;
+        state.blendFunc[3] = dstAlpha;
+    }
+}
+
+/**
+ * Sets whether writing to the depth buffer is enabled.
+ *
+ * @param flag      Whether writing to the depth buffer is enabled
+ */
+void cugl::renderstate::depthMask(GLboolean flag) {
+    RenderState& state = get_state();
+    Uint8 value = flag ? 1 : 0;
+    if (count_call(state.depthMask != value)) {
+        glDepthMask(flag);
+        state.depthMask = value;
+    }
+}
+
+/**
+ * Sets the depth comparison function.
+ *
+ * @param func      The depth comparison function
+ */
+void cugl::renderstate::depthFunc(GLenum func) {
+    RenderState& state = get_state();
+    if (count_call(state.depthFunc != func)) {
+        glDepthFunc(func);
+        state.depthFunc = func;
+    }
+}
+
+/**
+ * Sets which color components are written to the frame buffer.
+ *
+ * @param red       Whether to write the red component
+ * @param green     Whether to write the green component
+ * @param blue      Whether to write the blue component
+ * @param alpha     Whether to write the alpha component
+ */
+void cugl::renderstate::colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) {
+    RenderState& state = get_state();
+    Uint8 value[4] = { (Uint8)(red ? 1 : 0), (Uint8)(green ? 1 : 0),
+                       (Uint8)(blue ? 1 : 0), (Uint8)(alpha ? 1 : 0) };
+    if (count_call(std::memcmp(state.colorMask, value, sizeof(value)) != 0)) {
+        glColorMask(red, green, blue, alpha);
+        std::memcpy(state.colorMask, value, sizeof(value));
+    }
+}
+
+/**
+ * Sets the stencil write mask for both faces.
+ *
+ * @param mask      The stencil write mask
+ */
+void cugl::renderstate::stencilMask(GLuint mask) {
+    RenderState& state = get_state();
+    if (count_call(!state.hasStencilMask || state.stencilMask != mask)) {
+        glStencilMask(mask);
+        state.stencilMask = mask;
+        state.hasStencilMask = true;
+    }
+}
+
+/**
+ * Sets the stencil test function for both faces.
+ *
+ * @param func      The stencil test function
+ * @param ref       The stencil reference value
+ * @param mask      The stencil test mask
+ */
+void cugl::renderstate::stencilFunc(GLenum func, GLint ref, GLuint mask) {
+    RenderState& state = get_state();
+    if (count_call(state.stencilFunc != func || state.stencilRef != ref || state.stencilTest != mask)) {
+        glStencilFunc(func, ref, mask);
+        state.stencilFunc = func;
+        state.stencilRef  = ref;
+        state.stencilTest = mask;
+    }
+}
+
+/**
+ * Sets the stencil operations for both faces.
+ *
+ * @param sfail     The operation when the stencil test fails
+ * @param dpfail    The operation when the depth test fails
+ * @param dppass    The operation when both tests pass
+ */
+void cugl::renderstate::stencilOp(GLenum sfail, GLenum dpfail, GLenum dppass) {
+    RenderState& state = get_state();
+    GLenum ops[3] = { sfail, dpfail, dppass };
+    if (count_call(std::memcmp(state.frontOp, ops, sizeof(ops)) != 0 ||
+                   std::memcmp(state.backOp, ops, sizeof(ops)) != 0)) {
+        glStencilOp(sfail, dpfail, dppass);
+        std::memcpy(state.frontOp, ops, sizeof(ops));
+        std::memcpy(state.backOp, ops, sizeof(ops));
+    }
+}
+
+/**
+ * Sets the stencil operations for the given face.
+ *
+ * @param face      The face (GL_FRONT, GL_BACK, or GL_FRONT_AND_BACK)
+ * @param sfail     The operation when the stencil test fails
+ * @param dpfail    The operation when the depth test fails
+ * @param dppass    The operation when both tests pass
+ */
+void cugl::renderstate::stencilOpSeparate(GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass) {
+    if (face == GL_FRONT_AND_BACK) {
+        stencilOp(sfail, dpfail, dppass);
+        return;
+    }
+    RenderState& state = get_state();
+    GLenum ops[3] = { sfail, dpfail, dppass };
+    GLenum* cache = face == GL_FRONT ? state.frontOp : state.backOp;
+    if (count_call(std::memcmp(cache, ops, sizeof(ops)) != 0)) {
+        glStencilOpSeparate(face, sfail, dpfail, dppass);
+        std::memcpy(cache, ops, sizeof(ops));
+    }
+}
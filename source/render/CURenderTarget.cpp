@@ -42,11 +42,37 @@
 
 #include <cugl/render/CURenderTarget.h>
 #include <cugl/render/CUTexture.h>
+#include <cugl/render/CURenderState.h>
 #include <cugl/base/CUDisplay.h>
 #include <cugl/util/CUDebug.h>
+#include <algorithm>
 
 using namespace cugl;
 
+/**
+ * Returns the renderbuffer format for the pixel format
+ *
+ * These match the internal formats of the output textures, so that the
+ * multisampled buffers can be blitted to them.
+ *
+ * @param format    The explicit pixel format
+ *
+ * @return the renderbuffer format for the pixel format
+ */
+static GLenum sample_format(Texture::PixelFormat format) {
+    switch (format) {
+        case Texture::PixelFormat::RGB:
+            return GL_RGB8;
+        case Texture::PixelFormat::RED:
+            return GL_R8;
+        case Texture::PixelFormat::RED_GREEN:
+            return GL_RG8;
+        default:
+            break;
+    }
+    return GL_RGBA8;
+}
+
 #pragma mark Setup
 /**
  * Initializes the framebuffer and associated render buffer
@@ -61,7 +87,7 @@ using namespace cugl;
  * @return true if initialization was successful.
  */
 bool RenderTarget::prepareBuffer() {
-    glGetIntegerv(GL_VIEWPORT, _viewport);
+    renderstate::getViewport(_viewport);
     
     GLenum error;
     glGenFramebuffers(1, &_framebo);
@@ -71,7 +97,7 @@ bool RenderTarget::prepareBuffer() {
         return false;
     }
     
-    glBindFramebuffer(GL_FRAMEBUFFER, _framebo);
+    renderstate::bindFramebuffer(GL_FRAMEBUFFER, _framebo);
 
     // Attach the depth buffer first
     _depthst = Texture::alloc(_width,_height,Texture::PixelFormat::DEPTH_STENCIL);
@@ -92,7 +118,7 @@ bool RenderTarget::prepareBuffer() {
         return false;
     }
     
-    glBindRenderbuffer(GL_RENDERBUFFER, _renderbo);
+    renderstate::bindRenderbuffer(_renderbo);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, _width, _height);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
                               GL_RENDERBUFFER, _renderbo);
@@ -172,6 +198,94 @@ bool RenderTarget::completeBuffer() {
     return true;
 }
 
+/**
+ * Initializes the multisampled framebuffer and its renderbuffers
+ *
+ * This method must be called after the output textures are attached, as
+ * it creates a multisampled renderbuffer for each output.
+ *
+ * If this method fails, it will safely clean up any previously allocated
+ * objects before quitting.
+ *
+ * @return true if the multisampled framebuffer was successfully created.
+ */
+bool RenderTarget::prepareSamples() {
+    GLenum error;
+    glGenFramebuffers(1, &_samplebo);
+    if (!_samplebo) {
+        error = glGetError();
+        CULogError("Could not create multisample frame buffer. %s", gl_error_name(error).c_str());
+        dispose();
+        return false;
+    }
+    renderstate::bindFramebuffer(GL_FRAMEBUFFER, _samplebo);
+
+    // One buffer per output, and then the depth/stencil buffer
+    _samplebufs.resize(_outsize+1,0);
+    glGenRenderbuffers((GLsizei)_samplebufs.size(), _samplebufs.data());
+    for(size_t ii = 0; ii < _outsize; ii++) {
+        renderstate::bindRenderbuffer(_samplebufs[ii]);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, _samples,
+                                         sample_format(_outputs[ii]->getFormat()),
+                                         _width, _height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, _bindpoints[ii],
+                                  GL_RENDERBUFFER, _samplebufs[ii]);
+    }
+    renderstate::bindRenderbuffer(_samplebufs[_outsize]);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, _samples, GL_DEPTH24_STENCIL8,
+                                     _width, _height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                              GL_RENDERBUFFER, _samplebufs[_outsize]);
+    error = glGetError();
+    if (error) {
+        CULogError("Could not attach multisample buffers to frame buffer. %s",
+                   gl_error_name(error).c_str());
+        dispose();
+        Display::get()->restoreRenderTarget();
+        return false;
+    }
+
+    glDrawBuffers((int)_outsize, _bindpoints.data());
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        CULogError("Could not bind multisample frame buffer. %s",
+                   gl_error_name(status).c_str());
+        dispose();
+        Display::get()->restoreRenderTarget();
+        return false;
+    }
+
+    Display::get()->restoreRenderTarget();
+    return true;
+}
+
+/**
+ * Resolves the multisampled buffers to the output textures.
+ *
+ * This method blits each multisampled color buffer to the output texture
+ * at the same location. It does nothing if this target is not multisampled.
+ */
+void RenderTarget::resolve() {
+    if (!_samplebo) {
+        return;
+    }
+    renderstate::bindFramebuffer(GL_READ_FRAMEBUFFER, _samplebo);
+    renderstate::bindFramebuffer(GL_DRAW_FRAMEBUFFER, _framebo);
+
+    // A blit copies one read buffer to every draw buffer, so go one at a time
+    std::vector<GLenum> draws;
+    for(size_t ii = 0; ii < _outsize; ii++) {
+        GLuint point = _bindpoints[ii];
+        draws.assign(point-GL_COLOR_ATTACHMENT0+1,GL_NONE);
+        draws.back() = point;
+        glReadBuffer(point);
+        glDrawBuffers((int)draws.size(), draws.data());
+        glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    glDrawBuffers((int)_outsize, _bindpoints.data());
+}
+
 
 #pragma mark -
 #pragma mark Constructors
@@ -185,7 +299,9 @@ _framebo(0),
 _renderbo(0),
 _width(0),
 _height(0),
-_outsize(0) {
+_outsize(0),
+_samples(0),
+_samplebo(0) {
     _clearcol.set(0, 0, 0);
     _viewport[0] = 0; _viewport[1] = 0;
     _viewport[2] = 0; _viewport[3] = 0;
@@ -381,6 +497,34 @@ bool RenderTarget::init(int width, int height, Texture::PixelFormat* outputs, si
     return false;
 }
 
+/**
+ * Initializes this target with multisampled RGBA output textures.
+ *
+ * Drawing takes place in multisampled buffers, which are resolved to the
+ * output textures when {@link #end} is called. The number of samples is
+ * clamped to the maximum supported by this platform. If the number of
+ * samples is 1 or less, this is the same as {@link #init(int,int,size_t)}.
+ *
+ * @param width     The drawing width of this render target
+ * @param height    The drawing width of this render target
+ * @param samples   The number of samples per pixel
+ * @param outputs   The number of output textures
+ *
+ * @return true if initialization was successful.
+ */
+bool RenderTarget::initMultisample(int width, int height, int samples, size_t outputs) {
+    GLint limit = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &limit);
+    samples = std::min(samples,(int)limit);
+    if (!init(width,height,outputs)) {
+        return false;
+    } else if (samples <= 1) {
+        return true;
+    }
+    _samples = samples;
+    return prepareSamples();
+}
+
 /**
  * Deletes the render target and resets all attributes.
  *
@@ -388,13 +532,28 @@ bool RenderTarget::init(int width, int height, Texture::PixelFormat* outputs, si
  */
 void RenderTarget::dispose() {
     if (_framebo) {
+        renderstate::forgetFramebuffer(_framebo);
         glDeleteFramebuffers(1, &_framebo);
         _framebo = 0;
     }
     if (_renderbo) {
+        renderstate::forgetRenderbuffer(_renderbo);
         glDeleteRenderbuffers(1, &_renderbo);
         _renderbo = 0;
     }
+    if (_samplebo) {
+        renderstate::forgetFramebuffer(_samplebo);
+        glDeleteFramebuffers(1, &_samplebo);
+        _samplebo = 0;
+    }
+    if (!_samplebufs.empty()) {
+        for(auto it = _samplebufs.begin(); it != _samplebufs.end(); ++it) {
+            renderstate::forgetRenderbuffer(*it);
+        }
+        glDeleteRenderbuffers((GLsizei)_samplebufs.size(), _samplebufs.data());
+        _samplebufs.clear();
+    }
+    _samples = 0;
     _outputs.clear();
     _bindpoints.clear();
     _clearcol.set(0, 0, 0);
@@ -434,11 +593,11 @@ const std::shared_ptr<Texture>& RenderTarget::getTexture(size_t index) const {
  * return control to the default render target (the screen) when done.
  */
 void RenderTarget::begin() {
-    glGetIntegerv(GL_VIEWPORT, _viewport);
-    glBindFramebuffer(GL_FRAMEBUFFER, _framebo);
+    renderstate::getViewport(_viewport);
+    renderstate::bindFramebuffer(GL_FRAMEBUFFER, _samplebo ? _samplebo : _framebo);
     //glBindRenderbuffer(GL_RENDERBUFFER, _renderbo);
 
-    glViewport(0, 0, _width, _height);
+    renderstate::viewport(0, 0, _width, _height);
     glClearColor(_clearcol.r, _clearcol.g, _clearcol.b, _clearcol.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 }
@@ -447,14 +606,16 @@ void RenderTarget::begin() {
  * Stops sendinging draw commands to this render target.
  *
  * When this method is called, the original viewport will be restored. Future
- * draw commands will be sent directly to the screen.
+ * draw commands will be sent directly to the screen. If this target is
+ * multisampled, the samples are resolved to the output textures.
  *
  * It is NOT safe to call a begin/end pair of a render target inside of
  * another render target.  Render targets do not keep a stack.  They alway
  * return control to the default render target (the screen) when done.
  */
 void RenderTarget::end() {
+    resolve();
     Display::get()->restoreRenderTarget();
-    glViewport(_viewport[0], _viewport[1], _viewport[2], _viewport[3]);
+    renderstate::viewport(_viewport[0], _viewport[1], _viewport[2], _viewport[3]);
 }
 
@@ -0,0 +1,258 @@
+//
+//  CURenderTargetPool.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a pool of offscreen render targets. Post-processing
+//  effects and cached scene graph nodes need render targets of the same few
+//  sizes over and over again. Allocating a framebuffer (and its textures) each
+//  time churns GPU memory, so this pool keeps released targets, indexed by
+//  size and format, and hands them out again. Idle targets are deleted if they
+//  are not reused within a few frames.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/render/CURenderTargetPool.h>
+#include <cugl/util/CUDebug.h>
+#include <algorithm>
+
+using namespace cugl;
+
+/**
+ * Returns the number of samples a render target will actually use
+ *
+ * Requests are clamped to the maximum supported by the platform, and
+ * values of 1 or less disable multisampling.
+ *
+ * @param samples   The requested number of samples
+ *
+ * @return the number of samples a render target will actually use
+ */
+static int normalize_samples(int samples) {
+    if (samples <= 1) {
+        return 0;
+    }
+    static GLint limit = -1;
+    if (limit < 0) {
+        glGetIntegerv(GL_MAX_SAMPLES, &limit);
+    }
+    int result = std::min(samples,(int)limit);
+    return (result <= 1 ? 0 : result);
+}
+
+#pragma mark Constructors
+/**
+ * Disposes all of the resources used by this pool.
+ *
+ * All idle targets are deleted. Targets that are still acquired are not
+ * affected. A disposed pool can be safely reinitialized.
+ */
+void RenderTargetPool::dispose() {
+    _idle.clear();
+    _transient.clear();
+    _idleCount = 0;
+    _frame = 0;
+    _lifetime = 0;
+}
+
+/**
+ * Initializes a render target pool that keeps idle targets for the given frames.
+ *
+ * @param lifetime  The number of frames an idle target is kept
+ *
+ * @return true if the pool is initialized properly, false otherwise.
+ */
+bool RenderTargetPool::init(Uint32 lifetime) {
+    _lifetime = lifetime;
+    return true;
+}
+
+/**
+ * Returns the pool key for the given target attributes
+ *
+ * The number of samples should be normalized to what the platform
+ * supports, as this is the value stored in the render target.
+ *
+ * @param width     The target width
+ * @param height    The target height
+ * @param format    The target pixel format
+ * @param samples   The number of samples per pixel
+ *
+ * @return the pool key for the given target attributes
+ */
+Uint64 RenderTargetPool::makeKey(int width, int height, Texture::PixelFormat format, int samples) {
+    // Formats are GL enums, which are 16 bit; targets are never 2^20 pixels wide
+    Uint64 result = (Uint64)(width & 0xFFFFF) << 44;
+    result |= (Uint64)(height & 0xFFFFF) << 24;
+    result |= (Uint64)((GLenum)format & 0xFFFF) << 8;
+    result |= (Uint64)(samples & 0xFF);
+    return result;
+}
+
+#pragma mark Targets
+/**
+ * Returns a render target with the given attributes.
+ *
+ * If there is an idle target with these attributes, it is returned.
+ * Otherwise a new target is allocated. The target should be returned to
+ * the pool with {@link #release} when it is no longer needed. The clear
+ * color of the target is unchanged, so it should be set after acquisition.
+ *
+ * This method returns nullptr if the target could not be allocated.
+ *
+ * @param width     The drawing width of the render target
+ * @param height    The drawing height of the render target
+ * @param format    The pixel format of the output texture
+ * @param samples   The number of samples per pixel (1 or less to disable)
+ *
+ * @return a render target with the given attributes.
+ */
+std::shared_ptr<RenderTarget> RenderTargetPool::acquire(int width, int height,
+                                                        Texture::PixelFormat format,
+                                                        int samples) {
+    samples = normalize_samples(samples);
+    if (samples && format != Texture::PixelFormat::RGBA) {
+        CUWarn("Multisampled render targets must be RGBA");
+        samples = 0;
+    }
+
+    auto it = _idle.find(makeKey(width,height,format,samples));
+    if (it != _idle.end() && !it->second.empty()) {
+        // The most recently released target is the most likely to be cached
+        std::shared_ptr<RenderTarget> result = it->second.back().target;
+        it->second.pop_back();
+        _idleCount--;
+        return result;
+    }
+
+    std::shared_ptr<RenderTarget> result;
+    if (samples) {
+        result = RenderTarget::allocMultisample(width,height,samples);
+    } else {
+        result = RenderTarget::alloc(width,height,{format});
+    }
+    if (result == nullptr) {
+        CULogError("Could not allocate a %dx%d render target",width,height);
+    }
+    return result;
+}
+
+/**
+ * Returns a render target with the given attributes for this frame only.
+ *
+ * This method is the same as {@link #acquire}, except that the target is
+ * released automatically at the next call to {@link #advance}. The target
+ * should not be used after that, even if a reference is still held.
+ * Transient targets should never be released explicitly.
+ *
+ * This method returns nullptr if the target could not be allocated.
+ *
+ * @param width     The drawing width of the render target
+ * @param height    The drawing height of the render target
+ * @param format    The pixel format of the output texture
+ * @param samples   The number of samples per pixel (1 or less to disable)
+ *
+ * @return a render target with the given attributes for this frame only.
+ */
+std::shared_ptr<RenderTarget> RenderTargetPool::acquireTransient(int width, int height,
+                                                                 Texture::PixelFormat format,
+                                                                 int samples) {
+    std::shared_ptr<RenderTarget> result = acquire(width,height,format,samples);
+    if (result != nullptr) {
+        _transient.push_back(result);
+    }
+    return result;
+}
+
+/**
+ * Returns a render target to this pool.
+ *
+ * The target becomes idle, and may be returned by a later acquisition. Only
+ * targets with a single output texture are kept. Other targets are ignored.
+ *
+ * @param target    The render target to release
+ */
+void RenderTargetPool::release(const std::shared_ptr<RenderTarget>& target) {
+    if (target == nullptr || target->getOutputSize() != 1) {
+        return;
+    }
+    Uint64 key = makeKey(target->getWidth(),target->getHeight(),
+                         target->getTexture()->getFormat(),target->getSamples());
+    _idle[key].push_back({target,_frame});
+    _idleCount++;
+}
+
+/**
+ * Ends the current frame of this pool.
+ *
+ * This method releases all transient targets, and deletes any idle targets
+ * that have not been reused within the lifetime of this pool. It should be
+ * called once a frame, after all drawing is done.
+ */
+void RenderTargetPool::advance() {
+    for(auto it = _transient.begin(); it != _transient.end(); ++it) {
+        release(*it);
+    }
+    _transient.clear();
+    _frame++;
+
+    if (_idleCount == 0) {
+        return;
+    }
+    for(auto it = _idle.begin(); it != _idle.end(); ) {
+        std::vector<Idle>& idle = it->second;
+        // Targets are released in frame order, so the oldest are first
+        size_t stale = 0;
+        while (stale < idle.size() && idle[stale].frame+_lifetime < _frame) {
+            stale++;
+        }
+        idle.erase(idle.begin(),idle.begin()+stale);
+        _idleCount -= stale;
+        if (idle.empty()) {
+            it = _idle.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * Deletes all idle render targets.
+ *
+ * Targets that are still acquired (including transient ones) are not
+ * affected.
+ */
+void RenderTargetPool::clear() {
+    _idle.clear();
+    _idleCount = 0;
+}
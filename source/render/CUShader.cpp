@@ -32,10 +32,24 @@
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUStrings.h>
 #include <cugl/render/CUShader.h>
+#include <cugl/render/CURenderState.h>
 #include <cugl/render/CUTexture.h>
+#include <cugl/io/CUBinaryReader.h>
+#include <cugl/io/CUBinaryWriter.h>
+#include <cugl/util/CUFiletools.h>
+#include <cugl/util/CUProfiler.h>
+#include <cstdio>
 
 using namespace cugl;
 
+/** The magic number at the start of a cached program binary */
+#define BINARY_MAGIC        0x43554753
+/** The status query of the parallel shader compile extension */
+#define COMPLETION_STATUS   0x91B1
+
+/** The directory for cached program binaries (empty if disabled) */
+std::string Shader::_cacheDir;
+
 /**
  * Returns a pre-processed copy of a GLSL program
  *
@@ -53,6 +67,61 @@ static std::string preprocess_shader(const std::string code) {
     return source;
 }
 
+/**
+ * Folds the given string into a 64-bit FNV-1a hash.
+ *
+ * This hash is stable across launches and platforms (unlike std::hash),
+ * so it is safe to use as the name of a cached file.
+ *
+ * @param hash  The hash so far
+ * @param text  The string to add to the hash
+ *
+ * @return the updated hash
+ */
+static Uint64 hash_string(Uint64 hash, const char* text) {
+    if (text == nullptr) {
+        text = "";
+    }
+    for(const char* c = text; *c; c++) {
+        hash ^= (Uint8)(*c);
+        hash *= 0x100000001b3ULL;
+    }
+    // Separate the strings so "ab"+"c" differs from "a"+"bc"
+    hash ^= 0xff;
+    hash *= 0x100000001b3ULL;
+    return hash;
+}
+
+/**
+ * Returns true if the driver can save and load program binaries.
+ *
+ * @return true if the driver can save and load program binaries.
+ */
+static bool has_binaries() {
+    static GLint formats = -1;
+    if (formats < 0) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    return formats > 0;
+}
+
+/**
+ * Returns true if the driver can report whether a compilation is done.
+ *
+ * This is the case if the driver supports the parallel shader compile
+ * extension. Otherwise, any status query blocks until compilation is done.
+ *
+ * @return true if the driver can report whether a compilation is done.
+ */
+static bool has_parallel() {
+    static int parallel = -1;
+    if (parallel < 0) {
+        parallel = (SDL_GL_ExtensionSupported("GL_KHR_parallel_shader_compile") ||
+                    SDL_GL_ExtensionSupported("GL_ARB_parallel_shader_compile")) ? 1 : 0;
+    }
+    return parallel == 1;
+}
+
 #pragma mark -
 #pragma mark Compilation
 /**
@@ -63,10 +132,43 @@ static std::string preprocess_shader(const std::string code) {
  * @return true if compilation was successful.
  */
 bool Shader::compile() {
+    return submit() && complete();
+}
+
+/**
+ * Submits this shader to the driver without waiting for the result.
+ *
+ * If there is a valid cached binary for this shader, it is loaded in
+ * place of the source. Otherwise this method compiles the vertex and
+ * fragment sources and links them. In either case, the status is not
+ * queried, so that the driver can finish in the background.
+ *
+ * @return true if the shader was submitted.
+ */
+bool Shader::submit() {
+    CU_PROFILE_SCOPE("Shader::submit");
+    CU_PROFILE_BYTES(_vertSource.size()+_fragSource.size());
     CUAssertLog(!_vertSource.empty(), "Vertex shader source is not defined");
     CUAssertLog(!_fragSource.empty(), "Fragment shader source is not defined");
     CUAssertLog(!_program,   "This shader is already compiled");
     
+    _binary = loadBinary();
+    if (!_binary && !submitSource()) {
+        return false;
+    }
+    _pending = true;
+    return true;
+}
+
+/**
+ * Compiles the vertex and fragment sources and links them.
+ *
+ * The status is not queried, so that the driver can finish in the
+ * background.
+ *
+ * @return true if the program was allocated.
+ */
+bool Shader::submitSource() {
     _program = glCreateProgram();
     if (!_program) {
         CULogError("Unable to allocate shader program");
@@ -78,12 +180,6 @@ bool Shader::compile() {
     const char* source = _vertSource.c_str();
     glShaderSource( _vertShader, 1, &source, nullptr );
     glCompileShader( _vertShader );
-    
-    // Validate and quit if failed
-    if (!validateShader(_vertShader, "vertex")) {
-        dispose();
-        return false;
-    }
 
     //Create fragment shader and compile it
     _fragShader = glCreateShader( GL_FRAGMENT_SHADER );
@@ -91,19 +187,62 @@ bool Shader::compile() {
     glShaderSource( _fragShader, 1, &source, nullptr );
     glCompileShader( _fragShader );
     
+    // Now kiss
+    glAttachShader( _program, _vertShader );
+    glAttachShader( _program, _fragShader );
+    if (!_cacheDir.empty()) {
+        glProgramParameteri( _program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+    }
+    glLinkProgram( _program );
+    return true;
+}
+
+/**
+ * Completes a shader submitted with {@link #submit}.
+ *
+ * This method blocks until the driver is done. If a cached binary was
+ * rejected, it compiles the source instead. If the source was compiled,
+ * the linked program is saved to the binary cache.
+ *
+ * If compilation fails, it will display error messages on the log.
+ *
+ * @return true if compilation was successful.
+ */
+bool Shader::complete() {
+    // The status query blocks until the driver finishes the compile
+    CU_PROFILE_SCOPE("Shader::complete");
+    _pending = false;
+    GLint programSuccess = GL_TRUE;
+    if (_binary) {
+        glGetProgramiv( _program, GL_LINK_STATUS, &programSuccess );
+        if (programSuccess == GL_TRUE) {
+            return true;
+        }
+        
+        // The driver changed in a way the key did not catch
+        glGetError();
+        CULog("Discarding stale shader binary %s", getBinaryPath().c_str());
+        filetool::file_delete(getBinaryPath());
+        renderstate::forgetProgram(_program);
+        glDeleteProgram(_program);
+        _program = 0;
+        _binary = false;
+        if (!submitSource()) {
+            return false;
+        }
+    }
+    
     // Validate and quit if failed
+    if (!validateShader(_vertShader, "vertex")) {
+        dispose();
+        return false;
+    }
     if (!validateShader(_fragShader, "fragment")) {
         dispose();
         return false;
     }
     
-    // Now kiss
-    glAttachShader( _program, _vertShader );
-    glAttachShader( _program, _fragShader );
-    glLinkProgram( _program );
-    
     //Check for errors
-    GLint programSuccess = GL_TRUE;
     glGetProgramiv( _program, GL_LINK_STATUS, &programSuccess );
     if( programSuccess != GL_TRUE ) {
         CULogError( "Unable to link program %d.\n", _program );
@@ -112,6 +251,7 @@ bool Shader::compile() {
         return false;
     }
     
+    saveBinary();
     return true;
 }
 
@@ -121,19 +261,23 @@ bool Shader::compile() {
  * You must reinitialize the shader to use it.
  */
 void Shader::dispose() {
-    glUseProgram(0);
+    renderstate::useProgram(0);
     if (_fragShader) { glDeleteShader(_fragShader); _fragShader = 0;}
     if (_vertShader) { glDeleteShader(_vertShader); _vertShader = 0;}
-    if (_program) { glDeleteShader(_program); _program = 0;}
+    if (_program) { renderstate::forgetProgram(_program); glDeleteShader(_program); _program = 0;}
+    _pending = false;
+    _binary = false;
     _vertSource.clear();
     _fragSource.clear();
 
     _attribtypes.clear();
     _attribnames.clear();
     _attribsizes.clear();
+    _attriblocs.clear();
     _uniformtypes.clear();
     _uniformnames.clear();
     _uniformsizes.clear();
+    _uniformlocs.clear();
     _uniblocknames.clear();
     _uniblocksizes.clear();
     _uniblockfields.clear();
@@ -226,6 +370,9 @@ void Shader::logProgramError( GLuint program ) {
 
 /**
  * Querys all of the shader attributes and caches them for fast look-ups
+ *
+ * This includes the attribute locations, so that they are never queried
+ * from OpenGL after linking.
  */
 void Shader::cacheAttributes() {
     GLint count;
@@ -233,19 +380,21 @@ void Shader::cacheAttributes() {
     GLint size;     // size of the variable
     GLenum type;    // type of the variable (float, vec3 or mat4, etc)
 
-    const GLsizei bufSize = 16; // maximum name length
-    GLchar name[bufSize];       // variable name in GLSL
+    GLint bufSize = 0;          // maximum name length
     GLsizei length;             // name length
+    glGetProgramiv(_program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &bufSize);
+    std::vector<GLchar> name(SDL_max(bufSize,1)+1);  // variable name in GLSL
     
     glGetProgramiv(_program, GL_ACTIVE_ATTRIBUTES, &count);
     for (GLuint ii = 0; ii < count; ii++) {
-        glGetActiveAttrib(_program, ii, bufSize, &length, &size, &type, name);
+        glGetActiveAttrib(_program, ii, (GLsizei)name.size(), &length, &size, &type, name.data());
         GLenum error = glGetError();
         if (!error) {
-            std::string key(name);
+            std::string key(name.data(),length);
             _attribtypes[key] = type;
             _attribsizes[key] = size;
             _attribnames[ii] = key;
+            _attriblocs[key] = glGetAttribLocation(_program, key.c_str());
         }
     }
 }
@@ -261,28 +410,42 @@ void Shader::cacheUniforms() {
     GLint size;     // size of the variable
     GLenum type;    // type of the variable (float, vec3 or mat4, etc)
 
-    const GLsizei bufSize = 16; // maximum name length
-    GLchar name[bufSize];       // variable name in GLSL
+    GLint bufSize = 0;          // maximum name length
+    GLint blockSize = 0;        // maximum block name length
     GLsizei length;             // name length
+    glGetProgramiv(_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &bufSize);
+    glGetProgramiv(_program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &blockSize);
+    std::vector<GLchar> name(SDL_max(SDL_max(bufSize,blockSize),1)+1);  // variable name in GLSL
     
     glGetProgramiv(_program, GL_ACTIVE_UNIFORMS, &count);
     for (GLuint ii = 0; ii < count; ii++) {
-        glGetActiveUniform(_program, ii, bufSize, &length, &size, &type, name);
+        glGetActiveUniform(_program, ii, (GLsizei)name.size(), &length, &size, &type, name.data());
         GLenum error = glGetError();
         if (!error) {
-            std::string key(name);
+            std::string key(name.data(),length);
             _uniformtypes[key] = type;
             _uniformsizes[key] = size;
             _uniformnames[ii]  = key;
+            
+            // Uniforms in a block have no location
+            GLint locale = glGetUniformLocation(_program, key.c_str());
+            if (locale >= 0) {
+                _uniformlocs[key] = locale;
+                // Arrays are reported as the first element
+                size_t pos = key.size() > 3 ? key.size()-3 : 0;
+                if (key.compare(pos,3,"[0]") == 0) {
+                    _uniformlocs[key.substr(0,pos)] = locale;
+                }
+            }
         }
     }
     
     glGetProgramiv(_program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
     for (GLuint ii = 0; ii < count; ii++) {
-        glGetActiveUniformBlockName(_program, ii, bufSize, &length, name);
+        glGetActiveUniformBlockName(_program, ii, (GLsizei)name.size(), &length, name.data());
         GLenum error = glGetError();
         if (!error) {
-            std::string key(name);
+            std::string key(name.data(),length);
             glGetActiveUniformBlockiv(_program, ii, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
             _uniblocksizes[key] = size;
             _uniblocknames[ii]  = key;
@@ -328,6 +491,202 @@ bool Shader::init(const std::string vsource, const std::string fsource) {
     return true;
 }
 
+/**
+ * Initializes this shader with the given source, without waiting for it.
+ *
+ * The shader is submitted to the driver, but this method does not wait
+ * for compilation to finish. The shader is not ready for use until
+ * {@link #finish} is called. Use {@link #isPending} to poll whether
+ * {@link #finish} would block. This allows the driver to compile several
+ * shaders while the application draws a splash screen.
+ *
+ * This method only reports failures to allocate the program. Errors in
+ * the source are reported by {@link #finish}.
+ *
+ * @param vsource   The source string for the vertex shader.
+ * @param fsource   The source string for the fragment shader.
+ *
+ * @return true if the shader was submitted.
+ */
+bool Shader::initAsync(const std::string vsource, const std::string fsource) {
+    _vertSource = vsource;
+    _fragSource = fsource;
+    return submit();
+}
+
+/**
+ * Returns true if the driver is still compiling this shader.
+ *
+ * This is only meaningful for shaders initialized with {@link #initAsync}.
+ * If the driver cannot report its progress (it does not support the
+ * parallel shader compile extension), this method returns false once
+ * the shader is submitted, and {@link #finish} may block.
+ *
+ * @return true if the driver is still compiling this shader.
+ */
+bool Shader::isPending() const {
+    if (!_pending || !has_parallel()) {
+        return false;
+    }
+    GLint done = GL_TRUE;
+    glGetProgramiv(_program, COMPLETION_STATUS, &done);
+    return done != GL_TRUE;
+}
+
+/**
+ * Completes a shader initialized with {@link #initAsync}.
+ *
+ * This method blocks until compilation is done, and then prepares the
+ * shader for use. When it is done, the shader will be bound and active.
+ * If compilation fails, it will display error messages on the log. This
+ * method does nothing if the shader is already finished.
+ *
+ * @return true if compilation was successful.
+ */
+bool Shader::finish() {
+    if (!_pending) {
+        return _program != 0;
+    }
+    if (!complete()) {
+        return false;
+    }
+    
+    cacheAttributes();
+    cacheUniforms();
+    bind();
+    return true;
+}
+
+
+#pragma mark -
+#pragma mark Binary Cache
+/**
+ * Sets the directory for cached program binaries.
+ *
+ * When this directory is set, the program of each compiled shader is
+ * saved there as a driver binary. Later initializations of a shader
+ * with the same source load the binary instead, which is much faster
+ * on some mobile drivers. Binaries are keyed by the shader source and
+ * the driver version, and any binary the driver rejects is replaced.
+ *
+ * If the path is relative, it is placed in the application save
+ * directory. An empty path disables the cache, which is the default.
+ * The cache is also disabled if the driver has no binary formats.
+ *
+ * @param dir   The directory for cached program binaries
+ */
+void Shader::setBinaryCache(const std::string dir) {
+    if (dir.empty()) {
+        _cacheDir.clear();
+        return;
+    }
+    _cacheDir = filetool::normalize_path(dir);
+    if (!filetool::is_dir(_cacheDir) && !filetool::dir_create(_cacheDir)) {
+        CULogError("Could not create shader cache %s", _cacheDir.c_str());
+        _cacheDir.clear();
+    }
+}
+
+/**
+ * Returns the path of the cached binary for this shader.
+ *
+ * The path is a hash of the shader sources and the driver version, so
+ * a driver update or a change to the source never loads a stale binary.
+ *
+ * @return the path of the cached binary for this shader.
+ */
+std::string Shader::getBinaryPath() const {
+    Uint64 hash = 0xcbf29ce484222325ULL;
+    hash = hash_string(hash, _vertSource.c_str());
+    hash = hash_string(hash, _fragSource.c_str());
+    hash = hash_string(hash, (const char*)glGetString(GL_VENDOR));
+    hash = hash_string(hash, (const char*)glGetString(GL_RENDERER));
+    hash = hash_string(hash, (const char*)glGetString(GL_VERSION));
+    
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+    return filetool::join_path({_cacheDir,name});
+}
+
+/**
+ * Loads a cached binary for this shader, returning true on success.
+ *
+ * The binary is only submitted to the driver. Whether the driver
+ * accepts it is known in {@link #complete}.
+ *
+ * @return true if a cached binary was submitted
+ */
+bool Shader::loadBinary() {
+    if (_cacheDir.empty() || !has_binaries()) {
+        return false;
+    }
+    std::string path = getBinaryPath();
+    if (!filetool::file_exists(path)) {
+        return false;
+    }
+    
+    std::shared_ptr<BinaryReader> reader = BinaryReader::alloc(path);
+    if (reader == nullptr) {
+        return false;
+    }
+    if (!reader->ready(3*sizeof(Uint32)) || reader->readUint32() != BINARY_MAGIC) {
+        reader->close();
+        return false;
+    }
+    GLenum format = (GLenum)reader->readUint32();
+    Uint32 length = reader->readUint32();
+    std::vector<Uint8> data(length);
+    size_t amount = 0;
+    while (amount < length && reader->ready()) {
+        amount += reader->read(data.data(), length-amount, amount);
+    }
+    reader->close();
+    if (amount < length) {
+        return false;
+    }
+    
+    _program = glCreateProgram();
+    if (!_program) {
+        return false;
+    }
+    glProgramBinary(_program, format, data.data(), (GLsizei)length);
+    return true;
+}
+
+/**
+ * Saves the binary of the linked program to the cache.
+ *
+ * This method does nothing if the cache is disabled or the driver does
+ * not support program binaries.
+ */
+void Shader::saveBinary() {
+    if (_cacheDir.empty() || !has_binaries()) {
+        return;
+    }
+    GLint length = 0;
+    glGetProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    
+    std::vector<Uint8> data(length);
+    GLenum format = 0;
+    glGetProgramBinary(_program, length, &length, &format, data.data());
+    if (glGetError() != GL_NO_ERROR) {
+        return;
+    }
+    
+    std::shared_ptr<BinaryWriter> writer = BinaryWriter::alloc(getBinaryPath());
+    if (writer == nullptr) {
+        return;
+    }
+    writer->writeUint32(BINARY_MAGIC);
+    writer->writeUint32((Uint32)format);
+    writer->writeUint32((Uint32)length);
+    writer->write(data.data(), (size_t)length);
+    writer->close();
+}
+
 /**
  * Binds this shader, making it active.
  *
@@ -336,7 +695,7 @@ bool Shader::init(const std::string vsource, const std::string fsource) {
  */
 void Shader::bind() {
     CUAssertLog(_program, "Shader has not been initialized.");
-    glUseProgram( _program );
+    renderstate::useProgram( _program );
 }
 
 /**
@@ -347,7 +706,7 @@ void Shader::bind() {
 void Shader::unbind() {
     CUAssertLog(_program, "Shader has not been initialized.");
     if (isBound()) {
-        glUseProgram( 0 );
+        renderstate::useProgram( 0 );
     }
 }
 
@@ -359,9 +718,7 @@ void Shader::unbind() {
  * @return true if this shader is currently bound.
  */
 bool Shader::isBound() const {
-    GLint prog;
-    glGetIntegerv(GL_CURRENT_PROGRAM,&prog);
-    return prog == _program;
+    return renderstate::getProgram() == _program;
 }
  
 
@@ -383,14 +740,17 @@ std::vector<std::string> Shader::getAttributes() const {
 /**
  * Returns the program offset of the given attribute
  *
- * If name is not a valid attribute, this method returns -1.
+ * If name is not a valid attribute, this method returns -1. The offsets
+ * are reflected when the shader is linked, so this method does not query
+ * OpenGL.
  *
  * @param name  The attribute variable name
  *
  * @return the program offset of the given attribute
  */
-GLint Shader::getAttributeLocation(const std::string name) const {
-    return glGetAttribLocation(_program,name.c_str());
+GLint Shader::getAttributeLocation(const std::string& name) const {
+    auto search = _attriblocs.find(name);
+    return search == _attriblocs.end() ? -1 : search->second;
 }
 
 /**
@@ -400,7 +760,7 @@ GLint Shader::getAttributeLocation(const std::string name) const {
  *
  * @return the size (in bytes) of the given attribute
  */
-GLint Shader::getAttributeSize(const std::string name) const {
+GLint Shader::getAttributeSize(const std::string& name) const {
     auto search = _attribsizes.find(name);
     if (search == _attribsizes.end()) {
         return -1;
@@ -417,7 +777,7 @@ GLint Shader::getAttributeSize(const std::string name) const {
  *
  * @return the type of the given attribute
  */
-GLenum Shader::getAttributeType(const std::string name) const  {
+GLenum Shader::getAttributeType(const std::string& name) const  {
     auto search = _attribtypes.find(name);
     if (search == _attribtypes.end()) {
         return GL_FALSE;
@@ -446,7 +806,7 @@ GLenum Shader::getAttributeType(const std::string name) const  {
  *
  * @return the program offset of the given output variable.
  */
-GLint Shader::getOutputLocation(const std::string name) const {
+GLint Shader::getOutputLocation(const std::string& name) const {
     return glGetFragDataLocation(_program, name.c_str());
 }
 
@@ -469,14 +829,23 @@ std::vector<std::string> Shader::getUniforms() const {
 /**
  * Returns the program offset of the given uniform
  *
- * If name is not a valid uniform, this method returns -1.
+ * If name is not a valid uniform, this method returns -1. The offsets
+ * are reflected when the shader is linked, so this method does not query
+ * OpenGL. The only exception is an element of a uniform array other than
+ * the first (e.g. "uTextures[1]").
  *
  * @param name  The uniform variable name
  *
  * @return the program offset of the given uniform
  */
-GLint Shader::getUniformLocation(const std::string name) const {
-    return glGetUniformLocation(_program,name.c_str());
+GLint Shader::getUniformLocation(const std::string& name) const {
+    auto search = _uniformlocs.find(name);
+    if (search != _uniformlocs.end()) {
+        return search->second;
+    } else if (name.find('[') != std::string::npos) {
+        return glGetUniformLocation(_program,name.c_str());
+    }
+    return -1;
 }
 
 /**
@@ -488,7 +857,7 @@ GLint Shader::getUniformLocation(const std::string name) const {
  *
  * @return the size (in bytes) of the given uniform
  */
-GLint Shader::getUniformSize(const std::string name) const {
+GLint Shader::getUniformSize(const std::string& name) const {
     auto search = _uniformsizes.find(name);
     if (search == _uniformsizes.end()) {
         return -1;
@@ -505,7 +874,7 @@ GLint Shader::getUniformSize(const std::string name) const {
  *
  * @return the type of the given uniform
  */
-GLenum Shader::getUniformType(const std::string name) const {
+GLenum Shader::getUniformType(const std::string& name) const {
     auto search = _uniformtypes.find(name);
     if (search == _uniformtypes.end()) {
         return GL_FALSE;
@@ -548,9 +917,9 @@ std::vector<std::string> Shader::getSamplers() const {
  *
  * @return the program offset of the given sampler variable
  */
-GLint Shader::getSamplerLocation(const std::string name) const {
-    GLint result =  glGetUniformLocation(_program,name.c_str());
-    if (result != -1 && _uniformtypes.at(name) != GL_SAMPLER_2D) {
+GLint Shader::getSamplerLocation(const std::string& name) const {
+    GLint result = getUniformLocation(name);
+    if (result != -1 && getUniformType(name) != GL_SAMPLER_2D) {
         result = -1;
     }
     return result;
@@ -592,7 +961,7 @@ void Shader::setSampler(GLint pos, GLuint bpoint) {
  * @param name      The name of the sampler variable
  * @param bpoint   The bindpoint for the sampler
  */
-void Shader::setSampler(const std::string name, GLuint bpoint) {
+void Shader::setSampler(const std::string& name, GLuint bpoint) {
     setUniform1ui(name,bpoint);
 }
 
@@ -629,7 +998,7 @@ void Shader::setSampler(GLint pos, const std::shared_ptr<Texture>& texture) {
  * @param name      The name of the sampler variable
  * @param texture   The texture to initialize the bindpoint
  */
-void Shader::setSampler(const std::string name, const std::shared_ptr<Texture>& texture) {
+void Shader::setSampler(const std::string& name, const std::shared_ptr<Texture>& texture) {
     GLuint bpoint = texture == nullptr ? 0 : texture->getBindPoint();
     setUniform1ui(name,bpoint);
 }
@@ -662,7 +1031,7 @@ GLuint Shader::getSampler(GLint pos) const {
  *
  * @return the texture bindpoint associated with the given sampler variable.
  */
-GLuint Shader::getSampler(const std::string name) const {
+GLuint Shader::getSampler(const std::string& name) const {
     GLuint result = 0;
     getUniformuiv(name,1,&result);
     return result;
@@ -729,7 +1098,7 @@ std::vector<std::string> Shader::getUniformsForBlock(GLint pos) const {
  *
  * @return a vector of all uniform blocks used by this shader
  */
-std::vector<std::string> Shader::getUniformsForBlock(std::string name) const {
+std::vector<std::string> Shader::getUniformsForBlock(const std::string& name) const {
     std::vector<std::string> result;
     GLuint index = glGetUniformBlockIndex(_program, name.c_str());
     if (index == GL_INVALID_INDEX) {
@@ -773,7 +1142,7 @@ void Shader::setUniformBlock(GLint pos, GLuint bindpoint) {
  * @param name      The name of the uniform block in the shader
  * @param bpoint   The bindpoint for the uniform block
  */
-void Shader::setUniformBlock(const std::string name, GLuint bindpoint) {
+void Shader::setUniformBlock(const std::string& name, GLuint bindpoint) {
     GLuint index = glGetUniformBlockIndex(_program, name.c_str());
     if (index != GL_INVALID_INDEX) {
         glUniformBlockBinding(_program, index, bindpoint);
@@ -804,7 +1173,7 @@ void Shader::setUniformBlock(GLint pos, const std::shared_ptr<UniformBuffer>& bu
     // Do some verification
     for(auto it = _uniblockfields.begin(); it != _uniblockfields.end(); ++it) {
         if (it->second == pos) {
-            const std::string name = _uniformnames.at(it->first);
+            const std::string& name = _uniformnames.at(it->first);
             GLsizei offset = buffer->getOffset(name);
             if (offset == cugl::UniformBuffer::INVALID_OFFSET) {
                 CUWarn("Uniform buffer is missing variable '%s'.",name.c_str());
@@ -850,7 +1219,7 @@ void Shader::setUniformBlock(GLint pos, const std::shared_ptr<UniformBuffer>& bu
  * @param name      The name of the uniform block in the shader
  * @param buffer    The buffer to bind to this uniform block
  */
-void Shader::setUniformBlock(const std::string name,
+void Shader::setUniformBlock(const std::string& name,
                              const std::shared_ptr<UniformBuffer>& buffer) {
     GLuint index = glGetUniformBlockIndex(_program, name.c_str());
     if (index != GL_INVALID_INDEX) {
@@ -886,7 +1255,7 @@ GLuint Shader::getUniformBlock(GLint pos) const {
  *
  * @return the buffer bindpoint associated with the given uniform block.
  */
-GLuint Shader::getUniformBlock(const std::string name) const {
+GLuint Shader::getUniformBlock(const std::string& name) const {
     GLuint index = glGetUniformBlockIndex(_program, name.c_str());
     if (index == GL_INVALID_INDEX) {
         return 0;
@@ -921,9 +1290,9 @@ void Shader::setUniformVec2(GLint pos, const Vec2 vec) {
  * @param name  The name of the uniform
  * @param vec   The value for the uniform
  */
-void Shader::setUniformVec2(const std::string name, const Vec2 vec) {
+void Shader::setUniformVec2(const std::string& name, const Vec2 vec) {
     CUAssertLog(isBound(), "Shader is not active.");
-    GLint locale = getUniformLocation(name.c_str());
+    GLint locale = getUniformLocation(name);
     if (locale >= 0) glUniform2f(locale,vec.x,vec.y);
 }
 
@@ -954,7 +1323,7 @@ bool Shader::getUniformVec2(GLint pos, Vec2& vec) const {
  *
  * @return true if it can access the given uniform as a vector.
  */
-bool Shader::getUniformVec2(const std::string name, Vec2& vec) const {
+bool Shader::getUniformVec2(const std::string& name, Vec2& vec) const {
     float* data = reinterpret_cast<float*>(&vec);
     return getUniformfv(name, 2, data);
 }
@@ -980,9 +1349,9 @@ void Shader::setUniformVec3(GLint pos, const Vec3 vec) {
  * @param name  The name of the uniform
  * @param vec   The value for the uniform
  */
-void Shader::setUniformVec3(const std::string name, const Vec3 vec) {
+void Shader::setUniformVec3(const std::string& name, const Vec3 vec) {
     CUAssertLog(isBound(), "Shader is not active.");
-    GLint locale = getUniformLocation(name.c_str());
+    GLint locale = getUniformLocation(name);
     if (locale >= 0) glUniform3f(locale,vec.x,vec.y,vec.z);
 }
 
@@ -1013,7 +1382,7 @@ bool Shader::getUniformVec3(GLint pos, Vec3& vec) const {
  *
  * @return true if it can access the given uniform as a vector.
  */
-bool Shader::getUniformVec3(const std::string name, Vec3& vec) const {
+bool Shader::getUniformVec3(const std::string& name, Vec3& vec) const {
     float* data = reinterpret_cast<float*>(&vec);
     return getUniformfv(name, 3, data);
 }
@@ -1039,9 +1408,9 @@ void Shader::setUniformVec4(GLint pos, const Vec4 vec) {
  * @param name  The name of the uniform
  * @param vec   The value for the uniform
  */
-void Shader::setUniformVec4(const std::string name, const Vec4 vec) {
+void Shader::setUniformVec4(const std::string& name, const Vec4 vec) {
     CUAssertLog(isBound(), "Shader is not active.");
-    GLint locale = getUniformLocation(name.c_str());
+    GLint locale = getUniformLocation(name);
     if (locale >= 0) glUniform4f(locale,vec.x,vec.y,vec.z,vec.w);
 }
 
@@ -1072,7 +1441,7 @@ bool Shader::getUniformVec4(GLint pos, Vec4& vec) const {
  *
  * @return true if it can access the given uniform as a vector.
  */
-bool Shader::getUniformVec4(const std::string name, Vec4& vec) const {
+bool Shader::getUniformVec4(const std::string& name, Vec4& vec) const {
     float* data = reinterpret_cast<float*>(&vec);
     return getUniformfv(name, 4, data);
 }
@@ -1097,7 +1466,7 @@ void Shader::setUniformColor4(GLint pos, const Color4 color) {
  * @param name      The name of the uniform
  * @param color   The value for the uniform
  */
-void Shader::setUniformColor4(const std::string name, const Color4 color) {
+void Shader::setUniformColor4(const std::string& name, const Color4 color) {
     setUniformVec4(name, (Vec4)color);
 }
 
@@ -1132,7 +1501,7 @@ bool Shader::getUniformColor4(GLint pos, Color4& color) const {
  *
  * @return true if it can access the given uniform as a color.
  */
-bool Shader::getUniformColor4(const std::string name, Color4& color) const {
+bool Shader::getUniformColor4(const std::string& name, Color4& color) const {
     float data[4];
     if (getUniformfv(name, 4, data)) {
         color.set(data);
@@ -1160,7 +1529,7 @@ void Shader::setUniformColor4f(GLint pos, const Color4f color) {
  * @param name      The name of the uniform
  * @param color   The value for the uniform
  */
-void Shader::setUniformColor4f(const std::string name, const Color4f color) {
+void Shader::setUniformColor4f(const std::string& name, const Color4f color) {
     setUniformVec4(name, (Vec4)color);
 }
 
@@ -1191,7 +1560,7 @@ bool Shader::getUniformColor4f(GLint pos, Color4f& color) const {
  *
  * @return true if it can access the given uniform as a color.
  */
-bool Shader::getUniformColor4f(const std::string name, Color4f& color) const {
+bool Shader::getUniformColor4f(const std::string& name, Color4f& color) const {
     float* data = reinterpret_cast<float*>(&color);
     return (getUniformfv(name, 4, data));
 }
@@ -1219,9 +1588,9 @@ void Shader::setUniformMat4(GLint pos, const Mat4& mat) {
  * @param name  The name of the uniform
  * @param mat   The value for the uniform
  */
-void Shader::setUniformMat4(const std::string name, const Mat4& mat) {
+void Shader::setUniformMat4(const std::string& name, const Mat4& mat) {
     CUAssertLog(isBound(), "Shader is not active.");
-    GLint locale = getUniformLocation(name.c_str());
+    GLint locale = getUniformLocation(name);
     if (locale >= 0) glUniformMatrix4fv(locale,1,false,mat.m);
 }
 
@@ -1251,7 +1620,7 @@ bool Shader::getUniformMat4(GLint pos, Mat4& mat) const {
  *
  * @return true if it can access the given uniform as a matrix.
  */
-bool Shader::getUniformMat4(const std::string name, Mat4& mat) const {
+bool Shader::getUniformMat4(const std::string& name, Mat4& mat) const {
     return getUniformfv(name, 16, mat.m);
 }
 
@@ -1284,9 +1653,9 @@ void Shader::setUniformAffine2(GLint pos, const Affine2& mat) {
  * @param name  The name of the uniform
  * @param mat   The value for the uniform
  */
-void Shader::setUniformAffine2(const std::string name, const Affine2& mat) {
+void Shader::setUniformAffine2(const std::string& name, const Affine2& mat) {
     CUAssertLog(isBound(), "Shader is not active.");
-    GLint locale = getUniformLocation(name.c_str());
+    GLint locale = getUniformLocation(name);
     if (locale >= 0) {
         float data[9];
         mat.get3x3(data);
@@ -1327,7 +1696,7 @@ bool Shader::getUniformAffine2(GLint pos, Affine2& mat) const {
  *
  * @return true if it can access the given uniform as an affine transform.
  */
-bool Shader::getUniformAffine2(const std::string name, Affine2& mat) const {
+bool Shader::getUniformAffine2(const std::string& name, Affine2& mat) const {
     float data[9];
     if (getUniformfv(name, 9, data)) {
         mat.set(data, 3);
@@ -1356,7 +1725,7 @@ void Shader::setUniformQuaternion(GLint pos, const Quaternion& quat) {
  * @param name  The name of the uniform
  * @param quat  The value for the uniform
  */
-void Shader::setUniformQuaternion(const std::string name, const Quaternion& quat) {
+void Shader::setUniformQuaternion(const std::string& name, const Quaternion& quat) {
     setUniformVec4(name, (Vec4)quat);
 }
 
@@ -1387,7 +1756,7 @@ bool Shader::getUniformQuaternion(GLint pos, Quaternion& quat) const {
  *
  * @return true if it can access the given uniform as a quaternion.
  */
-bool Shader::getUniformQuaternion(const std::string name, Quaternion& quat) const {
+bool Shader::getUniformQuaternion(const std::string& name, Quaternion& quat) const {
     float* data = reinterpret_cast<float*>(&quat);
     return getUniformfv(name, 4, data);
 }
@@ -1418,9 +1787,9 @@ void Shader::setUniform1f(GLint pos, GLfloat v0) {
  * @param name  The name of the uniform
  * @param v0    The value for the uniform
  */
-void Shader::setUniform1f(const std::string name, GLfloat v0) {
+void Shader::setUniform1f(const std::string& name, GLfloat v0) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform1f(locale, v0);
 }
 
@@ -1449,9 +1818,9 @@ void Shader::setUniform2f(GLint pos, GLfloat v0, GLfloat v1) {
  * @param v0    The first value for the uniform
  * @param v1    The second value for the uniform
  */
-void Shader::setUniform2f(const std::string name, GLfloat v0, GLfloat v1) {
+void Shader::setUniform2f(const std::string& name, GLfloat v0, GLfloat v1) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform2f(locale, v0, v1);
 }
 
@@ -1482,9 +1851,9 @@ void Shader::setUniform3f(GLint pos, GLfloat v0, GLfloat v1, GLfloat v2) {
  * @param v1    The second value for the uniform
  * @param v2    The third value for the uniform
  */
-void Shader::setUniform3f(const std::string name, GLfloat v0, GLfloat v1, GLfloat v2) {
+void Shader::setUniform3f(const std::string& name, GLfloat v0, GLfloat v1, GLfloat v2) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform3f(locale, v0, v1, v2);
 }
 
@@ -1517,9 +1886,9 @@ void Shader::setUniform4f(GLint pos, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat
  * @param v2    The third value for the uniform
  * @param v3    The fourth value for the uniform
  */
-void Shader::setUniform4f(const std::string name, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
+void Shader::setUniform4f(const std::string& name, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform4f(locale, v0, v1, v2, v3);
 }
 
@@ -1546,9 +1915,9 @@ void Shader::setUniform1i(GLint pos, GLint v0) {
  * @param name  The name of the uniform
  * @param v0    The value for the uniform
  */
-void Shader::setUniform1i(const std::string name, GLint v0) {
+void Shader::setUniform1i(const std::string& name, GLint v0) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform1i(locale, v0);
 }
 
@@ -1577,9 +1946,9 @@ void Shader::setUniform2i(GLint pos, GLint v0, GLint v1) {
  * @param v0    The first value for the uniform
  * @param v1    The second value for the uniform
  */
-void Shader::setUniform2i(const std::string name, GLint v0, GLint v1) {
+void Shader::setUniform2i(const std::string& name, GLint v0, GLint v1) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform2i(locale, v0, v1);
 }
 
@@ -1610,9 +1979,9 @@ void Shader::setUniform3i(GLint pos, GLint v0, GLint v1, GLint v2) {
  * @param v1    The second value for the uniform
  * @param v2    The third value for the uniform
  */
-void Shader::setUniform3i(const std::string name, GLint v0, GLint v1, GLint v2) {
+void Shader::setUniform3i(const std::string& name, GLint v0, GLint v1, GLint v2) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform3i(locale, v0, v1, v2);
 }
 
@@ -1645,9 +2014,9 @@ void Shader::setUniform4i(GLint pos, GLint v0, GLint v1, GLint v2, GLint v3) {
  * @param v2    The third value for the uniform
  * @param v3    The fourth value for the uniform
  */
-void Shader::setUniform4i(const std::string name, GLint v0, GLint v1, GLint v2, GLint v3) {
+void Shader::setUniform4i(const std::string& name, GLint v0, GLint v1, GLint v2, GLint v3) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform4i(locale, v0, v1, v2, v3);
 }
 
@@ -1674,9 +2043,9 @@ void Shader::setUniform1ui(GLint pos, GLuint v0) {
  * @param name  The name of the uniform
  * @param v0    The value for the uniform
  */
-void Shader::setUniform1ui(const std::string name, GLuint v0) {
+void Shader::setUniform1ui(const std::string& name, GLuint v0) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform1ui(locale, v0);
 }
 
@@ -1705,9 +2074,9 @@ void Shader::setUniform2ui(GLint pos, GLuint v0, GLuint v1) {
  * @param v0    The first value for the uniform
  * @param v1    The second value for the uniform
  */
-void Shader::setUniform2ui(const std::string name, GLuint v0, GLuint v1) {
+void Shader::setUniform2ui(const std::string& name, GLuint v0, GLuint v1) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform2ui(locale, v0, v1);
 }
 
@@ -1738,9 +2107,9 @@ void Shader::setUniform3ui(GLint pos, GLuint v0, GLuint v1, GLuint v2) {
  * @param v1    The second value for the uniform
  * @param v2    The third value for the uniform
  */
-void Shader::setUniform3ui(const std::string name, GLuint v0, GLuint v1, GLuint v2) {
+void Shader::setUniform3ui(const std::string& name, GLuint v0, GLuint v1, GLuint v2) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform3ui(locale, v0, v1, v2);
 }
 
@@ -1773,9 +2142,9 @@ void Shader::setUniform4ui(GLint pos, GLuint v0, GLuint v1, GLuint v2, GLuint v3
  * @param v2    The third value for the uniform
  * @param v3    The fourth value for the uniform
  */
-void Shader::setUniform4ui(const std::string name, GLuint v0, GLuint v1, GLuint v2, GLuint v3) {
+void Shader::setUniform4ui(const std::string& name, GLuint v0, GLuint v1, GLuint v2, GLuint v3) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform4ui(locale, v0, v1, v2, v3);
 }
 
@@ -1804,9 +2173,9 @@ void Shader::setUniform1fv(GLint pos, GLsizei count, const GLfloat *value) {
  * @param count The number of elements in the array
  * @param value The array of floats
  */
-void Shader::setUniform1fv(const std::string name, GLsizei count, const GLfloat *value) {
+void Shader::setUniform1fv(const std::string& name, GLsizei count, const GLfloat *value) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform1fv(locale, count, value);
 }
 
@@ -1835,9 +2204,9 @@ void Shader::setUniform2fv(GLint pos, GLsizei count, const GLfloat *value) {
  * @param count The number of elements in the array
  * @param value The array of floats
  */
-void Shader::setUniform2fv(const std::string name, GLsizei count, const GLfloat *value) {
+void Shader::setUniform2fv(const std::string& name, GLsizei count, const GLfloat *value) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform2fv(locale, count, value);
 }
 
@@ -1866,9 +2235,9 @@ void Shader::setUniform3fv(GLint pos, GLsizei count, const GLfloat *value) {
  * @param count The number of elements in the array
  * @param value The array of floats
  */
-void Shader::setUniform3fv(const std::string name, GLsizei count, const GLfloat *value) {
+void Shader::setUniform3fv(const std::string& name, GLsizei count, const GLfloat *value) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform3fv(locale, count, value);
 }
 
@@ -1897,9 +2266,9 @@ void Shader::setUniform4fv(GLint pos, GLsizei count, const GLfloat *value) {
  * @param count The number of elements in the array
  * @param value The array of floats
  */
-void Shader::setUniform4fv(const std::string name, GLsizei count, const GLfloat *value) {
+void Shader::setUniform4fv(const std::string& name, GLsizei count, const GLfloat *value) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform4fv(locale, count, value);
 }
 
@@ -1928,9 +2297,9 @@ void Shader::setUniform1iv(GLint pos, GLsizei count, const GLint *value) {
  * @param count The number of elements in the array
  * @param value The array of ints
  */
-void Shader::setUniform1iv(const std::string name, GLsizei count, const GLint *value) {
+void Shader::setUniform1iv(const std::string& name, GLsizei count, const GLint *value) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform1iv(locale, count, value);
 }
 
@@ -1959,9 +2328,9 @@ void Shader::setUniform2iv(GLint pos, GLsizei count, const GLint *value) {
  * @param count The number of elements in the array
  * @param value The array of ints
  */
-void Shader::setUniform2iv(const std::string name, GLsizei count, const GLint *value) {
+void Shader::setUniform2iv(const std::string& name, GLsizei count, const GLint *value) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform2iv(locale, count, value);
 }
 
@@ -1990,9 +2359,9 @@ void Shader::setUniform3iv(GLint pos, GLsizei count, const GLint *value) {
  * @param count The number of elements in the array
  * @param value The array of ints
  */
-void Shader::setUniform3iv(const std::string name, GLsizei count, const GLint *value) {
+void Shader::setUniform3iv(const std::string& name, GLsizei count, const GLint *value) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform3iv(locale, count, value);
 }
 
@@ -2021,9 +2390,9 @@ void Shader::setUniform4iv(GLint pos, GLsizei count, const GLint *value) {
  * @param count The number of elements in the array
  * @param value The array of ints
  */
-void Shader::setUniform4iv(const std::string name, GLsizei count, const GLint *value) {
+void Shader::setUniform4iv(const std::string& name, GLsizei count, const GLint *value) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform4iv(locale, count, value);
 }
 
@@ -2052,9 +2421,9 @@ void Shader::setUniform1uiv(GLint pos, GLsizei count, const GLuint *value) {
  * @param count The number of elements in the array
  * @param value The array of unsigned ints
  */
-void Shader::setUniform1uiv(const std::string name, GLsizei count, const GLuint *value) {
+void Shader::setUniform1uiv(const std::string& name, GLsizei count, const GLuint *value) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform1uiv(locale, count, value);
 }
 
@@ -2083,9 +2452,9 @@ void Shader::setUniform2uiv(GLint pos, GLsizei count, const GLuint *value) {
  * @param count The number of elements in the array
  * @param value The array of unsigned ints
  */
-void Shader::setUniform2uiv(const std::string name, GLsizei count, const GLuint *value) {
+void Shader::setUniform2uiv(const std::string& name, GLsizei count, const GLuint *value) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform2uiv(locale, count, value);
 }
 
@@ -2114,9 +2483,9 @@ void Shader::setUniform3uiv(GLint pos, GLsizei count, const GLuint *value) {
  * @param count The number of elements in the array
  * @param value The array of unsigned ints
  */
-void Shader::setUniform3uiv(const std::string name, GLsizei count, const GLuint *value) {
+void Shader::setUniform3uiv(const std::string& name, GLsizei count, const GLuint *value) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform3uiv(locale, count, value);
 }
 
@@ -2145,9 +2514,9 @@ void Shader::setUniform4uiv(GLint pos, GLsizei count, const GLuint *value) {
  * @param count The number of elements in the array
  * @param value The array of unsigned ints
  */
-void Shader::setUniform4uiv(const std::string name, GLsizei count, const GLuint *value) {
+void Shader::setUniform4uiv(const std::string& name, GLsizei count, const GLuint *value) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniform4uiv(locale, count, value);
 }
 
@@ -2178,9 +2547,9 @@ void Shader::setUniformMatrix2fv(GLint pos, GLsizei count, const GLfloat *value,
  * @param value The array of matrices
  * @param tpose Whether to transpose the matrices
  */
-void Shader::setUniformMatrix2fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose) {
+void Shader::setUniformMatrix2fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniformMatrix2fv(locale, count, tpose, value);
 }
 
@@ -2211,9 +2580,9 @@ void Shader::setUniformMatrix3fv(GLint pos, GLsizei count, const GLfloat *value,
  * @param value The array of matrices
  * @param tpose Whether to transpose the matrices
  */
-void Shader::setUniformMatrix3fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose) {
+void Shader::setUniformMatrix3fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniformMatrix3fv(locale, count, tpose, value);
 }
 
@@ -2244,9 +2613,9 @@ void Shader::setUniformMatrix4fv(GLint pos, GLsizei count, const GLfloat *value,
  * @param value The array of matrices
  * @param tpose Whether to transpose the matrices
  */
-void Shader::setUniformMatrix4fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose) {
+void Shader::setUniformMatrix4fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniformMatrix4fv(locale, count, tpose, value);
 }
 
@@ -2277,9 +2646,9 @@ void Shader::setUniformMatrix2x3fv(GLint pos, GLsizei count, const GLfloat *valu
  * @param value The array of matrices
  * @param tpose Whether to transpose the matrices
  */
-void Shader::setUniformMatrix2x3fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose) {
+void Shader::setUniformMatrix2x3fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniformMatrix2x3fv(locale, count, tpose, value);
 }
 
@@ -2310,9 +2679,9 @@ void Shader::setUniformMatrix3x2fv(GLint pos, GLsizei count, const GLfloat *valu
  * @param value The array of matrices
  * @param tpose Whether to transpose the matrices
  */
-void Shader::setUniformMatrix3x2fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose) {
+void Shader::setUniformMatrix3x2fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniformMatrix3x2fv(locale, count, tpose, value);
 }
 
@@ -2343,9 +2712,9 @@ void Shader::setUniformMatrix2x4fv(GLint pos, GLsizei count, const GLfloat *valu
  * @param value The array of matrices
  * @param tpose Whether to transpose the matrices
  */
-void Shader::setUniformMatrix2x4fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose) {
+void Shader::setUniformMatrix2x4fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniformMatrix2x4fv(locale, count, tpose, value);
 }
 
@@ -2376,9 +2745,9 @@ void Shader::setUniformMatrix4x2fv(GLint pos, GLsizei count, const GLfloat *valu
  * @param value The array of matrices
  * @param tpose Whether to transpose the matrices
  */
-void Shader::setUniformMatrix4x2fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose) {
+void Shader::setUniformMatrix4x2fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniformMatrix4x2fv(locale, count, tpose, value);
 }
 
@@ -2409,9 +2778,9 @@ void Shader::setUniformMatrix3x4fv(GLint pos, GLsizei count, const GLfloat *valu
  * @param value The array of matrices
  * @param tpose Whether to transpose the matrices
  */
-void Shader::setUniformMatrix3x4fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose) {
+void Shader::setUniformMatrix3x4fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
 	if (locale >= 0) glUniformMatrix3x4fv(locale, count, tpose, value);
 }
 
@@ -2442,9 +2811,9 @@ void Shader::setUniformMatrix4x3fv(GLint pos, GLsizei count, const GLfloat *valu
  * @param value The array of matrices
  * @param tpose Whether to transpose the matrices
  */
-void Shader::setUniformMatrix4x3fv(const std::string name, GLsizei count, const GLfloat *value, GLboolean tpose) {
+void Shader::setUniformMatrix4x3fv(const std::string& name, GLsizei count, const GLfloat *value, GLboolean tpose) {
 	CUAssertLog(isBound(), "Shader is not active.");
-	GLint locale = getUniformLocation(name.c_str());
+	GLint locale = getUniformLocation(name);
     if (locale >= 0) glUniformMatrix4x3fv(locale, count, tpose, value);
 }
 
@@ -2478,9 +2847,9 @@ bool Shader::getUniformfv(GLint pos, GLsizei size, GLfloat *value) const {
  *
  * @return true if data was successfully read into value
  */
-bool Shader::getUniformfv(const std::string name, GLsizei size, GLfloat *value) const {
+bool Shader::getUniformfv(const std::string& name, GLsizei size, GLfloat *value) const {
     CUAssertLog(isBound(), "Shader is not active.");
-    GLint locale = getUniformLocation(name.c_str());
+    GLint locale = getUniformLocation(name);
     if (locale >= 0) {
         glGetUniformfv(_program,locale,value);
         return !(glGetError());
@@ -2518,9 +2887,9 @@ bool Shader::getUniformiv(GLint pos, GLsizei size, GLint *value) const {
  *
  * @return true if data was successfully read into value
  */
-bool Shader::getUniformiv(const std::string name, GLsizei size, GLint *value) const {
+bool Shader::getUniformiv(const std::string& name, GLsizei size, GLint *value) const {
     CUAssertLog(isBound(), "Shader is not active.");
-    GLint locale = getUniformLocation(name.c_str());
+    GLint locale = getUniformLocation(name);
     if (locale >= 0) {
         glGetUniformiv(_program,locale,value);
         return !(glGetError());
@@ -2558,9 +2927,9 @@ bool Shader::getUniformuiv(GLint pos, GLsizei size, GLuint *value) const {
  *
  * @return true if data was successfully read into value
  */
-bool Shader::getUniformuiv(const std::string name, GLsizei size, GLuint *value) const {
+bool Shader::getUniformuiv(const std::string& name, GLsizei size, GLuint *value) const {
     CUAssertLog(isBound(), "Shader is not active.");
-    GLint locale = getUniformLocation(name.c_str());
+    GLint locale = getUniformLocation(name);
     if (locale >= 0) {
         glGetUniformuiv(_program,locale,value);
         return !(glGetError());
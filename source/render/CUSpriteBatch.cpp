@@ -45,10 +45,13 @@
 //
 #include <cugl/math/cu_math.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUTimestamp.h>
+#include <cugl/util/CUProfiler.h>
 #include <cugl/render/CUSpriteBatch.h>
 #include <cugl/render/CUVertexBuffer.h>
 #include <cugl/render/CUTexture.h>
 #include <cugl/render/CUShader.h>
+#include <cugl/render/CURenderState.h>
 #include <cugl/render/CUGradient.h>
 #include <cugl/render/CUScissor.h>
 #include <cugl/render/CUFont.h>
@@ -79,6 +82,17 @@ const std::string oglShaderVert =
 #include "shaders/SpriteShader.vert"
 ;
 
+/**
+ * Instanced vertex shader
+ *
+ * This shader expands each sprite instance into a quad. It is paired with
+ * the default fragment shader. As with the other shaders, the #include
+ * statement below MUST be on its own separate line.
+ */
+const std::string oglInstanceVert =
+#include "shaders/SpriteInstance.vert"
+;
+
 using namespace cugl;
 
 
@@ -92,6 +106,12 @@ using namespace cugl;
 #define TYPE_SCISSOR    4
 /** The drawing type for a (simple) texture blur */
 #define TYPE_GAUSSBLUR  8
+/** The drawing type for a multitextured shape (texture is per vertex) */
+#define TYPE_MULTITEX   16
+/** The drawing type for a signed distance field texture */
+#define TYPE_DISTFIELD  32
+/** The drawing type for a gradient table shape (gradient is per vertex) */
+#define TYPE_GRADTABLE  64
 
 /** The drawing command has changed */
 #define DIRTY_COMMAND           0x001
@@ -117,8 +137,19 @@ using namespace cugl;
 #define DIRTY_BLURSTEP          0x400
 /** The block offset has changed */
 #define DIRTY_UNIBLOCK          0x800
+/** The hardware clip rectangle has changed */
+#define DIRTY_CLIPRECT          0x1000
 /** All values have changed */
-#define DIRTY_ALL_VALS          0xFFF
+#define DIRTY_ALL_VALS          0x1FFF
+
+/** The number of texture units in the default shader (uTextures) */
+#define SPRITE_MAX_TEXTURES     8
+/** The number of gradient rows in the default shader (uGradients) */
+#define SPRITE_MAX_GRADIENTS    32
+/** The number of floats in a gradient row (std140 layout) */
+#define SPRITE_GRADIENT_FLOATS  24
+/** The uniform buffer bind point of the gradient table */
+#define SPRITE_GRADIENT_BIND    1
 
 /**
  * Fills poly with a mesh defining the given rectangle.
@@ -158,6 +189,106 @@ static void makeRect(Poly2& poly, const Rect& rect, bool solid) {
     }
 }
 
+/**
+ * Returns the texture that owns the buffer of the given texture.
+ *
+ * Subtextures share the buffer of their parent, and so they must share a
+ * texture unit as well.
+ *
+ * @param texture   The (sub)texture
+ *
+ * @return the texture that owns the buffer of the given texture.
+ */
+static std::shared_ptr<Texture> root_texture(const std::shared_ptr<Texture>& texture) {
+    std::shared_ptr<Texture> result = texture;
+    while (result->getParent() != nullptr) {
+        result = result->getParent();
+    }
+    return result;
+}
+
+/**
+ * Transforms the positions of the given vertices in place.
+ *
+ * The positions are interleaved with the other vertex attributes, so this
+ * uses the strided (and vectorized) batch transform of {@link Affine2}.
+ *
+ * @param vertices  The vertices to transform
+ * @param size      The number of vertices
+ * @param mat       The transform to apply
+ */
+static void transform_positions(SpriteVertex2* vertices, size_t size, const Affine2& mat) {
+    static_assert(sizeof(SpriteVertex2) % sizeof(float) == 0, "Vertices must be float aligned");
+    float* data = reinterpret_cast<float*>(&(vertices->position));
+    Affine2::transform(mat, data, data, size, sizeof(SpriteVertex2)/sizeof(float));
+}
+
+/**
+ * Returns true if the perspective keeps rectangles axis-aligned on screen.
+ *
+ * This is true for any orthographic camera that is not rotated.
+ *
+ * @param mat   The perspective matrix
+ *
+ * @return true if the perspective keeps rectangles axis-aligned on screen.
+ */
+static bool is_aligned(const Mat4& mat) {
+    return (mat.m[1] == 0 && mat.m[4] == 0 && mat.m[8] == 0 && mat.m[9] == 0 &&
+            mat.m[3] == 0 && mat.m[7] == 0 && mat.m[11] == 0 && mat.m[15] != 0);
+}
+
+/**
+ * Returns true if the scissor mask is an axis-aligned rectangle.
+ *
+ * Such a mask can be applied with glScissor instead of the shader. A
+ * fringe of at most one pixel is allowed, as glScissor has a sharp edge.
+ * If this function returns true, the rectangle of the mask is stored in
+ * clip, in the coordinate system of the perspective.
+ *
+ * @param scissor   The scissor mask
+ * @param clip      The rectangle to store the mask
+ *
+ * @return true if the scissor mask is an axis-aligned rectangle.
+ */
+static bool clip_rect(const Scissor& scissor, Rect& clip) {
+    const Affine2 transform = scissor.getTransform();
+    if (transform.m[1] != 0 || transform.m[2] != 0 || scissor.getFringe() > 1) {
+        return false;
+    }
+    Rect bounds = scissor.getBounds();
+    Vec2 p0 = transform.transform(bounds.origin);
+    Vec2 p1 = transform.transform(bounds.origin+bounds.size);
+    clip.origin.set(std::min(p0.x,p1.x),std::min(p0.y,p1.y));
+    clip.size.set(std::fabs(p1.x-p0.x),std::fabs(p1.y-p0.y));
+    return true;
+}
+
+/**
+ * Applies the given clip rectangle with glScissor.
+ *
+ * The rectangle is mapped to the window by the perspective (which must be
+ * aligned) and the active viewport. Edges are rounded to the nearest pixel
+ * boundary, which keeps the same pixels as the shader (those whose centers
+ * are inside the rectangle).
+ *
+ * @param clip          The clip rectangle in the coordinate system of the perspective
+ * @param perspective   The perspective matrix
+ */
+static void apply_clip(const Rect& clip, const Mat4& perspective) {
+    GLint viewport[4];
+    renderstate::getViewport(viewport);
+    const float* m = perspective.m;
+    float x0 = (m[0]*clip.origin.x+m[12])/m[15];
+    float y0 = (m[5]*clip.origin.y+m[13])/m[15];
+    float x1 = (m[0]*(clip.origin.x+clip.size.width)+m[12])/m[15];
+    float y1 = (m[5]*(clip.origin.y+clip.size.height)+m[13])/m[15];
+    GLint left   = (GLint)std::lround(viewport[0]+(std::min(x0,x1)+1)*0.5f*viewport[2]);
+    GLint right  = (GLint)std::lround(viewport[0]+(std::max(x0,x1)+1)*0.5f*viewport[2]);
+    GLint bottom = (GLint)std::lround(viewport[1]+(std::min(y0,y1)+1)*0.5f*viewport[3]);
+    GLint top    = (GLint)std::lround(viewport[1]+(std::max(y0,y1)+1)*0.5f*viewport[3]);
+    glScissor(left, bottom, std::max(right-left,0), std::max(top-bottom,0));
+}
+
 #pragma mark -
 #pragma mark Context
 /**
@@ -193,14 +324,18 @@ public:
         blur = 0;
         type = 0;
         dirty = 0;
+        clipped = false;
     }
     
     /**
-     * Creates a copy of the given uniforms
+     * Sets this context to a copy of the given uniforms
+     *
+     * Contexts are recycled between flushes, so this method reuses the
+     * storage of this context where possible.
      *
      * @param copy  The uniforms to copy
      */
-    Context(Context* copy) {
+    void set(const Context* copy) {
         first = copy->first;
         last  = copy->last;
         type  = copy->type;
@@ -217,9 +352,25 @@ public:
         blockptr = copy->blockptr;
         zDepth = copy->zDepth;
         blur  = copy->blur;
+        textures = copy->textures;
+        clipped = copy->clipped;
+        clip = copy->clip;
         dirty = 0;
     }
     
+    /**
+     * Releases the resources of this context so that it may be recycled.
+     *
+     * The texture and perspective are released, so a recycled context does
+     * not keep them alive. Any storage for the texture units is kept.
+     */
+    void release() {
+        perspective = nullptr;
+        texture = nullptr;
+        textures.clear();
+        dirty = 0;
+    }
+
     /**
      * Disposes this collection of uniforms
      */
@@ -240,6 +391,8 @@ public:
         zDepth = 0;
         blur = 0;
         type = 0;
+        clipped = false;
+        textures.clear();
     }
     
     /**
@@ -250,6 +403,10 @@ public:
         if (texture != nullptr) {
             texture->unbind();
         }
+        for(auto it = textures.begin(); it != textures.end(); ++it) {
+            (*it)->unbind();
+        }
+        textures.clear();
         first = 0;
         last  = 0;
         command  = GL_TRIANGLES;
@@ -268,12 +425,15 @@ public:
         blur = 0;
         type = 0;
         dirty = 0;
+        clipped = false;
     }
     
     /** The first vertex index position for this set of uniforms */
     GLuint first;
     /** The last vertex index position for this set of uniforms */
     GLuint last;
+    /** The dirty bits relative to the previous set of uniforms */
+    GLuint dirty;
     /** The drawing type for the shader */
     GLint type;
     /** The stored drawing command */
@@ -296,14 +456,18 @@ public:
     std::shared_ptr<Mat4> perspective;
     /** The stored texture */
     std::shared_ptr<Texture> texture;
+    /** The texture unit assignments in multitexture mode (root textures only) */
+    std::vector<std::shared_ptr<Texture>> textures;
     /** The current depth for the z-plane */
     GLfloat zDepth;
     /** The radius for our blur function */
     GLfloat blur;
     /** The stored block offset for gradient and scissor */
     GLsizei blockptr;
-    /** The dirty bits relative to the previous set of uniforms */
-    GLuint dirty;
+    /** Whether the scissor mask is applied with glScissor */
+    bool clipped;
+    /** The hardware clip rectangle (in the coordinate system of the perspective) */
+    Rect clip;
 };
 
 #pragma mark -
@@ -321,15 +485,27 @@ _vertData(nullptr),
 _indxData(nullptr),
 _color(Color4f::WHITE),
 _context(nullptr),
+_recording(false),
+_multiMax(0),
+_texSlot(-1),
+_texMark(0),
+_gradMax(0),
+_gradSlot(-1),
+_gradMark(0),
 _vertMax(0),
 _vertSize(0),
 _indxMax(0),
 _indxSize(0),
 _vertTotal(0),
-_callTotal(0) {
+_callTotal(0),
+_stateTotal(0),
+_flushTime(0) {
     _shader = nullptr;
     _vertbuff = nullptr;
     _unifbuff = nullptr;
+    _gradbuff = nullptr;
+    _instShader = nullptr;
+    _instbuff = nullptr;
     _gradient = nullptr;
     _scissor  = nullptr;
 }
@@ -349,11 +525,22 @@ void SpriteBatch::dispose() {
     if (_context != nullptr) {
         delete _context; _context = nullptr;
     }
+    unwind();
+    for(auto it = _spares.begin(); it != _spares.end(); ++it) {
+        delete *it;
+    }
+    _spares.clear();
+    _blocks.clear();
+    _recording = false;
     _shader = nullptr;
     _vertbuff = nullptr;
     _unifbuff = nullptr;
+    _gradbuff = nullptr;
+    _instShader = nullptr;
+    _instbuff = nullptr;
     _gradient = nullptr;
     _scissor  = nullptr;
+    _gradRows.clear();
     
     _vertMax  = 0;
     _vertSize = 0;
@@ -363,6 +550,14 @@ void SpriteBatch::dispose() {
     
     _vertTotal = 0;
     _callTotal = 0;
+    _stateTotal = 0;
+    _flushTime = 0;
+    _multiMax = 0;
+    _texSlot = -1;
+    _texMark = 0;
+    _gradMax = 0;
+    _gradSlot = -1;
+    _gradMark = 0;
     
     _initialized = false;
     _inflight = false;
@@ -449,6 +644,7 @@ bool SpriteBatch::init(unsigned int capacity, const std::shared_ptr<Shader>& sha
     }
     
     _shader = shader;
+    resolveUniforms();
     
     _vertbuff = VertexBuffer::alloc(sizeof(SpriteVertex2));
     _vertbuff->setupAttribute("aPosition", 2, GL_FLOAT, GL_FALSE,
@@ -459,7 +655,17 @@ bool SpriteBatch::init(unsigned int capacity, const std::shared_ptr<Shader>& sha
                               offsetof(cugl::SpriteVertex2,texcoord));
     _vertbuff->setupAttribute("aGradCoord",2, GL_FLOAT, GL_FALSE,
                               offsetof(cugl::SpriteVertex2,gradcoord));
+    // Custom shaders need not support multitexturing
+    if (_shader->getAttributeLocation("aTexIndex") != -1) {
+        _vertbuff->setupAttribute("aTexIndex", 1, GL_FLOAT, GL_FALSE,
+                                  offsetof(cugl::SpriteVertex2,texindex));
+    }
+    if (_shader->getAttributeLocation("aGradIndex") != -1) {
+        _vertbuff->setupAttribute("aGradIndex", 1, GL_FLOAT, GL_FALSE,
+                                  offsetof(cugl::SpriteVertex2,gradindex));
+    }
     _vertbuff->attach(_shader);
+    _vertbuff->enableStreaming(capacity, capacity*3);
     
     // Set up data arrays;
     _vertMax = capacity;
@@ -483,6 +689,47 @@ bool SpriteBatch::init(unsigned int capacity, const std::shared_ptr<Shader>& sha
 
     _shader->setUniformBlock("uContext",_unifbuff);
     
+    // The gradient table is a single block of rows
+    _gradbuff = UniformBuffer::alloc(SPRITE_MAX_GRADIENTS*SPRITE_GRADIENT_FLOATS*sizeof(float));
+    _gradbuff->setBindPoint(SPRITE_GRADIENT_BIND);
+    _shader->setUniformBlock("uGradients",SPRITE_GRADIENT_BIND);
+    
+    _context = new Context();
+    _context->dirty = DIRTY_ALL_VALS;
+    return true;
+}
+
+/**
+ * Initializes a recording sprite batch with the given vertex capacity.
+ *
+ * A recorder is a sprite batch without any OpenGL resources. All drawing
+ * commands are supported (except {@link #drawInstances} and multitexture
+ * mode), but the vertices and state changes are only recorded. They are
+ * drawn when another, ordinary sprite batch calls {@link #replay} on this
+ * recording. Instead of flushing, a recorder grows as needed.
+ *
+ * As a recorder makes no OpenGL calls, it may be drawn to on any thread.
+ * This allows independent subtrees of a scene graph to generate their
+ * vertices in parallel (see {@link Scene2#renderParallel}). However, a recorder
+ * is not thread-safe itself, and should only be used by one thread at a
+ * time.
+ *
+ * @param capacity The initial vertex capacity of this recorder
+ *
+ * @return true if initialization was successful.
+ */
+bool SpriteBatch::initRecorder(unsigned int capacity) {
+    if (_initialized || _context != nullptr) {
+        CUAssertLog(false, "SpriteBatch is already initialized");
+        return false; // If asserts are turned off.
+    }
+    
+    _recording = true;
+    _vertMax = std::max(capacity,4u);
+    _vertData = new SpriteVertex2[_vertMax];
+    _indxMax = _vertMax*3;
+    _indxData = new GLuint[_indxMax];
+    
     _context = new Context();
     _context->dirty = DIRTY_ALL_VALS;
     return true;
@@ -515,11 +762,14 @@ void SpriteBatch::setColor(const Color4 color) {
  */
 void SpriteBatch::setShader(const std::shared_ptr<Shader>& shader) {
     CUAssertLog(_active, "Attempt to reassign shader while drawing is active");
+    CUAssertLog(!_recording, "A recorder does not have a shader");
     CUAssertLog(shader != nullptr, "Shader cannot be null");
     _vertbuff->detach();
     _shader = shader;
+    resolveUniforms();
     _vertbuff->attach(_shader);
     _shader->setUniformBlock("uContext", _unifbuff);
+    _shader->setUniformBlock("uGradients", SPRITE_GRADIENT_BIND);
 }
 
 
@@ -538,6 +788,15 @@ void SpriteBatch::setPerspective(const Mat4& perspective) {
         auto matrix = std::make_shared<Mat4>(perspective);
         _context->perspective = matrix;
         _context->dirty = _context->dirty | DIRTY_PERSPECTIVE;
+        
+        // A rotated camera moves the scissor back to the shader (and vice versa)
+        Rect rect;
+        if (_scissor != nullptr && !_recording &&
+            _context->clipped != (is_aligned(perspective) && clip_rect(*_scissor, rect))) {
+            std::shared_ptr<Scissor> scissor = _scissor;
+            _scissor = nullptr;
+            setScissor(scissor);
+        }
     }
 }
 
@@ -571,6 +830,35 @@ void SpriteBatch::setTexture(const std::shared_ptr<Texture>& texture) {
         return;
     }
 
+    if (_multiMax) {
+        // The texture is a vertex attribute unless we run out of units
+        stampTextures();
+        _context->texture = texture;
+        if (texture == nullptr) {
+            _texSlot = -1;
+            return;
+        }
+        std::shared_ptr<Texture> root = root_texture(texture);
+        auto& table = _context->textures;
+        if (_context->blur == 0) {
+            for(size_t ii = 0; ii < table.size(); ii++) {
+                if (table[ii] == root) {
+                    _texSlot = (GLint)ii;
+                    return;
+                }
+            }
+        }
+        if (_context->blur != 0 || table.size() >= _multiMax) {
+            if (_inflight) { record(); }
+            _context->textures.clear();
+            _context->dirty = _context->dirty | (_context->blur ? DIRTY_BLURSTEP : 0);
+        }
+        _context->textures.push_back(root);
+        _context->dirty = _context->dirty | DIRTY_TEXTURE;
+        _texSlot = (GLint)_context->textures.size()-1;
+        return;
+    }
+
     if (_inflight) { record(); }
     if (texture == nullptr) {
         // Active texture is not null
@@ -588,7 +876,7 @@ void SpriteBatch::setTexture(const std::shared_ptr<Texture>& texture) {
             _context->dirty = _context->dirty | DIRTY_TEXTURE;
         }
         _context->texture = texture;
-        if (_context->texture->getBindPoint()) {
+        if (!_recording && _context->texture->getBindPoint()) {
             _context->texture->setBindPoint(0);
         }
     }
@@ -651,7 +939,9 @@ std::shared_ptr<Gradient> SpriteBatch::getGradient() const {
  * drawing with an active gradient.
  *
  * This method acquires a copy of the gradient. Changes to the original
- * gradient after calling this method have no effect.
+ * gradient after calling this method have no effect. Changing this value
+ * will cause the sprite batch to flush, unless gradient table mode is
+ * enabled (see {@link #setGradientTable}).
  *
  * @param gradient   The active gradient for this sprite batch
  */
@@ -660,6 +950,19 @@ void SpriteBatch::setGradient(const std::shared_ptr<Gradient>& gradient) {
         return;
     }
     
+    if (_gradMax) {
+        // The gradient is a vertex attribute unless we run out of rows
+        stampGradients();
+        if (gradient == nullptr) {
+            _gradient = nullptr;
+            _gradSlot = -1;
+        } else {
+            _gradient = Gradient::allocCopy(gradient);
+            _gradSlot = acquireGradient();
+        }
+        return;
+    }
+    
     if (_inflight) { record(); }
     if (gradient == nullptr) {
         // Active gradient is not null
@@ -705,6 +1008,12 @@ std::shared_ptr<Scissor> SpriteBatch::getScissor() const {
  * If this value is nullptr, then no scissor mask is active. This value
  * is nullptr by default.
  *
+ * A scissor mask that is an axis-aligned rectangle (with a fringe of at
+ * most one pixel) under an unrotated perspective is applied with glScissor
+ * instead of the shader. Changing between two such masks does not use a
+ * uniform block, and does not break the batch at all if the rectangle is
+ * unchanged. All other masks are applied by the shader.
+ *
  * This method acquires a copy of the scissor. Changes to the original
  * scissor mask after calling this method have no effect.
  *
@@ -715,7 +1024,30 @@ void SpriteBatch::setScissor(const std::shared_ptr<Scissor>& scissor) {
         return;
     }
     
+    Rect rect;
+    if (scissor != nullptr && !_recording &&
+        is_aligned(*(_context->perspective.get())) && clip_rect(*scissor, rect)) {
+        if (_context->clipped && !(_context->type & TYPE_SCISSOR) && _context->clip == rect) {
+            _scissor = Scissor::alloc(scissor);
+            return;
+        }
+        if (_inflight) { record(); }
+        if (_context->type & TYPE_SCISSOR) {
+            _context->dirty = _context->dirty | DIRTY_DRAWTYPE;
+            _context->type = _context->type & ~TYPE_SCISSOR;
+        }
+        _context->dirty = _context->dirty | DIRTY_CLIPRECT;
+        _context->clipped = true;
+        _context->clip = rect;
+        _scissor = Scissor::alloc(scissor);
+        return;
+    }
+    
     if (_inflight) { record(); }
+    if (_context->clipped) {
+        _context->dirty = _context->dirty | DIRTY_CLIPRECT;
+        _context->clipped = false;
+    }
     if (scissor == nullptr) {
         // Active gradient is not null
         _context->dirty = _context->dirty | DIRTY_UNIBLOCK | DIRTY_DRAWTYPE;
@@ -963,6 +1295,17 @@ void SpriteBatch::setBlur(GLfloat radius) {
     } else if (_context->blur == 0){
         _context->dirty = _context->dirty | DIRTY_BLURSTEP | DIRTY_DRAWTYPE;
         _context->type = _context->type | TYPE_GAUSSBLUR;
+        if (_multiMax) {
+            // The blur only samples the first unit
+            stampTextures();
+            _context->textures.clear();
+            _texSlot = -1;
+            if (_context->texture != nullptr) {
+                _context->textures.push_back(root_texture(_context->texture));
+                _context->dirty = _context->dirty | DIRTY_TEXTURE;
+                _texSlot = 0;
+            }
+        }
     } else {
         _context->dirty = _context->dirty | DIRTY_BLURSTEP;
     }
@@ -993,6 +1336,56 @@ GLfloat SpriteBatch::getBlur() const {
     return _context->blur;
 }
 
+/**
+ * Sets whether textures are treated as signed distance fields.
+ *
+ * This sprite batch supports the distance field atlases of a {@link Font}
+ * (see {@link Font#setDistanceField}). In this mode, the alpha value of
+ * the texture is a distance to the edge of a glyph (with 0.5 on the edge),
+ * and not a coverage value. The shader converts this to an antialiased
+ * edge at any scale. So a single atlas can render its text crisply at any
+ * size.
+ *
+ * This mode only makes sense for distance field textures. The text drawing
+ * methods of this sprite batch set it automatically. This value is false
+ * by default.
+ *
+ * @param field    Whether textures are treated as signed distance fields
+ */
+void SpriteBatch::setDistanceField(bool field) {
+    if (getDistanceField() == field) {
+        return;
+    }
+    
+    if (_inflight) { record(); }
+    _context->dirty = _context->dirty | DIRTY_DRAWTYPE;
+    if (field) {
+        _context->type = _context->type | TYPE_DISTFIELD;
+    } else {
+        _context->type = _context->type & ~TYPE_DISTFIELD;
+    }
+}
+
+/**
+ * Returns true if textures are treated as signed distance fields.
+ *
+ * This sprite batch supports the distance field atlases of a {@link Font}
+ * (see {@link Font#setDistanceField}). In this mode, the alpha value of
+ * the texture is a distance to the edge of a glyph (with 0.5 on the edge),
+ * and not a coverage value. The shader converts this to an antialiased
+ * edge at any scale. So a single atlas can render its text crisply at any
+ * size.
+ *
+ * This mode only makes sense for distance field textures. The text drawing
+ * methods of this sprite batch set it automatically. This value is false
+ * by default.
+ *
+ * @return true if textures are treated as signed distance fields
+ */
+bool SpriteBatch::getDistanceField() const {
+    return (_context->type & TYPE_DISTFIELD) != 0;
+}
+
 /**
  * Sets the current stencil effect
  *
@@ -1068,6 +1461,144 @@ void SpriteBatch::clearHalfStencil(bool lower) {
     }
 }
 
+/**
+ * Sets the number of texture units to use in multitexture mode.
+ *
+ * Normally, every change of texture in a sprite batch (other than to a
+ * subtexture of the same atlas) is a state break, which requires a
+ * separate draw call. In multitexture mode, the default shader samples
+ * from several texture units at once, and each vertex records the unit
+ * of its texture. So up to this many textures can be drawn with a single
+ * draw call. Shapes are still drawn in the order submitted.
+ *
+ * A value of 0 or 1 disables multitexture mode. The value is clamped to
+ * the number of units supported by both the shader and the platform.
+ * Multitexture mode requires the default sprite batch shader (or one
+ * that has the same aTexIndex attribute and uTextures samplers). Blurred
+ * textures cannot share a draw call, so each blurred texture breaks the
+ * batch as usual. This value is 0 by default.
+ *
+ * @param units The number of texture units to use
+ */
+void SpriteBatch::setMultiTexture(Uint32 units) {
+    if (_recording) {
+        CUAssertLog(false, "A recorder does not support multitexture mode");
+        return;
+    }
+    GLint limit;
+    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &limit);
+    units = std::min(units,(Uint32)std::min(limit,SPRITE_MAX_TEXTURES));
+    if (units <= 1) {
+        units = 0;
+    }
+    if (units == _multiMax) {
+        return;
+    } else if (_multiMax && units) {
+        // Only the capacity changes
+        if (_context->textures.size() > units) {
+            if (_inflight) { record(); }
+            stampTextures();
+            _context->textures.clear();
+            _texSlot = -1;
+            _context->dirty = _context->dirty | DIRTY_TEXTURE;
+            if (_context->texture != nullptr) {
+                _context->textures.push_back(root_texture(_context->texture));
+                _texSlot = 0;
+            }
+        }
+        _multiMax = units;
+        return;
+    }
+
+    if (_inflight) { record(); }
+    stampTextures();
+    _context->textures.clear();
+    _context->dirty = _context->dirty | DIRTY_DRAWTYPE | DIRTY_TEXTURE;
+    if (_context->texture != nullptr) {
+        _context->type = _context->type | TYPE_TEXTURE;
+    } else {
+        _context->type = _context->type & ~TYPE_TEXTURE;
+    }
+    if (units) {
+        _context->type = _context->type | TYPE_MULTITEX;
+        _texSlot = -1;
+        if (_context->texture != nullptr) {
+            _context->textures.push_back(root_texture(_context->texture));
+            _texSlot = 0;
+        }
+        if (_active) {
+            bindSamplers();
+        }
+    } else {
+        _context->type = _context->type & ~TYPE_MULTITEX;
+        _texSlot = -1;
+    }
+    _multiMax = units;
+}
+
+/**
+ * Sets the number of gradient rows to use in gradient table mode.
+ *
+ * Normally, every change of gradient in a sprite batch is a state break,
+ * as the gradient is part of the uniform block. In gradient table mode,
+ * each distinct gradient is stored as a row of a shared table, and each
+ * vertex records the row of its gradient. So shapes with up to this many
+ * different gradients can be drawn with a single draw call. The rows are
+ * cached by value, and persist between flushes. When the table is full,
+ * the sprite batch flushes and starts a new table.
+ *
+ * A value of 0 or 1 disables gradient table mode. The value is clamped to
+ * the number of rows supported by the default shader. Gradient table mode
+ * requires the default sprite batch shader (or one that has the same
+ * aGradIndex attribute and uGradients uniform block). Changing this value
+ * (other than to increase it) causes the sprite batch to flush. This value
+ * is 0 by default.
+ *
+ * @param rows  The number of gradient rows to use
+ */
+void SpriteBatch::setGradientTable(Uint32 rows) {
+    if (_recording) {
+        CUAssertLog(false, "A recorder does not support gradient table mode");
+        return;
+    }
+    rows = std::min(rows,(Uint32)SPRITE_MAX_GRADIENTS);
+    if (rows <= 1) {
+        rows = 0;
+    }
+    if (rows == _gradMax) {
+        return;
+    } else if (_gradMax && rows > _gradMax) {
+        // Only the capacity changes
+        _gradMax = rows;
+        return;
+    } else if (rows && _shader->getAttributeLocation("aGradIndex") == -1) {
+        CULogError("Active shader does not support gradient tables");
+        return;
+    }
+    
+    if (_inflight) { record(); }
+    if (_gradMax) {
+        // The pending vertices may refer to any row
+        flush();
+        _gradRows.clear();
+    }
+    _gradMark = _vertSize;
+    _gradMax = rows;
+    _context->dirty = _context->dirty | DIRTY_DRAWTYPE;
+    if (rows) {
+        _context->type = _context->type | TYPE_GRADTABLE;
+        _context->type = _context->type & ~TYPE_GRADIENT;
+        _gradSlot = _gradient == nullptr ? -1 : acquireGradient();
+    } else {
+        _context->type = _context->type & ~TYPE_GRADTABLE;
+        _gradSlot = -1;
+        if (_gradient != nullptr) {
+            _context->type = _context->type | TYPE_GRADIENT;
+            _context->dirty = _context->dirty | DIRTY_UNIBLOCK;
+        }
+    }
+}
+
 #pragma mark -
 #pragma mark Rendering
 /**
@@ -1079,18 +1610,43 @@ void SpriteBatch::clearHalfStencil(bool lower) {
  * Calling this method will reset the vertex and OpenGL call counters to 0.
  */
 void SpriteBatch::begin() {
-    glDisable(GL_CULL_FACE);
-    glDepthMask(true);
-    glEnable(GL_BLEND);
+    if (_recording) {
+        // Each pass starts a new recording
+        unwind();
+        _context->texture = nullptr;
+        _context->reset();
+        _context->dirty = DIRTY_ALL_VALS;
+        _vertSize = _indxSize = 0;
+        _inflight = false;
+        _blocks.clear();
+        _gradient = nullptr;
+        _scissor  = nullptr;
+        _active = true;
+        _callTotal = 0;
+        _vertTotal = 0;
+        _stateTotal = 0;
+        _flushTime = 0;
+        return;
+    }
+    
+    renderstate::setEnabled(GL_CULL_FACE, false);
+    renderstate::depthMask(GL_TRUE);
+    renderstate::setEnabled(GL_BLEND, true);
 
     // DO NOT CLEAR.  This responsibility lies elsewhere
     _shader->bind();
     _vertbuff->bind();
     _unifbuff->bind(false);
     _unifbuff->deactivate();
+    _gradbuff->bind(false);
+    if (_multiMax) {
+        bindSamplers();
+    }
     _active = true;
     _callTotal = 0;
     _vertTotal = 0;
+    _stateTotal = 0;
+    _flushTime = 0;
 }
 
 /**
@@ -1101,12 +1657,32 @@ void SpriteBatch::begin() {
  */
 void SpriteBatch::end() {
     CUAssertLog(_active,"SpriteBatch is not active");
+    if (_recording) {
+        // Freeze the recording for replay
+        if (_context->first != _indxSize) {
+            record();
+        }
+        _vertTotal = _indxSize;
+        _active = false;
+        return;
+    }
     flush();
     _context->reset();
     _context->dirty = DIRTY_ALL_VALS;
+    if (_multiMax) {
+        _context->type = TYPE_MULTITEX;
+    }
+    if (_gradMax) {
+        _context->type = _context->type | TYPE_GRADTABLE;
+    }
+    _texSlot = -1;
+    _texMark = 0;
+    _gradSlot = -1;
+    _gradMark = 0;
 
     // Undo any active stencil effects
     cugl::stencil::applyEffect(StencilEffect::NONE);
+    renderstate::setEnabled(GL_SCISSOR_TEST, false);
     //glDisable(GL_STENCIL_TEST);
     //glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     
@@ -1128,45 +1704,86 @@ void SpriteBatch::end() {
  * restoring the OpenGL state.
  */
 void SpriteBatch::flush() {
-    if (_indxSize == 0 || _vertSize == 0) {
+    CU_PROFILE_SCOPE("SpriteBatch::flush");
+    if (_recording) {
+        // A recording is never drawn, so make room instead
+        SpriteVertex2* verts = new SpriteVertex2[2*_vertMax];
+        std::memcpy(verts,_vertData,_vertSize*sizeof(SpriteVertex2));
+        delete[] _vertData;
+        _vertData = verts;
+        _vertMax *= 2;
+        GLuint* indxs = new GLuint[2*_indxMax];
+        std::memcpy(indxs,_indxData,_indxSize*sizeof(GLuint));
+        delete[] _indxData;
+        _indxData = indxs;
+        _indxMax *= 2;
+        return;
+    } else if (_indxSize == 0 || _vertSize == 0) {
         return;
     } else if (_context->first != _indxSize) {
         record();
     }
+    Timestamp start;
+    if (_multiMax) {
+        stampTextures();
+    }
+    if (_gradMax) {
+        // Only the rows added since the last flush are sent
+        stampGradients();
+        _gradbuff->activate();
+        _gradbuff->flush();
+        _gradbuff->deactivate();
+    }
     
-    // Load all the vertex data at once
-    _vertbuff->loadVertexData(_vertData, _vertSize);
-    _vertbuff->loadIndexData(_indxData, _indxSize);
+    // Load all the vertex data at once (into the next streaming region)
+    _vertbuff->streamData(_vertData, _vertSize, _indxData, _indxSize);
     _unifbuff->activate();
     _unifbuff->flush();
     
     // Chunk the uniforms
     std::shared_ptr<Texture> previous = _context->texture;
+    bool multi = false;
     for(auto it = _history.begin(); it != _history.end(); ++it) {
         Context* next = *it;
+        if (next->dirty) {
+            _stateTotal++;
+        }
         if (next->dirty & DIRTY_BLENDEQUATION) {
-            glBlendEquation(next->blendEq);
+            renderstate::blendEquation(next->blendEq);
         }
         if (next->dirty & DIRTY_SRC_FUNCTION || next->dirty & DIRTY_DST_FUNCTION) {
-            if (next->srcRGB != next->srcAlpha || next->dstRGB != next->dstAlpha ) {
-                glBlendFuncSeparate(next->srcRGB, next->srcAlpha, next->dstRGB, next->dstAlpha);
-            } else {
-                glBlendFunc(next->srcRGB, next->dstRGB);
-            }
+            renderstate::blendFunc(next->srcRGB, next->dstRGB, next->srcAlpha, next->dstAlpha);
         }
         if (next->dirty & DIRTY_DEPTHVALUE) {
-            _shader->setUniform1f("uDepth", 0);
+            _shader->setUniform(_uDepth, 0.0f);
         }
         if (next->dirty & DIRTY_DRAWTYPE) {
-             _shader->setUniform1i("uType", next->type);
+            _shader->setUniform(_uType, (GLint)next->type);
         }
         if (next->dirty & DIRTY_PERSPECTIVE) {
-            _shader->setUniformMat4("uPerspective",*(next->perspective.get()));
+            _shader->setUniform(_uPerspective, *(next->perspective.get()));
+        }
+        if (next->dirty & DIRTY_CLIPRECT || (next->clipped && next->dirty & DIRTY_PERSPECTIVE)) {
+            renderstate::setEnabled(GL_SCISSOR_TEST, next->clipped);
+            if (next->clipped) {
+                apply_clip(next->clip, *(next->perspective.get()));
+            }
         }
         if (next->dirty & DIRTY_TEXTURE) {
-            previous = next->texture;
-            if (previous != nullptr) {
-                previous->bind();
+            if (next->type & TYPE_MULTITEX) {
+                multi = true;
+                for(GLuint ii = 0; ii < next->textures.size(); ii++) {
+                    auto& unit = next->textures[ii];
+                    if (unit->getBindPoint() != ii) {
+                        unit->setBindPoint(ii);
+                    }
+                    unit->bind();
+                }
+            } else {
+                previous = next->texture;
+                if (previous != nullptr) {
+                    previous->bind();
+                }
             }
         }
         if (next->dirty & DIRTY_UNIBLOCK) {
@@ -1189,16 +1806,144 @@ void SpriteBatch::flush() {
     
     _unifbuff->deactivate();
     
+    if (multi) {
+        // Other clients expect textures on the first unit
+        for(auto it = _history.begin(); it != _history.end(); ++it) {
+            for(auto jt = (*it)->textures.begin(); jt != (*it)->textures.end(); ++jt) {
+                if ((*jt)->getBindPoint()) {
+                    (*jt)->setBindPoint(0);
+                }
+            }
+        }
+        renderstate::activeTexture(GL_TEXTURE0);
+        _context->dirty = _context->dirty | DIRTY_TEXTURE;
+    }
+    
     // Increment the counters
     _vertTotal += _indxSize;
+    _flushTime += Timestamp::ellapsedMicros(start,Timestamp());
     
     _vertSize = _indxSize = 0;
+    _texMark = 0;
+    _gradMark = 0;
     unwind();
     _context->first = 0;
     _context->last  = 0;
     _context->blockptr = -1;
 }
 
+/**
+ * Draws the contents of the given recording with this sprite batch.
+ *
+ * The recording must be a recorder (see {@link #initRecorder}) that has
+ * completed its drawing pass with {@link #end}. Its vertices are appended
+ * to this sprite batch as is, with the recorded texture, gradient, scissor,
+ * blending, depth, blur, and stencil settings. The vertices were tinted
+ * and transformed when they were recorded, so the active color has no
+ * effect. The recorded perspective is ignored, as the recording is drawn
+ * with the perspective of this sprite batch.
+ *
+ * This sprite batch must be active, and this method must be called on
+ * the render thread. Recordings are drawn in the order that they are
+ * replayed, so replaying several recordings in a fixed order produces
+ * the same image independent of the order in which they were recorded.
+ * The state of this sprite batch is restored afterwards, and the recording
+ * is unchanged, so a recording may be replayed more than once.
+ *
+ * @param recording The recording to draw
+ */
+void SpriteBatch::replay(const std::shared_ptr<SpriteBatch>& recording) {
+    CUAssertLog(_active, "SpriteBatch is not active");
+    CUAssertLog(!_recording, "A recorder cannot replay a recording");
+    CUAssertLog(recording != nullptr && recording->_recording, "SpriteBatch is not a recorder");
+    CUAssertLog(!recording->_active, "Recording is still active");
+    if (recording->_history.empty()) {
+        return;
+    }
+    
+    // Save the state to restore
+    std::shared_ptr<Texture>  texture  = _context->texture;
+    std::shared_ptr<Gradient> gradient = _gradient;
+    std::shared_ptr<Scissor>  scissor  = _scissor;
+    GLenum command  = _context->command;
+    GLenum blendEq  = _context->blendEq;
+    GLenum srcRGB   = _context->srcRGB;
+    GLenum srcAlpha = _context->srcAlpha;
+    GLenum dstRGB   = _context->dstRGB;
+    GLenum dstAlpha = _context->dstAlpha;
+    GLfloat depth   = _context->zDepth;
+    GLfloat blur    = _context->blur;
+    bool field      = getDistanceField();
+    StencilEffect stencil = _context->stencil;
+    
+    // Gradients and scissors are copied on assignment, so only copy changes
+    const Gradient* lastgrad = _gradient.get();
+    const Scissor*  lastscis = _scissor.get();
+    const std::shared_ptr<Scissor>  noscis;
+    const std::shared_ptr<Gradient> nograd;
+    for(auto it = recording->_history.begin(); it != recording->_history.end(); ++it) {
+        const Context* next = *it;
+        if (next->first == next->last) {
+            continue;
+        }
+        
+        setCommand(next->command);
+        setBlendEquation(next->blendEq);
+        setSrcBlendFunc(next->srcRGB, next->srcAlpha);
+        setDstBlendFunc(next->dstRGB, next->dstAlpha);
+        setDepth(next->zDepth);
+        setStencilEffect(next->stencil);
+        setTexture(next->texture);
+        setBlur(next->blur);
+        setDistanceField((next->type & TYPE_DISTFIELD) != 0);
+        if ((next->cleared & STENCIL_BOTH) == STENCIL_BOTH) {
+            clearStencil();
+        } else if (next->cleared & STENCIL_LOWER) {
+            clearHalfStencil(true);
+        } else if (next->cleared & STENCIL_UPPER) {
+            clearHalfStencil(false);
+        }
+        
+        const std::shared_ptr<Scissor>*  scis = &noscis;
+        const std::shared_ptr<Gradient>* grad = &nograd;
+        if (next->blockptr >= 0 && (size_t)next->blockptr < recording->_blocks.size()) {
+            auto& block = recording->_blocks[next->blockptr];
+            if (next->type & TYPE_SCISSOR) {
+                scis = &block.first;
+            }
+            if (next->type & TYPE_GRADIENT) {
+                grad = &block.second;
+            }
+        }
+        if (scis->get() != lastscis) {
+            setScissor(*scis);
+            lastscis = scis->get();
+        }
+        if (grad->get() != lastgrad) {
+            setGradient(*grad);
+            lastgrad = grad->get();
+        }
+        
+        splice(recording.get(), next->first, next->last);
+    }
+    
+    setCommand(command);
+    setBlendEquation(blendEq);
+    setSrcBlendFunc(srcRGB, srcAlpha);
+    setDstBlendFunc(dstRGB, dstAlpha);
+    setDepth(depth);
+    setStencilEffect(stencil);
+    setTexture(texture);
+    setBlur(blur);
+    setDistanceField(field);
+    if (scissor.get() != lastscis) {
+        setScissor(scissor);
+    }
+    if (gradient.get() != lastgrad) {
+        setGradient(gradient);
+    }
+}
+
 
 #pragma mark -
 #pragma mark Solid Shapes
@@ -2429,6 +3174,78 @@ void SpriteBatch::drawMesh(const SpriteVertex2* vertices, size_t size, const Aff
     }
 }
 
+#pragma mark -
+#pragma mark Instanced Drawing
+/**
+ * Draws the given sprite instances with the given texture.
+ *
+ * Each instance is a quad, described by its center, size, angle, color
+ * and texture coordinates (see {@link SpriteInstance}). Instances are
+ * uploaded as is, and expanded into quads by the shader, so this is much
+ * faster than drawing the same quads one at a time. It is ideal for
+ * particles, bullets, and other large groups of identical sprites.
+ *
+ * Instances are drawn immediately, after anything batched so far, so the
+ * drawing order is preserved. They use the current perspective, blending
+ * and stencil effect. However, they use their own colors (which are not
+ * tinted by the active color) and ignore any gradient, scissor mask or
+ * blur. If texture is nullptr, the quads are drawn with solid colors.
+ *
+ * Instancing requires the default sprite batch fragment shader.
+ *
+ * @param texture   The texture to draw on each instance
+ * @param instances The instances to draw
+ * @param count     The number of instances
+ */
+void SpriteBatch::drawInstances(const std::shared_ptr<Texture>& texture,
+                                const SpriteInstance* instances, size_t count) {
+    CUAssertLog(_active, "SpriteBatch is not active");
+    if (_recording) {
+        CUAssertLog(false, "A recorder does not support instancing");
+        return;
+    }
+    if (count == 0) {
+        return;
+    }
+    flush();
+    if (_instbuff == nullptr && !initInstancing()) {
+        return;
+    }
+
+    // Apply the current context to the instance pipeline
+    _instbuff->bind();
+    renderstate::blendEquation(_context->blendEq);
+    renderstate::blendFunc(_context->srcRGB, _context->dstRGB, _context->srcAlpha, _context->dstAlpha);
+    if (_context->dirty & DIRTY_STENCIL_CLEAR) {
+        cugl::stencil::clearBuffer(_context->cleared);
+        _context->cleared = STENCIL_NONE;
+        _context->dirty = _context->dirty & ~DIRTY_STENCIL_CLEAR;
+    }
+    cugl::stencil::applyEffect(_context->stencil);
+    renderstate::setEnabled(GL_SCISSOR_TEST, _context->clipped);
+    if (_context->clipped) {
+        apply_clip(_context->clip, *(_context->perspective.get()));
+    }
+    _instShader->setUniformMat4("uPerspective",*(_context->perspective.get()));
+    _instShader->setUniform1i("uType", texture == nullptr ? 0 : TYPE_TEXTURE);
+    if (texture != nullptr) {
+        if (texture->getBindPoint()) {
+            texture->setBindPoint(0);
+        }
+        texture->bind();
+    }
+
+    _instbuff->loadVertexData(instances, (GLsizei)count);
+    _instbuff->drawInstanced(GL_TRIANGLES, 6, (GLsizei)count);
+    _callTotal++;
+    _stateTotal++;
+    _vertTotal += 6*(unsigned int)count;
+
+    // Restore the batch (the texture unit may have changed)
+    _vertbuff->bind();
+    _context->dirty = _context->dirty | DIRTY_TEXTURE;
+}
+
 #pragma mark -
 #pragma mark Text Drawing
 /**
@@ -2452,10 +3269,13 @@ void SpriteBatch::drawMesh(const SpriteVertex2* vertices, size_t size, const Aff
 void SpriteBatch::drawText(const std::string text, const std::shared_ptr<Font>& font, const Vec2 position) {
     std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
     font->getGlyphs(runs, text, position);
+    bool field = getDistanceField();
+    setDistanceField(font->hasDistanceField());
     for(auto it = runs.begin(); it != runs.end(); ++it) {
         setTexture(it->second->texture);
         drawMesh(it->second->mesh,Vec2::ZERO);
     }
+    setDistanceField(field);
 }
 
 /**
@@ -2480,10 +3300,13 @@ void SpriteBatch::drawText(const std::string text, const std::shared_ptr<Font>&
 void SpriteBatch::drawText(const std::string text, const std::shared_ptr<Font>& font, const Vec2 origin, const Affine2& transform) {
     std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
     font->getGlyphs(runs, text, -origin);
+    bool field = getDistanceField();
+    setDistanceField(font->hasDistanceField());
     for(auto it = runs.begin(); it != runs.end(); ++it) {
         setTexture(it->second->texture);
         drawMesh(it->second->mesh,transform);
     }
+    setDistanceField(field);
 }
 
 /**
@@ -2507,10 +3330,13 @@ void SpriteBatch::drawText(const std::string text, const std::shared_ptr<Font>&
 void SpriteBatch::drawText(const std::shared_ptr<TextLayout>& text, const Vec2 position) {
     std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
     text->getGlyphs(runs);
+    bool field = getDistanceField();
+    setDistanceField(text->getFont() != nullptr && text->getFont()->hasDistanceField());
     for(auto it = runs.begin(); it != runs.end(); ++it) {
         setTexture(it->second->texture);
         drawMesh(it->second->mesh,position);
     }
+    setDistanceField(field);
 }
 
 /**
@@ -2533,10 +3359,13 @@ void SpriteBatch::drawText(const std::shared_ptr<TextLayout>& text, const Vec2 p
 void SpriteBatch::drawText(const std::shared_ptr<TextLayout>& text, const Affine2& transform) {
     std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
     text->getGlyphs(runs);
+    bool field = getDistanceField();
+    setDistanceField(text->getFont() != nullptr && text->getFont()->hasDistanceField());
     for(auto it = runs.begin(); it != runs.end(); ++it) {
         setTexture(it->second->texture);
         drawMesh(it->second->mesh,transform);
     }
+    setDistanceField(field);
 }
 
 #pragma mark -
@@ -2549,7 +3378,14 @@ void SpriteBatch::drawText(const std::shared_ptr<TextLayout>& text, const Affine
  * will use the correct set of uniforms.
  */
 void SpriteBatch::record() {
-    Context* next = new Context(_context);
+    Context* next;
+    if (_spares.empty()) {
+        next = new Context();
+    } else {
+        next = _spares.back();
+        _spares.pop_back();
+    }
+    next->set(_context);
     _context->last = _indxSize;
     next->first = _indxSize;
     _history.push_back(_context);
@@ -2558,17 +3394,214 @@ void SpriteBatch::record() {
 }
 
 /**
- * Deletes the recorded uniforms.
+ * Recycles the recorded uniforms.
  *
- * This method is called upon flushing or cleanup.
+ * This method is called upon flushing or cleanup. The contexts are kept for
+ * reuse by {@link #record}, so that a state change does not allocate once
+ * the sprite batch has warmed up.
  */
 void SpriteBatch::unwind() {
     for(auto it = _history.begin(); it != _history.end(); ++it) {
-        delete *it;
+        (*it)->release();
+        _spares.push_back(*it);
     }
     _history.clear();
 }
 
+/**
+ * Appends the given range of recorded indices to this sprite batch.
+ *
+ * The indices are taken from the recording, along with the vertices that
+ * they reference. The range is split if it is too large for the capacity
+ * of this sprite batch.
+ *
+ * @param recording The recording with the vertices
+ * @param first     The first index to append
+ * @param last      The index after the last one to append
+ */
+void SpriteBatch::splice(const SpriteBatch* recording, GLuint first, GLuint last) {
+    const SpriteVertex2* vertices = recording->_vertData;
+    const GLuint* indices = recording->_indxData;
+    
+    // Never split a primitive between two flushes
+    GLuint prim = _context->command == GL_TRIANGLES ? 3 : (_context->command == GL_LINES ? 2 : 1);
+    GLuint limit = std::min(_vertMax,_indxMax);
+    limit -= limit % prim;
+    
+    GLuint pos = first;
+    while (pos < last) {
+        GLuint amt = std::min(last-pos,limit);
+        GLuint vmin = indices[pos];
+        GLuint vmax = vmin;
+        for(GLuint ii = pos+1; ii < pos+amt; ii++) {
+            vmin = std::min(vmin,indices[ii]);
+            vmax = std::max(vmax,indices[ii]);
+        }
+        
+        GLuint span = vmax-vmin+1;
+        if (span <= _vertMax) {
+            // Copy the vertex range with the indices shifted
+            if (_vertSize+span > _vertMax || _indxSize+amt > _indxMax) {
+                flush();
+            }
+            setUniformBlock(_context);
+            std::memcpy(_vertData+_vertSize, vertices+vmin, span*sizeof(SpriteVertex2));
+            for(GLuint ii = 0; ii < amt; ii++) {
+                _indxData[_indxSize+ii] = indices[pos+ii]-vmin+_vertSize;
+            }
+            _vertSize += span;
+        } else {
+            // The vertices are too spread out, so copy them once per index
+            if (_vertSize+amt > _vertMax || _indxSize+amt > _indxMax) {
+                flush();
+            }
+            setUniformBlock(_context);
+            for(GLuint ii = 0; ii < amt; ii++) {
+                _vertData[_vertSize+ii] = vertices[indices[pos+ii]];
+                _indxData[_indxSize+ii] = _vertSize+ii;
+            }
+            _vertSize += amt;
+        }
+        _indxSize += amt;
+        _inflight = true;
+        pos += amt;
+    }
+}
+
+/**
+ * Assigns the current texture slot to the vertices added since the last stamp.
+ *
+ * This method is only used in multitexture mode. It must be called before
+ * the texture slot changes, and before the vertices are flushed.
+ */
+void SpriteBatch::stampTextures() {
+    GLfloat slot = (GLfloat)_texSlot;
+    for(unsigned int ii = _texMark; ii < _vertSize; ii++) {
+        _vertData[ii].texindex = slot;
+    }
+    _texMark = _vertSize;
+}
+
+/**
+ * Assigns the current gradient row to the vertices added since the last stamp.
+ *
+ * This method is only used in gradient table mode. It must be called before
+ * the gradient row changes, and before the vertices are flushed.
+ */
+void SpriteBatch::stampGradients() {
+    GLfloat slot = (GLfloat)_gradSlot;
+    for(unsigned int ii = _gradMark; ii < _vertSize; ii++) {
+        _vertData[ii].gradindex = slot;
+    }
+    _gradMark = _vertSize;
+}
+
+/**
+ * Returns the gradient table row for the active gradient.
+ *
+ * This method is only used in gradient table mode. If the active gradient
+ * matches an existing row, that row is returned. Otherwise, the gradient
+ * is added as a new row. If the table is full, this method flushes the
+ * sprite batch and starts a new table.
+ *
+ * @return the gradient table row for the active gradient.
+ */
+GLint SpriteBatch::acquireGradient() {
+    GLfloat data[SPRITE_GRADIENT_FLOATS];
+    _gradient->getData(data);
+    
+    GLuint rows = (GLuint)(_gradRows.size()/SPRITE_GRADIENT_FLOATS);
+    for(GLuint ii = 0; ii < rows; ii++) {
+        if (!std::memcmp(data, _gradRows.data()+ii*SPRITE_GRADIENT_FLOATS, sizeof(data))) {
+            return (GLint)ii;
+        }
+    }
+    if (rows >= _gradMax) {
+        // The pending vertices may refer to any row
+        flush();
+        _gradRows.clear();
+        rows = 0;
+    }
+    _gradRows.insert(_gradRows.end(), data, data+SPRITE_GRADIENT_FLOATS);
+    _gradbuff->setUniformfv(0, (GLsizei)(rows*SPRITE_GRADIENT_FLOATS*sizeof(GLfloat)),
+                            SPRITE_GRADIENT_FLOATS, data);
+    return (GLint)rows;
+}
+
+/**
+ * Creates the shader and vertex buffer for instanced sprites.
+ *
+ * This method is called on the first call to {@link #drawInstances}.
+ *
+ * @return true if instancing is supported
+ */
+bool SpriteBatch::initInstancing() {
+    _instShader = Shader::alloc(SHADER(oglInstanceVert),SHADER(oglShaderFrag));
+    if (_instShader == nullptr) {
+        CULogError("Could not create the instanced sprite shader");
+        return false;
+    }
+
+    // Every attribute advances once per instance
+    _instbuff = VertexBuffer::alloc(sizeof(SpriteInstance));
+    _instbuff->setupAttribute("aPosition", 2, GL_FLOAT, GL_FALSE,
+                              offsetof(cugl::SpriteInstance,position));
+    _instbuff->setupAttribute("aSize",     2, GL_FLOAT, GL_FALSE,
+                              offsetof(cugl::SpriteInstance,size));
+    _instbuff->setupAttribute("aAngle",    1, GL_FLOAT, GL_FALSE,
+                              offsetof(cugl::SpriteInstance,angle));
+    _instbuff->setupAttribute("aColor",    4, GL_UNSIGNED_BYTE, GL_TRUE,
+                              offsetof(cugl::SpriteInstance,color));
+    _instbuff->setupAttribute("aTexMin",   2, GL_FLOAT, GL_FALSE,
+                              offsetof(cugl::SpriteInstance,texmin));
+    _instbuff->setupAttribute("aTexMax",   2, GL_FLOAT, GL_FALSE,
+                              offsetof(cugl::SpriteInstance,texmax));
+    _instbuff->setAttributeDivisor("aPosition", 1);
+    _instbuff->setAttributeDivisor("aSize",  1);
+    _instbuff->setAttributeDivisor("aAngle", 1);
+    _instbuff->setAttributeDivisor("aColor", 1);
+    _instbuff->setAttributeDivisor("aTexMin", 1);
+    _instbuff->setAttributeDivisor("aTexMax", 1);
+    _instbuff->attach(_instShader);
+    _instShader->setUniformBlock("uContext",_unifbuff);
+
+    // The corners of the quad are the vertex ids
+    GLuint quad[6] = { 0, 1, 2, 0, 2, 3 };
+    _instbuff->loadIndexData(quad, 6, GL_STATIC_DRAW);
+    return true;
+}
+
+/**
+ * Assigns the sampler uniforms of the texture units in multitexture mode.
+ *
+ * The shader must be bound.
+ */
+void SpriteBatch::bindSamplers() {
+    if (!_uTextures.isValid()) {
+        CULogError("Active shader does not support multitexturing");
+        return;
+    }
+    GLint units[SPRITE_MAX_TEXTURES];
+    for(GLint ii = 0; ii < SPRITE_MAX_TEXTURES; ii++) {
+        units[ii] = ii;
+    }
+    _shader->setUniform1iv(_uTextures.location, SPRITE_MAX_TEXTURES, units);
+}
+
+/**
+ * Resolves the uniform handles of the active shader.
+ *
+ * This is called whenever the shader changes, so that flushing the
+ * vertices does no uniform lookups.
+ */
+void SpriteBatch::resolveUniforms() {
+    _uDepth = _shader->getUniformHandle<GLfloat>("uDepth");
+    _uType  = _shader->getUniformHandle<GLint>("uType");
+    _uPerspective = _shader->getUniformHandle<Mat4>("uPerspective");
+    _uBlur  = _shader->getUniformHandle<Vec2>("uBlur");
+    _uTextures = _shader->getUniformHandle<GLint>("uTextures");
+}
+
 /**
  * Sets the active uniform block to agree with the gradient and stroke.
  *
@@ -2579,6 +3612,12 @@ void SpriteBatch::unwind() {
 void SpriteBatch::setUniformBlock(Context* context) {
     if (!(_context->dirty & DIRTY_UNIBLOCK)) {
         return;
+    } else if (_recording) {
+        // The block is built when the recording is replayed
+        _context->blockptr++;
+        _blocks.resize(_context->blockptr+1);
+        _blocks[_context->blockptr] = std::make_pair(_scissor,_gradient);
+        return;
     }
     if (_context->blockptr+1 >= _unifbuff->getBlockCount()) {
         flush();
@@ -2612,13 +3651,13 @@ void SpriteBatch::setUniformBlock(Context* context) {
  */
 void SpriteBatch::blurTexture(const std::shared_ptr<Texture>& texture, GLfloat step) {
     if (texture == nullptr) {
-        _shader->setUniform2f("uBlur", 0, 0);
+        _shader->setUniform(_uBlur, Vec2::ZERO);
         return;
     }
     Size size = texture->getSize();
     size.width  = step/size.width;
     size.height = step/size.height;
-    _shader->setUniform2f("uBlur",size.width,size.height);
+    _shader->setUniform(_uBlur, Vec2(size.width,size.height));
 }
 
 /**
@@ -2733,7 +3772,7 @@ unsigned int SpriteBatch::prepare(const Rect rect, const Affine2& mat) {
     GLuint clr = _color.getPacked();
     for(auto it = poly.vertices.begin(); it != poly.vertices.end(); ++it) {
         Vec2 point = *it;
-        _vertData[vstart+ii].position = point*mat;
+        _vertData[vstart+ii].position = point;
         point.x = (point.x-rect.origin.x)/rect.size.width;
         point.y = 1-(point.y-rect.origin.y)/rect.size.height;
         _vertData[vstart+ii].texcoord.x = point.x*tsmax+(1-point.x)*tsmin;
@@ -2744,6 +3783,7 @@ unsigned int SpriteBatch::prepare(const Rect rect, const Affine2& mat) {
 
         ii++;
     }
+    transform_positions(_vertData+vstart, ii, mat);
     
     int jj = 0;
     unsigned int istart = _indxSize;
@@ -2970,7 +4010,7 @@ unsigned int SpriteBatch::prepare(const Poly2& poly, const Affine2& mat) {
     GLuint clr = _color.getPacked();
     for(auto it = poly.vertices.begin(); it != poly.vertices.end(); ++it) {
         Vec2 point = *it;
-        _vertData[vstart+ii].position = point*mat;
+        _vertData[vstart+ii].position = point;
         point.x /= twidth;
         point.y = 1-point.y/theight;
         _vertData[vstart+ii].texcoord.x = point.x*tsmax+(1-point.x)*tsmin;
@@ -2980,6 +4020,7 @@ unsigned int SpriteBatch::prepare(const Poly2& poly, const Affine2& mat) {
         _vertData[vstart+ii].color = clr;
         ii++;
     }
+    transform_positions(_vertData+vstart, ii, mat);
     
     int jj = 0;
     unsigned int istart = _indxSize;
@@ -3103,7 +4144,6 @@ unsigned int SpriteBatch::prepare(const Mesh<SpriteVertex2>& mesh, const Affine2
     tint = tint && _color != Color4::WHITE;
     for(auto it = mesh.vertices.begin(); it != mesh.vertices.end(); ++it) {
         _vertData[_vertSize+ii] = *it;
-        _vertData[_vertSize+ii].position = it->position*mat;
         if (tint) {
             Uint32 c = marshall(_vertData[_vertSize+ii].color);
             Uint32 r = round(_color.r*((c >> 24)/255.0f));
@@ -3114,6 +4154,7 @@ unsigned int SpriteBatch::prepare(const Mesh<SpriteVertex2>& mesh, const Affine2
         }
         ii++;
     }
+    transform_positions(_vertData+_vertSize, ii, mat);
     
     int jj = 0;
     for(auto it = mesh.indices.begin(); it != mesh.indices.end(); ++it) {
@@ -3213,7 +4254,6 @@ unsigned int SpriteBatch::prepare(const SpriteVertex2* vertices, size_t size, co
     tint = tint && _color != Color4::WHITE;
     for(size_t kk = 0; kk < size; kk++) {
         _vertData[_vertSize+ii] = vertices[kk];
-        _vertData[_vertSize+ii].position = vertices[kk].position*mat;
         if (tint) {
             Uint32 c = marshall(_vertData[_vertSize+ii].color);
             Uint32 r = round(_color.r*((c >> 24)/255.0f));
@@ -3224,6 +4264,7 @@ unsigned int SpriteBatch::prepare(const SpriteVertex2* vertices, size_t size, co
         }
         ii++;
     }
+    transform_positions(_vertData+_vertSize, ii, mat);
     
     int jj = 0;
     for(Uint32 kk = 2; kk < size; kk++) {
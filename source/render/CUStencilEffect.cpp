@@ -31,6 +31,7 @@
 //  Version: 12/29/22
 //
 #include <cugl/render/CUStencilEffect.h>
+#include <cugl/render/CURenderState.h>
 
 using namespace cugl;
 /**
@@ -43,17 +44,17 @@ void cugl::stencil::clearBuffer(GLenum buffer) {
         case STENCIL_NONE:
             return;
         case STENCIL_LOWER:
-            glStencilMask(0xf0);
+            renderstate::stencilMask(0xf0);
             glClear(GL_STENCIL_BUFFER_BIT);
-            glStencilMask(0xff);
+            renderstate::stencilMask(0xff);
             return;
         case STENCIL_UPPER:
-            glStencilMask(0x0f);
+            renderstate::stencilMask(0x0f);
             glClear(GL_STENCIL_BUFFER_BIT);
-            glStencilMask(0xff);
+            renderstate::stencilMask(0xff);
             return;
         case STENCIL_BOTH:
-            glStencilMask(0xff);
+            renderstate::stencilMask(0xff);
             glClear(GL_STENCIL_BUFFER_BIT);
             return;
     }
@@ -71,343 +72,343 @@ void cugl::stencil::applyEffect(StencilEffect effect) {
             // Nothing more to do
             break;
         case StencilEffect::NONE:
-            glDisable(GL_STENCIL_TEST);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, false);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::CLIP:
         case StencilEffect::CLIP_JOIN:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_NOTEQUAL, 0x00, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0x00, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::MASK:
         case StencilEffect::MASK_JOIN:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_EQUAL, 0x00, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::FILL:
         case StencilEffect::FILL_JOIN:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_NOTEQUAL, 0x00, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0x00, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::WIPE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_ALWAYS, 0x00, 0xff);
-            glStencilOp(GL_ZERO, GL_ZERO, GL_ZERO);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_ALWAYS, 0x00, 0xff);
+            renderstate::stencilOp(GL_ZERO, GL_ZERO, GL_ZERO);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::STAMP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_ALWAYS, 0x00, 0xff);
-            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
-            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_DECR_WRAP);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_ALWAYS, 0x00, 0xff);
+            renderstate::stencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
+            renderstate::stencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_DECR_WRAP);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::CARVE:
         case StencilEffect::CARVE_NONE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_EQUAL, 0x00, 0xf0);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0xf0);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::CLAMP:
         case StencilEffect::CLAMP_NONE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_EQUAL, 0x00, 0xf0);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0xf0);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::NONE_CLIP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_NOTEQUAL, 0x00, 0x0f);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0x00, 0x0f);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::NONE_MASK:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_EQUAL, 0x00, 0x0f);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0x0f);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::NONE_FILL:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_NOTEQUAL, 0x00, 0x0f);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0x00, 0x0f);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::NONE_WIPE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_ALWAYS, 0x00, 0x0f);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_ALWAYS, 0x00, 0x0f);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::NONE_STAMP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_ALWAYS, 0x00, 0x0f);
-            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
-            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_ALWAYS, 0x00, 0x0f);
+            renderstate::stencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::stencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::NONE_CARVE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_EQUAL, 0x00, 0x0f);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0x0f);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::NONE_CLAMP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_EQUAL, 0x00, 0x0f);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0x0f);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::CLIP_NONE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_NOTEQUAL, 0x00, 0xf0);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0x00, 0xf0);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::CLIP_MEET:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_EQUAL, 0xff, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_EQUAL, 0xff, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::CLIP_MASK:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_EQUAL, 0xf0, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_EQUAL, 0xf0, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::CLIP_FILL:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_NOTEQUAL, 0x00, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0x00, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::CLIP_WIPE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_NOTEQUAL, 0x00, 0xf0);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0x00, 0xf0);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::CLIP_STAMP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_NOTEQUAL, 0x00, 0xf0);
-            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
-            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0x00, 0xf0);
+            renderstate::stencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::stencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::CLIP_CARVE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_EQUAL, 0xf0, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_EQUAL, 0xf0, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::CLIP_CLAMP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_EQUAL, 0xf0, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_EQUAL, 0xf0, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::MASK_NONE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_EQUAL, 0x00, 0xf0);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0xf0);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::MASK_MEET:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_NOTEQUAL, 0xff, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0xff, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::MASK_CLIP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_EQUAL, 0x0f, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_EQUAL, 0x0f, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::MASK_FILL:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_EQUAL, 0x0f, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_EQUAL, 0x0f, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::MASK_WIPE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_EQUAL, 0x00, 0xf0);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0xf0);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::MASK_STAMP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_EQUAL, 0x00, 0xf0);
-            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
-            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0xf0);
+            renderstate::stencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::stencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::MASK_CARVE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_EQUAL, 0x0, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_EQUAL, 0x0, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::MASK_CLAMP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0x0f);
-            glStencilFunc(GL_EQUAL, 0x00, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0x0f);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::FILL_NONE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_NOTEQUAL, 0x00, 0xf0);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0x00, 0xf0);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::FILL_MEET:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_EQUAL, 0xff, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_EQUAL, 0xff, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::FILL_CLIP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_EQUAL, 0xff, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_EQUAL, 0xff, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::FILL_MASK:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_EQUAL, 0xf0, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_EQUAL, 0xf0, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::WIPE_NONE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_ALWAYS, 0x00, 0xf0);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_ALWAYS, 0x00, 0xf0);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::WIPE_CLIP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_NOTEQUAL, 0x00, 0x0f);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0x00, 0x0f);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::WIPE_MASK:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_EQUAL, 0x00, 0x0f);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0x0f);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::STAMP_NONE:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_ALWAYS, 0x00, 0x0f);
-            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
-            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_ALWAYS, 0x00, 0x0f);
+            renderstate::stencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::stencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::STAMP_CLIP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_NOTEQUAL, 0x00, 0x0f);
-            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
-            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0x00, 0x0f);
+            renderstate::stencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::stencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::STAMP_MASK:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_EQUAL, 0x00, 0x0f);
-            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
-            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0x0f);
+            renderstate::stencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::stencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::STAMP_BOTH:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_ALWAYS, 0x00, 0xff);
-            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
-            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_ALWAYS, 0x00, 0xff);
+            renderstate::stencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::stencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::CARVE_CLIP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_NOTEQUAL, 0x0f, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_NOTEQUAL, 0x0f, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::CARVE_MASK:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_EQUAL, 0x0f, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_EQUAL, 0x0f, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::CARVE_BOTH:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xff);
-            glStencilFunc(GL_EQUAL, 0x00, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xff);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
             break;
         case StencilEffect::CLAMP_CLIP:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_EQUAL, 0x0f, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_EQUAL, 0x0f, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
         case StencilEffect::CLAMP_MASK:
-            glEnable(GL_STENCIL_TEST);
-            glStencilMask(0xf0);
-            glStencilFunc(GL_EQUAL, 0x00, 0xff);
-            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            renderstate::setEnabled(GL_STENCIL_TEST, true);
+            renderstate::stencilMask(0xf0);
+            renderstate::stencilFunc(GL_EQUAL, 0x00, 0xff);
+            renderstate::stencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            renderstate::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
             break;
     }
 }
@@ -1049,6 +1049,10 @@ size_t TextLayout::getGlyphBoxes(Mesh<SpriteVertex2>& mesh, Rect rect) const {
  * layout. For performance reasons, we do not automatically recompute the
  * layout in that case. Instead, the user must call {@link #layout} to
  * arrange the text.
+ *
+ * If the font has atlas paging (see {@link Font#setAtlasPaging}), any
+ * glyphs of the text missing from the font atlases are added first. In
+ * that case, this method may only be called in the main thread.
  */
 void TextLayout::layout() {
     if (_rows.size() > 0) {
@@ -1059,6 +1063,8 @@ void TextLayout::layout() {
         row->begin = 0;
         row->end = _text.size();
         return;
+    } else if (_font->hasAtlasPaging()) {
+        _font->addGlyphs(_text);
     }
     
     if (_breakline >= 0) {
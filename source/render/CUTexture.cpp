@@ -34,7 +34,10 @@
 #include <sstream>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUFiletools.h>
+#include <cugl/util/CUProfiler.h>
+#include <cugl/io/CUAssetBundle.h>
 #include <cugl/render/CUTexture.h>
+#include <cugl/render/CURenderState.h>
 
 using namespace cugl;
 
@@ -177,6 +180,7 @@ _magFilter(GL_LINEAR),
 _wrapS(GL_CLAMP_TO_EDGE),
 _wrapT(GL_CLAMP_TO_EDGE),
 _hasMipmaps(false),
+_compressed(0),
 _parent(nullptr),
 _bindpoint(0),
 _minS(0),
@@ -194,6 +198,7 @@ void Texture::dispose() {
     if (_buffer != 0) {
         // Do we own the texture?
         if (_parent == nullptr) {
+            renderstate::forgetTexture(_buffer);
             glDeleteTextures(1, &_buffer);
         }
         _buffer = 0;
@@ -206,6 +211,7 @@ void Texture::dispose() {
         _minS = _minT = 0;
         _maxS = _maxT = 1;
         _hasMipmaps = false;
+        _compressed = 0;
         _bindpoint  = 0;
         _dirty = false;
     }
@@ -248,16 +254,18 @@ bool Texture::initWithData(const void *data, int width, int height, Texture::Pix
     _width  = width;
     _height = height;
     _pixelFormat = format;
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, _buffer);
+    renderstate::bindTexture(GL_TEXTURE0, _buffer);
 
     GLint  internal = internal_format(format);
     GLenum datatype = format_type(format);
+    CU_PROFILE_SCOPE("Texture::upload");
+    CU_PROFILE_BYTES(data ? (Uint64)width*height*getByteSize() : 0);
     glTexImage2D(GL_TEXTURE_2D, 0, internal, width, height, 0, (GLenum)format, datatype, data);
     
     error = glGetError();
     if (error) {
         CULogError("Could not initialize texture. %s", gl_error_name(error).c_str());
+        renderstate::forgetTexture(_buffer);
         glDeleteTextures(1, &_buffer);
         _buffer = 0;
         return false;
@@ -268,7 +276,7 @@ bool Texture::initWithData(const void *data, int width, int height, Texture::Pix
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _wrapS);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _wrapT);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    renderstate::bindTexture(GL_TEXTURE0, 0);
     std::stringstream ss;
     ss << "@" << data;
     setName(ss.str());
@@ -288,13 +296,28 @@ bool Texture::initWithData(const void *data, int width, int height, Texture::Pix
  * The texture will be stored in RGBA format, even if it is a file format
  * that does not support transparency (e.g. JPEG).
  *
+ * Files with the extension .ktx or .ktx2 are instead read as GPU-compressed
+ * images (see {@link CompressedImage}), and are loaded with {@link #initWithImage}.
+ *
  * @param filename  The file supporting the texture file.
  *
  * @return true if initialization was successful.
  */
 bool Texture::initWithFile(const std::string filename) {
     std::string fullpath = filetool::normalize_path(filename);
-    SDL_Surface* surface = IMG_Load(fullpath.c_str());
+    if (CompressedImage::isContainer(fullpath)) {
+        std::shared_ptr<CompressedImage> image = CompressedImage::alloc(fullpath);
+        if (image == nullptr) {
+            CULogError("Could not load file %s.", filename.c_str());
+            return false;
+        }
+        bool result = initWithImage(image);
+        if (result) setName(filename);
+        return result;
+    }
+
+    SDL_RWops* stream = AssetBundle::openStream(fullpath);
+    SDL_Surface* surface = stream ? IMG_Load_RW(stream, 1) : nullptr;
     if (surface == nullptr) {
         CULogError("Could not load file %s. %s", filename.c_str(), SDL_GetError());
         return false;
@@ -318,6 +341,84 @@ bool Texture::initWithFile(const std::string filename) {
     return result;
 }
 
+/**
+ * Initializes a texture with the given GPU-compressed image.
+ *
+ * Initializing a texture requires the use of the binding point at 0. Any
+ * texture bound to that point will be unbound. In addition, once
+ * initialization is done, this texture will not longer be bound as well.
+ *
+ * The compressed data is sent to the graphics card as is, with no decoding.
+ * If the image has a mipmap chain, all of the levels are loaded, and
+ * {@link #hasMipMaps} will be true. Mipmaps cannot be generated for a
+ * compressed texture, and the data of a compressed texture cannot be
+ * changed with {@link #set}. This method fails if the format of the image
+ * is not supported by this device (see {@link CompressedImage#isSupported}).
+ *
+ * @param image     The compressed image
+ *
+ * @return true if initialization was successful.
+ */
+bool Texture::initWithImage(const std::shared_ptr<CompressedImage>& image) {
+    CUAssertLog(image != nullptr && image->getLevelCount() > 0, "Compressed image is empty");
+    GLenum error;
+    
+    if (_buffer) {
+        CUAssertLog(false, "Texture is already initialized");
+        return false; // In case asserts are off.
+    } else if (!CompressedImage::isSupported(image->getFormat())) {
+        CULogError("Compressed format 0x%04X is not supported on this device.", image->getFormat());
+        return false;
+    }
+    
+    glGenTextures(1, &_buffer);
+    if (_buffer == 0) {
+        error = glGetError();
+        CULogError("Could not allocate texture. %s", gl_error_name(error).c_str());
+        return false;
+    }
+    
+    _width  = image->getWidth();
+    _height = image->getHeight();
+    _pixelFormat = PixelFormat::RGBA;
+    _compressed  = image->getFormat();
+    renderstate::bindTexture(GL_TEXTURE0, _buffer);
+    
+    GLsizei width  = _width;
+    GLsizei height = _height;
+    GLint levels = (GLint)image->getLevelCount();
+    for(GLint level = 0; level < levels; level++) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, _compressed, width, height, 0,
+                               (GLsizei)image->getLevelSize(level), image->getLevelData(level));
+        width  = std::max(width/2,1);
+        height = std::max(height/2,1);
+    }
+    
+    error = glGetError();
+    if (error) {
+        CULogError("Could not initialize texture. %s", gl_error_name(error).c_str());
+        renderstate::forgetTexture(_buffer);
+        glDeleteTextures(1, &_buffer);
+        _buffer = 0;
+        _compressed = 0;
+        return false;
+    }
+    
+    // A partial chain is complete only if OpenGL knows where it ends
+    _hasMipmaps = levels > 1;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels-1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _magFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _wrapS);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _wrapT);
+    
+    renderstate::bindTexture(GL_TEXTURE0, 0);
+    std::stringstream ss;
+    ss << "@" << image.get();
+    setName(ss.str());
+    return true;
+}
+
 /**
  * Returns a blank texture that can be used to make solid shapes.
  *
@@ -363,7 +464,10 @@ const std::shared_ptr<Texture>& Texture::getBlank() {
  * @return a reference to this (modified) texture for chaining.
  */
 const Texture& Texture::set(const void *data) {
-    if (!isActive()) {
+    if (isCompressed()) {
+        CUAssertLog(false,"Texture %s is compressed.",_name.c_str());
+        return *this;
+    } else if (!isActive()) {
         CUAssertLog(false,"Texture %s is not currently active.",_name.c_str());
         return *this;
     }
@@ -373,6 +477,42 @@ const Texture& Texture::set(const void *data) {
     return *this;
 }
 
+/**
+ * Sets a rectangular region of this texture to the contents of the buffer.
+ *
+ * The buffer must have the correct data format. In addition, the buffer
+ * must be size width*height*bytesize, and the region must lie inside of
+ * the texture. Rows are assumed to be tightly packed. See {@link #getByteSize}
+ * for a description of the latter.
+ *
+ * This method does not rebuild any mipmaps.  Call {@link #buildMipMaps}
+ * when all regions have been updated. This method is only successful if
+ * the texture is currently active.
+ *
+ * @param data      The buffer to read into the texture
+ * @param x         The x-coordinate of the region origin
+ * @param y         The y-coordinate of the region origin
+ * @param width     The region width
+ * @param height    The region height
+ *
+ * @return a reference to this (modified) texture for chaining.
+ */
+const Texture& Texture::set(const void *data, int x, int y, int width, int height) {
+    if (isCompressed()) {
+        CUAssertLog(false,"Texture %s is compressed.",_name.c_str());
+        return *this;
+    } else if (!isActive()) {
+        CUAssertLog(false,"Texture %s is not currently active.",_name.c_str());
+        return *this;
+    }
+    CUAssertLog(x >= 0 && y >= 0 && x+width <= (int)_width && y+height <= (int)_height,
+                "Region [%d,%d,%d,%d] is outside of texture %s",x,y,width,height,_name.c_str());
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height,
+                    (GLenum)_pixelFormat, GL_UNSIGNED_BYTE, data);
+    return *this;
+}
+
 
 #pragma mark -
 #pragma mark Attributes
@@ -409,11 +549,19 @@ unsigned int Texture::getByteSize() const {
  *
  * This method will fail if this texture is a subtexture.  Only the parent
  * texture can have mipmaps.  In addition, mipmaps can only be built if the
- * texture size is a power of two.
+ * texture size is a power of two. Compressed textures cannot build mipmaps,
+ * and this method does nothing for them (see {@link #initWithImage}).
  *
  * This method is only successful if the texture is currently active.
  */
 void Texture::buildMipMaps() {
+    if (_compressed) {
+        // Compressed mipmaps must come from the file
+        if (!_hasMipmaps) {
+            CUWarn("Cannot build mipmaps for compressed texture %s", _name.c_str());
+        }
+        return;
+    }
     CUAssertLog(nextPOT(_width)  == _width,  "Width  %d is not a power of two", _width);
     CUAssertLog(nextPOT(_height) == _height, "Height %d is not a power of two", _height);
     CUAssertLog(_parent == nullptr, "Cannot build mipmaps for a subtexture");
@@ -593,18 +741,10 @@ std::shared_ptr<Texture> Texture::getSubTexture(GLfloat minS, GLfloat maxS,
  * @param point the texture location to associate with this texture.
  */
 void Texture::setBindPoint(GLuint point) {
-    GLint orig;
-    glGetIntegerv(GL_ACTIVE_TEXTURE,&orig);
-    if (orig != _bindpoint+GL_TEXTURE0) {
-        glActiveTexture(GL_TEXTURE0+_bindpoint);
-    }
-    GLint bind;
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bind);
-    if (bind == _buffer) {
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
-    if (orig != _bindpoint+GL_TEXTURE0) {
-        glActiveTexture(orig);
+    if (renderstate::getTexture(GL_TEXTURE0+_bindpoint) == _buffer) {
+        GLenum orig = renderstate::getActiveTexture();
+        renderstate::bindTexture(GL_TEXTURE0+_bindpoint, 0);
+        renderstate::activeTexture(orig);
     }
     GLenum error = glGetError();
     CUAssertLog(error == GL_NO_ERROR, "Texture: %s", gl_error_name(error).c_str());
@@ -633,8 +773,7 @@ void Texture::bind() {
         return;
     }
     
-    glActiveTexture(GL_TEXTURE0+_bindpoint);
-    glBindTexture(GL_TEXTURE_2D,_buffer);
+    renderstate::bindTexture(GL_TEXTURE0+_bindpoint, _buffer);
     if (_dirty) {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _minFilter);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _magFilter);
@@ -661,14 +800,10 @@ void Texture::unbind() {
         return;
     }
 
-    GLint orig;
-    glGetIntegerv(GL_ACTIVE_TEXTURE,&orig);
-    if (orig != _bindpoint+GL_TEXTURE0) {
-        glActiveTexture(GL_TEXTURE0+_bindpoint);
-    }
-    glBindTexture(GL_TEXTURE_2D, 0);
-    if (orig != _bindpoint+GL_TEXTURE0) {
-        glActiveTexture(orig);
+    if (renderstate::getTexture(GL_TEXTURE0+_bindpoint) == _buffer) {
+        GLenum orig = renderstate::getActiveTexture();
+        renderstate::bindTexture(GL_TEXTURE0+_bindpoint, 0);
+        renderstate::activeTexture(orig);
     }
 }
 
@@ -690,18 +825,7 @@ bool Texture::isBound() const {
         return false;
     }
     
-    GLint orig;
-    glGetIntegerv(GL_ACTIVE_TEXTURE,&orig);
-    if (orig != _bindpoint+GL_TEXTURE0) {
-        glActiveTexture(GL_TEXTURE0+_bindpoint);
-    }
-    GLint bind;
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bind);
-    bool result = (bind == _buffer);
-    if (orig != _bindpoint+GL_TEXTURE0) {
-        glActiveTexture(orig);
-    }
-    return result;
+    return renderstate::getTexture(GL_TEXTURE0+_bindpoint) == _buffer;
 }
 
 /**
@@ -721,14 +845,10 @@ bool Texture::isActive() const {
     if (!_buffer) {
         return false;
     }
-    GLint orig;
-    glGetIntegerv(GL_ACTIVE_TEXTURE,&orig);
-    if (orig != _bindpoint+GL_TEXTURE0) {
+    if (renderstate::getActiveTexture() != _bindpoint+GL_TEXTURE0) {
         return false;
     }
-    GLint bind;
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bind);
-    return (bind == _buffer);
+    return renderstate::getTexture(GL_TEXTURE0+_bindpoint) == _buffer;
 }
 
 
@@ -779,7 +899,10 @@ bool Texture::save(const std::string file) {
     CUAssertLog(false, "Texture saving is not supported in OpenGLES");
     return false;
 #else
-    if (!isActive()) {
+    if (isCompressed()) {
+        CUAssertLog(false,"Texture %s is compressed.",_name.c_str());
+        return false;
+    } else if (!isActive()) {
         CUAssertLog(false,"Texture %s is not currently active.",_name.c_str());
         return false;
     } else if (!filetool::is_absolute(file)) {
@@ -44,6 +44,7 @@
 //  Version: 2/29/20
 #include <cugl/util/CUDebug.h>
 #include <cugl/render/CUUniformBuffer.h>
+#include <cugl/render/CURenderState.h>
 
 using namespace cugl;
 
@@ -62,7 +63,8 @@ _blocksize(0),
 _blockstride(0),
 _bindpoint(0),
 _autoflush(false),
-_dirty(false)
+_dirtyBegin(0),
+_dirtyEnd(0)
 {
     _name = "";
     _bytebuffer = nullptr;
@@ -139,10 +141,11 @@ bool UniformBuffer::init(GLsizei capacity, GLuint blocks) {
     }
 
     _bytebuffer = (char*)malloc(_blockstride*_blockcount);
-    glBindBuffer(GL_UNIFORM_BUFFER, _dataBuffer);
+    renderstate::bindBuffer(GL_UNIFORM_BUFFER, _dataBuffer);
     glBufferData(GL_UNIFORM_BUFFER, _blockstride*_blockcount, NULL, _drawtype);
     error = glGetError();
     if (error) {
+        renderstate::forgetBuffer(_dataBuffer);
         glDeleteBuffers(1, &_dataBuffer);
         _dataBuffer = 0;
         CULogError("Could not allocate memory for uniform buffer. %s",
@@ -150,7 +153,7 @@ bool UniformBuffer::init(GLsizei capacity, GLuint blocks) {
         return false;
     }
     
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    renderstate::bindBuffer(GL_UNIFORM_BUFFER, 0);
     return true;
 }
 
@@ -161,6 +164,7 @@ bool UniformBuffer::init(GLsizei capacity, GLuint blocks) {
  */
 void UniformBuffer::dispose() {
     if (_dataBuffer) {
+        renderstate::forgetBuffer(_dataBuffer);
         glDeleteBuffers(1,&_dataBuffer);
         _dataBuffer = 0;
     }
@@ -174,6 +178,8 @@ void UniformBuffer::dispose() {
     _blocksize   = 0;
     _blockstride = 0;
     _bindpoint = 0;
+    _dirtyBegin = 0;
+    _dirtyEnd = 0;
 }
 
 
@@ -197,10 +203,8 @@ void UniformBuffer::dispose() {
  * @param point The bind point for for this uniform buffer.
  */
 void UniformBuffer::setBindPoint(GLuint point) {
-    GLint bound;
-    glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING,_bindpoint,&bound);
-    if (bound == _dataBuffer) {
-        glBindBufferBase(GL_UNIFORM_BUFFER, _bindpoint, 0);
+    if (renderstate::getBufferBase(GL_UNIFORM_BUFFER,_bindpoint) == _dataBuffer) {
+        renderstate::bindBufferBase(GL_UNIFORM_BUFFER, _bindpoint, 0);
     }
     _bindpoint = point;
 }
@@ -229,7 +233,7 @@ void UniformBuffer::bind(bool activate) {
     if (activate) {
         this->activate();
     }
-    glBindBufferBase(GL_UNIFORM_BUFFER, _bindpoint, _dataBuffer);
+    renderstate::bindBufferBase(GL_UNIFORM_BUFFER, _bindpoint, _dataBuffer);
 }
 
 /**
@@ -246,10 +250,8 @@ void UniformBuffer::bind(bool activate) {
  * This call is reentrant.  If can be safely called multiple times.
  */
 void UniformBuffer::unbind() {
-    GLint bound;
-    glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING,_bindpoint,&bound);
-    if (bound == _dataBuffer) {
-        glBindBufferBase(GL_UNIFORM_BUFFER, _bindpoint, 0);
+    if (renderstate::getBufferBase(GL_UNIFORM_BUFFER,_bindpoint) == _dataBuffer) {
+        renderstate::bindBufferBase(GL_UNIFORM_BUFFER, _bindpoint, 0);
     }
 }
 
@@ -268,10 +270,9 @@ void UniformBuffer::unbind() {
  * This call is reentrant.  If can be safely called multiple times.
  */
 void UniformBuffer::activate() {
-    glBindBuffer(GL_UNIFORM_BUFFER, _dataBuffer);
-    if (_autoflush && _dirty) {
-        glBufferData(GL_UNIFORM_BUFFER,_blockstride*_blockcount,_bytebuffer,_drawtype);
-        _dirty = false;
+    renderstate::bindBuffer(GL_UNIFORM_BUFFER, _dataBuffer);
+    if (_autoflush) {
+        flush();
     }
 }
 
@@ -289,12 +290,10 @@ void UniformBuffer::activate() {
 void UniformBuffer::deactivate() {
 #if CU_PLATFORM == CU_PLATFORM_ANDROID
  	// There are problems with this query on emulator
- 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+ 	renderstate::bindBuffer(GL_UNIFORM_BUFFER, 0);
 #else
-	GLint bound;
-    glGetIntegerv(GL_UNIFORM_BUFFER_BINDING,&bound);
-    if (bound == _dataBuffer) {
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    if (renderstate::getBuffer(GL_UNIFORM_BUFFER) == _dataBuffer) {
+        renderstate::bindBuffer(GL_UNIFORM_BUFFER, 0);
     }
 #endif
 }
@@ -309,9 +308,7 @@ void UniformBuffer::deactivate() {
  * @return true if this uniform block is currently bound.
  */
 bool UniformBuffer::isBound() const {
-    GLint bound;
-    glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING,_bindpoint,&bound);
-    return bound == _dataBuffer;
+    return renderstate::getBufferBase(GL_UNIFORM_BUFFER,_bindpoint) == _dataBuffer;
 }
     
 /**
@@ -328,9 +325,7 @@ bool UniformBuffer::isBound() const {
  * @return true if this uniform block is currently active.
  */
 bool UniformBuffer::isActive() const {
-    GLint bound;
-    glGetIntegerv(GL_UNIFORM_BUFFER_BINDING,&bound);
-    return bound == _dataBuffer;
+    return renderstate::getBuffer(GL_UNIFORM_BUFFER) == _dataBuffer;
 }
 
 /**
@@ -346,8 +341,8 @@ void UniformBuffer::setBlock(GLuint block) {
     CUAssertLog(isBound(), "Buffer is not bound.");
     if (_blockpntr != block) {
         _blockpntr = block;
-        glBindBufferRange(GL_UNIFORM_BUFFER,_bindpoint,_dataBuffer,
-                          block*_blockstride,_blocksize);
+        renderstate::bindBufferRange(GL_UNIFORM_BUFFER,_bindpoint,_dataBuffer,
+                                     block*_blockstride,_blocksize);
     }
 }
 
@@ -358,11 +353,19 @@ void UniformBuffer::setBlock(GLuint block) {
  * buffer directly via {@link #getData} and needs to push these changes to the
  * graphics card.  Calling this method will not affect the active uniform
  * buffer.
+ *
+ * Only the range of bytes changed since the last flush is sent to the
+ * graphics card. The buffer storage is never reallocated, so this method
+ * does nothing if there are no pending changes.
  */
 void UniformBuffer::flush() {
     // CUAssertLog(isActive(), "Buffer is not active."); // Problems on android emulator for now
-    glBufferData(GL_UNIFORM_BUFFER,_blockstride*_blockcount,_bytebuffer,_drawtype);
-    _dirty = false;
+    if (_dirtyBegin < _dirtyEnd) {
+        glBufferSubData(GL_UNIFORM_BUFFER, _dirtyBegin, _dirtyEnd-_dirtyBegin,
+                        _bytebuffer+_dirtyBegin);
+    }
+    _dirtyBegin = 0;
+    _dirtyEnd = 0;
 }
 
 
@@ -1238,14 +1241,14 @@ void UniformBuffer::setUniformfv(GLint block, GLsizei offset, GLsizei size, cons
         if (_autoflush && isActive()) {
             glBufferSubData(GL_UNIFORM_BUFFER, position, size*sizeof(float), values);
         } else {
-            _dirty = true;
+            markDirty(position, position+size*(GLsizei)sizeof(float));
         }
     } else {
         bool active = false;
         if (_autoflush && isActive()) {
             active = true;
         } else {
-            _dirty = true;
+            markDirty(offset, (_blockcount-1)*_blockstride+offset+size*(GLsizei)sizeof(float));
         }
         for(int block = 0; block < _blockcount; block++) {
             GLsizei position = block*_blockstride+offset;
@@ -1355,14 +1358,14 @@ void UniformBuffer::setUniformiv(GLint block, GLsizei offset, GLsizei size, cons
         if (_autoflush && isActive()) {
             glBufferSubData(GL_UNIFORM_BUFFER, position, size*sizeof(GLint), values);
         } else {
-            _dirty = true;
+            markDirty(position, position+size*(GLsizei)sizeof(GLint));
         }
     } else {
         bool active = false;
         if (_autoflush && isActive()) {
             active = true;
         } else {
-            _dirty = true;
+            markDirty(offset, (_blockcount-1)*_blockstride+offset+size*(GLsizei)sizeof(GLint));
         }
         for(int block = 0; block < _blockcount; block++) {
             GLsizei position = block*_blockstride+offset;
@@ -1472,14 +1475,14 @@ void UniformBuffer::setUniformuiv(GLint block, GLsizei offset, GLsizei size, con
         if (_autoflush && isActive()) {
             glBufferSubData(GL_UNIFORM_BUFFER, position, size*sizeof(GLuint), values);
         } else {
-            _dirty = true;
+            markDirty(position, position+size*(GLsizei)sizeof(GLuint));
         }
     } else {
         bool active = false;
         if (_autoflush && isActive()) {
             active = true;
         } else {
-            _dirty = true;
+            markDirty(offset, (_blockcount-1)*_blockstride+offset+size*(GLsizei)sizeof(GLuint));
         }
         for(int block = 0; block < _blockcount; block++) {
             GLsizei position = block*_blockstride+offset;
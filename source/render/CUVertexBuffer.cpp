@@ -31,11 +31,18 @@
 //  Version: 2/10/20
 #include <cugl/util/CUDebug.h>
 #include <cugl/render/CUVertexBuffer.h>
+#include <cugl/render/CURenderState.h>
 #include <cugl/render/CUShader.h>
 #include <cugl/render/CUTexture.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 using namespace cugl;
 
+/** The maximum time to wait for the GPU to release a streaming region (in ns) */
+#define STREAM_TIMEOUT  1000000000
+
 #pragma mark Constructors
 /**
  * Creates an uninitialized vertex buffer.
@@ -46,8 +53,16 @@ VertexBuffer::VertexBuffer() :
 _vertArray(0),
 _vertBuffer(0),
 _indxBuffer(0),
-_stride(0) {
+_stride(0),
+_streamVerts(0),
+_streamIndxs(0),
+_region(0),
+_pending(false),
+_indxBase(0) {
     _shader = nullptr;
+    for(Uint32 ii = 0; ii < VERTEX_STREAM_REGIONS; ii++) {
+        _fences[ii] = 0;
+    }
 }
 
 /**
@@ -113,6 +128,10 @@ void VertexBuffer::dispose() {
     }
     _enabled.clear();
     _attributes.clear();
+    disableStreaming();
+    renderstate::forgetBuffer(_indxBuffer);
+    renderstate::forgetBuffer(_vertBuffer);
+    renderstate::forgetVertexArray(_vertArray);
     glDeleteBuffers(1,&_indxBuffer);
     glDeleteBuffers(1,&_vertBuffer);
     glDeleteVertexArrays(1,&_vertArray);
@@ -139,9 +158,9 @@ void VertexBuffer::dispose() {
  */
 void VertexBuffer::bind() {
     CUAssertLog(_vertBuffer, "VertexBuffer has not be initialized.");
-    glBindVertexArray(_vertArray);
-	glBindBuffer( GL_ARRAY_BUFFER, _vertBuffer );
-	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _indxBuffer );
+    renderstate::bindVertexArray(_vertArray);
+    renderstate::bindBuffer( GL_ARRAY_BUFFER, _vertBuffer );
+    renderstate::bindBuffer( GL_ELEMENT_ARRAY_BUFFER, _indxBuffer );
     if (_shader != nullptr) {
         _shader->bind();
     }
@@ -160,9 +179,9 @@ void VertexBuffer::bind() {
  */
 void VertexBuffer::unbind() {
     if (isBound()) {
-        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
-        glBindBuffer( GL_ARRAY_BUFFER, 0 );
-        glBindVertexArray(0);
+        renderstate::bindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+        renderstate::bindBuffer( GL_ARRAY_BUFFER, 0 );
+        renderstate::bindVertexArray(0);
     }
 }
 
@@ -185,7 +204,7 @@ void VertexBuffer::attach(const std::shared_ptr<Shader>& shader) {
         // Link up attributes on the first time
         for(auto it = _attributes.begin(); it != _attributes.end(); ++it) {
             std::string name = it->first;
-			GLint pos = glGetAttribLocation(_shader->getProgram(), name.c_str());
+			GLint pos = _shader->getAttributeLocation(name);
 			if (pos == -1) {
 				CUWarn("Active shader has no attribute %s", name.c_str());
 			} else if (_enabled[name]) {
@@ -193,6 +212,7 @@ void VertexBuffer::attach(const std::shared_ptr<Shader>& shader) {
 				glVertexAttribPointer(pos,it->second.size,it->second.type,
 									  it->second.norm,_stride,
 									  reinterpret_cast<void*>(it->second.offset));
+                glVertexAttribDivisor(pos,it->second.divisor);
 			} else {
 				glDisableVertexAttribArray(pos);
 			}
@@ -225,9 +245,7 @@ std::shared_ptr<Shader> VertexBuffer::detach() {
  * @return true if this vertex is currently bound.
  */
 bool VertexBuffer::isBound() const {
-    GLint vao;
-    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
-    return vao == _vertArray;
+    return renderstate::getVertexArray() == _vertArray;
 }
 
 
@@ -260,6 +278,7 @@ bool VertexBuffer::isBound() const {
  */
 void VertexBuffer::loadVertexData(const void * data, GLsizei size, GLenum usage) {
     //CUAssertLog(isBound(), "Vertex buffer is not bound"); // Problems on android emulator for now
+    disableStreaming();
     glBufferData( GL_ARRAY_BUFFER, _stride * size, data, usage );
     
     GLenum error = glGetError();
@@ -294,7 +313,152 @@ void VertexBuffer::loadVertexData(const void * data, GLsizei size, GLenum usage)
  */
 void VertexBuffer::loadIndexData(const void * data, GLsizei size, GLenum usage) {
     //CUAssertLog(isBound(), "Vertex buffer is not bound"); // Problems on android emulator for now
+    disableStreaming();
     glBufferData( GL_ELEMENT_ARRAY_BUFFER, size * sizeof(GLuint), data, usage );
+    _indxBase = 0;
+    GLenum error = glGetError();
+    CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+}
+
+/**
+ * Enables streaming with the given capacity.
+ *
+ * A streaming vertex buffer divides its buffers into a ring of regions
+ * (currently three). Each call to {@link #streamData} writes to the next
+ * region with an unsynchronized map, while the GPU is free to read
+ * from the regions drawn previously. A fence guards each region, so a
+ * region is only reused once the GPU is done with it. This avoids the
+ * driver stalls that can happen when {@link #loadVertexData} replaces a
+ * buffer that is still in use.
+ *
+ * Streaming is disabled by any call to {@link #loadVertexData} or
+ * {@link #loadIndexData}, as these reallocate the buffers.
+ *
+ * This method will only succeed if this buffer is actively bound.
+ *
+ * @param vertices  The number of vertices in each region
+ * @param indices   The number of indices in each region
+ */
+void VertexBuffer::enableStreaming(GLsizei vertices, GLsizei indices) {
+    disableStreaming();
+    if (vertices <= 0 || indices <= 0) {
+        return;
+    }
+    glBufferData(GL_ARRAY_BUFFER, _stride * vertices * VERTEX_STREAM_REGIONS, nullptr, GL_STREAM_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices * VERTEX_STREAM_REGIONS, nullptr, GL_STREAM_DRAW);
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        CULogError("Could not allocate streaming buffers. %s", gl_error_name(error).c_str());
+        return;
+    }
+    _streamVerts = vertices;
+    _streamIndxs = indices;
+    _region = VERTEX_STREAM_REGIONS-1;
+    _indxBase = 0;
+}
+
+/**
+ * Disables streaming, releasing the streaming regions.
+ *
+ * The buffers are not reallocated until the next load.
+ */
+void VertexBuffer::disableStreaming() {
+    clearFences();
+    _streamVerts = 0;
+    _streamIndxs = 0;
+    _region = 0;
+    _pending = false;
+    _indxBase = 0;
+}
+
+/**
+ * Releases any fences guarding the streaming regions.
+ */
+void VertexBuffer::clearFences() {
+    for(Uint32 ii = 0; ii < VERTEX_STREAM_REGIONS; ii++) {
+        if (_fences[ii]) {
+            glDeleteSync(_fences[ii]);
+            _fences[ii] = 0;
+        }
+    }
+}
+
+/**
+ * Loads the given vertices and indices into the next streaming region.
+ *
+ * The data will be used by all draw commands until the next load. Indices
+ * are relative to the given vertices, exactly as with {@link #loadIndexData},
+ * and draw offsets are relative to the given indices. If the data does not
+ * fit in a region, the regions are grown to fit. If this buffer is not
+ * streaming, this method falls back to {@link #loadVertexData} and
+ * {@link #loadIndexData}.
+ *
+ * This method will only succeed if this buffer is actively bound.
+ *
+ * @param vertices  The vertices to load
+ * @param vsize     The number of vertices to load
+ * @param indices   The indices to load
+ * @param isize     The number of indices to load
+ */
+void VertexBuffer::streamData(const void* vertices, GLsizei vsize, const GLuint* indices, GLsizei isize) {
+    if (_streamVerts && (vsize > _streamVerts || isize > _streamIndxs)) {
+        enableStreaming(std::max(vsize,_streamVerts), std::max(isize,_streamIndxs));
+    }
+    if (!_streamVerts) {
+        loadVertexData(vertices, vsize);
+        loadIndexData(indices, isize);
+        return;
+    }
+    
+    // Fence the region just drawn, and wait for the GPU to finish the next one
+    if (_pending) {
+        if (_fences[_region]) {
+            glDeleteSync(_fences[_region]);
+        }
+        _fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        _pending = false;
+    }
+    Uint32 next = (_region+1) % VERTEX_STREAM_REGIONS;
+    if (_fences[next]) {
+        GLenum status = glClientWaitSync(_fences[next], GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_TIMEOUT);
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+            CUWarn("VertexBuffer: streaming region was not released in time");
+        }
+        glDeleteSync(_fences[next]);
+        _fences[next] = 0;
+    }
+    
+    GLintptr vbase = (GLintptr)next*_streamVerts;
+    GLintptr ibase = (GLintptr)next*_streamIndxs;
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    
+    GLsizeiptr vbytes = (GLsizeiptr)_stride*vsize;
+    void* vdst = glMapBufferRange(GL_ARRAY_BUFFER, vbase*_stride, vbytes, access);
+    if (vdst != nullptr) {
+        std::memcpy(vdst, vertices, vbytes);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    } else {
+        glBufferSubData(GL_ARRAY_BUFFER, vbase*_stride, vbytes, vertices);
+    }
+    
+    // The indices are shifted to the vertices of this region
+    GLsizeiptr ibytes = sizeof(GLuint)*isize;
+    GLuint* idst = (GLuint*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, ibase*sizeof(GLuint), ibytes, access);
+    if (idst != nullptr) {
+        for(GLsizei ii = 0; ii < isize; ii++) {
+            idst[ii] = indices[ii]+(GLuint)vbase;
+        }
+        glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    } else {
+        std::vector<GLuint> shifted(indices,indices+isize);
+        for(auto it = shifted.begin(); it != shifted.end(); ++it) {
+            *it += (GLuint)vbase;
+        }
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, ibase*sizeof(GLuint), ibytes, shifted.data());
+    }
+    
+    _region = next;
+    _indxBase = (GLsizei)ibase;
     GLenum error = glGetError();
     CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
 }
@@ -322,7 +486,8 @@ void VertexBuffer::loadIndexData(const void * data, GLsizei size, GLenum usage)
  */
 void VertexBuffer::draw(GLenum mode, GLsizei count, GLsizei offset) {
     //CUAssertLog(isBound(), "Vertex buffer is not bound"); // Problems on android emulator for now
-    glDrawElements(mode, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)));
+    glDrawElements(mode, count, GL_UNSIGNED_INT, (void*)((offset+_indxBase) * sizeof(GLuint)));
+    _pending = _streamVerts > 0;
 }
 
 /**
@@ -356,7 +521,8 @@ void VertexBuffer::draw(GLenum mode, GLsizei count, GLsizei offset) {
  */
 void VertexBuffer::drawInstanced(GLenum mode, GLsizei count, GLsizei instance, GLsizei offset) {
     //CUAssertLog(isBound(), "Vertex buffer is not bound"); // Problems on android emulator for now
-    glDrawElementsInstanced(mode, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)), instance);
+    glDrawElementsInstanced(mode, count, GL_UNSIGNED_INT, (void*)((offset+_indxBase) * sizeof(GLuint)), instance);
+    _pending = _streamVerts > 0;
 }
 
 
@@ -387,18 +553,20 @@ void VertexBuffer::setupAttribute(const std::string name, GLint size, GLenum typ
     data.norm = norm;
     data.type = type;
     data.offset = offset;
+    data.divisor = 0;
     _attributes[name] = data;
     _enabled[name] = true;
     
     if (_shader != nullptr) {
         _shader->bind();
-        GLint pos = glGetAttribLocation(_shader->getProgram(), name.c_str());
+        GLint pos = _shader->getAttributeLocation(name);
         if (pos == -1) {
             CUWarn("Active shader has no attribute %s", name.c_str());
         } else {
             glEnableVertexAttribArray(pos);
             glVertexAttribPointer(pos,data.size,data.type,data.norm,_stride,
                                   reinterpret_cast<void*>(data.offset));
+            glVertexAttribDivisor(pos,0);
         }
         
         GLenum error = glGetError();
@@ -406,6 +574,37 @@ void VertexBuffer::setupAttribute(const std::string name, GLint size, GLenum typ
     }
 }
 
+/**
+ * Sets the instance divisor of the given attribute.
+ *
+ * An attribute with divisor 0 (the default) advances once per vertex. An
+ * attribute with divisor n advances once every n instances in a call to
+ * {@link #drawInstanced}. This allows a buffer to hold per-instance data,
+ * such as the transform of a sprite, which is shared by all of the vertices
+ * of that instance.
+ *
+ * The attribute must have been set up with {@link #setupAttribute}. The
+ * divisor is cached and applied whenever a shader is attached.
+ *
+ * @param name      The attribute name
+ * @param divisor   The number of instances between updates of the attribute
+ */
+void VertexBuffer::setAttributeDivisor(const std::string name, GLuint divisor) {
+    auto it = _attributes.find(name);
+    CUAssertLog(it != _attributes.end(), "Vertex buffer has no attribute %s", name.c_str());
+    if (it == _attributes.end()) {
+        return;
+    }
+    it->second.divisor = divisor;
+    if (_shader != nullptr) {
+        bind();
+        GLint pos = _shader->getAttributeLocation(name);
+        if (pos != -1) {
+            glVertexAttribDivisor(pos,divisor);
+        }
+    }
+}
+
 /**
  * Enables the given attribute
  *
@@ -0,0 +1,71 @@
+R"(////////// SHADER BEGIN /////////
+//  SpriteInstance.vert
+//  Cornell University Game Library (CUGL)
+//
+//  This is the instanced vertex shader for SpriteBatch. Each instance is a
+//  single quad, described by its center, size, angle, color and texture
+//  coordinates. The corners of the quad come from the vertex id, so the only
+//  data uploaded is the instance itself. This shader is paired with the
+//  standard SpriteBatch fragment shader.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+
+// Instance attributes
+in vec2  aPosition;
+in vec2  aSize;
+in float aAngle;
+in vec4  aColor;
+in vec2  aTexMin;
+in vec2  aTexMax;
+
+// The outputs expected by the fragment shader
+out vec2 outPosition;
+out vec4 outColor;
+out vec2 outTexCoord;
+out vec2 outGradCoord;
+flat out int outTexIndex;
+flat out int outGradIndex;
+
+// Matrices
+uniform mat4 uPerspective;
+
+// Expand the instance into the corner for this vertex
+void main(void) {
+    // Corners are counter clockwise from the bottom left
+    vec2 corner = vec2((gl_VertexID == 1 || gl_VertexID == 2) ? 1.0 : 0.0,
+                       (gl_VertexID >= 2) ? 1.0 : 0.0);
+    vec2 local = (corner-vec2(0.5))*aSize;
+    float c = cos(aAngle);
+    float s = sin(aAngle);
+    vec2 world = aPosition+vec2(c*local.x-s*local.y, s*local.x+c*local.y);
+
+    gl_Position = uPerspective*vec4(world,0,1);
+    outPosition = world; // Need untransformed for scissor
+    outColor = aColor;
+    outTexCoord = vec2(mix(aTexMin.x,aTexMax.x,corner.x), mix(aTexMax.y,aTexMin.y,corner.y));
+    outGradCoord = outTexCoord;
+    outTexIndex = 0;
+    outGradIndex = -1;
+}
+
+/////////// SHADER END //////////)"
@@ -7,7 +7,7 @@ R"(////////// SHADER BEGIN /////////
 //  (which can be used simulataneously with textures, but not with colors), as
 //  well as a scissor mask.  Gradients use the color inputs as their texture
 //  coordinates. Finally, there is support for very simple blur effects, which
-//  are used for font labels.
+//  are used for font labels, and for signed distance field font atlases.
 //
 //  This shader was inspired by nanovg by Mikko Mononen (memon@inside.org).
 //
@@ -44,6 +44,8 @@ uniform vec2 uBlur;
 
 // The texture for sampling
 uniform sampler2D uTexture;
+// The textures for multitexturing (one per texture unit)
+uniform sampler2D uTextures[8];
 
 // The output color
 out vec4 frag_color;
@@ -53,6 +55,8 @@ in vec2 outPosition;
 in vec4 outColor;
 in vec2 outTexCoord;
 in vec2 outGradCoord;
+flat in int outTexIndex;
+flat in int outGradIndex;
 
 // The stroke+gradient uniform block
 layout (std140) uniform uContext
@@ -68,6 +72,23 @@ layout (std140) uniform uContext
     float gdFeathr;     //  4
 };
 
+// A single gradient in the gradient table (same layout as uContext)
+struct GradientRow
+{
+    mat3 matrix;        // 48
+    vec4 inner;         // 16
+    vec4 outer;         // 16
+    vec2 extent;        //  8
+    float radius;       //  4
+    float feathr;       //  4
+};
+
+// The gradient table (for batching several gradients)
+layout (std140) uniform uGradients
+{
+    GradientRow gdRows[32];
+};
+
 /**
  * Returns an interpolation value for a box gradient
  *
@@ -135,6 +156,49 @@ vec4 blursample(vec2 coord) {
     return result;
 }
 
+/**
+ * Returns the sample from the texture in the given slot
+ *
+ * Samplers may only be indexed by constants in OpenGL ES, so each slot
+ * is its own branch. Every fragment of a triangle has the same slot, so
+ * the branches do not diverge.
+ *
+ * slot:  The texture slot
+ * coord: The texture coordinate
+ */
+vec4 multisample(int slot, vec2 coord) {
+    if (slot < 4) {
+        if (slot == 0) {
+            return texture(uTextures[0], coord);
+        } else if (slot == 1) {
+            return texture(uTextures[1], coord);
+        } else if (slot == 2) {
+            return texture(uTextures[2], coord);
+        }
+        return texture(uTextures[3], coord);
+    } else if (slot == 4) {
+        return texture(uTextures[4], coord);
+    } else if (slot == 5) {
+        return texture(uTextures[5], coord);
+    } else if (slot == 6) {
+        return texture(uTextures[6], coord);
+    }
+    return texture(uTextures[7], coord);
+}
+
+/**
+ * Returns the coverage of a signed distance field sample
+ *
+ * The distance field has value 0.5 on the edge of the shape. The edge is
+ * antialiased over (roughly) one screen pixel, independent of the scale.
+ *
+ * dist: The sampled distance value
+ */
+float distancefield(float dist) {
+    float width = max(fwidth(dist),0.0001);
+    return smoothstep(0.5-width,0.5+width,dist);
+}
+
 /**
  * Performs the main fragment shading.
  */
@@ -142,7 +206,13 @@ void main(void) {
     vec4 result;
     float fType = float(uType);
 
-    if (mod(fType, 4.0) >= 2.0) {
+    if (mod(fType, 128.0) >= 64.0 && outGradIndex >= 0) {
+        // Each vertex picks its gradient from the table
+        vec2 pt = (gdRows[outGradIndex].matrix * vec3(outGradCoord,1.0)).xy;
+        float d = boxgradient(pt,gdRows[outGradIndex].extent,
+                              gdRows[outGradIndex].radius,gdRows[outGradIndex].feathr);
+        result = mix(gdRows[outGradIndex].inner,gdRows[outGradIndex].outer,d)*outColor;
+    } else if (mod(fType, 4.0) >= 2.0) {
         // Apply a gradient color
         mat3  cmatrix = gdMatrix;
         vec2  cextent = gdExtent;
@@ -155,15 +225,31 @@ void main(void) {
         result = outColor;
     }
     
-    if (mod(fType, 2.0) == 1.0) {
+    vec4 texel = vec4(1.0);
+    if (mod(fType, 32.0) >= 16.0) {
+        // Each vertex picks its texture (a blurred texture is always in slot 0)
+        if (outTexIndex >= 0) {
+            if (mod(fType, 16.0) >= 8.0) {
+                texel = blursample(outTexCoord);
+            } else {
+                texel = multisample(outTexIndex, outTexCoord);
+            }
+        }
+    } else if (mod(fType, 2.0) == 1.0) {
         // Include texture (tinted by color and/or gradient)
-        if (uType >= 8) {
-            result *= blursample(outTexCoord);
+        if (mod(fType, 16.0) >= 8.0) {
+            texel = blursample(outTexCoord);
         } else {
-            result *= texture(uTexture, outTexCoord);
+            texel = texture(uTexture, outTexCoord);
         }
     }
     
+    if (mod(fType, 64.0) >= 32.0) {
+        // The texture alpha is a distance to the edge
+        texel.w = distancefield(texel.w);
+    }
+    result *= texel;
+    
     if (mod(fType, 8.0) >= 4.0) {
         // Apply scissor mask
         result.w *= scissormask(outPosition);
@@ -49,6 +49,14 @@ out vec2 outTexCoord;
 in  vec2 aGradCoord;
 out vec2 outGradCoord;
 
+// Texture slots (for multitexturing)
+in  float aTexIndex;
+flat out int outTexIndex;
+
+// Gradient rows (for gradient tables)
+in  float aGradIndex;
+flat out int outGradIndex;
+
 // Matrices
 uniform mat4 uPerspective;
 
@@ -62,6 +70,8 @@ void main(void) {
     outColor = aColor;
     outTexCoord = aTexCoord;
     outGradCoord = aGradCoord;
+    outTexIndex = int(aTexIndex);
+    outGradIndex = int(aGradIndex);
 }
 
 /////////// SHADER END //////////)"
@@ -40,12 +40,53 @@
 //  Version: 7/1/16
 
 #include <cugl/scene2/CUScene2.h>
+#include <cugl/scene2/CUScene2Profiler.h>
+#include <cugl/scene2/ui/CULabelBatch.h>
+#include <cugl/render/CUFont.h>
 #include <cugl/util/CUStrings.h>
+#include <cugl/util/CUThreadPool.h>
+#include <condition_variable>
+#include <mutex>
 #include <sstream>
 #include <algorithm>
 
 using namespace cugl;
 
+/** The granularity (in pixels) of the render targets for cached subtrees */
+#define TARGET_GRAIN    64
+/** The number of profiler scopes listed in the overlay */
+#define PROFILE_LINES   8
+/** The margin (in pixels) of the profiler overlay */
+#define PROFILE_MARGIN  4
+
+/**
+ * Returns the pick grid key for the given cell
+ *
+ * @param col   The cell column
+ * @param row   The cell row
+ *
+ * @return the pick grid key for the given cell
+ */
+static Uint64 pick_key(int col, int row) {
+    return ((Uint64)(Uint32)col << 32) | (Uint64)(Uint32)row;
+}
+
+/**
+ * Returns true if the node and all of its ancestors are visible
+ *
+ * @param node  The node to test
+ *
+ * @return true if the node and all of its ancestors are visible
+ */
+static bool pick_visible(const scene2::SceneNode* node) {
+    for(; node != nullptr; node = node->getParent()) {
+        if (!node->isVisible()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * Creates a new degenerate Scene on the stack.
  *
@@ -61,7 +102,10 @@ _color(Color4::WHITE),
 _blendEquation(GL_FUNC_ADD),
 _srcFactor(GL_SRC_ALPHA),
 _dstFactor(GL_ONE_MINUS_SRC_ALPHA),
-_active(false)
+_active(false),
+_culling(false),
+_pickCell(0),
+_offscreen(false)
 {}
 
 /**
@@ -75,7 +119,16 @@ void Scene2::dispose() {
     _camera = nullptr;
     _name = "";
     _color = Color4::WHITE;
+    _recorders.clear();
     _active = false;
+    _pickCell = 0;
+    _pickables.clear();
+    _pickDirty.clear();
+    _pickGrid.clear();
+    _pickRanges.clear();
+    _targets = nullptr;
+    _profileFont = nullptr;
+    _labelBatch = nullptr;
 }
 
 /**
@@ -138,6 +191,28 @@ std::string Scene2::toString(bool verbose) const {
     return ss.str();
 }
 
+/**
+ * Sets whether this scene merges the text of its labels.
+ *
+ * When label batching is enabled, the glyphs of every {@link scene2::Label}
+ * in this scene are merged into one mesh for each font atlas page, and
+ * drawn after the rest of the scene (see {@link scene2::LabelBatch}). So a
+ * text-heavy HUD costs only a few draw calls. Labels are drawn in order
+ * of their priority (see {@link scene2::SceneNode#setPriority}), but they
+ * are always on top of the other nodes. Hence this is disabled by default.
+ *
+ * Labels are not merged by {@link #renderParallel}.
+ *
+ * @param value Whether this scene merges the text of its labels.
+ */
+void Scene2::setLabelBatching(bool value) {
+    if (value && _labelBatch == nullptr) {
+        _labelBatch = scene2::LabelBatch::alloc();
+    } else if (!value) {
+        _labelBatch = nullptr;
+    }
+}
+
 
 #pragma mark -
 #pragma mark Scene Graph
@@ -351,6 +426,65 @@ void Scene2::removeAllChildren() {
 
 #pragma mark -
 #pragma mark Rendering
+/**
+ * Updates the culling rectangle to match the current camera view.
+ *
+ * This also updates the culling frustum. This method should be called at
+ * the start of each render pass.
+ */
+void Scene2::updateCullRect() {
+    if (!_culling) {
+        return;
+    }
+    
+    // Unproject the corners of normalized device space
+    const Mat4& inverse = _camera->getInverseProjectView();
+    _cullFrustum.set(inverse);
+    Vec3 corner = inverse.transform(Vec3(-1,-1,0));
+    Vec2 min(corner.x,corner.y);
+    Vec2 max = min;
+    const float signs[3][2] = { {1,-1}, {-1,1}, {1,1} };
+    for(int ii = 0; ii < 3; ii++) {
+        corner = inverse.transform(Vec3(signs[ii][0],signs[ii][1],0));
+        min.x = std::min(min.x,corner.x); min.y = std::min(min.y,corner.y);
+        max.x = std::max(max.x,corner.x); max.y = std::max(max.y,corner.y);
+    }
+    _cullRect.set(min,max-min);
+}
+
+/**
+ * Draws the profiler overlay in the top left corner of the camera view.
+ *
+ * The overlay shows the statistics of the last complete profiler frame
+ * (see {@link scene2::Scene2Profiler}). The sprite batch must be active.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ */
+void Scene2::drawProfile(const std::shared_ptr<SpriteBatch>& batch) {
+    typedef scene2::Scene2Profiler Profiler;
+    const Profiler::FrameStats& stats = Profiler::getFrameStats();
+    const std::vector<Profiler::Entry>& entries = Profiler::getEntries();
+
+    Vec3 corner = _camera->getInverseProjectView().transform(Vec3(-1,1,0));
+    Vec2 pos(corner.x+PROFILE_MARGIN,corner.y-PROFILE_MARGIN-_profileFont->getAscent());
+    float skip = (float)_profileFont->getLineSkip();
+
+    char line[256];
+    snprintf(line, sizeof(line), "frame %.2f ms  calls %u  verts %u  states %u  flush %.2f ms",
+             stats.duration/1000.0f, stats.calls, stats.vertices, stats.states, stats.flush/1000.0f);
+    batch->setColor(Color4::WHITE);
+    batch->drawText(line, _profileFont, pos);
+    size_t amount = std::min(entries.size(),(size_t)PROFILE_LINES);
+    for(size_t ii = 0; ii < amount; ii++) {
+        const Profiler::Entry& entry = entries[ii];
+        pos.y -= skip;
+        snprintf(line, sizeof(line), "%-8s %-24s %7.3f ms self %7.3f ms total (x%u)",
+                 Profiler::getCategoryName(entry.category), entry.name.c_str(),
+                 entry.self/1000.0f, entry.total/1000.0f, entry.calls);
+        batch->drawText(line, _profileFont, pos);
+    }
+}
+
 /**
  * Draws all of the children in this scene with the given SpriteBatch.
  *
@@ -366,14 +500,327 @@ void Scene2::removeAllChildren() {
  * @param batch     The SpriteBatch to draw with.
  */
 void Scene2::render(const std::shared_ptr<SpriteBatch>& batch) {
+    updateCullRect();
     batch->begin(_camera->getCombined());
     batch->setSrcBlendFunc(_srcFactor);
     batch->setDstBlendFunc(_dstFactor);
     batch->setBlendEquation(_blendEquation);
 
+    if (_labelBatch != nullptr) {
+        _labelBatch->begin(batch);
+    }
     for(auto it = _children.begin(); it != _children.end(); ++it) {
         (*it)->render(batch, Affine2::IDENTITY, _color);
     }
+    if (_labelBatch != nullptr) {
+        _labelBatch->end();
+    }
+    if (_profileFont != nullptr && scene2::Scene2Profiler::isEnabled()) {
+        drawProfile(batch);
+    }
+
+    batch->end();
+    if (_targets != nullptr) {
+        _targets->advance();
+    }
+}
 
+/**
+ * Draws all of the children in this scene, recording them in parallel.
+ *
+ * This method is identical to {@link #render}, except that the children
+ * are split into (at most) the given number of contiguous groups. Each
+ * group is traversed on the thread pool (or this thread), drawing to its
+ * own recording sprite batch (see {@link SpriteBatch#initRecorder}). The
+ * recordings are then replayed to the given sprite batch in the order of
+ * the children. So the result is the same as {@link #render}, and all
+ * OpenGL calls still take place on this thread. This method blocks until
+ * every group is recorded.
+ *
+ * This is only safe if the children are independent, and if their draw
+ * methods only use the sprite batch. In particular, no node may be
+ * modified (or lazily build OpenGL resources) while the scene renders.
+ * The sprite batch must not be active, and the recordings are reused on
+ * the next call to this method.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ * @param pool      The thread pool to record with.
+ * @param tasks     The maximum number of groups to record in parallel.
+ */
+void Scene2::renderParallel(const std::shared_ptr<SpriteBatch>& batch,
+                            const std::shared_ptr<ThreadPool>& pool, Uint32 tasks) {
+    size_t groups = std::min((size_t)tasks,_children.size());
+    if (pool == nullptr || groups <= 1) {
+        render(batch);
+        return;
+    }
+    
+    updateCullRect();
+    while (_recorders.size() < groups) {
+        _recorders.push_back(SpriteBatch::allocRecorder());
+    }
+    
+    // The calling thread records groups as well
+    size_t total = _children.size();
+    pool->parallelFor(groups,1,[&](size_t first, size_t last) {
+        for(size_t ii = first; ii < last; ii++) {
+            SpriteBatch* recorder = _recorders[ii].get();
+            recorder->begin();
+            recorder->setSrcBlendFunc(_srcFactor);
+            recorder->setDstBlendFunc(_dstFactor);
+            recorder->setBlendEquation(_blendEquation);
+            for(size_t jj = (ii*total)/groups; jj < ((ii+1)*total)/groups; jj++) {
+                _children[jj]->render(_recorders[ii], Affine2::IDENTITY, _color);
+            }
+            recorder->end();
+        }
+    });
+    
+    // Replay in order so that the result does not depend on the threads
+    batch->begin(_camera->getCombined());
+    batch->setSrcBlendFunc(_srcFactor);
+    batch->setDstBlendFunc(_dstFactor);
+    batch->setBlendEquation(_blendEquation);
+    for(size_t ii = 0; ii < groups; ii++) {
+        batch->replay(_recorders[ii]);
+    }
+    if (_profileFont != nullptr && scene2::Scene2Profiler::isEnabled()) {
+        drawProfile(batch);
+    }
     batch->end();
+    if (_targets != nullptr) {
+        _targets->advance();
+    }
+}
+
+#pragma mark -
+#pragma mark Picking
+/**
+ * Sets the size of a pick grid cell in world coordinates.
+ *
+ * The pick grid is a spatial index of the interactive nodes in this scene
+ * (see {@link scene2::SceneNode#setInteractive}). Each interactive node is
+ * stored in every cell that its bounding box overlaps, and the cells are
+ * only updated when the node (or one of its ancestors) is transformed.
+ * Hence {@link #pick} only tests the nodes in a single cell. A value of 0
+ * means that there is no grid, and every interactive node is tested.
+ *
+ * A good cell size is about the size of a typical interactive node.
+ *
+ * @param size  The size of a pick grid cell in world coordinates.
+ */
+void Scene2::setPickGrid(float size) {
+    CUAssertLog(size >= 0, "Pick grid size %.3f is invalid", size);
+    _pickCell = size;
+    _pickGrid.clear();
+    _pickRanges.clear();
+    _pickDirty.clear();
+    if (_pickCell > 0) {
+        _pickDirty.insert(_pickables.begin(),_pickables.end());
+    }
+}
+
+/**
+ * Returns the topmost interactive node containing the given world point.
+ *
+ * A node contains a point if the point is inside its content bounds, and
+ * the node and all of its ancestors are visible. If several nodes contain
+ * the point, this method returns the one drawn last in a pre-order
+ * traversal. It returns nullptr if no interactive node contains the point.
+ *
+ * @param point     The point in world coordinates
+ *
+ * @return the topmost interactive node containing the given world point.
+ */
+std::shared_ptr<scene2::SceneNode> Scene2::pick(const Vec2 point) {
+    const std::vector<scene2::SceneNode*>* candidates = nullptr;
+    std::vector<scene2::SceneNode*> everything;
+    if (_pickCell > 0) {
+        updatePickGrid();
+        auto it = _pickGrid.find(pick_key((int)floorf(point.x/_pickCell),
+                                          (int)floorf(point.y/_pickCell)));
+        if (it == _pickGrid.end()) {
+            return nullptr;
+        }
+        candidates = &(it->second);
+    } else {
+        everything.assign(_pickables.begin(),_pickables.end());
+        candidates = &everything;
+    }
+    
+    scene2::SceneNode* result = nullptr;
+    for(auto it = candidates->begin(); it != candidates->end(); ++it) {
+        scene2::SceneNode* node = *it;
+        Vec2 local = node->worldToNodeCoords(point);
+        if (Rect(Vec2::ZERO,node->getContentSize()).contains(local) && pick_visible(node)) {
+            if (result == nullptr || drawsBefore(result,node)) {
+                result = node;
+            }
+        }
+    }
+    return result == nullptr ? nullptr : result->shared_from_this();
+}
+
+/**
+ * Returns true if the given node might contain the given world point.
+ *
+ * This is a fast rejection test for input handlers. It returns false
+ * only if the node is interactive, and the pick grid shows that it is
+ * nowhere near the point. A true result must be confirmed with an exact
+ * test of the node bounds.
+ *
+ * @param node      The node to test
+ * @param point     The point in world coordinates
+ *
+ * @return true if the given node might contain the given world point.
+ */
+bool Scene2::mayPick(const scene2::SceneNode* node, const Vec2 point) {
+    scene2::SceneNode* key = const_cast<scene2::SceneNode*>(node);
+    if (_pickCell <= 0 || _pickables.find(key) == _pickables.end()) {
+        return true;
+    }
+    updatePickGrid();
+    auto it = _pickRanges.find(key);
+    if (it == _pickRanges.end()) {
+        return true;
+    }
+    int col = (int)floorf(point.x/_pickCell);
+    int row = (int)floorf(point.y/_pickCell);
+    const PickCells& cells = it->second;
+    return cells.left <= col && col <= cells.right && cells.bottom <= row && row <= cells.top;
+}
+
+/**
+ * Adds an interactive node to the pick index.
+ *
+ * @param node  The interactive node
+ */
+void Scene2::addPickable(scene2::SceneNode* node) {
+    _pickables.emplace(node);
+    if (_pickCell > 0) {
+        _pickDirty.emplace(node);
+    }
+}
+
+/**
+ * Removes an interactive node from the pick index.
+ *
+ * @param node  The interactive node
+ */
+void Scene2::removePickable(scene2::SceneNode* node) {
+    unlinkPickable(node);
+    _pickables.erase(node);
+    _pickDirty.erase(node);
+}
+
+/**
+ * Removes an interactive node from all of its grid cells.
+ *
+ * @param node  The interactive node
+ */
+void Scene2::unlinkPickable(scene2::SceneNode* node) {
+    auto it = _pickRanges.find(node);
+    if (it == _pickRanges.end()) {
+        return;
+    }
+    const PickCells& cells = it->second;
+    for(int col = cells.left; col <= cells.right; col++) {
+        for(int row = cells.bottom; row <= cells.top; row++) {
+            auto jt = _pickGrid.find(pick_key(col,row));
+            if (jt != _pickGrid.end()) {
+                std::vector<scene2::SceneNode*>& nodes = jt->second;
+                nodes.erase(std::remove(nodes.begin(), nodes.end(), node), nodes.end());
+                if (nodes.empty()) {
+                    _pickGrid.erase(jt);
+                }
+            }
+        }
+    }
+    _pickRanges.erase(it);
+}
+
+/**
+ * Recomputes the grid cells of all out of date interactive nodes.
+ */
+void Scene2::updatePickGrid() {
+    for(auto it = _pickDirty.begin(); it != _pickDirty.end(); ++it) {
+        scene2::SceneNode* node = *it;
+        unlinkPickable(node);
+        
+        Rect bounds(Vec2::ZERO,node->getContentSize());
+        bounds = node->getNodeToWorldTransform().transform(bounds);
+        PickCells cells;
+        cells.left   = (int)floorf(bounds.getMinX()/_pickCell);
+        cells.bottom = (int)floorf(bounds.getMinY()/_pickCell);
+        cells.right  = (int)floorf(bounds.getMaxX()/_pickCell);
+        cells.top    = (int)floorf(bounds.getMaxY()/_pickCell);
+        for(int col = cells.left; col <= cells.right; col++) {
+            for(int row = cells.bottom; row <= cells.top; row++) {
+                _pickGrid[pick_key(col,row)].push_back(node);
+            }
+        }
+        _pickRanges[node] = cells;
+    }
+    _pickDirty.clear();
+}
+
+/**
+ * Returns true if node a is drawn before node b in a pre-order traversal.
+ *
+ * @param a     The first node
+ * @param b     The second node
+ *
+ * @return true if node a is drawn before node b in a pre-order traversal.
+ */
+bool Scene2::drawsBefore(const scene2::SceneNode* a, const scene2::SceneNode* b) const {
+    std::vector<const scene2::SceneNode*> pathA;
+    std::vector<const scene2::SceneNode*> pathB;
+    for(; a != nullptr; a = a->getParent()) { pathA.push_back(a); }
+    for(; b != nullptr; b = b->getParent()) { pathB.push_back(b); }
+    
+    // Walk down from the roots to where the paths split
+    auto ita = pathA.rbegin();
+    auto itb = pathB.rbegin();
+    while (ita != pathA.rend() && itb != pathB.rend() && *ita == *itb) {
+        ++ita;
+        ++itb;
+    }
+    if (ita == pathA.rend()) {
+        return true;   // a is an ancestor of b
+    } else if (itb == pathB.rend()) {
+        return false;  // b is an ancestor of a
+    }
+    return (*ita)->_childOffset < (*itb)->_childOffset;
+}
+
+/**
+ * Returns a render target at least the given size for a cached subtree.
+ *
+ * The size is rounded up so that targets can be shared by subtrees of
+ * similar size. An idle target of that size is reused if possible.
+ * This method returns nullptr if the target could not be allocated.
+ *
+ * @param width     The minimum width in pixels
+ * @param height    The minimum height in pixels
+ *
+ * @return a render target at least the given size for a cached subtree.
+ */
+std::shared_ptr<RenderTarget> Scene2::acquireTarget(Uint32 width, Uint32 height) {
+    if (_targets == nullptr) {
+        _targets = RenderTargetPool::alloc();
+    }
+    width  = ((width +TARGET_GRAIN-1)/TARGET_GRAIN)*TARGET_GRAIN;
+    height = ((height+TARGET_GRAIN-1)/TARGET_GRAIN)*TARGET_GRAIN;
+    return _targets->acquire(width,height);
+}
+
+/**
+ * Returns a render target to the pool of idle targets.
+ *
+ * @param target    The render target to release
+ */
+void Scene2::releaseTarget(const std::shared_ptr<RenderTarget>& target) {
+    if (_targets != nullptr) {
+        _targets->release(target);
+    }
 }
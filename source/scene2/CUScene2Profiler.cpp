@@ -0,0 +1,493 @@
+//
+//  CUScene2Profiler.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides an opt-in hierarchical profiler for the scene graph.
+//  When enabled, the scene graph times the rendering, layout, and actions of
+//  each node, aggregating the results per named node and per frame. The
+//  results can be shown as an overlay in a Scene2 (see Scene2#setProfileFont)
+//  or saved as a Chrome trace (chrome://tracing or https://ui.perfetto.dev).
+//
+//  This class is a static class. It has no constructors, and all of its
+//  methods are static. The profiler only records on the thread that began
+//  the current frame, so it does not record parallel rendering.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/scene2/CUScene2Profiler.h>
+#include <cugl/scene2/graph/CUSceneNode.h>
+#include <cugl/render/CUSpriteBatch.h>
+#include <cugl/assets/CUJsonValue.h>
+#include <cugl/io/CUJsonWriter.h>
+#include <cugl/util/CUTimestamp.h>
+#include <cugl/util/CUDebug.h>
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <deque>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+/** The number of scope categories */
+#define PROFILE_CATEGORIES  4
+/** The default number of recent frames kept for tracing */
+#define DEFAULT_TRACE_FRAMES    120
+
+/**
+ * An open profiler scope
+ */
+class OpenScope {
+public:
+    /** The index of the aggregated entry */
+    size_t entry;
+    /** The start time in microseconds (relative to the profiler origin) */
+    Uint64 start;
+    /** The time spent in nested scopes */
+    Uint64 nested;
+};
+
+/**
+ * A completed scope of a traced frame
+ */
+class TraceEvent {
+public:
+    /** The index of the aggregated entry (in the frame) */
+    size_t entry;
+    /** The start time in microseconds (relative to the profiler origin) */
+    Uint64 start;
+    /** The duration in microseconds */
+    Uint64 duration;
+};
+
+/**
+ * A frame kept for tracing
+ */
+class TraceFrame {
+public:
+    /** The aggregated entries of this frame (for the event names) */
+    std::vector<Scene2Profiler::Entry> entries;
+    /** The completed scopes of this frame */
+    std::vector<TraceEvent> events;
+    /** The statistics of this frame */
+    Scene2Profiler::FrameStats stats;
+    /** The end time in microseconds (relative to the profiler origin) */
+    Uint64 end;
+};
+
+/**
+ * The state of the profiler
+ */
+class ProfilerState {
+public:
+    /** The time that all scopes are measured against */
+    Timestamp origin;
+    /** The thread that began the current frame */
+    std::thread::id owner;
+    /** Whether a frame is in progress */
+    bool active;
+    /** The number of the current frame */
+    Uint64 frame;
+    /** The start of the current frame */
+    Uint64 start;
+    /** The open scopes, innermost last */
+    std::vector<OpenScope> stack;
+    /** The aggregated entries of the current frame */
+    std::vector<Scene2Profiler::Entry> entries;
+    /** The entry index of each scope name, per category */
+    std::unordered_map<std::string, size_t> index[PROFILE_CATEGORIES];
+    /** The completed scopes of the current frame (if tracing) */
+    std::vector<TraceEvent> events;
+    /** The sorted entries of the last complete frame */
+    std::vector<Scene2Profiler::Entry> results;
+    /** The statistics of the last complete frame */
+    Scene2Profiler::FrameStats stats;
+    /** The recent frames for tracing */
+    std::deque<TraceFrame> trace;
+    /** The number of recent frames kept for tracing */
+    size_t capacity;
+
+    /**
+     * Creates an idle profiler
+     */
+    ProfilerState() : active(false), frame(0), start(0), capacity(DEFAULT_TRACE_FRAMES) {}
+
+    /**
+     * Returns the microseconds since the profiler origin
+     *
+     * @return the microseconds since the profiler origin
+     */
+    Uint64 now() const {
+        return Timestamp::ellapsedMicros(origin,Timestamp());
+    }
+
+    /**
+     * Resets the current frame
+     */
+    void reset() {
+        active = false;
+        stack.clear();
+        entries.clear();
+        events.clear();
+        for(int ii = 0; ii < PROFILE_CATEGORIES; ii++) {
+            index[ii].clear();
+        }
+    }
+};
+
+/**
+ * Returns the profiler state
+ *
+ * @return the profiler state
+ */
+static ProfilerState& profiler_state() {
+    static ProfilerState state;
+    return state;
+}
+
+/** Whether the profiler is enabled */
+bool Scene2Profiler::_enabled = false;
+
+#pragma mark -
+#pragma mark Scopes
+/**
+ * Returns true if a scope with the given category and name was opened
+ *
+ * This method fails if called outside of a frame, or on a thread other
+ * than the one that began the frame.
+ *
+ * @param category  The scope category
+ * @param name      The scope name
+ *
+ * @return true if a scope with the given category and name was opened
+ */
+bool Scene2Profiler::push(Category category, const std::string& name) {
+    ProfilerState& state = profiler_state();
+    if (!state.active || std::this_thread::get_id() != state.owner) {
+        return false;
+    }
+
+    auto& index = state.index[(int)category];
+    auto it = index.find(name);
+    size_t entry;
+    if (it == index.end()) {
+        entry = state.entries.size();
+        index.emplace(name,entry);
+        Entry record;
+        record.name = name;
+        record.category = category;
+        record.total = 0;
+        record.self  = 0;
+        record.calls = 0;
+        state.entries.push_back(record);
+    } else {
+        entry = it->second;
+    }
+
+    OpenScope scope;
+    scope.entry  = entry;
+    scope.nested = 0;
+    scope.start  = state.now();
+    state.stack.push_back(scope);
+    return true;
+}
+
+/**
+ * Returns true if a scope for the given scene graph node was opened
+ *
+ * This method fails if called outside of a frame, or on a thread other
+ * than the one that began the frame.
+ *
+ * @param category  The scope category
+ * @param node      The node being timed
+ *
+ * @return true if a scope for the given scene graph node was opened
+ */
+bool Scene2Profiler::push(Category category, const SceneNode* node) {
+    const std::string name = node->getName();
+    return push(category, name.empty() ? node->getClassName() : name);
+}
+
+/**
+ * Closes the innermost profiler scope
+ */
+void Scene2Profiler::pop() {
+    ProfilerState& state = profiler_state();
+    if (state.stack.empty()) {
+        // The frame was abandoned while this scope was open
+        return;
+    }
+
+    OpenScope scope = state.stack.back();
+    state.stack.pop_back();
+    Uint64 duration = state.now()-scope.start;
+    Entry& entry = state.entries[scope.entry];
+    entry.total += duration;
+    entry.self  += duration-std::min(duration,scope.nested);
+    entry.calls++;
+    if (!state.stack.empty()) {
+        state.stack.back().nested += duration;
+    }
+    if (state.capacity) {
+        TraceEvent event;
+        event.entry = scope.entry;
+        event.start = scope.start;
+        event.duration = duration;
+        state.events.push_back(event);
+    }
+}
+
+#pragma mark -
+#pragma mark Activation
+/**
+ * Sets whether the profiler is enabled
+ *
+ * Disabling the profiler in the middle of a frame abandons that frame.
+ *
+ * @param flag  Whether the profiler is enabled
+ */
+void Scene2Profiler::setEnabled(bool flag) {
+    if (_enabled && !flag) {
+        profiler_state().reset();
+    }
+    _enabled = flag;
+}
+
+/**
+ * Starts a new profiler frame
+ *
+ * This should be called once per animation frame, typically at the start
+ * of the update. The profiler records scopes on this thread until the
+ * next call to {@link #endFrame}. This method does nothing if the
+ * profiler is disabled.
+ */
+void Scene2Profiler::beginFrame() {
+    if (!_enabled) {
+        return;
+    }
+    ProfilerState& state = profiler_state();
+    CUAssertLog(state.stack.empty(), "Profiler frame started with open scopes");
+    state.reset();
+    state.owner = std::this_thread::get_id();
+    state.start = state.now();
+    state.active = true;
+}
+
+/**
+ * Completes the current profiler frame
+ *
+ * The sprite batch statistics are read from the given batch, which should
+ * be the one that rendered the frame. As these statistics are reset by
+ * {@link SpriteBatch#begin}, this method should be called after the last
+ * drawing pass of the frame. The batch may be nullptr. This method does
+ * nothing if no frame was started.
+ *
+ * @param batch The sprite batch that rendered this frame
+ */
+void Scene2Profiler::endFrame(const std::shared_ptr<SpriteBatch>& batch) {
+    ProfilerState& state = profiler_state();
+    if (!state.active) {
+        return;
+    }
+
+    Uint64 end = state.now();
+    FrameStats stats;
+    stats.frame = state.frame++;
+    stats.duration = end-state.start;
+    if (batch != nullptr) {
+        stats.calls = batch->getCallsMade();
+        stats.vertices = batch->getVerticesDrawn();
+        stats.states = batch->getStateChanges();
+        stats.flush = batch->getFlushTime();
+    }
+    state.stats = stats;
+    state.results = state.entries;
+    std::sort(state.results.begin(), state.results.end(), [](const Entry& a, const Entry& b) {
+        return a.self > b.self;
+    });
+
+    if (state.capacity) {
+        TraceFrame frame;
+        frame.entries.swap(state.entries);
+        frame.events.swap(state.events);
+        frame.stats = stats;
+        frame.end = end;
+        state.trace.push_back(std::move(frame));
+        while (state.trace.size() > state.capacity) {
+            state.trace.pop_front();
+        }
+    }
+    state.reset();
+}
+
+#pragma mark -
+#pragma mark Statistics
+/**
+ * Returns the aggregated scopes of the most recent complete frame
+ *
+ * The entries are sorted from the largest to the smallest self time.
+ *
+ * @return the aggregated scopes of the most recent complete frame
+ */
+const std::vector<Scene2Profiler::Entry>& Scene2Profiler::getEntries() {
+    return profiler_state().results;
+}
+
+/**
+ * Returns the statistics of the most recent complete frame
+ *
+ * @return the statistics of the most recent complete frame
+ */
+const Scene2Profiler::FrameStats& Scene2Profiler::getFrameStats() {
+    return profiler_state().stats;
+}
+
+/**
+ * Returns the name of the given category
+ *
+ * @param category  The scope category
+ *
+ * @return the name of the given category
+ */
+const char* Scene2Profiler::getCategoryName(Category category) {
+    switch (category) {
+        case Category::RENDER:
+            return "render";
+        case Category::LAYOUT:
+            return "layout";
+        case Category::ACTIONS:
+            return "actions";
+        case Category::USER:
+            return "user";
+    }
+    return "unknown";
+}
+
+#pragma mark -
+#pragma mark Tracing
+/**
+ * Returns the number of recent frames kept for tracing
+ *
+ * By default this value is 120.
+ *
+ * @return the number of recent frames kept for tracing
+ */
+size_t Scene2Profiler::getTraceCapacity() {
+    return profiler_state().capacity;
+}
+
+/**
+ * Sets the number of recent frames kept for tracing
+ *
+ * Every scope of a traced frame is kept, so large scenes should use a
+ * small value. A value of 0 disables tracing. By default this value is 120.
+ *
+ * @param frames    The number of recent frames kept for tracing
+ */
+void Scene2Profiler::setTraceCapacity(size_t frames) {
+    ProfilerState& state = profiler_state();
+    state.capacity = frames;
+    while (state.trace.size() > frames) {
+        state.trace.pop_front();
+    }
+    if (!frames) {
+        state.events.clear();
+    }
+}
+
+/**
+ * Returns the recent frames as a Chrome trace
+ *
+ * The trace is a JSON object in the Trace Event Format. Each scope is a
+ * complete ("X") event, and the sprite batch statistics of each frame are
+ * counter ("C") events.
+ *
+ * @return the recent frames as a Chrome trace
+ */
+std::shared_ptr<JsonValue> Scene2Profiler::getTrace() {
+    ProfilerState& state = profiler_state();
+    std::shared_ptr<JsonValue> events = JsonValue::allocArray();
+    for(auto it = state.trace.begin(); it != state.trace.end(); ++it) {
+        for(auto jt = it->events.begin(); jt != it->events.end(); ++jt) {
+            const Entry& entry = it->entries[jt->entry];
+            std::shared_ptr<JsonValue> event = JsonValue::allocObject();
+            event->appendValue("name", entry.name);
+            event->appendValue("cat", std::string(getCategoryName(entry.category)));
+            event->appendValue("ph", std::string("X"));
+            event->appendValue("ts", (double)jt->start);
+            event->appendValue("dur", (double)jt->duration);
+            event->appendValue("pid", 1L);
+            event->appendValue("tid", 1L);
+            events->appendChild(event);
+        }
+
+        std::shared_ptr<JsonValue> counter = JsonValue::allocObject();
+        counter->appendValue("name", std::string("SpriteBatch"));
+        counter->appendValue("ph", std::string("C"));
+        counter->appendValue("ts", (double)it->end);
+        counter->appendValue("pid", 1L);
+        std::shared_ptr<JsonValue> args = JsonValue::allocObject();
+        args->appendValue("calls", (long)it->stats.calls);
+        args->appendValue("vertices", (long)it->stats.vertices);
+        args->appendValue("states", (long)it->stats.states);
+        args->appendValue("flush", (double)it->stats.flush);
+        counter->appendChild("args", args);
+        events->appendChild(counter);
+    }
+
+    std::shared_ptr<JsonValue> result = JsonValue::allocObject();
+    result->appendChild("traceEvents", events);
+    result->appendValue("displayTimeUnit", std::string("ms"));
+    return result;
+}
+
+/**
+ * Returns true if the recent frames were saved as a Chrome trace
+ *
+ * The file can be opened with chrome://tracing or https://ui.perfetto.dev.
+ *
+ * @param path  The file to write
+ *
+ * @return true if the recent frames were saved as a Chrome trace
+ */
+bool Scene2Profiler::writeTrace(const std::string& path) {
+    std::shared_ptr<JsonWriter> writer = JsonWriter::alloc(path);
+    if (writer == nullptr) {
+        CULogError("Could not write the profiler trace to '%s'", path.c_str());
+        return false;
+    }
+    writer->writeJson(getTrace(), false);
+    writer->close();
+    return true;
+}
+
+/**
+ * Deletes all frame statistics and traced frames
+ */
+void Scene2Profiler::clear() {
+    ProfilerState& state = profiler_state();
+    state.reset();
+    state.results.clear();
+    state.stats = FrameStats();
+    state.trace.clear();
+}
@@ -54,6 +54,7 @@ using namespace cugl;
  * the heap, use one of the static constructors instead.
  */
 Scene2Texture::Scene2Texture() : Scene2() {
+    _offscreen = true;
 }
   
 /**
@@ -113,6 +114,7 @@ bool Scene2Texture::init(float x, float y, float width, float height) {
  * @param batch     The SpriteBatch to draw with.
  */
 void Scene2Texture::render(const std::shared_ptr<SpriteBatch>& batch) {
+    updateCullRect();
     Affine2 matrix = _camera->getCombined();
     matrix.scale(1, -1); // Flip the y axis for texture write
     
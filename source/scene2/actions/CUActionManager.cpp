@@ -39,10 +39,27 @@
 //  Version: 12/12/22
 //
 #include <cugl/scene2/actions/CUActionManager.h>
+#include <cugl/scene2/CUScene2Profiler.h>
+#include <cstring>
 
 using namespace cugl;
 using namespace cugl::scene2;
 
+/** The number of easing function types */
+#define EASING_TYPES ((int)EasingFunction::Type::ELASTIC_IN_OUT+1)
+
+/**
+ * Returns the handle for the given slot and generation
+ *
+ * @param slot          The handle slot
+ * @param generation    The slot generation
+ *
+ * @return the handle for the given slot and generation
+ */
+static Uint64 make_handle(Uint32 slot, Uint32 generation) {
+    return ((Uint64)generation << 32) | (Uint64)slot;
+}
+
 /**
  * Disposes all of the resources used by this action manager.
  *
@@ -50,12 +67,19 @@ using namespace cugl::scene2;
  * action manager will be released.They will be deleted if no other object owns them.
  */
 void ActionManager::dispose() {
-    _keys.clear();
-    for(auto it = _actions.begin(); it != _actions.end(); ++it) {
-        delete it->second;
-        it->second = nullptr;
+    while (!_actions.empty()) {
+        release(_actions.back());
+    }
+    for(auto it = _recycled.begin(); it != _recycled.end(); ++it) {
+        delete *it;
+        *it = nullptr;
     }
-    _actions.clear();
+    _recycled.clear();
+    _slots.clear();
+    _generations.clear();
+    _freeslots.clear();
+    _keys.clear();
+    _targets.clear();
 }
 
 /**
@@ -67,6 +91,137 @@ ActionManager::ActionInstance::~ActionInstance() {
     target = nullptr;
 }
 
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns the animation for the given handle
+ *
+ * This method returns nullptr if the handle is not active.
+ *
+ * @param handle    The animation handle
+ *
+ * @return the animation for the given handle
+ */
+ActionManager::ActionInstance* ActionManager::lookup(Uint64 handle) const {
+    Uint32 slot = (Uint32)(handle & 0xFFFFFFFF);
+    Uint32 generation = (Uint32)(handle >> 32);
+    if (slot >= _slots.size() || _generations[slot] != generation) {
+        return nullptr;
+    }
+    return _slots[slot];
+}
+
+/**
+ * Returns the animation for the given string key
+ *
+ * This method returns nullptr if the key is not active.
+ *
+ * @param key       The identifying key
+ *
+ * @return the animation for the given string key
+ */
+ActionManager::ActionInstance* ActionManager::lookup(const std::string& key) const {
+    auto it = _keys.find(key);
+    return (it == _keys.end() ? nullptr : lookup(it->second));
+}
+
+/**
+ * Returns a newly started animation with the given target and action
+ *
+ * The animation is assigned a fresh handle, but no string key.
+ *
+ * @param action    The action to animate with
+ * @param target    The node to animate on
+ * @param easing    The easing (interpolation) function
+ *
+ * @return a newly started animation with the given target and action
+ */
+ActionManager::ActionInstance* ActionManager::acquire(const std::shared_ptr<Action>& action,
+                                                      const std::shared_ptr<SceneNode>& target,
+                                                      std::function<float(float)> easing) {
+    ActionInstance* instance;
+    if (_recycled.empty()) {
+        instance = new ActionInstance();
+    } else {
+        instance = _recycled.back();
+        _recycled.pop_back();
+    }
+
+    Uint32 slot;
+    if (_freeslots.empty()) {
+        slot = (Uint32)_slots.size();
+        _slots.push_back(nullptr);
+        _generations.push_back(1);
+    } else {
+        slot = _freeslots.back();
+        _freeslots.pop_back();
+    }
+    _slots[slot] = instance;
+
+    instance->handle = make_handle(slot,_generations[slot]);
+    instance->index = _actions.size();
+    instance->action = action;
+    instance->target = target;
+    instance->interpolant = easing;
+    instance->easing = EasingFunction::Type::LINEAR;
+    instance->batched = false;
+    instance->state = NULL;
+    instance->duration = 0.0f;
+    instance->elapsed  = 0.0f;
+    instance->paused = false;
+    action->start(target, &(instance->state));
+
+    _actions.push_back(instance);
+    _targets[target.get()].push_back(instance->handle);
+    return instance;
+}
+
+/**
+ * Stops the given animation and recycles its instance
+ *
+ * The handle (and string key) of this animation become inactive.
+ *
+ * @param instance  The animation to stop
+ */
+void ActionManager::release(ActionInstance* instance) {
+    instance->action->stop(instance->target, &(instance->state));
+
+    // Swap with the last animation to keep the array dense
+    ActionInstance* last = _actions.back();
+    _actions[instance->index] = last;
+    last->index = instance->index;
+    _actions.pop_back();
+
+    // Retire the handle so that it never matches again
+    Uint32 slot = (Uint32)(instance->handle & 0xFFFFFFFF);
+    _slots[slot] = nullptr;
+    _generations[slot] = (_generations[slot] == UINT32_MAX ? 1 : _generations[slot]+1);
+    _freeslots.push_back(slot);
+
+    if (!instance->key.empty()) {
+        _keys.erase(instance->key);
+        instance->key.clear();
+    }
+    auto set = _targets.find(instance->target.get());
+    if (set != _targets.end()) {
+        std::vector<Uint64>& handles = set->second;
+        auto pos = std::find(handles.begin(), handles.end(), instance->handle);
+        if (pos != handles.end()) {
+            *pos = handles.back();
+            handles.pop_back();
+        }
+        if (handles.empty()) {
+            _targets.erase(set);
+        }
+    }
+
+    instance->interpolant = nullptr;
+    instance->action = nullptr;
+    instance->target = nullptr;
+    instance->handle = 0;
+    _recycled.push_back(instance);
+}
+
 #pragma mark -
 #pragma mark Action Management
 /**
@@ -76,9 +231,8 @@ ActionManager::ActionInstance::~ActionInstance() {
  *
  * @return true if the given key represents an active animation
  */
-bool ActionManager::isActive(std::string key) const {
-    auto action = _actions.find(key);
-    return (action != _actions.end());
+bool ActionManager::isActive(const std::string& key) const {
+    return lookup(key) != nullptr;
 }
 
 /**
@@ -97,25 +251,113 @@ bool ActionManager::isActive(std::string key) const {
  *
  * @return true if the animation was successfully started
  */
-bool ActionManager::activate(std::string key,
+bool ActionManager::activate(const std::string& key,
                              const std::shared_ptr<Action>& action,
                              const std::shared_ptr<scene2::SceneNode>& target,
                              std::function<float(float)>easing) {
-    auto item = _actions.find(key);
-    if (item != _actions.end()) {
+    if (_keys.find(key) != _keys.end()) {
         return false;
     }
     
-    ActionInstance* instance = new ActionInstance();
-    instance->action = action;
-    instance->target = target;
-    instance->interpolant = easing;
-    action->start(target, &(instance->state));
-    _actions.emplace(key,instance);
-    _keys[target.get()].emplace(key);
+    ActionInstance* instance = acquire(action,target,easing);
+    instance->key = key;
+    _keys.emplace(key,instance->handle);
+    return true;
+}
+
+/**
+ * Actives an animation with the given target and action, returning its handle
+ *
+ * The easing function allows for effects like bouncing or elasticity in
+ * the linear interpolation. If null, the animation will use the standard
+ * linear easing.
+ *
+ * The animation has no string key. The handle should be used to pause or
+ * remove it instead. This is the fastest way to start an animation.
+ *
+ * @param action    The action to animate with
+ * @param target    The node to animate on
+ * @param easing    The easing (interpolation) function
+ *
+ * @return the handle of the new animation
+ */
+Uint64 ActionManager::activate(const std::shared_ptr<Action>& action,
+                               const std::shared_ptr<SceneNode>& target,
+                               std::function<float(float)> easing) {
+    return acquire(action,target,easing)->handle;
+}
+
+/**
+ * Actives an animation with the given target, action, and easing type
+ *
+ * Unlike an arbitrary easing function, a typed easing function is
+ * evaluated in batch with all other animations of the same type. This is
+ * the preferred way to ease large numbers of animations.
+ *
+ * This method will fail if the provided key is already in use.
+ *
+ * @param key       The identifying key
+ * @param action    The action to animate with
+ * @param target    The node to animate on
+ * @param easing    The easing function type
+ *
+ * @return true if the animation was successfully started
+ */
+bool ActionManager::activate(const std::string& key,
+                             const std::shared_ptr<Action>& action,
+                             const std::shared_ptr<SceneNode>& target,
+                             EasingFunction::Type easing) {
+    if (_keys.find(key) != _keys.end()) {
+        return false;
+    }
+
+    ActionInstance* instance = acquire(action,target,nullptr);
+    instance->easing = easing;
+    instance->batched = true;
+    instance->key = key;
+    _keys.emplace(key,instance->handle);
     return true;
 }
 
+/**
+ * Actives an animation with the given target, action, and easing type
+ *
+ * Unlike an arbitrary easing function, a typed easing function is
+ * evaluated in batch with all other animations of the same type. This is
+ * the preferred way to ease large numbers of animations.
+ *
+ * The animation has no string key. The handle should be used to pause or
+ * remove it instead.
+ *
+ * @param action    The action to animate with
+ * @param target    The node to animate on
+ * @param easing    The easing function type
+ *
+ * @return the handle of the new animation
+ */
+Uint64 ActionManager::activate(const std::shared_ptr<Action>& action,
+                               const std::shared_ptr<SceneNode>& target,
+                               EasingFunction::Type easing) {
+    ActionInstance* instance = acquire(action,target,nullptr);
+    instance->easing = easing;
+    instance->batched = true;
+    return instance->handle;
+}
+
+/**
+ * Returns the handle for the animation with the given key
+ *
+ * This method returns 0 if there is no active animation for the key.
+ *
+ * @param key       The identifying key
+ *
+ * @return the handle for the animation with the given key
+ */
+Uint64 ActionManager::getHandle(const std::string& key) const {
+    auto it = _keys.find(key);
+    return (it == _keys.end() ? 0 : it->second);
+}
+
 /**
  * Removes the animation for the given key.
  *
@@ -129,17 +371,34 @@ bool ActionManager::activate(std::string key,
  *
  * @return true if the animation was successfully removed
  */
-bool ActionManager::remove(std::string key) {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
+bool ActionManager::remove(const std::string& key) {
+    ActionInstance* instance = lookup(key);
+    if (instance == nullptr) {
         return false;
     }
-    ActionInstance* instance = action->second;
-    instance->action->stop(instance->target, &(instance->state));
-    _keys[instance->target.get()].erase(key);
-    delete instance;
-    action->second = nullptr;
-    _actions.erase(action);
+    release(instance);
+    return true;
+}
+
+/**
+ * Removes the animation for the given handle.
+ *
+ * This act will immediately stop the animation.  The animated node will
+ * continue to have whatever state it had when the animation stopped.
+ *
+ * If there is no animation for the give handle (e.g. the animation is
+ * complete) this method will return false.
+ *
+ * @param handle    The animation handle
+ *
+ * @return true if the animation was successfully removed
+ */
+bool ActionManager::remove(Uint64 handle) {
+    ActionInstance* instance = lookup(handle);
+    if (instance == nullptr) {
+        return false;
+    }
+    release(instance);
     return true;
 }
 
@@ -153,15 +412,26 @@ bool ActionManager::remove(std::string key) {
  * @param dt    The number of seconds to animate
  */
 void ActionManager::update(float dt) {
-    auto completed = std::vector<std::unordered_map<std::string,ActionInstance*>::iterator>();
-    for(auto it = _actions.begin(); it != _actions.end(); ++it) {
-        ActionInstance* instance = it->second;
-        Action* action = instance->action.get();
-        float current = 1.0;
-        float future  = 1.0;
-        if (action->getDuration() > 0) {
-            current = (instance->elapsed) / action->getDuration();
-            future  = (instance->elapsed+dt)/ action->getDuration();
+    Scene2Profiler::Scope scope(Scene2Profiler::Category::ACTIONS,"ActionManager");
+    size_t total = _actions.size();
+    _tweenStart.resize(total);
+    _tweenEnd.resize(total);
+
+    // Compute the linear tweening times, counting the batched easings
+    size_t counts[EASING_TYPES+1];
+    std::memset(counts, 0, sizeof(counts));
+    for(size_t ii = 0; ii < total; ii++) {
+        ActionInstance* instance = _actions[ii];
+        if (instance->paused) {
+            continue;
+        }
+
+        float duration = instance->action->getDuration();
+        float current = 1.0f;
+        float future  = 1.0f;
+        if (duration > 0) {
+            current = (instance->elapsed) / duration;
+            future  = (instance->elapsed+dt)/ duration;
             // Clamp to end
             if (future > 1.0f) {
                 future = 1.0f;
@@ -169,25 +439,75 @@ void ActionManager::update(float dt) {
         } else {
             current = 0.0f;
         }
-        
+
         if (instance->interpolant) {
             current = instance->interpolant(current);
             future  = instance->interpolant(future);
+        } else if (instance->batched && instance->easing != EasingFunction::Type::LINEAR) {
+            counts[(int)instance->easing+1]++;
+        }
+        _tweenStart[ii] = current;
+        _tweenEnd[ii] = future;
+    }
+
+    // Group the batched animations by easing type (a counting sort)
+    for(int ii = 1; ii <= EASING_TYPES; ii++) {
+        counts[ii] += counts[ii-1];
+    }
+    size_t batched = counts[EASING_TYPES];
+    if (batched > 0) {
+        _tweenOrder.resize(batched);
+        _tweenTimes.resize(2*batched);
+        size_t offsets[EASING_TYPES];
+        std::memcpy(offsets, counts, sizeof(offsets));
+        for(size_t ii = 0; ii < total; ii++) {
+            ActionInstance* instance = _actions[ii];
+            if (!instance->paused && !instance->interpolant &&
+                instance->batched && instance->easing != EasingFunction::Type::LINEAR) {
+                size_t pos = offsets[(int)instance->easing]++;
+                _tweenOrder[pos] = ii;
+                _tweenTimes[pos] = _tweenStart[ii];
+                _tweenTimes[pos+batched] = _tweenEnd[ii];
+            }
+        }
+
+        // Ease each group at once, start and end times together
+        for(int ii = 0; ii < EASING_TYPES; ii++) {
+            size_t first = counts[ii];
+            size_t count = counts[ii+1]-first;
+            if (count > 0) {
+                EasingFunction::Type type = (EasingFunction::Type)ii;
+                EasingFunction::evaluate(type, _tweenTimes.data()+first,
+                                         _tweenTimes.data()+first, count);
+                EasingFunction::evaluate(type, _tweenTimes.data()+first+batched,
+                                         _tweenTimes.data()+first+batched, count);
+            }
         }
-        
-        action->update(instance->target, instance->state, future-current);
+
+        for(size_t ii = 0; ii < batched; ii++) {
+            size_t pos = _tweenOrder[ii];
+            _tweenStart[pos] = _tweenTimes[ii];
+            _tweenEnd[pos] = _tweenTimes[ii+batched];
+        }
+    }
+
+    // Write the results back to the nodes
+    std::vector<ActionInstance*> completed;
+    for(size_t ii = 0; ii < total; ii++) {
+        ActionInstance* instance = _actions[ii];
+        if (instance->paused) {
+            continue;
+        }
+        Action* action = instance->action.get();
+        action->update(instance->target, instance->state, _tweenEnd[ii]-_tweenStart[ii]);
         instance->elapsed = instance->elapsed+dt;
         if (instance->elapsed >= action->getDuration()) {
-            completed.push_back(it);
+            completed.push_back(instance);
         }
     }
     
     for (auto it = completed.begin(); it != completed.end(); ++it) {
-        ActionInstance* instance = (*it)->second;
-        instance->action->stop(instance->target, &(instance->state));
-        delete instance;
-        (*it)->second = nullptr;
-        _actions.erase(*it);
+        release(*it);
     }
 }
 
@@ -204,12 +524,24 @@ void ActionManager::update(float dt) {
  *
  * @return true if the animation for the given key is paused
  */
-bool ActionManager::isPaused(std::string key) {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
-        return false;
-    }
-    return action->second->paused;
+bool ActionManager::isPaused(const std::string& key) {
+    ActionInstance* instance = lookup(key);
+    return instance != nullptr && instance->paused;
+}
+
+/**
+ * Returns true if the animation for the given handle is paused
+ *
+ * This method will return false if there is no active animation with the
+ * given handle.
+ *
+ * @param handle    The animation handle
+ *
+ * @return true if the animation for the given handle is paused
+ */
+bool ActionManager::isPaused(Uint64 handle) {
+    ActionInstance* instance = lookup(handle);
+    return instance != nullptr && instance->paused;
 }
 
 /**
@@ -220,14 +552,27 @@ bool ActionManager::isPaused(std::string key) {
  *
  * @param key       The identifying key
  */
-void ActionManager::pause(std::string key) {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
-        return;
+void ActionManager::pause(const std::string& key) {
+    ActionInstance* instance = lookup(key);
+    if (instance != nullptr) {
+        instance->paused = true;
     }
-    action->second->paused = true;
 }
 
+/**
+ * Pauses the animation for the given handle.
+ *
+ * If there is no active animation for the given handle, or if it is
+ * already paused, this method does nothing.
+ *
+ * @param handle    The animation handle
+ */
+void ActionManager::pause(Uint64 handle) {
+    ActionInstance* instance = lookup(handle);
+    if (instance != nullptr) {
+        instance->paused = true;
+    }
+}
 
 /**
  * Unpauses the animation for the given key.
@@ -237,12 +582,26 @@ void ActionManager::pause(std::string key) {
  *
  * @param key       The identifying key
  */
-void ActionManager::unpause(std::string key) {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
-        return;
+void ActionManager::unpause(const std::string& key) {
+    ActionInstance* instance = lookup(key);
+    if (instance != nullptr) {
+        instance->paused = false;
+    }
+}
+
+/**
+ * Unpauses the animation for the given handle.
+ *
+ * If there is no active animation for the given handle, or if it is not
+ * currently paused, this method does nothing.
+ *
+ * @param handle    The animation handle
+ */
+void ActionManager::unpause(Uint64 handle) {
+    ActionInstance* instance = lookup(handle);
+    if (instance != nullptr) {
+        instance->paused = false;
     }
-    action->second->paused = false;
 }
 
 
@@ -256,19 +615,18 @@ void ActionManager::unpause(std::string key) {
  * @param target    The node to stop animating
  */
 void ActionManager::clearAllActions(const std::shared_ptr<scene2::SceneNode>& target) {
-    auto set = _keys.find(target.get());
-    if (set == _keys.end()) {
+    auto set = _targets.find(target.get());
+    if (set == _targets.end()) {
         return;
     }
-    for(auto it = set->second.begin(); it != set->second.end(); ++it) {
-        auto action = _actions.find(*it);
-        if (action != _actions.end()) {
-            delete action->second;
-            action->second = nullptr;
-            _actions.erase(action);
+    // Releasing modifies the handle list, so copy it first
+    std::vector<Uint64> handles = set->second;
+    for(auto it = handles.begin(); it != handles.end(); ++it) {
+        ActionInstance* instance = lookup(*it);
+        if (instance != nullptr) {
+            release(instance);
         }
     }
-    _keys.erase(target.get());
 }
 
 /**
@@ -280,15 +638,12 @@ void ActionManager::clearAllActions(const std::shared_ptr<scene2::SceneNode>& ta
  * @param target    The node to pause animating
  */
 void ActionManager::pauseAllActions(const std::shared_ptr<scene2::SceneNode>& target) {
-    auto set = _keys.find(target.get());
-    if (set == _keys.end()) {
+    auto set = _targets.find(target.get());
+    if (set == _targets.end()) {
         return;
     }
     for(auto it = set->second.begin(); it != set->second.end(); ++it) {
-        auto action = _actions.find(*it);
-        if (action != _actions.end()) {
-            action->second->paused = true;
-        }
+        pause(*it);
     }
 }
 
@@ -301,15 +656,12 @@ void ActionManager::pauseAllActions(const std::shared_ptr<scene2::SceneNode>& ta
  * @param target    The node to pause animating
  */
 void ActionManager::unpauseAllActions(const std::shared_ptr<scene2::SceneNode>& target) {
-    auto set = _keys.find(target.get());
-    if (set == _keys.end()) {
+    auto set = _targets.find(target.get());
+    if (set == _targets.end()) {
         return;
     }
     for(auto it = set->second.begin(); it != set->second.end(); ++it) {
-        auto action = _actions.find(*it);
-        if (action != _actions.end()) {
-            action->second->paused = false;
-        }
+        unpause(*it);
     }
 }
 
@@ -317,7 +669,8 @@ void ActionManager::unpauseAllActions(const std::shared_ptr<scene2::SceneNode>&
  * Returns the keys for all active animations of the given target
  *
  * The returned vector is a copy of the keys.  Modifying it has no affect
- * on the underlying animation.
+ * on the underlying animation. Animations without a string key are not
+ * included (see {@link #getAllHandles}).
  *
  * @param target    The node to query animations
  *
@@ -325,16 +678,33 @@ void ActionManager::unpauseAllActions(const std::shared_ptr<scene2::SceneNode>&
  */
 std::vector<std::string> ActionManager::getAllActions(const std::shared_ptr<scene2::SceneNode>& target) const {
     std::vector<std::string> result;
-    auto set = _keys.find(target.get());
-    if (set == _keys.end()) {
-        return std::vector<std::string>();
+    auto set = _targets.find(target.get());
+    if (set == _targets.end()) {
+        return result;
     }
     for(auto it = set->second.begin(); it != set->second.end(); ++it) {
-        result.push_back(*it);
+        ActionInstance* instance = lookup(*it);
+        if (instance != nullptr && !instance->key.empty()) {
+            result.push_back(instance->key);
+        }
     }
     return result;
 }
 
-
-
-
+/**
+ * Returns the handles for all active animations of the given target
+ *
+ * The returned vector is a copy of the handles.  Modifying it has no
+ * affect on the underlying animation.
+ *
+ * @param target    The node to query animations
+ *
+ * @return the handles for all active animations of the given target
+ */
+std::vector<Uint64> ActionManager::getAllHandles(const std::shared_ptr<scene2::SceneNode>& target) const {
+    auto set = _targets.find(target.get());
+    if (set == _targets.end()) {
+        return std::vector<Uint64>();
+    }
+    return set->second;
+}
@@ -65,6 +65,8 @@ using namespace cugl::scene2;
 #define MIN_TOLERANCE   0.005f
 #define MAX_TOLERANCE   10000.0f
 #define KAPPA90         0.5522847493f    // Length proportional to radius of a cubic bezier handle for 90deg arcs.
+/** The maximum number of cached path extrusions before a sweep */
+#define TESSELLATION_LIMIT  512
 /**
  * Returns the sign (1, -1, or 0) of the given number
  *
@@ -752,6 +754,107 @@ enum PathOrientation {
     CW_CONCAVE
 };
 
+/**
+ * Returns the cache key for the given path extrusion
+ *
+ * @param stroke    Whether this is a stroke (as opposed to a fill fringe)
+ * @param path      The path to extrude
+ * @param params    The extrusion settings
+ * @param count     The number of extrusion settings
+ *
+ * @return the cache key for the given path extrusion
+ */
+static Uint64 tessellation_key(bool stroke, const Path2* path, const float* params, size_t count) {
+    // FNV-1a over the raw bytes
+    Uint64 hash = 14695981039346656037ULL;
+    auto mix = [&](const void* data, size_t size) {
+        const Uint8* bytes = static_cast<const Uint8*>(data);
+        for(size_t ii = 0; ii < size; ii++) {
+            hash ^= bytes[ii];
+            hash *= 1099511628211ULL;
+        }
+    };
+    Uint8 flags = (stroke ? 1 : 0) | (path->closed ? 2 : 0);
+    mix(&flags,sizeof(Uint8));
+    mix(params,count*sizeof(float));
+    mix(path->vertices.data(),path->vertices.size()*sizeof(Vec2));
+    return hash;
+}
+
+/**
+ * Appends the cached mesh to the given mesh with the given colors
+ *
+ * Cached meshes are white, with clear vertices on the outside of a fringe.
+ * These are recolored with the inner and outer colors, respectively.
+ *
+ * @param dst   The mesh to append to
+ * @param src   The cached mesh
+ * @param inner The packed interior color
+ * @param outer The packed exterior color
+ */
+static void append_tessellation(Mesh<SpriteVertex2>& dst, const Mesh<SpriteVertex2>& src,
+                                Uint32 inner, Uint32 outer) {
+    Uint32 offset = (Uint32)dst.vertices.size();
+    dst.vertices.reserve(offset+src.vertices.size());
+    for(auto it = src.vertices.begin(); it != src.vertices.end(); ++it) {
+        dst.vertices.push_back(*it);
+        dst.vertices.back().color = (Color4(it->color).a > 0 ? inner : outer);
+    }
+    dst.indices.reserve(dst.indices.size()+src.indices.size());
+    for(auto it = src.indices.begin(); it != src.indices.end(); ++it) {
+        dst.indices.push_back(*it+offset);
+    }
+}
+
+/**
+ * A cached extrusion of a single path
+ *
+ * Extruding strokes (and anti-aliasing fringes) is the most expensive
+ * part of a drawing command. Animated canvases typically redraw the same
+ * paths every frame, so these meshes are saved, indexed by the path
+ * geometry and the stroke settings.
+ */
+class CanvasNode::Tessellation {
+public:
+    /** Whether this is a stroke (as opposed to a fill fringe) */
+    bool stroke;
+    /** The extruded path */
+    Path2 path;
+    /** The extrusion settings (stroke width, fringe, mitre, cap, joint) */
+    float params[5];
+    /** The number of extrusion settings */
+    size_t count;
+    /** The stroke mesh (empty for a fill fringe) */
+    Mesh<SpriteVertex2> mesh;
+    /** The fringe mesh (empty if there is no fringe) */
+    Mesh<SpriteVertex2> border;
+    /** Whether this extrusion was used since the last sweep */
+    bool used;
+
+    /**
+     * Creates an empty extrusion
+     */
+    Tessellation() : stroke(false), count(0), used(true) {}
+
+    /**
+     * Returns true if this is an extrusion of the given path and settings
+     *
+     * This is necessary to rule out a hash collision.
+     *
+     * @param stroke    Whether this is a stroke (as opposed to a fill fringe)
+     * @param path      The path to extrude
+     * @param params    The extrusion settings
+     * @param count     The number of extrusion settings
+     *
+     * @return true if this is an extrusion of the given path and settings
+     */
+    bool matches(bool stroke, const Path2* path, const float* params, size_t count) const {
+        return (this->stroke == stroke && this->count == count && this->path.closed == path->closed &&
+                std::equal(params,params+count,this->params) &&
+                this->path.vertices == path->vertices);
+    }
+};
+
 
 /**
  * A single drawing canvas page
@@ -777,6 +880,8 @@ public:
     SplinePather flatner;
     /** A toold for extruding paths */
     SimpleExtruder extruder;
+    /** The stroke outlines for fringing (scratch space kept across frames) */
+    std::vector<Path2> outlines;
     /* The spline "workspace" for an uncommited path */
     Spline2 spline;
     /** Whether there is an uncommitted path */
@@ -896,6 +1001,7 @@ public:
         if (spline.size() > 0) {
             flatner.clear();
             flatner.set(&spline);
+            flatner.setScale(node->_pathscale);
             flatner.calculate();
 
             paths.push_back(new Path2());
@@ -958,6 +1064,110 @@ public:
         active = false;
     }
     
+    /**
+     * Returns the extrusion of the given path with the current settings
+     *
+     * A stroke extrusion contains the stroke mesh and its fringe. A fill
+     * extrusion only contains the anti-aliasing fringe. The result is cached
+     * in the canvas node, and is only computed if there is no cached copy.
+     *
+     * @param stroke    Whether this is a stroke (as opposed to a fill fringe)
+     * @param path      The path to extrude
+     * @param direction The path orientation
+     *
+     * @return the extrusion of the given path with the current settings
+     */
+    Tessellation* tessellate(bool stroke, Path2* path, PathOrientation direction) {
+        Context* state = getState();
+        float params[5];
+        size_t count;
+        if (stroke) {
+            params[0] = state->strokeWidth;
+            params[1] = state->fringe;
+            params[2] = state->mitreLimit;
+            params[3] = (float)state->lineCap;
+            params[4] = (float)state->lineJoint;
+            count = 5;
+        } else {
+            params[0] = state->fringe;
+            params[1] = (float)direction;
+            count = 2;
+        }
+
+        Uint64 key = tessellation_key(stroke,path,params,count);
+        auto it = node->_tessellations.find(key);
+        if (it != node->_tessellations.end() && it->second->matches(stroke,path,params,count)) {
+            it->second->used = true;
+            return it->second;
+        }
+
+        Tessellation* result;
+        if (it != node->_tessellations.end()) {
+            // Replace the colliding entry
+            result = it->second;
+            result->mesh.clear();
+            result->border.clear();
+            result->used = true;
+        } else {
+            if (node->_tessellations.size() >= TESSELLATION_LIMIT) {
+                node->sweepTessellations();
+            }
+            result = new Tessellation();
+            node->_tessellations[key] = result;
+        }
+        result->stroke = stroke;
+        result->path = *path;
+        result->count = count;
+        std::copy(params,params+count,result->params);
+        result->mesh.command = GL_TRIANGLES;
+        result->border.command = GL_TRIANGLES;
+
+        // Reuse the page extruder so that its buffers persist across frames
+        if (stroke) {
+            // Extrude the basic shape
+            extruder.set(*path);
+            extruder.setMitreLimit(state->mitreLimit);
+            extruder.setEndCap(state->lineCap);
+            extruder.setJoint(state->lineJoint);
+            extruder.calculate(state->strokeWidth-state->fringe/2);
+            extruder.getMesh(&result->mesh,Color4::WHITE);
+
+            if (state->fringe > 0) {
+                outlines.clear();
+                extruder.getBorder(outlines);
+                for(auto jt = outlines.begin(); jt != outlines.end(); ++jt) {
+                    extruder.clear();
+                    extruder.set(*jt);
+                    extruder.setJoint(poly2::Joint::MITRE);
+                    extruder.setEndCap(poly2::EndCap::BUTT);
+                    extruder.calculate(0,state->fringe/2);
+                    extruder.getMesh(&result->border,Color4::WHITE,Color4::CLEAR);
+                }
+            }
+        } else if (state->fringe > 0) {
+            extruder.set(path->vertices,true);
+            extruder.setMitreLimit(10.0f);
+            extruder.setJoint(poly2::Joint::MITRE);
+            switch (direction) {
+                case CCW_CONCAVE:
+                case CW_CONCAVE:
+                    // Need both sides
+                    extruder.calculate(0,state->fringe);
+                    extruder.getMesh(&result->border,Color4::WHITE,Color4::CLEAR);
+                    extruder.reset();
+                case CCW_CONVEX:
+                case CW_CONVEX:
+                    // Interior is to the left
+                    extruder.calculate(0,state->fringe);
+                    extruder.getMesh(&result->border,Color4::WHITE,Color4::CLEAR);
+                    break;
+                case COLINEAR:
+                    break;
+            }
+        }
+        return result;
+    }
+
     /**
      * Materializes the current drawing state into a sequence of commands
      *
@@ -1079,28 +1289,9 @@ public:
                             if (state->fringe > 0) {
                                 Color4 clear = state->fillColor;
                                 clear.a = 0;
-                                
-                                SimpleExtruder extruder;
-                                extruder.clear();
-                                extruder.set(path->vertices,true);
-                                extruder.setJoint(poly2::Joint::MITRE);
-                                
-                                switch (direction) {
-                                    case CCW_CONCAVE:
-                                    case CW_CONCAVE:
-                                        // Need both sides
-                                        extruder.calculate(0,state->fringe);
-                                        extruder.getMesh(&packet->border,color,clear);
-                                        extruder.reset();
-                                    case CCW_CONVEX:
-                                    case CW_CONVEX:
-                                        // Interior is to the left
-                                        extruder.calculate(0,state->fringe);
-                                        extruder.getMesh(&packet->border,color,clear);
-                                        break;
-                                    case COLINEAR:
-                                        break;
-                                }
+                                Tessellation* cached = tessellate(false,path,direction);
+                                append_tessellation(packet->border,cached->border,
+                                                    rgba,clear.getPacked());
                             }
                             
                             switch (state->fillrule) {
@@ -1136,31 +1327,17 @@ public:
                             Color4 color = state->strokeColor;
                             color.a *= state->globalAlpha;
                             
-                            // Extrude the basic shape
-                            SimpleExtruder extruder;
-                            extruder.set(*path);
-                            extruder.setMitreLimit(state->mitreLimit);
-                            extruder.setEndCap(state->lineCap);
-                            extruder.setJoint(state->lineJoint);
-                            extruder.calculate(state->strokeWidth-state->fringe/2);
-                            packet->mesh.command = GL_TRIANGLES;
-                            extruder.getMesh(&packet->mesh,color);
+                            // Extrude the basic shape (or reuse the extrusion)
+                            Tessellation* cached = tessellate(true,path,direction);
+                            Uint32 rgba = color.getPacked();
+                            append_tessellation(packet->mesh,cached->mesh,rgba,rgba);
                             
                             if (state->fringe > 0) {
                                 Color4 clear = color;
                                 clear.a = 0;
-
-                                std::vector<Path2> outlines;
-                                extruder.getBorder(outlines);
                                 packet->border.command = GL_TRIANGLES;
-                                for(auto jt = outlines.begin(); jt != outlines.end(); ++jt) {
-                                    extruder.clear();
-                                    extruder.set(*jt);
-                                    extruder.setJoint(poly2::Joint::MITRE);
-                                    extruder.setEndCap(poly2::EndCap::BUTT);
-                                    extruder.calculate(0,state->fringe/2);
-                                    extruder.getMesh(&packet->border,color,clear);
-                                }
+                                append_tessellation(packet->border,cached->border,
+                                                    rgba,clear.getPacked());
                             }
                             
                             
@@ -1270,6 +1447,7 @@ void CanvasNode::dispose() {
         *it = nullptr;
     }
     _canvas.clear();
+    clearTessellations();
     SceneNode::dispose();
 }
 
@@ -1483,6 +1661,7 @@ void CanvasNode::setDrawPage(size_t page) {
         paginate(page+1);
     }
     _draw = page;
+    invalidateCache();
 }
 
 /**
@@ -1497,6 +1676,7 @@ void CanvasNode::clearPage() {
     page->clearCommands();
     page->clearPaths();
     page->resetContexts();
+    invalidateCache();
 }
 
 /**
@@ -1508,6 +1688,43 @@ void CanvasNode::clearAll() {
         (*it)->clearPaths();
         (*it)->resetContexts();
     }
+    invalidateCache();
+}
+
+/**
+ * Deletes all cached path extrusions
+ *
+ * Stroking a path (or adding an anti-aliasing fringe to a fill) extrudes
+ * it into a mesh. These meshes are cached, indexed by the path geometry
+ * and the stroke settings, so redrawing an unchanged path (with any color
+ * or paint) does not extrude it again. The cache is shared by all pages.
+ */
+void CanvasNode::clearTessellations() {
+    for(auto it = _tessellations.begin(); it != _tessellations.end(); ++it) {
+        delete it->second;
+    }
+    _tessellations.clear();
+}
+
+/**
+ * Removes all cached extrusions not used since the last sweep
+ *
+ * This method is called when the cache is full. If every extrusion
+ * was used, the cache is emptied.
+ */
+void CanvasNode::sweepTessellations() {
+    for(auto it = _tessellations.begin(); it != _tessellations.end(); ) {
+        if (it->second->used) {
+            it->second->used = false;
+            ++it;
+        } else {
+            delete it->second;
+            it = _tessellations.erase(it);
+        }
+    }
+    if (_tessellations.size() >= TESSELLATION_LIMIT) {
+        clearTessellations();
+    }
 }
 
 /**
@@ -1859,6 +2076,24 @@ void CanvasNode::setFringe(float fringe) {
     _canvas[_edit]->getState()->fringe = fringe;
 }
 
+/**
+ * Sets the screen scale used to flatten curves
+ *
+ * Curves (such as arcs and bezier segments) are approximated by the
+ * minimum number of line segments that keep the path within a fixed
+ * tolerance in screen space. This value is the number of screen units
+ * per unit of this canvas, such as the camera zoom times the scale of
+ * this node. Larger values produce smoother curves. The default is 1.
+ *
+ * This value is applied when each path is committed.
+ *
+ * @param scale The screen scale used to flatten curves
+ */
+void CanvasNode::setPathScale(float scale) {
+    CUAssertLog(scale > 0, "Path scale %f is not positive", scale);
+    _pathscale = scale;
+}
+
 /**
  * Returns the transparency to apply to all rendered shapes.
  *
@@ -3333,6 +3568,7 @@ void CanvasNode::fillPaths() {
     Page* page = _canvas[_edit];
     page->savePath();
     page->materialize(CommandType::FILL);
+    invalidateCache();
 }
 
 /**
@@ -3346,6 +3582,7 @@ void CanvasNode::strokePaths() {
     Page* page = _canvas[_edit];
     page->savePath();
     page->materialize(CommandType::STROKE);
+    invalidateCache();
 }
 
 #pragma mark -
@@ -3580,6 +3817,7 @@ void CanvasNode::drawText(float x, float y, const char* substr, const char* end)
     page->layout.setVerticalAlignment(state->fontVAlign);
     page->layout.layout();
     page->materialize(CommandType::TEXT);
+    invalidateCache();
 }
 
 /**
@@ -3631,5 +3869,6 @@ void CanvasNode::drawTextBox(float x, float y, float width, const char* substr,
     page->layout.setVerticalAlignment(state->fontVAlign);
     page->layout.layout();
     page->materialize(CommandType::TEXT);
+    invalidateCache();
 }
 
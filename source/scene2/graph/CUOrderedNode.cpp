@@ -44,11 +44,57 @@
 //  Author: Walker White
 //  Version: 3/7/21
 #include <cugl/scene2/graph/CUOrderedNode.h>
+#include <cugl/scene2/graph/CUTexturedNode.h>
+#include <cugl/scene2/CUScene2Profiler.h>
 #include <cugl/render/CUScissor.h>
+#include <cugl/render/CUTexture.h>
+#include <cstring>
 
 using namespace cugl;
 using namespace cugl::scene2;
 
+/** The number of bits per radix sort pass */
+#define RADIX_BITS  8
+/** The number of buckets per radix sort pass */
+#define RADIX_SIZE  (1 << RADIX_BITS)
+/** The average number of moves per entry before an insertion sort gives up */
+#define INSERTION_LIMIT 8
+
+/**
+ * Returns the batched sort key for the given node.
+ *
+ * The high 32 bits are the priority, mapped so that the order of the
+ * unsigned bits agrees with the order of the floats. The next 24 bits are
+ * the texture buffer (0 if there is no texture), and the final 8 bits are
+ * a hash of the blend mode.
+ *
+ * @param node      The node to draw
+ * @param barrier   Whether the node is a render barrier
+ *
+ * @return the batched sort key for the given node.
+ */
+static Uint64 batched_key(const SceneNode* node, bool barrier) {
+    float priority = const_cast<SceneNode*>(node)->getPriority();
+    Uint32 bits;
+    std::memcpy(&bits,&priority,sizeof(Uint32));
+    bits = (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+    Uint64 result = ((Uint64)bits) << 32;
+    
+    // Barriers render their own subtree, so they are not batched
+    const TexturedNode* textured = barrier ? nullptr : dynamic_cast<const TexturedNode*>(node);
+    if (textured != nullptr) {
+        const std::shared_ptr<Texture>& texture = textured->getTexture();
+        if (texture != nullptr) {
+            result |= ((Uint64)(texture->getBuffer() & 0xFFFFFF)) << 8;
+        }
+        Uint32 blend = textured->getBlendEquation();
+        blend = blend*31+textured->getSourceBlendFactor();
+        blend = blend*31+textured->getDestinationBlendFactor();
+        result |= (blend ^ (blend >> 8) ^ (blend >> 16)) & 0xFF;
+    }
+    return result;
+}
+
 #pragma mark Context
 /**
  * Creates a drawing context with the given parent object
@@ -58,7 +104,8 @@ using namespace cugl::scene2;
 OrderedNode::Context::Context(OrderedNode* parent) :
 node(nullptr),
 scissor(nullptr),
-canonical(0) {
+canonical(0),
+key(0) {
     this->parent = parent;
     tint = Color4::WHITE;
 }
@@ -73,6 +120,7 @@ OrderedNode::Context::Context(const Context& copy) {
     node = copy.node;
     scissor = copy.scissor;
     canonical = copy.canonical;
+    key = copy.key;
     transform = copy.transform;
     tint = copy.tint;
 }
@@ -102,6 +150,11 @@ bool OrderedNode::Context::sortCompare(Context* a, Context* b) {
         case Order::PRE_ORDER:
         case Order::POST_ORDER:
             return a->canonical < b->canonical;
+        case Order::BATCHED:
+            if (a->key == b->key) {
+                return a->canonical < b->canonical;
+            }
+            return a->key < b->key;
         case Order::ASCEND:
             if (a->node->getPriority() == b->node->getPriority()) {
                 return a->canonical < b->canonical;
@@ -163,6 +216,10 @@ void OrderedNode::dispose() {
         *it = nullptr;
     }
     _entries.clear();
+    _keyed.clear();
+    _scratch.clear();
+    _permutation.clear();
+    _sorted.clear();
     _viewport = nullptr;
     SceneNode::dispose();
 }
@@ -268,6 +325,8 @@ bool OrderedNode::initWithData(const Scene2Loader* loader, const std::shared_ptr
                 _order = Order::POST_ASCEND;
             } else if (value == "post-descend") {
                 _order = Order::POST_DESCEND;
+            } else if (value == "batched") {
+                _order = Order::BATCHED;
             }
         }
         return true;
@@ -290,8 +349,7 @@ bool OrderedNode::initWithData(const Scene2Loader* loader, const std::shared_ptr
 void OrderedNode::visit(const std::shared_ptr<SceneNode>& node, const Affine2& transform, Color4 tint) {
     if (!node->isVisible()) { return; }
 
-    Affine2 matrix;
-    Affine2::multiply(node->getTransform(),transform,&matrix);
+    Affine2 matrix = node->getRenderTransform(transform);
     Color4 color = node->getColor();
     if (node->hasRelativeColor()) {
         color *= tint;
@@ -329,6 +387,9 @@ void OrderedNode::visit(const std::shared_ptr<SceneNode>& node, const Affine2& t
     context->scissor = _viewport;
     context->tint = barrier ? tint : color;
     context->canonical = canonical;
+    if (_order == Order::BATCHED) {
+        context->key = batched_key(node.get(),barrier);
+    }
     
     if (!ispost && !barrier) {
         auto children = node->getChildren();
@@ -340,6 +401,99 @@ void OrderedNode::visit(const std::shared_ptr<SceneNode>& node, const Affine2& t
     _viewport = previous;
 }
 
+/**
+ * Sorts the render queue in batched order.
+ *
+ * Each entry is assigned a sort key from its priority, texture, and blend
+ * mode. The entries are then radix sorted on these keys. As radix sort is
+ * stable, entries with the same key remain in pre-order.
+ */
+void OrderedNode::sortBatched() {
+    size_t size = _entries.size();
+    _keyed.resize(size);
+    _scratch.resize(size);
+    for(size_t ii = 0; ii < size; ii++) {
+        _keyed[ii] = std::make_pair(_entries[ii]->key,_entries[ii]);
+    }
+    
+    // LSD radix sort, skipping any digit shared by every key
+    size_t counts[RADIX_SIZE];
+    for(Uint32 shift = 0; shift < 64; shift += RADIX_BITS) {
+        std::memset(counts,0,sizeof(counts));
+        for(auto it = _keyed.begin(); it != _keyed.end(); ++it) {
+            counts[(it->first >> shift) & (RADIX_SIZE-1)]++;
+        }
+        if (counts[(_keyed[0].first >> shift) & (RADIX_SIZE-1)] == size) {
+            continue;
+        }
+        size_t total = 0;
+        for(size_t ii = 0; ii < RADIX_SIZE; ii++) {
+            size_t amt = counts[ii];
+            counts[ii] = total;
+            total += amt;
+        }
+        for(auto it = _keyed.begin(); it != _keyed.end(); ++it) {
+            _scratch[counts[(it->first >> shift) & (RADIX_SIZE-1)]++] = *it;
+        }
+        _keyed.swap(_scratch);
+    }
+    
+    for(size_t ii = 0; ii < size; ii++) {
+        _entries[ii] = _keyed[ii].second;
+    }
+}
+
+/**
+ * Sorts the render queue in a priority order.
+ *
+ * The entries are first placed in the sorted order of the previous frame.
+ * In a typical frame only a few priorities change, so this order is nearly
+ * sorted, and an insertion sort only has to move the changed entries. If
+ * the queue has changed size, or if the insertion sort does too much work,
+ * this method falls back to a full sort.
+ */
+void OrderedNode::sortIncremental() {
+    size_t size = _entries.size();
+    _sorted.resize(size);
+    bool sorted = false;
+    if (_permutation.size() == size) {
+        // Canonical values are the positions in the unsorted queue
+        for(size_t ii = 0; ii < size; ii++) {
+            _sorted[ii] = _entries[_permutation[ii]];
+        }
+
+        // Insertion sort, with a budget for badly out-of-order queues
+        size_t budget = INSERTION_LIMIT*size;
+        sorted = true;
+        for(size_t ii = 1; sorted && ii < size; ii++) {
+            Context* entry = _sorted[ii];
+            size_t jj = ii;
+            while (jj > 0 && Context::sortCompare(entry,_sorted[jj-1])) {
+                _sorted[jj] = _sorted[jj-1];
+                jj--;
+                if (budget-- == 0) {
+                    sorted = false;
+                    break;
+                }
+            }
+            _sorted[jj] = entry;
+        }
+    }
+    
+    if (!sorted) {
+        for(size_t ii = 0; ii < size; ii++) {
+            _sorted[ii] = _entries[ii];
+        }
+        std::sort(_sorted.begin(), _sorted.end(), Context::sortCompare);
+    }
+
+    _permutation.resize(size);
+    for(size_t ii = 0; ii < size; ii++) {
+        _entries[ii] = _sorted[ii];
+        _permutation[ii] = _sorted[ii]->canonical;
+    }
+}
+
 /**
  * Draws this node and all of its children with the given SpriteBatch.
  *
@@ -361,8 +515,8 @@ void OrderedNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine
         // Drop to standard for efficiency
         SceneNode::render(batch,transform,tint);
     } else {
-        Affine2 matrix;
-        Affine2::multiply(_combined,transform,&matrix);
+        Scene2Profiler::Scope scope(Scene2Profiler::Category::RENDER,this);
+        Affine2 matrix = getRenderTransform(transform);
         Color4 color = _tintColor;
         if (_hasParentColor) {
             color *= tint;
@@ -385,7 +539,13 @@ void OrderedNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine
             visit(*it, matrix, color);
         }
 
-        std::sort(_entries.begin(), _entries.end(), Context::sortCompare);
+        if (_order == Order::BATCHED) {
+            sortBatched();
+        } else if (_order == Order::PRE_ORDER || _order == Order::POST_ORDER) {
+            std::sort(_entries.begin(), _entries.end(), Context::sortCompare);
+        } else {
+            sortIncremental();
+        }
         for(auto it = _entries.begin(); it != _entries.end(); ++it) {
             Context* context = *it;
             batch->setScissor(context->scissor); // This is in render, so must be applied
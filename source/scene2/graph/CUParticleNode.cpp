@@ -0,0 +1,460 @@
+//
+//  CUParticleNode.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a scene graph node for a simple particle emitter.
+//  The particles are simulated on the CPU in a structure-of-arrays layout,
+//  so that each step of the simulation is a tight loop over a single array.
+//  They are drawn to the SpriteBatch as sprite instances, so that the entire
+//  emitter costs a single draw call, no matter how many particles it has.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/scene2/graph/CUParticleNode.h>
+#include <cugl/render/CUSpriteBatch.h>
+#include <cugl/util/CUDebug.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+/**
+ * Moves the element at position src of the array to position dst
+ *
+ * @param array The array to modify
+ * @param dst   The destination position
+ * @param src   The source position
+ */
+static inline void move_entry(std::vector<float>& array, size_t dst, size_t src) {
+    array[dst] = array[src];
+}
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates an empty particle node.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+ParticleNode::ParticleNode() : SceneNode(),
+_texture(nullptr),
+_blendEquation(GL_FUNC_ADD),
+_srcFactor(GL_SRC_ALPHA),
+_dstFactor(GL_ONE_MINUS_SRC_ALPHA),
+_capacity(0),
+_count(0),
+_radius(0),
+_rate(0),
+_accumulator(0),
+_minLife(1),
+_maxLife(1),
+_minSpeed(0),
+_maxSpeed(0),
+_direction((float)M_PI_2),
+_spread((float)(2*M_PI)),
+_minSpin(0),
+_maxSpin(0),
+_damping(0),
+_startSize(1),
+_endSize(1),
+_startColor(Color4f::WHITE),
+_endColor(Color4f::WHITE) {
+    _classname = "ParticleNode";
+}
+
+/**
+ * Disposes all of the resources used by this node.
+ *
+ * A disposed node can be safely reinitialized. Any children owned by this
+ * node will be released. They will be deleted if no other object owns them.
+ *
+ * It is unsafe to call this on a node that is still currently inside of
+ * a scene graph.
+ */
+void ParticleNode::dispose() {
+    _texture = nullptr;
+    _blendEquation = GL_FUNC_ADD;
+    _srcFactor = GL_SRC_ALPHA;
+    _dstFactor = GL_ONE_MINUS_SRC_ALPHA;
+    _capacity = 0;
+    _count = 0;
+    _posx.clear();
+    _posy.clear();
+    _velx.clear();
+    _vely.clear();
+    _angle.clear();
+    _spin.clear();
+    _age.clear();
+    _life.clear();
+    _instances.clear();
+    _extent = Rect::ZERO;
+    _emitter = Vec2::ZERO;
+    _radius = 0;
+    _rate = 0;
+    _accumulator = 0;
+    _minLife = 1;
+    _maxLife = 1;
+    _minSpeed = 0;
+    _maxSpeed = 0;
+    _direction = (float)M_PI_2;
+    _spread = (float)(2*M_PI);
+    _minSpin = 0;
+    _maxSpin = 0;
+    _gravity = Vec2::ZERO;
+    _damping = 0;
+    _startSize = 1;
+    _endSize = 1;
+    _startColor = Color4f::WHITE;
+    _endColor = Color4f::WHITE;
+    SceneNode::dispose();
+}
+
+/**
+ * Initializes a particle node with the given texture and capacity.
+ *
+ * The capacity is the maximum number of live particles. Particles emitted
+ * while the node is at capacity are discarded. If the texture is nullptr,
+ * each particle is a solid square.
+ *
+ * @param texture   The texture of each particle
+ * @param capacity  The maximum number of live particles
+ *
+ * @return true if initialization was successful.
+ */
+bool ParticleNode::initWithTexture(const std::shared_ptr<Texture>& texture, size_t capacity) {
+    if (!SceneNode::init()) {
+        return false;
+    }
+    _texture = texture;
+    _random.seed(std::random_device()());
+    setCapacity(capacity);
+    return true;
+}
+
+#pragma mark -
+#pragma mark Emitter Attributes
+/**
+ * Sets the range of lifetimes of a particle in seconds
+ *
+ * @param min   The minimum lifetime
+ * @param max   The maximum lifetime
+ */
+void ParticleNode::setLifetime(float min, float max) {
+    CUAssertLog(min > 0 && min <= max, "Lifetime range [%.3f,%.3f] is invalid", min, max);
+    _minLife = min;
+    _maxLife = max;
+}
+
+/**
+ * Sets the range of initial speeds of a particle
+ *
+ * @param min   The minimum speed
+ * @param max   The maximum speed
+ */
+void ParticleNode::setSpeed(float min, float max) {
+    CUAssertLog(min <= max, "Speed range [%.3f,%.3f] is invalid", min, max);
+    _minSpeed = min;
+    _maxSpeed = max;
+}
+
+/**
+ * Sets the range of angular velocities of a particle in radians per second
+ *
+ * @param min   The minimum angular velocity
+ * @param max   The maximum angular velocity
+ */
+void ParticleNode::setSpin(float min, float max) {
+    CUAssertLog(min <= max, "Spin range [%.3f,%.3f] is invalid", min, max);
+    _minSpin = min;
+    _maxSpin = max;
+}
+
+#pragma mark -
+#pragma mark Simulation
+/**
+ * Sets the maximum number of live particles
+ *
+ * If the capacity is less than the current number of particles, the
+ * newest particles are discarded.
+ *
+ * @param capacity  The maximum number of live particles
+ */
+void ParticleNode::setCapacity(size_t capacity) {
+    _capacity = capacity;
+    _count = std::min(_count,capacity);
+    _posx.resize(capacity);
+    _posy.resize(capacity);
+    _velx.resize(capacity);
+    _vely.resize(capacity);
+    _angle.resize(capacity);
+    _spin.resize(capacity);
+    _age.resize(capacity);
+    _life.resize(capacity);
+    _instances.reserve(capacity);
+    computeExtent();
+}
+
+/**
+ * Emits the given number of particles immediately
+ *
+ * Particles beyond the capacity of this node are discarded. This method
+ * is independent of the emission rate, and is ideal for bursts such as
+ * explosions.
+ *
+ * @param count The number of particles to emit
+ */
+void ParticleNode::emit(size_t count) {
+    count = std::min(count,_capacity-_count);
+    float half = _spread/2;
+    for(size_t ii = _count; ii < _count+count; ii++) {
+        Vec2 pos = _emitter;
+        if (_radius > 0) {
+            // Square root gives a uniform distribution over the disc
+            float r = _radius*sqrtf(random(0,1));
+            float a = random(0,(float)(2*M_PI));
+            pos.x += r*cosf(a);
+            pos.y += r*sinf(a);
+        }
+        float speed = random(_minSpeed,_maxSpeed);
+        float angle = _direction+random(-half,half);
+        _posx[ii] = pos.x;
+        _posy[ii] = pos.y;
+        _velx[ii] = speed*cosf(angle);
+        _vely[ii] = speed*sinf(angle);
+        _angle[ii] = 0;
+        _spin[ii] = random(_minSpin,_maxSpin);
+        _age[ii] = 0;
+        _life[ii] = random(_minLife,_maxLife);
+    }
+    _count += count;
+    if (count) {
+        computeExtent();
+    }
+}
+
+/**
+ * Removes all of the live particles
+ *
+ * This does not change the emission rate.
+ */
+void ParticleNode::clear() {
+    _count = 0;
+    _accumulator = 0;
+    computeExtent();
+}
+
+/**
+ * Advances the particle simulation by the given number of seconds.
+ *
+ * This method ages and moves the live particles, removes the particles
+ * that have died, and then emits new particles at the emission rate.
+ *
+ * @param dt    The number of seconds since the last update
+ */
+void ParticleNode::update(float dt) {
+    // Age every particle first, so the loop stays branch free
+    float* age = _age.data();
+    for(size_t ii = 0; ii < _count; ii++) {
+        age[ii] += dt;
+    }
+
+    // Swap the dead with the last live particle (this loop is rarely hot)
+    size_t ii = 0;
+    while (ii < _count) {
+        if (_age[ii] >= _life[ii]) {
+            size_t last = _count-1;
+            move_entry(_posx,ii,last);
+            move_entry(_posy,ii,last);
+            move_entry(_velx,ii,last);
+            move_entry(_vely,ii,last);
+            move_entry(_angle,ii,last);
+            move_entry(_spin,ii,last);
+            move_entry(_age,ii,last);
+            move_entry(_life,ii,last);
+            _count--;
+        } else {
+            ii++;
+        }
+    }
+
+    // Integrate one attribute at a time
+    float damp = (_damping > 0 ? std::max(0.0f,1.0f-_damping*dt) : 1.0f);
+    float gx = _gravity.x*dt;
+    float gy = _gravity.y*dt;
+    float* px = _posx.data();
+    float* py = _posy.data();
+    float* vx = _velx.data();
+    float* vy = _vely.data();
+    float* an = _angle.data();
+    float* sp = _spin.data();
+    for(size_t jj = 0; jj < _count; jj++) {
+        vx[jj] = vx[jj]*damp+gx;
+    }
+    for(size_t jj = 0; jj < _count; jj++) {
+        vy[jj] = vy[jj]*damp+gy;
+    }
+    for(size_t jj = 0; jj < _count; jj++) {
+        px[jj] += vx[jj]*dt;
+    }
+    for(size_t jj = 0; jj < _count; jj++) {
+        py[jj] += vy[jj]*dt;
+    }
+    for(size_t jj = 0; jj < _count; jj++) {
+        an[jj] += sp[jj]*dt;
+    }
+
+    // Emit at the current rate
+    if (_rate > 0) {
+        _accumulator += _rate*dt;
+        size_t spawn = (size_t)_accumulator;
+        _accumulator -= spawn;
+        emit(spawn);
+    }
+    computeExtent();
+}
+
+/**
+ * Draws this node via the given SpriteBatch.
+ *
+ * This method only worries about drawing the current node. It does not
+ * attempt to render the children.
+ *
+ * The particles are drawn as sprite instances, in a single call. As the
+ * instances do not have a transform, the particles are transformed now.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ * @param transform The global transformation matrix.
+ * @param tint      The tint to blend with the Node color.
+ */
+void ParticleNode::draw(const std::shared_ptr<SpriteBatch>& batch,
+                        const Affine2& transform, Color4 tint) {
+    if (_count == 0) {
+        return;
+    }
+
+    // Instances can rotate and scale uniformly, but cannot shear
+    const float* m = transform.m;
+    float sx = sqrtf(m[0]*m[0]+m[1]*m[1]);
+    float sy = sqrtf(m[2]*m[2]+m[3]*m[3]);
+    float rot = atan2f(m[1],m[0]);
+
+    Color4f tintf(tint);
+    Color4f start = _startColor*tintf;
+    Color4f end   = _endColor*tintf;
+    Vec2 texmin = Vec2::ZERO;
+    Vec2 texmax = Vec2::ONE;
+    if (_texture != nullptr) {
+        texmin.set(_texture->getMinS(),_texture->getMinT());
+        texmax.set(_texture->getMaxS(),_texture->getMaxT());
+    }
+
+    _instances.resize(_count);
+    for(size_t ii = 0; ii < _count; ii++) {
+        float t = std::min(_age[ii]/_life[ii],1.0f);
+        float size = _startSize+(_endSize-_startSize)*t;
+        SpriteInstance& inst = _instances[ii];
+        inst.position = transform.transform(Vec2(_posx[ii],_posy[ii]));
+        inst.size.set(size*sx,size*sy);
+        inst.angle = _angle[ii]+rot;
+        inst.color = start.getLerp(end,t).getPacked();
+        inst.texmin = texmin;
+        inst.texmax = texmax;
+    }
+
+    batch->setBlendEquation(_blendEquation);
+    batch->setSrcBlendFunc(_srcFactor);
+    batch->setDstBlendFunc(_dstFactor);
+    batch->drawInstances(_texture,_instances.data(),_instances.size());
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns an AABB containing this node and all of its descendants.
+ *
+ * This bounding box includes the live particles, which may lie outside
+ * of the content bounds of this node.
+ *
+ * @return an AABB containing this node and all of its descendants.
+ */
+Rect ParticleNode::computeSubtreeBounds() {
+    Rect result = SceneNode::computeSubtreeBounds();
+    if (_count) {
+        result.merge(_extent);
+    }
+    return result;
+}
+
+/**
+ * Returns a random value between min and max (inclusive)
+ *
+ * @param min   The minimum value
+ * @param max   The maximum value
+ *
+ * @return a random value between min and max (inclusive)
+ */
+float ParticleNode::random(float min, float max) {
+    if (min >= max) {
+        return min;
+    }
+    std::uniform_real_distribution<float> dist(min,max);
+    return dist(_random);
+}
+
+/**
+ * Recomputes the extent of the live particles
+ */
+void ParticleNode::computeExtent() {
+    if (_count == 0) {
+        _extent = Rect::ZERO;
+    } else {
+        float minx = _posx[0], maxx = _posx[0];
+        float miny = _posy[0], maxy = _posy[0];
+        for(size_t ii = 1; ii < _count; ii++) {
+            minx = std::min(minx,_posx[ii]);
+            maxx = std::max(maxx,_posx[ii]);
+        }
+        for(size_t ii = 1; ii < _count; ii++) {
+            miny = std::min(miny,_posy[ii]);
+            maxy = std::max(maxy,_posy[ii]);
+        }
+        // Pad by the largest half size (rotated squares need the diagonal)
+        float pad = std::max(_startSize,_endSize)*0.7072f;
+        _extent.set(minx-pad,miny-pad,maxx-minx+2*pad,maxy-miny+2*pad);
+    }
+    invalidateBounds();
+    invalidateCache();
+}
@@ -507,12 +507,12 @@ void PathNode::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& tr
     if (_stencil) {
         batch->setStencilEffect(StencilEffect::CLAMP_NONE);
     }
-    batch->drawMesh(_mesh, transform);
+    batch->drawMesh(getRenderMesh(), transform);
     if (_fringe > 0) {
         if (_stencil) {
             batch->setStencilEffect(StencilEffect::MASK_NONE);
         }
-        batch->drawMesh(_border, transform);
+        batch->drawMesh(_geometry != nullptr ? _geometry->border : _border, transform);
     }
     
     if (_stencil) {
@@ -529,6 +529,18 @@ void PathNode::generateRenderData() {
     if (_texture == nullptr) {
         return;
     }
+
+    std::string key;
+    if (_shared) {
+        appendGeometryKey(key);
+        if (acquireGeometry(key)) {
+            _polygon = _geometry->shape;
+            _extrabounds = _geometry->bounds;
+            _border.clear();
+            _rendered = true;
+            return;
+        }
+    }
     
     updateExtrusion();
     Size nsize = getContentSize();
@@ -554,6 +566,14 @@ void PathNode::generateRenderData() {
     
     _rendered = true;
     updateTextureCoords();
+    if (_shared) {
+        std::shared_ptr<Geometry> geometry = std::make_shared<Geometry>();
+        geometry->border = std::move(_border);
+        geometry->shape  = _polygon;
+        geometry->bounds = _extrabounds;
+        _border = Mesh<SpriteVertex2>();
+        shareGeometry(key,geometry);
+    }
 }
 
 /**
@@ -567,6 +587,11 @@ void PathNode::updateTextureCoords() {
     if (!_rendered) {
         return;
     }
+    if (_geometry != nullptr) {
+        // Shared meshes are read-only, so regenerate on the next draw
+        clearRenderData();
+        return;
+    }
     
     // First the interior stroke
     Size tsize = _texture->getSize();
@@ -637,10 +662,10 @@ void PathNode::updateExtrusion() {
         _mesh.set(_polygon);
         
         if (_fringe > 0) {
-            std::vector<Path2> outlines;
-            _extruder.getBorder(outlines);
+            _outlines.clear();
+            _extruder.getBorder(_outlines);
             _border.command = GL_TRIANGLES;
-            for(auto it = outlines.begin(); it != outlines.end(); ++it) {
+            for(auto it = _outlines.begin(); it != _outlines.end(); ++it) {
                 _extruder.clear();
                 _extruder.set(*it);
                 _extruder.setJoint(poly2::Joint::MITRE);
@@ -650,10 +675,11 @@ void PathNode::updateExtrusion() {
             }
         }
     } else if (_fringe > 0) {
-        Path2 outline;
+        _outlines.resize(1);
+        Path2& outline = _outlines.back();
         size_t size = _path.vertices.size();
         outline.vertices.reserve(2*size);
-        outline.vertices = _path.vertices;
+        outline.vertices.assign(_path.vertices.begin(),_path.vertices.end());
         for(size_t ii = 2; ii < size; ii++) {
             outline.vertices.push_back(_path.vertices[size-ii]);
         }
@@ -687,3 +713,21 @@ void PathNode::updateExtrusion() {
         _extrabounds = _path.getBounds();
     }
 }
+
+/**
+ * Appends the settings that determine the render data to the given key
+ *
+ * Nodes with equal keys have identical render data.
+ *
+ * @param key   The key to extend
+ */
+void PathNode::appendGeometryKey(std::string& key) const {
+    TexturedNode::appendGeometryKey(key);
+    key.append("PathNode");
+    appendKey(key,_stroke);
+    appendKey(key,_fringe);
+    appendKey(key,_joint);
+    appendKey(key,_endcap);
+    appendKey(key,(Uint8)(_path.closed ? 1 : 0));
+    appendKey(key,_path.vertices);
+}
@@ -177,17 +177,26 @@ std::shared_ptr<SceneNode> PolygonNode::copy(const std::shared_ptr<SceneNode>& d
 /**
  * Sets the polgon to the vertices expressed in texture space.
  *
- * The vertices will be triangulated with {@link EarclipTriangulator}.
+ * The vertices will be triangulated with {@link EarclipTriangulator}, or
+ * with {@link MonotoneTriangulator} if there are at least
+ * {@link CU_MONOTONE_THRESHOLD} vertices.
  *
  * @param vertices  The vertices to texture
  */
 void PolygonNode::setPolygon(const std::vector<Vec2>& vertices) {
-    EarclipTriangulator triangulator;
     _polygon.set(vertices);
     _polygon.indices.clear();
-    triangulator.set(vertices);
-    triangulator.calculate();
-    triangulator.getTriangulation(_polygon.indices);
+    if (vertices.size() >= CU_MONOTONE_THRESHOLD) {
+        MonotoneTriangulator triangulator;
+        triangulator.set(vertices);
+        triangulator.calculate();
+        triangulator.getTriangulation(_polygon.indices);
+    } else {
+        EarclipTriangulator triangulator;
+        triangulator.set(vertices);
+        triangulator.calculate();
+        triangulator.getTriangulation(_polygon.indices);
+    }
     
     setContentSize(_polygon.getBounds().size);
     updateTextureCoords();
@@ -246,7 +255,7 @@ void PolygonNode::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2&
     batch->setBlendEquation(_blendEquation);
     batch->setSrcBlendFunc(_srcFactor);
     batch->setDstBlendFunc(_dstFactor);
-    batch->drawMesh(_mesh, transform);
+    batch->drawMesh(getRenderMesh(), transform);
     if (_gradient) {
         batch->setGradient(nullptr);
     }
@@ -260,27 +269,35 @@ void PolygonNode::generateRenderData() {
     if (_texture == nullptr) {
         return;
     }
+
+    std::string key;
+    if (_shared) {
+        appendGeometryKey(key);
+        if (acquireGeometry(key)) {
+            _rendered = true;
+            return;
+        }
+    }
     
     _mesh.set(_polygon);
     _mesh.command = GL_TRIANGLES;
     
     // Antialias the boundaries (if required)
     if (_fringe > 0) {
-        SimpleExtruder extruder;
         std::vector<std::vector<Uint32>> boundaries = _polygon.boundaries();
         Color4 clear = Color4(255,255,255,0);
         for(auto it = boundaries.begin(); it != boundaries.end(); ++it) {
-            std::vector<Vec2> border;
-            border.reserve(it->size());
+            _outline.clear();
+            _outline.reserve(it->size());
             for (auto jt = it->begin(); jt != it->end(); ++jt) {
-                border.push_back(_polygon.vertices[*jt]);
+                _outline.push_back(_polygon.vertices[*jt]);
             }
-            extruder.clear();
-            extruder.set(border,true);
-            extruder.setJoint(poly2::Joint::SQUARE);
+            _extruder.clear();
+            _extruder.set(_outline,true);
+            _extruder.setJoint(poly2::Joint::SQUARE);
             // Interior is to the left
-            extruder.calculate(0,_fringe);
-            extruder.getMesh(&_mesh,Color4::WHITE,clear);
+            _extruder.calculate(0,_fringe);
+            _extruder.getMesh(&_mesh,Color4::WHITE,clear);
         }
     }
 
@@ -308,6 +325,9 @@ void PolygonNode::generateRenderData() {
 
     _rendered = true;
     updateTextureCoords();
+    if (_shared) {
+        shareGeometry(key);
+    }
 }
 
 /**
@@ -321,6 +341,11 @@ void PolygonNode::updateTextureCoords() {
     if (!_rendered) {
         return;
     }
+    if (_geometry != nullptr) {
+        // Shared meshes are read-only, so regenerate on the next draw
+        clearRenderData();
+        return;
+    }
     
     Size tsize = _texture->getSize();
     Vec2 off = _offset+_polygon.getBounds().origin;
@@ -345,3 +370,18 @@ void PolygonNode::updateTextureCoords() {
         }
     }
 }
+
+/**
+ * Appends the settings that determine the render data to the given key
+ *
+ * Nodes with equal keys have identical render data.
+ *
+ * @param key   The key to extend
+ */
+void PolygonNode::appendGeometryKey(std::string& key) const {
+    TexturedNode::appendGeometryKey(key);
+    key.append("PolygonNode");
+    appendKey(key,_fringe);
+    appendKey(key,_polygon.vertices);
+    appendKey(key,_polygon.indices);
+}
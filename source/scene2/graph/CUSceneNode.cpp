@@ -36,8 +36,10 @@
 
 #include <cugl/scene2/graph/CUSceneNode.h>
 #include <cugl/scene2/CUScene2.h>
+#include <cugl/scene2/CUScene2Profiler.h>
 #include <cugl/scene2/layout/CULayout.h>
 #include <cugl/render/CUCamera.h>
+#include <cugl/render/CURenderTarget.h>
 #include <cugl/util/CUStrings.h>
 #include <cugl/assets/CUAssetManager.h>
 #include <sstream>
@@ -46,6 +48,11 @@
 using namespace cugl;
 using namespace cugl::scene2;
 
+/** The minimum number of children before they are culled as a batch */
+#define CULL_BATCH  8
+/** The number of children culled in a single batch */
+#define CULL_CHUNK  64
+
 #pragma mark Constructors
 /**
  * Creates an uninitialized node.
@@ -68,8 +75,19 @@ _angle(0),
 _useTransform(false),
 _parent(nullptr),
 _graph(nullptr),
+_layoutDirty(true),
+_layoutPending(true),
+_inLayout(false),
+_layoutVersion(0),
 _childOffset(-2),
-_priority(0) {
+_priority(0),
+_boundsDirty(true),
+_preculled(false),
+_worldDirty(true),
+_inverseDirty(true),
+_interactive(false),
+_cacheTexture(false),
+_cacheDirty(true) {
     _classname = "SceneNode";
 }
 
@@ -254,6 +272,8 @@ void SceneNode::dispose() {
         removeFromParent();
     }
     removeAllChildren();
+    setInteractive(false);
+    setCacheAsTexture(false);
     _position = Vec2::ZERO;
     _anchor   = Vec2::ANCHOR_CENTER;
     _contentSize = Size::ZERO;
@@ -273,6 +293,11 @@ void SceneNode::dispose() {
     _hashOfName = 0;
     _priority = 0.0f;
     _json = nullptr;
+    _deferred = nullptr;
+    _bounds = Rect::ZERO;
+    _boundsDirty = true;
+    _worldDirty = true;
+    _inverseDirty = true;
 }
 
 /**
@@ -303,6 +328,8 @@ std::shared_ptr<SceneNode> SceneNode::copy(const std::shared_ptr<SceneNode>& dst
     dst->_hashOfName = _hashOfName;
     dst->_priority = _priority;
     dst->_json = _json;
+    dst->invalidateBounds();
+    dst->invalidateWorld();
     return dst;
 }
 
@@ -340,8 +367,16 @@ void SceneNode::setPosition(float x, float y) {
  * @param size  The untransformed size of the node.
  */
 void SceneNode::setContentSize(const Size size) {
+    if (_parent && _parent->_layout && !_parent->_inLayout && size != _contentSize) {
+        _parent->setNeedsLayout();
+    }
     _position += _anchor*(size-_contentSize);
     _contentSize.set(size);
+    invalidateBounds();
+    invalidateCache();
+    if (_interactive && _graph) {
+        _graph->dirtyPickable(this);
+    }
     if (!_useTransform) updateTransform();
     if (_layout) {
         doLayout();
@@ -427,14 +462,43 @@ Size SceneNode::getSize() const {
  * This matrix is used to convert node coordinates into OpenGL coordinates.
  * It is the recursive (left-multiplied) transforms of all of its descendents.
  *
+ * This matrix is cached, and is only recomputed when the transform of this
+ * node or one of its ancestors changes. So repeated calls are O(1).
+ *
  * @return the matrix transforming node space to world space.
  */
-Affine2 SceneNode::getNodeToWorldTransform() const {
-    Affine2 result = _combined;
-    if (_parent) {
-        // Multiply on left
-        Affine2::multiply(result,_parent->getNodeToWorldTransform(),&result);
+const Affine2& SceneNode::getNodeToWorldTransform() const {
+    if (_worldDirty) {
+        if (_parent) {
+            // Multiply on left
+            Affine2::multiply(_combined,_parent->getNodeToWorldTransform(),&_world);
+        } else {
+            _world = _combined;
+        }
+        _worldDirty = false;
     }
+    return _world;
+}
+
+/**
+ * Returns the transform to draw this node with, given its parent transform.
+ *
+ * This is the product of the node-to-parent transform and the given
+ * transform. When the given transform is the node-to-world transform of
+ * the parent (as it is when a {@link Scene2} renders), this method
+ * returns the cached node-to-world transform instead of recomputing it.
+ *
+ * @param transform The parent-to-world transform used for rendering
+ *
+ * @return the transform to draw this node with, given its parent transform.
+ */
+Affine2 SceneNode::getRenderTransform(const Affine2& transform) const {
+    const Affine2& base = _parent ? _parent->getNodeToWorldTransform() : Affine2::IDENTITY;
+    if (transform == base) {
+        return getNodeToWorldTransform();
+    }
+    Affine2 result;
+    Affine2::multiply(_combined,transform,&result);
     return result;
 }
 
@@ -492,6 +556,11 @@ Vec2 SceneNode::nodeToScreenCoords(const Vec2 nodePoint) const {
  * transform, and positional translation, in that order.
  */
 void SceneNode::updateTransform() {
+    invalidateBounds();
+    invalidateWorld();
+    if (_parent) {
+        _parent->invalidateCache();
+    }
     Vec2 offset = _anchor*getContentSize();
     if (_useTransform) {
         Affine2::createTranslation(_position.x-offset.x, _position.y-offset.y, &_combined);
@@ -506,6 +575,27 @@ void SceneNode::updateTransform() {
      }
 }
 
+/**
+ * Marks the cached world transforms of this node and its descendants invalid.
+ *
+ * This method must be called whenever the node-to-parent transform of this
+ * node changes, or when this node changes parents.
+ */
+void SceneNode::invalidateWorld() {
+    _inverseDirty = true;
+    if (_worldDirty) {
+        // A node is only computed after its parent, so descendants are dirty too
+        return;
+    }
+    _worldDirty = true;
+    if (_interactive && _graph) {
+        _graph->dirtyPickable(this);
+    }
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        (*it)->invalidateWorld();
+    }
+}
+
 
 #pragma mark -
 #pragma mark Scene Graph
@@ -605,7 +695,11 @@ void SceneNode::addChild(const std::shared_ptr<SceneNode>& child) {
     // Add the child
     _children.push_back(child);
     child->setParent(this);
+    child->invalidateWorld();
     child->pushScene(_graph);
+    invalidateBounds();
+    invalidateCache();
+    setNeedsLayout();
     
 }
 
@@ -628,8 +722,13 @@ void SceneNode::swapChild(const std::shared_ptr<SceneNode>& child1,
     child2->_childOffset = child1->_childOffset;
     child2->setParent(this);
     child1->setParent(nullptr);
+    child2->invalidateWorld();
+    child1->invalidateWorld();
     child2->pushScene(_graph);
     child1->pushScene(nullptr);
+    invalidateBounds();
+    invalidateCache();
+    setNeedsLayout();
     
     // Check if we are dirty and/or inherit children
     if (inherit) {
@@ -653,6 +752,7 @@ void SceneNode::removeChild(unsigned int pos) {
     CUAssertLog(pos < _children.size(), "Position index out of bounds");
     std::shared_ptr<SceneNode> child = _children[pos];
     child->setParent(nullptr);
+    child->invalidateWorld();
     child->pushScene(nullptr);
     child->_childOffset = -1;
     for(int ii = pos; ii < _children.size()-1; ii++) {
@@ -660,6 +760,9 @@ void SceneNode::removeChild(unsigned int pos) {
         _children[ii]->_childOffset = ii;
     }
     _children.resize(_children.size()-1);
+    invalidateBounds();
+    invalidateCache();
+    setNeedsLayout();
 }
 
 /**
@@ -719,10 +822,14 @@ void SceneNode::removeChildByName(const std::string name) {
 void SceneNode::removeAllChildren() {
     for(auto it = _children.begin(); it != _children.end(); ++it) {
         (*it)->setParent(nullptr);
+        (*it)->invalidateWorld();
         (*it)->_childOffset = -1;
         (*it)->pushScene(nullptr);
     }
     _children.clear();
+    invalidateBounds();
+    invalidateCache();
+    setNeedsLayout();
 }
 
 /**
@@ -734,6 +841,13 @@ void SceneNode::removeAllChildren() {
  * @param scene A pointer to the scene graph.
  */
 void SceneNode::pushScene(Scene2* scene) {
+    if (_interactive && _graph != scene) {
+        if (_graph) { _graph->removePickable(this); }
+        if (scene)  { scene->addPickable(this); }
+    }
+    if (_graph != scene) {
+        releaseCache();
+    }
     setScene(scene);
     for(auto it = _children.begin(); it != _children.end(); ++it) {
         (*it)->pushScene(scene);
@@ -748,12 +862,149 @@ void SceneNode::pushScene(Scene2* scene) {
  * before we can apply a layout manager to the children.
  */
 void SceneNode::doLayout() {
+    Scene2Profiler::Scope scope(Scene2Profiler::Category::LAYOUT,this);
     if (_layout) {
+        _inLayout = true;
         _layout->layout(this);
+        _inLayout = false;
+        _layoutVersion = _layout->getVersion();
+        _layoutBounds = getLayoutBounds();
     }
+    _layoutDirty = false;
+    _layoutPending = false;
     for(auto it = _children.begin(); it != _children.end(); ++it) {
-        (*it)->doLayout();
+        if ((*it)->needsLayout()) {
+            (*it)->doLayout();
+        }
+    }
+}
+
+/**
+ * Marks this node as needing to redo its layout.
+ *
+ * The layout is not performed immediately. It happens the next time
+ * {@link doLayout()} is called on this node or any of its ancestors.
+ * Changes to the size, name, or children of a node mark the appropriate
+ * nodes automatically. So do changes to the layout information of a
+ * layout manager. This method is only needed when some other state read
+ * by a layout manager has changed.
+ */
+void SceneNode::setNeedsLayout() {
+    _layoutDirty = true;
+    for(SceneNode* node = _parent; node != nullptr; node = node->_parent) {
+        node->_layoutPending = true;
+    }
+}
+
+/**
+ * Returns true if this node or one of its descendants needs layout.
+ *
+ * A node needs layout if it has been marked by {@link setNeedsLayout},
+ * if its layout information has changed, or if its layout bounds have
+ * changed since the last layout.
+ *
+ * @return true if this node or one of its descendants needs layout.
+ */
+bool SceneNode::needsLayout() const {
+    if (_layoutDirty || _layoutPending) {
+        return true;
+    } else if (_layout) {
+        return _layout->getVersion() != _layoutVersion || getLayoutBounds() != _layoutBounds;
+    }
+    return false;
+}
+
+/**
+ * Builds the children of this node if they have been deferred.
+ *
+ * This method does nothing if the children of this node are not deferred.
+ * Otherwise it builds them immediately, instead of waiting for this node
+ * to be made visible.
+ */
+void SceneNode::buildDeferredChildren() {
+    if (_deferred) {
+        // Clear first, in case the builder makes this node visible
+        std::function<void(SceneNode* node)> builder = _deferred;
+        _deferred = nullptr;
+        builder(this);
+    }
+}
+
+#pragma mark -
+#pragma mark Subtree Bounds
+/**
+ * Returns an AABB containing this node and all of its descendants.
+ *
+ * The bounding box is in the parent's coordinates. It is the union of the
+ * bounding box of this node (see {@link #getBoundingBox}) and the subtree
+ * bounds of every child. This value is cached, and is only recomputed
+ * when a transform, content size, or child in this subtree changes.
+ *
+ * These bounds assume that every node draws inside of its content size.
+ * They are used by {@link Scene2#setCulling} to skip off-screen subtrees.
+ *
+ * @return an AABB containing this node and all of its descendants.
+ */
+const Rect& SceneNode::getSubtreeBounds() {
+    if (_boundsDirty) {
+        _bounds = _combined.transform(computeSubtreeBounds());
+        _boundsDirty = false;
+    }
+    return _bounds;
+}
+
+/**
+ * Returns an AABB containing this node and all of its descendants.
+ *
+ * Unlike {@link #getSubtreeBounds}, this bounding box is in the coordinate
+ * space of this node, and it is never cached. Subclasses that transform
+ * their children (such as {@link ScrollPane}) should override this method.
+ *
+ * @return an AABB containing this node and all of its descendants.
+ */
+Rect SceneNode::computeSubtreeBounds() {
+    Rect result(Vec2::ZERO,_contentSize);
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        result.merge((*it)->getSubtreeBounds());
+    }
+    return result;
+}
+
+/**
+ * Marks the subtree bounds of this node and its ancestors as invalid.
+ *
+ * Subclasses should call this method whenever they change how their
+ * children are positioned.
+ */
+void SceneNode::invalidateBounds() {
+    // A dirty node always has dirty ancestors, so we can stop early
+    SceneNode* node = this;
+    while (node != nullptr && !node->_boundsDirty) {
+        node->_boundsDirty = true;
+        node = node->_parent;
+    }
+}
+
+/**
+ * Returns true if this subtree is entirely outside the scene view.
+ *
+ * This method always returns false if the node is not in a scene, or if
+ * culling is disabled for the scene (see {@link Scene2#setCulling}).
+ * Otherwise, it compares the subtree bounds of this node, transformed by
+ * the given parent-to-world transform, with the view of the scene camera.
+ *
+ * @param transform The transform from parent to world coordinates
+ *
+ * @return true if this subtree is entirely outside the scene view.
+ */
+bool SceneNode::isCulled(const Affine2& transform) {
+    if (_preculled) {
+        _preculled = false;
+        return false;
+    } else if (_graph == nullptr || !_graph->isCulling()) {
+        return false;
     }
+    return !transform.transform(getSubtreeBounds()).doesIntersect(_graph->getCullRect());
 }
 
 #pragma mark -
@@ -773,10 +1024,14 @@ void SceneNode::doLayout() {
  * @param tint      The tint to blend with the Node color.
  */
 void SceneNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {
-    if (!_isVisible) { return; }
+    if (!_isVisible || isCulled(transform)) { return; }
+    Scene2Profiler::Scope scope(Scene2Profiler::Category::RENDER,this);
     
-    Affine2 matrix;
-    Affine2::multiply(_combined,transform,&matrix);
+    Affine2 matrix = getRenderTransform(transform);
+    if (_cacheTexture && drawCache(batch,matrix,tint)) {
+        return;
+    }
+
     Color4 color = _tintColor;
     if (_hasParentColor) {
         color *= tint;
@@ -793,8 +1048,34 @@ void SceneNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2&
     }
 
     draw(batch,matrix,color);
-    for(auto it = _children.begin(); it != _children.end(); ++it) {
-        (*it)->render(batch, matrix, color);
+    if (_graph != nullptr && _graph->isCulling() && _children.size() >= CULL_BATCH) {
+        // Cull the children as a batch so that each check is a few vector ops
+        float x[CULL_CHUNK], y[CULL_CHUNK], hx[CULL_CHUNK], hy[CULL_CHUNK];
+        float zero[CULL_CHUNK] = { 0 };
+        Uint32 mask[CULL_CHUNK/32];
+        const Frustum& frustum = _graph->getCullFrustum();
+        for(size_t ii = 0; ii < _children.size(); ii += CULL_CHUNK) {
+            size_t size = std::min((size_t)CULL_CHUNK,_children.size()-ii);
+            for(size_t jj = 0; jj < size; jj++) {
+                Rect box = matrix.transform(_children[ii+jj]->getSubtreeBounds());
+                hx[jj] = box.size.width/2;
+                hy[jj] = box.size.height/2;
+                x[jj] = box.origin.x+hx[jj];
+                y[jj] = box.origin.y+hy[jj];
+            }
+            frustum.cullBoxes(x,y,zero,hx,hy,zero,size,mask,false);
+            for(size_t jj = 0; jj < size; jj++) {
+                const std::shared_ptr<SceneNode>& child = _children[ii+jj];
+                if (child->_isVisible && (mask[jj/32] & (1u << (jj%32)))) {
+                    child->_preculled = true;
+                    child->render(batch, matrix, color);
+                }
+            }
+        }
+    } else {
+        for(auto it = _children.begin(); it != _children.end(); ++it) {
+            (*it)->render(batch, matrix, color);
+        }
     }
 
     if (_scissor) {
@@ -819,3 +1100,212 @@ Color4 SceneNode::getAbsoluteColor() {
     return result;
 }
 
+/**
+ * Sets whether this node can be found by {@link Scene2#pick}.
+ *
+ * Interactive nodes are stored in the pick index of their scene, which
+ * makes it fast to find the node under a touch or mouse click. UI widgets
+ * (such as {@link Button}) are interactive while they are active. The
+ * default value is false.
+ *
+ * @param value Whether this node can be found by {@link Scene2#pick}.
+ */
+void SceneNode::setInteractive(bool value) {
+    if (value == _interactive) {
+        return;
+    }
+    _interactive = value;
+    if (_graph) {
+        if (value) {
+            _graph->addPickable(this);
+        } else {
+            _graph->removePickable(this);
+        }
+    }
+}
+
+
+/**
+ * Sets whether this subtree is drawn from a cached texture.
+ *
+ * A cached subtree is drawn once to an offscreen texture, and that texture
+ * is drawn as a single quad on every frame after. The texture is only
+ * redrawn when something in the subtree changes (see {@link #invalidateCache}).
+ * This is ideal for large, static subtrees such as backgrounds and HUD
+ * panels. Moving, rotating, or tinting this node does not redraw the
+ * texture. The default value is false.
+ *
+ * The texture has one pixel per unit of node space, so a cached node that
+ * is scaled up will look blurry. The texture is borrowed from a pool in
+ * the scene, and so the node is only cached while it is in a scene. Nodes
+ * rendered to a {@link Scene2Texture}, or with a parallel recording, are
+ * drawn normally whenever the texture is out of date.
+ *
+ * @param value Whether this subtree is drawn from a cached texture.
+ */
+void SceneNode::setCacheAsTexture(bool value) {
+    _cacheTexture = value;
+    _cacheDirty = true;
+    if (!value) {
+        releaseCache();
+    }
+}
+
+/**
+ * Marks the cached textures of this node and its ancestors as out of date.
+ *
+ * This method is called automatically when a node is added, removed,
+ * resized, moved, recolored, or changes its drawing data. Custom nodes
+ * should call it whenever their {@link #draw} method would produce a
+ * different result. It does nothing if no ancestor is cached.
+ */
+void SceneNode::invalidateCache() {
+    // Caches may be nested, so we cannot stop early
+    for(SceneNode* node = this; node != nullptr; node = node->_parent) {
+        if (node->_cacheTexture) {
+            node->_cacheDirty = true;
+        }
+    }
+}
+
+/**
+ * Draws the cached texture of this subtree, returning true on success.
+ *
+ * If the texture is out of date, this method redraws it first. This
+ * method returns false if the texture is out of date and cannot be
+ * redrawn with this sprite batch. In that case the subtree should be
+ * drawn normally.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ * @param transform The node-to-world transform of this node.
+ * @param tint      The tint inherited from the parent.
+ *
+ * @return true if the cached texture was drawn
+ */
+bool SceneNode::drawCache(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {
+    if (_graph == nullptr || batch->isRecorder()) {
+        return false;
+    } else if (_cacheDirty && (_graph->_offscreen || !bakeCache(batch))) {
+        return false;
+    } else if (_cacheRegion == nullptr) {
+        // Nothing to draw
+        return true;
+    }
+
+    // The texture is premultiplied, so the tint must be as well
+    Color4 color = _hasParentColor ? tint : Color4::WHITE;
+    color.premultiply();
+
+    GLenum srcRGB = batch->getSrcBlendRGB();
+    GLenum srcAlpha = batch->getSrcBlendAlpha();
+    GLenum dstRGB = batch->getDstBlendRGB();
+    GLenum dstAlpha = batch->getDstBlendAlpha();
+    batch->setSrcBlendFunc(GL_ONE);
+    batch->setDstBlendFunc(GL_ONE_MINUS_SRC_ALPHA);
+    batch->draw(_cacheRegion,color,_cacheBounds,Vec2::ZERO,transform);
+    batch->setSrcBlendFunc(srcRGB,srcAlpha);
+    batch->setDstBlendFunc(dstRGB,dstAlpha);
+    return true;
+}
+
+/**
+ * Redraws the cached texture of this subtree, returning true on success.
+ *
+ * The sprite batch is ended and restarted with the same perspective,
+ * with all other drawing state restored.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ *
+ * @return true if the cached texture was redrawn
+ */
+bool SceneNode::bakeCache(const std::shared_ptr<SpriteBatch>& batch) {
+    if (!batch->isDrawing()) {
+        return false;
+    }
+
+    Rect bounds = computeSubtreeBounds();
+    Uint32 width  = (Uint32)ceilf(bounds.size.width);
+    Uint32 height = (Uint32)ceilf(bounds.size.height);
+    if (width == 0 || height == 0) {
+        releaseCache();
+        _cacheBounds = bounds;
+        _cacheDirty = false;
+        return true;
+    }
+
+    if (_cache == nullptr || (Uint32)_cache->getWidth() < width || (Uint32)_cache->getHeight() < height) {
+        releaseCache();
+        _cache = _graph->acquireTarget(width,height);
+        if (_cache == nullptr) {
+            return false;
+        }
+    }
+    float tw = (float)_cache->getWidth();
+    float th = (float)_cache->getHeight();
+
+    // Save the batch state, as ending the batch resets it
+    Mat4 perspective = batch->getPerspective();
+    std::shared_ptr<Texture> texture = batch->getTexture();
+    std::shared_ptr<Scissor> scissor = batch->getScissor();
+    Color4 color = batch->getColor();
+    GLenum srcRGB = batch->getSrcBlendRGB();
+    GLenum srcAlpha = batch->getSrcBlendAlpha();
+    GLenum dstRGB = batch->getDstBlendRGB();
+    GLenum dstAlpha = batch->getDstBlendAlpha();
+    GLenum equation = batch->getBlendEquation();
+    batch->end();
+
+    // Flip the y axis for texture write (like Scene2Texture)
+    float top = bounds.origin.y+bounds.size.height;
+    Mat4 ortho = Mat4::createOrthographicOffCenter(bounds.origin.x, bounds.origin.x+tw,
+                                                   top, top-th, -1, 1);
+    _cache->setClearColor(Color4::CLEAR);
+    _cache->begin();
+    batch->begin(ortho);
+
+    // Accumulate premultiplied alpha so the texture composites correctly
+    batch->setSrcBlendFunc(GL_SRC_ALPHA,GL_ONE);
+    batch->setDstBlendFunc(GL_ONE_MINUS_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+    batch->setBlendEquation(GL_FUNC_ADD);
+    batch->setScissor(_scissor ? Scissor::alloc(_scissor) : nullptr);
+
+    // Nodes may invalidate the cache while drawing (e.g. to animate)
+    _cacheDirty = false;
+
+    // The descendants are in node space, not the camera view
+    bool culling = _graph->_culling;
+    _graph->_culling = false;
+    draw(batch,Affine2::IDENTITY,_tintColor);
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        (*it)->render(batch, Affine2::IDENTITY, _tintColor);
+    }
+    _graph->_culling = culling;
+
+    batch->end();
+    _cache->end();
+
+    batch->begin(perspective);
+    batch->setSrcBlendFunc(srcRGB,srcAlpha);
+    batch->setDstBlendFunc(dstRGB,dstAlpha);
+    batch->setBlendEquation(equation);
+    batch->setScissor(scissor);
+    batch->setColor(color);
+    batch->setTexture(texture);
+
+    _cacheRegion = _cache->getTexture()->getSubTexture(0, bounds.size.width/tw,
+                                                       0, bounds.size.height/th);
+    _cacheBounds = bounds;
+    return true;
+}
+
+/**
+ * Returns the cached texture (if any) to the pool of the scene.
+ */
+void SceneNode::releaseCache() {
+    if (_cache != nullptr && _graph != nullptr) {
+        _graph->releaseTarget(_cache);
+    }
+    _cache = nullptr;
+    _cacheRegion = nullptr;
+    _cacheDirty = true;
+}
@@ -0,0 +1,474 @@
+//
+//  CUSpriteLayerNode.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a scene graph node for a large number of simple
+//  sprites, such as tiles or bullets. A scene graph node is too heavy for
+//  this purpose, as it has a name, a child list, layout data and more. This
+//  node instead stores each sprite as a small record in a contiguous array.
+//  The sprites are referenced by handle, culled as a batch, and drawn to the
+//  SpriteBatch as sprite instances in a single call.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/scene2/graph/CUSpriteLayerNode.h>
+#include <cugl/scene2/CUScene2.h>
+#include <cugl/render/CUSpriteBatch.h>
+#include <cugl/util/CUDebug.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+/** The number of sprites culled at once */
+#define LAYER_CULL_CHUNK    64
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates an empty sprite layer node.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+SpriteLayerNode::SpriteLayerNode() : SceneNode(),
+_texture(nullptr),
+_blendEquation(GL_FUNC_ADD),
+_srcFactor(GL_SRC_ALPHA),
+_dstFactor(GL_ONE_MINUS_SRC_ALPHA),
+_extentDirty(false) {
+    _classname = "SpriteLayerNode";
+}
+
+/**
+ * Disposes all of the resources used by this node.
+ *
+ * A disposed node can be safely reinitialized. Any children owned by this
+ * node will be released. They will be deleted if no other object owns them.
+ *
+ * It is unsafe to call this on a node that is still currently inside of
+ * a scene graph.
+ */
+void SpriteLayerNode::dispose() {
+    _texture = nullptr;
+    _blendEquation = GL_FUNC_ADD;
+    _srcFactor = GL_SRC_ALPHA;
+    _dstFactor = GL_ONE_MINUS_SRC_ALPHA;
+    _sprites.clear();
+    _owners.clear();
+    _slots.clear();
+    _freed.clear();
+    _instances.clear();
+    _extent = Rect::ZERO;
+    _extentDirty = false;
+    SceneNode::dispose();
+}
+
+/**
+ * Initializes a sprite layer with the given texture.
+ *
+ * The texture is typically an atlas, and each sprite draws a region of
+ * it. If the texture is nullptr, each sprite is a solid rectangle.
+ *
+ * @param texture   The texture of the sprites
+ *
+ * @return true if initialization was successful.
+ */
+bool SpriteLayerNode::initWithTexture(const std::shared_ptr<Texture>& texture) {
+    if (!SceneNode::init()) {
+        return false;
+    }
+    _texture = texture;
+    return true;
+}
+
+#pragma mark -
+#pragma mark Rendering Attributes
+/**
+ * Sets the texture of the sprites
+ *
+ * If this value is nullptr, each sprite is a solid rectangle. Changing
+ * the texture resets the region of every sprite to the entire texture.
+ *
+ * @param texture   The texture of the sprites
+ */
+void SpriteLayerNode::setTexture(const std::shared_ptr<Texture>& texture) {
+    _texture = texture;
+    Vec2 texmin = Vec2::ZERO;
+    Vec2 texmax = Vec2::ONE;
+    if (_texture != nullptr) {
+        texmin.set(_texture->getMinS(),_texture->getMinT());
+        texmax.set(_texture->getMaxS(),_texture->getMaxT());
+    }
+    for(auto it = _sprites.begin(); it != _sprites.end(); ++it) {
+        it->texmin = texmin;
+        it->texmax = texmax;
+    }
+    invalidateCache();
+}
+
+#pragma mark -
+#pragma mark Sprites
+/**
+ * Reserves space for the given number of sprites
+ *
+ * This method allows the sprite arrays to be allocated once, up front.
+ *
+ * @param capacity  The number of sprites to reserve space for
+ */
+void SpriteLayerNode::reserve(size_t capacity) {
+    _sprites.reserve(capacity);
+    _owners.reserve(capacity);
+    _slots.reserve(capacity);
+    _instances.reserve(capacity);
+}
+
+/**
+ * Returns the handle of a newly added sprite
+ *
+ * The sprite is white, has no rotation, and draws the entire texture.
+ * The position is the center of the sprite in node space.
+ *
+ * @param position  The center of the sprite
+ * @param size      The width and height of the sprite
+ *
+ * @return the handle of a newly added sprite
+ */
+Uint32 SpriteLayerNode::addSprite(const Vec2 position, const Size size) {
+    Uint32 handle;
+    if (_freed.empty()) {
+        handle = (Uint32)_slots.size();
+        _slots.push_back(SPRITE_LAYER_NONE);
+    } else {
+        handle = _freed.back();
+        _freed.pop_back();
+    }
+    _slots[handle] = (Uint32)_sprites.size();
+    _owners.push_back(handle);
+
+    Sprite sprite;
+    sprite.position = position;
+    sprite.size.set(size.width,size.height);
+    sprite.angle = 0;
+    sprite.color = Color4::WHITE;
+    if (_texture != nullptr) {
+        sprite.texmin.set(_texture->getMinS(),_texture->getMinT());
+        sprite.texmax.set(_texture->getMaxS(),_texture->getMaxT());
+    } else {
+        sprite.texmin = Vec2::ZERO;
+        sprite.texmax = Vec2::ONE;
+    }
+    _sprites.push_back(sprite);
+    invalidateExtent();
+    return handle;
+}
+
+/**
+ * Returns the handle of a newly added sprite
+ *
+ * The sprite is white, has no rotation, and draws the given region of
+ * the texture. The region is in pixels, with the origin at the bottom
+ * left corner of the texture. The position is the center of the sprite
+ * in node space.
+ *
+ * @param position  The center of the sprite
+ * @param size      The width and height of the sprite
+ * @param region    The region of the texture in pixels
+ *
+ * @return the handle of a newly added sprite
+ */
+Uint32 SpriteLayerNode::addSprite(const Vec2 position, const Size size, const Rect region) {
+    Uint32 handle = addSprite(position,size);
+    applyRegion(_sprites.back(),region);
+    return handle;
+}
+
+/**
+ * Removes the sprite with the given handle
+ *
+ * The last sprite of this layer takes the place of the removed one in
+ * the drawing order. The handle may be reused by a later sprite.
+ *
+ * @param handle    The sprite handle
+ */
+void SpriteLayerNode::removeSprite(Uint32 handle) {
+    if (!isValid(handle)) {
+        CUAssertLog(false, "Sprite handle %u is invalid", handle);
+        return;
+    }
+    Uint32 slot = _slots[handle];
+    Uint32 last = (Uint32)_sprites.size()-1;
+    if (slot != last) {
+        _sprites[slot] = _sprites[last];
+        _owners[slot] = _owners[last];
+        _slots[_owners[slot]] = slot;
+    }
+    _sprites.pop_back();
+    _owners.pop_back();
+    _slots[handle] = SPRITE_LAYER_NONE;
+    _freed.push_back(handle);
+    invalidateExtent();
+}
+
+/**
+ * Removes all of the sprites in this layer
+ *
+ * This invalidates every handle.
+ */
+void SpriteLayerNode::clearSprites() {
+    _sprites.clear();
+    _owners.clear();
+    _slots.clear();
+    _freed.clear();
+    invalidateExtent();
+}
+
+/**
+ * Returns the sprite with the given handle
+ *
+ * The handle must be valid.
+ *
+ * @param handle    The sprite handle
+ *
+ * @return the sprite with the given handle
+ */
+const SpriteLayerNode::Sprite& SpriteLayerNode::getSprite(Uint32 handle) const {
+    CUAssertLog(isValid(handle), "Sprite handle %u is invalid", handle);
+    return _sprites[_slots[handle]];
+}
+
+/**
+ * Sets the center of the sprite with the given handle
+ *
+ * @param handle    The sprite handle
+ * @param position  The center of the sprite in node space
+ */
+void SpriteLayerNode::setSpritePosition(Uint32 handle, const Vec2 position) {
+    CUAssertLog(isValid(handle), "Sprite handle %u is invalid", handle);
+    _sprites[_slots[handle]].position = position;
+    invalidateExtent();
+}
+
+/**
+ * Sets the size of the sprite with the given handle
+ *
+ * @param handle    The sprite handle
+ * @param size      The width and height of the sprite
+ */
+void SpriteLayerNode::setSpriteSize(Uint32 handle, const Size size) {
+    CUAssertLog(isValid(handle), "Sprite handle %u is invalid", handle);
+    _sprites[_slots[handle]].size.set(size.width,size.height);
+    invalidateExtent();
+}
+
+/**
+ * Sets the angle of the sprite with the given handle
+ *
+ * @param handle    The sprite handle
+ * @param angle     The angle of the sprite in radians (counter clockwise)
+ */
+void SpriteLayerNode::setSpriteAngle(Uint32 handle, float angle) {
+    CUAssertLog(isValid(handle), "Sprite handle %u is invalid", handle);
+    _sprites[_slots[handle]].angle = angle;
+    invalidateCache();
+}
+
+/**
+ * Sets the color of the sprite with the given handle
+ *
+ * The color is tinted by the color of this node when drawn.
+ *
+ * @param handle    The sprite handle
+ * @param color     The color of the sprite
+ */
+void SpriteLayerNode::setSpriteColor(Uint32 handle, Color4 color) {
+    CUAssertLog(isValid(handle), "Sprite handle %u is invalid", handle);
+    _sprites[_slots[handle]].color = color;
+    invalidateCache();
+}
+
+/**
+ * Sets the texture region of the sprite with the given handle
+ *
+ * The region is in pixels, with the origin at the bottom left corner of
+ * the texture. This method has no effect if there is no texture.
+ *
+ * @param handle    The sprite handle
+ * @param region    The region of the texture in pixels
+ */
+void SpriteLayerNode::setSpriteRegion(Uint32 handle, const Rect region) {
+    CUAssertLog(isValid(handle), "Sprite handle %u is invalid", handle);
+    applyRegion(_sprites[_slots[handle]],region);
+    invalidateCache();
+}
+
+#pragma mark -
+#pragma mark Rendering
+/**
+ * Draws this node via the given SpriteBatch.
+ *
+ * This method only worries about drawing the current node. It does not
+ * attempt to render the children.
+ *
+ * The sprites are culled as a batch, and the visible ones are drawn as
+ * sprite instances in a single call. As the instances do not have a
+ * transform, the sprites are transformed now.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ * @param transform The global transformation matrix.
+ * @param tint      The tint to blend with the Node color.
+ */
+void SpriteLayerNode::draw(const std::shared_ptr<SpriteBatch>& batch,
+                           const Affine2& transform, Color4 tint) {
+    if (_sprites.empty()) {
+        return;
+    }
+
+    // Instances can rotate and scale uniformly, but cannot shear
+    const float* m = transform.m;
+    float sx = sqrtf(m[0]*m[0]+m[1]*m[1]);
+    float sy = sqrtf(m[2]*m[2]+m[3]*m[3]);
+    float rot = atan2f(m[1],m[0]);
+
+    size_t count = _sprites.size();
+    _instances.resize(count);
+    for(size_t ii = 0; ii < count; ii++) {
+        const Sprite& sprite = _sprites[ii];
+        SpriteInstance& inst = _instances[ii];
+        inst.position = transform.transform(sprite.position);
+        inst.size.set(sprite.size.x*sx,sprite.size.y*sy);
+        inst.angle = sprite.angle+rot;
+        inst.color = (sprite.color*tint).getPacked();
+        inst.texmin = sprite.texmin;
+        inst.texmax = sprite.texmax;
+    }
+
+    if (_graph != nullptr && _graph->isCulling()) {
+        // Cull a chunk at a time, compacting the visible instances in place
+        float x[LAYER_CULL_CHUNK], y[LAYER_CULL_CHUNK], h[LAYER_CULL_CHUNK];
+        float zero[LAYER_CULL_CHUNK] = { 0 };
+        Uint32 mask[LAYER_CULL_CHUNK/32];
+        const Frustum& frustum = _graph->getCullFrustum();
+        size_t kept = 0;
+        for(size_t ii = 0; ii < count; ii += LAYER_CULL_CHUNK) {
+            size_t size = std::min((size_t)LAYER_CULL_CHUNK,count-ii);
+            for(size_t jj = 0; jj < size; jj++) {
+                // The half diagonal bounds the sprite at any angle
+                const SpriteInstance& inst = _instances[ii+jj];
+                x[jj] = inst.position.x;
+                y[jj] = inst.position.y;
+                h[jj] = 0.5f*sqrtf(inst.size.x*inst.size.x+inst.size.y*inst.size.y);
+            }
+            frustum.cullBoxes(x,y,zero,h,h,zero,size,mask,false);
+            for(size_t jj = 0; jj < size; jj++) {
+                if (mask[jj/32] & (1u << (jj%32))) {
+                    _instances[kept++] = _instances[ii+jj];
+                }
+            }
+        }
+        _instances.resize(kept);
+        if (kept == 0) {
+            return;
+        }
+    }
+
+    batch->setBlendEquation(_blendEquation);
+    batch->setSrcBlendFunc(_srcFactor);
+    batch->setDstBlendFunc(_dstFactor);
+    batch->drawInstances(_texture,_instances.data(),_instances.size());
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns an AABB containing this node and all of its descendants.
+ *
+ * This bounding box includes the sprites, which may lie outside of the
+ * content bounds of this node.
+ *
+ * @return an AABB containing this node and all of its descendants.
+ */
+Rect SpriteLayerNode::computeSubtreeBounds() {
+    Rect result = SceneNode::computeSubtreeBounds();
+    if (_sprites.empty()) {
+        return result;
+    }
+    if (_extentDirty) {
+        float minx = _sprites[0].position.x, maxx = minx;
+        float miny = _sprites[0].position.y, maxy = miny;
+        float pad = 0;
+        for(auto it = _sprites.begin(); it != _sprites.end(); ++it) {
+            minx = std::min(minx,it->position.x);
+            maxx = std::max(maxx,it->position.x);
+            miny = std::min(miny,it->position.y);
+            maxy = std::max(maxy,it->position.y);
+            pad = std::max(pad,it->size.x*it->size.x+it->size.y*it->size.y);
+        }
+        // Pad by the largest half diagonal (sprites may be rotated)
+        pad = 0.5f*sqrtf(pad);
+        _extent.set(minx-pad,miny-pad,maxx-minx+2*pad,maxy-miny+2*pad);
+        _extentDirty = false;
+    }
+    result.merge(_extent);
+    return result;
+}
+
+/**
+ * Marks the extent of the sprites as changed
+ */
+void SpriteLayerNode::invalidateExtent() {
+    _extentDirty = true;
+    invalidateBounds();
+    invalidateCache();
+}
+
+/**
+ * Stores the texture coordinates of the given region in the sprite
+ *
+ * @param sprite    The sprite to modify
+ * @param region    The region of the texture in pixels
+ */
+void SpriteLayerNode::applyRegion(Sprite& sprite, const Rect region) const {
+    if (_texture == nullptr || _texture->getWidth() == 0 || _texture->getHeight() == 0) {
+        return;
+    }
+    // Texture coordinates have their origin at the top left
+    float minS = _texture->getMinS();
+    float maxT = _texture->getMaxT();
+    float ds = (_texture->getMaxS()-minS)/_texture->getWidth();
+    float dt = (maxT-_texture->getMinT())/_texture->getHeight();
+    sprite.texmin.set(minS+region.getMinX()*ds, maxT-region.getMaxY()*dt);
+    sprite.texmax.set(minS+region.getMaxX()*ds, maxT-region.getMinY()*dt);
+}
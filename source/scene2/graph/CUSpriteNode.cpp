@@ -218,6 +218,11 @@ void SpriteNode::updateTextureCoords() {
     if (!_rendered) {
         return;
     }
+    if (_geometry != nullptr) {
+        // Shared meshes are read-only, so regenerate on the next draw
+        clearRenderData();
+        return;
+    }
     
     Size tsize = _texture->getSize();
     Vec2 off = _bounds.origin;
@@ -251,3 +256,16 @@ void SpriteNode::updateTextureCoords() {
         }
     }
 }
+
+/**
+ * Appends the settings that determine the render data to the given key
+ *
+ * Nodes with equal keys have identical render data.
+ *
+ * @param key   The key to extend
+ */
+void SpriteNode::appendGeometryKey(std::string& key) const {
+    PolygonNode::appendGeometryKey(key);
+    key.append("SpriteNode");
+    appendKey(key,_bounds);
+}
@@ -39,11 +39,27 @@
 #include <cugl/assets/CUAssetManager.h>
 #include <cugl/render/CUGradient.h>
 #include <sstream>
+#include <unordered_map>
 
 using namespace cugl::scene2;
 
 /** For handling JSON issues */
 #define UNKNOWN_STR "<unknown>"
+/** The minimum size of the shared mesh cache before removing unused meshes */
+#define GEOMETRY_SWEEP  64
+
+/**
+ * Returns the render data shared by all textured nodes
+ *
+ * The cache does not own the render data. An entry is deleted once the last
+ * node using it releases it.
+ *
+ * @return the render data shared by all textured nodes
+ */
+static std::unordered_map<std::string, std::weak_ptr<const TexturedNode::Geometry>>& geometry_cache() {
+    static std::unordered_map<std::string, std::weak_ptr<const TexturedNode::Geometry>> cache;
+    return cache;
+}
 
 static GLenum blendEq(std::string value) {
     if (value == "GL_FUNC_SUBTRACT") {
@@ -105,6 +121,7 @@ _texture(nullptr),
 _gradient(nullptr),
 _absolute(false),
 _rendered(false),
+_shared(true),
 _blendEquation(GL_FUNC_ADD),
 _srcFactor(GL_SRC_ALPHA),
 _dstFactor(GL_ONE_MINUS_SRC_ALPHA),
@@ -133,6 +150,8 @@ void TexturedNode::dispose() {
     _flipHorizontal = false;
     _flipVertical = false;
     _mesh.clear();
+    _geometry = nullptr;
+    _shared = true;
     SceneNode::dispose();
 }
 
@@ -278,6 +297,8 @@ std::shared_ptr<SceneNode> TexturedNode::copy(const std::shared_ptr<SceneNode>&
         node->_rendered = _rendered;
         node->_offset = _offset;
         node->_mesh   = _mesh;
+        node->_geometry = _geometry;
+        node->_shared = _shared;
 
         node->_blendEquation = _blendEquation;
         node->_srcFactor = _srcFactor;
@@ -397,7 +418,108 @@ void TexturedNode::setContentSize(const Size size) {
  */
 void TexturedNode::clearRenderData() {
     _mesh.clear();
+    _geometry = nullptr;
     _rendered = false;
+    invalidateCache();
+}
+
+/**
+ * Appends the settings that determine the render data to the given key
+ *
+ * Nodes with equal keys have identical render data. This method appends
+ * the texture attributes. Subclasses should call this method and then
+ * append a tag for the class, followed by their geometry settings.
+ *
+ * @param key   The key to extend
+ */
+void TexturedNode::appendGeometryKey(std::string& key) const {
+    // A node holding the geometry also holds the texture, so the address is safe
+    appendKey(key,_texture.get());
+    appendKey(key,_offset);
+    appendKey(key,_contentSize);
+    Uint8 flags = (_absolute ? 1 : 0) | (_flipHorizontal ? 2 : 0) |
+                  (_flipVertical ? 4 : 0) | (_gradient != nullptr ? 8 : 0);
+    appendKey(key,flags);
+}
+
+/**
+ * Returns true if this node found shared render data for the given key
+ *
+ * If successful, this node will draw the shared mesh. This method always
+ * fails if sharing is disabled.
+ *
+ * @param key   The render data key (see {@link #appendGeometryKey})
+ *
+ * @return true if this node found shared render data for the given key
+ */
+bool TexturedNode::acquireGeometry(const std::string& key) {
+    if (!_shared) {
+        return false;
+    }
+    auto& cache = geometry_cache();
+    auto it = cache.find(key);
+    if (it == cache.end()) {
+        return false;
+    }
+    _geometry = it->second.lock();
+    if (_geometry == nullptr) {
+        cache.erase(it);
+        return false;
+    }
+    _mesh.clear();
+    return true;
+}
+
+/**
+ * Shares the render data of this node under the given key
+ *
+ * The node mesh is moved into the given geometry, which becomes read-only.
+ * Subclasses should set any extra attributes of the geometry beforehand.
+ * This method does nothing if sharing is disabled.
+ *
+ * @param key       The render data key (see {@link #appendGeometryKey})
+ * @param geometry  The geometry to share
+ */
+void TexturedNode::shareGeometry(const std::string& key, const std::shared_ptr<Geometry>& geometry) {
+    if (!_shared) {
+        return;
+    }
+    geometry->mesh = std::move(_mesh);
+    _mesh = Mesh<SpriteVertex2>();
+    _geometry = geometry;
+
+    // Drop unused meshes whenever the cache doubles in size
+    static size_t limit = GEOMETRY_SWEEP;
+    auto& cache = geometry_cache();
+    if (cache.size() >= limit) {
+        for(auto it = cache.begin(); it != cache.end(); ) {
+            if (it->second.expired()) {
+                it = cache.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        limit = std::max((size_t)GEOMETRY_SWEEP,2*cache.size());
+    }
+    cache[key] = _geometry;
+}
+
+/**
+ * Returns the number of distinct meshes shared by textured nodes
+ *
+ * This only counts meshes that are still in use by some node.
+ *
+ * @return the number of distinct meshes shared by textured nodes
+ */
+size_t TexturedNode::getGeometryCacheSize() {
+    size_t result = 0;
+    auto& cache = geometry_cache();
+    for(auto it = cache.begin(); it != cache.end(); ++it) {
+        if (!it->second.expired()) {
+            result++;
+        }
+    }
+    return result;
 }
 
 
@@ -557,7 +557,7 @@ void WireNode::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& tr
     batch->setBlendEquation(_blendEquation);
     batch->setSrcBlendFunc(_srcFactor);
     batch->setDstBlendFunc(_dstFactor);
-    batch->drawMesh(_mesh, transform);
+    batch->drawMesh(getRenderMesh(), transform);
     batch->setGradient(nullptr);
 }
 
@@ -569,6 +569,15 @@ void WireNode::generateRenderData() {
     if (_texture == nullptr) {
         return;
     }
+
+    std::string key;
+    if (_shared) {
+        appendGeometryKey(key);
+        if (acquireGeometry(key)) {
+            _rendered = true;
+            return;
+        }
+    }
     
     // Adjust the mesh as necesary
     Size nsize = getContentSize();
@@ -603,6 +612,9 @@ void WireNode::generateRenderData() {
     
     _rendered = true;
     updateTextureCoords();
+    if (_shared) {
+        shareGeometry(key);
+    }
 }
 
 /**
@@ -616,6 +628,11 @@ void WireNode::updateTextureCoords() {
     if (!_rendered) {
         return;
     }
+    if (_geometry != nullptr) {
+        // Shared meshes are read-only, so regenerate on the next draw
+        clearRenderData();
+        return;
+    }
     
     Size tsize = _texture->getSize();
     Vec2 off = _offset+_polygon.getBounds().origin;
@@ -744,3 +761,17 @@ void WireNode::makeInteriorTraversal(const Poly2& src) {
         _indices.push_back(indxs->at(ii  ));
     }
 }
+
+/**
+ * Appends the settings that determine the render data to the given key
+ *
+ * Nodes with equal keys have identical render data.
+ *
+ * @param key   The key to extend
+ */
+void WireNode::appendGeometryKey(std::string& key) const {
+    TexturedNode::appendGeometryKey(key);
+    key.append("WireNode");
+    appendKey(key,_polygon.vertices);
+    appendKey(key,_indices);
+}
@@ -122,6 +122,7 @@ bool FloatLayout::initWithData(const std::shared_ptr<JsonValue>& data) {
 void FloatLayout::dispose() {
     _entries.clear();
     _priority.clear();
+    touch();
 }
 
 
@@ -175,6 +176,7 @@ bool FloatLayout::add(const std::string key, const std::shared_ptr<JsonValue>& d
         entry.pad_bottom = 0;
     }
     _entries[key] = entry;
+    touch();
     _priority.push_back(key);
     return true;
 }
@@ -199,6 +201,7 @@ bool FloatLayout::remove(const std::string key) {
         return false;
     }
     _entries.erase(it);
+    touch();
     auto position = std::find(_priority.begin(), _priority.end(), key);
     if (position != _priority.end()) {
         _priority.erase(position);
@@ -148,6 +148,7 @@ bool GridLayout::addPosition(const std::string key, unsigned int x, unsigned int
     entry.x = x;
     entry.y = y;
     _entries[key] = entry;
+    touch();
     return true;
 }
 
@@ -169,6 +170,7 @@ bool GridLayout::remove(const std::string key) {
     auto entry = _entries.find(key);
     if (entry != _entries.end()) {
         _entries.erase(entry);
+        touch();
         return true;
     }
     return false;
@@ -223,6 +225,7 @@ void GridLayout::setGridSize(Uint32 width, Uint32 height) {
     if (validate(width,height)) {
         _gwidth  = width;
         _gheight = height;
+        touch();
     }
 }
 
@@ -343,6 +343,7 @@ bool Button::activate() {
         _active = up & down;
     }
 
+    setInteractive(_active);
     return _active;
 }
 
@@ -381,6 +382,7 @@ bool Button::deactivate() {
 
     _active = false;
     _mouse = false;
+    setInteractive(false);
 
     return success;
 }
@@ -575,6 +577,13 @@ void Button::setDown(bool down) {
  * @return true if this button contains the given screen point
  */
 bool Button::containsScreen(const Vec2 point) {
+    // The pick grid only knows the content bounds
+    if (_graph != nullptr && _graph->getPickGrid() > 0 && _bounds.size() == 0) {
+        Vec3 world = _graph->getCamera()->screenToWorldCoords(point);
+        if (!_graph->mayPick(this, Vec2(world.x,world.y))) {
+            return false;
+        }
+    }
     Vec2 local = screenToNodeCoords(point);
     if (_bounds.size() > 0) {
         return _bounds.contains(local);
@@ -45,6 +45,9 @@
 #include <cugl/assets/CUAssetManager.h>
 #include <cugl/render/CUFont.h>
 #include <cugl/render/CUTextLayout.h>
+#include <cugl/scene2/ui/CULabelBatch.h>
+#include <cugl/scene2/CUScene2.h>
+#include <cugl/util/CUStrings.h>
 
 using namespace cugl;
 using namespace cugl::scene2;
@@ -53,6 +56,8 @@ using namespace cugl::scene2;
 #define UNKNOWN_STR "<unknown>"
 /** The color for the drop shadow */
 #define DROP_COLOR  Color4(0,0,0,128)
+/** The buffer size for formatting a number */
+#define NUMBER_CHARS 64
 
 #pragma mark -
 #pragma mark Constructors
@@ -92,6 +97,7 @@ _dstFactor(GL_ONE_MINUS_SRC_ALPHA) {
  */
 void Label::dispose() {
     clearRenderData();
+    _glyphrun.clear();
     _layout = nullptr;
     _font = nullptr;
     _foreground = Color4::BLACK;
@@ -504,10 +510,18 @@ const std::string Label::getText() const {
  * Changing this value will regenerate the render data, and is potentially
  * expensive, particularly if the font is using a fallback atlas.
  *
+ * Setting the text that the label already has (without resizing) does
+ * nothing. Otherwise the glyph meshes are rebuilt in place, so text that
+ * changes every frame (e.g. a score or a timer) does not allocate new
+ * glyph runs.
+ *
  * @param text      The text for this label.
  * @param resize    Whether to resize the label to fit the new text.
  */
 void Label::setText(const std::string text, bool resize) {
+    if (!resize && text == _layout->getText()) {
+        return;
+    }
     _layout->setText(text);
     _layout->layout();
     if (resize) {
@@ -517,6 +531,52 @@ void Label::setText(const std::string text, bool resize) {
     clearRenderData();
 }
 
+/**
+ * Sets the text for this label to the given integer.
+ *
+ * This is a convenience method for counters, such as a score. The number
+ * is formatted into a stack buffer (independent of the locale) and is
+ * compared to the current text before any string is allocated. Hence
+ * setting the same number every frame costs almost nothing.
+ *
+ * @param value     The number to display
+ * @param resize    Whether to resize the label to fit the new text.
+ */
+void Label::setNumber(Sint64 value, bool resize) {
+    char buffer[NUMBER_CHARS];
+    size_t len = strtool::to_chars(value,buffer,NUMBER_CHARS);
+    if (resize || std::string_view(buffer,len) != _layout->getText()) {
+        setText(std::string(buffer,len),resize);
+    }
+}
+
+/**
+ * Sets the text for this label to the given decimal number.
+ *
+ * This is a convenience method for counters, such as a timer. The number
+ * is formatted into a stack buffer (independent of the locale) and is
+ * compared to the current text before any string is allocated. Hence
+ * setting the same number every frame costs almost nothing.
+ *
+ * The precision is the number of digits after the decimal point. If it
+ * is negative, the number is displayed with the fewest digits that
+ * represent it exactly.
+ *
+ * @param value     The number to display
+ * @param precision The number of digits after the decimal point
+ * @param resize    Whether to resize the label to fit the new text.
+ */
+void Label::setNumber(double value, int precision, bool resize) {
+    char buffer[NUMBER_CHARS];
+    size_t len = strtool::to_chars(value,buffer,NUMBER_CHARS,precision);
+    if (len == 0) {
+        // Too large for the buffer
+        setText(strtool::to_string(value,precision),resize);
+    } else if (resize || std::string_view(buffer,len) != _layout->getText()) {
+        setText(std::string(buffer,len),resize);
+    }
+}
+
 /**
  * Sets the font to use this label
  *
@@ -535,6 +595,7 @@ void Label::setFont(const std::shared_ptr<Font>& font, bool resize) {
     }
     reanchor();
     clearRenderData();
+    _glyphrun.clear();
 }
 
 /**
@@ -1041,22 +1102,49 @@ void Label::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& trans
         batch->setColor(tint*getBackground());
         batch->fill(_bounds,Vec2::ANCHOR_CENTER, transform);
     }
+    bool field = _font != nullptr && _font->hasDistanceField();
+
+    // Merge the glyphs with the other labels of the scene if possible
+    scene2::LabelBatch* merge = _graph != nullptr ? _graph->getLabelBatch().get() : nullptr;
+    if (merge != nullptr && merge->isMerging(batch)) {
+        merge->count();
+        if (_dropShadow) {
+            Affine2 offset = Affine2::createTranslation(_dropOffset);
+            offset *= transform;
+            for(auto it = _glyphrun.begin(); it != _glyphrun.end(); ++it) {
+                merge->add(it->second->mesh, it->second->texture, offset,
+                           tint*DROP_COLOR, _priority, field, true, _dropBlur);
+            }
+        }
+        for(auto it = _glyphrun.begin(); it != _glyphrun.end(); ++it) {
+            merge->add(it->second->mesh, it->second->texture, transform,
+                       tint, _priority, field);
+        }
+        return;
+    }
+
+    batch->setDistanceField(field);
     if (_dropShadow) {
         batch->setBlur(_dropBlur);
         batch->setColor(tint*DROP_COLOR);
         Affine2 offset = Affine2::createTranslation(_dropOffset);
         offset *= transform;
         for(auto it = _glyphrun.begin(); it != _glyphrun.end(); ++it) {
-            batch->setTexture(it->second->texture);
-            batch->drawMesh(it->second->mesh, offset);
+            if (!it->second->mesh.indices.empty()) {
+                batch->setTexture(it->second->texture);
+                batch->drawMesh(it->second->mesh, offset);
+            }
         }
         batch->setBlur(0);
     }
     batch->setColor(tint);
     for(auto it = _glyphrun.begin(); it != _glyphrun.end(); ++it) {
-        batch->setTexture(it->second->texture);
-        batch->drawMesh(it->second->mesh, transform);
+        if (!it->second->mesh.indices.empty()) {
+            batch->setTexture(it->second->texture);
+            batch->drawMesh(it->second->mesh, transform);
+        }
     }
+    batch->setDistanceField(false);
 }
 
 /**
@@ -1074,10 +1162,11 @@ void Label::generateRenderData() {
     Rect legal = _bounds;
     legal.origin -= _offset;
     _layout->getGlyphs(_glyphrun,legal);
+    GLuint color = _foreground.getPacked();
     for(auto it = _glyphrun.begin(); it != _glyphrun.end(); ++it) {
         for(auto jt = it->second->mesh.vertices.begin(); jt != it->second->mesh.vertices.end(); ++jt) {
             jt->position += _offset;
-            jt->color = _foreground.getPacked();
+            jt->color = color;
         }
     }
 
@@ -1086,10 +1175,17 @@ void Label::generateRenderData() {
 
 /**
  * Clears the render data, releasing all vertices and indices.
+ *
+ * The glyph runs are kept (though empty), so that the next call to
+ * {@link #generateRenderData} can reuse their storage.
  */
 void Label::clearRenderData() {
-    _glyphrun.clear();
+    // Keep the runs so that new text reuses their storage
+    for(auto it = _glyphrun.begin(); it != _glyphrun.end(); ++it) {
+        it->second->reset();
+    }
     _rendered = false;
+    invalidateCache();
 }
 
 /**
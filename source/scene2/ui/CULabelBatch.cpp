@@ -0,0 +1,265 @@
+//
+//  CULabelBatch.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module merges the text of many labels into a few draw calls. Each
+//  label normally draws its own glyph runs, and a HUD full of small labels
+//  becomes a long series of small sprite batch submissions, many of which
+//  break the batch to change the blur or distance field settings. When a
+//  scene enables label batching, every label it draws adds its transformed
+//  glyphs to this object instead. The glyphs are then drawn at the end of the
+//  scene, with one mesh for each atlas page and sort key.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/scene2/ui/CULabelBatch.h>
+#include <cugl/render/CUTexture.h>
+#include <cugl/util/CUDebug.h>
+#include <algorithm>
+
+using namespace cugl;
+using namespace cugl::scene2;
+
+#pragma mark Constructors
+/**
+ * Creates an inactive label batch.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+LabelBatch::LabelBatch() :
+_batch(nullptr),
+_active(0),
+_last(0),
+_labels(0),
+_lastLabels(0),
+_lastGroups(0) {
+}
+
+/**
+ * Disposes all of the resources used by this label batch.
+ *
+ * Any glyphs that have not been drawn are discarded.
+ */
+void LabelBatch::dispose() {
+    _batch = nullptr;
+    _groups.clear();
+    _active = 0;
+    _last = 0;
+    _labels = 0;
+    _lastLabels = 0;
+    _lastGroups = 0;
+}
+
+#pragma mark -
+#pragma mark Batching
+/**
+ * Starts merging the labels drawn to the given sprite batch.
+ *
+ * The sprite batch should be active.
+ *
+ * @param batch     The sprite batch to merge labels for
+ */
+void LabelBatch::begin(const std::shared_ptr<SpriteBatch>& batch) {
+    CUAssertLog(_batch == nullptr, "Label batch is already active");
+    _batch = batch.get();
+    _active = 0;
+    _last = 0;
+    _labels = 0;
+}
+
+/**
+ * Returns the group for the given glyphs, creating it if necessary
+ *
+ * The scissor and blend mode of the group are read from the active
+ * sprite batch.
+ *
+ * @param texture   The atlas page
+ * @param priority  The sort key
+ * @param field     Whether the page is a distance field
+ * @param shadow    Whether the glyphs are a drop shadow
+ * @param blur      The blur radius of the drop shadow
+ *
+ * @return the group for the given glyphs
+ */
+LabelBatch::Group& LabelBatch::acquire(const std::shared_ptr<Texture>& texture,
+                                       float priority, bool field, bool shadow, GLfloat blur) {
+    const std::shared_ptr<Scissor>& scissor = _batch->getScissor();
+    GLenum equation = _batch->getBlendEquation();
+    GLenum srcRGB = _batch->getSrcBlendRGB();
+    GLenum srcAlpha = _batch->getSrcBlendAlpha();
+    GLenum dstRGB = _batch->getDstBlendRGB();
+    GLenum dstAlpha = _batch->getDstBlendAlpha();
+
+    // Consecutive labels almost always share a group
+    size_t start = _last < _active ? _last : 0;
+    for(size_t kk = 0; kk < _active; kk++) {
+        Group& group = _groups[(start+kk) % _active];
+        if (group.texture == texture && group.priority == priority && group.shadow == shadow &&
+            group.scissor == scissor && group.equation == equation && group.blur == blur &&
+            group.srcRGB == srcRGB && group.srcAlpha == srcAlpha && group.dstRGB == dstRGB &&
+            group.dstAlpha == dstAlpha && group.field == field) {
+            _last = (start+kk) % _active;
+            return group;
+        }
+    }
+
+    // Reuse the meshes of an earlier frame
+    if (_active == _groups.size()) {
+        _groups.emplace_back();
+        _groups.back().mesh.command = GL_TRIANGLES;
+    }
+    Group& group = _groups[_active];
+    group.priority = priority;
+    group.shadow = shadow;
+    group.order = _active;
+    group.texture = texture;
+    group.scissor = scissor;
+    group.equation = equation;
+    group.srcRGB = srcRGB;
+    group.srcAlpha = srcAlpha;
+    group.dstRGB = dstRGB;
+    group.dstAlpha = dstAlpha;
+    group.blur = blur;
+    group.field = field;
+    group.mesh.vertices.clear();
+    group.mesh.indices.clear();
+    _last = _active++;
+    return group;
+}
+
+/**
+ * Adds the glyphs of a label to this batch.
+ *
+ * The mesh vertices are transformed, and their colors are multiplied by
+ * the given color. The scissor and blend mode are read from the sprite
+ * batch, so they should be set as if the mesh were drawn directly. The
+ * distance field and blur are not, as changing them would break the
+ * sprite batch for every label. Drop shadows are drawn beneath all of the
+ * glyphs with the same sort key.
+ *
+ * @param mesh      The glyph mesh
+ * @param texture   The atlas page of the glyphs
+ * @param transform The glyph transform
+ * @param color     The color to tint the glyphs
+ * @param priority  The sort key of the label
+ * @param field     Whether the page is a distance field
+ * @param shadow    Whether the glyphs are a drop shadow
+ * @param blur      The blur radius of the drop shadow
+ */
+void LabelBatch::add(const Mesh<SpriteVertex2>& mesh, const std::shared_ptr<Texture>& texture,
+                     const Affine2& transform, Color4 color, float priority,
+                     bool field, bool shadow, GLfloat blur) {
+    CUAssertLog(_batch != nullptr, "Label batch is not active");
+    if (mesh.indices.empty()) {
+        return;
+    }
+
+    Group& group = acquire(texture, priority, field, shadow, blur);
+    GLuint offset = (GLuint)group.mesh.vertices.size();
+    bool tint = color != Color4::WHITE;
+    for(auto it = mesh.vertices.begin(); it != mesh.vertices.end(); ++it) {
+        group.mesh.vertices.push_back(*it);
+        SpriteVertex2& vert = group.mesh.vertices.back();
+        vert.position *= transform;
+        if (tint) {
+            vert.color = (Color4(vert.color)*color).getPacked();
+        }
+    }
+    for(auto it = mesh.indices.begin(); it != mesh.indices.end(); ++it) {
+        group.mesh.indices.push_back(offset+(*it));
+    }
+}
+
+/**
+ * Draws every merged glyph and stops merging.
+ *
+ * The sprite batch must still be active. Its color, texture, scissor, blend
+ * mode, blur and distance field settings are restored afterwards.
+ */
+void LabelBatch::end() {
+    CUAssertLog(_batch != nullptr, "Label batch is not active");
+    SpriteBatch* batch = _batch;
+    _batch = nullptr;
+    _lastLabels = _labels;
+    _lastGroups = _active;
+    if (_active == 0) {
+        return;
+    }
+
+    // Sort keys first, then shadows beneath glyphs, then creation order
+    std::vector<Group*> order;
+    order.reserve(_active);
+    for(size_t ii = 0; ii < _active; ii++) {
+        order.push_back(&(_groups[ii]));
+    }
+    std::sort(order.begin(), order.end(), [](const Group* a, const Group* b) {
+        if (a->priority != b->priority) {
+            return a->priority < b->priority;
+        } else if (a->shadow != b->shadow) {
+            return a->shadow;
+        }
+        return a->order < b->order;
+    });
+
+    Color4 color = batch->getColor();
+    std::shared_ptr<Texture> texture = batch->getTexture();
+    std::shared_ptr<Scissor> scissor = batch->getScissor();
+    GLenum equation = batch->getBlendEquation();
+    GLenum srcRGB = batch->getSrcBlendRGB();
+    GLenum srcAlpha = batch->getSrcBlendAlpha();
+    GLenum dstRGB = batch->getDstBlendRGB();
+    GLenum dstAlpha = batch->getDstBlendAlpha();
+    GLfloat blur = batch->getBlur();
+    bool field = batch->getDistanceField();
+
+    batch->setColor(Color4::WHITE);
+    for(auto it = order.begin(); it != order.end(); ++it) {
+        Group* group = *it;
+        batch->setScissor(group->scissor);
+        batch->setBlendEquation(group->equation);
+        batch->setSrcBlendFunc(group->srcRGB, group->srcAlpha);
+        batch->setDstBlendFunc(group->dstRGB, group->dstAlpha);
+        batch->setDistanceField(group->field);
+        batch->setTexture(group->texture);
+        batch->setBlur(group->blur);
+        batch->drawMesh(group->mesh, Affine2::IDENTITY, false);
+
+        // Release the atlas and scissor, but keep the memory
+        group->texture = nullptr;
+        group->scissor = nullptr;
+        group->mesh.vertices.clear();
+        group->mesh.indices.clear();
+    }
+
+    batch->setBlur(0);
+    batch->setTexture(texture);
+    batch->setBlur(blur);
+    batch->setDistanceField(field);
+    batch->setDstBlendFunc(dstRGB, dstAlpha);
+    batch->setSrcBlendFunc(srcRGB, srcAlpha);
+    batch->setBlendEquation(equation);
+    batch->setScissor(scissor);
+    batch->setColor(color);
+    _active = 0;
+}
@@ -51,6 +51,7 @@
 //  Version: 11/18/21
 //
 #include <cugl/scene2/ui/CUScrollPane.h>
+#include <cugl/scene2/CUScene2Profiler.h>
 
 using namespace cugl;
 using namespace cugl::scene2;
@@ -467,7 +468,10 @@ _zoomamt(1.0f),
 _panemask(nullptr),
 _constrained(true),
 _reoriented(false),
-_simple(true) {
+_simple(true),
+_rowcount(0),
+_rowheight(0),
+_rowtop(0) {
     _panetrans.setIdentity();
     _classname = "ScrollPane";
 }
@@ -490,6 +494,13 @@ void ScrollPane::dispose() {
     _reoriented = false;
     _simple = true;
     _panemask = nullptr;
+    _rowfactory = nullptr;
+    _rowbinder = nullptr;
+    _rows.clear();
+    _rowbound.clear();
+    _rowcount = 0;
+    _rowheight = 0;
+    _rowtop = 0;
     SceneNode::dispose();
 }
 
@@ -816,6 +827,7 @@ void ScrollPane::setMasked(bool value) {
     } else {
         _panemask = nullptr;
     }
+    invalidateBounds();
 }
 
 /**
@@ -914,6 +926,8 @@ Vec2 ScrollPane::applyPan(const Vec2& delta) {
     } else {
         _panetrans.translate(delta);
     }
+    invalidateBounds();
+    updateRows();
     return result;
 }
 
@@ -976,6 +990,8 @@ float ScrollPane::applySpin(float angle) {
     _panetrans.translate(-center.x, -center.y);
     _panetrans.rotate(angle);
     _panetrans.translate(center.x, center.y);
+    invalidateBounds();
+    updateRows();
     return angle;
 }
 
@@ -1027,6 +1043,8 @@ float ScrollPane::applyZoom(float scale) {
     _panetrans.translate(-center.x, -center.y);
     _panetrans.scale(scale,scale);
     _panetrans.translate(center.x, center.y);
+    invalidateBounds();
+    updateRows();
     return scale;
 }
 
@@ -1064,8 +1082,195 @@ void ScrollPane::resetPane() {
         
         _panetrans.translate(offset);
     }
+    invalidateBounds();
+    updateRows();
 }
     
+#pragma mark -
+#pragma mark Virtual Lists
+/**
+ * Makes this scroll pane a virtual list with the given rows.
+ *
+ * A virtual list is a vertical list of rows of the given height, with the
+ * first row at the top. The interior bounds are as wide as the content
+ * bounds and tall enough to hold every row. This replaces any previous
+ * interior, and resets the pane (see {@link #resetPane}).
+ *
+ * The rows are nodes created by the factory on demand. There are only
+ * ever enough of them to cover the visible area, and they are rebound to
+ * new data indices by the binder as the pane is navigated. These nodes are
+ * added as children of this pane, and their position is managed by the
+ * pane. Other children are unaffected. A virtual list should not have a
+ * layout manager.
+ *
+ * @param count     The number of data rows
+ * @param height    The height of each row
+ * @param factory   The factory to create row nodes
+ * @param binder    The function to bind a row node to a data index
+ *
+ * @return true if the virtual list was successfully created
+ */
+bool ScrollPane::setVirtualList(size_t count, float height, RowFactory factory, RowBinder binder) {
+    if (height <= 0 || factory == nullptr || binder == nullptr) {
+        CUAssertLog(false, "Virtual list requires a positive row height, a factory, and a binder");
+        return false;
+    }
+    clearVirtualList();
+    _rowfactory = factory;
+    _rowbinder = binder;
+    _rowheight = height;
+    _rowcount = count;
+    
+    float total = std::max(count*height,_contentSize.height);
+    setInterior(Rect(0,_contentSize.height-total,_contentSize.width,total));
+    return true;
+}
+
+/**
+ * Removes the virtual list from this scroll pane.
+ *
+ * All row nodes are removed from the pane. The interior bounds are not
+ * changed.
+ */
+void ScrollPane::clearVirtualList() {
+    for(auto it = _rows.begin(); it != _rows.end(); ++it) {
+        if ((*it)->getParent() == this) {
+            removeChild(*it);
+        }
+    }
+    _rows.clear();
+    _rowbound.clear();
+    _rowfactory = nullptr;
+    _rowbinder = nullptr;
+    _rowcount = 0;
+    _rowheight = 0;
+}
+
+/**
+ * Sets the number of data rows in the virtual list.
+ *
+ * The interior bounds grow or shrink to fit the new row count, but the
+ * pane is not reset. Instead, the current pan is adjusted if necessary to
+ * stay within the new interior. All visible rows are rebound, as the data
+ * has presumably changed.
+ *
+ * @param count     The number of data rows
+ */
+void ScrollPane::setRowCount(size_t count) {
+    _rowcount = count;
+    if (_rowfactory == nullptr) {
+        return;
+    }
+    
+    // The top of the list stays fixed
+    float top   = _interior.origin.y+_interior.size.height;
+    float total = std::max(count*_rowheight,_contentSize.height);
+    _interior.origin.y = top-total;
+    _interior.size.height = total;
+    std::fill(_rowbound.begin(), _rowbound.end(), _rowcount);
+    if (_constrained) {
+        applyPan(Vec2::ZERO);
+    } else {
+        invalidateBounds();
+        updateRows();
+    }
+}
+
+/**
+ * Rebinds all of the visible rows of the virtual list.
+ *
+ * This method should be called when the data displayed by the rows has
+ * changed, but the number of rows has not.
+ */
+void ScrollPane::refreshRows() {
+    std::fill(_rowbound.begin(), _rowbound.end(), _rowcount);
+    updateRows();
+}
+
+/**
+ * Rebinds the rows of the virtual list to the visible area.
+ *
+ * Only the rows that have moved to a new data index are rebound. The
+ * pool of rows grows if the visible area needs more rows than it has.
+ * This method does nothing if this pane is not a virtual list.
+ */
+void ScrollPane::updateRows() {
+    if (_rowfactory == nullptr) {
+        return;
+    }
+    
+    // Find the visible rows in interior coordinates
+    Rect view = _panetrans.getInverse().transform(Rect(Vec2::ZERO,_contentSize));
+    float top = _interior.origin.y+_interior.size.height;
+    double lo = std::floor((top-view.getMaxY())/_rowheight);
+    double hi = std::ceil((top-view.getMinY())/_rowheight)-1;
+    lo = std::max(lo,0.0);
+    hi = std::min(hi,(double)_rowcount-1);
+    
+    size_t first = (size_t)lo;
+    size_t needed = (hi < lo ? 0 : (size_t)(hi-lo)+1);
+    
+    // Rows are placed by index, so moving the top invalidates them all
+    bool rebind = (top != _rowtop);
+    while (_rows.size() < needed) {
+        std::shared_ptr<SceneNode> row = _rowfactory();
+        CUAssertLog(row != nullptr, "Virtual list factory failed to create a row");
+        row->setAnchor(Vec2::ANCHOR_BOTTOM_LEFT);
+        addChild(row);
+        _rows.push_back(row);
+        _rowbound.push_back(_rowcount);
+        rebind = true;
+    }
+    _rowtop = top;
+    
+    // Each index has a fixed slot in the pool, so few rows are rebound on a pan
+    size_t pool = _rows.size();
+    if (pool == 0) {
+        return;
+    }
+    for(size_t ii = 0; ii < pool; ii++) {
+        size_t offset = (ii+pool-(first % pool)) % pool;
+        if (offset >= needed) {
+            if (_rows[ii]->isVisible()) {
+                _rows[ii]->setVisible(false);
+            }
+            _rowbound[ii] = _rowcount;
+            continue;
+        }
+        size_t index = first+offset;
+        if (rebind || _rowbound[ii] != index) {
+            _rowbinder(_rows[ii],index);
+            _rows[ii]->setPosition(_interior.origin.x,top-(index+1)*_rowheight);
+            _rowbound[ii] = index;
+        }
+        if (!_rows[ii]->isVisible()) {
+            _rows[ii]->setVisible(true);
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Subtree Bounds
+/**
+ * Returns an AABB containing this node and all of its descendants.
+ *
+ * The children of a scroll pane are moved by the pane transform. If the
+ * pane has a mask, the children cannot be seen outside of the mask, so only
+ * the content bounds are used.
+ *
+ * @return an AABB containing this node and all of its descendants.
+ */
+Rect ScrollPane::computeSubtreeBounds() {
+    Rect result(Vec2::ZERO,_contentSize);
+    if (_panemask) {
+        return result;
+    }
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        result.merge(_panetrans.transform((*it)->getSubtreeBounds()));
+    }
+    return result;
+}
+
 #pragma mark -
 #pragma mark Rendering
 /**
@@ -1081,10 +1286,10 @@ void ScrollPane::resetPane() {
  * @param tint      The tint to blend with the Node color.
  */
 void ScrollPane::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {
-    if (!_isVisible) { return; }
+    if (!_isVisible || isCulled(transform)) { return; }
+    Scene2Profiler::Scope scope(Scene2Profiler::Category::RENDER,this);
     
-    Affine2 matrix;
-    Affine2::multiply(_combined,transform,&matrix);
+    Affine2 matrix = getRenderTransform(transform);
     Color4 color = _tintColor;
     if (_hasParentColor) {
         color *= tint;
@@ -631,6 +631,8 @@ void TextField::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& t
     Label::draw(batch, transform, tint);
 
 	if (_focused && _showCursor) {
+		// The cursor blinks, so this node cannot be cached
+		invalidateCache();
 		_cursorBlink--;
 		if (_cursorBlink < 0) {
 			batch->setTexture(Texture::getBlank());
@@ -0,0 +1,175 @@
+//
+//  CUFrameArena.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a linear (bump) allocator for transient data. Memory
+//  from an arena is never freed individually. Instead, the entire arena is
+//  reset at once, typically at the start of an animation frame. This makes
+//  allocation a pointer increment, and it never fragments the heap.
+//
+//  The class Application owns two of these arenas, which it swaps every
+//  frame. So memory allocated in one frame remains valid through the next
+//  frame.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/util/CUFrameArena.h>
+#include <cugl/util/CUDebug.h>
+#include <algorithm>
+#include <new>
+
+using namespace cugl;
+
+#pragma mark Constructors
+/**
+ * Creates an empty arena with the default block size.
+ *
+ * The arena does not allocate any memory until it is first used. Unlike
+ * most classes in CUGL, an arena is usable without initialization. This
+ * allows it to be a field of other classes.
+ */
+FrameArena::FrameArena() :
+_current(0),
+_offset(0),
+_blocksize(CU_ARENA_BLOCK),
+_usage(0),
+_peaksize(0) {
+}
+
+/**
+ * Disposes this arena, releasing all memory.
+ *
+ * Any memory allocated from this arena is no longer valid. A disposed
+ * arena may still be used, and will allocate new blocks as necessary.
+ */
+void FrameArena::dispose() {
+    for(auto it = _blocks.begin(); it != _blocks.end(); ++it) {
+        ::operator delete(it->data);
+    }
+    _blocks.clear();
+    _current = 0;
+    _offset  = 0;
+    _usage   = 0;
+}
+
+/**
+ * Initializes this arena with a block of the given size.
+ *
+ * The block size is the minimum size of any block that the arena adds.
+ * Allocations larger than this get a block of their own (until they are
+ * merged on reset).
+ *
+ * @param blocksize The minimum block size in bytes
+ *
+ * @return true if initialization was successful.
+ */
+bool FrameArena::init(size_t blocksize) {
+    CUAssertLog(blocksize > 0, "The block size must be positive");
+    dispose();
+    _blocksize = blocksize;
+    addBlock(blocksize);
+    return true;
+}
+
+/**
+ * Adds a new block with at least the given capacity.
+ *
+ * @param capacity  The minimum block capacity in bytes
+ */
+void FrameArena::addBlock(size_t capacity) {
+    Block block;
+    block.capacity = std::max(capacity,_blocksize);
+    block.data = static_cast<Uint8*>(::operator new(block.capacity));
+    _blocks.push_back(block);
+}
+
+#pragma mark Allocation
+/**
+ * Returns a pointer to the given number of bytes with the given alignment.
+ *
+ * The memory is valid until the next call to {@link #reset}. The
+ * alignment must be a power of two.
+ *
+ * @param size      The number of bytes to allocate
+ * @param alignment The memory alignment
+ *
+ * @return a pointer to the given number of bytes with the given alignment.
+ */
+void* FrameArena::allocate(size_t size, size_t alignment) {
+    CUAssertLog((alignment & (alignment-1)) == 0, "The alignment %zu is not a power of two", alignment);
+    while (true) {
+        if (_current < _blocks.size()) {
+            Block& block = _blocks[_current];
+            uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+            uintptr_t addr = (base+_offset+alignment-1) & ~(uintptr_t)(alignment-1);
+            size_t end = (addr-base)+size;
+            if (end <= block.capacity) {
+                _usage += end-_offset;
+                _peaksize = std::max(_peaksize,_usage);
+                _offset = end;
+                return reinterpret_cast<void*>(addr);
+            }
+            if (_current+1 < _blocks.size()) {
+                _current++;
+                _offset = 0;
+                continue;
+            }
+        }
+
+        // Room for the worst case alignment
+        addBlock(size+alignment);
+        _current = _blocks.size()-1;
+        _offset = 0;
+    }
+}
+
+/**
+ * Releases all memory allocated from this arena.
+ *
+ * The arena keeps its memory for future allocations. If the last frame
+ * needed more than one block, the blocks are merged into one.
+ */
+void FrameArena::reset() {
+    if (_blocks.size() > 1) {
+        size_t capacity = getCapacity();
+        dispose();
+        addBlock(capacity);
+    }
+    _current = 0;
+    _offset  = 0;
+    _usage   = 0;
+}
+
+#pragma mark Attributes
+/**
+ * Returns the total capacity of all blocks in this arena.
+ *
+ * @return the total capacity of all blocks in this arena.
+ */
+size_t FrameArena::getCapacity() const {
+    size_t result = 0;
+    for(auto it = _blocks.begin(); it != _blocks.end(); ++it) {
+        result += it->capacity;
+    }
+    return result;
+}
@@ -0,0 +1,538 @@
+//
+//  CULogger.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides an asynchronous backend for the CUGL log macros. The
+//  macros in CUDebug.h still format their messages with SDL, but once the
+//  logger is started, SDL hands the formatted messages to the logger instead
+//  of writing them. Each thread copies its messages into a lock-free ring of
+//  its own, and a background thread drains the rings in order and writes the
+//  messages with the original SDL output function. Hence logging no longer
+//  blocks the calling thread on the console (or logcat).
+//
+//  The logger can also rate limit a log category, so that chatty subsystems
+//  (such as the network debug messages) cannot flood the log.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/util/CULogger.h>
+#include <cugl/util/CUProfiler.h>
+#include <condition_variable>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+
+using namespace cugl;
+
+#pragma mark Thread Rings
+
+/** A single formatted message */
+struct LogEntry {
+    /** The global order of this message */
+    Uint64 sequence;
+    /** The log category */
+    int category;
+    /** The log priority */
+    SDL_LogPriority priority;
+    /** The message text */
+    char text[CU_LOG_ENTRY_SIZE];
+};
+
+/**
+ * The messages logged by a single thread.
+ *
+ * This is a single-producer single-consumer ring. The producer is the thread
+ * that owns the ring, and the consumer is whichever thread holds the drain
+ * lock of the registry.
+ */
+struct LogRing {
+    /** The index of the next message to write (consumer side) */
+    std::atomic<Uint32> head{0};
+    /** The index of the next message to log (producer side) */
+    std::atomic<Uint32> tail{0};
+    /** Whether a live thread owns this ring */
+    std::atomic<bool> owned{true};
+    /** The pending messages */
+    LogEntry entries[CU_LOG_RING_SIZE];
+};
+
+/** The rate limit of a single log category */
+struct LogLimit {
+    /** The number of messages allowed each period (0 for no limit) */
+    std::atomic<Uint32> count{0};
+    /** The period length in milliseconds */
+    std::atomic<Uint32> millis{1000};
+    /** The number of messages logged this period */
+    std::atomic<Uint32> used{0};
+    /** The number of messages discarded this period */
+    std::atomic<Uint32> suppressed{0};
+    /** The start of the current period in milliseconds */
+    std::atomic<Uint64> start{0};
+};
+
+/** The global state of the logger */
+struct LogRegistry {
+    /** The rings of all threads that have logged */
+    std::vector<std::shared_ptr<LogRing>> rings;
+    /** The mutex guarding the ring list */
+    std::mutex mutex;
+    /** The mutex held by the thread writing messages */
+    std::mutex drain;
+    /** The ring snapshot for a drain (guarded by the drain mutex) */
+    std::vector<LogRing*> scratch;
+    /** The mutex guarding start, stop and the rate limits */
+    std::mutex control;
+    /** The mutex for waking the background thread */
+    std::mutex wakeMutex;
+    /** The condition for waking the background thread */
+    std::condition_variable wake;
+    /** Whether the background thread should exit */
+    bool stopping = false;
+    /** The background thread */
+    std::thread thread;
+    /** The original SDL output function */
+    SDL_LogOutputFunction output = nullptr;
+    /** The user data of the original SDL output function */
+    void* userdata = nullptr;
+    /** Whether the logger output function is installed */
+    bool installed = false;
+    /** The sequence number of the next message */
+    std::atomic<Uint64> sequence{0};
+    /** The total number of rate limited messages */
+    std::atomic<Uint64> suppressed{0};
+    /** The rate limits of each category */
+    LogLimit limits[CU_LOG_MAX_CATEGORIES];
+
+    /** Stops the background thread, if it is still running at exit */
+    ~LogRegistry();
+};
+
+/** Whether the background thread is running */
+std::atomic<bool> Logger::_active(false);
+
+/**
+ * Returns the logger registry
+ *
+ * This is a function-local static to avoid static initialization order
+ * problems with messages logged by other static initializers.
+ *
+ * @return the logger registry
+ */
+static LogRegistry& get_registry() {
+    static LogRegistry registry;
+    return registry;
+}
+
+/**
+ * The ring of a thread
+ *
+ * When the thread exits, the ring is released so that a new thread may reuse
+ * it. The registry still owns the ring, so no pending message is lost.
+ */
+struct RingHandle {
+    /** The ring of this thread */
+    std::shared_ptr<LogRing> ring;
+
+    /** Releases the ring of this thread */
+    ~RingHandle() {
+        if (ring != nullptr) {
+            ring->owned.store(false,std::memory_order_release);
+        }
+    }
+};
+
+/**
+ * Returns the log ring for the current thread
+ *
+ * The ring is claimed the first time the thread logs. If a thread has
+ * exited, its ring is reused. Otherwise a new ring is registered.
+ *
+ * @return the log ring for the current thread
+ */
+static LogRing* get_ring() {
+    static thread_local RingHandle local;
+    if (local.ring == nullptr) {
+        LogRegistry& registry = get_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for(auto it = registry.rings.begin(); local.ring == nullptr && it != registry.rings.end(); ++it) {
+            bool expected = false;
+            if ((*it)->owned.compare_exchange_strong(expected,true,std::memory_order_acq_rel)) {
+                local.ring = *it;
+            }
+        }
+        if (local.ring == nullptr) {
+            local.ring = std::make_shared<LogRing>();
+            registry.rings.push_back(local.ring);
+        }
+    }
+    return local.ring.get();
+}
+
+/**
+ * Returns the current time in milliseconds
+ *
+ * @return the current time in milliseconds
+ */
+static Uint64 now_millis() {
+    auto time = std::chrono::steady_clock::now().time_since_epoch();
+    return (Uint64)std::chrono::duration_cast<std::chrono::milliseconds>(time).count();
+}
+
+#pragma mark -
+#pragma mark Output
+/**
+ * Writes the given message with the original SDL output function
+ *
+ * @param registry  The logger registry
+ * @param category  The log category
+ * @param priority  The log priority
+ * @param message   The message text
+ */
+static void write_message(LogRegistry& registry, int category, SDL_LogPriority priority,
+                          const char* message) {
+    if (registry.output != nullptr) {
+        registry.output(registry.userdata,category,priority,message);
+    }
+}
+
+/**
+ * Writes every pending message of every thread.
+ *
+ * The messages are written in the order they were logged. The caller must
+ * hold the drain mutex of the registry.
+ *
+ * @param registry  The logger registry
+ */
+static void drain_rings(LogRegistry& registry) {
+    registry.scratch.clear();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for(auto it = registry.rings.begin(); it != registry.rings.end(); ++it) {
+            registry.scratch.push_back(it->get());
+        }
+    }
+
+    while (true) {
+        LogRing* next = nullptr;
+        Uint64 best = 0;
+        for(auto it = registry.scratch.begin(); it != registry.scratch.end(); ++it) {
+            LogRing* ring = *it;
+            Uint32 head = ring->head.load(std::memory_order_relaxed);
+            if (head != ring->tail.load(std::memory_order_acquire)) {
+                Uint64 sequence = ring->entries[head % CU_LOG_RING_SIZE].sequence;
+                if (next == nullptr || sequence < best) {
+                    next = ring;
+                    best = sequence;
+                }
+            }
+        }
+        if (next == nullptr) {
+            return;
+        }
+
+        Uint32 head = next->head.load(std::memory_order_relaxed);
+        LogEntry& entry = next->entries[head % CU_LOG_RING_SIZE];
+        write_message(registry,entry.category,entry.priority,entry.text);
+        next->head.store(head+1,std::memory_order_release);
+    }
+}
+
+/**
+ * Copies the given message into the ring of the current thread.
+ *
+ * This method never blocks. It fails if the ring is full.
+ *
+ * @param registry  The logger registry
+ * @param category  The log category
+ * @param priority  The log priority
+ * @param message   The message text
+ * @param length    The message length (less than CU_LOG_ENTRY_SIZE)
+ *
+ * @return true if the message was added to the ring
+ */
+static bool push_message(LogRegistry& registry, int category, SDL_LogPriority priority,
+                         const char* message, size_t length) {
+    LogRing* ring = get_ring();
+    Uint32 tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail-ring->head.load(std::memory_order_acquire) >= CU_LOG_RING_SIZE) {
+        return false;
+    }
+
+    LogEntry& entry = ring->entries[tail % CU_LOG_RING_SIZE];
+    entry.sequence = registry.sequence.fetch_add(1,std::memory_order_relaxed);
+    entry.category = category;
+    entry.priority = priority;
+    std::memcpy(entry.text,message,length);
+    entry.text[length] = '\0';
+    ring->tail.store(tail+1,std::memory_order_release);
+    return true;
+}
+
+/**
+ * Writes the given message, either to the thread ring or synchronously.
+ *
+ * Errors, long messages, and messages that do not fit in the ring are written
+ * synchronously, but only after every pending message.
+ *
+ * @param registry  The logger registry
+ * @param category  The log category
+ * @param priority  The log priority
+ * @param message   The message text
+ */
+static void emit_message(LogRegistry& registry, int category, SDL_LogPriority priority,
+                         const char* message) {
+    if (priority < SDL_LOG_PRIORITY_ERROR && Logger::isActive()) {
+        size_t length = std::strlen(message);
+        if (length < CU_LOG_ENTRY_SIZE && push_message(registry,category,priority,message,length)) {
+            // The logger may have stopped after the check
+            if (!Logger::isActive()) {
+                Logger::flush();
+            }
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(registry.drain);
+    drain_rings(registry);
+    write_message(registry,category,priority,message);
+}
+
+/**
+ * Returns true if the given message exceeds the rate limit of its category
+ *
+ * When a new period starts, this method logs the number of messages that
+ * were discarded in the previous one.
+ *
+ * @param registry  The logger registry
+ * @param category  The log category
+ *
+ * @return true if the given message exceeds the rate limit of its category
+ */
+static bool is_limited(LogRegistry& registry, int category) {
+    if (category < 0 || category >= CU_LOG_MAX_CATEGORIES) {
+        return false;
+    }
+    LogLimit& limit = registry.limits[category];
+    Uint32 count = limit.count.load(std::memory_order_relaxed);
+    if (count == 0) {
+        return false;
+    }
+
+    Uint64 now = now_millis();
+    Uint64 start = limit.start.load(std::memory_order_relaxed);
+    if (now-start >= limit.millis.load(std::memory_order_relaxed) &&
+        limit.start.compare_exchange_strong(start,now,std::memory_order_relaxed)) {
+        limit.used.store(0,std::memory_order_relaxed);
+        Uint32 dropped = limit.suppressed.exchange(0,std::memory_order_relaxed);
+        if (dropped > 0) {
+            char notice[64];
+            snprintf(notice,sizeof(notice),"(%u messages suppressed)",dropped);
+            emit_message(registry,category,SDL_LOG_PRIORITY_WARN,notice);
+        }
+    }
+
+    if (limit.used.fetch_add(1,std::memory_order_relaxed) < count) {
+        return false;
+    }
+    limit.suppressed.fetch_add(1,std::memory_order_relaxed);
+    registry.suppressed.fetch_add(1,std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * The SDL log output function of the logger
+ *
+ * @param userdata  The user data (unused)
+ * @param category  The log category
+ * @param priority  The log priority
+ * @param message   The message text
+ */
+static void log_output(void* userdata, int category, SDL_LogPriority priority, const char* message) {
+    LogRegistry& registry = get_registry();
+    if (priority < SDL_LOG_PRIORITY_ERROR && is_limited(registry,category)) {
+        return;
+    }
+    emit_message(registry,category,priority,message);
+}
+
+/**
+ * Replaces the SDL log output function with the logger.
+ *
+ * The caller must hold the control mutex of the registry.
+ *
+ * @param registry  The logger registry
+ */
+static void install_output(LogRegistry& registry) {
+    if (!registry.installed) {
+        SDL_LogGetOutputFunction(&registry.output,&registry.userdata);
+        SDL_LogSetOutputFunction(log_output,nullptr);
+        registry.installed = true;
+    }
+}
+
+/**
+ * Writes the messages of all threads until the logger stops
+ */
+static void drain_loop() {
+    Profiler::setThreadName("Logger");
+    LogRegistry& registry = get_registry();
+    std::unique_lock<std::mutex> lock(registry.wakeMutex);
+    while (!registry.stopping) {
+        registry.wake.wait_for(lock,std::chrono::milliseconds(CU_LOG_DRAIN_INTERVAL));
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> guard(registry.drain);
+            drain_rings(registry);
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * Stops the background thread, if it is still running at exit
+ */
+LogRegistry::~LogRegistry() {
+    if (thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        thread.join();
+    }
+    std::lock_guard<std::mutex> lock(drain);
+    drain_rings(*this);
+    if (installed) {
+        SDL_LogSetOutputFunction(output,userdata);
+    }
+}
+
+#pragma mark -
+#pragma mark Activation
+/**
+ * Starts the asynchronous logger.
+ *
+ * This replaces the SDL log output function, and starts the background
+ * thread that writes the messages. It does nothing if the logger is
+ * already started.
+ *
+ * @return true if the logger was started
+ */
+bool Logger::start() {
+    LogRegistry& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.control);
+    if (_active.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    install_output(registry);
+    {
+        std::lock_guard<std::mutex> guard(registry.wakeMutex);
+        registry.stopping = false;
+    }
+    registry.thread = std::thread(drain_loop);
+    _active.store(true,std::memory_order_release);
+    return true;
+}
+
+/**
+ * Stops the asynchronous logger.
+ *
+ * This writes every pending message and stops the background thread.
+ * Messages logged after this method are written synchronously.
+ */
+void Logger::stop() {
+    LogRegistry& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.control);
+    if (!_active.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    _active.store(false,std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> guard(registry.wakeMutex);
+        registry.stopping = true;
+    }
+    registry.wake.notify_all();
+    registry.thread.join();
+    flush();
+}
+
+/**
+ * Writes every pending message now.
+ *
+ * This method blocks until the messages are written. It is safe to call
+ * whether or not the logger is active.
+ */
+void Logger::flush() {
+    LogRegistry& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.drain);
+    drain_rings(registry);
+}
+
+#pragma mark -
+#pragma mark Rate Limits
+/**
+ * Limits the number of messages in the given category.
+ *
+ * The category is an SDL log category, such as SDL_LOG_CATEGORY_APPLICATION
+ * or {@link CU_LOG_CATEGORY_NETCODE}. At most count messages are written
+ * every millis milliseconds. A count of 0 removes the limit. Categories of
+ * {@link CU_LOG_MAX_CATEGORIES} or more are ignored.
+ *
+ * Errors and critical messages are never rate limited.
+ *
+ * @param category  The log category
+ * @param count     The number of messages allowed in each period
+ * @param millis    The period length in milliseconds
+ */
+void Logger::setRateLimit(int category, Uint32 count, Uint32 millis) {
+    if (category < 0 || category >= CU_LOG_MAX_CATEGORIES) {
+        return;
+    }
+    LogRegistry& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.control);
+    install_output(registry);
+
+    LogLimit& limit = registry.limits[category];
+    limit.millis.store(std::max(millis,1u),std::memory_order_relaxed);
+    limit.used.store(0,std::memory_order_relaxed);
+    limit.start.store(now_millis(),std::memory_order_relaxed);
+    limit.count.store(count,std::memory_order_relaxed);
+}
+
+/**
+ * Returns the number of messages discarded by rate limits.
+ *
+ * This is the total over all categories since the application started.
+ *
+ * @return the number of messages discarded by rate limits.
+ */
+Uint64 Logger::getSuppressed() {
+    return get_registry().suppressed.load(std::memory_order_relaxed);
+}
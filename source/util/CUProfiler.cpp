@@ -0,0 +1,680 @@
+//
+//  CUProfiler.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a lightweight hierarchical profiler. Code is timed
+//  with scoped macros, which record a begin and end time (in nanoseconds)
+//  to a buffer local to the current thread. Nested scopes form a hierarchy
+//  per thread. A capture can be exported as a Chrome trace (JSON), which can
+//  be viewed in chrome://tracing or https://ui.perfetto.dev.
+//
+//  The macros compile to nothing when CU_PROFILE_ENABLED is 0, which is the
+//  default for release (NDEBUG) builds. Even when compiled in, a scope costs
+//  a single atomic load unless a capture is active.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: Walker White
+//  Version: 10/14/26
+//
+#include <cugl/util/CUProfiler.h>
+#include <cugl/util/CUDebug.h>
+#include <cugl/io/CUTextWriter.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <set>
+#include <cstdio>
+
+using namespace cugl;
+
+#pragma mark Thread Buffers
+
+/** A single completed event */
+struct ProfileEvent {
+    /** The event name */
+    const char* name;
+    /** The start time in nanoseconds */
+    Uint64 begin;
+    /** The duration in nanoseconds */
+    Uint64 duration;
+    /** The bytes processed */
+    Uint64 bytes;
+    /** The wait time in nanoseconds */
+    Uint64 wait;
+    /** The detail (an index into the thread details, plus 1) */
+    Uint32 detail;
+};
+
+/**
+ * The events recorded by a single thread.
+ *
+ * The mutex is only contended when exporting or clearing a capture.
+ */
+struct ProfileBuffer {
+    /** The thread index (for the trace) */
+    Uint32 index;
+    /** The thread display name */
+    std::string name;
+    /** The recorded events */
+    std::vector<ProfileEvent> events;
+    /** The event details (which are copied) */
+    std::vector<std::string> details;
+    /** The number of dropped events */
+    size_t dropped;
+    /** The mutex guarding this buffer */
+    std::mutex mutex;
+};
+
+/** The global state of the profiler */
+struct ProfileRegistry {
+    /** The buffers of all threads that have recorded (or been named) */
+    std::vector<std::shared_ptr<ProfileBuffer>> buffers;
+    /** The mutex guarding the buffer list */
+    std::mutex mutex;
+    /** The index for the next thread buffer */
+    Uint32 nextIndex = 1;
+    /** The steady clock time (in nanoseconds) of the capture start */
+    std::atomic<Sint64> epoch{0};
+};
+
+/** Whether a capture is active */
+std::atomic<bool> Profiler::_active(false);
+
+/** The innermost open scope of the current thread */
+static thread_local ProfileScope* current_scope = nullptr;
+
+/**
+ * Returns the profiler registry
+ *
+ * This is a function-local static to avoid static initialization order
+ * problems with scopes in other static initializers.
+ *
+ * @return the profiler registry
+ */
+static ProfileRegistry& get_registry() {
+    static ProfileRegistry registry;
+    return registry;
+}
+
+/**
+ * Returns the profile buffer for the current thread
+ *
+ * The buffer is created (and registered) the first time the thread uses it.
+ * The registry shares ownership, so the events survive the thread.
+ *
+ * @return the profile buffer for the current thread
+ */
+static ProfileBuffer* get_buffer() {
+    static thread_local std::shared_ptr<ProfileBuffer> local;
+    if (local == nullptr) {
+        ProfileRegistry& registry = get_registry();
+        local = std::make_shared<ProfileBuffer>();
+        local->dropped = 0;
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        local->index = registry.nextIndex++;
+        registry.buffers.push_back(local);
+    }
+    return local.get();
+}
+
+/**
+ * Appends the event to the buffer of the current thread
+ *
+ * The event is dropped if there is no active capture, or if the thread has
+ * exceeded {@link CU_PROFILE_CAPACITY} events.
+ *
+ * @param event The event to record
+ */
+static void push_event(ProfileEvent event) {
+    ProfileBuffer* buffer = get_buffer();
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    if (event.detail > buffer->details.size()) {
+        // The detail was cleared with the previous capture
+        event.detail = 0;
+    }
+    if (buffer->events.size() < CU_PROFILE_CAPACITY) {
+        buffer->events.push_back(event);
+    } else {
+        buffer->dropped++;
+    }
+}
+
+/**
+ * Appends the given string to the buffer as a JSON string literal
+ *
+ * @param buffer    The output buffer
+ * @param value     The string to quote
+ */
+static void append_quoted(std::string& buffer, const char* value) {
+    buffer.push_back('"');
+    for(const char* c = value; *c; c++) {
+        switch (*c) {
+            case '"':
+                buffer.append("\\\"");
+                break;
+            case '\\':
+                buffer.append("\\\\");
+                break;
+            case '\n':
+                buffer.append("\\n");
+                break;
+            case '\t':
+                buffer.append("\\t");
+                break;
+            default:
+                if ((unsigned char)*c < 0x20) {
+                    char code[8];
+                    snprintf(code, sizeof(code), "\\u%04x", (unsigned char)*c);
+                    buffer.append(code);
+                } else {
+                    buffer.push_back(*c);
+                }
+        }
+    }
+    buffer.push_back('"');
+}
+
+/**
+ * Appends the given nanosecond value to the buffer in microseconds
+ *
+ * Chrome traces measure time in (fractional) microseconds.
+ *
+ * @param buffer    The output buffer
+ * @param nanos     The time in nanoseconds
+ */
+static void append_micros(std::string& buffer, Uint64 nanos) {
+    char value[32];
+    snprintf(value, sizeof(value), "%llu.%03u",
+             (unsigned long long)(nanos/1000), (unsigned int)(nanos%1000));
+    buffer.append(value);
+}
+
+/** A single event of the report timeline */
+struct ReportEvent {
+    /** The recorded event */
+    ProfileEvent event;
+    /** The depth of the event in its thread hierarchy */
+    size_t depth;
+    /** The thread display name */
+    std::string thread;
+    /** The event detail (or the empty string) */
+    std::string detail;
+};
+
+/** The aggregate of all report events with the same name */
+struct ReportStat {
+    /** The number of events */
+    size_t count = 0;
+    /** The total duration in nanoseconds */
+    Uint64 total = 0;
+    /** The maximum duration in nanoseconds */
+    Uint64 peak = 0;
+    /** The total wait time in nanoseconds */
+    Uint64 wait = 0;
+    /** The total bytes processed */
+    Uint64 bytes = 0;
+    /** The indices of the threads recording these events */
+    std::set<Uint32> threads;
+};
+
+/**
+ * Returns the given nanosecond value in milliseconds
+ *
+ * @param nanos     The time in nanoseconds
+ *
+ * @return the given nanosecond value in milliseconds
+ */
+static double to_millis(Uint64 nanos) {
+    return nanos/1000000.0;
+}
+
+#pragma mark -
+#pragma mark Capture
+/**
+ * Starts a new capture.
+ *
+ * This discards all events from any previous capture. Timestamps in the
+ * new capture are relative to the moment that this method is called.
+ */
+void Profiler::start() {
+    clear();
+    auto time = std::chrono::steady_clock::now().time_since_epoch();
+    get_registry().epoch.store(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+    _active.store(true);
+}
+
+/**
+ * Stops the current capture.
+ *
+ * The events are retained until the next call to {@link #start} or
+ * {@link #clear}. Any scope still open on another thread when this
+ * method is called is dropped.
+ */
+void Profiler::stop() {
+    _active.store(false);
+}
+
+/**
+ * Discards all recorded events.
+ *
+ * This does not stop an active capture.
+ */
+void Profiler::clear() {
+    ProfileRegistry& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for(auto it = registry.buffers.begin(); it != registry.buffers.end(); ) {
+        // Forget threads that have exited
+        if (it->use_count() == 1) {
+            it = registry.buffers.erase(it);
+        } else {
+            std::lock_guard<std::mutex> guard((*it)->mutex);
+            (*it)->events.clear();
+            (*it)->details.clear();
+            (*it)->dropped = 0;
+            ++it;
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Recording
+/**
+ * Returns the time since the start of the capture in nanoseconds.
+ *
+ * @return the time since the start of the capture in nanoseconds.
+ */
+Uint64 Profiler::now() {
+    auto time = std::chrono::steady_clock::now().time_since_epoch();
+    Sint64 nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+    nanos -= get_registry().epoch.load(std::memory_order_relaxed);
+    return nanos < 0 ? 0 : (Uint64)nanos;
+}
+
+/**
+ * Records a completed event for the current thread.
+ *
+ * The times should be values returned by {@link #now}. An event is
+ * dropped if there is no active capture, or if the thread has exceeded
+ * {@link CU_PROFILE_CAPACITY} events.
+ *
+ * @param name  The event name (which must outlive the capture)
+ * @param begin The event start time in nanoseconds
+ * @param end   The event end time in nanoseconds
+ */
+void Profiler::record(const char* name, Uint64 begin, Uint64 end) {
+    // The scope straddled a restart
+    if (!isActive() || end < begin) {
+        return;
+    }
+    push_event({name,begin,end-begin,0,0,0});
+}
+
+/**
+ * Opens the given scope on the current thread.
+ *
+ * The scope becomes the target of any annotations until it is closed.
+ *
+ * @param scope The scope to open
+ */
+void Profiler::enter(ProfileScope* scope) {
+    scope->_parent = current_scope;
+    current_scope = scope;
+}
+
+/**
+ * Closes the given scope on the current thread, recording its event.
+ *
+ * The scope must be the innermost open scope on this thread.
+ *
+ * @param scope The scope to close
+ */
+void Profiler::leave(ProfileScope* scope) {
+    Uint64 end = now();
+    current_scope = scope->_parent;
+    if (!isActive() || end < scope->_begin) {
+        return;
+    }
+    push_event({scope->_name,scope->_begin,end-scope->_begin,
+                scope->_bytes,scope->_wait,scope->_detail});
+}
+
+/**
+ * Sets the display name of the current thread.
+ *
+ * This name is used to label the thread in the exported trace. Threads
+ * without a name are labeled by their index.
+ *
+ * @param name  The thread name
+ */
+void Profiler::setThreadName(const std::string name) {
+    ProfileBuffer* buffer = get_buffer();
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    buffer->name = name;
+}
+
+#pragma mark -
+#pragma mark Annotation
+/**
+ * Adds the given number of bytes to the innermost open scope.
+ *
+ * This is the amount of data processed by the scope, such as the size of
+ * a file or of a texture upload. It does nothing if there is no open
+ * scope on this thread, or if there is no active capture.
+ *
+ * @param bytes The number of bytes processed
+ */
+void Profiler::addBytes(Uint64 bytes) {
+    if (current_scope != nullptr && isActive()) {
+        current_scope->_bytes += bytes;
+    }
+}
+
+/**
+ * Adds the given wait time to the innermost open scope.
+ *
+ * This is the time that the work of the scope spent blocked or queued,
+ * such as an asset waiting for the main thread. It need not overlap the
+ * scope itself. It does nothing if there is no open scope on this
+ * thread, or if there is no active capture.
+ *
+ * @param nanos The wait time in nanoseconds
+ */
+void Profiler::addWait(Uint64 nanos) {
+    if (current_scope != nullptr && isActive()) {
+        current_scope->_wait += nanos;
+    }
+}
+
+/**
+ * Sets the detail string of the innermost open scope.
+ *
+ * The detail distinguishes events with the same name, such as the file
+ * of an asset load. Unlike the scope name, it is copied. It does nothing
+ * if there is no open scope on this thread, or if there is no active
+ * capture.
+ *
+ * @param detail    The detail string
+ */
+void Profiler::setDetail(const std::string& detail) {
+    if (current_scope == nullptr || !isActive()) {
+        return;
+    }
+    ProfileBuffer* buffer = get_buffer();
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    buffer->details.push_back(detail);
+    current_scope->_detail = (Uint32)buffer->details.size();
+}
+
+#pragma mark -
+#pragma mark Export
+/**
+ * Returns the number of events recorded in the current capture.
+ *
+ * @return the number of events recorded in the current capture.
+ */
+size_t Profiler::getEventCount() {
+    ProfileRegistry& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    size_t result = 0;
+    for(auto it = registry.buffers.begin(); it != registry.buffers.end(); ++it) {
+        std::lock_guard<std::mutex> guard((*it)->mutex);
+        result += (*it)->events.size();
+    }
+    return result;
+}
+
+/**
+ * Returns the number of events dropped from the current capture.
+ *
+ * Events are dropped when a thread exceeds {@link CU_PROFILE_CAPACITY}
+ * events in a single capture.
+ *
+ * @return the number of events dropped from the current capture.
+ */
+size_t Profiler::getDroppedCount() {
+    ProfileRegistry& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    size_t result = 0;
+    for(auto it = registry.buffers.begin(); it != registry.buffers.end(); ++it) {
+        std::lock_guard<std::mutex> guard((*it)->mutex);
+        result += (*it)->dropped;
+    }
+    return result;
+}
+
+/**
+ * Returns the current capture as a Chrome trace.
+ *
+ * The result is a JSON string in the Chrome trace event format. It can
+ * be loaded in chrome://tracing or https://ui.perfetto.dev. This method
+ * may be called during a capture, but it is best called after
+ * {@link #stop}.
+ *
+ * @return the current capture as a Chrome trace.
+ */
+std::string Profiler::getTrace() {
+    ProfileRegistry& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::string result;
+    result.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    bool first = true;
+    for(auto it = registry.buffers.begin(); it != registry.buffers.end(); ++it) {
+        ProfileBuffer* buffer = it->get();
+        std::lock_guard<std::mutex> guard(buffer->mutex);
+        std::string tid = std::to_string(buffer->index);
+
+        // Thread label metadata
+        std::string label = buffer->name.empty() ? "Thread "+tid : buffer->name;
+        result.append(first ? "\n" : ",\n");
+        result.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+        result.append(tid);
+        result.append(",\"args\":{\"name\":");
+        append_quoted(result, label.c_str());
+        result.append("}}");
+        first = false;
+
+        for(auto jt = buffer->events.begin(); jt != buffer->events.end(); ++jt) {
+            result.append(",\n{\"name\":");
+            append_quoted(result, jt->name);
+            result.append(",\"cat\":\"cugl\",\"ph\":\"X\",\"ts\":");
+            append_micros(result, jt->begin);
+            result.append(",\"dur\":");
+            append_micros(result, jt->duration);
+            result.append(",\"pid\":1,\"tid\":");
+            result.append(tid);
+            if (jt->bytes || jt->wait || jt->detail) {
+                result.append(",\"args\":{");
+                bool comma = false;
+                if (jt->detail) {
+                    result.append("\"detail\":");
+                    append_quoted(result, buffer->details[jt->detail-1].c_str());
+                    comma = true;
+                }
+                if (jt->bytes) {
+                    result.append(comma ? ",\"bytes\":" : "\"bytes\":");
+                    result.append(std::to_string(jt->bytes));
+                    comma = true;
+                }
+                if (jt->wait) {
+                    result.append(comma ? ",\"wait_us\":" : "\"wait_us\":");
+                    append_micros(result, jt->wait);
+                }
+                result.push_back('}');
+            }
+            result.push_back('}');
+        }
+    }
+    result.append("\n]}\n");
+    return result;
+}
+
+/**
+ * Returns a plain text report of the current capture.
+ *
+ * The report has two parts. The timeline lists every event at least as
+ * long as the given threshold, in order of start time. Each line has the
+ * start time, the duration, the wait time, the bytes, the thread, and
+ * the event name (indented by its depth in the hierarchy of its thread)
+ * followed by any detail. The summary aggregates the events by name,
+ * ordered by total time, with the number of threads that recorded them.
+ *
+ * Times are in milliseconds. This method may be called during a capture,
+ * but it is best called after {@link #stop}.
+ *
+ * @param threshold The minimum duration of a timeline event in nanoseconds
+ *
+ * @return a plain text report of the current capture.
+ */
+std::string Profiler::getReport(Uint64 threshold) {
+    std::vector<ReportEvent> timeline;
+    std::map<std::string,ReportStat> stats;
+    Uint64 span = 0;
+    size_t events  = 0;
+    size_t dropped = 0;
+    size_t threads = 0;
+    {
+        ProfileRegistry& registry = get_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for(auto it = registry.buffers.begin(); it != registry.buffers.end(); ++it) {
+            ProfileBuffer* buffer = it->get();
+            std::lock_guard<std::mutex> guard(buffer->mutex);
+            dropped += buffer->dropped;
+            if (buffer->events.empty()) {
+                continue;
+            }
+            threads++;
+            events += buffer->events.size();
+            std::string label = buffer->name.empty() ? "Thread "+std::to_string(buffer->index) : buffer->name;
+
+            // Events are recorded as they end, so parents follow their children
+            std::vector<ProfileEvent> sorted = buffer->events;
+            std::sort(sorted.begin(), sorted.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+                return a.begin < b.begin || (a.begin == b.begin && a.duration > b.duration);
+            });
+
+            std::vector<Uint64> open;
+            for(auto jt = sorted.begin(); jt != sorted.end(); ++jt) {
+                while (!open.empty() && open.back() <= jt->begin) {
+                    open.pop_back();
+                }
+                size_t depth = open.size();
+                open.push_back(jt->begin+jt->duration);
+                span = std::max(span,jt->begin+jt->duration);
+
+                ReportStat& stat = stats[jt->name];
+                stat.count++;
+                stat.total += jt->duration;
+                stat.peak  = std::max(stat.peak,jt->duration);
+                stat.wait  += jt->wait;
+                stat.bytes += jt->bytes;
+                stat.threads.insert(buffer->index);
+
+                if (jt->duration >= threshold) {
+                    ReportEvent entry;
+                    entry.event  = *jt;
+                    entry.depth  = depth;
+                    entry.thread = label;
+                    if (jt->detail) {
+                        entry.detail = buffer->details[jt->detail-1];
+                    }
+                    timeline.push_back(entry);
+                }
+            }
+        }
+    }
+
+    std::stable_sort(timeline.begin(), timeline.end(), [](const ReportEvent& a, const ReportEvent& b) {
+        return a.event.begin < b.event.begin;
+    });
+
+    std::string result;
+    char line[256];
+    snprintf(line, sizeof(line), "Profile report: %.3f ms, %zu threads, %zu events (%zu dropped)\n",
+             to_millis(span), threads, events, dropped);
+    result.append(line);
+
+    snprintf(line, sizeof(line), "Timeline (events of at least %.3f ms):\n", to_millis(threshold));
+    result.append(line);
+    snprintf(line, sizeof(line), "%10s %10s %10s %12s  %-14s %s\n",
+             "start ms", "dur ms", "wait ms", "bytes", "thread", "event");
+    result.append(line);
+    for(auto it = timeline.begin(); it != timeline.end(); ++it) {
+        snprintf(line, sizeof(line), "%10.3f %10.3f %10.3f %12llu  %-14s ",
+                 to_millis(it->event.begin), to_millis(it->event.duration),
+                 to_millis(it->event.wait), (unsigned long long)it->event.bytes,
+                 it->thread.c_str());
+        result.append(line);
+        result.append(2*it->depth, ' ');
+        result.append(it->event.name);
+        if (!it->detail.empty()) {
+            result.append(" (");
+            result.append(it->detail);
+            result.push_back(')');
+        }
+        result.push_back('\n');
+    }
+
+    std::vector<std::pair<std::string,ReportStat>> order(stats.begin(),stats.end());
+    std::sort(order.begin(), order.end(), [](const std::pair<std::string,ReportStat>& a,
+                                             const std::pair<std::string,ReportStat>& b) {
+        return a.second.total > b.second.total;
+    });
+
+    result.append("Summary:\n");
+    snprintf(line, sizeof(line), "%8s %10s %10s %10s %12s %8s  %s\n",
+             "count", "total ms", "max ms", "wait ms", "bytes", "threads", "event");
+    result.append(line);
+    for(auto it = order.begin(); it != order.end(); ++it) {
+        const ReportStat& stat = it->second;
+        snprintf(line, sizeof(line), "%8zu %10.3f %10.3f %10.3f %12llu %8zu  ",
+                 stat.count, to_millis(stat.total), to_millis(stat.peak), to_millis(stat.wait),
+                 (unsigned long long)stat.bytes, stat.threads.size());
+        result.append(line);
+        result.append(it->first);
+        result.push_back('\n');
+    }
+    return result;
+}
+
+/**
+ * Saves the current capture as a Chrome trace to the given file.
+ *
+ * See {@link #getTrace} for the file format. If the path is relative,
+ * it is relative to the save directory of the application.
+ *
+ * @param path  The file to write to
+ *
+ * @return true if the capture was successfully saved.
+ */
+bool Profiler::save(const std::string path) {
+    std::shared_ptr<TextWriter> writer = TextWriter::alloc(path);
+    if (writer == nullptr) {
+        CULogError("Could not save profile to '%s'",path.c_str());
+        return false;
+    }
+    writer->write(getTrace());
+    writer->close();
+    return true;
+}
@@ -40,14 +40,319 @@
 #include <utf8/utf8.h>
 #include <cugl/util/CUStrings.h>
 #include <cugl/util/CUDebug.h>
-
-#if defined (__ANDROID__)
+#include <type_traits>
+#include <charconv>
 #include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <limits>
+
+/** A buffer size large enough for any integer (including the sign) */
+#define INTEGER_CHARS 24
+/** A buffer size large enough for most floating point values */
+#define FLOAT_CHARS 64
+
+// Floating point support in <charconv> is not available on every platform
+#if defined (__cpp_lib_to_chars)
+    #define CU_FLOAT_CHARCONV 1
 #endif
 
 namespace cugl {
 namespace strtool {
 
+#pragma mark Internal Helpers
+/**
+ * Writes the given integer to a character buffer
+ *
+ * @param value     The value to write
+ * @param buffer    The buffer to store the characters
+ * @param size      The size of the buffer
+ *
+ * @return the number of characters written (0 if the buffer is too small)
+ */
+template <typename T>
+static size_t write_integer(T value, char* buffer, size_t size) {
+    std::to_chars_result result = std::to_chars(buffer,buffer+size,value);
+    return result.ec == std::errc() ? (size_t)(result.ptr-buffer) : 0;
+}
+
+/**
+ * Writes the given floating point value to a character buffer
+ *
+ * The value is written in fixed point notation. If precision is negative,
+ * this is the shortest representation that converts back to the same value.
+ * Platforms without floating point support in <charconv> use snprintf
+ * instead, which (for negative precision) may use scientific notation.
+ *
+ * @param value     The value to write
+ * @param buffer    The buffer to store the characters
+ * @param size      The size of the buffer
+ * @param precision The number of digits after the decimal point
+ *
+ * @return the number of characters written (0 if the buffer is too small)
+ */
+template <typename T>
+static size_t write_floating(T value, char* buffer, size_t size, int precision) {
+#if defined (CU_FLOAT_CHARCONV)
+    std::to_chars_result result;
+    if (precision >= 0) {
+        result = std::to_chars(buffer,buffer+size,value,std::chars_format::fixed,precision);
+    } else {
+        result = std::to_chars(buffer,buffer+size,value,std::chars_format::fixed);
+    }
+    return result.ec == std::errc() ? (size_t)(result.ptr-buffer) : 0;
+#else
+    int amt;
+    if (precision >= 0) {
+        amt = std::snprintf(buffer,size,"%.*f",precision,(double)value);
+    } else {
+        amt = std::snprintf(buffer,size,"%.*g",std::numeric_limits<T>::max_digits10,(double)value);
+    }
+    return (amt >= 0 && (size_t)amt < size) ? (size_t)amt : 0;
+#endif
+}
+
+/**
+ * Returns the string for a floating point value too large for a local buffer
+ *
+ * @param value     The value to write
+ * @param precision The number of digits after the decimal point
+ *
+ * @return the string for a floating point value too large for a local buffer
+ */
+template <typename T>
+static std::string format_large(T value, int precision) {
+    size_t size = std::numeric_limits<T>::max_exponent10-std::numeric_limits<T>::min_exponent10;
+    size += std::numeric_limits<T>::max_digits10+std::max(precision,0)+FLOAT_CHARS;
+    std::string result(size,'\0');
+    result.resize(write_floating(value,&result[0],size,precision));
+    return result;
+}
+
+/**
+ * Reads an integer from a character buffer, clamping it to the type range
+ *
+ * @param buffer    The characters to read
+ * @param size      The number of characters in the buffer
+ * @param value     The variable to store the result
+ * @param base      The number base
+ *
+ * @return the number of characters read (0 if there is no number)
+ */
+template <typename T>
+static size_t read_integer(const char* buffer, size_t size, T& value, int base) {
+    std::from_chars_result result = std::from_chars(buffer,buffer+size,value,base);
+    if (result.ec == std::errc::invalid_argument) {
+        return 0;
+    } else if (result.ec == std::errc::result_out_of_range) {
+        bool negative = size > 0 && buffer[0] == '-';
+        value = negative ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+    }
+    return result.ptr-buffer;
+}
+
+/**
+ * Reads a floating point value from a character buffer
+ *
+ * Values that std::from_chars cannot read (such as hexadecimal or out of
+ * range values), as well as all values on platforms without floating point
+ * support in <charconv>, fall back to strtod.
+ *
+ * @param buffer    The characters to read
+ * @param size      The number of characters in the buffer
+ * @param value     The variable to store the result
+ *
+ * @return the number of characters read (0 if there is no number)
+ */
+template <typename T>
+static size_t read_floating(const char* buffer, size_t size, T& value) {
+    if (size == 0 || std::isspace((unsigned char)buffer[0]) || buffer[0] == '+') {
+        return 0;
+    }
+#if defined (CU_FLOAT_CHARCONV)
+    size_t lead = buffer[0] == '-' ? 1 : 0;
+    bool hex = size > lead+1 && buffer[lead] == '0' && (buffer[lead+1] == 'x' || buffer[lead+1] == 'X');
+    std::from_chars_result result = std::from_chars(buffer,buffer+size,value);
+    if (result.ec == std::errc() && !hex) {
+        return result.ptr-buffer;
+    }
+#endif
+    // strtod requires a null-terminated string
+    char local[FLOAT_CHARS];
+    std::string large;
+    const char* start = local;
+    if (size < FLOAT_CHARS) {
+        std::memcpy(local,buffer,size);
+        local[size] = '\0';
+    } else {
+        large.assign(buffer,size);
+        start = large.c_str();
+    }
+
+    char* end = nullptr;
+    double number = std::strtod(start,&end);
+    if (end == start) {
+        return 0;
+    }
+    value = (T)number;
+    return end-start;
+}
+
+/**
+ * Reads the magnitude and sign of an integer in the style of strtoull
+ *
+ * This function skips leading whitespace, and accepts a sign and (for base
+ * 16) a 0x prefix. A base of 0 determines the base from the prefix. Values
+ * that are out of range are clamped.
+ *
+ * @param str       The string to read
+ * @param magnitude The variable to store the magnitude
+ * @param negate    The variable to store whether the number is negative
+ * @param base      The number base
+ *
+ * @return the number of characters read (0 if there is no number)
+ */
+static size_t parse_magnitude(const std::string& str, Uint64& magnitude, bool& negate, int base) {
+    const char* begin = str.c_str();
+    const char* end = begin+str.size();
+    const char* curr = begin;
+    while (curr != end && std::isspace((unsigned char)*curr)) {
+        curr++;
+    }
+
+    negate = false;
+    if (curr != end && (*curr == '+' || *curr == '-')) {
+        negate = *curr == '-';
+        curr++;
+    }
+    bool hex = (end-curr > 2 && curr[0] == '0' && (curr[1] == 'x' || curr[1] == 'X') &&
+                std::isxdigit((unsigned char)curr[2]));
+    if (base == 0) {
+        base = hex ? 16 : (curr != end && *curr == '0' ? 8 : 10);
+    }
+    if (base == 16 && hex) {
+        curr += 2;
+    }
+
+    magnitude = 0;
+    std::from_chars_result result = std::from_chars(curr,end,magnitude,base);
+    if (result.ec == std::errc::invalid_argument) {
+        negate = false;
+        return 0;
+    } else if (result.ec == std::errc::result_out_of_range) {
+        magnitude = std::numeric_limits<Uint64>::max();
+    }
+    return result.ptr-begin;
+}
+
+/**
+ * Reads a signed integer in the style of strtoll
+ *
+ * @param str       The string to read
+ * @param value     The variable to store the result
+ * @param base      The number base
+ *
+ * @return the number of characters read (0 if there is no number)
+ */
+static size_t parse_signed(const std::string& str, Sint64& value, int base) {
+    Uint64 magnitude;
+    bool negate;
+    size_t read = parse_magnitude(str,magnitude,negate,base);
+    const Uint64 limit = (Uint64)std::numeric_limits<Sint64>::max();
+    if (negate) {
+        value = magnitude > limit ? std::numeric_limits<Sint64>::min() : -(Sint64)magnitude;
+    } else {
+        value = magnitude > limit ? std::numeric_limits<Sint64>::max() : (Sint64)magnitude;
+    }
+    return read;
+}
+
+/**
+ * Reads an unsigned integer in the style of strtoull
+ *
+ * As with strtoull, a negative number is negated in the unsigned type.
+ *
+ * @param str       The string to read
+ * @param value     The variable to store the result
+ * @param base      The number base
+ *
+ * @return the number of characters read (0 if there is no number)
+ */
+static size_t parse_unsigned(const std::string& str, Uint64& value, int base) {
+    Uint64 magnitude;
+    bool negate;
+    size_t read = parse_magnitude(str,magnitude,negate,base);
+    value = negate ? 0-magnitude : magnitude;
+    return read;
+}
+
+/**
+ * Reads a floating point value in the style of strtod
+ *
+ * This function skips leading whitespace and accepts a leading '+'.
+ *
+ * @param str       The string to read
+ * @param value     The variable to store the result
+ *
+ * @return the number of characters read (0 if there is no number)
+ */
+template <typename T>
+static size_t parse_floating(const std::string& str, T& value) {
+    const char* begin = str.c_str();
+    const char* end = begin+str.size();
+    const char* curr = begin;
+    while (curr != end && std::isspace((unsigned char)*curr)) {
+        curr++;
+    }
+    if (curr != end && *curr == '+') {
+        curr++;
+        if (curr != end && *curr == '-') {
+            return 0;
+        }
+    }
+    size_t read = read_floating(curr,(size_t)(end-curr),value);
+    return read == 0 ? 0 : (size_t)(curr-begin)+read;
+}
+
+/**
+ * Returns a python-style list of the given values
+ *
+ * @param array     The values to convert
+ * @param length    The number of values
+ * @param precision The number of digits after the decimal point (floats only)
+ * @param suffix    The suffix to append to each value
+ *
+ * @return a python-style list of the given values
+ */
+template <typename T>
+static std::string join_array(const T* array, size_t length, int precision=-1,
+                              const char* suffix="") {
+    char buffer[FLOAT_CHARS];
+    std::string result;
+    result.reserve(2+length*(std::is_floating_point<T>::value ? 12 : 6));
+    result.push_back('[');
+    for(size_t ii = 0; ii < length; ii++) {
+        if (ii > 0) {
+            result.append(", ");
+        }
+        if constexpr (std::is_floating_point<T>::value) {
+            size_t size = write_floating(array[ii],buffer,FLOAT_CHARS,precision);
+            if (size == 0) {
+                result.append(format_large(array[ii],precision));
+            } else {
+                result.append(buffer,size);
+            }
+        } else {
+            result.append(buffer,write_integer(array[ii],buffer,FLOAT_CHARS));
+        }
+        result.append(suffix);
+    }
+    result.push_back(']');
+    return result;
+}
+
+#pragma mark -
 #pragma mark NUMBER TO STRING FUNCTIONS
 /**
  * Returns a string equivalent to the given byte
@@ -59,13 +364,8 @@ namespace strtool {
  * @return a string equivalent to the given byte
  */
 std::string to_string(Uint8 value) {
-#if defined (__ANDROID__)
-    std::stringstream ss;
-    ss << (Uint32)value;
-    return ss.str();
-#else
-    return std::to_string((Uint32)value);
-#endif
+    char buffer[INTEGER_CHARS];
+    return std::string(buffer,to_chars((Uint32)value,buffer,INTEGER_CHARS));
 }
 
 /**
@@ -76,13 +376,8 @@ std::string to_string(Uint8 value) {
  * @return a string equivalent to the given signed 16 bit integer
  */
 std::string to_string(Sint16 value) {
-#if defined (__ANDROID__)
-    std::stringstream ss;
-    ss << (Sint32)value;
-    return ss.str();
-#else
-    return std::to_string((Sint32)value);
-#endif
+    char buffer[INTEGER_CHARS];
+    return std::string(buffer,to_chars((Sint32)value,buffer,INTEGER_CHARS));
 }
 
 /**
@@ -93,13 +388,8 @@ std::string to_string(Sint16 value) {
  * @return a string equivalent to the given unsigned 16 bit integer
  */
 std::string to_string(Uint16 value) {
-#if defined (__ANDROID__)
-    std::stringstream ss;
-    ss << (Uint32)value;
-    return ss.str();
-#else
-    return std::to_string((Uint32)value);
-#endif
+    char buffer[INTEGER_CHARS];
+    return std::string(buffer,to_chars((Uint32)value,buffer,INTEGER_CHARS));
 }
 
 /**
@@ -110,13 +400,8 @@ std::string to_string(Uint16 value) {
  * @return a string equivalent to the given signed 32 bit integer
  */
 std::string to_string(Sint32 value) {
-#if defined (__ANDROID__)
-    std::stringstream ss;
-    ss << value;
-    return ss.str();
-#else
-    return std::to_string(value);
-#endif
+    char buffer[INTEGER_CHARS];
+    return std::string(buffer,to_chars(value,buffer,INTEGER_CHARS));
 }
 
 /**
@@ -127,13 +412,8 @@ std::string to_string(Sint32 value) {
  * @return a string equivalent to the given unsigned 32 bit integer
  */
 std::string to_string(Uint32 value ) {
-#if defined (__ANDROID__)
-    std::stringstream ss;
-    ss << value;
-    return ss.str();
-#else
-    return std::to_string(value);
-#endif
+    char buffer[INTEGER_CHARS];
+    return std::string(buffer,to_chars(value,buffer,INTEGER_CHARS));
 }
 
 /**
@@ -144,13 +424,8 @@ std::string to_string(Uint32 value ) {
  * @return a string equivalent to the given signed 64 bit integer
  */
 std::string to_string(Sint64 value) {
-#if defined (__ANDROID__)
-    std::stringstream ss;
-    ss << value;
-    return ss.str();
-#else
-    return std::to_string(value);
-#endif
+    char buffer[INTEGER_CHARS];
+    return std::string(buffer,to_chars(value,buffer,INTEGER_CHARS));
 }
 
 /**
@@ -161,13 +436,8 @@ std::string to_string(Sint64 value) {
  * @return a string equivalent to the given unsigned 64 bit integer
  */
 std::string to_string(Uint64 value ) {
-#if defined (__ANDROID__)
-    std::stringstream ss;
-    ss << value;
-    return ss.str();
-#else
-    return std::to_string(value);
-#endif
+    char buffer[INTEGER_CHARS];
+    return std::string(buffer,to_chars(value,buffer,INTEGER_CHARS));
 }
 
 /**
@@ -175,7 +445,8 @@ std::string to_string(Uint64 value ) {
  *
  * This function differs from std::to_string(float) in that it allows us
  * to specify a precision (the number of digits to display after the decimal
- * point).  If precision is negative, then maximum precision will be used.
+ * point).  If precision is negative, this is the shortest string that
+ * converts back to the same value.
  *
  * @param  value        the numeric value to convert
  * @param  precision    the number of digits to display after the decimal
@@ -183,10 +454,12 @@ std::string to_string(Uint64 value ) {
  * @return a string equivalent to the given float value
  */
 std::string to_string(float value, int precision) {
-    int width = (precision >= 0 ? precision : std::numeric_limits<long double>::digits10 + 1);
-    std::stringstream ss;
-    ss << std::fixed << std::setprecision(width) << value;
-    return ss.str();
+    char buffer[FLOAT_CHARS];
+    size_t size = to_chars(value,buffer,FLOAT_CHARS,precision);
+    if (size == 0) {
+        return format_large(value,precision);
+    }
+    return std::string(buffer,size);
 }
 
 /**
@@ -194,7 +467,8 @@ std::string to_string(float value, int precision) {
  *
  * This function differs from std::to_string(double) in that it allows us
  * to specify a precision (the number of digits to display after the decimal
- * point).  If precision is negative, then maximum precision will be used.
+ * point).  If precision is negative, this is the shortest string that
+ * converts back to the same value.
  *
  * @param  value        the numeric value to convert
  * @param  precision    the number of digits to display after the decimal
@@ -202,10 +476,12 @@ std::string to_string(float value, int precision) {
  * @return a string equivalent to the given double value
  */
 std::string to_string(double value, int precision) {
-    int width = (precision >= 0 ? precision : std::numeric_limits<long double>::digits10 + 1);
-    std::stringstream ss;
-    ss << std::fixed << std::setprecision(width) << value;
-    return ss.str();
+    char buffer[FLOAT_CHARS];
+    size_t size = to_chars(value,buffer,FLOAT_CHARS,precision);
+    if (size == 0) {
+        return format_large(value,precision);
+    }
+    return std::string(buffer,size);
 }
 
 /**
@@ -239,6 +515,231 @@ std::string to_hexstring(Uint32 value, size_t len) {
     return result;
 }
 
+
+#pragma mark -
+#pragma mark BUFFER FUNCTIONS
+/**
+ * Writes the given signed 32 bit integer to a character buffer
+ *
+ * This function is locale-independent and does not allocate memory. The
+ * result is not null-terminated. If the buffer is too small, this function
+ * returns 0 and the contents of the buffer are unspecified.
+ *
+ * @param  value    the numeric value to convert
+ * @param  buffer   the buffer to store the characters
+ * @param  size     the size of the buffer
+ *
+ * @return the number of characters written
+ */
+size_t to_chars(Sint32 value, char* buffer, size_t size) {
+    return write_integer(value,buffer,size);
+}
+
+/**
+ * Writes the given unsigned 32 bit integer to a character buffer
+ *
+ * This function is locale-independent and does not allocate memory. The
+ * result is not null-terminated. If the buffer is too small, this function
+ * returns 0 and the contents of the buffer are unspecified.
+ *
+ * @param  value    the numeric value to convert
+ * @param  buffer   the buffer to store the characters
+ * @param  size     the size of the buffer
+ *
+ * @return the number of characters written
+ */
+size_t to_chars(Uint32 value, char* buffer, size_t size) {
+    return write_integer(value,buffer,size);
+}
+
+/**
+ * Writes the given signed 64 bit integer to a character buffer
+ *
+ * This function is locale-independent and does not allocate memory. The
+ * result is not null-terminated. If the buffer is too small, this function
+ * returns 0 and the contents of the buffer are unspecified.
+ *
+ * @param  value    the numeric value to convert
+ * @param  buffer   the buffer to store the characters
+ * @param  size     the size of the buffer
+ *
+ * @return the number of characters written
+ */
+size_t to_chars(Sint64 value, char* buffer, size_t size) {
+    return write_integer(value,buffer,size);
+}
+
+/**
+ * Writes the given unsigned 64 bit integer to a character buffer
+ *
+ * This function is locale-independent and does not allocate memory. The
+ * result is not null-terminated. If the buffer is too small, this function
+ * returns 0 and the contents of the buffer are unspecified.
+ *
+ * @param  value    the numeric value to convert
+ * @param  buffer   the buffer to store the characters
+ * @param  size     the size of the buffer
+ *
+ * @return the number of characters written
+ */
+size_t to_chars(Uint64 value, char* buffer, size_t size) {
+    return write_integer(value,buffer,size);
+}
+
+/**
+ * Writes the given float value to a character buffer
+ *
+ * The value is written in fixed point notation, with the given number of
+ * digits after the decimal point. If precision is negative, this is the
+ * shortest string that converts back to the same value.
+ *
+ * This function is locale-independent and does not allocate memory. The
+ * result is not null-terminated. If the buffer is too small, this function
+ * returns 0 and the contents of the buffer are unspecified.
+ *
+ * @param  value        the numeric value to convert
+ * @param  buffer       the buffer to store the characters
+ * @param  size         the size of the buffer
+ * @param  precision    the number of digits to display after the decimal
+ *
+ * @return the number of characters written
+ */
+size_t to_chars(float value, char* buffer, size_t size, int precision) {
+    return write_floating(value,buffer,size,precision);
+}
+
+/**
+ * Writes the given double value to a character buffer
+ *
+ * The value is written in fixed point notation, with the given number of
+ * digits after the decimal point. If precision is negative, this is the
+ * shortest string that converts back to the same value.
+ *
+ * This function is locale-independent and does not allocate memory. The
+ * result is not null-terminated. If the buffer is too small, this function
+ * returns 0 and the contents of the buffer are unspecified.
+ *
+ * @param  value        the numeric value to convert
+ * @param  buffer       the buffer to store the characters
+ * @param  size         the size of the buffer
+ * @param  precision    the number of digits to display after the decimal
+ *
+ * @return the number of characters written
+ */
+size_t to_chars(double value, char* buffer, size_t size, int precision) {
+    return write_floating(value,buffer,size,precision);
+}
+
+/**
+ * Reads a signed 32 bit integer from a character buffer
+ *
+ * Unlike {@link stos32}, this function does not skip whitespace, and it
+ * does not accept a leading '+' or a base prefix. It is locale-independent
+ * and does not allocate memory. If the number is out of range, the result
+ * is clamped to the range of the type.
+ *
+ * @param  buffer   the characters to read
+ * @param  size     the number of characters in the buffer
+ * @param  value    the variable to store the result
+ * @param  base     the number base
+ *
+ * @return the number of characters read (0 if there is no number)
+ */
+size_t from_chars(const char* buffer, size_t size, Sint32& value, int base) {
+    return read_integer(buffer,size,value,base);
+}
+
+/**
+ * Reads an unsigned 32 bit integer from a character buffer
+ *
+ * Unlike {@link stou32}, this function does not skip whitespace, and it
+ * does not accept a leading '+' or a base prefix. It is locale-independent
+ * and does not allocate memory. If the number is out of range, the result
+ * is clamped to the range of the type.
+ *
+ * @param  buffer   the characters to read
+ * @param  size     the number of characters in the buffer
+ * @param  value    the variable to store the result
+ * @param  base     the number base
+ *
+ * @return the number of characters read (0 if there is no number)
+ */
+size_t from_chars(const char* buffer, size_t size, Uint32& value, int base) {
+    return read_integer(buffer,size,value,base);
+}
+
+/**
+ * Reads a signed 64 bit integer from a character buffer
+ *
+ * Unlike {@link stos64}, this function does not skip whitespace, and it
+ * does not accept a leading '+' or a base prefix. It is locale-independent
+ * and does not allocate memory. If the number is out of range, the result
+ * is clamped to the range of the type.
+ *
+ * @param  buffer   the characters to read
+ * @param  size     the number of characters in the buffer
+ * @param  value    the variable to store the result
+ * @param  base     the number base
+ *
+ * @return the number of characters read (0 if there is no number)
+ */
+size_t from_chars(const char* buffer, size_t size, Sint64& value, int base) {
+    return read_integer(buffer,size,value,base);
+}
+
+/**
+ * Reads an unsigned 64 bit integer from a character buffer
+ *
+ * Unlike {@link stou64}, this function does not skip whitespace, and it
+ * does not accept a leading '+' or a base prefix. It is locale-independent
+ * and does not allocate memory. If the number is out of range, the result
+ * is clamped to the range of the type.
+ *
+ * @param  buffer   the characters to read
+ * @param  size     the number of characters in the buffer
+ * @param  value    the variable to store the result
+ * @param  base     the number base
+ *
+ * @return the number of characters read (0 if there is no number)
+ */
+size_t from_chars(const char* buffer, size_t size, Uint64& value, int base) {
+    return read_integer(buffer,size,value,base);
+}
+
+/**
+ * Reads a float from a character buffer
+ *
+ * Unlike {@link stof}, this function does not skip whitespace, and it does
+ * not accept a leading '+'. It is locale-independent and does not allocate
+ * memory (on platforms with floating point support for std::from_chars).
+ *
+ * @param  buffer   the characters to read
+ * @param  size     the number of characters in the buffer
+ * @param  value    the variable to store the result
+ *
+ * @return the number of characters read (0 if there is no number)
+ */
+size_t from_chars(const char* buffer, size_t size, float& value) {
+    return read_floating(buffer,size,value);
+}
+
+/**
+ * Reads a double from a character buffer
+ *
+ * Unlike {@link stod}, this function does not skip whitespace, and it does
+ * not accept a leading '+'. It is locale-independent and does not allocate
+ * memory (on platforms with floating point support for std::from_chars).
+ *
+ * @param  buffer   the characters to read
+ * @param  size     the number of characters in the buffer
+ * @param  value    the variable to store the result
+ *
+ * @return the number of characters read (0 if there is no number)
+ */
+size_t from_chars(const char* buffer, size_t size, double& value) {
+    return read_floating(buffer,size,value);
+}
+
 #pragma mark -
 #pragma mark ARRAY TO STRING FUNCTIONS
 /**
@@ -253,20 +754,11 @@ std::string to_hexstring(Uint32 value, size_t len) {
  * @return a string equivalent to the given byte array
  */
 std::string to_string(Uint8* array, size_t length, size_t offset) {
-    std::stringstream ss;
-    ss << "[";
-    for(int ii = 0; ii < length; ii++) {
-        ss << (Uint32)array[ii+offset];
-        if (ii != length-1) {
-            ss << ", ";
-        }
-    }
-    ss << "]";
-    return ss.str();
+    return join_array(array+offset,length);
 }
 
 /**
- * Returns a string equivalent to the signed 16 bit integer array
+ * Returns a string equivalent to the given signed 16 bit integer array
  *
  * The value is display as a python-style list in brackets.
  *
@@ -274,23 +766,14 @@ std::string to_string(Uint8* array, size_t length, size_t offset) {
  * @param length    the array length
  * @param offset    the starting position in the array
  *
- * @return a string equivalent to the signed 16 bit integer array
+ * @return a string equivalent to the given signed 16 bit integer array
  */
 std::string to_string(Sint16* array, size_t length, size_t offset) {
-    std::stringstream ss;
-    ss << "[";
-    for(int ii = 0; ii < length; ii++) {
-        ss << array[ii+offset];
-        if (ii != length-1) {
-            ss << ", ";
-        }
-    }
-    ss << "]";
-    return ss.str();
+    return join_array(array+offset,length);
 }
 
 /**
- * Returns a string equivalent to the unsigned 16 bit integer array
+ * Returns a string equivalent to the given unsigned 16 bit integer array
  *
  * The value is display as a python-style list in brackets.
  *
@@ -298,24 +781,14 @@ std::string to_string(Sint16* array, size_t length, size_t offset) {
  * @param length    the array length
  * @param offset    the starting position in the array
  *
- * @return a string equivalent to the unsigned 16 bit integer array
+ * @return a string equivalent to the given unsigned 16 bit integer array
  */
 std::string to_string(Uint16* array, size_t length, size_t offset) {
-    std::stringstream ss;
-    ss << "[";
-    for(int ii = 0; ii < length; ii++) {
-        ss << array[ii+offset];
-        if (ii != length-1) {
-            ss << ", ";
-        }
-    }
-    ss << "]";
-    return ss.str();
+    return join_array(array+offset,length);
 }
 
-
 /**
- * Returns a string equivalent to the signed 32 bit integer array
+ * Returns a string equivalent to the given signed 32 bit integer array
  *
  * The value is display as a python-style list in brackets.
  *
@@ -323,24 +796,14 @@ std::string to_string(Uint16* array, size_t length, size_t offset) {
  * @param length    the array length
  * @param offset    the starting position in the array
  *
- * @return a string equivalent to the signed 32 bit integer array
+ * @return a string equivalent to the given signed 32 bit integer array
  */
 std::string to_string(Sint32* array, size_t length, size_t offset) {
-    std::stringstream ss;
-    ss << "[";
-    for(int ii = 0; ii < length; ii++) {
-        ss << array[ii+offset];
-        if (ii != length-1) {
-            ss << ", ";
-        }
-    }
-    ss << "]";
-    return ss.str();
+    return join_array(array+offset,length);
 }
 
-
 /**
- * Returns a string equivalent to the unsigned 32 bit integer array
+ * Returns a string equivalent to the given unsigned 32 bit integer array
  *
  * The value is display as a python-style list in brackets.
  *
@@ -348,23 +811,14 @@ std::string to_string(Sint32* array, size_t length, size_t offset) {
  * @param length    the array length
  * @param offset    the starting position in the array
  *
- * @return a string equivalent to the unsigned 32 bit integer array
+ * @return a string equivalent to the given unsigned 32 bit integer array
  */
 std::string to_string(Uint32* array, size_t length, size_t offset) {
-    std::stringstream ss;
-    ss << "[";
-    for(int ii = 0; ii < length; ii++) {
-        ss << array[ii+offset];
-        if (ii != length-1) {
-            ss << ", ";
-        }
-    }
-    ss << "]";
-    return ss.str();
+    return join_array(array+offset,length);
 }
 
 /**
- * Returns a string equivalent to the signed 64 bit integer array
+ * Returns a string equivalent to the given signed 64 bit integer array
  *
  * The value is display as a python-style list in brackets.
  *
@@ -372,24 +826,14 @@ std::string to_string(Uint32* array, size_t length, size_t offset) {
  * @param length    the array length
  * @param offset    the starting position in the array
  *
- * @return a string equivalent to the signed 64 bit integer array
+ * @return a string equivalent to the given signed 64 bit integer array
  */
 std::string to_string(Sint64* array, size_t length, size_t offset) {
-    std::stringstream ss;
-    ss << "[";
-    for(int ii = 0; ii < length; ii++) {
-        ss << array[ii+offset];
-        if (ii != length-1) {
-            ss << ", ";
-        }
-    }
-    ss << "]";
-    return ss.str();
+    return join_array(array+offset,length);
 }
 
-
 /**
- * Returns a string equivalent to the unsigned 64 bit integer array
+ * Returns a string equivalent to the given unsigned 64 bit integer array
  *
  * The value is display as a python-style list in brackets.
  *
@@ -397,22 +841,12 @@ std::string to_string(Sint64* array, size_t length, size_t offset) {
  * @param length    the array length
  * @param offset    the starting position in the array
  *
- * @return a string equivalent to the unsigned 64 bit integer array
+ * @return a string equivalent to the given unsigned 64 bit integer array
  */
 std::string to_string(Uint64* array, size_t length, size_t offset) {
-    std::stringstream ss;
-    ss << "[";
-    for(int ii = 0; ii < length; ii++) {
-        ss << array[ii+offset];
-        if (ii != length-1) {
-            ss << ", ";
-        }
-    }
-    ss << "]";
-    return ss.str();
+    return join_array(array+offset,length);
 }
 
-
 /**
  * Returns a string equivalent to the given float array
  *
@@ -420,26 +854,17 @@ std::string to_string(Uint64* array, size_t length, size_t offset) {
  *
  * As with to_string(float), this function allows us to specify a precision
  * (the number of digits to display after the decimal point).  If precision is
- * negative, then maximum precision will be used.
+ * negative, each value is the shortest string that converts back to it.
  *
  * @param array     the array to convert
  * @param length    the array length
  * @param offset    the starting position in the array
+ * @param precision the number of digits to display after the decimal
  *
  * @return a string equivalent to the given float array
  */
 std::string to_string(float* array, size_t length, size_t offset, int precision) {
-    int width = (precision >= 0 ? precision : std::numeric_limits<long double>::digits10 + 1);
-    std::stringstream ss;
-    ss << "[" << std::fixed << std::setprecision(width);
-    for(int ii = 0; ii < length; ii++) {
-        ss << array[ii+offset] << 'f';
-        if (ii != length-1) {
-            ss << ", ";
-        }
-    }
-    ss << "]";
-    return ss.str();
+    return join_array(array+offset,length,precision,"f");
 }
 
 /**
@@ -449,29 +874,19 @@ std::string to_string(float* array, size_t length, size_t offset, int precision)
  *
  * As with to_string(double), this function allows us to specify a precision
  * (the number of digits to display after the decimal point).  If precision is
- * negative, then maximum precision will be used.
+ * negative, each value is the shortest string that converts back to it.
  *
  * @param array     the array to convert
  * @param length    the array length
  * @param offset    the starting position in the array
+ * @param precision the number of digits to display after the decimal
  *
  * @return a string equivalent to the given double array
  */
 std::string to_string(double* array, size_t length, size_t offset, int precision) {
-    int width = (precision >= 0 ? precision : std::numeric_limits<long double>::digits10 + 1);
-    std::stringstream ss;
-    ss << "[" << std::fixed << std::setprecision(width);
-    for(int ii = 0; ii < length; ii++) {
-        ss << array[ii+offset];
-        if (ii != length-1) {
-            ss << ", ";
-        }
-    }
-    ss << "]";
-    return ss.str();
+    return join_array(array+offset,length,precision);
 }
 
-
 #pragma mark -
 #pragma mark STRING TO NUMBER FUNCTIONS
 
@@ -483,24 +898,22 @@ std::string to_string(double* array, size_t length, size_t offset, int precision
  * as possible to form a valid base-n (where n=base) integer number representation
  * and converts them to an integer value.
  *
+ * If no conversion can be performed, this function returns 0 (and stores
+ * 0 in pos). It never throws an exception.
+ *
  * @param  str  the string to convert
  * @param  pos  address of an integer to store the number of characters processed
  * @param  base the number base
  *
  * @return the byte equivalent to the given string
  */
-Uint8 stou8(const std::string str, std::size_t* pos, int base) {
-#if defined (__ANDROID__)
-    const char* start = str.c_str();
-    char* end;
-    int result = (Uint8)std::strtol(start, &end, base);
+Uint8 stou8(const std::string& str, std::size_t* pos, int base) {
+    Uint64 result = 0;
+    size_t read = parse_unsigned(str,result,base);
     if (pos) {
-	    *pos = (std::size_t)(end-start);
-	}
-    return result;
-#else
-    return (Uint8)std::stoi(str,pos,base);
-#endif
+        *pos = read;
+    }
+    return (Uint8)result;
 }
 
 /**
@@ -511,24 +924,22 @@ Uint8 stou8(const std::string str, std::size_t* pos, int base) {
  * as possible to form a valid base-n (where n=base) integer number representation
  * and converts them to a long value.
  *
+ * If no conversion can be performed, this function returns 0 (and stores
+ * 0 in pos). It never throws an exception.
+ *
  * @param  str  the string to convert
  * @param  pos  address of an integer to store the number of characters processed
  * @param  base the number base
  *
  * @return the signed 16 bit integer equivalent to the given string
  */
-Sint16 stos16(const std::string str, std::size_t* pos, int base)  {
-#if defined (__ANDROID__)
-    const char* start = str.c_str();
-    char* end;
-    int result = (Sint16)std::strtol(start, &end, base);
+Sint16 stos16(const std::string& str, std::size_t* pos, int base) {
+    Sint64 result = 0;
+    size_t read = parse_signed(str,result,base);
     if (pos) {
-	    *pos = (std::size_t)(end-start);
-	}
-    return result;
-#else
-    return (Sint16)std::stoi(str,pos,base);
-#endif
+        *pos = read;
+    }
+    return (Sint16)result;
 }
 
 /**
@@ -539,24 +950,22 @@ Sint16 stos16(const std::string str, std::size_t* pos, int base)  {
  * as possible to form a valid base-n (where n=base) integer number representation
  * and converts them to a long value.
  *
+ * If no conversion can be performed, this function returns 0 (and stores
+ * 0 in pos). It never throws an exception.
+ *
  * @param  str  the string to convert
  * @param  pos  address of an integer to store the number of characters processed
  * @param  base the number base
  *
  * @return the unsigned 16 bit integer equivalent to the given string
  */
-Uint16 stou16(const std::string str, std::size_t* pos, int base) {
-#if defined (__ANDROID__)
-    const char* start = str.c_str();
-    char* end;
-    int result = (Uint16)std::strtol(start, &end, base);
+Uint16 stou16(const std::string& str, std::size_t* pos, int base) {
+    Uint64 result = 0;
+    size_t read = parse_unsigned(str,result,base);
     if (pos) {
-	    *pos = (std::size_t)(end-start); 
-	}
-    return result;
-#else
-    return (Uint16)std::stol(str,pos,base);
-#endif
+        *pos = read;
+    }
+    return (Uint16)result;
 }
 
 /**
@@ -567,24 +976,22 @@ Uint16 stou16(const std::string str, std::size_t* pos, int base) {
  * as possible to form a valid base-n (where n=base) integer number representation
  * and converts them to a long value.
  *
+ * If no conversion can be performed, this function returns 0 (and stores
+ * 0 in pos). It never throws an exception.
+ *
  * @param  str  the string to convert
  * @param  pos  address of an integer to store the number of characters processed
  * @param  base the number base
  *
  * @return the signed 32 bit integer equivalent to the given string
  */
-Sint32 stos32(const std::string str, std::size_t* pos, int base) {
-#if defined (__ANDROID__)
-    const char* start = str.c_str();
-    char* end;
-    int result = (Sint32)std::strtol(start, &end, base);
+Sint32 stos32(const std::string& str, std::size_t* pos, int base) {
+    Sint64 result = 0;
+    size_t read = parse_signed(str,result,base);
     if (pos) {
-	    *pos = (std::size_t)(end-start);
-	}
-    return result;
-#else
-    return (Sint32)std::stol(str,pos,base);
-#endif
+        *pos = read;
+    }
+    return (Sint32)result;
 }
 
 /**
@@ -595,24 +1002,22 @@ Sint32 stos32(const std::string str, std::size_t* pos, int base) {
  * as possible to form a valid base-n (where n=base) integer number representation
  * and converts them to a long value.
  *
+ * If no conversion can be performed, this function returns 0 (and stores
+ * 0 in pos). It never throws an exception.
+ *
  * @param  str  the string to convert
  * @param  pos  address of an integer to store the number of characters processed
  * @param  base the number base
  *
  * @return the unsigned 32 bit integer equivalent to the given string
  */
-Uint32 stou32(const std::string str, std::size_t* pos, int base) {
-#if defined (__ANDROID__)
-    const char* start = str.c_str();
-    char* end;
-    int result = (Uint32)std::strtoul(start, &end, base);
+Uint32 stou32(const std::string& str, std::size_t* pos, int base) {
+    Uint64 result = 0;
+    size_t read = parse_unsigned(str,result,base);
     if (pos) {
-	    *pos = (std::size_t)(end-start);
-	}
-    return result;
-#else
-    return (Uint32)std::stoul(str,pos,base);
-#endif
+        *pos = read;
+    }
+    return (Uint32)result;
 }
 
 /**
@@ -623,24 +1028,22 @@ Uint32 stou32(const std::string str, std::size_t* pos, int base) {
  * as possible to form a valid base-n (where n=base) integer number representation
  * and converts them to a long value.
  *
+ * If no conversion can be performed, this function returns 0 (and stores
+ * 0 in pos). It never throws an exception.
+ *
  * @param  str  the string to convert
  * @param  pos  address of an integer to store the number of characters processed
  * @param  base the number base
  *
  * @return the signed 64 bit integer equivalent to the given string
  */
-Sint64 stos64(const std::string str, std::size_t* pos, int base) {
-#if defined (__ANDROID__)
-    const char* start = str.c_str();
-    char* end;
-    int result = (Sint64)std::strtoll(start, &end, base);
+Sint64 stos64(const std::string& str, std::size_t* pos, int base) {
+    Sint64 result = 0;
+    size_t read = parse_signed(str,result,base);
     if (pos) {
-	    *pos = (std::size_t)(end-start);
-	}
-    return result;
-#else
-    return (Sint64)std::stoll(str,pos,base);
-#endif
+        *pos = read;
+    }
+    return (Sint64)result;
 }
 
 
@@ -652,24 +1055,22 @@ Sint64 stos64(const std::string str, std::size_t* pos, int base) {
  * as possible to form a valid base-n (where n=base) integer number representation
  * and converts them to a long value.
  *
+ * If no conversion can be performed, this function returns 0 (and stores
+ * 0 in pos). It never throws an exception.
+ *
  * @param  str  the string to convert
  * @param  pos  address of an integer to store the number of characters processed
  * @param  base the number base
  *
  * @return the unsigned 64 bit integer equivalent to the given string
  */
-Uint64 stou64(const std::string str, std::size_t* pos, int base) {
-#if defined (__ANDROID__)
-    const char* start = str.c_str();
-    char* end;
-    int result = (Uint64)std::strtoull(start, &end, base);
+Uint64 stou64(const std::string& str, std::size_t* pos, int base) {
+    Uint64 result = 0;
+    size_t read = parse_unsigned(str,result,base);
     if (pos) {
-	    *pos = (std::size_t)(end-start);
-	}
-    return result;
-#else
-    return (Uint64)std::stoull(str,pos,base);
-#endif
+        *pos = read;
+    }
+    return (Uint64)result;
 }
 
 /**
@@ -680,23 +1081,21 @@ Uint64 stou64(const std::string str, std::size_t* pos, int base) {
  * possible to form a valid floating point representation and converts them to a floating
  * point value.
  *
+ * If no conversion can be performed, this function returns 0 (and stores
+ * 0 in pos). It never throws an exception.
+ *
  * @param  str  the string to convert
  * @param  pos  address of an integer to store the number of characters processed
  *
  * @return the float equivalent to the given string
  */
-float  stof(const std::string str, std::size_t* pos) {
-#if defined (__ANDROID__)
-    const char* start = str.c_str();
-    char* end;
-    float result = (float)std::strtod(start, &end);
+float  stof(const std::string& str, std::size_t* pos) {
+    float result = 0;
+    size_t read = parse_floating(str,result);
     if (pos) {
-	    *pos = (std::size_t)(end-start);
-	}
+        *pos = read;
+    }
     return result;
-#else
-    return std::stof(str,pos);
-#endif
 }
 
 /**
@@ -707,23 +1106,21 @@ float  stof(const std::string str, std::size_t* pos) {
  * possible to form a valid floating point representation and converts them to a floating
  * point value.
  *
+ * If no conversion can be performed, this function returns 0 (and stores
+ * 0 in pos). It never throws an exception.
+ *
  * @param  str  the string to convert
  * @param  pos  address of an integer to store the number of characters processed
  *
  * @return the double equivalent to the given string
  */
-double stod(const std::string str, std::size_t* pos) {
-#if defined (__ANDROID__)
-    const char* start = str.c_str();
-    char* end;
-    double result = std::strtod(start, &end);
+double stod(const std::string& str, std::size_t* pos) {
+    double result = 0;
+    size_t read = parse_floating(str,result);
     if (pos) {
-	    *pos = (std::size_t)(end-start); 
-	}
+        *pos = read;
+    }
     return result;
-#else
-    return std::stod(str,pos);
-#endif
 }
 
 #pragma mark -
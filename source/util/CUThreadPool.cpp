@@ -6,6 +6,11 @@
 //  task is specified by a void function.  There are no guarantees about thread
 //  safety; that is responsibility of the author of each task.
 //
+//  Each worker has its own task queue, and an idle worker steals from the
+//  queues of the other workers. So submitting a task only locks a single
+//  queue. Tasks are stored without std::function, so that small tasks do not
+//  allocate any memory.
+//
 //  This code is largely inspired from the Cocos2d file AudioEngine.cpp, from
 //  the code for asynchronous asset loading. We generalized that class added
 //  some notable safety changes.
@@ -30,12 +35,76 @@
 //      3. This notice may not be removed or altered from any source distribution.
 //
 //  Author: Walker White
-//  Version: 11/29/16
+//  Version: 10/14/26
 //
 #include <cugl/util/CUThreadPool.h>
+#include <cugl/util/CUDebug.h>
+#include <cugl/util/CUProfiler.h>
 
 using namespace cugl;
 
+/** The thread pool of the current thread (nullptr if not a worker) */
+static thread_local ThreadPool* local_pool = nullptr;
+/** The queue index of the current worker thread */
+static thread_local size_t local_index = 0;
+
+#pragma mark -
+#pragma mark Task Handle
+/**
+ * Marks this task as complete, scheduling any continuations.
+ */
+void TaskHandle::complete() {
+    std::vector<Task> continuations;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _done.store(true, std::memory_order_release);
+        continuations.swap(_continuations);
+        _finished.notify_all();
+    }
+    for(auto it = continuations.begin(); it != continuations.end(); ++it) {
+        _pool->addTask(std::move(*it));
+    }
+}
+
+/**
+ * Blocks until the task is complete.
+ *
+ * If this method is called from a worker of the same thread pool, that
+ * worker runs other tasks while it waits. So it is safe to wait on a
+ * task from within another task, even in a pool with a single thread.
+ */
+void TaskHandle::wait() {
+    if (_pool->isWorkerThread()) {
+        while (!isDone()) {
+            if (!_pool->runOne()) {
+                std::this_thread::yield();
+            }
+        }
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _finished.wait(lock, [this]() { return isDone(); });
+}
+
+/**
+ * Schedules a task to run once this task is complete.
+ *
+ * The continuation is added to the same thread pool as this task. If this
+ * task is already complete, the continuation is added immediately.
+ *
+ * @param task  The task to run once this task is complete
+ */
+void TaskHandle::then(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!isDone()) {
+            _continuations.push_back(std::move(task));
+            return;
+        }
+    }
+    _pool->addTask(std::move(task));
+}
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -43,12 +112,20 @@ using namespace cugl;
  *
  * A disposed thread pool can be safely reinitialized. However, it is a bad
  * idea to destroy the thread pool if the pool is not yet shut down. The
- * task queue is shared by the child threads, so we cannot delete it until
- * all the threads complete.  This destructor will block unti showndown.
+ * task queues are shared by the child threads, so we cannot delete them
+ * until all the threads complete.  This destructor will block until
+ * showndown. Any tasks that have not started are discarded.
  */
 void ThreadPool::dispose() {
     stop();
     while (!isShutdown());
+    _workers.clear();
+    _queues.clear();
+    _nextQueue = 0;
+    _pending = 0;
+    _started = 0;
+    _complete = 0;
+    _stop = false;
 }
 
 /**
@@ -63,6 +140,10 @@ void ThreadPool::dispose() {
  * @return true if the threed pool is initialized properly, false otherwise.
  */
 bool ThreadPool::init(int threads) {
+    // The queues must exist before any thread starts
+    for (int index = 0; index < threads; ++index) {
+        _queues.push_back(std::make_unique<WorkQueue>());
+    }
     for (int index = 0; index < threads; ++index) {
 #ifdef CU_SDL_THREADS
         _workers.emplace_back(SDL_CreateThread(ThreadPool::sdlThreadFunc,"Pool Dispatch",(void*)this));
@@ -80,66 +161,146 @@ bool ThreadPool::init(int threads) {
 /**
  * The body function of a single thread.
  *
- * This function pulls tasks from the task queue.
+ * This function pulls tasks from the task queues.
  *
  * This implementation is safe to use with std::thread.
  */
 void ThreadPool::threadFunc() {
+    local_pool  = this;
+    local_index = _started.fetch_add(1);
+    Profiler::setThreadName("Worker "+std::to_string(local_index));
     while (!_stop) {
-        std::function<void()> task = nullptr;
-        {   // Lock for save queue access
-            std::unique_lock<std::mutex> lk(_queueMutex);
-            if (_stop) {
-                break;
-            }
-            // Pull the next task off the queue
-            if (!_taskQueue.empty()) {
-                task = std::move(_taskQueue.front());
-                _taskQueue.pop();
-            } else {
-                _taskCondition.wait(lk);
-                continue;
+        Entry entry;
+        if (pop(local_index,entry)) {
+            // Perform the current task
+            entry.task();
+            if (entry.handle) {
+                entry.handle->complete();
             }
+            continue;
         }
-        // Perform the current task
-        task();
+        
+        // Sleep until there is something to steal
+        std::unique_lock<std::mutex> lk(_sleepMutex);
+        _sleeping.fetch_add(1);
+        _taskCondition.wait(lk, [this]() { return _stop || _pending.load() > 0; });
+        _sleeping.fetch_sub(1);
     }
+    local_pool = nullptr;
     _complete++;
 }
 
 /**
  * The body function of a single thread.
  *
- * This function pulls tasks from the task queue.
+ * This function pulls tasks from the task queues.
  *
  * This static implementation uses the SDL thread API.  It should be used
  * on Android and Windows, which have special thread requirements.
  */
 int ThreadPool::sdlThreadFunc(void* ptr) {
     ThreadPool* self = (ThreadPool*)ptr;
-    while (!self->_stop) {
-        std::function<void()> task = nullptr;
-        {   // Lock for save queue access
-            std::unique_lock<std::mutex> lk(self->_queueMutex);
-            if (self->_stop) {
-                break;
-            }
-            // Pull the next task off the queue
-            if (!self->_taskQueue.empty()) {
-                task = std::move(self->_taskQueue.front());
-                self->_taskQueue.pop();
-            } else {
-                self->_taskCondition.wait(lk);
-                continue;
-            }
+    self->threadFunc();
+    return 0;
+}
+
+/**
+ * Adds a task entry to the thread pool.
+ *
+ * @param entry     The task entry
+ * @param priority  Whether to run the task before the ones waiting
+ */
+void ThreadPool::push(Entry&& entry, bool priority) {
+    CUAssertLog(!_queues.empty(), "The thread pool is not initialized");
+    size_t index = local_pool == this ? local_index : _nextQueue.fetch_add(1) % _queues.size();
+    
+    // Count the task first, so that the count never underflows
+    _pending.fetch_add(1);
+    {
+        WorkQueue* queue = _queues[index].get();
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (priority) {
+            queue->tasks.push_front(std::move(entry));
+        } else {
+            queue->tasks.push_back(std::move(entry));
         }
-        // Perform the current task
-        task();
     }
-    self->_complete++;
-    return 0;
+    
+    // Only touch the shared lock if a worker is asleep
+    if (_sleeping.load() > 0) {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _taskCondition.notify_one();
+    }
 }
 
+/**
+ * Removes a task entry from the queues, returning true if successful.
+ *
+ * The given queue is checked first. If it is empty, this method steals
+ * from the other queues.
+ *
+ * @param index     The queue to check first
+ * @param entry     The entry to store the task
+ *
+ * @return true if a task was removed
+ */
+bool ThreadPool::pop(size_t index, Entry& entry) {
+    if (_pending.load() == 0) {
+        return false;
+    }
+    size_t size = _queues.size();
+    for(size_t ii = 0; ii < size; ii++) {
+        WorkQueue* queue = _queues[(index+ii) % size].get();
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (!queue->tasks.empty()) {
+            entry = std::move(queue->tasks.front());
+            queue->tasks.pop_front();
+            _pending.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Runs a single waiting task on the current thread.
+ *
+ * This method is used by the workers to make progress while waiting on
+ * other tasks. It does nothing if there are no tasks waiting.
+ *
+ * @return true if a task was run
+ */
+bool ThreadPool::runOne() {
+    Entry entry;
+    if (!pop(local_pool == this ? local_index : 0,entry)) {
+        return false;
+    }
+    entry.task();
+    if (entry.handle) {
+        entry.handle->complete();
+    }
+    return true;
+}
+
+/**
+ * Blocks until every chunk of the given loop is complete.
+ *
+ * A worker of this pool runs other tasks while it waits.
+ *
+ * @param loop  The parallel loop
+ */
+void ThreadPool::wait(Loop& loop) {
+    if (local_pool == this) {
+        while (loop.done.load() < loop.chunks) {
+            if (!runOne()) {
+                std::this_thread::yield();
+            }
+        }
+        return;
+    }
+    std::unique_lock<std::mutex> lock(loop.mutex);
+    loop.finished.wait(lock, [&]() { return loop.done.load() == loop.chunks; });
+}
 
 
 #pragma mark -
@@ -152,12 +313,46 @@ int ThreadPool::sdlThreadFunc(void* ptr) {
  * will not be executed immediately, but must wait for the first available
  * worker.
  *
- * @param  task     the task function to add to the thread pool
+ * If priority is true, the task is placed ahead of the tasks waiting in
+ * its queue. This does not affect tasks that are already running.
+ *
+ * @param task      the task function to add to the thread pool
+ * @param priority  whether to run the task before the ones waiting
  */
-void ThreadPool::addTask(const std::function<void()> &task){
-    std::unique_lock<std::mutex> lk(_queueMutex);
-    _taskQueue.emplace(task);
-    _taskCondition.notify_one();
+void ThreadPool::addTask(Task task, bool priority) {
+    Entry entry;
+    entry.task = std::move(task);
+    push(std::move(entry),priority);
+}
+
+/**
+ * Adds a task to the thread pool, returning a handle to the task.
+ *
+ * This method is the same as {@link #addTask}, except that the handle
+ * can be used to wait on the task, or to schedule other tasks to run once
+ * it is complete.
+ *
+ * @param task      the task function to add to the thread pool
+ * @param priority  whether to run the task before the ones waiting
+ *
+ * @return a handle to the task
+ */
+std::shared_ptr<TaskHandle> ThreadPool::submit(Task task, bool priority) {
+    Entry entry;
+    entry.task = std::move(task);
+    entry.handle = std::make_shared<TaskHandle>(this);
+    std::shared_ptr<TaskHandle> result = entry.handle;
+    push(std::move(entry),priority);
+    return result;
+}
+
+/**
+ * Returns true if the current thread is a worker of this pool.
+ *
+ * @return true if the current thread is a worker of this pool.
+ */
+bool ThreadPool::isWorkerThread() const {
+    return local_pool == this;
 }
 
 /**
@@ -169,17 +364,22 @@ void ThreadPool::addTask(const std::function<void()> &task){
  */
 void ThreadPool::stop() {
     {
-        std::unique_lock<std::mutex> lk(_queueMutex);
+        std::unique_lock<std::mutex> lk(_sleepMutex);
         _stop = true;
         _taskCondition.notify_all();
     }
     
     for (auto&& worker : _workers) {
 #ifdef CU_SDL_THREADS
-        int status;
-        SDL_WaitThread(worker,&status);
+        if (worker != nullptr) {
+            int status;
+            SDL_WaitThread(worker,&status);
+            worker = nullptr;
+        }
 #else
-        worker.join();
+        if (worker.joinable()) {
+            worker.join();
+        }
 #endif
     }
 }
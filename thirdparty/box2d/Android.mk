@@ -24,6 +24,10 @@ LOCAL_SRC_FILES := \
 	$(wildcard $(BOX2D_PATH)/src/dynamics/*.cpp) \
 	$(wildcard $(BOX2D_PATH)/src/rope/*.cpp) \
 	)
+
+# Bit identical simulation across platforms (no fused multiply-add)
+LOCAL_CFLAGS += -DB2_DETERMINISTIC -ffp-contract=off -fno-fast-math
+
 LOCAL_STATIC_LIBRARIES :=
 
 include $(BUILD_STATIC_LIBRARY)
@@ -35,7 +35,17 @@ inline bool b2IsValid(float x)
 }
 
 #define	b2Sqrt(x)	sqrtf(x)
-#define	b2Atan2(y, x)	atan2f(y, x)
+
+/// Compute the sine of an angle in radians.
+/// If the library is built with B2_DETERMINISTIC, this does not use the
+/// platform math library and gives bit identical results on every platform.
+B2_API float b2Sin(float angle);
+
+/// Compute the cosine of an angle in radians. See b2Sin.
+B2_API float b2Cos(float angle);
+
+/// Compute the arc tangent of y/x in radians. See b2Sin.
+B2_API float b2Atan2(float y, float x);
 
 /// A 2D column vector.
 struct B2_API b2Vec2
@@ -292,16 +302,16 @@ struct B2_API b2Rot
 	explicit b2Rot(float angle)
 	{
 		/// TODO_ERIN optimize
-		s = sinf(angle);
-		c = cosf(angle);
+		s = b2Sin(angle);
+		c = b2Cos(angle);
 	}
 
 	/// Set using an angle in radians.
 	void Set(float angle)
 	{
 		/// TODO_ERIN optimize
-		s = sinf(angle);
-		c = cosf(angle);
+		s = b2Sin(angle);
+		c = b2Cos(angle);
 	}
 
 	/// Set to the identity rotation
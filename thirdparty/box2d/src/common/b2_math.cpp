@@ -24,6 +24,115 @@
 
 const b2Vec2 b2Vec2_zero(0.0f, 0.0f);
 
+#ifdef B2_DETERMINISTIC
+
+// These only use basic double arithmetic and sqrt, which are correctly
+// rounded under IEEE 754. With contraction disabled (no fused multiply-add)
+// they give the same bits on every platform, unlike sinf and cosf.
+
+static const double b2_twoPi = 6.28318530717958647692;
+static const double b2_halfPi = 1.57079632679489661923;
+
+// Reduces an angle to [-pi/4,pi/4] and returns the quadrant
+static int b2ReduceAngle(double x, double* r)
+{
+	x -= b2_twoPi * floor(x / b2_twoPi + 0.5);
+	double k = floor(x / b2_halfPi + 0.5);
+	*r = x - k * b2_halfPi;
+	return int(k) & 3;
+}
+
+// Taylor series on [-pi/4,pi/4] with error below 1e-11
+static double b2SinKernel(double x)
+{
+	double x2 = x * x;
+	return x * (1.0 + x2 * (-1.0 / 6.0 + x2 * (1.0 / 120.0 + x2 * (-1.0 / 5040.0 +
+		x2 * (1.0 / 362880.0 + x2 * (-1.0 / 39916800.0 + x2 * (1.0 / 6227020800.0)))))));
+}
+
+static double b2CosKernel(double x)
+{
+	double x2 = x * x;
+	return 1.0 + x2 * (-1.0 / 2.0 + x2 * (1.0 / 24.0 + x2 * (-1.0 / 720.0 +
+		x2 * (1.0 / 40320.0 + x2 * (-1.0 / 3628800.0 + x2 * (1.0 / 479001600.0))))));
+}
+
+float b2Sin(float angle)
+{
+	double r;
+	switch (b2ReduceAngle(angle, &r))
+	{
+	case 0: return float(b2SinKernel(r));
+	case 1: return float(b2CosKernel(r));
+	case 2: return float(-b2SinKernel(r));
+	default: return float(-b2CosKernel(r));
+	}
+}
+
+float b2Cos(float angle)
+{
+	double r;
+	switch (b2ReduceAngle(angle, &r))
+	{
+	case 0: return float(b2CosKernel(r));
+	case 1: return float(-b2SinKernel(r));
+	case 2: return float(-b2CosKernel(r));
+	default: return float(b2SinKernel(r));
+	}
+}
+
+float b2Atan2(float y, float x)
+{
+	double dx = x;
+	double dy = y;
+	double ax = fabs(dx);
+	double ay = fabs(dy);
+
+	// Angle of (|x|,|y|) with the ratio at most one
+	bool swap = ay > ax;
+	double t = ax == 0.0 && ay == 0.0 ? 0.0 : (swap ? ax / ay : ay / ax);
+
+	// Two half angle steps bring t below tan(pi/16)
+	t = t / (1.0 + sqrt(1.0 + t * t));
+	t = t / (1.0 + sqrt(1.0 + t * t));
+	double t2 = t * t;
+	double a = 0.0;
+	for (int i = 21; i >= 1; i -= 2)
+	{
+		a = 1.0 / i - t2 * a;
+	}
+	a = 4.0 * t * a;
+
+	if (swap)
+	{
+		a = b2_halfPi - a;
+	}
+	if (signbit(dx))
+	{
+		a = 2.0 * b2_halfPi - a;
+	}
+	return float(signbit(dy) ? -a : a);
+}
+
+#else
+
+float b2Sin(float angle)
+{
+	return sinf(angle);
+}
+
+float b2Cos(float angle)
+{
+	return cosf(angle);
+}
+
+float b2Atan2(float y, float x)
+{
+	return atan2f(y, x);
+}
+
+#endif
+
 /// Solve A * x = b, where b is a column vector. This is more efficient
 /// than computing the inverse in one-shot cases.
 b2Vec3 b2Mat33::Solve33(const b2Vec3& b) const